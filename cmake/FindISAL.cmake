@@ -0,0 +1,39 @@
+find_package (PkgConfig REQUIRED)
+
+pkg_search_module (ISAL_PC
+  QUIET
+  libisal)
+
+find_library (ISAL_LIBRARY
+  NAMES isal
+  HINTS
+    ${ISAL_PC_LIBRARY_DIRS})
+
+find_path (ISAL_INCLUDE_DIR
+  NAMES isa-l/igzip_lib.h
+  HINTS
+    ${ISAL_PC_INCLUDE_DIRS})
+
+mark_as_advanced (
+  ISAL_LIBRARY
+  ISAL_INCLUDE_DIR)
+
+include (FindPackageHandleStandardArgs)
+
+find_package_handle_standard_args (ISAL
+  REQUIRED_VARS
+    ISAL_LIBRARY
+    ISAL_INCLUDE_DIR
+  VERSION_VAR ISAL_PC_VERSION)
+
+set (ISAL_LIBRARIES ${ISAL_LIBRARY})
+set (ISAL_INCLUDE_DIRS ${ISAL_INCLUDE_DIR})
+
+if (ISAL_FOUND AND NOT (TARGET ISAL::isal))
+  add_library (ISAL::isal UNKNOWN IMPORTED)
+
+  set_target_properties (ISAL::isal
+    PROPERTIES
+      IMPORTED_LOCATION ${ISAL_LIBRARY}
+      INTERFACE_INCLUDE_DIRECTORIES ${ISAL_INCLUDE_DIRS})
+endif ()
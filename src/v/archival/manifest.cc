@@ -0,0 +1,250 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "archival/manifest.h"
+
+#include "hashing/xx.h"
+#include "json/json.h"
+#include "storage/version.h"
+#include "utils/to_string.h"
+#include "vassert.h"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+
+namespace archival {
+
+static constexpr int manifest_version = 1;
+
+ss::sstring segment_meta::file_name() const {
+    return fmt::format(
+      "{}-{}-{}.log",
+      base_offset(),
+      term(),
+      storage::to_string(storage::record_version_type::v1));
+}
+
+std::ostream& operator<<(std::ostream& o, const segment_meta& m) {
+    fmt::print(
+      o,
+      "{{base_offset: {}, committed_offset: {}, term: {}, size_bytes: {}, "
+      "max_timestamp: {}, has_compaction_index: {}}}",
+      m.base_offset,
+      m.committed_offset,
+      m.term,
+      m.size_bytes,
+      m.max_timestamp,
+      m.has_compaction_index);
+    return o;
+}
+
+manifest::manifest(model::ntp ntp)
+  : _ntp(std::move(ntp)) {}
+
+ss::sstring manifest::prefix() const {
+    auto path = _ntp.path();
+    return fmt::format(
+      "{:08x}/{}", xxhash_32(path.data(), path.size()), path);
+}
+
+s3::object_key manifest::manifest_key() const {
+    return s3::object_key(fmt::format("{}/manifest.json", prefix()));
+}
+
+s3::object_key manifest::segment_key(const segment_meta& m) const {
+    return s3::object_key(fmt::format("{}/{}", prefix(), m.file_name()));
+}
+
+s3::object_key manifest::index_key(const segment_meta& m) const {
+    return s3::object_key(
+      fmt::format("{}/{}.base_index", prefix(), m.file_name()));
+}
+
+s3::object_key manifest::compaction_index_key(const segment_meta& m) const {
+    return s3::object_key(
+      fmt::format("{}/{}.compaction_index", prefix(), m.file_name()));
+}
+
+std::optional<model::offset> manifest::start_offset() const {
+    if (_segments.empty()) {
+        return std::nullopt;
+    }
+    return _segments.begin()->second.base_offset;
+}
+
+std::optional<model::offset> manifest::last_offset() const {
+    if (_segments.empty()) {
+        return std::nullopt;
+    }
+    return _segments.rbegin()->second.committed_offset;
+}
+
+const segment_meta* manifest::find(model::offset o) const {
+    auto it = _segments.upper_bound(o);
+    if (it == _segments.begin()) {
+        return nullptr;
+    }
+    --it;
+    return o <= it->second.committed_offset ? &it->second : nullptr;
+}
+
+void manifest::add(segment_meta m) {
+    vassert(
+      _segments.empty() || m.base_offset > *last_offset(),
+      "{} - archived segment {} overlaps {}",
+      _ntp,
+      m,
+      _segments.rbegin()->second);
+    auto base = m.base_offset;
+    _segments.emplace(base, std::move(m));
+}
+
+std::vector<segment_meta> manifest::apply_retention(
+  model::timestamp threshold, std::optional<size_t> max_bytes) {
+    std::vector<segment_meta> removed;
+    auto size = size_bytes();
+    while (!_segments.empty()) {
+        auto& front = _segments.begin()->second;
+        if (
+          front.max_timestamp >= threshold
+          && (!max_bytes || size <= *max_bytes)) {
+            break;
+        }
+        size -= front.size_bytes;
+        removed.push_back(front);
+        _segments.erase(_segments.begin());
+    }
+    return removed;
+}
+
+size_t manifest::size_bytes() const {
+    size_t size = 0;
+    for (const auto& [_, m] : _segments) {
+        size += m.size_bytes;
+    }
+    return size;
+}
+
+iobuf manifest::serialize() const {
+    rapidjson::StringBuffer buf;
+    rapidjson::Writer<rapidjson::StringBuffer> w(buf);
+    w.StartObject();
+    w.Key("version");
+    w.Int(manifest_version);
+    w.Key("namespace");
+    w.String(_ntp.ns().data(), _ntp.ns().size());
+    w.Key("topic");
+    w.String(_ntp.tp.topic().data(), _ntp.tp.topic().size());
+    w.Key("partition");
+    w.Int(_ntp.tp.partition());
+    w.Key("segments");
+    w.StartArray();
+    for (const auto& [_, m] : _segments) {
+        w.StartObject();
+        w.Key("base_offset");
+        w.Int64(m.base_offset());
+        w.Key("committed_offset");
+        w.Int64(m.committed_offset());
+        w.Key("term");
+        w.Int64(m.term());
+        w.Key("size_bytes");
+        w.Uint64(m.size_bytes);
+        w.Key("max_timestamp");
+        w.Int64(m.max_timestamp.value());
+        w.Key("compaction_index");
+        w.Bool(m.has_compaction_index);
+        w.EndObject();
+    }
+    w.EndArray();
+    w.EndObject();
+    iobuf out;
+    out.append(buf.GetString(), buf.GetSize());
+    return out;
+}
+
+static std::runtime_error
+invalid(const model::ntp& ntp, std::string_view why) {
+    return std::runtime_error(
+      fmt::format("{} - invalid archive manifest: {}", ntp, why));
+}
+
+manifest manifest::deserialize(model::ntp ntp, iobuf in) {
+    auto json = iobuf_to_bytes(in);
+    rapidjson::Document doc;
+    doc.Parse(
+      reinterpret_cast<const char*>(json.data()), json.size()); // NOLINT
+    if (doc.HasParseError() || !doc.IsObject()) {
+        throw invalid(ntp, "not a json object");
+    }
+    auto has = [&doc](const char* key, auto is) {
+        auto it = doc.FindMember(key);
+        return it != doc.MemberEnd() && is(it->value);
+    };
+    if (
+      !has("version", [](const auto& v) { return v.IsInt(); })
+      || doc["version"].GetInt() != manifest_version) {
+        throw invalid(ntp, "unsupported version");
+    }
+    if (
+      !has("namespace", [](const auto& v) { return v.IsString(); })
+      || !has("topic", [](const auto& v) { return v.IsString(); })
+      || !has("partition", [](const auto& v) { return v.IsInt(); })
+      || !has("segments", [](const auto& v) { return v.IsArray(); })) {
+        throw invalid(ntp, "missing fields");
+    }
+    if (
+      ntp.ns() != doc["namespace"].GetString()
+      || ntp.tp.topic() != doc["topic"].GetString()
+      || ntp.tp.partition() != doc["partition"].GetInt()) {
+        throw invalid(ntp, "manifest of another partition");
+    }
+    manifest m(std::move(ntp));
+    for (const auto& s : doc["segments"].GetArray()) {
+        if (
+          !s.IsObject() || !s.HasMember("base_offset")
+          || !s.HasMember("committed_offset") || !s.HasMember("term")
+          || !s.HasMember("size_bytes") || !s.HasMember("max_timestamp")
+          || !s.HasMember("compaction_index")) {
+            throw invalid(m.ntp(), "malformed segment");
+        }
+        segment_meta meta{
+          .base_offset = model::offset(s["base_offset"].GetInt64()),
+          .committed_offset = model::offset(s["committed_offset"].GetInt64()),
+          .term = model::term_id(s["term"].GetInt64()),
+          .size_bytes = s["size_bytes"].GetUint64(),
+          .max_timestamp = model::timestamp(s["max_timestamp"].GetInt64()),
+          .has_compaction_index = s["compaction_index"].GetBool(),
+        };
+        if (
+          meta.committed_offset < meta.base_offset
+          || (!m.empty() && meta.base_offset <= *m.last_offset())) {
+            throw invalid(m.ntp(), "segments out of order");
+        }
+        m.add(meta);
+    }
+    return m;
+}
+
+std::ostream& operator<<(std::ostream& o, const manifest& m) {
+    fmt::print(
+      o,
+      "{{ntp: {}, segments: {}, start_offset: {}, last_offset: {}}}",
+      m._ntp,
+      m._segments.size(),
+      m.start_offset(),
+      m.last_offset());
+    return o;
+}
+
+} // namespace archival
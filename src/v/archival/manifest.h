@@ -0,0 +1,106 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "model/fundamental.h"
+#include "model/timestamp.h"
+#include "s3/client.h"
+#include "seastarx.h"
+
+#include <seastar/core/sstring.hh>
+
+#include <iosfwd>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace archival {
+
+/// A segment uploaded to object storage
+struct segment_meta {
+    model::offset base_offset;
+    model::offset committed_offset;
+    model::term_id term;
+    size_t size_bytes{0};
+    model::timestamp max_timestamp;
+    /// the compaction index was uploaded with the segment
+    bool has_compaction_index{false};
+
+    /// name of the segment file, as it is named in a log directory
+    ss::sstring file_name() const;
+
+    friend std::ostream& operator<<(std::ostream&, const segment_meta&);
+};
+
+/*
+ * The segments of a partition that were uploaded to object storage.
+ *
+ * The manifest is itself stored as a json object next to the segments, and
+ * is the source of truth for what is archived: a segment is uploaded before
+ * it is added to the manifest, and removed from the manifest before it is
+ * removed from object storage.
+ *
+ * The objects of a partition are under a prefix made of a hash of the
+ * partition and its path, so that partitions spread over the key space of
+ * the bucket, e.g. 9fbb4e1d/kafka/topic/0/0-1-v1.log
+ */
+class manifest {
+public:
+    using segments_t = std::map<model::offset, segment_meta>;
+
+    explicit manifest(model::ntp ntp);
+
+    const model::ntp& ntp() const { return _ntp; }
+
+    s3::object_key manifest_key() const;
+    s3::object_key segment_key(const segment_meta&) const;
+    s3::object_key index_key(const segment_meta&) const;
+    s3::object_key compaction_index_key(const segment_meta&) const;
+
+    /// first archived offset
+    std::optional<model::offset> start_offset() const;
+    /// last archived offset
+    std::optional<model::offset> last_offset() const;
+    /// the archived segment holding the offset
+    const segment_meta* find(model::offset) const;
+
+    /// appends a segment, which starts after the last archived offset
+    void add(segment_meta);
+
+    /// \brief Removes the oldest segments beyond the retention
+    ///
+    /// Segments whose records are all older than the threshold are removed,
+    /// then the oldest segments until the archive fits in max_bytes.
+    ///
+    /// \return the removed segments, oldest first
+    std::vector<segment_meta> apply_retention(
+      model::timestamp threshold, std::optional<size_t> max_bytes);
+
+    size_t size_bytes() const;
+    const segments_t& segments() const { return _segments; }
+    bool empty() const { return _segments.empty(); }
+
+    iobuf serialize() const;
+    /// \throws std::runtime_error if the json is not a manifest of the ntp
+    static manifest deserialize(model::ntp, iobuf);
+
+    friend std::ostream& operator<<(std::ostream&, const manifest&);
+
+private:
+    ss::sstring prefix() const;
+
+    model::ntp _ntp;
+    segments_t _segments;
+};
+
+} // namespace archival
@@ -0,0 +1,290 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "archival/ntp_archiver.h"
+
+#include "archival/logger.h"
+#include "storage/lock_manager.h"
+#include "storage/log_reader.h"
+#include "storage/segment_set.h"
+#include "vlog.h"
+
+#include <seastar/core/fstream.hh>
+#include <seastar/core/loop.hh>
+
+namespace archival {
+
+/// how often the followers download the manifest, in upload intervals
+static constexpr int follower_sync_intervals = 10;
+
+remote_partition::remote_partition(
+  ss::lw_shared_ptr<const manifest> m, segment_cache& cache)
+  : _manifest(std::move(m))
+  , _cache(cache) {}
+
+static model::record_batch_reader empty_reader() {
+    return model::make_memory_record_batch_reader(
+      model::record_batch_reader::data_t{});
+}
+
+ss::future<model::record_batch_reader>
+remote_partition::make_reader(storage::log_reader_config cfg) {
+    // reads stop at the end of the archived segment, readers continue from
+    // the next offset
+    const auto* found = _manifest->find(cfg.start_offset);
+    if (!found) {
+        return ss::make_ready_future<model::record_batch_reader>(
+          empty_reader());
+    }
+    auto meta = *found;
+    return _cache.get(*_manifest, meta)
+      .then([](segment_cache::segment_ptr seg) {
+          return seg->read_lock().then([seg](ss::rwlock::holder h) {
+              return std::make_pair(seg, std::move(h));
+          });
+      })
+      .then([this, self = shared_from_this(), meta, cfg](
+              std::pair<segment_cache::segment_ptr, ss::rwlock::holder>
+                locked) mutable {
+          auto& [seg, h] = locked;
+          if (seg->is_closed()) {
+              // evicted while waiting for the lock
+              return empty_reader();
+          }
+          storage::segment_set::underlying_t segs;
+          segs.push_back(seg);
+          auto lease = std::make_unique<storage::lock_manager::lease>(
+            storage::segment_set(std::move(segs)));
+          lease->locks.push_back(std::move(h));
+          cfg.max_offset = std::min(cfg.max_offset, meta.committed_offset);
+          return model::make_record_batch_reader<storage::log_reader>(
+            std::move(lease), cfg, _cache.probe());
+      });
+}
+
+ntp_archiver::ntp_archiver(
+  ss::lw_shared_ptr<cluster::partition> partition,
+  storage::log log,
+  const configuration& config,
+  remote& remote,
+  segment_cache& cache)
+  : _partition(std::move(partition))
+  , _log(std::move(log))
+  , _config(config)
+  , _remote(remote)
+  , _manifest(ss::make_lw_shared<manifest>(_partition->ntp()))
+  , _reader(ss::make_shared<remote_partition>(_manifest, cache)) {
+    _partition->set_archive_reader(_reader);
+}
+
+ss::future<> ntp_archiver::run() {
+    return ss::with_gate(_gate, [this] {
+        if (_partition->is_leader()) {
+            return upload();
+        }
+        // the manifest is downloaded again if leadership comes back, as
+        // another leader may have changed it meanwhile
+        _synced = false;
+        return sync_manifest();
+    });
+}
+
+ss::future<> ntp_archiver::stop() {
+    _partition->set_archive_reader(nullptr);
+    return _gate.close();
+}
+
+ss::future<> ntp_archiver::upload() {
+    auto f = _synced ? ss::now() : download_manifest().then([this] {
+        _synced = true;
+    });
+    return f
+      .then([this] {
+          return ss::repeat([this] {
+              return upload_next_segment().then([](bool uploaded) {
+                  return uploaded ? ss::stop_iteration::no
+                                  : ss::stop_iteration::yes;
+              });
+          });
+      })
+      .then([this] { return apply_retention(); })
+      .handle_exception([this](std::exception_ptr e) {
+          // the manifest in the bucket is the source of truth, the next run
+          // starts over from it
+          _synced = false;
+          return ss::make_exception_future<>(e);
+      });
+}
+
+ss::future<> ntp_archiver::sync_manifest() {
+    auto now = ss::lowres_clock::now();
+    if (now - _last_sync < _config.upload_interval * follower_sync_intervals) {
+        return ss::now();
+    }
+    _last_sync = now;
+    return download_manifest();
+}
+
+ss::future<> ntp_archiver::download_manifest() {
+    return ss::do_with(iobuf(), [this](iobuf& buf) {
+        return _remote
+          .download(
+            _manifest->manifest_key(),
+            [&buf](iobuf chunk) {
+                buf.append(std::move(chunk));
+                return ss::now();
+            })
+          .then([this, &buf] {
+              *_manifest = manifest::deserialize(ntp(), std::move(buf));
+              vlog(archival_log.debug, "Downloaded manifest {}", *_manifest);
+              manifest_changed();
+          })
+          .handle_exception_type([](const s3::rest_error_response& e) {
+              if (e.is_not_found()) {
+                  // nothing was archived yet
+                  return ss::now();
+              }
+              return ss::make_exception_future<>(e);
+          });
+    });
+}
+
+ss::future<> ntp_archiver::upload_manifest() {
+    auto buf = _manifest->serialize();
+    auto size = buf.size_bytes();
+    return _remote.upload(
+      _manifest->manifest_key(),
+      size,
+      make_iobuf_input_stream(std::move(buf)));
+}
+
+ss::future<bool> ntp_archiver::upload_next_segment() {
+    auto next = _manifest->last_offset()
+                  ? *_manifest->last_offset() + model::offset(1)
+                  : _log.offsets().start_offset;
+    auto end = _log.closed_segment_end(next);
+    if (!end || *end > _partition->committed_offset()) {
+        return ss::make_ready_future<bool>(false);
+    }
+    return _log.open_closed_segment(next).then(
+      [this, next](std::optional<storage::segment_files> files) {
+          if (!files) {
+              vlog(
+                archival_log.debug,
+                "{} - no segment starts at {}, archiving is stalled",
+                ntp(),
+                next);
+              return ss::make_ready_future<bool>(false);
+          }
+          return ss::do_with(
+            std::move(*files), [this](storage::segment_files& files) {
+                segment_meta meta{
+                  .base_offset = files.base_offset,
+                  .committed_offset = files.dirty_offset,
+                  .term = files.term,
+                  .size_bytes = files.data_size,
+                  .max_timestamp = files.max_timestamp,
+                  .has_compaction_index = files.compaction_index.has_value(),
+                };
+                return upload_segment(meta, files)
+                  .then([this, meta] {
+                      _manifest->add(meta);
+                      return upload_manifest();
+                  })
+                  .then([this, meta] {
+                      vlog(
+                        archival_log.debug,
+                        "{} - archived segment {}",
+                        ntp(),
+                        meta);
+                      manifest_changed();
+                      return true;
+                  })
+                  .finally([&files] { return files.close(); });
+            });
+      });
+}
+
+ss::future<> ntp_archiver::upload_segment(
+  const segment_meta& meta, storage::segment_files& files) {
+    return _remote
+      .upload(
+        _manifest->segment_key(meta),
+        files.data_size,
+        ss::make_file_input_stream(files.data, 0, files.data_size))
+      .then([this, meta, &files] {
+          return _remote.upload(
+            _manifest->index_key(meta),
+            files.index_size,
+            ss::make_file_input_stream(files.index, 0, files.index_size));
+      })
+      .then([this, meta, &files] {
+          if (!files.compaction_index) {
+              return ss::now();
+          }
+          return _remote.upload(
+            _manifest->compaction_index_key(meta),
+            files.compaction_index_size,
+            ss::make_file_input_stream(
+              *files.compaction_index, 0, files.compaction_index_size));
+      });
+}
+
+ss::future<> ntp_archiver::apply_retention() {
+    auto threshold = model::timestamp(
+      model::timestamp::now().value() - _config.delete_retention.count());
+    auto removed = _manifest->apply_retention(
+      threshold, _config.retention_bytes);
+    if (removed.empty()) {
+        return ss::now();
+    }
+    vlog(
+      archival_log.info,
+      "{} - removing {} archived segments, from {} to {}",
+      ntp(),
+      removed.size(),
+      removed.front().base_offset,
+      removed.back().committed_offset);
+    return upload_manifest().then(
+      [this, removed = std::move(removed)]() mutable {
+        return ss::do_with(
+          std::move(removed), [this](std::vector<segment_meta>& removed) {
+              return ss::do_for_each(removed, [this](const segment_meta& m) {
+                  return _remote.remove(_manifest->segment_key(m))
+                    .then([this, m] {
+                        return _remote.remove(_manifest->index_key(m));
+                    })
+                    .then([this, m] {
+                        if (!m.has_compaction_index) {
+                            return ss::now();
+                        }
+                        return _remote.remove(
+                          _manifest->compaction_index_key(m));
+                    })
+                    .handle_exception([this, m](std::exception_ptr e) {
+                        // no longer in the manifest, the objects are leaked
+                        vlog(
+                          archival_log.warn,
+                          "{} - error removing archived segment {}: {}",
+                          ntp(),
+                          m,
+                          e);
+                    });
+              });
+          });
+    });
+}
+
+void ntp_archiver::manifest_changed() {
+    if (auto last = _manifest->last_offset()) {
+        _log.set_archived_offset(*last);
+    }
+}
+
+} // namespace archival
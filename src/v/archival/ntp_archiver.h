@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "archival/manifest.h"
+#include "archival/remote.h"
+#include "archival/segment_cache.h"
+#include "archival/types.h"
+#include "cluster/partition.h"
+#include "seastarx.h"
+#include "storage/log.h"
+#include "storage/segment_transfer.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/shared_ptr.hh>
+
+namespace archival {
+
+/// Serves the reads below the local start offset of a partition from its
+/// archived segments
+class remote_partition final
+  : public cluster::archive_reader
+  , public ss::enable_shared_from_this<remote_partition> {
+public:
+    /// the manifest is updated by the archiver of the partition
+    remote_partition(ss::lw_shared_ptr<const manifest>, segment_cache&);
+
+    std::optional<model::offset> start_offset() const final {
+        return _manifest->start_offset();
+    }
+
+    ss::future<model::record_batch_reader>
+      make_reader(storage::log_reader_config) final;
+
+private:
+    ss::lw_shared_ptr<const manifest> _manifest;
+    segment_cache& _cache;
+};
+
+/*
+ * Archives a partition of the shard.
+ *
+ * On the leader, the closed segments of the log that are fully committed are
+ * uploaded in order, each with its index and compaction index, and then
+ * added to the manifest, which is uploaded after them. The log may then
+ * evict them from disk (see storage::log::set_archived_offset). Segments
+ * that fall out of the retention of the partition are removed from the
+ * manifest, and then from the bucket.
+ *
+ * The other replicas download the manifest from time to time, so that they
+ * evict the segments the leader uploaded.
+ *
+ * Archiving stops at a segment that does not start right after the last
+ * archived offset, which can only happen when adjacent segments of a
+ * compacted topic were merged after some of them were archived.
+ */
+class ntp_archiver {
+public:
+    ntp_archiver(
+      ss::lw_shared_ptr<cluster::partition>,
+      storage::log,
+      const configuration&,
+      remote&,
+      segment_cache&);
+
+    const model::ntp& ntp() const { return _partition->ntp(); }
+    const ss::lw_shared_ptr<cluster::partition>& partition() const {
+        return _partition;
+    }
+
+    /// \brief archives what is new, as leader, or syncs the manifest
+    ss::future<> run();
+
+    /// \brief waits for the pending run, and stops serving reads
+    ss::future<> stop();
+
+private:
+    ss::future<> upload();
+    ss::future<> sync_manifest();
+    ss::future<> download_manifest();
+    ss::future<> upload_manifest();
+    /// \return false when there was nothing to upload
+    ss::future<bool> upload_next_segment();
+    ss::future<> upload_segment(const segment_meta&, storage::segment_files&);
+    ss::future<> apply_retention();
+    /// publishes a change of the manifest to reads and to the log
+    void manifest_changed();
+
+    ss::lw_shared_ptr<cluster::partition> _partition;
+    storage::log _log;
+    const configuration& _config;
+    remote& _remote;
+    ss::lw_shared_ptr<manifest> _manifest;
+    ss::shared_ptr<remote_partition> _reader;
+    /// the manifest was downloaded once, as leader
+    bool _synced{false};
+    ss::lowres_clock::time_point _last_sync;
+    ss::gate _gate;
+};
+
+} // namespace archival
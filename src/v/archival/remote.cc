@@ -0,0 +1,76 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "archival/remote.h"
+
+#include "archival/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/timer.hh>
+
+namespace archival {
+
+namespace {
+/// a connection, shut down when the request takes too long
+struct request {
+    explicit request(const s3::configuration& cfg)
+      : client(cfg) {
+        timeout.set_callback([this] { client.shutdown(); });
+    }
+
+    s3::client client;
+    ss::timer<ss::lowres_clock> timeout;
+};
+} // namespace
+
+remote::remote(const configuration& cfg)
+  : _config(cfg) {}
+
+template<typename Func>
+ss::future<> remote::with_client(Func f) {
+    return ss::with_gate(_gate, [this, f = std::move(f)]() mutable {
+        auto r = ss::make_lw_shared<request>(_config.client_config);
+        r->timeout.arm(_config.request_timeout);
+        return ss::futurize_invoke(f, r->client).finally([r] {
+            r->timeout.cancel();
+            return r->client.stop().finally([r] {});
+        });
+    });
+}
+
+ss::future<> remote::upload(
+  const s3::object_key& key, size_t size, ss::input_stream<char> body) {
+    vlog(archival_log.trace, "uploading {} ({} bytes)", key, size);
+    return with_client([this, key, size, body = std::move(body)](
+                         s3::client& c) mutable {
+        return c.put_object(_config.bucket, key, size, std::move(body));
+    });
+}
+
+ss::future<> remote::download(
+  const s3::object_key& key,
+  s3::client::body_consumer consume,
+  std::optional<s3::byte_range> range) {
+    vlog(archival_log.trace, "downloading {}", key);
+    return with_client(
+      [this, key, range, consume = std::move(consume)](s3::client& c) mutable {
+          return c.get_object(_config.bucket, key, std::move(consume), range);
+      });
+}
+
+ss::future<> remote::remove(const s3::object_key& key) {
+    vlog(archival_log.trace, "removing {}", key);
+    return with_client([this, key](s3::client& c) {
+        return c.delete_object(_config.bucket, key);
+    });
+}
+
+} // namespace archival
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "archival/types.h"
+#include "s3/client.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/iostream.hh>
+
+#include <optional>
+
+namespace archival {
+
+/// Requests to the bucket of the archive.
+///
+/// Each request opens its own connection, so that requests of different
+/// partitions run in parallel, and is failed if it does not complete within
+/// the request timeout.
+class remote {
+public:
+    explicit remote(const configuration&);
+
+    /// \brief uploads size bytes of the stream, which is closed once done
+    ss::future<>
+    upload(const s3::object_key&, size_t size, ss::input_stream<char>);
+
+    /// \brief downloads an object, or a range of it, handing its body to the
+    /// consumer
+    ss::future<> download(
+      const s3::object_key&,
+      s3::client::body_consumer consume,
+      std::optional<s3::byte_range> range = std::nullopt);
+
+    ss::future<> remove(const s3::object_key&);
+
+    /// \brief waits for the pending requests
+    ss::future<> stop() { return _gate.close(); }
+
+private:
+    template<typename Func>
+    ss::future<> with_client(Func f);
+
+    const configuration& _config;
+    ss::gate _gate;
+};
+
+} // namespace archival
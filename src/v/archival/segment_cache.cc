@@ -0,0 +1,568 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "archival/segment_cache.h"
+
+#include "archival/logger.h"
+#include "units.h"
+#include "utils/directory_walker.h"
+#include "vlog.h"
+
+#include <seastar/core/align.hh>
+#include <seastar/core/aligned_buffer.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/seastar.hh>
+
+#include <boost/range/irange.hpp>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace archival {
+
+template<typename Func>
+auto segment_cache::with_chunks(
+  const segment_chunks_ptr& c, uint64_t pos, size_t len, Func read) {
+    using futurator = ss::futurize<std::invoke_result_t<Func>>;
+    const auto end = std::min<uint64_t>(pos + len, c->size_bytes);
+    if (pos >= end) {
+        return futurator::invoke(std::move(read));
+    }
+    const size_t first = pos / _chunk_size;
+    const size_t last = (end - 1) / _chunk_size;
+    // pinned chunks are not evicted until the read is done
+    for (size_t i = first; i <= last; ++i) {
+        ++c->chunks[i].pins;
+    }
+    prefetch(c, first, last);
+    return ss::parallel_for_each(
+             boost::irange(first, last + 1),
+             [this, c](size_t i) { return fetch_chunk(c, i); })
+      .then(std::move(read))
+      .finally([this, c, first, last] {
+          for (size_t i = first; i <= last; ++i) {
+              --c->chunks[i].pins;
+          }
+          trim();
+      });
+}
+
+/*
+ * The data file of a cached segment: reads wait for the chunks they touch
+ * to be downloaded, everything else goes to the local file.
+ */
+class segment_cache::chunked_file final : public ss::file_impl {
+public:
+    chunked_file(ss::file f, segment_cache& cache, segment_chunks_ptr chunks)
+      : _file(std::move(f))
+      , _cache(cache)
+      , _chunks(std::move(chunks)) {}
+
+    ss::future<size_t> read_dma(
+      uint64_t pos,
+      void* buffer,
+      size_t len,
+      const ss::io_priority_class& pc) final {
+        return _cache.with_chunks(
+          _chunks, pos, len, [this, pos, buffer, len, pc] {
+              return get_file_impl(_file)->read_dma(pos, buffer, len, pc);
+          });
+    }
+
+    ss::future<size_t> read_dma(
+      uint64_t pos,
+      std::vector<iovec> iov,
+      const ss::io_priority_class& pc) final {
+        auto len = std::accumulate(
+          iov.begin(), iov.end(), size_t(0), [](size_t acc, const iovec& v) {
+              return acc + v.iov_len;
+          });
+        return _cache.with_chunks(
+          _chunks, pos, len, [this, pos, iov = std::move(iov), pc]() mutable {
+              return get_file_impl(_file)->read_dma(pos, std::move(iov), pc);
+          });
+    }
+
+    ss::future<ss::temporary_buffer<uint8_t>> dma_read_bulk(
+      uint64_t offset,
+      size_t range_size,
+      const ss::io_priority_class& pc) final {
+        return _cache.with_chunks(
+          _chunks, offset, range_size, [this, offset, range_size, pc] {
+              return get_file_impl(_file)->dma_read_bulk(
+                offset, range_size, pc);
+          });
+    }
+
+    ss::future<size_t> write_dma(
+      uint64_t pos,
+      const void* buffer,
+      size_t len,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->write_dma(pos, buffer, len, pc);
+    }
+
+    ss::future<size_t> write_dma(
+      uint64_t pos,
+      std::vector<iovec> iov,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->write_dma(pos, std::move(iov), pc);
+    }
+
+    ss::future<> flush() final { return get_file_impl(_file)->flush(); }
+
+    ss::future<struct stat> stat() final {
+        return get_file_impl(_file)->stat();
+    }
+
+    ss::future<> truncate(uint64_t length) final {
+        return get_file_impl(_file)->truncate(length);
+    }
+
+    ss::future<> discard(uint64_t offset, uint64_t length) final {
+        return get_file_impl(_file)->discard(offset, length);
+    }
+
+    ss::future<> allocate(uint64_t position, uint64_t length) final {
+        return get_file_impl(_file)->allocate(position, length);
+    }
+
+    ss::future<uint64_t> size() final { return get_file_impl(_file)->size(); }
+
+    ss::future<> close() final { return get_file_impl(_file)->close(); }
+
+    std::unique_ptr<ss::file_handle_impl> dup() final {
+        return get_file_impl(_file)->dup();
+    }
+
+    ss::subscription<ss::directory_entry> list_directory(
+      std::function<ss::future<>(ss::directory_entry de)> next) final {
+        return get_file_impl(_file)->list_directory(std::move(next));
+    }
+
+private:
+    ss::file _file;
+    segment_cache& _cache;
+    segment_chunks_ptr _chunks;
+};
+
+/// removes the content of a directory
+static ss::future<> clear_directory(std::filesystem::path dir) {
+    return directory_walker::walk(
+      dir.string(), [dir](const ss::directory_entry& de) {
+          auto path = dir / de.name.c_str();
+          auto f = de.type && *de.type == ss::directory_entry_type::directory
+                     ? clear_directory(path)
+                     : ss::now();
+          return f.then([path] { return ss::remove_file(path.string()); });
+      });
+}
+
+segment_cache::segment_cache(
+  std::filesystem::path dir,
+  size_t capacity,
+  size_t chunk_size,
+  size_t prefetch_chunks,
+  remote& remote,
+  storage::log_manager& log_manager)
+  : _dir(std::move(dir))
+  , _capacity(capacity)
+  , _chunk_size(ss::align_up(std::max<size_t>(chunk_size, 1), 4_KiB))
+  , _prefetch_chunks(prefetch_chunks)
+  , _remote(remote)
+  , _log_manager(log_manager) {}
+
+ss::future<> segment_cache::start() {
+    return ss::recursive_touch_directory(_dir.string()).then([this] {
+        return clear_directory(_dir);
+    });
+}
+
+ss::future<> segment_cache::stop() {
+    return _gate.close().then([this] {
+        _lru.clear();
+        _size_bytes = 0;
+        return ss::do_with(
+          std::exchange(_segments, {}),
+          [](absl::flat_hash_map<ss::sstring, entry>& segments) {
+              return ss::parallel_for_each(
+                segments, [](std::pair<const ss::sstring, entry>& e) {
+                    return e.second.segment->close().then(
+                      [c = e.second.chunks] { return c->writer.close(); });
+                });
+          });
+    });
+}
+
+ss::future<segment_cache::segment_ptr>
+segment_cache::get(const manifest& m, const segment_meta& meta) {
+    auto path = _dir / m.ntp().path().c_str() / meta.file_name().c_str();
+    auto key = ss::sstring(path.string());
+    return get_or_open(
+      std::move(key),
+      location{
+        .path = std::move(path),
+        .data = m.segment_key(meta),
+        .index = m.index_key(meta),
+        .size_bytes = meta.size_bytes,
+      });
+}
+
+ss::future<segment_cache::segment_ptr>
+segment_cache::get_or_open(ss::sstring key, location loc) {
+    if (auto it = _segments.find(key); it != _segments.end()) {
+        return ss::make_ready_future<segment_ptr>(it->second.segment);
+    }
+    if (auto it = _downloads.find(key); it != _downloads.end()) {
+        return it->second.get_future();
+    }
+    if (auto it = _evictions.find(key); it != _evictions.end()) {
+        // the files of the evicted segment are still being removed
+        return it->second.get_future().then(
+          [this, key = std::move(key), loc = std::move(loc)]() mutable {
+              return get_or_open(std::move(key), std::move(loc));
+          });
+    }
+    if (_gate.is_closed()) {
+        return ss::make_exception_future<segment_ptr>(
+          ss::gate_closed_exception());
+    }
+    auto f = ss::with_gate(
+               _gate,
+               [this, key, loc = std::move(loc)]() mutable {
+                   return open(key, std::move(loc))
+                     .then([this, key](entry e) {
+                         auto seg = e.segment;
+                         insert(key, std::move(e));
+                         return seg;
+                     });
+               })
+               .finally([this, key] { _downloads.erase(key); });
+    auto [it, _] = _downloads.emplace(
+      key, ss::shared_future<segment_ptr>(std::move(f)));
+    return it->second.get_future();
+}
+
+ss::future<segment_cache::entry>
+segment_cache::open(ss::sstring key, location loc) {
+    vlog(archival_log.debug, "opening archived segment {}", loc.path);
+    auto index_path = loc.path;
+    index_path.replace_extension("base_index");
+    return ss::recursive_touch_directory(loc.path.parent_path().string())
+      .then([this, index = loc.index, index_path] {
+          return download_file(index, index_path);
+      })
+      .then([this, key = std::move(key), loc = std::move(loc)](
+              size_t index_bytes) mutable {
+          // the data file is sparse until its chunks are read
+          const auto flags = ss::open_flags::rw | ss::open_flags::create
+                             | ss::open_flags::truncate;
+          return ss::open_file_dma(loc.path.string(), flags)
+            .then([loc](ss::file writer) {
+                return writer.truncate(loc.size_bytes).then([writer] {
+                    return writer;
+                });
+            })
+            .then([this, key = std::move(key), loc, index_bytes](
+                    ss::file writer) mutable {
+                auto c = ss::make_lw_shared<segment_chunks>();
+                c->key = std::move(key);
+                c->object = loc.data;
+                c->size_bytes = loc.size_bytes;
+                c->writer = std::move(writer);
+                c->chunks.resize(
+                  (loc.size_bytes + _chunk_size - 1) / _chunk_size);
+                return _log_manager
+                  .open_log_segment(
+                    loc.path,
+                    [this, c](ss::file f) {
+                        return ss::file(ss::make_shared<chunked_file>(
+                          std::move(f), *this, c));
+                    })
+                  .then([](segment_ptr seg) {
+                      return seg->materialize_index().then([seg](bool valid) {
+                          if (!valid) {
+                              return seg->close().then([seg] {
+                                  return ss::make_exception_future<
+                                    segment_ptr>(std::runtime_error(fmt::format(
+                                    "Archived segment has an invalid index: {}",
+                                    seg)));
+                              });
+                          }
+                          seg->force_set_commit_offset_from_index();
+                          return ss::make_ready_future<segment_ptr>(seg);
+                      });
+                  })
+                  .then_wrapped([c, index_bytes](ss::future<segment_ptr> f) {
+                      if (f.failed()) {
+                          return c->writer.close().then(
+                            [e = f.get_exception()] {
+                                return ss::make_exception_future<entry>(e);
+                            });
+                      }
+                      return ss::make_ready_future<entry>(
+                        entry{f.get0(), c, index_bytes});
+                  });
+            });
+      });
+}
+
+ss::future<size_t> segment_cache::download_file(
+  const s3::object_key& key, std::filesystem::path path) {
+    const auto flags = ss::open_flags::wo | ss::open_flags::create
+                       | ss::open_flags::truncate;
+    return ss::open_file_dma(path.string(), flags)
+      .then(
+        [](ss::file f) { return ss::make_file_output_stream(std::move(f)); })
+      .then([this, key](ss::output_stream<char> out) {
+          return ss::do_with(
+            std::move(out),
+            size_t(0),
+            [this, key](ss::output_stream<char>& out, size_t& size) {
+                return _remote
+                  .download(
+                    key,
+                    [&out, &size](iobuf buf) {
+                        size += buf.size_bytes();
+                        return write_iobuf_to_output_stream(
+                          std::move(buf), out);
+                    })
+                  .then([&out] { return out.flush(); })
+                  .finally([&out] { return out.close(); })
+                  .then([&size] { return size; });
+            });
+      });
+}
+
+void segment_cache::insert(const ss::sstring& key, entry e) {
+    _size_bytes += e.index_bytes;
+    _segments.emplace(key, std::move(e));
+    trim();
+}
+
+void segment_cache::prefetch(
+  const segment_chunks_ptr& c, size_t first, size_t last) {
+    // a read may start in the chunk the previous one ended in
+    const bool sequential = first == c->next_read
+                            || first + 1 == c->next_read;
+    c->next_read = last + 1;
+    if (!sequential) {
+        return;
+    }
+    const auto end = std::min(c->chunks.size(), last + 1 + _prefetch_chunks);
+    for (size_t i = last + 1; i < end; ++i) {
+        const auto& ch = c->chunks[i];
+        if (ch.present || ch.download) {
+            continue;
+        }
+        (void)fetch_chunk(c, i).handle_exception(
+          [key = c->key, i](std::exception_ptr e) {
+              vlog(
+                archival_log.debug,
+                "Error prefetching chunk {} of {}: {}",
+                i,
+                key,
+                e);
+          });
+    }
+}
+
+ss::future<>
+segment_cache::fetch_chunk(const segment_chunks_ptr& c, size_t i) {
+    auto& ch = c->chunks[i];
+    if (ch.present) {
+        if (!c->evicted) {
+            _lru.splice(_lru.begin(), _lru, ch.lru);
+        }
+        return ss::now();
+    }
+    if (ch.download) {
+        return ch.download->get_future();
+    }
+    if (_gate.is_closed() || c->ops.is_closed()) {
+        return ss::make_exception_future<>(ss::gate_closed_exception());
+    }
+    // a chunk evicted just before is punched out first
+    auto discarded = ch.discard ? ch.discard->get_future() : ss::now();
+    auto f = ss::with_gate(
+               _gate,
+               [this, c, i, discarded = std::move(discarded)]() mutable {
+                   return ss::with_gate(
+                     c->ops,
+                     [this, c, i, discarded = std::move(discarded)]() mutable {
+                         return discarded.then(
+                           [this, c, i] { return download_chunk(c, i); });
+                     });
+               })
+               .then([this, c, i] { chunk_downloaded(c, i); })
+               .finally([c, i] { c->chunks[i].download.reset(); });
+    ch.download.emplace(std::move(f));
+    return ch.download->get_future();
+}
+
+ss::future<>
+segment_cache::download_chunk(const segment_chunks_ptr& c, size_t i) {
+    const size_t offset = i * _chunk_size;
+    const size_t len = chunk_size(*c, i);
+    return ss::do_with(iobuf(), [this, c, offset, len](iobuf& buf) {
+        return _remote
+          .download(
+            c->object,
+            [&buf](iobuf chunk) {
+                buf.append(std::move(chunk));
+                return ss::now();
+            },
+            s3::byte_range{.first = offset, .last = offset + len - 1})
+          .then([c, offset, len, &buf] {
+              if (buf.size_bytes() != len) {
+                  return ss::make_exception_future<>(
+                    std::runtime_error(fmt::format(
+                      "Downloaded {} bytes of {} at {}, expected {}",
+                      buf.size_bytes(),
+                      c->key,
+                      offset,
+                      len)));
+              }
+              // dma writes are padded up to the alignment of the file
+              const auto aligned = ss::align_up(
+                len, c->writer.disk_write_dma_alignment());
+              auto data = ss::allocate_aligned_buffer<char>(
+                aligned, c->writer.memory_dma_alignment());
+              size_t copied = 0;
+              for (const auto& frag : buf) {
+                  std::copy_n(frag.get(), frag.size(), data.get() + copied);
+                  copied += frag.size();
+              }
+              std::fill(data.get() + len, data.get() + aligned, 0);
+              auto ptr = data.get();
+              return c->writer.dma_write(offset, ptr, aligned)
+                .then([c, offset, len, aligned, data = std::move(data)](
+                        size_t written) {
+                    if (written != aligned) {
+                        return ss::make_exception_future<>(
+                          std::runtime_error(fmt::format(
+                            "Short write of {} at {}: {} of {} bytes",
+                            c->key,
+                            offset,
+                            written,
+                            aligned)));
+                    }
+                    if (offset + len == c->size_bytes && aligned != len) {
+                        // the padding of the last chunk is cut off
+                        return c->writer.truncate(c->size_bytes);
+                    }
+                    return ss::now();
+                });
+          });
+    });
+}
+
+void segment_cache::chunk_downloaded(const segment_chunks_ptr& c, size_t i) {
+    auto& ch = c->chunks[i];
+    ch.present = true;
+    ++c->present;
+    if (c->evicted) {
+        return;
+    }
+    _lru.push_front(chunk_ref{.segment = c, .index = i});
+    ch.lru = _lru.begin();
+    _size_bytes += chunk_size(*c, i);
+    trim();
+}
+
+size_t segment_cache::chunk_size(const segment_chunks& c, size_t i) const {
+    return std::min(_chunk_size, c.size_bytes - i * _chunk_size);
+}
+
+void segment_cache::trim() {
+    if (_gate.is_closed()) {
+        // stop() closes the segments
+        return;
+    }
+    auto it = _lru.end();
+    while (_size_bytes > _capacity && it != _lru.begin()) {
+        --it;
+        auto c = it->segment;
+        const auto i = it->index;
+        auto& ch = c->chunks[i];
+        if (ch.pins > 0) {
+            continue;
+        }
+        const auto len = chunk_size(*c, i);
+        it = _lru.erase(it);
+        ch.present = false;
+        --c->present;
+        _size_bytes -= len;
+        auto f = ss::with_gate(_gate, [c, i, offset = i * _chunk_size, len] {
+            return ss::with_gate(c->ops, [c, offset, len] {
+                return c->writer.discard(offset, len);
+            });
+        });
+        ch.discard.emplace(std::move(f));
+        (void)ch.discard->get_future()
+          .handle_exception([key = c->key](std::exception_ptr e) {
+              vlog(
+                archival_log.warn,
+                "Error evicting a chunk of {}: {}",
+                key,
+                e);
+          })
+          .finally([c, i] { c->chunks[i].discard.reset(); });
+        if (c->present == 0) {
+            evict_segment(c->key);
+        }
+    }
+}
+
+void segment_cache::evict_segment(const ss::sstring& key) {
+    auto it = _segments.find(key);
+    if (it == _segments.end()) {
+        return;
+    }
+    auto e = std::move(it->second);
+    _segments.erase(it);
+    e.chunks->evicted = true;
+    _size_bytes -= e.index_bytes;
+    auto f = ss::with_gate(
+      _gate, [this, e = std::move(e)]() mutable {
+          return close_segment(std::move(e));
+      });
+    auto [ev, _] = _evictions.emplace(key, ss::shared_future<>(std::move(f)));
+    (void)ev->second.get_future().finally(
+      [this, key] { _evictions.erase(key); });
+}
+
+ss::future<> segment_cache::close_segment(entry e) {
+    auto seg = e.segment;
+    auto c = e.chunks;
+    // waits for the readers of the segment, then for its pending downloads
+    return seg->write_lock()
+      .then([seg, c](ss::rwlock::holder h) {
+          return c->ops.close()
+            .then([seg] { return seg->close(); })
+            .then([c] { return c->writer.close(); })
+            .then([seg] {
+                return ss::when_all_succeed(
+                  ss::remove_file(seg->reader().filename()),
+                  ss::remove_file(seg->index().filename()));
+            })
+            .finally([h = std::move(h)] {});
+      })
+      .handle_exception([seg](std::exception_ptr e) {
+          vlog(
+            archival_log.warn,
+            "Error evicting archived segment {}: {}",
+            seg,
+            e);
+      });
+}
+
+} // namespace archival
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "archival/manifest.h"
+#include "archival/remote.h"
+#include "seastarx.h"
+#include "storage/log_manager.h"
+#include "storage/probe.h"
+#include "storage/segment.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/shared_ptr.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <filesystem>
+#include <list>
+#include <optional>
+#include <vector>
+
+namespace archival {
+
+/*
+ * Archived segments downloaded for reads, on the local disk of a shard.
+ *
+ * A segment is opened like the segments of a log, in a directory laid out
+ * like the log directory of its partition, but only its index is downloaded
+ * up front. Its data file starts out sparse, and the chunks of it that reads
+ * touch are downloaded on demand with ranged requests. Reads that continue
+ * where the previous read of the segment ended download the next chunks
+ * ahead of time.
+ *
+ * The least recently read chunks are punched out of their files when the
+ * cache outgrows its capacity, unless a read is using them. A segment is
+ * closed and removed once none of its chunks are left; readers hold a read
+ * lock on the segments they read, which this waits for. The directory of
+ * the cache is cleared when it starts, as it is not tracked across restarts.
+ */
+class segment_cache {
+public:
+    using segment_ptr = ss::lw_shared_ptr<storage::segment>;
+
+    /// \param chunk_size rounded up to a multiple of 4KiB
+    segment_cache(
+      std::filesystem::path dir,
+      size_t capacity,
+      size_t chunk_size,
+      size_t prefetch_chunks,
+      remote&,
+      storage::log_manager&);
+
+    ss::future<> start();
+    ss::future<> stop();
+
+    /// \brief the archived segment, opened unless cached
+    ss::future<segment_ptr> get(const manifest&, const segment_meta&);
+
+    /// accounts the reads of the archived segments
+    storage::probe& probe() { return _probe; }
+
+private:
+    class chunked_file;
+    struct segment_chunks;
+    using segment_chunks_ptr = ss::lw_shared_ptr<segment_chunks>;
+
+    struct chunk_ref {
+        segment_chunks_ptr segment;
+        size_t index;
+    };
+    using lru_list = std::list<chunk_ref>;
+
+    struct chunk {
+        bool present{false};
+        /// reads waiting for or reading the chunk
+        unsigned pins{0};
+        std::optional<ss::shared_future<>> download;
+        std::optional<ss::shared_future<>> discard;
+        /// valid while present
+        lru_list::iterator lru;
+    };
+
+    /// the chunks of the data file of a cached segment
+    struct segment_chunks {
+        ss::sstring key;
+        s3::object_key object;
+        size_t size_bytes;
+        /// writes the downloaded chunks, and punches out the evicted ones
+        ss::file writer;
+        std::vector<chunk> chunks;
+        size_t present{0};
+        /// chunk following the last read, to detect sequential reads
+        size_t next_read{0};
+        /// no longer part of the cache, its chunks are not accounted
+        bool evicted{false};
+        ss::gate ops;
+    };
+
+    struct entry {
+        segment_ptr segment;
+        segment_chunks_ptr chunks;
+        size_t index_bytes;
+    };
+
+    struct location {
+        std::filesystem::path path;
+        s3::object_key data;
+        s3::object_key index;
+        size_t size_bytes;
+    };
+
+    ss::future<segment_ptr> get_or_open(ss::sstring key, location);
+    ss::future<entry> open(ss::sstring key, location);
+    ss::future<size_t>
+    download_file(const s3::object_key&, std::filesystem::path);
+    void insert(const ss::sstring&, entry);
+
+    /// \brief runs the read once the chunks of its range are present
+    template<typename Func>
+    auto with_chunks(
+      const segment_chunks_ptr&, uint64_t pos, size_t len, Func read);
+    void prefetch(const segment_chunks_ptr&, size_t first, size_t last);
+    ss::future<> fetch_chunk(const segment_chunks_ptr&, size_t);
+    ss::future<> download_chunk(const segment_chunks_ptr&, size_t);
+    void chunk_downloaded(const segment_chunks_ptr&, size_t);
+    size_t chunk_size(const segment_chunks&, size_t) const;
+
+    /// evicts the least recently read chunks, down to the capacity
+    void trim();
+    void evict_segment(const ss::sstring&);
+    ss::future<> close_segment(entry);
+
+    std::filesystem::path _dir;
+    size_t _capacity;
+    size_t _chunk_size;
+    size_t _prefetch_chunks;
+    size_t _size_bytes{0};
+    remote& _remote;
+    storage::log_manager& _log_manager;
+    storage::probe _probe;
+    absl::flat_hash_map<ss::sstring, entry> _segments;
+    /// present chunks, most recently read first
+    lru_list _lru;
+    absl::flat_hash_map<ss::sstring, ss::shared_future<segment_ptr>>
+      _downloads;
+    absl::flat_hash_map<ss::sstring, ss::shared_future<>> _evictions;
+    ss::gate _gate;
+};
+
+} // namespace archival
@@ -0,0 +1,126 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "archival/service.h"
+
+#include "archival/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/loop.hh>
+#include <seastar/core/smp.hh>
+
+#include <string>
+#include <vector>
+
+namespace archival {
+
+service::service(
+  ss::sharded<cluster::partition_manager>& partition_manager,
+  ss::sharded<storage::api>& storage,
+  configuration config)
+  : _partition_manager(partition_manager)
+  , _storage(storage)
+  , _config(std::move(config))
+  , _remote(_config)
+  , _uploads(_config.max_concurrent_uploads) {
+    _timer.set_callback([this] {
+        (void)ss::with_gate(_gate, [this] {
+            return run_archivers()
+              .handle_exception([](std::exception_ptr e) {
+                  vlog(archival_log.warn, "Error archiving partitions: {}", e);
+              })
+              .then([this] { arm_timer(); });
+        });
+    });
+}
+
+ss::future<> service::start() {
+    // the log manager of the shard exists once storage started
+    _cache = std::make_unique<segment_cache>(
+      _config.cache_directory / std::to_string(ss::this_shard_id()),
+      _config.cache_size,
+      _config.cache_chunk_size,
+      _config.cache_prefetch_chunks,
+      _remote,
+      _storage.local().log_mgr());
+    return _cache->start().then([this] { arm_timer(); });
+}
+
+ss::future<> service::stop() {
+    _timer.cancel();
+    return _gate.close()
+      .then([this] {
+          return ss::parallel_for_each(
+            _archivers, [](auto& e) { return e.second->stop(); });
+      })
+      .then([this] {
+          _archivers.clear();
+          return _cache ? _cache->stop() : ss::now();
+      })
+      .then([this] { return _remote.stop(); });
+}
+
+void service::arm_timer() {
+    if (!_gate.is_closed()) {
+        _timer.arm(_config.upload_interval);
+    }
+}
+
+ss::future<> service::run_archivers() {
+    return reconcile_archivers().then([this] {
+        return ss::parallel_for_each(_archivers, [this](auto& e) {
+            ntp_archiver& archiver = *e.second;
+            return ss::with_semaphore(
+                     _uploads, 1, [&archiver] { return archiver.run(); })
+              .handle_exception([&archiver](std::exception_ptr e) {
+                  vlog(
+                    archival_log.warn,
+                    "{} - error archiving: {}",
+                    archiver.ntp(),
+                    e);
+              });
+        });
+    });
+}
+
+ss::future<> service::reconcile_archivers() {
+    const auto& partitions = _partition_manager.local().partitions();
+    std::vector<std::unique_ptr<ntp_archiver>> stale;
+    for (auto it = _archivers.begin(); it != _archivers.end();) {
+        auto p = partitions.find(it->first);
+        // the partition is gone, or was moved away and back
+        if (p == partitions.end() || p->second != it->second->partition()) {
+            stale.push_back(std::move(it->second));
+            _archivers.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    auto& log_manager = _storage.local().log_mgr();
+    for (const auto& [ntp, partition] : partitions) {
+        if (!log_manager.is_archived(ntp) || _archivers.contains(ntp)) {
+            continue;
+        }
+        auto log = log_manager.get(ntp);
+        if (!log) {
+            continue;
+        }
+        _archivers.emplace(
+          ntp,
+          std::make_unique<ntp_archiver>(
+            partition, *log, _config, _remote, *_cache));
+    }
+    return ss::do_with(
+      std::move(stale), [](std::vector<std::unique_ptr<ntp_archiver>>& stale) {
+          return ss::parallel_for_each(
+            stale, [](std::unique_ptr<ntp_archiver>& a) { return a->stop(); });
+      });
+}
+
+} // namespace archival
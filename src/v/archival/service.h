@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "archival/ntp_archiver.h"
+#include "archival/remote.h"
+#include "archival/segment_cache.h"
+#include "archival/types.h"
+#include "cluster/partition_manager.h"
+#include "model/fundamental.h"
+#include "seastarx.h"
+#include "storage/api.h"
+
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <memory>
+
+namespace archival {
+
+/*
+ * Archives the partitions of the kafka namespace hosted by the shard to
+ * object storage, and serves their archived offsets back to reads.
+ *
+ * Every upload interval, an archiver is started for each new partition of
+ * the shard and stopped for each partition the shard no longer hosts, then
+ * all archivers run, at most max_concurrent_uploads at once.
+ */
+class service {
+public:
+    service(
+      ss::sharded<cluster::partition_manager>&,
+      ss::sharded<storage::api>&,
+      configuration);
+
+    ss::future<> start();
+    ss::future<> stop();
+
+private:
+    ss::future<> run_archivers();
+    ss::future<> reconcile_archivers();
+    void arm_timer();
+
+    ss::sharded<cluster::partition_manager>& _partition_manager;
+    ss::sharded<storage::api>& _storage;
+    configuration _config;
+    remote _remote;
+    /// created once storage started
+    std::unique_ptr<segment_cache> _cache;
+    absl::flat_hash_map<model::ntp, std::unique_ptr<ntp_archiver>> _archivers;
+    ss::semaphore _uploads;
+    ss::timer<ss::lowres_clock> _timer;
+    ss::gate _gate;
+};
+
+} // namespace archival
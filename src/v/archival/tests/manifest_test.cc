@@ -0,0 +1,102 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE archival
+#include "archival/manifest.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+static model::ntp test_ntp() {
+    return model::ntp(
+      model::ns("kafka"), model::topic("tapioca"), model::partition_id(3));
+}
+
+static archival::segment_meta
+make_meta(int64_t base, int64_t committed, int64_t ts, size_t size) {
+    return archival::segment_meta{
+      .base_offset = model::offset(base),
+      .committed_offset = model::offset(committed),
+      .term = model::term_id(2),
+      .size_bytes = size,
+      .max_timestamp = model::timestamp(ts),
+    };
+}
+
+static archival::manifest make_manifest() {
+    archival::manifest m(test_ntp());
+    m.add(make_meta(0, 99, 1000, 100));
+    m.add(make_meta(100, 199, 2000, 200));
+    auto last = make_meta(200, 299, 3000, 300);
+    last.has_compaction_index = true;
+    m.add(last);
+    return m;
+}
+
+BOOST_AUTO_TEST_CASE(test_manifest_serialization_roundtrip) {
+    auto m = make_manifest();
+    auto copy = archival::manifest::deserialize(test_ntp(), m.serialize());
+    BOOST_REQUIRE_EQUAL(copy.segments().size(), 3);
+    BOOST_REQUIRE_EQUAL(*copy.start_offset(), model::offset(0));
+    BOOST_REQUIRE_EQUAL(*copy.last_offset(), model::offset(299));
+    BOOST_REQUIRE_EQUAL(copy.size_bytes(), 600);
+    const auto& last = copy.segments().rbegin()->second;
+    BOOST_REQUIRE_EQUAL(last.term, model::term_id(2));
+    BOOST_REQUIRE_EQUAL(last.max_timestamp, model::timestamp(3000));
+    BOOST_REQUIRE(last.has_compaction_index);
+}
+
+BOOST_AUTO_TEST_CASE(test_manifest_of_another_partition) {
+    auto m = make_manifest();
+    auto other = model::ntp(
+      model::ns("kafka"), model::topic("tapioca"), model::partition_id(4));
+    BOOST_REQUIRE_THROW(
+      archival::manifest::deserialize(other, m.serialize()),
+      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_manifest_find) {
+    auto m = make_manifest();
+    BOOST_REQUIRE(m.find(model::offset(0))->base_offset == model::offset(0));
+    BOOST_REQUIRE(
+      m.find(model::offset(150))->base_offset == model::offset(100));
+    BOOST_REQUIRE(
+      m.find(model::offset(299))->base_offset == model::offset(200));
+    BOOST_REQUIRE(m.find(model::offset(300)) == nullptr);
+    BOOST_REQUIRE(m.find(model::offset(-1)) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(test_manifest_retention) {
+    auto m = make_manifest();
+    // by time: the first segment is older than the threshold
+    auto removed = m.apply_retention(model::timestamp(1500), std::nullopt);
+    BOOST_REQUIRE_EQUAL(removed.size(), 1);
+    BOOST_REQUIRE_EQUAL(removed[0].base_offset, model::offset(0));
+    BOOST_REQUIRE_EQUAL(*m.start_offset(), model::offset(100));
+    // by size: the archive fits in 300 bytes without the second segment
+    removed = m.apply_retention(model::timestamp(0), 300);
+    BOOST_REQUIRE_EQUAL(removed.size(), 1);
+    BOOST_REQUIRE_EQUAL(m.size_bytes(), 300);
+    BOOST_REQUIRE_EQUAL(*m.start_offset(), model::offset(200));
+}
+
+BOOST_AUTO_TEST_CASE(test_manifest_keys) {
+    auto m = make_manifest();
+    const auto& first = m.segments().begin()->second;
+    auto key = m.segment_key(first)();
+    BOOST_REQUIRE(
+      key.find("/kafka/tapioca/3/0-2-v1.log") != ss::sstring::npos);
+    BOOST_REQUIRE_EQUAL(m.index_key(first)(), key + ".base_index");
+    BOOST_REQUIRE_EQUAL(
+      m.compaction_index_key(first)(), key + ".compaction_index");
+    // all the objects of the partition share a prefix
+    auto prefix = key.substr(0, key.find("/0-2-v1.log"));
+    BOOST_REQUIRE_EQUAL(m.manifest_key()(), prefix + "/manifest.json");
+}
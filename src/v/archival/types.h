@@ -0,0 +1,44 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "s3/client.h"
+#include "seastarx.h"
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+namespace archival {
+
+struct configuration {
+    s3::configuration client_config;
+    s3::bucket_name bucket;
+    /// how often the partitions of a shard are archived
+    std::chrono::milliseconds upload_interval;
+    /// segments uploaded at once by a shard
+    size_t max_concurrent_uploads;
+    /// a request to the object storage is failed after this long
+    std::chrono::milliseconds request_timeout;
+    /// segments downloaded for reads, by a shard
+    std::filesystem::path cache_directory;
+    size_t cache_size;
+    /// segments are downloaded for reads in ranges of this size
+    size_t cache_chunk_size;
+    /// chunks downloaded ahead of sequential reads
+    size_t cache_prefetch_chunks;
+    /// retention of the partitions in object storage
+    std::chrono::milliseconds delete_retention;
+    std::optional<size_t> retention_bytes;
+};
+
+} // namespace archival
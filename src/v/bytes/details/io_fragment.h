@@ -17,12 +17,30 @@
 
 #include <seastar/core/temporary_buffer.hh>
 
+#include <cstdlib>
+#include <new>
+
 namespace details {
-class io_fragment {
+/// \brief a buffer in the list of an iobuf
+///
+/// Fragments are allocated from a per shard free list, see operator new.
+///
+/// A small fragment can be made inline with make_inline(): the fragment and
+/// its buffer share a single allocation, owned by the deleter of the buffer
+/// so that buffers shared from it outlive the fragment. Such a fragment must
+/// be destroyed with dispose(), never with delete, and its buffer is never
+/// replaced while the fragment lives.
+class io_fragment final {
 public:
     struct full {};
     struct empty {};
 
+    /// allocations up to this size get an inline fragment, which covers the
+    /// first fragment of an iobuf (768 bytes, see io_allocation_size)
+    static constexpr size_t max_inline_size = 1024;
+    /// fragments kept by the free list of a shard
+    static constexpr size_t max_pooled = 1024;
+
     io_fragment(ss::temporary_buffer<char> buf, full)
       : _buf(std::move(buf))
       , _used_bytes(_buf.size()) {}
@@ -35,6 +53,39 @@ public:
     io_fragment& operator=(const io_fragment& o) = delete;
     ~io_fragment() noexcept = default;
 
+    static void* operator new(size_t size);
+    static void operator delete(void* p) noexcept;
+
+    /// an empty fragment of capacity bytes in a single allocation
+    static io_fragment* make_inline(size_t capacity) {
+        // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+        auto* block = static_cast<char*>(
+          std::malloc(sizeof(io_fragment) + capacity));
+        if (!block) {
+            throw std::bad_alloc();
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        auto* data = block + sizeof(io_fragment);
+        return new (block) io_fragment(
+          ss::temporary_buffer<char>(
+            data, capacity, ss::make_free_deleter(block)),
+          inline_tag{});
+    }
+
+    /// destroys a fragment made by new or make_inline()
+    static void dispose(io_fragment* f) noexcept {
+        if (!f->_inline) {
+            delete f; // NOLINT
+            return;
+        }
+        // the buffer owns the memory of the fragment, so it is released
+        // once the fragment is destroyed
+        auto buf = std::move(f->_buf);
+        f->~io_fragment();
+    }
+
+    bool is_inline() const { return _inline; }
+
     bool operator==(const io_fragment& o) const {
         return _used_bytes == o._used_bytes && _buf == o._buf;
     }
@@ -78,7 +129,7 @@ public:
             return;
         }
         size_t half = _buf.size() / 2;
-        if (_used_bytes <= half) {
+        if (_used_bytes <= half && !_inline) {
             // this is an important optimization. often times during RPC
             // serialization we append some small controll bytes, _right_
             // before we append a full new chain of iobufs
@@ -88,6 +139,9 @@ public:
         }
     }
     void trim(size_t len) { _used_bytes = std::min(len, _used_bytes); }
+    /// drops the capacity past the used bytes without copying them, for a
+    /// buffer whose memory is shared with other fragments
+    void trim_capacity() { _buf.trim(_used_bytes); }
     void trim_front(size_t pos) {
         // required by input_stream<char> converter
         _buf.trim_front(pos);
@@ -99,8 +153,16 @@ public:
     safe_intrusive_list_hook hook;
 
 private:
+    struct inline_tag {};
+
+    io_fragment(ss::temporary_buffer<char> buf, inline_tag)
+      : _buf(std::move(buf))
+      , _used_bytes(0)
+      , _inline(true) {}
+
     ss::temporary_buffer<char> _buf;
     size_t _used_bytes;
+    bool _inline{false};
 };
 
 } // namespace details
@@ -14,12 +14,16 @@
 #include "bytes/details/io_byte_iterator.h"
 #include "bytes/details/io_fragment.h"
 #include "bytes/details/io_placeholder.h"
+#include "likely.h"
 #include "utils/concepts-enabled.h"
 
 #include <seastar/core/byteorder.hh>
 #include <seastar/core/future-util.hh>
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
 
 /*
  * It is common for an io_iterator_consumer to be initialized with the begin and
@@ -62,6 +66,10 @@ public:
         }
     }
     void skip(size_t n) {
+        if (likely(n < segment_bytes_left())) {
+            advance_in_segment(n);
+            return;
+        }
         size_t c = consume(n, [](const char*, size_t /*max*/) {
             return ss::stop_iteration::no;
         });
@@ -72,6 +80,12 @@ public:
     }
     template<typename Output>
     [[gnu::always_inline]] void consume_to(size_t n, Output out) {
+        if (likely(n < segment_bytes_left())) {
+            // the common case of a field within the current fragment
+            std::copy_n(_frag_index, n, out);
+            advance_in_segment(n);
+            return;
+        }
         size_t c = consume(n, [&out](const char* src, size_t max) {
             std::copy_n(src, max, out);
             out += max;
@@ -162,9 +176,58 @@ public:
 
         return i;
     }
+    /// \brief the distance from the current position to the first byte
+    /// equal to c within the next max bytes, without consuming them. Each
+    /// fragment is scanned with memchr, which is vectorized.
+    std::optional<size_t>
+    find(char c, size_t max = std::numeric_limits<size_t>::max()) const {
+        size_t scanned = 0;
+        const char* begin = _frag_index;
+        const char* end = _frag_index_end;
+        for (auto it = _frag; it != _frag_end && scanned < max;) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            const size_t len = std::min<size_t>(end - begin, max - scanned);
+            if (const void* p = std::memchr(begin, c, len); p) {
+                return scanned + (static_cast<const char*>(p) - begin);
+            }
+            scanned += len;
+            if (++it != _frag_end) {
+                begin = it->get();
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                end = it->get() + it->size();
+            }
+        }
+        return std::nullopt;
+    }
+
+    /// \brief compares the next n bytes to data, like memcmp, without
+    /// consuming them. Bytes past the end of the buffer compare lower.
+    int compare(const char* data, size_t n) const {
+        size_t compared = 0;
+        const char* begin = _frag_index;
+        const char* end = _frag_index_end;
+        for (auto it = _frag; it != _frag_end && compared < n;) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            const size_t len = std::min<size_t>(end - begin, n - compared);
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            if (int r = std::memcmp(begin, data + compared, len); r != 0) {
+                return r;
+            }
+            compared += len;
+            if (++it != _frag_end) {
+                begin = it->get();
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                end = it->get() + it->size();
+            }
+        }
+        return compared == n ? 0 : -1;
+    }
+
     size_t bytes_consumed() const { return _bytes_consumed; }
     // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
     size_t segment_bytes_left() const { return _frag_index_end - _frag_index; }
+    /// the bytes left in the current fragment, segment_bytes_left() of them
+    const char* segment_data() const { return _frag_index; }
     bool is_finished() const { return _frag == _frag_end; }
 
     /// starts a new iterator byte-for-byte starting at *this* index
@@ -177,6 +240,13 @@ public:
     }
 
 private:
+    /// n must be less than segment_bytes_left()
+    void advance_in_segment(size_t n) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        _frag_index += n;
+        _bytes_consumed += n;
+    }
+
     io_const_iterator _frag;
     io_const_iterator _frag_end;
     const char* _frag_index = nullptr;
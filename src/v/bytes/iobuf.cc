@@ -13,12 +13,70 @@
 #include "vassert.h"
 
 #include <seastar/core/bitops.hh>
+#include <seastar/core/deleter.hh>
 #include <seastar/core/do_with.hh>
 #include <seastar/core/future-util.hh>
+#include <seastar/core/sharded.hh>
 #include <seastar/core/smp.hh>
 
 #include <iostream>
 #include <limits>
+#include <new>
+#include <utility>
+
+namespace details {
+namespace {
+/// the memory of freed fragments of a shard, reused by the next ones. a
+/// fragment freed on another shard than the one it was allocated on is
+/// pooled on the freeing shard; seastar frees it across shards once it
+/// leaves the pool.
+struct fragment_pool {
+    struct node {
+        node* next;
+    };
+
+    fragment_pool() noexcept = default;
+    fragment_pool(const fragment_pool&) = delete;
+    fragment_pool& operator=(const fragment_pool&) = delete;
+    fragment_pool(fragment_pool&&) = delete;
+    fragment_pool& operator=(fragment_pool&&) = delete;
+    ~fragment_pool() noexcept {
+        while (head) {
+            ::operator delete(std::exchange(head, head->next));
+        }
+    }
+
+    node* head{nullptr};
+    size_t size{0};
+};
+
+static_assert(sizeof(io_fragment) >= sizeof(fragment_pool::node));
+
+fragment_pool& shard_local_fragment_pool() {
+    static thread_local fragment_pool pool;
+    return pool;
+}
+} // namespace
+
+void* io_fragment::operator new(size_t size) {
+    auto& pool = shard_local_fragment_pool();
+    if (likely(size == sizeof(io_fragment) && pool.head)) {
+        --pool.size;
+        return std::exchange(pool.head, pool.head->next);
+    }
+    return ::operator new(size);
+}
+
+void io_fragment::operator delete(void* p) noexcept {
+    auto& pool = shard_local_fragment_pool();
+    if (!p || pool.size >= max_pooled) {
+        ::operator delete(p);
+        return;
+    }
+    ++pool.size;
+    pool.head = new (p) fragment_pool::node{pool.head};
+}
+} // namespace details
 
 std::ostream& operator<<(std::ostream& o, const iobuf& io) {
     return o << "{bytes=" << io.size_bytes()
@@ -156,6 +214,25 @@ iobuf iobuf_copy(iobuf::iterator_consumer& in, size_t len) {
     return ret;
 }
 
+iobuf iobuf_make_foreign(iobuf buf) {
+    if (buf.empty()) {
+        return buf;
+    }
+    auto owned = std::make_unique<iobuf>(std::move(buf));
+    const iobuf& src = *owned;
+    // shared by the views, released on the core of the last one
+    ss::deleter d = ss::make_object_deleter(ss::make_foreign(std::move(owned)));
+    iobuf ret;
+    for (const auto& frag : src) {
+        auto f = new iobuf::fragment(
+          ss::temporary_buffer<char>(
+            const_cast<char*>(frag.get()), frag.size(), d.share()), // NOLINT
+          iobuf::fragment::full{});
+        ret.append_take_ownership(f);
+    }
+    return ret;
+}
+
 iobuf iobuf::share(size_t pos, size_t len) {
     iobuf ret;
     size_t left = len;
@@ -58,9 +58,10 @@ class iobuf {
     // 24  of ss::temporary_buffer<>
     // 16  for left,right pointers
     // 8   for consumed capacity
+    // 8   for the inline flag, padded
     // -----------------------
     //
-    // 48 bytes total
+    // 56 bytes total
 
 public:
     using fragment = details::io_fragment;
@@ -139,6 +140,8 @@ public:
     void append(ss::temporary_buffer<char>);
     /// appends the contents of buffer; might pack values into existing space
     void append(iobuf);
+    /// appends the fragments of the arg as they are; never copies nor packs
+    void append_fragments(iobuf);
     /// \brief trims the back, and appends direct.
     void append_take_ownership(fragment*);
     /// prepends the _the buffer_ as iobuf::details::io_fragment::full{}
@@ -184,7 +187,7 @@ private:
 
 inline void iobuf::clear() {
     _frags.clear_and_dispose([](fragment* f) {
-        delete f; // NOLINT
+        fragment::dispose(f);
     });
     _size = 0;
 }
@@ -232,7 +235,14 @@ inline void iobuf::create_new_fragment(size_t sz) {
     oncore_debug_verify(_verify_shard);
     auto chunk_max = std::max(sz, last_allocation_size());
     auto asz = details::io_allocation_size::next_allocation_size(chunk_max);
-    auto f = new fragment(ss::temporary_buffer<char>(asz), fragment::empty{});
+    // small iobufs, e.g. keys, headers and rpc envelopes, then cost a single
+    // allocation instead of one for the fragment and one for its buffer
+    fragment* f = nullptr;
+    if (asz <= fragment::max_inline_size) {
+        f = fragment::make_inline(asz);
+    } else {
+        f = new fragment(ss::temporary_buffer<char>(asz), fragment::empty{});
+    }
     append_take_ownership(f);
 }
 inline iobuf::placeholder iobuf::reserve(size_t sz) {
@@ -270,7 +280,7 @@ inline void iobuf::reserve_memory(size_t reservation) {
     while (!b._frags.empty()) {
         b._frags.pop_back_and_dispose([this](fragment* f) {
             prepend(f->share());
-            delete f; // NOLINT
+            fragment::dispose(f);
         });
     }
 }
@@ -334,23 +344,36 @@ inline void iobuf::append(iobuf o) {
     while (!o._frags.empty()) {
         o._frags.pop_front_and_dispose([this](fragment* f) {
             append(f->share());
-            delete f; // NOLINT
+            fragment::dispose(f);
         });
     }
 }
+/// appends the fragments of the arg as they are; never copies nor packs
+inline void iobuf::append_fragments(iobuf o) {
+    oncore_debug_verify(_verify_shard);
+    if (!_frags.empty() && _frags.back().is_empty()) {
+        pop_back();
+    }
+    while (!o._frags.empty()) {
+        auto& f = o._frags.front();
+        o._size -= f.size();
+        o._frags.pop_front();
+        append_take_ownership(&f);
+    }
+}
 /// used for iostreams
 inline void iobuf::pop_front() {
     oncore_debug_verify(_verify_shard);
     _size -= _frags.front().size();
     _frags.pop_front_and_dispose([](fragment* f) {
-        delete f; // NOLINT
+        fragment::dispose(f);
     });
 }
 inline void iobuf::pop_back() {
     oncore_debug_verify(_verify_shard);
     _size -= _frags.back().size();
     _frags.pop_back_and_dispose([](fragment* f) {
-        delete f; // NOLINT
+        fragment::dispose(f);
     });
 }
 inline void iobuf::trim_front(size_t n) {
@@ -398,6 +421,12 @@ ss::future<> write_iobuf_to_output_stream(iobuf, ss::output_stream<char>&);
 
 iobuf iobuf_copy(iobuf::iterator_consumer& in, size_t len);
 
+/// \brief views of the buffers of the iobuf, which is destroyed on this core
+/// once all of them are released, whatever the core. use it to hand the
+/// buffers of an iobuf, which may share the memory of caches, to another core
+/// without copying them
+iobuf iobuf_make_foreign(iobuf);
+
 namespace std {
 template<>
 struct hash<::iobuf> {
@@ -19,7 +19,12 @@
 
 #include <seastar/core/sstring.hh>
 
+#include <array>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <string_view>
+#include <tuple>
 
 /**
  * iobuf parser interface suitable for an iobuf passed by const-ref. also
@@ -46,11 +51,33 @@ public:
     size_t bytes_consumed() const { return _in.bytes_consumed(); }
 
     std::pair<int64_t, uint8_t> read_varlong() {
-        auto [val, length_size] = vint::deserialize(_in);
+        auto [val, length_size] = vint::deserialize(
+          segment_data(), _in.segment_bytes_left());
+        if (unlikely(length_size == 0)) {
+            // spans fragments or ends the buffer
+            std::tie(val, length_size) = vint::deserialize(_in);
+        }
         _in.skip(length_size);
         return {val, length_size};
     }
 
+    /// \brief reads N consecutive varlongs, decoded together when the
+    /// current fragment holds all of them
+    template<size_t N>
+    std::array<int64_t, N> read_varlongs() {
+        std::array<int64_t, N> vals;
+        const size_t sz = vint::deserialize_batch(
+          segment_data(), _in.segment_bytes_left(), vals.data(), N);
+        if (likely(sz > 0)) {
+            _in.skip(sz);
+            return vals;
+        }
+        for (auto& v : vals) {
+            v = read_varlong().first;
+        }
+        return vals;
+    }
+
     ss::sstring read_string(size_t len) {
         ss::sstring str = ss::uninitialized_string(len);
         _in.consume_to(str.size(), str.begin());
@@ -66,6 +93,8 @@ public:
 
     bool read_bool() { return bool(consume_type<int8_t>()); }
 
+    void consume_to(size_t n, char* dst) { _in.consume_to(n, dst); }
+
     template<typename T>
     T consume_type() {
         return _in.consume_type<T>();
@@ -78,6 +107,18 @@ public:
 
     void skip(size_t n) { _in.skip(n); }
 
+    /// \brief the distance to the next byte equal to c within the next max
+    /// bytes, scanning the fragments in place
+    std::optional<size_t>
+    find(char c, size_t max = std::numeric_limits<size_t>::max()) const {
+        return _in.find(c, max);
+    }
+
+    /// \brief whether the next bytes are equal to data, compared in place
+    bool starts_with(std::string_view data) const {
+        return _in.compare(data.data(), data.size()) == 0;
+    }
+
     // clang-format off
     template<typename Consumer>
     CONCEPT(requires requires(Consumer c, const char* src, size_t max) {
@@ -94,6 +135,11 @@ protected:
     iobuf& ref() { return *std::get<owned_buf>(_buf); }
 
 private:
+    const uint8_t* segment_data() const {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        return reinterpret_cast<const uint8_t*>(_in.segment_data());
+    }
+
     using const_ref = const iobuf*;
     using owned_buf = std::unique_ptr<iobuf>;
 
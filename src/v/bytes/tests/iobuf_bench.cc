@@ -0,0 +1,129 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/iobuf.h"
+#include "random/generators.h"
+
+#include <seastar/core/memory.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <iostream>
+
+/*
+ * Counts the allocations of the measured sections, and prints their mean per
+ * iteration once the test is done. Seastar's default allocator, used by debug
+ * builds, does not count them.
+ */
+class alloc_counter {
+public:
+    alloc_counter() = default;
+    alloc_counter(const alloc_counter&) = delete;
+    alloc_counter& operator=(const alloc_counter&) = delete;
+    alloc_counter(alloc_counter&&) = delete;
+    alloc_counter& operator=(alloc_counter&&) = delete;
+    ~alloc_counter() {
+        if (_iterations > 0) {
+            std::cout << fmt::format(
+              "allocations per iteration: {:.2f}\n",
+              double(_allocs) / double(_iterations));
+        }
+    }
+
+    void start() {
+        _start = ss::memory::stats().mallocs();
+        perf_tests::start_measuring_time();
+    }
+
+    void stop() {
+        perf_tests::stop_measuring_time();
+        _allocs += ss::memory::stats().mallocs() - _start;
+        ++_iterations;
+    }
+
+private:
+    uint64_t _start{0};
+    uint64_t _allocs{0};
+    uint64_t _iterations{0};
+};
+
+struct iobuf_bench : alloc_counter {
+    const ss::sstring key = random_generators::gen_alphanum_string(16);
+    const ss::sstring value = random_generators::gen_alphanum_string(100);
+    const ss::sstring payload = random_generators::gen_alphanum_string(4096);
+};
+
+// a key or a header on its own
+PERF_TEST_F(iobuf_bench, small_append) {
+    start();
+    iobuf buf;
+    buf.append(key.data(), key.size());
+    perf_tests::do_not_optimize(buf);
+    buf.clear();
+    stop();
+}
+
+// the key and value of a record appended to the records of a batch
+PERF_TEST_F(iobuf_bench, record_append) {
+    start();
+    iobuf records;
+    for (int i = 0; i < 10; ++i) {
+        iobuf k;
+        k.append(key.data(), key.size());
+        iobuf v;
+        v.append(value.data(), value.size());
+        records.append(std::move(k));
+        records.append(std::move(v));
+    }
+    perf_tests::do_not_optimize(records);
+    records.clear();
+    stop();
+}
+
+// an rpc envelope: a reserved header filled in after the payload
+PERF_TEST_F(iobuf_bench, rpc_envelope) {
+    start();
+    iobuf out;
+    auto ph = out.reserve(26);
+    out.append(value.data(), value.size());
+    std::array<char, 26> header{};
+    ph.write(header.data(), header.size());
+    perf_tests::do_not_optimize(out);
+    out.clear();
+    stop();
+}
+
+// an envelope around a large payload shared into it
+PERF_TEST_F(iobuf_bench, rpc_envelope_large_payload) {
+    iobuf body;
+    body.append(payload.data(), payload.size());
+    start();
+    iobuf out;
+    auto ph = out.reserve(26);
+    out.append(body.share(0, body.size_bytes()));
+    std::array<char, 26> header{};
+    ph.write(header.data(), header.size());
+    perf_tests::do_not_optimize(out);
+    out.clear();
+    stop();
+}
+
+// fragments churned through the free list of the shard
+PERF_TEST_F(iobuf_bench, share_and_drop) {
+    iobuf body;
+    body.append(payload.data(), payload.size());
+    start();
+    for (size_t i = 0; i < 16; ++i) {
+        auto s = body.share(i * 256, 256);
+        perf_tests::do_not_optimize(s);
+    }
+    stop();
+}
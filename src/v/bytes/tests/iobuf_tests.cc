@@ -11,7 +11,9 @@
 #include "bytes/details/io_allocation_size.h"
 #include "bytes/iobuf.h"
 #include "bytes/iobuf_ostreambuf.h"
+#include "bytes/iobuf_parser.h"
 #include "bytes/tests/utils.h"
+#include "units.h"
 
 #include <seastar/core/temporary_buffer.hh>
 #include <seastar/testing/thread_test_case.hh>
@@ -403,6 +405,30 @@ SEASTAR_THREAD_TEST_CASE(test_next_chunk_allocation_append_iobuf) {
     BOOST_REQUIRE_EQUAL(msg.size(), sz);
 }
 
+SEASTAR_THREAD_TEST_CASE(test_append_fragments_shares_data) {
+    const auto b = random_generators::gen_alphanum_string(1024);
+    ss::temporary_buffer<char> tb(b.data(), b.size());
+    const char* data = tb.get();
+
+    iobuf buf;
+    buf.append("header", 6);
+    iobuf tmp_buf;
+    tmp_buf.append_take_ownership(
+      new iobuf::fragment(tb.share(), iobuf::fragment::full{}));
+    buf.append_fragments(std::move(tmp_buf));
+    BOOST_REQUIRE_EQUAL(buf.size_bytes(), 6 + b.size());
+
+    // the appended fragment is not packed into the first one
+    auto distance = std::distance(buf.begin(), buf.end());
+    BOOST_REQUIRE_EQUAL(distance, 2);
+    BOOST_REQUIRE(std::next(buf.begin())->get() == data);
+
+    iobuf expected;
+    expected.append("header", 6);
+    expected.append(b.data(), b.size());
+    BOOST_REQUIRE_EQUAL(buf, expected);
+}
+
 /*
  * testing various trim_front scenarios
  *
@@ -492,3 +518,132 @@ SEASTAR_THREAD_TEST_CASE(trim_front) {
         BOOST_TEST(buf.size_bytes() == 99);
     }
 }
+
+SEASTAR_THREAD_TEST_CASE(test_small_iobuf_has_inline_fragment) {
+    iobuf buf;
+    buf.append("key", 3);
+    BOOST_REQUIRE(buf.begin()->is_inline());
+    BOOST_REQUIRE_EQUAL(buf.begin()->size(), 3);
+
+    // growing past the first fragment allocates a regular one
+    const auto big = random_generators::gen_alphanum_string(4096);
+    buf.append(big.data(), big.size());
+    BOOST_REQUIRE(!std::next(buf.begin())->is_inline());
+
+    iobuf expected;
+    expected.append("key", 3);
+    expected.append(big.data(), big.size());
+    BOOST_REQUIRE_EQUAL(buf, expected);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_share_outlives_inline_fragment) {
+    const auto data = random_generators::gen_alphanum_string(100);
+    iobuf shared;
+    {
+        iobuf buf;
+        buf.append(data.data(), data.size());
+        BOOST_REQUIRE(buf.begin()->is_inline());
+        shared = buf.share(10, 50);
+        buf.trim_back(90);
+        buf.append(data.data(), data.size());
+    }
+    iobuf expected;
+    expected.append(data.data() + 10, 50);
+    BOOST_REQUIRE_EQUAL(shared, expected);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_trim_inline_fragment) {
+    iobuf buf;
+    buf.append("header", 6);
+    BOOST_REQUIRE(buf.begin()->is_inline());
+    // trims the inline fragment in place
+    buf.append(ss::temporary_buffer<char>(64_KiB));
+    BOOST_REQUIRE_EQUAL(buf.begin()->capacity(), 6);
+    BOOST_REQUIRE_EQUAL(buf.size_bytes(), 6 + 64_KiB);
+
+    iobuf copy = buf.copy();
+    BOOST_REQUIRE_EQUAL(copy, buf);
+}
+
+namespace {
+/// "abc|defg|hij|klmno" as four fragments
+iobuf make_fragmented() {
+    iobuf buf;
+    for (std::string_view s : {"abc", "defg", "hij", "klmno"}) {
+        buf.append(ss::temporary_buffer<char>(s.data(), s.size()));
+    }
+    return buf;
+}
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(test_parser_find_across_fragments) {
+    iobuf_parser parser(make_fragmented());
+    BOOST_REQUIRE_EQUAL(parser.find('a').value(), 0);
+    BOOST_REQUIRE_EQUAL(parser.find('e').value(), 4);
+    BOOST_REQUIRE_EQUAL(parser.find('o').value(), 14);
+    BOOST_REQUIRE(!parser.find('z'));
+    BOOST_REQUIRE(!parser.find('o', 14));
+    BOOST_REQUIRE_EQUAL(parser.find('o', 15).value(), 14);
+
+    // relative to the position of the parser, which find does not move
+    parser.skip(5);
+    BOOST_REQUIRE_EQUAL(parser.find('f').value(), 0);
+    BOOST_REQUIRE_EQUAL(parser.find('k').value(), 5);
+    BOOST_REQUIRE(!parser.find('a'));
+    BOOST_REQUIRE_EQUAL(parser.bytes_consumed(), 5);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_parser_starts_with_across_fragments) {
+    iobuf_parser parser(make_fragmented());
+    BOOST_REQUIRE(parser.starts_with(""));
+    BOOST_REQUIRE(parser.starts_with("ab"));
+    BOOST_REQUIRE(parser.starts_with("abcdefghij"));
+    BOOST_REQUIRE(parser.starts_with("abcdefghijklmno"));
+    BOOST_REQUIRE(!parser.starts_with("abcdefghijklmnop"));
+    BOOST_REQUIRE(!parser.starts_with("abcdefgXij"));
+
+    parser.skip(2);
+    BOOST_REQUIRE(parser.starts_with("cdefgh"));
+    BOOST_REQUIRE_EQUAL(parser.bytes_consumed(), 2);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_parser_consume_within_and_across_fragments) {
+    iobuf_parser parser(make_fragmented());
+    BOOST_REQUIRE_EQUAL(parser.read_string(2), "ab");
+    BOOST_REQUIRE_EQUAL(parser.read_string(6), "cdefgh");
+    parser.skip(1);
+    BOOST_REQUIRE_EQUAL(parser.read_string(2), "jk");
+    parser.skip(3);
+    BOOST_REQUIRE_EQUAL(parser.read_string(1), "o");
+    BOOST_REQUIRE_EQUAL(parser.bytes_left(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_foreign_views_release_the_source) {
+    bool released = false;
+    iobuf buf;
+    for (std::string_view s : {"0123456789", "abcdefghij"}) {
+        ss::temporary_buffer<char> b(s.size());
+        std::copy_n(s.data(), s.size(), b.get_write());
+        buf.append_take_ownership(new iobuf::fragment(
+          ss::temporary_buffer<char>(
+            b.get_write(),
+            b.size(),
+            ss::make_deleter([b = std::move(b), &released]() mutable {
+                released = true;
+            })),
+          iobuf::fragment::full{}));
+    }
+    auto expected = buf.copy();
+
+    auto views = iobuf_make_foreign(std::move(buf));
+    BOOST_REQUIRE_EQUAL(views, expected);
+    BOOST_REQUIRE_EQUAL(
+      std::distance(views.begin(), views.end()),
+      std::distance(expected.begin(), expected.end()));
+    BOOST_REQUIRE(!released);
+
+    views.pop_front();
+    BOOST_REQUIRE(!released);
+    views.clear();
+    BOOST_REQUIRE(released);
+}
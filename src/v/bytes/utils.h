@@ -11,13 +11,17 @@
 
 #pragma once
 #include "bytes/iobuf.h"
+#include "bytes/iobuf_parser.h"
 #include "hashing/crc32c.h"
 
 inline void crc_extend_iobuf(crc32& crc, const iobuf& buf) {
-    auto in = iobuf::iterator_consumer(buf.cbegin(), buf.cend());
-    (void)in.consume(buf.size_bytes(), [&crc](const char* src, size_t sz) {
-        // NOLINTNEXTLINE
-        crc.extend(reinterpret_cast<const uint8_t*>(src), sz);
+    crc.extend_fragments(buf.cbegin(), buf.cend());
+}
+
+/// \brief extends the crc over the bytes left in the parser, consuming them
+inline void crc_extend_iobuf(crc32& crc, iobuf_parser_base& in) {
+    (void)in.consume(in.bytes_left(), [&crc](const char* src, size_t sz) {
+        crc.extend(src, sz);
         return ss::stop_iteration::no;
     });
 }
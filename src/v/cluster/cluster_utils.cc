@@ -111,7 +111,11 @@ ss::future<> maybe_create_tcp_client(
                       .server_addr = new_addr,
                       .credentials = std::move(credentials),
                       .disable_metrics = rpc::metrics_disabled(
-                        config::shard_local_cfg().disable_metrics)},
+                        config::shard_local_cfg().disable_metrics),
+                      .cork_window = std::chrono::microseconds(
+                        config::shard_local_cfg().rpc_cork_window_us()),
+                      .send_timeouts = config::shard_local_cfg()
+                                         .rpc_send_request_timeouts()},
                     rpc::make_exponential_backoff_policy<rpc::clock_type>(
                       std::chrono::seconds(1), std::chrono::seconds(60)));
               });
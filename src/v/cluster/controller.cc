@@ -103,13 +103,35 @@ ss::future<> controller::start() {
           });
       })
       .then(
-        [this] { return _backend.invoke_on_all(&controller_backend::start); });
+        [this] { return _backend.invoke_on_all(&controller_backend::start); })
+      .then([this] {
+          return _leader_balancer.start_single(
+            std::ref(_tp_state),
+            std::ref(_partition_leaders),
+            std::ref(_partition_manager));
+      })
+      .then([this] {
+          return _leader_balancer.invoke_on(
+            leader_balancer::shard, &leader_balancer::start);
+      })
+      .then([this] {
+          return _shard_balancer.start_single(
+            std::ref(_tp_state),
+            std::ref(_partition_manager),
+            std::ref(_tp_frontend));
+      })
+      .then([this] {
+          return _shard_balancer.invoke_on(
+            shard_balancer::shard, &shard_balancer::start);
+      });
 }
 ss::future<> controller::stop() {
     return _as.invoke_on_all(&ss::abort_source::request_abort)
       .then([this] { return _stm.stop(); })
       .then([this] { return _members_manager.stop(); })
+      .then([this] { return _shard_balancer.stop(); })
       .then([this] { return _tp_frontend.stop(); })
+      .then([this] { return _leader_balancer.stop(); })
       .then([this] { return _backend.stop(); })
       .then([this] { return _tp_state.stop(); })
       .then([this] { return _partition_allocator.stop(); })
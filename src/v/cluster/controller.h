@@ -14,10 +14,12 @@
 #include "cluster/controller_backend.h"
 #include "cluster/controller_service.h"
 #include "cluster/controller_stm.h"
+#include "cluster/leader_balancer.h"
 #include "cluster/members_manager.h"
 #include "cluster/metadata_dissemination_service.h"
 #include "cluster/partition_leaders_table.h"
 #include "cluster/partition_manager.h"
+#include "cluster/shard_balancer.h"
 #include "cluster/shard_table.h"
 #include "cluster/topic_table.h"
 #include "cluster/topic_updates_dispatcher.h"
@@ -68,6 +70,8 @@ private:
     ss::sharded<controller_backend> _backend;      // instance per core
     ss::sharded<controller_stm> _stm;              // single instance
     ss::sharded<controller_service> _service;      // instance per core
+    ss::sharded<leader_balancer> _leader_balancer; // single instance
+    ss::sharded<shard_balancer> _shard_balancer;   // single instance
     ss::sharded<rpc::connection_cache>& _connections;
     ss::sharded<partition_manager>& _partition_manager;
     ss::sharded<shard_table>& _shard_table;
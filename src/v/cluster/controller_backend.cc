@@ -62,6 +62,7 @@ ss::future<> controller_backend::stop() {
 }
 
 ss::future<> controller_backend::start() {
+    _started_at = ss::lowres_clock::now();
     start_topics_reconciliation_loop();
     _housekeeping_timer.set_callback([this] { housekeeping(); });
     _housekeeping_timer.arm_periodic(std::chrono::seconds(1));
@@ -105,15 +106,40 @@ void controller_backend::housekeeping() {
     }
 }
 
+static bool only_creates_partitions(const topic_table::delta& d) {
+    return d.partitions.deletions.empty() && d.partitions.updates.empty();
+}
+
 // caller must hold _topics_sem lock
 ss::future<> controller_backend::reconcile_topics() {
     using meta_t = task_meta<topic_table::delta>;
+    using iterator = std::vector<meta_t>::iterator;
     // _topic_deltas are chronologically ordered, we cannot reorder applying
-    // them, hence we have to use `ss::do_for_each`
-    return ss::do_for_each(
-             std::begin(_topic_deltas),
-             std::end(_topic_deltas),
-             [this](meta_t& task) { return do_reconcile_topic(task); })
+    // them, hence we have to use `ss::do_for_each`. Runs of deltas only
+    // creating partitions are the exception: they touch distinct partitions
+    // and are reconciled concurrently, as at startup, the log manager
+    // bounding the logs recovered at once
+    std::vector<std::pair<iterator, iterator>> runs;
+    for (auto it = _topic_deltas.begin(); it != _topic_deltas.end();) {
+        auto end = std::next(it);
+        if (only_creates_partitions(it->delta)) {
+            end = std::find_if_not(end, _topic_deltas.end(), [](meta_t& m) {
+                return only_creates_partitions(m.delta);
+            });
+        }
+        runs.emplace_back(it, end);
+        it = end;
+    }
+    return ss::do_with(
+             std::move(runs),
+             [this](std::vector<std::pair<iterator, iterator>>& runs) {
+                 return ss::do_for_each(runs, [this](auto& run) {
+                     return ss::parallel_for_each(
+                       run.first, run.second, [this](meta_t& task) {
+                           return do_reconcile_topic(task);
+                       });
+                 });
+             })
       .then([this] {
           // remove finished tasks
           auto it = std::stable_partition(
@@ -121,9 +147,24 @@ ss::future<> controller_backend::reconcile_topics() {
             std::end(_topic_deltas),
             [](meta_t& task) { return task.finished; });
           _topic_deltas.erase(_topic_deltas.begin(), it);
+          maybe_report_recovery();
       });
 }
 
+void controller_backend::maybe_report_recovery() {
+    if (!_recovering || !_topic_deltas.empty()) {
+        return;
+    }
+    _recovering = false;
+    vlog(
+      clusterlog.info,
+      "Recovered {} partitions in {} ms after startup",
+      _partition_manager.local().partitions().size(),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+        ss::lowres_clock::now() - _started_at)
+        .count());
+}
+
 bool has_local_replicas(
   model::node_id self, const std::vector<model::broker_shard>& replicas) {
     return std::find_if(
@@ -135,6 +176,21 @@ bool has_local_replicas(
            != replicas.cend();
 }
 
+/// the core of this node holding a replica, when it is not the current one
+std::optional<ss::shard_id> other_local_shard(
+  model::node_id self, const std::vector<model::broker_shard>& replicas) {
+    auto it = std::find_if(
+      std::cbegin(replicas),
+      std::cend(replicas),
+      [self](const model::broker_shard& bs) {
+          return bs.node_id == self && bs.shard != ss::this_shard_id();
+      });
+    if (it == replicas.cend()) {
+        return std::nullopt;
+    }
+    return it->shard;
+}
+
 std::vector<model::broker> create_brokers_set(
   const std::vector<model::broker_shard>& replicas,
   cluster::members_table& members) {
@@ -166,29 +222,12 @@ controller_backend::results_t join_results(
 ss::future<>
 controller_backend::do_reconcile_topic(task_meta<topic_table::delta>& task) {
     // new partitions
-    auto f = ssx::parallel_transform(
-      task.delta.partitions.additions,
-      [this, o = task.delta.offset](topic_table::delta::partition p) {
-          // only create partitions for this backend
-          // partitions created on current shard at this node
-          if (!has_local_replicas(_self, p.second.replicas)) {
-              return ss::make_ready_future<std::error_code>(errc::success);
-          }
-          return create_partition(
-            model::ntp(p.first.ns, p.first.tp, p.second.id),
-            p.second.group,
-            o,
-            create_brokers_set(p.second.replicas, _members_table.local()));
-      });
+    auto f = create_partitions(
+      task.delta.partitions.additions, task.delta.offset);
 
     // delete partitions
     f = f.then([this, &task](results_t results) {
-        return ssx::parallel_transform(
-                 task.delta.partitions.deletions,
-                 [this](const topic_table::delta::partition& p) {
-                     return delete_partition(
-                       model::ntp(p.first.ns, p.first.tp, p.second.id));
-                 })
+        return delete_partitions(task.delta.partitions.deletions)
           .then([results = std::move(results)](results_t new_results) mutable {
               return join_results(std::move(results), std::move(new_results));
           });
@@ -232,6 +271,11 @@ ss::future<std::error_code> controller_backend::process_partition_update(
         if (!partition) {
             return ss::make_ready_future<std::error_code>(errc::success);
         }
+        // the partition moves to another core of this node, its log stays
+        if (auto target = other_local_shard(_self, p.second.replicas);
+            target) {
+            return migrate_partition(std::move(ntp), *target);
+        }
         // this partition has to be removed eventually
 
         return update_partition_replica_set(ntp, p.second.replicas)
@@ -247,11 +291,54 @@ ss::future<std::error_code> controller_backend::process_partition_update(
     if (partition) {
         return update_partition_replica_set(ntp, p.second.replicas);
     }
+    // the core the partition moves from has to release it first
+    if (auto shard = _shard_table.local().shard_for(ntp);
+        shard && *shard != ss::this_shard_id()) {
+        return ss::make_ready_future<std::error_code>(
+          errc::partition_migrating);
+    }
     // create partition with empty configuration. Configuration
     // will be populated during node recovery
     return create_partition(ntp, p.second.group, offset, {});
 }
 
+ss::future<std::error_code>
+controller_backend::migrate_partition(model::ntp ntp, ss::shard_id target) {
+    auto group = _partition_manager.local().get(ntp)->group();
+    vlog(
+      clusterlog.info,
+      "moving partition {} from core {} to core {}",
+      ntp,
+      ss::this_shard_id(),
+      target);
+    return _partition_manager.local()
+      .shutdown(ntp)
+      .then([this, target](partition_manager::kvstore_state state) {
+          // the state is removed here only once written on the target core
+          return ss::do_with(
+            std::move(state),
+            [this, target](partition_manager::kvstore_state& state) {
+                return _partition_manager
+                  .invoke_on(
+                    target,
+                    [state](partition_manager& pm) mutable {
+                        return pm.restore(std::move(state));
+                    })
+                  .then([this, &state] {
+                      return _partition_manager.local()
+                        .remove_persistent_state(state);
+                  });
+            });
+      })
+      .then([this, ntp = std::move(ntp), group] {
+          // the target core creates the partition once it is not in the
+          // shard table anymore
+          return _shard_table.invoke_on_all(
+            [ntp, group](shard_table& s) { s.erase(ntp, group); });
+      })
+      .then([] { return std::error_code(errc::success); });
+}
+
 bool is_configuration_up_to_date(
   const std::vector<model::broker_shard>& bs,
   const raft::group_configuration& cfg) {
@@ -303,6 +390,27 @@ ss::future<std::error_code> controller_backend::update_partition_replica_set(
     return ss::make_ready_future<std::error_code>(errc::success);
 }
 
+ss::future<> controller_backend::add_to_shard_table(
+  std::vector<std::pair<model::ntp, raft::group_id>> partitions,
+  ss::shard_id shard) {
+    if (partitions.empty()) {
+        return ss::now();
+    }
+    // update shard_table: a single broadcast, read by every core
+    return ss::do_with(
+      std::move(partitions),
+      [this, shard](
+        const std::vector<std::pair<model::ntp, raft::group_id>>& partitions) {
+          return _shard_table.invoke_on_all(
+            [&partitions, shard](shard_table& s) {
+                for (const auto& [ntp, raft_group] : partitions) {
+                    s.insert(ntp, shard);
+                    s.insert(raft_group, shard);
+                }
+            });
+      });
+}
+
 ss::future<> controller_backend::add_to_shard_table(
   model::ntp ntp, raft::group_id raft_group, uint32_t shard) {
     // update shard_table: broadcast
@@ -313,8 +421,8 @@ ss::future<> controller_backend::add_to_shard_table(
       });
 }
 
-ss::future<std::error_code> controller_backend::create_partition(
-  model::ntp ntp,
+ss::future<bool> controller_backend::manage_partition(
+  const model::ntp& ntp,
   raft::group_id group_id,
   model::offset offset,
   std::vector<model::broker> members) {
@@ -322,25 +430,35 @@ ss::future<std::error_code> controller_backend::create_partition(
 
     if (!cfg) {
         // partition was already removed, do nothing
-        return ss::make_ready_future<std::error_code>(errc::success);
+        return ss::make_ready_future<bool>(false);
     }
 
-    auto f = ss::now();
     // handle partially created topic
-    if (likely(_partition_manager.local().get(ntp).get() == nullptr)) {
-        // we use offset as an ntp_id as it is always increasing and it
-        // increases while ntp is being created again
-        auto ntp_id = storage::ntp_config::ntp_id(offset());
-        f = _partition_manager.local()
-              .manage(
-                cfg->make_ntp_config(_data_directory, ntp.tp.partition, ntp_id),
-                group_id,
-                std::move(members))
-              .discard_result();
+    if (unlikely(_partition_manager.local().get(ntp).get() != nullptr)) {
+        return ss::make_ready_future<bool>(true);
     }
+    // we use offset as an ntp_id as it is always increasing and it
+    // increases while ntp is being created again
+    auto ntp_id = storage::ntp_config::ntp_id(offset());
+    return _partition_manager.local()
+      .manage(
+        cfg->make_ntp_config(_data_directory, ntp.tp.partition, ntp_id),
+        group_id,
+        std::move(members))
+      .then([](auto) { return true; });
+}
 
+ss::future<std::error_code> controller_backend::create_partition(
+  model::ntp ntp,
+  raft::group_id group_id,
+  model::offset offset,
+  std::vector<model::broker> members) {
+    auto f = manage_partition(ntp, group_id, offset, std::move(members));
     return f
-      .then([this, ntp = std::move(ntp), group_id]() mutable {
+      .then([this, ntp = std::move(ntp), group_id](bool managed) mutable {
+          if (!managed) {
+              return ss::now();
+          }
           // we create only partitions that belongs to current shard
           return add_to_shard_table(
             std::move(ntp), group_id, ss::this_shard_id());
@@ -348,6 +466,102 @@ ss::future<std::error_code> controller_backend::create_partition(
       .then([] { return make_error_code(errc::success); });
 }
 
+ss::future<controller_backend::results_t>
+controller_backend::create_partitions(
+  const std::vector<topic_table::delta::partition>& additions,
+  model::offset o) {
+    // only create partitions for this backend
+    // partitions created on current shard at this node
+    std::vector<partition_manager::manage_params> params;
+    std::vector<std::pair<model::ntp, raft::group_id>> partitions;
+    size_t local = 0;
+    for (const auto& p : additions) {
+        if (!has_local_replicas(_self, p.second.replicas)) {
+            continue;
+        }
+        ++local;
+        model::ntp ntp(p.first.ns, p.first.tp, p.second.id);
+        auto cfg = _topics.local().get_topic_cfg(p.first);
+        if (!cfg) {
+            // partition was already removed, do nothing
+            continue;
+        }
+        // handle partially created topic
+        if (!_partition_manager.local().get(ntp)) {
+            // we use offset as an ntp_id as it is always increasing and it
+            // increases while ntp is being created again
+            params.push_back(partition_manager::manage_params{
+              .ntp_cfg = cfg->make_ntp_config(
+                _data_directory,
+                ntp.tp.partition,
+                storage::ntp_config::ntp_id(o())),
+              .group = p.second.group,
+              .nodes = create_brokers_set(
+                p.second.replicas, _members_table.local())});
+        }
+        partitions.emplace_back(std::move(ntp), p.second.group);
+    }
+    // the raft groups are all created at once, so that their kvstore writes
+    // are committed together, and the shard tables learn about them in a
+    // single broadcast
+    return _partition_manager.local()
+      .manage_all(std::move(params))
+      .then([this, local, partitions = std::move(partitions)]() mutable {
+          results_t results(local, make_error_code(errc::success));
+          return add_to_shard_table(std::move(partitions), ss::this_shard_id())
+            .then([results = std::move(results)]() mutable {
+                return std::move(results);
+            });
+      });
+}
+
+ss::future<controller_backend::results_t>
+controller_backend::delete_partitions(
+  const std::vector<topic_table::delta::partition>& deletions) {
+    // partitions this core does not have are already deleted
+    std::vector<std::pair<model::ntp, raft::group_id>> partitions;
+    for (const auto& p : deletions) {
+        model::ntp ntp(p.first.ns, p.first.tp, p.second.id);
+        if (auto part = _partition_manager.local().get(ntp); part) {
+            partitions.emplace_back(std::move(ntp), part->group());
+        }
+    }
+    if (partitions.empty()) {
+        return ss::make_ready_future<results_t>();
+    }
+    // the shard and leaders tables forget all of them in a single broadcast
+    return ss::do_with(
+      std::move(partitions),
+      [this](std::vector<std::pair<model::ntp, raft::group_id>>& partitions) {
+          return _shard_table
+            .invoke_on_all([&partitions](shard_table& st) {
+                for (const auto& [ntp, group_id] : partitions) {
+                    st.erase(ntp, group_id);
+                }
+            })
+            .then([this, &partitions] {
+                return _partition_leaders_table.invoke_on_all(
+                  [&partitions](partition_leaders_table& leaders) {
+                      for (const auto& p : partitions) {
+                          leaders.remove_leader(p.first);
+                      }
+                  });
+            })
+            .then([this, &partitions] {
+                std::vector<model::ntp> ntps;
+                ntps.reserve(partitions.size());
+                for (const auto& p : partitions) {
+                    ntps.push_back(p.first);
+                }
+                return _partition_manager.local().remove_all(std::move(ntps));
+            })
+            .then([&partitions] {
+                return results_t(
+                  partitions.size(), make_error_code(errc::success));
+            });
+      });
+}
+
 ss::future<std::error_code>
 controller_backend::delete_partition(model::ntp ntp) {
     auto part = _partition_manager.local().get(ntp);
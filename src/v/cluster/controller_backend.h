@@ -20,6 +20,7 @@
 #include "outcome.h"
 
 #include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
 #include <seastar/core/sharded.hh>
 
 namespace cluster {
@@ -54,13 +55,28 @@ private:
     void start_topics_reconciliation_loop();
     ss::future<> reconcile_topics();
     ss::future<> do_reconcile_topic(task_meta<topic_table::delta>&);
+    void maybe_report_recovery();
     ss::future<std::error_code> create_partition(
       model::ntp, raft::group_id, model::offset, std::vector<model::broker>);
+    ss::future<bool> manage_partition(
+      const model::ntp&,
+      raft::group_id,
+      model::offset,
+      std::vector<model::broker>);
+    ss::future<results_t> create_partitions(
+      const std::vector<topic_table::delta::partition>&, model::offset);
+    ss::future<results_t>
+    delete_partitions(const std::vector<topic_table::delta::partition>&);
     ss::future<> add_to_shard_table(model::ntp, raft::group_id, ss::shard_id);
+    ss::future<> add_to_shard_table(
+      std::vector<std::pair<model::ntp, raft::group_id>>, ss::shard_id);
     ss::future<std::error_code> process_partition_update(
       const topic_table::delta::partition&, model::offset);
 
     ss::future<std::error_code> delete_partition(model::ntp);
+    /// Moves a partition of the current core to another core of the node,
+    /// keeping its log and its persistent state
+    ss::future<std::error_code> migrate_partition(model::ntp, ss::shard_id);
     ss::future<std::error_code> update_partition_replica_set(
       const model::ntp&, const std::vector<model::broker_shard>&);
 
@@ -75,6 +91,9 @@ private:
     ss::sstring _data_directory;
     ss::sharded<ss::abort_source>& _as;
     std::vector<task_meta<topic_table::delta>> _topic_deltas;
+    // the partitions of this core, as of startup, are being recovered
+    bool _recovering{true};
+    ss::lowres_clock::time_point _started_at;
     ss::timer<> _housekeeping_timer;
     ss::semaphore _topics_sem{1};
     ss::gate _gate;
@@ -0,0 +1,98 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/controller_stm.h"
+
+#include "config/configuration.h"
+#include "raft/consensus.h"
+#include "reflection/adl.h"
+#include "vlog.h"
+
+namespace cluster {
+
+controller_stm::controller_stm(
+  ss::logger& logger,
+  raft::consensus* c,
+  raft::persistent_last_applied persist,
+  topic_updates_dispatcher& dispatcher)
+  : raft::mux_state_machine<topic_updates_dispatcher>(
+    logger, c, persist, dispatcher)
+  , _raft(c)
+  , _dispatcher(dispatcher)
+  , _log(logger) {
+    _snapshot_timer.set_callback([this] {
+        (void)ss::with_gate(_gate, [this] {
+            return maybe_write_snapshot().finally([this] {
+                if (!_gate.is_closed()) {
+                    _snapshot_timer.arm(
+                      config::shard_local_cfg()
+                        .controller_snapshot_interval_ms());
+                }
+            });
+        });
+    });
+}
+
+ss::future<> controller_stm::start() {
+    return raft::mux_state_machine<topic_updates_dispatcher>::start().then(
+      [this] {
+          _snapshot_timer.arm(
+            config::shard_local_cfg().controller_snapshot_interval_ms());
+      });
+}
+
+ss::future<> controller_stm::stop() {
+    _snapshot_timer.cancel();
+    return _gate.close().then([this] {
+        return raft::mux_state_machine<topic_updates_dispatcher>::stop();
+    });
+}
+
+ss::future<>
+controller_stm::apply_snapshot(model::offset last_included, iobuf&& data) {
+    auto snapshot = reflection::from_iobuf<controller_snapshot>(
+      std::move(data));
+    vassert(
+      snapshot.version == controller_snapshot::current_version,
+      "Unsupported controller snapshot version {}",
+      int(snapshot.version));
+    vlog(
+      _log.info,
+      "Loading {} topics from the controller snapshot up to {}",
+      snapshot.topics.size(),
+      last_included);
+    _last_snapshot = last_included;
+    return _dispatcher.apply_snapshot(last_included, std::move(snapshot));
+}
+
+ss::future<> controller_stm::maybe_write_snapshot() {
+    const auto offset = _dispatcher.last_applied();
+    if (offset <= _last_snapshot) {
+        return ss::now();
+    }
+    auto snapshot = _dispatcher.make_snapshot();
+    if (!snapshot) {
+        // an update is being applied, the next round takes the snapshot
+        return ss::now();
+    }
+    vlog(
+      _log.debug,
+      "Writing controller snapshot of {} topics up to {}",
+      snapshot->topics.size(),
+      offset);
+    return _raft
+      ->write_snapshot(raft::write_snapshot_cfg(
+        offset, reflection::to_iobuf(std::move(*snapshot))))
+      .then([this, offset] { _last_snapshot = offset; })
+      .handle_exception([this](const std::exception_ptr& e) {
+          vlog(_log.warn, "Unable to write controller snapshot - {}", e);
+      });
+}
+
+} // namespace cluster
@@ -15,11 +15,41 @@
 #include "cluster/topic_updates_dispatcher.h"
 #include "raft/mux_state_machine.h"
 
+#include <seastar/core/gate.hh>
+#include <seastar/core/timer.hh>
+
 namespace cluster {
 
 // single instance
-using controller_stm = raft::mux_state_machine<topic_updates_dispatcher>;
+//
+// The controller state is periodically written into the raft0 snapshot, which
+// prefix truncates the log. Nodes restarting, or lagging followers installing
+// the snapshot of the leader, load the state from it and only replay the
+// entries that follow.
+class controller_stm final
+  : public raft::mux_state_machine<topic_updates_dispatcher> {
+public:
+    controller_stm(
+      ss::logger&,
+      raft::consensus*,
+      raft::persistent_last_applied,
+      topic_updates_dispatcher&);
+
+    ss::future<> start();
+    ss::future<> stop();
+
+private:
+    ss::future<> apply_snapshot(model::offset, iobuf&&) final;
+    ss::future<> maybe_write_snapshot();
+
+    raft::consensus* _raft;
+    topic_updates_dispatcher& _dispatcher;
+    ss::logger& _log;
+    model::offset _last_snapshot;
+    ss::timer<> _snapshot_timer;
+    ss::gate _gate;
+};
 
 static constexpr ss::shard_id controller_stm_shard = 0;
 
-} // namespace cluster
\ No newline at end of file
+} // namespace cluster
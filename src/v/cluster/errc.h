@@ -33,7 +33,13 @@ enum class errc {
     topic_not_exists,
     invalid_topic_name,
     partition_not_exists,
-    not_leader
+    not_leader,
+    partition_migrating,
+    sequence_out_of_order,
+    duplicate_sequence,
+    invalid_producer_epoch,
+    unknown_producer_id,
+    transactions_unsupported,
 };
 struct errc_category final : public std::error_category {
     const char* name() const noexcept final { return "cluster::errc"; }
@@ -80,6 +86,19 @@ struct errc_category final : public std::error_category {
             return "Invalid topic name";
         case errc::partition_not_exists:
             return "Requested partition does not exists";
+        case errc::partition_migrating:
+            return "Partition is moving from another core";
+        case errc::sequence_out_of_order:
+            return "Batch sequence number does not follow the previous batch "
+                   "of the producer";
+        case errc::duplicate_sequence:
+            return "Batch of the producer is being written already";
+        case errc::invalid_producer_epoch:
+            return "Producer epoch is older than the current one";
+        case errc::unknown_producer_id:
+            return "Producer is unknown to the partition";
+        case errc::transactions_unsupported:
+            return "Partition does not track the state of producers";
         default:
             return "cluster::errc::unknown";
         }
@@ -0,0 +1,221 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/leader_balancer.h"
+
+#include "cluster/errc.h"
+#include "cluster/logger.h"
+#include "config/configuration.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "vlog.h"
+
+#include <seastar/core/loop.hh>
+#include <seastar/core/metrics.hh>
+
+namespace cluster {
+
+leader_balancer::leader_balancer(
+  ss::sharded<topic_table>& topics,
+  ss::sharded<partition_leaders_table>& leaders,
+  ss::sharded<partition_manager>& partition_manager)
+  : _topics(topics)
+  , _leaders(leaders)
+  , _partition_manager(partition_manager)
+  , _self(config::shard_local_cfg().node_id()) {}
+
+ss::future<> leader_balancer::start() {
+    setup_metrics();
+    if (!config::shard_local_cfg().enable_leader_balancer()) {
+        return ss::now();
+    }
+    _timer.set_callback([this] { tick(); });
+    _timer.arm_periodic(
+      config::shard_local_cfg().leader_balancer_interval_ms());
+    return ss::now();
+}
+
+ss::future<> leader_balancer::stop() {
+    _timer.cancel();
+    return _gate.close();
+}
+
+void leader_balancer::tick() {
+    if (_balancing || _gate.is_closed()) {
+        // the previous round is still transferring
+        return;
+    }
+    _balancing = true;
+    (void)ss::with_gate(_gate, [this] {
+        return balance().finally([this] { _balancing = false; });
+    });
+}
+
+ss::future<> leader_balancer::balance() {
+    std::map<core, size_t> leaders;
+    std::vector<led_partition> led;
+    for (auto& md : _topics.local().all_topics_metadata()) {
+        for (auto& p : md.partitions) {
+            std::vector<core> replicas;
+            replicas.reserve(p.replicas.size());
+            for (const auto& r : p.replicas) {
+                // cores without leaders are candidates too
+                leaders.try_emplace(core(r.node_id, r.shard), 0);
+                replicas.emplace_back(r.node_id, r.shard);
+            }
+            auto leader = _leaders.local().get_leader(md.tp_ns, p.id);
+            if (!leader) {
+                continue;
+            }
+            auto it = std::find_if(
+              replicas.begin(), replicas.end(), [&leader](const core& c) {
+                  return c.first == *leader;
+              });
+            if (it == replicas.end()) {
+                // leadership is stale
+                continue;
+            }
+            leaders[*it]++;
+            if (*leader == _self) {
+                led.push_back(led_partition{
+                  .ntp = model::ntp(md.tp_ns.ns, md.tp_ns.tp, p.id),
+                  .leader = *it,
+                  .replicas = std::move(replicas)});
+            }
+        }
+    }
+    ++_rounds;
+    auto transfers = plan(
+      std::move(leaders),
+      led,
+      config::shard_local_cfg().leader_balancer_max_transfers());
+    if (transfers.empty()) {
+        return ss::now();
+    }
+    vlog(
+      clusterlog.info,
+      "Rebalancing leadership of {} partitions",
+      transfers.size());
+    // one at a time, not to disrupt many partitions together
+    return ss::do_with(
+      std::move(transfers), [this](std::vector<transfer>& transfers) {
+          return ss::do_for_each(transfers, [this](const transfer& t) {
+              return do_transfer(t);
+          });
+      });
+}
+
+std::vector<leader_balancer::transfer> leader_balancer::plan(
+  std::map<core, size_t> leaders,
+  const std::vector<led_partition>& led,
+  size_t max_transfers) {
+    std::vector<transfer> ret;
+    std::vector<bool> moved(led.size(), false);
+    while (ret.size() < max_transfers) {
+        // the move that narrows the widest gap between two cores
+        std::optional<size_t> best;
+        core best_target;
+        size_t best_gap = 1;
+        for (size_t i = 0; i < led.size(); ++i) {
+            if (moved[i]) {
+                continue;
+            }
+            const auto& p = led[i];
+            const size_t source = leaders[p.leader];
+            for (const auto& r : p.replicas) {
+                if (r.first == p.leader.first) {
+                    continue;
+                }
+                const size_t target = leaders[r];
+                if (source > target && source - target > best_gap) {
+                    best = i;
+                    best_target = r;
+                    best_gap = source - target;
+                }
+            }
+        }
+        if (!best) {
+            // moving any leadership would not make the cores more even
+            break;
+        }
+        const auto& p = led[*best];
+        leaders[p.leader]--;
+        leaders[best_target]++;
+        moved[*best] = true;
+        ret.push_back(transfer{
+          .ntp = p.ntp,
+          .shard = p.leader.second,
+          .target = best_target.first});
+    }
+    return ret;
+}
+
+ss::future<> leader_balancer::do_transfer(const transfer& t) {
+    vlog(
+      clusterlog.debug,
+      "Transferring leadership of {} to node {}",
+      t.ntp,
+      t.target);
+    return _partition_manager
+      .invoke_on(
+        t.shard,
+        [ntp = t.ntp, target = t.target](partition_manager& pm) {
+            auto partition = pm.get(ntp);
+            if (!partition) {
+                return ss::make_ready_future<std::error_code>(
+                  errc::partition_not_exists);
+            }
+            return partition->transfer_leadership(target);
+        })
+      .then_wrapped([this, ntp = t.ntp](ss::future<std::error_code> f) {
+          if (f.failed()) {
+              ++_failed_transfers;
+              vlog(
+                clusterlog.info,
+                "Leadership transfer of {} failed: {}",
+                ntp,
+                f.get_exception());
+              return;
+          }
+          if (auto ec = f.get0(); ec) {
+              ++_failed_transfers;
+              vlog(
+                clusterlog.info,
+                "Leadership transfer of {} failed: {}",
+                ntp,
+                ec.message());
+              return;
+          }
+          ++_transfers;
+      });
+}
+
+void leader_balancer::setup_metrics() {
+    namespace sm = ss::metrics;
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("cluster:leader_balancer"),
+      {
+        sm::make_derive(
+          "rounds",
+          [this] { return _rounds; },
+          sm::description("Number of leadership rebalancing rounds")),
+        sm::make_derive(
+          "leader_transfers",
+          [this] { return _transfers; },
+          sm::description("Number of leaderships transferred")),
+        sm::make_derive(
+          "failed_leader_transfers",
+          [this] { return _failed_transfers; },
+          sm::description("Number of failed leadership transfers")),
+      });
+}
+
+} // namespace cluster
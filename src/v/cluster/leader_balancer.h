@@ -0,0 +1,93 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "cluster/partition_leaders_table.h"
+#include "cluster/partition_manager.h"
+#include "cluster/topic_table.h"
+#include "model/fundamental.h"
+#include "model/metadata.h"
+
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
+
+#include <map>
+#include <vector>
+
+namespace cluster {
+
+/// Spreads raft leadership evenly across the cores of the cluster.
+///
+/// Every node runs a balancer, which periodically counts the leaders of each
+/// core, a core being a replica's node and shard, from the topic and the
+/// partition leaders tables. It then moves the leadership of partitions it
+/// leads from its most loaded cores to the least loaded core among their
+/// replicas, for as long as that narrows the gap, and at most
+/// leader_balancer_max_transfers times per round. Nodes only transfer the
+/// leaderships they hold, so their rounds do not conflict.
+class leader_balancer {
+public:
+    static constexpr ss::shard_id shard = 0;
+
+    leader_balancer(
+      ss::sharded<topic_table>&,
+      ss::sharded<partition_leaders_table>&,
+      ss::sharded<partition_manager>&);
+
+    ss::future<> start();
+    ss::future<> stop();
+
+    /// A leadership the balancer moves
+    struct transfer {
+        model::ntp ntp;
+        ss::shard_id shard;
+        model::node_id target;
+    };
+
+    using core = std::pair<model::node_id, ss::shard_id>;
+    /// A partition led by this node
+    struct led_partition {
+        model::ntp ntp;
+        core leader;
+        std::vector<core> replicas;
+    };
+
+    /// \brief the transfers that even out the leaders per core, given the
+    /// leaders of each core and the partitions this node leads
+    static std::vector<transfer> plan(
+      std::map<core, size_t> leaders,
+      const std::vector<led_partition>&,
+      size_t max_transfers);
+
+private:
+    void tick();
+    ss::future<> balance();
+    ss::future<> do_transfer(const transfer&);
+    void setup_metrics();
+
+    ss::sharded<topic_table>& _topics;
+    ss::sharded<partition_leaders_table>& _leaders;
+    ss::sharded<partition_manager>& _partition_manager;
+    model::node_id _self;
+    ss::timer<> _timer;
+    ss::gate _gate;
+    bool _balancing{false};
+
+    uint64_t _rounds{0};
+    uint64_t _transfers{0};
+    uint64_t _failed_transfers{0};
+    ss::metrics::metric_groups _metrics;
+};
+
+} // namespace cluster
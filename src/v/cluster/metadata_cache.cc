@@ -15,6 +15,7 @@
 #include "model/fundamental.h"
 #include "model/metadata.h"
 #include "model/timestamp.h"
+#include "random/generators.h"
 
 #include <seastar/core/sharded.hh>
 
@@ -73,6 +74,14 @@ std::vector<model::topic_metadata> metadata_cache::all_topics_metadata() const {
     return all_md;
 }
 
+metadata_cache::topic_revision
+metadata_cache::get_topic_revision(model::topic_namespace_view tp) const {
+    return topic_revision{
+      .topic = _topics_state.local().topic_revision(tp),
+      .leaders = _leaders.local().topic_revision(tp),
+    };
+}
+
 std::optional<broker_ptr> metadata_cache::get_broker(model::node_id nid) const {
     return _members_table.local().get_broker(nid);
 }
@@ -90,6 +99,32 @@ bool metadata_cache::contains(
     return _topics_state.local().contains(tp, pid);
 }
 
+std::optional<model::node_id> metadata_cache::get_preferred_read_replica(
+  model::topic_namespace_view tp,
+  model::partition_id pid,
+  const ss::sstring& rack) const {
+    auto assignment = _topics_state.local().get_partition_assignment(tp, pid);
+    if (!assignment) {
+        return std::nullopt;
+    }
+    auto leader = _leaders.local().get_leader(tp, pid);
+    std::vector<model::node_id> in_rack;
+    for (const auto& bs : assignment->replicas) {
+        auto broker = get_broker(bs.node_id);
+        if (!broker || (*broker)->rack() != rack) {
+            continue;
+        }
+        if (bs.node_id == leader) {
+            return std::nullopt;
+        }
+        in_rack.push_back(bs.node_id);
+    }
+    if (in_rack.empty()) {
+        return std::nullopt;
+    }
+    return in_rack[random_generators::get_int<size_t>(in_rack.size() - 1)];
+}
+
 ss::future<model::node_id> metadata_cache::get_leader(
   const model::ntp& ntp,
   ss::lowres_clock::time_point tout,
@@ -83,6 +83,22 @@ public:
     /// Returns metadata of all topics.
     std::vector<model::topic_metadata> all_topics_metadata() const;
 
+    /// Revision of the metadata of a topic, including the leaders of its
+    /// partitions. It changes whenever get_topic_metadata() of the topic may
+    /// return something else.
+    struct topic_revision {
+        uint64_t topic{0};
+        uint64_t leaders{0};
+
+        bool exists() const { return topic != 0; }
+        bool operator==(const topic_revision& o) const {
+            return topic == o.topic && leaders == o.leaders;
+        }
+        bool operator!=(const topic_revision& o) const { return !(*this == o); }
+    };
+
+    topic_revision get_topic_revision(model::topic_namespace_view) const;
+
     /// Returns all brokers, returns copy as the content of broker can change
     std::vector<broker_ptr> all_brokers() const;
 
@@ -95,6 +111,17 @@ public:
 
     bool contains(model::topic_namespace_view, model::partition_id) const;
 
+    ///\brief Returns a replica of the partition in the rack of a client,
+    /// which the client should fetch from instead of the leader.
+    ///
+    /// Returns an empty optional when the leader is in the rack of the client,
+    /// or when none of the replicas is. The replica is picked at random among
+    /// the replicas of the rack so that their clients spread the reads.
+    std::optional<model::node_id> get_preferred_read_replica(
+      model::topic_namespace_view,
+      model::partition_id,
+      const ss::sstring& rack) const;
+
     /// Returns metadata of all topics in cache internal format
     // const cache_t& all_metadata() const { return _cache; }
 
@@ -40,32 +40,47 @@ metadata_dissemination_handler::update_leadership(
 ss::future<update_leadership_reply>
 metadata_dissemination_handler::do_update_leadership(
   update_leadership_request&& req) {
-    return _leaders
-      .invoke_on_all(
-        [req = std::move(req)](partition_leaders_table& pl) mutable {
-            for (auto& leader : req.leaders) {
-                pl.update_partition_leader(
-                  leader.ntp, leader.term, leader.leader_id);
-            }
-        })
-      .then([] { return ss::make_ready_future<update_leadership_reply>(); });
+    // the request is read by every shard rather than copied to each of them
+    return ss::do_with(
+      std::move(req), [this](const update_leadership_request& req) {
+          return _leaders
+            .invoke_on_all([&req](partition_leaders_table& pl) {
+                for (const auto& leader : req.leaders) {
+                    pl.update_partition_leader(
+                      leader.ntp, leader.term, leader.leader_id);
+                }
+            })
+            .then(
+              [] { return ss::make_ready_future<update_leadership_reply>(); });
+      });
 }
 
-static get_leadership_reply
-make_get_leadership_reply(const partition_leaders_table& leaders) {
+static get_leadership_reply make_get_leadership_reply(
+  const partition_leaders_table& leaders, const get_leadership_request& req) {
+    // only the changes are sent to a node that already pulled from this
+    // table, everything otherwise
+    const uint64_t since = req.instance == leaders.instance()
+                               && req.since_revision <= leaders.revision()
+                             ? req.since_revision
+                             : 0;
     ntp_leaders ret;
-    leaders.for_each_leader([&ret](
-                              model::topic_namespace_view tp_ns,
-                              model::partition_id pid,
-                              std::optional<model::node_id> leader,
-                              model::term_id term) mutable {
-        ret.emplace_back(ntp_leader{
-          .ntp = model::ntp(tp_ns.ns, tp_ns.tp, pid),
-          .term = term,
-          .leader_id = leader});
-    });
+    leaders.for_each_leader_since(
+      since,
+      [&ret](
+        model::topic_namespace_view tp_ns,
+        model::partition_id pid,
+        std::optional<model::node_id> leader,
+        model::term_id term) mutable {
+          ret.emplace_back(ntp_leader{
+            .ntp = model::ntp(tp_ns.ns, tp_ns.tp, pid),
+            .term = term,
+            .leader_id = leader});
+      });
 
-    return get_leadership_reply{std::move(ret)};
+    return get_leadership_reply{
+      .leaders = std::move(ret),
+      .instance = leaders.instance(),
+      .revision = leaders.revision()};
 }
 
 ss::future<get_leadership_reply> metadata_dissemination_handler::get_leadership(
@@ -73,7 +88,7 @@ ss::future<get_leadership_reply> metadata_dissemination_handler::get_leadership(
     return ss::with_scheduling_group(
       get_scheduling_group(), [this, req = std::move(req)]() mutable {
           return ss::make_ready_future<get_leadership_reply>(
-            make_get_leadership_reply(_leaders.local()));
+            make_get_leadership_reply(_leaders.local(), req));
       });
 }
 
@@ -22,6 +22,7 @@
 #include "model/fundamental.h"
 #include "model/metadata.h"
 #include "model/timeout_clock.h"
+#include "reflection/adl.h"
 #include "rpc/connection_cache.h"
 #include "rpc/types.h"
 #include "utils/retry.h"
@@ -39,6 +40,12 @@
 #include <exception>
 
 namespace cluster {
+/// Dissemination periods between queries of the leadership changes
+static constexpr uint32_t reconcile_every_ticks = 10;
+/// Dissemination periods after which the updates not delivered along with
+/// the heartbeats are sent in an update request
+static constexpr uint32_t request_after_ticks = 2;
+
 metadata_dissemination_service::metadata_dissemination_service(
   ss::sharded<raft::group_manager>& raft_manager,
   ss::sharded<cluster::partition_manager>& partition_manager,
@@ -98,6 +105,7 @@ ss::future<> metadata_dissemination_service::start() {
     if (ss::this_shard_id() != 0) {
         return ss::make_ready_future<>();
     }
+    _raft_manager.local().set_heartbeat_attachments(this);
     // poll either seed servers or configuration
     auto ids = _members_table.local().all_broker_ids();
     // use hash set to deduplicate ids
@@ -148,22 +156,97 @@ ss::future<> metadata_dissemination_service::apply_leadership_notification(
     // the gate also needs to be taken on the destination core.
     return ss::with_gate(
       _bg, [this, ntp = std::move(ntp), lid, term]() mutable {
-          // the lock sequences the updates from raft
-          return _lock.with([this, ntp = std::move(ntp), lid, term]() mutable {
-              // update partition leaders
-              auto f = _leaders.invoke_on_all(
-                [ntp, lid, term](partition_leaders_table& leaders) {
-                    leaders.update_partition_leader(ntp, term, lid);
-                });
-              if (lid == _self) {
-                  // only disseminate from current leader
-                  f = f.then([this, ntp = std::move(ntp), term, lid]() mutable {
-                      return disseminate_leadership(std::move(ntp), term, lid);
-                  });
+          _notifications.push_back(ntp_leader{std::move(ntp), term, lid});
+          // the lock sequences the updates from raft, the notifications that
+          // arrive while it is held are applied together
+          return _lock.with(
+            [this] { return apply_pending_leadership_notifications(); });
+      });
+}
+
+ss::future<>
+metadata_dissemination_service::apply_pending_leadership_notifications() {
+    if (_notifications.empty()) {
+        // applied along with an earlier notification
+        return ss::now();
+    }
+    return ss::do_with(
+      std::exchange(_notifications, {}), [this](ntp_leaders& notifications) {
+          return _leaders
+            .invoke_on_all([&notifications](partition_leaders_table& leaders) {
+                for (const auto& n : notifications) {
+                    leaders.update_partition_leader(n.ntp, n.term, n.leader_id);
+                }
+            })
+            .then([this, &notifications] {
+                for (auto& n : notifications) {
+                    // only disseminate from current leader
+                    if (n.leader_id == _self) {
+                        disseminate_leadership(
+                          std::move(n.ntp), n.term, n.leader_id);
+                    }
+                }
+            });
+      });
+}
+
+ss::future<> metadata_dissemination_service::update_leaders(
+  ntp_leaders leaders) {
+    // the leaders are read by every shard rather than copied to each of them
+    return ss::do_with(std::move(leaders), [this](const ntp_leaders& leaders) {
+        return _leaders.invoke_on_all(
+          [&leaders](partition_leaders_table& table) {
+              for (const auto& l : leaders) {
+                  table.update_partition_leader(l.ntp, l.term, l.leader_id);
               }
-              return f;
           });
-      });
+    });
+}
+
+ss::future<>
+metadata_dissemination_service::apply_heartbeat_attachment(iobuf buf) {
+    auto req = reflection::from_iobuf<update_leadership_request>(
+      std::move(buf));
+    vlog(
+      clusterlog.trace,
+      "Received {} leadership updates along with a heartbeat",
+      req.leaders.size());
+    return update_leaders(std::move(req.leaders));
+}
+
+std::vector<model::node_id> metadata_dissemination_service::pending() {
+    collect_pending_updates();
+    std::vector<model::node_id> ret;
+    ret.reserve(_pending_updates.size());
+    for (const auto& [id, meta] : _pending_updates) {
+        if (!meta.finished) {
+            ret.push_back(id);
+        }
+    }
+    return ret;
+}
+
+std::optional<std::pair<iobuf, uint64_t>>
+metadata_dissemination_service::attachment(model::node_id id) {
+    auto it = _pending_updates.find(id);
+    if (it == _pending_updates.end() || it->second.finished) {
+        return std::nullopt;
+    }
+    update_leadership_request req;
+    req.leaders.reserve(it->second.updates.size());
+    for (const auto& [_, update] : it->second.updates) {
+        req.leaders.push_back(update);
+    }
+    return std::make_pair(
+      reflection::to_iobuf(std::move(req)), it->second.version);
+}
+
+void metadata_dissemination_service::delivered(
+  model::node_id id, uint64_t version) {
+    if (auto it = _pending_updates.find(id);
+        it != _pending_updates.end() && it->second.version == version) {
+        it->second.finished = true;
+    }
 }
 
 static inline ss::future<>
@@ -223,15 +306,45 @@ ss::future<> metadata_dissemination_service::process_get_update_reply(
           *meta.next);
         return ss::make_ready_future<>();
     }
+    auto& reply = reply_result.value();
+    _leadership_version = leadership_version{
+      .id = *meta.next, .instance = reply.instance, .revision = reply.revision};
     // Update all NTP leaders
-    return _leaders
-      .invoke_on_all([reply = std::move(reply_result.value())](
-                       partition_leaders_table& leaders) mutable {
-          for (auto& l : reply.leaders) {
-              leaders.update_partition_leader(l.ntp, l.term, l.leader_id);
+    return update_leaders(std::move(reply.leaders)).then([&meta] {
+        meta.success = true;
+    });
+}
+
+ss::future<> metadata_dissemination_service::reconcile_leadership() {
+    if (!_leadership_version || _reconciling) {
+        return ss::now();
+    }
+    _reconciling = true;
+    const auto id = _leadership_version->id;
+    return dispatch_get_metadata_update(id)
+      .then([this, id](result<get_leadership_reply> r) {
+          if (!r) {
+              vlog(
+                clusterlog.debug,
+                "Unable to query leadership changes from node {} - {}",
+                id,
+                r.error().message());
+              return ss::now();
           }
+          auto& reply = r.value();
+          vlog(
+            clusterlog.trace,
+            "Received {} leadership changes from node {}",
+            reply.leaders.size(),
+            id);
+          _leadership_version = leadership_version{
+            .id = id, .instance = reply.instance, .revision = reply.revision};
+          return update_leaders(std::move(reply.leaders));
+      })
+      .handle_exception([](const std::exception_ptr& e) {
+          vlog(clusterlog.debug, "Leadership changes query error: {}", e);
       })
-      .then([&meta] { meta.success = true; });
+      .finally([this] { _reconciling = false; });
 }
 
 ss::future<result<get_leadership_reply>>
@@ -243,10 +356,16 @@ metadata_dissemination_service::dispatch_get_metadata_update(
         _self,
         ss::this_shard_id(),
         id,
-        [this](metadata_dissemination_rpc_client_protocol c) {
+        [this, id](metadata_dissemination_rpc_client_protocol c) {
+            // a node already queried only returns what changed since
+            get_leadership_request req;
+            if (_leadership_version && _leadership_version->id == id) {
+                req.instance = _leadership_version->instance;
+                req.since_revision = _leadership_version->revision;
+            }
             return c
               .get_leadership(
-                get_leadership_request{},
+                req,
                 rpc::client_opts(
                   rpc::clock_type::now() + _dissemination_interval))
               .then(&rpc::get_ctx_data<get_leadership_reply>);
@@ -266,10 +385,16 @@ void metadata_dissemination_service::collect_pending_updates() {
         auto non_overlapping = calculate_non_overlapping_nodes(
           get_partition_members(ntp_leader.ntp.tp.partition, *tp_md), brokers);
         for (auto& id : non_overlapping) {
-            if (!_pending_updates.contains(id)) {
-                _pending_updates.emplace(id, update_retry_meta{ntp_leaders{}});
+            auto& meta = _pending_updates[id];
+            auto it = meta.updates.find(ntp_leader.ntp);
+            if (it == meta.updates.end()) {
+                meta.updates.emplace(ntp_leader.ntp, ntp_leader);
+            } else if (it->second.term <= ntp_leader.term) {
+                it->second = ntp_leader;
             }
-            _pending_updates[id].updates.push_back(ntp_leader);
+            // a delivered update of the node is sent again with this one
+            meta.finished = false;
+            ++meta.version;
         }
     }
     _requests.clear();
@@ -290,39 +415,57 @@ void metadata_dissemination_service::cleanup_finished_updates() {
 
 ss::future<> metadata_dissemination_service::dispatch_disseminate_leadership() {
     collect_pending_updates();
+    if (++_ticks % reconcile_every_ticks == 0 && !_bg.is_closed()) {
+        // in the background, not to delay the dissemination
+        (void)ss::with_gate(_bg, [this] { return reconcile_leadership(); });
+    }
+    cleanup_finished_updates();
     return ss::parallel_for_each(
              _pending_updates.begin(),
              _pending_updates.end(),
              [this](broker_updates_t::value_type& br_update) {
-                 return dispatch_one_update(br_update.first, br_update.second);
+                 auto& meta = br_update.second;
+                 // the heartbeats deliver the updates in the meantime
+                 if (++meta.age < request_after_ticks) {
+                     return ss::now();
+                 }
+                 return dispatch_one_update(br_update.first, meta);
              })
       .then([this] { cleanup_finished_updates(); });
 }
 
 ss::future<> metadata_dissemination_service::dispatch_one_update(
   model::node_id target_id, update_retry_meta& meta) {
+    // the pending updates change along with the heartbeats while the request
+    // is in flight, it only holds onto the version it sends
+    ntp_leaders updates;
+    updates.reserve(meta.updates.size());
+    for (const auto& [_, update] : meta.updates) {
+        updates.push_back(update);
+    }
     return _clients.local()
       .with_node_client<metadata_dissemination_rpc_client_protocol>(
         _self,
         ss::this_shard_id(),
         target_id,
-        [this, &meta, target_id](
+        [this, updates = std::move(updates), target_id](
           metadata_dissemination_rpc_client_protocol proto) mutable {
             vlog(
               clusterlog.trace,
               "Sending {} metadata updates to {}",
-              meta.updates.size(),
+              updates.size(),
               target_id);
             return proto
               .update_leadership(
-                update_leadership_request{meta.updates},
+                update_leadership_request{std::move(updates)},
                 rpc::client_opts(
                   _dissemination_interval + rpc::clock_type::now()))
               .then(&rpc::get_ctx_data<update_leadership_reply>);
         })
-      .then([target_id, &meta](result<update_leadership_reply> r) {
+      .then([this, target_id, version = meta.version](
+              result<update_leadership_reply> r) {
           if (r) {
-              meta.finished = true;
+              delivered(target_id, version);
               return;
           }
           vlog(
@@ -337,6 +480,9 @@ ss::future<> metadata_dissemination_service::dispatch_one_update(
 }
 
 ss::future<> metadata_dissemination_service::stop() {
+    if (ss::this_shard_id() == 0) {
+        _raft_manager.local().set_heartbeat_attachments(nullptr);
+    }
     _raft_manager.local().unregister_leadership_notification(
       _notification_handle);
     _as.request_abort();
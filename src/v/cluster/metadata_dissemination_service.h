@@ -40,7 +40,17 @@ namespace cluster {
 /// The service caches all leadership updates and sends them as
 /// batch per node, every configurable period of time. This service is also
 /// responsible for querying one of the cluster nodes for current leadership
-/// metadata when node has started.
+/// metadata when node has started. Later queries to that node only return the
+/// leaders that changed since the previous one; they run every few periods to
+/// catch up with updates that were not delivered.
+///
+/// The updates are sent along with the raft heartbeats of shard 0, see
+/// raft::heartbeat_attachments, so that they arrive within a heartbeat
+/// interval; the update requests only deliver those that are still pending
+/// a couple of periods later.
+///
+/// Leadership notifications of all shards are applied to the leaders table of
+/// every shard in batches, rather than one cross shard broadcast each.
 ///
 /// Used acronymes:
 /// RG<num> - raft group with <num> id
@@ -71,7 +81,8 @@ namespace cluster {
 ///                New leader
 
 class metadata_dissemination_service final
-  : public ss::peering_sharded_service<metadata_dissemination_service> {
+  : public ss::peering_sharded_service<metadata_dissemination_service>
+  , public raft::heartbeat_attachments {
 public:
     metadata_dissemination_service(
       ss::sharded<raft::group_manager>&,
@@ -89,13 +100,33 @@ public:
     ss::future<> start();
     ss::future<> stop();
 
+    /// Applies the leadership updates sent along with a heartbeat
+    ss::future<> apply_heartbeat_attachment(iobuf);
+
+    std::vector<model::node_id> pending() final;
+    std::optional<std::pair<iobuf, uint64_t>>
+      attachment(model::node_id) final;
+    void delivered(model::node_id, uint64_t) final;
+
 private:
     // Used to store pending updates
     // When update was delivered successfully the finished flag is set to true
     // and object is removed from pending updates map
     struct update_retry_meta {
-        ntp_leaders updates;
+        // only the latest update of each ntp is sent
+        absl::flat_hash_map<model::ntp, ntp_leader> updates;
         bool finished = false;
+        // bumped on every change of the updates, a delivered attachment
+        // only finishes the version it carried
+        uint64_t version{0};
+        // dissemination periods the updates have been pending
+        uint32_t age{0};
+    };
+    // The leaders table of a node, and its revision, as of the last query
+    struct leadership_version {
+        model::node_id id;
+        uint64_t instance{0};
+        uint64_t revision{0};
     };
     // Used to track the process of requesting update when redpanda starts
     // when update using a node from ids will fail we will try the next one
@@ -115,6 +146,9 @@ private:
       model::ntp, model::term_id, std::optional<model::node_id>);
     ss::future<> apply_leadership_notification(
       model::ntp, model::term_id, std::optional<model::node_id>);
+    ss::future<> apply_pending_leadership_notifications();
+    ss::future<> update_leaders(ntp_leaders);
+    ss::future<> reconcile_leadership();
 
     void collect_pending_updates();
     void cleanup_finished_updates();
@@ -137,6 +171,11 @@ private:
     model::node_id _self;
     std::chrono::milliseconds _dissemination_interval;
     std::vector<ntp_leader> _requests;
+    // notifications waiting to be applied to the leaders tables
+    std::vector<ntp_leader> _notifications;
+    std::optional<leadership_version> _leadership_version;
+    uint32_t _ticks{0};
+    bool _reconciling{false};
     std::vector<model::node_id> _seed_server_ids;
     broker_updates_t _pending_updates;
     mutex _lock;
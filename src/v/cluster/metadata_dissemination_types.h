@@ -31,10 +31,18 @@ struct update_leadership_request {
 
 struct update_leadership_reply {};
 
-struct get_leadership_request {};
+/// \brief requests the leaders that changed after the revision of the
+/// leaders table instance, all of them when the instance is another one
+struct get_leadership_request {
+    uint64_t instance{0};
+    uint64_t since_revision{0};
+};
 
 struct get_leadership_reply {
     ntp_leaders leaders;
+    /// the leaders table the reply was made from, and its revision
+    uint64_t instance{0};
+    uint64_t revision{0};
 };
 
 inline std::ostream& operator<<(std::ostream& o, const ntp_leader& l) {
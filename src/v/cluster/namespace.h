@@ -30,6 +30,16 @@ inline model::ntp kvstore_ntp(ss::shard_id shard) {
     return model::ntp(redpanda_ns, kvstore_topic, model::partition_id(shard));
 }
 
+/*
+ * The shared write-ahead log of the logs of a core, see storage::shared_wal,
+ * is organized as the kvstore.
+ */
+inline const model::topic shared_wal_topic("shared_wal");
+inline model::ntp shared_wal_ntp(ss::shard_id shard) {
+    return model::ntp(
+      redpanda_ns, shared_wal_topic, model::partition_id(shard));
+}
+
 inline const model::ns kafka_namespace("kafka");
 
 inline const model::ns kafka_internal_namespace("kafka_internal");
@@ -10,6 +10,7 @@
 #include "cluster/partition.h"
 
 #include "cluster/logger.h"
+#include "cluster/namespace.h"
 #include "prometheus/prometheus_sanitize.h"
 
 namespace cluster {
@@ -17,9 +18,20 @@ namespace cluster {
 partition::partition(consensus_ptr r)
   : _raft(r)
   , _probe(*this) {
+    // the batches of kafka producers are deduplicated
+    if (_raft->ntp().ns == kafka_namespace) {
+        _producer_stm = std::make_unique<producer_state_stm>(
+          _raft.get(), clusterlog);
+    }
     if (_raft->log_config().is_collectable()) {
+        raft::log_eviction_stm::snapshot_data_fn snapshot_data;
+        if (_producer_stm) {
+            snapshot_data = [this](model::offset last_evicted) {
+                return _producer_stm->snapshot_data(last_evicted);
+            };
+        }
         _nop_stm = std::make_unique<raft::log_eviction_stm>(
-          _raft.get(), clusterlog, _as);
+          _raft.get(), clusterlog, _as, std::move(snapshot_data));
     }
 }
 
@@ -28,6 +40,10 @@ ss::future<> partition::start() {
 
     auto f = _raft->start();
 
+    if (_producer_stm != nullptr) {
+        f = f.then([this] { return _producer_stm->start(); });
+    }
+
     if (_nop_stm != nullptr) {
         return f.then([this] { return _nop_stm->start(); });
     }
@@ -37,12 +53,17 @@ ss::future<> partition::start() {
 
 ss::future<> partition::stop() {
     _as.request_abort();
-    // no state machine
-    if (_nop_stm == nullptr) {
-        return ss::now();
+
+    auto f = ss::now();
+    if (_nop_stm != nullptr) {
+        f = _nop_stm->stop();
+    }
+
+    if (_producer_stm != nullptr) {
+        return f.then([this] { return _producer_stm->stop(); });
     }
 
-    return _nop_stm->stop();
+    return f;
 }
 
 ss::future<std::optional<storage::timequery_result>>
@@ -11,7 +11,9 @@
 
 #pragma once
 
+#include "cluster/errc.h"
 #include "cluster/partition_probe.h"
+#include "cluster/producer_state.h"
 #include "cluster/types.h"
 #include "model/record_batch_reader.h"
 #include "raft/configuration.h"
@@ -20,9 +22,26 @@
 #include "raft/types.h"
 #include "storage/types.h"
 
+#include <seastar/core/shared_ptr.hh>
+
+#include <optional>
+
 namespace cluster {
 class partition_manager;
 
+/// Reads the data of a partition that was moved from its local log to
+/// object storage, see archival::service
+class archive_reader {
+public:
+    virtual ~archive_reader() = default;
+
+    /// first offset of the archived data, if any
+    virtual std::optional<model::offset> start_offset() const = 0;
+
+    virtual ss::future<model::record_batch_reader>
+      make_reader(storage::log_reader_config) = 0;
+};
+
 /// holds cluster logic that is not raft related
 /// all raft logic is proxied transparently
 class partition {
@@ -38,18 +57,51 @@ public:
         return _raft->replicate(std::move(r), std::move(opts));
     }
 
+    /**
+     * Replicates a batch of a kafka producer. The batches of idempotent
+     * producers are checked against the last batches of the producer, see
+     * producer_state_table.
+     */
+    ss::future<result<raft::replicate_result>> replicate(
+      batch_identity bid,
+      model::record_batch_reader&& r,
+      raft::replicate_options opts) {
+        if (!bid.is_idempotent() || !_producer_stm) {
+            return replicate(std::move(r), std::move(opts));
+        }
+        return _producer_stm->replicate(bid, std::move(r), std::move(opts));
+    }
+
     /**
      * The reader is modified such that the max offset is configured to be
      * the minimum of the max offset requested and the committed index of the
      * underlying raft group.
+     *
+     * Reads below the local start offset are served by the archive reader.
      */
     ss::future<model::record_batch_reader> make_reader(
       storage::log_reader_config config,
       std::optional<model::timeout_clock::time_point> deadline = std::nullopt) {
+        if (_archive && config.start_offset < _raft->start_offset()) {
+            return _archive->make_reader(std::move(config));
+        }
         return _raft->make_reader(std::move(config), deadline);
     }
 
-    model::offset start_offset() const { return _raft->start_offset(); }
+    /// start of the partition, including its archived data
+    model::offset start_offset() const {
+        auto start = _raft->start_offset();
+        if (auto archived = _archive ? _archive->start_offset() : std::nullopt;
+            archived && *archived < start) {
+            return *archived;
+        }
+        return start;
+    }
+
+    /// installed while the data of the partition is archived
+    void set_archive_reader(ss::shared_ptr<archive_reader> r) {
+        _archive = std::move(r);
+    }
 
     /**
      * The returned value of last committed offset should not be used to
@@ -69,9 +121,9 @@ public:
      *
      * There are two important pieces in this comment:
      *
-     *   1) "non-transaction message are considered decided immediately". Since
-     *   redpanda doesn't have transactional messages, that's what we're
-     *   interested in.
+     *   1) "non-transaction message are considered decided immediately". The
+     *   ongoing transactions are tracked by the producer_state_stm, which
+     *   bounds the offset by the first one of the oldest transaction.
      *
      *   2) "first offset such that all lower offsets have been decided". this
      *   is describing a strictly greater than relationship.
@@ -80,9 +132,32 @@ public:
      * kafka clients, simply report the next offset.
      */
     model::offset last_stable_offset() const {
+        if (_producer_stm) {
+            return _producer_stm->last_stable_offset(
+              _raft->last_stable_offset());
+        }
         return _raft->last_stable_offset() + model::offset(1);
     }
 
+    /// the aborted transactions with batches in the range, inclusive
+    std::vector<aborted_transaction>
+    aborted_transactions(model::offset from, model::offset to) const {
+        if (!_producer_stm) {
+            return {};
+        }
+        return _producer_stm->aborted_transactions(from, to);
+    }
+
+    /// writes the commit or abort marker of the transaction of a producer
+    ss::future<result<raft::replicate_result>> end_transaction(
+      int64_t producer_id, int16_t epoch, control_record_type type) {
+        if (!_producer_stm) {
+            return ss::make_ready_future<result<raft::replicate_result>>(
+              errc::transactions_unsupported);
+        }
+        return _producer_stm->end_transaction(producer_id, epoch, type);
+    }
+
     /**
      * Greatest offset visible to consumers. Named high_watermark to be
      * consistent with Kafka nomenclature.
@@ -91,8 +166,23 @@ public:
         return _raft->last_visible_index();
     }
 
+    /**
+     * Wait until the high watermark reaches the given offset, the timeout
+     * expires, or an abort is requested.
+     */
+    ss::future<> wait_for_high_watermark(
+      model::offset offset,
+      model::timeout_clock::time_point timeout,
+      ss::abort_source& as) {
+        return _raft->wait_for_visible_offset(offset, timeout, as);
+    }
+
     const model::ntp& ntp() const { return _raft->ntp(); }
 
+    const storage::ntp_config& log_config() const {
+        return _raft->log_config();
+    }
+
     ss::future<std::optional<storage::timequery_result>>
       timequery(model::timestamp, ss::io_priority_class);
 
@@ -112,18 +202,32 @@ public:
         return _raft->config();
     }
 
+    /// the followers of this leader that are catching up
+    std::vector<raft::follower_recovery_state> recovering_followers() const {
+        return _raft->recovering_followers();
+    }
+
+    std::vector<raft::follower_recovery_state> follower_states() const {
+        return _raft->follower_states();
+    }
+
+    storage::log_stats log_stats() const { return _raft->log_stats(); }
+
     partition_probe& probe() { return _probe; }
 
 private:
     friend partition_manager;
+    friend partition_probe;
 
     consensus_ptr raft() { return _raft; }
 
 private:
     consensus_ptr _raft;
     std::unique_ptr<raft::log_eviction_stm> _nop_stm;
+    std::unique_ptr<producer_state_stm> _producer_stm;
     ss::abort_source _as;
     partition_probe _probe;
+    ss::shared_ptr<archive_reader> _archive;
 
     friend std::ostream& operator<<(std::ostream& o, const partition& x);
 };
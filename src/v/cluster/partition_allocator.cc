@@ -16,8 +16,10 @@
 #include <roaring/roaring.hh>
 
 #include <algorithm>
+#include <limits>
 #include <numeric>
 #include <random>
+#include <tuple>
 
 namespace cluster {
 
@@ -35,78 +37,93 @@ void partition_allocator::rollback(const std::vector<model::broker_shard>& v) {
     }
 }
 
-static inline bool valid_machine_fault_domain_diversity(
-  const std::vector<model::broker_shard>& replicas) {
-    model::node_id sentinel = replicas.begin()->node_id;
-    const uint32_t unique = std::accumulate(
-      replicas.begin(),
-      replicas.end(),
-      uint32_t(1),
-      [&sentinel](uint32_t acc, const model::broker_shard& bs) {
-          if (sentinel != bs.node_id) {
-              acc += 1;
-          }
-          return acc;
-      });
-    return unique == replicas.size();
-}
-
-static bool is_machine_in_replicas(
-  const allocation_node& machine,
-  const std::vector<model::broker_shard>& replicas) {
-    return std::any_of(
-      replicas.begin(),
-      replicas.end(),
-      [&machine](const model::broker_shard& bs) {
-          return machine.id() == bs.node_id;
-      });
+/// the replicas of a partition already placed on the rack of the candidate
+static uint32_t rack_replicas(
+  const allocation_node& candidate,
+  const std::vector<const allocation_node*>& chosen) {
+    if (!candidate.rack()) {
+        return 0;
+    }
+    return static_cast<uint32_t>(std::count_if(
+      chosen.begin(), chosen.end(), [&candidate](const allocation_node* n) {
+          return n->rack() == candidate.rack();
+      }));
 }
 
 std::optional<std::vector<model::broker_shard>>
-partition_allocator::allocate_replicas(int16_t replication_factor) {
+partition_allocator::allocate_replicas(
+  std::vector<candidate>& candidates,
+  int16_t replication_factor,
+  size_t rotation) {
     std::vector<model::broker_shard> replicas;
     replicas.reserve(replication_factor);
+    std::vector<const allocation_node*> chosen;
+    chosen.reserve(replication_factor);
 
     while (replicas.size() < (size_t)replication_factor) {
-        const uint16_t replicas_left = replication_factor - replicas.size();
-        if (_available_machines.size() < replicas_left) {
+        const bool leader = replicas.empty();
+        // prefer, in order: a rack without replicas of the partition, the
+        // node with the fewest leaders (for the first replica) and replicas
+        // of the topic, and the node with the most capacity left. The
+        // rotation spreads the ties across nodes.
+        auto key = [&chosen, leader](const candidate& c) {
+            return std::make_tuple(
+              rack_replicas(*c.node, chosen),
+              leader ? c.leaders : 0,
+              c.replicas,
+              std::numeric_limits<uint32_t>::max()
+                - c.node->partition_capacity());
+        };
+        candidate* best = nullptr;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            auto& c = candidates[(i + rotation) % candidates.size()];
+            if (
+              c.full
+              || std::find(chosen.begin(), chosen.end(), c.node)
+                   != chosen.end()) {
+                continue;
+            }
+            if (best == nullptr || key(c) < key(*best)) {
+                best = &c;
+            }
+        }
+        if (best == nullptr) {
+            // fewer nodes with capacity left than replicas
             rollback(replicas);
             return std::nullopt;
         }
-        auto& rr = round_robin_ptr();
-        auto& machine = *rr;
-        rr++;
-        if (is_machine_in_replicas(machine, replicas)) {
-            continue;
-        }
+        auto& machine = *best->node;
         const uint32_t cpu = machine.allocate();
-        model::broker_shard bs{.node_id = machine.id(), .shard = cpu};
-        replicas.push_back(bs);
+        replicas.push_back(
+          model::broker_shard{.node_id = machine.id(), .shard = cpu});
+        chosen.push_back(&machine);
+        best->replicas++;
+        if (leader) {
+            best->leaders++;
+        }
         if (machine.is_full()) {
+            best->full = true;
             _available_machines.erase(_available_machines.iterator_to(machine));
         }
     }
-    if (!valid_machine_fault_domain_diversity(replicas)) {
-        rollback(replicas);
-        return std::nullopt;
-    }
     return replicas;
 }
 
-// FIXME: take into account broker.rack diversity & other constraints
 std::optional<partition_allocator::allocation_units>
 partition_allocator::allocate(const topic_configuration& cfg) {
-    if (_available_machines.empty()) {
+    if (
+      cfg.replication_factor <= 0
+      || _available_machines.size() < (size_t)cfg.replication_factor) {
         return std::nullopt;
     }
-    const int32_t cap = std::accumulate(
+    const int64_t cap = std::accumulate(
       _available_machines.begin(),
       _available_machines.end(),
-      int32_t(0),
-      [](int32_t acc, const allocation_node& n) {
+      int64_t(0),
+      [](int64_t acc, const allocation_node& n) {
           return acc + n.partition_capacity();
       });
-    if (cap < cfg.partition_count) {
+    if (cap < int64_t(cfg.partition_count) * cfg.replication_factor) {
         vlog(
           clusterlog.info,
           "Cannot allocate request: {}. Exceeds maximum capacity left:{}",
@@ -114,12 +131,19 @@ partition_allocator::allocate(const topic_configuration& cfg) {
           cap);
         return std::nullopt;
     }
+    // the nodes are snapshotted, as full ones leave _available_machines
+    std::vector<candidate> candidates;
+    candidates.reserve(_available_machines.size());
+    for (auto& n : _available_machines) {
+        candidates.push_back(candidate{.node = &n, .full = n.is_full()});
+    }
     std::vector<partition_assignment> ret;
     ret.reserve(cfg.partition_count);
     for (int32_t i = 0; i < cfg.partition_count; ++i) {
         // all replicas must belong to the same raft group
         raft::group_id partition_group = raft::group_id(_highest_group() + 1);
-        auto replicas_assignment = allocate_replicas(cfg.replication_factor);
+        auto replicas_assignment = allocate_replicas(
+          candidates, cfg.replication_factor, _highest_group());
         if (replicas_assignment == std::nullopt) {
             rollback(ret);
             return std::nullopt;
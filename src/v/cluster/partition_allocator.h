@@ -33,10 +33,12 @@ public:
     allocation_node(
       model::node_id id,
       uint32_t cpus,
-      std::unordered_map<ss::sstring, ss::sstring> labels)
+      std::unordered_map<ss::sstring, ss::sstring> labels,
+      std::optional<ss::sstring> rack = std::nullopt)
       : _id(id)
       , _weights(cpus)
-      , _machine_labels(std::move(labels)) {
+      , _machine_labels(std::move(labels))
+      , _rack(std::move(rack)) {
         // add extra weights to core 0
         _weights[0] = core0_extra_weight;
         _partition_capacity = (cpus * max_allocations_per_core)
@@ -47,7 +49,8 @@ public:
       : _id(o._id)
       , _weights(std::move(o._weights))
       , _partition_capacity(o._partition_capacity)
-      , _machine_labels(std::move(o._machine_labels)) {
+      , _machine_labels(std::move(o._machine_labels))
+      , _rack(std::move(o._rack)) {
         _hook.swap_nodes(o._hook);
     }
 
@@ -58,6 +61,7 @@ public:
     uint32_t cpus() const { return _weights.size(); }
     model::node_id id() const { return _id; }
     uint32_t partition_capacity() const { return _partition_capacity; }
+    const std::optional<ss::sstring>& rack() const { return _rack; }
 
 private:
     friend partition_allocator;
@@ -104,6 +108,9 @@ private:
     uint32_t _partition_capacity{0};
     /// generated by `rpk` usually in /etc/redpanda/machine_labels.json
     std::unordered_map<ss::sstring, ss::sstring> _machine_labels;
+    /// the failure domain of the node, replicas of a partition are spread
+    /// across racks first
+    std::optional<ss::sstring> _rack;
 
     // for partition_allocator
     safe_intrusive_list_hook _hook;
@@ -155,9 +162,7 @@ public:
     /// are up to date, and have the highest known group_id ever assigned
     /// reset to nullptr when no longer leader
     explicit partition_allocator(raft::group_id highest_known_group)
-      : _highest_group(highest_known_group) {
-        _rr = _available_machines.end();
-    }
+      : _highest_group(highest_known_group) {}
     void register_node(ptr n) {
         _available_machines.push_back(*n);
         _machines.emplace(n->id(), std::move(n));
@@ -165,7 +170,10 @@ public:
 
     bool contains_node(model::node_id n) { return _machines.contains(n); }
 
-    /// best effort placement.
+    /// best effort placement of all the partitions of a topic at once,
+    /// balancing the replicas and the leaders of the topic across nodes,
+    /// spreading the replicas of each partition across racks, and the load of
+    /// each node across its cores.
     /// kafka/common/protocol/Errors.java does not have a way to
     /// represent failed allocation yet. Up to caller to interpret
     /// how to use a nullopt value
@@ -183,10 +191,7 @@ public:
 
     const underlying_t& allocation_nodes() { return _machines; }
 
-    ~partition_allocator() {
-        _available_machines.clear();
-        _rr = _available_machines.end();
-    }
+    ~partition_allocator() { _available_machines.clear(); }
 
 private:
     friend partition_allocator_tester;
@@ -196,19 +201,21 @@ private:
     void rollback(const std::vector<partition_assignment>& pa);
     void rollback(const std::vector<model::broker_shard>& v);
 
-    std::optional<std::vector<model::broker_shard>>
-    allocate_replicas(int16_t replication_factor);
+    /// a node the topic being allocated may be placed on, with the replicas
+    /// of the topic placed on it so far
+    struct candidate {
+        allocation_node* node;
+        uint32_t leaders{0};
+        uint32_t replicas{0};
+        bool full{false};
+    };
+
+    std::optional<std::vector<model::broker_shard>> allocate_replicas(
+      std::vector<candidate>&, int16_t replication_factor, size_t rotation);
     iterator find_node(model::node_id id);
 
-    [[gnu::always_inline]] inline cil_t::iterator& round_robin_ptr() {
-        if (_rr == _available_machines.end()) {
-            _rr = _available_machines.begin();
-        }
-        return _rr;
-    }
     raft::group_id _highest_group;
 
-    cil_t::iterator _rr; // round robin
     cil_t _available_machines;
     underlying_t _machines;
 
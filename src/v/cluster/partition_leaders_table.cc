@@ -11,6 +11,7 @@
 
 #include "model/fundamental.h"
 #include "model/metadata.h"
+#include "random/generators.h"
 
 #include <seastar/core/future-util.hh>
 
@@ -18,6 +19,9 @@
 
 namespace cluster {
 
+partition_leaders_table::partition_leaders_table()
+  : _instance(random_generators::get_int<uint64_t>()) {}
+
 ss::future<> partition_leaders_table::stop() {
     while (!_leader_promises.empty()) {
         auto it = _leader_promises.begin();
@@ -51,7 +55,8 @@ void partition_leaders_table::update_partition_leader(
     auto key = leader_key_view{
       model::topic_namespace_view(ntp), ntp.tp.partition};
     auto it = _leaders.find(key);
-    if (it == _leaders.end()) {
+    const bool inserted = it == _leaders.end();
+    if (inserted) {
         auto [new_it, _] = _leaders.emplace(
           leader_key{
             model::topic_namespace(ntp.ns, ntp.tp.topic), ntp.tp.partition},
@@ -64,6 +69,12 @@ void partition_leaders_table::update_partition_leader(
         return;
     }
     // existing partition
+    if (inserted || it->second.id != leader_id) {
+        bump_revision(model::topic_namespace_view(ntp));
+        it->second.revision = _revision;
+    } else if (it->second.update_term != term) {
+        it->second.revision = ++_revision;
+    }
     it->second.id = leader_id;
     it->second.update_term = term;
 
@@ -79,6 +90,23 @@ void partition_leaders_table::update_partition_leader(
     }
 }
 
+void partition_leaders_table::bump_revision(
+  model::topic_namespace_view tp_ns) {
+    if (auto it = _revisions.find(tp_ns); it != _revisions.end()) {
+        it->second = ++_revision;
+        return;
+    }
+    _revisions.emplace(model::topic_namespace(tp_ns), ++_revision);
+}
+
+uint64_t partition_leaders_table::topic_revision(
+  model::topic_namespace_view tp_ns) const {
+    if (auto it = _revisions.find(tp_ns); it != _revisions.end()) {
+        return it->second;
+    }
+    return 0;
+}
+
 ss::future<model::node_id> partition_leaders_table::wait_for_leader(
   const model::ntp& ntp,
   ss::lowres_clock::time_point timeout,
@@ -27,7 +27,7 @@ namespace cluster {
 /// received by cluster::metadata_dissemination_service.
 class partition_leaders_table {
 public:
-    partition_leaders_table() = default;
+    partition_leaders_table();
 
     ss::future<> stop();
 
@@ -53,20 +53,42 @@ public:
     })
     // clang-format on
     void for_each_leader(Func&& f) const {
+        for_each_leader_since(0, std::forward<Func>(f));
+    }
+
+    /// \brief visits the leaders updated after the given revision
+    template<typename Func>
+    void for_each_leader_since(uint64_t revision, Func&& f) const {
         for (auto& [k, v] : _leaders) {
-            f(k.tp_ns, k.pid, v.id, v.update_term);
+            if (v.revision > revision) {
+                f(k.tp_ns, k.pid, v.id, v.update_term);
+            }
         }
     }
 
     void remove_leader(const model::ntp& ntp) {
-        _leaders.erase(
-          leader_key_view{model::topic_namespace_view(ntp), ntp.tp.partition});
+        if (_leaders.erase(leader_key_view{
+              model::topic_namespace_view(ntp), ntp.tp.partition})) {
+            bump_revision(model::topic_namespace_view(ntp));
+        }
     }
 
     void update_partition_leader(
       const model::ntp&, model::term_id, std::optional<model::node_id>);
 
+    /// \brief a value that changes whenever the leader of a partition of the
+    /// topic does
+    uint64_t topic_revision(model::topic_namespace_view) const;
+
+    /// \brief the revision of the latest update to the table
+    uint64_t revision() const { return _revision; }
+
+    /// \brief identifies this table, as revisions restart with the process
+    uint64_t instance() const { return _instance; }
+
 private:
+    void bump_revision(model::topic_namespace_view);
+
     // optimized to reduce number of ntp copies
     struct leader_key {
         model::topic_namespace tp_ns;
@@ -126,11 +148,22 @@ private:
     struct leader_meta {
         std::optional<model::node_id> id;
         model::term_id update_term;
+        // revision of the table when the entry was last updated
+        uint64_t revision{0};
     };
 
     absl::flat_hash_map<leader_key, leader_meta, leader_key_hash, leader_key_eq>
       _leaders;
 
+    absl::flat_hash_map<
+      model::topic_namespace,
+      uint64_t,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>
+      _revisions;
+    uint64_t _revision{0};
+    uint64_t _instance;
+
     // per-ntp notifications for leadership election. note that the
     // namespace is currently ignored pending an update to the metadata
     // cache that attaches a namespace to all topics partition references.
@@ -13,22 +13,28 @@
 #include "config/configuration.h"
 #include "model/metadata.h"
 #include "raft/consensus.h"
+#include "raft/consensus_utils.h"
 #include "raft/log_eviction_stm.h"
 #include "raft/rpc_client_protocol.h"
 #include "raft/types.h"
 #include "resource_mgmt/io_priority.h"
+#include "ssx/future-util.h"
 #include "vlog.h"
 
+#include <seastar/core/future-util.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/smp.hh>
 
+#include <boost/range/irange.hpp>
+
 namespace cluster {
 
 partition_manager::partition_manager(
   ss::sharded<storage::api>& storage, ss::sharded<raft::group_manager>& raft)
   : _storage(storage.local())
-  , _raft_manager(raft) {}
+  , _raft_manager(raft)
+  , _producer_ids(_storage) {}
 
 ss::future<consensus_ptr> partition_manager::manage(
   storage::ntp_config ntp_cfg,
@@ -50,9 +56,88 @@ ss::future<consensus_ptr> partition_manager::manage(
       });
 }
 
+ss::future<> partition_manager::manage_all(std::vector<manage_params> params) {
+    using group_params = raft::group_manager::group_params;
+    return ssx::parallel_transform(
+             std::move(params),
+             [this](manage_params p) {
+                 return _storage.log_mgr()
+                   .manage(std::move(p.ntp_cfg))
+                   .then([group = p.group, nodes = std::move(p.nodes)](
+                           storage::log log) mutable {
+                       return group_params{
+                         .id = group, .nodes = std::move(nodes), .log = log};
+                   });
+             })
+      .then([this](std::vector<group_params> groups) {
+          return _raft_manager.local().create_groups(std::move(groups));
+      })
+      .then([this](std::vector<consensus_ptr> groups) {
+          return ss::parallel_for_each(groups, [this](consensus_ptr c) {
+              auto p = ss::make_lw_shared<partition>(c);
+              _ntp_table.emplace(c->ntp(), p);
+              _raft_table.emplace(c->group(), p);
+              _manage_watchers.notify(p->ntp(), p);
+              return p->start();
+          });
+      });
+}
+
+ss::future<> partition_manager::start() {
+    const auto interval
+      = config::shard_local_cfg().partition_offsets_publish_interval_ms();
+    if (interval.count() > 0) {
+        _publish_timer.set_callback([this] { publish_offsets(); });
+        _publish_timer.arm_periodic(interval);
+    }
+    return ss::now();
+}
+
 ss::future<> partition_manager::stop() {
-    return ss::parallel_for_each(
-      _ntp_table, [](auto& p) { return p.second->stop(); });
+    _publish_timer.cancel();
+    return _gate.close().then([this] {
+        return ss::parallel_for_each(
+          _ntp_table, [](auto& p) { return p.second->stop(); });
+    });
+}
+
+void partition_manager::publish_offsets() {
+    // a round waiting for a busy shard is not piled up on
+    if (_gate.is_closed() || _publishing) {
+        return;
+    }
+    partition_offsets_table::snapshot offsets;
+    offsets.reserve(_ntp_table.size());
+    for (const auto& [ntp, p] : _ntp_table) {
+        offsets.emplace(
+          ntp,
+          partition_offsets_table::offsets{
+            .start_offset = p->start_offset(),
+            .high_watermark = p->high_watermark(),
+            .last_stable_offset = p->last_stable_offset(),
+            .leader = p->is_leader(),
+          });
+    }
+    const auto taken = ss::lowres_clock::now();
+    auto shared = ss::make_lw_shared<const partition_offsets_table::snapshot>(
+      std::move(offsets));
+    _publishing = true;
+    // background
+    (void)ss::with_gate(_gate, [this, shared = std::move(shared), taken] {
+        return ss::parallel_for_each(
+                 boost::irange(0u, ss::smp::count),
+                 [this, shared, taken](ss::shard_id shard) {
+                     return container().invoke_on(
+                       shard,
+                       [source = ss::this_shard_id(),
+                        offsets = ss::make_foreign(shared),
+                        taken](partition_manager& pm) mutable {
+                           pm._offsets.publish(
+                             source, std::move(offsets), taken);
+                       });
+                 })
+          .finally([this] { _publishing = false; });
+    });
 }
 
 ss::future<> partition_manager::remove(const model::ntp& ntp) {
@@ -77,6 +162,106 @@ ss::future<> partition_manager::remove(const model::ntp& ntp) {
       .finally([partition] {}); // in the end remove partition
 }
 
+ss::future<> partition_manager::remove_all(std::vector<model::ntp> ntps) {
+    std::vector<ss::lw_shared_ptr<partition>> partitions;
+    partitions.reserve(ntps.size());
+    for (const auto& ntp : ntps) {
+        auto partition = get(ntp);
+        if (!partition) {
+            return ss::make_exception_future<>(
+              std::invalid_argument(fmt::format(
+                "Can not remove partition. NTP {} is not present in "
+                "partition manager",
+                ntp)));
+        }
+        partitions.push_back(std::move(partition));
+    }
+
+    std::vector<consensus_ptr> groups;
+    groups.reserve(partitions.size());
+    for (auto& p : partitions) {
+        _ntp_table.erase(p->ntp());
+        _raft_table.erase(p->group());
+        groups.push_back(p->raft());
+    }
+
+    return _raft_manager.local()
+      .remove_groups(std::move(groups))
+      .then([this, partitions = std::move(partitions)]() mutable {
+          return ss::do_with(
+            std::move(partitions),
+            [this](std::vector<ss::lw_shared_ptr<partition>>& partitions) {
+                return ss::parallel_for_each(
+                  partitions, [this](ss::lw_shared_ptr<partition> p) {
+                      return p->stop().then([this, p] {
+                          return _storage.log_mgr().remove(p->ntp());
+                      });
+                  });
+            });
+      });
+}
+
+ss::future<partition_manager::kvstore_state>
+partition_manager::shutdown(const model::ntp& ntp) {
+    auto partition = get(ntp);
+    if (!partition) {
+        return ss::make_exception_future<kvstore_state>(
+          std::invalid_argument(fmt::format(
+            "Can not shutdown partition. NTP {} is not present in partition "
+            "manager",
+            ntp)));
+    }
+    auto group_id = partition->group();
+
+    _ntp_table.erase(ntp);
+    _raft_table.erase(group_id);
+
+    return _raft_manager.local()
+      .shutdown(partition->raft())
+      .then([partition] { return partition->stop(); })
+      .then([this, ntp] { return _storage.log_mgr().shutdown(ntp); })
+      .then([this, ntp, group_id] {
+          // read after the group and the log stopped writing their state
+          kvstore_state state;
+          auto collect = [this, &state](
+                           storage::kvstore::key_space ks,
+                           std::vector<bytes> keys) {
+              for (auto& key : keys) {
+                  if (auto value = _storage.kvs().get(ks, key); value) {
+                      state.push_back(kvstore_entry{
+                        .ks = ks,
+                        .key = std::move(key),
+                        .value = iobuf_to_bytes(*value)});
+                  }
+              }
+          };
+          collect(
+            storage::kvstore::key_space::consensus,
+            raft::details::persistent_state_keys(group_id));
+          collect(
+            storage::kvstore::key_space::storage,
+            storage::log_manager::kvstore_keys(ntp));
+          return state;
+      })
+      .finally([partition] {});
+}
+
+ss::future<> partition_manager::restore(kvstore_state state) {
+    return ss::do_with(std::move(state), [this](kvstore_state& state) {
+        return ss::parallel_for_each(state, [this](kvstore_entry& e) {
+            return _storage.kvs().put(
+              e.ks, std::move(e.key), bytes_to_iobuf(e.value));
+        });
+    });
+}
+
+ss::future<>
+partition_manager::remove_persistent_state(const kvstore_state& state) {
+    return ss::parallel_for_each(state, [this](const kvstore_entry& e) {
+        return _storage.kvs().remove(e.ks, e.key);
+    });
+}
+
 std::ostream& operator<<(std::ostream& o, const partition_manager& pm) {
     return o << "{shard:" << ss::this_shard_id() << ", mngr:{}"
              << pm._storage.log_mgr()
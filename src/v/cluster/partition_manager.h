@@ -13,6 +13,8 @@
 
 #include "cluster/ntp_callbacks.h"
 #include "cluster/partition.h"
+#include "cluster/partition_offsets_table.h"
+#include "cluster/producer_id_allocator.h"
 #include "cluster/shard_table.h"
 #include "model/metadata.h"
 #include "raft/consensus_client_protocol.h"
@@ -21,10 +23,15 @@
 #include "storage/api.h"
 #include "utils/named_type.h"
 
+#include <seastar/core/gate.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
+
 #include <absl/container/flat_hash_map.h>
 
 namespace cluster {
-class partition_manager {
+class partition_manager
+  : public ss::peering_sharded_service<partition_manager> {
 public:
     partition_manager(
       ss::sharded<storage::api>&, ss::sharded<raft::group_manager>&);
@@ -55,13 +62,54 @@ public:
         return nullptr;
     }
 
-    ss::future<> start() { return ss::now(); }
+    ss::future<> start();
     ss::future<> stop();
     ss::future<consensus_ptr>
       manage(storage::ntp_config, raft::group_id, std::vector<model::broker>);
 
+    /// A partition to manage, see manage_all
+    struct manage_params {
+        storage::ntp_config ntp_cfg;
+        raft::group_id group;
+        std::vector<model::broker> nodes;
+    };
+
+    /// Manages many partitions at once: their logs are opened concurrently
+    /// and their raft groups created together
+    ss::future<> manage_all(std::vector<manage_params>);
+
     ss::future<> remove(const model::ntp& ntp);
 
+    /// Removes many partitions at once: their raft groups are removed
+    /// together, and the files of their logs in the background, see
+    /// storage::directory_deleter
+    ss::future<> remove_all(std::vector<model::ntp>);
+
+    /// An entry of the state of a partition in the kvstore, which moves
+    /// along with the partition to another core of the node
+    struct kvstore_entry {
+        storage::kvstore::key_space ks;
+        bytes key;
+        bytes value;
+    };
+    using kvstore_state = std::vector<kvstore_entry>;
+
+    /// Stops managing a partition, keeping its log, and returns its state in
+    /// the kvstore so that another core can manage it
+    ss::future<kvstore_state> shutdown(const model::ntp& ntp);
+
+    /// Writes the state of a partition moved from another core, before the
+    /// partition is managed by this one
+    ss::future<> restore(kvstore_state);
+
+    /// Removes the state of a partition moved to another core
+    ss::future<> remove_persistent_state(const kvstore_state&);
+
+    const absl::flat_hash_map<model::ntp, ss::lw_shared_ptr<partition>>&
+    partitions() const {
+        return _ntp_table;
+    }
+
     std::optional<storage::log> log(const model::ntp& ntp) {
         return _storage.log_mgr().get(ntp);
     }
@@ -98,17 +146,35 @@ public:
         _manage_watchers.unregister_notify(id);
     }
 
+    /// ids of the idempotent producers initialized on this shard
+    producer_id_allocator& producer_ids() { return _producer_ids; }
+
+    /// offsets of the partitions of every shard, as published by the shards
+    /// every partition_offsets_publish_interval_ms
+    const partition_offsets_table& offsets_table() const { return _offsets; }
+
 private:
+    /// publishes a snapshot of the offsets of the partitions of the shard to
+    /// the offsets tables of all the shards
+    void publish_offsets();
+
     storage::api& _storage;
     /// used to wait for concurrent recoveries
     ss::sharded<raft::group_manager>& _raft_manager;
 
+    producer_id_allocator _producer_ids;
+
     ntp_callbacks<manage_cb_t> _manage_watchers;
     // XXX use intrusive containers here
     absl::flat_hash_map<model::ntp, ss::lw_shared_ptr<partition>> _ntp_table;
     absl::flat_hash_map<raft::group_id, ss::lw_shared_ptr<partition>>
       _raft_table;
 
+    partition_offsets_table _offsets;
+    ss::timer<ss::lowres_clock> _publish_timer;
+    bool _publishing{false};
+    ss::gate _gate;
+
     friend std::ostream& operator<<(std::ostream&, const partition_manager&);
 };
 } // namespace cluster
@@ -0,0 +1,60 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/partition_offsets_table.h"
+
+#include <seastar/core/smp.hh>
+
+namespace cluster {
+
+partition_offsets_table::partition_offsets_table()
+  : _shards(ss::smp::count) {}
+
+void partition_offsets_table::publish(
+  ss::shard_id shard, snapshot_ptr offsets, clock_type::time_point taken) {
+    auto& p = _shards[shard];
+    // a late snapshot of a previous round does not replace a newer one
+    if (p.offsets && taken < p.taken) {
+        return;
+    }
+    p.offsets = std::move(offsets);
+    p.taken = taken;
+}
+
+std::optional<partition_offsets_table::offsets> partition_offsets_table::get(
+  ss::shard_id owner,
+  const model::ntp& ntp,
+  clock_type::duration max_age) const {
+    const auto& p = _shards[owner];
+    if (!p.offsets || clock_type::now() - p.taken > max_age) {
+        return std::nullopt;
+    }
+    if (auto it = p.offsets->find(ntp); it != p.offsets->end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<partition_offsets_table::offsets> partition_offsets_table::get(
+  const model::ntp& ntp, clock_type::duration max_age) const {
+    // a partition moving to another shard is in the snapshots of both for a
+    // while, the latest snapshot wins
+    std::optional<offsets> ret;
+    std::optional<clock_type::time_point> taken;
+    for (ss::shard_id s = 0; s < _shards.size(); ++s) {
+        auto o = get(s, ntp, max_age);
+        if (o && (!taken || _shards[s].taken > *taken)) {
+            ret = o;
+            taken = _shards[s].taken;
+        }
+    }
+    return ret;
+}
+
+} // namespace cluster
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "model/fundamental.h"
+#include "seastarx.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/shared_ptr.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <optional>
+#include <vector>
+
+namespace cluster {
+
+/**
+ * Offsets of the partitions of every shard of the node, readable from any
+ * shard without a cross-core hop.
+ *
+ * Every publish interval, each shard takes a snapshot of the offsets of its
+ * partitions and publishes it to the table of every shard. A snapshot is
+ * immutable and shared by the tables of all the shards, which read it through
+ * a foreign pointer, so a round of publishing copies the offsets only once.
+ *
+ * The offsets are as old as the snapshot they come from: the table is meant
+ * for the queries which do not need the latest offsets, e.g. consumer lag,
+ * and the callers pass the age of the snapshots they accept.
+ */
+class partition_offsets_table {
+public:
+    using clock_type = ss::lowres_clock;
+
+    struct offsets {
+        model::offset start_offset;
+        model::offset high_watermark;
+        model::offset last_stable_offset;
+        /// whether the shard led the partition when the snapshot was taken
+        bool leader{false};
+    };
+    using snapshot = absl::flat_hash_map<model::ntp, offsets>;
+    using snapshot_ptr = ss::foreign_ptr<ss::lw_shared_ptr<const snapshot>>;
+
+    partition_offsets_table();
+
+    /// \brief replaces the offsets published by the shard
+    void publish(ss::shard_id, snapshot_ptr, clock_type::time_point taken);
+
+    /// \brief the offsets of the partition, from a snapshot of the shard
+    /// that is at most max_age old
+    std::optional<offsets> get(
+      ss::shard_id owner,
+      const model::ntp&,
+      clock_type::duration max_age) const;
+
+    /// \brief the offsets of the partition, from the snapshot of any shard
+    /// that is at most max_age old
+    std::optional<offsets>
+    get(const model::ntp&, clock_type::duration max_age) const;
+
+private:
+    struct published {
+        snapshot_ptr offsets;
+        clock_type::time_point taken;
+    };
+
+    std::vector<published> _shards;
+};
+
+} // namespace cluster
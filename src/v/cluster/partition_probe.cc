@@ -15,14 +15,217 @@
 
 #include <seastar/core/metrics.hh>
 
+#include <absl/container/node_hash_map.h>
+
+#include <algorithm>
+#include <vector>
+
 namespace cluster {
-void partition_probe::setup_metrics(const model::ntp& ntp) {
+
+namespace {
+/// the partitions of a topic on this shard, exported summed up
+struct topic_rollup {
+    std::vector<const partition_probe*> probes;
+    ss::metrics::metric_groups metrics;
+
+    template<typename T, typename Func>
+    T sum(Func f) const {
+        T acc{0};
+        for (auto* p : probes) {
+            acc += f(*p);
+        }
+        return acc;
+    }
+};
+
+using topic_rollups
+  = absl::node_hash_map<model::topic_namespace, topic_rollup>;
+
+topic_rollups& shard_local_rollups() {
+    static thread_local topic_rollups rollups;
+    return rollups;
+}
+
+void setup_rollup_metrics(
+  const model::topic_namespace& tp_ns, topic_rollup& r) {
     namespace sm = ss::metrics;
 
+    const std::vector<sm::label_instance> labels = {
+      sm::label("namespace")(tp_ns.ns()),
+      sm::label("topic")(tp_ns.tp()),
+    };
+
+    r.metrics.add_group(
+      prometheus_sanitize::metrics_name("cluster:topic"),
+      {
+        sm::make_gauge(
+          "partitions",
+          [&r] { return r.probes.size(); },
+          sm::description("Number of partitions of the topic on the shard"),
+          labels),
+        sm::make_gauge(
+          "leaders",
+          [&r] {
+              return r.sum<uint64_t>(
+                [](const partition_probe& p) { return p.is_leader(); });
+          },
+          sm::description("Number of partitions led by the shard"),
+          labels),
+        sm::make_gauge(
+          "under_replicated",
+          [&r] {
+              return r.sum<uint64_t>(
+                [](const partition_probe& p) { return p.under_replicated(); });
+          },
+          sm::description(
+            "Number of led partitions with a follower catching up"),
+          labels),
+        sm::make_gauge(
+          "follower_lag_offsets",
+          [&r] {
+              return r.sum<int64_t>([](const partition_probe& p) {
+                  return p.follower_lag_offsets();
+              });
+          },
+          sm::description(
+            "Sum of the offsets the furthest behind follower of each led "
+            "partition lags"),
+          labels),
+        sm::make_gauge(
+          "follower_lag_bytes",
+          [&r] {
+              return r.sum<uint64_t>([](const partition_probe& p) {
+                  return p.follower_lag_bytes();
+              });
+          },
+          sm::description(
+            "Sum of the estimated bytes the furthest behind follower of each "
+            "led partition lags"),
+          labels),
+        sm::make_derive(
+          "records_produced",
+          [&r] {
+              return r.sum<uint64_t>(
+                [](const partition_probe& p) { return p.records_produced(); });
+          },
+          sm::description("Total number of records produced"),
+          labels),
+        sm::make_derive(
+          "records_fetched",
+          [&r] {
+              return r.sum<uint64_t>(
+                [](const partition_probe& p) { return p.records_fetched(); });
+          },
+          sm::description("Total number of records fetched"),
+          labels),
+        sm::make_derive(
+          "bytes_produced",
+          [&r] {
+              return r.sum<uint64_t>(
+                [](const partition_probe& p) { return p.bytes_produced(); });
+          },
+          sm::description("Total number of bytes produced"),
+          labels),
+        sm::make_derive(
+          "bytes_fetched",
+          [&r] {
+              return r.sum<uint64_t>(
+                [](const partition_probe& p) { return p.bytes_fetched(); });
+          },
+          sm::description("Total number of bytes fetched"),
+          labels),
+        sm::make_derive(
+          "batch_cache_hits",
+          [&r] {
+              return r.sum<uint64_t>([](const partition_probe& p) {
+                  return p.log_stats().batch_cache_hits;
+              });
+          },
+          sm::description("Reads served by the batch cache"),
+          labels),
+        sm::make_derive(
+          "batch_cache_misses",
+          [&r] {
+              return r.sum<uint64_t>([](const partition_probe& p) {
+                  return p.log_stats().batch_cache_misses;
+              });
+          },
+          sm::description("Reads that missed the batch cache"),
+          labels),
+      });
+}
+} // namespace
+
+partition_probe::~partition_probe() {
+    if (!_rollup) {
+        return;
+    }
+    auto& rollups = shard_local_rollups();
+    auto it = rollups.find(*_rollup);
+    if (it == rollups.end()) {
+        return;
+    }
+    auto& probes = it->second.probes;
+    probes.erase(std::remove(probes.begin(), probes.end(), this), probes.end());
+    if (probes.empty()) {
+        rollups.erase(it);
+    }
+}
+
+bool partition_probe::is_leader() const { return _partition.is_leader(); }
+
+bool partition_probe::under_replicated() const {
+    return !_partition.recovering_followers().empty();
+}
+
+int64_t partition_probe::follower_lag_offsets() const {
+    int64_t lag = 0;
+    for (const auto& f : _partition.follower_states()) {
+        lag = std::max<int64_t>(lag, f.last_offset() - f.match_index());
+    }
+    return lag;
+}
+
+uint64_t partition_probe::follower_lag_bytes() const {
+    auto lag = follower_lag_offsets();
+    if (lag == 0) {
+        return 0;
+    }
+    int64_t offsets = _partition.committed_offset()()
+                      - _partition._raft->start_offset()() + 1;
+    if (offsets <= 0) {
+        return 0;
+    }
+    return log_stats().size_bytes / static_cast<uint64_t>(offsets)
+           * static_cast<uint64_t>(lag);
+}
+
+storage::log_stats partition_probe::log_stats() const {
+    return _partition.log_stats();
+}
+
+void partition_probe::setup_metrics(const model::ntp& ntp) {
     if (config::shard_local_cfg().disable_metrics()) {
         return;
     }
 
+    if (!config::shard_local_cfg().aggregate_partition_metrics()) {
+        setup_partition_metrics(ntp);
+        return;
+    }
+
+    auto tp_ns = model::topic_namespace(ntp.ns, ntp.tp.topic);
+    auto [it, inserted] = shard_local_rollups().try_emplace(tp_ns);
+    if (inserted) {
+        setup_rollup_metrics(it->first, it->second);
+    }
+    it->second.probes.push_back(this);
+    _rollup = std::move(tp_ns);
+}
+
+void partition_probe::setup_partition_metrics(const model::ntp& ntp) {
+    namespace sm = ss::metrics;
+
     auto ns_label = sm::label("namespace");
     auto topic_label = sm::label("topic");
     auto partition_label = sm::label("partition");
@@ -52,6 +255,24 @@ void partition_probe::setup_metrics(const model::ntp& ntp) {
           [this] { return _partition.committed_offset(); },
           sm::description("Committed offset"),
           labels),
+        sm::make_gauge(
+          "under_replicated",
+          [this] { return under_replicated() ? 1 : 0; },
+          sm::description(
+            "Flag indicating if a follower of this leader is catching up"),
+          labels),
+        sm::make_gauge(
+          "follower_lag_offsets",
+          [this] { return follower_lag_offsets(); },
+          sm::description(
+            "Offsets the furthest behind follower of this leader lags"),
+          labels),
+        sm::make_gauge(
+          "follower_lag_bytes",
+          [this] { return follower_lag_bytes(); },
+          sm::description("Estimated bytes the furthest behind follower of "
+                          "this leader lags"),
+          labels),
         sm::make_derive(
           "records_produced",
           [this] { return _records_produced; },
@@ -62,6 +283,26 @@ void partition_probe::setup_metrics(const model::ntp& ntp) {
           [this] { return _records_fetched; },
           sm::description("Total number of records fetched"),
           labels),
+        sm::make_derive(
+          "bytes_produced",
+          [this] { return _bytes_produced; },
+          sm::description("Total number of bytes produced"),
+          labels),
+        sm::make_derive(
+          "bytes_fetched",
+          [this] { return _bytes_fetched; },
+          sm::description("Total number of bytes fetched"),
+          labels),
+        sm::make_derive(
+          "batch_cache_hits",
+          [this] { return log_stats().batch_cache_hits; },
+          sm::description("Reads served by the batch cache"),
+          labels),
+        sm::make_derive(
+          "batch_cache_misses",
+          [this] { return log_stats().batch_cache_misses; },
+          sm::description("Reads that missed the batch cache"),
+          labels),
       });
 }
 } // namespace cluster
@@ -11,19 +11,32 @@
 
 #pragma once
 #include "model/fundamental.h"
+#include "model/metadata.h"
+#include "storage/types.h"
 
 #include <seastar/core/metrics_registration.hh>
 
 #include <cstdint>
+#include <optional>
 
 namespace cluster {
 
 class partition;
 
+/// Per partition throughput, replication and cache metrics.
+///
+/// With aggregate_partition_metrics the partitions of a topic on a shard are
+/// exported summed up, labeled by their topic only, so that the number of
+/// series grows with the topics instead of the partitions.
 class partition_probe {
 public:
     explicit partition_probe(partition& partition)
       : _partition(partition) {}
+    partition_probe(const partition_probe&) = delete;
+    partition_probe& operator=(const partition_probe&) = delete;
+    partition_probe(partition_probe&&) = delete;
+    partition_probe& operator=(partition_probe&&) = delete;
+    ~partition_probe();
 
     void setup_metrics(const model::ntp&);
 
@@ -35,10 +48,36 @@ public:
         _records_fetched += num_records;
     }
 
+    void add_bytes_produced(uint64_t num_bytes) {
+        _bytes_produced += num_bytes;
+    }
+
+    void add_bytes_fetched(uint64_t num_bytes) { _bytes_fetched += num_bytes; }
+
+    uint64_t bytes_produced() const { return _bytes_produced; }
+    uint64_t bytes_fetched() const { return _bytes_fetched; }
+    uint64_t records_produced() const { return _records_produced; }
+    uint64_t records_fetched() const { return _records_fetched; }
+
+    bool is_leader() const;
+    /// whether a follower of this leader is catching up
+    bool under_replicated() const;
+    /// offsets the furthest behind follower of this leader lags
+    int64_t follower_lag_offsets() const;
+    /// the lag in bytes, estimated from the average size of an offset
+    uint64_t follower_lag_bytes() const;
+    storage::log_stats log_stats() const;
+
 private:
+    void setup_partition_metrics(const model::ntp&);
+
     partition& _partition;
     uint64_t _records_produced = 0;
     uint64_t _records_fetched = 0;
+    uint64_t _bytes_produced = 0;
+    uint64_t _bytes_fetched = 0;
+    // the topic this partition is summed into, when aggregated
+    std::optional<model::topic_namespace> _rollup;
     ss::metrics::metric_groups _metrics;
 };
 } // namespace cluster
@@ -0,0 +1,77 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/producer_id_allocator.h"
+
+#include "bytes/bytes.h"
+#include "reflection/adl.h"
+
+#include <seastar/core/smp.hh>
+
+#include <limits>
+#include <stdexcept>
+
+namespace cluster {
+
+namespace {
+// 23 bits of node id, 8 bits of shard and 32 bits of counter
+constexpr int shard_shift = 32;
+constexpr int node_shift = 40;
+constexpr int64_t max_counter = std::numeric_limits<uint32_t>::max();
+
+bytes block_key() {
+    iobuf buf;
+    reflection::serialize(buf, ss::sstring("producer_id_block"));
+    return iobuf_to_bytes(buf);
+}
+} // namespace
+
+producer_id_allocator::producer_id_allocator(storage::api& storage)
+  : _storage(storage) {}
+
+ss::future<int64_t> producer_id_allocator::allocate(model::node_id node) {
+    return _lock.with([this, node] {
+        auto f = ss::now();
+        if (_next == _block_end) {
+            f = reserve_block();
+        }
+        return f.then([this, node] {
+            return (int64_t(node()) << node_shift)
+                   | (int64_t(ss::this_shard_id()) << shard_shift) | _next++;
+        });
+    });
+}
+
+ss::future<> producer_id_allocator::reserve_block() {
+    // the end of the block reserved before a restart starts the next one
+    if (_block_end == 0) {
+        if (auto v = _storage.kvs().get(
+              storage::kvstore::key_space::controller, block_key());
+            v) {
+            _block_end = reflection::from_iobuf<int64_t>(std::move(*v));
+        }
+    }
+    const auto start = _block_end;
+    const auto end = start + block_size;
+    if (end > max_counter) {
+        return ss::make_exception_future<>(
+          std::runtime_error("producer ids of the shard are exhausted"));
+    }
+    return _storage.kvs()
+      .put(
+        storage::kvstore::key_space::controller,
+        block_key(),
+        reflection::to_iobuf(end))
+      .then([this, start, end] {
+          _next = start;
+          _block_end = end;
+      });
+}
+
+} // namespace cluster
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "model/metadata.h"
+#include "seastarx.h"
+#include "storage/api.h"
+#include "utils/mutex.h"
+
+#include <seastar/core/future.hh>
+
+namespace cluster {
+
+/**
+ * Hands out the ids of idempotent producers on a shard.
+ *
+ * An id is made of the node, the shard and a counter of the shard, so that
+ * the ids of the nodes and shards never collide without coordination. The
+ * counter is reserved in blocks persisted in the kvstore, so that ids are not
+ * handed out twice across restarts.
+ */
+class producer_id_allocator {
+public:
+    static constexpr int64_t block_size = 1000;
+
+    explicit producer_id_allocator(storage::api&);
+
+    ss::future<int64_t> allocate(model::node_id);
+
+private:
+    ss::future<> reserve_block();
+
+    storage::api& _storage;
+    mutex _lock;
+    int64_t _next{0};
+    int64_t _block_end{0};
+};
+
+} // namespace cluster
@@ -0,0 +1,581 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/producer_state.h"
+
+#include "bytes/iobuf_parser.h"
+#include "cluster/errc.h"
+#include "likely.h"
+#include "model/record_utils.h"
+#include "raft/consensus.h"
+#include "raft/errc.h"
+#include "reflection/adl.h"
+#include "storage/record_batch_builder.h"
+#include "vassert.h"
+#include "vlog.h"
+
+#include <seastar/core/byteorder.hh>
+
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace cluster {
+
+namespace {
+int32_t next_seq(int32_t seq) {
+    return seq == std::numeric_limits<int32_t>::max() ? 0 : seq + 1;
+}
+
+bool same_batch(
+  const producer_state_table::seq_entry& e, int32_t first, int32_t last) {
+    return e.first_seq == first && e.last_seq == last;
+}
+
+/// serialized form of a producer of the table
+struct producer_snapshot {
+    int64_t id;
+    int16_t epoch;
+    std::vector<producer_state_table::seq_entry> window;
+};
+
+struct ongoing_snapshot {
+    int64_t id;
+    model::offset first_offset;
+};
+
+/// version 0 holds the producers only, version 1 adds the transactions
+struct table_snapshot {
+    static constexpr int8_t current_version = 1;
+
+    int8_t version{current_version};
+    std::vector<producer_snapshot> producers;
+    std::vector<ongoing_snapshot> ongoing;
+    std::vector<aborted_transaction> aborted;
+};
+
+/// the entries of a new term wait for the state of the previous ones
+constexpr auto sync_timeout = std::chrono::seconds(5);
+
+/// the key of a control record is its version and type, in big endian
+constexpr int16_t control_record_version = 0;
+
+template<typename T>
+void append_be(iobuf& out, T v) {
+    v = ss::cpu_to_be(v);
+    // NOLINTNEXTLINE
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+model::record_batch make_control_batch(
+  int64_t producer_id, int16_t epoch, control_record_type type) {
+    iobuf key;
+    append_be(key, control_record_version);
+    append_be(key, static_cast<int16_t>(type));
+    // the value holds the epoch of the coordinator, which is not tracked
+    iobuf value;
+    append_be(value, control_record_version);
+    append_be(value, int32_t(0));
+
+    storage::record_batch_builder builder(
+      raft::data_batch_type, model::offset(0));
+    builder.add_raw_kv(std::move(key), std::move(value));
+    auto batch = std::move(builder).build();
+    auto& h = batch.header();
+    h.attrs = model::record_batch_attributes(
+      model::record_batch_attributes::transactional_mask
+      | model::record_batch_attributes::control_mask);
+    h.producer_id = producer_id;
+    h.producer_epoch = epoch;
+    h.crc = model::crc_record_batch(batch);
+    h.header_crc = model::internal_header_only_crc(h);
+    return batch;
+}
+
+std::optional<control_record_type> parse_control_type(iobuf key) {
+    if (key.size_bytes() < 2 * sizeof(int16_t)) {
+        return std::nullopt;
+    }
+    iobuf_parser parser(std::move(key));
+    auto version = parser.consume_be_type<int16_t>();
+    auto type = parser.consume_be_type<int16_t>();
+    if (version != control_record_version) {
+        return std::nullopt;
+    }
+    switch (static_cast<control_record_type>(type)) {
+    case control_record_type::abort:
+    case control_record_type::commit:
+        return static_cast<control_record_type>(type);
+    }
+    return std::nullopt;
+}
+} // namespace
+
+batch_identity batch_identity::from(const model::record_batch_header& h) {
+    return batch_identity{
+      .producer_id = h.producer_id,
+      .producer_epoch = h.producer_epoch,
+      .first_seq = h.base_sequence,
+      .record_count = h.record_count,
+      .is_transactional = h.attrs.is_transactional(),
+    };
+}
+
+int32_t batch_identity::last_seq() const {
+    constexpr int64_t wrap = int64_t(std::numeric_limits<int32_t>::max()) + 1;
+    int64_t last = int64_t(first_seq) + record_count - 1;
+    return static_cast<int32_t>(last >= wrap ? last - wrap : last);
+}
+
+std::ostream& operator<<(std::ostream& o, const batch_identity& bid) {
+    fmt::print(
+      o,
+      "{{producer_id: {}, epoch: {}, first_seq: {}, records: {}}}",
+      bid.producer_id,
+      bid.producer_epoch,
+      bid.first_seq,
+      bid.record_count);
+    return o;
+}
+
+const producer_state_table::seq_entry*
+producer_state_table::producer::newest() const {
+    return count == 0 ? nullptr : &window[count - 1];
+}
+
+void producer_state_table::producer::reset(int16_t e) {
+    epoch = e;
+    count = 0;
+    in_flight.clear();
+}
+
+void producer_state_table::producer::insert(seq_entry e) {
+    auto end = window.begin() + count;
+    if (std::any_of(window.begin(), end, [&e](const seq_entry& w) {
+            return w.last_offset == e.last_offset;
+        })) {
+        return;
+    }
+    // the window is ordered by offset, entries are applied in order unless
+    // replayed after a snapshot
+    size_t pos = count;
+    while (pos > 0 && window[pos - 1].last_offset > e.last_offset) {
+        --pos;
+    }
+    if (count == window.size()) {
+        if (pos == 0) {
+            return;
+        }
+        std::move(window.begin() + 1, window.begin() + pos, window.begin());
+        --pos;
+        --count;
+    }
+    std::move_backward(
+      window.begin() + pos,
+      window.begin() + count,
+      window.begin() + count + 1);
+    window[pos] = e;
+    ++count;
+}
+
+producer_state_table::outcome
+producer_state_table::check(const batch_identity& bid) const {
+    auto it = _producers.find(bid.producer_id);
+    if (it == _producers.end()) {
+        return {
+          bid.first_seq == 0 ? verdict::accept : verdict::unknown_producer,
+          model::offset{}};
+    }
+    const auto& p = it->second;
+    if (bid.producer_epoch < p.epoch) {
+        return {verdict::stale_epoch, model::offset{}};
+    }
+    if (bid.producer_epoch > p.epoch) {
+        // a new epoch starts its sequence over
+        return {
+          bid.first_seq == 0 ? verdict::accept : verdict::out_of_order,
+          model::offset{}};
+    }
+
+    const auto last = bid.last_seq();
+    for (size_t i = 0; i < p.count; ++i) {
+        if (same_batch(p.window[i], bid.first_seq, last)) {
+            return {verdict::duplicate, p.window[i].last_offset};
+        }
+    }
+    for (const auto& e : p.in_flight) {
+        if (same_batch(e, bid.first_seq, last)) {
+            if (e.last_offset >= model::offset(0)) {
+                return {verdict::duplicate, e.last_offset};
+            }
+            return {verdict::duplicate_in_flight, model::offset{}};
+        }
+    }
+
+    int32_t expected = 0;
+    if (!p.in_flight.empty()) {
+        expected = next_seq(p.in_flight.back().last_seq);
+    } else if (const auto* n = p.newest(); n) {
+        expected = next_seq(n->last_seq);
+    }
+    return {
+      bid.first_seq == expected ? verdict::accept : verdict::out_of_order,
+      model::offset{}};
+}
+
+void producer_state_table::begin(const batch_identity& bid) {
+    auto [it, inserted] = _producers.try_emplace(bid.producer_id);
+    auto& p = it->second;
+    if (inserted || bid.producer_epoch > p.epoch) {
+        p.reset(bid.producer_epoch);
+    }
+    p.in_flight.push_back(
+      seq_entry{bid.first_seq, bid.last_seq(), model::offset{}});
+}
+
+void producer_state_table::end(
+  const batch_identity& bid, std::optional<model::offset> last_offset) {
+    auto it = _producers.find(bid.producer_id);
+    if (it == _producers.end() || it->second.epoch != bid.producer_epoch) {
+        return;
+    }
+    auto& in_flight = it->second.in_flight;
+    const auto last = bid.last_seq();
+    auto e = std::find_if(
+      in_flight.begin(), in_flight.end(), [&bid, last](const seq_entry& e) {
+          return same_batch(e, bid.first_seq, last);
+      });
+    // applied already, or dropped by a new term
+    if (e == in_flight.end()) {
+        return;
+    }
+    if (last_offset) {
+        e->last_offset = *last_offset;
+    } else {
+        in_flight.erase(e);
+    }
+}
+
+void producer_state_table::clear_in_flight() {
+    for (auto& [_, p] : _producers) {
+        p.in_flight.clear();
+    }
+}
+
+void producer_state_table::apply(
+  const batch_identity& bid, model::offset last_offset) {
+    auto [it, inserted] = _producers.try_emplace(bid.producer_id);
+    auto& p = it->second;
+    if (inserted || bid.producer_epoch > p.epoch) {
+        p.reset(bid.producer_epoch);
+    } else if (bid.producer_epoch < p.epoch) {
+        return;
+    }
+    const auto last = bid.last_seq();
+    p.insert(seq_entry{bid.first_seq, last, last_offset});
+    p.in_flight.erase(
+      std::remove_if(
+        p.in_flight.begin(),
+        p.in_flight.end(),
+        [&bid, last](const seq_entry& e) {
+            return same_batch(e, bid.first_seq, last);
+        }),
+      p.in_flight.end());
+}
+
+std::optional<int16_t> producer_state_table::epoch(int64_t producer_id) const {
+    auto it = _producers.find(producer_id);
+    if (it == _producers.end()) {
+        return std::nullopt;
+    }
+    return it->second.epoch;
+}
+
+void producer_state_table::apply_transactional(
+  int64_t producer_id, model::offset o) {
+    _ongoing.try_emplace(producer_id, o);
+}
+
+void producer_state_table::apply_marker(
+  int64_t producer_id, control_record_type type, model::offset o) {
+    auto it = _ongoing.find(producer_id);
+    if (it == _ongoing.end()) {
+        // a marker with no transactional batch before it, or replayed
+        return;
+    }
+    if (type == control_record_type::abort) {
+        _aborted.push_back(aborted_transaction{
+          .producer_id = producer_id,
+          .first_offset = it->second,
+          .last_offset = o});
+    }
+    _ongoing.erase(it);
+}
+
+std::optional<model::offset>
+producer_state_table::first_ongoing_offset() const {
+    std::optional<model::offset> first;
+    for (const auto& [_, o] : _ongoing) {
+        if (!first || o < *first) {
+            first = o;
+        }
+    }
+    return first;
+}
+
+std::vector<aborted_transaction> producer_state_table::aborted_transactions(
+  model::offset from, model::offset to) const {
+    // the transactions which ended before the range are skipped, the ones
+    // ending later may have started before its end
+    auto it = std::lower_bound(
+      _aborted.begin(),
+      _aborted.end(),
+      from,
+      [](const aborted_transaction& t, model::offset o) {
+          return t.last_offset < o;
+      });
+    std::vector<aborted_transaction> ret;
+    std::copy_if(
+      it,
+      _aborted.end(),
+      std::back_inserter(ret),
+      [to](const aborted_transaction& t) { return t.first_offset <= to; });
+    return ret;
+}
+
+void producer_state_table::evict(model::offset o) {
+    for (auto it = _producers.begin(); it != _producers.end();) {
+        const auto& p = it->second;
+        const auto* n = p.newest();
+        if (
+          p.in_flight.empty() && (!n || n->last_offset < o)
+          && !_ongoing.contains(it->first)) {
+            _producers.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    auto end = std::lower_bound(
+      _aborted.begin(),
+      _aborted.end(),
+      o,
+      [](const aborted_transaction& t, model::offset o) {
+          return t.last_offset < o;
+      });
+    _aborted.erase(_aborted.begin(), end);
+}
+
+iobuf producer_state_table::serialize() const {
+    table_snapshot s;
+    s.producers.reserve(_producers.size());
+    for (const auto& [id, p] : _producers) {
+        s.producers.push_back(producer_snapshot{
+          .id = id,
+          .epoch = p.epoch,
+          .window = std::vector<seq_entry>(
+            p.window.begin(), p.window.begin() + p.count)});
+    }
+    s.ongoing.reserve(_ongoing.size());
+    for (const auto& [id, o] : _ongoing) {
+        s.ongoing.push_back(ongoing_snapshot{.id = id, .first_offset = o});
+    }
+    s.aborted = _aborted;
+    return reflection::to_iobuf(std::move(s));
+}
+
+producer_state_table producer_state_table::deserialize(iobuf buf) {
+    iobuf_parser parser(std::move(buf));
+    table_snapshot s;
+    s.version = reflection::adl<int8_t>{}.from(parser);
+    vassert(
+      s.version >= 0 && s.version <= table_snapshot::current_version,
+      "Unknown producer state snapshot version: {}",
+      s.version);
+    s.producers = reflection::adl<std::vector<producer_snapshot>>{}.from(
+      parser);
+    if (s.version >= 1) {
+        s.ongoing = reflection::adl<std::vector<ongoing_snapshot>>{}.from(
+          parser);
+        s.aborted = reflection::adl<std::vector<aborted_transaction>>{}.from(
+          parser);
+    }
+    producer_state_table t;
+    for (auto& ps : s.producers) {
+        auto& p = t._producers[ps.id];
+        p.epoch = ps.epoch;
+        for (const auto& e : ps.window) {
+            p.insert(e);
+        }
+    }
+    for (const auto& o : s.ongoing) {
+        t._ongoing.emplace(o.id, o.first_offset);
+    }
+    t._aborted = std::move(s.aborted);
+    return t;
+}
+
+producer_state_stm::producer_state_stm(raft::consensus* c, ss::logger& logger)
+  : raft::state_machine(c, logger, ss::default_priority_class())
+  , _raft(c)
+  , _log(logger) {}
+
+ss::future<result<raft::replicate_result>> producer_state_stm::replicate(
+  batch_identity bid,
+  model::record_batch_reader&& r,
+  raft::replicate_options opts) {
+    // checked synchronously so that the pipelined batches of a producer keep
+    // their order
+    if (likely(_synced_term == _raft->term())) {
+        return do_replicate(bid, std::move(r), std::move(opts));
+    }
+    return sync().then(
+      [this, bid, r = std::move(r), opts = std::move(opts)](
+        std::error_code ec) mutable {
+          if (ec) {
+              return ss::make_ready_future<result<raft::replicate_result>>(ec);
+          }
+          return do_replicate(bid, std::move(r), std::move(opts));
+      });
+}
+
+ss::future<result<raft::replicate_result>> producer_state_stm::do_replicate(
+  batch_identity bid,
+  model::record_batch_reader&& r,
+  raft::replicate_options opts) {
+    using ret_t = result<raft::replicate_result>;
+    using verdict = producer_state_table::verdict;
+
+    auto outcome = _table.check(bid);
+    switch (outcome.v) {
+    case verdict::accept:
+        break;
+    case verdict::duplicate:
+        vlog(_log.debug, "Skipping duplicate batch {}", bid);
+        return ss::make_ready_future<ret_t>(
+          raft::replicate_result{outcome.last_offset});
+    case verdict::duplicate_in_flight:
+        return ss::make_ready_future<ret_t>(errc::duplicate_sequence);
+    case verdict::out_of_order:
+        return ss::make_ready_future<ret_t>(errc::sequence_out_of_order);
+    case verdict::stale_epoch:
+        return ss::make_ready_future<ret_t>(errc::invalid_producer_epoch);
+    case verdict::unknown_producer:
+        return ss::make_ready_future<ret_t>(errc::unknown_producer_id);
+    }
+
+    _table.begin(bid);
+    return _raft->replicate(std::move(r), std::move(opts))
+      .then_wrapped([this, bid](ss::future<ret_t> f) {
+          try {
+              auto r = f.get0();
+              _table.end(
+                bid,
+                r ? std::optional<model::offset>(r.value().last_offset)
+                  : std::nullopt);
+              return r;
+          } catch (...) {
+              _table.end(bid, std::nullopt);
+              throw;
+          }
+      });
+}
+
+ss::future<std::error_code> producer_state_stm::sync() {
+    const auto term = _raft->term();
+    return linearizable_barrier(model::timeout_clock::now() + sync_timeout)
+      .then([this, term](std::error_code ec) {
+          if (ec) {
+              return ec;
+          }
+          if (_raft->term() != term) {
+              return std::error_code(raft::errc::not_leader);
+          }
+          if (_synced_term != term) {
+              _table.clear_in_flight();
+              _synced_term = term;
+          }
+          return ec;
+      });
+}
+
+iobuf producer_state_stm::snapshot_data(model::offset last_evicted) {
+    _table.evict(last_evicted);
+    return _table.serialize();
+}
+
+ss::future<result<raft::replicate_result>>
+producer_state_stm::end_transaction(
+  int64_t producer_id, int16_t epoch, control_record_type type) {
+    using ret_t = result<raft::replicate_result>;
+    return sync().then([this, producer_id, epoch, type](std::error_code ec) {
+        if (ec) {
+            return ss::make_ready_future<ret_t>(ec);
+        }
+        if (auto e = _table.epoch(producer_id); e && *e > epoch) {
+            return ss::make_ready_future<ret_t>(errc::invalid_producer_epoch);
+        }
+        auto batch = make_control_batch(producer_id, epoch, type);
+        return _raft->replicate(
+          model::make_memory_record_batch_reader(std::move(batch)),
+          raft::replicate_options(raft::consistency_level::quorum_ack));
+    });
+}
+
+model::offset
+producer_state_stm::last_stable_offset(model::offset committed) const {
+    auto lso = std::min(committed + model::offset(1), next_to_apply());
+    if (auto first = _table.first_ongoing_offset(); first) {
+        lso = std::min(lso, *first);
+    }
+    return lso;
+}
+
+ss::future<> producer_state_stm::apply(model::record_batch b) {
+    auto bid = batch_identity::from(b.header());
+    if (!bid.is_idempotent()) {
+        return ss::now();
+    }
+    if (b.header().attrs.is_control()) {
+        apply_control(b);
+        return ss::now();
+    }
+    _table.apply(bid, b.last_offset());
+    if (bid.is_transactional) {
+        _table.apply_transactional(bid.producer_id, b.base_offset());
+    }
+    return ss::now();
+}
+
+void producer_state_stm::apply_control(const model::record_batch& b) {
+    if (b.compressed() || b.record_count() != 1) {
+        vlog(_log.warn, "Skipping malformed control batch {}", b.header());
+        return;
+    }
+    b.for_each_record([this, &b](model::record r) {
+        auto type = parse_control_type(r.release_key());
+        if (!type) {
+            vlog(_log.warn, "Skipping unknown control record {}", b.header());
+            return;
+        }
+        _table.apply_marker(b.header().producer_id, *type, b.base_offset());
+    });
+}
+
+ss::future<> producer_state_stm::apply_snapshot(model::offset, iobuf&& data) {
+    if (data.empty()) {
+        // taken before the table was written into the snapshots
+        _table = producer_state_table{};
+    } else {
+        _table = producer_state_table::deserialize(std::move(data));
+    }
+    return ss::now();
+}
+
+} // namespace cluster
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "model/fundamental.h"
+#include "model/record.h"
+#include "model/record_batch_reader.h"
+#include "outcome.h"
+#include "raft/state_machine.h"
+#include "raft/types.h"
+#include "seastarx.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace cluster {
+
+/// The producer and the sequence numbers of a batch, set by idempotent
+/// producers only
+struct batch_identity {
+    int64_t producer_id{-1};
+    int16_t producer_epoch{0};
+    int32_t first_seq{0};
+    int32_t record_count{0};
+    bool is_transactional{false};
+
+    static batch_identity from(const model::record_batch_header&);
+
+    bool is_idempotent() const { return producer_id >= 0; }
+
+    /// sequence numbers wrap around to 0 after the max int32
+    int32_t last_seq() const;
+};
+
+std::ostream& operator<<(std::ostream&, const batch_identity&);
+
+/// the types of the control records ending a transaction, as written by kafka
+enum class control_record_type : int16_t { abort = 0, commit = 1 };
+
+/// a transaction of a producer aborted by the marker at last_offset
+struct aborted_transaction {
+    int64_t producer_id;
+    model::offset first_offset;
+    model::offset last_offset;
+};
+
+/**
+ * The sequence numbers of the last batches written by each idempotent
+ * producer of a partition.
+ *
+ * A producer retrying a batch among its last window_size batches gets the
+ * offset of the batch written first instead of writing a duplicate, which
+ * allows producers to pipeline their requests. Only the leader tracks the
+ * batches in flight, the followers learn the batches from the log.
+ *
+ * The table also tracks the ongoing transactions of the producers, which
+ * bound the last stable offset, and indexes the aborted ones for the fetches
+ * of read committed consumers.
+ */
+class producer_state_table {
+public:
+    static constexpr size_t window_size = 5;
+
+    struct seq_entry {
+        int32_t first_seq;
+        int32_t last_seq;
+        model::offset last_offset;
+    };
+
+    enum class verdict {
+        accept,
+        /// written already, at the offset of the outcome
+        duplicate,
+        /// still in flight, so that its offset is unknown
+        duplicate_in_flight,
+        out_of_order,
+        stale_epoch,
+        unknown_producer,
+    };
+
+    struct outcome {
+        verdict v;
+        model::offset last_offset;
+    };
+
+    /// whether the batch may be written after the ones written and in flight
+    outcome check(const batch_identity&) const;
+
+    /// tracks a batch accepted by check() until its write completes
+    void begin(const batch_identity&);
+
+    /// a batch tracked by begin() was written at the offset, or failed. the
+    /// written batch stays in flight until applied.
+    void end(const batch_identity&, std::optional<model::offset> last_offset);
+
+    /// forgets the batches in flight, which the leader of a new term did not
+    /// write
+    void clear_in_flight();
+
+    /// records a committed batch. applying a batch again is a no-op.
+    void apply(const batch_identity&, model::offset last_offset);
+
+    /// the epoch of the producer, if known
+    std::optional<int16_t> epoch(int64_t producer_id) const;
+
+    /// a transactional batch of the producer was applied at the offset, which
+    /// starts the transaction of the producer unless it is ongoing already
+    void apply_transactional(int64_t producer_id, model::offset);
+
+    /// the marker at the offset ends the ongoing transaction of the producer
+    void apply_marker(int64_t producer_id, control_record_type, model::offset);
+
+    /// the first offset of the oldest ongoing transaction
+    std::optional<model::offset> first_ongoing_offset() const;
+
+    /// the aborted transactions which have batches in the range, inclusive
+    std::vector<aborted_transaction>
+    aborted_transactions(model::offset from, model::offset to) const;
+
+    /// drops the producers which last wrote before the offset, and the
+    /// aborted transactions that ended before it
+    void evict(model::offset);
+
+    /// the producers and their windows, without the batches in flight
+    iobuf serialize() const;
+    static producer_state_table deserialize(iobuf);
+
+    size_t size() const { return _producers.size(); }
+
+private:
+    struct producer {
+        int16_t epoch{0};
+        /// oldest first
+        std::array<seq_entry, window_size> window{};
+        uint8_t count{0};
+        /// the batches in flight, in the order they were accepted. their
+        /// offset is set once written.
+        std::vector<seq_entry> in_flight;
+
+        const seq_entry* newest() const;
+        void reset(int16_t);
+        void insert(seq_entry);
+    };
+
+    absl::flat_hash_map<int64_t, producer> _producers;
+    /// the first offset of the ongoing transaction of each producer
+    absl::flat_hash_map<int64_t, model::offset> _ongoing;
+    /// ordered by last offset, as the markers are applied in order. the
+    /// range of a fetch is found by a binary search on the end of the
+    /// transactions rather than by scanning the log.
+    std::vector<aborted_transaction> _aborted;
+};
+
+/**
+ * Keeps the producer_state_table of a partition: the leader checks and
+ * tracks the writes of idempotent producers and every replica applies the
+ * batches of the log. The table is written into the snapshot taken when the
+ * log is prefix truncated.
+ */
+class producer_state_stm final : public raft::state_machine {
+public:
+    producer_state_stm(raft::consensus*, ss::logger&);
+
+    /// replicates the batch unless it is a duplicate or out of sequence
+    ss::future<result<raft::replicate_result>> replicate(
+      batch_identity, model::record_batch_reader&&, raft::replicate_options);
+
+    /// the snapshot data of the table up to the last evicted offset
+    iobuf snapshot_data(model::offset last_evicted);
+
+    /// writes the marker which ends the ongoing transaction of the producer
+    ss::future<result<raft::replicate_result>>
+    end_transaction(int64_t producer_id, int16_t epoch, control_record_type);
+
+    /**
+     * The last stable offset: the first offset of the oldest ongoing
+     * transaction. Bounded by the next offset to apply, as the transactions
+     * started by the committed batches are only known once applied.
+     */
+    model::offset last_stable_offset(model::offset committed) const;
+
+    std::vector<aborted_transaction>
+    aborted_transactions(model::offset from, model::offset to) const {
+        return _table.aborted_transactions(from, to);
+    }
+
+    const producer_state_table& table() const { return _table; }
+
+private:
+    ss::future<> apply(model::record_batch) final;
+    ss::future<> apply_snapshot(model::offset, iobuf&&) final;
+    void apply_control(const model::record_batch&);
+
+    /// waits for the entries committed by previous leaders to be applied
+    ss::future<std::error_code> sync();
+
+    ss::future<result<raft::replicate_result>> do_replicate(
+      batch_identity, model::record_batch_reader&&, raft::replicate_options);
+
+    raft::consensus* _raft;
+    ss::logger& _log;
+    producer_state_table _table;
+    model::term_id _synced_term{-1};
+};
+
+} // namespace cluster
@@ -83,6 +83,21 @@ service::fetch_metadata_and_cfg(const std::vector<topic_result>& res) {
     return {std::move(md), std::move(cfg)};
 }
 
+ss::future<move_partition_replicas_reply> service::move_partition_replicas(
+  move_partition_replicas_request&& r, rpc::streaming_context&) {
+    return ss::with_scheduling_group(
+             get_scheduling_group(),
+             [this, r = std::move(r)]() mutable {
+                 return _topics_frontend.local().move_partition_replicas(
+                   std::move(r.ntp),
+                   std::move(r.replicas),
+                   model::timeout_clock::now() + r.timeout);
+             })
+      .then([](std::error_code ec) {
+          return move_partition_replicas_reply{static_cast<errc>(ec.value())};
+      });
+}
+
 ss::future<configuration_update_reply> service::update_node_configuration(
   configuration_update_request&& req, rpc::streaming_context&) {
     return ss::with_scheduling_group(
@@ -0,0 +1,220 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/shard_balancer.h"
+
+#include "cluster/logger.h"
+#include "config/configuration.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "vlog.h"
+
+#include <seastar/core/metrics.hh>
+#include <seastar/core/smp.hh>
+
+namespace cluster {
+
+using namespace std::chrono_literals;
+
+static constexpr model::timeout_clock::duration move_timeout = 10s;
+
+shard_balancer::shard_balancer(
+  ss::sharded<topic_table>& topics,
+  ss::sharded<partition_manager>& partition_manager,
+  ss::sharded<topics_frontend>& frontend)
+  : _topics(topics)
+  , _partition_manager(partition_manager)
+  , _frontend(frontend)
+  , _self(config::shard_local_cfg().node_id()) {}
+
+ss::future<> shard_balancer::start() {
+    setup_metrics();
+    if (!config::shard_local_cfg().enable_shard_balancer()) {
+        return ss::now();
+    }
+    _timer.set_callback([this] { tick(); });
+    _timer.arm_periodic(config::shard_local_cfg().shard_balancer_interval_ms());
+    return ss::now();
+}
+
+ss::future<> shard_balancer::stop() {
+    _timer.cancel();
+    return _gate.close();
+}
+
+void shard_balancer::tick() {
+    if (_balancing || _gate.is_closed()) {
+        // the previous move is still in progress
+        return;
+    }
+    _balancing = true;
+    (void)ss::with_gate(_gate, [this] {
+        return balance().finally([this] { _balancing = false; });
+    });
+}
+
+ss::future<> shard_balancer::balance() {
+    return collect_loads().then([this](std::vector<partition_load> loads) {
+        ++_rounds;
+        auto m = plan(
+          loads,
+          ss::smp::count,
+          config::shard_local_cfg().shard_balancer_imbalance_percent());
+        if (!m) {
+            return ss::now();
+        }
+        return do_move(std::move(*m));
+    });
+}
+
+ss::future<std::vector<shard_balancer::partition_load>>
+shard_balancer::collect_loads() {
+    using served_t = std::vector<std::pair<model::ntp, uint64_t>>;
+    return _partition_manager
+      .map([](partition_manager& pm) {
+          served_t served;
+          served.reserve(pm.partitions().size());
+          for (const auto& [ntp, p] : pm.partitions()) {
+              served.emplace_back(
+                ntp, p->probe().bytes_produced() + p->probe().bytes_fetched());
+          }
+          return served;
+      })
+      .then([this](std::vector<served_t> per_shard) {
+          std::vector<partition_load> loads;
+          absl::flat_hash_map<model::ntp, uint64_t> served;
+          for (ss::shard_id s = 0; s < per_shard.size(); ++s) {
+              for (auto& [ntp, bytes] : per_shard[s]) {
+                  uint64_t delta = 0;
+                  if (auto it = _served.find(ntp); it != _served.end()) {
+                      // the counters restart when the partition moves
+                      delta = bytes >= it->second ? bytes - it->second
+                                                  : bytes;
+                  }
+                  loads.push_back(
+                    partition_load{.ntp = ntp, .shard = s, .bytes = delta});
+                  served.emplace(std::move(ntp), bytes);
+              }
+          }
+          _served = std::move(served);
+          return loads;
+      });
+}
+
+std::optional<shard_balancer::move> shard_balancer::plan(
+  const std::vector<partition_load>& loads,
+  ss::shard_id shard_count,
+  uint32_t imbalance_percent) {
+    if (shard_count < 2) {
+        return std::nullopt;
+    }
+    std::vector<uint64_t> per_shard(shard_count, 0);
+    for (const auto& l : loads) {
+        per_shard[l.shard] += l.bytes;
+    }
+    auto busiest = std::distance(
+      per_shard.begin(), std::max_element(per_shard.begin(), per_shard.end()));
+    auto idlest = std::distance(
+      per_shard.begin(), std::min_element(per_shard.begin(), per_shard.end()));
+    const uint64_t gap = per_shard[busiest] - per_shard[idlest];
+    if (gap == 0 || gap * 100 <= per_shard[busiest] * imbalance_percent) {
+        return std::nullopt;
+    }
+    // the busiest partition that narrows the gap, moving one that is larger
+    // than the gap would only swap the cores
+    const partition_load* candidate = nullptr;
+    for (const auto& l : loads) {
+        if (
+          l.shard == ss::shard_id(busiest) && l.bytes > 0 && l.bytes < gap
+          && (!candidate || l.bytes > candidate->bytes)) {
+            candidate = &l;
+        }
+    }
+    if (!candidate) {
+        return std::nullopt;
+    }
+    return move{.ntp = candidate->ntp, .target = ss::shard_id(idlest)};
+}
+
+ss::future<> shard_balancer::do_move(move m) {
+    auto md = _topics.local().get_topic_metadata(
+      model::topic_namespace_view(m.ntp));
+    if (!md) {
+        return ss::now();
+    }
+    auto p = std::find_if(
+      md->partitions.begin(),
+      md->partitions.end(),
+      [&m](const model::partition_metadata& p) {
+          return p.id == m.ntp.tp.partition;
+      });
+    if (p == md->partitions.end()) {
+        return ss::now();
+    }
+    auto replicas = std::move(p->replicas);
+    for (auto& r : replicas) {
+        if (r.node_id == _self) {
+            r.shard = m.target;
+        }
+    }
+    vlog(
+      clusterlog.info,
+      "Moving partition {} to core {}, replicas: {}",
+      m.ntp,
+      m.target,
+      replicas);
+    return _frontend.local()
+      .move_partition_replicas(
+        m.ntp, std::move(replicas), model::timeout_clock::now() + move_timeout)
+      .then_wrapped([this, ntp = m.ntp](ss::future<std::error_code> f) {
+          if (f.failed()) {
+              ++_failed_moves;
+              vlog(
+                clusterlog.info,
+                "Moving partition {} failed: {}",
+                ntp,
+                f.get_exception());
+              return;
+          }
+          if (auto ec = f.get0(); ec) {
+              ++_failed_moves;
+              vlog(
+                clusterlog.info,
+                "Moving partition {} failed: {}",
+                ntp,
+                ec.message());
+              return;
+          }
+          ++_moves;
+      });
+}
+
+void shard_balancer::setup_metrics() {
+    namespace sm = ss::metrics;
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("cluster:shard_balancer"),
+      {
+        sm::make_derive(
+          "rounds",
+          [this] { return _rounds; },
+          sm::description("Number of partition to core rebalancing rounds")),
+        sm::make_derive(
+          "partition_moves",
+          [this] { return _moves; },
+          sm::description("Number of partitions moved to another core")),
+        sm::make_derive(
+          "failed_partition_moves",
+          [this] { return _failed_moves; },
+          sm::description("Number of failed partition moves")),
+      });
+}
+
+} // namespace cluster
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "cluster/partition_manager.h"
+#include "cluster/topic_table.h"
+#include "cluster/topics_frontend.h"
+#include "model/fundamental.h"
+
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <optional>
+#include <vector>
+
+namespace cluster {
+
+/// Moves hot partitions between the cores of a node.
+///
+/// Partitions are placed on a core when they are created, so a few busy
+/// partitions may saturate a core while the others idle. Every round, the
+/// balancer sums the bytes produced to and fetched from the partitions of
+/// each core since the previous round. When the busiest core served more than
+/// shard_balancer_imbalance_percent over the idlest one, the largest partition
+/// that narrows the gap moves to the idlest core, through a controller
+/// partition move that only changes the core of this node's replica. The
+/// controller backend then moves the log and its kvstore state between the
+/// cores. One partition moves per round, as it is unavailable while moving.
+class shard_balancer {
+public:
+    static constexpr ss::shard_id shard = 0;
+
+    shard_balancer(
+      ss::sharded<topic_table>&,
+      ss::sharded<partition_manager>&,
+      ss::sharded<topics_frontend>&);
+
+    ss::future<> start();
+    ss::future<> stop();
+
+    /// The bytes a partition of this node served during a round
+    struct partition_load {
+        model::ntp ntp;
+        ss::shard_id shard;
+        uint64_t bytes;
+    };
+
+    struct move {
+        model::ntp ntp;
+        ss::shard_id target;
+    };
+
+    /// \brief the partition to move, if any, to even out the bytes served by
+    /// the cores of the node
+    static std::optional<move> plan(
+      const std::vector<partition_load>&,
+      ss::shard_id shard_count,
+      uint32_t imbalance_percent);
+
+private:
+    void tick();
+    ss::future<> balance();
+    ss::future<std::vector<partition_load>> collect_loads();
+    ss::future<> do_move(move);
+    void setup_metrics();
+
+    ss::sharded<topic_table>& _topics;
+    ss::sharded<partition_manager>& _partition_manager;
+    ss::sharded<topics_frontend>& _frontend;
+    model::node_id _self;
+    /// bytes served by each partition, as of the previous round
+    absl::flat_hash_map<model::ntp, uint64_t> _served;
+    ss::timer<> _timer;
+    ss::gate _gate;
+    bool _balancing{false};
+
+    uint64_t _rounds{0};
+    uint64_t _moves{0};
+    uint64_t _failed_moves{0};
+    ss::metrics::metric_groups _metrics;
+};
+
+} // namespace cluster
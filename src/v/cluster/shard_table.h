@@ -12,6 +12,7 @@
 #pragma once
 
 #include "model/fundamental.h"
+#include "model/ntp_registry.h"
 #include "raft/types.h"
 #include "seastarx.h"
 
@@ -19,11 +20,28 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <optional>
+#include <vector>
+
 namespace cluster {
 /// \brief this is populated by consensus::controller
 /// every core will have a _full_ copy of all indexes
 class shard_table final {
 public:
+    shard_table() = default;
+    shard_table(const shard_table&) = delete;
+    shard_table& operator=(const shard_table&) = delete;
+    shard_table(shard_table&&) = delete;
+    shard_table& operator=(shard_table&&) = delete;
+    ~shard_table() {
+        auto& registry = model::ntp_registry::local();
+        for (size_t i = 0; i < _ntp_idx.size(); ++i) {
+            if (_ntp_idx[i]) {
+                registry.release(model::ntp_id(i));
+            }
+        }
+    }
+
     bool contains(const raft::group_id& group) {
         return _group_idx.find(group) != _group_idx.end();
     }
@@ -35,24 +53,48 @@ public:
      * \brief Lookup the owning shard for an ntp.
      */
     std::optional<ss::shard_id> shard_for(const model::ntp& ntp) {
-        if (auto it = _ntp_idx.find(ntp); it != _ntp_idx.end()) {
-            return it->second;
+        if (auto id = model::ntp_registry::local().find(ntp); id) {
+            return shard_for(*id);
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * \brief Lookup the owning shard for an ntp id of this core, resolved
+     * once when a request is decoded.
+     */
+    std::optional<ss::shard_id> shard_for(model::ntp_id id) {
+        if (id() < _ntp_idx.size()) {
+            return _ntp_idx[id()];
         }
         return std::nullopt;
     }
-    void insert(model::ntp ntp, ss::shard_id i) {
-        _ntp_idx.insert({std::move(ntp), i});
+
+    void insert(const model::ntp& ntp, ss::shard_id i) {
+        auto& registry = model::ntp_registry::local();
+        if (auto id = registry.find(ntp); id && shard_for(*id)) {
+            return;
+        }
+        const auto id = registry.acquire(ntp);
+        if (id() >= _ntp_idx.size()) {
+            _ntp_idx.resize(id() + 1);
+        }
+        _ntp_idx[id()] = i;
     }
     void insert(raft::group_id g, ss::shard_id i) { _group_idx.insert({g, i}); }
 
     void erase(const model::ntp& ntp, raft::group_id g) {
-        _ntp_idx.erase(ntp);
+        auto& registry = model::ntp_registry::local();
+        if (auto id = registry.find(ntp); id && shard_for(*id)) {
+            _ntp_idx[(*id)()] = std::nullopt;
+            registry.release(*id);
+        }
         _group_idx.erase(g);
     }
 
 private:
-    // kafka index
-    absl::flat_hash_map<model::ntp, ss::shard_id> _ntp_idx;
+    // kafka index, by the ntp id of this core
+    std::vector<std::optional<ss::shard_id>> _ntp_idx;
     // raft index
     absl::flat_hash_map<raft::group_id, ss::shard_id> _group_idx;
 };
@@ -47,3 +47,11 @@ PERF_TEST_F(partition_allocator_tester, recovery) {
     pa.update_allocation_state(md, raft::group_id(partitions_per_topic));
     perf_tests::stop_measuring_time();
 }
+PERF_TEST_F(partition_allocator_tester, bulk_allocation_30000_3) {
+    auto cfg = gen_topic_configuration(30000, 3);
+
+    perf_tests::start_measuring_time();
+    auto vals = pa.allocate(cfg);
+    perf_tests::do_not_optimize(vals);
+    perf_tests::stop_measuring_time();
+}
@@ -0,0 +1,69 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE cluster
+#include "cluster/leader_balancer.h"
+#include "model/fundamental.h"
+#include "model/metadata.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <vector>
+
+using lb = cluster::leader_balancer;
+
+static lb::core make_core(int node, ss::shard_id shard) {
+    return lb::core(model::node_id(node), shard);
+}
+
+static model::ntp make_ntp(int p) {
+    return model::ntp(
+      model::ns("test_ns"), model::topic("tp"), model::partition_id(p));
+}
+
+/// partitions led by node 0, shard 0, replicated to shard 0 of nodes 1 and 2
+static std::vector<lb::led_partition> led_by_self(int count) {
+    std::vector<lb::led_partition> ret;
+    for (int i = 0; i < count; ++i) {
+        ret.push_back(lb::led_partition{
+          .ntp = make_ntp(i),
+          .leader = make_core(0, 0),
+          .replicas = {make_core(0, 0), make_core(1, 0), make_core(2, 0)}});
+    }
+    return ret;
+}
+
+BOOST_AUTO_TEST_CASE(balanced_cluster_has_no_transfers) {
+    std::map<lb::core, size_t> leaders{
+      {make_core(0, 0), 2}, {make_core(1, 0), 2}, {make_core(2, 0), 2}};
+    auto transfers = lb::plan(leaders, led_by_self(2), 10);
+    BOOST_REQUIRE(transfers.empty());
+}
+
+BOOST_AUTO_TEST_CASE(leaders_spread_to_least_loaded_cores) {
+    std::map<lb::core, size_t> leaders{
+      {make_core(0, 0), 6}, {make_core(1, 0), 0}, {make_core(2, 0), 0}};
+    auto transfers = lb::plan(leaders, led_by_self(6), 10);
+    BOOST_REQUIRE_EQUAL(transfers.size(), 4);
+    std::map<model::node_id, size_t> targets;
+    for (auto& t : transfers) {
+        BOOST_REQUIRE_EQUAL(t.shard, ss::shard_id(0));
+        targets[t.target]++;
+    }
+    BOOST_REQUIRE_EQUAL(targets[model::node_id(1)], 2);
+    BOOST_REQUIRE_EQUAL(targets[model::node_id(2)], 2);
+}
+
+BOOST_AUTO_TEST_CASE(transfers_are_capped) {
+    std::map<lb::core, size_t> leaders{
+      {make_core(0, 0), 6}, {make_core(1, 0), 0}, {make_core(2, 0), 0}};
+    auto transfers = lb::plan(leaders, led_by_self(6), 1);
+    BOOST_REQUIRE_EQUAL(transfers.size(), 1);
+}
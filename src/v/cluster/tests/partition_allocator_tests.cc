@@ -12,6 +12,8 @@
 #include "raft/types.h"
 #include "test_utils/fixture.h"
 
+#include <set>
+
 using namespace cluster; // NOLINT
 
 uint allocated_nodes_count(const std::vector<partition_assignment>& allocs) {
@@ -197,4 +199,53 @@ FIXTURE_TEST(allocation_units_test, partition_allocator_tester) {
       machines().at(model::node_id(2))->partition_capacity(), max);
     // we do not decrement the highest raft group
     BOOST_REQUIRE_EQUAL(highest_group()(), partitions);
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE(rack_aware_assignment) {
+    // 6 nodes in 3 racks
+    partition_allocator_tester test(0, 10);
+    for (auto i = 0; i < 6; ++i) {
+        test.pa.register_node(std::make_unique<allocation_node>(
+          model::node_id(i),
+          10,
+          std::unordered_map<ss::sstring, ss::sstring>(),
+          ss::sstring(fmt::format("rack-{}", i % 3))));
+    }
+    auto cfg = test.gen_topic_configuration(120, 3);
+    std::vector<partition_assignment> allocs
+      = test.pa.allocate(cfg).value().get_assignments();
+    std::map<model::node_id, int> leaders;
+    std::map<model::node_id, int> replicas;
+    for (auto& a : allocs) {
+        std::set<int> racks;
+        for (auto& bs : a.replicas) {
+            racks.insert(bs.node_id() % 3);
+            replicas[bs.node_id]++;
+        }
+        // every replica of a partition is on its own rack
+        BOOST_REQUIRE_EQUAL(racks.size(), 3);
+        leaders[a.replicas.front().node_id]++;
+    }
+    for (auto& p : replicas) {
+        BOOST_REQUIRE_EQUAL(p.second, 60);
+    }
+    for (auto& p : leaders) {
+        BOOST_REQUIRE_EQUAL(p.second, 20);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(core_balanced_assignment) {
+    partition_allocator_tester test(3, 4);
+    auto cfg = test.gen_topic_configuration(398, 3);
+    std::vector<partition_assignment> allocs
+      = test.pa.allocate(cfg).value().get_assignments();
+    std::map<std::pair<model::node_id, uint32_t>, int> cores;
+    for (auto& a : allocs) {
+        for (auto& bs : a.replicas) {
+            cores[{bs.node_id, bs.shard}]++;
+        }
+    }
+    for (auto& [core, count] : cores) {
+        // core 0 starts with extra weight
+        BOOST_REQUIRE_EQUAL(count, core.second == 0 ? 98 : 100);
+    }
+}
@@ -0,0 +1,70 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE cluster
+#include "cluster/partition_leaders_table.h"
+#include "model/fundamental.h"
+#include "model/metadata.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+static model::ntp make_ntp(int p) {
+    return model::ntp(
+      model::ns("test_ns"), model::topic("tp"), model::partition_id(p));
+}
+
+static std::vector<model::partition_id>
+updated_since(const cluster::partition_leaders_table& table, uint64_t rev) {
+    std::vector<model::partition_id> ret;
+    table.for_each_leader_since(
+      rev,
+      [&ret](
+        model::topic_namespace_view,
+        model::partition_id pid,
+        std::optional<model::node_id>,
+        model::term_id) { ret.push_back(pid); });
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+BOOST_AUTO_TEST_CASE(test_leaders_updated_since_revision) {
+    cluster::partition_leaders_table table;
+    for (int p = 0; p < 10; ++p) {
+        table.update_partition_leader(
+          make_ntp(p), model::term_id(1), model::node_id(1));
+    }
+    BOOST_REQUIRE_EQUAL(updated_since(table, 0).size(), 10);
+    const auto rev = table.revision();
+    BOOST_REQUIRE(updated_since(table, rev).empty());
+
+    // a new leader, a new term, and a stale update
+    table.update_partition_leader(
+      make_ntp(3), model::term_id(2), model::node_id(2));
+    table.update_partition_leader(
+      make_ntp(5), model::term_id(2), model::node_id(1));
+    table.update_partition_leader(
+      make_ntp(7), model::term_id(0), model::node_id(2));
+    // a duplicate of the current state
+    table.update_partition_leader(
+      make_ntp(8), model::term_id(1), model::node_id(1));
+
+    std::vector<model::partition_id> expected{
+      model::partition_id(3), model::partition_id(5)};
+    BOOST_REQUIRE_EQUAL(updated_since(table, rev), expected);
+    BOOST_REQUIRE(updated_since(table, table.revision()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_leaders_table_instances_differ) {
+    cluster::partition_leaders_table a;
+    cluster::partition_leaders_table b;
+    BOOST_REQUIRE_NE(a.instance(), b.instance());
+}
@@ -0,0 +1,62 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/partition_offsets_table.h"
+#include "model/fundamental.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+using namespace std::chrono_literals;
+using table_t = cluster::partition_offsets_table;
+
+static table_t::snapshot_ptr
+make_snapshot(const model::ntp& ntp, model::offset hwm) {
+    table_t::snapshot s;
+    s.emplace(
+      ntp,
+      table_t::offsets{
+        .start_offset = model::offset(0),
+        .high_watermark = hwm,
+        .last_stable_offset = hwm,
+        .leader = true,
+      });
+    return ss::make_foreign(
+      ss::make_lw_shared<const table_t::snapshot>(std::move(s)));
+}
+
+SEASTAR_THREAD_TEST_CASE(reads_published_offsets) {
+    const model::ntp ntp(model::ns("kafka"), model::topic("t"), 0);
+    table_t table;
+    BOOST_REQUIRE(!table.get(ntp, 1s));
+
+    const auto now = table_t::clock_type::now();
+    table.publish(0, make_snapshot(ntp, model::offset(10)), now);
+    auto o = table.get(0, ntp, 1s);
+    BOOST_REQUIRE(o);
+    BOOST_REQUIRE_EQUAL(o->high_watermark, model::offset(10));
+    BOOST_REQUIRE(table.get(ntp, 1s));
+    BOOST_REQUIRE(!table.get(
+      0, model::ntp(model::ns("kafka"), model::topic("t"), 1), 1s));
+
+    // a late snapshot of an earlier round is dropped
+    table.publish(0, make_snapshot(ntp, model::offset(5)), now - 1s);
+    BOOST_REQUIRE_EQUAL(
+      table.get(0, ntp, 2s)->high_watermark, model::offset(10));
+}
+
+SEASTAR_THREAD_TEST_CASE(ignores_old_snapshots) {
+    const model::ntp ntp(model::ns("kafka"), model::topic("t"), 0);
+    table_t table;
+    table.publish(
+      0,
+      make_snapshot(ntp, model::offset(10)),
+      table_t::clock_type::now() - 10s);
+    BOOST_REQUIRE(!table.get(0, ntp, 1s));
+    BOOST_REQUIRE(table.get(0, ntp, 20s));
+}
@@ -0,0 +1,201 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE cluster
+#include "cluster/producer_state.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+
+using table = cluster::producer_state_table;
+using verdict = table::verdict;
+
+static cluster::batch_identity
+batch(int64_t pid, int32_t first_seq, int32_t records, int16_t epoch = 0) {
+    return cluster::batch_identity{
+      .producer_id = pid,
+      .producer_epoch = epoch,
+      .first_seq = first_seq,
+      .record_count = records};
+}
+
+BOOST_AUTO_TEST_CASE(last_seq_wraps_around) {
+    BOOST_REQUIRE_EQUAL(batch(1, 0, 10).last_seq(), 9);
+    auto max = std::numeric_limits<int32_t>::max();
+    BOOST_REQUIRE_EQUAL(batch(1, max - 1, 2).last_seq(), max);
+    BOOST_REQUIRE_EQUAL(batch(1, max - 1, 4).last_seq(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(new_producer_starts_at_zero) {
+    table t;
+    BOOST_REQUIRE(t.check(batch(1, 0, 10)).v == verdict::accept);
+    BOOST_REQUIRE(t.check(batch(1, 5, 10)).v == verdict::unknown_producer);
+}
+
+BOOST_AUTO_TEST_CASE(pipelined_batches_follow_in_flight_ones) {
+    table t;
+    t.begin(batch(1, 0, 10));
+    BOOST_REQUIRE(t.check(batch(1, 10, 10)).v == verdict::accept);
+    t.begin(batch(1, 10, 10));
+    BOOST_REQUIRE(t.check(batch(1, 20, 10)).v == verdict::accept);
+    BOOST_REQUIRE(t.check(batch(1, 30, 10)).v == verdict::out_of_order);
+    BOOST_REQUIRE(t.check(batch(1, 0, 10)).v == verdict::duplicate_in_flight);
+}
+
+BOOST_AUTO_TEST_CASE(retried_batch_gets_offset_of_first_write) {
+    table t;
+    t.begin(batch(1, 0, 10));
+    t.end(batch(1, 0, 10), model::offset(9));
+    // written but not applied yet
+    auto o = t.check(batch(1, 0, 10));
+    BOOST_REQUIRE(o.v == verdict::duplicate);
+    BOOST_REQUIRE_EQUAL(o.last_offset, model::offset(9));
+
+    t.apply(batch(1, 0, 10), model::offset(9));
+    o = t.check(batch(1, 0, 10));
+    BOOST_REQUIRE(o.v == verdict::duplicate);
+    BOOST_REQUIRE_EQUAL(o.last_offset, model::offset(9));
+    BOOST_REQUIRE(t.check(batch(1, 10, 10)).v == verdict::accept);
+}
+
+BOOST_AUTO_TEST_CASE(failed_write_can_be_retried) {
+    table t;
+    t.begin(batch(1, 0, 10));
+    t.end(batch(1, 0, 10), std::nullopt);
+    BOOST_REQUIRE(t.check(batch(1, 0, 10)).v == verdict::accept);
+}
+
+BOOST_AUTO_TEST_CASE(window_keeps_last_batches) {
+    table t;
+    for (int i = 0; i < 10; ++i) {
+        t.apply(batch(1, i * 10, 10), model::offset(i * 10 + 9));
+    }
+    for (int i = 0; i < 10; ++i) {
+        auto o = t.check(batch(1, i * 10, 10));
+        if (i < 10 - int(table::window_size)) {
+            BOOST_REQUIRE(o.v == verdict::out_of_order);
+        } else {
+            BOOST_REQUIRE(o.v == verdict::duplicate);
+            BOOST_REQUIRE_EQUAL(o.last_offset, model::offset(i * 10 + 9));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(applying_again_is_a_noop) {
+    table t;
+    t.apply(batch(1, 0, 10), model::offset(9));
+    t.apply(batch(1, 10, 10), model::offset(19));
+    t.apply(batch(1, 0, 10), model::offset(9));
+    BOOST_REQUIRE(t.check(batch(1, 20, 10)).v == verdict::accept);
+}
+
+BOOST_AUTO_TEST_CASE(epochs_fence_older_producers) {
+    table t;
+    t.apply(batch(1, 0, 10, 1), model::offset(9));
+    BOOST_REQUIRE(t.check(batch(1, 10, 10, 0)).v == verdict::stale_epoch);
+    BOOST_REQUIRE(t.check(batch(1, 10, 10, 2)).v == verdict::out_of_order);
+    BOOST_REQUIRE(t.check(batch(1, 0, 10, 2)).v == verdict::accept);
+}
+
+BOOST_AUTO_TEST_CASE(new_term_forgets_in_flight_batches) {
+    table t;
+    t.apply(batch(1, 0, 10), model::offset(9));
+    t.begin(batch(1, 10, 10));
+    t.clear_in_flight();
+    BOOST_REQUIRE(t.check(batch(1, 10, 10)).v == verdict::accept);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_roundtrip_and_eviction) {
+    table t;
+    t.apply(batch(1, 0, 10), model::offset(9));
+    t.apply(batch(2, 0, 10), model::offset(19));
+    t.apply(batch(2, 10, 10), model::offset(29));
+    t.evict(model::offset(15));
+    BOOST_REQUIRE_EQUAL(t.size(), 1);
+
+    auto restored = table::deserialize(t.serialize());
+    BOOST_REQUIRE_EQUAL(restored.size(), 1);
+    auto o = restored.check(batch(2, 10, 10));
+    BOOST_REQUIRE(o.v == verdict::duplicate);
+    BOOST_REQUIRE_EQUAL(o.last_offset, model::offset(29));
+    BOOST_REQUIRE(restored.check(batch(2, 20, 10)).v == verdict::accept);
+    BOOST_REQUIRE(
+      restored.check(batch(1, 10, 10)).v == verdict::unknown_producer);
+}
+
+BOOST_AUTO_TEST_CASE(ongoing_transactions_bound_the_stable_offset) {
+    using cluster::control_record_type;
+    table t;
+    BOOST_REQUIRE(!t.first_ongoing_offset());
+    t.apply_transactional(1, model::offset(10));
+    t.apply_transactional(2, model::offset(20));
+    // later batches of the same transaction
+    t.apply_transactional(1, model::offset(30));
+    BOOST_REQUIRE_EQUAL(*t.first_ongoing_offset(), model::offset(10));
+
+    t.apply_marker(1, control_record_type::commit, model::offset(40));
+    BOOST_REQUIRE_EQUAL(*t.first_ongoing_offset(), model::offset(20));
+    t.apply_marker(2, control_record_type::abort, model::offset(50));
+    BOOST_REQUIRE(!t.first_ongoing_offset());
+    // a replayed marker is ignored
+    t.apply_marker(2, control_record_type::abort, model::offset(50));
+    BOOST_REQUIRE_EQUAL(
+      t.aborted_transactions(model::offset(0), model::offset(100)).size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(aborted_transactions_of_a_range) {
+    using cluster::control_record_type;
+    table t;
+    // [10, 20], [15, 40] and [50, 60] aborted, [25, 30] committed
+    t.apply_transactional(1, model::offset(10));
+    t.apply_transactional(2, model::offset(15));
+    t.apply_marker(1, control_record_type::abort, model::offset(20));
+    t.apply_transactional(1, model::offset(25));
+    t.apply_marker(1, control_record_type::commit, model::offset(30));
+    t.apply_marker(2, control_record_type::abort, model::offset(40));
+    t.apply_transactional(3, model::offset(50));
+    t.apply_marker(3, control_record_type::abort, model::offset(60));
+
+    auto in = [&t](int64_t from, int64_t to) {
+        std::vector<int64_t> ids;
+        for (auto& a : t.aborted_transactions(
+               model::offset(from), model::offset(to))) {
+            ids.push_back(a.producer_id);
+        }
+        return ids;
+    };
+    BOOST_REQUIRE(in(0, 9).empty());
+    BOOST_REQUIRE((in(0, 12) == std::vector<int64_t>{1}));
+    BOOST_REQUIRE((in(21, 45) == std::vector<int64_t>{2}));
+    BOOST_REQUIRE((in(18, 100) == std::vector<int64_t>{1, 2, 3}));
+    BOOST_REQUIRE(in(61, 100).empty());
+
+    t.evict(model::offset(30));
+    BOOST_REQUIRE((in(0, 100) == std::vector<int64_t>{2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_roundtrip_with_transactions) {
+    using cluster::control_record_type;
+    table t;
+    t.apply(batch(1, 0, 10), model::offset(9));
+    t.apply_transactional(1, model::offset(0));
+    t.apply(batch(2, 0, 10), model::offset(19));
+    t.apply_transactional(2, model::offset(10));
+    t.apply_marker(2, control_record_type::abort, model::offset(20));
+
+    auto restored = table::deserialize(t.serialize());
+    BOOST_REQUIRE_EQUAL(*restored.first_ongoing_offset(), model::offset(0));
+    auto aborted = restored.aborted_transactions(
+      model::offset(0), model::offset(100));
+    BOOST_REQUIRE_EQUAL(aborted.size(), 1);
+    BOOST_REQUIRE_EQUAL(aborted[0].producer_id, 2);
+    BOOST_REQUIRE_EQUAL(aborted[0].first_offset, model::offset(10));
+    BOOST_REQUIRE_EQUAL(aborted[0].last_offset, model::offset(20));
+}
@@ -31,6 +31,9 @@ SEASTAR_THREAD_TEST_CASE(topic_config_rt_test) {
     cfg.segment_size = std::optional<size_t>(1_GiB);
     cfg.retention_bytes = tristate<size_t>{};
     cfg.retention_duration = tristate<std::chrono::milliseconds>(10h);
+    cfg.flush_ms = 100ms;
+    cfg.flush_bytes = 1_MiB;
+    cfg.in_memory = true;
 
     auto d = serialize_roundtrip_rpc(std::move(cfg));
 
@@ -48,6 +51,9 @@ SEASTAR_THREAD_TEST_CASE(topic_config_rt_test) {
       model::compaction_strategy::offset, d.compaction_strategy);
     BOOST_CHECK(10h == d.retention_duration.value());
     BOOST_REQUIRE_EQUAL(tristate<size_t>{}, d.retention_bytes);
+    BOOST_CHECK(100ms == d.flush_ms);
+    BOOST_REQUIRE_EQUAL(d.flush_bytes, 1_MiB);
+    BOOST_CHECK(d.in_memory);
 }
 
 SEASTAR_THREAD_TEST_CASE(broker_metadata_rt_test) {
@@ -0,0 +1,52 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE cluster
+#include "cluster/shard_balancer.h"
+#include "model/fundamental.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using sb = cluster::shard_balancer;
+
+static sb::partition_load load(int p, ss::shard_id shard, uint64_t bytes) {
+    return sb::partition_load{
+      .ntp = model::ntp(
+        model::ns("test_ns"), model::topic("tp"), model::partition_id(p)),
+      .shard = shard,
+      .bytes = bytes};
+}
+
+BOOST_AUTO_TEST_CASE(balanced_cores_do_not_move) {
+    std::vector<sb::partition_load> loads{
+      load(0, 0, 100), load(1, 1, 90), load(2, 2, 110)};
+    BOOST_REQUIRE(!sb::plan(loads, 3, 50));
+}
+
+BOOST_AUTO_TEST_CASE(moves_partition_narrowing_the_gap_to_idlest_core) {
+    std::vector<sb::partition_load> loads{
+      load(0, 0, 1000), load(1, 0, 200), load(2, 1, 800), load(3, 2, 700)};
+    // moving partition 0 would only swap the busiest and the idlest cores
+    auto m = sb::plan(loads, 3, 25);
+    BOOST_REQUIRE(m);
+    BOOST_REQUIRE_EQUAL(m->ntp.tp.partition, model::partition_id(1));
+    BOOST_REQUIRE_EQUAL(m->target, ss::shard_id(2));
+}
+
+BOOST_AUTO_TEST_CASE(single_hot_partition_does_not_move) {
+    std::vector<sb::partition_load> loads{load(0, 0, 1000)};
+    BOOST_REQUIRE(!sb::plan(loads, 2, 50));
+}
+
+BOOST_AUTO_TEST_CASE(single_core_does_not_move) {
+    std::vector<sb::partition_load> loads{load(0, 0, 1000), load(1, 0, 10)};
+    BOOST_REQUIRE(!sb::plan(loads, 1, 50));
+}
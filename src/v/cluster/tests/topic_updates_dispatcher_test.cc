@@ -200,3 +200,63 @@ FIXTURE_TEST(
         ->partition_capacity(),
       node_initial_capacity(4) - (1 + 12 + 2));
 }
+
+FIXTURE_TEST(test_applying_snapshot, topic_table_updates_dispatcher_fixture) {
+    create_topics();
+    auto snapshot = dispatcher.make_snapshot();
+    BOOST_REQUIRE(snapshot.has_value());
+    auto snapshot_offset = dispatcher.last_applied();
+    auto restored = reflection::from_iobuf<cluster::controller_snapshot>(
+      reflection::to_iobuf(std::move(*snapshot)));
+    BOOST_REQUIRE_EQUAL(restored.topics.size(), 3);
+
+    // the log moves on past the snapshot
+    dispatcher
+      .apply_update(serialize_cmd(cluster::delete_topic_cmd(
+                                    make_tp_ns("test_tp_2"),
+                                    make_tp_ns("test_tp_2")))
+                      .get0())
+      .get0();
+    dispatcher
+      .apply_update(
+        serialize_cmd(make_create_topic_cmd("test_tp_4", 2, 1)).get0())
+      .get0();
+
+    dispatcher.apply_snapshot(snapshot_offset, std::move(restored)).get0();
+    BOOST_REQUIRE_EQUAL(dispatcher.last_applied(), snapshot_offset);
+
+    auto md = table.local().all_topics_metadata();
+    std::sort(
+      md.begin(),
+      md.end(),
+      [](const model::topic_metadata& a, const model::topic_metadata& b) {
+          return a.tp_ns.tp < b.tp_ns.tp;
+      });
+    BOOST_REQUIRE_EQUAL(md.size(), 3);
+    BOOST_REQUIRE_EQUAL(md[0].tp_ns, make_tp_ns("test_tp_1"));
+    BOOST_REQUIRE_EQUAL(md[1].tp_ns, make_tp_ns("test_tp_2"));
+    BOOST_REQUIRE_EQUAL(md[1].partitions.size(), 12);
+    BOOST_REQUIRE_EQUAL(md[2].tp_ns, make_tp_ns("test_tp_3"));
+
+    // the allocations are those of the snapshot
+    BOOST_REQUIRE_EQUAL(
+      allocator.local()
+        .allocation_nodes()
+        .at(model::node_id(1))
+        ->partition_capacity(),
+      node_initial_capacity(8) - (1 + 12 + 3));
+
+    BOOST_REQUIRE_EQUAL(
+      allocator.local()
+        .allocation_nodes()
+        .at(model::node_id(2))
+        ->partition_capacity(),
+      node_initial_capacity(12) - (1 + 12 + 3));
+
+    BOOST_REQUIRE_EQUAL(
+      allocator.local()
+        .allocation_nodes()
+        .at(model::node_id(3))
+        ->partition_capacity(),
+      node_initial_capacity(4) - (1 + 12 + 2));
+}
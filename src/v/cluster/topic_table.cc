@@ -25,27 +25,38 @@ topic_table::transform_topics(Func&& f) const {
       std::cend(_topics),
       std::back_inserter(ret),
       [f = std::forward<Func>(f)](
-        const std::pair<model::topic_namespace, topic_configuration_assignment>&
-          p) { return f(p.second); });
+        const std::pair<const model::topic_namespace, topic_ptr>& p) {
+          return f(*p.second);
+      });
     return ret;
 }
 
 ss::future<std::error_code>
 topic_table::apply(create_topic_cmd cmd, model::offset offset) {
-    if (_topics.contains(cmd.key)) {
+    ss::lw_shared_ptr<const topic_configuration_assignment> topic
+      = ss::make_lw_shared<topic_configuration_assignment>(
+        std::move(cmd.value));
+    return apply_created(ss::make_foreign(std::move(topic)), offset);
+}
+
+ss::future<std::error_code>
+topic_table::apply_created(topic_ptr topic, model::offset offset) {
+    const auto& tp_ns = topic->cfg.tp_ns;
+    if (_topics.contains(tp_ns)) {
         // topic already exists
         return ss::make_ready_future<std::error_code>(
           errc::topic_already_exists);
     }
     // calculate delta
     delta d(offset);
-    d.topics.additions.push_back(cmd.value.cfg);
-    for (auto& pas : cmd.value.assignments) {
-        d.partitions.additions.emplace_back(cmd.value.cfg.tp_ns, pas);
+    d.topics.additions.push_back(topic->cfg);
+    for (auto& pas : topic->assignments) {
+        d.partitions.additions.emplace_back(tp_ns, pas);
     }
     _pending_deltas.push_back(std::move(d));
 
-    _topics.insert({cmd.key, std::move(cmd.value)});
+    bump_revision(tp_ns);
+    _topics.emplace(tp_ns, std::move(topic));
     notify_waiters();
     return ss::make_ready_future<std::error_code>(errc::success);
 }
@@ -61,11 +72,12 @@ ss::future<std::error_code>
 topic_table::apply(delete_topic_cmd cmd, model::offset offset) {
     if (auto tp = _topics.find(cmd.value); tp != _topics.end()) {
         delta d(offset);
-        d.topics.deletions.push_back(tp->second.cfg);
-        for (auto& p : tp->second.assignments) {
+        d.topics.deletions.push_back(tp->second->cfg);
+        for (auto& p : tp->second->assignments) {
             d.partitions.deletions.emplace_back(tp->first, p);
         }
         _pending_deltas.push_back(std::move(d));
+        _revisions.erase(tp->first);
         _topics.erase(tp);
         notify_waiters();
         return ss::make_ready_future<std::error_code>(errc::success);
@@ -73,36 +85,80 @@ topic_table::apply(delete_topic_cmd cmd, model::offset offset) {
     return ss::make_ready_future<std::error_code>(errc::topic_not_exists);
 }
 
-ss::future<std::error_code>
-topic_table::apply(move_partition_replicas_cmd cmd, model::offset o) {
+static std::vector<partition_assignment>::const_iterator find_assignment(
+  const topic_configuration_assignment& tp, model::partition_id id) {
+    return std::find_if(
+      tp.assignments.cbegin(),
+      tp.assignments.cend(),
+      [id](const partition_assignment& p_as) { return id == p_as.id; });
+}
+
+ss::lw_shared_ptr<const topic_configuration_assignment>
+topic_table::make_moved(const move_partition_replicas_cmd& cmd) const {
     auto tp = _topics.find(model::topic_namespace_view(cmd.key));
     if (tp == _topics.end()) {
-        return ss::make_ready_future<std::error_code>(errc::topic_not_exists);
+        return nullptr;
+    }
+    auto it = find_assignment(*tp->second, cmd.key.tp.partition);
+    if (it == tp->second->assignments.cend()) {
+        return nullptr;
     }
+    auto moved = ss::make_lw_shared<topic_configuration_assignment>(
+      *tp->second);
+    // replace partition replica set
+    moved->assignments[std::distance(tp->second->assignments.cbegin(), it)]
+      .replicas = cmd.value;
+    return moved;
+}
 
-    auto current_assignment_it = std::find_if(
-      tp->second.assignments.begin(),
-      tp->second.assignments.end(),
-      [p_id = cmd.key.tp.partition](partition_assignment& p_as) {
-          return p_id == p_as.id;
-      });
+ss::future<std::error_code>
+topic_table::apply(move_partition_replicas_cmd cmd, model::offset o) {
+    auto moved = make_moved(cmd);
+    if (!moved) {
+        const bool exists = _topics.contains(
+          model::topic_namespace_view(cmd.key));
+        return ss::make_ready_future<std::error_code>(
+          exists ? errc::partition_not_exists : errc::topic_not_exists);
+    }
+    return apply_moved(cmd.key, ss::make_foreign(std::move(moved)), o);
+}
 
-    if (current_assignment_it == tp->second.assignments.end()) {
+ss::future<std::error_code> topic_table::apply_moved(
+  const model::ntp& ntp, topic_ptr topic, model::offset o) {
+    auto tp = _topics.find(model::topic_namespace_view(ntp));
+    if (tp == _topics.end()) {
+        return ss::make_ready_future<std::error_code>(errc::topic_not_exists);
+    }
+    auto it = find_assignment(*topic, ntp.tp.partition);
+    if (it == topic->assignments.cend()) {
         return ss::make_ready_future<std::error_code>(
           errc::partition_not_exists);
     }
-    // replace partition replica set
-    current_assignment_it->replicas = cmd.value;
 
     // calculate deleta for backend
     delta d(o);
-    d.partitions.updates.emplace_back(tp->first, *current_assignment_it);
+    d.partitions.updates.emplace_back(tp->first, *it);
     _pending_deltas.push_back(std::move(d));
+    // swap in the updated topic
+    tp->second = std::move(topic);
+    bump_revision(tp->first);
     notify_waiters();
 
     return ss::make_ready_future<std::error_code>(errc::success);
 }
 
+void topic_table::bump_revision(const model::topic_namespace& tp_ns) {
+    _revisions.insert_or_assign(tp_ns, ++_revision);
+}
+
+uint64_t
+topic_table::topic_revision(model::topic_namespace_view tp_ns) const {
+    if (auto it = _revisions.find(tp_ns); it != _revisions.end()) {
+        return it->second;
+    }
+    return 0;
+}
+
 void topic_table::notify_waiters() {
     if (_waiters.empty()) {
         return;
@@ -161,7 +217,7 @@ std::vector<model::topic_namespace> topic_table::all_topics() const {
 std::optional<model::topic_metadata>
 topic_table::get_topic_metadata(model::topic_namespace_view tp) const {
     if (auto it = _topics.find(tp); it != _topics.end()) {
-        return it->second.get_metadata();
+        return it->second->get_metadata();
     }
     return {};
 }
@@ -169,7 +225,7 @@ topic_table::get_topic_metadata(model::topic_namespace_view tp) const {
 std::optional<topic_configuration>
 topic_table::get_topic_cfg(model::topic_namespace_view tp) const {
     if (auto it = _topics.find(tp); it != _topics.end()) {
-        return it->second.cfg;
+        return it->second->cfg;
     }
     return {};
 }
@@ -177,7 +233,7 @@ topic_table::get_topic_cfg(model::topic_namespace_view tp) const {
 std::optional<model::timestamp_type>
 topic_table::get_topic_timestamp_type(model::topic_namespace_view tp) const {
     if (auto it = _topics.find(tp); it != _topics.end()) {
-        return it->second.cfg.timestamp_type;
+        return it->second->cfg.timestamp_type;
     }
     return {};
 }
@@ -188,10 +244,16 @@ std::vector<model::topic_metadata> topic_table::all_topics_metadata() const {
     });
 }
 
+std::vector<topic_configuration_assignment>
+topic_table::all_topic_assignments() const {
+    return transform_topics(
+      [](const topic_configuration_assignment& td) { return td; });
+}
+
 bool topic_table::contains(
   model::topic_namespace_view topic, model::partition_id pid) const {
     if (auto it = _topics.find(topic); it != _topics.end()) {
-        const auto& partitions = it->second.assignments;
+        const auto& partitions = it->second->assignments;
         return std::any_of(
           partitions.cbegin(),
           partitions.cend(),
@@ -200,4 +262,19 @@ bool topic_table::contains(
     return false;
 }
 
+std::optional<partition_assignment> topic_table::get_partition_assignment(
+  model::topic_namespace_view topic, model::partition_id pid) const {
+    if (auto it = _topics.find(topic); it != _topics.end()) {
+        const auto& partitions = it->second->assignments;
+        auto p = std::find_if(
+          partitions.cbegin(),
+          partitions.cend(),
+          [&pid](const partition_assignment& pas) { return pas.id == pid; });
+        if (p != partitions.cend()) {
+            return *p;
+        }
+    }
+    return std::nullopt;
+}
+
 } // namespace cluster
@@ -17,13 +17,19 @@
 #include "model/fundamental.h"
 #include "utils/expiring_promise.h"
 
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/sharded.hh>
+
 #include <absl/container/flat_hash_map.h>
 
 namespace cluster {
 
 /// Topic table represent all topics configuration and partition assignments.
-/// The topic table is copied on each core to minimize cross core communication
-/// when requesting topic information. The topics table provides an API for
+/// The topic table is instantiated on each core to minimize cross core
+/// communication when requesting topic information. The topics themselves are
+/// immutable and may be shared by the tables of all cores: an update builds a
+/// new copy of the topic once, and each table swaps its pointer to it. The
+/// topics table provides an API for
 /// Kafka requests and delta API for controller backend. The delta API allows
 /// backend to wait for changes in topics table. Topics table is update directly
 /// from controller_stm. The table is always updated before any actions related
@@ -46,6 +52,11 @@ public:
         bool empty() const;
     };
 
+    /// A topic shared read only by the tables of all cores, released on the
+    /// core that built it
+    using topic_ptr = ss::foreign_ptr<
+      ss::lw_shared_ptr<const topic_configuration_assignment>>;
+
     bool is_batch_applicable(const model::record_batch& b) const {
         return b.header().type == topic_batch_type;
     }
@@ -63,6 +74,17 @@ public:
     ss::future<std::error_code>
       apply(move_partition_replicas_cmd, model::offset);
 
+    /// Applies a topic creation, or a partition move, whose topic was built
+    /// by the caller to be shared across cores
+    ss::future<std::error_code> apply_created(topic_ptr, model::offset);
+    ss::future<std::error_code>
+    apply_moved(const model::ntp&, topic_ptr, model::offset);
+
+    /// \brief The topic with the replicas of the partition replaced, to be
+    /// applied by apply_moved. Null if the partition does not exist.
+    ss::lw_shared_ptr<const topic_configuration_assignment>
+    make_moved(const move_partition_replicas_cmd&) const;
+
     ss::future<> stop();
 
     /// Delta API
@@ -97,12 +119,24 @@ public:
     /// Returns metadata of all topics.
     std::vector<model::topic_metadata> all_topics_metadata() const;
 
+    /// Returns configuration and partition assignments of all topics.
+    std::vector<topic_configuration_assignment> all_topic_assignments() const;
+
     /// Checks if it has given partition
     bool contains(model::topic_namespace_view, model::partition_id) const;
 
+    /// Returns the assignment of a partition, if it exists
+    std::optional<partition_assignment>
+      get_partition_assignment(model::topic_namespace_view, model::partition_id)
+        const;
+
     /// Returns partition leader
     std::optional<model::node_id> get_leader(const model::ntp&) const;
 
+    /// \brief a value that changes whenever the topic is created, deleted or
+    /// has its partitions reassigned. 0 if the topic does not exist
+    uint64_t topic_revision(model::topic_namespace_view) const;
+
     /// Updates partition leader and notify waiters if needed
     void update_partition_leader(
       const model::ntp&, model::term_id, std::optional<model::node_id>);
@@ -118,6 +152,7 @@ private:
     void deallocate_topic_partitions(const std::vector<partition_assignment>&);
 
     void notify_waiters();
+    void bump_revision(const model::topic_namespace&);
 
     template<typename Func>
     std::vector<std::invoke_result_t<Func, topic_configuration_assignment>>
@@ -125,11 +160,21 @@ private:
 
     absl::flat_hash_map<
       model::topic_namespace,
-      topic_configuration_assignment,
+      topic_ptr,
       model::topic_namespace_hash,
       model::topic_namespace_eq>
       _topics;
 
+    // revisions of the existing topics, drawn from a single counter so that a
+    // recreated topic never gets the revision of its previous incarnation
+    absl::flat_hash_map<
+      model::topic_namespace,
+      uint64_t,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>
+      _revisions;
+    uint64_t _revision{0};
+
     std::vector<delta> _pending_deltas;
     std::vector<std::unique_ptr<waiter>> _waiters;
     uint64_t _waiter_id{0};
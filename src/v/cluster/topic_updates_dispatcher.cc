@@ -13,6 +13,8 @@
 #include "model/metadata.h"
 #include "raft/types.h"
 
+#include <absl/container/flat_hash_map.h>
+
 #include <iterator>
 #include <system_error>
 #include <vector>
@@ -27,6 +29,7 @@ topic_updates_dispatcher::topic_updates_dispatcher(
 ss::future<std::error_code>
 topic_updates_dispatcher::apply_update(model::record_batch b) {
     auto base_offset = b.base_offset();
+    _applying = true;
     return deserialize(std::move(b), commands)
       .then([this, base_offset](auto cmd) {
           return ss::visit(
@@ -47,7 +50,7 @@ topic_updates_dispatcher::apply_update(model::record_batch b) {
                   });
             },
             [this, base_offset](create_topic_cmd create_cmd) {
-                return dispatch_updates_to_cores(create_cmd, base_offset)
+                return dispatch_created_topic(create_cmd, base_offset)
                   .then([this, create_cmd](std::error_code ec) {
                       if (ec == errc::success) {
                           update_allocations(create_cmd);
@@ -58,7 +61,7 @@ topic_updates_dispatcher::apply_update(model::record_batch b) {
             [this, base_offset](move_partition_replicas_cmd cmd) {
                 auto tp_md = _topic_table.local().get_topic_metadata(
                   model::topic_namespace_view(cmd.key));
-                return dispatch_updates_to_cores(cmd, base_offset)
+                return dispatch_moved_partition(cmd, base_offset)
                   .then([this, tp_md, cmd](std::error_code ec) {
                       if (!ec) {
                           vassert(
@@ -81,32 +84,157 @@ topic_updates_dispatcher::apply_update(model::record_batch b) {
                       return ec;
                   });
             });
+      })
+      .finally([this, last_offset = b.last_offset()] {
+          _applying = false;
+          _last_applied = last_offset;
       });
 }
 
-template<typename Cmd>
-ss::future<std::error_code> do_apply(
-  ss::shard_id shard,
-  Cmd cmd,
-  ss::sharded<topic_table>& table,
-  model::offset o) {
-    return table.invoke_on(
-      shard, [cmd = std::move(cmd), o](topic_table& local_table) mutable {
-          return local_table.apply(std::move(cmd), o);
+std::optional<controller_snapshot>
+topic_updates_dispatcher::make_snapshot() const {
+    if (_applying) {
+        return std::nullopt;
+    }
+    return controller_snapshot{
+      .topics = _topic_table.local().all_topic_assignments()};
+}
+
+static bool same_assignments(
+  const std::vector<partition_assignment>& a,
+  const std::vector<partition_assignment>& b) {
+    return std::equal(
+      a.begin(),
+      a.end(),
+      b.begin(),
+      b.end(),
+      [](const partition_assignment& l, const partition_assignment& r) {
+          return l.group == r.group && l.id == r.id && l.replicas == r.replicas;
+      });
+}
+
+ss::future<> topic_updates_dispatcher::apply_snapshot(
+  model::offset o, controller_snapshot snapshot) {
+    absl::flat_hash_map<
+      model::topic_namespace,
+      topic_configuration_assignment,
+      model::topic_namespace_hash,
+      model::topic_namespace_eq>
+      wanted;
+    for (auto& t : snapshot.topics) {
+        auto tp_ns = t.cfg.tp_ns;
+        wanted.emplace(std::move(tp_ns), std::move(t));
+    }
+    std::vector<model::topic_namespace> to_delete;
+    for (auto& t : _topic_table.local().all_topic_assignments()) {
+        auto it = wanted.find(t.cfg.tp_ns);
+        if (it == wanted.end()) {
+            to_delete.push_back(t.cfg.tp_ns);
+        } else if (!same_assignments(t.assignments, it->second.assignments)) {
+            to_delete.push_back(t.cfg.tp_ns);
+        } else {
+            wanted.erase(it);
+        }
+    }
+    _applying = true;
+    return ss::do_with(
+             std::move(to_delete),
+             std::move(wanted),
+             [this, o](auto& to_delete, auto& wanted) {
+                 return ss::do_for_each(
+                          to_delete,
+                          [this, o](model::topic_namespace& tp_ns) {
+                              return delete_for_snapshot(std::move(tp_ns), o);
+                          })
+                   .then([this, o, &wanted] {
+                       return ss::do_for_each(wanted, [this, o](auto& t) {
+                           return create_for_snapshot(std::move(t.second), o);
+                       });
+                   });
+             })
+      .finally([this, o] {
+          _applying = false;
+          _last_applied = o;
+      });
+}
+
+ss::future<> topic_updates_dispatcher::delete_for_snapshot(
+  model::topic_namespace tp_ns, model::offset o) {
+    auto tp_md = _topic_table.local().get_topic_metadata(tp_ns);
+    return dispatch_updates_to_cores(delete_topic_cmd(tp_ns, tp_ns), o)
+      .then([this, tp_md = std::move(tp_md)](std::error_code ec) {
+          if (ec == errc::success && tp_md) {
+              deallocate_topic(*tp_md);
+          }
+      });
+}
+
+ss::future<> topic_updates_dispatcher::create_for_snapshot(
+  topic_configuration_assignment t, model::offset o) {
+    auto tp_ns = t.cfg.tp_ns;
+    create_topic_cmd cmd(std::move(tp_ns), std::move(t));
+    return dispatch_created_topic(cmd, o).then(
+      [this, cmd](std::error_code ec) {
+          if (ec == errc::success) {
+              update_allocations(cmd);
+          }
       });
 }
 
 template<typename Cmd>
 ss::future<std::error_code>
 topic_updates_dispatcher::dispatch_updates_to_cores(Cmd cmd, model::offset o) {
+    return dispatch_to_cores([cmd = std::move(cmd), o](ss::shard_id) {
+        return [cmd, o](topic_table& local_table) mutable {
+            return local_table.apply(std::move(cmd), o);
+        };
+    });
+}
+
+ss::future<std::error_code> topic_updates_dispatcher::dispatch_created_topic(
+  create_topic_cmd cmd, model::offset o) {
+    ss::lw_shared_ptr<const topic_configuration_assignment> topic
+      = ss::make_lw_shared<topic_configuration_assignment>(
+        std::move(cmd.value));
+    return dispatch_to_cores([topic = std::move(topic), o](ss::shard_id) {
+        // the reference is taken here, on the core owning the topic
+        return [topic = ss::make_foreign(topic), o](
+                 topic_table& local_table) mutable {
+            return local_table.apply_created(std::move(topic), o);
+        };
+    });
+}
+
+ss::future<std::error_code> topic_updates_dispatcher::dispatch_moved_partition(
+  move_partition_replicas_cmd cmd, model::offset o) {
+    auto topic = _topic_table.local().make_moved(cmd);
+    if (!topic) {
+        // every table fails the same way
+        return dispatch_updates_to_cores(std::move(cmd), o);
+    }
+    return dispatch_to_cores(
+      [ntp = std::move(cmd.key), topic = std::move(topic), o](ss::shard_id) {
+          return [ntp, topic = ss::make_foreign(topic), o](
+                   topic_table& local_table) mutable {
+              return local_table.apply_moved(ntp, std::move(topic), o);
+          };
+      });
+}
+
+template<typename MakeApply>
+ss::future<std::error_code>
+topic_updates_dispatcher::dispatch_to_cores(MakeApply make_apply) {
     using ret_t = std::vector<std::error_code>;
     return ss::do_with(
-      ret_t{}, [this, cmd = std::move(cmd), o](ret_t& ret) mutable {
+      ret_t{},
+      std::move(make_apply),
+      [this](ret_t& ret, MakeApply& make_apply) mutable {
           ret.reserve(ss::smp::count);
           return ss::parallel_for_each(
                    boost::irange(0, (int)ss::smp::count),
-                   [this, &ret, cmd = std::move(cmd), o](int shard) mutable {
-                       return do_apply(shard, cmd, _topic_table, o)
+                   [this, &ret, &make_apply](int shard) mutable {
+                       return _topic_table
+                         .invoke_on(shard, make_apply(shard))
                          .then([&ret](std::error_code r) { ret.push_back(r); });
                    })
             .then([&ret] { return std::move(ret); })
@@ -23,7 +23,8 @@ namespace cluster {
 // from controller state machine and propagating updates to topic state core
 // local copies. The dispatcher handles partition_allocator updates. The
 // partition allocator exists only on core 0 hence the updates have to be
-// executed at the same core.
+// executed at the same core. Created and updated topics are built once, on
+// the dispatcher core, and shared read only by the tables of every core.
 //
 //
 //                                  +----------------+        +------------+
@@ -62,9 +63,31 @@ public:
         return batch.header().type == topic_batch_type;
     }
 
+    /// \brief Replaces the topics with those of the snapshot. The topics the
+    /// snapshot dropped, or that were recreated or moved since, are deleted
+    /// before the missing ones are created, so that the backends reconcile
+    /// the partitions as when applying the log.
+    ss::future<> apply_snapshot(model::offset, controller_snapshot);
+
+    /// \brief The state up to last_applied(), none while an update is being
+    /// applied
+    std::optional<controller_snapshot> make_snapshot() const;
+    model::offset last_applied() const { return _last_applied; }
+
 private:
     template<typename Cmd>
     ss::future<std::error_code> dispatch_updates_to_cores(Cmd, model::offset);
+    /// MakeApply(shard) returns the update to apply to the table of the shard
+    template<typename MakeApply>
+    ss::future<std::error_code> dispatch_to_cores(MakeApply);
+    ss::future<std::error_code>
+      dispatch_created_topic(create_topic_cmd, model::offset);
+    ss::future<std::error_code>
+      dispatch_moved_partition(move_partition_replicas_cmd, model::offset);
+
+    ss::future<> delete_for_snapshot(model::topic_namespace, model::offset);
+    ss::future<>
+      create_for_snapshot(topic_configuration_assignment, model::offset);
 
     void update_allocations(const create_topic_cmd&);
     void deallocate_topic(const model::topic_metadata&);
@@ -74,6 +97,9 @@ private:
 
     ss::sharded<partition_allocator>& _partition_allocator;
     ss::sharded<topic_table>& _topic_table;
+    // offset of the last update applied to all the tables
+    model::offset _last_applied;
+    bool _applying{false};
 };
 
 } // namespace cluster
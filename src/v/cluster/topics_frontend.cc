@@ -317,9 +317,49 @@ ss::future<std::error_code> topics_frontend::move_partition_replicas(
   model::ntp ntp,
   std::vector<model::broker_shard> new_replica_set,
   model::timeout_clock::time_point tout) {
+    auto leader = _leaders.local().get_leader(controller_ntp);
+    if (!leader) {
+        return ss::make_ready_future<std::error_code>(
+          errc::no_leader_controller);
+    }
+    if (leader != _self) {
+        return dispatch_move_to_leader(
+          leader.value(),
+          std::move(ntp),
+          std::move(new_replica_set),
+          tout - model::timeout_clock::now());
+    }
     move_partition_replicas_cmd cmd(std::move(ntp), std::move(new_replica_set));
 
-    return replicate_and_wait(std::move(cmd), tout);
+    return replicate_and_wait(std::move(cmd), tout)
+      .then([](std::error_code ec) { return std::error_code(map_errc(ec)); });
+}
+
+ss::future<std::error_code> topics_frontend::dispatch_move_to_leader(
+  model::node_id leader,
+  model::ntp ntp,
+  std::vector<model::broker_shard> replicas,
+  model::timeout_clock::duration timeout) {
+    vlog(clusterlog.trace, "Dispatching move of {} to {}", ntp, leader);
+    return _connections.local()
+      .with_node_client<cluster::controller_client_protocol>(
+        _self,
+        ss::this_shard_id(),
+        leader,
+        [ntp = std::move(ntp), replicas = std::move(replicas), timeout](
+          controller_client_protocol cp) mutable {
+            return cp.move_partition_replicas(
+              move_partition_replicas_request{
+                std::move(ntp), std::move(replicas), timeout},
+              rpc::client_opts(model::timeout_clock::now() + timeout));
+        })
+      .then(&rpc::get_ctx_data<move_partition_replicas_reply>)
+      .then([](result<move_partition_replicas_reply> r) {
+          if (r.has_error()) {
+              return std::error_code(map_errc(r.error()));
+          }
+          return std::error_code(r.value().result);
+      });
 }
 
 } // namespace cluster
@@ -77,6 +77,12 @@ private:
       std::vector<topic_configuration>,
       model::timeout_clock::duration);
 
+    ss::future<std::error_code> dispatch_move_to_leader(
+      model::node_id,
+      model::ntp,
+      std::vector<model::broker_shard>,
+      model::timeout_clock::duration);
+
     ss::future<> update_leaders_with_estimates(std::vector<ntp_leader>);
     // returns true if the topic name is valid
     static bool validate_topic_name(const model::topic_namespace&);
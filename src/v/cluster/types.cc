@@ -36,7 +36,8 @@ storage::ntp_config topic_configuration::make_ntp_config(
                          || segment_size || retention_bytes.has_value()
                          || retention_bytes.is_disabled()
                          || retention_duration.has_value()
-                         || retention_duration.is_disabled();
+                         || retention_duration.is_disabled() || compression
+                         || flush_ms || flush_bytes || in_memory;
     std::unique_ptr<storage::ntp_config::default_overrides> overrides = nullptr;
 
     if (has_overrides) {
@@ -46,7 +47,11 @@ storage::ntp_config topic_configuration::make_ntp_config(
             .compaction_strategy = compaction_strategy,
             .segment_size = segment_size,
             .retention_bytes = retention_bytes,
-            .retention_time = retention_duration});
+            .retention_time = retention_duration,
+            .compression = compression,
+            .flush_ms = flush_ms,
+            .flush_bytes = flush_bytes,
+            .in_memory = in_memory});
     }
     return storage::ntp_config(
       model::ntp(tp_ns.ns, tp_ns.tp, p_id),
@@ -81,7 +86,8 @@ std::ostream& operator<<(std::ostream& o, const topic_configuration& cfg) {
       "{{ topic: {}, partition_count: {}, replication_factor: {}, compression: "
       "{}, cleanup_policy_bitflags: {}, compaction_strategy: {}, "
       "retention_bytes: {}, "
-      "retention_duration_hours: {}, segment_size: {}, timestamp_type: {} }}",
+      "retention_duration_hours: {}, segment_size: {}, timestamp_type: {}, "
+      "flush_ms: {}, flush_bytes: {}, in_memory: {} }}",
       cfg.tp_ns,
       cfg.partition_count,
       cfg.replication_factor,
@@ -91,7 +97,10 @@ std::ostream& operator<<(std::ostream& o, const topic_configuration& cfg) {
       cfg.retention_bytes,
       cfg.retention_duration,
       cfg.segment_size,
-      cfg.timestamp_type);
+      cfg.timestamp_type,
+      cfg.flush_ms,
+      cfg.flush_bytes,
+      cfg.in_memory);
 
     return o;
 }
@@ -126,7 +135,10 @@ void adl<cluster::topic_configuration>::to(
       t.timestamp_type,
       t.segment_size,
       t.retention_bytes,
-      t.retention_duration);
+      t.retention_duration,
+      t.flush_ms,
+      t.flush_bytes,
+      t.in_memory);
 }
 
 cluster::topic_configuration
@@ -149,6 +161,9 @@ adl<cluster::topic_configuration>::from(iobuf_parser& in) {
     cfg.retention_bytes = adl<tristate<size_t>>{}.from(in);
     cfg.retention_duration = adl<tristate<std::chrono::milliseconds>>{}.from(
       in);
+    cfg.flush_ms = adl<std::optional<std::chrono::milliseconds>>{}.from(in);
+    cfg.flush_bytes = adl<std::optional<size_t>>{}.from(in);
+    cfg.in_memory = adl<bool>{}.from(in);
 
     return cfg;
 }
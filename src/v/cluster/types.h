@@ -105,6 +105,15 @@ struct topic_configuration {
     tristate<size_t> retention_bytes;
     tristate<std::chrono::milliseconds> retention_duration;
 
+    // Kafka flush.ms and redpanda flush.bytes, the replicas of a topic
+    // with either set acknowledge appends before flushing them
+    std::optional<std::chrono::milliseconds> flush_ms;
+    std::optional<size_t> flush_bytes;
+
+    // redpanda.storage.type=memory, the replicas keep the log of the topic
+    // in memory only, see storage::ntp_config::is_in_memory()
+    bool in_memory{false};
+
     friend std::ostream& operator<<(std::ostream&, const topic_configuration&);
 };
 
@@ -140,6 +149,16 @@ struct create_topics_reply {
     std::vector<topic_configuration> configs;
 };
 
+struct move_partition_replicas_request {
+    model::ntp ntp;
+    std::vector<model::broker_shard> replicas;
+    model::timeout_clock::duration timeout;
+};
+
+struct move_partition_replicas_reply {
+    errc result;
+};
+
 template<typename T>
 struct patch {
     std::vector<T> additions;
@@ -170,6 +189,16 @@ struct configuration_invariants {
     operator<<(std::ostream&, const configuration_invariants&);
 };
 
+/// The controller state of the topics, written into the snapshots of the
+/// controller log. The members of the cluster are those of the raft0
+/// configuration, which the snapshots already keep.
+struct controller_snapshot {
+    static constexpr int8_t current_version = 0;
+
+    int8_t version{current_version};
+    std::vector<topic_configuration_assignment> topics;
+};
+
 class configuration_invariants_changed final : public std::exception {
 public:
     explicit configuration_invariants_changed(
@@ -10,17 +10,66 @@
 #include "compression/compression.h"
 
 #include "compression/internal/gzip_compressor.h"
+#include "compression/internal/igzip_compressor.h"
 #include "compression/internal/lz4_frame_compressor.h"
 #include "compression/internal/snappy_java_compressor.h"
 #include "compression/internal/zstd_compressor.h"
+#include "compression/logger.h"
+#include "compression/stream_zstd.h"
+#include "vlog.h"
+
+#include <seastar/core/with_scheduling_group.hh>
 
 namespace compression {
+static ss::scheduling_group& async_scheduling_group() {
+    static thread_local ss::scheduling_group sg;
+    return sg;
+}
+
+// igzip, when built in, takes over gzip on the cpus it is faster on. the
+// choice is made once, on the first gzip batch of the shard
+#ifdef REDPANDA_HAVE_ISAL
+static bool use_igzip() {
+    static thread_local const bool use = [] {
+        const bool supported = internal::igzip_compressor::supported();
+        vlog(
+          complog.debug,
+          "gzip backend: {}",
+          supported ? "igzip" : "zlib, the cpu lacks the igzip kernels");
+        return supported;
+    }();
+    return use;
+}
+#endif
+
+static iobuf gzip_compress(const iobuf& io) {
+#ifdef REDPANDA_HAVE_ISAL
+    if (use_igzip()) {
+        return internal::igzip_compressor::compress(io);
+    }
+#endif
+    return internal::gzip_compressor::compress(io);
+}
+
+static iobuf gzip_uncompress(const iobuf& io) {
+#ifdef REDPANDA_HAVE_ISAL
+    if (use_igzip()) {
+        return internal::igzip_compressor::uncompress(io);
+    }
+#endif
+    return internal::gzip_compressor::uncompress(io);
+}
+
+void compressor::set_scheduling_group(ss::scheduling_group sg) {
+    async_scheduling_group() = sg;
+}
+
 iobuf compressor::compress(const iobuf& io, type t) {
     switch (t) {
     case type::none:
         throw std::runtime_error("compressor: nothing to compress for 'none'");
     case type::gzip:
-        return internal::gzip_compressor::compress(io);
+        return gzip_compress(io);
     case type::snappy:
         return internal::snappy_java_compressor::compress(io);
     case type::lz4:
@@ -40,7 +89,7 @@ iobuf compressor::uncompress(const iobuf& io, type t) {
         throw std::runtime_error(
           "compressor: nothing to uncompress for 'none'");
     case type::gzip:
-        return internal::gzip_compressor::uncompress(io);
+        return gzip_uncompress(io);
     case type::snappy:
         return internal::snappy_java_compressor::uncompress(io);
     case type::lz4:
@@ -51,4 +100,28 @@ iobuf compressor::uncompress(const iobuf& io, type t) {
     __builtin_unreachable();
 }
 
+ss::future<iobuf> compressor::compress_async(const iobuf& io, type t) {
+    if (io.size_bytes() < async_threshold) {
+        return ss::futurize_invoke([&io, t] { return compress(io, t); });
+    }
+    return ss::with_scheduling_group(async_scheduling_group(), [&io, t] {
+        if (t == type::zstd) {
+            return stream_zstd::compress_async(io);
+        }
+        return ss::make_ready_future<iobuf>(compress(io, t));
+    });
+}
+
+ss::future<iobuf> compressor::uncompress_async(const iobuf& io, type t) {
+    if (io.size_bytes() < async_threshold) {
+        return ss::futurize_invoke([&io, t] { return uncompress(io, t); });
+    }
+    return ss::with_scheduling_group(async_scheduling_group(), [&io, t] {
+        if (t == type::zstd) {
+            return stream_zstd::uncompress_async(io);
+        }
+        return ss::make_ready_future<iobuf>(uncompress(io, t));
+    });
+}
+
 } // namespace compression
@@ -12,6 +12,12 @@
 #pragma once
 #include "bytes/iobuf.h"
 #include "model/compression.h"
+#include "seastarx.h"
+#include "units.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/scheduling.hh>
+
 namespace compression {
 
 using type = model::compression;
@@ -19,8 +25,23 @@ using type = model::compression;
 // the defaults for all compressors. In the future, we can make these
 // a virtual interface so we can instantiate them
 struct compressor {
+    /// inputs from this size are handled asynchronously by the *_async
+    /// variants, smaller ones are handled in place
+    static constexpr size_t async_threshold = 256_KiB;
+
     static iobuf compress(const iobuf&, type);
     static iobuf uncompress(const iobuf&, type);
+
+    /// \brief as compress() and uncompress(), but large inputs are handled
+    /// in the compression scheduling group, and zstd ones in chunks with
+    /// preemption points in between, so that they do not stall the shard.
+    /// The input must outlive the returned future
+    static ss::future<iobuf> compress_async(const iobuf&, type);
+    static ss::future<iobuf> uncompress_async(const iobuf&, type);
+
+    /// \brief sets the scheduling group of the *_async variants on this
+    /// shard, the default scheduling group otherwise
+    static void set_scheduling_group(ss::scheduling_group);
 };
 
 } // namespace compression
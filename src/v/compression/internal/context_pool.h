@@ -0,0 +1,91 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace compression::internal {
+
+/**
+ * Reusable contexts of a codec, owned by a shard.
+ *
+ * Creating a context allocates its workspace, which for zstd and gzip is far
+ * larger than most batches. The contexts of a shard are kept once released
+ * and reset by the codec before each use. `Ptr` is the owning pointer of a
+ * context.
+ */
+template<typename Ptr>
+class context_pool {
+public:
+    /// returns the context to the pool when destroyed
+    class handle {
+    public:
+        handle(context_pool* pool, Ptr ctx) noexcept
+          : _pool(pool)
+          , _ctx(std::move(ctx)) {}
+        handle(const handle&) = delete;
+        handle& operator=(const handle&) = delete;
+        handle(handle&& o) noexcept
+          : _pool(std::exchange(o._pool, nullptr))
+          , _ctx(std::move(o._ctx)) {}
+        handle& operator=(handle&&) = delete;
+        ~handle() {
+            if (_pool) {
+                _pool->release(std::move(_ctx));
+            }
+        }
+
+        auto get() const { return _ctx.get(); }
+
+    private:
+        context_pool* _pool;
+        Ptr _ctx;
+    };
+
+    explicit context_pool(size_t max_cached) noexcept
+      : _max_cached(max_cached) {}
+
+    /// \brief a released context, or a new one made with make() if there is
+    /// none
+    template<typename Factory>
+    handle acquire(Factory&& make) {
+        if (_free.empty()) {
+            return handle(this, make());
+        }
+        auto ctx = std::move(_free.back());
+        _free.pop_back();
+        return handle(this, std::move(ctx));
+    }
+
+    size_t cached() const { return _free.size(); }
+
+private:
+    void release(Ptr ctx) noexcept {
+        if (_free.size() < _max_cached) {
+            // reserved on first use, so that releasing does not allocate
+            if (_free.capacity() < _max_cached) {
+                try {
+                    _free.reserve(_max_cached);
+                } catch (...) {
+                    return;
+                }
+            }
+            _free.push_back(std::move(ctx));
+        }
+    }
+
+    size_t _max_cached;
+    std::vector<Ptr> _free;
+};
+
+} // namespace compression::internal
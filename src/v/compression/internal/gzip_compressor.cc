@@ -10,12 +10,14 @@
 #include "compression/internal/gzip_compressor.h"
 
 #include "bytes/bytes.h"
+#include "compression/internal/context_pool.h"
 #include "vassert.h"
 
 #include <seastar/core/temporary_buffer.hh>
 
 #include <fmt/core.h>
 
+#include <memory>
 #include <zlib.h>
 
 namespace compression::internal {
@@ -39,88 +41,116 @@ inline z_stream default_zstream() {
     return zs;
 }
 
+// the state of a stream is allocated by deflateInit2 and inflateInit2 and
+// points back to the stream, which therefore lives on the heap
+struct deflate_stream_deleter {
+    void operator()(z_stream* zs) const {
+        deflateEnd(zs);
+        delete zs; // NOLINT
+    }
+};
+struct inflate_stream_deleter {
+    void operator()(z_stream* zs) const {
+        inflateEnd(zs);
+        delete zs; // NOLINT
+    }
+};
+using deflate_stream = std::unique_ptr<z_stream, deflate_stream_deleter>;
+using inflate_stream = std::unique_ptr<z_stream, inflate_stream_deleter>;
+
+static deflate_stream make_deflate_stream() {
+    auto zs = std::make_unique<z_stream>(default_zstream());
+    throw_if_zstream_error(
+      "gzip compress deflateInit2 error: {}",
+      deflateInit2(
+        zs.get(),
+        Z_DEFAULT_COMPRESSION,
+        Z_DEFLATED,
+        15 + 16,
+        8 /*512 byte*/,
+        Z_DEFAULT_STRATEGY));
+    return deflate_stream(zs.release());
+}
+
+static inflate_stream make_inflate_stream() {
+    auto zs = std::make_unique<z_stream>(default_zstream());
+    throw_if_zstream_error(
+      "gzip error with inflateInit2:{}", inflateInit2(zs.get(), 15 + 32));
+    return inflate_stream(zs.release());
+}
+
+using deflate_pool = context_pool<deflate_stream>;
+using inflate_pool = context_pool<inflate_stream>;
+
+static deflate_pool& deflate_streams() {
+    // compressions of a shard do not interleave, one stream is enough
+    static thread_local deflate_pool pool(1);
+    return pool;
+}
+
+static inflate_pool& inflate_streams() {
+    // uncompressing uses two streams, one of them to size the output
+    static thread_local inflate_pool pool(2);
+    return pool;
+}
+
 class gzip_compression_codec {
 public:
-    gzip_compression_codec() noexcept = default;
+    gzip_compression_codec()
+      : _stream(deflate_streams().acquire(make_deflate_stream)) {}
     gzip_compression_codec(const gzip_compression_codec&) = delete;
     gzip_compression_codec& operator=(const gzip_compression_codec&) = delete;
     gzip_compression_codec(gzip_compression_codec&&) noexcept = delete;
     gzip_compression_codec&
     operator=(gzip_compression_codec&&) noexcept = delete;
+    ~gzip_compression_codec() = default;
 
     void reset() {
-        vassert(!_init, "Double initialized gzip decompression codec");
-        _stream = default_zstream();
         throw_if_zstream_error(
-          "gzip compress deflateInit2 error: {}",
-          deflateInit2(
-            &_stream,
-            Z_DEFAULT_COMPRESSION,
-            Z_DEFLATED,
-            15 + 16,
-            8 /*512 byte*/,
-            Z_DEFAULT_STRATEGY));
-        _init = true;
-    }
-    z_stream& stream() { return _stream; }
-    ~gzip_compression_codec() {
-        if (_init) {
-            _init = false;
-            deflateEnd(&_stream);
-        }
+          "gzip compress deflateReset error: {}", deflateReset(&stream()));
     }
+    z_stream& stream() { return *_stream.get(); }
 
 private:
-    bool _init{false};
-    z_stream _stream;
+    deflate_pool::handle _stream;
 };
 class gzip_decompression_codec {
 public:
-    gzip_decompression_codec(const char* src, size_t src_size) noexcept
+    gzip_decompression_codec(const char* src, size_t src_size)
       : _input(src)
-      , _input_size(src_size) {}
+      , _input_size(src_size)
+      , _stream(inflate_streams().acquire(make_inflate_stream)) {}
     gzip_decompression_codec(const gzip_decompression_codec&) = delete;
     gzip_decompression_codec& operator=(const gzip_decompression_codec&)
       = delete;
     gzip_decompression_codec(gzip_decompression_codec&&) noexcept = delete;
     gzip_decompression_codec&
     operator=(gzip_decompression_codec&&) noexcept = delete;
+    ~gzip_decompression_codec() = default;
 
     void reset() {
-        vassert(!_init, "Double initialized gzip decompression codec");
-        _stream = default_zstream();
+        z_stream& zs = stream();
+        throw_if_zstream_error(
+          "gzip error with inflateReset:{}", inflateReset(&zs));
         // zlib is not const-correct
         // NOLINTNEXTLINE
-        _stream.next_in = (unsigned char*)_input;
-        _stream.avail_in = _input_size;
+        zs.next_in = (unsigned char*)_input;
+        zs.avail_in = _input_size;
+        // last, the header is forgotten by inflateReset
         throw_if_zstream_error(
-          "gzip error with inflateInit2:{}", inflateInit2(&_stream, 15 + 32));
-        // marking init must happen before gzip header
-        _init = true;
-
-        // last
-        throw_if_zstream_error(
-          "gzip inflateGetHeader error:{}", inflateGetHeader(&_stream, &_hdr));
+          "gzip inflateGetHeader error:{}", inflateGetHeader(&zs, &_hdr));
     }
 
     void inflate_to(char* output, size_t out_size);
 
-    ~gzip_decompression_codec() {
-        if (_init) {
-            _init = false;
-            inflateEnd(&_stream);
-        }
-    }
-
-    z_stream& stream() { return _stream; }
+    z_stream& stream() { return *_stream.get(); }
     gz_header& header() { return _hdr; }
 
 private:
-    bool _init{false};
     const char* _input;
     size_t _input_size;
-    gz_header _hdr; // needed for gzip
-    z_stream _stream;
+    gz_header _hdr{}; // needed for gzip
+    inflate_pool::handle _stream;
 };
 
 iobuf gzip_compressor::compress(const iobuf& b) {
@@ -153,7 +183,7 @@ iobuf gzip_compressor::compress(const iobuf& b) {
             throw_if_zstream_error("gzip error finishing compression: {}", ret);
         }
         obuf.trim(def.stream().total_out);
-        // trigger deflateEnd
+        // returns the stream to the shard
     }
     iobuf ret;
     ret.append(std::move(obuf));
@@ -167,9 +197,9 @@ void gzip_decompression_codec::inflate_to(char* output, size_t out_size) {
     auto out = reinterpret_cast<unsigned char*>(output);
     do {
         // NOLINTNEXTLINE
-        _stream.next_out = out + consumed_bytes;
-        _stream.avail_out = out_size - consumed_bytes;
-        code = inflate(&_stream, Z_NO_FLUSH);
+        stream().next_out = out + consumed_bytes;
+        stream().avail_out = out_size - consumed_bytes;
+        code = inflate(&stream(), Z_NO_FLUSH);
         switch (code) {
         case Z_STREAM_ERROR:
         case Z_NEED_DICT:
@@ -179,8 +209,8 @@ void gzip_decompression_codec::inflate_to(char* output, size_t out_size) {
         default: /*do nothing*/;
         }
         /* Advance output pointer (in pass 2). */
-        consumed_bytes = out_size - _stream.avail_out - consumed_bytes;
-    } while (_stream.avail_out == 0 && code != Z_STREAM_END);
+        consumed_bytes = out_size - stream().avail_out - consumed_bytes;
+    } while (stream().avail_out == 0 && code != Z_STREAM_END);
 }
 
 static ss::temporary_buffer<char>
@@ -0,0 +1,201 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "compression/internal/igzip_compressor.h"
+
+#include "compression/internal/context_pool.h"
+#include "units.h"
+
+#include <seastar/core/temporary_buffer.hh>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <memory>
+
+#include <isa-l/igzip_lib.h>
+
+namespace compression::internal {
+
+[[noreturn]] [[gnu::cold]] static void
+throw_igzip_error(const char* fmt, int ret) {
+    throw std::runtime_error(fmt::format(fmt, ret));
+}
+
+// level 1 is the one igzip is tuned for on every cpu: it compresses a few
+// times faster than zlib at its default level, for a slightly lower ratio
+static constexpr uint32_t deflate_level = 1;
+static constexpr uint32_t deflate_level_buf_size = ISAL_DEF_LVL1_DEFAULT;
+
+// the output is built in fragments of at most this size, as igzip does not
+// bound the size of its output upfront
+static constexpr size_t max_output_fragment = 128_KiB;
+
+struct deflate_context {
+    isal_zstream stream;
+    std::unique_ptr<uint8_t[]> level_buf; // NOLINT
+};
+using deflate_context_ptr = std::unique_ptr<deflate_context>;
+using inflate_context_ptr = std::unique_ptr<inflate_state>;
+
+static deflate_context_ptr make_deflate_context() {
+    auto ctx = std::make_unique<deflate_context>();
+    ctx->level_buf = std::make_unique<uint8_t[]>( // NOLINT
+      deflate_level_buf_size);
+    return ctx;
+}
+
+static inflate_context_ptr make_inflate_context() {
+    return std::make_unique<inflate_state>();
+}
+
+static context_pool<deflate_context_ptr>& deflate_contexts() {
+    static thread_local context_pool<deflate_context_ptr> pool(1);
+    return pool;
+}
+
+static context_pool<inflate_context_ptr>& inflate_contexts() {
+    // igzip inflates in one pass, without sizing the output first
+    static thread_local context_pool<inflate_context_ptr> pool(1);
+    return pool;
+}
+
+bool igzip_compressor::supported() {
+#if defined(__x86_64__)
+    return __builtin_cpu_supports("sse4.1");
+#elif defined(__aarch64__)
+    return true; // the kernels use neon, which every aarch64 cpu has
+#else
+    return false;
+#endif
+}
+
+// appends the filled part of the fragment to the output, and makes the next
+// fragment the target of the codec
+class output_fragments {
+public:
+    explicit output_fragments(size_t hint)
+      : _fragment_size(std::clamp<size_t>(hint, 4_KiB, max_output_fragment)) {
+    }
+
+    template<typename Stream>
+    void next(Stream& s) {
+        flush(s);
+        _buf = ss::temporary_buffer<char>(_fragment_size);
+        // NOLINTNEXTLINE
+        s.next_out = reinterpret_cast<uint8_t*>(_buf.get_write());
+        s.avail_out = _buf.size();
+        // the output is usually larger than the first guess
+        _fragment_size = std::min(_fragment_size * 2, max_output_fragment);
+    }
+
+    template<typename Stream>
+    iobuf release(Stream& s) && {
+        flush(s);
+        return std::move(_out);
+    }
+
+private:
+    template<typename Stream>
+    void flush(Stream& s) {
+        if (_buf.empty()) {
+            return;
+        }
+        _buf.trim(_buf.size() - s.avail_out);
+        if (!_buf.empty()) {
+            _out.append(std::move(_buf));
+        }
+        _buf = {};
+        s.avail_out = 0;
+    }
+
+    size_t _fragment_size;
+    ss::temporary_buffer<char> _buf;
+    iobuf _out;
+};
+
+iobuf igzip_compressor::compress(const iobuf& b) {
+    auto ctx = deflate_contexts().acquire(make_deflate_context);
+    isal_zstream& s = ctx.get()->stream;
+    isal_deflate_init(&s);
+    s.level = deflate_level;
+    s.level_buf = ctx.get()->level_buf.get();
+    s.level_buf_size = deflate_level_buf_size;
+    s.gzip_flag = IGZIP_GZIP;
+    s.flush = NO_FLUSH;
+    s.avail_out = 0;
+
+    output_fragments out(b.size_bytes());
+    auto deflate_input = [&s, &out](const char* src, size_t n, bool last) {
+        // igzip is not const correct
+        // NOLINTNEXTLINE
+        s.next_in = reinterpret_cast<uint8_t*>(const_cast<char*>(src));
+        s.avail_in = n;
+        s.end_of_stream = last ? 1 : 0;
+        do {
+            if (s.avail_out == 0) {
+                out.next(s);
+            }
+            if (int ret = isal_deflate(&s); ret != COMP_OK) {
+                throw_igzip_error("igzip error compressing chunk: {}", ret);
+            }
+        } while (s.avail_in > 0
+                 || (last && s.internal_state.state != ZSTATE_END));
+    };
+
+    size_t left = b.size_bytes();
+    for (auto& io : b) {
+        if (io.size() == 0) {
+            continue;
+        }
+        left -= io.size();
+        deflate_input(io.get(), io.size(), left == 0);
+    }
+    if (b.size_bytes() == 0) {
+        // still a valid, empty, gzip member
+        deflate_input(nullptr, 0, true);
+    }
+    return std::move(out).release(s);
+}
+
+iobuf igzip_compressor::uncompress(const iobuf& b) {
+    auto ctx = inflate_contexts().acquire(make_inflate_context);
+    inflate_state& s = *ctx.get();
+    isal_inflate_init(&s);
+    s.crc_flag = ISAL_GZIP;
+    s.avail_out = 0;
+
+    // kafka batches compress to a third of their size or so
+    output_fragments out(3 * b.size_bytes());
+    for (auto& io : b) {
+        // NOLINTNEXTLINE
+        s.next_in = reinterpret_cast<uint8_t*>(const_cast<char*>(io.get()));
+        s.avail_in = io.size();
+        // once the input is consumed, the codec may still hold output if it
+        // ran out of space
+        while ((s.avail_in > 0 || s.avail_out == 0)
+               && s.block_state != ISAL_BLOCK_FINISH) {
+            if (s.avail_out == 0) {
+                out.next(s);
+            }
+            if (int ret = isal_inflate(&s); ret < 0) {
+                throw_igzip_error("igzip uncompress error: {}", ret);
+            }
+        }
+        if (s.block_state == ISAL_BLOCK_FINISH) {
+            break;
+        }
+    }
+    if (s.block_state != ISAL_BLOCK_FINISH) {
+        throw std::runtime_error("igzip uncompress error: truncated input");
+    }
+    return std::move(out).release(s);
+}
+
+} // namespace compression::internal
@@ -0,0 +1,27 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/iobuf.h"
+namespace compression::internal {
+
+/// gzip with the igzip codec of ISA-L, which (de)compresses several times
+/// faster than zlib on the cpus its SIMD kernels run on. Only built when
+/// ISA-L is found, see REDPANDA_HAVE_ISAL.
+struct igzip_compressor {
+    /// \brief whether the cpu runs the SIMD kernels of igzip, without which
+    /// it is no faster than zlib
+    static bool supported();
+
+    static iobuf compress(const iobuf&);
+    static iobuf uncompress(const iobuf&);
+};
+} // namespace compression::internal
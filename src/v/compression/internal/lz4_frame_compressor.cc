@@ -10,6 +10,7 @@
 #include "compression/internal/lz4_frame_compressor.h"
 
 #include "bytes/bytes.h"
+#include "compression/internal/context_pool.h"
 #include "compression/logger.h"
 #include "static_deleter_fn.h"
 #include "units.h"
@@ -66,8 +67,23 @@ static lz4_decompression_ctx make_decompression_context() {
     return lz4_decompression_ctx(c);
 }
 
+using lz4_cctx_pool = context_pool<lz4_compression_ctx>;
+using lz4_dctx_pool = context_pool<lz4_decompression_ctx>;
+
+static lz4_cctx_pool& compression_contexts() {
+    // compressions of a shard do not interleave, one context is enough
+    static thread_local lz4_cctx_pool pool(1);
+    return pool;
+}
+
+static lz4_dctx_pool& decompression_contexts() {
+    static thread_local lz4_dctx_pool pool(1);
+    return pool;
+}
+
 iobuf lz4_frame_compressor::compress(const iobuf& b) {
-    auto ctx_ptr = make_compression_context();
+    // LZ4F_compressBegin resets the context
+    auto ctx_ptr = compression_contexts().acquire(make_compression_context);
     LZ4F_compressionContext_t ctx = ctx_ptr.get();
     /* Required by Kafka */
     LZ4F_preferences_t prefs;
@@ -121,8 +137,11 @@ compute_frame_uncompressed_size(size_t frame_size, size_t original) {
 }
 
 static iobuf do_uncompressed(const char* src, const size_t src_size) {
-    auto ctx_ptr = make_decompression_context();
+    auto ctx_ptr = decompression_contexts().acquire(
+      make_decompression_context);
     LZ4F_decompressionContext_t ctx = ctx_ptr.get();
+    // a previous use may have failed midway
+    LZ4F_resetDecompressionContext(ctx);
     LZ4F_frameInfo_t fi;
     size_t in_sz = src_size;
     LZ4F_errorCode_t code = LZ4F_getFrameInfo(ctx, &fi, src, &in_sz);
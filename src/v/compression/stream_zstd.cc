@@ -11,14 +11,20 @@
 
 #include "bytes/bytes.h"
 #include "bytes/details/io_allocation_size.h"
+#include "compression/internal/context_pool.h"
 #include "compression/logger.h"
 #include "likely.h"
 #include "units.h"
 #include "vlog.h"
 
+#include <seastar/core/do_with.hh>
+#include <seastar/core/loop.hh>
+
 #include <fmt/format.h>
 
 #include <array>
+#include <memory>
+#include <optional>
 #include <zstd.h>
 #include <zstd_errors.h>
 
@@ -33,36 +39,61 @@ static void throw_if_error(size_t rc) {
     }
 }
 
-void stream_zstd::reset_compressor() {
-    _compress.reset(ZSTD_createCCtx());
-    if (!_compress) {
+/// context initialized within a workspace of a fixed size, see
+/// ZSTD_initStaticCCtx
+template<typename Ctx>
+struct zstd_arena_ctx {
+    std::unique_ptr<char[]> arena;
+    Ctx* ctx{nullptr};
+
+    Ctx* get() const { return ctx; }
+};
+
+using zstd_cctx_pool = internal::context_pool<zstd_arena_ctx<ZSTD_CCtx>>;
+using zstd_dctx_pool = internal::context_pool<zstd_arena_ctx<ZSTD_DCtx>>;
+
+static zstd_arena_ctx<ZSTD_CCtx> make_compress_ctx() {
+    // enough for any input size at the default level, which is what
+    // stream_zstd compresses with
+    const size_t size = ZSTD_estimateCStreamSize(ZSTD_CLEVEL_DEFAULT);
+    std::unique_ptr<char[]> arena(new char[size]);
+    ZSTD_CCtx* ctx = ZSTD_initStaticCCtx(arena.get(), size);
+    if (!ctx) {
         throw std::bad_alloc{};
     }
-}
-stream_zstd::zstd_compress_ctx& stream_zstd::compressor() {
-    if (!_compress) {
-        reset_compressor();
-    }
-    return _compress;
+    return {std::move(arena), ctx};
 }
 
-void stream_zstd::reset_decompressor() {
-    _decompress.reset(ZSTD_createDCtx());
-    if (!_decompress) {
+static zstd_arena_ctx<ZSTD_DCtx> make_decompress_ctx() {
+    const size_t size = ZSTD_estimateDStreamSize(
+      size_t(1) << stream_zstd::max_pooled_window_log);
+    std::unique_ptr<char[]> arena(new char[size]);
+    ZSTD_DCtx* ctx = ZSTD_initStaticDCtx(arena.get(), size);
+    if (!ctx) {
         throw std::bad_alloc{};
     }
+    throw_if_error(ZSTD_DCtx_setParameter(
+      ctx, ZSTD_d_windowLogMax, stream_zstd::max_pooled_window_log));
+    return {std::move(arena), ctx};
 }
 
-stream_zstd::zstd_decompress_ctx& stream_zstd::decompressor() {
-    if (!_decompress) {
-        reset_decompressor();
-    }
-    return _decompress;
+static zstd_cctx_pool& compress_contexts() {
+    // only the async variants interleave, and rarely so the pool keeps a
+    // single context
+    static thread_local zstd_cctx_pool pool(1);
+    return pool;
+}
+
+static zstd_dctx_pool& decompress_contexts() {
+    static thread_local zstd_dctx_pool pool(1);
+    return pool;
 }
 
 iobuf stream_zstd::do_compress(const iobuf& x) {
-    reset_compressor();
-    ZSTD_CCtx* ctx = compressor().get();
+    auto handle = compress_contexts().acquire(make_compress_ctx);
+    ZSTD_CCtx* ctx = handle.get();
+    // a previous use may have failed midway
+    throw_if_error(ZSTD_CCtx_reset(ctx, ZSTD_reset_session_and_parameters));
     // NOTE: always enable content size. **decompression** depends on this
     throw_if_error(ZSTD_CCtx_setPledgedSrcSize(ctx, x.size_bytes()));
     // zstd requires linearized memory
@@ -128,13 +159,19 @@ size_t decompression_step(const iobuf& x) {
     return std::min(64_KiB, ret);
 }
 
-iobuf stream_zstd::do_uncompress(const iobuf& x) {
-    if (unlikely(x.empty())) {
-        throw std::runtime_error(
-          "Asked to stream_zstd::uncompress empty buffer");
-    }
-    reset_decompressor();
-    ZSTD_DCtx* dctx = decompressor().get();
+// whether the window of the first frame fits the contexts of the shard
+static bool fits_pooled_context(const iobuf& x) {
+    auto consumer = iobuf::iterator_consumer(x.cbegin(), x.cend());
+    std::array<char, ZSTD_FRAMEHEADERSIZE_MAX> hdr_arr{};
+    const size_t n = std::min(hdr_arr.size(), x.size_bytes());
+    consumer.consume_to(n, hdr_arr.data());
+    ZSTD_frameHeader hdr;
+    return ZSTD_getFrameHeader(&hdr, hdr_arr.data(), n) == 0
+           && hdr.windowSize
+                <= (uint64_t(1) << stream_zstd::max_pooled_window_log);
+}
+
+static iobuf uncompress_with(ZSTD_DCtx* dctx, const iobuf& x) {
     iobuf ret;
     ss::temporary_buffer<char> obuf(decompression_step(x));
     ZSTD_outBuffer out = {
@@ -157,4 +194,158 @@ iobuf stream_zstd::do_uncompress(const iobuf& x) {
     return ret;
 }
 
+iobuf stream_zstd::do_uncompress(const iobuf& x) {
+    if (unlikely(x.empty())) {
+        throw std::runtime_error(
+          "Asked to stream_zstd::uncompress empty buffer");
+    }
+    if (unlikely(!fits_pooled_context(x))) {
+        zstd_decompress_ctx dctx(ZSTD_createDCtx());
+        if (!dctx) {
+            throw std::bad_alloc{};
+        }
+        return uncompress_with(dctx.get(), x);
+    }
+    auto handle = decompress_contexts().acquire(make_decompress_ctx);
+    // a previous use may have failed midway
+    throw_if_error(ZSTD_DCtx_reset(handle.get(), ZSTD_reset_session_only));
+    return uncompress_with(handle.get(), x);
+}
+
+
+namespace {
+/// slices of at most async_chunk_size bytes of the fragments of an iobuf
+class chunk_cursor {
+public:
+    static constexpr size_t async_chunk_size = 128_KiB;
+
+    explicit chunk_cursor(const iobuf& x)
+      : _it(x.cbegin())
+      , _end(x.cend()) {}
+
+    /// \brief the next slice, false once there is none left
+    bool next(const char*& data, size_t& size) {
+        while (_it != _end && _pos == _it->size()) {
+            ++_it;
+            _pos = 0;
+        }
+        if (_it == _end) {
+            return false;
+        }
+        size = std::min(async_chunk_size, _it->size() - _pos);
+        data = _it->get() + _pos; // NOLINT
+        _pos += size;
+        return true;
+    }
+
+private:
+    iobuf::const_iterator _it;
+    iobuf::const_iterator _end;
+    size_t _pos{0};
+};
+
+struct async_compress_state {
+    zstd_cctx_pool::handle ctx;
+    ss::temporary_buffer<char> obuf;
+    ZSTD_outBuffer out;
+    chunk_cursor chunks;
+};
+
+struct async_uncompress_state {
+    // set when the frame does not fit the contexts of the shard
+    stream_zstd::zstd_decompress_ctx owned;
+    std::optional<zstd_dctx_pool::handle> pooled;
+    ZSTD_DCtx* ctx;
+    iobuf ret;
+    ss::temporary_buffer<char> obuf;
+    ZSTD_outBuffer out;
+    chunk_cursor chunks;
+};
+} // namespace
+
+ss::future<iobuf> stream_zstd::compress_async(const iobuf& x) {
+    auto handle = compress_contexts().acquire(make_compress_ctx);
+    ZSTD_CCtx* ctx = handle.get();
+    throw_if_error(ZSTD_CCtx_reset(ctx, ZSTD_reset_session_and_parameters));
+    throw_if_error(ZSTD_CCtx_setPledgedSrcSize(ctx, x.size_bytes()));
+    ss::temporary_buffer<char> obuf(ZSTD_compressBound(x.size_bytes()));
+    ZSTD_outBuffer out = {
+      .dst = obuf.get_write(), .size = obuf.size(), .pos = 0};
+    return ss::do_with(
+      async_compress_state{
+        .ctx = std::move(handle),
+        .obuf = std::move(obuf),
+        .out = out,
+        .chunks = chunk_cursor(x)},
+      [](async_compress_state& st) {
+          return ss::repeat([&st] {
+                     const char* data = nullptr;
+                     size_t size = 0;
+                     if (!st.chunks.next(data, size)) {
+                         return ss::stop_iteration::yes;
+                     }
+                     ZSTD_inBuffer in = {.src = data, .size = size, .pos = 0};
+                     while (in.pos != in.size) {
+                         throw_if_error(ZSTD_compressStream2(
+                           st.ctx.get(), &st.out, &in, ZSTD_e_continue));
+                     }
+                     return ss::stop_iteration::no;
+                 })
+            .then([&st] {
+                throw_if_error(ZSTD_endStream(st.ctx.get(), &st.out));
+                st.obuf.trim(st.out.pos);
+                iobuf ret;
+                ret.append(std::move(st.obuf));
+                return ret;
+            });
+      });
+}
+
+ss::future<iobuf> stream_zstd::uncompress_async(const iobuf& x) {
+    if (unlikely(x.empty())) {
+        return ss::make_exception_future<iobuf>(std::runtime_error(
+          "Asked to stream_zstd::uncompress_async empty buffer"));
+    }
+    async_uncompress_state st{.chunks = chunk_cursor(x)};
+    if (unlikely(!fits_pooled_context(x))) {
+        st.owned.reset(ZSTD_createDCtx());
+        if (!st.owned) {
+            throw std::bad_alloc{};
+        }
+        st.ctx = st.owned.get();
+    } else {
+        st.pooled.emplace(
+          decompress_contexts().acquire(make_decompress_ctx));
+        st.ctx = st.pooled->get();
+        throw_if_error(ZSTD_DCtx_reset(st.ctx, ZSTD_reset_session_only));
+    }
+    st.obuf = ss::temporary_buffer<char>(decompression_step(x));
+    st.out = {.dst = st.obuf.get_write(), .size = st.obuf.size(), .pos = 0};
+    return ss::do_with(std::move(st), [](async_uncompress_state& st) {
+        return ss::repeat([&st] {
+                   const char* data = nullptr;
+                   size_t size = 0;
+                   if (!st.chunks.next(data, size)) {
+                       return ss::stop_iteration::yes;
+                   }
+                   ZSTD_inBuffer in = {.src = data, .size = size, .pos = 0};
+                   while (in.pos != in.size) {
+                       auto err = ZSTD_decompressStream(st.ctx, &st.out, &in);
+                       if (in.pos != in.size && st.out.pos == st.out.size) {
+                           st.ret.append(st.obuf.get(), st.obuf.size());
+                           st.out.pos = 0;
+                       } else {
+                           throw_if_error(err);
+                       }
+                   }
+                   return ss::stop_iteration::no;
+               })
+          .then([&st] {
+              st.obuf.trim(st.out.pos);
+              st.ret.append(std::move(st.obuf));
+              return std::move(st.ret);
+          });
+    });
+}
+
 } // namespace compression
@@ -11,8 +11,11 @@
 
 #pragma once
 #include "bytes/iobuf.h"
+#include "seastarx.h"
 #include "static_deleter_fn.h"
 
+#include <seastar/core/future.hh>
+
 #include <memory>
 #include <zstd.h>
 
@@ -33,17 +36,21 @@ public:
     iobuf compress(iobuf&& b) { return do_compress(b); }
     iobuf uncompress(iobuf&& b) { return do_uncompress(b); }
 
+    /// \brief as compress() and uncompress(), a chunk of the input at a
+    /// time with preemption points in between. The input must outlive the
+    /// returned future
+    static ss::future<iobuf> compress_async(const iobuf&);
+    static ss::future<iobuf> uncompress_async(const iobuf&);
+
+    /// \brief frames whose window is larger than this are decompressed with
+    /// a context of their own rather than one of the shard
+    static constexpr size_t max_pooled_window_log = 23;
+
 private:
+    // the contexts are those of the shard, kept between calls, see
+    // internal::context_pool
     iobuf do_compress(const iobuf&);
     iobuf do_uncompress(const iobuf&);
-
-    void reset_compressor();
-    void reset_decompressor();
-    zstd_compress_ctx& compressor();
-    zstd_decompress_ctx& decompressor();
-
-    zstd_compress_ctx _compress{nullptr};
-    zstd_decompress_ctx _decompress{nullptr};
 };
 
 } // namespace compression
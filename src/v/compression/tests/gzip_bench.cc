@@ -0,0 +1,60 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "compression/internal/gzip_compressor.h"
+#include "compression/internal/igzip_compressor.h"
+#include "random/generators.h"
+#include "units.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+// zlib against igzip, on batches made of a few distinct records so that they
+// compress about as well as the usual kafka payloads
+static iobuf gen(size_t data_size) {
+    const auto data = random_generators::gen_alphanum_string(4_KiB);
+    iobuf ret;
+    while (ret.size_bytes() < data_size) {
+        const auto step = std::min(data_size - ret.size_bytes(), data.size());
+        ret.append(data.data(), step);
+    }
+    return ret;
+}
+
+template<typename Codec>
+static void compress_test(size_t data_size) {
+    auto o = gen(data_size);
+    perf_tests::start_measuring_time();
+    perf_tests::do_not_optimize(Codec::compress(o));
+    perf_tests::stop_measuring_time();
+}
+
+template<typename Codec>
+static void uncompress_test(size_t data_size) {
+    // both read the same input, compressed with zlib as most clients do
+    auto o = compression::internal::gzip_compressor::compress(gen(data_size));
+    perf_tests::start_measuring_time();
+    perf_tests::do_not_optimize(Codec::uncompress(o));
+    perf_tests::stop_measuring_time();
+}
+
+using zlib = compression::internal::gzip_compressor;
+
+PERF_TEST(gzip_zlib_16kb, compress) { compress_test<zlib>(16_KiB); }
+PERF_TEST(gzip_zlib_16kb, uncompress) { uncompress_test<zlib>(16_KiB); }
+PERF_TEST(gzip_zlib_1mb, compress) { compress_test<zlib>(1_MiB); }
+PERF_TEST(gzip_zlib_1mb, uncompress) { uncompress_test<zlib>(1_MiB); }
+
+#ifdef REDPANDA_HAVE_ISAL
+using igzip = compression::internal::igzip_compressor;
+
+PERF_TEST(gzip_igzip_16kb, compress) { compress_test<igzip>(16_KiB); }
+PERF_TEST(gzip_igzip_16kb, uncompress) { uncompress_test<igzip>(16_KiB); }
+PERF_TEST(gzip_igzip_1mb, compress) { compress_test<igzip>(1_MiB); }
+PERF_TEST(gzip_igzip_1mb, uncompress) { uncompress_test<igzip>(1_MiB); }
+#endif
@@ -7,14 +7,23 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "bytes/bytes.h"
 #include "compression/stream_zstd.h"
 #include "random/generators.h"
 #include "vassert.h"
 
+#include <seastar/core/memory.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/testing/perf_tests.hh>
 
+#include <fmt/format.h>
+
+#include <memory>
+#include <unordered_set>
+
+#include <zstd.h>
+
 static inline iobuf gen(const size_t data_size) {
     const auto data = random_generators::gen_alphanum_string(512);
     iobuf ret;
@@ -52,3 +61,127 @@ PERF_TEST(streaming_zstd_1mb, compress) { compress_test(1 << 20); }
 PERF_TEST(streaming_zstd_1mb, uncompress) { return uncompress_test(1 << 20); }
 PERF_TEST(streaming_zstd_10mb, compress) { compress_test(10 << 20); }
 PERF_TEST(streaming_zstd_10mb, uncompress) { return uncompress_test(10 << 20); }
+
+// Batches of compacted topics are small and each of them is decompressed, so
+// the cost of creating the contexts shows next to the (de)compression itself.
+// The fresh_* tests create their contexts on each call, as stream_zstd did
+// before it used the contexts of the shard.
+
+// prints once the allocations of an operation
+class alloc_report {
+public:
+    explicit alloc_report(const char* name)
+      : _name(name)
+      , _start(ss::memory::stats().mallocs()) {}
+    alloc_report(const alloc_report&) = delete;
+    alloc_report& operator=(const alloc_report&) = delete;
+    ~alloc_report() {
+        static thread_local std::unordered_set<const char*> reported;
+        if (reported.insert(_name).second) {
+            fmt::print(
+              "{}: {} allocations\n",
+              _name,
+              ss::memory::stats().mallocs() - _start);
+        }
+    }
+
+private:
+    const char* _name;
+    uint64_t _start;
+};
+
+inline iobuf fresh_compress(const iobuf& b) {
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> ctx(
+      ZSTD_createCCtx(), &ZSTD_freeCCtx);
+    auto in = iobuf_to_bytes(b);
+    ss::temporary_buffer<char> obuf(ZSTD_compressBound(in.size()));
+    auto n = ZSTD_compress2(
+      ctx.get(), obuf.get_write(), obuf.size(), in.data(), in.size());
+    vassert(!ZSTD_isError(n), "zstd error: {}", ZSTD_getErrorName(n));
+    obuf.trim(n);
+    iobuf ret;
+    ret.append(std::move(obuf));
+    return ret;
+}
+
+inline iobuf fresh_uncompress(const iobuf& b, size_t size) {
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> ctx(
+      ZSTD_createDCtx(), &ZSTD_freeDCtx);
+    auto in = iobuf_to_bytes(b);
+    ss::temporary_buffer<char> obuf(size);
+    auto n = ZSTD_decompressDCtx(
+      ctx.get(), obuf.get_write(), obuf.size(), in.data(), in.size());
+    vassert(!ZSTD_isError(n), "zstd error: {}", ZSTD_getErrorName(n));
+    obuf.trim(n);
+    iobuf ret;
+    ret.append(std::move(obuf));
+    return ret;
+}
+
+inline void pooled_compress_test(const char* name, size_t data_size) {
+    auto o = gen(data_size);
+    compression::stream_zstd fn;
+    perf_tests::start_measuring_time();
+    {
+        alloc_report r(name);
+        perf_tests::do_not_optimize(fn.compress(o));
+    }
+    perf_tests::stop_measuring_time();
+}
+
+inline void fresh_compress_test(const char* name, size_t data_size) {
+    auto o = gen(data_size);
+    perf_tests::start_measuring_time();
+    {
+        alloc_report r(name);
+        perf_tests::do_not_optimize(fresh_compress(o));
+    }
+    perf_tests::stop_measuring_time();
+}
+
+inline void pooled_uncompress_test(const char* name, size_t data_size) {
+    compression::stream_zstd fn;
+    auto o = fn.compress(gen(data_size));
+    perf_tests::start_measuring_time();
+    {
+        alloc_report r(name);
+        perf_tests::do_not_optimize(fn.uncompress(o));
+    }
+    perf_tests::stop_measuring_time();
+}
+
+inline void fresh_uncompress_test(const char* name, size_t data_size) {
+    compression::stream_zstd fn;
+    auto o = fn.compress(gen(data_size));
+    perf_tests::start_measuring_time();
+    {
+        alloc_report r(name);
+        perf_tests::do_not_optimize(fresh_uncompress(o, data_size));
+    }
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(pooled_zstd_4kb, compress) {
+    pooled_compress_test("pooled_zstd_4kb.compress", 4 << 10);
+}
+PERF_TEST(fresh_zstd_4kb, compress) {
+    fresh_compress_test("fresh_zstd_4kb.compress", 4 << 10);
+}
+PERF_TEST(pooled_zstd_4kb, uncompress) {
+    pooled_uncompress_test("pooled_zstd_4kb.uncompress", 4 << 10);
+}
+PERF_TEST(fresh_zstd_4kb, uncompress) {
+    fresh_uncompress_test("fresh_zstd_4kb.uncompress", 4 << 10);
+}
+PERF_TEST(pooled_zstd_64kb, compress) {
+    pooled_compress_test("pooled_zstd_64kb.compress", 64 << 10);
+}
+PERF_TEST(fresh_zstd_64kb, compress) {
+    fresh_compress_test("fresh_zstd_64kb.compress", 64 << 10);
+}
+PERF_TEST(pooled_zstd_64kb, uncompress) {
+    pooled_uncompress_test("pooled_zstd_64kb.uncompress", 64 << 10);
+}
+PERF_TEST(fresh_zstd_64kb, uncompress) {
+    fresh_uncompress_test("fresh_zstd_64kb.uncompress", 64 << 10);
+}
@@ -7,7 +7,9 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "compression/compression.h"
 #include "compression/internal/gzip_compressor.h"
+#include "compression/internal/igzip_compressor.h"
 #include "compression/internal/lz4_frame_compressor.h"
 #include "compression/internal/snappy_java_compressor.h"
 #include "compression/internal/zstd_compressor.h"
@@ -85,3 +87,70 @@ SEASTAR_THREAD_TEST_CASE(gzip_test) {
     using fn = compression::internal::gzip_compressor;
     roundtrip_compression(fn::compress, fn::uncompress);
 }
+
+#ifdef REDPANDA_HAVE_ISAL
+SEASTAR_THREAD_TEST_CASE(igzip_test) {
+    using fn = compression::internal::igzip_compressor;
+    using zlib = compression::internal::gzip_compressor;
+    roundtrip_compression(fn::compress, fn::uncompress);
+    // both backends read the gzip of the other, e.g. of a client or of a
+    // node with another backend
+    roundtrip_compression(fn::compress, zlib::uncompress);
+    roundtrip_compression(zlib::compress, fn::uncompress);
+
+    // output larger than a fragment, from an input of several fragments
+    iobuf buf;
+    for (int i = 0; i < 64; ++i) {
+        buf.append(gen(10_KiB));
+    }
+    BOOST_CHECK_EQUAL(fn::uncompress(zlib::compress(buf)), buf);
+    BOOST_CHECK_EQUAL(zlib::uncompress(fn::compress(buf)), buf);
+}
+#endif
+
+SEASTAR_THREAD_TEST_CASE(contexts_are_reusable_after_failures) {
+    // the contexts of the shard are kept after a use that stopped midway
+    auto truncated = [](iobuf b) {
+        b.trim_back(b.size_bytes() / 2);
+        return b;
+    };
+    using compression::compressor;
+    for (auto t :
+         {compression::type::zstd,
+          compression::type::lz4,
+          compression::type::gzip}) {
+        for (size_t i : sizes) {
+            if (i < 512) {
+                continue;
+            }
+            iobuf buf = gen(i);
+            auto cbuf = compressor::compress(buf, t);
+            try {
+                // not every codec detects the truncation
+                (void)compressor::uncompress(truncated(cbuf.copy()), t);
+            } catch (const std::exception&) {
+            }
+            BOOST_CHECK_EQUAL(compressor::uncompress(cbuf, t), buf);
+        }
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(async_roundtrip) {
+    using compression::compressor;
+    for (auto t :
+         {compression::type::zstd,
+          compression::type::lz4,
+          compression::type::gzip,
+          compression::type::snappy}) {
+        // handled in place, in one chunk and in several chunks
+        const std::array<size_t, 3> async_sizes{
+          10_KiB, compressor::async_threshold, 1_MiB + 3};
+        for (size_t i : async_sizes) {
+            iobuf buf = gen(i);
+            auto cbuf = compressor::compress_async(buf, t).get0();
+            BOOST_CHECK_EQUAL(compressor::uncompress(cbuf, t), buf);
+            BOOST_CHECK_EQUAL(
+              compressor::uncompress_async(cbuf, t).get0(), buf);
+        }
+    }
+}
@@ -40,6 +40,11 @@ public:
 
     const required is_required() const { return _required; }
 
+    /// true if the property may be updated while running, by the admin api.
+    /// its users read it on every use, or watch it, see property::watch()
+    bool is_runtime_updatable() const { return _runtime_updatable; }
+    void set_runtime_updatable() { _runtime_updatable = true; }
+
     // this serializes the property value. a full configuration serialization is
     // performed in config_store::to_json where the json object key is taken
     // from the property name.
@@ -50,6 +55,8 @@ public:
     virtual void set_value(YAML::Node) = 0;
     virtual void set_value(std::any) = 0;
     virtual std::optional<validation_error> validate() const = 0;
+    /// validates a new value for the property, without setting it
+    virtual std::optional<validation_error> validate(YAML::Node) const = 0;
     virtual base_property& operator=(const base_property&) = 0;
     virtual ~base_property() noexcept = default;
 
@@ -58,5 +65,6 @@ private:
     std::string_view _name;
     std::string_view _desc;
     required _required;
+    bool _runtime_updatable{false};
 };
 }; // namespace config
@@ -11,6 +11,8 @@
 
 #include "units.h"
 
+#include <initializer_list>
+
 namespace config {
 using namespace std::chrono_literals;
 
@@ -20,6 +22,15 @@ configuration::configuration()
     "data_directory",
     "Place where redpanda will keep the data",
     required::yes)
+  , additional_data_directories(
+      *this,
+      "additional_data_directories",
+      "Directories on other disks among which the partition logs are spread "
+      "along with the data_directory, each log kept where it was created. "
+      "The kvstore stays in the data_directory. The disks get their own io "
+      "queues when their mountpoints are listed in the io properties",
+      required::no,
+      {})
   , developer_mode(
       *this,
       "developer_mode",
@@ -40,6 +51,27 @@ configuration::configuration()
       "256MiB)",
       required::no,
       256_MiB)
+  , log_segment_adaptive_sizing(
+      *this,
+      "log_segment_adaptive_sizing",
+      "When enabled, the segments of each partition are sized from its write "
+      "rate to hold log_segment_roll_target_ms of writes, at most a quarter "
+      "of its retention, between log_segment_size_min and the segment sizes "
+      "above, and their files are fallocated in proportion",
+      required::no,
+      false)
+  , log_segment_roll_target_ms(
+      *this,
+      "log_segment_roll_target_ms",
+      "Writes held by a segment when log_segment_adaptive_sizing is enabled",
+      required::no,
+      std::chrono::hours(1))
+  , log_segment_size_min(
+      *this,
+      "log_segment_size_min",
+      "Smallest segment when log_segment_adaptive_sizing is enabled",
+      required::no,
+      1_MiB)
   , rpc_server(
       *this,
       "rpc_server",
@@ -53,6 +85,44 @@ configuration::configuration()
       required::no,
       tls_config(),
       tls_config::validate)
+  , rpc_cork_window_us(
+      *this,
+      "rpc_cork_window_us",
+      "Microseconds internal RPC connections delay a flush to coalesce "
+      "concurrent writes, 0 disables corking",
+      required::no,
+      0)
+  , rpc_connections_per_peer(
+      *this,
+      "rpc_connections_per_peer",
+      "Internal RPC connections opened to each peer, up to 3: control "
+      "traffic (heartbeats, votes), replication and recovery each get their "
+      "own connection until they run out",
+      required::no,
+      1)
+  , rpc_max_requests_per_method(
+      *this,
+      "rpc_max_requests_per_method",
+      "Requests of a single internal RPC method a core processes at once, "
+      "others wait for their turn. 0 does not limit them",
+      required::no,
+      0)
+  , rpc_queue_time_target_ms(
+      *this,
+      "rpc_queue_time_target_ms",
+      "Internal RPC methods whose requests keep waiting longer than this to "
+      "be processed reject new requests until they catch up. 0 disables "
+      "load shedding",
+      required::no,
+      0ms)
+  , rpc_send_request_timeouts(
+      *this,
+      "rpc_send_request_timeouts",
+      "Send the timeout of internal RPC requests with them, so that peers "
+      "drop the requests whose reply nobody waits for. Only to be enabled "
+      "once every node of the cluster is upgraded",
+      required::no,
+      false)
   , enable_coproc(
       *this, "enable_coproc", "Enable coprocessing mode", required::no, false)
   , coproc_management_server(
@@ -67,6 +137,40 @@ configuration::configuration()
       "IpAddress and port for supervisor service",
       required::no,
       unresolved_address("127.0.0.1", 43189))
+  , coproc_max_inflight_requests(
+      *this,
+      "coproc_max_inflight_requests",
+      "Maximum number of process batch requests that each shard pipelines "
+      "to the coprocessor engine",
+      required::no,
+      4)
+  , coproc_max_inflight_bytes(
+      *this,
+      "coproc_max_inflight_bytes",
+      "Maximum number of bytes of the input topics that each shard has in "
+      "flight to the coprocessor engine",
+      required::no,
+      10_MiB)
+  , coproc_offset_flush_interval_ms(
+      *this,
+      "coproc_offset_flush_interval_ms",
+      "Interval for which all coprocessor offsets are flushed to disk",
+      required::no,
+      std::chrono::milliseconds(300))
+  , coproc_cork_window_us(
+      *this,
+      "coproc_cork_window_us",
+      "Microseconds the connection to the coprocessor engine delays a flush "
+      "to coalesce pipelined requests, 0 disables corking",
+      required::no,
+      0)
+  , coproc_materialize_flush_window_us(
+      *this,
+      "coproc_materialize_flush_window_us",
+      "Microseconds a materialized log waits for the outputs of more "
+      "coprocessor replies before it is flushed once for all of them",
+      required::no,
+      1000)
   , node_id(
       *this,
       "node_id",
@@ -102,6 +206,16 @@ configuration::configuration()
       "Address and port of an interface to listen for Kafka API requests",
       required::no,
       unresolved_address("127.0.0.1", 9092))
+  , kafka_api_shard_aware(
+      *this,
+      "kafka_api_shard_aware",
+      "Address and port of an optional second Kafka API listener for shard "
+      "aware clients. It serves a connection from the source port p with the "
+      "core p % cores, and its metadata responses tell the cores of the "
+      "partitions of the broker, so that a client may connect to the core of "
+      "the partitions it produces to or fetches from",
+      required::no,
+      std::nullopt)
   , kafka_api_tls(
       *this,
       "kafka_api_tls",
@@ -109,6 +223,61 @@ configuration::configuration()
       required::no,
       tls_config(),
       tls_config::validate)
+  , kafka_max_connections_per_ip(
+      *this,
+      "kafka_max_connections_per_ip",
+      "Kafka API connections a core keeps open from a single address, others "
+      "are closed as soon as they are accepted. 0 does not limit them",
+      required::no,
+      0)
+  , kafka_max_connections_per_client_id(
+      *this,
+      "kafka_max_connections_per_client_id",
+      "Kafka API connections a core keeps open for a single client id, others "
+      "are closed at their first request. 0 does not limit them",
+      required::no,
+      0)
+  , kafka_max_accepted_connections_per_second(
+      *this,
+      "kafka_max_accepted_connections_per_second",
+      "Kafka API connections a core accepts per second, in bursts of up to a "
+      "second of connections. Others are closed as soon as they are "
+      "accepted. 0 does not limit them",
+      required::no,
+      0)
+  , kafka_control_plane_memory_bytes(
+      *this,
+      "kafka_control_plane_memory_bytes",
+      "Memory of a core reserved for the Kafka API requests of the consumer "
+      "groups and the metadata requests, so that heartbeats are not held "
+      "back by the memory of the produce and fetch requests",
+      required::no,
+      1_MiB)
+  , kafka_load_sketch_decay_interval_ms(
+      *this,
+      "kafka_load_sketch_decay_interval_ms",
+      "Interval at which the counts of the hottest partitions and clients of "
+      "the Kafka API are halved, so that they follow the recent load. 0 "
+      "keeps the counts since the start",
+      required::no,
+      60s)
+  , partition_offsets_publish_interval_ms(
+      *this,
+      "partition_offsets_publish_interval_ms",
+      "Interval at which each core publishes the offsets of its partitions to "
+      "the other cores, which read them without a cross core request, e.g. "
+      "for consumer lag. 0 disables publishing",
+      required::no,
+      200ms)
+  , kafka_list_offsets_max_staleness_ms(
+      *this,
+      "kafka_list_offsets_max_staleness_ms",
+      "Age of the published offsets up to which list offsets requests for "
+      "the earliest and latest offsets are answered from them, instead of "
+      "asking the core of the partition. 0 always asks the core of the "
+      "partition",
+      required::no,
+      0ms)
   , use_scheduling_groups(
       *this,
       "use_scheduling_groups",
@@ -160,6 +329,57 @@ configuration::configuration()
       "Target quota byte rate (bytes per second) - 64MB default",
       required::no,
       64_MiB)
+  , target_produce_quota_byte_rate(
+      *this,
+      "target_produce_quota_byte_rate",
+      "Target quota byte rate of produce requests (bytes per second), on top "
+      "of target_quota_byte_rate - disabled by default",
+      required::no,
+      std::nullopt)
+  , target_fetch_quota_byte_rate(
+      *this,
+      "target_fetch_quota_byte_rate",
+      "Target quota byte rate of fetch responses (bytes per second), on top "
+      "of target_quota_byte_rate - disabled by default",
+      required::no,
+      std::nullopt)
+  , quota_manager_reconcile_ms(
+      *this,
+      "quota_manager_reconcile_ms",
+      "Interval at which client byte rates are summed across cores, so that "
+      "quotas hold for a node. Zero keeps quotas per core",
+      required::no,
+      std::chrono::milliseconds(1000))
+  , scheduling_shares_adjust_ms(
+      *this,
+      "scheduling_shares_adjust_ms",
+      "Interval at which the shares of the scheduling groups are adjusted to "
+      "the latency of their task queues. Zero keeps the shares static",
+      required::no,
+      std::chrono::milliseconds(100))
+  , raft_scheduling_latency_target_ms(
+      *this,
+      "raft_scheduling_latency_target_ms",
+      "Latency of the raft task queue over which the raft scheduling group "
+      "is given more shares, so that heartbeats are not starved by other "
+      "work",
+      required::no,
+      std::chrono::milliseconds(10))
+  , memory_governor_interval_ms(
+      *this,
+      "memory_governor_interval_ms",
+      "Interval at which memory is moved between the budgets of the kafka "
+      "server, the rpc server, the chunk cache and the batch cache, by their "
+      "demand. Zero keeps the budgets static",
+      required::no,
+      std::chrono::milliseconds(1000))
+  , task_profiler_stall_threshold_ms(
+      *this,
+      "task_profiler_stall_threshold_ms",
+      "Time a profiled operation may hold the reactor before it is counted as "
+      "a stall and its backtrace is sampled. Zero disables the sampling",
+      required::no,
+      std::chrono::milliseconds(10))
   , rack(*this, "rack", "Rack identifier", required::no, std::nullopt)
   , disable_metrics(
       *this,
@@ -167,6 +387,27 @@ configuration::configuration()
       "Disable registering metrics",
       required::no,
       false)
+  , aggregate_partition_metrics(
+      *this,
+      "aggregate_partition_metrics",
+      "Export the metrics of the partitions of a shard summed per topic "
+      "instead of per partition, to bound their number",
+      required::no,
+      false)
+  , enable_shard_latency_metrics(
+      *this,
+      "enable_shard_latency_metrics",
+      "Export the latency histograms of every shard, besides those of the "
+      "node which merge them",
+      required::no,
+      true)
+  , node_latency_refresh_interval_ms(
+      *this,
+      "node_latency_refresh_interval_ms",
+      "Time between two merges of the latency histograms of the shards into "
+      "those of the node",
+      required::no,
+      10s)
   , group_min_session_timeout_ms(
       *this,
       "group_min_session_timeout_ms",
@@ -197,6 +438,34 @@ configuration::configuration()
       "Timeout for new member joins",
       required::no,
       30'000ms)
+  , group_offset_commit_window_ms(
+      *this,
+      "group_offset_commit_window_ms",
+      "Offset commits of the groups of a coordinator partition received within "
+      "this window are replicated as one batch",
+      required::no,
+      1ms)
+  , group_snapshot_interval_ms(
+      *this,
+      "group_snapshot_interval_ms",
+      "Interval between snapshots of the groups and offsets of a group "
+      "metadata partition, that recovery starts from. Zero disables snapshots",
+      required::no,
+      300'000ms)
+  , group_offset_retention_ms(
+      *this,
+      "group_offset_retention_ms",
+      "The offsets of a group without members are deleted once no offset was "
+      "committed to the group for this long. Zero disables the expiration",
+      required::no,
+      604'800'000ms)
+  , consumer_lag_refresh_interval_ms(
+      *this,
+      "consumer_lag_refresh_interval_ms",
+      "Interval between fetches of the high watermarks the lag of the "
+      "consumer groups is computed against. Zero disables the lag metrics",
+      required::no,
+      15'000ms)
   , metadata_dissemination_interval_ms(
       *this,
       "metadata_dissemination_interval_ms",
@@ -224,7 +493,8 @@ configuration::configuration()
   , group_topic_partitions(
       *this,
       "group_topic_partitions",
-      "Number of partitions in the internal group membership topic",
+      "Number of partitions in the internal group membership topic, raised to "
+      "the number of cores of the node creating it",
       required::no,
       1)
   , default_topic_replication(
@@ -263,6 +533,42 @@ configuration::configuration()
       "Election timeout expressed in milliseconds",
       required::no,
       1'500ms)
+  , raft_adaptive_election_timeout(
+      *this,
+      "raft_adaptive_election_timeout",
+      "When enabled, the followers of a raft group derive the election "
+      "timeout from the intervals at which the requests of their leader "
+      "arrive, between raft_election_timeout_min_ms and election_timeout_ms",
+      required::no,
+      false)
+  , raft_election_timeout_min_ms(
+      *this,
+      "raft_election_timeout_min_ms",
+      "Shortest adaptive election timeout, at least twice the heartbeat "
+      "interval. Leader leases are bounded by it when the timeout adapts",
+      required::no,
+      500ms)
+  , raft_max_concurrent_elections(
+      *this,
+      "raft_max_concurrent_elections",
+      "Maximum number of elections the raft groups of a core run at once",
+      required::no,
+      64)
+  , leadership_drain_timeout_ms(
+      *this,
+      "leadership_drain_timeout_ms",
+      "On shutdown, time given to the raft groups the node leads to transfer "
+      "their leadership to a follower before the node stops. 0 disables the "
+      "drain",
+      required::no,
+      10s)
+  , leadership_drain_max_concurrent(
+      *this,
+      "leadership_drain_max_concurrent",
+      "Maximum number of leadership transfers each core runs at once while "
+      "draining on shutdown",
+      required::no,
+      64)
   , kafka_group_recovery_timeout_ms(
       *this,
       "kafka_group_recovery_timeout_ms",
@@ -282,6 +588,88 @@ configuration::configuration()
       "follower",
       required::no,
       5s)
+  , recovery_read_size_bytes(
+      *this,
+      "recovery_read_size_bytes",
+      "Size of the log range read for each append entries request sent to a "
+      "recovering follower",
+      required::no,
+      256_KiB)
+  , recovery_max_inflight_requests(
+      *this,
+      "recovery_max_inflight_requests",
+      "Maximum number of append entries requests in flight to a recovering "
+      "follower",
+      required::no,
+      4)
+  , raft_max_inflight_follower_appends(
+      *this,
+      "raft_max_inflight_follower_appends",
+      "Maximum number of append entries requests of new entries in flight to "
+      "a follower. A follower past it is caught up by recovery instead",
+      required::no,
+      8)
+  , raft_max_inflight_follower_append_bytes(
+      *this,
+      "raft_max_inflight_follower_append_bytes",
+      "Maximum size of the entries of the append entries requests in flight "
+      "to a follower. A follower past it is caught up by recovery instead",
+      required::no,
+      16_MiB)
+  , recovery_stream_segments(
+      *this,
+      "recovery_stream_segments",
+      "Copy closed segments as files to followers that are far behind, "
+      "instead of replicating their batches one by one",
+      required::no,
+      true)
+  , recovery_max_bytes_per_sec(
+      *this,
+      "recovery_max_bytes_per_sec",
+      "Maximum rate per node at which leaders send data to recovering "
+      "followers, e.g. to new replicas of moved partitions. Shared evenly by "
+      "the cores",
+      required::no,
+      std::nullopt)
+  , raft_enable_leader_lease(
+      *this,
+      "raft_enable_leader_lease",
+      "Serve linearizable reads from raft leaders without a round trip to "
+      "followers while a quorum acknowledged them within the election "
+      "timeout",
+      required::no,
+      false)
+  , raft_quiesce_idle_ms(
+      *this,
+      "raft_quiesce_idle_ms",
+      "Stop heartbeating a raft group once it is fully replicated and was "
+      "not written to for this long, the heartbeats of the node keep its "
+      "followers from holding an election. 0 keeps heartbeating all groups",
+      required::no,
+      0ms)
+  , rpc_replication_compression(
+      *this,
+      "rpc_replication_compression",
+      "Codec of the raft append entries requests between nodes: none, zstd "
+      "or lz4. Batches compressed by their producer are sent as they are. "
+      "Enable lz4 once all the nodes of the cluster decode it",
+      required::no,
+      "none")
+  , replicate_batch_latency_target_ms(
+      *this,
+      "replicate_batch_latency_target_ms",
+      "Replication latency that the raft replicate batcher aims for when "
+      "choosing how long to wait for more requests",
+      required::no,
+      10ms)
+  , produce_trace_sample_period(
+      *this,
+      "produce_trace_sample_period",
+      "One of every this many produce requests records the latency of each "
+      "stage it goes through, from the kafka decode to the raft commit. Zero "
+      "disables the tracing",
+      required::no,
+      100)
   , reclaim_min_size(
       *this,
       "reclaim_min_size",
@@ -306,6 +694,283 @@ configuration::configuration()
       "Length of time above which growth is reset",
       required::no,
       10'000ms)
+  , reclaim_background(
+      *this,
+      "reclaim_background",
+      "Defer batch cache reclaim in low-memory situations to a background "
+      "fiber instead of reclaiming synchronously with memory allocation",
+      required::no,
+      false)
+  , batch_cache_max_batch_bytes(
+      *this,
+      "batch_cache_max_batch_bytes",
+      "Batches larger than this are written without being copied into the "
+      "batch cache, and are read back from disk",
+      required::no,
+      std::nullopt)
+  , max_resident_segment_indices(
+      *this,
+      "max_resident_segment_indices",
+      "Maximum number of lazily loaded segment indices kept in memory per "
+      "shard",
+      required::no,
+      1024)
+  , max_open_segment_files(
+      *this,
+      "max_open_segment_files",
+      "Maximum number of data and index files of the closed segments kept "
+      "open per shard. The least recently used ones are closed, and opened "
+      "again on their next read",
+      required::no,
+      2048)
+  , segment_index_step(
+      *this,
+      "segment_index_step",
+      "Bytes of batches between two entries of the offset and time index of "
+      "a segment. A denser index makes offset and timestamp lookups read "
+      "less data, at the cost of memory",
+      required::no,
+      32_KiB)
+  , compaction_hashed_key_index_bytes(
+      *this,
+      "compaction_hashed_key_index_bytes",
+      "When set, compaction deduplicates keys by hash in a table of at most "
+      "this many bytes per shard instead of keeping whole keys in memory",
+      required::no,
+      std::nullopt)
+  , compaction_bytes_per_sec(
+      *this,
+      "compaction_bytes_per_sec",
+      "Maximum rate per shard at which segments are scheduled for compaction. "
+      "Logs are compacted in order of dirty ratio within this budget",
+      required::no,
+      std::nullopt)
+  , log_recovery_concurrency(
+      *this,
+      "log_recovery_concurrency",
+      "Number of logs each shard opens and recovers at once",
+      required::no,
+      64)
+  , segment_deletion_concurrency(
+      *this,
+      "segment_deletion_concurrency",
+      "Number of segments removed by retention that each shard closes and "
+      "deletes at once, in the background",
+      required::no,
+      2)
+  , segment_deletion_truncate_step(
+      *this,
+      "segment_deletion_truncate_step",
+      "When set, the data file of a removed segment is truncated by this many "
+      "bytes at a time before it is unlinked, so that no single filesystem "
+      "operation frees all of its extents at once",
+      required::no,
+      std::nullopt)
+  , segment_recovery_checkpoint_bytes(
+      *this,
+      "segment_recovery_checkpoint_bytes",
+      "When set, the active segment persists its index and a recovery "
+      "checkpoint each time this many bytes were flushed, so that recovery "
+      "after an unclean shutdown only replays the batches written after it",
+      required::no,
+      64_MiB)
+  , storage_coalesced_read_max_bytes(
+      *this,
+      "storage_coalesced_read_max_bytes",
+      "When set, concurrent reads of a segment that are adjacent or overlap "
+      "are merged into reads of up to this many bytes",
+      required::no,
+      std::nullopt)
+  , readers_cache_eviction_timeout_ms(
+      *this,
+      "readers_cache_eviction_timeout_ms",
+      "Time a log reader stays parked for the next sequential read of its "
+      "partition before it is closed",
+      required::no,
+      30s)
+  , storage_read_buffer_memory(
+      *this,
+      "storage_read_buffer_memory",
+      "Memory of each shard for the buffers of sequential and large log "
+      "reads, beyond the smallest buffers every read gets",
+      required::no,
+      64_MiB)
+  , storage_min_free_bytes(
+      *this,
+      "storage_min_free_bytes",
+      "Free space kept on each data directory: below it, the oldest segments "
+      "of the deletable topics are removed ahead of their retention",
+      required::no,
+      std::nullopt)
+  , storage_scrub_bytes_per_sec(
+      *this,
+      "storage_scrub_bytes_per_sec",
+      "Node wide rate at which closed segments are read back in the "
+      "background to verify their checksums. Disabled when not set",
+      required::no,
+      std::nullopt)
+  , storage_scrub_interval_ms(
+      *this,
+      "storage_scrub_interval_ms",
+      "Time between two background verifications of the closed segments",
+      required::no,
+      24h)
+  , storage_calibrate_disk(
+      *this,
+      "storage_calibrate_disk",
+      "Measure the disk of the data directory at the first start and size "
+      "the reads of the segments after it. The measurement is kept in the "
+      "data directory, along with an io properties file for the io scheduler",
+      required::no,
+      false)
+  , storage_shared_wal_enabled(
+      *this,
+      "storage_shared_wal_enabled",
+      "Flush the partitions of each core through a write-ahead log shared by "
+      "them, so that the flushes of many small partitions cost one sync",
+      required::no,
+      false)
+  , storage_shared_wal_segment_size(
+      *this,
+      "storage_shared_wal_segment_size",
+      "Size of the segments of the shared write-ahead log of a core: the "
+      "partitions written to a segment flush their own segments once it is "
+      "full",
+      required::no,
+      64_MiB)
+  , storage_coalesce_batch_bytes(
+      *this,
+      "storage_coalesce_batch_bytes",
+      "When set, the runs of small uncompressed batches of the closed "
+      "segments are merged into batches of up to this size in housekeeping, "
+      "so that the segments hold fewer headers to read and index",
+      required::no,
+      std::nullopt)
+  , storage_deletion_bytes_per_sec(
+      *this,
+      "storage_deletion_bytes_per_sec",
+      "Node wide rate at which the files of the removed partitions are "
+      "deleted in the background. Unbounded when not set",
+      required::no,
+      std::nullopt)
+  , memory_topics_max_bytes(
+      *this,
+      "memory_topics_max_bytes",
+      "Node wide memory of the logs of the topics created with "
+      "redpanda.storage.type=memory. Defaults to a tenth of the memory",
+      required::no,
+      std::nullopt)
+  , archival_enabled(
+      *this,
+      "archival_enabled",
+      "Upload the closed segments of kafka topics to S3 compatible object "
+      "storage, and serve the reads below the local start of a partition "
+      "from there",
+      required::no,
+      false)
+  , archival_local_retention_bytes(
+      *this,
+      "archival_local_retention_bytes",
+      "With archival, max bytes per partition kept on disk. retention_bytes "
+      "then bounds the partition in object storage",
+      required::no,
+      std::nullopt)
+  , archival_local_retention_ms(
+      *this,
+      "archival_local_retention_ms",
+      "With archival, segments older than this are removed from disk once "
+      "uploaded. delete_retention_ms then bounds them in object storage",
+      required::no,
+      24h)
+  , archival_s3_access_key(
+      *this,
+      "archival_s3_access_key",
+      "Access key of the object storage",
+      required::no,
+      std::nullopt)
+  , archival_s3_secret_key(
+      *this,
+      "archival_s3_secret_key",
+      "Secret key of the object storage",
+      required::no,
+      std::nullopt)
+  , archival_s3_region(
+      *this,
+      "archival_s3_region",
+      "Region of the object storage, used to sign requests",
+      required::no,
+      "us-east-1")
+  , archival_s3_bucket(
+      *this,
+      "archival_s3_bucket",
+      "Bucket the segments are uploaded to",
+      required::no,
+      std::nullopt)
+  , archival_s3_endpoint(
+      *this,
+      "archival_s3_endpoint",
+      "Host name of the object storage, s3.<region>.amazonaws.com when not "
+      "set",
+      required::no,
+      std::nullopt)
+  , archival_s3_port(
+      *this,
+      "archival_s3_port",
+      "Port of the object storage",
+      required::no,
+      443)
+  , archival_s3_disable_tls(
+      *this,
+      "archival_s3_disable_tls",
+      "Connect to the object storage without TLS, e.g. to a local endpoint",
+      required::no,
+      false)
+  , archival_upload_interval_ms(
+      *this,
+      "archival_upload_interval_ms",
+      "How often the closed segments of the partitions led by a shard are "
+      "looked for and uploaded",
+      required::no,
+      10s)
+  , archival_max_concurrent_uploads(
+      *this,
+      "archival_max_concurrent_uploads",
+      "Segments of different partitions uploaded at once by a shard",
+      required::no,
+      4)
+  , archival_request_timeout_ms(
+      *this,
+      "archival_request_timeout_ms",
+      "Time an object storage request may take before it is failed",
+      required::no,
+      60s)
+  , archival_cache_directory(
+      *this,
+      "archival_cache_directory",
+      "Directory of the archived segments downloaded for reads, "
+      "<data_directory>/archival_cache when not set",
+      required::no,
+      std::nullopt)
+  , archival_cache_size(
+      *this,
+      "archival_cache_size",
+      "Bytes of downloaded archived segments kept for reads, shared by the "
+      "shards",
+      required::no,
+      20_GiB)
+  , archival_cache_chunk_size(
+      *this,
+      "archival_cache_chunk_size",
+      "Archived segments are downloaded for reads in chunks of this size, "
+      "rounded up to 4KiB",
+      required::no,
+      1_MiB)
+  , archival_cache_prefetch_chunks(
+      *this,
+      "archival_cache_prefetch_chunks",
+      "Chunks downloaded ahead of sequential reads of an archived segment",
+      required::no,
+      4)
   , auto_create_topics_enabled(
       *this,
       "auto_create_topics_enabled",
@@ -356,12 +1021,72 @@ configuration::configuration()
       "Timeout waiting for follower recovery when transferring leadership",
       required::no,
       10s)
+  , enable_leader_balancer(
+      *this,
+      "enable_leader_balancer",
+      "Enable automatic leadership rebalancing across nodes and cores",
+      required::no,
+      true)
+  , leader_balancer_interval_ms(
+      *this,
+      "leader_balancer_interval_ms",
+      "Interval between leadership rebalancing rounds",
+      required::no,
+      1min)
+  , leader_balancer_max_transfers(
+      *this,
+      "leader_balancer_max_transfers",
+      "Maximum number of leadership transfers per rebalancing round",
+      required::no,
+      4)
+  , enable_shard_balancer(
+      *this,
+      "enable_shard_balancer",
+      "Enable moving partitions from the busiest to the idlest core of a node",
+      required::no,
+      false)
+  , shard_balancer_interval_ms(
+      *this,
+      "shard_balancer_interval_ms",
+      "Interval between partition to core rebalancing rounds",
+      required::no,
+      5min)
+  , shard_balancer_imbalance_percent(
+      *this,
+      "shard_balancer_imbalance_percent",
+      "Difference between the bytes served by the busiest and the idlest "
+      "core, in percent of the busiest, above which a partition is moved",
+      required::no,
+      50)
+  , controller_snapshot_interval_ms(
+      *this,
+      "controller_snapshot_interval_ms",
+      "Interval between snapshots of the controller state, which prefix "
+      "truncate the controller log",
+      required::no,
+      10min)
   , release_cache_on_segment_roll(
       *this,
       "release_cache_on_segment_roll",
       "Free cache when segments roll",
       required::no,
       false)
+  , follower_batch_cache_tail_bytes(
+      *this,
+      "follower_batch_cache_tail_bytes",
+      "Bytes of the last batches appended by a follower kept in the batch "
+      "cache, unless clients fetch from followers, see rack. 0 does not cache "
+      "the appends of followers",
+      required::no,
+      1_MiB)
+  , leader_batch_cache_warm_bytes(
+      *this,
+      "leader_batch_cache_warm_bytes",
+      "Bytes of the tail of its log a new leader reads into the batch cache in "
+      "the background, so that its consumers do not read from disk after a "
+      "failover. 0 disables warming",
+      required::no,
+      4_MiB)
   , segment_appender_flush_timeout_ms(
       *this,
       "segment_appender_flush_timeout_ms",
@@ -379,9 +1104,20 @@ configuration::configuration()
       "advertised_rpc_api",
       "Address of RPC endpoint published to other cluster members",
       required::no,
-      std::nullopt)
-
-{}
+      std::nullopt) {
+    // read on every use, or watched by the services they configure
+    for (base_property* p : std::initializer_list<base_property*>{
+           &raft_heartbeat_interval_ms,
+           &kvstore_flush_interval,
+           &reclaim_min_size,
+           &log_compaction_interval_ms,
+           &target_quota_byte_rate,
+           &target_produce_quota_byte_rate,
+           &target_fetch_quota_byte_rate,
+           &segment_appender_flush_timeout_ms}) {
+        p->set_runtime_updatable();
+    }
+}
 
 void configuration::read_yaml(const YAML::Node& root_node) {
     if (!root_node["redpanda"]) {
@@ -30,16 +30,30 @@ namespace config {
 struct configuration final : public config_store {
     // WAL
     property<data_directory_path> data_directory;
+    property<std::vector<ss::sstring>> additional_data_directories;
     property<bool> developer_mode;
     property<uint64_t> log_segment_size;
     property<uint64_t> compacted_log_segment_size;
+    property<bool> log_segment_adaptive_sizing;
+    property<std::chrono::milliseconds> log_segment_roll_target_ms;
+    property<size_t> log_segment_size_min;
     // Network
     property<unresolved_address> rpc_server;
     property<tls_config> rpc_server_tls;
+    property<uint32_t> rpc_cork_window_us;
+    property<size_t> rpc_connections_per_peer;
+    property<size_t> rpc_max_requests_per_method;
+    property<std::chrono::milliseconds> rpc_queue_time_target_ms;
+    property<bool> rpc_send_request_timeouts;
     // Coproc
     property<bool> enable_coproc;
     property<unresolved_address> coproc_management_server;
     property<unresolved_address> coproc_supervisor_server;
+    property<size_t> coproc_max_inflight_requests;
+    property<size_t> coproc_max_inflight_bytes;
+    property<std::chrono::milliseconds> coproc_offset_flush_interval_ms;
+    property<uint32_t> coproc_cork_window_us;
+    property<uint32_t> coproc_materialize_flush_window_us;
     // Raft
     property<int32_t> node_id;
     property<int32_t> seed_server_meta_topic_partitions;
@@ -50,6 +64,14 @@ struct configuration final : public config_store {
     // Kafka
     property<unresolved_address> kafka_api;
     property<tls_config> kafka_api_tls;
+    property<std::optional<unresolved_address>> kafka_api_shard_aware;
+    property<uint32_t> kafka_max_connections_per_ip;
+    property<uint32_t> kafka_max_connections_per_client_id;
+    property<uint32_t> kafka_max_accepted_connections_per_second;
+    property<size_t> kafka_control_plane_memory_bytes;
+    property<std::chrono::milliseconds> kafka_load_sketch_decay_interval_ms;
+    property<std::chrono::milliseconds> partition_offsets_publish_interval_ms;
+    property<std::chrono::milliseconds> kafka_list_offsets_max_staleness_ms;
     property<bool> use_scheduling_groups;
     property<unresolved_address> admin;
     property<tls_config> admin_api_tls;
@@ -59,12 +81,26 @@ struct configuration final : public config_store {
     property<std::chrono::milliseconds> default_window_sec;
     property<std::chrono::milliseconds> quota_manager_gc_sec;
     property<uint32_t> target_quota_byte_rate;
+    property<std::optional<uint32_t>> target_produce_quota_byte_rate;
+    property<std::optional<uint32_t>> target_fetch_quota_byte_rate;
+    property<std::chrono::milliseconds> quota_manager_reconcile_ms;
+    property<std::chrono::milliseconds> scheduling_shares_adjust_ms;
+    property<std::chrono::milliseconds> raft_scheduling_latency_target_ms;
+    property<std::chrono::milliseconds> memory_governor_interval_ms;
+    property<std::chrono::milliseconds> task_profiler_stall_threshold_ms;
     property<std::optional<ss::sstring>> rack;
     property<bool> disable_metrics;
+    property<bool> aggregate_partition_metrics;
+    property<bool> enable_shard_latency_metrics;
+    property<std::chrono::milliseconds> node_latency_refresh_interval_ms;
     property<std::chrono::milliseconds> group_min_session_timeout_ms;
     property<std::chrono::milliseconds> group_max_session_timeout_ms;
     property<std::chrono::milliseconds> group_initial_rebalance_delay;
     property<std::chrono::milliseconds> group_new_member_join_timeout;
+    property<std::chrono::milliseconds> group_offset_commit_window_ms;
+    property<std::chrono::milliseconds> group_snapshot_interval_ms;
+    property<std::chrono::milliseconds> group_offset_retention_ms;
+    property<std::chrono::milliseconds> consumer_lag_refresh_interval_ms;
     property<std::chrono::milliseconds> metadata_dissemination_interval_ms;
     // same as delete.retention.ms in kafka
     property<std::chrono::milliseconds> delete_retention_ms;
@@ -78,14 +114,70 @@ struct configuration final : public config_store {
     property<int32_t> default_topic_partitions;
     property<bool> disable_batch_cache;
     property<std::chrono::milliseconds> raft_election_timeout_ms;
+    property<bool> raft_adaptive_election_timeout;
+    property<std::chrono::milliseconds> raft_election_timeout_min_ms;
+    property<size_t> raft_max_concurrent_elections;
+    property<std::chrono::milliseconds> leadership_drain_timeout_ms;
+    property<size_t> leadership_drain_max_concurrent;
     property<std::chrono::milliseconds> kafka_group_recovery_timeout_ms;
     property<std::chrono::milliseconds> replicate_append_timeout_ms;
     property<std::chrono::milliseconds> recovery_append_timeout_ms;
+    property<size_t> recovery_read_size_bytes;
+    property<size_t> recovery_max_inflight_requests;
+    property<size_t> raft_max_inflight_follower_appends;
+    property<size_t> raft_max_inflight_follower_append_bytes;
+    property<bool> recovery_stream_segments;
+    property<std::optional<size_t>> recovery_max_bytes_per_sec;
+    property<bool> raft_enable_leader_lease;
+    property<std::chrono::milliseconds> raft_quiesce_idle_ms;
+    property<ss::sstring> rpc_replication_compression;
+    property<std::chrono::milliseconds> replicate_batch_latency_target_ms;
+    property<uint32_t> produce_trace_sample_period;
 
     property<size_t> reclaim_min_size;
     property<size_t> reclaim_max_size;
     property<std::chrono::milliseconds> reclaim_growth_window;
     property<std::chrono::milliseconds> reclaim_stable_window;
+    property<bool> reclaim_background;
+    property<std::optional<size_t>> batch_cache_max_batch_bytes;
+    property<size_t> max_resident_segment_indices;
+    property<size_t> max_open_segment_files;
+    property<size_t> segment_index_step;
+    property<std::optional<size_t>> compaction_hashed_key_index_bytes;
+    property<std::optional<size_t>> compaction_bytes_per_sec;
+    property<size_t> log_recovery_concurrency;
+    property<size_t> segment_deletion_concurrency;
+    property<std::optional<size_t>> segment_deletion_truncate_step;
+    property<std::optional<size_t>> segment_recovery_checkpoint_bytes;
+    property<std::optional<size_t>> storage_coalesced_read_max_bytes;
+    property<std::chrono::milliseconds> readers_cache_eviction_timeout_ms;
+    property<size_t> storage_read_buffer_memory;
+    property<std::optional<size_t>> storage_min_free_bytes;
+    property<std::optional<size_t>> storage_scrub_bytes_per_sec;
+    property<std::chrono::milliseconds> storage_scrub_interval_ms;
+    property<bool> storage_calibrate_disk;
+    property<bool> storage_shared_wal_enabled;
+    property<size_t> storage_shared_wal_segment_size;
+    property<std::optional<size_t>> storage_coalesce_batch_bytes;
+    property<std::optional<size_t>> storage_deletion_bytes_per_sec;
+    property<std::optional<size_t>> memory_topics_max_bytes;
+    property<bool> archival_enabled;
+    property<std::optional<size_t>> archival_local_retention_bytes;
+    property<std::chrono::milliseconds> archival_local_retention_ms;
+    property<std::optional<ss::sstring>> archival_s3_access_key;
+    property<std::optional<ss::sstring>> archival_s3_secret_key;
+    property<ss::sstring> archival_s3_region;
+    property<std::optional<ss::sstring>> archival_s3_bucket;
+    property<std::optional<ss::sstring>> archival_s3_endpoint;
+    property<uint16_t> archival_s3_port;
+    property<bool> archival_s3_disable_tls;
+    property<std::chrono::milliseconds> archival_upload_interval_ms;
+    property<size_t> archival_max_concurrent_uploads;
+    property<std::chrono::milliseconds> archival_request_timeout_ms;
+    property<std::optional<ss::sstring>> archival_cache_directory;
+    property<size_t> archival_cache_size;
+    property<size_t> archival_cache_chunk_size;
+    property<size_t> archival_cache_prefetch_chunks;
     property<bool> auto_create_topics_enabled;
     property<bool> enable_pid_file;
     property<std::chrono::milliseconds> kvstore_flush_interval;
@@ -96,7 +188,16 @@ struct configuration final : public config_store {
     property<std::chrono::milliseconds> raft_timeout_now_timeout_ms;
     property<std::chrono::milliseconds>
       raft_transfer_leader_recovery_timeout_ms;
+    property<bool> enable_leader_balancer;
+    property<std::chrono::milliseconds> leader_balancer_interval_ms;
+    property<uint32_t> leader_balancer_max_transfers;
+    property<bool> enable_shard_balancer;
+    property<std::chrono::milliseconds> shard_balancer_interval_ms;
+    property<uint32_t> shard_balancer_imbalance_percent;
+    property<std::chrono::milliseconds> controller_snapshot_interval_ms;
     property<bool> release_cache_on_segment_roll;
+    property<size_t> follower_batch_cache_tail_bytes;
+    property<size_t> leader_batch_cache_warm_bytes;
     property<std::chrono::milliseconds> segment_appender_flush_timeout_ms;
 
     configuration();
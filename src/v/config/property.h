@@ -12,6 +12,7 @@
 #pragma once
 #include "config/base_property.h"
 #include "config/rjson_serialization.h"
+#include "utils/intrusive_list_helpers.h"
 #include "utils/to_string.h"
 
 #include <seastar/util/noncopyable_function.hh>
@@ -26,6 +27,47 @@ class property : public base_property {
 public:
     using validator =
       typename ss::noncopyable_function<std::optional<ss::sstring>(const T&)>;
+    using callback = ss::noncopyable_function<void(const T&)>;
+
+    /**
+     * A callback of the updates of the property on the shard, see
+     * property::watch(). The callback stops once the watcher is dropped.
+     * Moving a watcher keeps it registered.
+     */
+    class watcher {
+    public:
+        watcher() = default;
+        watcher(watcher&& o) noexcept
+          : _callback(std::move(o._callback)) {
+            if (o._hook.is_linked()) {
+                _hook.swap_nodes(o._hook);
+            }
+        }
+        watcher& operator=(watcher&& o) noexcept {
+            if (this != &o) {
+                if (_hook.is_linked()) {
+                    _hook.unlink();
+                }
+                _callback = std::move(o._callback);
+                if (o._hook.is_linked()) {
+                    _hook.swap_nodes(o._hook);
+                }
+            }
+            return *this;
+        }
+        watcher(const watcher&) = delete;
+        watcher& operator=(const watcher&) = delete;
+        ~watcher() = default;
+
+    private:
+        friend property;
+
+        explicit watcher(callback cb)
+          : _callback(std::move(cb)) {}
+
+        intrusive_list_hook _hook;
+        callback _callback;
+    };
 
     property(
       config_store& conf,
@@ -64,25 +106,55 @@ public:
         return std::nullopt;
     }
 
+    std::optional<validation_error> validate(YAML::Node n) const override {
+        if (auto err = _validator(n.as<T>()); err) {
+            return std::make_optional<validation_error>(name().data(), *err);
+        }
+        return std::nullopt;
+    }
+
     void set_value(std::any v) override {
         _value = std::any_cast<T>(std::move(v));
+        notify_watchers();
     }
 
-    void set_value(YAML::Node n) override { _value = std::move(n.as<T>()); }
+    void set_value(YAML::Node n) override {
+        _value = std::move(n.as<T>());
+        notify_watchers();
+    }
 
     property<T>& operator()(T v) {
         _value = std::move(v);
+        notify_watchers();
         return *this;
     }
 
     base_property& operator=(const base_property& pr) override {
         _value = dynamic_cast<const property<T>&>(pr)._value;
+        notify_watchers();
         return *this;
     }
 
+    /// \brief calls back with the new value on every update of the
+    /// property on this shard, until the watcher is dropped
+    [[nodiscard]] watcher watch(callback cb) {
+        watcher w(std::move(cb));
+        _watchers.push_back(w);
+        return w;
+    }
+
 private:
+    void notify_watchers() {
+        for (auto it = _watchers.begin(); it != _watchers.end();) {
+            // the callback may drop its own watcher
+            auto& w = *it++;
+            w._callback(_value);
+        }
+    }
+
     T _value;
     validator _validator;
+    intrusive_list<watcher, &watcher::_hook> _watchers;
     constexpr static auto noop_validator = [](const auto&) {
         return std::nullopt;
     };
@@ -142,6 +142,24 @@ SEASTAR_THREAD_TEST_CASE(update_property_value) {
     BOOST_TEST(cfg.required_string() == "new_string_value");
 };
 
+SEASTAR_THREAD_TEST_CASE(watch_property_updates) {
+    auto cfg = test_config();
+    cfg.read_yaml(minimal_valid_configuration());
+
+    std::vector<int> seen;
+    auto w = cfg.optional_int.watch([&seen](int v) { seen.push_back(v); });
+    cfg.get("optional_int").set_value(YAML::Load("7"));
+    auto moved = std::move(w);
+    cfg.optional_int(8);
+    BOOST_TEST(seen == std::vector<int>({7, 8}));
+
+    // a dropped watcher is not called back
+    moved = {};
+    cfg.optional_int(9);
+    BOOST_TEST(seen.size() == 2);
+    BOOST_TEST(cfg.optional_int() == 9);
+};
+
 SEASTAR_THREAD_TEST_CASE(validate_valid_configuration) {
     auto cfg = test_config();
     cfg.read_yaml(valid_configuration());
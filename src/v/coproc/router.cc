@@ -12,9 +12,13 @@
 #include "coproc/reference_window_consumer.hpp"
 #include "coproc/supervisor.h"
 #include "coproc/types.h"
+#include "config/configuration.h"
 #include "model/limits.h"
+#include "model/adl_serde.h"
 #include "model/record_batch_reader.h"
+#include "reflection/adl.h"
 #include "rpc/backoff_policy.h"
+#include "storage/kvstore.h"
 #include "storage/types.h"
 #include "units.h"
 #include "vassert.h"
@@ -22,32 +26,80 @@
 
 #include <seastar/core/loop.hh>
 #include <seastar/core/map_reduce.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/sleep.hh>
 
 #include <absl/container/flat_hash_map.h>
 
+#include <algorithm>
+#include <iterator>
+
 namespace coproc {
 
-ss::future<std::optional<router::offset_rbr_pair>>
+namespace {
+/// The most read from an ntp by a poll
+constexpr size_t max_read_bytes = 32_KiB;
+
+bytes checkpoint_key(script_id id, const model::ntp& ntp) {
+    iobuf buf;
+    reflection::serialize(buf, id, ntp);
+    return iobuf_to_bytes(buf);
+}
+} // namespace
+
+ss::future<std::optional<router::extracted_data>>
 router::extract_offset(model::record_batch_reader reader) {
     return model::consume_reader_to_memory(std::move(reader), model::no_timeout)
       .then([](model::record_batch_reader::data_t data) {
           if (data.empty()) {
-              return std::optional<offset_rbr_pair>(std::nullopt);
+              return std::optional<extracted_data>(std::nullopt);
           }
           const auto last_offset = data.back().last_offset();
-          return std::optional<offset_rbr_pair>(std::make_pair(
-            last_offset,
-            model::make_memory_record_batch_reader(std::move(data))));
+          size_t size_bytes = 0;
+          for (const auto& b : data) {
+              size_bytes += b.size_bytes();
+          }
+          return std::optional<extracted_data>(extracted_data{
+            .last_offset = last_offset,
+            .size_bytes = size_bytes,
+            .reader = model::make_memory_record_batch_reader(std::move(data))});
       });
 }
 
 router::router(ss::socket_address addr, ss::sharded<storage::api>& api)
   : _api(api)
+  , _request_credits(std::max<size_t>(
+      config::shard_local_cfg().coproc_max_inflight_requests(), 1))
+  // an ntp is read only once it holds the credits of a whole read
+  , _byte_credits(std::max<size_t>(
+      config::shard_local_cfg().coproc_max_inflight_bytes(), max_read_bytes))
   , _transport(
       {rpc::transport_configuration{
-        .server_addr = addr, .credentials = std::nullopt}},
+        .server_addr = addr,
+        .credentials = std::nullopt,
+        // pipelined requests are written with a single syscall
+        .cork_window = std::chrono::microseconds(
+          config::shard_local_cfg().coproc_cork_window_us())}},
       rpc::make_exponential_backoff_policy<rpc::clock_type>(
-        std::chrono::seconds(1), std::chrono::seconds(10))) {}
+        std::chrono::seconds(1), std::chrono::seconds(10)))
+  , _flush_window(
+      config::shard_local_cfg().coproc_materialize_flush_window_us()) {}
+
+ss::future<> router::start() {
+    _checkpoint_timer.set_callback([this] { checkpoint(); });
+    _checkpoint_timer.arm_periodic(
+      config::shard_local_cfg().coproc_offset_flush_interval_ms());
+    (void)ss::with_gate(_gate, [this] { return route(); });
+    return ss::now();
+}
+
+ss::future<> router::stop() {
+    _abort_source.request_abort();
+    _checkpoint_timer.cancel();
+    return ss::when_all(_gate.close(), _transport.stop())
+      .discard_result()
+      .then([this] { return checkpoint_offsets(); });
+}
 
 ss::future<result<supervisor_client_protocol>> router::get_client() {
     return _transport.get_connected().then(
@@ -80,7 +132,8 @@ ss::future<> router::route() {
      *
      * Data is consumed from the topic (max 32KiB read) and sent to the
      * interested topics, the reply is processed as writes to new materialized
-     * topics.
+     * topics. Requests are pipelined, within the limits of the request and
+     * byte credits.
      *
      * The loop is broken if the abort_source has been initiated externally or
      * it can be initiated internally by detection of a failed connection to the
@@ -89,58 +142,144 @@ ss::future<> router::route() {
     return ss::do_until(
       [this] { return _abort_source.abort_requested(); },
       [this] {
-          auto reducer =
-            [](std::vector<process_batch_request::data> acc, opt_req_data x) {
-                if (x.has_value()) {
-                    acc.emplace_back(std::move(*x));
-                }
-                return acc;
-            };
-          return ss::map_reduce(
-                   _sources.begin(),
-                   _sources.end(),
-                   [this](std::pair<const model::ntp, topic_state>& p) {
-                       return route_ntp(p.first, p.second);
-                   },
-                   std::vector<process_batch_request::data>(),
-                   std::move(reducer))
-            .then([this](std::vector<process_batch_request::data> batch) {
-                if (batch.empty()) {
-                    return ss::now();
-                }
-                process_batch_request r{.reqs = std::move(batch)};
-                return get_client().then(
-                  [this, r = std::move(r)](
-                    result<supervisor_client_protocol> transport) mutable {
-                      if (!transport) {
-                          const auto err = transport.error();
-                          if (err == rpc::errc::disconnected_endpoint) {
-                              vlog(
-                                coproclog.error,
-                                "Shutting down loop, failed to connect to "
-                                "coproc server");
-                              _abort_source.request_abort();
-                          }
+          // a request credit is taken before polling, so that the ntps are
+          // read only when their data can be sent right away
+          return ss::get_units(_request_credits, 1)
+            .then([this](ss::semaphore_units<> request_credit) {
+                drop_moved_sources();
+                auto reducer = [](pending_request acc, opt_req_data x) {
+                    if (x.has_value()) {
+                        acc.reqs.emplace_back(std::move(x->data));
+                        acc.credits.emplace_back(std::move(x->credits));
+                    }
+                    return acc;
+                };
+                return ss::map_reduce(
+                         _sources.begin(),
+                         _sources.end(),
+                         [this](std::pair<const model::ntp, topic_state>& p) {
+                             return route_ntp(p.first, p.second);
+                         },
+                         pending_request{},
+                         std::move(reducer))
+                  .then([this, request_credit = std::move(request_credit)](
+                          pending_request pr) mutable {
+                      if (pr.reqs.empty()) {
                           return ss::now();
                       }
-                      return send_batch(transport.value(), std::move(r));
+                      return send_request(
+                        std::move(pr), std::move(request_credit));
                   });
             });
       });
 }
 
+ss::future<> router::send_request(
+  pending_request pr, ss::semaphore_units<> request_credit) {
+    return get_client().then(
+      [this, pr = std::move(pr), request_credit = std::move(request_credit)](
+        result<supervisor_client_protocol> transport) mutable {
+          if (!transport) {
+              const auto err = transport.error();
+              if (err == rpc::errc::disconnected_endpoint) {
+                  vlog(
+                    coproclog.error,
+                    "Shutting down loop, failed to connect to coproc server");
+                  _abort_source.request_abort();
+              }
+              for (const auto& d : pr.reqs) {
+                  clear_in_flight(d.ntp);
+              }
+              return ss::now();
+          }
+          send_pipelined(
+            transport.value(), std::move(pr), std::move(request_credit));
+          return ss::now();
+      });
+}
+
+void router::send_pipelined(
+  supervisor_client_protocol transport,
+  pending_request pr,
+  ss::semaphore_units<> request_credit) {
+    std::vector<model::ntp> ntps;
+    ntps.reserve(pr.reqs.size());
+    for (const auto& d : pr.reqs) {
+        ntps.push_back(d.ntp);
+    }
+    if (_gate.is_closed()) {
+        for (const auto& ntp : ntps) {
+            clear_in_flight(ntp);
+        }
+        return;
+    }
+    process_batch_request r{.reqs = std::move(pr.reqs)};
+    // the credits are returned once the reply is processed
+    (void)ss::with_gate(
+      _gate,
+      [this,
+       transport,
+       r = std::move(r),
+       ntps = std::move(ntps),
+       credits = std::move(pr.credits),
+       request_credit = std::move(request_credit)]() mutable {
+          return send_batch(transport, std::move(r))
+            .finally([this,
+                      ntps = std::move(ntps),
+                      credits = std::move(credits),
+                      request_credit = std::move(request_credit)] {
+                for (const auto& ntp : ntps) {
+                    clear_in_flight(ntp);
+                }
+            });
+      });
+}
+
+void router::drop_moved_sources() {
+    // An ntp whose log left this shard is routed by the shard it moved to,
+    // once its scripts are registered there
+    absl::erase_if(_sources, [this](const auto& p) {
+        if (_api.local().log_mgr().get(p.first)) {
+            return false;
+        }
+        vlog(
+          coproclog.info, "Ntp no longer managed by this shard: {}", p.first);
+        return true;
+    });
+}
+
+void router::clear_in_flight(const model::ntp& ntp) {
+    if (auto found = _sources.find(ntp); found != _sources.end()) {
+        found->second.head.in_flight = false;
+    }
+}
+
 ss::future<router::opt_req_data>
 router::route_ntp(const model::ntp& ntp, topic_state& ts) {
     /**
      * Making a reader will grab a mutual exclusion lock on reading from the
-     * requested log. This is OK for now since the only topic_ingestion_policy
-     * supported will be 'latest'
+     * requested log. This is OK for now since the ntp is read once for all
+     * of its scripts, from a single offset
+     *
+     * An ntp whose previous data awaits its reply is skipped, and so is one
+     * for which there are not enough byte credits left; the credits of the
+     * bytes actually read are kept until the reply is processed.
      *
      * The last offset is recorded and the request is prepared and returned.
      */
+    if (ts.head.in_flight) {
+        return ss::make_ready_future<opt_req_data>(std::nullopt);
+    }
+    auto credits = ss::try_get_units(_byte_credits, max_read_bytes);
+    if (!credits) {
+        return ss::make_ready_future<opt_req_data>(std::nullopt);
+    }
     return make_reader_cfg(ts.log, ts.head)
-      .then([this, ntp, log = ts.log, sids = ts.scripts](
-              opt_cfg config) mutable {
+      .then([this,
+             ntp,
+             log = ts.log,
+             sids = ts.scripts,
+             credits = std::move(*credits)](opt_cfg config) mutable {
           if (!config) {
               return ss::make_ready_future<opt_req_data>(std::nullopt);
           }
@@ -148,12 +287,14 @@ router::route_ntp(const model::ntp& ntp, topic_state& ts) {
             .then([this, ntp](model::record_batch_reader reader) {
                 return extract_offset(std::move(reader));
             })
-            .then([this, ntp, sids = std::move(sids)](
-                    std::optional<offset_rbr_pair> p) {
+            .then([this,
+                   ntp,
+                   sids = std::move(sids),
+                   credits = std::move(credits)](
+                    std::optional<extracted_data> p) mutable {
                 if (!p) {
                     return opt_req_data(std::nullopt);
                 }
-                auto& [offset, rbr] = *p;
                 auto found = _sources.find(ntp);
                 if (found == _sources.end()) {
                     vlog(
@@ -162,12 +303,24 @@ router::route_ntp(const model::ntp& ntp, topic_state& ts) {
                       ntp);
                     return opt_req_data(std::nullopt);
                 }
-                found->second.head.dirty = offset;
+                found->second.head.dirty = p->last_offset;
+                found->second.head.in_flight = true;
+                // a read returns at least one batch, however large
+                if (p->size_bytes < max_read_bytes) {
+                    credits.return_units(max_read_bytes - p->size_bytes);
+                } else if (p->size_bytes > max_read_bytes) {
+                    credits.adopt(ss::consume_units(
+                      _byte_credits, p->size_bytes - max_read_bytes));
+                }
                 std::vector<script_id> ids(
                   std::make_move_iterator(sids.begin()),
                   std::make_move_iterator(sids.end()));
-                return opt_req_data(process_batch_request::data{
-                  .ids = std::move(ids), .ntp = ntp, .reader = std::move(rbr)});
+                return opt_req_data(routed_data{
+                  .data = process_batch_request::data{
+                    .ids = std::move(ids),
+                    .ntp = ntp,
+                    .reader = std::move(p->reader)},
+                  .credits = std::move(credits)});
             });
       });
 }
@@ -197,12 +350,28 @@ ss::future<> router::process_reply(process_batch_reply r) {
         vlog(coproclog.error, "Erroneous empty response received");
         return ss::now();
     }
+    // the outputs of the reply are appended once per materialized ntp
+    absl::flat_hash_map<model::ntp, std::vector<process_batch_reply::data>>
+      outputs;
+    for (auto& e : r.resps) {
+        if (!model::make_materialized_topic(e.ntp.tp.topic)) {
+            // For now this will signify a null response, which means the
+            // record_batch was is to be filtered out of the
+            // materialized_topic. Mark offset, to continue to next record and
+            // do nothing else.
+            bump_offset(e.ntp, e.id);
+            continue;
+        }
+        auto ntp = e.ntp;
+        outputs[ntp].push_back(std::move(e));
+    }
     return ss::do_with(
-      std::move(r.resps),
-      [this](std::vector<process_batch_reply::data>& resps) mutable {
-          const auto range = boost::irange<size_t>(0, resps.size());
-          return ss::do_for_each(range, [this, &resps](size_t i) {
-              return process_reply_one(std::move(resps[i]));
+      std::move(outputs),
+      [this](absl::flat_hash_map<
+             model::ntp,
+             std::vector<process_batch_reply::data>>& outputs) {
+          return ss::parallel_for_each(outputs, [this](auto& p) {
+              return materialize(p.first, std::move(p.second));
           });
       });
 }
@@ -219,55 +388,154 @@ void router::bump_offset(const model::ntp& src_ntp, const script_id sid) {
         return;
     }
     found->second.head.committed = found->second.head.dirty;
+    found->second.unsaved.emplace(sid);
 }
 
-ss::future<> router::process_reply_one(process_batch_reply::data e) {
-    // Strip the source/dest topics from the materialized topic
-    const auto mt = model::make_materialized_topic(e.ntp.tp.topic);
-    if (!mt) {
-        // For now this will signify a null response, which means the
-        // record_batch was is to be filtered out of the materialized_topic.
-        // Mark offset, to continue to next record and do nothing else.
-        bump_offset(e.ntp, e.id);
+void router::checkpoint() {
+    if (_checkpoint_sem.available_units() > 0) {
+        (void)ss::with_gate(_gate, [this] { return checkpoint_offsets(); });
+    }
+}
+
+ss::future<> router::checkpoint_offsets() {
+    std::vector<std::pair<bytes, model::offset>> offsets;
+    for (auto& [ntp, ts] : _sources) {
+        for (const auto id : ts.unsaved) {
+            offsets.emplace_back(checkpoint_key(id, ntp), ts.head.committed);
+        }
+        ts.unsaved.clear();
+    }
+    if (offsets.empty()) {
         return ss::now();
     }
+    // the kvstore batches the writes issued together into a single append
+    return ss::with_semaphore(
+      _checkpoint_sem, 1, [this, offsets = std::move(offsets)]() mutable {
+          return ss::do_with(
+            std::move(offsets),
+            [this](std::vector<std::pair<bytes, model::offset>>& offsets) {
+                return ss::parallel_for_each(
+                  offsets, [this](std::pair<bytes, model::offset>& p) {
+                      return _api.local().kvs().put(
+                        storage::kvstore::key_space::coproc,
+                        std::move(p.first),
+                        reflection::to_iobuf(p.second));
+                  });
+            });
+      });
+}
+
+std::optional<model::offset>
+router::stored_offset(script_id id, const model::ntp& ntp) {
+    auto value = _api.local().kvs().get(
+      storage::kvstore::key_space::coproc, checkpoint_key(id, ntp));
+    if (!value) {
+        return std::nullopt;
+    }
+    return reflection::adl<model::offset>{}.from(std::move(*value));
+}
+
+void router::remove_stored_offsets(script_id id, std::vector<model::ntp> ntps) {
+    if (ntps.empty() || _gate.is_closed()) {
+        return;
+    }
+    (void)ss::with_gate(_gate, [this, id, ntps = std::move(ntps)]() mutable {
+        return ss::do_with(
+          std::move(ntps), [this, id](std::vector<model::ntp>& ntps) {
+              return ss::parallel_for_each(
+                ntps, [this, id](const model::ntp& ntp) {
+                    return _api.local().kvs().remove(
+                      storage::kvstore::key_space::coproc,
+                      checkpoint_key(id, ntp));
+                });
+          });
+    });
+}
+
+ss::future<> router::materialize(
+  model::ntp ntp, std::vector<process_batch_reply::data> outputs) {
+    // Strip the source/dest topics from the materialized topic
+    const auto mt = model::make_materialized_topic(ntp.tp.topic);
     // The original ntp without the .$<destination>$ part of the topic
-    model::ntp src_ntp(e.ntp.ns, mt->src, e.ntp.tp.partition);
-    // Create the materialized log, the name of the log will be of the
-    // format: <src>.$<destination>$
-    return get_log(e.ntp).then([this,
-                                src_ntp,
-                                id = e.id,
-                                reader = std::move(e.reader)](
-                                 storage::log log) mutable {
-        // Append the requested data to the end of the log
-        storage::log_append_config cfg{
-          .should_fsync = storage::log_append_config::fsync::no,
-          .io_priority = ss::default_priority_class(),
-          .timeout = model::no_timeout};
-        return std::move(reader)
-          .for_each_ref(
-            coproc::reference_window_consumer(
-              model::record_batch_crc_checker(), log.make_appender(cfg)),
-            model::no_timeout)
-          .then(
-            [this, src_ntp, id, log](
-              std::tuple<bool, ss::future<storage::append_result>> t) mutable {
-                /// TODO(rob) NOT ideal to flush on every response.
-                /// Clubhouse ticket 'coprocessor enhancments' filed for this
-                const auto& [crc_parse_success, _] = t;
-                if (!crc_parse_success) {
-                    vlog(
-                      coproclog.warn,
-                      "record_batch failed to pass crc checks, not promoting "
-                      "log offset for source ntp: {}",
-                      src_ntp);
+    model::ntp src_ntp(ntp.ns, mt->src, ntp.tp.partition);
+    struct state {
+        std::vector<process_batch_reply::data> outputs;
+        model::record_batch_reader::data_t batches;
+        // the scripts whose output is appended
+        std::vector<script_id> ids;
+    };
+    return ss::do_with(
+      state{.outputs = std::move(outputs)},
+      [this, ntp = std::move(ntp), src_ntp = std::move(src_ntp)](
+        state& st) mutable {
+          return ss::do_for_each(
+                   st.outputs,
+                   [&st, src_ntp](process_batch_reply::data& e) {
+                       return model::consume_reader_to_memory(
+                                std::move(e.reader), model::no_timeout)
+                         .then([&st, src_ntp, id = e.id](
+                                 model::record_batch_reader::data_t data) {
+                             model::record_batch_crc_checker checker;
+                             for (auto& b : data) {
+                                 (void)checker(b);
+                             }
+                             if (!checker.end_of_stream()) {
+                                 vlog(
+                                   coproclog.warn,
+                                   "record_batch failed to pass crc checks, "
+                                   "not promoting log offset for source "
+                                   "ntp: {}",
+                                   src_ntp);
+                                 return;
+                             }
+                             std::move(
+                               data.begin(),
+                               data.end(),
+                               std::back_inserter(st.batches));
+                             st.ids.push_back(id);
+                         });
+                   })
+            .then([this, &st, ntp] {
+                if (st.batches.empty()) {
                     return ss::now();
                 }
-                bump_offset(src_ntp, id);
-                return log.flush();
+                // Create the materialized log, the name of the log will be
+                // of the format: <src>.$<destination>$
+                return get_log(ntp).then([this, &st, ntp](storage::log log) {
+                    storage::log_append_config cfg{
+                      .should_fsync = storage::log_append_config::fsync::no,
+                      .io_priority = ss::default_priority_class(),
+                      .timeout = model::no_timeout};
+                    auto reader = model::make_memory_record_batch_reader(
+                      std::move(st.batches));
+                    return std::move(reader)
+                      .for_each_ref(log.make_appender(cfg), model::no_timeout)
+                      .then([this, ntp, log](storage::append_result) {
+                          return flush_materialized(ntp, log);
+                      });
+                });
+            })
+            .then([this, &st, src_ntp] {
+                // the outputs are on disk, the input is not read again
+                for (auto id : st.ids) {
+                    bump_offset(src_ntp, id);
+                }
             });
+      });
+}
+
+ss::future<>
+router::flush_materialized(const model::ntp& ntp, storage::log log) {
+    if (auto it = _pending_flushes.find(ntp); it != _pending_flushes.end()) {
+        return it->second.get_future();
+    }
+    auto f = ss::sleep(_flush_window).then([this, ntp, log]() mutable {
+        // the appends from now on wait for the next flush
+        _pending_flushes.erase(ntp);
+        return log.flush();
     });
+    return _pending_flushes.emplace(ntp, std::move(f))
+      .first->second.get_future();
 }
 
 ss::future<router::opt_cfg>
@@ -303,7 +571,6 @@ errc router::add_source(
   const script_id id,
   const model::topic_namespace& tns,
   topic_ingestion_policy p) {
-    // For now only support the 'latest' policy
     if (!is_valid_ingestion_policy(p)) {
         return errc::invalid_ingestion_policy;
     }
@@ -317,8 +584,11 @@ errc router::add_source(
         if (found == _sources.end()) {
             topic_state ts{
               .log = log, .head = topic_offsets(), .scripts = {id}};
+            ts.head.committed = initial_offset(id, ntp, log, p);
             _sources.emplace(ntp, std::move(ts));
         } else {
+            // The ntp is read once for all of its scripts, the new script
+            // joins at the offset already reached
             found->second.scripts.emplace(id);
         }
         vlog(coproclog.info, "Inserted ntp {} id {}", ntp, id);
@@ -326,16 +596,51 @@ errc router::add_source(
     return errc::success;
 }
 
+model::offset router::initial_offset(
+  script_id id,
+  const model::ntp& ntp,
+  storage::log log,
+  topic_ingestion_policy p) {
+    // The offsets are those of the last record processed, 'min' meaning that
+    // the log is read from its start
+    switch (p) {
+    case topic_ingestion_policy::earliest:
+        return model::model_limits<model::offset>::min();
+    case topic_ingestion_policy::stored:
+        // Without a checkpoint, the script starts from the earliest record
+        if (auto stored = stored_offset(id, ntp)) {
+            vlog(
+              coproclog.info,
+              "Resuming script id {} on ntp {} after offset {}",
+              id,
+              ntp,
+              *stored);
+            return *stored;
+        }
+        return model::model_limits<model::offset>::min();
+    case topic_ingestion_policy::latest:
+        return log.offsets().committed_offset;
+    }
+    __builtin_unreachable();
+}
+
 bool router::remove_source(const script_id sid) {
     absl::flat_hash_set<model::ntp> deleted;
-    std::for_each(_sources.begin(), _sources.end(), [&deleted, sid](auto& p) {
-        auto& scripts = p.second.scripts;
-        scripts.erase(sid);
-        vlog(coproclog.info, "Deleted script id: {}", sid);
-        if (scripts.empty()) {
-            deleted.emplace(p.first);
-        }
-    });
+    std::vector<model::ntp> tracked;
+    std::for_each(
+      _sources.begin(), _sources.end(), [&deleted, &tracked, sid](auto& p) {
+          auto& scripts = p.second.scripts;
+          if (scripts.erase(sid) > 0) {
+              tracked.push_back(p.first);
+          }
+          p.second.unsaved.erase(sid);
+          vlog(coproclog.info, "Deleted script id: {}", sid);
+          if (scripts.empty()) {
+              deleted.emplace(p.first);
+          }
+      });
+    // A deregistered script starts over if it is registered again
+    remove_stored_offsets(sid, std::move(tracked));
     // If no more scripts are tracking an ntp, remove the ntp
     absl::erase_if(_sources, [&deleted](const auto& p) {
         return deleted.contains(p.first);
@@ -356,7 +661,7 @@ router::reader_cfg(model::offset start, model::offset end) {
       start,
       end,
       1,
-      32_KiB,
+      max_read_bytes,
       ss::default_priority_class(),
       model::well_known_record_batch_types[1],
       std::nullopt,
@@ -28,6 +28,8 @@
 #include <seastar/core/future.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/core/semaphore.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/timer.hh>
 #include <seastar/net/inet_address.hh>
 #include <seastar/net/socket_defs.hh>
 
@@ -36,24 +38,33 @@
 
 namespace coproc {
 /// Reads data from registered input topics and routes them to the coprocessor
-/// engine connected locally. This is done by polling the registered ntps in a
+/// engine connected locally. There is a router per shard, each with its own
+/// connection to the engine, and it only routes the ntps whose logs are
+/// managed by its shard, so that batches are read and materialized without
+/// crossing cores. This is done by polling the registered ntps in a
 /// loop. Offsets are managed for each coprocessor/input topic so materialized
 /// topics can resume upon last processed record in the case of a failure.
+///
+/// Each poll sends a single request covering every ntp with new data, and
+/// requests are pipelined: the next poll does not wait for the reply. Credits
+/// bound the requests and the bytes in flight to the engine, and an ntp is not
+/// read again until the reply to its last request is processed.
+///
+/// The outputs of a reply are appended to each materialized ntp at once, and
+/// the replies processed within a short window share the flush of the log.
+///
+/// The offsets processed by each script on each ntp are checkpointed to the
+/// kvstore periodically, so that after a restart the scripts registered with
+/// the 'stored' policy resume where they left off.
 class router {
 public:
     router(ss::socket_address, ss::sharded<storage::api>&);
 
     /// Begin the loop on the current shard
-    ss::future<> start() {
-        (void)ss::with_gate(_gate, [this] { return route(); });
-        return ss::now();
-    }
+    ss::future<> start();
 
-    /// Shut down the loop on the current shard
-    ss::future<> stop() {
-        _abort_source.request_abort();
-        return ss::when_all(_gate.close(), _transport.stop()).discard_result();
-    }
+    /// Shut down the loop on the current shard, checkpointing the offsets
+    ss::future<> stop();
 
     errc add_source(
       const script_id, const model::topic_namespace&, topic_ingestion_policy);
@@ -64,39 +75,74 @@ public:
     }
 
 private:
-    using offset_rbr_pair
-      = std::pair<model::offset, model::record_batch_reader>;
-    using opt_req_data = std::optional<process_batch_request::data>;
+    /// The data read from an ntp, from memory
+    struct extracted_data {
+        model::offset last_offset;
+        size_t size_bytes;
+        model::record_batch_reader reader;
+    };
+    /// The data read from an ntp, and the byte credits it holds
+    struct routed_data {
+        process_batch_request::data data;
+        ss::semaphore_units<> credits;
+    };
+    /// The data of the ntps of a request, and the byte credits they hold
+    struct pending_request {
+        std::vector<process_batch_request::data> reqs;
+        std::vector<ss::semaphore_units<>> credits;
+    };
+    using opt_req_data = std::optional<routed_data>;
     using opt_cfg = std::optional<storage::log_reader_config>;
 
     struct topic_offsets {
         model::offset committed{model::model_limits<model::offset>::min()};
         model::offset dirty{model::model_limits<model::offset>::min()};
         ss::semaphore sem_{1};
+        /// Set while a request with data of the ntp awaits its reply
+        bool in_flight{false};
     };
 
     struct topic_state {
-        /// For now the only possible topic_ingestion_policy is latest
         storage::log log;
         topic_offsets head;
         absl::flat_hash_set<script_id> scripts;
+        /// Scripts whose offset moved since the last checkpoint
+        absl::flat_hash_set<script_id> unsaved;
     };
 
     ss::future<result<supervisor_client_protocol>> get_client();
     ss::future<storage::log> get_log(const model::ntp& ntp);
 
     ss::future<> process_reply(process_batch_reply);
-    ss::future<> process_reply_one(process_batch_reply::data);
+    /// Appends the outputs of a reply to a materialized ntp at once, and
+    /// bumps the offsets of their scripts once flushed
+    ss::future<>
+      materialize(model::ntp, std::vector<process_batch_reply::data>);
+    /// Flushes a materialized log after the flush window, once for all the
+    /// appends of the window
+    ss::future<> flush_materialized(const model::ntp&, storage::log);
 
     ss::future<> route();
+    void drop_moved_sources();
     ss::future<opt_req_data> route_ntp(const model::ntp&, topic_state&);
     ss::future<> send_batch(supervisor_client_protocol, process_batch_request);
+    ss::future<> send_request(pending_request, ss::semaphore_units<>);
+    void send_pipelined(
+      supervisor_client_protocol, pending_request, ss::semaphore_units<>);
+    void clear_in_flight(const model::ntp&);
 
-    ss::future<std::optional<offset_rbr_pair>>
+    ss::future<std::optional<extracted_data>>
       extract_offset(model::record_batch_reader);
     void bump_offset(const model::ntp&, const script_id);
 
     ss::future<opt_cfg> make_reader_cfg(storage::log, topic_offsets&);
+    model::offset initial_offset(
+      script_id, const model::ntp&, storage::log, topic_ingestion_policy);
+
+    void checkpoint();
+    ss::future<> checkpoint_offsets();
+    std::optional<model::offset> stored_offset(script_id, const model::ntp&);
+    void remove_stored_offsets(script_id, std::vector<model::ntp>);
     storage::log_reader_config reader_cfg(model::offset, model::offset);
 
 private:
@@ -109,12 +155,25 @@ private:
     ss::abort_source _abort_source;
     uint8_t _connection_attempts{0};
 
+    /// Credits of the requests and of the bytes in flight to the engine
+    ss::semaphore _request_credits;
+    ss::semaphore _byte_credits;
+
+    /// Periodic flush of the offsets to the kvstore, one at a time
+    ss::timer<> _checkpoint_timer;
+    ss::semaphore _checkpoint_sem{1};
+
     /// Core in-memory data structure that manages the relationships between
     /// topics and coprocessor scripts
     absl::flat_hash_map<model::ntp, topic_state> _sources;
 
     /// Connection to the coprocessor engine
     rpc::reconnect_transport _transport;
+
+    /// The flushes of the materialized logs that the appends of the replies
+    /// processed within the window share
+    std::chrono::microseconds _flush_window;
+    absl::flat_hash_map<model::ntp, ss::shared_future<>> _pending_flushes;
 };
 
 } // namespace coproc
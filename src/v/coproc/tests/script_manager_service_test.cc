@@ -183,9 +183,11 @@ FIXTURE_TEST(
     client.connect().get();
     auto dclient = ss::defer([&client] { client.stop().get(); });
 
+    const auto invalid_policy = coproc::topic_ingestion_policy(7);
     const auto resp = coproc_register_topics(
                         client,
-                        {make_enable_req(3289, {{"foo", l}, {"bar", e}}),
+                        {make_enable_req(
+                           3289, {{"foo", l}, {"bar", invalid_policy}}),
                          {make_enable_req(script_id, {{"nogo", l}})}})
                         .get0()
                         .value()
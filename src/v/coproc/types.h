@@ -48,8 +48,9 @@ enum class disable_response_code : int8_t {
 enum class topic_ingestion_policy : int8_t { earliest = 0, stored, latest };
 
 inline bool is_valid_ingestion_policy(topic_ingestion_policy p) {
-    // Other ingestion policies to be implemented at a later time
-    return p == topic_ingestion_policy::latest;
+    return p == topic_ingestion_policy::earliest
+           || p == topic_ingestion_policy::stored
+           || p == topic_ingestion_policy::latest;
 }
 
 /// \brief type to use for registration/deregistration of a topic
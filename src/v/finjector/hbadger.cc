@@ -9,6 +9,8 @@
 
 #include "finjector/hbadger.h"
 
+#include "finjector/latency_probe.h"
+#include "utils/string_switch.h"
 #include "vlog.h"
 
 #include <seastar/util/log.hh>
@@ -19,8 +21,37 @@ namespace finjector {
 
 ss::logger log{"fault_injector"};
 
+latency_probe::type
+latency_probe::method_for_point(std::string_view p) const {
+    return string_switch<type>(p)
+      .match("segment_append", type(point::segment_append))
+      .match("segment_flush", type(point::segment_flush))
+      .match("kvstore_flush", type(point::kvstore_flush))
+      .match("rpc_send", type(point::rpc_send))
+      .match("replicate_dispatch", type(point::replicate_dispatch))
+      .default_match(0);
+}
+
+std::vector<ss::sstring> latency_probe::points() {
+    return {
+      "segment_append",
+      "segment_flush",
+      "kvstore_flush",
+      "rpc_send",
+      "replicate_dispatch"};
+}
+
+latency_probe& shard_local_latency_probe() {
+    static thread_local latency_probe probe;
+    return probe;
+}
+
+honey_badger::honey_badger() {
+    register_probe(latency_probe::name(), &shard_local_latency_probe());
+}
+
 void honey_badger::register_probe(std::string_view view, probe* p) {
-    if (p && p->is_enabled()) {
+    if (p && (p->is_enabled() || p->enabled_in_production())) {
         vlog(log.trace, "Probe registration: {}", view);
         _probes.insert({ss::sstring(view), p});
     } else {
@@ -39,22 +70,37 @@ void honey_badger::set_exception(
   const ss::sstring& module, const ss::sstring& point) {
     if (auto it = _probes.find(module); it != _probes.end()) {
         auto& [_, p] = *it;
+        if (!p->is_enabled()) {
+            vlog(log.debug, "Only delays are injected: {}-{}", module, point);
+            return;
+        }
         vlog(log.debug, "Setting exception probe: {}-{}", module, point);
         p->set_exception(point);
     }
 }
 void honey_badger::set_delay(
-  const ss::sstring& module, const ss::sstring& point) {
+  const ss::sstring& module,
+  const ss::sstring& point,
+  std::chrono::milliseconds delay) {
     if (auto it = _probes.find(module); it != _probes.end()) {
         auto& [_, p] = *it;
-        vlog(log.debug, "Setting delay probe: {}-{}", module, point);
-        p->set_delay(point);
+        vlog(
+          log.debug,
+          "Setting delay probe: {}-{} of {}ms",
+          module,
+          point,
+          delay.count());
+        p->set_delay(point, delay);
     }
 }
 void honey_badger::set_termination(
   const ss::sstring& module, const ss::sstring& point) {
     if (auto it = _probes.find(module); it != _probes.end()) {
         auto& [_, p] = *it;
+        if (!p->is_enabled()) {
+            vlog(log.debug, "Only delays are injected: {}-{}", module, point);
+            return;
+        }
         vlog(log.debug, "Setting termination probe: {}-{}", module, point);
         p->set_termination(point);
     }
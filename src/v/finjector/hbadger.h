@@ -18,9 +18,14 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <chrono>
+
 namespace finjector {
 
 struct probe {
+    /// the delay of a point set without one
+    static constexpr std::chrono::milliseconds default_delay{50};
+
     probe() = default;
     virtual ~probe() = default;
     virtual std::vector<ss::sstring> points() = 0;
@@ -37,11 +42,18 @@ struct probe {
     }
 
     bool is_enabled() const { return operator()(); }
+    /// whether the probe is registered in production builds as well, where
+    /// only its delays are injected
+    virtual bool enabled_in_production() const { return false; }
+
     void set_exception(std::string_view point) {
         _exception_methods |= method_for_point(point);
     }
-    void set_delay(std::string_view point) {
-        _delay_methods |= method_for_point(point);
+    void set_delay(
+      std::string_view point, std::chrono::milliseconds d = default_delay) {
+        const int8_t m = method_for_point(point);
+        _delay_methods |= m;
+        _delays[m] = d;
     }
     void set_termination(std::string_view point) {
         _termination_methods |= method_for_point(point);
@@ -51,22 +63,34 @@ struct probe {
         _exception_methods &= ~m;
         _delay_methods &= ~m;
         _termination_methods &= ~m;
+        _delays.erase(m);
     }
 
 protected:
+    /// the delay set for the method
+    std::chrono::milliseconds delay_for(int8_t method) const {
+        auto it = _delays.find(method);
+        return it == _delays.end() ? default_delay : it->second;
+    }
+
     int8_t _exception_methods = 0;
     int8_t _delay_methods = 0;
     int8_t _termination_methods = 0;
+    absl::flat_hash_map<int8_t, std::chrono::milliseconds> _delays;
 };
 
 class honey_badger {
 public:
-    honey_badger() = default;
+    /// registers the latency probe of the shard
+    honey_badger();
     void register_probe(std::string_view, probe* p);
     void deregister_probe(std::string_view);
 
     void set_exception(const ss::sstring& module, const ss::sstring& point);
-    void set_delay(const ss::sstring& module, const ss::sstring& point);
+    void set_delay(
+      const ss::sstring& module,
+      const ss::sstring& point,
+      std::chrono::milliseconds = probe::default_delay);
     void set_termination(const ss::sstring& module, const ss::sstring& point);
     void unset(const ss::sstring& module, const ss::sstring& point);
     absl::flat_hash_map<ss::sstring, std::vector<ss::sstring>> points() const;
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "finjector/hbadger.h"
+#include "likely.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/sleep.hh>
+
+namespace finjector {
+
+/**
+ * Delays injected on the disk and network paths, to reproduce slow disks and
+ * slow followers, e.g. with the admin api
+ *
+ *    POST /v1/failure-probes/finjector::latency/segment_flush/delay?ms=200
+ *
+ * every flush of a segment on every shard then takes 200ms longer. Unlike the
+ * failure probes, the latency probe is registered in production builds as
+ * well, as the cost of a point that is not delayed is a branch. Points only
+ * take delays, exceptions and terminations are not injected.
+ */
+class latency_probe final : public probe {
+public:
+    using type = int8_t;
+
+    static constexpr std::string_view name() { return "finjector::latency"; }
+
+    enum class point : type {
+        /// a batch written to the appender of a segment
+        segment_append = 1,
+        /// the flush of the appender of a segment
+        segment_flush = 2,
+        /// the write and flush of the pending ops of the kvstore
+        kvstore_flush = 4,
+        /// a request written to an rpc connection
+        rpc_send = 8,
+        /// an append entries request of the leader to a follower
+        replicate_dispatch = 16,
+    };
+
+    type method_for_point(std::string_view) const final;
+    std::vector<ss::sstring> points() final;
+    bool enabled_in_production() const final { return true; }
+
+    bool is_delayed(point p) const { return _delay_methods & type(p); }
+
+    ss::future<> delay(point p) {
+        if (likely(!is_delayed(p))) {
+            return ss::now();
+        }
+        return ss::sleep(delay_for(type(p)));
+    }
+};
+
+latency_probe& shard_local_latency_probe();
+
+} // namespace finjector
@@ -0,0 +1,206 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "hashing/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+// The crc32 instruction has a latency of 3 cycles but a throughput of one per
+// cycle, so a single dependency chain runs at a third of the speed of the
+// unit. The input is split in three streams of the same length whose crcs are
+// computed in an interleaved way and folded together afterwards, as in
+// https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/crc-iscsi-polynomial-crc32-instruction-paper.pdf
+
+namespace internal {
+
+// castagnoli polynomial, reflected
+static constexpr uint32_t crc32c_poly = 0x82f63b78;
+
+// a * b modulo p, reflected
+static uint32_t multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = uint32_t(1) << 31;
+    uint32_t p = 0;
+    while (m) {
+        if (a & m) {
+            p ^= b;
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ crc32c_poly : b >> 1;
+    }
+    return p;
+}
+
+// x^(8 * n) modulo p, reflected
+static uint32_t x8nmodp(size_t n) {
+    uint32_t x = uint32_t(1) << 31; // x^0
+    uint32_t sq = uint32_t(1) << 23; // x^8
+    for (; n; n >>= 1) {
+        if (n & 1) {
+            x = multmodp(sq, x);
+        }
+        sq = multmodp(sq, sq);
+    }
+    return x;
+}
+
+/// multiplication of a crc register by x^(8 * len), a byte at a time
+class crc32c_shift {
+public:
+    explicit crc32c_shift(size_t len) {
+        const auto x = x8nmodp(len);
+        for (size_t i = 0; i < _table.size(); ++i) {
+            for (uint32_t b = 0; b < 256; ++b) {
+                _table[i][b] = multmodp(x, b << (8 * i));
+            }
+        }
+    }
+
+    uint32_t operator()(uint32_t crc) const {
+        return _table[0][crc & 0xff] ^ _table[1][(crc >> 8) & 0xff]
+               ^ _table[2][(crc >> 16) & 0xff] ^ _table[3][crc >> 24];
+    }
+
+private:
+    std::array<std::array<uint32_t, 256>, 4> _table;
+};
+
+// lengths of a stream of the interleaved blocks
+static constexpr size_t crc32c_long = 8192;
+static constexpr size_t crc32c_short = 256;
+
+static const crc32c_shift& shift_long() {
+    static const crc32c_shift s(crc32c_long);
+    return s;
+}
+static const crc32c_shift& shift_short() {
+    static const crc32c_shift s(crc32c_short);
+    return s;
+}
+
+static uint64_t load_u64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+#if defined(__x86_64__)
+#define CRC32C_HW 1
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+
+CRC32C_TARGET static inline uint32_t crc32c_u8(uint32_t crc, uint8_t v) {
+    return _mm_crc32_u8(crc, v);
+}
+CRC32C_TARGET static inline uint32_t crc32c_u64(uint32_t crc, uint64_t v) {
+    return static_cast<uint32_t>(_mm_crc32_u64(crc, v));
+}
+
+static bool crc32c_hw_supported() { return __builtin_cpu_supports("sse4.2"); }
+#elif defined(__aarch64__)
+#define CRC32C_HW 1
+#define CRC32C_TARGET __attribute__((target("+crc")))
+
+CRC32C_TARGET static inline uint32_t crc32c_u8(uint32_t crc, uint8_t v) {
+    return __crc32cb(crc, v);
+}
+CRC32C_TARGET static inline uint32_t crc32c_u64(uint32_t crc, uint64_t v) {
+    return __crc32cd(crc, v);
+}
+
+static bool crc32c_hw_supported() {
+    return getauxval(AT_HWCAP) & HWCAP_CRC32;
+}
+#endif
+
+#ifdef CRC32C_HW
+// crc of the blocks of three streams of len bytes each
+CRC32C_TARGET static inline void crc32c_blocks(
+  uint32_t& crc,
+  const uint8_t*& p,
+  size_t& n,
+  size_t len,
+  const crc32c_shift& shift) {
+    while (n >= 3 * len) {
+        uint32_t c0 = crc;
+        uint32_t c1 = 0;
+        uint32_t c2 = 0;
+        const uint8_t* end = p + len;
+        do {
+            c0 = crc32c_u64(c0, load_u64(p));
+            c1 = crc32c_u64(c1, load_u64(p + len));
+            c2 = crc32c_u64(c2, load_u64(p + 2 * len));
+            p += 8;
+        } while (p < end);
+        crc = shift(shift(c0) ^ c1) ^ c2;
+        p += 2 * len;
+        n -= 3 * len;
+    }
+}
+
+CRC32C_TARGET static uint32_t
+crc32c_hw(uint32_t crc, const uint8_t* p, size_t n) {
+    crc = ~crc;
+    // align the words to be read
+    while (n && reinterpret_cast<uintptr_t>(p) & 7) { // NOLINT
+        crc = crc32c_u8(crc, *p++);
+        --n;
+    }
+    crc32c_blocks(crc, p, n, crc32c_long, shift_long());
+    crc32c_blocks(crc, p, n, crc32c_short, shift_short());
+    for (; n >= 8; n -= 8, p += 8) {
+        crc = crc32c_u64(crc, load_u64(p));
+    }
+    for (; n; --n) {
+        crc = crc32c_u8(crc, *p++);
+    }
+    return ~crc;
+}
+#endif
+
+static uint32_t crc32c_sw(uint32_t crc, const uint8_t* data, size_t size) {
+    return crc32c::Extend(crc, data, size);
+}
+
+using crc32c_fn = uint32_t (*)(uint32_t, const uint8_t*, size_t);
+
+static crc32c_fn select_crc32c() {
+#ifdef CRC32C_HW
+    if (crc32c_hw_supported()) {
+        // built before the first checksum rather than within it
+        shift_long();
+        shift_short();
+        return crc32c_hw;
+    }
+#endif
+    return crc32c_sw;
+}
+
+// selected on first use, crcs may be computed by static initializers
+static crc32c_fn crc32c_impl() {
+    static const crc32c_fn impl = select_crc32c();
+    return impl;
+}
+
+} // namespace internal
+
+uint32_t crc32c_extend(uint32_t crc, const uint8_t* data, size_t size) {
+    return internal::crc32c_impl()(crc, data, size);
+}
+
+bool crc32c_hardware_accelerated() {
+    return internal::crc32c_impl() != internal::crc32c_sw;
+}
@@ -12,8 +12,18 @@
 #pragma once
 #include <crc32c/crc32c.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 
+/// \brief extends crc, as crc32c::Extend, with the crc32 instructions of
+/// the cpu (sse4.2 or armv8 crc) over three interleaved streams when they are
+/// available, and falls back to crc32c::Extend otherwise
+uint32_t crc32c_extend(uint32_t crc, const uint8_t* data, size_t size);
+
+/// \brief whether crc32c_extend uses the crc32 instructions of the cpu
+bool crc32c_hardware_accelerated();
+
 class crc32 {
 public:
     template<typename T, typename = std::enable_if_t<std::is_integral_v<T>, T>>
@@ -22,7 +32,7 @@ public:
         extend(reinterpret_cast<const uint8_t*>(&num), sizeof(T));
     }
     void extend(const uint8_t* data, size_t size) {
-        _crc = crc32c::Extend(_crc, data, size);
+        _crc = crc32c_extend(_crc, data, size);
     }
     void extend(const char* data, size_t size) {
         extend(
@@ -31,6 +41,15 @@ public:
           size);
     }
 
+    /// \brief extends the crc over the fragments of [begin, end), as if they
+    /// were one buffer. The fragments must provide get() and size()
+    template<typename Iterator>
+    void extend_fragments(Iterator begin, Iterator end) {
+        for (; begin != end; ++begin) {
+            extend(begin->get(), begin->size());
+        }
+    }
+
     uint32_t value() const { return _crc; }
 
 private:
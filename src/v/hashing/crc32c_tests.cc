@@ -0,0 +1,78 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE crc32c
+#include "hashing/crc32c.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <random>
+#include <string_view>
+#include <vector>
+
+static std::vector<uint8_t> random_bytes(size_t n) {
+    std::mt19937 gen(n);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> v(n);
+    for (auto& b : v) {
+        b = static_cast<uint8_t>(dist(gen));
+    }
+    return v;
+}
+
+BOOST_AUTO_TEST_CASE(known_value) {
+    // check value of the castagnoli crc
+    constexpr std::string_view digits = "123456789";
+    crc32 crc;
+    crc.extend(digits.data(), digits.size());
+    BOOST_CHECK_EQUAL(crc.value(), 0xe3069283);
+}
+
+BOOST_AUTO_TEST_CASE(same_as_library_for_all_lengths_and_alignments) {
+    BOOST_TEST_MESSAGE(
+      "hardware accelerated: " << crc32c_hardware_accelerated());
+    // covers the long and short interleaved blocks and their tails
+    const auto data = random_bytes(3 * 8192 + 3 * 256 + 64);
+    std::vector<size_t> sizes;
+    for (size_t n = 0; n < 1024; ++n) {
+        sizes.push_back(n);
+    }
+    for (size_t n = 3 * 8192 - 16; n <= data.size() - 8; ++n) {
+        sizes.push_back(n);
+    }
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (auto n : sizes) {
+            BOOST_REQUIRE_EQUAL(
+              crc32c_extend(0x1234, data.data() + offset, n),
+              crc32c::Extend(0x1234, data.data() + offset, n));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(extend_in_parts) {
+    const auto data = random_bytes(100'000);
+    struct fragment {
+        const uint8_t* p;
+        size_t n;
+        const uint8_t* get() const { return p; }
+        size_t size() const { return n; }
+    };
+    std::vector<fragment> fragments;
+    for (size_t i = 0, n = 1; i < data.size(); i += n, n = n * 3 + 1) {
+        fragments.push_back({data.data() + i, std::min(n, data.size() - i)});
+    }
+    crc32 parts;
+    parts.extend_fragments(fragments.begin(), fragments.end());
+    crc32 whole;
+    whole.extend(data.data(), data.size());
+    BOOST_CHECK_EQUAL(parts.value(), whole.value());
+    BOOST_CHECK_EQUAL(
+      whole.value(), crc32c::Extend(0, data.data(), data.size()));
+}
@@ -18,6 +18,9 @@
 
 #include <boost/crc.hpp>
 
+#include <algorithm>
+#include <vector>
+
 static constexpr size_t step_bytes = 57;
 
 PERF_TEST(boost_crc16_fn, header_hash) {
@@ -72,3 +75,49 @@ PERF_TEST(xx64_twang_fn, header_hash) {
     perf_tests::do_not_optimize(o);
     perf_tests::stop_measuring_time();
 }
+
+// large batches, as checksummed on produce and when parsing segments
+static constexpr size_t batch_bytes = 128 * 1024;
+
+PERF_TEST(crc32c_library_fn, batch_hash) {
+    auto buffer = random_generators::gen_alphanum_string(batch_bytes);
+    perf_tests::start_measuring_time();
+    auto o = crc32c::Extend(
+      0,
+      // NOLINTNEXTLINE
+      reinterpret_cast<const uint8_t*>(buffer.data()),
+      buffer.size());
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(crc32c_interleaved_fn, batch_hash) {
+    auto buffer = random_generators::gen_alphanum_string(batch_bytes);
+    crc32 crc;
+    perf_tests::start_measuring_time();
+    crc.extend(buffer.data(), buffer.size());
+    auto o = crc.value();
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(crc32c_fragments_fn, batch_hash) {
+    // the fragments of an iobuf holding a batch read from the network
+    struct fragment {
+        ss::sstring buf;
+        const char* get() const { return buf.data(); }
+        size_t size() const { return buf.size(); }
+    };
+    std::vector<fragment> fragments;
+    for (size_t n = 0, sz = 512; n < batch_bytes; n += sz, sz *= 2) {
+        fragments.push_back(
+          {random_generators::gen_alphanum_string(
+            std::min(sz, batch_bytes - n))});
+    }
+    crc32 crc;
+    perf_tests::start_measuring_time();
+    crc.extend_fragments(fragments.begin(), fragments.end());
+    auto o = crc.value();
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
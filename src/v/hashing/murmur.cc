@@ -378,3 +378,40 @@ void murmurhash3_x64_128(
     ((uint64_t*)out)[0] = h1;
     ((uint64_t*)out)[1] = h2;
 }
+
+uint32_t murmurhash2(const void* key, std::size_t len, uint32_t seed) {
+    const uint8_t* data = (const uint8_t*)key;
+    const uint32_t m = 0x5bd1e995;
+    const int r = 24;
+
+    uint32_t h = seed ^ uint32_t(len);
+
+    // the blocks are read little endian, whatever the platform
+    const std::size_t nblocks = len / 4;
+    for (std::size_t i = 0; i < nblocks; ++i) {
+        const uint8_t* b = data + i * 4;
+        uint32_t k = uint32_t(b[0]) | (uint32_t(b[1]) << 8)
+                     | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h *= m;
+        h ^= k;
+    }
+
+    const uint8_t* tail = data + nblocks * 4;
+    switch (len & 3) {
+    case 3:
+        h ^= uint32_t(tail[2]) << 16;
+    case 2:
+        h ^= uint32_t(tail[1]) << 8;
+    case 1:
+        h ^= uint32_t(tail[0]);
+        h *= m;
+    };
+
+    h ^= h >> 13;
+    h *= m;
+    h ^= h >> 15;
+    return h;
+}
@@ -34,3 +34,11 @@ void murmurhash3_x64_128(
   std::size_t len,
   void* out,
   uint32_t seed = kDefaultHashingSeed);
+
+// seed of the murmur2 hash of the kafka java client
+constexpr static const uint32_t kKafkaMurmur2Seed = 0x9747b28c;
+
+// murmur2 as implemented by the kafka java client, which partitions keyed
+// records with it
+uint32_t murmurhash2(
+  const void* key, std::size_t len, uint32_t seed = kKafkaMurmur2Seed);
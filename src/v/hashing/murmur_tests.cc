@@ -0,0 +1,32 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE murmur
+#include "hashing/murmur.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string_view>
+#include <utility>
+
+BOOST_AUTO_TEST_CASE(murmur2_same_as_kafka_java_client) {
+    // signed hashes of the kafka java client's Utils.murmur2
+    const std::pair<std::string_view, int32_t> cases[] = {
+      {"21", -973932308},
+      {"foobar", -790332482},
+      {"a-little-bit-long-string", -985981536},
+      {"a-little-bit-longer-string", -1486304829},
+      {"lkjh234lh9fiuh90y23oiuhsafujhadof229phr9h19h89h8", -58897971},
+      {"abc", 479470107},
+    };
+    for (const auto& [key, expected] : cases) {
+        BOOST_CHECK_EQUAL(
+          int32_t(murmurhash2(key.data(), key.size())), expected);
+    }
+}
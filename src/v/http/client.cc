@@ -24,6 +24,7 @@ client::client(const rpc::base_transport::configuration& cfg)
 ss::future<client::request_response_t>
 client::make_request(client::request_header&& header) {
     vlog(http_log.trace, "client.make_request {}", header);
+    _reusable = false;
     auto req = ss::make_shared<request_stream>(this, std::move(header));
 
     auto res = ss::make_shared<response_stream>(this);
@@ -144,6 +145,10 @@ ss::future<> client::response_stream::do_recv_some(iobuf& result) {
 
           result.append(std::move(out));
           _buffer.trim_front(noctets);
+          if (_parser.is_done()) {
+              // the bytes past the response would belong to no request
+              _client->_reusable = _parser.keep_alive() && _buffer.empty();
+          }
           if (!_buffer.empty()) {
               vlog(
                 http_log.trace,
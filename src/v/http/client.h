@@ -59,6 +59,15 @@ public:
 
     explicit client(const rpc::base_transport::configuration& cfg);
 
+    using rpc::base_transport::is_valid;
+    using rpc::base_transport::shutdown;
+    using rpc::base_transport::stop;
+
+    /// true once the response of the last request was fully received on a
+    /// connection kept alive, so that the connection may serve another
+    /// request
+    bool is_reusable() const { return _reusable && is_valid(); }
+
     // Response state machine
     class response_stream {
     public:
@@ -143,6 +152,8 @@ private:
     template<class BufferSeq>
     static ss::future<>
     forward(rpc::batched_output_stream& stream, BufferSeq&& seq);
+
+    bool _reusable{false};
 };
 
 template<class BufferSeq>
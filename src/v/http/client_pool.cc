@@ -0,0 +1,195 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "http/client_pool.h"
+
+#include "http/logger.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "vlog.h"
+
+#include <seastar/core/gate.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/metrics.hh>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+
+namespace http {
+
+client_pool::lease::lease(
+  client_pool* pool,
+  host* h,
+  ss::semaphore_units<> units,
+  std::unique_ptr<client> c)
+  : _pool(pool)
+  , _host(h)
+  , _units(std::move(units))
+  , _client(std::move(c)) {
+    ++_pool->_leased;
+}
+
+client_pool::lease::~lease() {
+    if (_client) {
+        --_pool->_leased;
+        // before the units, so that the next waiter finds the connection
+        _pool->release(*_host, std::move(_client));
+    }
+}
+
+client_pool::client_pool(configuration cfg)
+  : _cfg(std::move(cfg)) {
+    _idle_timer.set_callback([this] { evict_idle(); });
+    _idle_timer.arm_periodic(_cfg.idle_timeout / 2);
+    if (!_cfg.disable_metrics) {
+        setup_metrics();
+    }
+}
+
+ss::future<client_pool::lease>
+client_pool::acquire(const rpc::base_transport::configuration& cfg) {
+    if (_stopping) {
+        return ss::make_exception_future<lease>(ss::gate_closed_exception());
+    }
+    auto key = fmt::format(
+      "{}/{}", cfg.server_addr, cfg.tls_sni_hostname.value_or(""));
+    auto it = _hosts.find(key);
+    if (it == _hosts.end()) {
+        it = _hosts
+               .emplace(
+                 std::move(key),
+                 std::make_unique<host>(_cfg.max_connections_per_host))
+               .first;
+    }
+    auto h = it->second.get();
+    return ss::get_units(h->connections, 1)
+      .then([this, h, cfg](ss::semaphore_units<> units) {
+          while (!h->idle.empty()) {
+              auto c = std::move(h->idle.back().c);
+              h->idle.pop_back();
+              if (c->is_reusable()) {
+                  ++_stats.reused;
+                  return lease(this, h, std::move(units), std::move(c));
+              }
+              // closed by the server while idle
+              close(std::move(c));
+          }
+          ++_stats.created;
+          return lease(
+            this, h, std::move(units), std::make_unique<client>(cfg));
+      });
+}
+
+void client_pool::release(host& h, std::unique_ptr<client> c) {
+    if (!c->is_reusable()) {
+        close(std::move(c));
+        return;
+    }
+    h.idle.push_back(idle_client{std::move(c), clock_type::now()});
+}
+
+void client_pool::evict_idle() {
+    const auto deadline = clock_type::now() - _cfg.idle_timeout;
+    for (auto& [key, h] : _hosts) {
+        auto end = std::find_if(
+          h->idle.begin(), h->idle.end(), [deadline](const idle_client& i) {
+              return i.since > deadline;
+          });
+        for (auto i = h->idle.begin(); i != end; ++i) {
+            vlog(http_log.trace, "closing idle connection to {}", key);
+            ++_stats.evicted;
+            close(std::move(i->c));
+        }
+        h->idle.erase(h->idle.begin(), end);
+    }
+}
+
+void client_pool::close(std::unique_ptr<client> c) {
+    (void)ss::with_gate(_gate, [c = std::move(c)]() mutable {
+        auto& ref = *c;
+        return ref.stop().handle_exception([](std::exception_ptr e) {
+            vlog(http_log.debug, "error closing connection: {}", e);
+        }).finally([c = std::move(c)] {});
+    });
+}
+
+ss::future<> client_pool::stop() {
+    _stopping = true;
+    _idle_timer.cancel();
+    return ss::do_for_each(
+             _hosts,
+             [this](auto& entry) {
+                 auto& h = *entry.second;
+                 // the units of all leases, returned once they are dropped
+                 return ss::get_units(
+                          h.connections, _cfg.max_connections_per_host)
+                   .then([this, &h](ss::semaphore_units<>) {
+                       for (auto& i : h.idle) {
+                           close(std::move(i.c));
+                       }
+                       h.idle.clear();
+                   });
+             })
+      .then([this] { return _gate.close(); });
+}
+
+void client_pool::setup_metrics() {
+    namespace sm = ss::metrics;
+    std::vector<sm::label_instance> labels{sm::label("pool")(_cfg.name)};
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("http:client_pool"),
+      {
+        sm::make_derive(
+          "connections_created",
+          [this] { return _stats.created; },
+          sm::description("Number of connections opened by the pool"),
+          labels),
+        sm::make_derive(
+          "connections_reused",
+          [this] { return _stats.reused; },
+          sm::description("Number of requests served by a connection kept "
+                          "alive"),
+          labels),
+        sm::make_derive(
+          "connections_evicted",
+          [this] { return _stats.evicted; },
+          sm::description("Number of connections closed once idle"),
+          labels),
+        sm::make_gauge(
+          "connections_leased",
+          [this] { return _leased; },
+          sm::description("Number of connections serving a request"),
+          labels),
+        sm::make_gauge(
+          "connections_idle",
+          [this] {
+              size_t n = 0;
+              for (auto& [_, h] : _hosts) {
+                  n += h->idle.size();
+              }
+              return n;
+          },
+          sm::description("Number of connections kept alive while idle"),
+          labels),
+        sm::make_gauge(
+          "waiters",
+          [this] {
+              size_t n = 0;
+              for (auto& [_, h] : _hosts) {
+                  n += h->connections.waiters();
+              }
+              return n;
+          },
+          sm::description("Number of requests waiting for a connection"),
+          labels),
+      });
+}
+
+} // namespace http
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "http/client.h"
+#include "rpc/transport.h"
+#include "rpc/types.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/core/timer.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace http {
+
+/**
+ * The connections of a shard to http servers, kept alive between requests.
+ *
+ * A lease gives a client to a single request at a time. Once the lease is
+ * dropped the client goes back to the idle connections of its host if the
+ * whole response was received on a connection kept alive, and is closed
+ * otherwise. The most recently used idle connection is leased first, so
+ * that the connections left idle for the idle timeout are closed.
+ *
+ * The leases of a host are bounded, the requests past the bound wait for a
+ * lease to be dropped.
+ */
+class client_pool {
+    struct host;
+
+public:
+    using clock_type = ss::lowres_clock;
+
+    struct configuration {
+        /// the label of the metrics of the pool
+        ss::sstring name;
+        size_t max_connections_per_host = 16;
+        clock_type::duration idle_timeout = std::chrono::seconds(30);
+        rpc::metrics_disabled disable_metrics = rpc::metrics_disabled::no;
+    };
+
+    struct stats {
+        /// the clients created, each of which connects once
+        uint64_t created{0};
+        /// the leases given an idle connection
+        uint64_t reused{0};
+        /// the idle connections closed by the idle timeout
+        uint64_t evicted{0};
+    };
+
+    class lease {
+    public:
+        lease(lease&&) noexcept = default;
+        lease& operator=(lease&&) noexcept = default;
+        lease(const lease&) = delete;
+        lease& operator=(const lease&) = delete;
+        ~lease();
+
+        client& operator*() { return *_client; }
+        client* operator->() { return _client.get(); }
+
+    private:
+        friend client_pool;
+
+        lease(
+          client_pool*, host*, ss::semaphore_units<>, std::unique_ptr<client>);
+
+        client_pool* _pool;
+        host* _host;
+        ss::semaphore_units<> _units;
+        std::unique_ptr<client> _client;
+    };
+
+    explicit client_pool(configuration);
+    client_pool(const client_pool&) = delete;
+    client_pool& operator=(const client_pool&) = delete;
+    client_pool(client_pool&&) = delete;
+    client_pool& operator=(client_pool&&) = delete;
+    ~client_pool() = default;
+
+    /// a client of the server of the configuration, connected by its first
+    /// request unless it is kept alive already
+    ss::future<lease> acquire(const rpc::base_transport::configuration&);
+
+    /// waits for the leases to be dropped and closes the connections
+    ss::future<> stop();
+
+    const stats& get_stats() const { return _stats; }
+
+private:
+    struct idle_client {
+        std::unique_ptr<client> c;
+        clock_type::time_point since;
+    };
+
+    struct host {
+        explicit host(size_t max_connections)
+          : connections(max_connections) {}
+
+        ss::semaphore connections;
+        /// the least recently used first
+        std::vector<idle_client> idle;
+    };
+
+    void release(host&, std::unique_ptr<client>);
+    void evict_idle();
+    void close(std::unique_ptr<client>);
+    void setup_metrics();
+
+    configuration _cfg;
+    absl::flat_hash_map<ss::sstring, std::unique_ptr<host>> _hosts;
+    stats _stats;
+    size_t _leased{0};
+    bool _stopping{false};
+    ss::timer<clock_type> _idle_timer;
+    ss::gate _gate;
+    ss::metrics::metric_groups _metrics;
+};
+
+} // namespace http
@@ -11,6 +11,7 @@
 #include "bytes/iobuf_parser.h"
 #include "http/chunk_encoding.h"
 #include "http/client.h"
+#include "http/client_pool.h"
 #include "rpc/transport.h"
 #include "seastarx.h"
 
@@ -245,6 +246,46 @@ SEASTAR_TEST_CASE(test_http_PUT_roundtrip) {
     });
 }
 
+SEASTAR_TEST_CASE(test_client_pool_keep_alive) {
+    return ss::async([] {
+        auto config = transport_configuration();
+        auto server = ss::make_shared<ss::httpd::http_server_control>();
+        server->start().get();
+        server->set_routes(set_routes).get();
+        server->listen(config.server_addr).get();
+        http::client_pool pool({
+          .name = "test",
+          .max_connections_per_host = 1,
+          .disable_metrics = rpc::metrics_disabled::yes,
+        });
+
+        for (int i = 0; i < 3; ++i) {
+            auto lease = pool.acquire(config).get0();
+            http::client::request_header header;
+            header.method(boost::beast::http::verb::get);
+            header.target("/get");
+            header.insert(boost::beast::http::field::host, config.server_addr);
+            auto [req_stream, resp_stream]
+              = lease->make_request(std::move(header)).get0();
+            req_stream->send_some(iobuf()).get();
+            req_stream->send_eof().get();
+            while (!resp_stream->is_done()) {
+                resp_stream->recv_some().get();
+            }
+            BOOST_REQUIRE_EQUAL(
+              resp_stream->get_headers().result(),
+              boost::beast::http::status::ok);
+            BOOST_REQUIRE(lease->is_reusable());
+        }
+
+        BOOST_REQUIRE_EQUAL(pool.get_stats().created, 1);
+        BOOST_REQUIRE_EQUAL(pool.get_stats().reused, 2);
+
+        pool.stop().get();
+        server->stop().get();
+    });
+}
+
 /// Simple tcp server that can receive pre-defined request and
 /// reply with pre-defined response.
 /// Seastar.Httpd doesn't support chunked encoding at the moment
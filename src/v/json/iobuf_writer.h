@@ -0,0 +1,37 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "json/json.h"
+
+namespace json {
+
+/// rapidjson output stream into the fragments of an iobuf, so that a
+/// document is serialized without a contiguous buffer to grow and copy
+class iobuf_ostream {
+public:
+    using Ch = char;
+
+    void Put(Ch c) { _buf.append(&c, 1); }
+    void Flush() {}
+
+    size_t size_bytes() const { return _buf.size_bytes(); }
+    iobuf release() && { return std::move(_buf); }
+
+private:
+    iobuf _buf;
+};
+
+using iobuf_writer = rapidjson::Writer<iobuf_ostream>;
+
+} // namespace json
@@ -9,50 +9,58 @@
 
 #include "json/json.h"
 
+#include "json/iobuf_writer.h"
+
 namespace json {
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, short v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, short v) {
     w.Int(v);
 }
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, bool v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, bool v) {
     w.Bool(v);
 }
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, long long v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, long long v) {
     w.Int64(v);
 }
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, int v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, int v) {
     w.Int(v);
 }
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, unsigned int v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, unsigned int v) {
     w.Uint(v);
 }
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, long v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, long v) {
     w.Int64(v);
 }
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, unsigned long v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, unsigned long v) {
     w.Uint64(v);
 }
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, double v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, double v) {
     w.Double(v);
 }
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, std::string_view v) {
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, std::string_view v) {
     w.String(v.data(), v.size());
 }
 
+template<typename Buffer>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const ss::socket_address& v) {
+  rapidjson::Writer<Buffer>& w, const ss::socket_address& v) {
     w.StartObject();
 
     std::ostringstream a;
@@ -72,8 +80,9 @@ void rjson_serialize(
     w.EndObject();
 }
 
+template<typename Buffer>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const unresolved_address& v) {
+  rapidjson::Writer<Buffer>& w, const unresolved_address& v) {
     w.StartObject();
 
     w.Key("address");
@@ -85,11 +94,32 @@ void rjson_serialize(
     w.EndObject();
 }
 
+template<typename Buffer>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w,
-  const std::chrono::milliseconds& v) {
+  rapidjson::Writer<Buffer>& w, const std::chrono::milliseconds& v) {
     uint64_t _tmp = v.count();
     rjson_serialize(w, _tmp);
 }
 
+#define RJSON_SERIALIZE_INSTANTIATE(...)                                       \
+    template void rjson_serialize(                                             \
+      rapidjson::Writer<rapidjson::StringBuffer>&, __VA_ARGS__);               \
+    template void rjson_serialize(                                             \
+      rapidjson::Writer<iobuf_ostream>&, __VA_ARGS__);
+
+RJSON_SERIALIZE_INSTANTIATE(short)
+RJSON_SERIALIZE_INSTANTIATE(bool)
+RJSON_SERIALIZE_INSTANTIATE(long long)
+RJSON_SERIALIZE_INSTANTIATE(int)
+RJSON_SERIALIZE_INSTANTIATE(unsigned int)
+RJSON_SERIALIZE_INSTANTIATE(long)
+RJSON_SERIALIZE_INSTANTIATE(unsigned long)
+RJSON_SERIALIZE_INSTANTIATE(double)
+RJSON_SERIALIZE_INSTANTIATE(std::string_view)
+RJSON_SERIALIZE_INSTANTIATE(const ss::socket_address&)
+RJSON_SERIALIZE_INSTANTIATE(const unresolved_address&)
+RJSON_SERIALIZE_INSTANTIATE(const std::chrono::milliseconds&)
+
+#undef RJSON_SERIALIZE_INSTANTIATE
+
 } // namespace json
@@ -40,46 +40,59 @@
 
 namespace json {
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, short v);
+// the serializers take a writer into any rapidjson output stream, e.g. a
+// rapidjson::StringBuffer or a json::iobuf_ostream. those of the fundamental
+// types are instantiated for both in json.cc
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, bool v);
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, short v);
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, long long v);
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, bool v);
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, int v);
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, long long v);
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, unsigned int v);
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, int v);
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, long v);
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, unsigned int v);
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, unsigned long v);
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, long v);
 
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, double v);
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, unsigned long v);
 
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, std::string_view s);
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, double v);
 
+template<typename Buffer>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, std::string_view s);
+
+template<typename Buffer>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const ss::socket_address& v);
+  rapidjson::Writer<Buffer>& w, const ss::socket_address& v);
 
+template<typename Buffer>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const unresolved_address& v);
+  rapidjson::Writer<Buffer>& w, const unresolved_address& v);
 
+template<typename Buffer>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w,
-  const std::chrono::milliseconds& v);
+  rapidjson::Writer<Buffer>& w, const std::chrono::milliseconds& v);
 
-template<typename T, typename = std::enable_if_t<std::is_enum_v<T>>>
-void rjson_serialize(rapidjson::Writer<rapidjson::StringBuffer>& w, T v) {
+template<
+  typename Buffer,
+  typename T,
+  typename = std::enable_if_t<std::is_enum_v<T>>>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, T v) {
     rjson_serialize(w, static_cast<std::underlying_type_t<T>>(v));
 }
 
-template<typename T>
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const std::optional<T>& v) {
+template<typename Buffer, typename T>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, const std::optional<T>& v) {
     if (v) {
         rjson_serialize(w, *v);
         return;
@@ -87,15 +100,14 @@ void rjson_serialize(
     w.Null();
 }
 
-template<typename T, typename Tag>
+template<typename Buffer, typename T, typename Tag>
 void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const named_type<T, Tag>& v) {
+  rapidjson::Writer<Buffer>& w, const named_type<T, Tag>& v) {
     rjson_serialize(w, v());
 }
 
-template<typename T, typename A>
-void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w, const std::vector<T, A>& v) {
+template<typename Buffer, typename T, typename A>
+void rjson_serialize(rapidjson::Writer<Buffer>& w, const std::vector<T, A>& v) {
     w.StartArray();
     for (const auto& e : v) {
         rjson_serialize(w, e);
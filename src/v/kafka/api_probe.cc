@@ -0,0 +1,90 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/api_probe.h"
+
+#include "config/configuration.h"
+#include "kafka/requests/api_versions_request.h"
+#include "prometheus/prometheus_sanitize.h"
+
+#include <seastar/core/metrics.hh>
+
+namespace kafka {
+
+void api_probe::setup_metrics(
+  ss::metrics::metric_groups& mgs, api_key key, api_version version) {
+    namespace sm = ss::metrics;
+    const node_histograms::label_set node_labels = {
+      {"api_key", ss::to_sstring(key())},
+      {"api_version", ss::to_sstring(version())}};
+    _node_hists = {
+      node_histograms::add(
+        "kafka_request_queue_time_us", node_labels, _queue_time),
+      node_histograms::add(
+        "kafka_request_processing_time_us", node_labels, _processing_time),
+      node_histograms::add(
+        "kafka_response_write_time_us", node_labels, _write_time)};
+    if (!config::shard_local_cfg().enable_shard_latency_metrics()) {
+        return;
+    }
+    std::vector<sm::label_instance> labels = {
+      sm::label("api_key")(key()), sm::label("api_version")(version())};
+    mgs.add_group(
+      prometheus_sanitize::metrics_name("kafka"),
+      {
+        sm::make_histogram(
+          "request_queue_time_us",
+          [this] { return _queue_time.seastar_histogram_logform(); },
+          sm::description(
+            "Time requests waited for their quota throttle and for memory"),
+          labels),
+        sm::make_histogram(
+          "request_processing_time_us",
+          [this] { return _processing_time.seastar_histogram_logform(); },
+          sm::description("Time taken to process requests into responses"),
+          labels),
+        sm::make_histogram(
+          "response_write_time_us",
+          [this] { return _write_time.seastar_histogram_logform(); },
+          sm::description(
+            "Time from a ready response to the end of its write, including "
+            "the wait for the responses before it on the connection"),
+          labels),
+      });
+}
+
+api_probes::api_probes(bool enabled)
+  : _enabled(enabled && !config::shard_local_cfg().disable_metrics()) {
+    for (const auto& api : get_supported_apis()) {
+        _supported.emplace(
+          api.api_key, std::make_pair(api.min_version, api.max_version));
+    }
+}
+
+api_probe* api_probes::get(api_key k, api_version v) {
+    if (!_enabled) {
+        return nullptr;
+    }
+    auto it = _probes.find(key(k(), v()));
+    if (it != _probes.end()) {
+        return it->second.get();
+    }
+    auto supported = _supported.find(k());
+    if (
+      supported == _supported.end() || v() < supported->second.first
+      || v() > supported->second.second) {
+        return nullptr;
+    }
+    auto& p = *_probes.emplace(key(k(), v()), std::make_unique<api_probe>())
+                 .first->second;
+    p.setup_metrics(_metrics, k, v);
+    return &p;
+}
+
+} // namespace kafka
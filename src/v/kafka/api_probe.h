@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "kafka/types.h"
+#include "seastarx.h"
+#include "utils/hdr_hist.h"
+#include "utils/node_histograms.h"
+
+#include <seastar/core/metrics_registration.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace kafka {
+
+/**
+ * Latencies of the requests of an api version on a shard.
+ *
+ * A request first waits for the throttle of the quotas of its client and for
+ * the memory of its admission, it is then processed, and its response waits
+ * for the responses to the requests before it on the connection before it is
+ * written to the socket.
+ *
+ * The histograms are merged into the node histograms, and also exposed per
+ * shard unless enable_shard_latency_metrics is off.
+ */
+class api_probe {
+public:
+    using duration = std::chrono::steady_clock::duration;
+
+    void queued_for(duration d) { _queue_time.record(to_us(d)); }
+    void processed_in(duration d) { _processing_time.record(to_us(d)); }
+    void written_in(duration d) { _write_time.record(to_us(d)); }
+
+    void setup_metrics(ss::metrics::metric_groups&, api_key, api_version);
+
+private:
+    static int64_t to_us(duration d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d)
+          .count();
+    }
+
+    hdr_hist _queue_time;
+    hdr_hist _processing_time;
+    hdr_hist _write_time;
+    std::array<node_histograms::registration, 3> _node_hists;
+};
+
+/**
+ * The api probes of a shard, created on the first request of each supported
+ * api version. The requests of unsupported apis and versions are not
+ * tracked, so that clients do not make up metrics.
+ */
+class api_probes {
+public:
+    /// \brief tracks nothing unless enabled and metrics are not disabled
+    explicit api_probes(bool enabled = true);
+
+    /// \brief the probe of the api version, or null if unsupported
+    api_probe* get(api_key, api_version);
+
+private:
+    using key = std::pair<api_key::type, api_version::type>;
+
+    bool _enabled;
+    /// the min and max supported version of each api
+    absl::flat_hash_map<api_key::type, std::pair<int16_t, int16_t>>
+      _supported;
+    absl::flat_hash_map<key, std::unique_ptr<api_probe>> _probes;
+    ss::metrics::metric_groups _metrics;
+};
+
+} // namespace kafka
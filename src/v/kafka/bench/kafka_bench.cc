@@ -0,0 +1,625 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/iobuf_parser.h"
+#include "kafka/client.h"
+#include "kafka/requests/create_topics_request.h"
+#include "kafka/requests/fetch_request.h"
+#include "kafka/requests/kafka_batch_adapter.h"
+#include "kafka/requests/metadata_request.h"
+#include "kafka/requests/produce_request.h"
+#include "model/compression.h"
+#include "raft/types.h"
+#include "random/generators.h"
+#include "storage/parser_utils.h"
+#include "storage/record_batch_builder.h"
+#include "syschecks/syschecks.h"
+#include "utils/hdr_hist.h"
+#include "utils/unresolved_address.h"
+#include "vlog.h"
+
+#include <seastar/core/app-template.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/util/defer.hh>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/range/irange.hpp>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Drives a produce and fetch load against a cluster over the kafka protocol
+// and reports the throughput and latency percentiles as json, e.g.
+//
+//   kafka_bench -c 4 --brokers 127.0.0.1:9092 --partitions 16 --acks -1 \
+//     --producers 8 --consumers 4 --batch-records 100 --record-size 1024 \
+//     --compression zstd --duration-s 60 --output result.json
+//
+// Every shard runs its own producers and consumers, each over the partitions
+// assigned to it, with one connection per shard to each leader.
+
+namespace ch = std::chrono;
+static ss::logger lgr{"kafka_bench"};
+
+using clock_type = ch::steady_clock;
+
+void cli_opts(boost::program_options::options_description_easy_init o) {
+    namespace po = boost::program_options;
+    o("brokers",
+      po::value<std::string>()->default_value("127.0.0.1:9092"),
+      "host:port of a broker to bootstrap from");
+    o("topic",
+      po::value<std::string>()->default_value("kafka_bench"),
+      "topic to produce to and fetch from, created when missing");
+    o("partitions",
+      po::value<int32_t>()->default_value(16),
+      "partitions of the topic when it is created");
+    o("replication-factor",
+      po::value<int16_t>()->default_value(3),
+      "replication factor of the topic when it is created");
+    o("duration-s",
+      po::value<uint32_t>()->default_value(60),
+      "duration of the load in seconds");
+    o("producers",
+      po::value<std::size_t>()->default_value(8),
+      "concurrent produce requests per core");
+    o("consumers",
+      po::value<std::size_t>()->default_value(0),
+      "concurrent fetch requests per core");
+    o("batch-records",
+      po::value<std::size_t>()->default_value(100),
+      "records per produced batch");
+    o("record-size",
+      po::value<std::size_t>()->default_value(1024),
+      "bytes of the value of a record");
+    o("acks",
+      po::value<int16_t>()->default_value(-1),
+      "acks of the produce requests, -1 or 1");
+    o("compression",
+      po::value<std::string>()->default_value("none"),
+      "codec of the produced batches: none, gzip, snappy, lz4 or zstd");
+    o("fetch-max-bytes",
+      po::value<int32_t>()->default_value(1 << 20),
+      "max bytes of a fetch request");
+    o("output",
+      po::value<std::string>()->default_value(""),
+      "file to write the json results to, stdout when empty");
+}
+
+struct bench_cfg {
+    unresolved_address bootstrap;
+    model::topic topic;
+    int32_t partitions;
+    int16_t replication_factor;
+    ch::seconds duration;
+    std::size_t producers;
+    std::size_t consumers;
+    std::size_t batch_records;
+    std::size_t record_size;
+    int16_t acks;
+    model::compression compression;
+    int32_t fetch_max_bytes;
+    std::string output;
+};
+
+bench_cfg cfg_from(const boost::program_options::variables_map& m) {
+    auto brokers = m["brokers"].as<std::string>();
+    auto colon = brokers.rfind(':');
+    if (colon == std::string::npos) {
+        throw std::invalid_argument(
+          fmt::format("--brokers must be host:port, got {}", brokers));
+    }
+    auto acks = m["acks"].as<int16_t>();
+    // the broker does not reply to acks=0 requests, which would leave the
+    // client waiting for the reply
+    if (acks != -1 && acks != 1) {
+        throw std::invalid_argument(
+          fmt::format("--acks must be -1 or 1, got {}", acks));
+    }
+    return bench_cfg{
+      .bootstrap = unresolved_address(
+        brokers.substr(0, colon),
+        boost::lexical_cast<uint16_t>(brokers.substr(colon + 1))),
+      .topic = model::topic(m["topic"].as<std::string>()),
+      .partitions = m["partitions"].as<int32_t>(),
+      .replication_factor = m["replication-factor"].as<int16_t>(),
+      .duration = ch::seconds(m["duration-s"].as<uint32_t>()),
+      .producers = m["producers"].as<std::size_t>(),
+      .consumers = m["consumers"].as<std::size_t>(),
+      .batch_records = m["batch-records"].as<std::size_t>(),
+      .record_size = m["record-size"].as<std::size_t>(),
+      .acks = acks,
+      .compression = boost::lexical_cast<model::compression>(
+        m["compression"].as<std::string>()),
+      .fetch_max_bytes = m["fetch-max-bytes"].as<int32_t>(),
+      .output = m["output"].as<std::string>(),
+    };
+}
+
+/// the leader of every partition of the topic
+using leaders_t = std::vector<ss::socket_address>;
+
+struct op_stats {
+    hdr_hist latency;
+    uint64_t requests{0};
+    uint64_t errors{0};
+    uint64_t records{0};
+    uint64_t bytes{0};
+
+    op_stats& operator+=(const op_stats& o) {
+        latency += o.latency;
+        requests += o.requests;
+        errors += o.errors;
+        records += o.records;
+        bytes += o.bytes;
+        return *this;
+    }
+};
+
+kafka::produce_request make_produce_request(
+  const model::topic& topic,
+  model::partition_id p,
+  int16_t acks,
+  model::record_batch batch) {
+    std::vector<kafka::produce_request::partition> partitions;
+    partitions.push_back(kafka::produce_request::partition{
+      .id = p,
+      .data{},
+      .adapter = kafka::kafka_batch_adapter{
+        .v2_format = true, .valid_crc = true, .batch{std::move(batch)}}});
+    std::vector<kafka::produce_request::topic> topics;
+    topics.push_back(kafka::produce_request::topic{
+      .name = topic, .partitions = std::move(partitions)});
+    return kafka::produce_request(std::nullopt, acks, std::move(topics));
+}
+
+kafka::fetch_request make_fetch_request(
+  const model::topic& topic,
+  model::partition_id p,
+  model::offset offset,
+  int32_t max_bytes) {
+    std::vector<kafka::fetch_request::partition> partitions;
+    partitions.push_back(kafka::fetch_request::partition{
+      .id = p,
+      .current_leader_epoch = -1,
+      .fetch_offset = offset,
+      .log_start_offset = model::offset(-1),
+      .partition_max_bytes = max_bytes});
+    std::vector<kafka::fetch_request::topic> topics;
+    topics.push_back(kafka::fetch_request::topic{
+      .name = topic, .partitions = std::move(partitions)});
+    return kafka::fetch_request{
+      .replica_id = model::node_id(-1),
+      .max_wait_time = ch::milliseconds(100),
+      .min_bytes = 1,
+      .max_bytes = max_bytes,
+      .isolation_level = 0,
+      .session_id = 0,
+      .session_epoch = -1,
+      .topics = std::move(topics)};
+}
+
+/// the next offset to fetch and the records of the complete batches of a
+/// fetched record set; a trailing batch cut by max_bytes is fetched again
+std::pair<model::offset, uint64_t>
+consume_record_set(iobuf record_set, model::offset offset) {
+    uint64_t records = 0;
+    iobuf_const_parser parser(record_set);
+    size_t pos{0};
+    while (parser.bytes_left() >= kafka::internal::kafka_header_size) {
+        parser.skip(sizeof(int64_t)); // base offset
+        auto batch_length = parser.consume_be_type<int32_t>();
+        if (batch_length < 0 || parser.bytes_left() < size_t(batch_length)) {
+            break;
+        }
+        parser.skip(batch_length);
+        auto size = sizeof(int64_t) + sizeof(int32_t) + batch_length;
+        kafka::kafka_batch_adapter kba;
+        kba.adapt(record_set.share(pos, size));
+        pos += size;
+        if (!kba.batch) {
+            break;
+        }
+        records += kba.batch->record_count();
+        offset = kba.batch->last_offset() + model::offset(1);
+    }
+    return {offset, records};
+}
+
+/// the load of a shard
+class bench_worker {
+public:
+    bench_worker(bench_cfg cfg, leaders_t leaders)
+      : _cfg(std::move(cfg))
+      , _leaders(std::move(leaders))
+      , _payload(random_generators::get_bytes(_cfg.record_size)) {}
+
+    ss::future<> connect() {
+        for (auto& addr : _leaders) {
+            if (
+              std::find(_addrs.begin(), _addrs.end(), addr) == _addrs.end()) {
+                _addrs.push_back(addr);
+            }
+        }
+        _clients.reserve(_addrs.size());
+        for (auto& addr : _addrs) {
+            _clients.emplace_back(std::make_unique<kafka::client>(
+              rpc::base_transport::configuration{.server_addr = addr}));
+        }
+        return ss::parallel_for_each(
+          _clients, [](std::unique_ptr<kafka::client>& c) {
+              return c->connect();
+          });
+    }
+
+    ss::future<> run() {
+        _deadline = clock_type::now() + _cfg.duration;
+        auto producers = boost::irange<size_t>(0, _cfg.producers);
+        auto consumers = boost::irange<size_t>(0, _cfg.consumers);
+        return ss::when_all_succeed(
+          ss::parallel_for_each(
+            producers, [this](size_t i) { return produce_loop(i); }),
+          ss::parallel_for_each(
+            consumers, [this](size_t i) { return fetch_loop(i); }));
+    }
+
+    ss::future<> stop() {
+        return ss::parallel_for_each(
+          _clients,
+          [](std::unique_ptr<kafka::client>& c) { return c->stop(); });
+    }
+
+    const op_stats& produce_stats() const { return _produce; }
+    const op_stats& fetch_stats() const { return _fetch; }
+
+private:
+    bool done() const { return clock_type::now() >= _deadline; }
+
+    kafka::client& leader(model::partition_id p) {
+        auto it = std::find(_addrs.begin(), _addrs.end(), _leaders[p()]);
+        return *_clients[std::distance(_addrs.begin(), it)];
+    }
+
+    /// the partitions of the topic, spread over the loops of all shards
+    model::partition_id
+    partition_of(size_t loop, size_t loops, size_t round) const {
+        auto global = (round * loops + loop) * ss::smp::count
+                      + ss::this_shard_id();
+        return model::partition_id(global % _leaders.size());
+    }
+
+    ss::future<model::record_batch> make_batch() {
+        storage::record_batch_builder builder(
+          raft::data_batch_type, model::offset(0));
+        for (size_t i = 0; i < _cfg.batch_records; ++i) {
+            iobuf value;
+            value.append(_payload.data(), _payload.size());
+            builder.add_raw_kv(iobuf(), std::move(value));
+        }
+        auto batch = std::move(builder).build();
+        if (_cfg.compression == model::compression::none) {
+            return ss::make_ready_future<model::record_batch>(
+              std::move(batch));
+        }
+        return storage::internal::compress_batch(
+          _cfg.compression, std::move(batch));
+    }
+
+    ss::future<> produce_loop(size_t loop) {
+        return ss::do_with(size_t(0), [this, loop](size_t& round) {
+            return ss::do_until(
+              [this] { return done(); },
+              [this, loop, &round] {
+                  auto p = partition_of(loop, _cfg.producers, round++);
+                  return make_batch().then(
+                    [this, p](model::record_batch batch) {
+                        return produce_one(p, std::move(batch));
+                    });
+              });
+        });
+    }
+
+    ss::future<> produce_one(model::partition_id p, model::record_batch b) {
+        auto records = b.record_count();
+        auto bytes = _cfg.batch_records * _cfg.record_size;
+        auto m = _produce.latency.auto_measure();
+        return leader(p)
+          .dispatch(
+            make_produce_request(_cfg.topic, p, _cfg.acks, std::move(b)))
+          .then_wrapped([this, records, bytes, m = std::move(m)](
+                          ss::future<kafka::produce_response> f) mutable {
+              ++_produce.requests;
+              bool failed = f.failed();
+              if (failed) {
+                  vlog(lgr.debug, "produce failed: {}", f.get_exception());
+              } else {
+                  auto r = f.get0();
+                  failed = r.topics.empty() || r.topics[0].partitions.empty()
+                           || r.topics[0].partitions[0].error
+                                != kafka::error_code::none;
+              }
+              if (failed) {
+                  m->set_trace(false);
+                  ++_produce.errors;
+                  return;
+              }
+              _produce.records += records;
+              _produce.bytes += bytes;
+          });
+    }
+
+    ss::future<> fetch_loop(size_t loop) {
+        // the offsets of the partitions read by this loop
+        return ss::do_with(
+          std::vector<model::offset>(_leaders.size(), model::offset(0)),
+          size_t(0),
+          [this, loop](std::vector<model::offset>& offsets, size_t& round) {
+              return ss::do_until(
+                [this] { return done(); },
+                [this, loop, &offsets, &round] {
+                    auto p = partition_of(loop, _cfg.consumers, round++);
+                    return fetch_one(p, offsets[p()]);
+                });
+          });
+    }
+
+    ss::future<> fetch_one(model::partition_id p, model::offset& offset) {
+        auto m = _fetch.latency.auto_measure();
+        return leader(p)
+          .dispatch(
+            make_fetch_request(_cfg.topic, p, offset, _cfg.fetch_max_bytes))
+          .then_wrapped([this, &offset, m = std::move(m)](
+                          ss::future<kafka::fetch_response> f) mutable {
+              ++_fetch.requests;
+              if (f.failed()) {
+                  vlog(lgr.debug, "fetch failed: {}", f.get_exception());
+                  m->set_trace(false);
+                  ++_fetch.errors;
+                  return;
+              }
+              auto r = f.get0();
+              if (
+                r.partitions.empty() || r.partitions[0].responses.empty()
+                || r.partitions[0].responses[0].error
+                     != kafka::error_code::none) {
+                  m->set_trace(false);
+                  ++_fetch.errors;
+                  return;
+              }
+              auto& res = r.partitions[0].responses[0];
+              if (!res.record_set) {
+                  return;
+              }
+              _fetch.bytes += res.record_set->size_bytes();
+              auto [next, records] = consume_record_set(
+                std::move(*res.record_set), offset);
+              offset = next;
+              _fetch.records += records;
+          });
+    }
+
+    bench_cfg _cfg;
+    leaders_t _leaders;
+    bytes _payload;
+    std::vector<ss::socket_address> _addrs;
+    std::vector<std::unique_ptr<kafka::client>> _clients;
+    clock_type::time_point _deadline;
+    op_stats _produce;
+    op_stats _fetch;
+};
+
+/// creates the topic when missing, and waits for the leaders of its
+/// partitions
+leaders_t prepare_topic_in_thread(const bench_cfg& cfg) {
+    auto addr = cfg.bootstrap.resolve().get0();
+    kafka::client client(
+      rpc::base_transport::configuration{.server_addr = addr});
+    client.connect().get();
+    auto close = ss::defer([&client] { client.stop().get(); });
+
+    kafka::creatable_topic topic;
+    topic.name = cfg.topic;
+    topic.num_partitions = cfg.partitions;
+    topic.replication_factor = cfg.replication_factor;
+    std::vector<kafka::creatable_topic> topics;
+    topics.push_back(std::move(topic));
+    auto created = client
+                     .dispatch(
+                       kafka::create_topics_request{.data{
+                         .topics = std::move(topics),
+                         .timeout_ms = ch::seconds(10),
+                         .validate_only = false,
+                       }},
+                       kafka::api_version(2))
+                     .get0();
+    for (auto& t : created.data.topics) {
+        if (
+          t.error_code != kafka::error_code::none
+          && t.error_code != kafka::error_code::topic_already_exists) {
+            throw std::runtime_error(
+              fmt::format("creating {} failed: {}", t.name, t.error_code));
+        }
+    }
+
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        auto md = client
+                    .dispatch(kafka::metadata_request{
+                      .topics = std::vector<model::topic>{cfg.topic}})
+                    .get0();
+        leaders_t leaders;
+        for (auto& t : md.topics) {
+            if (t.name != cfg.topic) {
+                continue;
+            }
+            leaders.resize(t.partitions.size());
+            for (auto& p : t.partitions) {
+                auto b = std::find_if(
+                  md.brokers.begin(),
+                  md.brokers.end(),
+                  [&p](const kafka::metadata_response::broker& b) {
+                      return b.node_id == p.leader;
+                  });
+                if (b == md.brokers.end()) {
+                    leaders.clear();
+                    break;
+                }
+                leaders[p.index()] = unresolved_address(b->host, b->port)
+                                       .resolve()
+                                       .get0();
+            }
+        }
+        if (!leaders.empty()) {
+            return leaders;
+        }
+        ss::sleep(ch::milliseconds(100)).get();
+    }
+    throw std::runtime_error(
+      fmt::format("no leaders were elected for {}", cfg.topic));
+}
+
+void write_op(
+  rapidjson::PrettyWriter<rapidjson::StringBuffer>& w,
+  const char* name,
+  const op_stats& s,
+  double seconds) {
+    w.Key(name);
+    w.StartObject();
+    w.Key("requests");
+    w.Uint64(s.requests);
+    w.Key("errors");
+    w.Uint64(s.errors);
+    w.Key("records");
+    w.Uint64(s.records);
+    w.Key("bytes");
+    w.Uint64(s.bytes);
+    w.Key("records_per_sec");
+    w.Double(double(s.records) / seconds);
+    w.Key("mb_per_sec");
+    w.Double(double(s.bytes) / seconds / (1024 * 1024));
+    w.Key("latency_us");
+    w.StartObject();
+    for (auto [key, p] : {
+           std::make_pair("p50", 50.0),
+           std::make_pair("p90", 90.0),
+           std::make_pair("p99", 99.0),
+           std::make_pair("p999", 99.9),
+           std::make_pair("max", 100.0),
+         }) {
+        w.Key(key);
+        w.Int64(s.latency.get_value_at(p));
+    }
+    w.Key("mean");
+    w.Double(s.latency.mean());
+    w.EndObject();
+    w.EndObject();
+}
+
+std::string results_json(
+  const bench_cfg& cfg,
+  const op_stats& produce,
+  const op_stats& fetch,
+  double seconds) {
+    rapidjson::StringBuffer buf;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> w(buf);
+    w.StartObject();
+    w.Key("config");
+    w.StartObject();
+    w.Key("topic");
+    w.String(cfg.topic().c_str());
+    w.Key("partitions");
+    w.Int(cfg.partitions);
+    w.Key("cores");
+    w.Uint(ss::smp::count);
+    w.Key("producers_per_core");
+    w.Uint64(cfg.producers);
+    w.Key("consumers_per_core");
+    w.Uint64(cfg.consumers);
+    w.Key("batch_records");
+    w.Uint64(cfg.batch_records);
+    w.Key("record_size");
+    w.Uint64(cfg.record_size);
+    w.Key("acks");
+    w.Int(cfg.acks);
+    w.Key("compression");
+    w.String(boost::lexical_cast<std::string>(cfg.compression).c_str());
+    w.EndObject();
+    w.Key("duration_sec");
+    w.Double(seconds);
+    write_op(w, "produce", produce, seconds);
+    write_op(w, "fetch", fetch, seconds);
+    w.EndObject();
+    return buf.GetString();
+}
+
+int main(int args, char** argv, char** env) {
+    syschecks::initialize_intrinsics();
+    std::setvbuf(stdout, nullptr, _IOLBF, 1024);
+    ss::app_template app;
+    cli_opts(app.add_options());
+    ss::sharded<bench_worker> workers;
+    return app.run(args, argv, [&] {
+        auto& m = app.configuration();
+        return ss::async([&] {
+            const bench_cfg cfg = cfg_from(m);
+            auto leaders = prepare_topic_in_thread(cfg);
+            vlog(
+              lgr.info,
+              "topic {} has {} partitions",
+              cfg.topic,
+              leaders.size());
+
+            workers.start(cfg, leaders).get();
+            auto stop = ss::defer([&workers] { workers.stop().get(); });
+            workers.invoke_on_all(&bench_worker::connect).get();
+
+            vlog(lgr.info, "running for {}s", cfg.duration.count());
+            auto begin = clock_type::now();
+            workers.invoke_on_all(&bench_worker::run).get();
+            auto seconds = ch::duration<double>(clock_type::now() - begin)
+                             .count();
+
+            // the loads are over, the stats of the other shards are only read
+            op_stats produce;
+            op_stats fetch;
+            for (ss::shard_id s = 0; s < ss::smp::count; ++s) {
+                workers
+                  .invoke_on(
+                    s,
+                    [&produce, &fetch](const bench_worker& w) {
+                        produce += w.produce_stats();
+                        fetch += w.fetch_stats();
+                    })
+                  .get();
+            }
+
+            auto json = results_json(cfg, produce, fetch, seconds);
+            if (cfg.output.empty()) {
+                std::cout << json << std::endl;
+                return;
+            }
+            auto f = ss::open_file_dma(
+                       cfg.output,
+                       ss::open_flags::wo | ss::open_flags::create
+                         | ss::open_flags::truncate)
+                       .get0();
+            auto out = ss::make_file_output_stream(std::move(f)).get0();
+            out.write(json).get();
+            out.close().get();
+        });
+    });
+}
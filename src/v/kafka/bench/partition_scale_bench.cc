@@ -0,0 +1,739 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "cluster/members_table.h"
+#include "cluster/metadata_cache.h"
+#include "cluster/namespace.h"
+#include "cluster/partition_leaders_table.h"
+#include "cluster/topic_table.h"
+#include "cluster/types.h"
+#include "config/configuration.h"
+#include "kafka/requests/metadata_request.h"
+#include "kafka/requests/response_writer.h"
+#include "model/metadata.h"
+#include "raft/consensus.h"
+#include "raft/consensus_client_protocol.h"
+#include "raft/errc.h"
+#include "raft/heartbeat_delta.h"
+#include "raft/heartbeat_manager.h"
+#include "raft/types.h"
+#include "random/generators.h"
+#include "storage/api.h"
+#include "syschecks/syschecks.h"
+#include "units.h"
+#include "utils/unresolved_address.h"
+#include "vlog.h"
+
+#include <seastar/core/app-template.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/memory.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/util/defer.hh>
+
+#include <absl/container/flat_hash_map.h>
+#include <boost/range/irange.hpp>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Measures the per partition costs of a node hosting many partitions, without
+// the followers and the network, and reports them as json, e.g.
+//
+//   partition_scale_bench -c 4 --groups 100000 --followers 2 \
+//     --heartbeat-interval-ms 150 --rounds 20 --topics 1000 --output r.json
+//
+// The node leads every group, each group on shard group % cores, and the
+// heartbeat_manager of each shard heartbeats the followers through a client
+// protocol that answers in place, as caught up followers would. The cpu time
+// and the allocations of the shards over a number of heartbeat intervals give
+// the cost of a heartbeat round, from building the delta encoded requests to
+// processing the replies. With --quiesce-idle-ms the idle groups are quiesced
+// and the rounds only keep the sessions of the followers alive.
+//
+// The partitions of the groups are then those of the topics, for timing the
+// updates of the partition_leaders_table and the metadata response listing
+// every topic, built from the metadata_cache and encoded.
+
+namespace ch = std::chrono;
+static ss::logger lgr{"partition_scale_bench"};
+
+using clock_type = ch::steady_clock;
+using consensus_ptr = ss::lw_shared_ptr<raft::consensus>;
+
+void cli_opts(boost::program_options::options_description_easy_init o) {
+    namespace po = boost::program_options;
+    o("groups",
+      po::value<int32_t>()->default_value(100000),
+      "number of raft groups, and of partitions");
+    o("followers",
+      po::value<int32_t>()->default_value(2),
+      "number of followers of every group");
+    o("heartbeat-interval-ms",
+      po::value<int32_t>()->default_value(150),
+      "raft heartbeat interval");
+    o("rounds",
+      po::value<uint32_t>()->default_value(20),
+      "heartbeat intervals measured");
+    o("quiesce-idle-ms",
+      po::value<int32_t>()->default_value(0),
+      "raft_quiesce_idle_ms, 0 heartbeats every group");
+    o("topics",
+      po::value<int32_t>()->default_value(1000),
+      "number of topics sharing the partitions");
+    o("metadata-runs",
+      po::value<uint32_t>()->default_value(5),
+      "metadata responses built and encoded");
+    o("workdir",
+      po::value<std::string>()->default_value("."),
+      "directory of the kvstore of the groups");
+    o("output",
+      po::value<std::string>()->default_value(""),
+      "file to write the json results to, stdout when empty");
+}
+
+struct bench_cfg {
+    int32_t groups;
+    int32_t followers;
+    ch::milliseconds heartbeat_interval;
+    uint32_t rounds;
+    ch::milliseconds quiesce_idle;
+    int32_t topics;
+    uint32_t metadata_runs;
+    ss::sstring workdir;
+    std::string output;
+
+    int32_t partitions_per_topic() const {
+        return std::max(1, (groups + topics - 1) / topics);
+    }
+
+    model::ntp ntp_of(raft::group_id g) const {
+        return model::ntp(
+          cluster::kafka_namespace,
+          model::topic(fmt::format("topic-{}", g() / partitions_per_topic())),
+          model::partition_id(g() % partitions_per_topic()));
+    }
+};
+
+bench_cfg cfg_from(const boost::program_options::variables_map& m) {
+    auto groups = m["groups"].as<int32_t>();
+    auto topics = m["topics"].as<int32_t>();
+    if (groups <= 0 || topics <= 0 || topics > groups) {
+        throw std::invalid_argument(fmt::format(
+          "--groups and --topics must be positive, with no more topics than "
+          "groups, got {} and {}",
+          groups,
+          topics));
+    }
+    return bench_cfg{
+      .groups = groups,
+      .followers = m["followers"].as<int32_t>(),
+      .heartbeat_interval = ch::milliseconds(
+        m["heartbeat-interval-ms"].as<int32_t>()),
+      .rounds = m["rounds"].as<uint32_t>(),
+      .quiesce_idle = ch::milliseconds(m["quiesce-idle-ms"].as<int32_t>()),
+      .topics = topics,
+      .metadata_runs = m["metadata-runs"].as<uint32_t>(),
+      .workdir = fmt::format(
+        "{}/partition_scale_bench.{}",
+        m["workdir"].as<std::string>(),
+        random_generators::gen_alphanum_string(6)),
+      .output = m["output"].as<std::string>(),
+    };
+}
+
+static ch::microseconds thread_cpu_time() {
+    rusage ru{};
+    ::getrusage(RUSAGE_THREAD, &ru);
+    auto to_us = [](timeval t) {
+        return ch::seconds(t.tv_sec) + ch::microseconds(t.tv_usec);
+    };
+    return to_us(ru.ru_utime) + to_us(ru.ru_stime);
+}
+
+/// the cpu time and the allocations of a shard
+struct shard_usage {
+    ch::microseconds cpu{0};
+    uint64_t mallocs{0};
+
+    static shard_usage local() {
+        return shard_usage{
+          .cpu = thread_cpu_time(), .mallocs = ss::memory::stats().mallocs()};
+    }
+
+    shard_usage& operator+=(const shard_usage& o) {
+        cpu += o.cpu;
+        mallocs += o.mallocs;
+        return *this;
+    }
+
+    shard_usage operator-(const shard_usage& o) const {
+        return shard_usage{.cpu = cpu - o.cpu, .mallocs = mallocs - o.mallocs};
+    }
+};
+
+static ss::future<shard_usage> node_usage() {
+    auto shards = boost::irange(0u, ss::smp::count);
+    return ss::map_reduce(
+      shards.begin(),
+      shards.end(),
+      [](ss::shard_id shard) {
+          return ss::smp::submit_to(shard, [] { return shard_usage::local(); });
+      },
+      shard_usage{},
+      [](shard_usage acc, shard_usage u) { return acc += u; });
+}
+
+/// the requests the followers answered
+struct follower_stats {
+    uint64_t heartbeats{0};
+    uint64_t heartbeated_groups{0};
+    uint64_t append_entries{0};
+
+    follower_stats& operator+=(const follower_stats& o) {
+        heartbeats += o.heartbeats;
+        heartbeated_groups += o.heartbeated_groups;
+        append_entries += o.append_entries;
+        return *this;
+    }
+};
+
+/// Followers that grant every vote and are caught up with every append, so
+/// that the leaders of the shard only pay for building the requests and
+/// processing the replies. The delta encoded heartbeats are decoded like the
+/// raft service does.
+class mock_followers final : public raft::consensus_client_protocol::impl {
+public:
+    using groups_t = absl::flat_hash_map<raft::group_id, consensus_ptr>;
+
+    mock_followers(const groups_t& groups, follower_stats& stats)
+      : _groups(groups)
+      , _stats(stats) {}
+
+    ss::future<result<raft::vote_reply>>
+    vote(model::node_id, raft::vote_request&& r, rpc::client_opts) final {
+        return ss::make_ready_future<result<raft::vote_reply>>(
+          raft::vote_reply{.term = r.term, .granted = true, .log_ok = true});
+    }
+
+    ss::future<result<raft::append_entries_reply>> append_entries(
+      model::node_id n,
+      raft::append_entries_request&& r,
+      rpc::client_opts) final {
+        ++_stats.append_entries;
+        // the leader appended the batches before sending them, the follower
+        // ends up with the log of the leader
+        auto meta = r.meta;
+        if (auto it = _groups.find(meta.group); it != _groups.end()) {
+            meta.prev_log_index = it->second->meta().prev_log_index;
+        }
+        return ss::make_ready_future<result<raft::append_entries_reply>>(
+          caught_up(n, meta));
+    }
+
+    ss::future<result<raft::heartbeat_reply>> heartbeat(
+      model::node_id n, raft::heartbeat_request&& r, rpc::client_opts) final {
+        ++_stats.heartbeats;
+        raft::heartbeat_reply reply;
+        reply.base_missing = apply_heartbeat_delta(n, r);
+        _stats.heartbeated_groups += r.meta.size();
+        reply.meta.reserve(r.meta.size());
+        for (auto& m : r.meta) {
+            reply.meta.push_back(caught_up(n, m));
+        }
+        return ss::make_ready_future<result<raft::heartbeat_reply>>(
+          std::move(reply));
+    }
+
+    ss::future<result<raft::install_snapshot_reply>> install_snapshot(
+      model::node_id,
+      raft::install_snapshot_request&&,
+      rpc::client_opts) final {
+        return unsupported<raft::install_snapshot_reply>();
+    }
+
+    ss::future<result<raft::install_segment_reply>> install_segment(
+      model::node_id, raft::install_segment_request&&, rpc::client_opts) final {
+        return unsupported<raft::install_segment_reply>();
+    }
+
+    ss::future<result<raft::timeout_now_reply>> timeout_now(
+      model::node_id, raft::timeout_now_request&&, rpc::client_opts) final {
+        return unsupported<raft::timeout_now_reply>();
+    }
+
+private:
+    // the followers never fall behind, so that these are never sent
+    template<typename T>
+    static ss::future<result<T>> unsupported() {
+        return ss::make_ready_future<result<T>>(
+          raft::make_error_code(raft::errc::node_does_not_exists));
+    }
+
+    static raft::append_entries_reply
+    caught_up(model::node_id n, const raft::protocol_metadata& m) {
+        return raft::append_entries_reply{
+          .node_id = n,
+          .group = m.group,
+          .term = m.term,
+          .last_committed_log_index = m.prev_log_index,
+          .last_dirty_log_index = m.prev_log_index,
+          .result = raft::append_entries_reply::status::success};
+    }
+
+    /// see raft::service::apply_heartbeat_delta
+    bool apply_heartbeat_delta(model::node_id n, raft::heartbeat_request& r) {
+        if (r.session == 0 || r.seq == 0) {
+            return false;
+        }
+        auto& bases = _bases[n];
+        static const raft::heartbeat_state no_base;
+        const raft::heartbeat_state* base = &no_base;
+        if (r.base_seq != 0) {
+            base = bases.find(r.session, r.base_seq);
+            if (!base) {
+                return true;
+            }
+        }
+        auto state = raft::decode_heartbeat_delta(r, *base);
+        r.meta = state;
+        bases.insert(r.session, r.seq, std::move(state));
+        return false;
+    }
+
+    const groups_t& _groups;
+    follower_stats& _stats;
+    absl::flat_hash_map<model::node_id, raft::heartbeat_bases> _bases;
+};
+
+/// the groups of the node on a shard, led by the node
+class bench_groups {
+public:
+    bench_groups(
+      model::node_id self, ss::sstring directory, ch::milliseconds interval)
+      : _self(self)
+      , _client_protocol(
+          raft::make_consensus_client_protocol<mock_followers>(
+            std::cref(_groups), std::ref(_stats)))
+      , _storage(
+          storage::kvstore_config(
+            1_MiB,
+            ch::milliseconds(10),
+            directory,
+            storage::debug_sanitize_files::no),
+          storage::log_config(
+            storage::log_config::storage_type::memory,
+            directory,
+            1_GiB,
+            storage::debug_sanitize_files::no))
+      , _hbeats(interval, _client_protocol, self)
+      , _election_timeout(interval * 2) {}
+
+    ss::future<> start() {
+        return _storage.start().then([this] { return _hbeats.start(); });
+    }
+
+    ss::future<> stop() {
+        return ss::parallel_for_each(
+                 _groups,
+                 [this](auto& e) {
+                     return _hbeats.deregister_group(e.first).then(
+                       [c = e.second] { return c->stop(); });
+                 })
+          .then([this] { return _hbeats.stop(); })
+          .then([this] { return _storage.stop(); });
+    }
+
+    /// creates the groups of this shard
+    ss::future<>
+    add_groups(const bench_cfg& cfg, std::vector<model::broker> brokers) {
+        std::vector<raft::group_id> groups;
+        for (int32_t g = 0; g < cfg.groups; ++g) {
+            if (ss::shard_id(g) % ss::smp::count == ss::this_shard_id()) {
+                groups.emplace_back(g);
+            }
+        }
+        return ss::do_with(
+                 std::move(groups),
+                 std::move(brokers),
+                 [this, &cfg](
+                   std::vector<raft::group_id>& groups,
+                   std::vector<model::broker>& brokers) {
+                     return ss::do_for_each(
+                       groups, [this, &cfg, &brokers](raft::group_id g) {
+                           return add_group(cfg.ntp_of(g), g, brokers);
+                       });
+                 })
+          .then([this] {
+              std::vector<consensus_ptr> groups;
+              groups.reserve(_groups.size());
+              for (auto& [_, c] : _groups) {
+                  groups.push_back(c);
+              }
+              return _hbeats.register_groups(std::move(groups));
+          });
+    }
+
+    bool all_leaders() const {
+        return std::all_of(_groups.begin(), _groups.end(), [](const auto& e) {
+            return e.second->is_leader();
+        });
+    }
+
+    const follower_stats& stats() const { return _stats; }
+
+private:
+    ss::future<> add_group(
+      model::ntp ntp,
+      raft::group_id g,
+      const std::vector<model::broker>& brokers) {
+        return _storage.log_mgr()
+          .manage(
+            storage::ntp_config(
+              std::move(ntp), _storage.log_mgr().config().base_dir))
+          .then([this, g, brokers](storage::log log) {
+              auto c = ss::make_lw_shared<raft::consensus>(
+                _self,
+                g,
+                raft::group_configuration(brokers),
+                raft::timeout_jitter(_election_timeout),
+                log,
+                ss::default_priority_class(),
+                ch::seconds(10),
+                _client_protocol,
+                [](raft::leadership_status) {},
+                _storage);
+              _groups.emplace(g, c);
+              return c->start();
+          });
+    }
+
+    model::node_id _self;
+    absl::flat_hash_map<raft::group_id, consensus_ptr> _groups;
+    follower_stats _stats;
+    raft::consensus_client_protocol _client_protocol;
+    storage::api _storage;
+    raft::heartbeat_manager _hbeats;
+    ch::milliseconds _election_timeout;
+};
+
+struct heartbeat_results {
+    double rounds{0};
+    shard_usage usage;
+    follower_stats followers;
+};
+
+struct leaders_results {
+    clock_type::duration new_leaders{0};
+    clock_type::duration changed_leaders{0};
+};
+
+struct metadata_results {
+    clock_type::duration create_topics{0};
+    std::vector<clock_type::duration> build;
+    std::vector<clock_type::duration> encode;
+    size_t bytes{0};
+};
+
+static follower_stats total_stats(ss::sharded<bench_groups>& groups) {
+    return groups
+      .map_reduce0(
+        [](const bench_groups& g) { return g.stats(); },
+        follower_stats{},
+        [](follower_stats acc, const follower_stats& s) { return acc += s; })
+      .get0();
+}
+
+static heartbeat_results measure_heartbeats_in_thread(
+  const bench_cfg& cfg, ss::sharded<bench_groups>& groups) {
+    // the followers are answered in place, the rounds that ran are those the
+    // heartbeat_manager of every shard sent to one of them
+    const auto followers = total_stats(groups);
+    const auto usage = node_usage().get0();
+    ss::sleep(cfg.heartbeat_interval * cfg.rounds).get();
+    heartbeat_results r;
+    r.usage = node_usage().get0() - usage;
+    r.followers = total_stats(groups);
+    r.followers.heartbeats -= followers.heartbeats;
+    r.followers.heartbeated_groups -= followers.heartbeated_groups;
+    r.followers.append_entries -= followers.append_entries;
+    r.rounds = double(r.followers.heartbeats)
+               / double(ss::smp::count * cfg.followers);
+    return r;
+}
+
+static leaders_results measure_leaders_in_thread(const bench_cfg& cfg) {
+    cluster::partition_leaders_table leaders;
+    auto update_all = [&cfg, &leaders](model::term_id term, int32_t leader) {
+        const auto start = clock_type::now();
+        for (int32_t g = 0; g < cfg.groups; ++g) {
+            leaders.update_partition_leader(
+              cfg.ntp_of(raft::group_id(g)), term, model::node_id(leader));
+            if (g % 1000 == 0) {
+                ss::thread::maybe_yield();
+            }
+        }
+        return clock_type::now() - start;
+    };
+    leaders_results r;
+    r.new_leaders = update_all(model::term_id(1), 0);
+    r.changed_leaders = update_all(model::term_id(2), 1);
+    leaders.stop().get();
+    return r;
+}
+
+static metadata_results measure_metadata_in_thread(
+  const bench_cfg& cfg, const std::vector<model::broker>& brokers) {
+    ss::sharded<cluster::topic_table> topics;
+    ss::sharded<cluster::members_table> members;
+    ss::sharded<cluster::partition_leaders_table> leaders;
+    ss::sharded<cluster::metadata_cache> cache;
+    topics.start().get();
+    auto stop_topics = ss::defer([&topics] { topics.stop().get(); });
+    members.start().get();
+    auto stop_members = ss::defer([&members] { members.stop().get(); });
+    leaders.start().get();
+    auto stop_leaders = ss::defer([&leaders] { leaders.stop().get(); });
+    cache.start(std::ref(topics), std::ref(members), std::ref(leaders)).get();
+    auto stop_cache = ss::defer([&cache] { cache.stop().get(); });
+
+    cluster::patch<cluster::members_table::broker_ptr> patch;
+    for (auto& b : brokers) {
+        patch.additions.push_back(ss::make_lw_shared<model::broker>(b));
+    }
+    members.local().update_brokers(std::move(patch));
+
+    metadata_results r;
+    const auto start = clock_type::now();
+    const auto per_topic = cfg.partitions_per_topic();
+    for (int32_t g = 0; g < cfg.groups; g += per_topic) {
+        auto ntp = cfg.ntp_of(raft::group_id(g));
+        const auto partitions = std::min(per_topic, cfg.groups - g);
+        cluster::topic_configuration tp_cfg(
+          ntp.ns, ntp.tp.topic, partitions, int16_t(brokers.size()));
+        std::vector<cluster::partition_assignment> assignments;
+        assignments.reserve(partitions);
+        for (int32_t p = 0; p < partitions; ++p) {
+            std::vector<model::broker_shard> replicas;
+            for (auto& b : brokers) {
+                replicas.push_back(model::broker_shard{
+                  .node_id = b.id(),
+                  .shard = uint32_t(g + p) % ss::smp::count});
+            }
+            assignments.push_back(cluster::partition_assignment{
+              .group = raft::group_id(g + p),
+              .id = model::partition_id(p),
+              .replicas = std::move(replicas)});
+        }
+        topics.local()
+          .apply(
+            cluster::create_topic_cmd(
+              model::topic_namespace(ntp.ns, ntp.tp.topic),
+              cluster::topic_configuration_assignment(
+                std::move(tp_cfg), std::move(assignments))),
+            model::offset(0))
+          .get();
+        for (int32_t p = 0; p < partitions; ++p) {
+            leaders.local().update_partition_leader(
+              cfg.ntp_of(raft::group_id(g + p)),
+              model::term_id(1),
+              brokers.front().id());
+        }
+    }
+    r.create_topics = clock_type::now() - start;
+
+    for (uint32_t i = 0; i < cfg.metadata_runs; ++i) {
+        auto begin = clock_type::now();
+        kafka::metadata_response resp;
+        for (auto& md : cache.local().all_topics_metadata()) {
+            resp.topics.push_back(
+              kafka::metadata_response::topic::make_from_topic_metadata(
+                std::move(md)));
+        }
+        auto built = clock_type::now();
+        iobuf out;
+        kafka::response_writer w(out);
+        resp.encode(w, kafka::metadata_api::max_supported, false);
+        r.build.push_back(built - begin);
+        r.encode.push_back(clock_type::now() - built);
+        r.bytes = out.size_bytes();
+    }
+    return r;
+}
+
+static double to_ms(clock_type::duration d) {
+    return ch::duration<double, std::milli>(d).count();
+}
+
+static double to_ns(clock_type::duration d) {
+    return double(ch::duration_cast<ch::nanoseconds>(d).count());
+}
+
+std::string results_json(
+  const bench_cfg& cfg,
+  const heartbeat_results& h,
+  const leaders_results& l,
+  const metadata_results& m) {
+    rapidjson::StringBuffer buf;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> w(buf);
+    const double rounds = std::max(h.rounds, 1.0);
+    w.StartObject();
+    w.Key("config");
+    w.StartObject();
+    w.Key("groups");
+    w.Int(cfg.groups);
+    w.Key("followers");
+    w.Int(cfg.followers);
+    w.Key("cores");
+    w.Uint(ss::smp::count);
+    w.Key("heartbeat_interval_ms");
+    w.Int64(cfg.heartbeat_interval.count());
+    w.Key("quiesce_idle_ms");
+    w.Int64(cfg.quiesce_idle.count());
+    w.Key("topics");
+    w.Int(cfg.topics);
+    w.EndObject();
+
+    w.Key("heartbeats");
+    w.StartObject();
+    w.Key("rounds");
+    w.Double(h.rounds);
+    w.Key("cpu_us_per_round");
+    w.Double(double(h.usage.cpu.count()) / rounds);
+    w.Key("cpu_ns_per_group_round");
+    w.Double(double(h.usage.cpu.count()) * 1000 / rounds / cfg.groups);
+    w.Key("mallocs_per_round");
+    w.Double(double(h.usage.mallocs) / rounds);
+    w.Key("mallocs_per_group_round");
+    w.Double(double(h.usage.mallocs) / rounds / cfg.groups);
+    w.Key("heartbeated_groups_per_round");
+    w.Double(double(h.followers.heartbeated_groups) / rounds);
+    w.Key("append_entries");
+    w.Uint64(h.followers.append_entries);
+    w.EndObject();
+
+    w.Key("partition_leaders_table");
+    w.StartObject();
+    w.Key("new_leader_ns_per_update");
+    w.Double(to_ns(l.new_leaders) / cfg.groups);
+    w.Key("changed_leader_ns_per_update");
+    w.Double(to_ns(l.changed_leaders) / cfg.groups);
+    w.EndObject();
+
+    w.Key("metadata");
+    w.StartObject();
+    w.Key("create_topics_ms");
+    w.Double(to_ms(m.create_topics));
+    w.Key("response_bytes");
+    w.Uint64(m.bytes);
+    for (auto [key, runs] : {
+           std::make_pair("build_ms", &m.build),
+           std::make_pair("encode_ms", &m.encode),
+         }) {
+        w.Key(key);
+        w.StartArray();
+        for (auto d : *runs) {
+            w.Double(to_ms(d));
+        }
+        w.EndArray();
+    }
+    w.EndObject();
+    w.EndObject();
+    return buf.GetString();
+}
+
+void write_results_in_thread(const bench_cfg& cfg, const std::string& json) {
+    if (cfg.output.empty()) {
+        std::cout << json << std::endl;
+        return;
+    }
+    auto f = ss::open_file_dma(
+               cfg.output,
+               ss::open_flags::wo | ss::open_flags::create
+                 | ss::open_flags::truncate)
+               .get0();
+    auto out = ss::make_file_output_stream(std::move(f)).get0();
+    out.write(json).get();
+    out.close().get();
+}
+
+int main(int args, char** argv, char** env) {
+    syschecks::initialize_intrinsics();
+    std::setvbuf(stdout, nullptr, _IOLBF, 1024);
+    ss::app_template app;
+    cli_opts(app.add_options());
+    ss::sharded<bench_groups> groups;
+    return app.run(args, argv, [&] {
+        auto& m = app.configuration();
+        return ss::async([&] {
+            const bench_cfg cfg = cfg_from(m);
+            ss::smp::invoke_on_all([&cfg] {
+                auto& c = config::shard_local_cfg();
+                c.get("disable_metrics").set_value(true);
+                c.get("raft_quiesce_idle_ms").set_value(cfg.quiesce_idle);
+            }).get();
+
+            std::vector<model::broker> brokers;
+            for (int32_t n = 0; n <= cfg.followers; ++n) {
+                auto addr = unresolved_address("127.0.0.1", 33145 + n);
+                brokers.emplace_back(
+                  model::node_id(n),
+                  addr,
+                  addr,
+                  std::nullopt,
+                  model::broker_properties{.cores = ss::smp::count});
+            }
+
+            groups
+              .start(
+                brokers.front().id(),
+                ss::sstring(cfg.workdir),
+                cfg.heartbeat_interval)
+              .get();
+            auto stop_groups = ss::defer([&groups] {
+                groups.invoke_on_all(&bench_groups::stop).get();
+                groups.stop().get();
+            });
+            groups.invoke_on_all(&bench_groups::start).get();
+            vlog(lgr.info, "creating {} groups", cfg.groups);
+            groups
+              .invoke_on_all([&cfg, brokers](bench_groups& g) {
+                  return g.add_groups(cfg, brokers);
+              })
+              .get();
+            while (!groups
+                      .map_reduce0(
+                        [](const bench_groups& g) { return g.all_leaders(); },
+                        true,
+                        std::logical_and<>())
+                      .get0()) {
+                ss::sleep(cfg.heartbeat_interval).get();
+            }
+            // past the quiescence of the idle groups, if enabled
+            ss::sleep(cfg.quiesce_idle + cfg.heartbeat_interval * 2).get();
+
+            vlog(lgr.info, "measuring {} heartbeat rounds", cfg.rounds);
+            auto hbeats = measure_heartbeats_in_thread(cfg, groups);
+            vlog(lgr.info, "updating the leaders of {} partitions", cfg.groups);
+            auto leaders = measure_leaders_in_thread(cfg);
+            vlog(lgr.info, "listing {} topics", cfg.topics);
+            auto metadata = measure_metadata_in_thread(cfg, brokers);
+            write_results_in_thread(
+              cfg, results_json(cfg, hbeats, leaders, metadata));
+        });
+    });
+}
@@ -20,9 +20,11 @@
 #include "rpc/transport.h"
 #include "seastarx.h"
 
+#include <seastar/core/byteorder.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/iostream.hh>
 #include <seastar/core/reactor.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/net/inet_address.hh>
 #include <seastar/net/socket_defs.hh>
 
@@ -31,20 +33,19 @@ namespace kafka {
 /**
  * \brief Kafka client.
  *
- * Restrictions:
- *  - don't dispatch concurrent requests.
+ * Requests may be dispatched concurrently: they are pipelined over the
+ * connection, and as the kafka protocol requires that replies be sent in the
+ * same order the requests are received at the server, the replies are read
+ * in the order the requests are sent and checked against their correlation
+ * id.
  */
 class client : public rpc::base_transport {
 private:
     /*
-     * send a request message and process the reply. note that the kafka
-     * protocol requires that replies be sent in the same order they are
-     * received at the server. in a future version of this client we will also
-     * want to do some form of request/response correlation so that multiple
-     * requests can be in flight.
+     * send a request message and process the reply.
      */
     template<typename Func>
-    auto send_recv(Func&& func) {
+    ss::future<iobuf> send_recv(correlation_id correlation, Func&& func) {
         // size prefixed buffer for request
         iobuf buf;
         auto ph = buf.reserve(sizeof(int32_t));
@@ -60,18 +61,46 @@ private:
         auto* raw_size = reinterpret_cast<const char*>(&be_total_size);
         ph.write(raw_size, sizeof(be_total_size));
 
-        return _out.write(iobuf_as_scattered(std::move(buf))).then([this] {
-            return kafka::parse_size(_in).then(
-              [this](std::optional<size_t> sz) {
-                  auto size = sz.value();
-                  return _in.read_exactly(sizeof(correlation_id))
-                    .then([this, size](ss::temporary_buffer<char>) {
-                        // drops the correlation id on the floor
-                        auto remaining = size - sizeof(correlation_id);
-                        return read_iobuf_exactly(_in, remaining);
-                    });
+        // the writes of the stream are ordered, so taking the turn to read
+        // along with the write keeps the replies in the order of the requests
+        auto recv_turn = ss::get_units(_recv_turn, 1);
+        return _out.write(iobuf_as_scattered(std::move(buf)))
+          .then_wrapped([this, correlation, recv_turn{std::move(recv_turn)}](
+                          ss::future<> f) mutable {
+              return std::move(recv_turn).then(
+                [this, correlation, f{std::move(f)}](
+                  ss::semaphore_units<> u) mutable {
+                  if (f.failed()) {
+                      return ss::make_exception_future<iobuf>(
+                        f.get_exception());
+                  }
+                  return recv(correlation).finally([u{std::move(u)}] {});
               });
-        });
+          });
+    }
+
+    ss::future<iobuf> recv(correlation_id correlation) {
+        return kafka::parse_size(_in).then(
+          [this, correlation](std::optional<size_t> sz) {
+              auto size = sz.value();
+              return _in.read_exactly(sizeof(correlation_id::type))
+                .then([this, size, correlation](ss::temporary_buffer<char> b) {
+                    if (b.size() != sizeof(correlation_id::type)) {
+                        // short read
+                        throw std::bad_optional_access();
+                    }
+                    auto received = correlation_id(
+                      ss::read_be<correlation_id::type>(b.get()));
+                    if (received != correlation) {
+                        throw std::runtime_error(fmt::format(
+                          "reply correlation id {} does not match request {}",
+                          received(),
+                          correlation()));
+                    }
+                    auto remaining = size - sizeof(correlation_id::type);
+                    return read_iobuf_exactly(_in, remaining);
+                });
+          });
     }
 
 public:
@@ -85,11 +114,16 @@ public:
     CONCEPT(requires(KafkaRequest<typename T::api_type>))
     ss::future<typename T::api_type::response_type> dispatch(
       T r, api_version request_version, api_version response_version) {
-        return send_recv([this, request_version, r = std::move(r)](
-                           response_writer& wr) mutable {
-                   write_header(wr, T::api_type::key, request_version);
-                   r.encode(wr, request_version);
-               })
+        auto correlation = _correlation;
+        _correlation = _correlation + correlation_id(1);
+        return send_recv(
+                 correlation,
+                 [this, correlation, request_version, r = std::move(r)](
+                   response_writer& wr) mutable {
+                     write_header(
+                       wr, T::api_type::key, request_version, correlation);
+                     r.encode(wr, request_version);
+                 })
           .then([response_version](iobuf buf) {
               using response_type = typename T::api_type::response_type;
               response_type r;
@@ -112,15 +146,20 @@ public:
     }
 
 private:
-    void write_header(response_writer& wr, api_key key, api_version version) {
+    void write_header(
+      response_writer& wr,
+      api_key key,
+      api_version version,
+      correlation_id correlation) {
         wr.write(int16_t(key()));
         wr.write(int16_t(version()));
-        wr.write(int32_t(_correlation()));
+        wr.write(int32_t(correlation()));
         wr.write(std::string_view("test_client"));
-        _correlation = _correlation + correlation_id(1);
     }
 
     correlation_id _correlation{0};
+    /// \brief the turns to read the replies, in the order of the requests
+    ss::semaphore _recv_turn{1};
 };
 
 } // namespace kafka
@@ -0,0 +1,180 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/groups/consumer_lag.h"
+
+#include "cluster/namespace.h"
+#include "config/configuration.h"
+#include "prometheus/prometheus_sanitize.h"
+
+#include <seastar/core/do_with.hh>
+#include <seastar/core/metrics.hh>
+
+#include <absl/container/flat_hash_set.h>
+
+#include <algorithm>
+
+namespace kafka {
+
+void consumer_lag_tracker::update(const group& g) {
+    if (_watermarks.empty()) {
+        return;
+    }
+    auto& topics = _groups[g.id()];
+    // the topics the group no longer commits to keep a negative lag
+    for (auto& [_, t] : topics) {
+        t->lag = -1;
+    }
+
+    const model::topic* last = nullptr;
+    const watermarks::mapped_type* partitions = nullptr;
+    topic_lag* lag = nullptr;
+    g.offsets().for_each([&](
+                           const model::topic& t,
+                           model::partition_id p,
+                           const offset_metadata& md) {
+        // the offsets of a topic are visited one after the other
+        if (&t != last) {
+            last = &t;
+            lag = nullptr;
+            auto it = _watermarks.find(t);
+            partitions = it == _watermarks.end() ? nullptr : &it->second;
+        }
+        if (!partitions || md.offset < model::offset(0)) {
+            return;
+        }
+        auto hwm = partitions->find(p);
+        if (hwm == partitions->end()) {
+            return;
+        }
+        if (!lag) {
+            auto& entry = topics[t];
+            if (!entry) {
+                entry = make_topic_lag(g.id(), t);
+            }
+            lag = entry.get();
+            lag->lag = 0;
+        }
+        lag->lag += std::max<int64_t>(0, hwm->second() - md.offset());
+    });
+
+    for (auto it = topics.begin(); it != topics.end();) {
+        if (it->second->lag < 0) {
+            topics.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    if (topics.empty()) {
+        _groups.erase(g.id());
+    }
+}
+
+ss::future<> consumer_lag_tracker::refresh(const group_map& groups) {
+    if (_refreshing) {
+        return ss::now();
+    }
+    absl::flat_hash_set<model::ntp> ntps;
+    for (const auto& [_, g] : groups) {
+        g->offsets().for_each(
+          [&ntps](
+            const model::topic& t,
+            model::partition_id p,
+            const offset_metadata&) {
+              ntps.emplace(cluster::kafka_namespace, t, p);
+          });
+    }
+    _refreshing = true;
+    return fetch_watermarks(std::move(ntps))
+      .then([this, &groups](watermarks w) {
+          _watermarks = std::move(w);
+          for (auto it = _groups.begin(); it != _groups.end();) {
+              if (_watermarks.empty() || !groups.contains(it->first)) {
+                  _groups.erase(it++);
+              } else {
+                  ++it;
+              }
+          }
+          for (const auto& [_, g] : groups) {
+              update(*g);
+          }
+      })
+      .finally([this] { _refreshing = false; });
+}
+
+ss::future<consumer_lag_tracker::watermarks>
+consumer_lag_tracker::fetch_watermarks(absl::flat_hash_set<model::ntp> ntps) {
+    // the offsets published by the shards are read without a cross core hop
+    const auto interval
+      = config::shard_local_cfg().partition_offsets_publish_interval_ms();
+    if (interval.count() > 0) {
+        const auto& table = _pm.local().offsets_table();
+        watermarks w;
+        for (const auto& ntp : ntps) {
+            if (auto o = table.get(ntp, 2 * interval)) {
+                w[ntp.tp.topic][ntp.tp.partition] = o->high_watermark;
+            }
+        }
+        return ss::make_ready_future<watermarks>(std::move(w));
+    }
+    return ss::do_with(
+      std::move(ntps), [this](const absl::flat_hash_set<model::ntp>& ntps) {
+          return _pm.map_reduce0(
+            [&ntps](cluster::partition_manager& pm) {
+                watermarks w;
+                for (const auto& ntp : ntps) {
+                    if (auto p = pm.get(ntp)) {
+                        w[ntp.tp.topic][ntp.tp.partition] = p->high_watermark();
+                    }
+                }
+                return w;
+            },
+            watermarks{},
+            [](watermarks acc, watermarks w) {
+                for (auto& [t, partitions] : w) {
+                    acc[t].insert(partitions.begin(), partitions.end());
+                }
+                return acc;
+            });
+      });
+}
+
+std::optional<int64_t> consumer_lag_tracker::lag(
+  const group_id& group, const model::topic& topic) const {
+    if (auto g = _groups.find(group); g != _groups.end()) {
+        if (auto t = g->second.find(topic); t != g->second.end()) {
+            return t->second->lag;
+        }
+    }
+    return std::nullopt;
+}
+
+std::unique_ptr<consumer_lag_tracker::topic_lag>
+consumer_lag_tracker::make_topic_lag(
+  const group_id& group, const model::topic& topic) {
+    auto lag = std::make_unique<topic_lag>();
+    if (config::shard_local_cfg().disable_metrics()) {
+        return lag;
+    }
+    namespace sm = ss::metrics;
+    lag->metrics.add_group(
+      prometheus_sanitize::metrics_name("kafka:consumer_group"),
+      {
+        sm::make_gauge(
+          "lag",
+          [l = lag.get()] { return l->lag; },
+          sm::description("Sum of the distances from the offsets committed by "
+                          "the group to the high watermarks of the partitions "
+                          "of the topic"),
+          {sm::label("group")(group()), sm::label("topic")(topic())}),
+      });
+    return lag;
+}
+
+} // namespace kafka
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "cluster/partition_manager.h"
+#include "kafka/groups/group.h"
+#include "kafka/types.h"
+#include "model/fundamental.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/sharded.hh>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+#include <memory>
+#include <optional>
+
+namespace kafka {
+
+/**
+ * Lag of the consumer groups of a shard, exported as a gauge per group and
+ * topic, so that lag exporters do not have to poll the coordinators with
+ * offset fetch and list offsets requests.
+ *
+ * The lag of a topic is the sum, over the partitions the group committed an
+ * offset for, of the distance from the committed offset to the high
+ * watermark. The watermarks are read periodically from the offsets published
+ * by the shards of the node, in one round for all the groups of the shard,
+ * and the lag of a group is recomputed against the last read watermarks on
+ * each of its commits.
+ *
+ * Only the partitions replicated by the node have a known watermark, the
+ * committed partitions of the others are left out of the lag.
+ */
+class consumer_lag_tracker {
+public:
+    using group_map = absl::flat_hash_map<group_id, group_ptr>;
+
+    explicit consumer_lag_tracker(ss::sharded<cluster::partition_manager>& pm)
+      : _pm(pm) {}
+
+    /// \brief recomputes the lag of the group with the last watermarks
+    void update(const group&);
+
+    /// \brief drops the lag of a deleted group
+    void remove(const group_id& g) { _groups.erase(g); }
+
+    /// \brief fetches the watermarks of the partitions committed by the
+    /// groups and recomputes the lag of every group. A refresh is skipped
+    /// while the previous one is still running.
+    ss::future<> refresh(const group_map&);
+
+    /// \brief the lag of the group on the topic, if any is known
+    std::optional<int64_t> lag(const group_id&, const model::topic&) const;
+
+private:
+    struct topic_lag {
+        int64_t lag{0};
+        ss::metrics::metric_groups metrics;
+    };
+
+    using watermarks = absl::flat_hash_map<
+      model::topic,
+      absl::flat_hash_map<model::partition_id, model::offset>>;
+
+    static std::unique_ptr<topic_lag>
+    make_topic_lag(const group_id&, const model::topic&);
+
+    /// the watermarks of the partitions, from the offsets published by the
+    /// shards if they publish them, or else from the shards of the partitions
+    ss::future<watermarks> fetch_watermarks(absl::flat_hash_set<model::ntp>);
+
+    ss::sharded<cluster::partition_manager>& _pm;
+    watermarks _watermarks;
+    absl::flat_hash_map<
+      group_id,
+      absl::flat_hash_map<model::topic, std::unique_ptr<topic_lag>>>
+      _groups;
+    bool _refreshing{false};
+};
+
+} // namespace kafka
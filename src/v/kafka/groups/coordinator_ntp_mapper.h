@@ -22,6 +22,8 @@
 
 #include <seastar/core/reactor.hh>
 
+#include <algorithm>
+
 namespace kafka {
 
 /**
@@ -59,6 +61,16 @@ public:
         return model::ntp(_tp_ns.ns, _tp_ns.tp, model::partition_id{p});
     }
 
+    /**
+     * The number of partitions the group topic is created with. Groups hash
+     * evenly over the partitions, and the partitions of a node are placed on
+     * its least loaded cores, so at least one partition per core spreads the
+     * coordinators over the shards rather than loading a single one.
+     */
+    static int32_t topic_partitions(int32_t configured) {
+        return std::max<int32_t>(configured, ss::smp::count);
+    }
+
     const model::ns& ns() const { return _tp_ns.ns; }
     const model::topic& topic() const { return _tp_ns.tp; }
 
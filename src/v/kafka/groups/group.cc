@@ -15,8 +15,10 @@
 #include "kafka/groups/group_manager.h"
 #include "kafka/logger.h"
 #include "kafka/requests/schemata/describe_groups_response.h"
+#include "kafka/requests/response_writer.h"
 #include "kafka/requests/sync_group_request.h"
 #include "likely.h"
+#include "utils/task_profiler.h"
 #include "utils/to_string.h"
 #include "vassert.h"
 
@@ -48,26 +50,32 @@ group::group(
   kafka::group_id id,
   group_state s,
   config::configuration& conf,
-  ss::lw_shared_ptr<cluster::partition> partition)
+  ss::lw_shared_ptr<cluster::partition> partition,
+  ss::lw_shared_ptr<offset_commit_batcher> commits)
   : _id(id)
   , _state(s)
   , _state_timestamp(clock_type::now())
+  , _last_commit(clock_type::now())
   , _generation(0)
   , _num_members_joining(0)
   , _new_member_added(false)
   , _conf(conf)
-  , _partition(partition) {}
+  , _partition(partition)
+  , _commits(std::move(commits)) {}
 
 group::group(
   kafka::group_id id,
   group_log_group_metadata& md,
   config::configuration& conf,
-  ss::lw_shared_ptr<cluster::partition> partition)
+  ss::lw_shared_ptr<cluster::partition> partition,
+  ss::lw_shared_ptr<offset_commit_batcher> commits)
   : _id(id)
+  , _last_commit(clock_type::now())
   , _num_members_joining(0)
   , _new_member_added(false)
   , _conf(conf)
-  , _partition(partition) {
+  , _partition(partition)
+  , _commits(std::move(commits)) {
     _state = md.members.empty() ? group_state::empty : group_state::stable;
     _generation = md.generation;
     _protocol_type = md.protocol_type;
@@ -148,11 +156,25 @@ void group::add_member_no_join(member_ptr member) {
           fmt::format("group already contains member {}", member));
     }
 
+    if (member->group_instance_id()) {
+        _static_members[*member->group_instance_id()] = member->id();
+    }
+
     for (auto& p : member->protocols()) {
         _supported_protocols[p.name]++;
     }
 }
 
+void group::remove_static_member(const group_member& member) {
+    if (!member.group_instance_id()) {
+        return;
+    }
+    auto it = _static_members.find(*member.group_instance_id());
+    if (it != _static_members.end() && it->second == member.id()) {
+        _static_members.erase(it);
+    }
+}
+
 ss::future<join_group_response> group::add_member(member_ptr member) {
     add_member_no_join(member);
     _num_members_joining++;
@@ -426,6 +448,21 @@ group::join_group_unknown_member(join_group_request&& r) {
 
     auto new_member_id = group::generate_member_id(r);
 
+    if (r.data.group_instance_id) {
+        if (auto old_member_id = get_static_member(*r.data.group_instance_id);
+            old_member_id) {
+            klog.trace(
+              "static member {} of instance {} rejoining as {}",
+              *old_member_id,
+              *r.data.group_instance_id,
+              new_member_id);
+            return update_static_member_and_rebalance(
+              std::move(*old_member_id),
+              std::move(new_member_id),
+              std::move(r));
+        }
+    }
+
     // <kafka>Only return MEMBER_ID_REQUIRED error if joinGroupRequest version
     // is >= 4 and groupInstanceId is configured to unknown.</kafka>
     if (r.version >= api_version(4) && !r.data.group_instance_id) {
@@ -460,6 +497,12 @@ group::join_group_known_member(join_group_request&& r) {
         kafka::member_id new_member_id = std::move(r.data.member_id);
         return add_member_and_rebalance(std::move(new_member_id), std::move(r));
 
+    } else if (is_static_member_fenced(
+                 r.data.member_id, r.data.group_instance_id)) {
+        klog.trace("static member is fenced");
+        return make_join_error(
+          r.data.member_id, error_code::fenced_instance_id);
+
     } else if (!contains_member(r.data.member_id)) {
         klog.trace("member is not registered in the group");
         return make_join_error(r.data.member_id, error_code::unknown_member_id);
@@ -587,20 +630,104 @@ ss::future<join_group_response> group::add_member_and_rebalance(
     // to a lot of defunct members in the rebalance. To prevent this going on
     // indefinitely, we timeout JoinGroup requests for new members. If the new
     // member is still there, we expect it to retry.</kafka>
-    member->expire_timer().cancel();
     auto now = clock_type::now();
     member->set_latest_heartbeat(now);
-    auto deadline = now + _conf.group_new_member_join_timeout();
-    member->expire_timer().set_callback(
-      [this, deadline, member_id = member->id()]() {
-          heartbeat_expire(member_id, deadline);
-      });
-    member->expire_timer().arm(deadline);
+    member->set_expiration(now + _conf.group_new_member_join_timeout());
 
     try_prepare_rebalance();
     return response;
 }
 
+member_ptr group::replace_static_member(
+  const kafka::group_instance_id& instance_id,
+  const kafka::member_id& old_member_id,
+  kafka::member_id new_member_id) {
+    auto it = _members.find(old_member_id);
+    vassert(
+      it != _members.end(),
+      "static member {} of instance {} not found",
+      old_member_id,
+      instance_id);
+    auto member = it->second;
+    _members.erase(it);
+
+    // <kafka>Fence potential duplicate member immediately if someone awaits
+    // join/sync callback.</kafka>
+    try_finish_joining_member(
+      member, _make_join_error(old_member_id, error_code::fenced_instance_id));
+    if (member->is_syncing()) {
+        member->set_sync_response(
+          sync_group_response(error_code::fenced_instance_id));
+    }
+
+    member->replace_id(new_member_id);
+    _members.emplace(new_member_id, member);
+    _static_members[instance_id] = new_member_id;
+    if (is_leader(old_member_id)) {
+        _leader = std::move(new_member_id);
+    }
+    return member;
+}
+
+ss::future<join_group_response> group::update_static_member_and_rebalance(
+  kafka::member_id old_member_id,
+  kafka::member_id new_member_id,
+  join_group_request&& r) {
+    // a leader which restarted is not asked to compute the assignment again
+    auto prev_leader = leader();
+    auto member = replace_static_member(
+      *r.data.group_instance_id, old_member_id, std::move(new_member_id));
+
+    // the session of the new incarnation starts now
+    schedule_next_heartbeat_expiration(member);
+
+    const bool protocols_changed = r.data.protocols != member->protocols();
+    auto response = update_member(member, r.native_member_protocols());
+
+    switch (state()) {
+    case group_state::stable:
+        [[fallthrough]];
+    case group_state::completing_rebalance:
+        if (
+          protocols_changed
+          || (in_state(group_state::completing_rebalance)
+              && is_leader(member->id()))) {
+            // the assignment is computed again if the member's protocols
+            // changed, or if the leader restarted before sending it
+            klog.trace("static member rejoin causing rebalance");
+            try_prepare_rebalance();
+            break;
+        }
+        // the member takes over the assignment of the instance, which is
+        // returned by the sync of the current generation
+        klog.trace("static member rejoined without a rebalance");
+        try_finish_joining_member(
+          member,
+          join_group_response(
+            error_code::none,
+            generation(),
+            protocol().value_or(kafka::protocol_name()),
+            prev_leader.value_or(kafka::member_id()),
+            member->id()));
+        break;
+
+    case group_state::preparing_rebalance:
+        // the member joins the rebalance in progress
+        break;
+
+    case group_state::empty:
+        [[fallthrough]];
+    case group_state::dead:
+        [[fallthrough]];
+    default:
+        // a group with a static member is not empty, and dead groups are
+        // rejected before joining
+        std::terminate();
+    }
+
+    return response;
+}
+
 ss::future<join_group_response>
 group::update_member_and_rebalance(member_ptr member, join_group_request&& r) {
     auto response = update_member(member, r.native_member_protocols());
@@ -693,9 +820,6 @@ void group::complete_join() {
         if (!it->second->is_joining()) {
             vlog(klog.trace, "removing unjoined member {}", it->first);
 
-            // cancel the heartbeat timer
-            it->second->expire_timer().cancel();
-
             // update supported protocols count
             for (auto& p : it->second->protocols()) {
                 auto& count = _supported_protocols[p.name];
@@ -704,6 +828,7 @@ void group::complete_join() {
             }
 
             auto leader = is_leader(it->second->id());
+            remove_static_member(*it->second);
             _members.erase(it++);
 
             if (leader) {
@@ -810,6 +935,21 @@ void group::heartbeat_expire(
     }
 }
 
+void group::expire_members(clock_type::time_point now) {
+    // expiring a member may remove other members from the group, so the
+    // expired ones are collected first
+    std::vector<std::pair<kafka::member_id, clock_type::time_point>> expired;
+    for (const auto& [id, member] : _members) {
+        if (member->expiration() <= now) {
+            expired.emplace_back(id, member->expiration());
+            member->clear_expiration();
+        }
+    }
+    for (auto& [id, deadline] : expired) {
+        heartbeat_expire(std::move(id), deadline);
+    }
+}
+
 void group::try_finish_joining_member(
   member_ptr member, join_group_response&& response) {
     if (member->is_joining()) {
@@ -820,15 +960,9 @@ void group::try_finish_joining_member(
 }
 
 void group::schedule_next_heartbeat_expiration(member_ptr member) {
-    member->expire_timer().cancel();
     auto now = clock_type::now();
     member->set_latest_heartbeat(now);
-    auto deadline = now + member->session_timeout();
-    member->expire_timer().set_callback(
-      [this, deadline, member_id = member->id()]() {
-          heartbeat_expire(member_id, deadline);
-      });
-    member->expire_timer().arm(deadline);
+    member->set_expiration(now + member->session_timeout());
 }
 
 void group::remove_pending_member(const kafka::member_id& member_id) {
@@ -864,6 +998,7 @@ void group::remove_member(member_ptr member) {
             }
         }
         vlog(klog.trace, "removing member {}", member->id());
+        remove_static_member(*member);
         _members.erase(it);
     }
 
@@ -909,6 +1044,11 @@ group::handle_sync_group(sync_group_request&& r) {
         klog.trace("group is dead");
         return make_sync_error(error_code::coordinator_not_available);
 
+    } else if (is_static_member_fenced(
+                 r.data.member_id, r.data.group_instance_id)) {
+        klog.trace("static member is fenced");
+        return make_sync_error(error_code::fenced_instance_id);
+
     } else if (!contains_member(r.data.member_id)) {
         klog.trace("member not found");
         return make_sync_error(error_code::unknown_member_id);
@@ -1076,6 +1216,11 @@ ss::future<heartbeat_response> group::handle_heartbeat(heartbeat_request&& r) {
         klog.trace("group is dead");
         return make_heartbeat_error(error_code::coordinator_not_available);
 
+    } else if (is_static_member_fenced(
+                 r.data.member_id, r.data.group_instance_id)) {
+        klog.trace("static member is fenced");
+        return make_heartbeat_error(error_code::fenced_instance_id);
+
     } else if (!contains_member(r.data.member_id)) {
         klog.trace("member not found");
         return make_heartbeat_error(error_code::unknown_member_id);
@@ -1136,7 +1281,6 @@ group::handle_leave_group(leave_group_request&& r) {
     } else {
         vlog(klog.trace, "member has left {}", r.data.member_id);
         auto member = get_member(r.data.member_id);
-        member->expire_timer().cancel();
         remove_member(member);
         return make_leave_error(error_code::none);
     }
@@ -1145,38 +1289,37 @@ group::handle_leave_group(leave_group_request&& r) {
 void group::complete_offset_commit(
   const model::topic_partition& tp, const offset_metadata& md) {
     // check if tp is pending
-    auto p_it = _pending_offset_commits.find(tp);
-    if (p_it != _pending_offset_commits.end()) {
+    auto pending = _pending_offset_commits.find(tp);
+    if (pending) {
         // save the tp commit if it hasn't yet been seen, or we are completing
         // for an instance that is newer based on log offset
-        auto o_it = _offsets.find(tp);
-        if (o_it == _offsets.end() || o_it->second.log_offset < md.log_offset) {
-            _offsets[tp] = md;
+        auto committed = _offsets.find(tp);
+        if (!committed || committed->log_offset < md.log_offset) {
+            _offsets.insert(tp, md);
+            _encoded_offsets.reset();
         }
 
         // clear pending for this tp
-        if (p_it->second.offset == md.offset) {
-            _pending_offset_commits.erase(p_it);
+        if (pending->offset == md.offset) {
+            _pending_offset_commits.erase(tp);
         }
     }
 }
 
 void group::fail_offset_commit(
   const model::topic_partition& tp, const offset_metadata& md) {
-    auto p_it = _pending_offset_commits.find(tp);
-    if (p_it != _pending_offset_commits.end()) {
+    auto pending = _pending_offset_commits.find(tp);
+    if (pending) {
         // clear pending for this tp
-        if (p_it->second.offset == md.offset) {
-            _pending_offset_commits.erase(p_it);
+        if (pending->offset == md.offset) {
+            _pending_offset_commits.erase(tp);
         }
     }
 }
 
 ss::future<offset_commit_response>
 group::store_offsets(offset_commit_request&& r) {
-    cluster::simple_batch_builder builder(
-      raft::data_batch_type, model::offset(0));
-
+    std::vector<offset_commit_batcher::record> records;
     std::vector<std::pair<model::topic_partition, offset_metadata>>
       offset_commits;
 
@@ -1195,7 +1338,9 @@ group::store_offsets(offset_commit_request&& r) {
               p.committed_leader_epoch,
               p.committed_metadata,
             };
-            builder.add_kv(std::move(key), std::move(val));
+            records.emplace_back(
+              reflection::to_iobuf(std::move(key)),
+              reflection::to_iobuf(std::move(val)));
 
             model::topic_partition tp(t.name, p.partition_index);
             offset_metadata md{
@@ -1207,17 +1352,13 @@ group::store_offsets(offset_commit_request&& r) {
 
             // record the offset commits as pending commits which will be
             // inspected after the append to catch concurrent updates.
-            _pending_offset_commits[tp] = md;
+            _pending_offset_commits.insert(tp, md);
         }
     }
+    _last_commit = clock_type::now();
 
-    auto batch = std::move(builder).build();
-    auto reader = model::make_memory_record_batch_reader(std::move(batch));
-
-    return _partition
-      ->replicate(
-        std::move(reader),
-        raft::replicate_options(raft::consistency_level::quorum_ack))
+    // replicated with the commits of the other groups of the partition
+    return _commits->replicate(std::move(records))
       .then([this, req = std::move(r), commits = std::move(offset_commits)](
               result<raft::replicate_result> r) mutable {
           error_code error = r ? error_code::none : error_code::not_coordinator;
@@ -1242,6 +1383,14 @@ group::store_offsets(offset_commit_request&& r) {
 
 ss::future<offset_commit_response>
 group::handle_offset_commit(offset_commit_request&& r) {
+    return profile_task(
+      "group::handle_offset_commit", [this, r = std::move(r)]() mutable {
+          return do_handle_offset_commit(std::move(r));
+      });
+}
+
+ss::future<offset_commit_response>
+group::do_handle_offset_commit(offset_commit_request&& r) {
     if (in_state(group_state::dead)) {
         return ss::make_ready_future<offset_commit_response>(
           offset_commit_response(r, error_code::coordinator_not_available));
@@ -1250,6 +1399,11 @@ group::handle_offset_commit(offset_commit_request&& r) {
         // <kafka>The group is only using Kafka to store offsets.</kafka>
         return store_offsets(std::move(r));
 
+    } else if (is_static_member_fenced(
+                 r.data.member_id, r.data.group_instance_id)) {
+        return ss::make_ready_future<offset_commit_response>(
+          offset_commit_response(r, error_code::fenced_instance_id));
+
     } else if (!contains_member(r.data.member_id)) {
         return ss::make_ready_future<offset_commit_response>(
           offset_commit_response(r, error_code::unknown_member_id));
@@ -1288,24 +1442,7 @@ group::handle_offset_fetch(offset_fetch_request&& r) {
 
     // retrieve all topics available
     if (!r.data.topics) {
-        absl::flat_hash_map<
-          model::topic,
-          std::vector<offset_fetch_response_partition>>
-          tmp;
-        for (const auto& e : _offsets) {
-            offset_fetch_response_partition p = {
-              .partition_index = e.first.partition,
-              .committed_offset = e.second.offset,
-              .metadata = e.second.metadata,
-              .error_code = error_code::none,
-            };
-            tmp[e.first.topic].push_back(std::move(p));
-        }
-        for (auto& e : tmp) {
-            resp.data.topics.push_back(
-              {.name = e.first, .partitions = std::move(e.second)});
-        }
-
+        resp.encoded = encoded_offsets(r.version);
         return ss::make_ready_future<offset_fetch_response>(std::move(resp));
     }
 
@@ -1340,6 +1477,82 @@ group::handle_offset_fetch(offset_fetch_request&& r) {
     return ss::make_ready_future<offset_fetch_response>(std::move(resp));
 }
 
+iobuf group::encoded_offsets(api_version version) {
+    if (!_encoded_offsets || _encoded_offsets->version != version) {
+        offset_fetch_response_data data;
+        data.error_code = error_code::none;
+        data.topics.reserve(_offsets.size());
+        // the offsets of a topic are visited one after the other
+        _offsets.for_each([&data](
+                            const model::topic& topic,
+                            model::partition_id partition,
+                            const offset_metadata& md) {
+            if (data.topics.empty() || data.topics.back().name != topic) {
+                data.topics.push_back({.name = topic});
+            }
+            data.topics.back().partitions.push_back({
+              .partition_index = partition,
+              .committed_offset = md.offset,
+              .metadata = md.metadata,
+              .error_code = error_code::none,
+            });
+        });
+        iobuf buf;
+        response_writer rw(buf);
+        data.encode(rw, version);
+        _encoded_offsets = encoded_offset_fetch{
+          .version = version, .response = std::move(buf)};
+    }
+    // the response is freed by the shard of the connection, so it gets a copy
+    // rather than a share of the cached buffer
+    return _encoded_offsets->response.copy();
+}
+
+bool group::offsets_expired(
+  clock_type::time_point now, duration_type retention) const {
+    if (retention == duration_type::zero() || !in_state(group_state::empty)) {
+        return false;
+    }
+    return now - std::max(_state_timestamp, _last_commit) >= retention;
+}
+
+ss::future<> group::delete_offsets() {
+    // an empty value is a tombstone, as the values of the group log records
+    // are never empty
+    std::vector<offset_commit_batcher::record> records;
+    records.reserve(_offsets.size() + 1);
+    records.emplace_back(
+      reflection::to_iobuf(group_log_record_key{
+        .record_type = group_log_record_key::type::group_metadata,
+        .key = reflection::to_iobuf(_id),
+      }),
+      iobuf());
+    _offsets.for_each([this, &records](
+                        const model::topic& topic,
+                        model::partition_id partition,
+                        const offset_metadata&) {
+        records.emplace_back(
+          reflection::to_iobuf(group_log_record_key{
+            .record_type = group_log_record_key::type::offset_commit,
+            .key = reflection::to_iobuf(
+              group_log_offset_key{_id, topic, partition}),
+          }),
+          iobuf());
+    });
+    _offsets = offset_table{};
+    _encoded_offsets.reset();
+    return _commits->replicate(std::move(records))
+      .then([id = _id](result<raft::replicate_result> r) {
+          if (!r) {
+              vlog(
+                klog.warn,
+                "failed to delete the offsets of group {}: {}",
+                id,
+                r.error().message());
+          }
+      });
+}
+
 kafka::member_id group::generate_member_id(const join_group_request& r) {
     auto client_id = r.client_id ? *r.client_id : "";
     auto id = r.data.group_instance_id ? (*r.data.group_instance_id)()
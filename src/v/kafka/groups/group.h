@@ -14,6 +14,8 @@
 #include "config/configuration.h"
 #include "kafka/errors.h"
 #include "kafka/groups/member.h"
+#include "kafka/groups/offset_commit_batcher.h"
+#include "kafka/groups/offset_table.h"
 #include "kafka/logger.h"
 #include "kafka/requests/heartbeat_request.h"
 #include "kafka/requests/join_group_request.h"
@@ -70,6 +72,12 @@ struct group_log_group_metadata;
  * also used to wait for all members to join before either rebalancing or
  * removing inactive members.
  *
+ * static members: a member joining with a group instance id (KIP-345) keeps
+ * its membership across restarts. when the instance rejoins with an unknown
+ * member id it takes over the member and the assignment of its previous
+ * incarnation, whose requests are then fenced, without a rebalance of the
+ * group.
+ *
  * \addtogroup kafka-groups
  * @{
  */
@@ -106,24 +114,22 @@ public:
     using clock_type = ss::lowres_clock;
     using duration_type = clock_type::duration;
 
-    struct offset_metadata {
-        model::offset log_offset;
-        model::offset offset;
-        ss::sstring metadata;
-    };
+    using offset_metadata = kafka::offset_metadata;
 
     group(
       kafka::group_id id,
       group_state s,
       config::configuration& conf,
-      ss::lw_shared_ptr<cluster::partition> partition);
+      ss::lw_shared_ptr<cluster::partition> partition,
+      ss::lw_shared_ptr<offset_commit_batcher> commits);
 
     // constructor used when loading state from log
     group(
       kafka::group_id id,
       group_log_group_metadata& md,
       config::configuration& conf,
-      ss::lw_shared_ptr<cluster::partition> partition);
+      ss::lw_shared_ptr<cluster::partition> partition,
+      ss::lw_shared_ptr<offset_commit_batcher> commits);
 
     /// Get the group id.
     const kafka::group_id& id() const { return _id; }
@@ -158,6 +164,32 @@ public:
         return _members.find(member_id) != _members.end();
     }
 
+    /// Get the member id of a static member of the group (if any).
+    std::optional<kafka::member_id>
+    get_static_member(const kafka::group_instance_id& instance_id) const {
+        auto it = _static_members.find(instance_id);
+        if (it == _static_members.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    /**
+     * \brief Check if a request comes from a fenced static member.
+     *
+     * A static member is fenced once its instance rejoined the group under a
+     * new member id.
+     */
+    bool is_static_member_fenced(
+      const kafka::member_id& member_id,
+      const std::optional<kafka::group_instance_id>& instance_id) const {
+        if (!instance_id) {
+            return false;
+        }
+        auto id = get_static_member(*instance_id);
+        return id && *id != member_id;
+    }
+
     /// Check if the group has members.
     bool has_members() const { return !_members.empty(); }
 
@@ -342,6 +374,24 @@ public:
     ss::future<join_group_response> add_member_and_rebalance(
       kafka::member_id member_id, join_group_request&& request);
 
+    /**
+     * \brief Replace the member id of a static member.
+     *
+     * A pending join or sync of the old member id is completed with the
+     * fenced_instance_id error.
+     */
+    member_ptr replace_static_member(
+      const kafka::group_instance_id& instance_id,
+      const kafka::member_id& old_member_id,
+      kafka::member_id new_member_id);
+
+    /// Rejoin a static member under a new member id, rebalancing only if the
+    /// member's protocols changed.
+    ss::future<join_group_response> update_static_member_and_rebalance(
+      kafka::member_id old_member_id,
+      kafka::member_id new_member_id,
+      join_group_request&& request);
+
     /// Update an existing member and rebalance.
     ss::future<join_group_response> update_member_and_rebalance(
       member_ptr member, join_group_request&& request);
@@ -356,11 +406,19 @@ public:
     void heartbeat_expire(
       kafka::member_id member_id, clock_type::time_point deadline);
 
+    /**
+     * \brief Expire the members whose expiration deadline passed.
+     *
+     * Called periodically by the group manager, in place of a timer per
+     * member which every heartbeat would have to re-arm.
+     */
+    void expire_members(clock_type::time_point now);
+
     /// Send response to joining member.
     void try_finish_joining_member(
       member_ptr member, join_group_response&& response);
 
-    /// Restart the member heartbeat timer.
+    /// Push back the member's expiration deadline.
     void schedule_next_heartbeat_expiration(member_ptr member);
 
     /// Removes a full member and may rebalance.
@@ -385,12 +443,15 @@ public:
 
     std::optional<offset_metadata>
     offset(const model::topic_partition& tp) const {
-        if (auto it = _offsets.find(tp); it != _offsets.end()) {
-            return it->second;
+        if (auto md = _offsets.find(tp)) {
+            return *md;
         }
         return std::nullopt;
     }
 
+    /// the committed offsets of the group
+    const offset_table& offsets() const { return _offsets; }
+
     void complete_offset_commit(
       const model::topic_partition& tp, const offset_metadata& md);
 
@@ -406,13 +467,40 @@ public:
     handle_offset_fetch(offset_fetch_request&& r);
 
     void insert_offset(model::topic_partition tp, offset_metadata md) {
-        _offsets[std::move(tp)] = std::move(md);
+        _offsets.insert(tp, std::move(md));
+        _encoded_offsets.reset();
     }
 
+    /// replaces the committed offsets of the group with the recovered ones
+    void recover_offsets(offset_table offsets) {
+        _offsets = std::move(offsets);
+        _encoded_offsets.reset();
+    }
+
+    /**
+     * \brief Check if the offsets of the group expired.
+     *
+     * The offsets of a group without members expire once the group stayed
+     * empty, and received no offset commit, for the retention period.
+     */
+    bool offsets_expired(
+      clock_type::time_point now, duration_type retention) const;
+
+    /**
+     * \brief Delete the group metadata and the committed offsets.
+     *
+     * Tombstones are written for the keys of the group, so that recovery
+     * drops them and compaction of the group topic keeps only the tombstones.
+     */
+    ss::future<> delete_offsets();
+
     // helper for the kafka api: describe groups
     described_group describe() const;
 
 private:
+    ss::future<offset_commit_response>
+    do_handle_offset_commit(offset_commit_request&& r);
+
     using member_map = absl::flat_hash_map<kafka::member_id, member_ptr>;
     using protocol_support = absl::flat_hash_map<kafka::protocol_name, int>;
 
@@ -420,14 +508,23 @@ private:
 
     model::record_batch checkpoint(const assignments_type& assignments);
 
+    void remove_static_member(const group_member&);
+
+    /// the offset fetch response for all the committed offsets
+    iobuf encoded_offsets(api_version);
+
     kafka::group_id _id;
     group_state _state;
     clock_type::time_point _state_timestamp;
+    // the offsets retention period starts over with each commit
+    clock_type::time_point _last_commit;
     kafka::generation_id _generation;
     protocol_support _supported_protocols;
     member_map _members;
     int _num_members_joining;
     absl::flat_hash_set<kafka::member_id> _pending_members;
+    absl::flat_hash_map<kafka::group_instance_id, kafka::member_id>
+      _static_members;
     std::optional<kafka::protocol_type> _protocol_type;
     std::optional<kafka::protocol_name> _protocol;
     std::optional<kafka::member_id> _leader;
@@ -435,9 +532,17 @@ private:
     bool _new_member_added;
     config::configuration& _conf;
     ss::lw_shared_ptr<cluster::partition> _partition;
-    absl::flat_hash_map<model::topic_partition, offset_metadata> _offsets;
-    absl::flat_hash_map<model::topic_partition, offset_metadata>
-      _pending_offset_commits;
+    // shared by the groups of the partition
+    ss::lw_shared_ptr<offset_commit_batcher> _commits;
+    offset_table _offsets;
+    offset_table _pending_offset_commits;
+    // consumers fetch all the offsets of the group each time they join it,
+    // which re-encodes the same offsets until the next commit
+    struct encoded_offset_fetch {
+        api_version version;
+        iobuf response;
+    };
+    std::optional<encoded_offset_fetch> _encoded_offsets;
 };
 
 using group_ptr = ss::lw_shared_ptr<group>;
@@ -9,13 +9,18 @@
 
 #include "kafka/groups/group_manager.h"
 
+#include "bytes/iobuf_parser.h"
 #include "cluster/simple_batch_builder.h"
 #include "kafka/requests/delete_groups_request.h"
 #include "kafka/requests/describe_groups_request.h"
 #include "kafka/requests/offset_commit_request.h"
 #include "kafka/requests/offset_fetch_request.h"
 #include "model/record.h"
+#include "reflection/adl.h"
 #include "resource_mgmt/io_priority.h"
+#include "storage/snapshot.h"
+
+#include <seastar/core/future-util.hh>
 
 namespace kafka {
 
@@ -46,29 +51,111 @@ ss::future<> group_manager::start() {
       cluster::kafka_group_topic,
       [this](ss::lw_shared_ptr<cluster::partition> p) { attach_partition(p); });
 
+    _expiration_timer.set_callback([this] {
+        expire_members();
+        expire_groups();
+    });
+    _expiration_timer.arm_periodic(expiration_sweep_interval);
+
+    if (auto interval = _conf.consumer_lag_refresh_interval_ms();
+        interval > std::chrono::milliseconds(0)) {
+        _lag_timer.set_callback([this] { refresh_consumer_lag(); });
+        _lag_timer.arm_periodic(interval);
+    }
+
     return ss::make_ready_future<>();
 }
 
 ss::future<> group_manager::stop() {
     _pm.local().unregister_manage_notification(_manage_notify_handle);
     _gm.local().unregister_leadership_notification(_leader_notify_handle);
+    _expiration_timer.cancel();
+    _lag_timer.cancel();
 
     for (auto& e : _partitions) {
         e.second->as.request_abort();
+        e.second->snapshot_timer.cancel();
+    }
+
+    return _gate.close().then([this] {
+        return ss::parallel_for_each(_partitions, [](auto& e) {
+            return e.second->commits->stop();
+        });
+    });
+}
+
+void group_manager::expire_members() {
+    const auto now = ss::lowres_clock::now();
+    for (auto& e : _groups) {
+        e.second->expire_members(now);
+    }
+}
+
+void group_manager::expire_groups() {
+    const auto now = ss::lowres_clock::now();
+    const auto retention = _conf.group_offset_retention_ms();
+    std::vector<group_ptr> expired;
+    for (auto& e : _groups) {
+        if (e.second->offsets_expired(now, retention)) {
+            expired.push_back(e.second);
+        }
     }
+    for (auto& group : expired) {
+        vlog(klog.info, "deleting group {} whose offsets expired", group->id());
+        _groups.erase(group->id());
+        _lag.remove(group->id());
+        group->set_state(group_state::dead);
+        (void)ss::with_gate(_gate, [group] { return group->delete_offsets(); });
+    }
+}
 
-    return _gate.close();
+void group_manager::refresh_consumer_lag() {
+    (void)ss::with_gate(_gate, [this] {
+        return _lag.refresh(_groups).handle_exception(
+          [](std::exception_ptr e) {
+              vlog(klog.debug, "failed to refresh consumer lag: {}", e);
+          });
+    });
 }
 
 void group_manager::attach_partition(ss::lw_shared_ptr<cluster::partition> p) {
     klog.debug("attaching group metadata partition {}", p->ntp());
-    auto attached = ss::make_lw_shared<attached_partition>(p);
+    auto attached = ss::make_lw_shared<attached_partition>(
+      p, _conf.group_offset_commit_window_ms());
     auto res = _partitions.try_emplace(p->ntp(), attached);
     // TODO: this is not a forever assertion. this should just generally never
     // happen _now_ because we don't support partition migration / removal.
     // however, group manager is also not prepared for such scenarios.
     vassert(
       res.second, "double registration of ntp in group manager {}", p->ntp());
+
+    attached->snapshot_timer.set_callback([this, ntp = p->ntp()] {
+        auto it = _partitions.find(ntp);
+        if (it == _partitions.end() || _gate.is_closed()) {
+            return;
+        }
+        (void)with_gate(_gate, [this, p = it->second] {
+            return ss::with_semaphore(
+                     p->sem, 1, [this, p] { return snapshot_partition(p); })
+              .handle_exception([p](std::exception_ptr e) {
+                  vlog(
+                    klog.warn,
+                    "failed to snapshot group metadata partition {}: {}",
+                    p->partition->ntp(),
+                    e);
+              })
+              .finally([this, p] { schedule_snapshot(p); });
+        });
+    });
+    schedule_snapshot(attached);
+}
+
+void group_manager::schedule_snapshot(ss::lw_shared_ptr<attached_partition> p) {
+    const auto interval = _conf.group_snapshot_interval_ms();
+    if (interval == std::chrono::milliseconds::zero() || _gate.is_closed()) {
+        return;
+    }
+    p->snapshot_timer.arm(interval);
 }
 
 void group_manager::handle_leader_change(
@@ -124,80 +211,194 @@ ss::future<> group_manager::handle_partition_leader_change(
          * we just became leader. make sure the log is up-to-date. see
          * struct group_log_record_key{} for more details.
          */
-        return inject_noop(p->partition, timeout).then([this, timeout, p] {
-            /*
-             * the full log is read and deduplicated. the dedupe processing is
-             * based on the record keys, so this code should be ready to
-             * transparently take advantage of key-based compaction in the
-             * future.
-             */
-            storage::log_reader_config reader_config(
-              p->partition->start_offset(),
-              model::model_limits<model::offset>::max(),
-              0,
-              std::numeric_limits<size_t>::max(),
-              kafka_read_priority(),
-              raft::data_batch_type,
-              std::nullopt,
-              std::nullopt);
-
-            return p->partition->make_reader(reader_config)
-              .then([this, p, timeout](model::record_batch_reader reader) {
-                  return std::move(reader)
-                    .consume(recovery_batch_consumer(&p->as), timeout)
-                    .then([this, p](recovery_batch_consumer ctx) {
-                        // avoid trying to recover if we stopped the reader
-                        // because an abort was requested
-                        if (p->as.abort_requested()) {
-                            return ss::make_ready_future<>();
-                        }
-                        return recover_partition(p->partition, std::move(ctx))
-                          .then([p] { p->loading = false; });
-                    });
-              });
-        });
+        return inject_noop(p->partition, timeout)
+          .then([this, p] { return read_snapshot(p); })
+          .then([this, timeout, p](
+                  std::optional<recovery_batch_consumer> snapshot) {
+              /*
+               * the log past the snapshot, or the full log when there is none,
+               * is read and deduplicated. the dedupe processing is based on
+               * the record keys, so this code should be ready to
+               * transparently take advantage of key-based compaction in the
+               * future.
+               */
+              auto ctx = snapshot ? std::move(*snapshot)
+                                  : recovery_batch_consumer(&p->as);
+              return replay(p, std::move(ctx), timeout)
+                .then([this, p](recovery_batch_consumer ctx) {
+                    // avoid trying to recover if we stopped the reader
+                    // because an abort was requested
+                    if (p->as.abort_requested()) {
+                        return ss::make_ready_future<>();
+                    }
+                    return recover_partition(p->partition, std::move(ctx))
+                      .then([p] { p->loading = false; });
+                });
+          });
     } else {
         // TODO: we are not yet handling group / partition deletion
         return ss::make_ready_future<>();
     }
 }
 
-/*
- * TODO: this routine can be improved from a copy vs move perspective, but is
- * rather complicated at the moment to start having to also analyze all the data
- * dependencies that would support optimizing for moves.
- */
-ss::future<> group_manager::recover_partition(
-  ss::lw_shared_ptr<cluster::partition> p, recovery_batch_consumer ctx) {
-    /*
-     * [group-id -> [topic-partition -> offset-metadata]]
-     */
-    using offset_map_type = absl::flat_hash_map<
-      kafka::group_id,
-      absl::flat_hash_map<
-        model::topic_partition,
-        std::pair<model::offset, group_log_offset_metadata>>>;
-
-    /*
-     * build a mapping from group-id to (tp, offset) pairs where the latest
-     * entries take precedence.
-     */
-    offset_map_type group_offsets;
-    offset_map_type empty_group_offsets;
+ss::future<recovery_batch_consumer> group_manager::replay(
+  ss::lw_shared_ptr<attached_partition> p,
+  recovery_batch_consumer ctx,
+  ss::lowres_clock::time_point timeout) {
+    auto start = p->partition->start_offset();
+    if (ctx.last_offset >= start) {
+        start = ctx.last_offset + model::offset(1);
+    }
+    storage::log_reader_config reader_config(
+      start,
+      model::model_limits<model::offset>::max(),
+      0,
+      std::numeric_limits<size_t>::max(),
+      kafka_read_priority(),
+      raft::data_batch_type,
+      std::nullopt,
+      std::nullopt);
+
+    return p->partition->make_reader(reader_config)
+      .then([ctx = std::move(ctx),
+             timeout](model::record_batch_reader reader) mutable {
+          return std::move(reader).consume(std::move(ctx), timeout);
+      });
+}
 
-    for (auto& e : ctx.loaded_offsets) {
-        model::topic_partition tp(e.first.topic, e.first.partition);
-        if (ctx.loaded_groups.contains(e.first.group)) {
-            group_offsets[e.first.group][tp] = e.second;
-        } else {
-            empty_group_offsets[e.first.group][tp] = e.second;
+namespace {
+struct group_snapshot_metadata {
+    static constexpr int8_t current_version = 0;
+
+    int8_t version;
+    // size of the snapshot data that follows
+    uint64_t size;
+};
+
+ss::future<iobuf> read_snapshot_data(storage::snapshot_reader& reader) {
+    return reader.read_metadata().then([&reader](iobuf buf) {
+        auto md = reflection::from_iobuf<group_snapshot_metadata>(
+          std::move(buf));
+        if (md.version != group_snapshot_metadata::current_version) {
+            return ss::make_exception_future<iobuf>(
+              std::runtime_error(fmt::format(
+                "unsupported group snapshot version {}", int(md.version))));
         }
-    }
+        return read_iobuf_exactly(reader.input(), md.size)
+          .then([size = md.size](iobuf data) {
+              if (data.size_bytes() != size) {
+                  return ss::make_exception_future<iobuf>(
+                    std::runtime_error(fmt::format(
+                      "truncated group snapshot: {} of {} bytes",
+                      data.size_bytes(),
+                      size)));
+              }
+              return ss::make_ready_future<iobuf>(std::move(data));
+          });
+    });
+}
+} // namespace
+
+ss::future<std::optional<recovery_batch_consumer>>
+group_manager::read_snapshot(ss::lw_shared_ptr<attached_partition> p) {
+    using ret_t = std::optional<recovery_batch_consumer>;
+    return p->snapshots.open_snapshot()
+      .then([p](std::optional<storage::snapshot_reader> reader) {
+          if (!reader) {
+              return ss::make_ready_future<ret_t>(std::nullopt);
+          }
+          return ss::do_with(
+            std::move(*reader), [p](storage::snapshot_reader& reader) {
+                return read_snapshot_data(reader)
+                  .then([p](iobuf data) {
+                      return ret_t(recovery_batch_consumer::from_snapshot(
+                        std::move(data), &p->as));
+                  })
+                  .finally([&reader] { return reader.close(); });
+            });
+      })
+      .handle_exception([p](std::exception_ptr e) {
+          vlog(
+            klog.warn,
+            "ignoring group metadata snapshot of {}: {}",
+            p->partition->ntp(),
+            e);
+          return ret_t(std::nullopt);
+      });
+}
+
+ss::future<> group_manager::write_snapshot(
+  ss::lw_shared_ptr<attached_partition> p, recovery_batch_consumer ctx) {
+    const auto last_offset = ctx.last_offset;
+    auto data = std::move(ctx).snapshot();
+    group_snapshot_metadata md{
+      .version = group_snapshot_metadata::current_version,
+      .size = data.size_bytes(),
+    };
+    return p->snapshots.start_snapshot().then(
+      [p, md, last_offset, data = std::move(data)](
+        storage::snapshot_writer writer) mutable {
+          return ss::do_with(
+            std::move(writer),
+            [p, md, last_offset, data = std::move(data)](
+              storage::snapshot_writer& writer) mutable {
+                return writer.write_metadata(reflection::to_iobuf(md))
+                  .then([&writer, data = std::move(data)]() mutable {
+                      return write_iobuf_to_output_stream(
+                        std::move(data), writer.output());
+                  })
+                  .finally([&writer] { return writer.close(); })
+                  .then([p, &writer] {
+                      return p->snapshots.finish_snapshot(writer);
+                  })
+                  .then([p, last_offset] {
+                      vlog(
+                        klog.debug,
+                        "snapshot of group metadata partition {} up to {}",
+                        p->partition->ntp(),
+                        last_offset);
+                  });
+            });
+      });
+}
+
+ss::future<>
+group_manager::snapshot_partition(ss::lw_shared_ptr<attached_partition> p) {
+    return p->snapshots.remove_partial_snapshots()
+      .then([this, p] { return read_snapshot(p); })
+      .then([this, p](std::optional<recovery_batch_consumer> snapshot) {
+          auto ctx = snapshot ? std::move(*snapshot)
+                              : recovery_batch_consumer(&p->as);
+          const auto covered = ctx.last_offset;
+          if (covered >= p->partition->committed_offset()) {
+              return ss::now();
+          }
+          // the reader stops at the committed offset, so that the snapshot
+          // never covers entries that may still be truncated
+          auto timeout = ss::lowres_clock::now()
+                         + _conf.kafka_group_recovery_timeout_ms();
+          return replay(p, std::move(ctx), timeout)
+            .then([this, p, covered](recovery_batch_consumer ctx) {
+                if (p->as.abort_requested() || ctx.last_offset <= covered) {
+                    return ss::now();
+                }
+                return write_snapshot(p, std::move(ctx));
+            });
+      });
+}
+
+ss::future<> group_manager::recover_partition(
+  ss::lw_shared_ptr<cluster::partition> p, recovery_batch_consumer ctx) {
+    auto commits = _partitions.find(p->ntp())->second->commits;
 
     for (auto& e : ctx.loaded_groups) {
-        offset_map_type::mapped_type offsets; // default empty if not found
-        if (auto it = group_offsets.find(e.first); it != group_offsets.end()) {
-            offsets = it->second;
+        // the offsets left once the groups are recovered are those of groups
+        // only used for offset storage
+        offset_table offsets;
+        if (auto it = ctx.loaded_offsets.find(e.first);
+            it != ctx.loaded_offsets.end()) {
+            offsets = std::move(it->second);
+            ctx.loaded_offsets.erase(it);
         }
 
         auto group = get_group(e.first);
@@ -206,23 +407,15 @@ ss::future<> group_manager::recover_partition(
             continue;
         }
 
-        group = ss::make_lw_shared<kafka::group>(e.first, e.second, _conf, p);
-
-        for (auto& e : offsets) {
-            group->insert_offset(
-              e.first,
-              group::offset_metadata{
-                e.second.first,
-                e.second.second.offset,
-                e.second.second.metadata.value_or(""),
-              });
-        }
+        group = ss::make_lw_shared<kafka::group>(
+          e.first, e.second, _conf, p, commits);
+        group->recover_offsets(std::move(offsets));
 
         _groups.emplace(e.first, group);
         group->reschedule_all_member_heartbeats();
     }
 
-    for (auto& e : empty_group_offsets) {
+    for (auto& e : ctx.loaded_offsets) {
         auto group = get_group(e.first);
         if (group) {
             klog.debug("group already exists {}", e.first);
@@ -230,17 +423,8 @@ ss::future<> group_manager::recover_partition(
         }
 
         group = ss::make_lw_shared<kafka::group>(
-          e.first, group_state::empty, _conf, p);
-
-        for (auto& e : e.second) {
-            group->insert_offset(
-              e.first,
-              group::offset_metadata{
-                e.second.first,
-                e.second.second.offset,
-                e.second.second.metadata.value_or(""),
-              });
-        }
+          e.first, group_state::empty, _conf, p, commits);
+        group->recover_offsets(std::move(e.second));
 
         _groups.emplace(e.first, group);
         group->reschedule_all_member_heartbeats();
@@ -255,7 +439,7 @@ ss::future<> group_manager::recover_partition(
     for (auto& group_id : ctx.removed_groups) {
         if (
           _groups.contains(group_id)
-          && !empty_group_offsets.contains(group_id)) {
+          && !ctx.loaded_offsets.contains(group_id)) {
             return ss::make_exception_future<>(
               std::runtime_error("unexpected unload of active group"));
         }
@@ -268,6 +452,7 @@ ss::future<ss::stop_iteration>
 recovery_batch_consumer::operator()(model::record_batch batch) {
     if (unlikely(batch.header().type != raft::data_batch_type)) {
         klog.trace("ignorning batch with type {}", int(batch.header().type));
+        last_offset = batch.last_offset();
         return ss::make_ready_future<ss::stop_iteration>(
           ss::stop_iteration::no);
     }
@@ -276,6 +461,7 @@ recovery_batch_consumer::operator()(model::record_batch batch) {
           ss::stop_iteration::yes);
     }
     batch_base_offset = batch.base_offset();
+    last_offset = batch.last_offset();
     return ss::do_with(
              std::move(batch),
              [this](model::record_batch& batch) {
@@ -311,24 +497,25 @@ recovery_batch_consumer::handle_group_metadata(iobuf key_buf, iobuf val_buf) {
     auto group_id = kafka::group_id(
       reflection::from_iobuf<kafka::group_id::type>(std::move(key_buf)));
 
-    auto metadata = reflection::from_iobuf<group_log_group_metadata>(
-      std::move(val_buf));
-
-    // TODO: this is primarily driven by _deleted_ partitions, and to a lesser
-    // extent deleted groups. We'll soon handle the later case, but redpanda
-    // doesn't consider yet the former.
-    const bool tombstone = false;
+    // group log values are never empty, except for the tombstones of
+    // deleted groups
+    const bool tombstone = val_buf.empty();
 
-    vlog(klog.trace, "Recovering group metadata {}", group_id);
+    vlog(
+      klog.trace,
+      "Recovering group metadata {} (tombstone {})",
+      group_id,
+      tombstone);
 
     if (tombstone) {
         loaded_groups.erase(group_id);
         removed_groups.emplace(group_id);
     } else {
         removed_groups.erase(group_id);
-        // until we switch over to a compacted topic or use raft snapshots,
-        // always take the latest entry in the log.
-        loaded_groups[group_id] = std::move(metadata);
+        // the latest entry in the log wins, which is the one compaction keeps
+        loaded_groups[group_id]
+          = reflection::from_iobuf<group_log_group_metadata>(
+            std::move(val_buf));
     }
 
     return ss::make_ready_future<>();
@@ -338,27 +525,112 @@ ss::future<>
 recovery_batch_consumer::handle_offset_metadata(iobuf key_buf, iobuf val_buf) {
     auto key = reflection::from_iobuf<group_log_offset_key>(std::move(key_buf));
 
+    // the offsets of deleted groups are tombstoned with an empty value
+    if (val_buf.empty()) {
+        vlog(klog.trace, "Recovering offset tombstone {}", key);
+        if (auto it = loaded_offsets.find(key.group);
+            it != loaded_offsets.end()) {
+            it->second.erase(model::topic_partition(key.topic, key.partition));
+            if (it->second.empty()) {
+                loaded_offsets.erase(it);
+            }
+        }
+        return ss::make_ready_future<>();
+    }
+
     auto metadata = reflection::from_iobuf<group_log_offset_metadata>(
       std::move(val_buf));
 
-    // TODO: handle for deleted groups and partitions. it isn't until kafka
-    // v2.4.0 that delete offsets shows up as an actual api.
-    const bool tombstone = false;
-
     vlog(klog.trace, "Recovering offset {} with metadata {}", key, metadata);
 
-    if (tombstone) {
-        loaded_offsets.erase(key);
-    } else {
-        // until we switch over to a compacted topic or use raft snapshots,
-        // always take the latest entry in the log.
-        loaded_offsets[key] = std::make_pair(
-          batch_base_offset, std::move(metadata));
-    }
+    // the latest entry in the log wins, which is the one compaction keeps
+    model::topic_partition tp(std::move(key.topic), key.partition);
+    loaded_offsets[std::move(key.group)].insert(
+      tp,
+      offset_metadata{
+        batch_base_offset,
+        metadata.offset,
+        std::move(metadata.metadata).value_or(""),
+      });
 
     return ss::make_ready_future<>();
 }
 
+/*
+ * the snapshot is the consumer state, in the form:
+ *
+ *   last_offset
+ *   [group_id, group_log_group_metadata] groups
+ *   [group_id] removed groups
+ *   [group_id, [topic, partition, log offset, offset, metadata]] offsets
+ *
+ * each list being prefixed with its int32 size.
+ */
+iobuf recovery_batch_consumer::snapshot() && {
+    iobuf out;
+    reflection::serialize(
+      out, last_offset, static_cast<int32_t>(loaded_groups.size()));
+    for (auto& [group, md] : loaded_groups) {
+        reflection::serialize(out, group, std::move(md));
+    }
+    reflection::serialize(out, static_cast<int32_t>(removed_groups.size()));
+    for (const auto& group : removed_groups) {
+        reflection::serialize(out, group);
+    }
+    reflection::serialize(out, static_cast<int32_t>(loaded_offsets.size()));
+    for (const auto& [group, offsets] : loaded_offsets) {
+        reflection::serialize(
+          out, group, static_cast<int32_t>(offsets.size()));
+        offsets.for_each([&out](
+                           const model::topic& topic,
+                           model::partition_id partition,
+                           const offset_metadata& md) {
+            reflection::serialize(
+              out, topic, partition, md.log_offset, md.offset, md.metadata);
+        });
+    }
+    return out;
+}
+
+recovery_batch_consumer
+recovery_batch_consumer::from_snapshot(iobuf buf, ss::abort_source* as) {
+    recovery_batch_consumer ctx(as);
+    iobuf_parser in(std::move(buf));
+    ctx.last_offset = reflection::adl<model::offset>{}.from(in);
+    auto groups = reflection::adl<int32_t>{}.from(in);
+    ctx.loaded_groups.reserve(groups);
+    for (int32_t i = 0; i < groups; ++i) {
+        auto group = reflection::adl<kafka::group_id>{}.from(in);
+        ctx.loaded_groups.emplace(
+          std::move(group),
+          reflection::adl<group_log_group_metadata>{}.from(in));
+    }
+    auto removed = reflection::adl<int32_t>{}.from(in);
+    ctx.removed_groups.reserve(removed);
+    for (int32_t i = 0; i < removed; ++i) {
+        ctx.removed_groups.emplace(reflection::adl<kafka::group_id>{}.from(in));
+    }
+    auto offset_groups = reflection::adl<int32_t>{}.from(in);
+    ctx.loaded_offsets.reserve(offset_groups);
+    for (int32_t i = 0; i < offset_groups; ++i) {
+        auto group = reflection::adl<kafka::group_id>{}.from(in);
+        auto& offsets = ctx.loaded_offsets[std::move(group)];
+        auto n = reflection::adl<int32_t>{}.from(in);
+        for (int32_t j = 0; j < n; ++j) {
+            auto topic = reflection::adl<model::topic>{}.from(in);
+            auto partition = reflection::adl<model::partition_id>{}.from(in);
+            offset_metadata md;
+            md.log_offset = reflection::adl<model::offset>{}.from(in);
+            md.offset = reflection::adl<model::offset>{}.from(in);
+            md.metadata = reflection::adl<ss::sstring>{}.from(in);
+            offsets.insert(
+              model::topic_partition(std::move(topic), partition),
+              std::move(md));
+        }
+    }
+    return ctx;
+}
+
 ss::future<join_group_response>
 group_manager::join_group(join_group_request&& r) {
     klog.trace("join request {}", r);
@@ -409,7 +681,7 @@ group_manager::join_group(join_group_request&& r) {
         }
         auto p = it->second->partition;
         group = ss::make_lw_shared<kafka::group>(
-          r.data.group_id, group_state::empty, _conf, p);
+          r.data.group_id, group_state::empty, _conf, p, it->second->commits);
         _groups.emplace(r.data.group_id, group);
         klog.trace("created new group {}", group);
         is_new_group = true;
@@ -422,11 +694,6 @@ ss::future<sync_group_response>
 group_manager::sync_group(sync_group_request&& r) {
     klog.trace("sync request {}", r);
 
-    if (r.data.group_instance_id) {
-        klog.trace("static group membership is unsupported");
-        return make_sync_error(error_code::unsupported_version);
-    }
-
     auto error = validate_group_status(
       r.ntp, r.data.group_id, sync_group_api::key);
     if (error != error_code::none) {
@@ -456,11 +723,6 @@ group_manager::sync_group(sync_group_request&& r) {
 ss::future<heartbeat_response> group_manager::heartbeat(heartbeat_request&& r) {
     klog.trace("heartbeat request {}", r);
 
-    if (r.data.group_instance_id) {
-        klog.trace("static group membership is unsupported");
-        return make_heartbeat_error(error_code::unsupported_version);
-    }
-
     auto error = validate_group_status(
       r.ntp, r.data.group_id, heartbeat_api::key);
     if (error != error_code::none) {
@@ -516,9 +778,13 @@ group_manager::offset_commit(offset_commit_request&& r) {
         if (r.data.generation_id < 0) {
             // <kafka>the group is not relying on Kafka for group management, so
             // allow the commit</kafka>
-            auto p = _partitions.find(r.ntp)->second->partition;
+            auto& attached = _partitions.find(r.ntp)->second;
             group = ss::make_lw_shared<kafka::group>(
-              r.data.group_id, group_state::empty, _conf, p);
+              r.data.group_id,
+              group_state::empty,
+              _conf,
+              attached->partition,
+              attached->commits);
             _groups.emplace(r.data.group_id, group);
         } else {
             // <kafka>or this is a request coming from an older generation.
@@ -528,7 +794,13 @@ group_manager::offset_commit(offset_commit_request&& r) {
         }
     }
 
-    return group->handle_offset_commit(std::move(r));
+    return group->handle_offset_commit(std::move(r))
+      .then([this, group](offset_commit_response resp) {
+          if (!group->in_state(group_state::dead)) {
+              _lag.update(*group);
+          }
+          return resp;
+      });
 }
 
 ss::future<offset_fetch_response>
@@ -15,8 +15,10 @@
 #include "cluster/partition_manager.h"
 #include "config/configuration.h"
 #include "kafka/errors.h"
+#include "kafka/groups/consumer_lag.h"
 #include "kafka/groups/group.h"
 #include "kafka/groups/member.h"
+#include "kafka/groups/offset_table.h"
 #include "kafka/requests/describe_groups_request.h"
 #include "kafka/requests/heartbeat_request.h"
 #include "kafka/requests/join_group_request.h"
@@ -26,11 +28,14 @@
 #include "kafka/requests/offset_fetch_request.h"
 #include "kafka/requests/sync_group_request.h"
 #include "raft/group_manager.h"
+#include "resource_mgmt/io_priority.h"
 #include "seastarx.h"
+#include "storage/snapshot.h"
 
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
 
 #include <absl/container/flat_hash_map.h>
 #include <cluster/partition_manager.h>
@@ -96,6 +101,39 @@ struct recovery_batch_consumer;
  * After the log is read the deduplicated state is used to re-populate the
  * in-memory cache of groups/commits through.
  *
+ * Snapshots (background)
+ * ======================
+ *
+ * Every replica of a partition, leader or not, periodically snapshots the
+ * deduplicated state next to the partition log. The snapshot records the last
+ * offset it covers, and only ever covers committed entries, so that it stays
+ * valid across leadership changes. A new snapshot is made by loading the
+ * previous one and reading the log past it, under the partition's semaphore.
+ *
+ * Recovery starts from the snapshot when there is one and only reads the tail
+ * of the log. A snapshot that can't be read is ignored and the whole log is
+ * read instead.
+ *
+ * Member expiration
+ * =================
+ *
+ * Heartbeats only push back the expiration deadline of the member. A single
+ * periodic sweep per shard expires the members of all groups whose deadline
+ * passed, instead of a timer per member re-armed on every heartbeat.
+ *
+ * The same sweep deletes the groups left empty, without offset commits, for
+ * the offset retention period. Tombstones are written for their metadata and
+ * offsets, so that recovery and the compaction of the group topic drop them,
+ * and the state to recover stays proportional to the live offsets.
+ *
+ * Consumer lag
+ * ============
+ *
+ * The lag of the groups is computed against the high watermarks of the
+ * partitions they commit to, fetched from the shards of the node every
+ * consumer_lag_refresh_interval_ms, and is recomputed on each offset commit.
+ * See consumer_lag_tracker.
+ *
  * Unload (background)
  * ===================
  *
@@ -117,6 +155,7 @@ public:
       : _gm(gm)
       , _pm(pm)
       , _conf(conf)
+      , _lag(pm)
       , _self(cluster::make_self_broker(config::shard_local_cfg())) {}
 
     ss::future<> start();
@@ -150,6 +189,9 @@ public:
 
     described_group describe_group(const model::ntp&, const kafka::group_id&);
 
+    /// \brief the lag of the groups of the shard
+    const consumer_lag_tracker& consumer_lag() const { return _lag; }
+
 public:
     error_code validate_group_status(
       const model::ntp& ntp, const group_id& group, api_key api);
@@ -167,17 +209,40 @@ private:
     cluster::notification_id_type _manage_notify_handle;
     ss::gate _gate;
 
+    /// the resolution of the session and join timeouts of the members
+    static constexpr auto expiration_sweep_interval
+      = std::chrono::milliseconds(500);
+
+    void expire_members();
+    void expire_groups();
+    ss::timer<ss::lowres_clock> _expiration_timer;
+
+    void refresh_consumer_lag();
+    ss::timer<ss::lowres_clock> _lag_timer;
+
     void attach_partition(ss::lw_shared_ptr<cluster::partition>);
 
+    static constexpr const char* snapshot_filename = "groups_snapshot";
+
     struct attached_partition {
         bool loading;
         ss::semaphore sem{1};
         ss::abort_source as;
         ss::lw_shared_ptr<cluster::partition> partition;
+        ss::lw_shared_ptr<offset_commit_batcher> commits;
+        storage::snapshot_manager snapshots;
+        ss::timer<ss::lowres_clock> snapshot_timer;
 
-        attached_partition(ss::lw_shared_ptr<cluster::partition> p)
+        attached_partition(
+          ss::lw_shared_ptr<cluster::partition> p,
+          std::chrono::milliseconds commit_window)
           : loading(true)
-          , partition(std::move(p)) {}
+          , partition(p)
+          , commits(ss::make_lw_shared<offset_commit_batcher>(p, commit_window))
+          , snapshots(
+              std::filesystem::path(p->log_config().work_directory()),
+              kafka_read_priority(),
+              snapshot_filename) {}
     };
 
     absl::flat_hash_map<model::ntp, ss::lw_shared_ptr<attached_partition>>
@@ -195,6 +260,19 @@ private:
     ss::future<> recover_partition(
       ss ::lw_shared_ptr<cluster::partition>, recovery_batch_consumer);
 
+    /// reads the log past the state already consumed by the consumer
+    ss::future<recovery_batch_consumer> replay(
+      ss::lw_shared_ptr<attached_partition>,
+      recovery_batch_consumer,
+      ss::lowres_clock::time_point timeout);
+
+    ss::future<std::optional<recovery_batch_consumer>>
+      read_snapshot(ss::lw_shared_ptr<attached_partition>);
+    ss::future<> write_snapshot(
+      ss::lw_shared_ptr<attached_partition>, recovery_batch_consumer);
+    ss::future<> snapshot_partition(ss::lw_shared_ptr<attached_partition>);
+    void schedule_snapshot(ss::lw_shared_ptr<attached_partition>);
+
     ss::future<> inject_noop(
       ss::lw_shared_ptr<cluster::partition> p,
       ss::lowres_clock::time_point timeout);
@@ -203,6 +281,7 @@ private:
     ss::sharded<cluster::partition_manager>& _pm;
     config::configuration& _conf;
     absl::flat_hash_map<group_id, group_ptr> _groups;
+    consumer_lag_tracker _lag;
     model::broker _self;
 };
 
@@ -296,17 +375,21 @@ struct recovery_batch_consumer {
 
     recovery_batch_consumer end_of_stream() { return std::move(*this); }
 
+    /// \brief serializes the consumed state, see from_snapshot()
+    iobuf snapshot() &&;
+    static recovery_batch_consumer from_snapshot(iobuf, ss::abort_source*);
+
     model::offset batch_base_offset;
+    // the log was consumed up to and including this offset
+    model::offset last_offset;
 
     absl::flat_hash_map<kafka::group_id, group_log_group_metadata>
       loaded_groups;
 
     absl::flat_hash_set<kafka::group_id> removed_groups;
 
-    absl::flat_hash_map<
-      group_log_offset_key,
-      std::pair<model::offset, group_log_offset_metadata>>
-      loaded_offsets;
+    // committed offsets indexed per group while reading the log
+    absl::flat_hash_map<kafka::group_id, offset_table> loaded_offsets;
 
     // this is invalid after end_of_stream() is invoked
     ss::abort_source* as;
@@ -111,6 +111,23 @@ public:
           });
     }
 
+    /// \brief the lag of the group on the topic, as last computed by its
+    /// coordinator
+    ss::future<std::optional<int64_t>>
+    consumer_lag(group_id g, model::topic t) {
+        auto m = shard_for(g);
+        if (!m) {
+            return ss::make_ready_future<std::optional<int64_t>>(
+              std::nullopt);
+        }
+        return _group_manager.invoke_on(
+          m->second,
+          _ssg,
+          [g = std::move(g), t = std::move(t)](GroupMgr& mgr) {
+              return mgr.consumer_lag().lag(g, t);
+          });
+    }
+
 private:
     std::optional<std::pair<model::ntp, ss::shard_id>>
     shard_for(const group_id& group) {
@@ -111,6 +111,9 @@ public:
     /// Get the member id.
     const kafka::member_id& id() const { return _state.id; }
 
+    /// Replace the member id of a static member rejoining the group.
+    void replace_id(kafka::member_id id) { _state.id = std::move(id); }
+
     /// Get the id of the member's group.
     const kafka::group_id& group_id() const { return _group_id; }
 
@@ -221,7 +224,11 @@ public:
         _latest_heartbeat = t;
     }
 
-    ss::timer<clock_type>& expire_timer() { return _expire_timer; }
+    /// The deadline after which the member is considered for expiration by
+    /// the periodic sweep of the group manager.
+    clock_type::time_point expiration() const { return _expiration; }
+    void set_expiration(clock_type::time_point t) { _expiration = t; }
+    void clear_expiration() { _expiration = clock_type::time_point::max(); }
 
     // helper for kafka api: describe groups
     described_group_member describe(const kafka::protocol_name&) const;
@@ -238,7 +245,7 @@ private:
 
     bool _is_new;
     clock_type::time_point _latest_heartbeat;
-    ss::timer<clock_type> _expire_timer;
+    clock_type::time_point _expiration{clock_type::time_point::max()};
 
     // external shutdown synchronization
     std::unique_ptr<sync_promise> _sync_promise;
@@ -0,0 +1,96 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/groups/offset_commit_batcher.h"
+
+#include "cluster/simple_batch_builder.h"
+#include "kafka/logger.h"
+#include "model/record_batch_reader.h"
+#include "raft/types.h"
+#include "vlog.h"
+
+#include <iterator>
+
+namespace kafka {
+
+offset_commit_batcher::offset_commit_batcher(
+  ss::lw_shared_ptr<cluster::partition> partition,
+  std::chrono::milliseconds window)
+  : _partition(std::move(partition))
+  , _window_duration(window)
+  , _flush_timer([this] { flush(); }) {}
+
+ss::future<offset_commit_batcher::result_type>
+offset_commit_batcher::replicate(std::vector<record> records) {
+    if (_gate.is_closed()) {
+        return ss::make_exception_future<result_type>(
+          ss::gate_closed_exception());
+    }
+    std::move(
+      records.begin(), records.end(), std::back_inserter(_window.records));
+    auto f = _window.waiters.emplace_back().get_future();
+    if (_window.records.size() >= max_batch_records) {
+        _flush_timer.cancel();
+        flush();
+    } else if (!_flush_timer.armed()) {
+        // a zero window still coalesces the commits of the same task quota
+        _flush_timer.arm(_window_duration);
+    }
+    return f;
+}
+
+void offset_commit_batcher::flush() {
+    auto w = std::exchange(_window, {});
+    if (w.waiters.empty()) {
+        return;
+    }
+    vlog(
+      klog.trace,
+      "replicating {} offset commit records of {} requests to {}",
+      w.records.size(),
+      w.waiters.size(),
+      _partition->ntp());
+    cluster::simple_batch_builder builder(
+      raft::data_batch_type, model::offset(0));
+    for (auto& [key, value] : w.records) {
+        builder.add_raw_kv(std::move(key), std::move(value));
+    }
+    auto reader = model::make_memory_record_batch_reader(
+      std::move(builder).build());
+    // background, the gate is waited for by stop()
+    (void)ss::with_gate(
+      _gate,
+      [this, reader = std::move(reader)]() mutable {
+          return _partition->replicate(
+            std::move(reader),
+            raft::replicate_options(raft::consistency_level::quorum_ack));
+      })
+      .then_wrapped(
+        [waiters = std::move(w.waiters)](ss::future<result_type> f) mutable {
+            if (f.failed()) {
+                auto e = f.get_exception();
+                for (auto& w : waiters) {
+                    w.set_exception(e);
+                }
+                return;
+            }
+            auto r = f.get0();
+            for (auto& w : waiters) {
+                w.set_value(r);
+            }
+        });
+}
+
+ss::future<> offset_commit_batcher::stop() {
+    _flush_timer.cancel();
+    flush();
+    return _gate.close();
+}
+
+} // namespace kafka
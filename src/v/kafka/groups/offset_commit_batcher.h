@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/iobuf.h"
+#include "cluster/partition.h"
+#include "outcome.h"
+#include "raft/types.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/timer.hh>
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+namespace kafka {
+
+/**
+ * Offset commits of all the groups coordinated by a partition of the group
+ * metadata topic.
+ *
+ * Rather than replicating each commit request as its own batch, the records of
+ * the requests received within a flush window are replicated together as a
+ * single batch. Each request still waits for its own result, which is the
+ * result of the batch it was part of.
+ */
+class offset_commit_batcher {
+public:
+    using clock_type = ss::lowres_clock;
+    using record = std::pair<iobuf, iobuf>;
+    using result_type = result<raft::replicate_result>;
+
+    /// a window is flushed early once it holds that many records
+    static constexpr size_t max_batch_records = 4096;
+
+    offset_commit_batcher(
+      ss::lw_shared_ptr<cluster::partition>, std::chrono::milliseconds window);
+
+    /// \brief replicates the records of a commit request with those of the
+    /// other requests of the current window
+    ss::future<result_type> replicate(std::vector<record>);
+
+    /// flushes the current window and waits for the flushes in flight
+    ss::future<> stop();
+
+private:
+    struct window {
+        std::vector<record> records;
+        std::vector<ss::promise<result_type>> waiters;
+    };
+
+    void flush();
+
+    ss::lw_shared_ptr<cluster::partition> _partition;
+    std::chrono::milliseconds _window_duration;
+    window _window;
+    ss::timer<clock_type> _flush_timer;
+    ss::gate _gate;
+};
+
+} // namespace kafka
@@ -0,0 +1,135 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/groups/offset_table.h"
+
+#include <algorithm>
+
+namespace kafka {
+
+topic_interner::topic_ptr topic_interner::intern(const model::topic& topic) {
+    const std::string_view name(topic());
+    if (auto it = _topics.find(name); it != _topics.end()) {
+        return *it;
+    }
+    if (_topics.size() >= _sweep_at) {
+        sweep();
+    }
+    auto t = ss::make_lw_shared<const model::topic>(topic);
+    _topics.insert(t);
+    return t;
+}
+
+void topic_interner::sweep() {
+    for (auto it = _topics.begin(); it != _topics.end();) {
+        if (it->use_count() == 1) {
+            _topics.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    // amortize the sweeps over at least as many new names as are in use
+    _sweep_at = std::max(min_sweep_size, _topics.size() * 2);
+}
+
+const offset_metadata*
+offset_table::topic_offsets::find(model::partition_id p) const {
+    if (p() >= 0 && static_cast<size_t>(p()) < dense.size()) {
+        return dense[p()] ? &*dense[p()] : nullptr;
+    }
+    if (auto it = sparse.find(p); it != sparse.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+bool offset_table::topic_offsets::insert(
+  model::partition_id p, offset_metadata md) {
+    if (p() < 0) {
+        auto [_, inserted] = sparse.insert_or_assign(p, std::move(md));
+        size += inserted;
+        return inserted;
+    }
+    const auto idx = static_cast<size_t>(p());
+    // the array grows as long as it stays about half full
+    if (idx >= dense.size() && idx < 2 * (size + 1) + 32) {
+        dense.resize(idx + 1);
+        for (auto it = sparse.begin(); it != sparse.end();) {
+            auto e = it++;
+            if (e->first() >= 0 && static_cast<size_t>(e->first()) <= idx) {
+                dense[e->first()] = std::move(e->second);
+                sparse.erase(e);
+            }
+        }
+    }
+    if (idx < dense.size()) {
+        const bool inserted = !dense[idx];
+        dense[idx] = std::move(md);
+        size += inserted;
+        return inserted;
+    }
+    auto [_, inserted] = sparse.insert_or_assign(p, std::move(md));
+    size += inserted;
+    return inserted;
+}
+
+bool offset_table::topic_offsets::erase(model::partition_id p) {
+    if (p() >= 0 && static_cast<size_t>(p()) < dense.size()) {
+        if (!dense[p()]) {
+            return false;
+        }
+        dense[p()] = std::nullopt;
+        --size;
+        return true;
+    }
+    const bool erased = sparse.erase(p) > 0;
+    size -= erased;
+    return erased;
+}
+
+const offset_metadata*
+offset_table::find(const model::topic_partition& tp) const {
+    if (auto it = _topics.find(std::string_view(tp.topic()));
+        it != _topics.end()) {
+        return it->second.find(tp.partition);
+    }
+    return nullptr;
+}
+
+void offset_table::insert(
+  const model::topic_partition& tp, offset_metadata md) {
+    auto it = _topics.find(std::string_view(tp.topic()));
+    if (it == _topics.end()) {
+        auto topic = interned_topics().intern(tp.topic);
+        std::string_view key((*topic)());
+        it = _topics.emplace(key, topic_offsets{.topic = std::move(topic)})
+               .first;
+    }
+    if (auto old = it->second.find(tp.partition)) {
+        _memory.sub(memory_usage(*old));
+    }
+    _memory.add(memory_usage(md));
+    _size += it->second.insert(tp.partition, std::move(md));
+}
+
+void offset_table::erase(const model::topic_partition& tp) {
+    auto it = _topics.find(std::string_view(tp.topic()));
+    if (it == _topics.end()) {
+        return;
+    }
+    if (auto old = it->second.find(tp.partition)) {
+        _memory.sub(memory_usage(*old));
+    }
+    _size -= it->second.erase(tp.partition);
+    if (it->second.size == 0) {
+        _topics.erase(it);
+    }
+}
+
+} // namespace kafka
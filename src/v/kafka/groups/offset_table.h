@@ -0,0 +1,155 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "model/fundamental.h"
+#include "resource_mgmt/memory_accounting.h"
+#include "seastarx.h"
+
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/sstring.hh>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/hash/hash.h>
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace kafka {
+
+/// Committed offset of a group for a partition
+struct offset_metadata {
+    model::offset log_offset;
+    model::offset offset;
+    ss::sstring metadata;
+};
+
+/**
+ * Topic names shared by all the groups of a shard.
+ *
+ * The groups of a shard commonly consume the same topics, so each name is
+ * kept once per shard instead of once per committed partition of each group.
+ * Names no longer referenced by any group are dropped as the set grows.
+ */
+class topic_interner {
+public:
+    using topic_ptr = ss::lw_shared_ptr<const model::topic>;
+
+    /// \brief the shared instance of the name of the topic
+    topic_ptr intern(const model::topic&);
+
+    size_t size() const { return _topics.size(); }
+
+private:
+    struct topic_hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view v) const {
+            return absl::Hash<std::string_view>{}(v);
+        }
+        size_t operator()(const topic_ptr& t) const {
+            return (*this)(std::string_view((*t)()));
+        }
+    };
+    struct topic_eq {
+        using is_transparent = void;
+        static std::string_view view(std::string_view v) { return v; }
+        static std::string_view view(const topic_ptr& t) {
+            return std::string_view((*t)());
+        }
+        template<typename L, typename R>
+        bool operator()(const L& l, const R& r) const {
+            return view(l) == view(r);
+        }
+    };
+
+    void sweep();
+
+    absl::flat_hash_set<topic_ptr, topic_hash, topic_eq> _topics;
+    // size of the set at which unreferenced names are next dropped
+    size_t _sweep_at{min_sweep_size};
+    static constexpr size_t min_sweep_size = 64;
+};
+
+/// \brief the topic names interned on this shard
+inline topic_interner& interned_topics() {
+    static thread_local topic_interner topics;
+    return topics;
+}
+
+/**
+ * Committed offsets of a group.
+ *
+ * The offsets are kept per topic, in an array indexed by partition id, with
+ * the topic names interned per shard. A partition far past the others of its
+ * topic, so that the array would be mostly empty, is kept aside in a map
+ * until the array grows enough to hold it.
+ */
+class offset_table {
+public:
+    const offset_metadata* find(const model::topic_partition&) const;
+    offset_metadata* find(const model::topic_partition& tp) {
+        return const_cast<offset_metadata*>(
+          static_cast<const offset_table&>(*this).find(tp));
+    }
+    bool contains(const model::topic_partition& tp) const {
+        return find(tp) != nullptr;
+    }
+
+    /// inserts the offset of the partition, replacing the previous one
+    void insert(const model::topic_partition&, offset_metadata);
+    void erase(const model::topic_partition&);
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    /// \brief calls f(topic, partition, metadata) for each committed offset,
+    /// the offsets of a topic being visited one after the other
+    template<typename Func>
+    void for_each(Func&& f) const {
+        for (const auto& [_, t] : _topics) {
+            for (size_t i = 0; i < t.dense.size(); ++i) {
+                if (t.dense[i]) {
+                    f(*t.topic, model::partition_id(i), *t.dense[i]);
+                }
+            }
+            for (const auto& [p, md] : t.sparse) {
+                f(*t.topic, p, md);
+            }
+        }
+    }
+
+private:
+    struct topic_offsets {
+        topic_interner::topic_ptr topic;
+        std::vector<std::optional<offset_metadata>> dense;
+        absl::flat_hash_map<model::partition_id, offset_metadata> sparse;
+        size_t size{0};
+
+        const offset_metadata* find(model::partition_id) const;
+        // returns whether the partition was not in the table yet
+        bool insert(model::partition_id, offset_metadata);
+        // returns whether the partition was in the table
+        bool erase(model::partition_id);
+    };
+
+    static size_t memory_usage(const offset_metadata& md) {
+        return sizeof(offset_metadata) + md.metadata.size();
+    }
+
+    // keyed by a view of the interned name held by the value
+    absl::flat_hash_map<std::string_view, topic_offsets> _topics;
+    size_t _size{0};
+    tracked_memory _memory{tracked_memory::subsystem::group_offsets};
+};
+
+} // namespace kafka
@@ -0,0 +1,63 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/load_sketches.h"
+
+#include "config/configuration.h"
+
+namespace kafka {
+
+void load_sketches::sketches::merge(const sketches& o) {
+    partition_bytes.merge(o.partition_bytes);
+    partition_requests.merge(o.partition_requests);
+    client_bytes.merge(o.client_bytes);
+    client_requests.merge(o.client_requests);
+}
+
+void load_sketches::record_partition(const model::ntp& ntp, size_t bytes) {
+    maybe_decay();
+    _sketches.partition_bytes.add(ntp, bytes);
+    _sketches.partition_requests.add(ntp);
+}
+
+void load_sketches::record_client(
+  std::optional<std::string_view> client_id, size_t bytes) {
+    maybe_decay();
+    // requests without a client id are counted under the empty id
+    ss::sstring id;
+    if (client_id) {
+        id = ss::sstring(client_id->data(), client_id->size());
+    }
+    _sketches.client_bytes.add(id, bytes);
+    _sketches.client_requests.add(id);
+}
+
+void load_sketches::maybe_decay() {
+    const auto interval
+      = config::shard_local_cfg().kafka_load_sketch_decay_interval_ms();
+    if (interval.count() <= 0) {
+        return;
+    }
+    const auto now = ss::lowres_clock::now();
+    if (now - _decayed < interval) {
+        return;
+    }
+    _decayed = now;
+    _sketches.partition_bytes.decay();
+    _sketches.partition_requests.decay();
+    _sketches.client_bytes.decay();
+    _sketches.client_requests.decay();
+}
+
+load_sketches& shard_load_sketches() {
+    static thread_local load_sketches sketches;
+    return sketches;
+}
+
+} // namespace kafka
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "model/fundamental.h"
+#include "seastarx.h"
+#include "utils/space_saving.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/sstring.hh>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+namespace kafka {
+
+/**
+ * Heaviest partitions and clients of the produce and fetch requests served by
+ * a shard, by bytes and by requests, in space-saving sketches of a bounded
+ * number of keys, so that the hot keys of a shard are known without a metric
+ * per partition and per client.
+ *
+ * The sketches of the shards are merged into those of the node by the admin
+ * api. Their counts are halved every decay interval, so that they follow the
+ * recent load rather than the load since the start of the node.
+ */
+class load_sketches {
+public:
+    static constexpr size_t capacity = 128;
+
+    using partition_sketch = space_saving<model::ntp, std::hash<model::ntp>>;
+    using client_sketch = space_saving<ss::sstring>;
+
+    struct sketches {
+        partition_sketch partition_bytes{capacity};
+        partition_sketch partition_requests{capacity};
+        client_sketch client_bytes{capacity};
+        client_sketch client_requests{capacity};
+
+        void merge(const sketches&);
+    };
+
+    /// \brief a read of, or a write to, the partition
+    void record_partition(const model::ntp&, size_t bytes);
+    /// \brief a produce or fetch request of the client
+    void record_client(std::optional<std::string_view> client_id, size_t);
+
+    const sketches& get() const { return _sketches; }
+
+private:
+    void maybe_decay();
+
+    sketches _sketches;
+    ss::lowres_clock::time_point _decayed{ss::lowres_clock::now()};
+};
+
+/// \brief the load sketches of this shard
+load_sketches& shard_load_sketches();
+
+} // namespace kafka
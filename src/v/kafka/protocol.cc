@@ -10,10 +10,21 @@
 #include "protocol.h"
 
 #include "cluster/topics_frontend.h"
+#include "config/configuration.h"
 #include "kafka/logger.h"
 #include "kafka/protocol_utils.h"
+#include "kafka/requests/fetch_memory.h"
+#include "kafka/requests/fetch_request.h"
+#include "kafka/requests/find_coordinator_request.h"
+#include "kafka/requests/heartbeat_request.h"
+#include "kafka/requests/join_group_request.h"
+#include "kafka/requests/leave_group_request.h"
+#include "kafka/requests/metadata_request.h"
+#include "kafka/requests/produce_request.h"
 #include "kafka/requests/request_context.h"
 #include "kafka/requests/response.h"
+#include "kafka/requests/sync_group_request.h"
+#include "prometheus/prometheus_sanitize.h"
 #include "utils/utf8.h"
 #include "vlog.h"
 
@@ -21,6 +32,7 @@
 #include <seastar/core/future-util.hh>
 #include <seastar/core/metrics.hh>
 #include <seastar/core/scattered_message.hh>
+#include <seastar/core/scheduling.hh>
 #include <seastar/core/semaphore.hh>
 #include <seastar/util/log.hh>
 
@@ -28,6 +40,8 @@
 
 #include <exception>
 #include <limits>
+#include <utility>
+#include <vector>
 
 namespace kafka {
 using sequence_id = protocol::sequence_id;
@@ -35,21 +49,68 @@ using session_resources = protocol::session_resources;
 
 protocol::protocol(
   ss::smp_service_group smp,
+  ss::scheduling_group control_sg,
   ss::sharded<cluster::metadata_cache>& meta,
   ss::sharded<cluster::topics_frontend>& tf,
   ss::sharded<quota_manager>& quota,
   ss::sharded<kafka::group_router_type>& router,
   ss::sharded<cluster::shard_table>& tbl,
   ss::sharded<cluster::partition_manager>& pm,
-  ss::sharded<coordinator_ntp_mapper>& coordinator_mapper) noexcept
+  ss::sharded<coordinator_ntp_mapper>& coordinator_mapper,
+  shard_aware sa) noexcept
   : _smp_group(smp)
+  , _control_sg(control_sg)
+  , _control_memory_max(std::max<size_t>(
+      1, config::shard_local_cfg().kafka_control_plane_memory_bytes()))
+  , _control_memory(_control_memory_max)
   , _topics_frontend(tf)
   , _metadata_cache(meta)
   , _quota_mgr(quota)
   , _group_router(router)
   , _shard_table(tbl)
   , _partition_manager(pm)
-  , _coordinator_mapper(coordinator_mapper) {}
+  , _coordinator_mapper(coordinator_mapper)
+  , _shard_aware(sa)
+  , _connections_per_client(
+      config::shard_local_cfg().kafka_max_connections_per_client_id())
+  , _api_probes(!sa) {
+    // the metrics of the shard are registered by the protocol of the main
+    // listener
+    if (!_shard_aware) {
+        setup_metrics();
+    }
+}
+
+void protocol::setup_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("kafka"),
+      {sm::make_gauge(
+         "fetch_memory_available_bytes",
+         [] { return fetch_memory().available_bytes(); },
+         sm::description("Memory left for the fetch responses of the shard")),
+       sm::make_derive(
+         "fetch_throttled_bytes",
+         [] { return fetch_memory().throttled_bytes(); },
+         sm::description(
+           "Bytes wanted by fetches beyond what the fetch memory granted")),
+       sm::make_gauge(
+         "control_plane_memory_available_bytes",
+         [this] { return _control_memory.available_units(); },
+         sm::description(
+           "Memory left for the control plane requests of the shard"))});
+}
+
+/// the requests a consumer needs answered within its session timeout to
+/// stay in its group, whatever the load of produce and fetch requests
+static bool is_control_plane(api_key key) {
+    return key == heartbeat_api::key || key == join_group_api::key
+           || key == sync_group_api::key || key == leave_group_api::key
+           || key == find_coordinator_api::key || key == metadata_api::key;
+}
 
 ss::future<> protocol::apply(rpc::server::resources rs) {
     auto ctx = ss::make_lw_shared<protocol::connection_context>(
@@ -79,17 +140,40 @@ ss::future<> protocol::connection_context::process_one_request() {
                       _rs.probe().header_corrupted();
                       return ss::make_ready_future<>();
                   }
+                  if (!admit_client(*h)) {
+                      // dropped with its request, before it takes memory
+                      _rs.conn->shutdown_input();
+                      return ss::make_ready_future<>();
+                  }
                   return dispatch_method_once(std::move(h.value()), s);
               });
       });
 }
 
+bool protocol::connection_context::admit_client(const request_header& hdr) {
+    if (_client_id || !hdr.client_id) {
+        return true;
+    }
+    ss::sstring id(hdr.client_id->data(), hdr.client_id->size());
+    if (!_proto._connections_per_client.try_add(id)) {
+        vlog(
+          klog.debug,
+          "Rejecting connection from {}, too many connections of client id {}",
+          _rs.conn->addr,
+          id);
+        _rs.probe().connection_rejected();
+        return false;
+    }
+    _client_id = std::move(id);
+    return true;
+}
+
 bool protocol::connection_context::is_finished_parsing() const {
     return _rs.conn->input().eof() || _rs.abort_requested();
 }
 
 ss::future<session_resources> protocol::connection_context::throttle_request(
-  std::optional<std::string_view> client_id, size_t request_size) {
+  const request_header& hdr, size_t request_size) {
     // update the throughput tracker for this client using the
     // size of the current request and return any computed delay
     // to apply for quota throttling.
@@ -101,16 +185,32 @@ ss::future<session_resources> protocol::connection_context::throttle_request(
     // distinguish throttling delays from real delays. delays
     // applied to subsequent messages allow backpressure to take
     // affect.
-    auto delay = _proto._quota_mgr.local().record_tp_and_throttle(
-      client_id, request_size);
+    //
+    // the delay is that of the most violated of the quotas of the request.
+    auto& quotas = _proto._quota_mgr.local();
+    auto delay = quotas.record_tp_and_throttle(hdr.client_id, request_size);
+    const bool control_plane = is_control_plane(hdr.key);
+    if (control_plane) {
+        // counted against the quotas, but never delayed by them
+        delay = {.first_violation = true, .duration = {}};
+    }
+    if (hdr.key == produce_api::key) {
+        delay = quota_manager::throttle_delay::longest(
+          delay,
+          quotas.record_produce_tp_and_throttle(hdr.client_id, request_size));
+    } else if (hdr.key == fetch_api::key) {
+        delay = quota_manager::throttle_delay::longest(
+          delay, quotas.throttle_fetch_tp(hdr.client_id));
+    }
 
     auto fut = ss::now();
     if (!delay.first_violation) {
         fut = ss::sleep_abortable(delay.duration, _rs.abort_source());
     }
     return fut
-      .then(
-        [this, request_size] { return reserve_request_units(request_size); })
+      .then([this, request_size, control_plane] {
+          return reserve_request_units(request_size, control_plane);
+      })
       .then([this, delay](ss::semaphore_units<> units) {
           return session_resources{
             .backpressure_delay = delay.duration,
@@ -121,8 +221,12 @@ ss::future<session_resources> protocol::connection_context::throttle_request(
 }
 
 ss::future<ss::semaphore_units<>>
-protocol::connection_context::reserve_request_units(size_t size) {
-    // Allow for extra copies and bookkeeping
+protocol::connection_context::reserve_request_units(
+  size_t size, bool control_plane) {
+    // the peak memory of a request is its buffer, and the copy of its batches
+    // which the partitions of the other shards keep until they are
+    // replicated, plus bookkeeping. requests that turn out to need less give
+    // back the difference once decoded, see request_context::release_memory.
     auto mem_estimate = size * 2 + 8000;
     if (mem_estimate >= (size_t)std::numeric_limits<int32_t>::max()) {
         // TODO: Create error response using the specific API?
@@ -131,6 +235,15 @@ protocol::connection_context::reserve_request_units(size_t size) {
           size,
           mem_estimate));
     }
+    // a request estimated past the memory of the server would wait forever.
+    // it is admitted alone instead, once all the other requests are done.
+    if (control_plane) {
+        // same for the reservation of the control plane
+        return ss::get_units(
+          _proto._control_memory,
+          std::min(mem_estimate, _proto._control_memory_max));
+    }
+    mem_estimate = std::min<size_t>(mem_estimate, _rs.max_memory());
     auto fut = ss::get_units(_rs.memory(), mem_estimate);
     if (_rs.memory().waiters()) {
         _rs.probe().waiting_for_available_memory();
@@ -140,16 +253,22 @@ protocol::connection_context::reserve_request_units(size_t size) {
 
 ss::future<> protocol::connection_context::dispatch_method_once(
   request_header hdr, size_t size) {
-    return throttle_request(hdr.client_id, size)
-      .then([this, hdr = std::move(hdr), size](session_resources sres) mutable {
+    auto probe = _proto._api_probes.get(hdr.key, hdr.version);
+    const auto queued_at = std::chrono::steady_clock::now();
+    return throttle_request(hdr, size)
+      .then([this, hdr = std::move(hdr), size, probe, queued_at](
+              session_resources sres) mutable {
           if (_rs.abort_requested()) {
               // protect against shutdown behavior
               return ss::make_ready_future<>();
           }
+          if (probe) {
+              probe->queued_for(std::chrono::steady_clock::now() - queued_at);
+          }
           auto remaining = size - sizeof(raw_request_header)
                            - hdr.client_id_buffer.size();
           return read_iobuf_exactly(_rs.conn->input(), remaining)
-            .then([this, hdr = std::move(hdr), sres = std::move(sres)](
+            .then([this, hdr = std::move(hdr), sres = std::move(sres), probe](
                     iobuf buf) mutable {
                 if (_rs.abort_requested()) {
                     // _proto._cntrl etc might not be alive
@@ -164,13 +283,25 @@ ss::future<> protocol::connection_context::dispatch_method_once(
                   _proto._group_router.local(),
                   _proto._shard_table.local(),
                   _proto._partition_manager,
-                  _proto._coordinator_mapper);
+                  _proto._coordinator_mapper,
+                  &_fetch_sessions);
+                rctx.hold_memory(std::move(sres.memlocks));
+                if (_proto._shard_aware) {
+                    rctx.set_shard_aware();
+                }
                 // background process this one full request
                 auto self = shared_from_this();
+                auto sg = is_control_plane(rctx.header().key)
+                            ? _proto._control_sg
+                            : ss::current_scheduling_group();
                 (void)ss::with_gate(
                   _rs.conn_gate(),
-                  [this, rctx = std::move(rctx)]() mutable {
-                      return do_process(std::move(rctx));
+                  [this, rctx = std::move(rctx), probe, sg]() mutable {
+                      return ss::with_scheduling_group(
+                        sg,
+                        [this, rctx = std::move(rctx), probe]() mutable {
+                            return do_process(std::move(rctx), probe);
+                        });
                   })
                   .handle_exception([self](std::exception_ptr e) {
                       vlog(
@@ -182,44 +313,114 @@ ss::future<> protocol::connection_context::dispatch_method_once(
       });
 }
 
-ss::future<> protocol::connection_context::do_process(request_context ctx) {
+ss::future<> protocol::connection_context::do_process(
+  request_context ctx, api_probe* probe) {
+    const auto started_at = std::chrono::steady_clock::now();
     const auto correlation = ctx.header().correlation;
     const sequence_id seq = _seq_idx;
     _seq_idx = _seq_idx + sequence_id(1);
+    _rs.probe().requests_in_flight(seq() - _next_response());
+    // fetch responses are accounted against the fetch quota of the client
+    std::optional<std::optional<ss::sstring>> fetch_client;
+    if (
+      ctx.header().key == fetch_api::key
+      && _proto._quota_mgr.local().fetch_quota_enabled()) {
+        const auto& client_id = ctx.header().client_id;
+        fetch_client.emplace(
+          client_id ? std::make_optional<ss::sstring>(*client_id)
+                    : std::nullopt);
+    }
     return kafka::process_request(std::move(ctx), _proto._smp_group)
-      .then([this, seq, correlation](response_ptr r) mutable {
+      .then([this,
+             seq,
+             correlation,
+             fetch_client = std::move(fetch_client),
+             probe,
+             started_at](response_ptr r) mutable {
+          const auto ready_at = std::chrono::steady_clock::now();
+          if (probe) {
+              probe->processed_in(ready_at - started_at);
+          }
+          if (fetch_client) {
+              _proto._quota_mgr.local().record_fetch_tp(
+                *fetch_client, r->buf().size_bytes());
+          }
           r->set_correlation(correlation);
-          _responses.insert({seq, std::move(r)});
+          _responses.insert(
+            {seq,
+             pending_response{
+               .response = std::move(r),
+               .ready_at = ready_at,
+               .probe = probe}});
           return process_next_response();
       });
 }
 
+// bytes of the replies coalesced in a write, past which the write is flushed
+// by the connection anyway
+static constexpr size_t max_coalesced_bytes
+  = rpc::batched_output_stream::default_max_unflushed_bytes;
+// fragments of a scattered message
+static constexpr size_t max_coalesced_chunks
+  = std::numeric_limits<int16_t>::max();
+
 ss::future<> protocol::connection_context::process_next_response() {
     return ss::repeat([this]() mutable {
-        auto it = _responses.find(_next_response);
-        if (it == _responses.end()) {
-            return ss::make_ready_future<ss::stop_iteration>(
-              ss::stop_iteration::yes);
+        // the ready responses that follow the ones already sent are written
+        // together, so that pipelined requests are replied to with a single
+        // flush
+        ss::scattered_message<char> msg;
+        size_t replies = 0;
+        size_t chunks = 0;
+        // the write time of the replies is measured from their ready time
+        using clock = std::chrono::steady_clock;
+        std::vector<std::pair<api_probe*, clock::time_point>> written;
+        const auto now = std::chrono::steady_clock::now();
+        while (msg.size() < max_coalesced_bytes) {
+            auto it = _responses.find(_next_response);
+            if (it == _responses.end()) {
+                break;
+            }
+            auto& r = it->second.response;
+            const auto r_chunks = r->is_noop() ? 0 : response_chunks(*r);
+            if (replies > 0 && chunks + r_chunks > max_coalesced_chunks) {
+                break;
+            }
+            // found one; increment counter
+            _next_response = _next_response + sequence_id(1);
+            _rs.probe().request_completed();
+            _rs.probe().reply_reordered_for(now - it->second.ready_at);
+            auto response = std::move(r);
+            auto probe = it->second.probe;
+            auto ready_at = it->second.ready_at;
+            _responses.erase(it);
+            if (response->is_noop()) {
+                continue;
+            }
+            if (probe) {
+                written.emplace_back(probe, ready_at);
+            }
+            append_response(msg, std::move(response));
+            chunks += r_chunks;
+            ++replies;
         }
-        // found one; increment counter
-        _next_response = _next_response + sequence_id(1);
-
-        auto r = std::move(it->second);
-        _responses.erase(it);
-        _rs.probe().request_completed();
-
-        if (r->is_noop()) {
+        if (replies == 0) {
             return ss::make_ready_future<ss::stop_iteration>(
-              ss::stop_iteration::no);
+              ss::stop_iteration::yes);
         }
 
-        auto msg = response_as_scattered(std::move(r));
+        _rs.probe().replies_coalesced(replies);
         _rs.probe().add_bytes_sent(msg.size());
         try {
-            return _rs.conn->write(std::move(msg)).then([] {
-                return ss::make_ready_future<ss::stop_iteration>(
-                  ss::stop_iteration::no);
-            });
+            return _rs.conn->write(std::move(msg))
+              .then([written = std::move(written)] {
+                  const auto now = std::chrono::steady_clock::now();
+                  for (auto& [probe, ready_at] : written) {
+                      probe->written_in(now - ready_at);
+                  }
+                  return ss::make_ready_future<ss::stop_iteration>(
+                    ss::stop_iteration::no);
+              });
         } catch (...) {
             vlog(
               klog.debug,
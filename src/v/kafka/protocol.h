@@ -14,10 +14,13 @@
 #include "cluster/partition_manager.h"
 #include "cluster/shard_table.h"
 #include "cluster/topics_frontend.h"
+#include "kafka/api_probe.h"
 #include "kafka/groups/group_router.h"
 #include "kafka/quota_manager.h"
+#include "kafka/requests/fetch_session.h"
 #include "kafka/requests/request_context.h"
 #include "kafka/requests/response.h"
+#include "rpc/connection_limits.h"
 #include "rpc/server.h"
 #include "utils/hdr_hist.h"
 
@@ -25,11 +28,14 @@
 #include <seastar/core/lowres_clock.hh>
 #include <seastar/core/metrics_registration.hh>
 #include <seastar/core/scattered_message.hh>
+#include <seastar/core/scheduling.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/core/shared_ptr.hh>
 
 #include <absl/container/flat_hash_map.h>
 
+#include <chrono>
 #include <cstdint>
 #include <optional>
 #include <vector>
@@ -47,21 +53,32 @@ namespace kafka {
 class protocol final : public rpc::server::protocol {
 public:
     using sequence_id = named_type<uint64_t, struct kafka_protocol_sequence>;
+    /// \brief a protocol of the shard aware listener, whose connections are
+    /// served by the core of their source port and whose metadata responses
+    /// tell the cores of the partitions of the broker
+    using shard_aware = ss::bool_class<struct shard_aware_tag>;
+
     struct session_resources {
         ss::lowres_clock::duration backpressure_delay;
         ss::semaphore_units<> memlocks;
         std::unique_ptr<hdr_hist::measurement> method_latency;
     };
 
+    /// \brief the requests of the group coordination of the consumers, and
+    /// the metadata and coordinator lookups they need, are served in
+    /// `control_sg` and from a memory reservation of their own, see
+    /// is_control_plane()
     protocol(
       ss::smp_service_group,
+      ss::scheduling_group control_sg,
       ss::sharded<cluster::metadata_cache>&,
       ss::sharded<cluster::topics_frontend>&,
       ss::sharded<quota_manager>&,
       ss::sharded<kafka::group_router_type>&,
       ss::sharded<cluster::shard_table>&,
       ss::sharded<cluster::partition_manager>&,
-      ss::sharded<coordinator_ntp_mapper>& coordinator_mapper) noexcept;
+      ss::sharded<coordinator_ntp_mapper>& coordinator_mapper,
+      shard_aware = shard_aware::no) noexcept;
 
     ~protocol() noexcept override = default;
     protocol(const protocol&) = delete;
@@ -75,7 +92,13 @@ public:
     ss::future<> apply(rpc::server::resources) final;
 
 private:
-    using map_t = absl::flat_hash_map<sequence_id, response_ptr>;
+    struct pending_response {
+        response_ptr response;
+        std::chrono::steady_clock::time_point ready_at;
+        /// null for the requests of unsupported apis
+        api_probe* probe;
+    };
+    using map_t = absl::flat_hash_map<sequence_id, pending_response>;
 
     class connection_context final
       : public ss::enable_lw_shared_from_this<connection_context> {
@@ -83,7 +106,11 @@ private:
         connection_context(protocol& p, rpc::server::resources&& r) noexcept
           : _proto(p)
           , _rs(std::move(r)) {}
-        ~connection_context() noexcept = default;
+        ~connection_context() noexcept {
+            if (_client_id) {
+                _proto._connections_per_client.remove(*_client_id);
+            }
+        }
         connection_context(const connection_context&) = delete;
         connection_context(connection_context&&) = delete;
         connection_context& operator=(const connection_context&) = delete;
@@ -94,15 +121,19 @@ private:
 
     private:
         /// called by throttle_request
-        ss::future<ss::semaphore_units<>> reserve_request_units(size_t size);
+        ss::future<ss::semaphore_units<>>
+        reserve_request_units(size_t size, bool control_plane);
 
         /// apply correct backpressure sequence
         ss::future<session_resources>
-        throttle_request(std::optional<std::string_view>, size_t sz);
+        throttle_request(const request_header&, size_t sz);
 
         ss::future<> dispatch_method_once(request_header, size_t sz);
+        /// counts the connection against the limit of its client id, once
+        /// its first request tells the id
+        bool admit_client(const request_header&);
         ss::future<> process_next_response();
-        ss::future<> do_process(request_context);
+        ss::future<> do_process(request_context, api_probe*);
 
     private:
         protocol& _proto;
@@ -110,11 +141,21 @@ private:
         sequence_id _next_response;
         sequence_id _seq_idx;
         map_t _responses;
+        fetch_session_cache _fetch_sessions;
+        // set once counted against the connections of the client id
+        std::optional<ss::sstring> _client_id;
     };
     friend connection_context;
 
 private:
+    void setup_metrics();
+
     ss::smp_service_group _smp_group;
+    ss::scheduling_group _control_sg;
+    // memory of the control plane requests of the shard, which do not wait
+    // for the memory of the server held by the data plane ones
+    size_t _control_memory_max;
+    ss::semaphore _control_memory;
 
     // services needed by kafka proto
     ss::sharded<cluster::topics_frontend>& _topics_frontend;
@@ -124,6 +165,10 @@ private:
     ss::sharded<cluster::shard_table>& _shard_table;
     ss::sharded<cluster::partition_manager>& _partition_manager;
     ss::sharded<kafka::coordinator_ntp_mapper>& _coordinator_mapper;
+    shard_aware _shard_aware;
+    rpc::connection_counts<ss::sstring> _connections_per_client;
+    ss::metrics::metric_groups _metrics;
+    api_probes _api_probes;
 };
 
 } // namespace kafka
@@ -14,6 +14,7 @@
 
 #include <seastar/core/temporary_buffer.hh>
 
+#include <iterator>
 #include <stdexcept>
 #include <vector>
 
@@ -89,7 +90,8 @@ ss::future<std::optional<size_t>> parse_size(ss::input_stream<char>& src) {
       });
 }
 
-ss::scattered_message<char> response_as_scattered(response_ptr response) {
+void append_response(
+  ss::scattered_message<char>& msg, response_ptr response) {
     auto correlation = response->correlation();
     auto header = ss::temporary_buffer<char>(sizeof(raw_response_header));
     // NOLINTNEXTLINE
@@ -100,7 +102,6 @@ ss::scattered_message<char> response_as_scattered(response_ptr response) {
     raw_header->correlation = ss::cpu_to_be(correlation());
     auto& buf = response->buf();
     buf.prepend(std::move(header));
-    ss::scattered_message<char> msg;
     auto in = iobuf::iterator_consumer(buf.cbegin(), buf.cend());
     int32_t chunk_no = 0;
     in.consume(
@@ -117,7 +118,11 @@ ss::scattered_message<char> response_as_scattered(response_ptr response) {
       });
     // MUST be the foreign ptr not the iobuf
     msg.on_delete([response = std::move(response)] {});
-    return msg;
+}
+
+size_t response_chunks(const response& r) {
+    // and the chunk of the header
+    return std::distance(r.buf().cbegin(), r.buf().cend()) + 1;
 }
 
 } // namespace kafka
@@ -29,6 +29,10 @@ ss::future<std::optional<request_header>> parse_header(ss::input_stream<char>&);
 size_t parse_size_buffer(ss::temporary_buffer<char>&);
 ss::future<std::optional<size_t>> parse_size(ss::input_stream<char>&);
 
-ss::scattered_message<char> response_as_scattered(response_ptr response);
+/// \brief appends the framed response to the message, which releases it
+void append_response(ss::scattered_message<char>&, response_ptr response);
+
+/// \brief chunks appended to a message by append_response()
+size_t response_chunks(const response&);
 
 } // namespace kafka
@@ -13,19 +13,33 @@
 #include "kafka/logger.h"
 #include "vlog.h"
 
+#include <seastar/core/smp.hh>
+
+#include <algorithm>
+
 namespace kafka {
 using clock = quota_manager::clock;
 using throttle_delay = quota_manager::throttle_delay;
 
-quota_manager::~quota_manager() { _gc_timer.cancel(); }
+quota_manager::~quota_manager() {
+    _gc_timer.cancel();
+    _reconcile_timer.cancel();
+}
 
 ss::future<> quota_manager::stop() {
     _gc_timer.cancel();
-    return ss::make_ready_future<>();
+    _reconcile_timer.cancel();
+    return _gate.close();
 }
 
 ss::future<> quota_manager::start() {
     _gc_timer.arm_periodic(_gc_freq);
+    // reconciliation is driven by core 0
+    if (
+      ss::this_shard_id() == 0 && ss::smp::count > 1
+      && _reconcile_freq > clock::duration::zero()) {
+        _reconcile_timer.arm(_reconcile_freq);
+    }
     return ss::make_ready_future<>();
 }
 
@@ -34,6 +48,38 @@ throttle_delay quota_manager::record_tp_and_throttle(
   std::optional<std::string_view> client_id,
   uint64_t bytes,
   clock::time_point now) {
+    return record_and_throttle(quota_type::total, client_id, bytes, now);
+}
+
+throttle_delay quota_manager::record_produce_tp_and_throttle(
+  std::optional<std::string_view> client_id,
+  uint64_t bytes,
+  clock::time_point now) {
+    return record_and_throttle(quota_type::produce, client_id, bytes, now);
+}
+
+throttle_delay quota_manager::throttle_fetch_tp(
+  std::optional<std::string_view> client_id, clock::time_point now) {
+    return record_and_throttle(quota_type::fetch, client_id, 0, now);
+}
+
+void quota_manager::record_fetch_tp(
+  std::optional<std::string_view> client_id,
+  uint64_t bytes,
+  clock::time_point now) {
+    record_and_throttle(quota_type::fetch, client_id, bytes, now);
+}
+
+throttle_delay quota_manager::record_and_throttle(
+  quota_type type,
+  std::optional<std::string_view> client_id,
+  uint64_t bytes,
+  clock::time_point now) {
+    const auto& target = _targets[size_t(type)];
+    if (!target) {
+        return throttle_delay{.first_violation = true, .duration = {}};
+    }
+
     // requests without a client id are grouped into an anonymous group that
     // shares a default quota. the anonymous group is keyed on empty string.
     auto cid = client_id ? *client_id : "";
@@ -45,27 +91,38 @@ throttle_delay quota_manager::record_tp_and_throttle(
     // equal_to<> overload. this is a general issue we'll be looking at. for
     // now, these client-name strings are small. This will be solved in
     // c++20 via Hash::transparent_key_equal.
-    auto [it, inserted] = _quotas.try_emplace(
-      ss::sstring(cid),
-      quota{
-        now,
-        clock::duration(0),
-        {_default_num_windows, _default_window_width}});
-
-    // bump to prevent gc
-    if (!inserted) {
+    auto it = _quotas.find(ss::sstring(cid));
+    if (it == _quotas.end()) {
+        auto make_rate = [this] {
+            return tracked_rate{
+              .local = rate_tracker(
+                _default_num_windows, _default_window_width),
+            };
+        };
+        it = _quotas
+               .emplace(
+                 ss::sstring(cid),
+                 quota{
+                   .last_seen = now,
+                   .rates = {make_rate(), make_rate(), make_rate()},
+                 })
+               .first;
+    } else {
+        // bump to prevent gc
         it->second.last_seen = now;
     }
+    auto& tracked = it->second.rates[size_t(type)];
 
-    auto rate = it->second.tp_rate.record_and_measure(bytes, now);
+    // the node-wide rate of the client
+    auto rate = tracked.local.record_and_measure(bytes, now) + tracked.others;
 
     uint64_t delay_ms = 0;
-    if (rate > _target_tp_rate) {
-        auto diff = rate - _target_tp_rate;
+    if (rate > *target) {
+        auto diff = rate - *target;
         double delay
-          = (diff / _target_tp_rate)
+          = (diff / *target)
             * (double)std::chrono::duration_cast<std::chrono::milliseconds>(
-                it->second.tp_rate.window_size())
+                tracked.local.window_size())
                 .count();
         delay_ms = static_cast<uint64_t>(delay);
     }
@@ -81,14 +138,91 @@ throttle_delay quota_manager::record_tp_and_throttle(
         delay_ms = _max_delay.count();
     }
 
-    auto prev = it->second.delay;
-    it->second.delay = std::chrono::milliseconds(delay_ms);
+    auto prev = tracked.delay;
+    tracked.delay = std::chrono::milliseconds(delay_ms);
 
     throttle_delay res{};
     res.first_violation = prev.count() == 0;
-    res.duration = it->second.delay;
+    res.duration = tracked.delay;
     return res;
 }
+
+quota_manager::rates_map quota_manager::report_rates(clock::time_point now) {
+    rates_map res;
+    for (auto& [cid, q] : _quotas) {
+        rates r{};
+        bool active = false;
+        for (size_t i = 0; i < num_quota_types; ++i) {
+            auto& tracked = q.rates[i];
+            tracked.reported = _targets[i]
+                                 ? tracked.local.record_and_measure(0, now)
+                                 : 0;
+            r[i] = tracked.reported;
+            active |= r[i] > 0;
+        }
+        if (active) {
+            res.emplace(cid, r);
+        }
+    }
+    return res;
+}
+
+void quota_manager::apply_node_rates(const rates_map& node_rates) {
+    for (auto& [cid, q] : _quotas) {
+        auto it = node_rates.find(cid);
+        for (size_t i = 0; i < num_quota_types; ++i) {
+            auto& tracked = q.rates[i];
+            tracked.others = it == node_rates.end()
+                               ? 0
+                               : std::max(0., it->second[i] - tracked.reported);
+        }
+    }
+}
+
+ss::future<> quota_manager::reconcile() {
+    const auto now = clock::now();
+    return container()
+      .map_reduce0(
+        [now](quota_manager& qm) { return qm.report_rates(now); },
+        rates_map{},
+        [](rates_map acc, rates_map shard_rates) {
+            for (auto& [cid, r] : shard_rates) {
+                auto& total = acc[cid];
+                for (size_t i = 0; i < num_quota_types; ++i) {
+                    total[i] += r[i];
+                }
+            }
+            return acc;
+        })
+      .then([this](rates_map node_rates) {
+          return ss::do_with(
+            std::move(node_rates), [this](const rates_map& node_rates) {
+                // the cores only read the rates, which outlive the calls
+                return container().invoke_on_all(
+                  [&node_rates](quota_manager& qm) {
+                      qm.apply_node_rates(node_rates);
+                  });
+            });
+      });
+}
+
+void quota_manager::reconcile_in_background() {
+    if (_gate.is_closed()) {
+        return;
+    }
+    (void)ss::with_gate(_gate, [this] {
+        return reconcile()
+          .handle_exception([](std::exception_ptr e) {
+              vlog(klog.warn, "Failed to reconcile client quotas: {}", e);
+          })
+          .finally([this] {
+              if (!_gate.is_closed()) {
+                  _reconcile_timer.arm(_reconcile_freq);
+              }
+          });
+    });
+}
+
 // erase inactive tracked quotas. windows are considered inactive if they
 // have not received any updates in ten window's worth of time.
 void quota_manager::gc(clock::duration full_window) {
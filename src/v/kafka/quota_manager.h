@@ -15,12 +15,15 @@
 #include "seastarx.h"
 
 #include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
 #include <seastar/core/lowres_clock.hh>
+#include <seastar/core/sharded.hh>
 #include <seastar/core/sstring.hh>
 #include <seastar/core/timer.hh>
 
 #include <absl/container/flat_hash_map.h>
 
+#include <array>
 #include <chrono>
 #include <optional>
 #include <string_view>
@@ -29,38 +32,64 @@ namespace kafka {
 
 // quota_manager tracks quota usage
 //
-// TODO:
-//   - we will want to eventually add support for configuring the quotas and
-//   quota settings as runtime through the kafka api and other mechanisms.
+// the throughput of each client is tracked by every core the client sends
+// requests to. each core periodically reports the rates of its clients to
+// core 0, which sums them and sends back to each core the rate of each client
+// on the other cores. a client is then throttled on its node-wide rate: its
+// current rate on the core plus its rate on the others at the last
+// reconciliation.
 //
-//   - currently only total throughput per client_id is tracked. in the future
-//   we will want to support additional quotas and accouting granularities to be
-//   at parity with kafka. for example:
+// besides the total throughput of a client, produce requests and fetch
+// responses may have their own quotas.
 //
-//      - splitting out rates separately for produce and fetch
-//      - accounting per user vs per client (these are separate in kafka)
+// TODO:
+//   - we will want to eventually add support for configuring the quotas
+//   through the kafka api. the target rates follow the updates of their
+//   properties already.
 //
-//   - it may eventually be beneficial to periodically reduce stats across
-//   shards or track stats globally to produce a more accurate per-node
-//   representation of a statistic (e.g. bandwidth).
+//   - accounting per user vs per client (these are separate in kafka)
 //
-class quota_manager {
+class quota_manager : public ss::peering_sharded_service<quota_manager> {
 public:
     using clock = ss::lowres_clock;
 
     struct throttle_delay {
         bool first_violation;
         clock::duration duration;
+
+        /// the longest of two delays
+        static throttle_delay longest(throttle_delay a, throttle_delay b) {
+            return a.duration >= b.duration ? a : b;
+        }
     };
 
     quota_manager()
       : _default_num_windows(config::shard_local_cfg().default_num_windows())
       , _default_window_width(config::shard_local_cfg().default_window_sec())
-      , _target_tp_rate(config::shard_local_cfg().target_quota_byte_rate())
+      , _targets{{
+          config::shard_local_cfg().target_quota_byte_rate(),
+          config::shard_local_cfg().target_produce_quota_byte_rate(),
+          config::shard_local_cfg().target_fetch_quota_byte_rate(),
+        }}
       , _gc_freq(config::shard_local_cfg().quota_manager_gc_sec())
+      , _reconcile_freq(config::shard_local_cfg().quota_manager_reconcile_ms())
       , _max_delay(config::shard_local_cfg().max_kafka_throttle_delay_ms()) {
+        auto& cfg = config::shard_local_cfg();
+        _total_target_watcher = cfg.target_quota_byte_rate.watch(
+          [this](uint32_t rate) {
+              _targets[size_t(quota_type::total)] = rate;
+          });
+        _produce_target_watcher = cfg.target_produce_quota_byte_rate.watch(
+          [this](std::optional<uint32_t> rate) {
+              _targets[size_t(quota_type::produce)] = rate;
+          });
+        _fetch_target_watcher = cfg.target_fetch_quota_byte_rate.watch(
+          [this](std::optional<uint32_t> rate) {
+              _targets[size_t(quota_type::fetch)] = rate;
+          });
         auto full_window = _default_num_windows * _default_window_width;
         _gc_timer.set_callback([this, full_window] { gc(full_window); });
+        _reconcile_timer.set_callback([this] { reconcile_in_background(); });
     }
 
     quota_manager(const quota_manager&) = delete;
@@ -80,30 +109,87 @@ public:
       uint64_t bytes,
       clock::time_point now = clock::now());
 
+    // record the size of a produce request against the produce quota
+    throttle_delay record_produce_tp_and_throttle(
+      std::optional<std::string_view> client_id,
+      uint64_t bytes,
+      clock::time_point now = clock::now());
+
+    // fetch responses are accounted once they are built, so a fetch request
+    // is throttled on the responses that preceded it
+    throttle_delay throttle_fetch_tp(
+      std::optional<std::string_view> client_id,
+      clock::time_point now = clock::now());
+    void record_fetch_tp(
+      std::optional<std::string_view> client_id,
+      uint64_t bytes,
+      clock::time_point now = clock::now());
+
+    bool fetch_quota_enabled() const {
+        return _targets[size_t(quota_type::fetch)].has_value();
+    }
+
 private:
+    enum class quota_type : uint8_t { total = 0, produce, fetch };
+    static constexpr size_t num_quota_types = 3;
+
+    // rates of a client per quota type, in bytes per second
+    using rates = std::array<double, num_quota_types>;
+    using rates_map = absl::flat_hash_map<ss::sstring, rates>;
+
     // erase inactive tracked quotas. windows are considered inactive if they
     // have not received any updates in ten window's worth of time.
     void gc(clock::duration full_window);
 
+    throttle_delay record_and_throttle(
+      quota_type,
+      std::optional<std::string_view> client_id,
+      uint64_t bytes,
+      clock::time_point now);
+
+    // rates of the active clients of this core, remembered as reported
+    rates_map report_rates(clock::time_point now);
+    // sets the rates of the clients on the other cores from their node-wide
+    // rates
+    void apply_node_rates(const rates_map&);
+    ss::future<> reconcile();
+    void reconcile_in_background();
+
 private:
-    // last_seen: used for gc keepalive
+    // local: throughput tracking on this core
+    // reported: local rate at the last reconciliation
+    // others: rate on the other cores at the last reconciliation
     // delay: last calculated delay
-    // tp_rate: throughput tracking
+    struct tracked_rate {
+        rate_tracker local;
+        double reported{0};
+        double others{0};
+        clock::duration delay{0};
+    };
+
+    // last_seen: used for gc keepalive
     struct quota {
         clock::time_point last_seen;
-        clock::duration delay;
-        rate_tracker tp_rate;
+        std::array<tracked_rate, num_quota_types> rates;
     };
 
     const std::size_t _default_num_windows;
     const clock::duration _default_window_width;
 
-    const uint32_t _target_tp_rate;
+    // target rate per quota type, none when the type is not enforced
+    std::array<std::optional<uint32_t>, num_quota_types> _targets;
     absl::flat_hash_map<ss::sstring, quota> _quotas;
 
     ss::timer<> _gc_timer;
     const clock::duration _gc_freq;
+    ss::timer<> _reconcile_timer;
+    const clock::duration _reconcile_freq;
     const clock::duration _max_delay;
+    ss::gate _gate;
+    // the target rates follow the updates of their properties
+    config::property<uint32_t>::watcher _total_target_watcher;
+    config::property<std::optional<uint32_t>>::watcher _produce_target_watcher;
+    config::property<std::optional<uint32_t>>::watcher _fetch_target_watcher;
 };
 
 } // namespace kafka
@@ -17,6 +17,7 @@
 #include "kafka/requests/fetch_request.h"
 #include "kafka/requests/find_coordinator_request.h"
 #include "kafka/requests/heartbeat_request.h"
+#include "kafka/requests/init_producer_id_request.h"
 #include "kafka/requests/join_group_request.h"
 #include "kafka/requests/leave_group_request.h"
 #include "kafka/requests/list_groups_request.h"
@@ -63,7 +64,8 @@ using request_types = make_request_types<
   describe_configs_api,
   alter_configs_api,
   delete_topics_api,
-  describe_groups_api>;
+  describe_groups_api,
+  init_producer_id_api>;
 
 template<typename RequestType>
 static auto make_api() {
@@ -55,7 +55,12 @@ struct api_versions_response final {
     api_versions_response_data data;
 
     void encode(const request_context& ctx, response& resp) {
-        data.encode(resp.writer(), ctx.header().version);
+        // a client of a version newer than supported is answered with
+        // version 0, the version it can always read
+        auto version = data.error_code == error_code::unsupported_version
+                         ? api_version(0)
+                         : ctx.header().version;
+        data.encode(resp.writer(), version);
     }
 
     void decode(iobuf buf, api_version version) {
@@ -46,7 +46,8 @@ private:
       partition_count_must_be_positive,
       replication_factor_must_be_positive,
       replication_factor_must_be_odd,
-      unsupported_configuration_entries>;
+      unsupported_configuration_entries,
+      storage_type_must_be_valid>;
 };
 
 struct create_topics_request final {
@@ -0,0 +1,45 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/requests/fetch_memory.h"
+
+#include "resource_mgmt/memory_groups.h"
+
+#include <algorithm>
+
+namespace kafka {
+
+size_t fetch_memory_budget::available_bytes() const {
+    // grants may overdraw the budget
+    return size_t(std::max<ssize_t>(_memory.available_units(), 0));
+}
+
+ss::semaphore_units<> fetch_memory_budget::grant(size_t wanted) {
+    const auto granted = std::min(
+      wanted, std::max(available_bytes(), min_grant));
+    _throttled_bytes += wanted - granted;
+    return ss::consume_units(_memory, granted);
+}
+
+void fetch_memory_budget::resize(ss::semaphore_units<>& units, size_t bytes) {
+    const auto held = units.count();
+    if (bytes < held) {
+        units.return_units(held - bytes);
+    } else if (bytes > held) {
+        units.adopt(ss::consume_units(_memory, bytes - held));
+    }
+}
+
+fetch_memory_budget& fetch_memory() {
+    static thread_local fetch_memory_budget budget(
+      memory_groups::kafka_fetch_memory());
+    return budget;
+}
+
+} // namespace kafka
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+#include "units.h"
+
+#include <seastar/core/semaphore.hh>
+
+#include <cstdint>
+
+namespace kafka {
+
+/**
+ * Memory of the fetch responses of a shard.
+ *
+ * A fetch response is assembled in memory before it is written, so the
+ * max_bytes of the requests do not bound the memory of the responses of many
+ * consumers. A fetch is granted the bytes it may read from the budget of the
+ * shard of its connection, and holds them until its response is written to
+ * the socket. Under pressure the grants shrink instead of failing the fetch,
+ * down to a minimum which lets every consumer make progress.
+ */
+class fetch_memory_budget {
+public:
+    static constexpr size_t min_grant = 1_MiB;
+
+    explicit fetch_memory_budget(size_t max_bytes)
+      : _max_bytes(max_bytes)
+      , _memory(max_bytes) {}
+
+    /// \brief grants up to the wanted bytes, never less than min_grant
+    ss::semaphore_units<> grant(size_t wanted);
+
+    /// \brief resizes the units of a grant to the bytes actually read, which
+    /// may exceed the grant by the first batch of a response
+    void resize(ss::semaphore_units<>&, size_t bytes);
+
+    size_t max_bytes() const { return _max_bytes; }
+    size_t available_bytes() const;
+    /// bytes the fetches wanted beyond their grants
+    uint64_t throttled_bytes() const { return _throttled_bytes; }
+
+private:
+    size_t _max_bytes;
+    ss::semaphore _memory;
+    uint64_t _throttled_bytes{0};
+};
+
+/// \brief the fetch memory budget of this shard
+fetch_memory_budget& fetch_memory();
+
+} // namespace kafka
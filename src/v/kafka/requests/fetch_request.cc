@@ -9,23 +9,32 @@
 
 #include "kafka/requests/fetch_request.h"
 
+#include "cluster/metadata_cache.h"
 #include "cluster/namespace.h"
 #include "cluster/partition.h"
 #include "cluster/partition_manager.h"
+#include "cluster/shard_table.h"
+#include "config/configuration.h"
 #include "kafka/errors.h"
+#include "kafka/load_sketches.h"
 #include "kafka/requests/batch_consumer.h"
+#include "kafka/requests/fetch_session.h"
 #include "likely.h"
 #include "model/fundamental.h"
 #include "model/timeout_clock.h"
+#include "raft/offset_monitor.h"
 #include "resource_mgmt/io_priority.h"
 #include "utils/to_string.h"
 
+#include <seastar/core/abort_source.hh>
 #include <seastar/core/sleep.hh>
+#include <seastar/core/smp.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/util/log.hh>
 
 #include <fmt/ostream.h>
 
+#include <algorithm>
 #include <string_view>
 
 namespace kafka {
@@ -93,12 +102,16 @@ void fetch_request::encode(response_writer& writer, api_version version) {
                 [](int32_t p, response_writer& writer) { writer.write(p); });
           });
     }
+    if (version >= api_version(11)) {
+        writer.write(rack_id);
+    }
 }
 
 void fetch_request::decode(request_context& ctx) {
-    auto& reader = ctx.reader();
-    auto version = ctx.header().version;
+    decode(ctx.reader(), ctx.header().version);
+}
 
+void fetch_request::decode(request_reader& reader, api_version version) {
     replica_id = model::node_id(reader.read_int32());
     max_wait_time = std::chrono::milliseconds(reader.read_int32());
     min_bytes = reader.read_int32();
@@ -139,6 +152,9 @@ void fetch_request::decode(request_context& ctx) {
             };
         });
     }
+    if (version >= api_version(11)) {
+        rack_id = reader.read_string();
+    }
 }
 
 std::ostream& operator<<(std::ostream& o, const fetch_request::partition& p) {
@@ -154,13 +170,14 @@ std::ostream& operator<<(std::ostream& o, const fetch_request& r) {
     return ss::fmt_print(
       o,
       "replica {} max_wait_time {} min_bytes {} max_bytes {} isolation {} "
-      "topics {}",
+      "topics {} rack {}",
       r.replica_id,
       r.max_wait_time,
       r.min_bytes,
       r.max_bytes,
       r.isolation_level,
-      r.topics);
+      r.topics,
+      r.rack_id);
 }
 
 void fetch_response::encode(const request_context& ctx, response& resp) {
@@ -193,7 +210,12 @@ void fetch_response::encode(const request_context& ctx, response& resp) {
                       writer.write(t.producer_id);
                       writer.write(int64_t(t.first_offset));
                   });
-                writer.write(std::move(r.record_set));
+                if (version >= api_version(11)) {
+                    writer.write(r.preferred_read_replica());
+                }
+                // read by another core, the record set references its
+                // buffers, see release_on_home_shard
+                writer.write_fragments(std::move(r.record_set));
             });
       });
 }
@@ -225,6 +247,8 @@ void fetch_response::decode(iobuf buf, api_version version) {
                       .first_offset = model::offset(reader.read_int64()),
                     };
                 }),
+              .preferred_read_replica = model::node_id(
+                version >= api_version(11) ? reader.read_int32() : -1),
               .record_set = reader.read_fragmented_nullable_bytes()};
         });
         return p;
@@ -242,13 +266,13 @@ operator<<(std::ostream& o, const fetch_response::partition_response& p) {
     return ss::fmt_print(
       o,
       "id {} err {} high_water {} last_stable_off {} aborted {} "
-      "record_set_len "
-      "{}",
+      "preferred_replica {} record_set_len {}",
       p.id,
       p.error,
       p.high_watermark,
       p.last_stable_offset,
       p.aborted_transactions,
+      p.preferred_read_replica,
       (p.record_set ? p.record_set->size_bytes() : -1));
 }
 
@@ -285,10 +309,11 @@ make_ready_partition_response_error(error_code error) {
 static ss::future<fetch_response::partition_response> read_from_partition(
   partition_wrapper pw,
   fetch_config config,
-  std::optional<model::timeout_clock::time_point> deadline) {
+  std::optional<model::timeout_clock::time_point> deadline,
+  model::offset max_offset = model::model_limits<model::offset>::max()) {
     storage::log_reader_config reader_config(
       config.start_offset,
-      model::model_limits<model::offset>::max(),
+      max_offset,
       0,
       config.max_bytes,
       kafka_read_priority(),
@@ -297,6 +322,8 @@ static ss::future<fetch_response::partition_response> read_from_partition(
       std::nullopt);
 
     reader_config.strict_max_bytes = config.strict_max_bytes;
+    // consumers read sequentially. read the next fetch into the cache.
+    reader_config.read_ahead_bytes = config.max_bytes;
 
     return pw.make_reader(reader_config, deadline)
       .then([pw, timeout = config.timeout](
@@ -309,6 +336,7 @@ static ss::future<fetch_response::partition_response> read_from_partition(
                  * return path will fill in other response fields.
                  */
                 pw.probe().add_records_fetched(res.record_count);
+                pw.probe().add_bytes_fetched(res.data.size_bytes());
                 return fetch_response::partition_response{
                   .error = error_code::none,
                   .record_set = std::move(res.data),
@@ -324,20 +352,199 @@ static ss::future<fetch_response::partition_response> read_from_partition(
       });
 }
 
+/*
+ * A follower of the leader that is not catching up on its log, and so may
+ * serve the reads of the clients in its rack.
+ */
+static bool
+is_in_sync_replica(const cluster::partition& partition, model::node_id id) {
+    auto followers = partition.follower_states();
+    auto recovering = partition.recovering_followers();
+    auto is = [id](const raft::follower_recovery_state& s) {
+        return s.node == id;
+    };
+    return std::any_of(followers.begin(), followers.end(), is)
+           && std::none_of(recovering.begin(), recovering.end(), is);
+}
+
+/**
+ * A read committed consumer reads up to the last stable offset. The aborted
+ * transactions of the range are looked up in the index of the partition,
+ * for the consumer to skip their batches.
+ */
+static ss::future<fetch_response::partition_response> read_committed(
+  ss::lw_shared_ptr<cluster::partition> partition, fetch_config config) {
+    const auto lso = partition->last_stable_offset();
+    if (config.start_offset >= lso) {
+        return ss::make_ready_future<fetch_response::partition_response>(
+          fetch_response::partition_response{
+            .error = error_code::none,
+            .high_watermark = partition->high_watermark(),
+            .last_stable_offset = lso,
+            .log_start_offset = partition->start_offset(),
+            .record_set = iobuf(),
+          });
+    }
+    const auto last = lso - model::offset(1);
+    return read_from_partition(
+             partition_wrapper(partition), config, std::nullopt, last)
+      .then([partition, lso, last, start = config.start_offset](
+              fetch_response::partition_response&& resp) {
+          resp.last_stable_offset = lso;
+          resp.high_watermark = partition->high_watermark();
+          for (const auto& t : partition->aborted_transactions(start, last)) {
+              resp.aborted_transactions.push_back(
+                fetch_response::aborted_transaction{
+                  .producer_id = t.producer_id,
+                  .first_offset = t.first_offset});
+          }
+          return std::move(resp);
+      });
+}
+
+/**
+ * Read from an ntp on its home core. Error responses are built for missing
+ * partitions, partitions that are not led by this node, and out of range
+ * offsets.
+ *
+ * A leader sends the client to its preferred read replica when that replica
+ * is in sync, and a follower serves the reads of v11+ clients up to its own
+ * high watermark, which trails the one of the leader.
+ */
+static ss::future<fetch_response::partition_response> read_from_local_ntp(
+  cluster::partition_manager& mgr, model::ntp ntp, fetch_config config) {
+    const auto mntpv = model::materialized_ntp(std::move(ntp));
+    /*
+     * lookup the ntp's partition
+     */
+    auto partition = mgr.get(mntpv.source_ntp());
+    if (unlikely(!partition)) {
+        return make_ready_partition_response_error(
+          error_code::unknown_topic_or_partition);
+    }
+    const bool is_leader = partition->is_leader();
+    if (unlikely(!is_leader && !config.read_from_follower)) {
+        return make_ready_partition_response_error(
+          error_code::not_leader_for_partition);
+    }
+    if (
+      is_leader && config.preferred_read_replica
+      && is_in_sync_replica(*partition, *config.preferred_read_replica)) {
+        return ss::make_ready_future<fetch_response::partition_response>(
+          fetch_response::partition_response{
+            .error = error_code::none,
+            .high_watermark = partition->high_watermark(),
+            .last_stable_offset = partition->last_stable_offset(),
+            .log_start_offset = partition->start_offset(),
+            .preferred_read_replica = *config.preferred_read_replica,
+            .record_set = iobuf(),
+          });
+    }
+    if (mntpv.is_materialized()) {
+        if (auto log = mgr.log(mntpv.input_ntp())) {
+            return read_from_partition(
+              partition_wrapper(partition, log), config, std::nullopt);
+        } else {
+            return make_ready_partition_response_error(
+              error_code::unknown_topic_or_partition);
+        }
+    }
+
+    auto high_watermark = partition->high_watermark();
+    auto max_offset = high_watermark < model::offset(0)
+                        ? model::offset(0)
+                        : high_watermark + model::offset(1);
+    if (!is_leader && config.start_offset > max_offset) {
+        // the follower has yet to learn that the offset was committed
+        return ss::make_ready_future<fetch_response::partition_response>(
+          fetch_response::partition_response{
+            .error = error_code::none,
+            .high_watermark = high_watermark,
+            .last_stable_offset = partition->last_stable_offset(),
+            .record_set = iobuf(),
+          });
+    }
+    if (
+      config.start_offset < partition->start_offset()
+      || config.start_offset > max_offset) {
+        return ss::make_ready_future<fetch_response::partition_response>(
+          fetch_response::partition_response{
+            .error = error_code::offset_out_of_range,
+            .high_watermark = model::offset(-1),
+            .last_stable_offset = model::offset(-1),
+            .log_start_offset = model::offset(-1),
+            .record_set = iobuf(),
+          });
+    }
+    if (config.read_committed) {
+        return read_committed(partition, config);
+    }
+    /*
+     * reads never wait for data to arrive. a fetch that needs more data waits
+     * for the high watermark of its partitions to advance between reads (see
+     * wait_for_new_data).
+     */
+    return read_from_partition(
+             partition_wrapper(partition), config, std::nullopt)
+      .then([partition](fetch_response::partition_response&& resp) {
+          resp.last_stable_offset = partition->last_stable_offset();
+          resp.high_watermark = partition->high_watermark();
+          return std::move(resp);
+      });
+}
+
+/*
+ * lookup the home shard for an ntp. the caller should check for the tp in the
+ * metadata cache so that a missing shard is unlikely.
+ */
+static std::optional<ss::shard_id>
+shard_for_ntp(op_context& octx, const model::ntp& ntp) {
+    const auto mntpv = model::materialized_ntp(ntp);
+    return octx.rctx.shards().shard_for(mntpv.source_ntp());
+}
+
+/*
+ * lookup the home shard by the ntp id resolved when the request was decoded.
+ * an id reused by another ntp since then sends the read to the wrong core,
+ * which responds that the partition is unknown as if it had just moved.
+ */
+static std::optional<ss::shard_id>
+shard_for_ntp(op_context& octx, std::optional<model::ntp_id> id) {
+    if (unlikely(!id)) {
+        return std::nullopt;
+    }
+    return octx.rctx.shards().shard_for(*id);
+}
+
+void op_context::resolve_ntp_ids() {
+    auto& registry = model::ntp_registry::local();
+    ntp_ids.clear();
+    for (auto it = request.cbegin(); it != request.cend(); ++it) {
+        const auto mntpv = model::materialized_ntp(model::ntp(
+          cluster::kafka_namespace, it->topic->name, it->partition->id));
+        ntp_ids.push_back(registry.find(mntpv.source_ntp()));
+    }
+}
+
+/*
+ * The record sets read on the home shard of their ntps reference the buffers
+ * of its segments and of its batch cache. Those handed to the shard of the
+ * request are views of them, which go back to the home shard once the
+ * response is written, rather than copies.
+ */
+static void release_on_home_shard(fetch_response::partition_response& r) {
+    if (r.record_set) {
+        r.record_set = iobuf_make_foreign(std::move(*r.record_set));
+    }
+}
+
 /**
  * Entry point for reading from an ntp. This will forward the request to
  * the ntp's home core and build error responses if anything goes wrong.
  */
 ss::future<fetch_response::partition_response>
 read_from_ntp(op_context& octx, model::ntp ntp, fetch_config config) {
-    /*
-     * lookup the home shard for this ntp. the caller should check for
-     * the tp in the metadata cache so that this condition is unlikely
-     * to pass.
-     */
-    const auto mntpv = model::materialized_ntp(std::move(ntp));
-    auto shard = octx.rctx.shards().shard_for(mntpv.source_ntp());
-
+    auto shard = shard_for_ntp(octx, ntp);
     if (unlikely(!shard)) {
         return make_ready_partition_response_error(
           error_code::unknown_topic_or_partition);
@@ -346,181 +553,488 @@ read_from_ntp(op_context& octx, model::ntp ntp, fetch_config config) {
     return octx.rctx.partition_manager().invoke_on(
       *shard,
       octx.ssg,
-      [initial_fetch = octx.initial_fetch,
-       deadline = octx.deadline,
-       mntpv = std::move(mntpv),
-       config](cluster::partition_manager& mgr) {
-          /*
-           * lookup the ntp's partition
-           */
-          auto partition = mgr.get(mntpv.source_ntp());
-          if (unlikely(!partition)) {
-              return make_ready_partition_response_error(
-                error_code::unknown_topic_or_partition);
-          }
-          if (unlikely(!partition->is_leader())) {
-              return make_ready_partition_response_error(
-                error_code::not_leader_for_partition);
-          }
-          if (mntpv.is_materialized()) {
-              if (auto log = mgr.log(mntpv.input_ntp())) {
-                  return read_from_partition(
-                    partition_wrapper(partition, log), config, std::nullopt);
-              } else {
-                  return make_ready_partition_response_error(
-                    error_code::unknown_topic_or_partition);
-              }
-          }
-
-          auto high_watermark = partition->high_watermark();
-          auto max_offset = high_watermark < model::offset(0)
-                              ? model::offset(0)
-                              : high_watermark + model::offset(1);
-          if (
-            config.start_offset < partition->start_offset()
-            || config.start_offset > max_offset) {
-              return ss::make_ready_future<fetch_response::partition_response>(
-                fetch_response::partition_response{
-                  .error = error_code::offset_out_of_range,
-                  .high_watermark = model::offset(-1),
-                  .last_stable_offset = model::offset(-1),
-                  .log_start_offset = model::offset(-1),
-                  .record_set = iobuf(),
-                });
-          }
-          /**
-           * Check if we should wait for more data.
-           *
-           * If request allow waiting for more data we will wait in two
-           * scenarios:
-           *
-           * - previous read didn't meet requested budged
-           * - consumer requested read that is beyond high water mark
-           */
-          bool can_wait = !initial_fetch
-                          || config.start_offset > high_watermark;
-
-          return read_from_partition(
-                   partition_wrapper(partition),
-                   config,
-                   can_wait ? deadline : std::nullopt)
-            .then([partition](fetch_response::partition_response&& resp) {
-                resp.last_stable_offset = partition->last_stable_offset();
-                resp.high_watermark = partition->high_watermark();
-                return std::move(resp);
+      [ntp = std::move(ntp), config, origin = ss::this_shard_id()](
+        cluster::partition_manager& mgr) mutable {
+          return read_from_local_ntp(mgr, std::move(ntp), config)
+            .then([origin](fetch_response::partition_response r) {
+                if (ss::this_shard_id() != origin) {
+                    release_on_home_shard(r);
+                }
+                return r;
             });
       });
 }
 
 /**
- * Top-level handler for fetching from a topic-partition. The result is
- * unwrapped and any errors from the storage sub-system are translated
- * into kafka specific response codes. On failure or success the
- * partition response is finalized and placed into its position in the
- * response message.
+ * Read from a set of ntps owned by the current core. All reads are issued
+ * concurrently and the responses are returned in the order of the requests. A
+ * failed read is reported as an unknown_server_error response for that ntp.
  */
-static ss::future<>
-handle_ntp_fetch(op_context& octx, model::ntp ntp, fetch_config config) {
-    using read_response_type = ss::future<fetch_response::partition_response>;
-    auto p_id = ntp.tp.partition;
-    return read_from_ntp(octx, std::move(ntp), config)
-      .then_wrapped([&octx, p_id](read_response_type&& f) {
-          try {
-              auto response = f.get0();
-              response.id = p_id;
-              octx.add_partition_response(std::move(response));
-          } catch (...) {
-              /*
-               * TODO: this is where we will want to handle any storage
-               * specific errors and translate them into kafka response
-               * error codes.
-               */
-              octx.response_error = true;
-              octx.add_partition_response(make_partition_response_error(
-                error_code::unknown_server_error));
-          }
-      });
+static ss::future<std::vector<fetch_response::partition_response>>
+read_from_local_ntps(
+  cluster::partition_manager& mgr, std::vector<ntp_fetch_config> requests) {
+    std::vector<ss::future<fetch_response::partition_response>> reads;
+    reads.reserve(requests.size());
+    for (auto& req : requests) {
+        auto ntp = req.ntp;
+        reads.push_back(
+          read_from_local_ntp(mgr, std::move(req.ntp), req.config)
+            .handle_exception([ntp = std::move(ntp)](std::exception_ptr e) {
+                vlog(klog.warn, "error reading from {}: {}", ntp, e);
+                return make_partition_response_error(
+                  error_code::unknown_server_error);
+            }));
+    }
+    return ss::when_all_succeed(reads.begin(), reads.end());
 }
 
+/*
+ * The partition reads of a fetch round that are owned by a single shard.
+ * Position i holds the index in request order of the i-th read.
+ */
+struct shard_fetch {
+    std::vector<ntp_fetch_config> requests;
+    std::vector<size_t> positions;
+};
+
 /**
- * Process partition fetch requests.
- *
- * Each request is handled serially in the order they appear in the request.
- * There are a couple reasons why we are not **yet** processing these in
- * parallel. First, Kafka expects to some extent that the order of the
- * partitions in the request is an implicit priority on which partitions to read
- * from. This is closely related to the request budget limits specified in terms
- * of maximum bytes and maximum time delay.
+ * Place the partition responses into the response message in request order.
  *
- * Once we start processing requests in parallel we'll have to work through
- * various challenges. First, once we dispatch in parallel, we'll need to
- * develop heuristics for dealing with the implicit priority order. We'll also
- * need to develop techniques and heuristics for dealing with budgets since
- * global budgets aren't trivially divisible onto each core when partition
- * requests may produce non-uniform amounts of data.
+ * Reads are dispatched concurrently and each one is bounded by the full
+ * response budget rather than by what other partitions left over. The budget
+ * then serves the partitions from octx.budget_start on, wrapping around: a
+ * response that no longer fits in what is left has its data dropped, and the
+ * consumer will fetch it again in a subsequent request. As the start rotates
+ * across fetches, each partition is eventually served first.
+ */
+static void assemble_fetch_response(
+  op_context& octx,
+  std::vector<fetch_response::partition_response>& responses) {
+    const size_t count = responses.size();
+    size_t bytes_left = octx.bytes_left;
+    bool has_data = false;
+    for (size_t i = 0; i < count; ++i) {
+        auto& resp = responses[(octx.budget_start + i) % count];
+        if (!resp.record_set) {
+            continue;
+        }
+        const auto bytes = resp.record_set->size_bytes();
+        if (has_data && bytes > bytes_left) {
+            if (bytes_left == 0) {
+                resp = make_partition_response_error(
+                  error_code::message_too_large);
+            } else {
+                resp.record_set = iobuf();
+            }
+            continue;
+        }
+        has_data = has_data || bytes > 0;
+        bytes_left -= std::min(bytes_left, bytes);
+    }
+
+    auto& sketches = shard_load_sketches();
+    size_t read_bytes = 0;
+    auto resp = responses.begin();
+    for (auto it = octx.request.cbegin(); it != octx.request.cend();
+         ++it, ++resp) {
+        if (it->new_topic) {
+            octx.start_response_topic(*it->topic);
+        }
+        if (resp->error == error_code::unknown_server_error) {
+            octx.response_error = true;
+        }
+        if (resp->preferred_read_replica >= model::node_id(0)) {
+            // answer right away so that the client moves to the replica
+            octx.redirected = true;
+        }
+        resp->id = it->partition->id;
+        if (resp->record_set && !resp->record_set->empty()) {
+            // only the reads which returned data load the partitions
+            const auto bytes = resp->record_set->size_bytes();
+            sketches.record_partition(
+              model::ntp(cluster::kafka_namespace, it->topic->name, resp->id),
+              bytes);
+            read_bytes += bytes;
+        }
+        octx.add_partition_response(std::move(*resp));
+    }
+    sketches.record_client(octx.rctx.header().client_id, read_bytes);
+}
+
+/**
+ * Process partition fetch requests.
  *
- * w.r.t. what is needed to parallelize this, there are no data dependencies
- * between partition requests within the fetch request, and so they can be run
- * fully in parallel. The only dependency that exists is that the response must
- * be reassembled such that the responses appear in these order as the
- * partitions in the request.
+ * Partitions are grouped by their home shard, and each shard receives a
+ * single cross-core request that reads all of its partitions concurrently.
+ * There are no data dependencies between partition requests within the fetch
+ * request. The only dependency is that the response must be reassembled such
+ * that the responses appear in the same order as the partitions in the
+ * request, while the byte budget serves them in a rotating order (see
+ * assemble_fetch_response).
  */
 static ss::future<> fetch_topic_partitions(op_context& octx) {
-    return ss::do_for_each(
-      octx.request.cbegin(),
-      octx.request.cend(),
-      [&octx](const fetch_request::const_iterator::value_type& p) {
-          /*
-           * the next topic-partition to fetch
-           */
-          auto& topic = *p.topic;
-          auto& part = *p.partition;
-
-          if (p.new_topic) {
-              octx.start_response_topic(topic);
-          }
+    octx.reset_response();
 
-          // if over budget create placeholder response
-          if (
-            octx.bytes_left == 0
-            || model::timeout_clock::now()
-                 > octx.deadline.value_or(model::no_timeout)) {
-              octx.add_partition_response(
-                make_partition_response_error(error_code::message_too_large));
-              return ss::make_ready_future<>();
-          }
+    std::vector<fetch_response::partition_response> responses;
+    std::vector<shard_fetch> fetches(ss::smp::count);
+
+    // if over budget create placeholder responses
+    const bool over_budget = octx.bytes_left == 0;
+    const bool read_from_follower = octx.may_read_from_follower();
+    const bool rack_aware = read_from_follower
+                            && !octx.request.rack_id.empty();
+    const model::node_id self(config::shard_local_cfg().node_id());
+
+    auto id = octx.ntp_ids.cbegin();
+    for (auto it = octx.request.cbegin(); it != octx.request.cend(); ++it) {
+        auto& topic = *it->topic;
+        auto& part = *it->partition;
+        const auto ntp_id = *id++;
+
+        if (over_budget) {
+            responses.push_back(
+              make_partition_response_error(error_code::message_too_large));
+            continue;
+        }
+
+        auto shard = shard_for_ntp(octx, ntp_id);
+        if (unlikely(!shard)) {
+            responses.push_back(make_partition_response_error(
+              error_code::unknown_topic_or_partition));
+            continue;
+        }
 
-          auto ntp = model::ntp(cluster::kafka_namespace, topic.name, part.id);
+        auto ntp = model::ntp(cluster::kafka_namespace, topic.name, part.id);
+        std::optional<model::node_id> preferred;
+        if (rack_aware) {
+            preferred = octx.rctx.metadata_cache().get_preferred_read_replica(
+              model::topic_namespace_view(ntp), part.id, octx.request.rack_id);
+            if (preferred == self) {
+                preferred = std::nullopt;
+            }
+        }
 
-          fetch_config config{
+        auto& fetch = fetches[*shard];
+        fetch.positions.push_back(responses.size());
+        fetch.requests.push_back(ntp_fetch_config{
+          .ntp = std::move(ntp),
+          .config = fetch_config{
             .start_offset = part.fetch_offset,
             .max_bytes = std::min(
               octx.bytes_left, size_t(part.partition_max_bytes)),
             .timeout = octx.deadline.value_or(model::no_timeout),
-            .strict_max_bytes = octx.response_size > 0,
+            .preferred_read_replica = preferred,
+            .read_from_follower = read_from_follower,
+            .read_committed = octx.request.isolation_level == 1,
+          },
+        });
+        // placeholder filled in once the shard responds
+        responses.emplace_back();
+    }
+
+    return ss::do_with(
+      std::move(responses),
+      std::move(fetches),
+      [&octx](
+        std::vector<fetch_response::partition_response>& responses,
+        std::vector<shard_fetch>& fetches) {
+          std::vector<ss::future<>> reads;
+          for (ss::shard_id shard = 0; shard < fetches.size(); ++shard) {
+              auto& fetch = fetches[shard];
+              if (fetch.requests.empty()) {
+                  continue;
+              }
+              reads.push_back(
+                octx.rctx.partition_manager()
+                  .invoke_on(
+                    shard,
+                    octx.ssg,
+                    [requests = std::move(fetch.requests),
+                     origin = ss::this_shard_id()](
+                      cluster::partition_manager& mgr) mutable {
+                        return read_from_local_ntps(mgr, std::move(requests))
+                          .then(
+                            [origin](std::vector<
+                                     fetch_response::partition_response> rs) {
+                                if (ss::this_shard_id() != origin) {
+                                    for (auto& r : rs) {
+                                        release_on_home_shard(r);
+                                    }
+                                }
+                                return rs;
+                            });
+                    })
+                  .then_wrapped(
+                    [&responses, &fetch](
+                      ss::future<
+                        std::vector<fetch_response::partition_response>> f) {
+                        try {
+                            auto results = f.get0();
+                            for (size_t i = 0; i < results.size(); ++i) {
+                                responses[fetch.positions[i]] = std::move(
+                                  results[i]);
+                            }
+                        } catch (...) {
+                            for (auto pos : fetch.positions) {
+                                responses[pos] = make_partition_response_error(
+                                  error_code::unknown_server_error);
+                            }
+                        }
+                    }));
+          }
+          return ss::when_all_succeed(reads.begin(), reads.end())
+            .then([&octx, &responses] {
+                assemble_fetch_response(octx, responses);
+                // a parked fetch holds the memory of what it read only
+                fetch_memory().resize(octx.memory, octx.response_size);
+            });
+      });
+}
+
+/*
+ * A partition of a parked fetch. The fetch is woken once the high watermark of
+ * the partition reaches the given offset.
+ */
+struct ntp_wait {
+    model::ntp ntp;
+    model::offset offset;
+    bool read_from_follower;
+};
+
+/**
+ * Wait for any of a set of ntps owned by the current core to receive new data.
+ * The first partition to advance requests an abort on the shard's abort
+ * source, which releases the waits on the other partitions. Returns true if
+ * the wait ended before the deadline.
+ */
+static ss::future<bool> wait_for_local_ntps(
+  cluster::partition_manager& mgr,
+  std::vector<ntp_wait> waits,
+  model::timeout_clock::time_point deadline,
+  ss::abort_source& as) {
+    auto wake = [&as] {
+        if (!as.abort_requested()) {
+            as.request_abort();
+        }
+    };
+    std::vector<ss::future<>> fs;
+    fs.reserve(waits.size());
+    for (auto& w : waits) {
+        const auto mntpv = model::materialized_ntp(std::move(w.ntp));
+        auto partition = mgr.get(mntpv.source_ntp());
+        if (
+          !partition
+          || (!partition->is_leader() && !w.read_from_follower)) {
+            // the partition moved since it was read. read it again so that
+            // the change is reported to the client.
+            wake();
+            continue;
+        }
+        fs.push_back(
+          partition->wait_for_high_watermark(w.offset, deadline, as)
+            .then(wake)
+            .handle_exception_type(
+              [](const raft::offset_monitor::wait_aborted&) {})
+            .finally([partition] {}));
+    }
+    return ss::when_all_succeed(fs.begin(), fs.end()).then([&as] {
+        return as.abort_requested();
+    });
+}
+
+/**
+ * Park a fetch that has not yet gathered min_bytes until one of its partitions
+ * receives new data, or until the fetch deadline.
+ *
+ * Each partition is woken when its high watermark moves past both the offset
+ * the client fetches from and the high watermark returned by the previous
+ * read. Partitions are grouped by their home shard and each shard parks a
+ * single wait. When a shard wakes up, the waits parked on the other shards are
+ * released through their abort source, so that no waiter outlives the fetch.
+ * Returns true if new data may be available.
+ */
+static ss::future<bool> wait_for_new_data(op_context& octx) {
+    if (!octx.deadline) {
+        return ss::make_ready_future<bool>(false);
+    }
+    std::vector<std::vector<ntp_wait>> waits(ss::smp::count);
+    bool any_waits = false;
+
+    // partition responses are in request order
+    auto topic = octx.response.partitions.begin();
+    auto resp = topic->responses.begin();
+    auto id = octx.ntp_ids.cbegin();
+    for (auto it = octx.request.cbegin(); it != octx.request.cend(); ++it) {
+        while (resp == topic->responses.end()) {
+            ++topic;
+            resp = topic->responses.begin();
+        }
+        const auto& r = *resp++;
+        const auto ntp_id = *id++;
+        if (r.error != error_code::none) {
+            // errors are not resolved by waiting for data
+            continue;
+        }
+        auto shard = shard_for_ntp(octx, ntp_id);
+        if (unlikely(!shard)) {
+            continue;
+        }
+        auto ntp = model::ntp(
+          cluster::kafka_namespace, it->topic->name, it->partition->id);
+        waits[*shard].push_back(ntp_wait{
+          .ntp = std::move(ntp),
+          .offset = std::max(
+            it->partition->fetch_offset, r.high_watermark + model::offset(1)),
+          .read_from_follower = octx.may_read_from_follower(),
+        });
+        any_waits = true;
+    }
+    if (!any_waits) {
+        return ss::make_ready_future<bool>(false);
+    }
+
+    return ss::do_with(
+      std::move(waits),
+      std::vector<ss::abort_source>(ss::smp::count),
+      false,
+      [&octx](
+        std::vector<std::vector<ntp_wait>>& waits,
+        std::vector<ss::abort_source>& aborts,
+        bool& woken) {
+          // release the waits parked on all shards. every abort source is
+          // only ever used on the shard it was handed to.
+          auto release = [&octx, &waits, &aborts] {
+              std::vector<ss::future<>> fs;
+              for (ss::shard_id shard = 0; shard < waits.size(); ++shard) {
+                  if (waits[shard].empty()) {
+                      continue;
+                  }
+                  fs.push_back(ss::smp::submit_to(
+                    shard, octx.ssg, [&as = aborts[shard]] {
+                        if (!as.abort_requested()) {
+                            as.request_abort();
+                        }
+                    }));
+              }
+              return ss::when_all_succeed(fs.begin(), fs.end());
           };
 
-          return handle_ntp_fetch(octx, std::move(ntp), config);
+          std::vector<ss::future<>> fs;
+          for (ss::shard_id shard = 0; shard < waits.size(); ++shard) {
+              if (waits[shard].empty()) {
+                  continue;
+              }
+              fs.push_back(
+                octx.rctx.partition_manager()
+                  .invoke_on(
+                    shard,
+                    octx.ssg,
+                    [w = waits[shard],
+                     deadline = *octx.deadline,
+                     &as = aborts[shard]](
+                      cluster::partition_manager& mgr) mutable {
+                        return wait_for_local_ntps(
+                          mgr, std::move(w), deadline, as);
+                    })
+                  .handle_exception([](std::exception_ptr e) {
+                      // read again to report the error
+                      vlog(klog.warn, "error waiting for fetch data: {}", e);
+                      return true;
+                  })
+                  .then([&woken, release](bool shard_woken) {
+                      if (!shard_woken || woken) {
+                          return ss::now();
+                      }
+                      woken = true;
+                      return release();
+                  }));
+          }
+          return ss::when_all_succeed(fs.begin(), fs.end()).then([&woken] {
+              return woken;
+          });
       });
 }
 
+/*
+ * Resolve the fetch session of the request. For an incremental fetch the
+ * request only carries the partitions that changed, so it is expanded to the
+ * full set of partitions tracked by the session.
+ */
+static fetch_session_cache::context maybe_get_session(op_context& octx) {
+    auto* sessions = octx.rctx.fetch_sessions();
+    if (octx.rctx.header().version < api_version(7) || !sessions) {
+        return fetch_session_cache::context{};
+    }
+    auto sctx = sessions->maybe_get_session(octx.request);
+    if (sctx.incremental) {
+        octx.request.topics = sctx.session->topics();
+        octx.request.forgotten_topics.clear();
+    }
+    return sctx;
+}
+
+/*
+ * A session orders its partitions so that those last served come last, see
+ * fetch_session::update_response. Outside of a session, the partition served
+ * first rotates across the fetches of the connection.
+ */
+static void set_budget_start(op_context& octx, bool in_session) {
+    auto* sessions = octx.rctx.fetch_sessions();
+    if (in_session || !sessions) {
+        return;
+    }
+    size_t partitions = 0;
+    for (const auto& t : octx.request.topics) {
+        partitions += t.partitions.size();
+    }
+    octx.budget_start = sessions->next_sessionless_start(partitions);
+}
+
 ss::future<response_ptr>
 fetch_api::process(request_context&& rctx, ss::smp_service_group ssg) {
-    return ss::do_with(op_context(std::move(rctx), ssg), [](op_context& octx) {
-        // top-level error is used for session-level errors, but we do not yet
-        // implement session management.
-        octx.response.error = error_code::none;
-        // first fetch, do not wait
-        return fetch_topic_partitions(octx)
-          .then([&octx] {
-              octx.initial_fetch = false;
-              return ss::do_until(
-                [&octx] { return octx.should_stop_fetch(); },
-                [&octx] { return fetch_topic_partitions(octx); });
-          })
-          .then(
-            [&octx] { return octx.rctx.respond(std::move(octx.response)); });
-    });
+    return ss::do_with(
+      op_context(std::move(rctx), ssg),
+      fetch_session_cache::context{},
+      [](op_context& octx, fetch_session_cache::context& sctx) {
+          sctx = maybe_get_session(octx);
+          // top-level error is used for session-level errors
+          octx.response.error = sctx.error;
+          octx.response.session_id = sctx.session
+                                       ? sctx.session->id()()
+                                       : invalid_fetch_session_id();
+          if (sctx.error != error_code::none) {
+              return octx.rctx.respond(std::move(octx.response));
+          }
+          set_budget_start(octx, bool(sctx.session));
+          octx.resolve_ntp_ids();
+          // first fetch, do not wait
+          return fetch_topic_partitions(octx)
+            .then([&octx] {
+                return ss::do_until(
+                  [&octx] { return octx.should_stop_fetch(); },
+                  [&octx] {
+                      return wait_for_new_data(octx).then([&octx](bool woken) {
+                          if (!woken) {
+                              // keep the response of the last read
+                              octx.wait_expired = true;
+                              return ss::now();
+                          }
+                          return fetch_topic_partitions(octx);
+                      });
+                  });
+            })
+            .then([&octx, &sctx] {
+                if (sctx.session) {
+                    sctx.session->update_response(
+                      octx.response, sctx.incremental);
+                }
+                return octx.rctx.respond(std::move(octx.response))
+                  .then([&octx](response_ptr r) {
+                      r->hold_memory(std::move(octx.memory));
+                      return r;
+                  });
+            });
+      });
 }
 
 } // namespace kafka
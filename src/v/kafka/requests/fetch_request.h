@@ -11,10 +11,12 @@
 
 #pragma once
 
+#include "kafka/requests/fetch_memory.h"
 #include "kafka/requests/request_context.h"
 #include "kafka/requests/response.h"
 #include "likely.h"
 #include "model/metadata.h"
+#include "model/ntp_registry.h"
 #include "model/timeout_clock.h"
 #include "seastarx.h"
 
@@ -30,7 +32,7 @@ struct fetch_api final {
     static constexpr const char* name = "fetch";
     static constexpr api_key key = api_key(1);
     static constexpr api_version min_supported = api_version(4);
-    static constexpr api_version max_supported = api_version(10);
+    static constexpr api_version max_supported = api_version(11);
 
     static ss::future<response_ptr>
     process(request_context&&, ss::smp_service_group);
@@ -62,14 +64,16 @@ struct fetch_request final {
     std::chrono::milliseconds max_wait_time;
     int32_t min_bytes;
     int32_t max_bytes;      // >= v3
-    int8_t isolation_level; // >= v4
+    int8_t isolation_level{0}; // >= v4
     int32_t session_id;     // >= v7
     int32_t session_epoch;  // >= v7
     std::vector<topic> topics;
     std::vector<forgotten_topic> forgotten_topics; // >= v7
+    ss::sstring rack_id;                           // >= v11
 
     void encode(response_writer& writer, api_version version);
     void decode(request_context& ctx);
+    void decode(request_reader& reader, api_version version);
 
     /*
      * For max_wait_time > 0 the request may be debounced in order to collect
@@ -196,6 +200,7 @@ struct fetch_response final {
         model::offset last_stable_offset;                      // >= v4
         model::offset log_start_offset;                        // >= v5
         std::vector<aborted_transaction> aborted_transactions; // >= v4
+        model::node_id preferred_read_replica{-1};             // >= v11
         std::optional<iobuf> record_set;
     };
 
@@ -232,7 +237,10 @@ struct op_context {
     fetch_response response;
 
     // operation budgets
+    size_t max_response_bytes;
     size_t bytes_left;
+    // the memory of the response on this shard, held until it is written
+    ss::semaphore_units<> memory;
     std::optional<model::timeout_clock::time_point> deadline;
 
     // size of response
@@ -240,7 +248,16 @@ struct op_context {
     // does the response contain an error
     bool response_error;
 
-    bool initial_fetch = true;
+    // the ntp ids of this core of the partitions, in request order
+    std::vector<std::optional<model::ntp_id>> ntp_ids;
+    // the partition, in request order, that the byte budget serves first.
+    // the partitions after it follow, and then those before it
+    size_t budget_start{0};
+
+    // a parked fetch reached its deadline without new data
+    bool wait_expired{false};
+    // the client is sent to another replica for some of the partitions
+    bool redirected{false};
     // decode request and initialize budgets
     op_context(request_context&& ctx, ss::smp_service_group ssg)
       : rctx(std::move(ctx))
@@ -265,7 +282,23 @@ struct op_context {
          * kafka server itself.
          */
         static constexpr size_t MAX_SIZE = 128 << 20;
-        bytes_left = std::min(MAX_SIZE, size_t(request.max_bytes));
+        max_response_bytes = std::min(MAX_SIZE, size_t(request.max_bytes));
+        bytes_left = max_response_bytes;
+    }
+
+    // resolve the ntp ids of the partitions of the final request, once for
+    // all the rounds of reads
+    void resolve_ntp_ids();
+
+    // clear the response and restore budgets before a new round of reads
+    void reset_response() {
+        response.partitions.clear();
+        response_size = 0;
+        redirected = false;
+        // a shard short of memory grants the round less than it wants
+        memory.return_all();
+        memory = fetch_memory().grant(max_response_bytes);
+        bytes_left = memory.count();
     }
 
     // insert and reserve space for a new topic in the response
@@ -286,7 +319,17 @@ struct op_context {
     bool should_stop_fetch() const {
         return !request.debounce_delay()
                || static_cast<int32_t>(response_size) >= request.min_bytes
-               || request.topics.empty() || response_error;
+               || request.topics.empty() || response_error || wait_expired
+               || redirected;
+    }
+
+    /*
+     * Consumers of v11+ may fetch from the followers (KIP-392). The replicas
+     * of the cluster always fetch from the leader.
+     */
+    bool may_read_from_follower() const {
+        return rctx.header().version >= api_version(11)
+               && request.replica_id < model::node_id(0);
     }
 };
 
@@ -295,6 +338,23 @@ struct fetch_config {
     size_t max_bytes;
     model::timeout_clock::time_point timeout;
     bool strict_max_bytes{false};
+    // the replica in the rack of the client, which the leader sends the
+    // client to rather than serving the read
+    std::optional<model::node_id> preferred_read_replica;
+    // whether a follower may serve the read up to its high watermark
+    bool read_from_follower{false};
+    // read committed consumers read up to the last stable offset, and get
+    // the aborted transactions of the range read
+    bool read_committed{false};
+};
+
+/*
+ * A single partition read. Reads that are owned by the same shard are grouped
+ * together so that each fetch round costs one cross-core hop per shard.
+ */
+struct ntp_fetch_config {
+    model::ntp ntp;
+    fetch_config config;
 };
 
 ss::future<fetch_response::partition_response>
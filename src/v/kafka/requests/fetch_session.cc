@@ -0,0 +1,193 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/requests/fetch_session.h"
+
+#include "kafka/logger.h"
+#include "vlog.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace kafka {
+
+void fetch_session::advance_epoch() {
+    _last_used = ss::lowres_clock::now();
+    if (_epoch() == std::numeric_limits<fetch_session_epoch::type>::max()) {
+        // epoch wraps around to 1, 0 and -1 have a special meaning
+        _epoch = fetch_session_epoch(1);
+    } else {
+        ++_epoch;
+    }
+}
+
+void fetch_session::update(const fetch_request& request) {
+    for (auto it = request.cbegin(); it != request.cend(); ++it) {
+        model::topic_partition tp(it->topic->name, it->partition->id);
+        if (auto p = _index.find(tp); p != _index.end()) {
+            p->second->max_bytes = it->partition->partition_max_bytes;
+            p->second->fetch_offset = it->partition->fetch_offset;
+            continue;
+        }
+        auto p = _partitions.insert(
+          _partitions.end(),
+          fetch_session_partition{
+            .tp = tp,
+            .max_bytes = it->partition->partition_max_bytes,
+            .fetch_offset = it->partition->fetch_offset,
+          });
+        _index.emplace(std::move(tp), p);
+    }
+
+    for (const auto& topic : request.forgotten_topics) {
+        for (auto id : topic.partitions) {
+            model::topic_partition tp(topic.name, model::partition_id(id));
+            if (auto p = _index.find(tp); p != _index.end()) {
+                _partitions.erase(p->second);
+                _index.erase(p);
+            }
+        }
+    }
+}
+
+std::vector<fetch_request::topic> fetch_session::topics() const {
+    std::vector<fetch_request::topic> topics;
+    for (const auto& p : _partitions) {
+        // consecutive partitions of the same topic share a topic entry
+        if (topics.empty() || topics.back().name != p.tp.topic) {
+            topics.push_back(fetch_request::topic{.name = p.tp.topic});
+        }
+        topics.back().partitions.push_back(fetch_request::partition{
+          .id = p.tp.partition,
+          .fetch_offset = p.fetch_offset,
+          .partition_max_bytes = p.max_bytes,
+        });
+    }
+    return topics;
+}
+
+/*
+ * Record the state returned to the client for a partition and report whether
+ * it differs from what was previously returned.
+ */
+static bool update_partition(
+  fetch_session_partition& p, const fetch_response::partition_response& resp) {
+    bool changed = false;
+    if (resp.record_set && !resp.record_set->empty()) {
+        changed = true;
+    }
+    if (resp.error != error_code::none) {
+        changed = true;
+    }
+    if (resp.high_watermark != p.high_watermark) {
+        p.high_watermark = resp.high_watermark;
+        changed = true;
+    }
+    if (resp.last_stable_offset != p.last_stable_offset) {
+        p.last_stable_offset = resp.last_stable_offset;
+        changed = true;
+    }
+    return changed;
+}
+
+void fetch_session::update_response(
+  fetch_response& response, bool incremental) {
+    for (auto& topic : response.partitions) {
+        auto& responses = topic.responses;
+        auto end = std::remove_if(
+          responses.begin(),
+          responses.end(),
+          [this, incremental, &topic](
+            const fetch_response::partition_response& resp) {
+              auto it = _index.find(
+                model::topic_partition(topic.name, resp.id));
+              if (it == _index.end()) {
+                  return false;
+              }
+              if (resp.record_set && !resp.record_set->empty()) {
+                  _partitions.splice(
+                    _partitions.end(), _partitions, it->second);
+              }
+              return !update_partition(*it->second, resp) && incremental;
+          });
+        responses.erase(end, responses.end());
+    }
+    auto& topics = response.partitions;
+    topics.erase(
+      std::remove_if(
+        topics.begin(),
+        topics.end(),
+        [](const fetch_response::partition& p) { return p.responses.empty(); }),
+      topics.end());
+}
+
+ss::lw_shared_ptr<fetch_session> fetch_session_cache::create_session() {
+    if (_sessions.size() >= max_sessions) {
+        auto lru = std::min_element(
+          _sessions.begin(), _sessions.end(), [](const auto& a, const auto& b) {
+              return a.second->last_used() < b.second->last_used();
+          });
+        vlog(klog.debug, "evicting fetch session {}", lru->first);
+        _sessions.erase(lru);
+    }
+
+    auto id = _next_id;
+    if (_next_id() == std::numeric_limits<fetch_session_id::type>::max()) {
+        _next_id = fetch_session_id(1);
+    } else {
+        ++_next_id;
+    }
+
+    auto session = ss::make_lw_shared<fetch_session>(id);
+    _sessions.insert_or_assign(id, session);
+    return session;
+}
+
+size_t fetch_session_cache::next_sessionless_start(size_t partitions) {
+    if (partitions == 0) {
+        return 0;
+    }
+    return _sessionless_fetches++ % partitions;
+}
+
+fetch_session_cache::context
+fetch_session_cache::maybe_get_session(const fetch_request& request) {
+    fetch_session_id id(request.session_id);
+    fetch_session_epoch epoch(request.session_epoch);
+
+    if (
+      epoch == final_fetch_session_epoch
+      || epoch == initial_fetch_session_epoch) {
+        // closing or re-creating a session discards the previous one
+        if (id != invalid_fetch_session_id) {
+            _sessions.erase(id);
+        }
+        if (epoch == final_fetch_session_epoch) {
+            return context{};
+        }
+        auto session = create_session();
+        session->update(request);
+        session->advance_epoch();
+        return context{.session = std::move(session)};
+    }
+
+    auto it = _sessions.find(id);
+    if (it == _sessions.end()) {
+        return context{.error = error_code::fetch_session_id_not_found};
+    }
+    auto session = it->second;
+    if (session->epoch() != epoch) {
+        return context{.error = error_code::invalid_fetch_session_epoch};
+    }
+    session->update(request);
+    session->advance_epoch();
+    return context{.session = std::move(session), .incremental = true};
+}
+
+} // namespace kafka
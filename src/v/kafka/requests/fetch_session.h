@@ -0,0 +1,155 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "kafka/errors.h"
+#include "kafka/requests/fetch_request.h"
+#include "kafka/types.h"
+#include "model/fundamental.h"
+#include "seastarx.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/shared_ptr.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <list>
+#include <vector>
+
+namespace kafka {
+
+/// Session id of fetch requests that are not part of a session.
+static inline const fetch_session_id invalid_fetch_session_id(0);
+
+/// Epoch used to request the creation of a new session.
+static inline const fetch_session_epoch initial_fetch_session_epoch(0);
+
+/// Epoch used to close a session, or to fetch without a session.
+static inline const fetch_session_epoch final_fetch_session_epoch(-1);
+
+/*
+ * Per-partition state cached by a fetch session. The fetch offset and max
+ * bytes are those most recently sent by the client. The offsets are the ones
+ * most recently returned to the client, and are used to decide if a partition
+ * has changed and must be included in an incremental fetch response.
+ */
+struct fetch_session_partition {
+    model::topic_partition tp;
+    int32_t max_bytes;
+    model::offset fetch_offset;
+    model::offset high_watermark{-1};
+    model::offset last_stable_offset{-1};
+};
+
+/*
+ * Incremental fetch session (KIP-227).
+ *
+ * A session remembers the set of partitions a client fetches from. Once it
+ * has been established by a full fetch, incremental fetch requests only carry
+ * partitions that were added or changed, along with those that should be
+ * removed. Similarly, incremental responses only carry partitions that have
+ * new data, or whose error or offsets changed since the previous response.
+ */
+class fetch_session {
+public:
+    explicit fetch_session(fetch_session_id id) noexcept
+      : _id(id)
+      , _last_used(ss::lowres_clock::now()) {}
+
+    fetch_session_id id() const { return _id; }
+
+    /// epoch expected in the next request for this session
+    fetch_session_epoch epoch() const { return _epoch; }
+
+    ss::lowres_clock::time_point last_used() const { return _last_used; }
+
+    size_t size() const { return _partitions.size(); }
+
+    /// advance the expected epoch once a request has been accepted
+    void advance_epoch();
+
+    /// apply the partitions added, updated and forgotten by a request
+    void update(const fetch_request&);
+
+    /// all partitions in the session in the order they were added
+    std::vector<fetch_request::topic> topics() const;
+
+    /*
+     * Record the state returned to the client in a full response. For an
+     * incremental response, partitions that did not change since the previous
+     * response are removed from the response.
+     *
+     * The partitions that returned data move to the end of the session, as
+     * in Kafka: the byte budget of a fetch serves the partitions in the order
+     * of the session, so that the others are served first next time.
+     */
+    void update_response(fetch_response&, bool incremental);
+
+private:
+    using partitions_t = std::list<fetch_session_partition>;
+
+    fetch_session_id _id;
+    fetch_session_epoch _epoch{0};
+    ss::lowres_clock::time_point _last_used;
+    partitions_t _partitions;
+    absl::flat_hash_map<model::topic_partition, partitions_t::iterator> _index;
+};
+
+/*
+ * Fetch sessions created on a single client connection.
+ *
+ * Sessions are bound to the connection that created them and are released
+ * when the connection closes. The number of sessions per connection is
+ * bounded: when the limit is reached, the least recently used session is
+ * evicted to make room for the new one.
+ */
+class fetch_session_cache {
+public:
+    static constexpr size_t max_sessions = 8;
+
+    /*
+     * Result of resolving the session of a fetch request. When a session is
+     * present the request is part of a session, and the response is
+     * incremental unless the session has just been created.
+     */
+    struct context {
+        ss::lw_shared_ptr<fetch_session> session;
+        bool incremental{false};
+        error_code error{error_code::none};
+    };
+
+    /*
+     * Resolve the session of a fetch request, creating, closing, and
+     * updating sessions as requested by the session id and epoch.
+     */
+    context maybe_get_session(const fetch_request&);
+
+    size_t size() const { return _sessions.size(); }
+
+    /*
+     * The partition, in request order, that the byte budget serves first in
+     * a fetch outside of a session. It rotates across the fetches of the
+     * connection, so that clients sending the partitions in the same order
+     * do not starve the last ones.
+     */
+    size_t next_sessionless_start(size_t partitions);
+
+private:
+    ss::lw_shared_ptr<fetch_session> create_session();
+
+    fetch_session_id _next_id{1};
+    size_t _sessionless_fetches{0};
+    absl::flat_hash_map<fetch_session_id, ss::lw_shared_ptr<fetch_session>>
+      _sessions;
+};
+
+} // namespace kafka
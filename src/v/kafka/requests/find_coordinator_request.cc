@@ -117,7 +117,8 @@ ss::future<response_ptr> find_coordinator_api::process(
           cluster::topic_configuration topic{
             ctx.coordinator_mapper().local().ns(),
             ctx.coordinator_mapper().local().topic(),
-            config::shard_local_cfg().group_topic_partitions(),
+            coordinator_ntp_mapper::topic_partitions(
+              config::shard_local_cfg().group_topic_partitions()),
             config::shard_local_cfg().default_topic_replication()};
 
           topic.cleanup_policy_bitflags
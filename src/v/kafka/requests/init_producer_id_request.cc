@@ -0,0 +1,59 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/requests/init_producer_id_request.h"
+
+#include "cluster/partition_manager.h"
+#include "config/configuration.h"
+#include "kafka/errors.h"
+#include "kafka/logger.h"
+#include "kafka/requests/request_context.h"
+#include "model/metadata.h"
+#include "vlog.h"
+
+namespace kafka {
+
+ss::future<response_ptr> init_producer_id_api::process(
+  request_context&& ctx, [[maybe_unused]] ss::smp_service_group g) {
+    init_producer_id_request request;
+    request.decode(ctx.reader(), ctx.header().version);
+    vlog(klog.trace, "Handling request {}", request);
+
+    return ss::do_with(
+      std::move(ctx), [request](request_context& ctx) mutable {
+          // transactions are not supported, only idempotent producers
+          if (request.data.transactional_id) {
+              init_producer_id_response reply;
+              reply.data.error_code
+                = error_code::transactional_id_authorization_failed;
+              return ctx.respond(std::move(reply));
+          }
+          // a new producer starts at epoch 0 of a new id
+          return ctx.partition_manager()
+            .local()
+            .producer_ids()
+            .allocate(model::node_id(config::shard_local_cfg().node_id()))
+            .then_wrapped([&ctx](ss::future<int64_t> f) {
+                init_producer_id_response reply;
+                try {
+                    reply.data.producer_id = producer_id(f.get0());
+                    reply.data.producer_epoch = 0;
+                } catch (...) {
+                    vlog(
+                      klog.warn,
+                      "Unable to allocate a producer id: {}",
+                      std::current_exception());
+                    reply.data.error_code = error_code::unknown_server_error;
+                }
+                return ctx.respond(std::move(reply));
+            });
+      });
+}
+
+} // namespace kafka
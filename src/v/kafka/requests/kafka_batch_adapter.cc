@@ -9,11 +9,13 @@
 
 #include "kafka/requests/kafka_batch_adapter.h"
 
+#include "bytes/utils.h"
 #include "hashing/crc32c.h"
 #include "kafka/requests/request_context.h"
 #include "kafka/requests/request_reader.h"
 #include "likely.h"
 #include "model/record.h"
+#include "model/record_utils.h"
 #include "raft/types.h"
 #include "storage/parser_utils.h"
 #include "vassert.h"
@@ -102,11 +104,7 @@ void kafka_batch_adapter::verify_crc(int32_t expected_crc, iobuf_parser in) {
     in.skip(21);
 
     // 2. consume & checksum the CRC
-    in.consume(in.bytes_left(), [&crc](const char* src, size_t n) {
-        // NOLINTNEXTLINE
-        crc.extend(reinterpret_cast<const uint8_t*>(src), n);
-        return ss::stop_iteration::no;
-    });
+    crc_extend_iobuf(crc, in);
 
     // the crc is calculated over the bytes we receive as a uint32_t, but the
     // crc arrives off the wire as a signed 32-bit value.
@@ -149,13 +147,17 @@ void kafka_batch_adapter::adapt(iobuf&& kbatch) {
       header, std::move(records), model::record_batch::tag_ctor_ng{});
 
     /**
-     * Perform some type of validation on the uncompressed input. In this case
-     * we make sure that the records can be materialized but we avoid
-     * re-encoding them using the lazy-record optimization.
+     * The batch keeps its wire encoding and the crc verified above, which
+     * storage keeps as well, so the records are only checked to be framed as
+     * the header says rather than materialized. Their contents are covered by
+     * the crc.
      */
     if (!new_batch.compressed()) {
         try {
-            new_batch.for_each_record([](model::record r) { (void)r; });
+            if (unlikely(!model::verify_record_framing(new_batch))) {
+                vlog(klog.error, "Invalid record framing: {}", header);
+                return;
+            }
         } catch (const std::exception& e) {
             vlog(klog.error, "Parsing uncompressed records: {}", e.what());
             return;
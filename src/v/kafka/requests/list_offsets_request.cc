@@ -12,6 +12,7 @@
 #include "cluster/metadata_cache.h"
 #include "cluster/namespace.h"
 #include "cluster/partition_manager.h"
+#include "config/configuration.h"
 #include "kafka/errors.h"
 #include "kafka/requests/request_context.h"
 #include "kafka/requests/response.h"
@@ -65,123 +66,234 @@ struct list_offsets_ctx {
       , ssg(ssg) {}
 };
 
-static ss::future<list_offset_partition_response> list_offsets_partition(
-  list_offsets_ctx& octx,
-  model::timestamp timestamp,
-  list_offset_topic& topic,
-  list_offset_partition& part) {
-    auto ntp = model::ntp(
-      cluster::kafka_namespace, topic.name, part.partition_index);
+/*
+ * A partition lookup, resolved on the partition's home shard.
+ */
+struct partition_lookup {
+    model::ntp ntp;
+    model::timestamp timestamp;
+};
 
-    auto shard = octx.rctx.shards().shard_for(ntp);
-    if (!shard) {
+/*
+ * The partition lookups of a request that are owned by a single shard.
+ * Position i holds the (topic, partition) index in the response of the i-th
+ * lookup.
+ */
+struct shard_lookup {
+    std::vector<partition_lookup> requests;
+    std::vector<std::pair<size_t, size_t>> positions;
+};
+
+static ss::future<list_offset_partition_response>
+list_offsets_partition(cluster::partition_manager& mgr, partition_lookup req) {
+    const auto id = req.ntp.tp.partition;
+    auto partition = mgr.get(req.ntp);
+    if (!partition) {
         return ss::make_ready_future<list_offset_partition_response>(
           list_offsets_response::make_partition(
-            ntp.tp.partition, error_code::unknown_topic_or_partition));
+            id, error_code::unknown_topic_or_partition));
     }
 
-    return octx.rctx.partition_manager().invoke_on(
-      *shard,
-      octx.ssg,
-      [timestamp, ntp = std::move(ntp)](cluster::partition_manager& mgr) {
-          auto partition = mgr.get(ntp);
-          if (!partition) {
-              return ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  ntp.tp.partition, error_code::unknown_topic_or_partition));
-          }
+    if (!partition->is_leader()) {
+        return ss::make_ready_future<list_offset_partition_response>(
+          list_offsets_response::make_partition(
+            id, error_code::not_leader_for_partition));
+    }
 
-          if (!partition->is_leader()) {
-              return ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  ntp.tp.partition, error_code::not_leader_for_partition));
-          }
+    /*
+     * the responses for earliest/latest timestamp queries do not require
+     * that the actual timestamp be returned. only the offset is required.
+     */
+    if (req.timestamp == list_offsets_request::earliest_timestamp) {
+        return ss::make_ready_future<list_offset_partition_response>(
+          list_offsets_response::make_partition(
+            id, model::timestamp(-1), partition->start_offset()));
 
-          /*
-           * the responses for earliest/latest timestamp queries do not require
-           * that the actual timestamp be returned. only the offset is required.
-           */
-          if (timestamp == list_offsets_request::earliest_timestamp) {
-              return ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  ntp.tp.partition,
-                  model::timestamp(-1),
-                  partition->start_offset()));
-
-          } else if (timestamp == list_offsets_request::latest_timestamp) {
-              return ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  ntp.tp.partition,
-                  model::timestamp(-1),
-                  partition->last_stable_offset()));
-          }
+    } else if (req.timestamp == list_offsets_request::latest_timestamp) {
+        return ss::make_ready_future<list_offset_partition_response>(
+          list_offsets_response::make_partition(
+            id, model::timestamp(-1), partition->last_stable_offset()));
+    }
 
-          return partition->timequery(timestamp, kafka_read_priority())
-            .then([partition, id = ntp.tp.partition](
-                    std::optional<storage::timequery_result> res) {
-                if (res) {
-                    return ss::make_ready_future<
-                      list_offset_partition_response>(
-                      list_offsets_response::make_partition(
-                        id, res->time, res->offset));
-                }
-                return ss::make_ready_future<list_offset_partition_response>(
-                  list_offsets_response::make_partition(
-                    id, model::timestamp(-1), partition->last_stable_offset()));
-            });
+    return partition->timequery(req.timestamp, kafka_read_priority())
+      .then([partition, id](std::optional<storage::timequery_result> res) {
+          if (res) {
+              return list_offsets_response::make_partition(
+                id, res->time, res->offset);
+          }
+          return list_offsets_response::make_partition(
+            id, model::timestamp(-1), partition->last_stable_offset());
       });
 }
 
-static ss::future<list_offset_topic_response>
-list_offsets_topic(list_offsets_ctx& octx, list_offset_topic& topic) {
-    std::vector<ss::future<list_offset_partition_response>> partitions;
-    partitions.reserve(topic.partitions.size());
-
-    for (auto& part : topic.partitions) {
-        if (octx.request.duplicate_tp(topic.name, part.partition_index)) {
-            partitions.push_back(
-              ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  part.partition_index, error_code::invalid_request)));
-            continue;
-        }
+/**
+ * \brief resolve a set of partition lookups owned by the current core.
+ *
+ * The lookups are resolved concurrently and the responses are returned in the
+ * order of the requests.
+ */
+static ss::future<std::vector<list_offset_partition_response>>
+list_offsets_local_ntps(
+  cluster::partition_manager& mgr, std::vector<partition_lookup> requests) {
+    std::vector<ss::future<list_offset_partition_response>> lookups;
+    lookups.reserve(requests.size());
+    for (auto& req : requests) {
+        lookups.push_back(list_offsets_partition(mgr, std::move(req)));
+    }
+    return ss::when_all_succeed(lookups.begin(), lookups.end());
+}
 
-        if (!octx.rctx.metadata_cache().contains(
-              model::topic_namespace_view(cluster::kafka_namespace, topic.name),
-              part.partition_index)) {
-            partitions.push_back(
-              ss::make_ready_future<list_offset_partition_response>(
-                list_offsets_response::make_partition(
-                  part.partition_index,
-                  error_code::unknown_topic_or_partition)));
-            continue;
-        }
+/**
+ * \brief the earliest or latest offset of a partition from the offsets
+ * published by its home shard, if they are recent enough
+ */
+static std::optional<list_offset_partition_response> published_offset(
+  list_offsets_ctx& octx,
+  ss::shard_id shard,
+  const model::ntp& ntp,
+  model::timestamp timestamp) {
+    const auto max_age
+      = config::shard_local_cfg().kafka_list_offsets_max_staleness_ms();
+    if (
+      max_age.count() <= 0
+      || (timestamp != list_offsets_request::earliest_timestamp
+          && timestamp != list_offsets_request::latest_timestamp)) {
+        return std::nullopt;
+    }
+    auto offsets
+      = octx.rctx.partition_manager().local().offsets_table().get(
+        shard, ntp, max_age);
+    // a follower at the time of the snapshot asks the home shard, which
+    // answers with the current leadership
+    if (!offsets || !offsets->leader) {
+        return std::nullopt;
+    }
+    return list_offsets_response::make_partition(
+      ntp.tp.partition,
+      model::timestamp(-1),
+      timestamp == list_offsets_request::earliest_timestamp
+        ? offsets->start_offset
+        : offsets->last_stable_offset);
+}
+
+/**
+ * \brief validate a partition of the request and add its lookup to the
+ * lookups of its home shard. Otherwise the response of the partition is
+ * returned right away: its error, or its offset when the offsets published
+ * by its home shard answer the lookup.
+ */
+static std::optional<list_offset_partition_response> prepare_partition(
+  list_offsets_ctx& octx,
+  const list_offset_topic& topic,
+  const list_offset_partition& part,
+  std::vector<shard_lookup>& shards,
+  std::pair<size_t, size_t> position) {
+    const auto error = [&part](error_code e) {
+        return list_offsets_response::make_partition(part.partition_index, e);
+    };
+    if (octx.request.duplicate_tp(topic.name, part.partition_index)) {
+        return error(error_code::invalid_request);
+    }
 
-        auto pr = list_offsets_partition(octx, part.timestamp, topic, part);
-        partitions.push_back(std::move(pr));
+    if (!octx.rctx.metadata_cache().contains(
+          model::topic_namespace_view(cluster::kafka_namespace, topic.name),
+          part.partition_index)) {
+        return error(error_code::unknown_topic_or_partition);
     }
 
-    return when_all_succeed(partitions.begin(), partitions.end())
-      .then([name = std::move(topic.name)](
-              std::vector<list_offset_partition_response> parts) mutable {
-          return list_offset_topic_response{
-            .name = std::move(name),
-            .partitions = std::move(parts),
-          };
-      });
+    auto ntp = model::ntp(
+      cluster::kafka_namespace, topic.name, part.partition_index);
+    auto shard = octx.rctx.shards().shard_for(ntp);
+    if (!shard) {
+        return error(error_code::unknown_topic_or_partition);
+    }
+
+    if (auto resp = published_offset(octx, *shard, ntp, part.timestamp)) {
+        return resp;
+    }
+
+    auto& lookups = shards[*shard];
+    lookups.positions.push_back(position);
+    lookups.requests.push_back(partition_lookup{
+      .ntp = std::move(ntp),
+      .timestamp = part.timestamp,
+    });
+    return std::nullopt;
 }
 
-static std::vector<ss::future<list_offset_topic_response>>
-list_offsets_topics(list_offsets_ctx& octx) {
-    std::vector<ss::future<list_offset_topic_response>> topics;
-    topics.reserve(octx.request.data.topics.size());
+/**
+ * \brief resolve the partitions of the request into the response.
+ *
+ * Stream processors restoring by time look up thousands of partitions at
+ * once. The partitions are grouped by their home shard, and each shard
+ * receives a single cross-core request that resolves all of its partitions
+ * concurrently. Responses are placed into the response in the order of the
+ * request.
+ */
+static ss::future<> list_offsets_topics(list_offsets_ctx& octx) {
+    std::vector<shard_lookup> shards(ss::smp::count);
 
-    for (auto& topic : octx.request.data.topics) {
-        auto tr = list_offsets_topic(octx, topic);
-        topics.push_back(std::move(tr));
+    auto& topics = octx.response.data.topics;
+    topics.reserve(octx.request.data.topics.size());
+    for (const auto& topic : octx.request.data.topics) {
+        auto& t = topics.emplace_back(
+          list_offset_topic_response{.name = topic.name});
+        t.partitions.reserve(topic.partitions.size());
+        for (const auto& part : topic.partitions) {
+            auto position = std::make_pair(
+              topics.size() - 1, t.partitions.size());
+            auto resp = prepare_partition(octx, topic, part, shards, position);
+            // a placeholder until the shard responds, unless answered
+            t.partitions.push_back(
+              resp ? std::move(*resp)
+                   : list_offsets_response::make_partition(
+                     part.partition_index, error_code::none));
+        }
     }
 
-    return topics;
+    return ss::do_with(
+      std::move(shards), [&octx](std::vector<shard_lookup>& shards) {
+          std::vector<ss::future<>> lookups;
+          for (ss::shard_id shard = 0; shard < shards.size(); ++shard) {
+              auto& shard_lookups = shards[shard];
+              if (shard_lookups.requests.empty()) {
+                  continue;
+              }
+              lookups.push_back(
+                octx.rctx.partition_manager()
+                  .invoke_on(
+                    shard,
+                    octx.ssg,
+                    [requests = std::move(shard_lookups.requests)](
+                      cluster::partition_manager& mgr) mutable {
+                        return list_offsets_local_ntps(
+                          mgr, std::move(requests));
+                    })
+                  .then_wrapped(
+                    [&octx, &shard_lookups](
+                      ss::future<std::vector<list_offset_partition_response>>
+                        f) {
+                        auto& topics = octx.response.data.topics;
+                        const auto& positions = shard_lookups.positions;
+                        try {
+                            auto results = f.get0();
+                            for (size_t i = 0; i < results.size(); ++i) {
+                                auto [t, p] = positions[i];
+                                topics[t].partitions[p] = std::move(
+                                  results[i]);
+                            }
+                        } catch (...) {
+                            for (auto [t, p] : positions) {
+                                auto& part = topics[t].partitions[p];
+                                part = list_offsets_response::make_partition(
+                                  part.partition_index,
+                                  error_code::unknown_server_error);
+                            }
+                        }
+                    }));
+          }
+          return ss::when_all_succeed(lookups.begin(), lookups.end());
+      });
 }
 
 ss::future<response_ptr>
@@ -194,12 +306,9 @@ list_offsets_api::process(request_context&& ctx, ss::smp_service_group ssg) {
     return ss::do_with(
       list_offsets_ctx(std::move(ctx), std::move(request), ssg),
       [](list_offsets_ctx& octx) {
-          auto topics = list_offsets_topics(octx);
-          return when_all_succeed(topics.begin(), topics.end())
-            .then([&octx](std::vector<list_offset_topic_response> topics) {
-                octx.response.data.topics = std::move(topics);
-                return octx.rctx.respond(std::move(octx.response));
-            });
+          return list_offsets_topics(octx).then([&octx] {
+              return octx.rctx.respond(std::move(octx.response));
+          });
       });
 }
 
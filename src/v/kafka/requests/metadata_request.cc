@@ -14,12 +14,14 @@
 #include "cluster/types.h"
 #include "config/configuration.h"
 #include "kafka/errors.h"
+#include "kafka/requests/metadata_response_cache.h"
 #include "kafka/requests/topics/topic_utils.h"
 #include "likely.h"
 #include "model/metadata.h"
 #include "utils/to_string.h"
 
 #include <seastar/core/future-util.hh>
+#include <seastar/core/smp.hh>
 #include <seastar/core/thread.hh>
 
 #include <fmt/ostream.h>
@@ -74,9 +76,11 @@ std::ostream& operator<<(std::ostream& o, const metadata_request& r) {
 }
 
 void metadata_response::encode(const request_context& ctx, response& resp) {
-    auto& writer = resp.writer();
-    auto version = ctx.header().version;
+    encode(resp.writer(), ctx.header().version, ctx.shard_aware());
+}
 
+void metadata_response::encode(
+  response_writer& writer, api_version version, bool shard_aware) {
     if (version >= api_version(3)) {
         writer.write(int32_t(throttle_time.count()));
     }
@@ -98,12 +102,26 @@ void metadata_response::encode(const request_context& ctx, response& resp) {
     if (version >= api_version(1)) {
         writer.write(controller_id);
     }
-    writer.write_array(topics, [version](const topic& tp, response_writer& rw) {
-        tp.encode(version, rw);
-    });
+    writer.write(int32_t(topics.size() + encoded_topics.size()));
+    for (const auto& tp : topics) {
+        tp.encode(version, writer);
+    }
+    for (auto& tp : encoded_topics) {
+        writer.write_fragments(std::move(tp));
+    }
     if (version >= api_version(8)) {
         writer.write(cluster_authorized_operations);
     }
+    if (shard_aware && routing) {
+        writer.write(routing->cores);
+        writer.write_array(
+          routing->partitions,
+          [](const shard_routing::partition_shard& p, response_writer& rw) {
+              rw.write(p.topic);
+              rw.write(p.index);
+              rw.write(p.shard);
+          });
+    }
 }
 
 void metadata_response::topic::encode(
@@ -213,6 +231,20 @@ void metadata_response::decode(iobuf buf, api_version version) {
     if (version >= api_version(8)) {
         cluster_authorized_operations = model::node_id(reader.read_int32());
     }
+
+    // only sent by the shard aware listener
+    if (reader.bytes_left() > 0) {
+        shard_routing r;
+        r.cores = reader.read_int32();
+        r.partitions = reader.read_array([](request_reader& reader) {
+            return shard_routing::partition_shard{
+              .topic = model::topic(reader.read_string()),
+              .index = model::partition_id(reader.read_int32()),
+              .shard = reader.read_int32(),
+            };
+        });
+        routing = std::move(r);
+    }
 }
 
 metadata_response::topic metadata_response::topic::make_from_topic_metadata(
@@ -279,12 +311,13 @@ std::ostream& operator<<(std::ostream& o, const metadata_response& resp) {
     return fmt_print(
       o,
       "throttle_time {} brokers {} cluster_id {} controller_id {} topics {} "
-      "cluster_aut_ops {}",
+      "encoded_topics {} cluster_aut_ops {}",
       resp.throttle_time,
       resp.brokers,
       resp.cluster_id,
       resp.controller_id,
       resp.topics,
+      resp.encoded_topics.size(),
       resp.cluster_authorized_operations);
 }
 
@@ -333,38 +366,89 @@ create_topic(request_context& ctx, model::topic&& topic) {
       });
 }
 
-static ss::future<std::vector<metadata_response::topic>>
-get_topic_metadata(request_context& ctx, metadata_request& request) {
-    std::vector<metadata_response::topic> res;
+/// \brief the encoded metadata of an existing topic, shared with the
+/// previous requests of the same version when the topic did not change since
+static std::optional<iobuf>
+encoded_topic_metadata(request_context& ctx, const model::topic& topic) {
+    const auto tp_ns = model::topic_namespace_view(
+      cluster::kafka_namespace, topic);
+    const auto rev = ctx.metadata_cache().get_topic_revision(tp_ns);
+    if (!rev.exists()) {
+        return std::nullopt;
+    }
+    const auto version = ctx.header().version;
+    auto& cache = metadata_responses();
+    if (auto encoded = cache.get(topic, version, rev); encoded) {
+        return encoded;
+    }
+    auto md = ctx.metadata_cache().get_topic_metadata(tp_ns);
+    if (!md) {
+        return std::nullopt;
+    }
+    iobuf buf;
+    response_writer rw(buf);
+    metadata_response::topic::make_from_topic_metadata(std::move(*md))
+      .encode(version, rw);
+    return cache.put(topic, version, rev, std::move(buf));
+}
+
+/// \brief the cores of the partitions of the topics replicated by the broker
+static metadata_response::shard_routing
+make_shard_routing(request_context& ctx, std::vector<model::topic> tps) {
+    metadata_response::shard_routing routing{
+      .cores = static_cast<int32_t>(ss::smp::count)};
+    for (const auto& tp : tps) {
+        auto cfg = ctx.metadata_cache().get_topic_cfg(
+          model::topic_namespace_view(cluster::kafka_namespace, tp));
+        if (!cfg) {
+            continue;
+        }
+        for (int32_t i = 0; i < cfg->partition_count; ++i) {
+            const auto id = model::partition_id(i);
+            if (auto shard = ctx.shards().shard_for(
+                  model::ntp(cluster::kafka_namespace, tp, id));
+                shard) {
+                routing.partitions.push_back(
+                  metadata_response::shard_routing::partition_shard{
+                    .topic = tp,
+                    .index = id,
+                    .shard = static_cast<int32_t>(*shard)});
+            }
+        }
+    }
+    return routing;
+}
+
+/// \brief the names of the encoded topics are added to encoded_names
+static ss::future<> get_topic_metadata(
+  request_context& ctx,
+  metadata_response& reply,
+  std::vector<model::topic>& encoded_names) {
+    metadata_request request;
+    request.decode(ctx);
 
     // request can be served from whatever happens to be in the cache
     if (request.list_all_topics) {
-        auto topics = ctx.metadata_cache().all_topics_metadata();
-        // only serve topics from the kafka namespace
-        auto it = std::remove_if(
-          topics.begin(), topics.end(), [](model::topic_metadata& t_md) {
-              return t_md.tp_ns.ns != cluster::kafka_namespace;
-          });
-        std::transform(
-          topics.begin(),
-          it,
-          std::back_inserter(res),
-          [](model::topic_metadata& t_md) {
-              return metadata_response::topic::make_from_topic_metadata(
-                std::move(t_md));
-          });
-        return ss::make_ready_future<std::vector<metadata_response::topic>>(
-          std::move(res));
+        for (auto& tp_ns : ctx.metadata_cache().all_topics()) {
+            // only serve topics from the kafka namespace
+            if (tp_ns.ns != cluster::kafka_namespace) {
+                continue;
+            }
+            if (auto encoded = encoded_topic_metadata(ctx, tp_ns.tp);
+                encoded) {
+                reply.encoded_topics.push_back(std::move(*encoded));
+                encoded_names.push_back(tp_ns.tp);
+            }
+        }
+        return ss::now();
     }
 
     std::vector<ss::future<metadata_response::topic>> new_topics;
 
     for (auto& topic : *request.topics) {
-        if (auto md = ctx.metadata_cache().get_topic_metadata(
-              model::topic_namespace_view(cluster::kafka_namespace, topic));
-            md) {
-            res.push_back(metadata_response::topic::make_from_topic_metadata(
-              std::move(*md)));
+        if (auto encoded = encoded_topic_metadata(ctx, topic); encoded) {
+            reply.encoded_topics.push_back(std::move(*encoded));
+            encoded_names.push_back(std::move(topic));
             continue;
         }
 
@@ -374,7 +458,7 @@ get_topic_metadata(request_context& ctx, metadata_request& request) {
             metadata_response::topic t;
             t.name = std::move(topic);
             t.err_code = error_code::unknown_topic_or_partition;
-            res.push_back(std::move(t));
+            reply.topics.push_back(std::move(t));
             continue;
         }
 
@@ -382,10 +466,11 @@ get_topic_metadata(request_context& ctx, metadata_request& request) {
     }
 
     return ss::when_all_succeed(new_topics.begin(), new_topics.end())
-      .then([res = std::move(res)](
-              std::vector<metadata_response::topic> topics) mutable {
-          res.insert(res.end(), topics.begin(), topics.end());
-          return res;
+      .then([&reply](std::vector<metadata_response::topic> topics) {
+          reply.topics.insert(
+            reply.topics.end(),
+            std::make_move_iterator(topics.begin()),
+            std::make_move_iterator(topics.end()));
       });
 }
 
@@ -394,7 +479,11 @@ ss::future<response_ptr> metadata_api::process(
     return ss::do_with(
       std::move(ctx),
       metadata_response{},
-      [](request_context& ctx, metadata_response& reply) {
+      std::vector<model::topic>{},
+      [](
+        request_context& ctx,
+        metadata_response& reply,
+        std::vector<model::topic>& names) {
           auto brokers = ctx.metadata_cache().all_brokers();
           std::transform(
             brokers.begin(),
@@ -414,13 +503,19 @@ ss::future<response_ptr> metadata_api::process(
           auto leader_id = ctx.metadata_cache().get_controller_leader_id();
           reply.controller_id = leader_id.value_or(model::node_id(-1));
 
-          metadata_request request;
-          request.decode(ctx);
-          return get_topic_metadata(ctx, request)
-            .then([&reply](std::vector<metadata_response::topic> topics) {
-                reply.topics = std::move(topics);
-            })
-            .then([&ctx, &reply] { return ctx.respond(std::move(reply)); });
+          return get_topic_metadata(ctx, reply, names)
+            .then([&ctx, &reply, &names] {
+                if (ctx.shard_aware()) {
+                    for (const auto& t : reply.topics) {
+                        if (t.err_code == error_code::none) {
+                            names.push_back(t.name);
+                        }
+                    }
+                    reply.routing = make_shard_routing(
+                      ctx, std::move(names));
+                }
+                return ctx.respond(std::move(reply));
+            });
       });
 }
 
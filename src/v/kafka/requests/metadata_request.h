@@ -89,9 +89,29 @@ struct metadata_response {
     std::optional<ss::sstring> cluster_id; // version >= 2
     model::node_id controller_id;          // version >= 1
     std::vector<topic> topics;
+    // topics already encoded for the version of the request, written after
+    // the ones above
+    std::vector<iobuf> encoded_topics;
     int32_t cluster_authorized_operations = 0; // version >= 8
 
+    /// \brief the cores of the partitions of the topics above replicated by
+    /// the broker answering, written after the fields of the version for the
+    /// connections of the shard aware listener only
+    struct shard_routing {
+        struct partition_shard {
+            model::topic topic;
+            model::partition_id index;
+            int32_t shard;
+        };
+        /// the cores of the broker: its shard aware listener serves a
+        /// connection from the source port p with the core p % cores
+        int32_t cores;
+        std::vector<partition_shard> partitions;
+    };
+    std::optional<shard_routing> routing;
+
     void encode(const request_context& ctx, response& resp);
+    void encode(response_writer& writer, api_version version, bool shard_aware);
     void decode(iobuf buf, api_version version);
 };
 
@@ -0,0 +1,55 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/requests/metadata_response_cache.h"
+
+namespace kafka {
+
+std::optional<iobuf> metadata_response_cache::get(
+  const model::topic& topic, api_version version, const revision& rev) {
+    auto it = _entries.find(key_view(topic(), version()));
+    if (it == _entries.end()) {
+        return std::nullopt;
+    }
+    if (it->second.rev != rev) {
+        _size_bytes -= it->second.encoded.size_bytes();
+        _entries.erase(it);
+        return std::nullopt;
+    }
+    return it->second.encoded.share(0, it->second.encoded.size_bytes());
+}
+
+iobuf metadata_response_cache::put(
+  const model::topic& topic,
+  api_version version,
+  const revision& rev,
+  iobuf encoded) {
+    const auto size = encoded.size_bytes();
+    if (size > _max_bytes) {
+        return encoded;
+    }
+    auto it = _entries.find(key_view(topic(), version()));
+    if (it != _entries.end()) {
+        _size_bytes -= it->second.encoded.size_bytes();
+        _entries.erase(it);
+    }
+    // the encodings of the topics no longer requested are not tracked, so
+    // they are all dropped once the cache is full
+    if (_size_bytes + size > _max_bytes) {
+        _entries.clear();
+        _size_bytes = 0;
+    }
+    // copied so that the cache holds no spare capacity of the encoder
+    auto [new_it, _] = _entries.emplace(
+      key(topic(), version()), entry{.rev = rev, .encoded = encoded.copy()});
+    _size_bytes += size;
+    return new_it->second.encoded.share(0, size);
+}
+
+} // namespace kafka
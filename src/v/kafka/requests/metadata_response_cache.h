@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "bytes/iobuf.h"
+#include "cluster/metadata_cache.h"
+#include "kafka/types.h"
+#include "model/fundamental.h"
+#include "seastarx.h"
+#include "units.h"
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace kafka {
+
+/**
+ * Encoded topics of the metadata responses of a shard.
+ *
+ * Clients refresh the metadata of the topics they use every few seconds, and
+ * encoding a topic with many partitions is most of the cost of a metadata
+ * request. The encoding of a topic is kept per api version, along with the
+ * revision of the metadata it was made from, and is shared by the responses
+ * as long as the revision of the topic stays the same.
+ */
+class metadata_response_cache {
+public:
+    using revision = cluster::metadata_cache::topic_revision;
+
+    static constexpr size_t default_max_bytes = 4_MiB;
+
+    explicit metadata_response_cache(size_t max_bytes = default_max_bytes)
+      : _max_bytes(max_bytes) {}
+
+    /// \brief the encoded topic, if it was encoded at this revision
+    std::optional<iobuf>
+    get(const model::topic&, api_version, const revision&);
+
+    /// \brief caches the encoded topic, returns a share of it
+    iobuf put(const model::topic&, api_version, const revision&, iobuf);
+
+    size_t size() const { return _entries.size(); }
+    size_t size_bytes() const { return _size_bytes; }
+
+private:
+    struct entry {
+        revision rev;
+        iobuf encoded;
+    };
+    using key = std::pair<ss::sstring, api_version::type>;
+    using key_view = std::pair<std::string_view, api_version::type>;
+    struct key_hash {
+        using is_transparent = void;
+        size_t operator()(const key_view& k) const {
+            return absl::Hash<key_view>{}(k);
+        }
+        size_t operator()(const key& k) const {
+            return (*this)(key_view(k.first, k.second));
+        }
+    };
+    struct key_eq {
+        using is_transparent = void;
+        static key_view view(const key_view& k) { return k; }
+        static key_view view(const key& k) {
+            return key_view(k.first, k.second);
+        }
+        template<typename L, typename R>
+        bool operator()(const L& l, const R& r) const {
+            return view(l) == view(r);
+        }
+    };
+
+    absl::flat_hash_map<key, entry, key_hash, key_eq> _entries;
+    size_t _size_bytes{0};
+    size_t _max_bytes;
+};
+
+/// \brief the metadata responses cached on this shard
+inline metadata_response_cache& metadata_responses() {
+    static thread_local metadata_response_cache cache;
+    return cache;
+}
+
+} // namespace kafka
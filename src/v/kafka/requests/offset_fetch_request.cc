@@ -54,6 +54,7 @@ ss::future<response_ptr>
 offset_fetch_api::process(request_context&& ctx, ss::smp_service_group ssg) {
     offset_fetch_request request;
     request.decode(ctx.reader(), ctx.header().version);
+    request.version = ctx.header().version;
     klog.trace("Handling request {}", request);
     return ss::do_with(
       offset_fetch_ctx(std::move(ctx), std::move(request), ssg),
@@ -23,6 +23,8 @@
 
 #include <seastar/core/future.hh>
 
+#include <optional>
+
 namespace kafka {
 
 struct offset_fetch_response;
@@ -52,6 +54,9 @@ struct offset_fetch_request final {
     // set during request processing after mapping group to ntp
     model::ntp ntp;
 
+    // the version of the request, which the group encodes its response with
+    api_version version;
+
     void encode(response_writer& writer, api_version version) {
         data.encode(writer, version);
     }
@@ -68,6 +73,9 @@ struct offset_fetch_response final {
 
     offset_fetch_response_data data;
 
+    // the response encoded by the group already, written instead of data
+    std::optional<iobuf> encoded;
+
     offset_fetch_response() = default;
 
     offset_fetch_response(error_code error) { data.error_code = error; }
@@ -100,6 +108,10 @@ struct offset_fetch_response final {
     }
 
     void encode(const request_context& ctx, response& resp) {
+        if (encoded) {
+            resp.writer().write_direct(std::move(*encoded));
+            return;
+        }
         data.encode(resp.writer(), ctx.header().version);
     }
 
@@ -10,10 +10,13 @@
 #include "kafka/requests/produce_request.h"
 
 #include "bytes/iobuf.h"
+#include "cluster/errc.h"
 #include "cluster/metadata_cache.h"
 #include "cluster/namespace.h"
 #include "cluster/partition_manager.h"
+#include "cluster/shard_table.h"
 #include "kafka/errors.h"
+#include "kafka/load_sketches.h"
 #include "kafka/requests/kafka_batch_adapter.h"
 #include "kafka/requests/response_writer_utils.h"
 #include "likely.h"
@@ -21,6 +24,7 @@
 #include "model/metadata.h"
 #include "model/record_batch_reader.h"
 #include "model/timestamp.h"
+#include "raft/replicate_trace.h"
 #include "raft/types.h"
 #include "storage/shard_assignment.h"
 #include "utils/remote.h"
@@ -29,6 +33,7 @@
 
 #include <seastar/core/execution_stage.hh>
 #include <seastar/core/future.hh>
+#include <seastar/core/smp.hh>
 #include <seastar/util/log.hh>
 
 #include <fmt/ostream.h>
@@ -54,8 +59,10 @@ void produce_request::encode(response_writer& writer, api_version) {
 }
 
 void produce_request::decode(request_context& ctx) {
-    auto& reader = ctx.reader();
+    decode(ctx.reader(), ctx.header().version);
+}
 
+void produce_request::decode(request_reader& reader, api_version) {
     transactional_id = reader.read_nullable_string();
     acks = reader.read_int16();
     timeout = std::chrono::milliseconds(reader.read_int32());
@@ -215,29 +222,58 @@ struct produce_ctx {
     produce_request request;
     produce_response response;
     ss::smp_service_group ssg;
+    // records the latency of its stages, see raft::replicate_tracer
+    bool traced;
 
     produce_ctx(
       request_context&& rctx,
       produce_request&& request,
-      ss::smp_service_group ssg)
+      ss::smp_service_group ssg,
+      bool traced)
       : rctx(std::move(rctx))
       , request(std::move(request))
-      , ssg(ssg) {}
+      , ssg(ssg)
+      , traced(traced) {}
 };
 
-static raft::replicate_options acks_to_replicate_options(int16_t acks) {
+static raft::consistency_level acks_to_consistency_level(int16_t acks) {
     switch (acks) {
     case -1:
-        return raft::replicate_options(raft::consistency_level::quorum_ack);
+        return raft::consistency_level::quorum_ack;
     case 0:
-        return raft::replicate_options(raft::consistency_level::no_ack);
+        return raft::consistency_level::no_ack;
     case 1:
-        return raft::replicate_options(raft::consistency_level::leader_ack);
+        return raft::consistency_level::leader_ack;
     default:
         throw std::invalid_argument("Not supported ack level");
     };
 }
 
+static raft::replicate_options
+acks_to_replicate_options(int16_t acks, bool traced) {
+    raft::replicate_options opts(acks_to_consistency_level(acks));
+    opts.traced = traced;
+    return opts;
+}
+
+static error_code map_produce_error(std::error_code ec) {
+    if (ec.category() == cluster::error_category()) {
+        switch (static_cast<cluster::errc>(ec.value())) {
+        case cluster::errc::sequence_out_of_order:
+            return error_code::out_of_order_sequence_number;
+        case cluster::errc::duplicate_sequence:
+            return error_code::duplicate_sequence_number;
+        case cluster::errc::invalid_producer_epoch:
+            return error_code::invalid_producer_epoch;
+        case cluster::errc::unknown_producer_id:
+            return error_code::unknown_producer_id;
+        default:
+            break;
+        }
+    }
+    return error_code::unknown_server_error;
+}
+
 static inline model::record_batch_reader
 reader_from_lcore_batch(model::record_batch&& batch) {
     /*
@@ -257,12 +293,16 @@ reader_from_lcore_batch(model::record_batch&& batch) {
 static ss::future<produce_response::partition> partition_append(
   model::partition_id id,
   ss::lw_shared_ptr<cluster::partition> partition,
+  cluster::batch_identity bid,
   model::record_batch_reader reader,
   int16_t acks,
-  int32_t num_records) {
+  bool traced,
+  int32_t num_records,
+  size_t num_bytes) {
     return partition
-      ->replicate(std::move(reader), acks_to_replicate_options(acks))
-      .then_wrapped([partition, id, num_records = num_records](
+      ->replicate(
+        bid, std::move(reader), acks_to_replicate_options(acks, traced))
+      .then_wrapped([partition, id, num_records = num_records, num_bytes](
                       ss::future<result<raft::replicate_result>> f) {
           produce_response::partition p{.id = id};
           try {
@@ -274,8 +314,9 @@ static ss::future<produce_response::partition> partition_append(
                     r.value().last_offset() - (num_records - 1));
                   p.error = error_code::none;
                   partition->probe().add_records_produced(num_records);
+                  partition->probe().add_bytes_produced(num_bytes);
               } else {
-                  p.error = error_code::unknown_server_error;
+                  p.error = map_produce_error(r.error());
               }
           } catch (...) {
               p.error = error_code::unknown_server_error;
@@ -284,13 +325,101 @@ static ss::future<produce_response::partition> partition_append(
       });
 }
 
+/*
+ * A single partition write, prepared on the connection core and dispatched
+ * to the partition's home core.
+ */
+struct partition_produce {
+    model::ntp ntp;
+    cluster::batch_identity bid;
+    model::record_batch_reader reader;
+    int32_t num_records;
+    size_t num_bytes;
+};
+
+/*
+ * The partition writes of a produce request that are owned by a single
+ * shard. Position i holds the (topic, partition) index in the response of
+ * the i-th write.
+ */
+struct shard_produce {
+    std::vector<partition_produce> requests;
+    std::vector<std::pair<size_t, size_t>> positions;
+};
+
+/**
+ * \brief write to a set of partitions owned by the current core.
+ *
+ * All writes are replicated concurrently and the responses are returned in
+ * the order of the requests.
+ */
+static ss::future<std::vector<produce_response::partition>>
+produce_local_ntps(
+  cluster::partition_manager& mgr,
+  std::vector<partition_produce> requests,
+  int16_t acks,
+  bool traced) {
+    std::vector<ss::future<produce_response::partition>> writes;
+    writes.reserve(requests.size());
+    for (auto& req : requests) {
+        auto partition = mgr.get(req.ntp);
+        if (!partition) {
+            writes.push_back(ss::make_ready_future<produce_response::partition>(
+              produce_response::partition{
+                .id = req.ntp.tp.partition,
+                .error = error_code::unknown_topic_or_partition}));
+            continue;
+        }
+        if (unlikely(!partition->is_leader())) {
+            writes.push_back(ss::make_ready_future<produce_response::partition>(
+              produce_response::partition{
+                .id = req.ntp.tp.partition,
+                .error = error_code::not_leader_for_partition}));
+            continue;
+        }
+        writes.push_back(partition_append(
+          req.ntp.tp.partition,
+          partition,
+          req.bid,
+          std::move(req.reader),
+          acks,
+          traced,
+          req.num_records,
+          req.num_bytes));
+    }
+    return ss::when_all_succeed(writes.begin(), writes.end());
+}
+
 /**
- * \brief handle writing to a single topic partition.
+ * \brief validate and prepare the write to a single topic partition.
+ *
+ * On success the batch is moved out of the request and the write is added to
+ * the writes of its home shard. Otherwise the error for the partition is
+ * returned.
  */
-static ss::future<produce_response::partition> produce_topic_partition(
+static error_code prepare_topic_partition(
   produce_ctx& octx,
   produce_request::topic& topic,
-  produce_request::partition& part) {
+  produce_request::partition& part,
+  std::vector<shard_produce>& shards,
+  std::pair<size_t, size_t> position) {
+    if (!octx.rctx.metadata_cache().contains(
+          model::topic_namespace_view(cluster::kafka_namespace, topic.name),
+          part.id)) {
+        return error_code::unknown_topic_or_partition;
+    }
+
+    if (unlikely(!part.adapter.valid_crc)) {
+        return error_code::corrupt_message;
+    }
+
+    // produce version >= 3 (enforced for all produce requests)
+    // requires exactly one record batch per request and it must use
+    // the v2 format.
+    if (unlikely(!part.adapter.v2_format || !part.adapter.batch)) {
+        return error_code::invalid_record;
+    }
+
     auto ntp = model::ntp(cluster::kafka_namespace, topic.name, part.id);
 
     /*
@@ -298,12 +427,8 @@ static ss::future<produce_response::partition> produce_topic_partition(
      * different partitions that are managed different cores.
      */
     auto shard = octx.rctx.shards().shard_for(ntp);
-
     if (!shard) {
-        return ss::make_ready_future<produce_response::partition>(
-          produce_response::partition{
-            .id = ntp.tp.partition,
-            .error = error_code::unknown_topic_or_partition});
+        return error_code::unknown_topic_or_partition;
     }
 
     // steal the batch from the adapter
@@ -324,123 +449,142 @@ static ss::future<produce_response::partition> produce_topic_partition(
     }
 
     auto num_records = batch.record_count();
-    auto reader = reader_from_lcore_batch(std::move(batch));
-
-    return octx.rctx.partition_manager().invoke_on(
-      *shard,
-      octx.ssg,
-      [reader = std::move(reader),
-       ntp = std::move(ntp),
-       num_records,
-       acks = octx.request.acks](cluster::partition_manager& mgr) mutable {
-          auto partition = mgr.get(ntp);
-          if (!partition) {
-              return ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = ntp.tp.partition,
-                  .error = error_code::unknown_topic_or_partition});
-          }
-          if (unlikely(!partition->is_leader())) {
-              return ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = ntp.tp.partition,
-                  .error = error_code::not_leader_for_partition});
-          }
-          return partition_append(
-            ntp.tp.partition, partition, std::move(reader), acks, num_records);
-      });
+    auto num_bytes = batch.size_bytes();
+    auto bid = cluster::batch_identity::from(batch.header());
+    shard_load_sketches().record_partition(ntp, num_bytes);
+    auto& writes = shards[*shard];
+    writes.positions.push_back(position);
+    writes.requests.push_back(partition_produce{
+      .ntp = std::move(ntp),
+      .bid = bid,
+      .reader = reader_from_lcore_batch(std::move(batch)),
+      .num_records = num_records,
+      .num_bytes = num_bytes,
+    });
+    return error_code::none;
 }
 
 /**
  * \brief Dispatch and collect topic partition produce responses
+ *
+ * The partitions of the request are grouped by their home shard, and each
+ * shard receives a single cross-core request that replicates all of its
+ * partitions concurrently. Responses are placed into the response in the
+ * order of the request.
  */
-static ss::future<produce_response::topic>
-produce_topic(produce_ctx& octx, produce_request::topic& topic) {
-    std::vector<ss::future<produce_response::partition>> partitions;
-    partitions.reserve(topic.partitions.size());
-
-    for (auto& part : topic.partitions) {
-        if (!octx.rctx.metadata_cache().contains(
-              model::topic_namespace_view(cluster::kafka_namespace, topic.name),
-              part.id)) {
-            partitions.push_back(
-              ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = part.id,
-                  .error = error_code::unknown_topic_or_partition}));
-            continue;
-        }
+static ss::future<> produce_topics(produce_ctx& octx) {
+    std::vector<shard_produce> shards(ss::smp::count);
 
-        if (unlikely(!part.adapter.valid_crc)) {
-            partitions.push_back(
-              ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = part.id, .error = error_code::corrupt_message}));
-            continue;
+    size_t batch_bytes = 0;
+    octx.response.topics.reserve(octx.request.topics.size());
+    for (auto& topic : octx.request.topics) {
+        auto& t = octx.response.topics.emplace_back(
+          produce_response::topic{.name = topic.name});
+        t.partitions.reserve(topic.partitions.size());
+        for (auto& part : topic.partitions) {
+            if (part.adapter.batch) {
+                batch_bytes += part.adapter.batch->size_bytes();
+            }
+            auto position = std::make_pair(
+              octx.response.topics.size() - 1, t.partitions.size());
+            auto error = prepare_topic_partition(
+              octx, topic, part, shards, position);
+            t.partitions.push_back(
+              produce_response::partition{.id = part.id, .error = error});
         }
+    }
+
+    shard_load_sketches().record_client(
+      octx.rctx.header().client_id, batch_bytes);
 
-        // produce version >= 3 (enforced for all produce requests)
-        // requires exactly one record batch per request and it must use
-        // the v2 format.
-        if (unlikely(!part.adapter.v2_format || !part.adapter.batch)) {
-            partitions.push_back(
-              ss::make_ready_future<produce_response::partition>(
-                produce_response::partition{
-                  .id = part.id, .error = error_code::invalid_record}));
+    // the admission reserved a copy of every batch, but only the partitions
+    // of the other shards copy their batches, see replicate_batcher
+    size_t copied_bytes = 0;
+    for (ss::shard_id shard = 0; shard < shards.size(); ++shard) {
+        if (shard == ss::this_shard_id()) {
             continue;
         }
-
-        auto pr = produce_topic_partition(octx, topic, part);
-        partitions.push_back(std::move(pr));
+        for (const auto& req : shards[shard].requests) {
+            copied_bytes += req.num_bytes;
+        }
     }
+    octx.rctx.release_memory(batch_bytes - copied_bytes);
 
-    // collect partition responses and build the topic response
-    return when_all_succeed(partitions.begin(), partitions.end())
-      .then([name = std::move(topic.name)](
-              std::vector<produce_response::partition> parts) mutable {
-          return produce_response::topic{
-            .name = std::move(name),
-            .partitions = std::move(parts),
-          };
+    return ss::do_with(
+      std::move(shards), [&octx](std::vector<shard_produce>& shards) {
+          std::vector<ss::future<>> writes;
+          for (ss::shard_id shard = 0; shard < shards.size(); ++shard) {
+              auto& shard_writes = shards[shard];
+              if (shard_writes.requests.empty()) {
+                  continue;
+              }
+              writes.push_back(
+                octx.rctx.partition_manager()
+                  .invoke_on(
+                    shard,
+                    octx.ssg,
+                    [requests = std::move(shard_writes.requests),
+                     acks = octx.request.acks,
+                     traced = octx.traced,
+                     sent = raft::clock_type::now()](
+                      cluster::partition_manager& mgr) mutable {
+                        if (traced) {
+                            raft::shard_local_replicate_tracer().record(
+                              raft::replicate_stage::shard_hop,
+                              raft::clock_type::now() - sent);
+                        }
+                        return produce_local_ntps(
+                          mgr, std::move(requests), acks, traced);
+                    })
+                  .then_wrapped(
+                    [&octx, &shard_writes](
+                      ss::future<std::vector<produce_response::partition>> f) {
+                        auto& topics = octx.response.topics;
+                        const auto& positions = shard_writes.positions;
+                        try {
+                            auto results = f.get0();
+                            for (size_t i = 0; i < results.size(); ++i) {
+                                auto [t, p] = positions[i];
+                                topics[t].partitions[p] = results[i];
+                            }
+                        } catch (...) {
+                            for (auto [t, p] : positions) {
+                                topics[t].partitions[p].error
+                                  = error_code::unknown_server_error;
+                            }
+                        }
+                    }));
+          }
+          return ss::when_all_succeed(writes.begin(), writes.end());
       });
 }
 
-/**
- * \brief Dispatch and collect topic produce responses
- */
-static std::vector<ss::future<produce_response::topic>>
-produce_topics(produce_ctx& octx) {
-    std::vector<ss::future<produce_response::topic>> topics;
-    topics.reserve(octx.request.topics.size());
-
-    for (auto& topic : octx.request.topics) {
-        auto tr = produce_topic(octx, topic);
-        topics.push_back(std::move(tr));
-    }
-
-    return topics;
-}
-
 ss::future<response_ptr>
 produce_api::process(request_context&& ctx, ss::smp_service_group ssg) {
+    auto& tracer = raft::shard_local_replicate_tracer();
+    const bool traced = tracer.sample();
+    auto decode_start = raft::clock_type::now();
     produce_request request(ctx);
+    if (traced) {
+        tracer.record(
+          raft::replicate_stage::kafka_decode,
+          raft::clock_type::now() - decode_start);
+    }
 
     /*
      * Authorization
      *
      * Note that in kafka authorization is performed based on
-     * transactional id, producer id, and idempotency. Redpanda does not
-     * yet support these features, so we reject all such requests as if
-     * authorization failed.
+     * transactional id, producer id, and idempotency. The partitions track
+     * the transactions of producers (see cluster::producer_state_table) but
+     * there is no transaction coordinator yet to end them, so we reject
+     * transactional requests as if authorization failed. Idempotent
+     * producers are deduplicated by the partitions.
      */
     if (request.has_transactional) {
         return ctx.respond(request.make_error_response(
           error_code::transactional_id_authorization_failed));
 
-    } else if (request.has_idempotent) {
-        return ctx.respond(request.make_error_response(
-          error_code::cluster_authorization_failed));
-
     } else if (request.acks < -1 || request.acks > 1) {
         // from kafka source: "if required.acks is outside accepted
         // range, something is wrong with the client Just return an
@@ -456,59 +600,52 @@ produce_api::process(request_context&& ctx, ss::smp_service_group ssg) {
     }
 
     return ss::do_with(
-      produce_ctx(std::move(ctx), std::move(request), ssg),
+      produce_ctx(std::move(ctx), std::move(request), ssg, traced),
       [](produce_ctx& octx) {
           vlog(klog.trace, "handling produce request {}", octx.request);
 
-          // dispatch produce requests for each topic
-          auto topics = produce_topics(octx);
-
-          // collect topic responses
-          return when_all_succeed(topics.begin(), topics.end())
-            .then([&octx](std::vector<produce_response::topic> topics) {
-                octx.response.topics = std::move(topics);
-            })
-            .then([&octx] {
-                // send response immediately
-                if (octx.request.acks != 0) {
-                    return octx.rctx.respond(std::move(octx.response));
-                }
+          // dispatch produce requests and collect partition responses
+          return produce_topics(octx).then([&octx] {
+              // send response immediately
+              if (octx.request.acks != 0) {
+                  return octx.rctx.respond(std::move(octx.response));
+              }
 
-                // acks = 0 is handled separately. first, check for
-                // errors
-                bool has_error = false;
-                for (const auto& topic : octx.response.topics) {
-                    for (const auto& p : topic.partitions) {
-                        if (p.error != error_code::none) {
-                            has_error = true;
-                            break;
-                        }
-                    }
-                }
+              // acks = 0 is handled separately. first, check for
+              // errors
+              bool has_error = false;
+              for (const auto& topic : octx.response.topics) {
+                  for (const auto& p : topic.partitions) {
+                      if (p.error != error_code::none) {
+                          has_error = true;
+                          break;
+                      }
+                  }
+              }
 
-                // in the absense of errors, acks = 0 results in the
-                // response being dropped, as the client does not expect
-                // a response. here we mark the response as noop, but
-                // let it flow back so that it can be accounted for in
-                // quota and stats tracking. it is dropped later during
-                // processing.
-                if (!has_error) {
-                    return octx.rctx.respond(std::move(octx.response))
-                      .then([](response_ptr resp) {
-                          resp->mark_noop();
-                          return resp;
-                      });
-                }
+              // in the absense of errors, acks = 0 results in the
+              // response being dropped, as the client does not expect
+              // a response. here we mark the response as noop, but
+              // let it flow back so that it can be accounted for in
+              // quota and stats tracking. it is dropped later during
+              // processing.
+              if (!has_error) {
+                  return octx.rctx.respond(std::move(octx.response))
+                    .then([](response_ptr resp) {
+                        resp->mark_noop();
+                        return resp;
+                    });
+              }
 
-                // errors in a response from an acks=0 produce request
-                // result in the connection being dropped to signal an
-                // issue to the client
-                return ss::make_exception_future<response_ptr>(
-                  std::runtime_error(fmt::format(
-                    "Closing connection due to error in produce "
-                    "response: {}",
-                    octx.response)));
-            });
+              // errors in a response from an acks=0 produce request
+              // result in the connection being dropped to signal an
+              // issue to the client
+              return ss::make_exception_future<response_ptr>(
+                std::runtime_error(fmt::format(
+                  "Closing connection due to error in produce "
+                  "response: {}",
+                  octx.response)));
+          });
       });
 }
 
@@ -77,9 +77,13 @@ struct produce_request final {
     produce_request(produce_request&&) = default;
     produce_request& operator=(produce_request&&) = delete;
     explicit produce_request(request_context& ctx) { decode(ctx); }
+    produce_request(request_reader& reader, api_version version) {
+        decode(reader, version);
+    }
 
     void encode(response_writer& writer, api_version version);
     void decode(request_context& ctx);
+    void decode(request_reader& reader, api_version version);
 
     /**
      * Build a generic error response for a given request.
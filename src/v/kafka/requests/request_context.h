@@ -19,10 +19,12 @@
 
 #include <seastar/core/future.hh>
 #include <seastar/core/reactor.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/sharded.hh>
 #include <seastar/core/unaligned.hh>
 #include <seastar/util/log.hh>
 
+#include <algorithm>
 #include <memory>
 
 namespace cluster {
@@ -34,6 +36,7 @@ class topics_frontend;
 
 namespace kafka {
 class coordinator_ntp_mapper;
+class fetch_session_cache;
 
 template<typename T>
 class group_router;
@@ -80,7 +83,8 @@ public:
       kafka::group_router_type& group_router,
       cluster::shard_table& shard_table,
       ss::sharded<cluster::partition_manager>& partition_manager,
-      ss::sharded<coordinator_ntp_mapper>& coordinator_mapper) noexcept
+      ss::sharded<coordinator_ntp_mapper>& coordinator_mapper,
+      fetch_session_cache* fetch_sessions) noexcept
       : _metadata_cache(&metadata_cache)
       , _topics_frontend(&topics_frontend)
       , _header(std::move(header))
@@ -89,7 +93,8 @@ public:
       , _group_router(&group_router)
       , _shard_table(&shard_table)
       , _partition_manager(&partition_manager)
-      , _coordinator_mapper(&coordinator_mapper) {
+      , _coordinator_mapper(&coordinator_mapper)
+      , _fetch_sessions(fetch_sessions) {
         // XXX: don't forget to extend the move ctor
     }
     ~request_context() noexcept = default;
@@ -102,7 +107,10 @@ public:
       , _group_router(o._group_router)
       , _shard_table(o._shard_table)
       , _partition_manager(o._partition_manager)
-      , _coordinator_mapper(o._coordinator_mapper) {}
+      , _coordinator_mapper(o._coordinator_mapper)
+      , _fetch_sessions(o._fetch_sessions)
+      , _memory(std::move(o._memory))
+      , _shard_aware(o._shard_aware) {}
     request_context& operator=(request_context&& o) noexcept {
         if (this != &o) {
             this->~request_context();
@@ -166,6 +174,25 @@ public:
         return *_coordinator_mapper;
     }
 
+    /// fetch sessions of the client connection, or null if not supported
+    fetch_session_cache* fetch_sessions() { return _fetch_sessions; }
+
+    /// the request was received by the shard aware listener
+    bool shard_aware() const { return _shard_aware; }
+    void set_shard_aware() { _shard_aware = true; }
+
+    /// \brief the memory reserved for the request when it was admitted, held
+    /// until the request is done
+    void hold_memory(ss::semaphore_units<> units) {
+        _memory = std::move(units);
+    }
+
+    /// \brief gives back the part of the reservation the request turned out
+    /// not to need, once decoded
+    void release_memory(size_t bytes) {
+        _memory.return_units(std::min(bytes, _memory.count()));
+    }
+
 private:
     ss::sharded<cluster::metadata_cache>* _metadata_cache;
     cluster::topics_frontend* _topics_frontend;
@@ -176,6 +203,9 @@ private:
     cluster::shard_table* _shard_table;
     ss::sharded<cluster::partition_manager>* _partition_manager;
     ss::sharded<kafka::coordinator_ntp_mapper>* _coordinator_mapper;
+    fetch_session_cache* _fetch_sessions;
+    ss::semaphore_units<> _memory;
+    bool _shard_aware{false};
 };
 
 // Executes the API call identified by the specified request_context.
@@ -76,6 +76,69 @@ public:
         return {std::move(ret), len};
     }
 
+    /// the varint of the lengths and tags of the flexible versions
+    uint32_t read_unsigned_varint() {
+        uint32_t v = 0;
+        for (unsigned shift = 0; shift < 35; shift += 7) {
+            auto b = _parser.consume_type<uint8_t>();
+            v |= uint32_t(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return v;
+            }
+        }
+        throw std::out_of_range("Unsigned varint longer than 5 bytes");
+    }
+
+    ss::sstring read_compact_string() {
+        return do_read_string(read_compact_length());
+    }
+
+    std::optional<ss::sstring> read_compact_nullable_string() {
+        auto n = read_compact_length();
+        if (n < 0) {
+            return std::nullopt;
+        }
+        return {do_read_string(n)};
+    }
+
+    bytes read_compact_bytes() {
+        auto n = read_compact_length();
+        if (unlikely(n < 0)) {
+            throw std::out_of_range("Asked to read null compact bytes");
+        }
+        return _parser.read_bytes(n);
+    }
+
+    /// the tagged fields ending the structs of the flexible versions, none of
+    /// which is known
+    void skip_tagged_fields() {
+        auto n = read_unsigned_varint();
+        while (n-- > 0) {
+            read_unsigned_varint(); // tag
+            _parser.skip(read_unsigned_varint());
+        }
+    }
+
+    template<
+      typename ElementParser,
+      typename T = std::invoke_result_t<ElementParser, request_reader&>>
+    std::vector<T> read_compact_array(ElementParser&& parser) {
+        auto len = read_compact_length();
+        return do_read_array(len, std::forward<ElementParser>(parser));
+    }
+
+    template<
+      typename ElementParser,
+      typename T = std::invoke_result_t<ElementParser, request_reader&>>
+    std::optional<std::vector<T>>
+    read_compact_nullable_array(ElementParser&& parser) {
+        auto len = read_compact_length();
+        if (len < 0) {
+            return std::nullopt;
+        }
+        return do_read_array(len, std::forward<ElementParser>(parser));
+    }
+
     template<
       typename ElementParser,
       typename T = std::invoke_result_t<ElementParser, request_reader&>>
@@ -96,7 +159,12 @@ public:
     }
 
 private:
-    ss::sstring do_read_string(int16_t n) {
+    // the compact lengths are off by one, zero is null
+    int32_t read_compact_length() {
+        return static_cast<int32_t>(read_unsigned_varint()) - 1;
+    }
+
+    ss::sstring do_read_string(int32_t n) {
         if (unlikely(n < 0)) {
             /// FIXME: maybe return empty string?
             throw std::out_of_range("Asked to read a negative byte string");
@@ -15,6 +15,7 @@
 #include "kafka/requests/response_writer.h"
 #include "seastarx.h"
 
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/sharded.hh>
 
 #include <memory>
@@ -44,8 +45,14 @@ public:
     bool is_noop() const { return _noop; }
     void mark_noop() { _noop = true; }
 
+    /// the memory of the response is released once it is written
+    void hold_memory(ss::semaphore_units<> units) {
+        _memory = std::move(units);
+    }
+
 private:
     bool _noop{false};
+    ss::semaphore_units<> _memory;
     correlation_id _correlation;
     iobuf _buf;
     response_writer _writer;
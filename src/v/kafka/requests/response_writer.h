@@ -23,9 +23,12 @@
 
 #include <seastar/core/byteorder.hh>
 #include <seastar/core/sstring.hh>
+#include <seastar/core/temporary_buffer.hh>
 
 #include <boost/range/numeric.hpp>
 
+#include <algorithm>
+#include <array>
 #include <optional>
 #include <string_view>
 
@@ -38,6 +41,7 @@ class response_writer {
             && std::is_integral<IntegerType>::value)
       // clang-format on
       uint32_t serialize_int(IntegerType val) {
+        reserve_small(sizeof(ExplicitIntegerType));
         auto nval = ss::cpu_to_be(ExplicitIntegerType(val));
         _out->append(reinterpret_cast<const char*>(&nval), sizeof(nval));
         return sizeof(nval);
@@ -45,6 +49,7 @@ class response_writer {
 
     uint32_t serialize_vint(int64_t val) {
         auto x = vint::to_bytes(val);
+        reserve_small(x.size());
         _out->append(x.data(), x.size());
         return x.size();
     }
@@ -78,6 +83,7 @@ public:
     uint32_t write_varlong(int64_t v) { return serialize_vint(v); }
 
     uint32_t write(std::string_view v) {
+        reserve_small(sizeof(int16_t) + v.size());
         auto size = serialize_int<int16_t>(v.size()) + v.size();
         _out->append(v.data(), v.size());
         return size;
@@ -100,6 +106,7 @@ public:
     }
 
     uint32_t write(bytes_view bv) {
+        reserve_small(sizeof(int32_t) + bv.size());
         auto size = serialize_int<int32_t>(bv.size()) + bv.size();
         _out->append(reinterpret_cast<const char*>(bv.data()), bv.size());
         return size;
@@ -107,12 +114,72 @@ public:
 
     uint32_t write(const model::topic& topic) { return write(topic()); }
 
+    /// the varint of the lengths and tags of the flexible versions
+    uint32_t write_unsigned_varint(uint32_t v) {
+        std::array<char, 5> buf;
+        size_t n = 0;
+        while (v >= 0x80) {
+            buf[n++] = char((v & 0x7f) | 0x80);
+            v >>= 7;
+        }
+        buf[n++] = char(v);
+        reserve_small(n);
+        _out->append(buf.data(), n);
+        return n;
+    }
+
+    /// the fields of the flexible versions, whose strings, bytes and arrays
+    /// are prefixed by an unsigned varint of their length plus one
+    template<typename T>
+    uint32_t write_compact(const T& v) {
+        return write(v);
+    }
+
+    template<typename T, typename Tag>
+    uint32_t write_compact(const named_type<T, Tag>& t) {
+        return write_compact(t());
+    }
+
+    template<typename T>
+    uint32_t write_compact(const std::optional<T>& v) {
+        if (!v) {
+            return write_unsigned_varint(0);
+        }
+        return write_compact(*v);
+    }
+
+    uint32_t write_compact(std::string_view v) {
+        auto size = write_unsigned_varint(v.size() + 1) + v.size();
+        reserve_small(v.size());
+        _out->append(v.data(), v.size());
+        return size;
+    }
+
+    uint32_t write_compact(const ss::sstring& v) {
+        return write_compact(std::string_view(v));
+    }
+
+    uint32_t write_compact(bytes_view bv) {
+        auto size = write_unsigned_varint(bv.size() + 1) + bv.size();
+        reserve_small(bv.size());
+        _out->append(reinterpret_cast<const char*>(bv.data()), bv.size());
+        return size;
+    }
+
+    uint32_t write_compact(const bytes& b) {
+        return write_compact(bytes_view(b));
+    }
+
+    /// none of the tagged fields ending the structs of the flexible versions
+    uint32_t write_tagged_fields() { return write_unsigned_varint(0); }
+
     uint32_t write(std::optional<iobuf>&& data) {
         if (!data) {
             return serialize_int<int32_t>(-1);
         }
         auto size = serialize_int<int32_t>(data->size_bytes())
                     + data->size_bytes();
+        seal_arena();
         _out->append(std::move(*data));
         return size;
     }
@@ -120,10 +187,28 @@ public:
     // write bytes directly to output without a length prefix
     uint32_t write_direct(iobuf&& f) {
         auto size = f.size_bytes();
+        seal_arena();
         _out->append(std::move(f));
         return size;
     }
 
+    // write the fragments of f directly to output without copying them
+    uint32_t write_fragments(iobuf&& f) {
+        auto size = f.size_bytes();
+        seal_arena();
+        _out->append_fragments(std::move(f));
+        return size;
+    }
+
+    // write the size prefixed data, or null, without copying its fragments
+    uint32_t write_fragments(std::optional<iobuf>&& data) {
+        if (!data) {
+            return serialize_int<int32_t>(-1);
+        }
+        auto size = serialize_int<int32_t>(data->size_bytes());
+        return size + write_fragments(std::move(*data));
+    }
+
     template<typename T, typename Tag>
     uint32_t write(const named_type<T, Tag>& t) {
         return write(t());
@@ -181,6 +266,25 @@ public:
         return write_array(*v, std::forward<ElementWriter>(writer));
     }
 
+    template<typename T, typename ElementWriter>
+    uint32_t write_compact_array(std::vector<T>& v, ElementWriter&& writer) {
+        auto start_size = uint32_t(_out->size_bytes());
+        write_unsigned_varint(v.size() + 1);
+        for (auto& elem : v) {
+            writer(elem, *this);
+        }
+        return _out->size_bytes() - start_size;
+    }
+
+    template<typename T, typename ElementWriter>
+    uint32_t write_compact_nullable_array(
+      std::optional<std::vector<T>>& v, ElementWriter&& writer) {
+        if (!v) {
+            return write_unsigned_varint(0);
+        }
+        return write_compact_array(*v, std::forward<ElementWriter>(writer));
+    }
+
     // wrap a writer in a kafka bytes array object. the writer should return
     // true if writing no bytes should result in the encoding as nullable bytes,
     // and false otherwise.
@@ -193,6 +297,7 @@ public:
     })
     // clang-format on
     uint32_t write_bytes_wrapped(ElementWriter&& writer) {
+        reserve_small(sizeof(int32_t));
         auto ph = _out->reserve(sizeof(int32_t));
         auto start_size = uint32_t(_out->size_bytes());
         auto zero_len_is_null = writer(*this);
@@ -207,7 +312,50 @@ public:
     }
 
 private:
+    /*
+     * The fields written between appended buffers, typically the headers of
+     * the partitions around their record sets, are packed into a chunk shared
+     * by the fragments of the response. Otherwise each of them would start a
+     * fragment sized by the growth policy of iobuf, which is then copied again
+     * when trimmed by the next append. The chunk is released with the
+     * response.
+     */
+    static constexpr size_t arena_size = 8192;
+    static constexpr size_t min_arena_write = 64;
+
+    void reserve_small(size_t n) {
+        if (_out->available_bytes() >= n || n > arena_size / 2) {
+            return;
+        }
+        seal_arena();
+        if (_arena.size() < std::max(n, min_arena_write)) {
+            _arena = ss::temporary_buffer<char>(arena_size);
+        }
+        _arena_view = _arena.get();
+        _out->append_take_ownership(
+          new iobuf::fragment(_arena.share(), iobuf::fragment::empty{}));
+    }
+
+    // ends the view of the chunk at the back of the output, before a buffer
+    // is appended after it
+    void seal_arena() {
+        if (!_arena_view) {
+            return;
+        }
+        if (!_out->empty() && _out->rbegin()->get() == _arena_view) {
+            auto& back = *_out->rbegin();
+            back.trim_capacity();
+            _arena.trim_front(back.size());
+        } else {
+            // filled, the chunk is used up
+            _arena = {};
+        }
+        _arena_view = nullptr;
+    }
+
     iobuf* _out;
+    ss::temporary_buffer<char> _arena;
+    const char* _arena_view{nullptr};
 };
 
 } // namespace kafka
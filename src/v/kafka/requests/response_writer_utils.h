@@ -10,6 +10,7 @@
  */
 
 #pragma once
+#include "bytes/details/io_allocation_size.h"
 #include "kafka/requests/kafka_batch_adapter.h"
 #include "kafka/requests/response_writer.h"
 #include "model/record.h"
@@ -18,8 +19,16 @@
 
 namespace kafka {
 
-inline void
-writer_serialize_batch(response_writer& w, model::record_batch&& batch) {
+/*
+ * Batches with at least this many bytes of records are written to the
+ * response without copying the records. Smaller batches are packed into the
+ * response buffer, which bounds the number of fragments in a response.
+ */
+static constexpr size_t zero_copy_batch_min_size
+  = details::io_allocation_size::ss_max_small_allocation;
+
+inline void writer_serialize_batch_header(
+  response_writer& w, const model::record_batch& batch) {
     /*
      * calculate batch size expected by kafka client.
      *
@@ -53,7 +62,25 @@ writer_serialize_batch(response_writer& w, model::record_batch&& batch) {
     w.write(int16_t(batch.header().producer_epoch));
     w.write(int32_t(batch.header().base_sequence));
     w.write(int32_t(batch.record_count()));
-    w.write_direct(std::move(batch).release_data());
+}
+
+inline void
+writer_serialize_batch(response_writer& w, model::record_batch&& batch) {
+    if (batch.data().size_bytes() < zero_copy_batch_min_size) {
+        writer_serialize_batch_header(w, batch);
+        w.write_direct(std::move(batch).release_data());
+        return;
+    }
+    /*
+     * The records are chained to the response as they were read from the
+     * segment. The header is encoded in a buffer of its own so that the
+     * response does not size its next allocation after the records.
+     */
+    iobuf header;
+    response_writer hw(header);
+    writer_serialize_batch_header(hw, batch);
+    w.write_fragments(std::move(header));
+    w.write_fragments(std::move(batch).release_data());
 }
 
 } // namespace kafka
@@ -21,12 +21,8 @@
 #   path_type_map to override types, it would be more efficient to specify the
 #   same mapping using the field_name_type_map + a whitelist of request types.
 #
-#   - The current version does not handle flexible versions. It will be some
-#   time before we encounter clients requiring this, but in principle this
-#   generator should be extensible (see type maps below). Note that when the
-#   time comes to support flexible versions, there is a filter in the templates
-#   within this file that ignores such fields, and that filter should be
-#   removed.
+#   - Tagged fields of flexible versions are skipped when decoded and never
+#   encoded. None of the tagged fields of the schemas is used by redpanda.
 #
 #   - Handle ignorable fields. Currently we handle nullable fields properly. The
 #   ignorable flag on a field doesn't change the wire protocol, but gives
@@ -184,6 +180,8 @@ entity_type_map = dict(
     groupId=("kafka::group_id", "string"),
     topicName=("model::topic", "string"),
     brokerId=("model::node_id", "int32"),
+    transactionalId=("kafka::transactional_id", "string"),
+    producerId=("kafka::producer_id", "int64"),
 )
 
 # mapping specified as a combination of native type and field name
@@ -194,15 +192,17 @@ field_name_type_map = {
     ("int32", "RebalanceTimeoutMs"): ("std::chrono::milliseconds", None),
 }
 
-# primitive types
+# primitive types: the type, its decoder and nullable decoder, and the same
+# decoders for the compact encoding of flexible versions
 basic_type_map = dict(
-    string=("ss::sstring", "read_string()", "read_nullable_string()"),
-    bytes=("bytes", "read_bytes()"),
-    bool=("bool", "read_bool()"),
-    int8=("int8_t", "read_int8()"),
-    int16=("int16_t", "read_int16()"),
-    int32=("int32_t", "read_int32()"),
-    int64=("int64_t", "read_int64()"),
+    string=("ss::sstring", "read_string()", "read_nullable_string()",
+            "read_compact_string()", "read_compact_nullable_string()"),
+    bytes=("bytes", "read_bytes()", None, "read_compact_bytes()", None),
+    bool=("bool", "read_bool()", None, "read_bool()", None),
+    int8=("int8_t", "read_int8()", None, "read_int8()", None),
+    int16=("int16_t", "read_int16()", None, "read_int16()", None),
+    int32=("int32_t", "read_int32()", None, "read_int32()", None),
+    int64=("int64_t", "read_int64()", None, "read_int64()", None),
 )
 
 # a listing of expected struct types
@@ -272,20 +272,13 @@ class VersionRange:
             max = int(match.group("max"))
             return min, max
 
-    def guard(self):
+    def contains(self, version):
         """
-        Generate the C++ bounds check.
+        Whether the range holds the version, checked when the code of the
+        version is generated.
         """
-        if self.min == self.max:
-            cond = f"version == api_version({self.min})"
-        else:
-            cond = []
-            if self.min > 0:
-                cond.append(f"version >= api_version({self.min})")
-            if self.max != None:
-                cond.append(f"version <= api_version({self.max})")
-            cond = " && ".join(cond)
-        return cond
+        return self.min <= version and (self.max is None
+                                        or version <= self.max)
 
     def __repr__(self):
         max = "+inf)" if self.max is None else f"{self.max}]"
@@ -365,6 +358,12 @@ class StructType(FieldType):
         """Format string for output operator"""
         return " ".join(map(lambda f: f"{f.name}={{}}", self.fields))
 
+    def used(self, version):
+        """
+        Whether any field is on the wire in the version.
+        """
+        return any(f.inline(version) for f in self.fields)
+
     def structs(self):
         """
         Return all struct types reachable from this struct.
@@ -399,6 +398,9 @@ class Field:
         self._nullable_versions = self._field.get("nullableVersions", None)
         if self._nullable_versions is not None:
             self._nullable_versions = VersionRange(self._nullable_versions)
+        self._tagged_versions = self._field.get("taggedVersions", None)
+        if self._tagged_versions is not None:
+            self._tagged_versions = VersionRange(self._tagged_versions)
         self._default_value = self._field.get("default", "")
         if self._default_value == "null":
             self._default_value = ""
@@ -418,6 +420,15 @@ class Field:
     def versions(self):
         return self._versions
 
+    def inline(self, version):
+        """
+        Whether the field is in the version, outside of the tagged fields.
+        """
+        if not self._versions.contains(version):
+            return False
+        return self._tagged_versions is None or \
+            not self._tagged_versions.contains(version)
+
     def default_value(self):
         return self._default_value
 
@@ -494,8 +505,7 @@ class Field:
 
         raise Exception(f"No decoder for {(tn, fn)}")
 
-    @property
-    def decoder(self):
+    def decoder(self, flex):
         """
         There are two cases:
 
@@ -510,13 +520,15 @@ class Field:
                 }
         """
         plain_decoder, named_type = self._redpanda_decoder()
+        # the decoders of flexible versions follow the others
+        base = 3 if flex else 1
         if self.is_array:
             # array fields never contain nullable types. so if this is an array
             # field then choose the non-nullable decoder for its element type.
-            return plain_decoder[1], named_type
+            return plain_decoder[base], named_type
         if self.nullable():
-            return plain_decoder[2], named_type
-        return plain_decoder[1], named_type
+            return plain_decoder[base + 1], named_type
+        return plain_decoder[base], named_type
 
     @property
     def is_array(self):
@@ -611,58 +623,55 @@ SOURCE_TEMPLATE = """
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
-{% macro version_guard(field) %}
-{%- set cond = field.versions().guard() %}
-{%- if cond %}
-if ({{ cond }}) {
-{{- caller() | indent }}
-}
-{%- else %}
-{{- caller() }}
-{%- endif %}
-{%- endmacro %}
-
-{% macro field_encoder(field, obj) %}
+{% macro field_encoder(field, obj, version, flex) %}
 {%- if obj %}
 {%- set fname = obj + "." + field.name %}
 {%- else %}
 {%- set fname = field.name %}
 {%- endif %}
+{%- set compact = "compact_" if flex else "" %}
 {%- if field.is_array %}
 {%- if field.nullable() %}
-writer.write_nullable_array({{ fname }}, [version]({{ field.value_type }}& v, response_writer& writer) {
+writer.write_{{ compact }}nullable_array({{ fname }}, []({{ field.value_type }}& v, response_writer& writer) {
 {%- else %}
-writer.write_array({{ fname }}, [version]({{ field.value_type }}& v, response_writer& writer) {
+writer.write_{{ compact }}array({{ fname }}, []({{ field.value_type }}& v, response_writer& writer) {
 {%- endif %}
 {%- if field.type().value_type().is_struct %}
-{{- struct_serde(field.type().value_type(), field_encoder, "v") | indent }}
+{{- struct_serde(field.type().value_type(), "encode", "v", version, flex) | indent }}
+{%- else %}
+{%- if flex %}
+    writer.write_compact(v);
 {%- else %}
     writer.write(v);
 {%- endif %}
+{%- endif %}
 });
+{%- elif flex %}
+writer.write_compact({{ fname }});
 {%- else %}
 writer.write({{ fname }});
 {%- endif %}
 {%- endmacro %}
 
-{% macro field_decoder(field, obj) %}
+{% macro field_decoder(field, obj, version, flex) %}
 {%- if obj %}
 {%- set fname = obj + "." + field.name %}
 {%- else %}
 {%- set fname = field.name %}
 {%- endif %}
+{%- set compact = "compact_" if flex else "" %}
 {%- if field.is_array %}
 {%- if field.nullable() %}
-{{ fname }} = reader.read_nullable_array([version](request_reader& reader) {
+{{ fname }} = reader.read_{{ compact }}nullable_array([](request_reader& reader) {
 {%- else %}
-{{ fname }} = reader.read_array([version](request_reader& reader) {
+{{ fname }} = reader.read_{{ compact }}array([](request_reader& reader) {
 {%- endif %}
 {%- if field.type().value_type().is_struct %}
     {{ field.type().value_type().name }} v;
-{{- struct_serde(field.type().value_type(), field_decoder, "v") | indent }}
+{{- struct_serde(field.type().value_type(), "decode", "v", version, flex) | indent }}
     return v;
 {%- else %}
-{%- set decoder, named_type = field.decoder %}
+{%- set decoder, named_type = field.decoder(flex) %}
 {%- if named_type == None %}
     return reader.{{ decoder }};
 {%- elif field.nullable() %}
@@ -679,7 +688,7 @@ writer.write({{ fname }});
 {%- endif %}
 });
 {%- else %}
-{%- set decoder, named_type = field.decoder %}
+{%- set decoder, named_type = field.decoder(flex) %}
 {%- if named_type == None %}
 {{ fname }} = reader.{{ decoder }};
 {%- elif field.nullable() %}
@@ -695,41 +704,79 @@ writer.write({{ fname }});
 {%- endif %}
 {%- endmacro %}
 
-{% macro struct_serde(struct, field_serde, obj = "") %}
+{#
+ # the fields of a struct in a single version. the fields missing from the
+ # version are left out when the code is generated, and so are the tagged
+ # fields, which are never written and skipped when read.
+ #}
+{% macro struct_serde(struct, op, obj, version, flex) %}
 {%- for field in struct.fields %}
-{%- call version_guard(field) %}
-{{- field_serde(field, obj) }}
-{%- endcall %}
+{%- if field.inline(version) %}
+{%- if op == "encode" %}
+{{- field_encoder(field, obj, version, flex) }}
+{%- else %}
+{{- field_decoder(field, obj, version, flex) }}
+{%- endif %}
+{%- endif %}
 {%- endfor %}
+{%- if flex %}
+{%- if op == "encode" %}
+writer.write_tagged_fields();
+{%- else %}
+reader.skip_tagged_fields();
+{%- endif %}
+{%- endif %}
 {%- endmacro %}
 
 namespace kafka {
 
-{%- if struct.fields %}
+namespace {
+{% for version in versions %}
+{%- set flex = flexible.contains(version) if flexible else False %}
+{%- set used = struct.used(version) or flex %}
+void encode_v{{ version }}(
+  {% if not used %}[[maybe_unused]] {% endif %}{{ struct.name }}& m,
+  {% if not used %}[[maybe_unused]] {% endif %}response_writer& writer) {
+{{- struct_serde(struct, "encode", "m", version, flex) | indent }}
+}
+
+void decode_v{{ version }}(
+  {% if not used %}[[maybe_unused]] {% endif %}{{ struct.name }}& m,
+  {% if not used %}[[maybe_unused]] {% endif %}request_reader& reader) {
+{{- struct_serde(struct, "decode", "m", version, flex) | indent }}
+}
+{% endfor %}
+} // namespace
+
+{#
+ # the versions are specialized when the code is generated, a version past the
+ # last one of the schema is handled as the last one.
+ #}
+{% macro dispatch(op, arg) %}
+    switch (version()) {
+{%- for version in versions[:-1] %}
+    case {{ version }}:
+        return {{ op }}_v{{ version }}(*this, {{ arg }});
+{%- endfor %}
+    default:
+        return {{ op }}_v{{ versions[-1] }}(*this, {{ arg }});
+    }
+{%- endmacro %}
+
 void {{ struct.name }}::encode(response_writer& writer, api_version version) {
-{{- struct_serde(struct, field_encoder) | indent }}
+{{- dispatch("encode", "writer") }}
 }
 
 {%- if op_type == "request" %}
 void {{ struct.name }}::decode(request_reader& reader, api_version version) {
-{{- struct_serde(struct, field_decoder) | indent }}
+{{- dispatch("decode", "reader") }}
 }
 {%- else %}
 void {{ struct.name }}::decode(iobuf buf, api_version version) {
     request_reader reader(std::move(buf));
-
-{{- struct_serde(struct, field_decoder) | indent }}
+{{ dispatch("decode", "reader") }}
 }
 {%- endif %}
-{%- else %}
-{%- if op_type == "request" %}
-void {{ struct.name }}::encode(response_writer&, api_version) {}
-void {{ struct.name }}::decode(request_reader&, api_version) {}
-{%- else %}
-void {{ struct.name }}::encode(const request_context&, response&) {}
-void {{ struct.name }}::decode(iobuf, api_version) {}
-{%- endif %}
-{%- endif %}
 
 {% set structs = struct.structs() + [struct] %}
 {% for struct in structs %}
@@ -910,6 +957,13 @@ if __name__ == "__main__":
     # request or response
     op_type = msg["type"]
 
+    # the code of each version is generated on its own
+    valid_versions = VersionRange(msg["validVersions"])
+    versions = list(range(valid_versions.min, valid_versions.max + 1))
+    flexible = None
+    if msg["flexibleVersions"] != "none":
+        flexible = VersionRange(msg["flexibleVersions"])
+
     with open(hdr, 'w') as f:
         f.write(
             jinja2.Template(HEADER_TEMPLATE).render(
@@ -921,4 +975,6 @@ if __name__ == "__main__":
         f.write(
             jinja2.Template(SOURCE_TEMPLATE).render(struct=struct,
                                                     header=hdr.name,
-                                                    op_type=op_type))
+                                                    op_type=op_type,
+                                                    versions=versions,
+                                                    flexible=flexible))
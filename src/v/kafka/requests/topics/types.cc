@@ -93,6 +93,14 @@ cluster::topic_configuration to_cluster_type(const creatable_topic& t) {
       config_entries, "retention.bytes");
     cfg.retention_duration = get_tristate_value<std::chrono::milliseconds>(
       config_entries, "retention.ms");
+    if (auto ms = get_config_value<int64_t>(config_entries, "flush.ms"); ms) {
+        cfg.flush_ms = std::chrono::milliseconds(*ms);
+    }
+    cfg.flush_bytes = get_config_value<size_t>(config_entries, "flush.bytes");
+    if (auto it = config_entries.find("redpanda.storage.type");
+        it != config_entries.end()) {
+        cfg.in_memory = it->second == "memory";
+    }
 
     return cfg;
 }
@@ -86,4 +86,17 @@ struct unsupported_configuration_entries {
     }
 };
 
+struct storage_type_must_be_valid {
+    static constexpr error_code ec = error_code::invalid_config;
+    static constexpr const char* error_message
+      = "redpanda.storage.type must be either memory or disk";
+
+    static bool is_valid(const creatable_topic& c) {
+        auto config_entries = config_map(c.configs);
+        auto it = config_entries.find("redpanda.storage.type");
+        return it == config_entries.end() || it->second == "memory"
+               || it->second == "disk";
+    }
+};
+
 } // namespace kafka
@@ -0,0 +1,326 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/requests/fetch_request.h"
+#include "kafka/requests/kafka_batch_adapter.h"
+#include "kafka/requests/metadata_request.h"
+#include "kafka/requests/offset_commit_request.h"
+#include "kafka/requests/produce_request.h"
+#include "kafka/requests/request_reader.h"
+#include "kafka/requests/response_writer.h"
+#include "kafka/requests/response_writer_utils.h"
+#include "model/record_batch_types.h"
+#include "random/generators.h"
+#include "storage/record_batch_builder.h"
+
+#include <seastar/core/reactor.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <fmt/format.h>
+
+using namespace kafka; // NOLINT
+
+// the messages of each test have a single topic with a constant number of
+// partitions, so that the runs of a test are of the same size
+static const model::topic bench_topic("bench-topic");
+static constexpr size_t record_size = 1024;
+
+static iobuf make_value(size_t size) {
+    iobuf value;
+    auto s = random_generators::gen_alphanum_string(size);
+    value.append(s.data(), s.size());
+    return value;
+}
+
+static model::record_batch make_batch(size_t records) {
+    storage::record_batch_builder builder(
+      model::well_known_record_batch_types[1], model::offset(0));
+    for (size_t i = 0; i < records; ++i) {
+        builder.add_raw_kv(iobuf{}, make_value(record_size));
+    }
+    return std::move(builder).build();
+}
+
+static fetch_request make_fetch_request(size_t partitions) {
+    fetch_request r;
+    r.replica_id = model::node_id(-1);
+    r.max_wait_time = std::chrono::milliseconds(500);
+    r.min_bytes = 1;
+    r.max_bytes = 50 * 1024 * 1024;
+    r.session_id = 0;
+    r.session_epoch = -1;
+    fetch_request::topic t{.name = bench_topic};
+    for (size_t i = 0; i < partitions; ++i) {
+        t.partitions.push_back(fetch_request::partition{
+          .id = model::partition_id(i),
+          .current_leader_epoch = 1,
+          .fetch_offset = model::offset(1000),
+          .log_start_offset = model::offset(-1),
+          .partition_max_bytes = 1024 * 1024,
+        });
+    }
+    r.topics.push_back(std::move(t));
+    return r;
+}
+
+static produce_request make_produce_request(size_t partitions) {
+    produce_request::topic t{.name = bench_topic};
+    for (size_t i = 0; i < partitions; ++i) {
+        produce_request::partition p{.id = model::partition_id(i)};
+        p.adapter.batch = make_batch(4);
+        t.partitions.push_back(std::move(p));
+    }
+    std::vector<produce_request::topic> topics;
+    topics.push_back(std::move(t));
+    produce_request r(std::nullopt, -1, std::move(topics));
+    r.timeout = std::chrono::milliseconds(1000);
+    return r;
+}
+
+static metadata_response make_metadata_response(size_t partitions) {
+    metadata_response r;
+    for (int32_t n = 0; n < 3; ++n) {
+        r.brokers.push_back(metadata_response::broker{
+          .node_id = model::node_id(n),
+          .host = fmt::format("broker-{}.local", n),
+          .port = 9092,
+        });
+    }
+    r.cluster_id = "bench-cluster";
+    r.controller_id = model::node_id(0);
+    metadata_response::topic t{
+      .err_code = error_code::none,
+      .name = bench_topic,
+    };
+    for (size_t i = 0; i < partitions; ++i) {
+        const auto leader = model::node_id(i % 3);
+        std::vector<model::node_id> replicas{
+          model::node_id(0), model::node_id(1), model::node_id(2)};
+        t.partitions.push_back(metadata_response::partition{
+          .err_code = error_code::none,
+          .index = model::partition_id(i),
+          .leader = leader,
+          .leader_epoch = 1,
+          .replica_nodes = replicas,
+          .isr_nodes = replicas,
+        });
+    }
+    r.topics.push_back(std::move(t));
+    return r;
+}
+
+static offset_commit_request make_offset_commit_request(size_t partitions) {
+    offset_commit_request r;
+    r.data.group_id = kafka::group_id("bench-group");
+    r.data.generation_id = kafka::generation_id(1);
+    r.data.member_id = kafka::member_id("bench-member");
+    offset_commit_request_topic t{.name = bench_topic};
+    for (size_t i = 0; i < partitions; ++i) {
+        t.partitions.push_back(offset_commit_request_partition{
+          .partition_index = model::partition_id(i),
+          .committed_offset = model::offset(1000),
+        });
+    }
+    r.data.topics.push_back(std::move(t));
+    return r;
+}
+
+template<typename T>
+static void encode_to(response_writer& w, T& msg, api_version v) {
+    msg.encode(w, v);
+}
+
+static void
+encode_to(response_writer& w, metadata_response& msg, api_version v) {
+    msg.encode(w, v, false);
+}
+
+template<typename T>
+static iobuf encode_message(T& msg, api_version v) {
+    iobuf out;
+    response_writer w(out);
+    encode_to(w, msg, v);
+    return out;
+}
+
+static fetch_request decode_fetch_request(iobuf buf, api_version v) {
+    request_reader reader(std::move(buf));
+    fetch_request r;
+    r.decode(reader, v);
+    return r;
+}
+
+static produce_request decode_produce_request(iobuf buf, api_version v) {
+    request_reader reader(std::move(buf));
+    return produce_request(reader, v);
+}
+
+static metadata_response decode_metadata_response(iobuf buf, api_version v) {
+    metadata_response r;
+    r.decode(std::move(buf), v);
+    return r;
+}
+
+static offset_commit_request
+decode_offset_commit_request(iobuf buf, api_version v) {
+    request_reader reader(std::move(buf));
+    offset_commit_request r;
+    r.decode(reader, v);
+    return r;
+}
+
+template<typename T>
+static void bench_encode(T msg, api_version v) {
+    perf_tests::start_measuring_time();
+    auto out = encode_message(msg, v);
+    perf_tests::do_not_optimize(out);
+    perf_tests::stop_measuring_time();
+}
+
+template<typename T, typename Decode>
+static void bench_decode(T msg, api_version v, Decode decode) {
+    auto buf = encode_message(msg, v);
+    perf_tests::start_measuring_time();
+    auto decoded = decode(std::move(buf), v);
+    perf_tests::do_not_optimize(decoded);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(fetch_request, encode_1) {
+    bench_encode(make_fetch_request(1), fetch_api::max_supported);
+}
+PERF_TEST(fetch_request, encode_100) {
+    bench_encode(make_fetch_request(100), fetch_api::max_supported);
+}
+PERF_TEST(fetch_request, encode_1000) {
+    bench_encode(make_fetch_request(1000), fetch_api::max_supported);
+}
+PERF_TEST(fetch_request, decode_1) {
+    bench_decode(
+      make_fetch_request(1), fetch_api::max_supported, decode_fetch_request);
+}
+PERF_TEST(fetch_request, decode_100) {
+    bench_decode(
+      make_fetch_request(100), fetch_api::max_supported, decode_fetch_request);
+}
+PERF_TEST(fetch_request, decode_1000) {
+    bench_decode(
+      make_fetch_request(1000), fetch_api::max_supported, decode_fetch_request);
+}
+
+// every partition has a batch of 4 records of 1KiB. the decoding includes the
+// validation of the batches by the batch adapter
+PERF_TEST(produce_request, encode_1) {
+    bench_encode(make_produce_request(1), produce_api::max_supported);
+}
+PERF_TEST(produce_request, encode_100) {
+    bench_encode(make_produce_request(100), produce_api::max_supported);
+}
+PERF_TEST(produce_request, decode_1) {
+    bench_decode(
+      make_produce_request(1),
+      produce_api::max_supported,
+      decode_produce_request);
+}
+PERF_TEST(produce_request, decode_100) {
+    bench_decode(
+      make_produce_request(100),
+      produce_api::max_supported,
+      decode_produce_request);
+}
+
+PERF_TEST(metadata_response, encode_1) {
+    bench_encode(make_metadata_response(1), metadata_api::max_supported);
+}
+PERF_TEST(metadata_response, encode_100) {
+    bench_encode(make_metadata_response(100), metadata_api::max_supported);
+}
+PERF_TEST(metadata_response, encode_1000) {
+    bench_encode(make_metadata_response(1000), metadata_api::max_supported);
+}
+PERF_TEST(metadata_response, decode_1) {
+    bench_decode(
+      make_metadata_response(1),
+      metadata_api::max_supported,
+      decode_metadata_response);
+}
+PERF_TEST(metadata_response, decode_100) {
+    bench_decode(
+      make_metadata_response(100),
+      metadata_api::max_supported,
+      decode_metadata_response);
+}
+PERF_TEST(metadata_response, decode_1000) {
+    bench_decode(
+      make_metadata_response(1000),
+      metadata_api::max_supported,
+      decode_metadata_response);
+}
+
+PERF_TEST(offset_commit_request, encode_1) {
+    bench_encode(
+      make_offset_commit_request(1), offset_commit_api::max_supported);
+}
+PERF_TEST(offset_commit_request, encode_100) {
+    bench_encode(
+      make_offset_commit_request(100), offset_commit_api::max_supported);
+}
+PERF_TEST(offset_commit_request, encode_1000) {
+    bench_encode(
+      make_offset_commit_request(1000), offset_commit_api::max_supported);
+}
+PERF_TEST(offset_commit_request, decode_1) {
+    bench_decode(
+      make_offset_commit_request(1),
+      offset_commit_api::max_supported,
+      decode_offset_commit_request);
+}
+PERF_TEST(offset_commit_request, decode_100) {
+    bench_decode(
+      make_offset_commit_request(100),
+      offset_commit_api::max_supported,
+      decode_offset_commit_request);
+}
+PERF_TEST(offset_commit_request, decode_1000) {
+    bench_decode(
+      make_offset_commit_request(1000),
+      offset_commit_api::max_supported,
+      decode_offset_commit_request);
+}
+
+// each run validates 1MiB of batches of the size as read off the wire by the
+// produce path, so that the time of a run is the time per MiB
+static constexpr size_t adapted_bytes = 1024 * 1024;
+
+static void adapt_batches(size_t batch_size) {
+    std::vector<iobuf> wire;
+    for (size_t n = 0; n < adapted_bytes; n += batch_size) {
+        iobuf buf;
+        response_writer w(buf);
+        writer_serialize_batch(w, make_batch(batch_size / record_size));
+        wire.push_back(std::move(buf));
+    }
+    std::vector<kafka_batch_adapter> adapters(wire.size());
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < wire.size(); ++i) {
+        adapters[i].adapt(std::move(wire[i]));
+    }
+    perf_tests::do_not_optimize(adapters);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(kafka_batch_adapter, adapt_1mb_of_4k_batches) {
+    adapt_batches(4 * 1024);
+}
+PERF_TEST(kafka_batch_adapter, adapt_1mb_of_64k_batches) {
+    adapt_batches(64 * 1024);
+}
+PERF_TEST(kafka_batch_adapter, adapt_1mb_of_1m_batches) {
+    adapt_batches(1024 * 1024);
+}
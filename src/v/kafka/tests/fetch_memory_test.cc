@@ -0,0 +1,57 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE fetch_memory
+#include "kafka/requests/fetch_memory.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace kafka; // NOLINT
+
+BOOST_AUTO_TEST_CASE(grants_shrink_under_pressure) {
+    fetch_memory_budget budget(10_MiB);
+    auto a = budget.grant(8_MiB);
+    BOOST_REQUIRE_EQUAL(a.count(), 8_MiB);
+    BOOST_REQUIRE_EQUAL(budget.throttled_bytes(), uint64_t(0));
+
+    auto b = budget.grant(8_MiB);
+    BOOST_REQUIRE_EQUAL(b.count(), 2_MiB);
+    BOOST_REQUIRE_EQUAL(budget.throttled_bytes(), 6_MiB);
+
+    // an exhausted budget still grants the minimum
+    auto c = budget.grant(8_MiB);
+    BOOST_REQUIRE_EQUAL(c.count(), fetch_memory_budget::min_grant);
+    BOOST_REQUIRE_EQUAL(budget.available_bytes(), size_t(0));
+
+    // small fetches are granted what they want
+    auto d = budget.grant(1_KiB);
+    BOOST_REQUIRE_EQUAL(d.count(), 1_KiB);
+}
+
+BOOST_AUTO_TEST_CASE(released_once_written) {
+    fetch_memory_budget budget(10_MiB);
+    {
+        auto a = budget.grant(10_MiB);
+        BOOST_REQUIRE_EQUAL(budget.available_bytes(), size_t(0));
+    }
+    BOOST_REQUIRE_EQUAL(budget.available_bytes(), 10_MiB);
+}
+
+BOOST_AUTO_TEST_CASE(resize_to_bytes_read) {
+    fetch_memory_budget budget(10_MiB);
+    auto a = budget.grant(4_MiB);
+    budget.resize(a, 1_MiB);
+    BOOST_REQUIRE_EQUAL(a.count(), 1_MiB);
+    BOOST_REQUIRE_EQUAL(budget.available_bytes(), 9_MiB);
+
+    // the first batch of a response may exceed the grant
+    budget.resize(a, 3_MiB);
+    BOOST_REQUIRE_EQUAL(a.count(), 3_MiB);
+    BOOST_REQUIRE_EQUAL(budget.available_bytes(), 7_MiB);
+}
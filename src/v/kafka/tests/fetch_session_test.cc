@@ -0,0 +1,203 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE fetch_session
+#include "kafka/requests/fetch_session.h"
+#include "model/fundamental.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace kafka; // NOLINT
+
+static fetch_request make_request(
+  fetch_session_id id,
+  fetch_session_epoch epoch,
+  std::vector<fetch_request::topic> topics,
+  std::vector<fetch_request::forgotten_topic> forgotten = {}) {
+    fetch_request req;
+    req.session_id = id();
+    req.session_epoch = epoch();
+    req.topics = std::move(topics);
+    req.forgotten_topics = std::move(forgotten);
+    return req;
+}
+
+static fetch_request::topic make_topic(
+  ss::sstring name, std::vector<std::pair<int32_t, int64_t>> partitions) {
+    fetch_request::topic t{.name = model::topic(std::move(name))};
+    for (auto [id, offset] : partitions) {
+        t.partitions.push_back(fetch_request::partition{
+          .id = model::partition_id(id),
+          .fetch_offset = model::offset(offset),
+          .partition_max_bytes = 1024,
+        });
+    }
+    return t;
+}
+
+static fetch_response::partition_response make_partition_response(
+  int32_t id, int64_t high_watermark, size_t data_size = 0) {
+    iobuf data;
+    if (data_size) {
+        data.append(ss::sstring(data_size, 'x').data(), data_size);
+    }
+    return fetch_response::partition_response{
+      .id = model::partition_id(id),
+      .error = error_code::none,
+      .high_watermark = model::offset(high_watermark),
+      .last_stable_offset = model::offset(high_watermark),
+      .record_set = std::move(data),
+    };
+}
+
+BOOST_AUTO_TEST_CASE(sessionless_fetch) {
+    fetch_session_cache cache;
+    auto ctx = cache.maybe_get_session(make_request(
+      invalid_fetch_session_id,
+      final_fetch_session_epoch,
+      {make_topic("a", {{0, 0}})}));
+    BOOST_REQUIRE(!ctx.session);
+    BOOST_REQUIRE(!ctx.incremental);
+    BOOST_REQUIRE(ctx.error == error_code::none);
+    BOOST_REQUIRE(cache.size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(create_update_and_close_session) {
+    fetch_session_cache cache;
+    auto ctx = cache.maybe_get_session(make_request(
+      invalid_fetch_session_id,
+      initial_fetch_session_epoch,
+      {make_topic("a", {{0, 0}, {1, 0}}), make_topic("b", {{0, 0}})}));
+    BOOST_REQUIRE(ctx.session);
+    BOOST_REQUIRE(!ctx.incremental);
+    BOOST_REQUIRE(ctx.session->size() == 3);
+    BOOST_REQUIRE(ctx.session->epoch() == fetch_session_epoch(1));
+    auto id = ctx.session->id();
+
+    // update a-1, add b-1 and forget a-0
+    auto inc = cache.maybe_get_session(make_request(
+      id,
+      fetch_session_epoch(1),
+      {make_topic("a", {{1, 10}}), make_topic("b", {{1, 0}})},
+      {fetch_request::forgotten_topic{
+        .name = model::topic("a"), .partitions = {0}}}));
+    BOOST_REQUIRE(inc.session);
+    BOOST_REQUIRE(inc.incremental);
+    BOOST_REQUIRE(inc.session->epoch() == fetch_session_epoch(2));
+
+    auto topics = inc.session->topics();
+    BOOST_REQUIRE(topics.size() == 2);
+    BOOST_REQUIRE(topics[0].name == model::topic("a"));
+    BOOST_REQUIRE(topics[0].partitions.size() == 1);
+    BOOST_REQUIRE(topics[0].partitions[0].id == model::partition_id(1));
+    BOOST_REQUIRE(topics[0].partitions[0].fetch_offset == model::offset(10));
+    BOOST_REQUIRE(topics[1].name == model::topic("b"));
+    BOOST_REQUIRE(topics[1].partitions.size() == 2);
+
+    // stale epoch is rejected
+    auto stale = cache.maybe_get_session(
+      make_request(id, fetch_session_epoch(1), {}));
+    BOOST_REQUIRE(stale.error == error_code::invalid_fetch_session_epoch);
+
+    // close the session
+    auto closed = cache.maybe_get_session(
+      make_request(id, final_fetch_session_epoch, {}));
+    BOOST_REQUIRE(!closed.session);
+    BOOST_REQUIRE(cache.size() == 0);
+
+    auto missing = cache.maybe_get_session(
+      make_request(id, fetch_session_epoch(2), {}));
+    BOOST_REQUIRE(missing.error == error_code::fetch_session_id_not_found);
+}
+
+BOOST_AUTO_TEST_CASE(incremental_response_skips_unchanged_partitions) {
+    fetch_session_cache cache;
+    auto ctx = cache.maybe_get_session(make_request(
+      invalid_fetch_session_id,
+      initial_fetch_session_epoch,
+      {make_topic("a", {{0, 0}, {1, 0}}), make_topic("b", {{0, 0}})}));
+
+    auto make_response = [](size_t a0, int64_t a1_hw) {
+        fetch_response resp;
+        resp.partitions.emplace_back(model::topic("a"));
+        resp.partitions.back().responses.push_back(
+          make_partition_response(0, 10, a0));
+        resp.partitions.back().responses.push_back(
+          make_partition_response(1, a1_hw));
+        resp.partitions.emplace_back(model::topic("b"));
+        resp.partitions.back().responses.push_back(
+          make_partition_response(0, 10));
+        return resp;
+    };
+
+    // full responses are never filtered
+    auto full = make_response(0, 10);
+    ctx.session->update_response(full, false);
+    BOOST_REQUIRE(full.partitions.size() == 2);
+    BOOST_REQUIRE(full.partitions[0].responses.size() == 2);
+
+    // nothing changed
+    auto none = make_response(0, 10);
+    ctx.session->update_response(none, true);
+    BOOST_REQUIRE(none.partitions.empty());
+
+    // a-0 has data, a-1 high watermark moved, b-0 unchanged
+    auto some = make_response(100, 11);
+    ctx.session->update_response(some, true);
+    BOOST_REQUIRE(some.partitions.size() == 1);
+    BOOST_REQUIRE(some.partitions[0].name == model::topic("a"));
+    BOOST_REQUIRE(some.partitions[0].responses.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(session_cache_is_bounded) {
+    fetch_session_cache cache;
+    for (size_t i = 0; i < fetch_session_cache::max_sessions * 2; ++i) {
+        auto ctx = cache.maybe_get_session(make_request(
+          invalid_fetch_session_id,
+          initial_fetch_session_epoch,
+          {make_topic("a", {{0, 0}})}));
+        BOOST_REQUIRE(ctx.session);
+    }
+    BOOST_REQUIRE(cache.size() == fetch_session_cache::max_sessions);
+}
+
+BOOST_AUTO_TEST_CASE(partitions_served_move_to_the_end) {
+    fetch_session_cache cache;
+    auto ctx = cache.maybe_get_session(make_request(
+      invalid_fetch_session_id,
+      initial_fetch_session_epoch,
+      {make_topic("a", {{0, 0}, {1, 0}}), make_topic("b", {{0, 0}})}));
+
+    // a-0 returned data, the others did not
+    fetch_response resp;
+    resp.partitions.emplace_back(model::topic("a"));
+    resp.partitions.back().responses.push_back(
+      make_partition_response(0, 10, 100));
+    resp.partitions.back().responses.push_back(make_partition_response(1, 0));
+    resp.partitions.emplace_back(model::topic("b"));
+    resp.partitions.back().responses.push_back(make_partition_response(0, 0));
+    ctx.session->update_response(resp, false);
+
+    auto topics = ctx.session->topics();
+    BOOST_REQUIRE(topics.size() == 3);
+    BOOST_REQUIRE(topics[0].name == model::topic("a"));
+    BOOST_REQUIRE(topics[0].partitions[0].id == model::partition_id(1));
+    BOOST_REQUIRE(topics[1].name == model::topic("b"));
+    BOOST_REQUIRE(topics[2].name == model::topic("a"));
+    BOOST_REQUIRE(topics[2].partitions[0].id == model::partition_id(0));
+}
+
+BOOST_AUTO_TEST_CASE(sessionless_start_rotates) {
+    fetch_session_cache cache;
+    BOOST_REQUIRE(cache.next_sessionless_start(3) == 0);
+    BOOST_REQUIRE(cache.next_sessionless_start(3) == 1);
+    BOOST_REQUIRE(cache.next_sessionless_start(3) == 2);
+    BOOST_REQUIRE(cache.next_sessionless_start(3) == 0);
+    BOOST_REQUIRE(cache.next_sessionless_start(0) == 0);
+}
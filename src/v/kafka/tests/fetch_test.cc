@@ -9,10 +9,14 @@
 
 #include "kafka/requests/fetch_request.h"
 #include "model/fundamental.h"
+#include "model/record_batch_reader.h"
+#include "model/timeout_clock.h"
 #include "redpanda/tests/fixture.h"
 #include "resource_mgmt/io_priority.h"
+#include "storage/tests/utils/random_batch.h"
 #include "test_utils/async.h"
 
+#include <seastar/core/sleep.hh>
 #include <seastar/core/smp.hh>
 
 #include <chrono>
@@ -159,7 +163,8 @@ static kafka::request_context make_request_context(application& app) {
       app.group_router.local(),
       app.shard_table.local(),
       app.partition_manager,
-      app.coordinator_ntp_mapper);
+      app.coordinator_ntp_mapper,
+      nullptr);
 
     iobuf buf;
     kafka::fetch_request request;
@@ -176,7 +181,8 @@ static kafka::request_context make_request_context(application& app) {
       app.group_router.local(),
       app.shard_table.local(),
       app.partition_manager,
-      app.coordinator_ntp_mapper);
+      app.coordinator_ntp_mapper,
+      nullptr);
 }
 
 // TODO: when we have a more precise log builder tool we can make these finer
@@ -281,3 +287,226 @@ FIXTURE_TEST(fetch_one, redpanda_thread_fixture) {
           resp.partitions[0].responses[0].record_set->size_bytes() > 0);
     }
 }
+
+FIXTURE_TEST(fetch_with_rack_id_from_leader, redpanda_thread_fixture) {
+    /*
+     * the only replica is the leader, which serves the reads of the clients
+     * of any rack rather than sending them elsewhere
+     */
+    model::topic topic("foo");
+    model::partition_id pid(0);
+    auto ntp = make_default_ntp(topic, pid);
+    auto log_config = make_default_config();
+    {
+        using namespace storage;
+        storage::disk_log_builder builder(log_config);
+        storage::ntp_config ntp_cfg(
+          ntp, log_config.base_dir, nullptr, storage::ntp_config::ntp_id(2));
+        builder | start(std::move(ntp_cfg)) | add_segment(model::offset(0))
+          | add_random_batch(model::offset(0), 10, maybe_compress_batches::no)
+          | stop();
+    }
+    wait_for_controller_leadership().get0();
+
+    add_topic(model::topic_namespace_view(ntp)).get();
+    auto shard = app.shard_table.local().shard_for(ntp);
+
+    tests::cooperative_spin_wait_with_timeout(10s, [this, shard, ntp] {
+        return app.partition_manager.invoke_on(
+          *shard, [ntp](cluster::partition_manager& mgr) {
+              auto partition = mgr.get(ntp);
+              return partition
+                     && partition->committed_offset() >= model::offset(1);
+          });
+    }).get();
+
+    kafka::fetch_request req;
+    req.replica_id = model::node_id(-1);
+    req.max_bytes = std::numeric_limits<int32_t>::max();
+    req.min_bytes = 1;
+    req.max_wait_time = std::chrono::milliseconds(0);
+    req.rack_id = "rack-a";
+    req.topics = {{
+      .name = topic,
+      .partitions = {{
+        .id = pid,
+        .fetch_offset = model::offset(0),
+      }},
+    }};
+
+    auto client = make_kafka_client().get0();
+    client.connect().get();
+    auto resp = client.dispatch(req, kafka::api_version(11)).get0();
+    client.stop().then([&client] { client.shutdown(); }).get();
+
+    BOOST_REQUIRE(resp.partitions.size() == 1);
+    BOOST_REQUIRE(resp.partitions[0].responses.size() == 1);
+    const auto& r = resp.partitions[0].responses[0];
+    BOOST_REQUIRE(r.error == kafka::error_code::none);
+    BOOST_REQUIRE(r.preferred_read_replica == model::node_id(-1));
+    BOOST_REQUIRE(r.record_set);
+    BOOST_REQUIRE(r.record_set->size_bytes() > 0);
+}
+
+FIXTURE_TEST(fetch_multi_partitions_in_request_order, redpanda_thread_fixture) {
+    /*
+     * reads are dispatched to their home shards concurrently, but the response
+     * must contain the partitions in the same order as the request
+     */
+    std::vector<model::topic> topics{
+      model::topic("foo"), model::topic("bar"), model::topic("baz")};
+    auto log_config = make_default_config();
+    for (auto& topic : topics) {
+        using namespace storage;
+        auto ntp = make_default_ntp(topic, model::partition_id(0));
+        storage::disk_log_builder builder(log_config);
+        storage::ntp_config ntp_cfg(
+          ntp, log_config.base_dir, nullptr, storage::ntp_config::ntp_id(2));
+        builder | start(std::move(ntp_cfg)) | add_segment(model::offset(0))
+          | add_random_batch(model::offset(0), 10, maybe_compress_batches::yes)
+          | stop();
+    }
+    wait_for_controller_leadership().get0();
+
+    for (auto& topic : topics) {
+        auto ntp = make_default_ntp(topic, model::partition_id(0));
+        add_topic(model::topic_namespace_view(ntp)).get();
+        auto shard = app.shard_table.local().shard_for(ntp);
+        tests::cooperative_spin_wait_with_timeout(10s, [this, shard, ntp] {
+            return app.partition_manager.invoke_on(
+              *shard, [ntp](cluster::partition_manager& mgr) {
+                  auto partition = mgr.get(ntp);
+                  return partition
+                         && partition->committed_offset() >= model::offset(1);
+              });
+        }).get();
+    }
+
+    kafka::fetch_request req;
+    req.max_bytes = std::numeric_limits<int32_t>::max();
+    req.min_bytes = 1;
+    req.max_wait_time = std::chrono::milliseconds(0);
+    // request in reverse order of creation and include an unknown partition
+    req.topics = {
+      {.name = topics[2], .partitions = {{.id = model::partition_id(0)}}},
+      {.name = topics[1],
+       .partitions = {{.id = model::partition_id(0)},
+                      {.id = model::partition_id(1)}}},
+      {.name = topics[0], .partitions = {{.id = model::partition_id(0)}}},
+    };
+
+    auto client = make_kafka_client().get0();
+    client.connect().get();
+    auto resp = client.dispatch(req, kafka::api_version(4)).get0();
+    client.stop().then([&client] { client.shutdown(); }).get();
+
+    BOOST_REQUIRE(resp.partitions.size() == 3);
+    BOOST_REQUIRE(resp.partitions[0].name == topics[2]());
+    BOOST_REQUIRE(resp.partitions[1].name == topics[1]());
+    BOOST_REQUIRE(resp.partitions[2].name == topics[0]());
+
+    BOOST_REQUIRE(resp.partitions[1].responses.size() == 2);
+    BOOST_REQUIRE(
+      resp.partitions[1].responses[0].id == model::partition_id(0));
+    BOOST_REQUIRE(
+      resp.partitions[1].responses[0].error == kafka::error_code::none);
+    BOOST_REQUIRE(
+      resp.partitions[1].responses[1].id == model::partition_id(1));
+    BOOST_REQUIRE(
+      resp.partitions[1].responses[1].error
+      == kafka::error_code::unknown_topic_or_partition);
+
+    for (auto i : {0, 2}) {
+        BOOST_REQUIRE(resp.partitions[i].responses.size() == 1);
+        auto& p = resp.partitions[i].responses[0];
+        BOOST_REQUIRE(p.error == kafka::error_code::none);
+        BOOST_REQUIRE(p.record_set);
+        BOOST_REQUIRE(p.record_set->size_bytes() > 0);
+    }
+}
+
+FIXTURE_TEST(fetch_long_poll_wakes_on_new_data, redpanda_thread_fixture) {
+    model::topic topic("foo");
+    model::partition_id pid(0);
+    auto ntp = make_default_ntp(topic, pid);
+    auto log_config = make_default_config();
+    {
+        using namespace storage;
+        storage::disk_log_builder builder(log_config);
+        storage::ntp_config ntp_cfg(
+          ntp, log_config.base_dir, nullptr, storage::ntp_config::ntp_id(2));
+        builder | start(std::move(ntp_cfg)) | add_segment(model::offset(0))
+          | add_random_batch(model::offset(0), 10, maybe_compress_batches::yes)
+          | stop();
+    }
+    wait_for_controller_leadership().get0();
+
+    add_topic(model::topic_namespace_view(ntp)).get();
+    auto shard = app.shard_table.local().shard_for(ntp);
+
+    tests::cooperative_spin_wait_with_timeout(10s, [this, shard, ntp] {
+        return app.partition_manager.invoke_on(
+          *shard, [ntp](cluster::partition_manager& mgr) {
+              auto partition = mgr.get(ntp);
+              return partition && partition->is_leader()
+                     && partition->committed_offset() >= model::offset(1);
+          });
+    }).get();
+
+    auto high_watermark = app.partition_manager
+                            .invoke_on(
+                              *shard,
+                              [ntp](cluster::partition_manager& mgr) {
+                                  return mgr.get(ntp)->high_watermark();
+                              })
+                            .get0();
+
+    // fetch past the end of the log, the fetch is parked until data arrives
+    kafka::fetch_request req;
+    req.max_bytes = std::numeric_limits<int32_t>::max();
+    req.min_bytes = 1;
+    req.max_wait_time = std::chrono::milliseconds(30000);
+    req.topics = {{
+      .name = topic,
+      .partitions = {{
+        .id = pid,
+        .fetch_offset = high_watermark + model::offset(1),
+      }},
+    }};
+
+    auto client = make_kafka_client().get0();
+    client.connect().get();
+    auto start = model::timeout_clock::now();
+    auto f = client.dispatch(req, kafka::api_version(4));
+
+    ss::sleep(100ms).get();
+    app.partition_manager
+      .invoke_on(
+        *shard,
+        [ntp](cluster::partition_manager& mgr) {
+            auto batches = storage::test::make_random_batches(
+              model::offset(0), 1);
+            auto rdr = model::make_memory_record_batch_reader(
+              std::move(batches));
+            auto p = mgr.get(ntp);
+            return p
+              ->replicate(
+                std::move(rdr),
+                raft::replicate_options(raft::consistency_level::quorum_ack))
+              .discard_result();
+        })
+      .get();
+
+    auto resp = f.get0();
+    auto elapsed = model::timeout_clock::now() - start;
+    client.stop().then([&client] { client.shutdown(); }).get();
+
+    BOOST_REQUIRE(elapsed < req.max_wait_time);
+    BOOST_REQUIRE(resp.partitions.size() == 1);
+    BOOST_REQUIRE(resp.partitions[0].responses.size() == 1);
+    auto& p = resp.partitions[0].responses[0];
+    BOOST_REQUIRE(p.error == kafka::error_code::none);
+    BOOST_REQUIRE(p.high_watermark > high_watermark);
+    BOOST_REQUIRE(p.record_set);
+    BOOST_REQUIRE(p.record_set->size_bytes() > 0);
+}
@@ -0,0 +1,366 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/bytes.h"
+#include "kafka/requests/find_coordinator_request.h"
+#include "kafka/requests/heartbeat_request.h"
+#include "kafka/requests/join_group_request.h"
+#include "kafka/requests/offset_commit_request.h"
+#include "kafka/requests/sync_group_request.h"
+#include "redpanda/tests/fixture.h"
+#include "test_utils/async.h"
+#include "utils/hdr_hist.h"
+
+#include <seastar/core/loop.hh>
+#include <seastar/core/smp.hh>
+
+#include <boost/range/irange.hpp>
+#include <fmt/format.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+/*
+ * Drives groups of members through join, sync, heartbeat and offset commit
+ * against the group coordinators of the node and reports the latency of each
+ * operation, and the cpu time of the node per operation.
+ *
+ * The requests are routed to the coordinators like those of the kafka server,
+ * minus the network and the codecs. The groups are checkpointed to the group
+ * topic, created with a single replica, so that replication costs a local
+ * append. The cpu time is that of the reactor threads of every shard, which
+ * includes the few requests built by the bench itself.
+ */
+
+using namespace std::chrono_literals; // NOLINT
+
+using clock_type = std::chrono::steady_clock;
+
+static std::chrono::microseconds thread_cpu_time() {
+    rusage ru{};
+    ::getrusage(RUSAGE_THREAD, &ru);
+    auto to_us = [](timeval t) {
+        return std::chrono::seconds(t.tv_sec)
+               + std::chrono::microseconds(t.tv_usec);
+    };
+    return to_us(ru.ru_utime) + to_us(ru.ru_stime);
+}
+
+static ss::future<std::chrono::microseconds> node_cpu_time() {
+    auto shards = boost::irange(0u, ss::smp::count);
+    return ss::map_reduce(
+      shards.begin(),
+      shards.end(),
+      [](ss::shard_id shard) {
+          return ss::smp::submit_to(shard, [] { return thread_cpu_time(); });
+      },
+      std::chrono::microseconds(0),
+      std::plus<>());
+}
+
+struct bench_member {
+    kafka::group_id group;
+    kafka::member_id id{kafka::unknown_member_id};
+    kafka::generation_id generation{kafka::unknown_generation_id};
+    // the members to assign, when the member leads its group
+    std::vector<kafka::member_id> members;
+    bool stable{false};
+};
+
+struct op_stats {
+    hdr_hist latency;
+    size_t errors{0};
+};
+
+class group_bench_fixture : public redpanda_thread_fixture {
+public:
+    static constexpr size_t partitions_per_commit = 10;
+
+    group_bench_fixture() {
+        ss::smp::invoke_on_all([] {
+            // the initial rebalance is not delayed, so that the join latency
+            // is that of the coordinator
+            config::shard_local_cfg()
+              .get("group_initial_rebalance_delay")
+              .set_value(std::chrono::milliseconds(0));
+        }).get();
+        wait_for_controller_leadership().get();
+    }
+
+    void run(size_t groups, size_t members_per_group, size_t rounds) {
+        std::vector<bench_member> members;
+        for (size_t g = 0; g < groups; ++g) {
+            for (size_t m = 0; m < members_per_group; ++m) {
+                members.push_back(bench_member{
+                  .group = kafka::group_id(fmt::format("bench-group-{}", g))});
+            }
+        }
+        wait_for_coordinators(groups);
+
+        auto start = clock_type::now();
+        auto cpu = node_cpu_time().get0();
+        stabilize(members);
+        const auto join_cpu = node_cpu_time().get0() - cpu;
+        const auto join_time = clock_type::now() - start;
+
+        start = clock_type::now();
+        cpu = node_cpu_time().get0();
+        ss::parallel_for_each(
+          members,
+          [this, rounds](bench_member& m) {
+              return ss::do_for_each(
+                boost::irange<size_t>(0, rounds), [this, &m](size_t) {
+                    return heartbeat(m).then(
+                      [this, &m](bool) { return commit(m); });
+                });
+          })
+          .get();
+        const auto steady_cpu = node_cpu_time().get0() - cpu;
+        const auto steady_time = clock_type::now() - start;
+
+        report(
+          groups,
+          members_per_group,
+          join_cpu,
+          join_time,
+          steady_cpu,
+          steady_time);
+    }
+
+private:
+    // the groups hash over the partitions of the group topic, each of which
+    // must have loaded its groups before it coordinates them
+    void wait_for_coordinators(size_t groups) {
+        auto client = make_kafka_client().get0();
+        client.connect().get();
+        client.dispatch(kafka::find_coordinator_request("bench-group-0"))
+          .get();
+        client.stop().then([&client] { client.shutdown(); }).get();
+
+        for (size_t g = 0; g < groups; ++g) {
+            auto group = kafka::group_id(fmt::format("bench-group-{}", g));
+            tests::cooperative_spin_wait_with_timeout(10s, [this, group] {
+                kafka::heartbeat_request r;
+                r.data.group_id = group;
+                r.data.member_id = kafka::member_id("unknown");
+                return app.group_router.local()
+                  .heartbeat(std::move(r))
+                  .then([](kafka::heartbeat_response resp) {
+                      return resp.data.error_code
+                             == kafka::error_code::unknown_member_id;
+                  });
+            }).get();
+        }
+    }
+
+    // joins and syncs the members until every one of them heartbeats within
+    // the generation it synced, as members joining late rebalance the
+    // members already synced
+    void stabilize(std::vector<bench_member>& members) {
+        while (true) {
+            ss::parallel_for_each(
+              members,
+              [this](bench_member& m) {
+                  if (m.stable) {
+                      return ss::now();
+                  }
+                  return join(m).then([this, &m](bool joined) {
+                      return joined ? sync(m).discard_result() : ss::now();
+                  });
+              })
+              .get();
+            ss::parallel_for_each(
+              members,
+              [this](bench_member& m) {
+                  return heartbeat(m).then([&m](bool ok) { m.stable = ok; });
+              })
+              .get();
+            if (std::all_of(
+                  members.begin(), members.end(), [](const bench_member& m) {
+                      return m.stable;
+                  })) {
+                return;
+            }
+        }
+    }
+
+    static void
+    record(op_stats& s, clock_type::time_point start, kafka::error_code e) {
+        s.latency.record(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+            clock_type::now() - start)
+            .count());
+        if (e != kafka::error_code::none) {
+            ++s.errors;
+        }
+    }
+
+    ss::future<bool> join(bench_member& m) {
+        kafka::join_group_request r;
+        r.version = kafka::api_version(3);
+        r.data.group_id = m.group;
+        r.data.session_timeout_ms = 30s;
+        r.data.rebalance_timeout_ms = 30s;
+        r.data.member_id = m.id;
+        r.data.protocol_type = kafka::protocol_type("consumer");
+        r.data.protocols.push_back(kafka::join_group_request_protocol{
+          .name = kafka::protocol_name("range"), .metadata = bytes()});
+        const auto start = clock_type::now();
+        return app.group_router.local()
+          .join_group(std::move(r))
+          .then([this, &m, start](kafka::join_group_response resp) {
+              record(_join, start, resp.data.error_code);
+              if (resp.data.error_code != kafka::error_code::none) {
+                  if (
+                    resp.data.error_code
+                    == kafka::error_code::unknown_member_id) {
+                      m.id = kafka::unknown_member_id;
+                  }
+                  return false;
+              }
+              m.id = resp.data.member_id;
+              m.generation = resp.data.generation_id;
+              m.members.clear();
+              if (resp.data.leader == m.id) {
+                  for (auto& member : resp.data.members) {
+                      m.members.push_back(member.member_id);
+                  }
+              }
+              return true;
+          });
+    }
+
+    ss::future<bool> sync(bench_member& m) {
+        kafka::sync_group_request r;
+        r.data.group_id = m.group;
+        r.data.generation_id = m.generation;
+        r.data.member_id = m.id;
+        for (auto& id : m.members) {
+            r.data.assignments.push_back(kafka::sync_group_request_assignment{
+              .member_id = id, .assignment = bytes()});
+        }
+        const auto start = clock_type::now();
+        return app.group_router.local().sync_group(std::move(r)).then(
+          [this, start](kafka::sync_group_response resp) {
+              record(_sync, start, resp.data.error_code);
+              return resp.data.error_code == kafka::error_code::none;
+          });
+    }
+
+    ss::future<bool> heartbeat(bench_member& m) {
+        kafka::heartbeat_request r;
+        r.data.group_id = m.group;
+        r.data.generation_id = m.generation;
+        r.data.member_id = m.id;
+        const auto start = clock_type::now();
+        return app.group_router.local().heartbeat(std::move(r)).then(
+          [this, start](kafka::heartbeat_response resp) {
+              record(_heartbeat, start, resp.data.error_code);
+              return resp.data.error_code == kafka::error_code::none;
+          });
+    }
+
+    ss::future<> commit(bench_member& m) {
+        kafka::offset_commit_request r;
+        r.data.group_id = m.group;
+        r.data.generation_id = m.generation;
+        r.data.member_id = m.id;
+        kafka::offset_commit_request_topic t{
+          .name = model::topic("bench-topic")};
+        for (size_t i = 0; i < partitions_per_commit; ++i) {
+            t.partitions.push_back(kafka::offset_commit_request_partition{
+              .partition_index = model::partition_id(i),
+              .committed_offset = model::offset(++_committed),
+            });
+        }
+        r.data.topics.push_back(std::move(t));
+        const auto start = clock_type::now();
+        return app.group_router.local().offset_commit(std::move(r)).then(
+          [this, start](kafka::offset_commit_response resp) {
+              auto error = kafka::error_code::none;
+              for (auto& t : resp.data.topics) {
+                  for (auto& p : t.partitions) {
+                      if (p.error_code != kafka::error_code::none) {
+                          error = p.error_code;
+                      }
+                  }
+              }
+              record(_commit, start, error);
+          });
+    }
+
+    void report(
+      size_t groups,
+      size_t members_per_group,
+      std::chrono::microseconds join_cpu,
+      clock_type::duration join_time,
+      std::chrono::microseconds steady_cpu,
+      clock_type::duration steady_time) {
+        auto line = [](const char* op, const op_stats& s) {
+            std::cout << fmt::format(
+              "  {:<14} count {:>8} errors {:>6} p50 {:>8}us p99 {:>8}us "
+              "max {:>8}us\n",
+              op,
+              s.latency.sample_count(),
+              s.errors,
+              s.latency.get_value_at(50.0),
+              s.latency.get_value_at(99.0),
+              s.latency.get_value_at(100.0));
+        };
+        auto phase = [](
+                       const char* name,
+                       size_t ops,
+                       std::chrono::microseconds cpu,
+                       clock_type::duration wall) {
+            const auto ms
+              = std::chrono::duration_cast<std::chrono::milliseconds>(wall);
+            std::cout << fmt::format(
+              "  {:<14} wall {:>8}ms cpu {:>8}ms cpu/op {:>6}us\n",
+              name,
+              ms.count(),
+              cpu.count() / 1000,
+              cpu.count() / std::max<size_t>(ops, 1));
+        };
+        std::cout << fmt::format(
+          "groups {} members per group {} shards {}\n",
+          groups,
+          members_per_group,
+          ss::smp::count);
+        line("join", _join);
+        line("sync", _sync);
+        line("heartbeat", _heartbeat);
+        line("offset_commit", _commit);
+        // the heartbeats of the stabilization belong to the join phase
+        const auto steady_heartbeats = _commit.latency.sample_count();
+        phase(
+          "join phase",
+          _join.latency.sample_count() + _sync.latency.sample_count()
+            + _heartbeat.latency.sample_count() - steady_heartbeats,
+          join_cpu,
+          join_time);
+        phase(
+          "steady phase",
+          steady_heartbeats + _commit.latency.sample_count(),
+          steady_cpu,
+          steady_time);
+    }
+
+    op_stats _join;
+    op_stats _sync;
+    op_stats _heartbeat;
+    op_stats _commit;
+    int64_t _committed{0};
+};
+
+FIXTURE_TEST(few_large_groups, group_bench_fixture) { run(10, 100, 20); }
+
+FIXTURE_TEST(many_small_groups, group_bench_fixture) { run(1000, 3, 20); }
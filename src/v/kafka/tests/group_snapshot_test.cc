@@ -0,0 +1,112 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE group_snapshot
+#include "kafka/groups/group_manager.h"
+#include "model/fundamental.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace kafka; // NOLINT
+
+static model::topic_partition tp(ss::sstring topic, int32_t partition) {
+    return model::topic_partition(
+      model::topic(std::move(topic)), model::partition_id(partition));
+}
+
+BOOST_AUTO_TEST_CASE(recovery_state_snapshot_roundtrip) {
+    ss::abort_source as;
+    recovery_batch_consumer ctx(&as);
+    ctx.last_offset = model::offset(1234);
+    ctx.loaded_groups[kafka::group_id("g0")] = group_log_group_metadata{
+      .protocol_type = kafka::protocol_type("consumer"),
+      .generation = kafka::generation_id(3),
+      .protocol = kafka::protocol_name("range"),
+      .leader = kafka::member_id("m0"),
+      .state_timestamp = 42,
+      .members = {},
+    };
+    ctx.removed_groups.emplace(kafka::group_id("g1"));
+    ctx.loaded_offsets[kafka::group_id("g0")].insert(
+      tp("a", 0),
+      offset_metadata{
+        .log_offset = model::offset(10),
+        .offset = model::offset(100),
+        .metadata = "m",
+      });
+    ctx.loaded_offsets[kafka::group_id("g2")].insert(
+      tp("b", 7),
+      offset_metadata{
+        .log_offset = model::offset(20),
+        .offset = model::offset(200),
+        .metadata = "",
+      });
+
+    auto restored = recovery_batch_consumer::from_snapshot(
+      std::move(ctx).snapshot(), &as);
+
+    BOOST_REQUIRE_EQUAL(restored.last_offset, model::offset(1234));
+    BOOST_REQUIRE_EQUAL(restored.loaded_groups.size(), size_t(1));
+    const auto& md = restored.loaded_groups.at(kafka::group_id("g0"));
+    BOOST_REQUIRE_EQUAL(md.protocol_type, kafka::protocol_type("consumer"));
+    BOOST_REQUIRE_EQUAL(md.generation, kafka::generation_id(3));
+    BOOST_REQUIRE(md.protocol == kafka::protocol_name("range"));
+    BOOST_REQUIRE(md.leader == kafka::member_id("m0"));
+    BOOST_REQUIRE_EQUAL(md.state_timestamp, 42);
+    BOOST_REQUIRE(md.members.empty());
+
+    BOOST_REQUIRE(restored.removed_groups.contains(kafka::group_id("g1")));
+
+    BOOST_REQUIRE_EQUAL(restored.loaded_offsets.size(), size_t(2));
+    auto a = restored.loaded_offsets.at(kafka::group_id("g0")).find(tp("a", 0));
+    BOOST_REQUIRE(a);
+    BOOST_REQUIRE_EQUAL(a->log_offset, model::offset(10));
+    BOOST_REQUIRE_EQUAL(a->offset, model::offset(100));
+    BOOST_REQUIRE_EQUAL(a->metadata, "m");
+    auto b = restored.loaded_offsets.at(kafka::group_id("g2")).find(tp("b", 7));
+    BOOST_REQUIRE(b);
+    BOOST_REQUIRE_EQUAL(b->offset, model::offset(200));
+}
+
+BOOST_AUTO_TEST_CASE(recovery_applies_tombstones) {
+    ss::abort_source as;
+    recovery_batch_consumer ctx(&as);
+    auto offset_key = [](const char* group) {
+        return reflection::to_iobuf(group_log_offset_key{
+          kafka::group_id(group), model::topic("a"), model::partition_id(0)});
+    };
+    auto offset_value = [] {
+        return reflection::to_iobuf(
+          group_log_offset_metadata{model::offset(100), 0, std::nullopt});
+    };
+    ctx.handle_offset_metadata(offset_key("g0"), offset_value()).get();
+    ctx.handle_offset_metadata(offset_key("g1"), offset_value()).get();
+    ctx
+      .handle_group_metadata(
+        reflection::to_iobuf(kafka::group_id("g0")),
+        reflection::to_iobuf(group_log_group_metadata{
+          .protocol_type = kafka::protocol_type("consumer"),
+          .generation = kafka::generation_id(1),
+          .protocol = std::nullopt,
+          .leader = std::nullopt,
+          .state_timestamp = 0,
+          .members = {},
+        }))
+      .get();
+
+    // the group g0 expired
+    ctx.handle_offset_metadata(offset_key("g0"), iobuf()).get();
+    ctx.handle_group_metadata(reflection::to_iobuf(kafka::group_id("g0")), {})
+      .get();
+
+    BOOST_REQUIRE(ctx.loaded_groups.empty());
+    BOOST_REQUIRE(ctx.removed_groups.contains(kafka::group_id("g0")));
+    BOOST_REQUIRE(!ctx.loaded_offsets.contains(kafka::group_id("g0")));
+    BOOST_REQUIRE(ctx.loaded_offsets.contains(kafka::group_id("g1")));
+}
@@ -18,6 +18,8 @@
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 
+#include <map>
+
 namespace kafka {
 
 static auto split_member_id(const ss::sstring& m) {
@@ -44,7 +46,8 @@ static bool is_uuid(const ss::sstring& uuid) {
  */
 static group get() {
     static config::configuration conf;
-    return group(kafka::group_id("g"), group_state::empty, conf, nullptr);
+    return group(
+      kafka::group_id("g"), group_state::empty, conf, nullptr, nullptr);
 }
 
 static const std::vector<member_protocol> test_protos = {
@@ -427,6 +430,129 @@ SEASTAR_THREAD_TEST_CASE(leader_rejoined) {
     BOOST_TEST(g.leader() == "n");
 }
 
+SEASTAR_THREAD_TEST_CASE(static_member_fencing) {
+    auto g = get();
+    const kafka::group_instance_id instance("i");
+    BOOST_TEST(!g.get_static_member(instance));
+
+    g.add_member_no_join(get_member("m"));
+    BOOST_TEST(*g.get_static_member(instance) == "m");
+    BOOST_TEST(!g.is_static_member_fenced(kafka::member_id("m"), instance));
+    BOOST_TEST(g.is_static_member_fenced(kafka::member_id("n"), instance));
+    BOOST_TEST(
+      !g.is_static_member_fenced(kafka::member_id("n"), std::nullopt));
+    BOOST_TEST(!g.is_static_member_fenced(
+      kafka::member_id("n"), kafka::group_instance_id("j")));
+}
+
+SEASTAR_THREAD_TEST_CASE(replace_static_member) {
+    auto g = get();
+    const kafka::group_instance_id instance("i");
+    auto m = get_member("m");
+    auto f = g.add_member(m);
+    BOOST_TEST(g.leader() == "m");
+    BOOST_TEST(!f.available());
+
+    auto r = g.replace_static_member(
+      instance, kafka::member_id("m"), kafka::member_id("n"));
+
+    // the pending join of the old incarnation is fenced
+    BOOST_REQUIRE(f.available());
+    BOOST_TEST(f.get0().data.error_code == error_code::fenced_instance_id);
+
+    BOOST_TEST(r == m);
+    BOOST_TEST(r->id() == "n");
+    BOOST_TEST(g.contains_member(kafka::member_id("n")));
+    BOOST_TEST(!g.contains_member(kafka::member_id("m")));
+    BOOST_TEST(g.leader() == "n");
+    BOOST_TEST(*g.get_static_member(instance) == "n");
+    BOOST_TEST(g.is_static_member_fenced(kafka::member_id("m"), instance));
+}
+
+SEASTAR_THREAD_TEST_CASE(expire_members) {
+    auto g = get();
+    auto m = get_member();
+    g.add_member_no_join(m);
+    g.schedule_next_heartbeat_expiration(m);
+    auto now = group::clock_type::now();
+
+    // within the session timeout of the member
+    g.expire_members(now);
+    BOOST_TEST(g.contains_member(kafka::member_id("m")));
+
+    g.expire_members(now + m->session_timeout() + std::chrono::seconds(1));
+    BOOST_TEST(!g.contains_member(kafka::member_id("m")));
+    BOOST_TEST(!g.has_members());
+}
+
+SEASTAR_THREAD_TEST_CASE(offsets_expire_for_empty_groups) {
+    auto g = get();
+    auto now = group::clock_type::now();
+    const auto retention = std::chrono::hours(24);
+    BOOST_TEST(!g.offsets_expired(now, retention));
+    BOOST_TEST(g.offsets_expired(now + retention, retention));
+    // disabled
+    BOOST_TEST(
+      !g.offsets_expired(now + retention, group::duration_type::zero()));
+
+    g.set_state(group_state::preparing_rebalance);
+    BOOST_TEST(!g.offsets_expired(now + retention, retention));
+}
+
+static offset_fetch_response_data
+fetch_all_offsets(group& g, api_version version) {
+    offset_fetch_request r;
+    r.data.group_id = g.id();
+    r.version = version;
+    auto resp = g.handle_offset_fetch(std::move(r)).get0();
+    BOOST_REQUIRE(resp.encoded);
+    offset_fetch_response_data data;
+    data.decode(std::move(*resp.encoded), version);
+    return data;
+}
+
+SEASTAR_THREAD_TEST_CASE(fetch_all_offsets_cached_until_commit) {
+    auto g = get();
+    const model::topic a("a");
+    const model::topic b("b");
+    g.insert_offset(
+      model::topic_partition(a, model::partition_id(0)),
+      {.offset = model::offset(1)});
+    g.insert_offset(
+      model::topic_partition(a, model::partition_id(1)),
+      {.offset = model::offset(2)});
+    g.insert_offset(
+      model::topic_partition(b, model::partition_id(0)),
+      {.offset = model::offset(3)});
+
+    auto committed = [](const offset_fetch_response_data& data) {
+        std::map<std::pair<model::topic, int>, model::offset> offsets;
+        for (const auto& t : data.topics) {
+            for (const auto& p : t.partitions) {
+                offsets[{t.name, p.partition_index()}] = p.committed_offset;
+            }
+        }
+        return offsets;
+    };
+
+    auto data = fetch_all_offsets(g, api_version(4));
+    BOOST_TEST(data.error_code == error_code::none);
+    BOOST_TEST(data.topics.size() == 2);
+    auto offsets = committed(data);
+    BOOST_TEST(offsets.size() == 3);
+    BOOST_TEST(offsets[{a, 1}] == model::offset(2));
+
+    // served again from the cache, and re-encoded for another version
+    BOOST_TEST(committed(fetch_all_offsets(g, api_version(4))) == offsets);
+    BOOST_TEST(committed(fetch_all_offsets(g, api_version(1))) == offsets);
+
+    g.insert_offset(
+      model::topic_partition(b, model::partition_id(0)),
+      {.offset = model::offset(4)});
+    offsets = committed(fetch_all_offsets(g, api_version(4)));
+    BOOST_TEST(offsets[{b, 0}] == model::offset(4));
+}
+
 SEASTAR_THREAD_TEST_CASE(generate_member_id) {
     join_group_request r;
 
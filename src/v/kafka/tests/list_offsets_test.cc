@@ -132,3 +132,63 @@ FIXTURE_TEST(list_offsets_latest, redpanda_thread_fixture) {
       resp.data.topics[0].partitions[0].timestamp == model::timestamp(-1));
     BOOST_CHECK(resp.data.topics[0].partitions[0].offset > model::offset(0));
 }
+
+FIXTURE_TEST(list_offsets_keeps_request_order, redpanda_thread_fixture) {
+    wait_for_controller_leadership().get0();
+    auto ntp = make_data(storage::ntp_config::ntp_id(2));
+    auto shard = app.shard_table.local().shard_for(ntp);
+    tests::cooperative_spin_wait_with_timeout(10s, [this, shard, ntp = ntp] {
+        return app.partition_manager.invoke_on(
+          *shard, [ntp](cluster::partition_manager& mgr) {
+              auto partition = mgr.get(ntp);
+              return partition
+                     && partition->committed_offset() >= model::offset(1);
+          });
+    }).get();
+
+    auto client = make_kafka_client().get0();
+    client.connect().get();
+
+    // lookups and errors interleaved across topics
+    kafka::list_offsets_request req;
+    req.data.topics = {
+      {
+        .name = model::topic("missing"),
+        .partitions = {{
+          .partition_index = model::partition_id(0),
+          .timestamp = kafka::list_offsets_request::latest_timestamp,
+        }},
+      },
+      {
+        .name = ntp.tp.topic,
+        .partitions = {
+          {
+            .partition_index = ntp.tp.partition,
+            .timestamp = kafka::list_offsets_request::earliest_timestamp,
+          },
+          {
+            .partition_index = model::partition_id(1000),
+            .timestamp = kafka::list_offsets_request::latest_timestamp,
+          },
+        },
+      },
+    };
+
+    auto resp = client.dispatch(req, kafka::api_version(1)).get0();
+    client.stop().then([&client] { client.shutdown(); }).get();
+
+    BOOST_REQUIRE_EQUAL(resp.data.topics.size(), 2);
+    BOOST_REQUIRE_EQUAL(resp.data.topics[0].partitions.size(), 1);
+    BOOST_CHECK(
+      resp.data.topics[0].partitions[0].error_code
+      == kafka::error_code::unknown_topic_or_partition);
+
+    const auto& parts = resp.data.topics[1].partitions;
+    BOOST_REQUIRE_EQUAL(parts.size(), 2);
+    BOOST_CHECK(parts[0].partition_index == ntp.tp.partition);
+    BOOST_CHECK(parts[0].error_code == kafka::error_code::none);
+    BOOST_CHECK(parts[0].offset == model::offset(0));
+    BOOST_CHECK(parts[1].partition_index == model::partition_id(1000));
+    BOOST_CHECK(
+      parts[1].error_code == kafka::error_code::unknown_topic_or_partition);
+}
@@ -0,0 +1,91 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE metadata_response_cache
+#include "bytes/iobuf.h"
+#include "bytes/iobuf_parser.h"
+#include "kafka/requests/metadata_response_cache.h"
+#include "model/fundamental.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string_view>
+
+using namespace kafka; // NOLINT
+
+using revision = metadata_response_cache::revision;
+
+static iobuf encoded(std::string_view v) {
+    iobuf buf;
+    buf.append(v.data(), v.size());
+    return buf;
+}
+
+static ss::sstring to_string(const iobuf& buf) {
+    iobuf_const_parser parser(buf);
+    return parser.read_string(buf.size_bytes());
+}
+
+BOOST_AUTO_TEST_CASE(get_at_same_revision) {
+    metadata_response_cache cache;
+    const model::topic t("a");
+    const revision rev{.topic = 1, .leaders = 2};
+    BOOST_REQUIRE(!cache.get(t, api_version(1), rev));
+
+    auto shared = cache.put(t, api_version(1), rev, encoded("v1"));
+    BOOST_REQUIRE_EQUAL(to_string(shared), "v1");
+    cache.put(t, api_version(5), rev, encoded("v5"));
+    BOOST_REQUIRE_EQUAL(cache.size(), size_t(2));
+    BOOST_REQUIRE_EQUAL(cache.size_bytes(), size_t(4));
+
+    BOOST_REQUIRE_EQUAL(to_string(*cache.get(t, api_version(1), rev)), "v1");
+    BOOST_REQUIRE_EQUAL(to_string(*cache.get(t, api_version(5), rev)), "v5");
+    BOOST_REQUIRE(!cache.get(t, api_version(2), rev));
+    BOOST_REQUIRE(!cache.get(model::topic("b"), api_version(1), rev));
+}
+
+BOOST_AUTO_TEST_CASE(changed_revision_drops_the_entry) {
+    metadata_response_cache cache;
+    const model::topic t("a");
+    const revision rev{.topic = 1, .leaders = 2};
+    cache.put(t, api_version(1), rev, encoded("old"));
+
+    const revision leader_changed{.topic = 1, .leaders = 3};
+    BOOST_REQUIRE(!cache.get(t, api_version(1), leader_changed));
+    BOOST_REQUIRE_EQUAL(cache.size(), size_t(0));
+    BOOST_REQUIRE_EQUAL(cache.size_bytes(), size_t(0));
+
+    cache.put(t, api_version(1), leader_changed, encoded("new"));
+    BOOST_REQUIRE(!cache.get(t, api_version(1), rev));
+    cache.put(t, api_version(1), leader_changed, encoded("newer"));
+    BOOST_REQUIRE_EQUAL(cache.size(), size_t(1));
+    BOOST_REQUIRE_EQUAL(cache.size_bytes(), size_t(5));
+    BOOST_REQUIRE_EQUAL(
+      to_string(*cache.get(t, api_version(1), leader_changed)), "newer");
+}
+
+BOOST_AUTO_TEST_CASE(full_cache_is_cleared) {
+    metadata_response_cache cache(8);
+    const revision rev{.topic = 1, .leaders = 1};
+    cache.put(model::topic("a"), api_version(1), rev, encoded("aaaa"));
+    cache.put(model::topic("b"), api_version(1), rev, encoded("bbbb"));
+    BOOST_REQUIRE_EQUAL(cache.size(), size_t(2));
+
+    cache.put(model::topic("c"), api_version(1), rev, encoded("cc"));
+    BOOST_REQUIRE_EQUAL(cache.size(), size_t(1));
+    BOOST_REQUIRE_EQUAL(cache.size_bytes(), size_t(2));
+    BOOST_REQUIRE(cache.get(model::topic("c"), api_version(1), rev));
+
+    // too large to be cached, but still returned
+    auto large = cache.put(
+      model::topic("d"), api_version(1), rev, encoded("ddddddddd"));
+    BOOST_REQUIRE_EQUAL(to_string(large), "ddddddddd");
+    BOOST_REQUIRE(!cache.get(model::topic("d"), api_version(1), rev));
+    BOOST_REQUIRE_EQUAL(cache.size(), size_t(1));
+}
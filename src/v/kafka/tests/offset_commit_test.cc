@@ -7,6 +7,7 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "kafka/requests/find_coordinator_request.h"
 #include "kafka/requests/offset_commit_request.h"
 #include "redpanda/tests/fixture.h"
 #include "resource_mgmt/io_priority.h"
@@ -17,8 +18,10 @@
 #include <chrono>
 #include <limits>
 
+using namespace std::chrono_literals; // NOLINT
+
 FIXTURE_TEST(
-  offset_commit_static_membership_not_supported, redpanda_thread_fixture) {
+  offset_commit_static_membership_supported, redpanda_thread_fixture) {
     auto client = make_kafka_client().get0();
     client.connect().get();
 
@@ -34,5 +37,69 @@ FIXTURE_TEST(
 
     BOOST_TEST(
       resp.data.topics[0].partitions[0].error_code
-      == kafka::error_code::unsupported_version);
+      != kafka::error_code::unsupported_version);
+}
+
+// the lag is refreshed often enough for the test, before the node starts
+struct consumer_lag_config {
+    consumer_lag_config() {
+        ss::smp::invoke_on_all([] {
+            config::shard_local_cfg()
+              .get("consumer_lag_refresh_interval_ms")
+              .set_value(std::chrono::milliseconds(100));
+        }).get();
+    }
+};
+
+struct consumer_lag_fixture
+  : consumer_lag_config
+  , redpanda_thread_fixture {};
+
+FIXTURE_TEST(offset_commit_consumer_lag, consumer_lag_fixture) {
+    wait_for_controller_leadership().get();
+    auto ntp = make_data(storage::ntp_config::ntp_id(2));
+    const auto group = kafka::group_id("lag-group");
+
+    auto client = make_kafka_client().get0();
+    client.connect().get();
+    client.dispatch(kafka::find_coordinator_request(group())).get();
+    client.stop().then([&client] { client.shutdown(); }).get();
+
+    // commits without group membership, once the coordinator is loaded
+    tests::cooperative_spin_wait_with_timeout(10s, [this, &ntp, group] {
+        kafka::offset_commit_request req;
+        req.data.group_id = group;
+        req.data.generation_id = kafka::generation_id(-1);
+        kafka::offset_commit_request_topic t{.name = ntp.tp.topic};
+        t.partitions.push_back(kafka::offset_commit_request_partition{
+          .partition_index = ntp.tp.partition,
+          .committed_offset = model::offset(1),
+        });
+        req.data.topics.push_back(std::move(t));
+        return app.group_router.local()
+          .offset_commit(std::move(req))
+          .then([](kafka::offset_commit_response resp) {
+              return resp.data.topics[0].partitions[0].error_code
+                     == kafka::error_code::none;
+          });
+    }).get();
+
+    auto shard = app.shard_table.local().shard_for(ntp);
+    BOOST_REQUIRE(shard);
+    tests::cooperative_spin_wait_with_timeout(10s, [this, &ntp, shard, group] {
+        return app.partition_manager
+          .invoke_on(
+            *shard,
+            [ntp](cluster::partition_manager& pm) {
+                return pm.get(ntp)->high_watermark();
+            })
+          .then([this, &ntp, group](model::offset hwm) {
+              return app.group_router.local()
+                .consumer_lag(group, ntp.tp.topic)
+                .then([hwm](std::optional<int64_t> lag) {
+                    return hwm > model::offset(1) && lag
+                           && *lag == hwm() - 1;
+                });
+          });
+    }).get();
 }
@@ -0,0 +1,130 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE offset_table
+#include "kafka/groups/offset_table.h"
+#include "model/fundamental.h"
+
+#include <boost/test/unit_test.hpp>
+#include <fmt/format.h>
+
+#include <set>
+#include <tuple>
+
+using namespace kafka; // NOLINT
+
+static model::topic_partition tp(ss::sstring topic, int32_t partition) {
+    return model::topic_partition(
+      model::topic(std::move(topic)), model::partition_id(partition));
+}
+
+static offset_metadata md(int64_t offset) {
+    return offset_metadata{
+      .log_offset = model::offset(offset * 10),
+      .offset = model::offset(offset),
+      .metadata = fmt::format("m{}", offset),
+    };
+}
+
+BOOST_AUTO_TEST_CASE(find_insert_erase) {
+    offset_table t;
+    BOOST_REQUIRE(t.empty());
+    BOOST_REQUIRE(!t.find(tp("a", 0)));
+
+    t.insert(tp("a", 0), md(1));
+    t.insert(tp("a", 3), md(2));
+    t.insert(tp("b", 1), md(3));
+    BOOST_REQUIRE_EQUAL(t.size(), size_t(3));
+    BOOST_REQUIRE_EQUAL(t.find(tp("a", 0))->offset, model::offset(1));
+    BOOST_REQUIRE_EQUAL(t.find(tp("a", 3))->metadata, "m2");
+    BOOST_REQUIRE_EQUAL(t.find(tp("b", 1))->log_offset, model::offset(30));
+    BOOST_REQUIRE(!t.find(tp("a", 1)));
+    BOOST_REQUIRE(!t.find(tp("b", 0)));
+    BOOST_REQUIRE(!t.find(tp("c", 0)));
+
+    // replacing does not change the size
+    t.insert(tp("a", 3), md(4));
+    BOOST_REQUIRE_EQUAL(t.size(), size_t(3));
+    BOOST_REQUIRE_EQUAL(t.find(tp("a", 3))->offset, model::offset(4));
+
+    t.erase(tp("a", 1));
+    t.erase(tp("c", 0));
+    BOOST_REQUIRE_EQUAL(t.size(), size_t(3));
+    t.erase(tp("a", 0));
+    t.erase(tp("b", 1));
+    BOOST_REQUIRE_EQUAL(t.size(), size_t(1));
+    BOOST_REQUIRE(!t.contains(tp("a", 0)));
+    BOOST_REQUIRE(!t.contains(tp("b", 1)));
+    BOOST_REQUIRE(t.contains(tp("a", 3)));
+}
+
+BOOST_AUTO_TEST_CASE(far_partitions_are_kept_aside) {
+    offset_table t;
+    t.insert(tp("a", 1'000'000), md(1));
+    t.insert(tp("a", -1), md(2));
+    for (int i = 0; i < 100; ++i) {
+        t.insert(tp("a", i), md(i));
+    }
+    BOOST_REQUIRE_EQUAL(t.size(), size_t(102));
+    BOOST_REQUIRE_EQUAL(t.find(tp("a", 1'000'000))->offset, model::offset(1));
+    BOOST_REQUIRE_EQUAL(t.find(tp("a", -1))->offset, model::offset(2));
+
+    // a partition kept aside moves to the array once the array reaches it
+    t.insert(tp("a", 300), md(300));
+    for (int i = 100; i < 400; ++i) {
+        t.insert(tp("a", i), md(i));
+    }
+    BOOST_REQUIRE_EQUAL(t.size(), size_t(400 + 2));
+    for (int i = 0; i < 400; ++i) {
+        BOOST_REQUIRE_EQUAL(t.find(tp("a", i))->offset, model::offset(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(for_each_visits_all_offsets) {
+    offset_table t;
+    std::set<std::tuple<ss::sstring, int32_t, int64_t>> expected;
+    for (int i = 0; i < 10; ++i) {
+        t.insert(tp("a", i), md(i));
+        t.insert(tp("b", i * 1000), md(i));
+        expected.emplace("a", i, i);
+        expected.emplace("b", i * 1000, i);
+    }
+    std::set<std::tuple<ss::sstring, int32_t, int64_t>> visited;
+    t.for_each([&visited](
+                 const model::topic& topic,
+                 model::partition_id p,
+                 const offset_metadata& m) {
+        visited.emplace(topic(), p(), m.offset());
+    });
+    BOOST_REQUIRE(visited == expected);
+}
+
+BOOST_AUTO_TEST_CASE(topics_are_interned_per_shard) {
+    auto& topics = interned_topics();
+    auto a = topics.intern(model::topic("interned"));
+    auto b = topics.intern(model::topic("interned"));
+    BOOST_REQUIRE_EQUAL(a.get(), b.get());
+
+    offset_table t1;
+    offset_table t2;
+    t1.insert(tp("shared", 0), md(1));
+    t2.insert(tp("shared", 1), md(2));
+    // held by the interner, both tables and the returned pointer
+    BOOST_REQUIRE_EQUAL(
+      topics.intern(model::topic("shared")).use_count(), 4);
+
+    // unreferenced names are dropped as new names are interned
+    t1 = offset_table();
+    t2 = offset_table();
+    const auto before = topics.size();
+    for (int i = 0; i < 1000; ++i) {
+        topics.intern(model::topic(fmt::format("t{}", i)));
+    }
+    BOOST_REQUIRE_LT(topics.size(), before + 1000);
+}
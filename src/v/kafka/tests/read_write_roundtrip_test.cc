@@ -9,10 +9,13 @@
 
 #include "kafka/requests/request_reader.h"
 #include "kafka/requests/response_writer.h"
+#include "kafka/requests/schemata/heartbeat_request.h"
 #include "random/generators.h"
 #include "utils/to_string.h"
 
 #include <seastar/testing/thread_test_case.hh>
+
+#include <fmt/format.h>
 using namespace kafka; // NOLINT
 
 #define roundtrip_test(value, type_cast, read_method)                          \
@@ -50,3 +53,89 @@ SEASTAR_THREAD_TEST_CASE(write_and_read_value_test) {
     roundtrip_test(
       model::topic{"test_topic"}, ss::sstring, &request_reader::read_string);
 }
+
+SEASTAR_THREAD_TEST_CASE(write_and_read_compact_value_test) {
+    auto out = iobuf();
+    kafka::response_writer w(out);
+    w.write_unsigned_varint(300);
+    w.write_compact(ss::sstring("ab"));
+    w.write_compact(std::optional<ss::sstring>());
+    w.write_compact(model::topic("test_topic"));
+    w.write_tagged_fields();
+    // a length plus one, and the string
+    BOOST_REQUIRE_EQUAL(out.size_bytes(), 2 + 3 + 1 + 11 + 1);
+
+    kafka::request_reader r(std::move(out));
+    BOOST_REQUIRE_EQUAL(r.read_unsigned_varint(), 300);
+    BOOST_REQUIRE_EQUAL(r.read_compact_string(), "ab");
+    BOOST_REQUIRE(!r.read_compact_nullable_string());
+    BOOST_REQUIRE_EQUAL(r.read_compact_string(), "test_topic");
+    r.skip_tagged_fields();
+    BOOST_REQUIRE_EQUAL(r.bytes_left(), 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(generated_codec_versions_roundtrip) {
+    auto roundtrip = [](kafka::api_version version) {
+        kafka::heartbeat_request_data data;
+        data.group_id = kafka::group_id("group");
+        data.generation_id = kafka::generation_id(7);
+        data.member_id = kafka::member_id("member");
+        data.group_instance_id = kafka::group_instance_id("instance");
+        auto out = iobuf();
+        kafka::response_writer w(out);
+        data.encode(w, version);
+        const auto size = out.size_bytes();
+
+        kafka::request_reader r(std::move(out));
+        kafka::heartbeat_request_data decoded;
+        decoded.decode(r, version);
+        BOOST_REQUIRE_EQUAL(r.bytes_left(), 0);
+        BOOST_REQUIRE_EQUAL(decoded.group_id, data.group_id);
+        BOOST_REQUIRE_EQUAL(decoded.generation_id, data.generation_id);
+        BOOST_REQUIRE_EQUAL(decoded.member_id, data.member_id);
+        if (version >= kafka::api_version(3)) {
+            BOOST_REQUIRE_EQUAL(
+              *decoded.group_instance_id, *data.group_instance_id);
+        } else {
+            BOOST_REQUIRE(!decoded.group_instance_id);
+        }
+        return size;
+    };
+    BOOST_REQUIRE_EQUAL(roundtrip(kafka::api_version(0)), 7 + 4 + 8);
+    BOOST_REQUIRE_EQUAL(roundtrip(kafka::api_version(3)), 7 + 4 + 8 + 10);
+    // flexible: compact strings and the empty tagged fields
+    BOOST_REQUIRE_EQUAL(roundtrip(kafka::api_version(4)), 6 + 4 + 7 + 9 + 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(write_fields_between_appended_buffers) {
+    // the layout of the partitions of a fetch response: fields around the
+    // record set of each, over more than a chunk of fields
+    constexpr int partitions = 2000;
+    auto out = iobuf();
+    kafka::response_writer w(out);
+    for (int i = 0; i < partitions; ++i) {
+        w.write(int32_t(i));
+        w.write(model::topic(fmt::format("topic-{}", i)));
+        auto data = random_generators::get_bytes(1024 + i);
+        auto records = iobuf();
+        records.append(data.data(), data.size());
+        if (i % 2) {
+            w.write(std::optional<iobuf>(std::move(records)));
+        } else {
+            w.write(int32_t(records.size_bytes()));
+            w.write_fragments(std::move(records));
+        }
+        w.write(int64_t(i));
+    }
+
+    kafka::request_reader r(std::move(out));
+    for (int i = 0; i < partitions; ++i) {
+        BOOST_REQUIRE_EQUAL(r.read_int32(), i);
+        BOOST_REQUIRE_EQUAL(r.read_string(), fmt::format("topic-{}", i));
+        auto [records, len] = r.read_nullable_iobuf();
+        BOOST_REQUIRE_EQUAL(len, 1024 + i);
+        BOOST_REQUIRE_EQUAL(records.size_bytes(), size_t(1024 + i));
+        BOOST_REQUIRE_EQUAL(r.read_int64(), i);
+    }
+    BOOST_REQUIRE_EQUAL(r.bytes_left(), size_t(0));
+}
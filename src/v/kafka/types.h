@@ -49,6 +49,20 @@ using protocol_type = named_type<ss::sstring, struct kafka_protocol_type>;
 /// Kafka group protocol name.
 using protocol_name = named_type<ss::sstring, struct kafka_protocol>;
 
+/// Kafka incremental fetch session identifier (KIP-227).
+using fetch_session_id = named_type<int32_t, struct kafka_fetch_session_id>;
+
+/// Kafka incremental fetch session epoch (KIP-227).
+using fetch_session_epoch
+  = named_type<int32_t, struct kafka_fetch_session_epoch>;
+
+/// Kafka transactional producer identifier.
+using transactional_id
+  = named_type<ss::sstring, struct kafka_transactional_id>;
+
+/// Kafka idempotent producer identifier (KIP-98).
+using producer_id = named_type<int64_t, struct kafka_producer_id>;
+
 /// An unknown / missing member id (Kafka protocol specific)
 static inline const member_id unknown_member_id("");
 
@@ -106,6 +106,11 @@ struct broker_shard {
     /// however, seastar uses unsized-ints (unsigned)
     /// and for predictability we need fixed-sized ints
     uint32_t shard;
+
+    bool operator==(const broker_shard& other) const {
+        return node_id == other.node_id && shard == other.shard;
+    }
+
     friend std::ostream& operator<<(std::ostream&, const broker_shard&);
 };
 
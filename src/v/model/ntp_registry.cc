@@ -0,0 +1,52 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "model/ntp_registry.h"
+
+#include "vassert.h"
+
+namespace model {
+
+ntp_registry& ntp_registry::local() {
+    static thread_local ntp_registry registry;
+    return registry;
+}
+
+ntp_id ntp_registry::acquire(const model::ntp& ntp) {
+    if (auto it = _ids.find(ntp); it != _ids.end()) {
+        ++_entries[it->second()].refs;
+        return it->second;
+    }
+    ntp_id id;
+    if (!_free.empty()) {
+        id = _free.back();
+        _free.pop_back();
+    } else {
+        id = ntp_id(_entries.size());
+        _entries.emplace_back();
+    }
+    auto& e = _entries[id()];
+    e.ntp = ntp;
+    e.refs = 1;
+    _ids.emplace(ntp, id);
+    return id;
+}
+
+void ntp_registry::release(ntp_id id) {
+    auto& e = _entries[id()];
+    vassert(e.refs > 0, "released ntp id {} is not interned", id);
+    if (--e.refs > 0) {
+        return;
+    }
+    _ids.erase(*e.ntp);
+    e.ntp = std::nullopt;
+    _free.push_back(id);
+}
+
+} // namespace model
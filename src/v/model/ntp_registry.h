@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "model/fundamental.h"
+#include "seastarx.h"
+#include "utils/named_type.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace model {
+
+/// \brief a compact handle of an ntp, valid on the core which interned it
+using ntp_id = named_type<uint32_t, struct ntp_id_tag>;
+
+/**
+ * The ntps interned by the current core, each of which is given a small
+ * integer id. The maps on the hot paths are indexed by the id, so that an
+ * ntp is hashed and compared once, when a request is decoded, instead of
+ * once per map.
+ *
+ * Ids are reference counted by the maps holding them, and the id of a
+ * released ntp is given to the next interned ntp. An id resolved by a
+ * request may thus name another ntp once its partition is removed, which
+ * the holder of the id finds out as it does when the partition moves to
+ * another core.
+ *
+ * Ids are not shared by cores, a request sent to another core carries the
+ * ntp and is resolved again there.
+ */
+class ntp_registry {
+public:
+    ntp_registry() = default;
+    ntp_registry(const ntp_registry&) = delete;
+    ntp_registry& operator=(const ntp_registry&) = delete;
+    ntp_registry(ntp_registry&&) = delete;
+    ntp_registry& operator=(ntp_registry&&) = delete;
+    ~ntp_registry() = default;
+
+    /// interns the ntp, or takes another reference of its id
+    ntp_id acquire(const model::ntp&);
+    /// drops a reference taken by acquire()
+    void release(ntp_id);
+
+    /// the id of an interned ntp
+    std::optional<ntp_id> find(const model::ntp& ntp) const {
+        if (auto it = _ids.find(ntp); it != _ids.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    /// the ntp of an id held by the caller
+    const model::ntp& get(ntp_id id) const { return *_entries[id()].ntp; }
+
+    /// the number of interned ntps
+    size_t size() const { return _ids.size(); }
+
+    /// the registry of the current core
+    static ntp_registry& local();
+
+private:
+    struct entry {
+        std::optional<model::ntp> ntp;
+        uint32_t refs{0};
+    };
+
+    absl::flat_hash_map<model::ntp, ntp_id> _ids;
+    std::vector<entry> _entries;
+    std::vector<ntp_id> _free;
+};
+
+} // namespace model
@@ -255,6 +255,7 @@ public:
     static constexpr uint16_t compression_mask = 0x7;
     static constexpr uint16_t timestamp_type_mask = 0x8;
     static constexpr uint16_t transactional_mask = 0x10;
+    static constexpr uint16_t control_mask = 0x20;
 
     using type = int16_t;
 
@@ -268,6 +269,8 @@ public:
     bool is_transactional() const {
         return maskable_value() & transactional_mask;
     }
+    /// the batch holds the commit or abort marker of a transaction
+    bool is_control() const { return maskable_value() & control_mask; }
     bool is_valid_compression() const {
         auto at = maskable_value() & compression_mask;
         if (at >= 0 && at <= 4) {
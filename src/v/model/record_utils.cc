@@ -116,9 +116,8 @@ static model::record do_parse_one_record_from_buffer(
   int32_t record_size,
   model::record_attributes::type attr,
   ParserData parser_data) {
-    auto [timestamp_delta, tv] = parser.read_varlong();
-    auto [offset_delta, ov] = parser.read_varlong();
-    auto [key_length, kv] = parser.read_varlong();
+    auto [timestamp_delta, offset_delta, key_length]
+      = parser.template read_varlongs<3>();
     iobuf key;
     if (key_length > 0) {
         key = parser_data(parser, key_length);
@@ -172,6 +171,21 @@ model::record parse_one_record_copy_from_buffer(iobuf_const_parser& parser) {
       });
 }
 
+bool verify_record_framing(const record_batch& batch) {
+    iobuf_const_parser parser(batch.data());
+    for (int32_t i = 0; i < batch.record_count(); ++i) {
+        if (parser.bytes_left() == 0) {
+            return false;
+        }
+        auto [record_size, _] = parser.read_varlong();
+        if (record_size < 0 || size_t(record_size) > parser.bytes_left()) {
+            return false;
+        }
+        parser.skip(record_size);
+    }
+    return parser.bytes_left() == 0;
+}
+
 static inline void append_vint_to_iobuf(iobuf& b, int64_t v) {
     auto vb = vint::to_bytes(v);
     b.append(vb.data(), vb.size());
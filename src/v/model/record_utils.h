@@ -34,4 +34,9 @@ model::record parse_one_record_from_buffer(iobuf_parser& parser);
 model::record parse_one_record_copy_from_buffer(iobuf_const_parser& parser);
 void append_record_to_buffer(iobuf& a, const model::record& r);
 
+/// \brief whether the records of an uncompressed batch are framed as its
+/// header says: record_count records whose lengths add up to the size of the
+/// records. Reads the length of each record only, without materializing it.
+bool verify_record_framing(const record_batch&);
+
 } // namespace model
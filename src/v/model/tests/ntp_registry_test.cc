@@ -0,0 +1,47 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE model
+#include "model/fundamental.h"
+#include "model/ntp_registry.h"
+
+#include <boost/test/unit_test.hpp>
+
+static model::ntp make_ntp(int32_t p) {
+    return model::ntp(
+      model::ns("kafka"), model::topic("tapioca"), model::partition_id(p));
+}
+
+BOOST_AUTO_TEST_CASE(test_interned_ntps_have_distinct_ids) {
+    model::ntp_registry registry;
+    auto a = registry.acquire(make_ntp(0));
+    auto b = registry.acquire(make_ntp(1));
+    BOOST_REQUIRE_NE(a, b);
+    BOOST_REQUIRE_EQUAL(registry.get(a), make_ntp(0));
+    BOOST_REQUIRE_EQUAL(registry.get(b), make_ntp(1));
+    BOOST_REQUIRE_EQUAL(*registry.find(make_ntp(1)), b);
+    BOOST_REQUIRE(!registry.find(make_ntp(2)));
+    BOOST_REQUIRE_EQUAL(registry.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_id_released_by_the_last_reference) {
+    model::ntp_registry registry;
+    auto a = registry.acquire(make_ntp(0));
+    BOOST_REQUIRE_EQUAL(registry.acquire(make_ntp(0)), a);
+    registry.release(a);
+    BOOST_REQUIRE_EQUAL(*registry.find(make_ntp(0)), a);
+    registry.release(a);
+    BOOST_REQUIRE(!registry.find(make_ntp(0)));
+    BOOST_REQUIRE_EQUAL(registry.size(), 0);
+
+    // the released id is given to the next ntp
+    auto b = registry.acquire(make_ntp(1));
+    BOOST_REQUIRE_EQUAL(b, a);
+    BOOST_REQUIRE_EQUAL(registry.get(b), make_ntp(1));
+}
@@ -78,3 +78,33 @@ SEASTAR_THREAD_TEST_CASE(set_max_timestamp) {
     BOOST_TEST(crc == batch.header().crc);
     BOOST_TEST(hdr_crc == batch.header().header_crc);
 }
+
+SEASTAR_THREAD_TEST_CASE(verify_record_framing) {
+    auto batch = storage::test::make_random_batch(model::offset(0), 10, false);
+    BOOST_REQUIRE(model::verify_record_framing(batch));
+
+    auto with_records = [&batch](iobuf records, int32_t record_count) {
+        auto h = batch.header();
+        h.record_count = record_count;
+        return model::record_batch(
+          h, std::move(records), model::record_batch::tag_ctor_ng{});
+    };
+    const auto& data = batch.data();
+    const auto count = batch.record_count();
+
+    // truncated
+    auto shorter = data.copy();
+    shorter.trim_back(1);
+    BOOST_TEST(
+      !model::verify_record_framing(with_records(std::move(shorter), count)));
+    // trailing bytes
+    auto longer = data.copy();
+    longer.append("x", 1);
+    BOOST_TEST(
+      !model::verify_record_framing(with_records(std::move(longer), count)));
+    // miscounted
+    BOOST_TEST(!model::verify_record_framing(
+      with_records(data.copy(), count + 1)));
+    BOOST_TEST(!model::verify_record_framing(
+      with_records(data.copy(), count - 1)));
+}
@@ -9,27 +9,73 @@
 
 #include "pandaproxy/client/broker.h"
 
+#include "pandaproxy/client/configuration.h"
 #include "pandaproxy/client/logger.h"
 
+#include <seastar/core/when_all.hh>
+
+#include <algorithm>
+
 namespace pandaproxy::client {
 
+ss::future<kafka::client> make_client(ss::socket_address addr) {
+    auto client = ss::make_lw_shared<kafka::client>(
+      rpc::base_transport::configuration{.server_addr = addr});
+    return client->connect().then(
+      [client]() mutable { return std::move(*client); });
+}
+
+/// \brief Connect the pool of a broker; if any connection fails, those that
+/// succeeded are stopped.
+ss::future<std::vector<kafka::client>> make_clients(ss::socket_address addr) {
+    auto count = std::max<size_t>(shard_local_cfg().broker_connections(), 1);
+    std::vector<ss::future<kafka::client>> futs;
+    futs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        futs.push_back(make_client(addr));
+    }
+    return ss::when_all(futs.begin(), futs.end())
+      .then([](std::vector<ss::future<kafka::client>> res) {
+          std::vector<kafka::client> clients;
+          clients.reserve(res.size());
+          std::exception_ptr ex;
+          for (auto& f : res) {
+              if (f.failed()) {
+                  ex = f.get_exception();
+              } else {
+                  clients.push_back(f.get0());
+              }
+          }
+          if (!ex) {
+              return ss::make_ready_future<std::vector<kafka::client>>(
+                std::move(clients));
+          }
+          return ss::do_with(
+            std::move(clients), [ex](std::vector<kafka::client>& clients) {
+                return ss::parallel_for_each(
+                         clients,
+                         [](kafka::client& c) { return c.stop(); })
+                  .then([ex]() {
+                      return ss::make_exception_future<
+                        std::vector<kafka::client>>(ex);
+                  });
+            });
+      });
+}
+
 ss::future<shared_broker_t>
 make_broker(model::node_id node_id, unresolved_address addr) {
     return addr.resolve()
-      .then([](ss::socket_address addr) {
-          auto client = ss::make_lw_shared<kafka::client>(
-            rpc::base_transport::configuration{.server_addr = addr});
-          return client->connect().then(
-            [client]() mutable { return std::move(client); });
-      })
-      .then([node_id, addr](ss::lw_shared_ptr<kafka::client> client) {
+      .then([](ss::socket_address addr) { return make_clients(addr); })
+      .then([node_id, addr](std::vector<kafka::client> clients) {
           vlog(
             ppclog.info,
-            "connected to broker:{} - {}:{}",
+            "connected to broker:{} - {}:{} with {} connections",
             node_id,
             addr.host(),
-            addr.port());
-          return ss::make_lw_shared<broker>(node_id, std::move(*client));
+            addr.port(),
+            clients.size());
+          return ss::make_lw_shared<broker>(node_id, std::move(clients));
       })
       .handle_exception_type([node_id](const std::system_error& ex) {
           if (
@@ -14,52 +14,42 @@
 #include "kafka/client.h"
 #include "model/metadata.h"
 #include "pandaproxy/client/error.h"
-#include "utils/mutex.h"
 
+#include <seastar/core/future-util.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/core/shared_ptr.hh>
 
 #include <absl/container/flat_hash_set.h>
 
-namespace pandaproxy::client {
-
-struct gated_mutex {
-    gated_mutex()
-      : _mutex{}
-      , _gate{} {}
-
-    template<typename Func>
-    auto with(Func&& func) noexcept {
-        return ss::with_gate(
-          _gate, [this, func{std::forward<Func>(func)}]() mutable {
-              return _mutex.with(
-                [this, func{std::forward<Func>(func)}]() mutable {
-                    _gate.check();
-                    return func();
-                });
-          });
-    }
-
-    ss::future<> close() { return _gate.close(); }
+#include <vector>
 
-    mutex _mutex;
-    ss::gate _gate;
-};
+namespace pandaproxy::client {
 
+/// \brief A pool of connections to a broker.
+///
+/// Requests are pipelined over the connections, and each is dispatched to
+/// the connection with the fewest requests in flight.
 class broker : public ss::enable_lw_shared_from_this<broker> {
 public:
-    broker(model::node_id node_id, kafka::client&& client)
-      : _node_id(node_id)
-      , _client(std::move(client))
-      , _gated_mutex{} {}
+    broker(model::node_id node_id, std::vector<kafka::client>&& clients)
+      : _node_id(node_id) {
+        _connections.reserve(clients.size());
+        for (auto& c : clients) {
+            _connections.emplace_back(std::move(c));
+        }
+    }
 
     template<typename T, typename Ret = typename T::api_type::response_type>
     CONCEPT(requires(KafkaRequest<typename T::api_type>))
     ss::future<Ret> dispatch(T r) {
-        return _gated_mutex
-          .with([this, r{std::move(r)}]() mutable {
-              return _client.dispatch(std::move(r));
-          })
+        return ss::with_gate(
+                 _gate,
+                 [this, r{std::move(r)}]() mutable {
+                     auto& c = next_connection();
+                     ++c.in_flight;
+                     return c.client.dispatch(std::move(r)).finally(
+                       [&c]() { --c.in_flight; });
+                 })
           .handle_exception_type([this](const std::bad_optional_access&) {
               // Short read
               return ss::make_exception_future<Ret>(broker_error(
@@ -70,16 +60,41 @@ public:
 
     model::node_id id() const { return _node_id; }
     ss::future<> stop() {
-        return _gated_mutex.close()
-          .then([this]() { return _client.stop(); })
+        return _gate.close()
+          .then([this]() {
+              return ss::parallel_for_each(
+                _connections, [](connection& c) { return c.client.stop(); });
+          })
           .finally([b = shared_from_this()]() {});
     }
 
 private:
+    struct connection {
+        explicit connection(kafka::client&& c)
+          : client(std::move(c)) {}
+        kafka::client client;
+        size_t in_flight{0};
+    };
+
+    /// \brief The connection with the fewest requests in flight, starting
+    /// the search after the last one chosen so that ties are round-robin.
+    connection& next_connection() {
+        auto n = _connections.size();
+        auto best = _next % n;
+        for (size_t i = 1; i < n; ++i) {
+            auto idx = (_next + i) % n;
+            if (_connections[idx].in_flight < _connections[best].in_flight) {
+                best = idx;
+            }
+        }
+        _next = best + 1;
+        return _connections[best];
+    }
+
     model::node_id _node_id;
-    kafka::client _client;
-    // TODO(Ben): allow overlapped requests
-    gated_mutex _gated_mutex;
+    std::vector<connection> _connections;
+    size_t _next{0};
+    ss::gate _gate;
 };
 
 using shared_broker_t = ss::lw_shared_ptr<broker>;
@@ -44,6 +44,28 @@ ss::future<shared_broker_t> brokers::find(model::topic_partition tp) {
     return ss::make_ready_future<shared_broker_t>(*b_it);
 }
 
+shared_broker_t brokers::leader(const model::topic_partition& tp) const {
+    auto l_it = _leaders.find(tp);
+    if (l_it == _leaders.end()) {
+        return nullptr;
+    }
+    auto b_it = _brokers.find(l_it->second);
+    if (b_it == _brokers.end()) {
+        return nullptr;
+    }
+    return *b_it;
+}
+
+ss::future<int32_t> brokers::partition_count(model::topic t) const {
+    auto it = _partition_counts.find(t);
+    if (it == _partition_counts.end()) {
+        return ss::make_exception_future<int32_t>(partition_error(
+          model::topic_partition(std::move(t), model::partition_id(-1)),
+          kafka::error_code::unknown_topic_or_partition));
+    }
+    return ss::make_ready_future<int32_t>(it->second);
+}
+
 ss::future<> brokers::erase(model::node_id node_id) {
     if (auto b_it = _brokers.find(node_id); b_it != _brokers.end()) {
         auto broker = *b_it;
@@ -89,15 +111,22 @@ ss::future<> brokers::apply(kafka::metadata_response&& res) {
               }
 
               leaders_t leaders;
+              partition_counts_t partition_counts;
               for (const auto& t : topics) {
                   for (auto const& p : t.partitions) {
                       leaders.emplace(
                         model::topic_partition(t.name, p.index), p.leader);
                   }
+                  if (
+                    t.err_code == kafka::error_code::none
+                    && !t.partitions.empty()) {
+                      partition_counts.emplace(t.name, t.partitions.size());
+                  }
               }
 
               std::swap(brokers, _brokers);
               std::swap(leaders, _leaders);
+              std::swap(partition_counts, _partition_counts);
           });
     });
 }
@@ -30,6 +30,7 @@ class brokers {
       = absl::flat_hash_set<shared_broker_t, broker_hash, broker_eq>;
     using leaders_t
       = absl::flat_hash_map<model::topic_partition, model::node_id>;
+    using partition_counts_t = absl::flat_hash_map<model::topic, int32_t>;
 
 public:
     /// \brief stop and wait for all outstanding activity to finish.
@@ -43,6 +44,12 @@ public:
     /// \brief Retrieve the broker for the given topic_partition.
     ss::future<shared_broker_t> find(model::topic_partition tp);
 
+    /// \brief The broker leading the given topic_partition, if it is known.
+    shared_broker_t leader(const model::topic_partition& tp) const;
+
+    /// \brief Retrieve the number of partitions of the given topic.
+    ss::future<int32_t> partition_count(model::topic t) const;
+
     /// \brief Remove a broker.
     ss::future<> erase(model::node_id id);
 
@@ -56,6 +63,8 @@ private:
     size_t _next_broker;
     /// \brief Leaders map a partition to a model::node_id.
     leaders_t _leaders;
+    /// \brief Partition counts map a topic to its number of partitions.
+    partition_counts_t _partition_counts;
 };
 
 } // namespace pandaproxy::client
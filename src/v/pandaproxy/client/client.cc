@@ -104,7 +104,9 @@ ss::future<> client::mitigate_error(std::exception_ptr ex) {
         switch (ex.error) {
         case kafka::error_code::unknown_topic_or_partition:
             [[fallthrough]];
-        case kafka::error_code::leader_not_available: {
+        case kafka::error_code::leader_not_available:
+            [[fallthrough]];
+        case kafka::error_code::not_leader_for_partition: {
             vlog(ppclog.debug, "partition_error: {}", ex.what());
             return _wait_or_start_update_metadata();
         }
@@ -122,6 +124,140 @@ ss::future<> client::mitigate_error(std::exception_ptr ex) {
     return ss::make_exception_future(std::move(ex));
 }
 
+ss::future<int32_t> client::partition_count(model::topic t) {
+    return ss::with_gate(_gate, [this, t{std::move(t)}]() {
+        return retry_with_mitigation(
+          shard_local_cfg().retries(),
+          shard_local_cfg().retry_base_backoff(),
+          [this, t]() {
+              _gate.check();
+              return _brokers.partition_count(t);
+          },
+          [this](std::exception_ptr ex) {
+              return mitigate_error(std::move(ex));
+          });
+    });
+}
+
+kafka::fetch_request make_fetch_request(
+  const model::topic_partition& tp,
+  model::offset offset,
+  int32_t max_bytes,
+  int32_t min_bytes,
+  std::chrono::milliseconds max_wait) {
+    std::vector<kafka::fetch_request::partition> partitions;
+    partitions.push_back(kafka::fetch_request::partition{
+      .id{tp.partition},
+      .current_leader_epoch = -1,
+      .fetch_offset{offset},
+      .log_start_offset{-1},
+      .partition_max_bytes = max_bytes});
+    std::vector<kafka::fetch_request::topic> topics;
+    topics.push_back(kafka::fetch_request::topic{
+      .name{tp.topic}, .partitions{std::move(partitions)}});
+    return kafka::fetch_request{
+      // consumers are not replicas
+      .replica_id{-1},
+      .max_wait_time{max_wait},
+      .min_bytes = min_bytes,
+      .max_bytes = max_bytes,
+      .isolation_level = 0,
+      .session_id = 0,
+      .session_epoch = -1,
+      .topics{std::move(topics)}};
+}
+
+kafka::fetch_response
+make_fetch_response(const model::topic_partition& tp, std::exception_ptr ex) {
+    auto error = kafka::error_code::unknown_server_error;
+    try {
+        std::rethrow_exception(std::move(ex));
+    } catch (const partition_error& ex) {
+        vlog(ppclog.debug, "handling partition_error {}", ex.what());
+        error = ex.error;
+    } catch (const broker_error& ex) {
+        vlog(ppclog.debug, "handling broker_error {}", ex.what());
+        error = ex.error;
+    } catch (const ss::gate_closed_exception&) {
+        vlog(ppclog.debug, "gate_closed_exception");
+        error = kafka::error_code::operation_not_attempted;
+    } catch (const std::exception& ex) {
+        vlog(ppclog.warn, "std::exception {}", ex.what());
+    }
+    std::vector<kafka::fetch_response::partition_response> responses;
+    responses.push_back(kafka::fetch_response::partition_response{
+      .id{tp.partition},
+      .error = error,
+      .high_watermark{-1},
+      .last_stable_offset{-1},
+      .log_start_offset{-1},
+      .aborted_transactions{},
+      .record_set{}});
+    kafka::fetch_response res;
+    res.error = kafka::error_code::none;
+    res.session_id = 0;
+    res.partitions.emplace_back(tp.topic);
+    res.partitions.back().responses = std::move(responses);
+    return res;
+}
+
+ss::future<kafka::fetch_response> client::fetch_partition(
+  model::topic_partition tp,
+  model::offset offset,
+  int32_t max_bytes,
+  int32_t min_bytes,
+  std::chrono::milliseconds max_wait) {
+    vlog(
+      ppclog.debug,
+      "fetch: {}, {{offset: {}, max_bytes: {}, min_bytes: {}, max_wait: {}}}",
+      tp,
+      offset,
+      max_bytes,
+      min_bytes,
+      max_wait.count());
+    auto req = make_fetch_request(tp, offset, max_bytes, min_bytes, max_wait);
+    return ss::with_gate(
+      _gate, [this, tp{std::move(tp)}, req{std::move(req)}]() {
+          return retry_with_mitigation(
+                   shard_local_cfg().retries(),
+                   shard_local_cfg().retry_base_backoff(),
+                   [this, tp, req]() {
+                       _gate.check();
+                       return _brokers.find(tp)
+                         .then([req](shared_broker_t broker) mutable {
+                             return broker->dispatch(std::move(req));
+                         })
+                         .then([tp](kafka::fetch_response res) {
+                             if (
+                               res.partitions.empty()
+                               || res.partitions[0].responses.empty()) {
+                                 throw partition_error(
+                                   tp, kafka::error_code::unknown_server_error);
+                             }
+                             // retry the errors that are mitigated by new
+                             // metadata, and hand the others to the caller
+                             switch (res.partitions[0].responses[0].error) {
+                             case kafka::error_code::unknown_topic_or_partition:
+                                 [[fallthrough]];
+                             case kafka::error_code::leader_not_available:
+                                 [[fallthrough]];
+                             case kafka::error_code::not_leader_for_partition:
+                                 throw partition_error(
+                                   tp, res.partitions[0].responses[0].error);
+                             default:
+                                 return res;
+                             }
+                         });
+                   },
+                   [this](std::exception_ptr ex) {
+                       return mitigate_error(std::move(ex));
+                   })
+            .handle_exception([tp](std::exception_ptr ex) {
+                return make_fetch_response(tp, std::move(ex));
+            });
+      });
+}
+
 ss::future<kafka::produce_response::partition> client::produce_record_batch(
   model::topic_partition tp, model::record_batch&& batch) {
     vlog(
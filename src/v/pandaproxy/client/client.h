@@ -87,6 +87,31 @@ public:
     ss::future<kafka::produce_response::partition> produce_record_batch(
       model::topic_partition tp, model::record_batch&& batch);
 
+    /// \brief The number of partitions of the topic, from the metadata.
+    ss::future<int32_t> partition_count(model::topic t);
+
+    /// \brief The partition of a record produced to the topic without one.
+    ///
+    /// Keyed records are partitioned like the kafka java client, and unkeyed
+    /// records stick to a partition until its batch is consumed.
+    model::partition_id partition(
+      const model::topic& t,
+      const std::optional<iobuf>& key,
+      int32_t partition_count) {
+        return _producer.partition(t, key, partition_count);
+    }
+
+    /// \brief Fetch from a partition, starting at the given offset.
+    ///
+    /// The leader waits up to max_wait for min_bytes to be available. Errors
+    /// of the partition are returned in the response.
+    ss::future<kafka::fetch_response> fetch_partition(
+      model::topic_partition tp,
+      model::offset offset,
+      int32_t max_bytes,
+      int32_t min_bytes,
+      std::chrono::milliseconds max_wait);
+
 private:
     /// \brief Connect and update metdata.
     ss::future<> do_connect(unresolved_address addr);
@@ -28,6 +28,13 @@ configuration::configuration()
       config::required::no,
       config::tls_config(),
       config::tls_config::validate)
+  , broker_connections(
+      *this,
+      "broker_connections",
+      "Number of connections to each broker, over which requests are "
+      "pipelined",
+      config::required::no,
+      2)
   , retries(
       *this,
       "retries",
@@ -57,7 +64,14 @@ configuration::configuration()
       "produce_batch_delay_ms",
       "Delay (in milliseconds) to wait before sending batch",
       config::required::no,
-      100ms) {}
+      100ms)
+  , produce_shared_requests(
+      *this,
+      "produce_shared_requests",
+      "Send the batches of the partitions led by the same broker with a "
+      "single produce request",
+      config::required::no,
+      true) {}
 
 void configuration::read_yaml(const YAML::Node& root_node) {
     if (!root_node["pandaproxy_client"]) {
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/bytes.h"
+#include "bytes/iobuf.h"
+#include "hashing/murmur.h"
+#include "model/fundamental.h"
+#include "random/generators.h"
+#include "vassert.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <optional>
+
+namespace pandaproxy::client {
+
+/// \brief Choose the partition of records produced without one.
+///
+/// Keyed records are partitioned like the kafka java client: the murmur2 of
+/// the key, made positive, modulo the number of partitions.
+///
+/// Unkeyed records stick to a partition of the topic until a batch of that
+/// partition is consumed, and then move to another one, so that they fill
+/// bigger batches.
+class partitioner {
+public:
+    model::partition_id operator()(
+      const model::topic& t,
+      const std::optional<iobuf>& key,
+      int32_t partition_count) {
+        vassert(partition_count > 0, "a topic has at least one partition");
+        if (key) {
+            return model::partition_id(
+              to_positive(hash(*key)) % partition_count);
+        }
+        auto it = _sticky.find(t);
+        if (it == _sticky.end() || it->second() >= partition_count) {
+            it = _sticky.insert_or_assign(t, next(t, partition_count)).first;
+        }
+        return it->second;
+    }
+
+    /// \brief A batch of the partition was consumed; the unkeyed records of
+    /// the topic move to another partition if they stuck to that one.
+    void batch_consumed(const model::topic_partition& tp) {
+        if (auto it = _sticky.find(tp.topic);
+            it != _sticky.end() && it->second == tp.partition) {
+            _sticky.erase(it);
+            _previous.insert_or_assign(tp.topic, tp.partition);
+        }
+    }
+
+private:
+    using sticky_t = absl::flat_hash_map<model::topic, model::partition_id>;
+
+    static uint32_t hash(const iobuf& key) {
+        if (key.begin() != key.end() && std::next(key.begin()) == key.end()) {
+            return murmurhash2(key.begin()->get(), key.size_bytes());
+        }
+        auto b = iobuf_to_bytes(key);
+        return murmurhash2(b.data(), b.size());
+    }
+
+    // like the java client, which masks the sign bit rather than abs()
+    static int32_t to_positive(uint32_t h) { return int32_t(h & 0x7fffffff); }
+
+    /// \brief A random partition, other than the previous one of the topic
+    /// when there are several.
+    model::partition_id
+    next(const model::topic& t, int32_t partition_count) const {
+        auto prev = _previous.find(t);
+        if (
+          partition_count == 1 || prev == _previous.end()
+          || prev->second() >= partition_count) {
+            return model::partition_id(
+              random_generators::get_int<int32_t>(partition_count - 1));
+        }
+        auto p = random_generators::get_int<int32_t>(partition_count - 2);
+        return model::partition_id(p < prev->second() ? p : p + 1);
+    }
+
+    /// \brief The partition the unkeyed records of a topic stick to.
+    sticky_t _sticky;
+    /// \brief The partition they last stuck to, to move away from it.
+    sticky_t _previous;
+};
+
+} // namespace pandaproxy::client
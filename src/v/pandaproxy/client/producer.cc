@@ -18,9 +18,14 @@
 #include "pandaproxy/client/logger.h"
 #include "pandaproxy/client/retry_with_mitigation.h"
 
+#include <seastar/core/future-util.hh>
 #include <seastar/core/gate.hh>
 
+#include <absl/container/flat_hash_map.h>
+
 #include <exception>
+#include <utility>
+#include <vector>
 
 namespace pandaproxy::client {
 
@@ -41,6 +46,29 @@ make_produce_request(model::topic_partition tp, model::record_batch&& batch) {
     return kafka::produce_request(t_id, acks, std::move(topics));
 }
 
+kafka::produce_request
+make_produce_request(std::vector<producer::pending_batch>& batches) {
+    using partitions_t = std::vector<kafka::produce_request::partition>;
+    absl::flat_hash_map<model::topic, partitions_t> partitions;
+    for (auto& b : batches) {
+        partitions[b.tp.topic].emplace_back(kafka::produce_request::partition{
+          .id{b.tp.partition},
+          .data{},
+          .adapter = kafka::kafka_batch_adapter{
+            .v2_format = true, .valid_crc = true, .batch{b.batch.share()}}});
+    }
+
+    std::vector<kafka::produce_request::topic> topics;
+    topics.reserve(partitions.size());
+    for (auto& [name, ps] : partitions) {
+        topics.emplace_back(kafka::produce_request::topic{
+          .name{name}, .partitions{std::move(ps)}});
+    }
+    std::optional<ss::sstring> t_id;
+    int16_t acks = -1;
+    return kafka::produce_request(t_id, acks, std::move(topics));
+}
+
 kafka::produce_response::partition
 make_produce_response(model::partition_id p_id, std::exception_ptr ex) {
     auto response = kafka::produce_response::partition{
@@ -73,6 +101,91 @@ producer::produce(model::topic_partition tp, model::record_batch&& batch) {
     return get_context(std::move(tp))->produce(std::move(batch));
 }
 
+void producer::queue(
+  model::topic_partition tp, model::record_batch&& batch) {
+    _pending.push_back(pending_batch{std::move(tp), std::move(batch)});
+    if (_pending.size() == 1) {
+        // the partitions consumed until the next task, such as those of a
+        // single post or whose linger expired together, share the requests
+        (void)ss::later().then([this] { flush_pending(); });
+    }
+}
+
+void producer::flush_pending() {
+    absl::flat_hash_map<
+      model::node_id,
+      std::pair<shared_broker_t, std::vector<pending_batch>>>
+      by_broker;
+    for (auto& p : std::exchange(_pending, {})) {
+        auto broker = _brokers.leader(p.tp);
+        if (!broker) {
+            // resolved with the mitigation of the retries
+            (void)send(std::move(p.tp), std::move(p.batch));
+            continue;
+        }
+        auto& [b, batches] = by_broker[broker->id()];
+        b = std::move(broker);
+        batches.push_back(std::move(p));
+    }
+    for (auto& [_, e] : by_broker) {
+        auto& [broker, batches] = e;
+        if (batches.size() == 1) {
+            auto& p = batches.front();
+            (void)send(std::move(p.tp), std::move(p.batch));
+            continue;
+        }
+        (void)send_shared(std::move(broker), std::move(batches));
+    }
+}
+
+ss::future<> producer::send_shared(
+  shared_broker_t broker, std::vector<pending_batch> batches) {
+    vlog(
+      ppclog.debug,
+      "send record_batches of {} partitions to broker {}",
+      batches.size(),
+      broker->id());
+    auto req = make_produce_request(batches);
+    return broker->dispatch(std::move(req))
+      .then_wrapped([this, batches{std::move(batches)}](
+                      ss::future<kafka::produce_response> f) mutable {
+          std::vector<bool> sent(batches.size(), false);
+          if (f.failed()) {
+              vlog(
+                ppclog.debug,
+                "shared produce request failed: {}",
+                f.get_exception());
+          } else {
+              absl::flat_hash_map<model::topic_partition, size_t> index;
+              for (size_t i = 0; i < batches.size(); ++i) {
+                  index.emplace(batches[i].tp, i);
+              }
+              auto res = f.get0();
+              for (auto& t : res.topics) {
+                  for (auto& p : t.partitions) {
+                      auto it = index.find(
+                        model::topic_partition(t.name, p.id));
+                      if (
+                        it == index.end() || sent[it->second]
+                        || p.error != kafka::error_code::none) {
+                          continue;
+                      }
+                      sent[it->second] = true;
+                      handle_response(
+                        std::move(batches[it->second].tp), std::move(p));
+                  }
+              }
+          }
+          // the others are retried on their own
+          for (size_t i = 0; i < batches.size(); ++i) {
+              if (!sent[i]) {
+                  (void)send(
+                    std::move(batches[i].tp), std::move(batches[i].batch));
+              }
+          }
+      });
+}
+
 ss::future<kafka::produce_response::partition>
 producer::do_send(model::topic_partition tp, model::record_batch&& batch) {
     return _brokers.find(tp)
@@ -133,8 +246,13 @@ producer::send(model::topic_partition tp, model::record_batch&& batch) {
             tp,
             record_count,
             res.error);
-          get_context(std::move(tp))->handle_response(std::move(res));
+          handle_response(std::move(tp), std::move(res));
       });
 }
 
+void producer::handle_response(
+  model::topic_partition tp, kafka::produce_response::partition res) {
+    get_context(std::move(tp))->handle_response(std::move(res));
+}
+
 } // namespace pandaproxy::client
@@ -12,12 +12,17 @@
 #pragma once
 
 #include "model/fundamental.h"
+#include "pandaproxy/client/broker.h"
+#include "pandaproxy/client/configuration.h"
+#include "pandaproxy/client/partitioner.h"
 #include "pandaproxy/client/produce_batcher.h"
 #include "pandaproxy/client/produce_partition.h"
 #include "ssx/future-util.h"
 
 #include <absl/container/flat_hash_map.h>
 
+#include <vector>
+
 namespace pandaproxy::client {
 
 class brokers;
@@ -38,21 +43,56 @@ public:
     ss::future<kafka::produce_response::partition>
     produce(model::topic_partition tp, model::record_batch&& batch);
 
+    /// \brief The partition of a record produced without one.
+    model::partition_id partition(
+      const model::topic& t,
+      const std::optional<iobuf>& key,
+      int32_t partition_count) {
+        return _partitioner(t, key, partition_count);
+    }
+
     ss::future<> stop() {
         return ssx::parallel_transform(
-          std::move(_partitions),
-          [](partitions_t::value_type p) { return p.second->stop(); });
+                 std::move(_partitions),
+                 [](partitions_t::value_type p) { return p.second->stop(); })
+          .then([this] { flush_pending(); });
     }
 
+    /// \brief A batch consumed from a partition, waiting to be sent.
+    struct pending_batch {
+        model::topic_partition tp;
+        model::record_batch batch;
+    };
+
 private:
+    /// \brief Queue a batch to be sent with those of the other partitions
+    /// consumed meanwhile.
+    void queue(model::topic_partition tp, model::record_batch&& batch);
+
+    /// \brief Send the queued batches, with one request per broker.
+    void flush_pending();
+
+    /// \brief Send the batches of partitions led by the broker with a single
+    /// request, the failed ones being sent again on their own.
+    ss::future<>
+    send_shared(shared_broker_t broker, std::vector<pending_batch> batches);
+
     ss::future<> send(model::topic_partition tp, model::record_batch&& batch);
 
+    void handle_response(
+      model::topic_partition tp, kafka::produce_response::partition res);
+
     ss::future<kafka::produce_response::partition>
     do_send(model::topic_partition tp, model::record_batch&& batch);
 
     auto make_consumer(model::topic_partition tp) {
         return [this, tp](model::record_batch&& batch) {
-            (void)send(tp, std::move(batch));
+            _partitioner.batch_consumed(tp);
+            if (shard_local_cfg().produce_shared_requests()) {
+                queue(tp, std::move(batch));
+            } else {
+                (void)send(tp, std::move(batch));
+            }
         };
     }
 
@@ -67,6 +107,8 @@ private:
 
     absl::flat_hash_map<model::topic_partition, shared_produce_partition>
       _partitions;
+    std::vector<pending_batch> _pending;
+    partitioner _partitioner;
     error_handler _error_handler;
     brokers& _brokers;
 };
@@ -0,0 +1,71 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "pandaproxy/client/partitioner.h"
+
+#include "bytes/iobuf.h"
+#include "model/fundamental.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+namespace ppc = pandaproxy::client;
+
+std::optional<iobuf> make_key(std::string_view v) {
+    iobuf buf;
+    buf.append(v.data(), v.size());
+    return buf;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_partitioner_keyed) {
+    ppc::partitioner partitioner;
+    auto t = model::topic("t");
+
+    // same partitions as the kafka java client
+    BOOST_REQUIRE_EQUAL(
+      partitioner(t, make_key("foobar"), 12), model::partition_id(6));
+    BOOST_REQUIRE_EQUAL(
+      partitioner(t, make_key("21"), 12), model::partition_id(0));
+
+    // a fragmented key hashes like a contiguous one
+    iobuf key;
+    for (auto c : std::string_view("foobar")) {
+        iobuf frag;
+        frag.append(&c, 1);
+        key.append_fragments(std::move(frag));
+    }
+    BOOST_REQUIRE_EQUAL(
+      partitioner(t, std::move(key), 12), model::partition_id(6));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_partitioner_sticky) {
+    ppc::partitioner partitioner;
+    auto t = model::topic("t");
+
+    auto p = partitioner(t, std::nullopt, 12);
+    for (int i = 0; i < 10; ++i) {
+        BOOST_REQUIRE_EQUAL(partitioner(t, std::nullopt, 12), p);
+    }
+
+    // a batch of another partition is consumed
+    partitioner.batch_consumed(
+      model::topic_partition(t, model::partition_id((p() + 1) % 12)));
+    BOOST_REQUIRE_EQUAL(partitioner(t, std::nullopt, 12), p);
+
+    // the batch of the sticky partition is consumed
+    partitioner.batch_consumed(model::topic_partition(t, p));
+    auto next = partitioner(t, std::nullopt, 12);
+    BOOST_REQUIRE_NE(next, p);
+    BOOST_REQUIRE_EQUAL(partitioner(t, std::nullopt, 12), next);
+
+    // topics stick independently
+    auto other = model::topic("other");
+    BOOST_REQUIRE_EQUAL(
+      partitioner(other, std::nullopt, 1), model::partition_id(0));
+    BOOST_REQUIRE_EQUAL(partitioner(t, std::nullopt, 12), next);
+}
@@ -0,0 +1,53 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "kafka/requests/metadata_request.h"
+#include "model/fundamental.h"
+#include "pandaproxy/client/client.h"
+#include "pandaproxy/client/configuration.h"
+#include "pandaproxy/client/test/pandaproxy_client_fixture.h"
+#include "ssx/future-util.h"
+
+#include <boost/range/irange.hpp>
+
+#include <vector>
+
+namespace ppc = pandaproxy::client;
+
+FIXTURE_TEST(pandaproxy_client_pipelining, ppc_test_fixture) {
+    info("Waiting for leadership");
+    wait_for_controller_leadership().get();
+
+    auto tp = model::topic_partition(model::topic("t"), model::partition_id(0));
+    auto ntp = make_default_ntp(tp.topic, tp.partition);
+    add_topic(model::topic_namespace_view(ntp)).get();
+
+    for (size_t connections : {1, 3}) {
+        info("Dispatching concurrently over {} connections", connections);
+        ppc::shard_local_cfg().broker_connections.set_value(connections);
+        auto client = make_connected_client();
+
+        // more requests than connections, so that they are pipelined
+        auto responses = ssx::parallel_transform(
+                           boost::irange(0, 32),
+                           [this, &client](int) {
+                               return client.dispatch(make_list_topics_req());
+                           })
+                           .get();
+
+        BOOST_REQUIRE_EQUAL(responses.size(), 32);
+        for (const auto& res : responses) {
+            BOOST_REQUIRE_EQUAL(res.topics.size(), 1);
+            BOOST_REQUIRE_EQUAL(res.topics[0].name(), "t");
+        }
+
+        info("Stopping client");
+        client.stop().get();
+    }
+}
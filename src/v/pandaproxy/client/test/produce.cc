@@ -84,3 +84,49 @@ FIXTURE_TEST(pandaproxy_produce_reconnect, ppc_test_fixture) {
 
     client.stop().get();
 }
+
+FIXTURE_TEST(pandaproxy_produce_shared_requests, ppc_test_fixture) {
+    using namespace std::chrono_literals;
+
+    info("Waiting for leadership");
+    wait_for_controller_leadership().get();
+
+    auto tp_a = model::topic_partition(
+      model::topic("a"), model::partition_id(0));
+    auto tp_b = model::topic_partition(
+      model::topic("b"), model::partition_id(0));
+    for (const auto& tp : {tp_a, tp_b}) {
+        auto ntp = make_default_ntp(tp.topic, tp.partition);
+        add_topic(model::topic_namespace_view(ntp)).get();
+    }
+
+    ppc::shard_local_cfg().retry_base_backoff.set_value(10ms);
+    ppc::shard_local_cfg().retries.set_value(size_t(10));
+    ppc::shard_local_cfg().produce_batch_record_count.set_value(2);
+    ppc::shard_local_cfg().produce_batch_size_bytes.set_value(1024);
+    ppc::shard_local_cfg().produce_batch_delay.set_value(1000ms);
+    ppc::shard_local_cfg().produce_shared_requests.set_value(true);
+
+    info("Connecting client");
+    auto client = make_connected_client();
+    client.connect().get();
+
+    info("Producing to both topics");
+    // consumed together, both partitions are led by the only broker
+    auto req_a_fut = client.produce_record_batch(
+      tp_a, make_batch(model::offset(0), 2));
+    auto req_b_fut = client.produce_record_batch(
+      tp_b, make_batch(model::offset(0), 2));
+
+    info("Waiting for results");
+    auto req_a = req_a_fut.get();
+    auto req_b = req_b_fut.get();
+
+    info("Testing assertions");
+    BOOST_REQUIRE_EQUAL(req_a.error, kafka::error_code::none);
+    BOOST_REQUIRE_EQUAL(req_a.id, tp_a.partition);
+    BOOST_REQUIRE_EQUAL(req_b.error, kafka::error_code::none);
+    BOOST_REQUIRE_EQUAL(req_b.id, tp_b.partition);
+
+    client.stop().get();
+}
@@ -9,12 +9,19 @@
 
 #include "handlers.h"
 
+#include "kafka/requests/kafka_batch_adapter.h"
+#include "model/record_utils.h"
+#include "pandaproxy/client/error.h"
+#include "pandaproxy/json/iobuf.h"
+#include "pandaproxy/json/requests/fetch.h"
 #include "pandaproxy/json/requests/produce.h"
 #include "pandaproxy/json/rjson_util.h"
 #include "pandaproxy/reply.h"
 #include "raft/types.h"
 #include "ssx/future-util.h"
+#include "storage/parser_utils.h"
 #include "storage/record_batch_builder.h"
+#include "units.h"
 
 #include <seastar/core/future.hh>
 
@@ -22,6 +29,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <algorithm>
+#include <charconv>
 #include <chrono>
 
 namespace ppj = pandaproxy::json;
@@ -74,29 +82,25 @@ get_topics_names(server::request_t rq, server::reply_t rp) {
                 return model::topic_view(e.name);
             });
 
-          auto json_rslt = ppj::rjson_serialize(names);
-          rp.rep->write_body("json", json_rslt);
+          rp.body = ppj::rjson_serialize_iobuf(names);
           return std::move(rp);
       });
 }
 
-ss::future<server::reply_t>
-post_topics_name(server::request_t rq, server::reply_t rp) {
-    auto fmt = parse_serialization_format(rq.req->get_header("Accept"));
-    if (fmt == serialization_format::unsupported) {
-        rp.rep = unprocessable_entity("Unsupported serialization format");
-        return ss::make_ready_future<server::reply_t>(std::move(rp));
-    }
-
-    auto raw_records = ppj::rjson_parse(
-      rq.req->content.data(), ppj::produce_request_handler(fmt));
-
+ss::future<server::reply_t> produce_records(
+  model::topic topic,
+  int32_t partition_count,
+  std::vector<ppj::record> raw_records,
+  server::request_t rq,
+  server::reply_t rp) {
     absl::flat_hash_map<model::partition_id, storage::record_batch_builder>
       partition_builders;
 
     for (auto& r : raw_records) {
+        auto id = r.id ? *r.id
+                       : rq.ctx.client.partition(topic, r.key, partition_count);
         auto it = partition_builders
-                    .try_emplace(r.id, raft::data_batch_type, model::offset(0))
+                    .try_emplace(id, raft::data_batch_type, model::offset(0))
                     .first;
         it->second.add_raw_kv(
           std::move(r.key).value_or(iobuf{}),
@@ -115,7 +119,6 @@ post_topics_name(server::request_t rq, server::reply_t rp) {
             .batch = std::move(pb.second).build()}});
     }
 
-    auto topic = model::topic(rq.req->param["topic_name"]);
     return ssx::parallel_transform(
              std::move(partitions),
              [topic,
@@ -133,8 +136,186 @@ post_topics_name(server::request_t rq, server::reply_t rp) {
             .topics{std::move(topics)},
             .throttle{std::chrono::milliseconds{0}}};
 
-          auto json_rslt = ppj::rjson_serialize(res.topics[0]);
-          rp.rep->write_body("json", json_rslt);
+          rp.body = ppj::rjson_serialize_iobuf(res.topics[0]);
+          return std::move(rp);
+      });
+}
+
+ss::future<server::reply_t>
+post_topics_name(server::request_t rq, server::reply_t rp) {
+    auto fmt = parse_serialization_format(rq.req->get_header("Accept"));
+    if (fmt == serialization_format::unsupported) {
+        rp.rep = unprocessable_entity("Unsupported serialization format");
+        return ss::make_ready_future<server::reply_t>(std::move(rp));
+    }
+
+    // Take ownership of the body rather than copying it, and parse it in
+    // place; the records are decoded into buffers of their own
+    iobuf body;
+    body.append(std::move(rq.req->content).release());
+    auto raw_records = ppj::rjson_parse(
+      body, ppj::produce_request_handler(fmt));
+    body.clear();
+
+    auto topic = model::topic(rq.req->param["topic_name"]);
+
+    // the partitioner needs the partition count of the topic only for the
+    // records produced without a partition
+    auto partition_count = std::any_of(
+                             raw_records.begin(),
+                             raw_records.end(),
+                             [](const ppj::record& r) { return !r.id; })
+                             ? rq.ctx.client.partition_count(topic)
+                             : ss::make_ready_future<int32_t>(0);
+    return partition_count.then([topic,
+                                 raw_records{std::move(raw_records)},
+                                 rq{std::move(rq)},
+                                 rp{std::move(rp)}](
+                                  int32_t partition_count) mutable {
+        return produce_records(
+          std::move(topic),
+          partition_count,
+          std::move(raw_records),
+          std::move(rq),
+          std::move(rp));
+    });
+}
+
+template<typename T>
+std::optional<T> parse_param(std::string_view v, T default_value) {
+    if (v.empty()) {
+        return default_value;
+    }
+    T res{};
+    auto [ptr, ec] = std::from_chars(v.begin(), v.end(), res);
+    if (ec != std::errc() || ptr != v.end()) {
+        return std::nullopt;
+    }
+    return res;
+}
+
+/// Split a fetched record set into its batches; a trailing batch truncated
+/// by max_bytes is dropped, and will be fetched in full next time.
+std::vector<model::record_batch> make_record_batches(iobuf record_set) {
+    std::vector<model::record_batch> batches;
+    iobuf_const_parser parser(record_set);
+    size_t pos{0};
+    while (parser.bytes_left() >= kafka::internal::kafka_header_size) {
+        parser.skip(sizeof(int64_t)); // base offset
+        auto batch_length = parser.consume_be_type<int32_t>();
+        if (batch_length < 0 || parser.bytes_left() < size_t(batch_length)) {
+            break;
+        }
+        parser.skip(batch_length);
+        auto size = sizeof(int64_t) + sizeof(int32_t) + batch_length;
+        kafka::kafka_batch_adapter kba;
+        kba.adapt(record_set.share(pos, size));
+        pos += size;
+        if (!kba.v2_format || !kba.valid_crc || !kba.batch) {
+            throw std::runtime_error("Invalid record batch");
+        }
+        batches.push_back(std::move(*kba.batch));
+    }
+    return batches;
+}
+
+/// Share the keys and values of the records at or after offset.
+std::vector<ppj::fetched_record> make_fetched_records(
+  std::vector<model::record_batch> batches, model::offset offset) {
+    std::vector<ppj::fetched_record> records;
+    for (auto& b : batches) {
+        auto base_offset = b.base_offset();
+        auto record_count = b.record_count();
+        iobuf_parser parser(std::move(b).release_data());
+        for (int32_t i = 0; i < record_count; ++i) {
+            auto r = model::parse_one_record_from_buffer(parser);
+            auto o = base_offset + model::offset(r.offset_delta());
+            if (o < offset) {
+                continue;
+            }
+            records.push_back(ppj::fetched_record{
+              .offset = o,
+              .key = r.key_size() < 0 ? std::nullopt
+                                      : std::make_optional(r.release_key()),
+              .value = r.value_size() < 0
+                         ? std::nullopt
+                         : std::make_optional(r.release_value())});
+        }
+    }
+    return records;
+}
+
+ss::future<server::reply_t> get_topics_name_partitions_id_records(
+  server::request_t rq, server::reply_t rp) {
+    auto fmt = parse_serialization_format(rq.req->get_header("Accept"));
+    if (fmt != serialization_format::binary_v2) {
+        rp.rep = unprocessable_entity("Unsupported serialization format");
+        return ss::make_ready_future<server::reply_t>(std::move(rp));
+    }
+
+    auto topic = model::topic(rq.req->param["topic_name"]);
+    auto partition = parse_param<int32_t>(rq.req->param["partition_id"], -1);
+    auto offset = parse_param<int64_t>(rq.req->get_query_param("offset"), -1);
+    auto timeout = parse_param<int32_t>(
+      rq.req->get_query_param("timeout"), 1000);
+    auto max_bytes = parse_param<int32_t>(
+      rq.req->get_query_param("max_bytes"), 1_MiB);
+    auto min_bytes = parse_param<int32_t>(
+      rq.req->get_query_param("min_bytes"), 1);
+    if (
+      !partition || *partition < 0 || !offset || *offset < 0 || !timeout
+      || *timeout < 0 || !max_bytes || *max_bytes <= 0 || !min_bytes
+      || *min_bytes < 0) {
+        rp.rep = unprocessable_entity("Invalid parameter");
+        return ss::make_ready_future<server::reply_t>(std::move(rp));
+    }
+    rq.req.reset();
+
+    auto tp = model::topic_partition(
+      std::move(topic), model::partition_id(*partition));
+    auto start = model::offset(*offset);
+    return rq.ctx.client
+      .fetch_partition(
+        tp,
+        start,
+        *max_bytes,
+        *min_bytes,
+        std::chrono::milliseconds(*timeout))
+      .then([start](kafka::fetch_response res) {
+          auto& p = res.partitions[0].responses[0];
+          if (p.error != kafka::error_code::none) {
+              return ss::make_exception_future<
+                std::vector<model::record_batch>>(
+                client::partition_error(
+                  model::topic_partition(
+                    std::move(res.partitions[0].name), p.id),
+                  p.error));
+          }
+          auto batches = p.record_set
+                           ? make_record_batches(std::move(*p.record_set))
+                           : std::vector<model::record_batch>{};
+          return ssx::parallel_transform(
+            std::move(batches), [](model::record_batch b) {
+                if (b.compressed()) {
+                    return storage::internal::decompress_batch(std::move(b));
+                }
+                return ss::make_ready_future<model::record_batch>(
+                  std::move(b));
+            });
+      })
+      .then_wrapped([tp{std::move(tp)}, start, rp{std::move(rp)}](
+                      ss::future<std::vector<model::record_batch>> f) mutable {
+          try {
+              auto records = make_fetched_records(f.get0(), start);
+              // the body is sized up front, and moved rather than copied
+              iobuf body;
+              body.append(
+                ppj::binary_v2_records_writer(tp.topic, tp.partition)(records)
+                  .release());
+              rp.body = std::move(body);
+          } catch (const client::partition_error& e) {
+              rp.rep = unprocessable_entity(e.what());
+          }
           return std::move(rp);
       });
 }
@@ -24,4 +24,7 @@ get_topics_names(server::request_t rq, server::reply_t rp);
 ss::future<server::reply_t>
 post_topics_name(server::request_t rq, server::reply_t rp);
 
+ss::future<server::reply_t>
+get_topics_name_partitions_id_records(server::request_t rq, server::reply_t rp);
+
 } // namespace pandaproxy
@@ -13,10 +13,15 @@
 
 #include "bytes/iobuf.h"
 #include "bytes/iobuf_parser.h"
+#include "pandaproxy/json/rjson_util.h"
 #include "pandaproxy/json/types.h"
 #include "pandaproxy/types.h"
+#include "vassert.h"
+
+#include <seastar/core/temporary_buffer.hh>
 
 #include <libbase64.h>
+
 #include <optional>
 
 namespace pandaproxy::json {
@@ -40,17 +45,24 @@ public:
         }
     }
 
+    /// decodes into a buffer that is then owned by the iobuf, without an
+    /// intermediate copy
     inline std::pair<bool, std::optional<iobuf>>
     decode_base64(std::string_view v) {
-        std::vector<char> decoded(v.length());
+        // every 4 characters, possibly padded, decode to at most 3 bytes
+        ss::temporary_buffer<char> decoded((v.length() + 3) / 4 * 3);
         size_t out_len{};
         if (
           0
-          == base64_decode(v.data(), v.length(), decoded.data(), &out_len, 0)) {
+          == base64_decode(
+            v.data(), v.length(), decoded.get_write(), &out_len, 0)) {
             return {false, std::nullopt};
         }
+        decoded.trim(out_len);
         auto buf = std::make_optional<iobuf>();
-        buf->append(decoded.data(), out_len);
+        if (out_len) {
+            buf->append(std::move(decoded));
+        }
         return {true, std::move(buf)};
     };
 
@@ -58,4 +70,91 @@ private:
     serialization_format _fmt;
 };
 
+/// size of the base64 encoding of n bytes, including the padding
+constexpr size_t base64_encoded_size(size_t n) { return (n + 2) / 3 * 4; }
+
+/// base64 encodes the fragments of buf directly into out, which must hold
+/// base64_encoded_size(buf.size_bytes()) characters; returns the end of the
+/// encoding
+inline char* encode_base64(const iobuf& buf, char* out) {
+    base64_state state{};
+    base64_stream_encode_init(&state, 0);
+    size_t out_len{};
+    for (const auto& frag : buf) {
+        base64_stream_encode(&state, frag.get(), frag.size(), out, &out_len);
+        out += out_len;
+    }
+    base64_stream_encode_final(&state, out, &out_len);
+    return out + out_len;
+}
+
+/// rapidjson input stream over the fragments of an iobuf, so that a body
+/// can be parsed without first being linearized
+class iobuf_istream {
+public:
+    using Ch = char;
+
+    explicit iobuf_istream(const iobuf& buf)
+      : _it(buf.begin())
+      , _end(buf.end()) {
+        skip_empty();
+    }
+
+    Ch Peek() const { return _it == _end ? '\0' : _it->get()[_pos]; }
+
+    Ch Take() {
+        if (_it == _end) {
+            return '\0';
+        }
+        auto c = _it->get()[_pos];
+        ++_offset;
+        if (++_pos == _it->size()) {
+            ++_it;
+            _pos = 0;
+            skip_empty();
+        }
+        return c;
+    }
+
+    size_t Tell() const { return _offset; }
+
+    // Only required for in-situ parsing, which is not supported
+    Ch* PutBegin() {
+        vassert(false, "iobuf_istream is read only");
+        return nullptr;
+    }
+    void Put(Ch) { vassert(false, "iobuf_istream is read only"); }
+    void Flush() { vassert(false, "iobuf_istream is read only"); }
+    size_t PutEnd(Ch*) {
+        vassert(false, "iobuf_istream is read only");
+        return 0;
+    }
+
+private:
+    void skip_empty() {
+        while (_it != _end && _it->size() == 0) {
+            ++_it;
+        }
+    }
+
+    iobuf::const_iterator _it;
+    iobuf::const_iterator _end;
+    size_t _pos{0};
+    size_t _offset{0};
+};
+
+template<typename Handler>
+CONCEPT(requires std::is_same_v<
+        decltype(std::declval<Handler>().result),
+        typename Handler::rjson_parse_result>)
+typename Handler::rjson_parse_result
+  rjson_parse(const iobuf& buf, Handler&& handler) {
+    rapidjson::Reader reader;
+    iobuf_istream is(buf);
+    if (!reader.Parse(is, handler)) {
+        throw parse_error(reader.GetErrorOffset());
+    }
+    return std::move(handler.result);
+}
+
 } // namespace pandaproxy::json
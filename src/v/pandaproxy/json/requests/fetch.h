@@ -0,0 +1,131 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "model/fundamental.h"
+#include "pandaproxy/json/iobuf.h"
+#include "seastarx.h"
+#include "vassert.h"
+
+#include <seastar/core/sstring.hh>
+
+#include <fmt/format.h>
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace pandaproxy::json {
+
+struct fetched_record {
+    model::offset offset;
+    std::optional<iobuf> key;
+    std::optional<iobuf> value;
+};
+
+/// \brief Serialize fetched records as application/vnd.kafka.binary.v2+json
+///
+/// The size of the body is computed up front, and the keys and values are
+/// base64 encoded straight into it, so that no document is built and the
+/// body is never reallocated.
+///
+/// The topic is written unescaped, as kafka topic names are restricted to
+/// [a-zA-Z0-9._-].
+class binary_v2_records_writer {
+public:
+    binary_v2_records_writer(
+      const model::topic& topic, model::partition_id partition)
+      : _topic(topic)
+      , _partition(partition) {}
+
+    ss::sstring operator()(const std::vector<fetched_record>& records) const {
+        ss::sstring body(ss::sstring::initialized_later{}, size(records));
+        char* out = body.data();
+        *out++ = '[';
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (i != 0) {
+                *out++ = ',';
+            }
+            out = write(records[i], out);
+        }
+        *out++ = ']';
+        vassert(
+          out == body.data() + body.size(),
+          "binary_v2 body size mismatch: {} != {}",
+          out - body.data(),
+          body.size());
+        return body;
+    }
+
+private:
+    static constexpr std::string_view topic_key = R"({"topic":")";
+    static constexpr std::string_view key_key = R"(","key":)";
+    static constexpr std::string_view value_key = R"(,"value":)";
+    static constexpr std::string_view partition_key = R"(,"partition":)";
+    static constexpr std::string_view offset_key = R"(,"offset":)";
+    static constexpr std::string_view null = "null";
+
+    static size_t size(const std::optional<iobuf>& buf) {
+        return buf ? base64_encoded_size(buf->size_bytes()) + 2 : null.size();
+    }
+
+    size_t size(const fetched_record& r) const {
+        return topic_key.size() + _topic().size() + key_key.size()
+               + size(r.key) + value_key.size() + size(r.value)
+               + partition_key.size()
+               + fmt::formatted_size("{}", _partition()) + offset_key.size()
+               + fmt::formatted_size("{}", r.offset()) + 1;
+    }
+
+    size_t size(const std::vector<fetched_record>& records) const {
+        size_t n = 2 + (records.empty() ? 0 : records.size() - 1);
+        for (const auto& r : records) {
+            n += size(r);
+        }
+        return n;
+    }
+
+    static char* write(std::string_view v, char* out) {
+        return std::copy(v.begin(), v.end(), out);
+    }
+
+    static char* write(const std::optional<iobuf>& buf, char* out) {
+        if (!buf) {
+            return write(null, out);
+        }
+        *out++ = '"';
+        out = encode_base64(*buf, out);
+        *out++ = '"';
+        return out;
+    }
+
+    char* write(const fetched_record& r, char* out) const {
+        out = write(topic_key, out);
+        out = write(_topic(), out);
+        out = write(key_key, out);
+        out = write(r.key, out);
+        out = write(value_key, out);
+        out = write(r.value, out);
+        out = write(partition_key, out);
+        out = fmt::format_to(out, "{}", _partition());
+        out = write(offset_key, out);
+        out = fmt::format_to(out, "{}", r.offset());
+        *out++ = '}';
+        return out;
+    }
+
+    const model::topic& _topic;
+    model::partition_id _partition;
+};
+
+} // namespace pandaproxy::json
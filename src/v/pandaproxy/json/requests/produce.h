@@ -28,7 +28,8 @@
 namespace pandaproxy::json {
 
 struct record {
-    model::partition_id id;
+    /// \brief unset when the partitioner chooses
+    std::optional<model::partition_id> id;
     std::optional<iobuf> key;
     std::optional<iobuf> value;
 };
@@ -152,9 +153,9 @@ public:
     bool EndArray(rapidjson::SizeType) { return state == state::records; }
 };
 
-inline void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w,
-  const kafka::produce_response::partition& v) {
+template<typename Buffer>
+void rjson_serialize(
+  rapidjson::Writer<Buffer>& w, const kafka::produce_response::partition& v) {
     w.StartObject();
     w.Key("partition");
     w.Int(v.id);
@@ -167,9 +168,9 @@ inline void rjson_serialize(
     w.EndObject();
 }
 
-inline void rjson_serialize(
-  rapidjson::Writer<rapidjson::StringBuffer>& w,
-  const kafka::produce_response::topic& v) {
+template<typename Buffer>
+void rjson_serialize(
+  rapidjson::Writer<Buffer>& w, const kafka::produce_response::topic& v) {
     w.StartObject();
     w.Key("offsets");
     w.StartArray();
@@ -0,0 +1,56 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "pandaproxy/json/requests/fetch.h"
+
+#include "model/fundamental.h"
+#include "seastarx.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+namespace ppj = pandaproxy::json;
+
+iobuf make_fragmented(std::string_view v) {
+    // a fragment per byte, so that base64 carries across fragments
+    iobuf buf;
+    for (auto c : v) {
+        iobuf frag;
+        frag.append(&c, 1);
+        buf.append_fragments(std::move(frag));
+    }
+    return buf;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_fetch_binary_v2_records) {
+    std::vector<ppj::fetched_record> records;
+    records.push_back(ppj::fetched_record{
+      .offset = model::offset(41),
+      .key = std::nullopt,
+      .value = make_fragmented("vectorized")});
+    records.push_back(ppj::fetched_record{
+      .offset = model::offset(42),
+      .key = make_fragmented("key"),
+      .value = make_fragmented("pandaproxy")});
+
+    auto expected
+      = R"([{"topic":"topic","key":null,"value":"dmVjdG9yaXplZA==","partition":1,"offset":41},)"
+        R"({"topic":"topic","key":"a2V5","value":"cGFuZGFwcm94eQ==","partition":1,"offset":42}])";
+
+    auto topic = model::topic("topic");
+    auto body = ppj::binary_v2_records_writer(topic, model::partition_id(1))(
+      records);
+    BOOST_TEST(body == expected);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_fetch_binary_v2_records_empty) {
+    auto topic = model::topic("topic");
+    auto body = ppj::binary_v2_records_writer(topic, model::partition_id(1))(
+      {});
+    BOOST_TEST(body == "[]");
+}
@@ -12,6 +12,7 @@
 #include "kafka/requests/produce_request.h"
 #include "kafka/requests/response.h"
 #include "model/timestamp.h"
+#include "pandaproxy/json/iobuf.h"
 #include "pandaproxy/json/rjson_util.h"
 #include "seastarx.h"
 
@@ -54,6 +55,52 @@ SEASTAR_THREAD_TEST_CASE(test_produce_request) {
     BOOST_TEST(records[1].id == model::partition_id(1));
 }
 
+SEASTAR_THREAD_TEST_CASE(test_produce_request_fragmented) {
+    std::string_view input = R"(
+      {
+        "records": [
+          {
+            "value": "dmVjdG9yaXplZA==",
+            "partition": 0
+          }
+        ]
+      })";
+
+    // split the body, including the value, over fragments of a few bytes
+    iobuf body;
+    for (size_t i = 0; i < input.size(); i += 7) {
+        iobuf frag;
+        frag.append(ss::temporary_buffer<char>(
+          input.data() + i, std::min<size_t>(7, input.size() - i)));
+        body.append_fragments(std::move(frag));
+    }
+
+    auto records = ppj::rjson_parse(body, make_binary_v2_handler());
+    BOOST_TEST(records.size() == 1);
+    BOOST_TEST(!!records[0].value);
+
+    auto parser = iobuf_parser(std::move(*records[0].value));
+    auto value = parser.read_string(parser.bytes_left());
+    BOOST_TEST(value == "vectorized");
+    BOOST_TEST(records[0].id == model::partition_id(0));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_produce_request_fragmented_error) {
+    iobuf body;
+    for (std::string_view frag : {R"({"records": [{"val)", R"(ue": 42}]})"}) {
+        iobuf buf;
+        buf.append(frag.data(), frag.size());
+        body.append_fragments(std::move(buf));
+    }
+
+    BOOST_CHECK_EXCEPTION(
+      ppj::rjson_parse(body, make_binary_v2_handler()),
+      ppj::parse_error,
+      [](ppj::parse_error const& e) {
+          return e.what() == std::string_view("parse error at offset 25");
+      });
+}
+
 SEASTAR_THREAD_TEST_CASE(test_produce_request_empty) {
     auto input = R"(
       {
@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include "bytes/iobuf.h"
+#include "json/iobuf_writer.h"
 #include "json/json.h"
 #include "utils/concepts-enabled.h"
 
@@ -47,6 +49,20 @@ ss::sstring rjson_serialize(const T& v) {
     return ss::sstring(str_buf.GetString(), str_buf.GetSize());
 }
 
+/// as rjson_serialize, into the fragments of an iobuf rather than a
+/// contiguous string, for bodies that are large or may be compressed
+template<typename T>
+iobuf rjson_serialize_iobuf(const T& v) {
+    ::json::iobuf_ostream os;
+    ::json::iobuf_writer wrt(os);
+
+    using ::json::rjson_serialize;
+    using ::pandaproxy::json::rjson_serialize;
+    rjson_serialize(wrt, v);
+
+    return std::move(os).release();
+}
+
 template<typename Handler>
 CONCEPT(requires std::is_same_v<
         decltype(std::declval<Handler>().result),
@@ -10,9 +10,13 @@
 #include "pandaproxy/json/iobuf.h"
 
 #include "bytes/iobuf_parser.h"
+#include "model/fundamental.h"
+#include "pandaproxy/reply.h"
 
 #include <seastar/testing/thread_test_case.hh>
 
+#include <fmt/format.h>
+
 namespace pp = pandaproxy;
 namespace ppj = pp::json;
 
@@ -31,3 +35,28 @@ SEASTAR_THREAD_TEST_CASE(test_iobuf_parse_binary_error) {
     BOOST_REQUIRE(!res);
     BOOST_REQUIRE(!buf);
 }
+
+SEASTAR_THREAD_TEST_CASE(test_iobuf_serialize) {
+    std::vector<model::topic_view> topics;
+    // larger than a fragment, so that the body is not contiguous
+    std::vector<ss::sstring> names;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back(fmt::format("topic-{}", i));
+    }
+    for (const auto& n : names) {
+        topics.emplace_back(n);
+    }
+    auto buf = ppj::rjson_serialize_iobuf(topics);
+    iobuf_parser p(std::move(buf));
+    BOOST_TEST(p.read_string(p.bytes_left()) == ppj::rjson_serialize(topics));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_accepts_gzip) {
+    BOOST_TEST(pp::accepts_gzip("gzip"));
+    BOOST_TEST(pp::accepts_gzip("deflate, gzip;q=1.0, *;q=0.5"));
+    BOOST_TEST(pp::accepts_gzip(" gzip ;q=0.5"));
+    BOOST_TEST(!pp::accepts_gzip(""));
+    BOOST_TEST(!pp::accepts_gzip("deflate, br"));
+    BOOST_TEST(!pp::accepts_gzip("gzip;q=0"));
+    BOOST_TEST(!pp::accepts_gzip("br, gzip; q=0.00"));
+}
@@ -9,6 +9,7 @@
 
 #include "pandaproxy/proxy.h"
 
+#include "pandaproxy/api/api-doc/get_topics_name_partitions_id_records.json.h"
 #include "pandaproxy/api/api-doc/get_topics_names.json.h"
 #include "pandaproxy/api/api-doc/health.json.h"
 #include "pandaproxy/api/api-doc/post_topics_name.json.h"
@@ -42,6 +43,12 @@ std::vector<server::route_t> get_proxy_routes() {
       ss::httpd::post_topics_name_json::post_topics_name,
       post_topics_name});
 
+    routes.emplace_back(server::route_t{
+      "get_topics_name_partitions_id_records",
+      ss::httpd::get_topics_name_partitions_id_records_json::
+        get_topics_name_partitions_id_records,
+      get_topics_name_partitions_id_records});
+
     return routes;
 }
 
@@ -11,15 +11,23 @@
 
 #pragma once
 
+#include "bytes/iobuf.h"
+#include "compression/compression.h"
+#include "pandaproxy/client/error.h"
 #include "pandaproxy/json/requests/error_reply.h"
 #include "pandaproxy/json/rjson_util.h"
 #include "pandaproxy/logger.h"
 #include "seastarx.h"
 
 #include <seastar/core/gate.hh>
+#include <seastar/core/iostream.hh>
+#include <seastar/core/loop.hh>
 #include <seastar/core/sstring.hh>
 #include <seastar/http/reply.hh>
 
+#include <algorithm>
+#include <string_view>
+
 namespace pandaproxy {
 
 inline ss::httpd::reply& set_reply_unavailable(ss::httpd::reply& rep) {
@@ -46,6 +54,74 @@ inline std::unique_ptr<ss::httpd::reply> unprocessable_entity(ss::sstring msg) {
     return rep;
 }
 
+/// bodies from this size are gzip encoded for the clients that accept it,
+/// smaller ones are not worth the cpu
+inline constexpr size_t gzip_min_body_bytes = 1024;
+
+/// whether an Accept-Encoding header lists gzip, and does not refuse it with
+/// a zero weight
+inline bool accepts_gzip(std::string_view accept_encoding) {
+    auto trim = [](std::string_view v) {
+        auto first = v.find_first_not_of(' ');
+        if (first == v.npos) {
+            return std::string_view{};
+        }
+        return v.substr(first, v.find_last_not_of(' ') - first + 1);
+    };
+    while (!accept_encoding.empty()) {
+        auto coding = accept_encoding.substr(0, accept_encoding.find(','));
+        accept_encoding.remove_prefix(
+          std::min(accept_encoding.size(), coding.size() + 1));
+        auto params = coding.find(';');
+        if (trim(coding.substr(0, params)) != "gzip") {
+            continue;
+        }
+        if (params == coding.npos) {
+            return true;
+        }
+        auto q = trim(coding.substr(params + 1));
+        return q.substr(0, 2) != "q="
+               || q.find_first_not_of("0.", 2) != q.npos;
+    }
+    return false;
+}
+
+/// \brief streams the fragments of body to the client, gzip encoded if
+/// requested and the body is large enough, without first copying it into
+/// a contiguous string
+inline ss::future<std::unique_ptr<ss::httpd::reply>>
+write_body(std::unique_ptr<ss::httpd::reply> rep, iobuf body, bool gzip) {
+    auto encode = [gzip, &rep](iobuf body) {
+        if (!gzip || body.size_bytes() < gzip_min_body_bytes) {
+            return ss::make_ready_future<iobuf>(std::move(body));
+        }
+        rep->add_header("Content-Encoding", "gzip");
+        return ss::do_with(std::move(body), [](const iobuf& body) {
+            return compression::compressor::compress_async(
+              body, compression::type::gzip);
+        });
+    };
+    return encode(std::move(body))
+      .then([rep = std::move(rep)](iobuf body) mutable {
+          rep->write_body(
+            "json",
+            [body = std::move(body)](ss::output_stream<char>&& out) mutable {
+                return ss::do_with(
+                  std::move(out),
+                  std::move(body),
+                  [](ss::output_stream<char>& out, const iobuf& body) {
+                      return ss::do_for_each(
+                               body,
+                               [&out](const iobuf::fragment& f) {
+                                   return out.write(f.get(), f.size());
+                               })
+                        .then([&out] { return out.close(); });
+                  });
+            });
+          return std::move(rep);
+      });
+}
+
 inline std::unique_ptr<ss::httpd::reply> exception_reply(std::exception_ptr e) {
     try {
         std::rethrow_exception(e);
@@ -53,6 +129,8 @@ inline std::unique_ptr<ss::httpd::reply> exception_reply(std::exception_ptr e) {
         return reply_unavailable();
     } catch (const pandaproxy::json::parse_error& e) {
         return unprocessable_entity(e.what());
+    } catch (const pandaproxy::client::partition_error& e) {
+        return unprocessable_entity(e.what());
     } catch (...) {
         vlog(plog.error, "{}", std::current_exception());
         throw;
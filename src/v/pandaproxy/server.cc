@@ -71,21 +71,38 @@ struct handler_adaptor : ss::httpd::handler_base {
               server::request_t rq{std::move(req), this->_ctx};
               server::reply_t rp{std::move(rep)};
               auto req_size = get_request_size(*rq.req);
+              // the handler may drop the request before its reply is ready
+              const bool gzip = accepts_gzip(
+                get_header(*rq.req, "Accept-Encoding"));
 
               return ss::with_semaphore(
                        _ctx.mem_sem,
                        req_size,
-                       [this, rq{std::move(rq)}, rp{std::move(rp)}]() mutable {
+                       [this,
+                        gzip,
+                        rq{std::move(rq)},
+                        rp{std::move(rp)}]() mutable {
                            if (_ctx.as.abort_requested()) {
                                set_reply_unavailable(*rp.rep);
                                return ss::make_ready_future<
                                  std::unique_ptr<ss::reply>>(std::move(rp.rep));
                            }
                            return _handler(std::move(rq), std::move(rp))
-                             .then([](server::reply_t rp) {
-                                 rp.rep->set_mime_type(
+                             .then([gzip](server::reply_t rp) {
+                                 if (!rp.body) {
+                                     return ss::make_ready_future<
+                                       std::unique_ptr<ss::reply>>(
+                                       std::move(rp.rep));
+                                 }
+                                 return write_body(
+                                   std::move(rp.rep),
+                                   std::move(*rp.body),
+                                   gzip);
+                             })
+                             .then([](std::unique_ptr<ss::reply> rep) {
+                                 rep->set_mime_type(
                                    "application/vnd.kafka.binary.v2+json");
-                                 return std::move(rp.rep);
+                                 return rep;
                              });
                        })
                 .finally([m{std::move(m)}]() {});
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include "bytes/iobuf.h"
 #include "pandaproxy/context.h"
 #include "seastarx.h"
 
@@ -26,6 +27,7 @@
 #include <seastar/util/noncopyable_function.hh>
 
 #include <memory>
+#include <optional>
 
 namespace pandaproxy {
 
@@ -46,6 +48,9 @@ public:
 
     struct reply_t {
         std::unique_ptr<ss::httpd::reply> rep;
+        // a body streamed to the client once the handler is done, gzip
+        // encoded if the client accepts it
+        std::optional<iobuf> body;
         // will contains other extensions passed to user specific handler.
     };
 
@@ -0,0 +1,658 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "config/configuration.h"
+#include "model/metadata.h"
+#include "model/record_batch_reader.h"
+#include "raft/consensus.h"
+#include "raft/consensus_client_protocol.h"
+#include "raft/heartbeat_manager.h"
+#include "raft/rpc_client_protocol.h"
+#include "raft/service.h"
+#include "raft/types.h"
+#include "random/generators.h"
+#include "rpc/backoff_policy.h"
+#include "rpc/connection_cache.h"
+#include "rpc/server.h"
+#include "rpc/simple_protocol.h"
+#include "storage/api.h"
+#include "storage/record_batch_builder.h"
+#include "syschecks/syschecks.h"
+#include "units.h"
+#include "utils/hdr_hist.h"
+#include "utils/unresolved_address.h"
+#include "vlog.h"
+
+#include <seastar/core/app-template.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/memory.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/util/defer.hh>
+
+#include <absl/container/flat_hash_map.h>
+#include <boost/range/irange.hpp>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Replicates batches over N raft groups hosted by M in-process nodes, which
+// talk over loopback rpc, and reports the throughput and the latency
+// percentiles of replicate as json, e.g.
+//
+//   raft_bench -c 4 --groups 64 --nodes 3 --concurrency 4 --acks quorum \
+//     --heartbeat-interval-ms 150 --batch-latency-target-ms 2 --output r.json
+//
+// Every node hosts every group, each group on shard group % cores, and sends
+// the heartbeats of all of its groups from a heartbeat_manager per shard.
+// Replicate requests go through the replicate_batcher of the leaders, so that
+// requests in flight to the same group are coalesced into a flush. Comparing
+// --acks leader against --acks quorum gives the cost of the round trip to the
+// followers.
+
+namespace ch = std::chrono;
+static ss::logger lgr{"raft_bench"};
+
+using clock_type = ch::steady_clock;
+using consensus_ptr = ss::lw_shared_ptr<raft::consensus>;
+
+void cli_opts(boost::program_options::options_description_easy_init o) {
+    namespace po = boost::program_options;
+    o("groups",
+      po::value<int32_t>()->default_value(16),
+      "number of raft groups");
+    o("nodes",
+      po::value<int32_t>()->default_value(3),
+      "number of nodes hosting every group");
+    o("duration-s",
+      po::value<uint32_t>()->default_value(30),
+      "duration of the load in seconds");
+    o("concurrency",
+      po::value<size_t>()->default_value(4),
+      "replicate requests in flight per group");
+    o("batch-records",
+      po::value<size_t>()->default_value(10),
+      "records per replicated batch");
+    o("record-size",
+      po::value<size_t>()->default_value(1024),
+      "bytes of the value of a record");
+    o("acks",
+      po::value<std::string>()->default_value("quorum"),
+      "consistency level of replicate: quorum or leader");
+    o("heartbeat-interval-ms",
+      po::value<int32_t>()->default_value(150),
+      "raft heartbeat interval");
+    o("batch-latency-target-ms",
+      po::value<int32_t>()->default_value(
+        config::shard_local_cfg().replicate_batch_latency_target_ms().count()),
+      "latency target of the replicate_batcher");
+    o("base-port",
+      po::value<uint16_t>()->default_value(36000),
+      "rpc port of the first node, the others take the next ones");
+    o("workdir",
+      po::value<std::string>()->default_value("."),
+      "directory of the logs of the nodes");
+    o("output",
+      po::value<std::string>()->default_value(""),
+      "file to write the json results to, stdout when empty");
+}
+
+struct bench_cfg {
+    int32_t groups;
+    int32_t nodes;
+    ch::seconds duration;
+    size_t concurrency;
+    size_t batch_records;
+    size_t record_size;
+    raft::consistency_level acks;
+    ch::milliseconds heartbeat_interval;
+    ch::milliseconds batch_latency_target;
+    uint16_t base_port;
+    ss::sstring workdir;
+    std::string output;
+};
+
+bench_cfg cfg_from(const boost::program_options::variables_map& m) {
+    auto acks = m["acks"].as<std::string>();
+    if (acks != "quorum" && acks != "leader") {
+        throw std::invalid_argument(
+          fmt::format("--acks must be quorum or leader, got {}", acks));
+    }
+    return bench_cfg{
+      .groups = m["groups"].as<int32_t>(),
+      .nodes = m["nodes"].as<int32_t>(),
+      .duration = ch::seconds(m["duration-s"].as<uint32_t>()),
+      .concurrency = m["concurrency"].as<size_t>(),
+      .batch_records = m["batch-records"].as<size_t>(),
+      .record_size = m["record-size"].as<size_t>(),
+      .acks = acks == "quorum" ? raft::consistency_level::quorum_ack
+                               : raft::consistency_level::leader_ack,
+      .heartbeat_interval = ch::milliseconds(
+        m["heartbeat-interval-ms"].as<int32_t>()),
+      .batch_latency_target = ch::milliseconds(
+        m["batch-latency-target-ms"].as<int32_t>()),
+      .base_port = m["base-port"].as<uint16_t>(),
+      .workdir = fmt::format(
+        "{}/raft_bench.{}",
+        m["workdir"].as<std::string>(),
+        random_generators::gen_alphanum_string(6)),
+      .output = m["output"].as<std::string>(),
+    };
+}
+
+struct shard_lookup {
+    ss::shard_id shard_for(raft::group_id g) { return g() % ss::smp::count; }
+    bool contains(raft::group_id) { return true; }
+};
+
+/// the groups of a node on a shard
+class group_manager {
+public:
+    group_manager(
+      model::node_id self,
+      ss::sstring directory,
+      ch::milliseconds heartbeat_interval,
+      ss::sharded<rpc::connection_cache>& clients)
+      : _self(self)
+      , _client_protocol(raft::make_rpc_client_protocol(self, clients))
+      , _storage(
+          storage::kvstore_config(
+            1_MiB,
+            ch::milliseconds(10),
+            directory,
+            storage::debug_sanitize_files::no),
+          storage::log_config(
+            storage::log_config::storage_type::disk,
+            directory,
+            1_GiB,
+            storage::debug_sanitize_files::no))
+      , _hbeats(heartbeat_interval, _client_protocol, self)
+      , _election_timeout(heartbeat_interval * 2) {}
+
+    ss::future<> start() {
+        return _storage.start().then([this] { return _hbeats.start(); });
+    }
+
+    ss::future<> stop() {
+        return ss::parallel_for_each(
+                 _groups,
+                 [this](auto& e) {
+                     return _hbeats.deregister_group(e.first).then(
+                       [c = e.second] { return c->stop(); });
+                 })
+          .then([this] { return _hbeats.stop(); })
+          .then([this] { return _storage.stop(); });
+    }
+
+    /// creates the groups of this shard
+    ss::future<> add_groups(
+      std::vector<raft::group_id> groups,
+      std::vector<model::broker> brokers) {
+        return ss::do_with(
+                 std::move(groups),
+                 std::move(brokers),
+                 [this](
+                   std::vector<raft::group_id>& groups,
+                   std::vector<model::broker>& brokers) {
+                     return ss::do_for_each(
+                       groups, [this, &brokers](raft::group_id g) {
+                           return add_group(g, brokers);
+                       });
+                 })
+          .then([this] {
+              std::vector<consensus_ptr> groups;
+              groups.reserve(_groups.size());
+              for (auto& [_, c] : _groups) {
+                  groups.push_back(c);
+              }
+              return _hbeats.register_groups(std::move(groups));
+          });
+    }
+
+    consensus_ptr consensus_for(raft::group_id g) {
+        auto it = _groups.find(g);
+        return it == _groups.end() ? nullptr : it->second;
+    }
+
+private:
+    ss::future<>
+    add_group(raft::group_id g, const std::vector<model::broker>& brokers) {
+        auto ntp = model::ntp(
+          model::ns("raft_bench"),
+          model::topic(fmt::format("group_{}", g())),
+          model::partition_id(0));
+        return _storage.log_mgr()
+          .manage(
+            storage::ntp_config(ntp, _storage.log_mgr().config().base_dir))
+          .then([this, g, brokers](storage::log log) {
+              auto c = ss::make_lw_shared<raft::consensus>(
+                _self,
+                g,
+                raft::group_configuration(brokers),
+                raft::timeout_jitter(_election_timeout),
+                log,
+                ss::default_priority_class(),
+                ch::seconds(10),
+                _client_protocol,
+                [](raft::leadership_status) {},
+                _storage);
+              _groups.emplace(g, c);
+              return c->start();
+          });
+    }
+
+    model::node_id _self;
+    raft::consensus_client_protocol _client_protocol;
+    storage::api _storage;
+    raft::heartbeat_manager _hbeats;
+    ch::milliseconds _election_timeout;
+    absl::flat_hash_map<raft::group_id, consensus_ptr> _groups;
+};
+
+/// the rpc server, clients and groups of a node
+class bench_node {
+public:
+    bench_node(model::broker broker, const bench_cfg& cfg)
+      : _broker(std::move(broker))
+      , _cfg(cfg) {}
+
+    void start_in_thread(const std::vector<model::broker>& brokers) {
+        _clients.start().get();
+        for (auto& b : brokers) {
+            if (b.id() != _broker.id()) {
+                connect_to_in_thread(b);
+            }
+        }
+        _groups
+          .start(
+            _broker.id(),
+            fmt::format("{}/{}", _cfg.workdir, _broker.id()),
+            _cfg.heartbeat_interval,
+            std::ref(_clients))
+          .get();
+        _groups.invoke_on_all(&group_manager::start).get();
+
+        rpc::server_configuration scfg("raft_bench_rpc");
+        scfg.addrs = {_broker.rpc_address().resolve().get0()};
+        scfg.max_service_memory_per_core = ss::memory::stats().total_memory()
+                                           / 4;
+        scfg.disable_metrics = rpc::metrics_disabled::yes;
+        _server.start(std::move(scfg)).get();
+        _server
+          .invoke_on_all([this](rpc::server& s) {
+              auto proto = std::make_unique<rpc::simple_protocol>();
+              proto->register_service<
+                raft::service<group_manager, shard_lookup>>(
+                ss::default_scheduling_group(),
+                ss::default_smp_service_group(),
+                _groups,
+                _shard_table);
+              s.set_protocol(std::move(proto));
+          })
+          .get();
+        _server.invoke_on_all(&rpc::server::start).get();
+        _started = true;
+    }
+
+    /// creates every group on its shard
+    void add_groups_in_thread(const std::vector<model::broker>& brokers) {
+        _groups
+          .invoke_on_all([this, brokers](group_manager& m) {
+              std::vector<raft::group_id> groups;
+              for (int32_t g = 0; g < _cfg.groups; ++g) {
+                  if (_shard_table.shard_for(raft::group_id(g))
+                      == ss::this_shard_id()) {
+                      groups.emplace_back(g);
+                  }
+              }
+              return m.add_groups(std::move(groups), brokers);
+          })
+          .get();
+    }
+
+    void stop_in_thread() {
+        if (!_started) {
+            return;
+        }
+        _server.stop().get();
+        _groups.invoke_on_all(&group_manager::stop).get();
+        _groups.stop().get();
+        _clients.stop().get();
+    }
+
+    ss::sharded<group_manager>& groups() { return _groups; }
+
+private:
+    void connect_to_in_thread(const model::broker& b) {
+        auto addr = b.rpc_address().resolve().get0();
+        for (ss::shard_id i = 0; i < ss::smp::count; ++i) {
+            auto shard = rpc::connection_cache::shard_for(
+              _broker.id(), i, b.id());
+            _clients
+              .invoke_on(
+                shard,
+                [id = b.id(), addr](rpc::connection_cache& c) {
+                    if (c.contains(id)) {
+                        return ss::now();
+                    }
+                    return c.emplace(
+                      id,
+                      {.server_addr = addr,
+                       .disable_metrics = rpc::metrics_disabled::yes},
+                      rpc::make_exponential_backoff_policy<rpc::clock_type>(
+                        ch::milliseconds(1), ch::milliseconds(100)));
+                })
+              .get();
+        }
+    }
+
+    model::broker _broker;
+    const bench_cfg& _cfg;
+    bool _started{false};
+    shard_lookup _shard_table;
+    ss::sharded<rpc::connection_cache> _clients;
+    ss::sharded<rpc::server> _server;
+    ss::sharded<group_manager> _groups;
+};
+
+struct replicate_stats {
+    hdr_hist latency;
+    uint64_t requests{0};
+    uint64_t errors{0};
+    uint64_t bytes{0};
+    uint64_t leader_lookups{0};
+
+    replicate_stats& operator+=(const replicate_stats& o) {
+        latency += o.latency;
+        requests += o.requests;
+        errors += o.errors;
+        bytes += o.bytes;
+        leader_lookups += o.leader_lookups;
+        return *this;
+    }
+};
+
+/// replicates over the groups of its shard
+class bench_driver {
+public:
+    bench_driver(
+      const bench_cfg& cfg, std::vector<ss::sharded<group_manager>*> nodes)
+      : _cfg(cfg)
+      , _nodes(std::move(nodes))
+      , _payload(random_generators::get_bytes(_cfg.record_size)) {}
+
+    ss::future<> run() {
+        _deadline = clock_type::now() + _cfg.duration;
+        std::vector<std::pair<raft::group_id, size_t>> loops;
+        for (int32_t g = 0; g < _cfg.groups; ++g) {
+            if (shard_lookup{}.shard_for(raft::group_id(g))
+                != ss::this_shard_id()) {
+                continue;
+            }
+            for (size_t i = 0; i < _cfg.concurrency; ++i) {
+                loops.emplace_back(raft::group_id(g), i);
+            }
+        }
+        return ss::do_with(std::move(loops), [this](auto& loops) {
+            return ss::parallel_for_each(loops, [this](auto& l) {
+                return replicate_loop(l.first);
+            });
+        });
+    }
+
+    /// the leader of g on this shard, if any
+    consensus_ptr leader(raft::group_id g) const {
+        for (auto* n : _nodes) {
+            auto c = n->local().consensus_for(g);
+            if (c && c->is_leader()) {
+                return c;
+            }
+        }
+        return nullptr;
+    }
+
+    /// whether every group of this shard has a leader
+    bool has_leaders() const {
+        for (int32_t g = 0; g < _cfg.groups; ++g) {
+            if (
+              shard_lookup{}.shard_for(raft::group_id(g)) == ss::this_shard_id()
+              && !leader(raft::group_id(g))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const replicate_stats& stats() const { return _stats; }
+
+    ss::future<> stop() { return ss::now(); }
+
+private:
+    model::record_batch make_batch() const {
+        storage::record_batch_builder builder(
+          raft::data_batch_type, model::offset(0));
+        for (size_t i = 0; i < _cfg.batch_records; ++i) {
+            iobuf value;
+            value.append(_payload.data(), _payload.size());
+            builder.add_raw_kv(iobuf(), std::move(value));
+        }
+        return std::move(builder).build();
+    }
+
+    ss::future<> replicate_loop(raft::group_id g) {
+        return ss::do_with(consensus_ptr{}, [this, g](consensus_ptr& c) {
+            return ss::do_until(
+              [this] { return clock_type::now() >= _deadline; },
+              [this, g, &c] {
+                  if (!c || !c->is_leader()) {
+                      c = leader(g);
+                      ++_stats.leader_lookups;
+                      if (!c) {
+                          return ss::sleep(_cfg.heartbeat_interval);
+                      }
+                  }
+                  return replicate_one(c);
+              });
+        });
+    }
+
+    ss::future<> replicate_one(consensus_ptr c) {
+        auto bytes = _cfg.batch_records * _cfg.record_size;
+        auto m = _stats.latency.auto_measure();
+        return c
+          ->replicate(
+            model::make_memory_record_batch_reader(make_batch()),
+            raft::replicate_options(_cfg.acks))
+          .then_wrapped(
+            [this, bytes, m = std::move(m), c](
+              ss::future<result<raft::replicate_result>> f) mutable {
+                ++_stats.requests;
+                bool failed = f.failed();
+                if (failed) {
+                    vlog(lgr.debug, "replicate failed: {}", f.get_exception());
+                } else {
+                    failed = f.get0().has_error();
+                }
+                if (failed) {
+                    m->set_trace(false);
+                    ++_stats.errors;
+                    return;
+                }
+                _stats.bytes += bytes;
+            });
+    }
+
+    const bench_cfg& _cfg;
+    std::vector<ss::sharded<group_manager>*> _nodes;
+    bytes _payload;
+    clock_type::time_point _deadline;
+    replicate_stats _stats;
+};
+
+std::string results_json(
+  const bench_cfg& cfg, const replicate_stats& s, double seconds) {
+    rapidjson::StringBuffer buf;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> w(buf);
+    w.StartObject();
+    w.Key("config");
+    w.StartObject();
+    w.Key("groups");
+    w.Int(cfg.groups);
+    w.Key("nodes");
+    w.Int(cfg.nodes);
+    w.Key("cores");
+    w.Uint(ss::smp::count);
+    w.Key("concurrency_per_group");
+    w.Uint64(cfg.concurrency);
+    w.Key("batch_records");
+    w.Uint64(cfg.batch_records);
+    w.Key("record_size");
+    w.Uint64(cfg.record_size);
+    w.Key("acks");
+    w.String(
+      cfg.acks == raft::consistency_level::quorum_ack ? "quorum" : "leader");
+    w.Key("heartbeat_interval_ms");
+    w.Int64(cfg.heartbeat_interval.count());
+    w.Key("batch_latency_target_ms");
+    w.Int64(cfg.batch_latency_target.count());
+    w.EndObject();
+    w.Key("duration_sec");
+    w.Double(seconds);
+    w.Key("replicate");
+    w.StartObject();
+    w.Key("requests");
+    w.Uint64(s.requests);
+    w.Key("errors");
+    w.Uint64(s.errors);
+    w.Key("leader_lookups");
+    w.Uint64(s.leader_lookups);
+    w.Key("requests_per_sec");
+    w.Double(double(s.requests - s.errors) / seconds);
+    w.Key("mb_per_sec");
+    w.Double(double(s.bytes) / seconds / (1024 * 1024));
+    w.Key("latency_us");
+    w.StartObject();
+    for (auto [key, p] : {
+           std::make_pair("p50", 50.0),
+           std::make_pair("p90", 90.0),
+           std::make_pair("p99", 99.0),
+           std::make_pair("p999", 99.9),
+           std::make_pair("max", 100.0),
+         }) {
+        w.Key(key);
+        w.Int64(s.latency.get_value_at(p));
+    }
+    w.Key("mean");
+    w.Double(s.latency.mean());
+    w.EndObject();
+    w.EndObject();
+    w.EndObject();
+    return buf.GetString();
+}
+
+void write_results_in_thread(const bench_cfg& cfg, const std::string& json) {
+    if (cfg.output.empty()) {
+        std::cout << json << std::endl;
+        return;
+    }
+    auto f = ss::open_file_dma(
+               cfg.output,
+               ss::open_flags::wo | ss::open_flags::create
+                 | ss::open_flags::truncate)
+               .get0();
+    auto out = ss::make_file_output_stream(std::move(f)).get0();
+    out.write(json).get();
+    out.close().get();
+}
+
+int main(int args, char** argv, char** env) {
+    syschecks::initialize_intrinsics();
+    std::setvbuf(stdout, nullptr, _IOLBF, 1024);
+    ss::app_template app;
+    cli_opts(app.add_options());
+    ss::sharded<bench_driver> drivers;
+    return app.run(args, argv, [&] {
+        auto& m = app.configuration();
+        return ss::async([&] {
+            const bench_cfg cfg = cfg_from(m);
+            // every node registers the same group metrics
+            ss::smp::invoke_on_all([&cfg] {
+                auto& c = config::shard_local_cfg();
+                c.get("disable_metrics").set_value(true);
+                c.get("replicate_batch_latency_target_ms")
+                  .set_value(cfg.batch_latency_target);
+            }).get();
+
+            std::vector<model::broker> brokers;
+            for (int32_t n = 0; n < cfg.nodes; ++n) {
+                auto addr = unresolved_address("127.0.0.1", cfg.base_port + n);
+                brokers.emplace_back(
+                  model::node_id(n),
+                  addr,
+                  addr,
+                  std::nullopt,
+                  model::broker_properties{.cores = ss::smp::count});
+            }
+            std::vector<std::unique_ptr<bench_node>> nodes;
+            auto stop_nodes = ss::defer([&nodes] {
+                for (auto& n : nodes) {
+                    n->stop_in_thread();
+                }
+            });
+            for (auto& b : brokers) {
+                nodes.push_back(std::make_unique<bench_node>(b, cfg));
+                nodes.back()->start_in_thread(brokers);
+            }
+            for (auto& n : nodes) {
+                n->add_groups_in_thread(brokers);
+            }
+
+            std::vector<ss::sharded<group_manager>*> managers;
+            for (auto& n : nodes) {
+                managers.push_back(&n->groups());
+            }
+            drivers.start(std::cref(cfg), managers).get();
+            auto stop_drivers = ss::defer([&drivers] { drivers.stop().get(); });
+
+            vlog(lgr.info, "waiting for the leaders of {} groups", cfg.groups);
+            while (!drivers
+                      .map_reduce0(
+                        [](const bench_driver& d) { return d.has_leaders(); },
+                        true,
+                        std::logical_and<>())
+                      .get0()) {
+                ss::sleep(cfg.heartbeat_interval).get();
+            }
+
+            vlog(lgr.info, "running for {}s", cfg.duration.count());
+            auto begin = clock_type::now();
+            drivers.invoke_on_all(&bench_driver::run).get();
+            auto seconds = ch::duration<double>(clock_type::now() - begin)
+                             .count();
+
+            // the loads are over, the stats of the other shards are only read
+            replicate_stats total;
+            for (ss::shard_id s = 0; s < ss::smp::count; ++s) {
+                drivers
+                  .invoke_on(
+                    s,
+                    [&total](const bench_driver& d) { total += d.stats(); })
+                  .get();
+            }
+            write_results_in_thread(cfg, results_json(cfg, total, seconds));
+        });
+    });
+}
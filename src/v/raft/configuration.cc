@@ -75,6 +75,14 @@ bool group_configuration::is_voter(model::node_id id) const {
     return old_it != std::cend(_old->voters);
 }
 
+bool group_configuration::is_learner(model::node_id id) const {
+    auto contains = [id](const std::vector<model::node_id>& ids) {
+        return std::find(std::cbegin(ids), std::cend(ids), id)
+               != std::cend(ids);
+    };
+    return contains(_current.learners) || (_old && contains(_old->learners));
+}
+
 bool group_configuration::contains_broker(model::node_id id) const {
     auto it = std::find_if(
       std::cbegin(_brokers),
@@ -141,14 +149,27 @@ void group_configuration::add(std::vector<model::broker> brokers) {
         }
     }
 
-    // FIXME: add to learners when we will implement learners promotion
-    _old = _current;
     for (auto& b : brokers) {
-        _current.voters.push_back(b.id());
+        _current.learners.push_back(b.id());
         _brokers.push_back(std::move(b));
     }
 }
 
+void group_configuration::promote_to_voter(model::node_id id) {
+    vassert(
+      !_old, "can not promote learner in joint configuration - {}", *this);
+    auto it = std::find(
+      std::cbegin(_current.learners), std::cend(_current.learners), id);
+    if (unlikely(it == std::cend(_current.learners))) {
+        throw std::invalid_argument(fmt::format(
+          "node {} is not a learner in configuration {}", id, *this));
+    }
+
+    _old = _current;
+    _current.learners.erase(it);
+    _current.voters.push_back(id);
+}
+
 void group_configuration::remove(const std::vector<model::node_id>& ids) {
     vassert(
       !_old, "can not remove broker from joint configuration - {}", *this);
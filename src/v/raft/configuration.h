@@ -65,13 +65,29 @@ public:
     bool is_voter(model::node_id) const;
 
     /**
-     * Configuration manipulation API. Each operation cause the configuration to
-     * become joint configuration.
+     * Check if node with given id replicates the log without voting
+     */
+    bool is_learner(model::node_id) const;
+
+    /**
+     * Configuration manipulation API. Each operation except add cause the
+     * configuration to become joint configuration.
      */
-    void add(std::vector<model::broker>);
     void remove(const std::vector<model::node_id>&);
     void replace(std::vector<model::broker>);
 
+    /**
+     * Adds brokers as learners. Learners do not account to majority so the
+     * configuration stays simple, they become voters with promote_to_voter.
+     */
+    void add(std::vector<model::broker>);
+
+    /**
+     * Makes the learner a voter, the configuration becomes joint as the
+     * majority changes
+     */
+    void promote_to_voter(model::node_id);
+
     /**
      * Updating broker configuration. This operation does not require entering
      * joint consensus as it never change majority
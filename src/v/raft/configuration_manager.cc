@@ -48,8 +48,7 @@ ss::future<> configuration_manager::truncate(model::offset offset) {
         _configurations.erase(it, _configurations.end());
 
         _highest_known_offset = std::min(offset, _highest_known_offset);
-        return store_highest_known_offset().then(
-          [this] { return store_configurations(); });
+        return store_configurations();
     });
 }
 
@@ -68,8 +67,7 @@ ss::future<> configuration_manager::prefix_truncate(model::offset offset) {
         }
         _configurations.erase(_configurations.begin(), it);
         _highest_known_offset = std::max(offset, _highest_known_offset);
-        return store_highest_known_offset().then(
-          [this] { return store_configurations(); });
+        return store_configurations();
     });
 }
 
@@ -88,18 +86,19 @@ ss::future<>
 configuration_manager::add(std::vector<offset_configuration> configurations) {
     return _lock.with([this,
                        configurations = std::move(configurations)]() mutable {
+        underlying_t delta;
         for (auto& co : configurations) {
             vlog(
               _ctxlog.trace,
               "Adding configuration: {}, offset: {}",
               co.cfg,
               co.offset);
-            add_configuration(co.offset, std::move(co.cfg));
+            add_configuration(co.offset, co.cfg);
+            delta.emplace(co.offset, std::move(co.cfg));
             _highest_known_offset = std::max(_highest_known_offset, co.offset);
         }
         _config_changed.broadcast();
-        return store_configurations().then(
-          [this] { return store_highest_known_offset(); });
+        return store_delta(std::move(delta));
     });
 }
 
@@ -114,11 +113,12 @@ configuration_manager::add(model::offset offset, group_configuration cfg) {
             return ss::now();
         }
 
-        add_configuration(offset, std::move(cfg));
+        add_configuration(offset, cfg);
         _highest_known_offset = std::max(offset, _highest_known_offset);
         _config_changed.broadcast();
-        return store_configurations().then(
-          [this] { return store_highest_known_offset(); });
+        underlying_t delta;
+        delta.emplace(offset, std::move(cfg));
+        return store_delta(std::move(delta));
     });
 }
 
@@ -208,12 +208,43 @@ bytes configuration_manager::highest_known_offset_key() {
     return iobuf_to_bytes(buf);
 }
 
+bytes configuration_manager::delta_key(raft::group_id group, uint16_t slot) {
+    iobuf buf;
+    reflection::serialize(buf, metadata_key::config_delta, group, slot);
+    return iobuf_to_bytes(buf);
+}
+
 ss::future<> configuration_manager::store_configurations() {
     return serialize_configurations(_configurations).then([this](iobuf buf) {
-        return _storage.kvs().put(
-          storage::kvstore::key_space::consensus,
-          configurations_map_key(),
-          std::move(buf));
+        constexpr auto ks = storage::kvstore::key_space::consensus;
+        std::vector<ss::future<>> writes;
+        writes.reserve(_deltas + 2);
+        writes.push_back(
+          _storage.kvs().put(ks, configurations_map_key(), std::move(buf)));
+        for (uint16_t slot = 0; slot < _deltas; ++slot) {
+            writes.push_back(
+              _storage.kvs().remove(ks, delta_key(_group, slot)));
+        }
+        writes.push_back(store_highest_known_offset());
+        _deltas = 0;
+        return ss::when_all_succeed(writes.begin(), writes.end());
+    });
+}
+
+ss::future<> configuration_manager::store_delta(underlying_t delta) {
+    if (_deltas == max_deltas) {
+        return store_configurations();
+    }
+    return ss::do_with(std::move(delta), [this](const underlying_t& delta) {
+        return serialize_configurations(delta).then([this](iobuf buf) {
+            auto slot = _deltas++;
+            return ss::when_all_succeed(
+              _storage.kvs().put(
+                storage::kvstore::key_space::consensus,
+                delta_key(_group, slot),
+                std::move(buf)),
+              store_highest_known_offset());
+        });
     });
 }
 
@@ -246,6 +277,37 @@ ss::future<> configuration_manager::start() {
                   });
         }
 
+        std::vector<iobuf> deltas;
+        uint16_t slot = 0;
+        for (; slot < max_deltas; ++slot) {
+            auto delta_buf = _storage.kvs().get(
+              storage::kvstore::key_space::consensus, delta_key(_group, slot));
+            if (!delta_buf) {
+                break;
+            }
+            deltas.push_back(std::move(*delta_buf));
+        }
+        _deltas = slot;
+        if (!deltas.empty()) {
+            f = f.then([this, deltas = std::move(deltas)]() mutable {
+                return ss::do_with(
+                  std::move(deltas), [this](std::vector<iobuf>& deltas) {
+                      return ss::do_for_each(deltas, [this](iobuf& buf) {
+                          return deserialize_configurations(std::move(buf))
+                            .then([this](underlying_t cfgs) {
+                                for (auto& [o, cfg] : cfgs) {
+                                    _configurations.insert_or_assign(
+                                      o, std::move(cfg));
+                                }
+                                _highest_known_offset = std::max(
+                                  _highest_known_offset,
+                                  _configurations.rbegin()->first);
+                            });
+                      });
+                  });
+            });
+        }
+
         auto offset_buf = _storage.kvs().get(
           storage::kvstore::key_space::consensus, highest_known_offset_key());
         if (offset_buf) {
@@ -307,12 +369,16 @@ ss::future<offset_configuration> configuration_manager::wait_for_change(
 }
 
 ss::future<> configuration_manager::remove_persistent_state() {
-    return _storage.kvs()
-      .remove(storage::kvstore::key_space::consensus, configurations_map_key())
-      .then([this] {
-          return _storage.kvs().remove(
-            storage::kvstore::key_space::consensus, highest_known_offset_key());
-      });
+    constexpr auto ks = storage::kvstore::key_space::consensus;
+    std::vector<ss::future<>> removals;
+    removals.reserve(_deltas + 2);
+    removals.push_back(_storage.kvs().remove(ks, configurations_map_key()));
+    removals.push_back(_storage.kvs().remove(ks, highest_known_offset_key()));
+    for (uint16_t slot = 0; slot < _deltas; ++slot) {
+        removals.push_back(_storage.kvs().remove(ks, delta_key(_group, slot)));
+    }
+    _deltas = 0;
+    return ss::when_all_succeed(removals.begin(), removals.end());
 }
 
 std::ostream& operator<<(std::ostream& o, const configuration_manager& m) {
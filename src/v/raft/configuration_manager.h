@@ -43,10 +43,21 @@ namespace raft {
  * The highest known offset is not group_configuration offset, it is an offset
  * up to which all configuration are guranted to be present in configuration
  * manager.
+ *
+ * Added configurations are stored as deltas, each of them in its own key, so
+ * that adding a configuration does not write the whole history again. When
+ * all the delta keys are used, or when the configurations are truncated, the
+ * whole map is written and the deltas are removed. The keys written by an
+ * operation are put synchronously so that they are flushed in the same
+ * kvstore batch.
  */
 class configuration_manager {
 public:
     static constexpr size_t offset_update_treshold = 64_MiB;
+    static constexpr uint16_t max_deltas = 16;
+
+    /// the key of the delta stored at given slot
+    static bytes delta_key(raft::group_id, uint16_t slot);
 
     configuration_manager(
       group_configuration, raft::group_id, storage::api&, ctx_log&);
@@ -138,7 +149,10 @@ private:
     // requested
     using underlying_t = absl::btree_map<model::offset, group_configuration>;
 
+    /// writes the whole map and removes the deltas
     ss::future<> store_configurations();
+    /// writes the configurations added to the map
+    ss::future<> store_delta(underlying_t);
     ss::future<> store_highest_known_offset();
     bytes configurations_map_key();
     bytes highest_known_offset_key();
@@ -161,6 +175,8 @@ private:
      * bootstrap redpanda will have to read up to 64MB per raft group.
      */
     size_t _bytes_since_last_offset_update = 0;
+    // number of delta keys stored since the whole map was written
+    uint16_t _deltas = 0;
     ctx_log& _ctxlog;
 };
 } // namespace raft
@@ -17,12 +17,15 @@
 #include "raft/consensus_utils.h"
 #include "raft/errc.h"
 #include "raft/logger.h"
+#include "raft/node_liveness.h"
 #include "raft/prevote_stm.h"
 #include "raft/recovery_stm.h"
+#include "raft/replicate_trace.h"
 #include "raft/rpc_client_protocol.h"
 #include "raft/types.h"
 #include "raft/vote_stm.h"
 #include "reflection/adl.h"
+#include "resource_mgmt/io_priority.h"
 #include "utils/state_crc_file.h"
 #include "utils/state_crc_file_errc.h"
 #include "vlog.h"
@@ -32,6 +35,7 @@
 
 #include <fmt/ostream.h>
 
+#include <algorithm>
 #include <iterator>
 
 namespace raft {
@@ -62,16 +66,47 @@ consensus::consensus(
       config::shard_local_cfg().replicate_append_timeout_ms())
   , _recovery_append_timeout(
       config::shard_local_cfg().recovery_append_timeout_ms())
+  , _lease_enabled(config::shard_local_cfg().raft_enable_leader_lease())
+  , _lease_duration(_jit.base_duration() * 4 / 5)
+  , _replication_compression(
+      rpc::compression_type_from_string(
+        config::shard_local_cfg().rpc_replication_compression())
+        .value_or(rpc::compression_type::none))
+  , _quiesce_idle(config::shard_local_cfg().raft_quiesce_idle_ms())
+  , _bounded_loss(_log.config().has_bounded_loss())
+  , _flush_interval(default_flush_interval)
   , _storage(storage)
   , _snapshot_mgr(
       std::filesystem::path(_log.config().work_directory()), _io_priority)
   , _configuration_manager(std::move(initial_cfg), _group, _storage, _ctxlog) {
     setup_metrics();
     update_follower_stats(_configuration_manager.get_latest());
+    if (config::shard_local_cfg().raft_adaptive_election_timeout()) {
+        const auto max = _jit.base_duration();
+        const auto min = std::min<clock_type::duration>(
+          max,
+          std::max<clock_type::duration>(
+            config::shard_local_cfg().raft_election_timeout_min_ms(),
+            2 * config::shard_local_cfg().raft_heartbeat_interval_ms()));
+        _election_timeout_bounds = {min, max};
+        // a follower may elect another leader as early as the lower bound
+        _lease_duration = min * 4 / 5;
+    }
     _vote_timeout.set_callback([this] {
         maybe_step_down();
         dispatch_vote(false);
     });
+    if (_bounded_loss) {
+        const auto& o = _log.config().get_overrides();
+        if (o.flush_ms) {
+            _flush_interval = *o.flush_ms;
+        }
+        _flush_bytes = o.flush_bytes;
+        _flush_timer.set_callback([this] {
+            _probe.interval_flush();
+            dispatch_flush_with_lock();
+        });
+    }
 }
 
 void consensus::setup_metrics() {
@@ -86,21 +121,45 @@ void consensus::setup_metrics() {
     _metrics.add_group(
       prometheus_sanitize::metrics_name("raft"),
       {sm::make_gauge(
-        "leader_for",
-        [this] { return is_leader(); },
-        sm::description("Number of groups for which node is a leader"),
-        labels)});
+         "leader_for",
+         [this] { return is_leader(); },
+         sm::description("Number of groups for which node is a leader"),
+         labels),
+       sm::make_gauge(
+         "replicate_batch_linger_us",
+         [this] {
+             return std::chrono::duration_cast<std::chrono::microseconds>(
+                      _batcher.linger())
+               .count();
+         },
+         sm::description("Time replicate requests wait for more requests"),
+         labels),
+       sm::make_gauge(
+         "replicate_batch_target_bytes",
+         [this] { return _batcher.target_bytes(); },
+         sm::description("Size at which replicate requests are dispatched"),
+         labels),
+       sm::make_gauge(
+         "unflushed_bytes",
+         [this] { return _unflushed_bytes; },
+         sm::description("Bytes acknowledged by the replica and not flushed "
+                         "yet, with the flush.ms or flush.bytes properties"),
+         labels)});
 }
 
 void consensus::do_step_down() {
     _hbeat = clock_type::now();
     _vstate = vote_state::follower;
+    // any request of the leader wakes the group
+    _quiesced = false;
+    _quiesced_session = 0;
 }
 
 void consensus::maybe_step_down() {
     (void)ss::with_gate(_bg, [this] {
         return _op_lock.with([this] {
-            if (_vstate == vote_state::leader) {
+            // the followers of a quiesced group are not heartbeated
+            if (_vstate == vote_state::leader && !_quiesced) {
                 auto majority_hbeat = config().quorum_match(
                   [this](model::node_id id) {
                       if (id == _self) {
@@ -125,7 +184,9 @@ void consensus::maybe_step_down() {
 ss::future<> consensus::stop() {
     vlog(_ctxlog.info, "Stopping");
     _vote_timeout.cancel();
+    _flush_timer.cancel();
     _as.request_abort();
+    _consumable_offset_monitor.stop();
     _commit_index_updated.broken();
 
     return _event_manager.stop()
@@ -138,7 +199,8 @@ ss::future<> consensus::stop() {
           }
           return _snapshot_writer->close().then(
             [this] { _snapshot_writer.reset(); });
-      });
+      })
+      .then([this] { return abort_segment_receiver(); });
 }
 
 consensus::success_reply consensus::update_follower_index(
@@ -212,6 +274,11 @@ consensus::success_reply consensus::update_follower_index(
     }
 
     update_node_hbeat_timestamp(node);
+    if (idx.lease_probe_seq && seq >= *idx.lease_probe_seq) {
+        // the follower heard from us after the probe was sent
+        idx.lease_ack_timestamp = idx.lease_probe_timestamp;
+        idx.lease_probe_seq.reset();
+    }
 
     // If recovery is in progress the recovery STM will handle follower index
     // updates
@@ -228,6 +295,7 @@ consensus::success_reply consensus::update_follower_index(
 
     if (reply.result == append_entries_reply::status::success) {
         successfull_append_entries_reply(idx, std::move(reply));
+        maybe_promote_learner(idx);
         return success_reply::yes;
     }
 
@@ -246,9 +314,6 @@ consensus::success_reply consensus::update_follower_index(
         return success_reply::no;
     }
     return success_reply::no;
-    // TODO(agallego) - add target_replication_factor,
-    // current_replication_factor to group_configuration so we can promote
-    // learners to nodes and perform data movement to added replicas
 }
 
 void consensus::process_append_entries_reply(
@@ -276,6 +341,46 @@ void consensus::successfull_append_entries_reply(
       idx.next_index);
 }
 
+void consensus::maybe_promote_learner(const follower_index_metadata& idx) {
+    // a learner is caught up when it has all the entries committed by the
+    // group, the entries appended later are replicated to the joint
+    // configuration
+    if (
+      !idx.is_learner || idx.is_recovering || _promoting_learner
+      || idx.match_index < _commit_index) {
+        return;
+    }
+    vlog(
+      _ctxlog.info,
+      "Promoting learner {} to voter, match index: {}",
+      idx.node_id,
+      idx.match_index);
+    _promoting_learner = true;
+    (void)ss::with_gate(_bg, [this, id = idx.node_id] {
+        return change_configuration([id](group_configuration current) {
+                   if (!current.is_learner(id)) {
+                       return result<group_configuration>(
+                         errc::node_does_not_exists);
+                   }
+                   current.promote_to_voter(id);
+                   return result<group_configuration>(std::move(current));
+               })
+          .then([this, id](std::error_code ec) {
+              if (ec) {
+                  vlog(
+                    _ctxlog.debug,
+                    "Unable to promote learner {} - {}",
+                    id,
+                    ec.message());
+              }
+          })
+          .handle_exception([this, id](const std::exception_ptr& e) {
+              vlog(_ctxlog.warn, "Error promoting learner {} - {}", id, e);
+          })
+          .finally([this] { _promoting_learner = false; });
+    });
+}
+
 bool consensus::needs_recovery(const follower_index_metadata& idx) {
     // follower match_index is behind, we have to recover it
     auto lstats = _log.offsets();
@@ -300,7 +405,7 @@ void consensus::dispatch_recovery(follower_index_metadata& idx) {
     // background
     (void)with_gate(_bg, [this, &idx] {
         auto recovery = std::make_unique<recovery_stm>(
-          this, idx.node_id, _io_priority);
+          this, idx.node_id, raft_recovery_priority());
         auto ptr = recovery.get();
         return ptr->apply()
           .handle_exception([this, &idx](const std::exception_ptr& e) {
@@ -322,11 +427,11 @@ consensus::replicate(model::record_batch_reader&& rdr, replicate_options opts) {
 
     if (opts.consistency == consistency_level::quorum_ack) {
         _probe.replicate_requests_ack_all();
-        return ss::with_gate(_bg, [this, rdr = std::move(rdr)]() mutable {
-            return _batcher.replicate(std::move(rdr)).finally([this] {
-                _probe.replicate_done();
-            });
-        });
+        return ss::with_gate(
+          _bg, [this, rdr = std::move(rdr), traced = opts.traced]() mutable {
+              return _batcher.replicate(std::move(rdr), traced)
+                .finally([this] { _probe.replicate_done(); });
+          });
     }
 
     if (opts.consistency == consistency_level::leader_ack) {
@@ -337,16 +442,21 @@ consensus::replicate(model::record_batch_reader&& rdr, replicate_options opts) {
     // For relaxed consistency, append data to leader disk without flush
     // asynchronous replication is provided by Raft protocol recovery mechanism.
     return _op_lock
-      .with([this, rdr = std::move(rdr)]() mutable {
+      .with([this, rdr = std::move(rdr), traced = opts.traced]() mutable {
           if (!is_leader()) {
               return seastar::make_ready_future<result<replicate_result>>(
                 errc::not_leader);
           }
 
+          auto start = clock_type::now();
           return disk_append(model::make_record_batch_reader<
                                details::term_assigning_reader>(
                                std::move(rdr), model::term_id(_term)))
-            .then([this](storage::append_result res) {
+            .then([this, traced, start](storage::append_result res) {
+                if (traced) {
+                    shard_local_replicate_tracer().record(
+                      replicate_stage::local_append, clock_type::now() - start);
+                }
                 // update last_visible_index immediately after append succeed
                 maybe_update_last_visible_index(res.last_offset);
                 return result<replicate_result>(
@@ -401,7 +511,7 @@ bool consensus::should_skip_vote(bool ignore_heartbeat) {
 
     if (likely(!ignore_heartbeat)) {
         auto last_election = clock_type::now() - _jit.base_duration();
-        skip_vote |= (_hbeat > last_election); // nothing to do.
+        skip_vote |= heard_from_leader(last_election); // nothing to do.
     }
 
     skip_vote |= _vstate == vote_state::leader; // already a leader
@@ -411,6 +521,62 @@ bool consensus::should_skip_vote(bool ignore_heartbeat) {
     return skip_vote;
 }
 
+bool consensus::heard_from_leader(clock_type::time_point tp) const {
+    return _hbeat > tp
+           || (_quiesced_session != 0
+               && node_liveness::local().heard_since(_quiesced_session, tp));
+}
+
+bool consensus::can_quiesce() {
+    if (
+      _quiesce_idle == clock_type::duration::zero() || !is_leader()
+      || _transferring_leadership) {
+        return false;
+    }
+    const auto now = clock_type::now();
+    const auto dirty = _log.offsets().dirty_offset;
+    if (dirty != _quiesce_offset) {
+        _quiesce_offset = dirty;
+        _quiesce_offset_since = now;
+        return false;
+    }
+    if (_quiesced) {
+        // nothing was appended since
+        return true;
+    }
+    if (now - _quiesce_offset_since < _quiesce_idle || _commit_index != dirty) {
+        return false;
+    }
+    // the followers have the whole log and replied within a heartbeat
+    // timeout, so that a follower that went away is not quiesced
+    return std::all_of(_fstats.begin(), _fstats.end(), [&](const auto& f) {
+        return f.second.match_index == dirty
+               && f.second.last_hbeat_timestamp + _jit.base_duration() > now;
+    });
+}
+
+void consensus::set_quiesced(bool quiesced) {
+    if (_quiesced == quiesced) {
+        return;
+    }
+    vlog(_ctxlog.trace, "Quiesced: {}", quiesced);
+    _quiesced = quiesced;
+    if (!quiesced) {
+        const auto now = clock_type::now();
+        for (auto& [_, f] : _fstats) {
+            f.last_hbeat_timestamp = std::max(f.last_hbeat_timestamp, now);
+        }
+    }
+}
+
+void consensus::quiesce(uint64_t session, model::term_id term) {
+    // the group may have moved on while the reply was sent
+    if (_vstate == vote_state::follower && _term == term) {
+        vlog(_ctxlog.trace, "Quiesced by session {}", session);
+        _quiesced_session = session;
+    }
+}
+
 ss::future<bool> consensus::dispatch_prevote(bool leadership_transfer) {
     auto pvstm_p = std::make_unique<prevote_stm>(this);
     auto pvstm = pvstm_p.get();
@@ -442,6 +608,17 @@ ss::future<bool> consensus::dispatch_prevote(bool leadership_transfer) {
       });
 }
 
+/*
+ * The elections the groups of a core run at once. When a node goes away all
+ * the groups it led start an election within an election timeout, and the
+ * groups queued behind the limit skip theirs once a new leader shows up.
+ */
+static ss::semaphore& election_limiter() {
+    static thread_local ss::semaphore limiter(
+      config::shard_local_cfg().raft_max_concurrent_elections());
+    return limiter;
+}
+
 /// performs no raft-state mutation other than resetting the timer
 void consensus::dispatch_vote(bool leadership_transfer) {
     // 5.2.1.4 - prepare next timeout
@@ -452,47 +629,99 @@ void consensus::dispatch_vote(bool leadership_transfer) {
 
     // background, acquire lock, transition state
     (void)with_gate(_bg, [this, leadership_transfer] {
-        return dispatch_prevote(leadership_transfer)
-          .then([this, leadership_transfer](bool ready) mutable {
-              if (!ready) {
-                  return ss::make_ready_future<>();
-              }
-              auto vstm = std::make_unique<vote_stm>(this);
-              auto p = vstm.get();
-
-              // CRITICAL: vote performs locking on behalf of consensus
-              return p->vote(leadership_transfer)
-                .then_wrapped([this, p, vstm = std::move(vstm)](
-                                ss::future<> vote_f) mutable {
-                    try {
-                        vote_f.get();
-                    } catch (...) {
-                        vlog(
-                          _ctxlog.warn,
-                          "Error returned from voting process {}",
-                          std::current_exception());
-                    }
-                    auto f = p->wait().finally([vstm = std::move(vstm)] {});
-                    // make sure we wait for all futures when gate is closed
-                    if (_bg.is_closed()) {
-                        return f;
-                    }
-                    // background
-                    (void)with_gate(
-                      _bg,
-                      [vstm = std::move(vstm), f = std::move(f)]() mutable {
-                          return std::move(f);
-                      });
-
-                    return ss::make_ready_future<>();
-                });
-          })
+        return ss::with_semaphore(
+                 election_limiter(),
+                 1,
+                 [this, leadership_transfer] {
+                     return do_dispatch_vote(leadership_transfer);
+                 })
           .handle_exception([this](const std::exception_ptr& e) {
               vlog(_ctxlog.warn, "Exception thrown while voting - {}", e);
           })
           .finally([this] { arm_vote_timeout(); });
     });
 }
+
+ss::future<> consensus::do_dispatch_vote(bool leadership_transfer) {
+    // a leader may have shown up while waiting for the limiter
+    if (_bg.is_closed() || should_skip_vote(leadership_transfer)) {
+        return ss::now();
+    }
+    return dispatch_prevote(leadership_transfer)
+      .then([this, leadership_transfer](bool ready) mutable {
+          if (!ready) {
+              return ss::make_ready_future<>();
+          }
+          auto vstm = std::make_unique<vote_stm>(this);
+          auto p = vstm.get();
+
+          // CRITICAL: vote performs locking on behalf of consensus
+          return p->vote(leadership_transfer)
+            .then_wrapped([this, p, vstm = std::move(vstm)](
+                            ss::future<> vote_f) mutable {
+                try {
+                    vote_f.get();
+                } catch (...) {
+                    vlog(
+                      _ctxlog.warn,
+                      "Error returned from voting process {}",
+                      std::current_exception());
+                }
+                auto f = p->wait().finally([vstm = std::move(vstm)] {});
+                // make sure we wait for all futures when gate is closed
+                if (_bg.is_closed()) {
+                    return f;
+                }
+                // background
+                (void)with_gate(
+                  _bg, [vstm = std::move(vstm), f = std::move(f)]() mutable {
+                      return std::move(f);
+                  });
+
+                return ss::make_ready_future<>();
+            });
+      });
+}
+
+void consensus::update_election_timeout(model::node_id leader) {
+    if (!_election_timeout_bounds) {
+        return;
+    }
+    // the requests a follower would time out without
+    static constexpr int missed_requests = 3;
+    const auto [min, max] = *_election_timeout_bounds;
+    const auto now = clock_type::now();
+    const auto prev = std::exchange(_last_leader_request, now);
+    if (_timed_leader != leader) {
+        // another peer, another network path
+        _timed_leader = leader;
+        _leader_interval = clock_type::duration{0};
+        _leader_interval_dev = clock_type::duration{0};
+        return;
+    }
+    const auto interval = now - prev;
+    if (interval >= max) {
+        // the group was quiesced, or the leader was stalled: either way not
+        // an interval of the heartbeats
+        return;
+    }
+    if (_leader_interval == clock_type::duration{0}) {
+        _leader_interval = interval;
+        _leader_interval_dev = interval / 2;
+    } else {
+        const auto err = interval > _leader_interval
+                           ? interval - _leader_interval
+                           : _leader_interval - interval;
+        _leader_interval_dev = (3 * _leader_interval_dev + err) / 4;
+        _leader_interval = (7 * _leader_interval + interval) / 8;
+    }
+    const auto timeout = std::clamp<clock_type::duration>(
+      missed_requests * (_leader_interval + 4 * _leader_interval_dev),
+      min,
+      max);
+    _jit.set_duration(timeout, timeout / 2);
+}
+
 void consensus::arm_vote_timeout() {
     if (!_bg.is_closed()) {
         _vote_timeout.rearm(_jit());
@@ -554,6 +783,7 @@ consensus::add_group_members(std::vector<model::broker> nodes) {
               return result<group_configuration>(errc::node_already_exists);
           }
 
+          // new members replicate as learners until they caught up
           current.add(std::move(nodes));
 
           return result<group_configuration>(std::move(current));
@@ -646,6 +876,8 @@ ss::future<> consensus::start() {
               });
           })
           .then([this] {
+              // a group starts as a follower
+              update_batch_cache_policy();
               auto next_election = clock_type::now();
               // set last heartbeat timestamp to prevent skipping first
               // election
@@ -751,6 +983,9 @@ void consensus::read_voted_for() {
 }
 
 ss::future<vote_reply> consensus::vote(vote_request&& r) {
+    // a follower that lost track of the quiesced group, e.g. it restarted
+    // between two heartbeats, gets heartbeated again
+    set_quiesced(false);
     return with_gate(_bg, [this, r = std::move(r)]() mutable {
         return _op_lock.with(
           [this, r = std::move(r)]() mutable { return do_vote(std::move(r)); });
@@ -804,10 +1039,13 @@ ss::future<vote_reply> consensus::do_vote(vote_request&& r) {
     // Check if we updated the heartbeat timepoint in the last election
     // timeout duration When the vote was requested because of leadership
     // transfer grant the vote immediately.
+    // A vote that was already granted in this term may be granted again, but
+    // in a later term the candidate gets no precedence over the leader: the
+    // leader lease relies on this.
     auto prev_election = clock_type::now() - _jit.base_duration();
     if (
-      _hbeat > prev_election && !r.leadership_transfer
-      && r.node_id != _voted_for) {
+      heard_from_leader(prev_election) && !r.leadership_transfer
+      && (r.node_id != _voted_for || r.term > _term)) {
         vlog(
           _ctxlog.trace,
           "Already heard from the leader, not granting vote to node {}",
@@ -881,14 +1119,16 @@ ss::future<vote_reply> consensus::do_vote(vote_request&& r) {
 ss::future<append_entries_reply>
 consensus::append_entries(append_entries_request&& r) {
     return with_gate(_bg, [this, r = std::move(r)]() mutable {
-        return _op_lock.with([this, r = std::move(r)]() mutable {
-            return do_append_entries(std::move(r));
-        });
+        return _op_lock.get_units().then(
+          [this, r = std::move(r)](ss::semaphore_units<> u) mutable {
+              return do_append_entries(std::move(r), std::move(u));
+          });
     });
 }
 
 ss::future<append_entries_reply>
-consensus::do_append_entries(append_entries_request&& r) {
+consensus::do_append_entries(
+  append_entries_request&& r, ss::semaphore_units<> u) {
     auto lstats = _log.offsets();
     append_entries_reply reply;
     reply.node_id = _self;
@@ -919,7 +1159,7 @@ consensus::do_append_entries(append_entries_request&& r) {
           _term);
         _term = r.meta.term;
         _voted_for = {};
-        return do_append_entries(std::move(r));
+        return do_append_entries(std::move(r), std::move(u));
     }
 
     // raft.pdf:If AppendEntries RPC received from new leader: convert to
@@ -929,6 +1169,7 @@ consensus::do_append_entries(append_entries_request&& r) {
         _leader_id = r.node_id;
         trigger_leadership_notification();
     }
+    update_election_timeout(r.node_id);
 
     // raft.pdf: Reply false if log doesn’t contain an entry at
     // prevLogIndex whose term matches prevLogTerm (§5.3)
@@ -1027,7 +1268,10 @@ consensus::do_append_entries(append_entries_request&& r) {
                   update_follower_stats(_configuration_manager.get_latest());
               });
           })
-          .then([this, r = std::move(r), truncate_at]() mutable {
+          .then([this,
+                 r = std::move(r),
+                 truncate_at,
+                 u = std::move(u)]() mutable {
               auto lstats = _log.offsets();
               if (unlikely(lstats.dirty_offset != r.meta.prev_log_index)) {
                   vlog(
@@ -1039,7 +1283,7 @@ consensus::do_append_entries(append_entries_request&& r) {
                     lstats,
                     truncate_at);
               }
-              return do_append_entries(std::move(r));
+              return do_append_entries(std::move(r), std::move(u));
           })
           .handle_exception([this, reply = std::move(reply)](
                               const std::exception_ptr& e) mutable {
@@ -1053,9 +1297,15 @@ consensus::do_append_entries(append_entries_request&& r) {
     // success. copy entries for each subsystem
     using offsets_ret = storage::append_result;
     return disk_append(std::move(r.batches))
-      .then([this, m = r.meta, flush = r.flush](offsets_ret ofs) mutable {
+      .then([this, m = r.meta, flush = r.flush, u = std::move(u)](
+              offsets_ret ofs) mutable {
           auto f = ss::make_ready_future<>();
           if (flush) {
+              // the flush waits for its wave with the flushes of the other
+              // groups of this shard. the next requests of the group are
+              // appended meanwhile and share the wave, the reply goes out
+              // once the entries are durable.
+              u.return_all();
               f = f.then([this] { return flush_log(); });
           }
           maybe_update_last_visible_index(
@@ -1107,6 +1357,41 @@ ss::future<> consensus::hydrate_snapshot() {
       });
 }
 
+ss::future<std::optional<snapshot_data>> consensus::read_snapshot() {
+    using ret_t = std::optional<snapshot_data>;
+    return _snapshot_mgr.open_snapshot().then(
+      [](std::optional<storage::snapshot_reader> reader) {
+          if (!reader) {
+              return ss::make_ready_future<ret_t>();
+          }
+          return ss::do_with(
+            std::move(*reader), [](storage::snapshot_reader& reader) {
+                return reader.read_metadata()
+                  .then([&reader](iobuf buf) {
+                      const auto md_size = buf.size_bytes();
+                      auto parser = iobuf_parser(std::move(buf));
+                      auto md = reflection::adl<snapshot_metadata>{}.from(
+                        parser);
+                      return reader.get_snapshot_size().then(
+                        [&reader, md_size, md = std::move(md)](size_t size) {
+                            // the data takes the rest of the file
+                            const size_t data_size
+                              = size - storage::snapshot_header::ondisk_size
+                                - md_size;
+                            return read_iobuf_exactly(reader.input(), data_size)
+                              .then([offset = md.last_included_index](
+                                      iobuf data) {
+                                  return ret_t(snapshot_data{
+                                    .last_included_index = offset,
+                                    .data = std::move(data)});
+                              });
+                        });
+                  })
+                  .finally([&reader] { return reader.close(); });
+            });
+      });
+}
+
 ss::future<> consensus::truncate_to_latest_snapshot() {
     auto lstats = _log.offsets();
     if (lstats.start_offset > _last_snapshot_index) {
@@ -1250,6 +1535,137 @@ ss::future<install_snapshot_reply> consensus::finish_snapshot(
       });
 }
 
+ss::future<install_segment_reply>
+consensus::install_segment(install_segment_request&& r) {
+    return _op_lock.with([this, r = std::move(r)]() mutable {
+        return do_install_segment(std::move(r));
+    });
+}
+
+ss::future<> consensus::abort_segment_receiver() {
+    if (!_segment_receiver) {
+        return ss::now();
+    }
+    return _segment_receiver->abort().finally(
+      [this] { _segment_receiver.reset(); });
+}
+
+ss::future<install_segment_reply>
+consensus::do_install_segment(install_segment_request&& r) {
+    vlog(_ctxlog.trace, "Install segment request: {}", r);
+    auto lstats = _log.offsets();
+    install_segment_reply reply{
+      .term = _term,
+      .bytes_stored = 0,
+      .last_dirty_log_index = lstats.dirty_offset,
+      .last_committed_log_index = lstats.committed_offset,
+      .success = false};
+
+    if (r.term < _term) {
+        return ss::make_ready_future<install_segment_reply>(reply);
+    }
+
+    // no need to trigger timeout
+    _hbeat = clock_type::now();
+
+    // request received from new leader
+    if (r.term > _term) {
+        _term = r.term;
+        _voted_for = {};
+        do_step_down();
+        return do_install_segment(std::move(r));
+    }
+
+    auto f = ss::now();
+    // first chunk of a segment, the segment has to directly follow the log
+    if (r.file == storage::segment_file_type::data && r.file_offset == 0) {
+        const bool log_matches = lstats.dirty_offset
+                                   == details::prev_offset(r.base_offset)
+                                 && lstats.dirty_offset_term
+                                      == r.prev_log_term;
+        if (!log_matches || r.segment_term < lstats.dirty_offset_term) {
+            vlog(
+              _ctxlog.debug,
+              "Rejecting segment {}, log offsets: {}",
+              r,
+              lstats);
+            return abort_segment_receiver().then([reply] { return reply; });
+        }
+        f = abort_segment_receiver().then(
+          [this, base = r.base_offset, term = r.segment_term] {
+              return storage::segment_receiver::open(
+                       _log.config(), base, term, _io_priority)
+                .then([this](storage::segment_receiver rcv) {
+                    _segment_receiver.emplace(std::move(rcv));
+                });
+          });
+    }
+
+    return f.then([this, r = std::move(r), reply]() mutable {
+        const bool in_sequence = _segment_receiver
+                                 && _segment_receiver->base_offset()
+                                      == r.base_offset
+                                 && _segment_receiver->bytes_stored(r.file)
+                                      == r.file_offset;
+        if (!in_sequence) {
+            // chunks out of order, leader will fall back to append entries
+            return abort_segment_receiver().then([reply] { return reply; });
+        }
+        auto chunk = std::move(r.chunk);
+        return _segment_receiver->write(r.file, std::move(chunk))
+          .then([this, r = std::move(r), reply]() mutable {
+              reply.bytes_stored = _segment_receiver->bytes_stored(r.file);
+              if (!r.done) {
+                  reply.success = true;
+                  return ss::make_ready_future<install_segment_reply>(reply);
+              }
+              return finish_segment(std::move(r), reply);
+          });
+    });
+}
+
+ss::future<install_segment_reply> consensus::finish_segment(
+  install_segment_request r, install_segment_reply reply) {
+    return _segment_receiver->close()
+      .then([this, base = r.base_offset, term = r.segment_term] {
+          _segment_receiver.reset();
+          return _log.install_segment(base, term);
+      })
+      .then([this, base = r.base_offset] {
+          // the segment may carry configuration changes
+          return details::read_bootstrap_state(_log, base, _as);
+      })
+      .then([this](configuration_bootstrap_state st) {
+          if (st.config_batches_seen() == 0) {
+              return ss::now();
+          }
+          update_follower_stats(st.config());
+          return _configuration_manager
+            .add(st.prev_log_index(), st.release_config())
+            .then([this] { _probe.configuration_update(); });
+      })
+      .then([this, commit_index = r.commit_index] {
+          return maybe_update_follower_commit_idx(commit_index);
+      })
+      .then_wrapped([this, reply](ss::future<> f) mutable {
+          if (f.failed()) {
+              vlog(
+                _ctxlog.warn,
+                "Unable to install received segment: {}",
+                f.get_exception());
+              reply.success = false;
+          } else {
+              reply.success = true;
+          }
+          return abort_segment_receiver().then([this, reply]() mutable {
+              auto lstats = _log.offsets();
+              reply.last_dirty_log_index = lstats.dirty_offset;
+              reply.last_committed_log_index = lstats.committed_offset;
+              return reply;
+          });
+      });
+}
+
 ss::future<> consensus::write_snapshot(write_snapshot_cfg cfg) {
     return _op_lock.with([this, cfg = std::move(cfg)]() mutable {
         // do nothing, we already have snapshot for this offset
@@ -1364,9 +1780,38 @@ consensus::make_append_entries_reply(storage::append_result disk_results) {
     return reply;
 }
 
+void consensus::track_unflushed(size_t bytes) {
+    if (!_bounded_loss) {
+        return;
+    }
+    _unflushed_bytes += bytes;
+    if (_flush_bytes && _unflushed_bytes >= *_flush_bytes) {
+        _probe.bytes_flush();
+        _unflushed_bytes = 0;
+        _flush_timer.cancel();
+        dispatch_flush_with_lock();
+        return;
+    }
+    if (!_flush_timer.armed()) {
+        _flush_timer.arm(_flush_interval);
+    }
+}
+
 ss::future<> consensus::flush_log() {
     _probe.log_flushed();
-    return _log.flush().then([this] { _has_pending_flushes = false; });
+    // the flush covers the appends tracked so far
+    _unflushed_bytes = 0;
+    _flush_timer.cancel();
+    return ss::with_gate(_bg, [this] {
+        // the flush is coalesced with those of other groups on this shard,
+        // appends that land while it is queued are flushed by it as well
+        auto dirty = _log.offsets().dirty_offset;
+        return _storage.flush_coord().flush(_log).then([this, dirty] {
+            if (_log.offsets().dirty_offset == dirty) {
+                _has_pending_flushes = false;
+            }
+        });
+    });
 }
 
 ss::future<storage::append_result>
@@ -1386,6 +1831,7 @@ consensus::disk_append(model::record_batch_reader&& reader) {
       .then([this](std::tuple<ret_t, std::vector<offset_configuration>> t) {
           auto& [ret, configurations] = t;
           _has_pending_flushes = true;
+          track_unflushed(ret.byte_size);
           // TODO
           // if we rolled a log segment. write current configuration
           // for speedy recovery in the background
@@ -1418,6 +1864,19 @@ model::term_id consensus::get_term(model::offset o) {
     return _log.get_term(o).value_or(model::term_id{});
 }
 
+rpc::compression_type consensus::replication_compression(
+  const ss::circular_buffer<model::record_batch>& batches) const {
+    if (
+      _replication_compression == rpc::compression_type::none
+      || std::all_of(
+        batches.begin(), batches.end(), [](const model::record_batch& b) {
+            return b.compressed();
+        })) {
+        return rpc::compression_type::none;
+    }
+    return _replication_compression;
+}
+
 clock_type::time_point consensus::last_append_timestamp(model::node_id id) {
     return _fstats.get(id).last_append_timestamp;
 }
@@ -1431,8 +1890,72 @@ void consensus::update_node_hbeat_timestamp(model::node_id id) {
     _fstats.get(id).last_hbeat_timestamp = clock_type::now();
 }
 
+void consensus::update_node_append_rtt(
+  model::node_id id, clock_type::duration rtt) {
+    // the follower may have been removed while the request was in flight
+    auto it = _fstats.find(id);
+    if (it == _fstats.end()) {
+        return;
+    }
+    auto& avg = it->second.append_rtt;
+    avg = avg == clock_type::duration(0) ? rtt : (avg * 7 + rtt) / 8;
+}
+
+clock_type::duration consensus::quorum_append_rtt() const {
+    // quorum_match returns the largest value that a majority is at or above,
+    // negating the round trip times gives the smallest one that majority is
+    // at or below
+    return -config().quorum_match([this](model::node_id id) {
+        auto it = _fstats.find(id);
+        if (id == _self || it == _fstats.end()) {
+            return clock_type::duration(0);
+        }
+        return -it->second.append_rtt;
+    });
+}
+
 follower_req_seq consensus::next_follower_sequence(model::node_id id) {
-    return _fstats.get(id).last_sent_seq++;
+    auto& meta = _fstats.get(id);
+    auto seq = meta.last_sent_seq++;
+    if (!meta.lease_probe_seq) {
+        meta.lease_probe_seq = seq;
+        meta.lease_probe_timestamp = clock_type::now();
+    }
+    return seq;
+}
+
+result<model::offset> consensus::linearizable_read_offset() const {
+    using ret_t = result<model::offset>;
+    if (!is_leader()) {
+        return ret_t(errc::not_leader);
+    }
+    if (!_lease_enabled || _transferring_leadership) {
+        return ret_t(errc::leader_lease_expired);
+    }
+    // until an entry of the current term is committed the leader may not
+    // know about entries committed by its predecessor
+    auto lstats = _log.offsets();
+    if (
+      lstats.dirty_offset_term != _term
+      || _commit_index < lstats.last_term_start_offset) {
+        return ret_t(errc::leader_lease_expired);
+    }
+    const auto now = clock_type::now();
+    auto lease_start = config().quorum_match([this, now](model::node_id id) {
+        if (id == _self) {
+            return now;
+        }
+        auto it = _fstats.find(id);
+        if (it == _fstats.end()) {
+            return clock_type::time_point::min();
+        }
+        return it->second.lease_ack_timestamp;
+    });
+    const auto not_before = std::max(_became_leader_at, _lease_not_before);
+    if (lease_start < not_before || lease_start + _lease_duration <= now) {
+        return ret_t(errc::leader_lease_expired);
+    }
+    return ret_t(_commit_index);
 }
 
 absl::flat_hash_map<model::node_id, follower_req_seq>
@@ -1509,12 +2032,14 @@ consensus::do_maybe_update_leader_commit_idx(ss::semaphore_units<> u) {
     // of matchIndex[i] ≥ N, and log[N].term == currentTerm:
     // set commitIndex = N (§5.3, §5.4).
     auto majority_match = config().quorum_match(
-      [this, committed_offset = lstats.committed_offset](model::node_id id) {
+      [this, acked = acked_offset(lstats)](model::node_id id) {
           // current node - we just return commited offset
           if (id == _self) {
-              return committed_offset;
+              return acked;
           }
-          return _fstats.get(id).match_committed_index();
+          auto& f = _fstats.get(id);
+          // with bounded loss the followers acknowledge unflushed entries
+          return _bounded_loss ? f.match_index : f.match_committed_index();
       });
     if (
       majority_match > _commit_index
@@ -1544,7 +2069,7 @@ consensus::maybe_update_follower_commit_idx(model::offset request_commit_idx) {
     // min(leaderCommit, index of last new entry)
     if (request_commit_idx > _commit_index) {
         auto new_commit_idx = std::min(
-          request_commit_idx, lstats.committed_offset);
+          request_commit_idx, acked_offset(lstats));
         if (new_commit_idx != _commit_index) {
             _commit_index = new_commit_idx;
             vlog(
@@ -1559,15 +2084,38 @@ consensus::maybe_update_follower_commit_idx(model::offset request_commit_idx) {
 
 void consensus::update_follower_stats(const group_configuration& cfg) {
     vlog(_ctxlog.trace, "Updating follower stats with config {}", cfg);
-    cfg.for_each_broker([this](const model::broker& n) {
-        if (n.id() == _self || _fstats.contains(n.id())) {
+    cfg.for_each_broker([this, &cfg](const model::broker& n) {
+        if (n.id() == _self) {
             return;
         }
-        _fstats.emplace(n.id(), follower_index_metadata(n.id()));
+        if (!_fstats.contains(n.id())) {
+            _fstats.emplace(n.id(), follower_index_metadata(n.id()));
+        }
+        _fstats.get(n.id()).is_learner = !cfg.is_voter(n.id());
+    });
+}
+
+void consensus::update_batch_cache_policy() {
+    // clients in the rack of a follower fetch from it, see fetch_request.cc
+    const bool follower_reads = config::shard_local_cfg().rack().has_value();
+    _log.set_batch_cache_policy(
+      is_leader() || follower_reads ? storage::batch_cache_policy::all
+                                    : storage::batch_cache_policy::tail);
+    if (!is_leader() || _bg.is_closed()) {
+        return;
+    }
+    const size_t warm_bytes
+      = config::shard_local_cfg().leader_batch_cache_warm_bytes();
+    (void)ss::with_gate(_bg, [this, warm_bytes] {
+        return _log.warm_batch_cache(warm_bytes, _io_priority)
+          .handle_exception([this](const std::exception_ptr& e) {
+              vlog(_ctxlog.debug, "Could not warm the batch cache: {}", e);
+          });
     });
 }
 
 void consensus::trigger_leadership_notification() {
+    update_batch_cache_policy();
     _probe.leadership_changed();
     _leader_notification(leadership_status{
       .term = model::term_id(_term),
@@ -1746,6 +2294,7 @@ consensus::transfer_leadership(std::optional<model::node_id> target) {
          * complete the transfer.
          */
         _transferring_leadership = true;
+        _lease_not_before = clock_type::time_point::max();
 
         /*
          * the follower's log needs to be up-to-date so that it will
@@ -1817,7 +2366,12 @@ consensus::transfer_leadership(std::optional<model::node_id> target) {
         });
     });
 
-    return f.finally([this] { _transferring_leadership = false; });
+    return f.finally([this] {
+        _transferring_leadership = false;
+        // followers may have granted their vote to the target regardless of
+        // the leader lease, only count acknowledgements sent from now on
+        _lease_not_before = clock_type::now();
+    });
 }
 
 ss::future<> consensus::remove_persistent_state() {
@@ -79,6 +79,8 @@ public:
     ss::future<append_entries_reply> append_entries(append_entries_request&& r);
     ss::future<install_snapshot_reply>
     install_snapshot(install_snapshot_request&& r);
+    ss::future<install_segment_reply>
+    install_segment(install_segment_request&& r);
 
     ss::future<timeout_now_reply> timeout_now(timeout_now_request&& r);
 
@@ -114,6 +116,51 @@ public:
     clock_type::time_point last_heartbeat() const { return _hbeat; };
 
     clock_type::time_point last_append_timestamp(model::node_id);
+
+    /// the codec of the append entries requests carrying the batches, see
+    /// `rpc_replication_compression`. Batches compressed by their producer
+    /// already are sent as they are
+    rpc::compression_type replication_compression(
+      const ss::circular_buffer<model::record_batch>&) const;
+
+    /**
+     * \brief Quiescence of an idle group, see heartbeat_manager
+     *
+     * With `raft_quiesce_idle_ms` a leader whose log was fully replicated
+     * and not appended to for that long may stop heartbeating the group,
+     * once every follower acknowledged a heartbeat announcing it. A
+     * quiesced follower holds no election while it hears the heartbeat
+     * session of the leader's node, and is woken by the next request of
+     * the leader.
+     *
+     * Returns true if the leader may quiesce the group, or keep it
+     * quiesced.
+     */
+    bool can_quiesce();
+    bool is_quiesced() const { return _quiesced; }
+    /// the leader stops, or resumes, heartbeating the group. Resuming
+    /// gives the followers an election timeout to reply before stepping
+    /// down
+    void set_quiesced(bool);
+    /// the follower acknowledged the quiescence announced by a heartbeat of
+    /// the session, sent by the leader of the term
+    void quiesce(uint64_t session, model::term_id);
+
+    /**
+     * \brief Offset up to which a local read is linearizable
+     *
+     * With `raft_enable_leader_lease` the leader holds a lease as long as a
+     * quorum acknowledged requests it sent less than the lease duration ago.
+     * Followers do not grant votes for an election timeout after hearing
+     * from the leader, so no other leader can be elected while the lease
+     * holds and the commit index of the leader is up to date. The lease is
+     * shorter than the election timeout to absorb clock drift.
+     *
+     * Returns errc::not_leader when not the leader and
+     * errc::leader_lease_expired when the lease is disabled or does not hold,
+     * in which case a read has to go through the log.
+     */
+    result<model::offset> linearizable_read_offset() const;
     /**
      * \brief Persist snapshot with given data and start offset
      *
@@ -123,6 +170,14 @@ public:
      */
     ss::future<> write_snapshot(write_snapshot_cfg);
 
+    /**
+     * \brief Reads the state machine data of the latest snapshot
+     *
+     * State machines whose entries were prefix truncated from the log rebuild
+     * their state from it, see state_machine::apply_snapshot.
+     */
+    ss::future<std::optional<snapshot_data>> read_snapshot();
+
     /// Increment and returns next append_entries order tracking sequence for
     /// follower with given node id
     follower_req_seq next_follower_sequence(model::node_id);
@@ -160,6 +215,18 @@ public:
      */
     model::offset last_visible_index() const { return _last_visible_index; };
 
+    /**
+     * Wait until the last visible index reaches the given offset, the timeout
+     * expires, or an abort is requested. Waiters are released with
+     * offset_monitor::wait_aborted when the consensus instance is stopped.
+     */
+    ss::future<> wait_for_visible_offset(
+      model::offset offset,
+      model::timeout_clock::time_point timeout,
+      ss::abort_source& as) {
+        return _consumable_offset_monitor.wait(offset, timeout, as);
+    }
+
     ss::future<offset_configuration>
     wait_for_config_change(model::offset last_seen, ss::abort_source& as) {
         return _configuration_manager.wait_for_change(last_seen, as);
@@ -210,6 +277,43 @@ public:
 
     probe& get_probe() { return _probe; };
 
+    /// The followers this leader is recovering, empty on followers
+    std::vector<follower_recovery_state> recovering_followers() const {
+        std::vector<follower_recovery_state> ret;
+        if (!is_leader()) {
+            return ret;
+        }
+        auto last_offset = _log.offsets().dirty_offset;
+        for (const auto& [node, meta] : _fstats) {
+            if (meta.is_recovering) {
+                ret.push_back(follower_recovery_state{
+                  .node = node,
+                  .match_index = meta.match_index,
+                  .last_offset = last_offset});
+            }
+        }
+        return ret;
+    }
+
+    /// The offsets every follower of this leader matches, empty on followers
+    std::vector<follower_recovery_state> follower_states() const {
+        std::vector<follower_recovery_state> ret;
+        if (!is_leader()) {
+            return ret;
+        }
+        auto last_offset = _log.offsets().dirty_offset;
+        ret.reserve(_fstats.size());
+        for (const auto& [node, meta] : _fstats) {
+            ret.push_back(follower_recovery_state{
+              .node = node,
+              .match_index = meta.match_index,
+              .last_offset = last_offset});
+        }
+        return ret;
+    }
+
+    storage::log_stats log_stats() const { return _log.stats(); }
+
 private:
     friend replicate_entries_stm;
     friend vote_stm;
@@ -222,8 +326,10 @@ private:
     // via the _op_sem
     void do_step_down();
     ss::future<vote_reply> do_vote(vote_request&&);
+    /// the units of _op_lock are released before waiting for the appended
+    /// entries to be flushed
     ss::future<append_entries_reply>
-    do_append_entries(append_entries_request&&);
+    do_append_entries(append_entries_request&&, ss::semaphore_units<>);
     ss::future<install_snapshot_reply>
     do_install_snapshot(install_snapshot_request&& r);
     /**
@@ -239,6 +345,12 @@ private:
     ss::future<install_snapshot_reply>
       finish_snapshot(install_snapshot_request, install_snapshot_reply);
 
+    ss::future<install_segment_reply>
+    do_install_segment(install_segment_request&& r);
+    ss::future<install_segment_reply>
+      finish_segment(install_segment_request, install_segment_reply);
+    ss::future<> abort_segment_receiver();
+
     ss::future<> do_write_snapshot(model::offset, iobuf&&);
     append_entries_reply make_append_entries_reply(storage::append_result);
 
@@ -254,6 +366,8 @@ private:
       model::node_id, result<append_entries_reply>, follower_req_seq seq_id);
     void successfull_append_entries_reply(
       follower_index_metadata&, append_entries_reply);
+    /// promotes the learner to a voter once it caught up with the leader
+    void maybe_promote_learner(const follower_index_metadata&);
 
     bool needs_recovery(const follower_index_metadata&);
     void dispatch_recovery(follower_index_metadata&);
@@ -268,8 +382,12 @@ private:
      * requests stable leadership optimization to be ignored.
      */
     void dispatch_vote(bool leadership_transfer);
+    ss::future<> do_dispatch_vote(bool leadership_transfer);
     ss::future<bool> dispatch_prevote(bool leadership_transfer);
     bool should_skip_vote(bool ignore_heartbeat);
+    /// true if the leader was heard from after the time point, by a
+    /// request of the group or by the heartbeats of a quiesced group
+    bool heard_from_leader(clock_type::time_point) const;
 
     /// Replicates configuration to other nodes,
     //  caller have to pass in _op_sem semaphore units
@@ -279,17 +397,37 @@ private:
     ss::future<> maybe_update_follower_commit_idx(model::offset);
 
     void arm_vote_timeout();
+    /// \brief with raft_adaptive_election_timeout, follows the intervals
+    /// at which the requests of the leader arrive, and sets the election
+    /// timeout to a few of them, as tcp sets its retransmission timeout from
+    /// the mean and deviation of the round trip time (rfc 6298)
+    void update_election_timeout(model::node_id leader);
     void update_node_append_timestamp(model::node_id);
     void update_node_hbeat_timestamp(model::node_id);
+    void update_node_append_rtt(model::node_id, clock_type::duration);
+    /// append entries round trip time within which a majority replies
+    clock_type::duration quorum_append_rtt() const;
 
     void update_follower_stats(const group_configuration&);
     void trigger_leadership_notification();
+    /// \brief caches every append of the log of a leader, and the tail of
+    /// those of a follower. a new leader reads the tail of its log into the
+    /// cache in the background
+    void update_batch_cache_policy();
 
     /// \brief _does not_ hold the lock.
     ss::future<> flush_log();
-    /// \brief called by the vote timer, to dispatch a write under
+    /// \brief called by the flush timer, to dispatch a write under
     /// the ops semaphore
     void dispatch_flush_with_lock();
+    /// \brief counts the bytes appended unflushed, and flushes them once
+    /// the flush policy of the group is met
+    void track_unflushed(size_t bytes);
+    /// the last offset of the log which counts as acknowledged by this
+    /// replica, see _bounded_loss
+    model::offset acked_offset(const storage::offset_stats& s) const {
+        return _bounded_loss ? s.dirty_offset : s.committed_offset;
+    }
 
     void maybe_step_down();
 
@@ -332,6 +470,29 @@ private:
     model::node_id _voted_for;
     std::optional<model::node_id> _leader_id;
     bool _transferring_leadership{false};
+    // acknowledgements of requests sent before do not count for the lease
+    clock_type::time_point _lease_not_before = clock_type::now();
+    bool _lease_enabled;
+    clock_type::duration _lease_duration;
+    rpc::compression_type _replication_compression;
+    /// quiescence, 0 disables it
+    clock_type::duration _quiesce_idle;
+    /// the dirty offset of the leader, unchanged since the time point
+    model::offset _quiesce_offset;
+    clock_type::time_point _quiesce_offset_since = clock_type::now();
+    /// the leader stopped heartbeating the group
+    bool _quiesced{false};
+    /// the heartbeat session the follower was quiesced by, 0 if none
+    uint64_t _quiesced_session{0};
+    /// bounds of the adaptive election timeout, unset when fixed
+    std::optional<std::pair<clock_type::duration, clock_type::duration>>
+      _election_timeout_bounds;
+    /// the leader the requests of which are timed, when they last arrived,
+    /// and the mean and deviation of the intervals between them
+    std::optional<model::node_id> _timed_leader;
+    clock_type::time_point _last_leader_request;
+    clock_type::duration _leader_interval{0};
+    clock_type::duration _leader_interval_dev{0};
 
     /// useful for when we are not the leader
     clock_type::time_point _hbeat = clock_type::now();
@@ -341,6 +502,19 @@ private:
     /// used for votes only. heartbeats are done by heartbeat_manager
     timer_type _vote_timeout;
 
+    /// with the flush.ms or flush.bytes topic properties the replicas
+    /// acknowledge entries once appended, and flush them once the interval
+    /// passes or the bytes are appended. the entries committed since the
+    /// last flush are lost if a quorum crashes. only flush.bytes set keeps
+    /// the default interval
+    static constexpr clock_type::duration default_flush_interval
+      = std::chrono::seconds(1);
+    bool _bounded_loss;
+    clock_type::duration _flush_interval;
+    std::optional<size_t> _flush_bytes;
+    size_t _unflushed_bytes{0};
+    timer_type _flush_timer;
+
     /// used for keepint tally on followers
     follower_stats _fstats;
 
@@ -353,6 +527,9 @@ private:
     /// all raft operations must happen exclusively since the common case
     /// is for the operation to touch the disk
     mutex _op_lock;
+    /// a single learner is promoted at a time, as promotion enters joint
+    /// consensus
+    bool _promoting_learner{false};
     /// used for notifying when commits happened to log
     event_manager _event_manager;
     probe _probe;
@@ -366,6 +543,7 @@ private:
     storage::api& _storage;
     storage::snapshot_manager _snapshot_mgr;
     std::optional<storage::snapshot_writer> _snapshot_writer;
+    std::optional<storage::segment_receiver> _segment_receiver;
     model::offset _last_snapshot_index;
     model::term_id _last_snapshot_term;
     configuration_manager _configuration_manager;
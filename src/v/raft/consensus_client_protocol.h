@@ -40,6 +40,10 @@ public:
           model::node_id, install_snapshot_request&&, rpc::client_opts)
           = 0;
 
+        virtual ss::future<result<install_segment_reply>> install_segment(
+          model::node_id, install_segment_request&&, rpc::client_opts)
+          = 0;
+
         virtual ss::future<result<timeout_now_reply>>
         timeout_now(model::node_id, timeout_now_request&&, rpc::client_opts)
           = 0;
@@ -75,6 +79,14 @@ public:
           target_node, std::move(r), std::move(opts));
     }
 
+    ss::future<result<install_segment_reply>> install_segment(
+      model::node_id target_node,
+      install_segment_request&& r,
+      rpc::client_opts opts) {
+        return _impl->install_segment(
+          target_node, std::move(r), std::move(opts));
+    }
+
     ss::future<result<timeout_now_reply>> timeout_now(
       model::node_id target_node,
       timeout_now_request&& r,
@@ -204,6 +204,23 @@ ss::circular_buffer<model::record_batch> make_ghost_batches_in_gaps(
     return res;
 }
 
+std::vector<bytes> persistent_state_keys(group_id group) {
+    std::vector<bytes> keys;
+    for (auto key :
+         {metadata_key::voted_for,
+          metadata_key::config_map,
+          metadata_key::config_latest_known_offset,
+          metadata_key::last_applied_offset}) {
+        iobuf buf;
+        reflection::serialize(buf, key, group);
+        keys.push_back(iobuf_to_bytes(buf));
+    }
+    for (uint16_t slot = 0; slot < configuration_manager::max_deltas; ++slot) {
+        keys.push_back(configuration_manager::delta_key(group, slot));
+    }
+    return keys;
+}
+
 ss::future<> persist_snapshot(
   storage::snapshot_manager& snapshot_manager,
   snapshot_metadata md,
@@ -47,6 +47,9 @@ read_bootstrap_state(storage::log, model::offset, ss::abort_source&);
 ss::circular_buffer<model::record_batch> make_ghost_batches_in_gaps(
   model::offset, ss::circular_buffer<model::record_batch>&&);
 
+/// the keys of the persistent state of a group in the consensus kvstore
+std::vector<bytes> persistent_state_keys(group_id);
+
 /// writes snapshot with given data to disk
 ss::future<>
 persist_snapshot(storage::snapshot_manager&, snapshot_metadata, iobuf&&);
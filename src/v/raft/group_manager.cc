@@ -11,8 +11,15 @@
 
 #include "config/configuration.h"
 #include "prometheus/prometheus_sanitize.h"
+#include "raft/logger.h"
+#include "raft/replicate_trace.h"
 #include "resource_mgmt/io_priority.h"
 
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/with_timeout.hh>
+
+#include <absl/container/flat_hash_set.h>
+
 namespace raft {
 
 group_manager::group_manager(
@@ -26,6 +33,11 @@ group_manager::group_manager(
   , _client(make_rpc_client_protocol(self, clients))
   , _heartbeats(heartbeat_interval, _client, _self)
   , _storage(storage.local()) {
+    _heartbeat_interval_watcher
+      = config::shard_local_cfg().raft_heartbeat_interval_ms.watch(
+        [this](std::chrono::milliseconds interval) {
+            _heartbeats.set_heartbeat_interval(interval);
+        });
     setup_metrics();
 }
 
@@ -41,9 +53,71 @@ ss::future<> group_manager::stop() {
       });
 }
 
-ss::future<ss::lw_shared_ptr<raft::consensus>> group_manager::create_group(
+ss::future<> group_manager::drain_leadership(
+  size_t max_concurrent, model::timeout_clock::time_point deadline) {
+    std::vector<ss::lw_shared_ptr<consensus>> led;
+    std::copy_if(
+      _groups.begin(),
+      _groups.end(),
+      std::back_inserter(led),
+      [](const ss::lw_shared_ptr<consensus>& c) { return c->is_leader(); });
+    if (led.empty()) {
+        return ss::now();
+    }
+    vlog(raftlog.info, "Draining leadership of {} groups", led.size());
+    auto sem = ss::make_lw_shared<ss::semaphore>(
+      std::max<size_t>(max_concurrent, 1));
+    const auto started = model::timeout_clock::now();
+    return ss::with_gate(
+      _gate, [this, sem, deadline, started, led = std::move(led)]() mutable {
+          return ss::parallel_for_each(
+                   led,
+                   [this, sem, deadline](ss::lw_shared_ptr<consensus> c) {
+                       return ss::with_semaphore(*sem, 1, [this, c, deadline] {
+                           return transfer_for_drain(c, deadline);
+                       });
+                   })
+            .finally([this, sem, started] {
+                _drain.duration
+                  = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    model::timeout_clock::now() - started);
+                vlog(
+                  raftlog.info,
+                  "Drained leadership in {}ms, {} groups failed to transfer",
+                  _drain.duration.count(),
+                  _drain.failed);
+            });
+      });
+}
+
+ss::future<> group_manager::transfer_for_drain(
+  ss::lw_shared_ptr<consensus> c, model::timeout_clock::time_point deadline) {
+    auto f = ss::make_ready_future<std::error_code>(
+      make_error_code(errc::timeout));
+    if (model::timeout_clock::now() < deadline) {
+        f = ss::with_timeout(deadline, c->transfer_leadership(std::nullopt));
+    }
+    return f
+      .handle_exception([](const std::exception_ptr&) {
+          return make_error_code(errc::timeout);
+      })
+      .then([this, c](std::error_code ec) {
+          if (!ec) {
+              ++_drain.transferred;
+              return;
+          }
+          ++_drain.failed;
+          vlog(
+            raftlog.info,
+            "Could not transfer leadership of group {}: {}",
+            c->group(),
+            ec.message());
+      });
+}
+
+ss::lw_shared_ptr<raft::consensus> group_manager::make_group(
   raft::group_id id, std::vector<model::broker> nodes, storage::log log) {
-    auto raft = ss::make_lw_shared<raft::consensus>(
+    return ss::make_lw_shared<raft::consensus>(
       _self,
       id,
       raft::group_configuration(std::move(nodes)),
@@ -57,7 +131,11 @@ ss::future<ss::lw_shared_ptr<raft::consensus>> group_manager::create_group(
           trigger_leadership_notification(std::move(st));
       },
       _storage);
+}
 
+ss::future<ss::lw_shared_ptr<raft::consensus>> group_manager::create_group(
+  raft::group_id id, std::vector<model::broker> nodes, storage::log log) {
+    auto raft = make_group(id, std::move(nodes), std::move(log));
     return ss::with_gate(_gate, [this, raft] {
         return _heartbeats.register_group(raft).then([this, raft] {
             _groups.push_back(raft);
@@ -66,6 +144,22 @@ ss::future<ss::lw_shared_ptr<raft::consensus>> group_manager::create_group(
     });
 }
 
+ss::future<std::vector<ss::lw_shared_ptr<raft::consensus>>>
+group_manager::create_groups(std::vector<group_params> params) {
+    std::vector<ss::lw_shared_ptr<raft::consensus>> groups;
+    groups.reserve(params.size());
+    for (auto& p : params) {
+        groups.push_back(make_group(p.id, std::move(p.nodes), p.log));
+    }
+    return ss::with_gate(_gate, [this, groups = std::move(groups)]() mutable {
+        return _heartbeats.register_groups(groups).then(
+          [this, groups = std::move(groups)]() mutable {
+              _groups.insert(_groups.end(), groups.begin(), groups.end());
+              return std::move(groups);
+          });
+    });
+}
+
 ss::future<> group_manager::remove(ss::lw_shared_ptr<raft::consensus> c) {
     return c->stop()
       .then([c] { return c->remove_persistent_state(); })
@@ -77,6 +171,52 @@ ss::future<> group_manager::remove(ss::lw_shared_ptr<raft::consensus> c) {
       });
 }
 
+ss::future<> group_manager::remove_groups(
+  std::vector<ss::lw_shared_ptr<raft::consensus>> groups) {
+    return ss::do_with(
+      std::move(groups),
+      [this](std::vector<ss::lw_shared_ptr<raft::consensus>>& groups) {
+          return ss::parallel_for_each(
+                   groups,
+                   [](ss::lw_shared_ptr<raft::consensus> c) {
+                       return c->stop().then(
+                         [c] { return c->remove_persistent_state(); });
+                   })
+            .then([this, &groups] {
+                std::vector<raft::group_id> ids;
+                ids.reserve(groups.size());
+                for (auto& c : groups) {
+                    ids.push_back(c->group());
+                }
+                return _heartbeats.deregister_groups(std::move(ids));
+            })
+            .finally([this, &groups] {
+                absl::flat_hash_set<raft::group_id> removed;
+                for (auto& c : groups) {
+                    removed.insert(c->group());
+                }
+                _groups.erase(
+                  std::remove_if(
+                    _groups.begin(),
+                    _groups.end(),
+                    [&removed](const ss::lw_shared_ptr<raft::consensus>& c) {
+                        return removed.contains(c->group());
+                    }),
+                  _groups.end());
+            });
+      });
+}
+
+ss::future<> group_manager::shutdown(ss::lw_shared_ptr<raft::consensus> c) {
+    return c->stop()
+      .then(
+        [this, id = c->group()] { return _heartbeats.deregister_group(id); })
+      .finally([this, c] {
+          _groups.erase(
+            std::remove(_groups.begin(), _groups.end(), c), _groups.end());
+      });
+}
+
 void group_manager::trigger_leadership_notification(
   raft::leadership_status st) {
     for (auto& cb : _notifications) {
@@ -94,9 +234,52 @@ void group_manager::setup_metrics() {
     _metrics.add_group(
       prometheus_sanitize::metrics_name("raft"),
       {sm::make_gauge(
-        "group_count",
-        [this] { return _groups.size(); },
-        sm::description("Number of raft groups"))});
+         "group_count",
+         [this] { return _groups.size(); },
+         sm::description("Number of raft groups")),
+       sm::make_derive(
+         "flush_waves",
+         [this] { return _storage.flush_coord().get_stats().waves; },
+         sm::description("Number of coalesced log flush waves")),
+       sm::make_derive(
+         "coalesced_flushes",
+         [this] { return _storage.flush_coord().get_stats().coalesced; },
+         sm::description("Number of log flushes served by a queued flush")),
+       sm::make_derive(
+         "leadership_drain_transfers",
+         [this] { return _drain.transferred; },
+         sm::description("Leaderships transferred away on shutdown")),
+       sm::make_derive(
+         "leadership_drain_failures",
+         [this] { return _drain.failed; },
+         sm::description("Leaderships that could not be transferred away on "
+                         "shutdown")),
+       sm::make_gauge(
+         "leadership_drain_duration_ms",
+         [this] { return _drain.duration.count(); },
+         sm::description("Duration of the leadership drain on shutdown"))});
+
+    for (size_t i = 0; i < replicate_tracer::stages; ++i) {
+        auto stage = static_cast<replicate_stage>(i);
+        _node_hists.push_back(node_histograms::add(
+          "produce_trace_stage_latency_us",
+          {{"stage", ss::sstring(to_string_view(stage))}},
+          shard_local_replicate_tracer().hist(stage)));
+        if (!config::shard_local_cfg().enable_shard_latency_metrics()) {
+            continue;
+        }
+        _metrics.add_group(
+          prometheus_sanitize::metrics_name("produce_trace"),
+          {sm::make_histogram(
+            "stage_latency_us",
+            [stage] {
+                return shard_local_replicate_tracer()
+                  .hist(stage)
+                  .seastar_histogram_logform();
+            },
+            sm::description("Latency of a stage of traced produce requests"),
+            {sm::label("stage")(ss::sstring(to_string_view(stage)))})});
+    }
 }
 
 } // namespace raft
@@ -11,12 +11,14 @@
 
 #pragma once
 #include "cluster/types.h"
+#include "config/property.h"
 #include "raft/consensus.h"
 #include "raft/consensus_client_protocol.h"
 #include "raft/heartbeat_manager.h"
 #include "raft/rpc_client_protocol.h"
 #include "raft/types.h"
 #include "storage/api.h"
+#include "utils/node_histograms.h"
 
 #include <seastar/core/metrics_registration.hh>
 
@@ -47,8 +49,41 @@ public:
     ss::future<ss::lw_shared_ptr<raft::consensus>> create_group(
       raft::group_id id, std::vector<model::broker> nodes, storage::log log);
 
+    /// A group to create, see create_groups
+    struct group_params {
+        raft::group_id id;
+        std::vector<model::broker> nodes;
+        storage::log log;
+    };
+
+    /// Creates many groups at once, registering them with the heartbeats in
+    /// a single step. The groups are returned in the order of the params
+    ss::future<std::vector<ss::lw_shared_ptr<raft::consensus>>>
+      create_groups(std::vector<group_params>);
+
     ss::future<> remove(ss::lw_shared_ptr<raft::consensus>);
 
+    /// Removes many groups at once: they are stopped concurrently and
+    /// deregistered from the heartbeats in a single step
+    ss::future<> remove_groups(std::vector<ss::lw_shared_ptr<raft::consensus>>);
+
+    /// Stops a group without removing its persistent state, so that it can
+    /// be started again on another core
+    ss::future<> shutdown(ss::lw_shared_ptr<raft::consensus>);
+
+    /// Transfers the leadership of the groups this core leads to their most
+    /// up to date follower, at most `max_concurrent` at once, so that a
+    /// planned shutdown does not leave them leaderless for an election
+    /// timeout. The transfers still running at the deadline are left to
+    /// complete on their own
+    ss::future<> drain_leadership(
+      size_t max_concurrent, model::timeout_clock::time_point deadline);
+
+    /// Sends the attachments along with the heartbeats of this core
+    void set_heartbeat_attachments(heartbeat_attachments* a) {
+        _heartbeats.set_attachments(a);
+    }
+
     cluster::notification_id_type
     register_leadership_notification(leader_cb_t cb) {
         auto id = _notification_id++;
@@ -73,7 +108,11 @@ public:
     }
 
 private:
+    ss::lw_shared_ptr<raft::consensus>
+      make_group(raft::group_id, std::vector<model::broker>, storage::log);
     void trigger_leadership_notification(raft::leadership_status);
+    ss::future<> transfer_for_drain(
+      ss::lw_shared_ptr<consensus>, model::timeout_clock::time_point);
     void setup_metrics();
 
     model::node_id _self;
@@ -85,8 +124,17 @@ private:
     cluster::notification_id_type _notification_id{0};
     std::vector<std::pair<cluster::notification_id_type, leader_cb_t>>
       _notifications;
+    struct drain_stats {
+        uint64_t transferred{0};
+        uint64_t failed{0};
+        std::chrono::milliseconds duration{0};
+    };
+    drain_stats _drain;
     ss::metrics::metric_groups _metrics;
+    std::vector<node_histograms::registration> _node_hists;
     storage::api& _storage;
+    config::property<std::chrono::milliseconds>::watcher
+      _heartbeat_interval_watcher;
 };
 
 } // namespace raft
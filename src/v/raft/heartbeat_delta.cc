@@ -0,0 +1,115 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/heartbeat_delta.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace raft {
+
+static constexpr size_t bits_per_word = 64;
+
+static void set_bit(std::vector<uint64_t>& bitmap, size_t i) {
+    bitmap[i / bits_per_word] |= uint64_t(1) << (i % bits_per_word);
+}
+
+static bool test_bit(const std::vector<uint64_t>& bitmap, size_t i) {
+    const auto w = i / bits_per_word;
+    return w < bitmap.size()
+           && (bitmap[w] & (uint64_t(1) << (i % bits_per_word))) != 0;
+}
+
+static bool group_less(const protocol_metadata& l, const protocol_metadata& r) {
+    return l.group < r.group;
+}
+
+void encode_heartbeat_delta(
+  heartbeat_request& req,
+  const heartbeat_state& state,
+  uint64_t base_seq,
+  const heartbeat_state& base) {
+    req.base_seq = base_seq;
+    req.unchanged.clear();
+    req.meta.clear();
+    if (base.empty()) {
+        req.base_seq = 0;
+        req.meta = state;
+        return;
+    }
+    req.unchanged.resize((base.size() + bits_per_word - 1) / bits_per_word);
+    // both are sorted by group, merge them
+    auto b = base.begin();
+    for (auto& m : state) {
+        b = std::lower_bound(b, base.end(), m, group_less);
+        if (b != base.end() && *b == m) {
+            set_bit(req.unchanged, std::distance(base.begin(), b));
+            continue;
+        }
+        req.meta.push_back(m);
+    }
+}
+
+heartbeat_state decode_heartbeat_delta(
+  const heartbeat_request& req, const heartbeat_state& base) {
+    heartbeat_state changed = req.meta;
+    std::sort(changed.begin(), changed.end(), group_less);
+    heartbeat_state state;
+    state.reserve(changed.size() + base.size());
+    auto c = changed.begin();
+    for (size_t i = 0; i < base.size(); ++i) {
+        if (!test_bit(req.unchanged, i)) {
+            continue;
+        }
+        while (c != changed.end() && c->group < base[i].group) {
+            state.push_back(*c++);
+        }
+        state.push_back(base[i]);
+    }
+    std::copy(c, changed.end(), std::back_inserter(state));
+    return state;
+}
+
+const heartbeat_state*
+heartbeat_bases::find(uint64_t session, uint64_t seq) const {
+    auto it = _sessions.find(session);
+    if (it == _sessions.end()) {
+        return nullptr;
+    }
+    for (const auto& b : it->second.bases) {
+        if (b.seq == seq) {
+            return &b.state;
+        }
+    }
+    return nullptr;
+}
+
+void heartbeat_bases::insert(
+  uint64_t session, uint64_t seq, heartbeat_state state) {
+    evict_idle_sessions();
+    auto& s = _sessions[session];
+    s.last_update = clock_type::now();
+    s.bases.push_back(base{.seq = seq, .state = std::move(state)});
+    while (s.bases.size() > max_bases_per_session) {
+        s.bases.pop_front();
+    }
+}
+
+void heartbeat_bases::evict_idle_sessions() {
+    const auto deadline = clock_type::now() - session_timeout;
+    for (auto it = _sessions.begin(); it != _sessions.end();) {
+        if (it->second.last_update < deadline) {
+            _sessions.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace raft
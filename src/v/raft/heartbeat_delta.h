@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "raft/types.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace raft {
+
+/// metadata of all groups of a heartbeat request, sorted by group
+using heartbeat_state = std::vector<protocol_metadata>;
+
+/**
+ * Delta encoding of heartbeat requests.
+ *
+ * A heartbeat request may refer to a previous request of the same session
+ * received by the target node, its base. Groups whose metadata did not change
+ * since the base are not sent. Instead, the request carries a bitmap with one
+ * bit for every group of the base, in group order, that is set when the group
+ * is heartbeated again with the same metadata. Only the groups that changed or
+ * were not part of the base are sent in full.
+ *
+ * `state` and `base` must be sorted by group.
+ */
+void encode_heartbeat_delta(
+  heartbeat_request&,
+  const heartbeat_state& state,
+  uint64_t base_seq,
+  const heartbeat_state& base);
+
+/// applies the delta to the base, returns the state of the request
+heartbeat_state
+decode_heartbeat_delta(const heartbeat_request&, const heartbeat_state& base);
+
+/**
+ * Recently received heartbeat states of each session, used as bases for
+ * decoding delta encoded heartbeats.
+ *
+ * A few states are kept for every session so that a request whose base is not
+ * the latest one, because its sender did not yet receive the reply to the
+ * latest request, can still be decoded. Sessions that stopped sending
+ * heartbeats, e.g. the sender restarted, are dropped after a while.
+ */
+class heartbeat_bases {
+public:
+    static constexpr size_t max_bases_per_session = 3;
+    static constexpr clock_type::duration session_timeout
+      = std::chrono::minutes(1);
+
+    /// returns nullptr if the base is not known
+    const heartbeat_state* find(uint64_t session, uint64_t seq) const;
+
+    void insert(uint64_t session, uint64_t seq, heartbeat_state);
+
+private:
+    struct base {
+        uint64_t seq;
+        heartbeat_state state;
+    };
+    struct session_bases {
+        std::deque<base> bases;
+        clock_type::time_point last_update;
+    };
+
+    void evict_idle_sessions();
+
+    absl::flat_hash_map<uint64_t, session_bases> _sessions;
+};
+
+} // namespace raft
@@ -17,8 +17,10 @@
 #include "raft/errc.h"
 #include "raft/raftgen_service.h"
 #include "raft/types.h"
+#include "random/generators.h"
 #include "rpc/reconnect_transport.h"
 #include "rpc/types.h"
+#include "utils/task_profiler.h"
 #include "vlog.h"
 
 #include <seastar/core/future-util.hh>
@@ -27,6 +29,8 @@
 #include <bits/stdint-uintn.h>
 #include <boost/range/iterator_range.hpp>
 
+#include <limits>
+
 namespace raft {
 ss::logger hbeatlog{"r/heartbeat"};
 using consensus_ptr = heartbeat_manager::consensus_ptr;
@@ -44,7 +48,7 @@ static std::vector<heartbeat_manager::node_heartbeat> requests_for_range(
     auto self = (*c.begin())->self();
     auto last_heartbeat = clock_type::now() - heartbeat_interval;
     for (auto& ptr : c) {
-        if (!ptr->is_leader()) {
+        if (!ptr->is_leader() || ptr->is_quiesced()) {
             continue;
         }
 
@@ -86,6 +90,7 @@ static std::vector<heartbeat_manager::node_heartbeat> requests_for_range(
     std::vector<heartbeat_manager::node_heartbeat> reqs;
     reqs.reserve(pending_beats.size());
     for (auto& p : pending_beats) {
+        // groups are visited in order, the requests are sorted by group
         std::vector<protocol_metadata> requests;
         absl::flat_hash_map<raft::group_id, follower_req_seq> sequence_map;
         requests.reserve(p.second.size());
@@ -107,7 +112,9 @@ heartbeat_manager::heartbeat_manager(
   duration_type interval, consensus_client_protocol proto, model::node_id self)
   : _heartbeat_interval(interval)
   , _client_protocol(proto)
-  , _self(self) {
+  , _self(self)
+  , _session(random_generators::get_int<uint64_t>(
+      1, std::numeric_limits<uint64_t>::max())) {
     _heartbeat_timer.set_callback([this] { dispatch_heartbeats(); });
 }
 
@@ -124,6 +131,14 @@ heartbeat_manager::send_heartbeats(std::vector<node_heartbeat> reqs) {
                          futures.push_back(do_self_heartbeat(std::move(r)));
                          continue;
                      }
+                     // a request without groups only carries an attachment
+                     // or keeps the session alive, it must not become the
+                     // base of the next ones
+                     if (!r.request.meta.empty()) {
+                         encode_delta(r);
+                     } else {
+                         r.request.session = _session;
+                     }
                      futures.push_back(do_heartbeat(std::move(r)));
                  }
                  return _dispatch_sem.wait(reqs.size())
@@ -139,8 +154,153 @@ heartbeat_manager::send_heartbeats(std::vector<node_heartbeat> reqs) {
 }
 
 ss::future<> heartbeat_manager::do_dispatch_heartbeats() {
-    auto reqs = requests_for_range(_consensus_groups, _heartbeat_interval);
-    return send_heartbeats(std::move(reqs));
+    return profile_task("heartbeat_manager::do_dispatch_heartbeats", [this] {
+        auto followers = update_quiescence();
+        auto reqs = requests_for_range(_consensus_groups, _heartbeat_interval);
+        announce_quiescence(reqs, followers);
+        attach(reqs);
+        return send_heartbeats(std::move(reqs));
+    });
+}
+
+void heartbeat_manager::attach(std::vector<node_heartbeat>& reqs) {
+    if (!_attachments) {
+        return;
+    }
+    for (auto id : _attachments->pending()) {
+        auto it = std::find_if(
+          reqs.begin(), reqs.end(), [id](const node_heartbeat& r) {
+              return r.target == id;
+          });
+        if (id != _self && it == reqs.end()) {
+            reqs.emplace_back(
+              id,
+              heartbeat_request{.node_id = _self},
+              absl::flat_hash_map<raft::group_id, follower_req_seq>{});
+        }
+    }
+    for (auto& r : reqs) {
+        if (r.target == _self) {
+            continue;
+        }
+        if (auto a = _attachments->attachment(r.target); a) {
+            r.request.attachment = std::move(a->first);
+            r.attachment_token = a->second;
+        }
+    }
+}
+
+absl::flat_hash_set<model::node_id> heartbeat_manager::update_quiescence() {
+    absl::flat_hash_set<model::node_id> followers;
+    for (auto& ptr : _consensus_groups) {
+        const bool can_quiesce = ptr->can_quiesce();
+        if (ptr->is_quiesced()) {
+            if (!can_quiesce) {
+                // appended to, or not the leader anymore
+                ptr->set_quiesced(false);
+                continue;
+            }
+            ptr->config().for_each_broker([this, &followers](
+                                            const model::broker& b) {
+                if (b.id() != _self) {
+                    followers.insert(b.id());
+                }
+            });
+            continue;
+        }
+        auto it = _quiescing.find(ptr->group());
+        if (!can_quiesce) {
+            if (it != _quiescing.end()) {
+                _quiescing.erase(it);
+            }
+            continue;
+        }
+        if (it != _quiescing.end()) {
+            continue;
+        }
+        std::vector<model::node_id> pending;
+        ptr->config().for_each_broker(
+          [this, &pending](const model::broker& b) {
+              if (b.id() != _self) {
+                  pending.push_back(b.id());
+              }
+          });
+        // a group without followers is not heartbeated over the network
+        if (!pending.empty()) {
+            vlog(hbeatlog.trace, "Quiescing group {}", ptr->group());
+            _quiescing.emplace(ptr->group(), std::move(pending));
+        }
+    }
+    return followers;
+}
+
+void heartbeat_manager::announce_quiescence(
+  std::vector<node_heartbeat>& reqs,
+  const absl::flat_hash_set<model::node_id>& followers) {
+    if (!_quiescing.empty()) {
+        for (auto& r : reqs) {
+            for (auto& [g, pending] : _quiescing) {
+                // only the groups heartbeated by the request are acknowledged
+                if (
+                  r.sequence_map.contains(g)
+                  && std::find(pending.begin(), pending.end(), r.target)
+                       != pending.end()) {
+                    r.request.quiesced.push_back(g);
+                }
+            }
+            std::sort(r.request.quiesced.begin(), r.request.quiesced.end());
+        }
+    }
+    for (auto id : followers) {
+        auto it = std::find_if(
+          reqs.begin(), reqs.end(), [id](const node_heartbeat& r) {
+              return r.target == id;
+          });
+        if (it == reqs.end()) {
+            reqs.emplace_back(
+              id,
+              heartbeat_request{.node_id = _self},
+              absl::flat_hash_map<raft::group_id, follower_req_seq>{});
+        }
+    }
+}
+
+void heartbeat_manager::quiesce_acknowledged(
+  model::node_id n,
+  const std::vector<raft::group_id>& groups,
+  const heartbeat_reply& reply) {
+    for (auto& m : reply.meta) {
+        if (
+          m.result != append_entries_reply::status::success
+          || !std::binary_search(groups.begin(), groups.end(), m.group)) {
+            continue;
+        }
+        auto it = _quiescing.find(m.group);
+        if (it == _quiescing.end()) {
+            continue;
+        }
+        auto& pending = it->second;
+        pending.erase(
+          std::remove(pending.begin(), pending.end(), n), pending.end());
+        if (!pending.empty()) {
+            continue;
+        }
+        _quiescing.erase(it);
+        if (auto c = _consensus_groups.find(m.group);
+            c != _consensus_groups.end()) {
+            vlog(hbeatlog.trace, "Quiesced group {}", m.group);
+            (*c)->set_quiesced(true);
+        }
+    }
+}
+
+void heartbeat_manager::wake_quiesced(model::node_id n) {
+    for (auto& ptr : _consensus_groups) {
+        if (ptr->is_quiesced() && ptr->config().contains_broker(n)) {
+            vlog(hbeatlog.trace, "Waking group {}", ptr->group());
+            ptr->set_quiesced(false);
+        }
+    }
 }
 
 ss::future<> heartbeat_manager::do_self_heartbeat(node_heartbeat&& r) {
@@ -161,7 +321,30 @@ ss::future<> heartbeat_manager::do_self_heartbeat(node_heartbeat&& r) {
     return ss::now();
 }
 
+void heartbeat_manager::encode_delta(node_heartbeat& r) {
+    r.state = std::move(r.request.meta);
+    r.request.session = _session;
+    r.request.seq = ++_next_seq;
+    auto it = _delta_bases.find(r.target);
+    if (it == _delta_bases.end()) {
+        encode_heartbeat_delta(r.request, r.state, 0, {});
+        return;
+    }
+    encode_heartbeat_delta(
+      r.request, r.state, it->second.seq, it->second.state);
+    vlog(
+      hbeatlog.trace,
+      "Heartbeat to {} sends {} of {} groups, base {}",
+      r.target,
+      r.request.meta.size(),
+      r.state.size(),
+      r.request.base_seq);
+}
+
 ss::future<> heartbeat_manager::do_heartbeat(node_heartbeat&& r) {
+    auto seq = r.request.seq;
+    auto token = r.attachment_token;
+    auto quiesced = r.request.quiesced;
     auto f = _client_protocol.heartbeat(
       r.target,
       std::move(r.request),
@@ -169,13 +352,48 @@ ss::future<> heartbeat_manager::do_heartbeat(node_heartbeat&& r) {
         next_heartbeat_timeout(), rpc::compression_type::zstd, 512));
     _dispatch_sem.signal();
     return f
-      .then([node = r.target, groups = std::move(r.sequence_map), this](
-              result<heartbeat_reply> ret) mutable {
+      .then([node = r.target,
+             groups = std::move(r.sequence_map),
+             seq,
+             token,
+             state = std::move(r.state),
+             quiesced = std::move(quiesced),
+             this](result<heartbeat_reply> ret) mutable {
+          if (ret && !quiesced.empty()) {
+              quiesce_acknowledged(node, quiesced, ret.value());
+          }
+          if (ret && seq != 0) {
+              update_delta_base(node, seq, std::move(state), ret.value());
+          }
+          if (ret && token && _attachments) {
+              _attachments->delivered(node, *token);
+          }
           process_reply(node, std::move(groups), std::move(ret));
       })
       .handle_exception_type([](const ss::gate_closed_exception&) {});
 }
 
+void heartbeat_manager::update_delta_base(
+  model::node_id n,
+  uint64_t seq,
+  heartbeat_state state,
+  const heartbeat_reply& reply) {
+    if (reply.base_missing) {
+        // the target lost our bases, e.g. it restarted. send all the groups
+        vlog(hbeatlog.debug, "Heartbeat base missing at node {}", n);
+        _delta_bases.erase(n);
+        return;
+    }
+    auto [it, inserted] = _delta_bases.try_emplace(
+      n, delta_base{.seq = seq, .state = {}});
+    if (!inserted && it->second.seq > seq) {
+        // reply to an older request
+        return;
+    }
+    it->second.seq = seq;
+    it->second.state = std::move(state);
+}
+
 void heartbeat_manager::process_reply(
   model::node_id n,
   absl::flat_hash_map<raft::group_id, follower_req_seq> groups,
@@ -187,6 +405,8 @@ void heartbeat_manager::process_reply(
           n,
           r,
           r.error().message());
+        // the followers on the node may not hear the session anymore
+        wake_quiesced(n);
         for (auto& [g, seq_id] : groups) {
             auto it = _consensus_groups.find(g);
             if (it == _consensus_groups.end()) {
@@ -235,6 +455,19 @@ ss::future<> heartbeat_manager::deregister_group(group_id g) {
         auto it = _consensus_groups.find(g);
         vassert(it != _consensus_groups.end(), "group not found: {}", g);
         _consensus_groups.erase(it);
+        _quiescing.erase(g);
+    });
+}
+
+ss::future<>
+heartbeat_manager::deregister_groups(std::vector<group_id> groups) {
+    return _lock.with([this, groups = std::move(groups)] {
+        for (auto g : groups) {
+            auto it = _consensus_groups.find(g);
+            vassert(it != _consensus_groups.end(), "group not found: {}", g);
+            _consensus_groups.erase(it);
+            _quiescing.erase(g);
+        }
     });
 }
 
@@ -250,6 +483,19 @@ heartbeat_manager::register_group(ss::lw_shared_ptr<consensus> ptr) {
     });
 }
 
+ss::future<> heartbeat_manager::register_groups(
+  std::vector<ss::lw_shared_ptr<consensus>> groups) {
+    return _lock.with([this, groups = std::move(groups)] {
+        const auto expected = _consensus_groups.size() + groups.size();
+        _consensus_groups.insert(groups.begin(), groups.end());
+        vassert(
+          _consensus_groups.size() == expected,
+          "double registration of groups, {} groups instead of {}",
+          _consensus_groups.size(),
+          expected);
+    });
+}
+
 ss::future<> heartbeat_manager::start() {
     dispatch_heartbeats();
     return ss::make_ready_future<>();
@@ -16,6 +16,7 @@
 #include "outcome.h"
 #include "raft/consensus.h"
 #include "raft/consensus_client_protocol.h"
+#include "raft/heartbeat_delta.h"
 #include "raft/types.h"
 #include "rpc/connection_cache.h"
 #include "utils/mutex.h"
@@ -25,6 +26,7 @@
 #include <seastar/util/log.hh>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 #include <boost/container/flat_set.hpp>
 
 namespace raft::details {
@@ -53,6 +55,23 @@ struct consensus_ptr_by_group_id {
 namespace raft {
 extern ss::logger hbeatlog;
 
+/**
+ * Data of an upper layer sent along with the heartbeats of a node, such as
+ * the leadership of the groups the node has no replica of. Nodes that share
+ * no group with this one get heartbeats carrying only their attachment.
+ */
+class heartbeat_attachments {
+public:
+    virtual ~heartbeat_attachments() = default;
+    /// \brief the nodes that have an attachment waiting
+    virtual std::vector<model::node_id> pending() = 0;
+    /// \brief the attachment of a node, with a token acknowledging it
+    virtual std::optional<std::pair<iobuf, uint64_t>>
+      attachment(model::node_id) = 0;
+    /// \brief the node received the attachment of the token
+    virtual void delivered(model::node_id, uint64_t token) = 0;
+};
+
 /**
  * The heartbeat manager addresses the scalability challenge of handling
  * heartbeats for a large number of raft groups by batching many heartbeats into
@@ -82,6 +101,18 @@ extern ss::logger hbeatlog;
  *
  *    heartbeat({L0, L1}) -> {F0, F1}(node-b)
  *    heartbeat({L0, L1}) -> {F0, F1}(node-c)
+ *
+ * Requests are further delta encoded against the last request acknowledged
+ * by the target node: groups whose metadata did not change since then are
+ * only flagged in a bitmap, see heartbeat_delta.h.
+ *
+ * With `raft_quiesce_idle_ms`, idle groups whose log is fully replicated are
+ * not heartbeated at all. The heartbeats of such a group announce it as
+ * quiesced until each follower acknowledged the announcement, and stop
+ * after. The nodes following quiesced groups keep getting a request per
+ * interval, empty if need be, whose session keeps the followers from holding
+ * an election, see node_liveness. A group is woken, and heartbeated again,
+ * once its leader appends to the log or fails to heartbeat a follower node.
  */
 class heartbeat_manager {
 public:
@@ -104,16 +135,34 @@ public:
         // each raft group has its own follower metadata hence we need map to
         // track a sequence per group
         absl::flat_hash_map<raft::group_id, follower_req_seq> sequence_map;
+        // metadata of all groups in the request, base of the next request
+        // once acknowledged
+        heartbeat_state state;
+        // acknowledges the attachment of the request once delivered
+        std::optional<uint64_t> attachment_token;
     };
     heartbeat_manager(
       duration_type interval, consensus_client_protocol, model::node_id);
 
     ss::future<> register_group(ss::lw_shared_ptr<consensus>);
+    /// \brief registers many groups with a single merge into the set
+    ss::future<> register_groups(std::vector<ss::lw_shared_ptr<consensus>>);
     ss::future<> deregister_group(raft::group_id);
+    /// \brief deregisters many groups under a single hold of the lock
+    ss::future<> deregister_groups(std::vector<raft::group_id>);
 
     ss::future<> start();
     ss::future<> stop();
 
+    /// \brief sends the attachments along with the heartbeats, or stops
+    /// sending them when null
+    void set_attachments(heartbeat_attachments* a) { _attachments = a; }
+
+    /// \brief the interval applies from the next dispatch
+    void set_heartbeat_interval(duration_type interval) {
+        _heartbeat_interval = interval;
+    }
+
 private:
     void dispatch_heartbeats();
 
@@ -124,6 +173,25 @@ private:
 
     ss::future<> send_heartbeats(std::vector<node_heartbeat>);
 
+    /// \brief adds the attachments to the requests
+    void attach(std::vector<node_heartbeat>&);
+    /// \brief quiesces the idle groups and wakes the others, returns the
+    /// nodes following quiesced groups
+    absl::flat_hash_set<model::node_id> update_quiescence();
+    /// \brief announces the groups being quiesced in the requests, and
+    /// sends a request to each node following quiesced groups
+    void announce_quiescence(
+      std::vector<node_heartbeat>&,
+      const absl::flat_hash_set<model::node_id>& followers);
+    /// \brief the followers acknowledged the quiesced groups of a request
+    void quiesce_acknowledged(
+      model::node_id,
+      const std::vector<raft::group_id>&,
+      const heartbeat_reply&);
+    /// \brief wakes the quiesced groups the node follows
+    void wake_quiesced(model::node_id);
+    /// \brief delta encodes the request against the last acknowledged one
+    void encode_delta(node_heartbeat&);
     /// \brief sends a batch to one node
     ss::future<> do_heartbeat(node_heartbeat&&);
     /// \brief handle heartbeat at local node
@@ -137,6 +205,9 @@ private:
       model::node_id n,
       absl::flat_hash_map<raft::group_id, follower_req_seq> groups,
       result<heartbeat_reply> result);
+    /// \brief records the state of an acknowledged request as the next base
+    void update_delta_base(
+      model::node_id, uint64_t seq, heartbeat_state, const heartbeat_reply&);
 
     // private members
 
@@ -152,5 +223,18 @@ private:
     consensus_client_protocol _client_protocol;
     ss::semaphore _dispatch_sem{0};
     model::node_id _self;
+
+    struct delta_base {
+        uint64_t seq;
+        heartbeat_state state;
+    };
+    // identifies the sequences of this manager at the target nodes
+    uint64_t _session;
+    uint64_t _next_seq{0};
+    absl::flat_hash_map<model::node_id, delta_base> _delta_bases;
+    heartbeat_attachments* _attachments{nullptr};
+    // groups announced as quiesced, with the followers yet to acknowledge
+    absl::flat_hash_map<raft::group_id, std::vector<model::node_id>>
+      _quiescing;
 };
 } // namespace raft
@@ -68,6 +68,20 @@ kvrsm::get_and_wait(ss::sstring key, model::timeout_clock::time_point timeout) {
 }
 
 ss::future<> kvrsm::apply(model::record_batch b) {
+    apply_batch(std::move(b));
+    return ss::now();
+}
+
+ss::future<>
+kvrsm::apply_batches(ss::circular_buffer<model::record_batch> batches) {
+    // commands are applied synchronously, the range needs a single future
+    for (auto& b : batches) {
+        apply_batch(std::move(b));
+    }
+    return ss::now();
+}
+
+void kvrsm::apply_batch(model::record_batch b) {
     if (b.header().type == kvrsm::kvrsm_batch_type) {
         auto last_offset = b.last_offset();
         auto result = process(std::move(b));
@@ -77,8 +91,6 @@ ss::future<> kvrsm::apply(model::record_batch b) {
             it->second.set_value(result);
         }
     }
-
-    return ss::now();
 }
 
 kvrsm::cmd_result kvrsm::process(model::record_batch&& b) {
@@ -125,6 +125,9 @@ private:
     cmd_result execute(cas_cmd c);
 
     ss::future<> apply(model::record_batch b) override;
+    ss::future<>
+      apply_batches(ss::circular_buffer<model::record_batch>) override;
+    void apply_batch(model::record_batch);
     ss::future<result<raft::replicate_result>> replicate(model::record_batch&&);
     ss::future<cmd_result> replicate_and_wait(
       model::record_batch&& b,
@@ -17,10 +17,14 @@
 namespace raft {
 
 log_eviction_stm::log_eviction_stm(
-  consensus* raft, ss::logger& logger, ss::abort_source& as)
+  consensus* raft,
+  ss::logger& logger,
+  ss::abort_source& as,
+  snapshot_data_fn snapshot_data)
   : _raft(raft)
   , _logger(logger)
-  , _as(as) {}
+  , _as(as)
+  , _snapshot_data(std::move(snapshot_data)) {}
 
 ss::future<> log_eviction_stm::start() {
     monitor_log_eviction();
@@ -55,8 +59,8 @@ log_eviction_stm::handle_deletion_notification(model::offset last_evicted) {
     if (last_evicted <= _previous_eviction_offset) {
         return ss::now();
     }
-    // persist empty snapshot, we can have no timeout in here as we are passing
-    // in an abort source
+    // persist the snapshot, empty unless a state machine provides its data.
+    // we can have no timeout in here as we are passing in an abort source
     _previous_eviction_offset = last_evicted;
 
     return _raft->events()
@@ -64,7 +68,7 @@ log_eviction_stm::handle_deletion_notification(model::offset last_evicted) {
       .then([this, last_evicted]() mutable {
           return _raft->write_snapshot(write_snapshot_cfg(
             last_evicted,
-            iobuf(),
+            _snapshot_data ? _snapshot_data(last_evicted) : iobuf(),
             write_snapshot_cfg::should_prefix_truncate::no));
       });
 }
@@ -16,6 +16,7 @@
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/util/log.hh>
+#include <seastar/util/noncopyable_function.hh>
 
 namespace raft {
 
@@ -27,7 +28,15 @@ class consensus;
  */
 class log_eviction_stm {
 public:
-    log_eviction_stm(consensus*, ss::logger&, ss::abort_source&);
+    /// the state machine data of the snapshot taken after the log was
+    /// evicted up to the offset
+    using snapshot_data_fn = ss::noncopyable_function<iobuf(model::offset)>;
+
+    log_eviction_stm(
+      consensus*,
+      ss::logger&,
+      ss::abort_source&,
+      snapshot_data_fn = snapshot_data_fn());
 
     ss::future<> start();
 
@@ -40,6 +49,7 @@ private:
     consensus* _raft;
     ss::logger& _logger;
     ss::abort_source& _as;
+    snapshot_data_fn _snapshot_data;
     ss::gate _gate;
     model::offset _previous_eviction_offset;
 };
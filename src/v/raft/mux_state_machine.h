@@ -29,9 +29,12 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <exception>
 #include <optional>
 #include <system_error>
+#include <type_traits>
 #include <variant>
+#include <vector>
 
 namespace raft {
 
@@ -47,6 +50,23 @@ CONCEPT(
 )
 // clang-format on
 
+// states may apply a run of consecutive batches at once with
+//
+//   ss::future<std::vector<std::error_code>>
+//     apply_updates(ss::circular_buffer<model::record_batch>);
+//
+// which returns the result of each batch, in order. the other states apply
+// the batches of a run one at a time with apply_update.
+template<typename T, typename = void>
+struct has_apply_updates : std::false_type {};
+
+template<typename T>
+struct has_apply_updates<
+  T,
+  std::void_t<decltype(std::declval<T&>().apply_updates(
+    std::declval<ss::circular_buffer<model::record_batch>>()))>>
+  : std::true_type {};
+
 using persistent_last_applied
   = ss::bool_class<struct persistent_last_applied_tag>;
 
@@ -62,6 +82,16 @@ using persistent_last_applied
 // state. Thanks to this approach it is easy to implement the optimistic
 // locking concurrency control in state.
 //
+// The batches of concurrent replicate_and_wait calls are replicated together:
+// the caller that gets to replicate takes the batches queued meanwhile along
+// with its own, and each caller still gets the result of applying its own
+// batch.
+//
+// Ranges of batches are applied in runs of consecutive batches of the same
+// state. The waiters of a run are notified together and the last applied
+// offset is persisted once per run, which keeps the replay of a long log from
+// paying for them per batch.
+//
 // IMPORTANT: is_batch_applicable results have to be mutually exclusive. i.e.
 // when batch is applicable for one state is has to be not applicable for
 // another
@@ -105,7 +135,7 @@ public:
     ss::future<result<raft::replicate_result>> replicate(model::record_batch&&);
 
     /// Replicates record batch and waits until state will be applied to the
-    /// state machine
+    /// state machine. Batches of concurrent calls are replicated at once
     ss::future<std::error_code> replicate_and_wait(
       model::record_batch&& b,
       model::timeout_clock::time_point timeout,
@@ -118,9 +148,33 @@ private:
     using container_t
       = absl::flat_hash_map<model::offset, expiring_promise<std::error_code>>;
 
+    using state_ptr = std::optional<std::variant<T*...>>;
+
+    // a batch queued by replicate_and_wait, until a caller replicates it
+    struct pending_replicate {
+        explicit pending_replicate(model::record_batch b)
+          : batch(std::move(b)) {}
+        model::record_batch batch;
+        // the last offset of the batch once replicated, or the error
+        std::optional<result<model::offset>> offset;
+        std::exception_ptr exception;
+    };
+    using pending_ptr = ss::lw_shared_ptr<pending_replicate>;
+
+    /// replicates the queued batches in a single request, and registers
+    /// the promises of their offsets. called with _mutex held
+    ss::future<> replicate_pending();
+
     ss::future<> apply(model::record_batch b) final;
+    ss::future<>
+      apply_batches(ss::circular_buffer<model::record_batch>) final;
+
+    state_ptr find_state(const model::record_batch&);
+    ss::future<>
+      apply_run(state_ptr, ss::circular_buffer<model::record_batch>);
 
     container_t _promises;
+    std::vector<pending_ptr> _pending;
 
     /*
      * Here the _mutex is used to make sure that promise was inserted into
@@ -191,35 +245,91 @@ ss::future<std::error_code> mux_state_machine<T...>::replicate_and_wait(
   model::timeout_clock::time_point timeout,
   ss::abort_source& as) {
     using ret_t = std::error_code;
-    return _mutex.get_units().then(
-      [this, b = std::move(b), timeout, &as](ss::semaphore_units<> u) mutable {
-          return replicate(std::move(b))
-            .then([this, u = std::move(u), timeout, &as](
-                    result<raft::replicate_result> r) {
-                if (!r) {
-                    return ss::make_ready_future<ret_t>(r.error());
-                }
-
-                auto last_offset = r.value().last_offset;
-
-                auto [it, insterted] = _promises.emplace(
-                  last_offset, expiring_promise<ret_t>{});
-                vassert(
-                  insterted,
-                  "Prosmise for offset {} already registered",
-                  last_offset);
-                return it->second
-                  .get_future_with_timeout(
-                    timeout, [] { return errc::timeout; }, as)
-                  .then_wrapped(
-                    [this, last_offset](ss::future<std::error_code> ec) {
-                        _promises.erase(last_offset);
-                        return ec;
-                    });
+    auto pending = ss::make_lw_shared<pending_replicate>(std::move(b));
+    _pending.push_back(pending);
+    return _mutex.get_units()
+      .then([this, pending](ss::semaphore_units<> u) {
+          // replicated by the caller that held the mutex before
+          if (pending->offset || pending->exception) {
+              return ss::now();
+          }
+          return replicate_pending().finally([u = std::move(u)] {});
+      })
+      .then([this, pending, timeout, &as] {
+          if (pending->exception) {
+              return ss::make_exception_future<ret_t>(pending->exception);
+          }
+          if (!*pending->offset) {
+              return ss::make_ready_future<ret_t>(pending->offset->error());
+          }
+          auto last_offset = pending->offset->value();
+          auto it = _promises.find(last_offset);
+          vassert(
+            it != _promises.end(),
+            "Promise for offset {} not registered",
+            last_offset);
+          return it->second
+            .get_future_with_timeout(timeout, [] { return errc::timeout; }, as)
+            .then_wrapped([this, last_offset](ss::future<std::error_code> ec) {
+                _promises.erase(last_offset);
+                return ec;
             });
       });
 }
 
+template<typename... T>
+ss::future<> mux_state_machine<T...>::replicate_pending() {
+    auto pending = std::exchange(_pending, {});
+    ss::circular_buffer<model::record_batch> batches;
+    batches.reserve(pending.size());
+    std::vector<int64_t> spans;
+    spans.reserve(pending.size());
+    for (auto& p : pending) {
+        spans.push_back(p->batch.header().last_offset_delta + 1);
+        batches.push_back(std::move(p->batch));
+    }
+    return _c
+      ->replicate(
+        model::make_memory_record_batch_reader(std::move(batches)),
+        raft::replicate_options{raft::consistency_level::quorum_ack})
+      .then_wrapped([this,
+                     pending = std::move(pending),
+                     spans = std::move(spans)](
+                      ss::future<result<raft::replicate_result>> f) {
+          if (f.failed()) {
+              auto e = f.get_exception();
+              for (auto& p : pending) {
+                  p->exception = e;
+              }
+              return;
+          }
+          auto r = f.get0();
+          if (!r) {
+              for (auto& p : pending) {
+                  p->offset = r.error();
+              }
+              return;
+          }
+          // the batches are appended in order and each ends right before the
+          // next one
+          auto last = r.value().last_offset;
+          for (size_t i = pending.size(); i-- > 0;) {
+              auto& p = pending[i];
+              p->offset = last;
+              last = last - model::offset(spans[i]);
+              const bool inserted
+                = _promises
+                    .emplace(
+                      p->offset->value(), expiring_promise<std::error_code>{})
+                    .second;
+              vassert(
+                inserted,
+                "Promise for offset {} already registered",
+                p->offset->value());
+          }
+      });
+}
+
 // return value only if state accepts given batch type
 template<typename State>
 static std::optional<State*>
@@ -231,39 +341,119 @@ is_batch_applicable(State& s, const model::record_batch& batch) {
 }
 
 template<typename... T>
-ss::future<> mux_state_machine<T...>::apply(model::record_batch b) {
-    // lookup for the state to apply the update
-    auto state = std::apply(
+typename mux_state_machine<T...>::state_ptr
+mux_state_machine<T...>::find_state(const model::record_batch& b) {
+    return std::apply(
       [&b](T&... st) {
-          using variant_t = std::variant<T*...>;
-          std::optional<variant_t> res;
+          state_ptr res;
           (void)((res = is_batch_applicable(st, b), res) || ...);
           return res;
       },
       _state);
+}
+
+template<typename State>
+static ss::future<std::vector<std::error_code>>
+apply_updates(State& s, ss::circular_buffer<model::record_batch> batches) {
+    if constexpr (has_apply_updates<State>::value) {
+        return s.apply_updates(std::move(batches));
+    } else {
+        return ss::do_with(
+          std::move(batches),
+          std::vector<std::error_code>{},
+          [&s](
+            ss::circular_buffer<model::record_batch>& batches,
+            std::vector<std::error_code>& results) {
+              results.reserve(batches.size());
+              return ss::do_for_each(
+                       batches,
+                       [&s, &results](model::record_batch& b) {
+                           return s.apply_update(std::move(b))
+                             .then([&results](std::error_code ec) {
+                                 results.push_back(ec);
+                             });
+                       })
+                .then([&results] { return std::move(results); });
+          });
+    }
+}
 
+template<typename... T>
+ss::future<> mux_state_machine<T...>::apply(model::record_batch b) {
+    auto state = find_state(b);
+    ss::circular_buffer<model::record_batch> run;
+    run.push_back(std::move(b));
+    return apply_run(state, std::move(run));
+}
+
+template<typename... T>
+ss::future<> mux_state_machine<T...>::apply_batches(
+  ss::circular_buffer<model::record_batch> batches) {
+    return ss::do_with(
+      std::move(batches),
+      [this](ss::circular_buffer<model::record_batch>& batches) {
+          return ss::repeat([this, &batches] {
+              if (batches.empty()) {
+                  return ss::make_ready_future<ss::stop_iteration>(
+                    ss::stop_iteration::yes);
+              }
+              auto state = find_state(batches.front());
+              ss::circular_buffer<model::record_batch> run;
+              do {
+                  run.push_back(std::move(batches.front()));
+                  batches.pop_front();
+              } while (!batches.empty()
+                       && find_state(batches.front()) == state);
+              return apply_run(state, std::move(run)).then([] {
+                  return ss::stop_iteration::no;
+              });
+          });
+      });
+}
+
+template<typename... T>
+ss::future<> mux_state_machine<T...>::apply_run(
+  state_ptr state, ss::circular_buffer<model::record_batch> run) {
     // applicable state not found
     if (!state) {
-        vassert(
-          b.header().type == state_machine::checkpoint_batch_type
-            || b.header().type == raft::configuration_batch_type,
-          "State handler for batch of type: {} not found",
-          b.header().type);
+        for (const auto& b : run) {
+            vassert(
+              b.header().type == state_machine::checkpoint_batch_type
+                || b.header().type == raft::configuration_batch_type,
+              "State handler for batch of type: {} not found",
+              b.header().type);
+        }
         return ss::now();
     }
 
-    auto last_offset = b.last_offset();
-    // apply update
-    auto result_f = std::visit(
-      [b = std::move(b)](auto& state) mutable {
-          return state->apply_update(std::move(b));
+    std::vector<model::offset> offsets;
+    offsets.reserve(run.size());
+    for (const auto& b : run) {
+        offsets.push_back(b.last_offset());
+    }
+    // apply updates
+    auto results_f = std::visit(
+      [run = std::move(run)](auto& state) mutable {
+          return apply_updates(*state, std::move(run));
       },
       *state);
 
-    return result_f.then([this, last_offset](std::error_code ec) {
-        auto f = _mutex.with([this, last_offset, ec] {
-            if (auto it = _promises.find(last_offset); it != _promises.end()) {
-                it->second.set_value(ec);
+    return results_f.then([this, offsets = std::move(offsets)](
+                            std::vector<std::error_code> results) mutable {
+        vassert(
+          results.size() == offsets.size(),
+          "Expected {} results of applied updates, got {}",
+          offsets.size(),
+          results.size());
+        auto last_offset = offsets.back();
+        auto f = _mutex.with([this,
+                              offsets = std::move(offsets),
+                              results = std::move(results)] {
+            for (size_t i = 0; i < offsets.size(); ++i) {
+                if (auto it = _promises.find(offsets[i]);
+                    it != _promises.end()) {
+                    it->second.set_value(results[i]);
+                }
             }
         });
         if (!_persist_last_applied) {
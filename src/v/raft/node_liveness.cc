@@ -0,0 +1,47 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/node_liveness.h"
+
+#include <algorithm>
+
+namespace raft {
+
+node_liveness& node_liveness::local() {
+    static thread_local node_liveness liveness;
+    return liveness;
+}
+
+void node_liveness::heard(uint64_t session, clock_type::time_point tp) {
+    auto& last = _sessions[session];
+    last = std::max(last, tp);
+    if (tp - _last_eviction > session_timeout) {
+        evict_idle_sessions(tp);
+    }
+}
+
+bool node_liveness::heard_since(
+  uint64_t session, clock_type::time_point tp) const {
+    auto it = _sessions.find(session);
+    return it != _sessions.end() && it->second > tp;
+}
+
+void node_liveness::evict_idle_sessions(clock_type::time_point now) {
+    _last_eviction = now;
+    const auto deadline = now - session_timeout;
+    for (auto it = _sessions.begin(); it != _sessions.end();) {
+        if (it->second < deadline) {
+            _sessions.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace raft
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "raft/types.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
+#include <cstdint>
+
+namespace raft {
+
+/**
+ * The heartbeat sessions heard by the current core, see heartbeat_manager.
+ *
+ * A quiesced follower is not heartbeated by its leader, and holds no
+ * election while the session of the leader's heartbeat manager is heard.
+ * The session is heard once per heartbeat interval, groups or not, so that
+ * the followers of all the quiesced groups of a node are kept alive by a
+ * single request. A new session, e.g. of a restarted node, is not the one
+ * the groups quiesced with.
+ */
+class node_liveness {
+public:
+    static constexpr clock_type::duration session_timeout
+      = std::chrono::minutes(1);
+    /// a session is noted by all cores at most once per resolution
+    static constexpr clock_type::duration resolution
+      = std::chrono::milliseconds(100);
+
+    node_liveness() = default;
+    node_liveness(const node_liveness&) = delete;
+    node_liveness& operator=(const node_liveness&) = delete;
+    node_liveness(node_liveness&&) = delete;
+    node_liveness& operator=(node_liveness&&) = delete;
+    ~node_liveness() = default;
+
+    void heard(uint64_t session, clock_type::time_point);
+
+    /// true if the session was heard after the time point
+    bool heard_since(uint64_t session, clock_type::time_point) const;
+
+    /// the liveness of the current core
+    static node_liveness& local();
+
+private:
+    void evict_idle_sessions(clock_type::time_point now);
+
+    absl::flat_hash_map<uint64_t, clock_type::time_point> _sessions;
+    clock_type::time_point _last_eviction;
+};
+
+} // namespace raft
@@ -30,7 +30,7 @@ ss::future<> offset_monitor::wait(
     if (offset <= _last_applied) {
         return ss::now();
     }
-    auto w = std::make_unique<waiter>(this, timeout, as);
+    auto w = std::make_unique<waiter>(this, offset, timeout, as);
     auto f = w->done.get_future();
     if (!f.available()) {
         // the future may already be available, for example if an abort had
@@ -50,16 +50,19 @@ void offset_monitor::notify(model::offset offset) {
         }
         it->second->done.set_value();
         // when the waiter is destroyed here by erase, then if they are active,
-        // the timer is cancelled and the abort source subscription is removed.
+        // the timeout is cancelled and the abort source subscription is
+        // removed.
         _waiters.erase(it);
     }
 }
 
 offset_monitor::waiter::waiter(
   offset_monitor* mon,
+  model::offset offset,
   model::timeout_clock::time_point timeout,
   std::optional<std::reference_wrapper<ss::abort_source>> as)
-  : mon(mon) {
+  : mon(mon)
+  , offset(offset) {
     if (as) {
         auto opt_sub = as->get().subscribe(
           [this]() noexcept { handle_abort(); });
@@ -71,22 +74,22 @@ offset_monitor::waiter::waiter(
         }
     }
     if (timeout != model::no_timeout) {
-        timer.set_callback([this] { handle_abort(); });
-        timer.arm(timeout);
+        deadline.set_callback([this] { handle_abort(); });
+        timing_wheel::local().arm(deadline, timeout);
     }
 }
 
 void offset_monitor::waiter::handle_abort() {
     done.set_exception(wait_aborted());
+    // only the waiters of the same offset are searched
+    auto [first, last] = mon->_waiters.equal_range(offset);
     auto it = std::find_if(
-      mon->_waiters.begin(),
-      mon->_waiters.end(),
-      [this](const waiters_type::value_type& w) {
+      first, last, [this](const waiters_type::value_type& w) {
           return w.second.get() == this;
       });
-    vassert(it != mon->_waiters.end(), "waiter not found");
+    vassert(it != last, "waiter not found");
     // when the waiter is destroyed here by erase, then if they are active,
-    // the timer is cancelled and the abort source subscription is removed.
+    // the timeout is cancelled and the abort source subscription is removed.
     mon->_waiters.erase(it); // *this is no longer valid after erase
 }
 
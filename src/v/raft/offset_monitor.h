@@ -13,10 +13,10 @@
 #include "model/fundamental.h"
 #include "model/timeout_clock.h"
 #include "seastarx.h"
+#include "utils/timing_wheel.h"
 
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/future.hh>
-#include <seastar/core/timer.hh>
 
 #include <absl/container/btree_map.h>
 
@@ -27,7 +27,8 @@ namespace raft {
  *
  * Utility for manging waiters based on a threshold offset. Supports multiple
  * waiters on the same offset, as well as timeout and abort source methods of
- * aborting a wait.
+ * aborting a wait. The timeouts are armed on the timing wheel of the shard,
+ * as most waits are notified long before they expire.
  */
 class offset_monitor {
 public:
@@ -69,12 +70,14 @@ public:
 private:
     struct waiter {
         offset_monitor* mon;
+        model::offset offset;
         ss::promise<> done;
-        ss::timer<model::timeout_clock> timer;
+        timing_wheel::entry deadline;
         ss::abort_source::subscription sub;
 
         waiter(
           offset_monitor*,
+          model::offset,
           model::timeout_clock::time_point,
           std::optional<std::reference_wrapper<ss::abort_source>>);
 
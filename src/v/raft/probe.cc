@@ -79,6 +79,20 @@ void probe::setup_metrics(const model::ntp& ntp) {
          [this] { return _log_flushes; },
          sm::description("Number of log flushes"),
          labels),
+       sm::make_derive(
+         "log_interval_flushes",
+         [this] { return _interval_flushes; },
+         sm::description(
+           "Number of flushes of acknowledged entries once the flush "
+           "interval passed"),
+         labels),
+       sm::make_derive(
+         "log_bytes_flushes",
+         [this] { return _bytes_flushes; },
+         sm::description(
+           "Number of flushes of acknowledged entries once the flush bytes "
+           "were appended"),
+         labels),
        sm::make_derive(
          "log_truncations",
          [this] { return _log_truncations; },
@@ -103,6 +117,13 @@ void probe::setup_metrics(const model::ntp& ntp) {
          "recovery_requests_errors",
          [this] { return _recovery_request_error; },
          sm::description("Number of failed recovery requests"),
+         labels),
+       sm::make_derive(
+         "append_windows_full",
+         [this] { return _append_windows_full; },
+         sm::description(
+           "Number of times a follower was switched to recovery as its window "
+           "of append entries requests in flight was full"),
          labels)});
 }
 
@@ -30,6 +30,8 @@ public:
 
     void log_truncated() { ++_log_truncations; }
     void log_flushed() { ++_log_flushes; }
+    void interval_flush() { ++_interval_flushes; }
+    void bytes_flush() { ++_bytes_flushes; }
 
     void replicate_batch_flushed() { ++_replicate_batch_flushed; }
     void recovery_append_request() { ++_recovery_requests; }
@@ -45,6 +47,7 @@ public:
     void heartbeat_request_error() { ++_heartbeat_request_error; };
     void replicate_request_error() { ++_replicate_request_error; };
     void recovery_request_error() { ++_recovery_request_error; };
+    void append_window_full() { ++_append_windows_full; }
 
 private:
     uint64_t _vote_requests = 0;
@@ -55,6 +58,8 @@ private:
     uint64_t _replicate_requests_ack_none = 0;
     uint64_t _replicate_requests_done = 0;
     uint64_t _log_flushes = 0;
+    uint64_t _interval_flushes = 0;
+    uint64_t _bytes_flushes = 0;
     uint64_t _replicate_batch_flushed = 0;
     uint32_t _log_truncations = 0;
     uint32_t _configuration_updates = 0;
@@ -63,6 +68,7 @@ private:
     uint64_t _heartbeat_request_error = 0;
     uint64_t _replicate_request_error = 0;
     uint64_t _recovery_request_error = 0;
+    uint64_t _append_windows_full = 0;
 
     ss::metrics::metric_groups _metrics;
 };
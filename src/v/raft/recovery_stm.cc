@@ -9,6 +9,7 @@
 
 #include "raft/recovery_stm.h"
 
+#include "config/configuration.h"
 #include "model/fundamental.h"
 #include "model/record_batch_reader.h"
 #include "outcome_future_utils.h"
@@ -16,9 +17,11 @@
 #include "raft/errc.h"
 #include "raft/logger.h"
 #include "raft/raftgen_service.h"
+#include "raft/recovery_throttle.h"
 
 #include <seastar/core/future-util.hh>
 
+#include <algorithm>
 #include <chrono>
 
 namespace raft {
@@ -29,7 +32,12 @@ recovery_stm::recovery_stm(
   : _ptr(p)
   , _node_id(node_id)
   , _prio(prio)
-  , _ctxlog(_ptr->group(), _ptr->ntp()) {}
+  , _ctxlog(_ptr->group(), _ptr->ntp())
+  , _read_size(config::shard_local_cfg().recovery_read_size_bytes())
+  , _max_inflight(std::max<size_t>(
+      1, config::shard_local_cfg().recovery_max_inflight_requests()))
+  , _inflight(_max_inflight)
+  , _stream_segments(config::shard_local_cfg().recovery_stream_segments()) {}
 
 ss::future<> recovery_stm::do_recover() {
     // We have to send all the records that leader have, event those that are
@@ -42,10 +50,50 @@ ss::future<> recovery_stm::do_recover() {
         return ss::make_ready_future<>();
     }
 
+    if (_reset_requested) {
+        // replies still in flight may move the follower next index, restart
+        // once all of them were processed
+        return drain_inflight().then([this] {
+            _reset_requested = false;
+            _next_read_offset.reset();
+            _segment_boundary.reset();
+        });
+    }
+
+    if (_streamed_segment) {
+        return send_install_segment_request();
+    }
+
     auto lstats = _ptr->_log.offsets();
-    // follower last index was already evicted at the leader, use snapshot
-    if (meta.value()->next_index < lstats.start_offset) {
-        return install_snapshot();
+    if (!_next_read_offset) {
+        // follower last index was already evicted at the leader, use snapshot
+        if (meta.value()->next_index < lstats.start_offset) {
+            return install_snapshot();
+        }
+        _next_read_offset = meta.value()->next_index;
+        // nothing is in flight, the follower log ends right before the next
+        // index. copy the segment as a whole if a closed one starts there
+        if (_stream_segments) {
+            return open_streamed_segment(meta.value()->next_index);
+        }
+    }
+
+    if (
+      *_next_read_offset > lstats.dirty_offset
+      || (_segment_boundary && *_next_read_offset > *_segment_boundary)) {
+        // everything was sent, wait for the replies. if the follower is still
+        // behind afterwards, the pipeline restarts from its next index
+        _segment_boundary.reset();
+        return drain_inflight().then([this] { _next_read_offset.reset(); });
+    }
+
+    auto end_offset = lstats.dirty_offset;
+    if (_stream_segments) {
+        // stop at the end of the segment, the following one may be streamed
+        _segment_boundary = _ptr->_log.closed_segment_end(*_next_read_offset);
+        if (_segment_boundary) {
+            end_offset = std::min(end_offset, *_segment_boundary);
+        }
     }
 
     /**
@@ -81,8 +129,7 @@ ss::future<> recovery_stm::do_recover() {
     _committed_offset = _ptr->committed_offset();
 
     // read & replicate log entries
-    return read_range_for_recovery(
-      meta.value()->next_index, lstats.dirty_offset);
+    return read_range_for_recovery(*_next_read_offset, end_offset);
 }
 
 ss::future<> recovery_stm::read_range_for_recovery(
@@ -91,11 +138,10 @@ ss::future<> recovery_stm::read_range_for_recovery(
       start_offset,
       end_offset,
       1,
-      // 32KB is a modest estimate. It has good batching and it also prevents an
-      // OOM situation where we have a lot of raft groups recovering at the same
-      // time and all drawing from memory. If this setting proves difficult,
-      // we'll need to throttle with a core-local semaphore
-      32 * 1024,
+      // memory used by a recovering follower is bounded by the read size
+      // times the number of requests in flight. If this setting proves
+      // difficult, we'll need to throttle with a core-local semaphore
+      _read_size,
       _prio,
       std::nullopt,
       std::nullopt,
@@ -130,9 +176,7 @@ ss::future<> recovery_stm::read_range_for_recovery(
               start_offset, std::move(batches));
             _base_batch_offset = gap_filled_batches.begin()->base_offset();
             _last_batch_offset = gap_filled_batches.back().last_offset();
-
-            auto f_reader = model::make_foreign_memory_record_batch_reader(
-              std::move(gap_filled_batches));
+            _next_read_offset = details::next_offset(_last_batch_offset);
 
             /**
              * We request follower to flush only when we use quorum consistency
@@ -143,7 +187,22 @@ ss::future<> recovery_stm::read_range_for_recovery(
               _last_batch_offset == lstats.dirty_offset
               && (_ptr->last_visible_index() <= _ptr->committed_offset()));
 
-            return replicate(std::move(f_reader), should_flush);
+            size_t bytes = 0;
+            for (const auto& b : gap_filled_batches) {
+                bytes += b.size_bytes();
+            }
+            auto codec = _ptr->replication_compression(gap_filled_batches);
+            return recovery_throttle::local()
+              .throttle(bytes, _ptr->_as)
+              .then([this,
+                     should_flush,
+                     codec,
+                     batches = std::move(gap_filled_batches)]() mutable {
+                  auto f_reader
+                    = model::make_foreign_memory_record_batch_reader(
+                      std::move(batches));
+                  return replicate(std::move(f_reader), should_flush, codec);
+              });
         });
 }
 
@@ -180,10 +239,7 @@ ss::future<> recovery_stm::send_install_snapshot_request() {
             _node_id,
             req.last_included_index);
           return _ptr->_client_protocol
-            .install_snapshot(
-              _node_id,
-              std::move(req),
-              rpc::client_opts(append_entries_timeout()))
+            .install_snapshot(_node_id, std::move(req), recovery_client_opts())
             .then([this](result<install_snapshot_reply> reply) {
                 return handle_install_snapshot_reply(reply);
             });
@@ -244,26 +300,169 @@ ss::future<> recovery_stm::install_snapshot() {
     });
 }
 
+ss::future<> recovery_stm::open_streamed_segment(model::offset base_offset) {
+    return _ptr->_log.open_closed_segment(base_offset)
+      .then([this](std::optional<storage::segment_files> files) {
+          if (!files) {
+              return;
+          }
+          vlog(
+            _ctxlog.debug,
+            "Streaming segment with base offset {} to node {}",
+            files->base_offset,
+            _node_id);
+          _streamed_segment = std::move(files);
+          _streamed_file = storage::segment_file_type::data;
+          _streamed_bytes = 0;
+          _next_read_offset.reset();
+      });
+}
+
+ss::future<> recovery_stm::send_install_segment_request() {
+    auto& seg = *_streamed_segment;
+    auto prev_log_term = get_prev_log_term(
+      details::prev_offset(seg.base_offset));
+    if (!prev_log_term) {
+        return close_streamed_segment();
+    }
+    const size_t size = seg.size(_streamed_file);
+    const size_t len = std::min(size - _streamed_bytes, _read_size);
+    return recovery_throttle::local()
+      .throttle(len, _ptr->_as)
+      .then([this, len] {
+          return _streamed_segment->get(_streamed_file)
+            .dma_read_bulk<char>(_streamed_bytes, len, _prio);
+      })
+      .then([this, len, size, prev_log_term = *prev_log_term](
+              ss::temporary_buffer<char> buf) {
+          if (buf.size() != len) {
+              return ss::make_exception_future<>(
+                std::runtime_error(fmt::format(
+                  "short read of segment {} {} file, expected {} bytes, got {}",
+                  _streamed_segment->base_offset,
+                  _streamed_file,
+                  len,
+                  buf.size())));
+          }
+          iobuf chunk;
+          chunk.append(std::move(buf));
+          auto& seg = *_streamed_segment;
+          install_segment_request req{
+            .term = _ptr->term(),
+            .group = _ptr->group(),
+            .node_id = _ptr->_self,
+            .base_offset = seg.base_offset,
+            .segment_term = seg.term,
+            .last_offset = seg.dirty_offset,
+            .prev_log_term = prev_log_term,
+            .commit_index = std::min(
+              seg.dirty_offset, _ptr->committed_offset()),
+            .file = _streamed_file,
+            .file_offset = _streamed_bytes,
+            .chunk = std::move(chunk),
+            .done = _streamed_file == storage::segment_file_type::index
+                    && _streamed_bytes + len == size};
+
+          vlog(_ctxlog.trace, "Sending install segment request {}", req);
+          _ptr->update_node_append_timestamp(_node_id);
+          return _ptr->_client_protocol
+            .install_segment(_node_id, std::move(req), recovery_client_opts())
+            .then([this](result<install_segment_reply> reply) {
+                return handle_install_segment_reply(reply);
+            });
+      })
+      .handle_exception([this](const std::exception_ptr& e) {
+          vlog(_ctxlog.warn, "Unable to stream segment - {}", e);
+          _stream_segments = false;
+          return close_streamed_segment();
+      });
+}
+
+ss::future<> recovery_stm::close_streamed_segment() {
+    if (!_streamed_segment) {
+        return ss::now();
+    }
+    auto files = std::move(*_streamed_segment);
+    _streamed_segment.reset();
+    _streamed_bytes = 0;
+    return ss::do_with(std::move(files), [](storage::segment_files& files) {
+        return files.close();
+    });
+}
+
+ss::future<> recovery_stm::handle_install_segment_reply(
+  result<install_segment_reply> reply) {
+    // segment delivery failed, fall back to append entries
+    if (reply.has_error() || !reply.value().success) {
+        vlog(
+          _ctxlog.debug,
+          "Unable to stream segment to node {}, falling back to append entries",
+          _node_id);
+        _stream_segments = false;
+        return close_streamed_segment().then(
+          [this, reply = std::move(reply)] {
+              if (reply && reply.value().term > _ptr->_term) {
+                  return _ptr->step_down(reply.value().term);
+              }
+              return ss::now();
+          });
+    }
+    _streamed_bytes = reply.value().bytes_stored;
+
+    // we will send next chunk as a part of recovery loop
+    if (_streamed_bytes != _streamed_segment->size(_streamed_file)) {
+        return ss::now();
+    }
+    if (_streamed_file == storage::segment_file_type::data) {
+        _streamed_file = storage::segment_file_type::index;
+        _streamed_bytes = 0;
+        return ss::now();
+    }
+
+    auto meta = get_follower_meta();
+    if (!meta) {
+        // stop recovery when node was removed
+        _stop_requested = true;
+        return close_streamed_segment();
+    }
+
+    // segment installed by the follower, continue with recovery
+    (*meta)->last_dirty_log_index = reply.value().last_dirty_log_index;
+    (*meta)->last_committed_log_index = reply.value().last_committed_log_index;
+    (*meta)->match_index = reply.value().last_dirty_log_index;
+    (*meta)->next_index = details::next_offset(
+      reply.value().last_dirty_log_index);
+    _ptr->maybe_update_leader_commit_idx();
+    return close_streamed_segment();
+}
+
+std::optional<model::term_id>
+recovery_stm::get_prev_log_term(model::offset prev_log_idx) {
+    auto lstats = _ptr->_log.offsets();
+    if (prev_log_idx >= lstats.start_offset) {
+        return _ptr->_log.get_term(prev_log_idx);
+    } else if (prev_log_idx < model::offset(0)) {
+        return model::term_id{};
+    } else if (prev_log_idx == _ptr->_last_snapshot_index) {
+        return _ptr->_last_snapshot_term;
+    }
+    return std::nullopt;
+}
+
 ss::future<> recovery_stm::replicate(
   model::record_batch_reader&& reader,
-  append_entries_request::flush_after_append flush) {
+  append_entries_request::flush_after_append flush,
+  rpc::compression_type codec) {
     // collect metadata for append entries request
     // last persisted offset is last_offset of batch before the first one in the
     // reader
     auto prev_log_idx = details::prev_offset(_base_batch_offset);
-    model::term_id prev_log_term;
-    auto lstats = _ptr->_log.offsets();
-
     // get term for prev_log_idx batch
-    if (prev_log_idx >= lstats.start_offset) {
-        prev_log_term = *_ptr->_log.get_term(prev_log_idx);
-    } else if (prev_log_idx < model::offset(0)) {
-        prev_log_term = model::term_id{};
-    } else if (prev_log_idx == _ptr->_last_snapshot_index) {
-        prev_log_term = _ptr->_last_snapshot_term;
-    } else {
+    auto prev_log_term = get_prev_log_term(prev_log_idx);
+    if (!prev_log_term) {
         // no entry for prev_log_idx, fallback to install snapshot
-        return install_snapshot();
+        _next_read_offset.reset();
+        return drain_inflight().then([this] { return install_snapshot(); });
     }
 
     // calculate commit index for follower to update immediately
@@ -278,64 +477,115 @@ ss::future<> recovery_stm::replicate(
         .commit_index = commit_idx,
         .term = _ptr->term(),
         .prev_log_index = prev_log_idx,
-        .prev_log_term = prev_log_term,
+        .prev_log_term = *prev_log_term,
         .last_visible_index = last_visible_idx},
       std::move(reader),
       flush);
 
-    _ptr->update_node_append_timestamp(_node_id);
+    return dispatch_pipelined(std::move(r), _base_batch_offset, codec);
+}
 
-    auto seq = _ptr->next_follower_sequence(_node_id);
-    return dispatch_append_entries(std::move(r)).then([this, seq](auto r) {
-        if (!r) {
-            vlog(
-              _ctxlog.error,
-              "recovery_stm: not replicate entry: {} - {}",
-              r,
-              r.error().message());
-            _stop_requested = true;
-            _ptr->get_probe().recovery_request_error();
-        }
-        _ptr->process_append_entries_reply(_node_id, r.value(), seq);
-        // If request was reordered we have to stop recovery as follower state
-        // is not known
-        if (seq < _ptr->_fstats.get(_node_id).last_received_seq) {
-            _stop_requested = true;
-            return;
-        }
-        // move the follower next index backward if recovery were not
-        // successfull
-        //
-        // Raft paper:
-        // If AppendEntries fails because of log inconsistency: decrement
-        // nextIndex and retry(§5.3)
-
-        if (r.value().result == append_entries_reply::status::failure) {
-            auto meta = get_follower_meta();
-            if (!meta) {
+ss::future<> recovery_stm::dispatch_pipelined(
+  append_entries_request r,
+  model::offset base_offset,
+  rpc::compression_type codec) {
+    // returns once the request is sent, the reply is handled in the
+    // background while holding one unit of the window
+    return ss::get_units(_inflight, 1).then(
+      [this, r = std::move(r), base_offset, codec](
+        ss::semaphore_units<> u) mutable {
+          if (_reset_requested || _stop_requested) {
+              // the follower state changed while waiting for the window
+              return;
+          }
+          _ptr->update_node_append_timestamp(_node_id);
+          auto seq = _ptr->next_follower_sequence(_node_id);
+          (void)ss::with_gate(
+            _inflight_gate,
+            [this, r = std::move(r), base_offset, seq, codec]() mutable {
+                return dispatch_append_entries(std::move(r), codec)
+                  .then([this, seq, base_offset](
+                          result<append_entries_reply> reply) {
+                      handle_append_entries_reply(
+                        std::move(reply), seq, base_offset);
+                  });
+            })
+            .handle_exception([this](const std::exception_ptr& e) {
+                vlog(_ctxlog.warn, "Recovery request failed - {}", e);
                 _stop_requested = true;
-                return;
-            }
-            meta.value()->next_index = std::max(
-              model::offset(0), details::prev_offset(_base_batch_offset));
-            vlog(
-              _ctxlog.trace,
-              "Move node {} next index {} backward",
-              _node_id,
-              meta.value()->next_index);
-        }
-    });
+            })
+            .finally([u = std::move(u)] {});
+      });
+}
+
+void recovery_stm::handle_append_entries_reply(
+  result<append_entries_reply> r,
+  follower_req_seq seq,
+  model::offset base_offset) {
+    if (!r) {
+        vlog(
+          _ctxlog.error,
+          "recovery_stm: not replicate entry: {} - {}",
+          r,
+          r.error().message());
+        _stop_requested = true;
+        _ptr->get_probe().recovery_request_error();
+        return;
+    }
+    _ptr->process_append_entries_reply(_node_id, r, seq);
+    auto meta = get_follower_meta();
+    if (!meta) {
+        _stop_requested = true;
+        return;
+    }
+    // If request was reordered we have to stop recovery as follower state
+    // is not known
+    if (seq < meta.value()->last_received_seq) {
+        _stop_requested = true;
+        return;
+    }
+    // move the follower next index backward if recovery were not
+    // successfull
+    //
+    // Raft paper:
+    // If AppendEntries fails because of log inconsistency: decrement
+    // nextIndex and retry(§5.3)
+
+    if (r.value().result == append_entries_reply::status::failure) {
+        meta.value()->next_index = std::max(
+          model::offset(0), details::prev_offset(base_offset));
+        _reset_requested = true;
+        vlog(
+          _ctxlog.trace,
+          "Move node {} next index {} backward",
+          _node_id,
+          meta.value()->next_index);
+    }
+}
+
+ss::future<> recovery_stm::drain_inflight() {
+    return ss::get_units(_inflight, _max_inflight).discard_result();
 }
 
 clock_type::time_point recovery_stm::append_entries_timeout() {
     return raft::clock_type::now() + _ptr->_recovery_append_timeout;
 }
 
+rpc::client_opts recovery_stm::recovery_client_opts() {
+    // keep recovery from delaying heartbeats and replication to the follower
+    rpc::client_opts opts(append_entries_timeout());
+    opts.traffic = rpc::traffic_class::recovery;
+    return opts;
+}
+
 ss::future<result<append_entries_reply>>
-recovery_stm::dispatch_append_entries(append_entries_request&& r) {
+recovery_stm::dispatch_append_entries(
+  append_entries_request&& r, rpc::compression_type codec) {
     _ptr->_probe.recovery_append_request();
+    auto opts = recovery_client_opts();
+    opts.compression = codec;
     return _ptr->_client_protocol.append_entries(
-      _node_id, std::move(r), rpc::client_opts(append_entries_timeout()));
+      _node_id, std::move(r), std::move(opts));
 }
 
 bool recovery_stm::is_recovery_finished() {
@@ -365,11 +615,13 @@ ss::future<> recovery_stm::apply() {
     return ss::with_gate(
              _ptr->_bg,
              [this] {
-                 return do_recover().then([this] {
-                     return ss::do_until(
-                       [this] { return is_recovery_finished(); },
-                       [this] { return do_recover(); });
-                 });
+                 return do_recover()
+                   .then([this] {
+                       return ss::do_until(
+                         [this] { return is_recovery_finished(); },
+                         [this] { return do_recover(); });
+                   })
+                   .finally([this] { return _inflight_gate.close(); });
              })
       .finally([this] {
           vlog(_ctxlog.trace, "Finished node {} recovery", _node_id);
@@ -378,10 +630,14 @@ ss::future<> recovery_stm::apply() {
               meta.value()->is_recovering = false;
               meta.value()->recovery_finished.broadcast();
           }
+          auto f = ss::now();
           if (_snapshot_reader != nullptr) {
-              return close_snapshot_reader();
+              f = close_snapshot_reader();
           }
-          return ss::now();
+          if (_streamed_segment) {
+              f = f.then([this] { return close_streamed_segment(); });
+          }
+          return f;
       });
 }
 
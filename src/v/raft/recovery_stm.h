@@ -15,8 +15,27 @@
 #include "raft/consensus.h"
 #include "raft/types.h"
 
+#include <seastar/core/gate.hh>
+#include <seastar/core/semaphore.hh>
+
 namespace raft {
 
+/*
+ * Brings a follower up to date with the leader log.
+ *
+ * Recovery is pipelined: up to `recovery_max_inflight_requests` append
+ * entries requests of `recovery_read_size_bytes` each are in flight to the
+ * follower, so throughput is not bounded by one round trip per request. The
+ * leader reads ahead with its own cursor and, when the follower rejects a
+ * request or replies out of order, waits for the requests in flight and
+ * restarts from the follower next index.
+ *
+ * When `recovery_stream_segments` is set, closed segments of the leader log
+ * that start right after the end of the follower log are copied to the
+ * follower file by file instead, without decoding their batches. Reads are
+ * clipped at segment boundaries so that a follower catching up on entries
+ * reaches the start of the next closed segment.
+ */
 class recovery_stm {
 public:
     recovery_stm(consensus*, model::node_id, ss::io_priority_class);
@@ -26,11 +45,20 @@ private:
     ss::future<> do_recover();
     ss::future<> read_range_for_recovery(model::offset, model::offset);
     ss::future<> replicate(
-      model::record_batch_reader&&, append_entries_request::flush_after_append);
+      model::record_batch_reader&&,
+      append_entries_request::flush_after_append,
+      rpc::compression_type);
+    ss::future<> dispatch_pipelined(
+      append_entries_request, model::offset, rpc::compression_type);
+    void handle_append_entries_reply(
+      result<append_entries_reply>, follower_req_seq, model::offset);
+    ss::future<> drain_inflight();
+    std::optional<model::term_id> get_prev_log_term(model::offset);
     ss::future<result<append_entries_reply>>
-    dispatch_append_entries(append_entries_request&&);
+      dispatch_append_entries(append_entries_request&&, rpc::compression_type);
     std::optional<follower_index_metadata*> get_follower_meta();
     clock_type::time_point append_entries_timeout();
+    rpc::client_opts recovery_client_opts();
 
     ss::future<> install_snapshot();
     ss::future<> send_install_snapshot_request();
@@ -38,6 +66,11 @@ private:
     ss::future<> open_snapshot_reader();
     ss::future<> close_snapshot_reader();
 
+    ss::future<> open_streamed_segment(model::offset);
+    ss::future<> send_install_segment_request();
+    ss::future<> handle_install_segment_reply(result<install_segment_reply>);
+    ss::future<> close_streamed_segment();
+
     bool is_recovery_finished();
 
     consensus* _ptr;
@@ -53,6 +86,24 @@ private:
     size_t _snapshot_size = 0;
     // needed to early exit. (node down)
     bool _stop_requested = false;
+
+    // next offset to read, ahead of the follower next index by the requests
+    // in flight. not set when the pipeline is empty
+    std::optional<model::offset> _next_read_offset;
+    // the follower rejected a request, the pipeline must be restarted
+    bool _reset_requested = false;
+    size_t _read_size;
+    size_t _max_inflight;
+    ss::semaphore _inflight;
+    ss::gate _inflight_gate;
+
+    // tracking follower segment delivery
+    bool _stream_segments;
+    std::optional<storage::segment_files> _streamed_segment;
+    storage::segment_file_type _streamed_file{storage::segment_file_type::data};
+    size_t _streamed_bytes = 0;
+    // last offset of the closed segment the current reads were clipped to
+    std::optional<model::offset> _segment_boundary;
 };
 
 } // namespace raft
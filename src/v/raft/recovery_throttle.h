@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "config/configuration.h"
+#include "seastarx.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/smp.hh>
+
+#include <chrono>
+#include <cstdint>
+
+namespace raft {
+
+/// Bounds the rate at which the recoveries of a core send data to followers,
+/// so that moving replicas, e.g. off a decommissioned node, does not take the
+/// disk and the network from the clients.
+///
+/// The node wide recovery_max_bytes_per_sec is split evenly across cores. The
+/// recoveries share a token bucket holding at most a second worth of bytes;
+/// a recovery takes its bytes right away, leaving the bucket in debt, and
+/// waits for the debt to be repaid, so that concurrent recoveries queue up in
+/// order.
+class recovery_throttle {
+public:
+    static recovery_throttle& local() {
+        static thread_local recovery_throttle throttle;
+        return throttle;
+    }
+
+    /// Waits until `bytes` more may be sent, or the abort source fires
+    ss::future<> throttle(size_t bytes, ss::abort_source& as) {
+        auto rate = per_core_rate();
+        if (rate == 0) {
+            return ss::now();
+        }
+        refill(rate);
+        _tokens -= static_cast<int64_t>(bytes);
+        if (_tokens >= 0) {
+            return ss::now();
+        }
+        auto wait = std::chrono::milliseconds(-_tokens * 1000 / rate);
+        return ss::sleep_abortable(wait, as);
+    }
+
+private:
+    using clock_type = ss::lowres_clock;
+
+    recovery_throttle() = default;
+
+    static int64_t per_core_rate() {
+        auto rate = config::shard_local_cfg().recovery_max_bytes_per_sec();
+        if (!rate) {
+            return 0;
+        }
+        return std::max<int64_t>(1, *rate / ss::smp::count);
+    }
+
+    void refill(int64_t rate) {
+        auto now = clock_type::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+          now - _last_refill);
+        _last_refill = now;
+        _tokens = std::min(rate, _tokens + elapsed.count() * rate / 1000);
+    }
+
+    int64_t _tokens{0};
+    clock_type::time_point _last_refill{clock_type::now()};
+};
+
+} // namespace raft
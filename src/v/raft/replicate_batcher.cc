@@ -9,45 +9,93 @@
 
 #include "raft/replicate_batcher.h"
 
+#include "config/configuration.h"
 #include "model/fundamental.h"
 #include "model/record_batch_reader.h"
 #include "raft/consensus_utils.h"
 #include "raft/errc.h"
 #include "raft/replicate_entries_stm.h"
+#include "raft/replicate_trace.h"
 #include "raft/types.h"
 
 #include <seastar/core/semaphore.hh>
 #include <seastar/core/sleep.hh>
 #include <seastar/core/smp.hh>
 
+#include <algorithm>
 #include <chrono>
 #include <exception>
 
 namespace raft {
-using namespace std::chrono_literals; // NOLINT
 replicate_batcher::replicate_batcher(consensus* ptr, size_t cache_size)
   : _ptr(ptr)
-  , _max_batch_size(cache_size) {
-    _flush_timer.set_callback([this] {
-        (void)ss::with_gate(_ptr->_bg, [this] {
-            // background block further caching too
-            return _lock.with([this] { return flush(); });
-        }).handle_exception_type([this](const ss::gate_closed_exception&) {
-            vlog(
-              _ptr->_ctxlog.debug,
-              "Gate closed while flushing replicate requests");
-        });
+  , _max_batch_size(cache_size)
+  , _latency_target(
+      config::shard_local_cfg().replicate_batch_latency_target_ms())
+  , _target_bytes(cache_size)
+  , _sample_start(clock_type::now()) {
+    _flush_timer.set_callback([this] { dispatch_background_flush(); });
+}
+
+void replicate_batcher::dispatch_background_flush() {
+    (void)ss::with_gate(_ptr->_bg, [this] {
+        // background block further caching too
+        return _lock.with([this] { return flush(); });
+    }).handle_exception_type([this](const ss::gate_closed_exception&) {
+        vlog(
+          _ptr->_ctxlog.debug, "Gate closed while flushing replicate requests");
     });
 }
 
+void replicate_batcher::update_targets() {
+    using seconds = std::chrono::duration<double>;
+    auto now = clock_type::now();
+    auto elapsed = seconds(now - _sample_start).count();
+    if (elapsed > 0) {
+        constexpr double alpha = 0.2;
+        _bytes_rate = (1 - alpha) * _bytes_rate
+                      + alpha * static_cast<double>(_sampled_bytes) / elapsed;
+        _requests_rate = (1 - alpha) * _requests_rate
+                         + alpha * static_cast<double>(_sampled_requests)
+                             / elapsed;
+    }
+    _sampled_bytes = 0;
+    _sampled_requests = 0;
+    _sample_start = now;
+
+    auto rtt = _ptr->quorum_append_rtt();
+    auto budget = _latency_target > rtt ? _latency_target - rtt
+                                        : clock_type::duration(0);
+    // when not even one more request is expected within the budget, waiting
+    // for it would only add latency
+    _linger = _requests_rate * seconds(budget).count() < 1.0
+                ? clock_type::duration(0)
+                : budget;
+    // enough to keep the followers busy while a batch is in flight
+    auto expected = static_cast<size_t>(
+      _bytes_rate * seconds(_linger + rtt).count());
+    _target_bytes = std::clamp(
+      expected, std::min(min_batch_bytes, _max_batch_size), _max_batch_size);
+}
+
 ss::future<result<replicate_result>>
-replicate_batcher::replicate(model::record_batch_reader&& r) {
+replicate_batcher::replicate(model::record_batch_reader&& r, bool traced) {
+    std::optional<clock_type::time_point> traced_since;
+    if (traced) {
+        traced_since = clock_type::now();
+    }
     return _lock
       .with(
         [this, r = std::move(r)]() mutable { return do_cache(std::move(r)); })
-      .then([this](item_ptr i) {
-          if (_pending_bytes < _max_batch_size || !_flush_timer.armed()) {
-              _flush_timer.rearm(clock_type::now() + 4ms);
+      .then([this, traced_since](item_ptr i) {
+          i->traced_since = traced_since;
+          if (_pending_bytes >= _target_bytes) {
+              _flush_timer.cancel();
+              dispatch_background_flush();
+          } else if (!_flush_timer.armed()) {
+              // the window starts with the first pending request, so that it
+              // bounds the latency that batching adds
+              _flush_timer.arm(_linger);
           }
           return i->_promise.get_future();
       });
@@ -70,6 +118,7 @@ ss::future<> replicate_batcher::stop() {
             _item_cache.clear();
             _data_cache.clear();
             _pending_bytes = 0;
+            _memory.set(0);
         }
     });
 }
@@ -82,6 +131,8 @@ replicate_batcher::do_cache(model::record_batch_reader&& r) {
           for (auto& b : batches) {
               record_count += b.record_count();
               _pending_bytes += b.size_bytes();
+              _memory.add(b.size_bytes());
+              _sampled_bytes += b.size_bytes();
               if (b.header().ctx.owner_shard == ss::this_shard_id()) {
                   _data_cache.emplace_back(std::move(b));
               } else {
@@ -89,6 +140,7 @@ replicate_batcher::do_cache(model::record_batch_reader&& r) {
               }
           }
           i->record_count = record_count;
+          _sampled_requests += 1;
           _item_cache.emplace_back(i);
           return i;
       });
@@ -98,13 +150,17 @@ ss::future<> replicate_batcher::flush() {
     if (_pending_bytes == 0) {
         return ss::make_ready_future<>();
     }
+    update_targets();
     auto notifications = std::exchange(_item_cache, {});
     auto data = std::exchange(_data_cache, {});
+    // counted until the batches are appended and released
+    auto memory = std::move(_memory);
     _pending_bytes = 0;
     return ss::with_gate(
       _ptr->_bg,
       [this,
        data = std::move(data),
+       memory = std::move(memory),
        notifications = std::move(notifications)]() mutable {
           return _ptr->_op_lock.get_units().then(
             [this,
@@ -124,6 +180,16 @@ ss::future<> replicate_batcher::flush() {
                     return ss::make_ready_future<>();
                 }
 
+                auto& tracer = shard_local_replicate_tracer();
+                auto now = clock_type::now();
+                for (auto& n : notifications) {
+                    if (n->traced_since) {
+                        tracer.record(
+                          replicate_stage::batcher_wait,
+                          now - *n->traced_since);
+                    }
+                }
+
                 auto meta = _ptr->meta();
                 auto const term = model::term_id(meta.term);
                 for (auto& b : data) {
@@ -139,7 +205,8 @@ ss::future<> replicate_batcher::flush() {
                   std::move(req),
                   std::move(u),
                   std::move(seqs));
-            });
+            })
+            .finally([memory = std::move(memory)] {});
       });
 }
 static void propagate_result(
@@ -176,8 +243,12 @@ ss::future<> replicate_batcher::do_flush(
   ss::semaphore_units<> u,
   absl::flat_hash_map<model::node_id, follower_req_seq> seqs) {
     _ptr->_probe.replicate_batch_flushed();
+    bool traced = std::any_of(
+      notifications.begin(), notifications.end(), [](const item_ptr& i) {
+          return i->traced_since.has_value();
+      });
     auto stm = ss::make_lw_shared<replicate_entries_stm>(
-      _ptr, std::move(req), std::move(seqs));
+      _ptr, std::move(req), std::move(seqs), traced);
     return stm->apply(std::move(u))
       .then_wrapped([this, stm, notifications = std::move(notifications)](
                       ss::future<result<replicate_result>> fut) mutable {
@@ -14,22 +14,41 @@
 #include "model/record_batch_reader.h"
 #include "outcome.h"
 #include "raft/types.h"
+#include "resource_mgmt/memory_accounting.h"
 #include "utils/mutex.h"
 
 #include <absl/container/flat_hash_map.h>
+
+#include <optional>
+
 namespace raft {
 class consensus;
 
+/*
+ * Accumulates replicate requests and dispatches them to the followers in a
+ * single append entries request.
+ *
+ * How long requests linger and how many bytes make a full batch adapt to the
+ * load. Both are derived, on every flush, from the observed arrival rate of
+ * requests and the append round trip time of the quorum, so that requests
+ * are replicated within the configured latency target. A request that is not
+ * expected to be followed by another one within the target is dispatched
+ * right away. Batches bigger than the target flush without waiting for the
+ * linger window.
+ */
 class replicate_batcher {
 public:
     struct item {
         ss::promise<result<replicate_result>> _promise;
         replicate_result ret;
         size_t record_count;
+        // when the traced request entered the batcher
+        std::optional<clock_type::time_point> traced_since;
     };
     using item_ptr = ss::lw_shared_ptr<item>;
     // 1MB default size
     static constexpr size_t default_batch_bytes = 1024 * 1024;
+    static constexpr size_t min_batch_bytes = 16 * 1024;
 
     explicit replicate_batcher(
       consensus* ptr, size_t cache_size = default_batch_bytes);
@@ -41,11 +60,14 @@ public:
     ~replicate_batcher() noexcept = default;
 
     ss::future<result<replicate_result>>
-    replicate(model::record_batch_reader&&);
+    replicate(model::record_batch_reader&&, bool traced = false);
 
     ss::future<> flush();
     ss::future<> stop();
 
+    clock_type::duration linger() const { return _linger; }
+    size_t target_bytes() const { return _target_bytes; }
+
     // it will lock on behalf of caller to append entries to leader log.
     ss::future<> do_flush(
       std::vector<item_ptr>&&,
@@ -55,14 +77,27 @@ public:
 
 private:
     ss::future<item_ptr> do_cache(model::record_batch_reader&&);
+    void dispatch_background_flush();
+    void update_targets();
 
     consensus* _ptr;
     size_t _max_batch_size{default_batch_bytes};
     size_t _pending_bytes{0};
     timer_type _flush_timer;
 
+    clock_type::duration _latency_target;
+    clock_type::duration _linger{0};
+    size_t _target_bytes;
+    // moving averages of the arrival rates, per second
+    double _bytes_rate{0};
+    double _requests_rate{0};
+    size_t _sampled_bytes{0};
+    size_t _sampled_requests{0};
+    clock_type::time_point _sample_start;
+
     std::vector<item_ptr> _item_cache;
     ss::circular_buffer<model::record_batch> _data_cache;
+    tracked_memory _memory{tracked_memory::subsystem::raft_batcher};
     mutex _lock;
 };
 
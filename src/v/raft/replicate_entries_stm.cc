@@ -9,6 +9,8 @@
 
 #include "raft/replicate_entries_stm.h"
 
+#include "config/configuration.h"
+#include "finjector/latency_probe.h"
 #include "likely.h"
 #include "model/fundamental.h"
 #include "model/metadata.h"
@@ -21,24 +23,46 @@
 #include "raft/types.h"
 #include "rpc/types.h"
 
+#include <algorithm>
 #include <chrono>
 
 namespace raft {
 using namespace std::chrono_literals;
 
-ss::future<append_entries_request> replicate_entries_stm::share_request() {
-    // one extra copy is needed for retries
-    return with_semaphore(_share_sem, 1, [this] {
-        return details::foreign_share_n(std::move(_req.batches), 2)
-          .then([this](std::vector<model::record_batch_reader> readers) {
-              // keep a copy around until the end
-              _req.batches = std::move(readers.back());
-              readers.pop_back();
-              return append_entries_request{
-                _req.node_id, _req.meta, std::move(readers.back())};
-          });
-    });
+ss::future<> replicate_entries_stm::encode_request() {
+    return model::consume_reader_to_memory(
+             std::move(_req.batches), model::no_timeout)
+      .then([this](ss::circular_buffer<model::record_batch> batches) {
+          _batches = std::move(batches);
+          // encoded once, the requests to all the followers share the buffer
+          _encoded = ss::make_lw_shared<iobuf>(
+            append_entries_request::encode_batches(share_batches()));
+      });
+}
+
+ss::circular_buffer<model::record_batch>
+replicate_entries_stm::share_batches() {
+    ss::circular_buffer<model::record_batch> ret;
+    ret.reserve(_batches.size());
+    for (auto& b : _batches) {
+        ret.push_back(b.share());
+    }
+    return ret;
+}
+
+append_entries_request replicate_entries_stm::follower_request() {
+    // with bounded loss the followers acknowledge the entries unflushed
+    append_entries_request req(
+      _req.node_id,
+      _req.meta,
+      model::make_memory_record_batch_reader(
+        ss::circular_buffer<model::record_batch>{}),
+      _ptr->_bounded_loss ? append_entries_request::flush_after_append::no
+                          : append_entries_request::flush_after_append::yes);
+    req.encoded_batches = ss::make_foreign(_encoded);
+    return req;
 }
+
 ss::future<result<append_entries_reply>> replicate_entries_stm::do_dispatch_one(
   model::node_id n,
   append_entries_request req,
@@ -46,10 +70,14 @@ ss::future<result<append_entries_reply>> replicate_entries_stm::do_dispatch_one(
     using ret_t = result<append_entries_reply>;
 
     if (n == _ptr->_self) {
-        auto f = _ptr->flush_log()
-                   .then([this, units]() {
+        auto start = clock_type::now();
+        // with bounded loss the entries are flushed by the flush policy
+        auto flushed = _ptr->_bounded_loss ? ss::now() : _ptr->flush_log();
+        auto f = std::move(flushed)
+                   .then([this, units, start]() {
+                       trace(replicate_stage::leader_flush, start);
                        auto lstats = _ptr->_log.offsets();
-                       auto last_idx = lstats.committed_offset;
+                       auto last_idx = _ptr->acked_offset(lstats);
                        append_entries_reply reply;
                        reply.node_id = _ptr->_self;
                        reply.group = _ptr->group();
@@ -68,6 +96,15 @@ ss::future<result<append_entries_reply>> replicate_entries_stm::do_dispatch_one(
         _dispatch_sem.signal();
         return f;
     }
+    // the dispatch of the requests holds up the next replicate of the group
+    using point = finjector::latency_probe::point;
+    auto& latency = finjector::shard_local_latency_probe();
+    if (unlikely(latency.is_delayed(point::replicate_dispatch))) {
+        return latency.delay(point::replicate_dispatch)
+          .then([this, n, req = std::move(req)]() mutable {
+              return send_append_entries_request(n, std::move(req));
+          });
+    }
     return send_append_entries_request(n, std::move(req));
 }
 
@@ -81,8 +118,20 @@ replicate_entries_stm::send_append_entries_request(
     _ptr->update_node_append_timestamp(n);
     vlog(_ctxlog.trace, "Sending append entries request {} to {}", req.meta, n);
 
-    auto f = _ptr->_client_protocol.append_entries(
-      n, std::move(req), rpc::client_opts(append_entries_timeout()));
+    rpc::client_opts opts(append_entries_timeout());
+    opts.traffic = rpc::traffic_class::replication;
+    opts.compression = _ptr->replication_compression(_batches);
+    auto f = _ptr->_client_protocol
+               .append_entries(n, std::move(req), std::move(opts))
+               .then([this, n, sent = clock_type::now()](
+                       result<append_entries_reply> r) {
+                   if (r) {
+                       _ptr->update_node_append_rtt(
+                         n, clock_type::now() - sent);
+                       trace(replicate_stage::follower_rtt, sent);
+                   }
+                   return r;
+               });
     _dispatch_sem.signal();
     return f;
 }
@@ -93,7 +142,9 @@ ss::future<> replicate_entries_stm::dispatch_one(
     return ss::with_gate(
              _req_bg,
              [this, id, units]() mutable {
+                 track_inflight(id, true);
                  return dispatch_single_retry(id, std::move(units))
+                   .finally([this, id] { track_inflight(id, false); })
                    .then([this, id](result<append_entries_reply> reply) {
                        auto it = _followers_seq.find(id);
                        auto seq = it == _followers_seq.end()
@@ -112,10 +163,9 @@ ss::future<result<append_entries_reply>>
 replicate_entries_stm::dispatch_single_retry(
   model::node_id id,
   ss::lw_shared_ptr<std::vector<ss::semaphore_units<>>> units) {
-    return share_request()
-      .then([this, id, units](append_entries_request r) mutable {
-          return do_dispatch_one(id, std::move(r), units);
-      })
+    return ss::futurize_invoke([this, id, units] {
+               return do_dispatch_one(id, follower_request(), units);
+           })
       .handle_exception([this](const std::exception_ptr& e) {
           vlog(_ctxlog.warn, "Error while replicating entries {}", e);
           return result<append_entries_reply>(
@@ -125,10 +175,17 @@ replicate_entries_stm::dispatch_single_retry(
 
 ss::future<result<storage::append_result>>
 replicate_entries_stm::append_to_self() {
-    return share_request()
-      .then([this](append_entries_request req) mutable {
-          vlog(_ctxlog.trace, "Self append entries - {}", req.meta);
-          return _ptr->disk_append(std::move(req.batches));
+    return encode_request()
+      .then([this] {
+          vlog(_ctxlog.trace, "Self append entries - {}", _req.meta);
+          auto start = clock_type::now();
+          return _ptr
+            ->disk_append(
+              model::make_memory_record_batch_reader(share_batches()))
+            .then([this, start](storage::append_result res) {
+                trace(replicate_stage::local_append, start);
+                return res;
+            });
       })
       .then([](storage::append_result res) {
           return result<storage::append_result>(std::move(res));
@@ -146,6 +203,37 @@ inline bool replicate_entries_stm::is_follower_recovering(model::node_id id) {
     return id != _ptr->self() && _ptr->_fstats.get(id).is_recovering;
 }
 
+bool replicate_entries_stm::has_append_window(model::node_id id) {
+    if (id == _ptr->self()) {
+        return true;
+    }
+    const auto& meta = _ptr->_fstats.get(id);
+    const auto& cfg = config::shard_local_cfg();
+    // a single request is always let through, however large
+    return meta.inflight_appends == 0
+           || (meta.inflight_appends < cfg.raft_max_inflight_follower_appends()
+               && meta.inflight_append_bytes + _encoded->size_bytes()
+                    <= cfg.raft_max_inflight_follower_append_bytes());
+}
+
+void replicate_entries_stm::track_inflight(model::node_id id, bool sent) {
+    // the follower may have left the configuration in the meantime
+    auto it = _ptr->_fstats.find(id);
+    if (id == _ptr->self() || it == _ptr->_fstats.end()) {
+        return;
+    }
+    auto& meta = it->second;
+    const auto bytes = _encoded->size_bytes();
+    if (sent) {
+        ++meta.inflight_appends;
+        meta.inflight_append_bytes += bytes;
+    } else {
+        meta.inflight_appends -= std::min<size_t>(meta.inflight_appends, 1);
+        meta.inflight_append_bytes -= std::min(
+          meta.inflight_append_bytes, bytes);
+    }
+}
+
 ss::future<result<replicate_result>>
 replicate_entries_stm::apply(ss::semaphore_units<> u) {
     // first append lo leader log, no flushing
@@ -173,6 +261,18 @@ replicate_entries_stm::apply(ss::semaphore_units<> u) {
                       n.id());
                     return;
                 }
+                // instead of queueing requests behind those a slow follower
+                // did not acknowledge yet, recovery streams the entries to it
+                // at the pace of its acknowledgements
+                if (!has_append_window(n.id())) {
+                    vlog(
+                      _ctxlog.debug,
+                      "Window of append requests to {} is full, recovering",
+                      n.id());
+                    _ptr->get_probe().append_window_full();
+                    _ptr->dispatch_recovery(_ptr->_fstats.get(n.id()));
+                    return;
+                }
                 ++requests_count;
                 (void)dispatch_one(n.id(), units); // background
             });
@@ -200,7 +300,8 @@ replicate_entries_stm::apply(ss::semaphore_units<> u) {
                      || _ptr->term() > appended_term;
           };
           return _ptr->_commit_index_updated.wait(stop_cond).then(
-            [this, appended_offset, appended_term] {
+            [this, appended_offset, appended_term, start = clock_type::now()] {
+                trace(replicate_stage::commit_wait, start);
                 return process_result(appended_offset, appended_term);
             });
       });
@@ -237,15 +338,24 @@ result<replicate_result> replicate_entries_stm::process_result(
 
 ss::future<> replicate_entries_stm::wait() { return _req_bg.close(); }
 
+void replicate_entries_stm::trace(
+  replicate_stage stage, clock_type::time_point start) {
+    if (_traced) {
+        shard_local_replicate_tracer().record(
+          stage, clock_type::now() - start);
+    }
+}
+
 replicate_entries_stm::replicate_entries_stm(
   consensus* p,
   append_entries_request r,
-  absl::flat_hash_map<model::node_id, follower_req_seq> seqs)
+  absl::flat_hash_map<model::node_id, follower_req_seq> seqs,
+  bool traced)
   : _ptr(p)
   , _req(std::move(r))
   , _followers_seq(std::move(seqs))
-  , _share_sem(1)
-  , _ctxlog(_ptr->group(), _ptr->ntp()) {}
+  , _ctxlog(_ptr->group(), _ptr->ntp())
+  , _traced(traced) {}
 
 replicate_entries_stm::~replicate_entries_stm() {
     vassert(
@@ -13,6 +13,7 @@
 
 #include "model/metadata.h"
 #include "raft/consensus.h"
+#include "raft/replicate_trace.h"
 #include "seastarx.h"
 #include "storage/types.h"
 
@@ -76,10 +77,12 @@ namespace raft {
 
 class replicate_entries_stm {
 public:
+    /// a traced stm records the latency of its stages, see replicate_tracer
     replicate_entries_stm(
       consensus*,
       append_entries_request,
-      absl::flat_hash_map<model::node_id, follower_req_seq>);
+      absl::flat_hash_map<model::node_id, follower_req_seq>,
+      bool traced = false);
     ~replicate_entries_stm();
 
     /// caller have to pass _op_sem semaphore units, the apply call will do the
@@ -90,7 +93,11 @@ public:
     ss::future<> wait();
 
 private:
-    ss::future<append_entries_request> share_request();
+    /// reads the batches of the request and encodes them once
+    ss::future<> encode_request();
+    ss::circular_buffer<model::record_batch> share_batches();
+    /// the request to a follower, sharing the encoded batches
+    append_entries_request follower_request();
 
     ss::future<> dispatch_one(
       model::node_id, ss::lw_shared_ptr<std::vector<ss::semaphore_units<>>>);
@@ -105,17 +112,25 @@ private:
       send_append_entries_request(model::node_id, append_entries_request);
     result<replicate_result> process_result(model::offset, model::term_id);
     bool is_follower_recovering(model::node_id);
+    /// whether the request fits in the window of the follower
+    bool has_append_window(model::node_id);
+    /// adds the request to, or removes it from, the window of the follower
+    void track_inflight(model::node_id, bool sent);
     clock_type::time_point append_entries_timeout();
     /// This append will happen under the lock
     ss::future<result<storage::append_result>> append_to_self();
+    void trace(replicate_stage, clock_type::time_point start);
+
     consensus* _ptr;
-    /// we keep a copy around until we finish the retries
     append_entries_request _req;
+    /// we keep the batches around until we finish the retries
+    ss::circular_buffer<model::record_batch> _batches;
+    ss::lw_shared_ptr<iobuf> _encoded;
     absl::flat_hash_map<model::node_id, follower_req_seq> _followers_seq;
-    ss::semaphore _share_sem;
     ss::semaphore _dispatch_sem{0};
     ss::gate _req_bg;
     ctx_log _ctxlog;
+    bool _traced;
 };
 
 } // namespace raft
@@ -0,0 +1,46 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/replicate_trace.h"
+
+#include "config/configuration.h"
+
+namespace raft {
+
+std::string_view to_string_view(replicate_stage s) {
+    switch (s) {
+    case replicate_stage::kafka_decode:
+        return "kafka_decode";
+    case replicate_stage::shard_hop:
+        return "shard_hop";
+    case replicate_stage::batcher_wait:
+        return "batcher_wait";
+    case replicate_stage::local_append:
+        return "local_append";
+    case replicate_stage::follower_rtt:
+        return "follower_rtt";
+    case replicate_stage::leader_flush:
+        return "leader_flush";
+    case replicate_stage::commit_wait:
+        return "commit_wait";
+    }
+    return "unknown";
+}
+
+bool replicate_tracer::sample() {
+    auto period = config::shard_local_cfg().produce_trace_sample_period();
+    return period > 0 && _requests++ % period == 0;
+}
+
+replicate_tracer& shard_local_replicate_tracer() {
+    static thread_local replicate_tracer tracer;
+    return tracer;
+}
+
+} // namespace raft
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "raft/types.h"
+#include "utils/hdr_hist.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+namespace raft {
+
+/// Stages of the path of a produce request, from the kafka server to the
+/// commit of its batches.
+enum class replicate_stage : uint8_t {
+    /// decoding the kafka request
+    kafka_decode = 0,
+    /// hop from the connection shard to the home shard of the partition
+    shard_hop,
+    /// wait in the replicate batcher until its batch is dispatched
+    batcher_wait,
+    /// append to the log of the leader, without flushing
+    local_append,
+    /// append entries round trip to a follower
+    follower_rtt,
+    /// flush of the log of the leader
+    leader_flush,
+    /// wait from the dispatch of the batch until it is committed
+    commit_wait,
+};
+
+std::string_view to_string_view(replicate_stage);
+
+/// \brief per shard latency histograms of the stages of a produce request
+///
+/// One of every produce_trace_sample_period requests is traced. A traced
+/// request records the latency of each stage it goes through on the shard
+/// the stage runs on. Stages past the batcher are shared by every request of
+/// the batch, and are recorded when the batch holds a traced request.
+class replicate_tracer {
+public:
+    static constexpr size_t stages = 7;
+
+    /// whether the next request is traced
+    bool sample();
+
+    void record(replicate_stage s, clock_type::duration d) {
+        _hists[static_cast<size_t>(s)].record(
+          std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    }
+
+    const hdr_hist& hist(replicate_stage s) const {
+        return _hists[static_cast<size_t>(s)];
+    }
+
+private:
+    // up to a minute at 2 significant figures
+    static hdr_hist make_hist() { return hdr_hist(60000000, 1, 2); }
+
+    uint64_t _requests{0};
+    std::array<hdr_hist, stages> _hists{
+      make_hist(),
+      make_hist(),
+      make_hist(),
+      make_hist(),
+      make_hist(),
+      make_hist(),
+      make_hist()};
+};
+
+replicate_tracer& shard_local_replicate_tracer();
+
+} // namespace raft
@@ -10,20 +10,110 @@
 #include "raft/rpc_client_protocol.h"
 
 #include "outcome_future_utils.h"
+#include "raft/logger.h"
 #include "raft/raftgen_service.h"
 #include "rpc/connection_cache.h"
 #include "rpc/exceptions.h"
 #include "rpc/transport.h"
 #include "rpc/types.h"
+#include "vlog.h"
+
+#include <seastar/core/sleep.hh>
+
+#include <algorithm>
 
 namespace raft {
 
 ss::future<result<vote_reply>> rpc_client_protocol::vote(
   model::node_id n, vote_request&& r, rpc::client_opts opts) {
+    auto& q = _votes[n];
+    if (q.votes.empty()) {
+        q.timeout = opts.timeout;
+        q.traffic = opts.traffic;
+        (void)ss::sleep(vote_linger).then(
+          [self = shared_from_this(), n] { self->dispatch_votes(n); });
+    } else {
+        // the batch lasts as long as its longest vote
+        q.timeout = std::max(q.timeout, opts.timeout);
+    }
+    q.votes.push_back(pending_vote{.request = std::move(r)});
+    return q.votes.back().reply.get_future();
+}
+
+void rpc_client_protocol::dispatch_votes(model::node_id n) {
+    auto it = _votes.find(n);
+    if (it == _votes.end()) {
+        return;
+    }
+    auto q = std::move(it->second);
+    _votes.erase(it);
+
+    if (q.votes.size() == 1) {
+        auto& v = q.votes.front();
+        (void)send_vote(
+          n,
+          std::move(v.request),
+          rpc::client_opts(q.timeout),
+          q.traffic)
+          .then_wrapped([reply = std::move(v.reply)](
+                          ss::future<result<vote_reply>> f) mutable {
+              f.forward_to(std::move(reply));
+          });
+        return;
+    }
+
+    vote_batch_request req;
+    req.requests.reserve(q.votes.size());
+    for (const auto& v : q.votes) {
+        req.requests.push_back(v.request);
+    }
+    (void)_connection_cache.local()
+      .with_node_client<raftgen_client_protocol>(
+        _self,
+        ss::this_shard_id(),
+        n,
+        q.traffic,
+        [req = std::move(req),
+         timeout = q.timeout](raftgen_client_protocol client) mutable {
+            return client.vote_batch(std::move(req), rpc::client_opts(timeout))
+              .then(&rpc::get_ctx_data<vote_batch_reply>);
+        })
+      .then_wrapped([votes = std::move(q.votes)](
+                      ss::future<result<vote_batch_reply>> f) mutable {
+          result<vote_batch_reply> r = std::error_code(
+            errc::vote_dispatch_error);
+          try {
+              r = f.get0();
+          } catch (...) {
+              vlog(
+                raftlog.debug,
+                "error sending a batch of {} votes: {}",
+                votes.size(),
+                std::current_exception());
+          }
+          if (r && r.value().replies.size() != votes.size()) {
+              r = std::error_code(errc::vote_dispatch_error);
+          }
+          for (size_t i = 0; i < votes.size(); ++i) {
+              if (r) {
+                  votes[i].reply.set_value(r.value().replies[i]);
+              } else {
+                  votes[i].reply.set_value(r.error());
+              }
+          }
+      });
+}
+
+ss::future<result<vote_reply>> rpc_client_protocol::send_vote(
+  model::node_id n,
+  vote_request&& r,
+  rpc::client_opts opts,
+  rpc::traffic_class traffic) {
     return _connection_cache.local().with_node_client<raftgen_client_protocol>(
       _self,
       ss::this_shard_id(),
       n,
+      traffic,
       [r = std::move(r),
        opts = std::move(opts)](raftgen_client_protocol client) mutable {
           return client.vote(std::move(r), std::move(opts))
@@ -33,10 +123,12 @@ ss::future<result<vote_reply>> rpc_client_protocol::vote(
 
 ss::future<result<append_entries_reply>> rpc_client_protocol::append_entries(
   model::node_id n, append_entries_request&& r, rpc::client_opts opts) {
+    const auto traffic = opts.traffic;
     return _connection_cache.local().with_node_client<raftgen_client_protocol>(
       _self,
       ss::this_shard_id(),
       n,
+      traffic,
       [r = std::move(r),
        opts = std::move(opts)](raftgen_client_protocol client) mutable {
           return client.append_entries(std::move(r), std::move(opts))
@@ -46,10 +138,12 @@ ss::future<result<append_entries_reply>> rpc_client_protocol::append_entries(
 
 ss::future<result<heartbeat_reply>> rpc_client_protocol::heartbeat(
   model::node_id n, heartbeat_request&& r, rpc::client_opts opts) {
+    const auto traffic = opts.traffic;
     return _connection_cache.local().with_node_client<raftgen_client_protocol>(
       _self,
       ss::this_shard_id(),
       n,
+      traffic,
       [r = std::move(r),
        opts = std::move(opts)](raftgen_client_protocol client) mutable {
           return client.heartbeat(std::move(r), std::move(opts))
@@ -60,10 +154,12 @@ ss::future<result<heartbeat_reply>> rpc_client_protocol::heartbeat(
 ss::future<result<install_snapshot_reply>>
 rpc_client_protocol::install_snapshot(
   model::node_id n, install_snapshot_request&& r, rpc::client_opts opts) {
+    const auto traffic = opts.traffic;
     return _connection_cache.local().with_node_client<raftgen_client_protocol>(
       _self,
       ss::this_shard_id(),
       n,
+      traffic,
       [r = std::move(r),
        opts = std::move(opts)](raftgen_client_protocol client) mutable {
           return client.install_snapshot(std::move(r), std::move(opts))
@@ -71,12 +167,30 @@ rpc_client_protocol::install_snapshot(
       });
 }
 
+ss::future<result<install_segment_reply>>
+rpc_client_protocol::install_segment(
+  model::node_id n, install_segment_request&& r, rpc::client_opts opts) {
+    const auto traffic = opts.traffic;
+    return _connection_cache.local().with_node_client<raftgen_client_protocol>(
+      _self,
+      ss::this_shard_id(),
+      n,
+      traffic,
+      [r = std::move(r),
+       opts = std::move(opts)](raftgen_client_protocol client) mutable {
+          return client.install_segment(std::move(r), std::move(opts))
+            .then(&rpc::get_ctx_data<install_segment_reply>);
+      });
+}
+
 ss::future<result<timeout_now_reply>> rpc_client_protocol::timeout_now(
   model::node_id n, timeout_now_request&& r, rpc::client_opts opts) {
+    const auto traffic = opts.traffic;
     return _connection_cache.local().with_node_client<raftgen_client_protocol>(
       _self,
       ss::this_shard_id(),
       n,
+      traffic,
       [r = std::move(r),
        opts = std::move(opts)](raftgen_client_protocol client) mutable {
           return client.timeout_now(std::move(r), std::move(opts))
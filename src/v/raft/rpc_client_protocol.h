@@ -20,18 +20,30 @@
 #include "rpc/connection_cache.h"
 #include "rpc/transport.h"
 
+#include <seastar/core/shared_ptr.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
 #include <system_error>
+#include <vector>
 
 namespace raft {
 
 /// Raft client protocol implementation underlied by RPC connections cache
-class rpc_client_protocol final : public consensus_client_protocol::impl {
+class rpc_client_protocol final
+  : public consensus_client_protocol::impl
+  , public ss::enable_shared_from_this<rpc_client_protocol> {
 public:
     explicit rpc_client_protocol(
       model::node_id self, ss::sharded<rpc::connection_cache>& cache)
       : _self(self)
       , _connection_cache(cache) {}
 
+    /// The votes of the groups of this core to a node are gathered for
+    /// vote_linger and sent in a single vote_batch request. The elections of
+    /// the groups led by a lost node start together, so that they share few
+    /// requests.
     ss::future<result<vote_reply>>
     vote(model::node_id, vote_request&&, rpc::client_opts) final;
 
@@ -44,12 +56,33 @@ public:
     ss::future<result<install_snapshot_reply>> install_snapshot(
       model::node_id, install_snapshot_request&&, rpc::client_opts) final;
 
+    ss::future<result<install_segment_reply>> install_segment(
+      model::node_id, install_segment_request&&, rpc::client_opts) final;
+
     ss::future<result<timeout_now_reply>>
     timeout_now(model::node_id, timeout_now_request&&, rpc::client_opts) final;
 
 private:
+    static constexpr auto vote_linger = std::chrono::milliseconds(2);
+
+    struct pending_vote {
+        vote_request request;
+        ss::promise<result<vote_reply>> reply;
+    };
+
+    struct vote_queue {
+        std::vector<pending_vote> votes;
+        rpc::clock_type::time_point timeout;
+        rpc::traffic_class traffic;
+    };
+
+    void dispatch_votes(model::node_id);
+    ss::future<result<vote_reply>> send_vote(
+      model::node_id, vote_request&&, rpc::client_opts, rpc::traffic_class);
+
     model::node_id _self;
     ss::sharded<rpc::connection_cache>& _connection_cache;
+    absl::flat_hash_map<model::node_id, vote_queue> _votes;
 };
 
 inline consensus_client_protocol make_rpc_client_protocol(
@@ -12,6 +12,9 @@
 #pragma once
 
 #include "raft/consensus.h"
+#include "raft/heartbeat_delta.h"
+#include "raft/logger.h"
+#include "raft/node_liveness.h"
 #include "raft/raftgen_service.h"
 #include "raft/types.h"
 #include "seastarx.h"
@@ -22,6 +25,8 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <algorithm>
+
 namespace raft {
 // clang-format off
 CONCEPT(
@@ -48,14 +53,20 @@ CONCEPT(
 class service final : public raftgen_service {
 public:
     using failure_probes = raftgen_service::failure_probes;
+    /// applies the attachment of a heartbeat, see heartbeat_attachments
+    using attachment_handler
+      = ss::noncopyable_function<ss::future<>(model::node_id, iobuf)>;
+
     service(
       ss::scheduling_group sc,
       ss::smp_service_group ssg,
       ss::sharded<ConsensusManager>& mngr,
-      ShardLookup& tbl)
+      ShardLookup& tbl,
+      attachment_handler on_attachment = {})
       : raftgen_service(sc, ssg)
       , _group_manager(mngr)
-      , _shard_table(tbl) {
+      , _shard_table(tbl)
+      , _on_attachment(std::move(on_attachment)) {
         finjector::shard_local_badger().register_probe(
           failure_probes::name(), &_probe);
     }
@@ -67,6 +78,11 @@ public:
     [[gnu::always_inline]] ss::future<heartbeat_reply>
     heartbeat(heartbeat_request&& r, rpc::streaming_context&) final {
         using ret_t = std::vector<append_entries_reply>;
+        auto attached = apply_attachment(r);
+        auto heard = note_heard(r.session);
+        const bool base_missing = apply_heartbeat_delta(r);
+        // groups of the request the sender stops heartbeating
+        std::sort(r.quiesced.begin(), r.quiesced.end());
         std::vector<append_entries_request> reqs;
         reqs.reserve(r.meta.size());
         for (auto& m : r.meta) {
@@ -78,13 +94,17 @@ public:
         }
 
         auto req_size = reqs.size();
-        auto groupped = group_hbeats_by_shard(std::move(reqs));
+        auto groupped = group_hbeats_by_shard(std::move(reqs), r.quiesced);
 
         std::vector<ss::future<std::vector<append_entries_reply>>> futures;
         futures.reserve(groupped.shard_requests.size());
         for (auto& [shard, req] : groupped.shard_requests) {
             // dispatch to each core in parallel
-            futures.push_back(dispatch_hbeats_to_core(shard, std::move(req)));
+            futures.push_back(dispatch_hbeats_to_core(
+              shard,
+              std::move(req),
+              r.session,
+              std::move(groupped.shard_quiesced[shard])));
         }
         // replies for groups that are not yet registered at this node
         std::vector<append_entries_reply> group_missing_replies;
@@ -100,7 +120,19 @@ public:
           });
 
         return ss::when_all_succeed(futures.begin(), futures.end())
-          .then([req_size, missing = std::move(group_missing_replies)](
+          .then([attached = std::move(attached), heard = std::move(heard)](
+                  std::vector<ret_t> replies) mutable {
+              return std::move(attached)
+                .then([heard = std::move(heard)]() mutable {
+                    return std::move(heard);
+                })
+                .then([replies = std::move(replies)]() mutable {
+                    return std::move(replies);
+                });
+          })
+          .then([req_size,
+                 base_missing,
+                 missing = std::move(group_missing_replies)](
                   std::vector<ret_t> replies) mutable {
               ret_t ret;
               ret.reserve(req_size);
@@ -110,7 +142,8 @@ public:
               }
               std::move(
                 missing.begin(), missing.end(), std::back_inserter(ret));
-              return heartbeat_reply{std::move(ret)};
+              return heartbeat_reply{
+                .meta = std::move(ret), .base_missing = base_missing};
           });
     }
 
@@ -126,6 +159,46 @@ public:
         });
     }
 
+    /// the votes are dispatched with one cross core request per shard, and
+    /// their replies returned in request order
+    [[gnu::always_inline]] ss::future<vote_batch_reply>
+    vote_batch(vote_batch_request&& r, rpc::streaming_context&) final {
+        return _probe.vote_batch().then([this, r = std::move(r)]() mutable {
+            const auto size = r.requests.size();
+            absl::flat_hash_map<ss::shard_id, std::vector<size_t>> positions;
+            absl::flat_hash_map<ss::shard_id, std::vector<vote_request>> reqs;
+            for (size_t i = 0; i < size; ++i) {
+                auto group = r.requests[i].target_group();
+                if (unlikely(!_shard_table.contains(group))) {
+                    continue;
+                }
+                auto shard = _shard_table.shard_for(group);
+                positions[shard].push_back(i);
+                reqs[shard].push_back(r.requests[i]);
+            }
+            std::vector<ss::future<>> futures;
+            futures.reserve(reqs.size());
+            auto replies = ss::make_lw_shared<std::vector<vote_reply>>(
+              size,
+              vote_reply{
+                .term = model::term_id{}, .granted = false, .log_ok = false});
+            for (auto& [shard, req] : reqs) {
+                futures.push_back(
+                  dispatch_votes_to_core(shard, std::move(req))
+                    .then([replies, pos = std::move(positions[shard])](
+                            std::vector<vote_reply> part) {
+                        for (size_t i = 0; i < part.size(); ++i) {
+                            (*replies)[pos[i]] = part[i];
+                        }
+                    }));
+            }
+            return ss::when_all_succeed(futures.begin(), futures.end())
+              .then([replies] {
+                  return vote_batch_reply{.replies = std::move(*replies)};
+              });
+        });
+    }
+
     [[gnu::always_inline]] ss::future<append_entries_reply>
     append_entries(append_entries_request&& r, rpc::streaming_context&) final {
         return _probe.append_entries().then([this, r = std::move(r)]() mutable {
@@ -153,6 +226,19 @@ public:
         });
     }
 
+    [[gnu::always_inline]] ss::future<install_segment_reply> install_segment(
+      install_segment_request&& r, rpc::streaming_context&) final {
+        return _probe.install_segment().then([this,
+                                              r = std::move(r)]() mutable {
+            return dispatch_request(
+              install_segment_request_foreign_wrapper(std::move(r)),
+              &service::make_failed_install_segment_reply,
+              [](install_segment_request_foreign_wrapper&& r, consensus_ptr c) {
+                  return c->install_segment(r.copy());
+              });
+        });
+    }
+
     [[gnu::always_inline]] ss::future<timeout_now_reply>
     timeout_now(timeout_now_request&& r, rpc::streaming_context&) final {
         return _probe.timeout_now().then([this, r = std::move(r)]() mutable {
@@ -169,8 +255,11 @@ private:
     using consensus_ptr = seastar::lw_shared_ptr<consensus>;
     using hbeats_t = std::vector<append_entries_request>;
     using hbeats_ptr = ss::foreign_ptr<std::unique_ptr<hbeats_t>>;
+    /// the quiesced groups of a request, with the term of the leader
+    using quiesced_t = std::vector<std::pair<group_id, model::term_id>>;
     struct shard_groupped_hbeat_requests {
         absl::flat_hash_map<ss::shard_id, hbeats_ptr> shard_requests;
+        absl::flat_hash_map<ss::shard_id, quiesced_t> shard_quiesced;
         std::vector<append_entries_request> group_missing_requests;
     };
 
@@ -186,6 +275,12 @@ private:
             .term = model::term_id{}, .bytes_stored = 0, .success = false});
     }
 
+    static ss::future<install_segment_reply>
+    make_failed_install_segment_reply() {
+        return ss::make_ready_future<install_segment_reply>(
+          install_segment_reply{.bytes_stored = 0, .success = false});
+    }
+
     static ss::future<append_entries_reply>
     make_missing_group_reply(raft::group_id group) {
         return ss::make_ready_future<append_entries_reply>(append_entries_reply{
@@ -227,22 +322,59 @@ private:
           });
     }
 
-    ss::future<std::vector<append_entries_reply>>
-    dispatch_hbeats_to_core(ss::shard_id shard, hbeats_ptr requests) {
+    ss::future<std::vector<vote_reply>>
+    dispatch_votes_to_core(ss::shard_id shard, std::vector<vote_request> reqs) {
+        return with_scheduling_group(
+          get_scheduling_group(),
+          [this, shard, reqs = std::move(reqs)]() mutable {
+              return _group_manager.invoke_on(
+                shard,
+                get_smp_service_group(),
+                [reqs = std::move(reqs)](ConsensusManager& m) mutable {
+                    std::vector<ss::future<vote_reply>> futures;
+                    futures.reserve(reqs.size());
+                    for (auto& req : reqs) {
+                        auto c = m.consensus_for(req.target_group());
+                        if (unlikely(!c)) {
+                            futures.push_back(make_failed_vote_reply());
+                            continue;
+                        }
+                        futures.push_back(c->vote(std::move(req)));
+                    }
+                    return ss::when_all_succeed(
+                      futures.begin(), futures.end());
+                });
+          });
+    }
+
+    ss::future<std::vector<append_entries_reply>> dispatch_hbeats_to_core(
+      ss::shard_id shard,
+      hbeats_ptr requests,
+      uint64_t session,
+      quiesced_t quiesced) {
         return with_scheduling_group(
           get_scheduling_group(),
-          [this, shard, r = std::move(requests)]() mutable {
+          [this,
+           shard,
+           r = std::move(requests),
+           session,
+           q = std::move(quiesced)]() mutable {
               return _group_manager.invoke_on(
                 shard,
                 get_smp_service_group(),
-                [this, r = std::move(r)](ConsensusManager& m) mutable {
-                    return dispatch_hbeats_to_groups(m, std::move(r));
+                [this, r = std::move(r), session, q = std::move(q)](
+                  ConsensusManager& m) mutable {
+                    return dispatch_hbeats_to_groups(
+                      m, std::move(r), session, std::move(q));
                 });
           });
     }
 
-    ss::future<std::vector<append_entries_reply>>
-    dispatch_hbeats_to_groups(ConsensusManager& m, hbeats_ptr reqs) {
+    ss::future<std::vector<append_entries_reply>> dispatch_hbeats_to_groups(
+      ConsensusManager& m,
+      hbeats_ptr reqs,
+      uint64_t session,
+      quiesced_t quiesced) {
         std::vector<ss::future<append_entries_reply>> futures;
         futures.reserve(reqs->size());
         // dispatch requests in parallel
@@ -254,10 +386,85 @@ private:
               return dispatch_append_entries(m, std::move(req));
           });
 
-        return ss::when_all_succeed(futures.begin(), futures.end());
+        return ss::when_all_succeed(futures.begin(), futures.end())
+          .then([&m, session, q = std::move(quiesced)](
+                  std::vector<append_entries_reply> replies) {
+              // the groups are quiesced once they heartbeated successfully
+              for (auto& [group, term] : q) {
+                  auto it = std::find_if(
+                    replies.begin(),
+                    replies.end(),
+                    [group = group](const append_entries_reply& r) {
+                        return r.group == group;
+                    });
+                  if (
+                    it == replies.end()
+                    || it->result != append_entries_reply::status::success) {
+                      continue;
+                  }
+                  if (auto c = m.consensus_for(group); c) {
+                      c->quiesce(session, term);
+                  }
+              }
+              return replies;
+          });
     }
 
-    shard_groupped_hbeat_requests group_hbeats_by_shard(hbeats_t reqs) {
+    /// notes the heartbeat session as heard on all cores, at most once per
+    /// resolution of the liveness, see node_liveness
+    static ss::future<> note_heard(uint64_t session) {
+        const auto now = clock_type::now();
+        if (
+          session == 0
+          || node_liveness::local().heard_since(
+            session, now - node_liveness::resolution)) {
+            return ss::now();
+        }
+        return ss::smp::invoke_on_all(
+          [session, now] { node_liveness::local().heard(session, now); });
+    }
+
+    /// hands the attachment of the request to the upper layer, whose
+    /// failures do not fail the heartbeat
+    ss::future<> apply_attachment(heartbeat_request& r) {
+        if (r.attachment.empty() || !_on_attachment) {
+            return ss::now();
+        }
+        auto node = r.node_id;
+        return _on_attachment(node, std::move(r.attachment))
+          .handle_exception([node](const std::exception_ptr& e) {
+              vlog(
+                raftlog.warn,
+                "failed to apply the heartbeat attachment of node {}: {}",
+                node,
+                e);
+          });
+    }
+
+    /// replaces the delta encoded metadata of the request with the metadata
+    /// of all its groups, returns true if the base of the request is unknown
+    bool apply_heartbeat_delta(heartbeat_request& r) {
+        if (r.session == 0 || r.seq == 0) {
+            // not delta encoded, e.g. only keeps the session alive
+            return false;
+        }
+        static const heartbeat_state no_base;
+        const heartbeat_state* base = &no_base;
+        if (r.base_seq != 0) {
+            base = _heartbeat_bases.find(r.session, r.base_seq);
+            if (unlikely(!base)) {
+                // only the groups sent in full can be heartbeated
+                return true;
+            }
+        }
+        auto state = decode_heartbeat_delta(r, *base);
+        r.meta = state;
+        _heartbeat_bases.insert(r.session, r.seq, std::move(state));
+        return false;
+    }
+
+    shard_groupped_hbeat_requests group_hbeats_by_shard(
+      hbeats_t reqs, const std::vector<group_id>& quiesced) {
         shard_groupped_hbeat_requests ret;
 
         for (auto& r : reqs) {
@@ -267,6 +474,13 @@ private:
             }
 
             auto shard = _shard_table.shard_for(r.meta.group);
+            if (
+              !quiesced.empty()
+              && std::binary_search(
+                quiesced.begin(), quiesced.end(), r.meta.group)) {
+                ret.shard_quiesced[shard].emplace_back(
+                  r.meta.group, r.meta.term);
+            }
             if (!ret.shard_requests.contains(shard)) {
                 auto hbeats = ss::make_foreign(
                   std::make_unique<std::vector<append_entries_request>>());
@@ -293,5 +507,7 @@ private:
     failure_probes _probe;
     ss::sharded<ConsensusManager>& _group_manager;
     ShardLookup& _shard_table;
+    heartbeat_bases _heartbeat_bases;
+    attachment_handler _on_attachment;
 };
 } // namespace raft
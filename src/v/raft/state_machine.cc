@@ -12,6 +12,7 @@
 #include "model/fundamental.h"
 #include "model/record_batch_reader.h"
 #include "raft/consensus.h"
+#include "raft/errc.h"
 #include "storage/log.h"
 #include "storage/record_batch_builder.h"
 
@@ -51,21 +52,42 @@ model::offset state_machine::bootstrap_last_applied() const {
     return _bootstrap_last_applied;
 }
 
-state_machine::batch_applicator::batch_applicator(state_machine* machine)
+state_machine::range_collector::range_collector(state_machine* machine)
   : _machine(machine) {}
 
 ss::future<ss::stop_iteration>
-state_machine::batch_applicator::operator()(model::record_batch batch) {
+state_machine::range_collector::operator()(model::record_batch batch) {
     if (_machine->stop_batch_applicator()) {
         return ss::make_ready_future<ss::stop_iteration>(
           ss::stop_iteration::yes);
     }
+    _bytes += batch.size_bytes();
+    _batches.push_back(std::move(batch));
+    return ss::make_ready_future<ss::stop_iteration>(
+      _bytes >= max_range_bytes ? ss::stop_iteration::yes
+                                : ss::stop_iteration::no);
+}
+
+ss::future<>
+state_machine::apply_batches(ss::circular_buffer<model::record_batch> batches) {
+    return ss::do_with(
+      std::move(batches),
+      [this](ss::circular_buffer<model::record_batch>& batches) {
+          return ss::do_for_each(batches, [this](model::record_batch& b) {
+              return apply(std::move(b));
+          });
+      });
+}
 
-    auto last_offset = batch.last_offset();
-    return _machine->apply(std::move(batch)).then([this, last_offset] {
-        _last_applied = last_offset;
-        _machine->_waiters.notify(_last_applied);
-        return ss::stop_iteration::no;
+ss::future<> state_machine::apply_range(
+  ss::circular_buffer<model::record_batch> batches) {
+    if (batches.empty() || stop_batch_applicator()) {
+        return ss::now();
+    }
+    auto last_offset = batches.back().last_offset();
+    return apply_batches(std::move(batches)).then([this, last_offset] {
+        _next = last_offset + model::offset(1);
+        _waiters.notify(last_offset);
     });
 }
 
@@ -98,10 +120,34 @@ ss::future<result<replicate_result>> state_machine::quorum_write_empty_batch(
       });
 }
 
+ss::future<std::error_code> state_machine::linearizable_barrier(
+  model::timeout_clock::time_point timeout) {
+    auto read_offset = _raft->linearizable_read_offset();
+    if (read_offset) {
+        if (read_offset.value() < model::offset(0)) {
+            return ss::make_ready_future<std::error_code>(errc::success);
+        }
+        return wait(read_offset.value(), timeout).then([] {
+            return std::error_code(errc::success);
+        });
+    }
+    if (read_offset.error() != errc::leader_lease_expired) {
+        return ss::make_ready_future<std::error_code>(read_offset.error());
+    }
+    return quorum_write_empty_batch(timeout).then(
+      [](result<replicate_result> r) {
+          if (!r) {
+              return r.error();
+          }
+          return std::error_code(errc::success);
+      });
+}
+
 ss::future<> state_machine::apply() {
     // wait until consensus commit index is >= _next
     return _raft->events()
       .wait(_next, model::no_timeout, _as)
+      .then([this] { return maybe_apply_snapshot(); })
       .then([this] {
           // build a reader for log range [_next, +inf).
           storage::log_reader_config config(
@@ -109,13 +155,23 @@ ss::future<> state_machine::apply() {
           return _raft->make_reader(config);
       })
       .then([this](model::record_batch_reader reader) {
-          // apply each batch to the state machine
-          return std::move(reader)
-            .consume(batch_applicator(this), model::no_timeout)
-            .then([this](model::offset last_applied) {
-                if (last_applied >= model::offset(0)) {
-                    _next = last_applied + model::offset(1);
-                }
+          // apply the batches to the state machine a range at a time
+          return ss::do_with(
+            std::move(reader), [this](model::record_batch_reader& reader) {
+                return ss::do_until(
+                  [this, &reader] {
+                      return reader.is_end_of_stream()
+                             || stop_batch_applicator();
+                  },
+                  [this, &reader] {
+                      return reader
+                        .consume(range_collector(this), model::no_timeout)
+                        .then(
+                          [this](
+                            ss::circular_buffer<model::record_batch> batches) {
+                              return apply_range(std::move(batches));
+                          });
+                  });
             });
       })
       .handle_exception([this](const std::exception_ptr& e) {
@@ -123,6 +179,30 @@ ss::future<> state_machine::apply() {
       });
 }
 
+ss::future<> state_machine::maybe_apply_snapshot() {
+    if (_next >= _raft->start_offset()) {
+        return ss::now();
+    }
+    return _raft->read_snapshot().then([this](std::optional<snapshot_data> s) {
+        // without a snapshot covering them the entries were evicted, the
+        // state machine goes on from the start of the log
+        if (!s || s->last_included_index < _next) {
+            return ss::now();
+        }
+        vlog(
+          _log.info,
+          "Applying snapshot up to {}, next offset to apply {}",
+          s->last_included_index,
+          _next);
+        auto last_included = s->last_included_index;
+        return apply_snapshot(last_included, std::move(s->data))
+          .then([this, last_included] {
+              _next = last_included + model::offset(1);
+              _waiters.notify(last_included);
+          });
+    });
+}
+
 ss::future<> state_machine::write_last_applied(model::offset o) {
     return _raft->write_last_applied(o);
 }
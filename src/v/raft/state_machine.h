@@ -19,6 +19,7 @@
 #include "seastarx.h"
 
 #include <seastar/core/abort_source.hh>
+#include <seastar/core/circular_buffer.hh>
 #include <seastar/core/file.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/util/log.hh>
@@ -50,6 +51,10 @@ class consensus;
  *       db_update(batch);
  *     }
  *
+ * State machines that replay many small batches may override `apply_batches`
+ * to apply a range of consecutive batches at once, which amortizes the cost of
+ * a future per batch when the log is replayed on startup.
+ *
  * The state machine tracks which batches have been applied. Use the `wait`
  * primitive to wait until a particular log offset has been applied to the state
  * machine.
@@ -67,12 +72,32 @@ public:
     // wait until at least offset is applied to state machine
     ss::future<> wait(model::offset, model::timeout_clock::time_point);
 
+    // the offset of the next batch to apply
+    model::offset next_to_apply() const { return _next; }
+
     /**
      * This must be implemented by the state machine. The state machine should
      * replay this batch and return a completed future. If an exceptional future
      * is returned an error is logged and the same batch will be applied again.
      */
     virtual ss::future<> apply(model::record_batch) = 0;
+    /**
+     * Applies a range of consecutive batches, in offset order. The default
+     * applies them one at a time through apply(). The offsets of the range are
+     * notified as applied once the returned future completes. If an
+     * exceptional future is returned the whole range is applied again.
+     */
+    virtual ss::future<>
+      apply_batches(ss::circular_buffer<model::record_batch>);
+    /**
+     * Called when the entries the state machine has yet to apply were prefix
+     * truncated from the log, with the data of the snapshot that replaced
+     * them. State machines writing their state into the snapshots rebuild it
+     * from the data, the others ignore it.
+     */
+    virtual ss::future<> apply_snapshot(model::offset, iobuf&&) {
+        return ss::now();
+    }
     /**
      * Return last applied offset established when STM starts. This can be used
      * to wait for the entries to be applied when STM is starting.
@@ -88,21 +113,37 @@ public:
     ss::future<result<replicate_result>>
       quorum_write_empty_batch(model::timeout_clock::time_point);
 
+    /**
+     * Waits until all entries committed before the call are applied, after
+     * which reads from the state machine are linearizable. Uses the leader
+     * lease when it holds and replicates an empty batch otherwise.
+     */
+    ss::future<std::error_code>
+      linearizable_barrier(model::timeout_clock::time_point);
+
 private:
-    class batch_applicator {
+    /// collects the batches of the next range to apply, up to max_range_bytes
+    class range_collector {
     public:
-        explicit batch_applicator(state_machine*);
+        static constexpr size_t max_range_bytes = 1 << 20;
+
+        explicit range_collector(state_machine*);
         ss::future<ss::stop_iteration> operator()(model::record_batch);
-        model::offset end_of_stream() const { return _last_applied; }
+        ss::circular_buffer<model::record_batch> end_of_stream() {
+            return std::move(_batches);
+        }
 
     private:
         state_machine* _machine;
-        model::offset _last_applied;
+        ss::circular_buffer<model::record_batch> _batches;
+        size_t _bytes{0};
     };
 
-    friend batch_applicator;
+    friend range_collector;
 
     ss::future<> apply();
+    ss::future<> apply_range(ss::circular_buffer<model::record_batch>);
+    ss::future<> maybe_apply_snapshot();
     bool stop_batch_applicator();
 
     consensus* _raft;
@@ -227,3 +227,32 @@ FIXTURE_TEST(test_start_write_concurrency, config_manager_fixture) {
     BOOST_REQUIRE_EQUAL(
       new_cfg_manager.get_highest_known_offset(), model::offset(3000));
 }
+
+FIXTURE_TEST(test_recovery_from_deltas, config_manager_fixture) {
+    // fills the delta keys twice, so that the map is written in between
+    std::vector<raft::group_configuration> configurations;
+    const auto count = 2 * raft::configuration_manager::max_deltas + 3;
+    for (int i = 0; i < count; ++i) {
+        configurations.push_back(add_random_cfg(model::offset(i * 10)));
+    }
+    _cfg_mgr.truncate(model::offset((count - 1) * 10)).get0();
+    configurations.pop_back();
+    add_random_cfg(model::offset(count * 10));
+
+    raft::configuration_manager recovered(
+      raft::group_configuration({}), raft::group_id(1), _storage, _logger);
+    recovered.start().get0();
+
+    BOOST_REQUIRE_EQUAL(recovered.get_latest(), _cfg_mgr.get_latest());
+    BOOST_REQUIRE_EQUAL(
+      recovered.get_highest_known_offset(),
+      _cfg_mgr.get_highest_known_offset());
+    for (size_t i = 0; i < configurations.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(
+          recovered.get(model::offset(i * 10)), configurations[i]);
+    }
+    // the truncated configuration is not recovered
+    BOOST_REQUIRE_EQUAL(
+      recovered.get(model::offset((count - 1) * 10)),
+      configurations.back());
+}
@@ -46,3 +46,39 @@ BOOST_AUTO_TEST_CASE(should_return_false_as_it_does_not_contain_machine) {
     auto contains = test_grp.contains_broker(model::node_id(1));
     BOOST_REQUIRE_EQUAL(contains, false);
 }
+
+BOOST_AUTO_TEST_CASE(should_add_brokers_as_learners) {
+    raft::group_configuration cfg = raft::group_configuration(
+      {create_broker(1)});
+
+    cfg.add({create_broker(2)});
+    BOOST_REQUIRE(cfg.type() == raft::configuration_type::simple);
+    BOOST_REQUIRE(cfg.contains_broker(model::node_id(2)));
+    BOOST_REQUIRE(cfg.is_learner(model::node_id(2)));
+    BOOST_REQUIRE(!cfg.is_voter(model::node_id(2)));
+    BOOST_REQUIRE_EQUAL(cfg.unique_voter_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(should_promote_learner_through_joint_configuration) {
+    raft::group_configuration cfg = raft::group_configuration(
+      {create_broker(1)});
+    cfg.add({create_broker(2)});
+
+    cfg.promote_to_voter(model::node_id(2));
+    BOOST_REQUIRE(cfg.type() == raft::configuration_type::joint);
+    BOOST_REQUIRE(cfg.is_voter(model::node_id(2)));
+    BOOST_REQUIRE(!cfg.is_learner(model::node_id(2)));
+
+    cfg.discard_old_config();
+    BOOST_REQUIRE(cfg.type() == raft::configuration_type::simple);
+    BOOST_REQUIRE_EQUAL(cfg.unique_voter_count(), 2);
+    BOOST_REQUIRE_EQUAL(cfg.brokers().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(should_not_promote_voter) {
+    raft::group_configuration cfg = raft::group_configuration(
+      {create_broker(1)});
+
+    BOOST_REQUIRE_THROW(
+      cfg.promote_to_voter(model::node_id(1)), std::invalid_argument);
+}
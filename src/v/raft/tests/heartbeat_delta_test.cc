@@ -0,0 +1,133 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "raft/heartbeat_delta.h"
+#include "raft/node_liveness.h"
+#include "raft/types.h"
+#include "seastarx.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <vector>
+
+static raft::protocol_metadata make_meta(int64_t group, int64_t offset) {
+    return raft::protocol_metadata{
+      .group = raft::group_id(group),
+      .commit_index = model::offset(offset),
+      .term = model::term_id(1),
+      .prev_log_index = model::offset(offset),
+      .prev_log_term = model::term_id(1),
+      .last_visible_index = model::offset(offset)};
+}
+
+static raft::heartbeat_request roundtrip(raft::heartbeat_request req) {
+    iobuf buf;
+    reflection::async_adl<raft::heartbeat_request>{}
+      .to(buf, std::move(req))
+      .get();
+    iobuf_parser parser(std::move(buf));
+    return reflection::async_adl<raft::heartbeat_request>{}.from(parser).get0();
+}
+
+SEASTAR_THREAD_TEST_CASE(heartbeat_delta_roundtrip) {
+    static constexpr int64_t groups = 1000;
+    raft::heartbeat_state base;
+    for (int64_t g = 0; g < groups; ++g) {
+        base.push_back(make_meta(g, 10));
+    }
+    // every tenth group changed, every 7th is not heartbeated and a few new
+    // groups are added at the end
+    raft::heartbeat_state state;
+    for (int64_t g = 0; g < groups + 5; ++g) {
+        if (g % 7 == 0) {
+            continue;
+        }
+        state.push_back(make_meta(g, g % 10 == 0 ? 11 : 10));
+    }
+
+    raft::heartbeat_request req;
+    req.node_id = model::node_id(1);
+    req.session = 5;
+    req.seq = 2;
+    raft::encode_heartbeat_delta(req, state, 1, base);
+    BOOST_REQUIRE_EQUAL(req.base_seq, 1);
+    BOOST_REQUIRE_LT(req.meta.size(), state.size() / 5);
+
+    auto res = roundtrip(std::move(req));
+    BOOST_REQUIRE_EQUAL(res.session, 5);
+    BOOST_REQUIRE_EQUAL(res.seq, 2);
+    BOOST_REQUIRE_EQUAL(res.base_seq, 1);
+    auto decoded = raft::decode_heartbeat_delta(res, base);
+    BOOST_REQUIRE(decoded == state);
+}
+
+SEASTAR_THREAD_TEST_CASE(heartbeat_delta_without_base) {
+    raft::heartbeat_state state{make_meta(1, 1), make_meta(2, 2)};
+    raft::heartbeat_request req;
+    raft::encode_heartbeat_delta(req, state, 0, {});
+    BOOST_REQUIRE_EQUAL(req.base_seq, 0);
+    BOOST_REQUIRE(req.unchanged.empty());
+    BOOST_REQUIRE(req.meta == state);
+    BOOST_REQUIRE(raft::decode_heartbeat_delta(req, {}) == state);
+}
+
+SEASTAR_THREAD_TEST_CASE(heartbeat_bases_keep_recent_states) {
+    raft::heartbeat_bases bases;
+    for (uint64_t seq = 1; seq <= 5; ++seq) {
+        bases.insert(1, seq, raft::heartbeat_state{make_meta(0, seq)});
+    }
+    BOOST_REQUIRE(bases.find(2, 5) == nullptr);
+    BOOST_REQUIRE(bases.find(1, 1) == nullptr);
+    for (uint64_t seq = 3; seq <= 5; ++seq) {
+        auto b = bases.find(1, seq);
+        BOOST_REQUIRE(b != nullptr);
+        BOOST_REQUIRE_EQUAL(b->front().commit_index, model::offset(seq));
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(heartbeat_attachment_roundtrip) {
+    raft::heartbeat_request req;
+    req.node_id = model::node_id(1);
+    req.attachment.append("leaders", 7);
+    auto expected = req.attachment.copy();
+
+    auto res = roundtrip(std::move(req));
+    BOOST_REQUIRE(res.meta.empty());
+    BOOST_REQUIRE_EQUAL(res.seq, 0);
+    BOOST_REQUIRE(res.attachment == expected);
+}
+
+SEASTAR_THREAD_TEST_CASE(heartbeat_quiesced_groups_roundtrip) {
+    raft::heartbeat_request req;
+    req.node_id = model::node_id(1);
+    req.meta = {make_meta(1, 10), make_meta(2, 20)};
+    req.quiesced = {raft::group_id(2)};
+
+    auto res = roundtrip(std::move(req));
+    BOOST_REQUIRE_EQUAL(res.meta.size(), 2);
+    BOOST_REQUIRE_EQUAL(res.quiesced.size(), 1);
+    BOOST_REQUIRE_EQUAL(res.quiesced[0], raft::group_id(2));
+}
+
+SEASTAR_THREAD_TEST_CASE(node_liveness_tracks_sessions) {
+    raft::node_liveness liveness;
+    auto now = raft::clock_type::now();
+    liveness.heard(1, now);
+    BOOST_REQUIRE(liveness.heard_since(1, now - std::chrono::seconds(1)));
+    BOOST_REQUIRE(!liveness.heard_since(1, now));
+    BOOST_REQUIRE(!liveness.heard_since(2, now - std::chrono::seconds(1)));
+
+    // a late notification does not move the session back
+    liveness.heard(1, now - std::chrono::seconds(5));
+    BOOST_REQUIRE(liveness.heard_since(1, now - std::chrono::seconds(1)));
+
+    // idle sessions are evicted as others are heard
+    liveness.heard(2, now + raft::node_liveness::session_timeout * 2);
+    BOOST_REQUIRE(!liveness.heard_since(1, now - std::chrono::seconds(1)));
+}
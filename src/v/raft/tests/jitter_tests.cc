@@ -27,3 +27,14 @@ SEASTAR_THREAD_TEST_CASE(base_jitter_gurantees) {
         BOOST_CHECK(next >= now + low && next <= now + high);
     }
 }
+
+SEASTAR_THREAD_TEST_CASE(jitter_follows_set_duration) {
+    raft::timeout_jitter jit(1500ms);
+    jit.set_duration(300ms, 150ms);
+    BOOST_CHECK_EQUAL(
+      jit.base_duration().count(), raft::duration_type(300ms).count());
+    for (auto i = 0; i < 10; ++i) {
+        auto next = jit.next_duration();
+        BOOST_CHECK(next >= 300ms && next < 450ms);
+    }
+}
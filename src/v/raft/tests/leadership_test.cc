@@ -11,7 +11,9 @@
 #include "model/metadata.h"
 #include "model/timeout_clock.h"
 #include "raft/tests/raft_group_fixture.h"
+#include "raft/errc.h"
 #include "raft/types.h"
+#include "test_utils/async.h"
 
 FIXTURE_TEST(test_single_node_group, raft_test_fixture) {
     raft_group gr = raft_group(raft::group_id(0), 1);
@@ -110,4 +112,42 @@ FIXTURE_TEST(
     // wait for next leader to be elected after recovery
     wait_for_group_leader(gr);
     assert_at_most_one_leader(gr);
-};
\ No newline at end of file
+};
+FIXTURE_TEST(test_leader_lease_reads, raft_test_fixture) {
+    config::shard_local_cfg().get("raft_enable_leader_lease").set_value(true);
+    raft_group gr = raft_group(raft::group_id(0), 3);
+    gr.enable_all();
+    auto leader_id = wait_for_group_leader(gr);
+    auto leader = gr.get_member(leader_id).consensus;
+
+    // heartbeat acknowledgements establish the lease
+    tests::cooperative_spin_wait_with_timeout(5s, [leader] {
+        return leader->linearizable_read_offset().has_value();
+    }).get0();
+    BOOST_REQUIRE_EQUAL(
+      leader->linearizable_read_offset().value(), leader->committed_offset());
+
+    for (auto& [id, m] : gr.get_members()) {
+        if (id == leader_id) {
+            continue;
+        }
+        auto res = m.consensus->linearizable_read_offset();
+        BOOST_REQUIRE(!res);
+        BOOST_REQUIRE(res.error() == raft::errc::not_leader);
+    }
+
+    // without a quorum the lease expires
+    std::vector<model::node_id> followers;
+    for (auto& [id, m] : gr.get_members()) {
+        if (id != leader_id) {
+            followers.push_back(id);
+        }
+    }
+    for (auto id : followers) {
+        gr.disable_node(id);
+    }
+    tests::cooperative_spin_wait_with_timeout(5s, [leader] {
+        return !leader->linearizable_read_offset();
+    }).get0();
+    config::shard_local_cfg().get("raft_enable_leader_lease").set_value(false);
+};
@@ -165,6 +165,35 @@ struct simple_kv {
     }
 };
 
+// applies the runs of its batches at once
+template<int8_t bt>
+struct bulk_kv : simple_kv<bt> {
+    size_t runs{0};
+    size_t batches{0};
+
+    ss::future<std::vector<std::error_code>>
+    apply_updates(ss::circular_buffer<model::record_batch> run) {
+        ++runs;
+        batches += run.size();
+        return ss::do_with(
+          std::move(run),
+          std::vector<std::error_code>{},
+          [this](
+            ss::circular_buffer<model::record_batch>& run,
+            std::vector<std::error_code>& results) {
+              return ss::do_for_each(
+                       run,
+                       [this, &results](model::record_batch& b) {
+                           return this->apply_update(std::move(b))
+                             .then([&results](std::error_code ec) {
+                                 results.push_back(ec);
+                             });
+                       })
+                .then([&results] { return std::move(results); });
+          });
+    }
+};
+
 ss::logger kvlog{"kv-test"};
 
 template<typename T>
@@ -292,6 +321,39 @@ FIXTURE_TEST(test_concurrent_sets, mux_state_machine_fixture) {
     BOOST_REQUIRE_EQUAL(success_count, 1);
 }
 
+FIXTURE_TEST(test_replicated_together, mux_state_machine_fixture) {
+    start_raft();
+    simple_kv<batch_type_1> state;
+    raft::mux_state_machine stm(
+      kvlog, _raft.get(), raft::persistent_last_applied::yes, state);
+    stm.start().get0();
+    wait_for_leader();
+    ss::abort_source as;
+    auto stop = ss::defer([&stm] { stm.stop().get0(); });
+    // issued at once, all but the first are queued behind it and replicated
+    // together, each still gets the result of its own command
+    std::vector<ss::future<std::error_code>> futures;
+    for (int i = 0; i < 20; ++i) {
+        futures.push_back(stm.replicate_and_wait(
+          serialize_cmd(
+            set_cmd{fmt::format("key-{}", i % 10), i}, batch_type_1),
+          model::timeout_clock::now() + 2s,
+          as));
+    }
+
+    auto results = ss::when_all_succeed(futures.begin(), futures.end()).get0();
+
+    for (int i = 0; i < results.size(); ++i) {
+        if (i < 10) {
+            BOOST_REQUIRE_EQUAL(results[i], errc::success);
+        } else {
+            BOOST_REQUIRE_EQUAL(results[i], errc::key_already_exists);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(state.kv_map.size(), 10);
+    BOOST_REQUIRE_EQUAL(state.kv_map.find("key-3")->second, 3);
+}
+
 FIXTURE_TEST(test_stm_recovery, mux_state_machine_fixture) {
     {
         auto cfg = storage::log_builder_config();
@@ -355,6 +417,49 @@ FIXTURE_TEST(test_stm_recovery, mux_state_machine_fixture) {
     BOOST_REQUIRE_EQUAL(state.kv_map.contains("test-2"), 1);
 }
 
+FIXTURE_TEST(test_stm_recovery_in_runs, mux_state_machine_fixture) {
+    {
+        auto cfg = storage::log_builder_config();
+        cfg.base_dir = _data_dir;
+        storage::disk_log_builder builder(cfg);
+        model::offset offset(0);
+
+        builder | storage::start(_ntp) | storage::add_segment(0);
+
+        builder
+          .add_batch(serialize_cmd(set_cmd{"a", 1}, batch_type_1, offset++))
+          .get0();
+        builder
+          .add_batch(serialize_cmd(set_cmd{"b", 2}, batch_type_1, offset++))
+          .get0();
+        builder
+          .add_batch(serialize_cmd(set_cmd{"c", 3}, batch_type_2, offset++))
+          .get0();
+        builder
+          .add_batch(serialize_cmd(set_cmd{"a", 4}, batch_type_1, offset++))
+          .get0(); // -> failed
+        builder.stop().get0();
+    }
+    start_raft();
+    bulk_kv<batch_type_1> state_1;
+    simple_kv<batch_type_2> state_2;
+    raft::mux_state_machine stm(
+      kvlog, _raft.get(), raft::persistent_last_applied::yes, state_1, state_2);
+    stm.start().get0();
+    auto stop = ss::defer([&stm] { stm.stop().get0(); });
+    wait_for_leader();
+    auto offset = _storage.local().log_mgr().get(_ntp)->offsets().dirty_offset;
+    stm.wait(offset, model::timeout_clock::now() + 1s).get0();
+
+    // the batches of the second state split the first one into two runs
+    BOOST_REQUIRE_EQUAL(state_1.batches, 3);
+    BOOST_REQUIRE_GE(state_1.runs, 2);
+    BOOST_REQUIRE_EQUAL(state_1.kv_map.size(), 2);
+    BOOST_REQUIRE_EQUAL(state_1.kv_map.find("a")->second, 1);
+    BOOST_REQUIRE_EQUAL(state_1.kv_map.find("b")->second, 2);
+    BOOST_REQUIRE_EQUAL(state_2.kv_map.find("c")->second, 3);
+}
+
 FIXTURE_TEST(test_mulitple_states, mux_state_machine_fixture) {
     start_raft();
     simple_kv<batch_type_1> state_1;
@@ -94,6 +94,46 @@ SEASTAR_THREAD_TEST_CASE(append_entries_requests) {
       .get0();
 }
 
+SEASTAR_THREAD_TEST_CASE(append_entries_requests_with_encoded_batches) {
+    auto batches = storage::test::make_random_batches(
+      model::offset(1), 3, false);
+    ss::circular_buffer<model::record_batch> expected;
+    ss::circular_buffer<model::record_batch> shared;
+    for (auto& b : batches) {
+        b.set_term(model::term_id(123));
+        expected.push_back(b.share());
+        shared.push_back(b.share());
+    }
+    auto encoded = ss::make_lw_shared<iobuf>(
+      raft::append_entries_request::encode_batches(std::move(shared)));
+    auto meta = raft::protocol_metadata{
+      .group = raft::group_id(1),
+      .commit_index = model::offset(100),
+      .term = model::term_id(10),
+    };
+
+    // the encoded batches are sent instead of the reader
+    for (int i = 0; i < 2; ++i) {
+        raft::append_entries_request req(
+          model::node_id(1),
+          meta,
+          model::make_memory_record_batch_reader(
+            ss::circular_buffer<model::record_batch>{}));
+        req.encoded_batches = ss::make_foreign(encoded);
+        auto d = async_serialize_roundtrip_rpc(std::move(req)).get0();
+
+        BOOST_REQUIRE_EQUAL(d.node_id, model::node_id(1));
+        BOOST_REQUIRE_EQUAL(d.meta.group, meta.group);
+        BOOST_REQUIRE_EQUAL(d.meta.term, meta.term);
+        ss::circular_buffer<model::record_batch> exp;
+        for (auto& b : expected) {
+            exp.push_back(b.share());
+        }
+        d.batches.consume(checking_consumer(std::move(exp)), model::no_timeout)
+          .get0();
+    }
+}
+
 model::broker create_test_broker() {
     return model::broker(
       model::node_id(random_generators::get_int(1000)), // id
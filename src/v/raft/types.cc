@@ -44,18 +44,24 @@ std::ostream& operator<<(std::ostream& o, const follower_index_metadata& i) {
              << ", match_index: " << i.match_index
              << ", next_index: " << i.next_index
              << ", is_learner: " << i.is_learner
-             << ", is_recovering: " << i.is_recovering << "}";
+             << ", is_recovering: " << i.is_recovering
+             << ", inflight_appends: " << i.inflight_appends
+             << ", inflight_append_bytes: " << i.inflight_append_bytes << "}";
 }
 
 std::ostream& operator<<(std::ostream& o, const heartbeat_request& r) {
-    o << "{node: " << r.node_id << ", meta:(" << r.meta.size() << ") [";
+    o << "{node: " << r.node_id << ", session: " << r.session
+      << ", seq: " << r.seq << ", base_seq: " << r.base_seq
+      << ", attachment: " << r.attachment.size_bytes()
+      << ", quiesced: " << r.quiesced.size() << ", meta:("
+      << r.meta.size() << ") [";
     for (auto& m : r.meta) {
         o << m << ",";
     }
     return o << "]}";
 }
 std::ostream& operator<<(std::ostream& o, const heartbeat_reply& r) {
-    o << "{meta:[";
+    o << "{base_missing: " << r.base_missing << ", meta:[";
     for (auto& m : r.meta) {
         o << m << ",";
     }
@@ -119,6 +125,37 @@ std::ostream& operator<<(std::ostream& o, const install_snapshot_request& r) {
     return o;
 }
 
+std::ostream& operator<<(std::ostream& o, const install_segment_request& r) {
+    fmt::print(
+      o,
+      "{{term: {}, group: {}, node_id: {}, base_offset: {}, segment_term: {}, "
+      "last_offset: {}, file: {}, file_offset: {}, chunk_size: {}, done: {}}}",
+      r.term,
+      r.group,
+      r.node_id,
+      r.base_offset,
+      r.segment_term,
+      r.last_offset,
+      r.file,
+      r.file_offset,
+      r.chunk.size_bytes(),
+      r.done);
+    return o;
+}
+
+std::ostream& operator<<(std::ostream& o, const install_segment_reply& r) {
+    fmt::print(
+      o,
+      "{{term: {}, bytes_stored: {}, last_dirty_log_index: {}, "
+      "last_committed_log_index: {}, success: {}}}",
+      r.term,
+      r.bytes_stored,
+      r.last_dirty_log_index,
+      r.last_committed_log_index,
+      r.success);
+    return o;
+}
+
 std::ostream& operator<<(std::ostream& o, const install_snapshot_reply& r) {
     fmt::print(
       o,
@@ -129,6 +166,16 @@ std::ostream& operator<<(std::ostream& o, const install_snapshot_reply& r) {
     return o;
 }
 
+iobuf append_entries_request::encode_batches(
+  ss::circular_buffer<model::record_batch> batches) {
+    iobuf out;
+    reflection::adl<uint32_t>{}.to(out, batches.size());
+    for (auto& batch : batches) {
+        reflection::serialize(out, std::move(batch));
+    }
+    return out;
+}
+
 } // namespace raft
 
 namespace reflection {
@@ -156,14 +203,25 @@ struct rpc_model_reader_consumer {
 
 ss::future<> async_adl<raft::append_entries_request>::to(
   iobuf& out, raft::append_entries_request&& request) {
+    if (request.encoded_batches) {
+        // shared when sent from the shard of the leader, fragments can not be
+        // shared with other shards
+        auto& encoded = *request.encoded_batches;
+        if (request.encoded_batches.get_owner_shard() == ss::this_shard_id()) {
+            out.append(encoded.share(0, encoded.size_bytes()));
+        } else {
+            out.append(encoded.copy());
+        }
+        reflection::serialize(
+          out, request.meta, request.node_id, request.flush);
+        return ss::now();
+    }
     return model::consume_reader_to_memory(
              std::move(request.batches), model::no_timeout)
       .then([&out, request = std::move(request)](
               ss::circular_buffer<model::record_batch> batches) {
-          reflection::adl<uint32_t>{}.to(out, batches.size());
-          for (auto& batch : batches) {
-              reflection::serialize(out, std::move(batch));
-          }
+          out.append(raft::append_entries_request::encode_batches(
+            std::move(batches)));
           reflection::serialize(
             out, request.meta, request.node_id, request.flush);
       });
@@ -302,7 +360,7 @@ ss::future<> async_adl<raft::heartbeat_request>::to(
     };
     std::sort(request.meta.begin(), request.meta.end(), sorter_fn{});
     return ss::make_ready_future<>()
-      .then([&out, request = std::move(request)] {
+      .then([&out, request = std::move(request)]() mutable {
           internal::hbeat_soa encodee(request.meta.size());
           const size_t size = request.meta.size();
           for (size_t i = 0; i < size; ++i) {
@@ -323,6 +381,13 @@ ss::future<> async_adl<raft::heartbeat_request>::to(
           // important to release this memory after this function
           // request.meta = {}; // release memory
           adl<model::node_id>{}.to(out, request.node_id);
+          adl<uint64_t>{}.to(out, request.session);
+          adl<uint64_t>{}.to(out, request.seq);
+          adl<uint64_t>{}.to(out, request.base_seq);
+          adl<std::vector<uint64_t>>{}.to(out, request.unchanged);
+          adl<iobuf>{}.to(out, std::move(request.attachment));
+          adl<std::vector<raft::group_id>>{}.to(
+            out, std::move(request.quiesced));
           adl<uint32_t>{}.to(out, size);
           return encodee;
       })
@@ -349,6 +414,12 @@ ss::future<raft::heartbeat_request>
 async_adl<raft::heartbeat_request>::from(iobuf_parser& in) {
     raft::heartbeat_request req;
     req.node_id = adl<model::node_id>{}.from(in);
+    req.session = adl<uint64_t>{}.from(in);
+    req.seq = adl<uint64_t>{}.from(in);
+    req.base_seq = adl<uint64_t>{}.from(in);
+    req.unchanged = adl<std::vector<uint64_t>>{}.from(in);
+    req.attachment = adl<iobuf>{}.from(in);
+    req.quiesced = adl<std::vector<raft::group_id>>{}.from(in);
     req.meta = std::vector<raft::protocol_metadata>(adl<uint32_t>{}.from(in));
     if (req.meta.empty()) {
         return ss::make_ready_future<raft::heartbeat_request>(std::move(req));
@@ -407,6 +478,7 @@ ss::future<> async_adl<raft::heartbeat_reply>::to(
             return lhs.last_committed_log_index < rhs.last_committed_log_index;
         }
     };
+    adl<bool>{}.to(out, reply.base_missing);
     adl<uint32_t>{}.to(out, reply.meta.size());
     // no requests
     if (reply.meta.empty()) {
@@ -448,6 +520,7 @@ ss::future<> async_adl<raft::heartbeat_reply>::to(
 ss::future<raft::heartbeat_reply>
 async_adl<raft::heartbeat_reply>::from(iobuf_parser& in) {
     raft::heartbeat_reply reply;
+    reply.base_missing = adl<bool>{}.from(in);
     reply.meta = std::vector<raft::append_entries_reply>(
       adl<uint32_t>{}.from(in));
 
@@ -19,9 +19,12 @@
 #include "model/timeout_clock.h"
 #include "raft/configuration.h"
 #include "reflection/async_adl.h"
+#include "storage/segment_transfer.h"
 #include "utils/named_type.h"
 
 #include <seastar/core/condition-variable.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/sharded.hh>
 #include <seastar/net/socket_defs.hh>
 #include <seastar/util/bool_class.hh>
 
@@ -50,6 +53,13 @@ struct protocol_metadata {
     model::offset prev_log_index;
     model::term_id prev_log_term;
     model::offset last_visible_index;
+
+    bool operator==(const protocol_metadata& other) const {
+        return group == other.group && commit_index == other.commit_index
+               && term == other.term && prev_log_index == other.prev_log_index
+               && prev_log_term == other.prev_log_term
+               && last_visible_index == other.last_visible_index;
+    }
 };
 
 // The sequence used to track the order of follower append entries request
@@ -80,7 +90,21 @@ struct follower_index_metadata {
     // timestamp of last append_entries_rpc call
     clock_type::time_point last_append_timestamp;
     clock_type::time_point last_hbeat_timestamp;
+    // moving average of the round trip time of append entries requests
+    clock_type::duration append_rtt{0};
+    // leader lease: the follower acknowledged the leader at least with a
+    // request sent at `lease_ack_timestamp`. the oldest request sent since
+    // the last acknowledgement is tracked as a probe
+    clock_type::time_point lease_ack_timestamp;
+    std::optional<follower_req_seq> lease_probe_seq;
+    clock_type::time_point lease_probe_timestamp;
     uint64_t failed_appends{0};
+    // append entries requests of the replicate path in flight to the
+    // follower, and the size of their batches. past the window set by
+    // raft_max_inflight_follower_appends and _append_bytes the follower is
+    // caught up by recovery instead
+    size_t inflight_appends{0};
+    size_t inflight_append_bytes{0};
     // The pair of sequences used to track append entries requests sent and
     // received by the follower. Every time append entries request is created
     // the `last_sent_seq` is incremented before accessing raft protocol state
@@ -139,6 +163,15 @@ struct follower_index_metadata {
     ss::condition_variable recovery_finished;
 };
 
+/// The progress of a follower the leader is recovering
+struct follower_recovery_state {
+    model::node_id node;
+    /// the last offset the follower has, matching the leader's log
+    model::offset match_index;
+    /// the last offset of the leader's log
+    model::offset last_offset;
+};
+
 struct append_entries_request {
     using flush_after_append = ss::bool_class<struct flush_after_append_tag>;
 
@@ -164,12 +197,21 @@ struct append_entries_request {
     protocol_metadata meta;
     model::record_batch_reader batches;
     flush_after_append flush;
+    /// the batches encoded once by the leader and shared by the requests to
+    /// all the followers. when set they are sent instead of `batches`.
+    ss::foreign_ptr<ss::lw_shared_ptr<iobuf>> encoded_batches;
+
+    /// the wire format of the batches of a request
+    static iobuf encode_batches(ss::circular_buffer<model::record_batch>);
+
     static append_entries_request make_foreign(append_entries_request&& req) {
-        return append_entries_request(
+        append_entries_request ret(
           req.node_id,
           std::move(req.meta),
           model::make_foreign_record_batch_reader(std::move(req.batches)),
           req.flush);
+        ret.encoded_batches = std::move(req.encoded_batches);
+        return ret;
     }
 };
 
@@ -201,9 +243,24 @@ struct append_entries_reply {
 struct heartbeat_request {
     model::node_id node_id;
     std::vector<protocol_metadata> meta;
+    // delta encoding, see heartbeat_delta.h. Sequences are assigned per
+    // session, 0 means that the request has no base
+    uint64_t session{0};
+    uint64_t seq{0};
+    uint64_t base_seq{0};
+    // bitmap of base groups heartbeated again with unchanged metadata
+    std::vector<uint64_t> unchanged;
+    // data of an upper layer sent along, see heartbeat_attachments
+    iobuf attachment;
+    // groups of the request the sender stops heartbeating once the target
+    // acknowledged them, see heartbeat_manager
+    std::vector<raft::group_id> quiesced;
 };
 struct heartbeat_reply {
     std::vector<append_entries_reply> meta;
+    // the base of the request was not known, the unchanged groups were not
+    // heartbeated
+    bool base_missing{false};
 };
 
 struct vote_request {
@@ -232,6 +289,16 @@ struct vote_reply {
     bool log_ok = false;
 };
 
+/// The vote requests of the groups of a core to the same node, sent together
+struct vote_batch_request {
+    std::vector<vote_request> requests;
+};
+
+/// The replies to a vote_batch_request, in the order of its requests
+struct vote_batch_reply {
+    std::vector<vote_reply> replies;
+};
+
 /// This structure is used by consensus to notify other systems about group
 /// leadership changes.
 struct leadership_status {
@@ -256,6 +323,8 @@ struct replicate_options {
       : consistency(l) {}
 
     consistency_level consistency;
+    // records the latency of the stages of the request, see replicate_tracer
+    bool traced{false};
 };
 
 struct snapshot_metadata {
@@ -265,6 +334,12 @@ struct snapshot_metadata {
     ss::lowres_clock::time_point cluster_time;
 };
 
+/// The state machine data of the latest snapshot of a group
+struct snapshot_data {
+    model::offset last_included_index;
+    iobuf data;
+};
+
 struct install_snapshot_request {
     // leader’s term
     model::term_id term;
@@ -332,6 +407,88 @@ struct install_snapshot_reply {
     operator<<(std::ostream&, const install_snapshot_reply&);
 };
 
+/*
+ * Chunk of a closed segment copied as is to a follower that is far behind.
+ * The data file is sent first, followed by its offset index. The follower
+ * appends the segment to its log once the last chunk of the index arrives.
+ */
+struct install_segment_request {
+    // leader’s term
+    model::term_id term;
+    // target group
+    raft::group_id group;
+    // leader id so follower can redirect clients
+    model::node_id node_id;
+    // base offset and term identifying the segment
+    model::offset base_offset;
+    model::term_id segment_term;
+    // last offset in the segment
+    model::offset last_offset;
+    // term of the entry preceding the segment, the follower log must match
+    model::term_id prev_log_term;
+    model::offset commit_index;
+    storage::segment_file_type file;
+    // byte offset where the chunk is positioned in the file
+    uint64_t file_offset;
+    // file chunk, raw bytes
+    iobuf chunk;
+    // true if this is the last chunk of the segment
+    bool done;
+
+    raft::group_id target_group() const { return group; }
+    friend std::ostream&
+    operator<<(std::ostream&, const install_segment_request&);
+};
+
+class install_segment_request_foreign_wrapper {
+public:
+    using ptr_t = ss::foreign_ptr<std::unique_ptr<install_segment_request>>;
+
+    explicit install_segment_request_foreign_wrapper(
+      install_segment_request&& req)
+      : _ptr(ss::make_foreign(
+        std::make_unique<install_segment_request>(std::move(req)))) {}
+
+    install_segment_request copy() const {
+        // make copy on target core
+        return install_segment_request{
+          .term = _ptr->term,
+          .group = _ptr->group,
+          .node_id = _ptr->node_id,
+          .base_offset = _ptr->base_offset,
+          .segment_term = _ptr->segment_term,
+          .last_offset = _ptr->last_offset,
+          .prev_log_term = _ptr->prev_log_term,
+          .commit_index = _ptr->commit_index,
+          .file = _ptr->file,
+          .file_offset = _ptr->file_offset,
+          .chunk = _ptr->chunk.copy(),
+          .done = _ptr->done};
+    }
+
+    raft::group_id target_group() const { return _ptr->target_group(); }
+
+private:
+    ptr_t _ptr;
+};
+
+struct install_segment_reply {
+    // current term, for leader to update itself
+    model::term_id term;
+    // bytes of the file stored by the follower after applying the request
+    uint64_t bytes_stored;
+    // last offsets of the follower log, so that the leader can fall back to
+    // replicating entries when the follower log does not end right before
+    // the segment
+    model::offset last_dirty_log_index;
+    model::offset last_committed_log_index;
+    // indicates if the request was successfull
+    bool success = false;
+
+    friend std::ostream&
+    operator<<(std::ostream&, const install_segment_reply&);
+};
+
 /**
  * Configuration describing snapshot that is going to be taken at current node.
  */
@@ -380,6 +537,7 @@ enum class metadata_key : int8_t {
     config_map = 1,
     config_latest_known_offset = 2,
     last_applied_offset = 3,
+    config_delta = 4,
 };
 
 std::ostream& operator<<(std::ostream& o, const consistency_level& l);
@@ -13,6 +13,8 @@
 
 #include "random/fast_prng.h"
 
+#include <algorithm>
+
 template<
   typename ClockType,
   typename DurationType = typename ClockType::duration>
@@ -35,6 +37,12 @@ public:
     }
     DurationType next_duration() { return _base + next_jitter_duration(); }
 
+    /// for timeouts that follow what they time out on, keeps the generator
+    void set_duration(DurationType base, DurationType jitter) {
+        _base = base;
+        _jitter = std::max(jitter, DurationType(1));
+    }
+
 private:
     DurationType _base;
     DurationType _jitter;
@@ -12,24 +12,35 @@
 #include "cluster/metadata_dissemination_handler.h"
 #include "cluster/metadata_dissemination_service.h"
 #include "cluster/service.h"
+#include "compression/compression.h"
 #include "config/configuration.h"
 #include "config/seed_server.h"
+#include "finjector/hbadger.h"
+#include "kafka/load_sketches.h"
 #include "kafka/protocol.h"
 #include "model/metadata.h"
 #include "platform/stop_signal.h"
 #include "raft/service.h"
 #include "redpanda/admin/api-doc/config.json.h"
+#include "redpanda/admin/api-doc/failure_probes.json.h"
 #include "redpanda/admin/api-doc/kafka.json.h"
+#include "redpanda/admin/api-doc/latency.json.h"
+#include "redpanda/admin/api-doc/memory.json.h"
+#include "redpanda/admin/api-doc/profiler.json.h"
 #include "redpanda/admin/api-doc/raft.json.h"
+#include "resource_mgmt/io_priority.h"
 #include "rpc/simple_protocol.h"
 #include "storage/chunk_cache.h"
 #include "storage/directories.h"
+#include "storage/log_reader.h"
 #include "syschecks/syschecks.h"
 #include "test_utils/logs.h"
 #include "utils/file_io.h"
+#include "utils/task_profiler.h"
 #include "version.h"
 #include "vlog.h"
 
+#include <seastar/core/memory.hh>
 #include <seastar/core/metrics.hh>
 #include <seastar/core/prometheus.hh>
 #include <seastar/core/thread.hh>
@@ -38,11 +49,17 @@
 #include <seastar/json/json_elements.hh>
 #include <seastar/util/defer.hh>
 
+#include <boost/range/irange.hpp>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <sys/utsname.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
 #include <vector>
 
 int application::run(int ac, char** av) {
@@ -80,6 +97,7 @@ int application::run(int ac, char** av) {
                 start();
                 app_signal.wait().get();
                 vlog(_log.info, "Stopping...");
+                drain_leadership();
             } catch (...) {
                 vlog(
                   _log.info,
@@ -101,6 +119,9 @@ void application::initialize() {
       [this] { _scheduling_groups.destroy_groups().get(); });
     _smp_groups.create_groups().get();
     _deferred.emplace_back([this] { _smp_groups.destroy_groups().get(); });
+    ss::smp::invoke_on_all([sg = _scheduling_groups.compression_sg()] {
+        compression::compressor::set_scheduling_group(sg);
+    }).get();
 }
 
 void application::setup_metrics() {
@@ -118,6 +139,93 @@ void application::setup_metrics() {
     }
 }
 
+void application::add_memory_budgets(memory_governor& g) {
+    auto& kafka = _kafka_server.local();
+    g.add(memory_governor::budget{
+      .name = "kafka",
+      .floor = memory_groups::kafka_min_memory(),
+      .ceiling = memory_groups::kafka_max_memory(),
+      .initial = memory_groups::kafka_total_memory(),
+      .used = [&kafka] { return size_t(kafka.consumed_memory()); },
+      .starved = memory_governor::counter_grew(
+        [&kafka] { return kafka.memory_waits(); }),
+      .resize = [&kafka](size_t n) { kafka.set_max_memory(int64_t(n)); },
+    });
+    auto& rpc = _rpc.local();
+    g.add(memory_governor::budget{
+      .name = "rpc",
+      .floor = memory_groups::rpc_min_memory(),
+      .ceiling = memory_groups::rpc_max_memory(),
+      .initial = memory_groups::rpc_total_memory(),
+      .used = [&rpc] { return size_t(rpc.consumed_memory()); },
+      .starved = memory_governor::counter_grew(
+        [&rpc] { return rpc.memory_waits(); }),
+      .resize = [&rpc](size_t n) { rpc.set_max_memory(int64_t(n)); },
+    });
+    auto& chunks = storage::internal::chunks();
+    g.add(memory_governor::budget{
+      .name = "chunk_cache",
+      .floor = memory_groups::chunk_cache_min_memory(),
+      .ceiling = memory_groups::chunk_cache_max_memory(),
+      .initial = chunks.size_limit(),
+      .used = [&chunks] { return chunks.size_bytes(); },
+      .starved = memory_governor::counter_grew(
+        [&chunks] { return chunks.waits(); }),
+      .resize = [&chunks](size_t n) { chunks.set_size_limit(n); },
+    });
+    auto& cache = storage.local().log_mgr().cache();
+    g.add(memory_governor::budget{
+      .name = "batch_cache",
+      .floor = 0,
+      .ceiling = memory_groups::batch_cache_max_memory(),
+      .initial = 0,
+      .used = [&cache] { return cache.size_bytes(); },
+      .starved = memory_governor::counter_grew(
+        [&cache] { return cache.probe().reclaimed_bytes(); }),
+      .resize = [](size_t) {},
+    });
+}
+
+void application::sample_memory_accounting() {
+    using subsystem = memory_accounting::subsystem;
+    auto& accounting = shard_memory_accounting();
+    auto& kafka = _kafka_server.local();
+    accounting.sample(subsystem::kafka_requests, [&kafka] {
+        return size_t(kafka.consumed_memory());
+    });
+    auto& rpc = _rpc.local();
+    accounting.sample(subsystem::rpc_requests, [&rpc] {
+        return size_t(rpc.consumed_memory());
+    });
+    auto& chunks = storage::internal::chunks();
+    accounting.sample(
+      subsystem::chunk_cache, [&chunks] { return chunks.size_bytes(); });
+    auto& cache = storage.local().log_mgr().cache();
+    accounting.sample(
+      subsystem::batch_cache, [&cache] { return cache.size_bytes(); });
+    accounting.setup_metrics();
+}
+
+std::chrono::steady_clock::time_point application::record_startup_phase(
+  std::string_view phase, std::chrono::steady_clock::time_point started) {
+    auto now = std::chrono::steady_clock::now();
+    auto took = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  now - started)
+                  .count();
+    vlog(_log.info, "Startup phase {} took {} ms", phase, took);
+    if (!config::shard_local_cfg().disable_metrics()) {
+        _metrics.add_group(
+          "application",
+          {ss::metrics::make_gauge(
+            "startup_phase_ms",
+            [took] { return took; },
+            ss::metrics::description(
+              "Time taken by a phase of the startup in milliseconds"),
+            {ss::metrics::label("phase")(ss::sstring(phase))})});
+    }
+    return now;
+}
+
 void application::validate_arguments(const po::variables_map& cfg) {
     if (!cfg.count("redpanda-cfg")) {
         throw std::invalid_argument("Missing redpanda-cfg flag");
@@ -170,6 +278,34 @@ void application::check_environment() {
     storage::directories::initialize(
       config::shard_local_cfg().data_directory().as_sstring())
       .get();
+    for (auto& dir : config::shard_local_cfg().additional_data_directories()) {
+        storage::directories::initialize(dir).get();
+    }
+    if (config::shard_local_cfg().storage_calibrate_disk()) {
+        calibrate_disk();
+    }
+}
+
+void application::calibrate_disk() {
+    const auto dir = config::shard_local_cfg().data_directory().as_sstring();
+    _disk_calibration = syschecks::read_disk_calibration(dir).get0();
+    if (!_disk_calibration) {
+        syschecks::systemd_message("calibrating the disk of {}", dir);
+        _disk_calibration = syschecks::calibrate_disk(dir).get0();
+        syschecks::write_disk_calibration(dir, *_disk_calibration).get();
+        // the io scheduler is set up before the application runs, so that
+        // it only gets the calibration on the next start
+        const auto io_properties
+          = (std::filesystem::path(dir) / "io-properties.yaml").string();
+        syschecks::write_io_properties(io_properties, dir, *_disk_calibration)
+          .get();
+        vlog(
+          _log.info,
+          "Start with --io-properties-file={} to schedule the ios after the "
+          "disk calibration",
+          io_properties);
+    }
+    vlog(_log.info, "Disk calibration of {}: {}", dir, *_disk_calibration);
 }
 
 void application::configure_admin_server() {
@@ -212,15 +348,17 @@ void application::configure_admin_server() {
               rb->register_api_file(server._routes, "header");
               rb->register_api_file(server._routes, "config");
               rb->register_api_file(server._routes, "raft");
-              ss::httpd::config_json::get_config.set(
-                server._routes, []([[maybe_unused]] ss::const_req req) {
-                    rapidjson::StringBuffer buf;
-                    rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
-                    config::shard_local_cfg().to_json(writer);
-                    return ss::json::json_return_type(buf.GetString());
-                });
+              rb->register_api_file(server._routes, "profiler");
+              rb->register_api_file(server._routes, "latency");
+              rb->register_api_file(server._routes, "memory");
+              rb->register_api_file(server._routes, "failure_probes");
+              admin_register_config_routes(server);
               admin_register_raft_routes(server);
               admin_register_kafka_routes(server);
+              admin_register_profiler_routes(server);
+              admin_register_latency_routes(server);
+              admin_register_memory_routes(server);
+              admin_register_failure_probe_routes(server);
           })
           .get();
     }
@@ -259,8 +397,10 @@ static storage::kvstore_config kvstore_config_from_global_config() {
       storage::debug_sanitize_files::no);
 }
 
-static storage::log_config manager_config_from_global_config() {
-    return storage::log_config(
+static storage::log_config manager_config_from_global_config(
+  scheduling_groups& sgs,
+  const std::optional<syschecks::disk_calibration>& disk) {
+    auto cfg = storage::log_config(
       storage::log_config::storage_type::disk,
       config::shard_local_cfg().data_directory().as_sstring(),
       config::shard_local_cfg().log_segment_size(),
@@ -276,18 +416,156 @@ static storage::log_config manager_config_from_global_config() {
         .stable_window = config::shard_local_cfg().reclaim_stable_window(),
         .min_size = config::shard_local_cfg().reclaim_min_size(),
         .max_size = config::shard_local_cfg().reclaim_max_size(),
+        .background = config::shard_local_cfg().reclaim_background(),
+        .max_batch_size
+        = config::shard_local_cfg().batch_cache_max_batch_bytes(),
       });
+    if (config::shard_local_cfg().log_segment_adaptive_sizing()) {
+        cfg.segment_roll_target
+          = config::shard_local_cfg().log_segment_roll_target_ms();
+        cfg.min_segment_size = config::shard_local_cfg().log_segment_size_min();
+    }
+    cfg.hashed_key_index_bytes
+      = config::shard_local_cfg().compaction_hashed_key_index_bytes();
+    cfg.compaction_bytes_per_sec
+      = config::shard_local_cfg().compaction_bytes_per_sec();
+    cfg.extra_dirs = config::shard_local_cfg().additional_data_directories();
+    cfg.max_concurrent_recoveries
+      = config::shard_local_cfg().log_recovery_concurrency();
+    cfg.max_concurrent_segment_deletions
+      = config::shard_local_cfg().segment_deletion_concurrency();
+    cfg.coalesced_read_max_bytes
+      = config::shard_local_cfg().storage_coalesced_read_max_bytes();
+    if (disk) {
+        // the reads of the segments are of the size past which the
+        // bandwidth of the disk does not grow
+        cfg.segment_readahead_size = std::max(
+          disk->read_io_size, storage::read_buffer_sizer::min_buffer_size);
+        if (!cfg.coalesced_read_max_bytes) {
+            cfg.coalesced_read_max_bytes = cfg.segment_readahead_size;
+        }
+    }
+    cfg.readers_cache_eviction_timeout
+      = config::shard_local_cfg().readers_cache_eviction_timeout_ms();
+    cfg.read_buffers_memory
+      = config::shard_local_cfg().storage_read_buffer_memory();
+    cfg.min_free_bytes = config::shard_local_cfg().storage_min_free_bytes();
+    if (auto rate = config::shard_local_cfg().storage_scrub_bytes_per_sec();
+        rate) {
+        // split evenly across the cores, as the disk is shared
+        cfg.scrub_bytes_per_sec = std::max<size_t>(1, *rate / ss::smp::count);
+    }
+    cfg.scrub_interval = config::shard_local_cfg().storage_scrub_interval_ms();
+    cfg.scrub_priority = scrub_priority();
+    if (config::shard_local_cfg().storage_shared_wal_enabled()) {
+        cfg.shared_wal_segment_size
+          = config::shard_local_cfg().storage_shared_wal_segment_size();
+    }
+    cfg.coalesce_batch_bytes
+      = config::shard_local_cfg().storage_coalesce_batch_bytes();
+    if (auto rate = config::shard_local_cfg().storage_deletion_bytes_per_sec();
+        rate) {
+        cfg.deletion_bytes_per_sec = std::max<size_t>(
+          1, *rate / ss::smp::count);
+    }
+    if (auto max = config::shard_local_cfg().memory_topics_max_bytes(); max) {
+        cfg.memory_log_bytes = *max / ss::smp::count;
+    } else {
+        cfg.memory_log_bytes = memory_groups::memory_log_memory();
+    }
+    cfg.archival_enabled = config::shard_local_cfg().archival_enabled();
+    cfg.local_retention_bytes
+      = config::shard_local_cfg().archival_local_retention_bytes();
+    cfg.local_delete_retention
+      = config::shard_local_cfg().archival_local_retention_ms();
+    cfg.compaction_sg = sgs.compaction_sg();
+    cfg.compaction_priority = compaction_priority();
+    return cfg;
+}
+
+// called from a seastar thread, resolves the endpoint
+static archival::configuration archival_config_from_global_config() {
+    const auto& cfg = config::shard_local_cfg();
+    if (
+      !cfg.archival_s3_bucket() || !cfg.archival_s3_access_key()
+      || !cfg.archival_s3_secret_key()) {
+        throw std::invalid_argument(
+          "archival_enabled requires archival_s3_bucket, "
+          "archival_s3_access_key and archival_s3_secret_key");
+    }
+    auto endpoint = cfg.archival_s3_endpoint().value_or(
+      fmt::format("s3.{}.amazonaws.com", cfg.archival_s3_region()));
+    s3::configuration client_cfg;
+    client_cfg.server_addr
+      = unresolved_address(endpoint, cfg.archival_s3_port()).resolve().get0();
+    if (!cfg.archival_s3_disable_tls()) {
+        ss::tls::credentials_builder builder;
+        builder.set_system_trust().get0();
+        client_cfg.credentials = std::move(builder);
+        client_cfg.tls_sni_hostname = endpoint;
+    }
+    client_cfg.uri = endpoint;
+    client_cfg.access_key = s3::access_key(*cfg.archival_s3_access_key());
+    client_cfg.secret_key = s3::secret_key(*cfg.archival_s3_secret_key());
+    client_cfg.region = s3::region(cfg.archival_s3_region());
+    auto cache_dir = cfg.archival_cache_directory()
+                       ? std::filesystem::path(
+                         cfg.archival_cache_directory()->c_str())
+                       : cfg.data_directory().path / "archival_cache";
+    return archival::configuration{
+      .client_config = std::move(client_cfg),
+      .bucket = s3::bucket_name(*cfg.archival_s3_bucket()),
+      .upload_interval = cfg.archival_upload_interval_ms(),
+      .max_concurrent_uploads = cfg.archival_max_concurrent_uploads(),
+      .request_timeout = cfg.archival_request_timeout_ms(),
+      .cache_directory = std::move(cache_dir),
+      // the cache size is shared by the shards
+      .cache_size = cfg.archival_cache_size() / ss::smp::count,
+      .cache_chunk_size = cfg.archival_cache_chunk_size(),
+      .cache_prefetch_chunks = cfg.archival_cache_prefetch_chunks(),
+      .delete_retention = cfg.delete_retention_ms(),
+      .retention_bytes = cfg.retention_bytes(),
+    };
 }
 
 // add additional services in here
 void application::wire_up_services() {
     ss::smp::invoke_on_all([] {
+        shard_local_task_profiler().set_stall_threshold(
+          config::shard_local_cfg().task_profiler_stall_threshold_ms());
         return storage::internal::chunks().start();
     }).get();
 
+    using controlled_group = scheduling_shares_controller::group;
+    auto& sgs = _scheduling_groups;
+    construct_service(
+      _shares_controller,
+      std::vector<controlled_group>{
+        {sgs.admin_sg(), scheduling_groups::admin_shares, std::nullopt},
+        {sgs.raft_sg(),
+         scheduling_groups::raft_shares,
+         config::shard_local_cfg().raft_scheduling_latency_target_ms()},
+        {sgs.kafka_sg(), scheduling_groups::kafka_shares, std::nullopt},
+        {sgs.kafka_control_sg(),
+         scheduling_groups::kafka_control_shares,
+         std::nullopt},
+        {sgs.cluster_sg(), scheduling_groups::cluster_shares, std::nullopt},
+        {sgs.coproc_sg(), scheduling_groups::coproc_shares, std::nullopt},
+        {sgs.compaction_sg(),
+         scheduling_groups::compaction_shares,
+         std::nullopt},
+        {sgs.compression_sg(),
+         scheduling_groups::compression_shares,
+         std::nullopt},
+      })
+      .get();
+
     // cluster
     syschecks::systemd_message("Adding raft client cache");
-    construct_service(_raft_connection_cache).get();
+    construct_service(
+      _raft_connection_cache,
+      config::shard_local_cfg().rpc_connections_per_peer())
+      .get();
     syschecks::systemd_message("Building shard-lookup tables");
     construct_service(shard_table).get();
 
@@ -295,7 +573,8 @@ void application::wire_up_services() {
     construct_service(
       storage,
       kvstore_config_from_global_config(),
-      manager_config_from_global_config())
+      manager_config_from_global_config(
+        _scheduling_groups, _disk_calibration))
       .get();
 
     if (coproc_enabled()) {
@@ -327,6 +606,16 @@ void application::wire_up_services() {
       .get();
     vlog(_log.info, "Partition manager started");
 
+    if (archival_enabled()) {
+        syschecks::systemd_message("Creating archival service");
+        construct_service(
+          archival_service,
+          std::ref(partition_manager),
+          std::ref(storage),
+          archival_config_from_global_config())
+          .get();
+    }
+
     // controller
 
     syschecks::systemd_message("Creating cluster::controller");
@@ -390,6 +679,12 @@ void application::wire_up_services() {
     rpc_cfg.load_balancing_algo
       = ss::server_socket::load_balancing_algorithm::port;
     rpc_cfg.max_service_memory_per_core = memory_groups::rpc_total_memory();
+    rpc_cfg.cork_window = std::chrono::microseconds(
+      config::shard_local_cfg().rpc_cork_window_us());
+    rpc_cfg.max_requests_per_method
+      = config::shard_local_cfg().rpc_max_requests_per_method();
+    rpc_cfg.queue_time_target
+      = config::shard_local_cfg().rpc_queue_time_target_ms();
     auto rpc_server_addr
       = config::shard_local_cfg().rpc_server().resolve().get0();
     rpc_cfg.addrs.push_back(rpc_server_addr);
@@ -424,13 +719,36 @@ void application::wire_up_services() {
                               .kafka_api_tls()
                               .get_credentials_builder()
                               .get0();
+    kafka_cfg.max_connections_per_ip
+      = config::shard_local_cfg().kafka_max_connections_per_ip();
+    kafka_cfg.max_accepts_per_second
+      = config::shard_local_cfg().kafka_max_accepted_connections_per_second();
     syschecks::systemd_message("Starting kafka RPC {}", kafka_cfg);
     construct_service(_kafka_server, kafka_cfg).get();
+
+    if (auto addr = config::shard_local_cfg().kafka_api_shard_aware(); addr) {
+        auto shard_aware_cfg = kafka_cfg;
+        shard_aware_cfg.name = "kafka_shard_aware_rpc";
+        shard_aware_cfg.addrs = {addr->resolve().get0()};
+        shard_aware_cfg.load_balancing_algo
+          = ss::server_socket::load_balancing_algorithm::port;
+        syschecks::systemd_message(
+          "Starting shard aware kafka RPC {}", shard_aware_cfg);
+        construct_service(_kafka_shard_aware_server, shard_aware_cfg).get();
+    }
 }
 
 void application::start() {
+    const auto started = std::chrono::steady_clock::now();
+    _shares_controller.invoke_on_all(&scheduling_shares_controller::start)
+      .get();
     syschecks::systemd_message("Staring storage services");
+    // the kvstore of each shard is recovered before its logs are managed
     storage.invoke_on_all(&storage::api::start).get();
+    storage
+      .invoke_on_all([](storage::api& s) { s.log_mgr().setup_metrics(); })
+      .get();
+    auto phase = record_startup_phase("storage", started);
 
     syschecks::systemd_message("Starting the partition manager");
     partition_manager.invoke_on_all(&cluster::partition_manager::start).get();
@@ -440,9 +758,18 @@ void application::start() {
 
     syschecks::systemd_message("Starting Kafka group manager");
     _group_manager.invoke_on_all(&kafka::group_manager::start).get();
+    phase = record_startup_phase("groups", phase);
 
+    // replays the controller log, the partitions are then recovered in the
+    // background, see controller_backend
     syschecks::systemd_message("Starting controller");
     controller->start().get0();
+    phase = record_startup_phase("controller", phase);
+
+    if (archival_enabled()) {
+        syschecks::systemd_message("Starting archival service");
+        archival_service.invoke_on_all(&archival::service::start).get();
+    }
 
     // FIXME: in first patch explain why this is started after the
     // controller so the broker set will be available. Then next patch fix.
@@ -460,7 +787,11 @@ void application::start() {
             _scheduling_groups.raft_sg(),
             _smp_groups.raft_smp_sg(),
             partition_manager,
-            shard_table.local());
+            shard_table.local(),
+            [this](model::node_id, iobuf attachment) {
+                return md_dissemination_service.local()
+                  .apply_heartbeat_attachment(std::move(attachment));
+            });
           proto->register_service<cluster::service>(
             _scheduling_groups.cluster_sg(),
             _smp_groups.cluster_smp_sg(),
@@ -496,12 +827,14 @@ void application::start() {
     }
 
     _quota_mgr.invoke_on_all(&kafka::quota_manager::start).get();
+    phase = record_startup_phase("rpc", phase);
 
     // Kafka API
     _kafka_server
       .invoke_on_all([this](rpc::server& s) {
           auto proto = std::make_unique<kafka::protocol>(
             _smp_groups.kafka_smp_sg(),
+            _scheduling_groups.kafka_control_sg(),
             metadata_cache,
             controller->get_topics_frontend(),
             _quota_mgr,
@@ -515,12 +848,177 @@ void application::start() {
     _kafka_server.invoke_on_all(&rpc::server::start).get();
     vlog(
       _log.info, "Started Kafka API server listening at {}", conf.kafka_api());
+    if (conf.kafka_api_shard_aware()) {
+        _kafka_shard_aware_server
+          .invoke_on_all([this](rpc::server& s) {
+              s.set_protocol(std::make_unique<kafka::protocol>(
+                _smp_groups.kafka_smp_sg(),
+                _scheduling_groups.kafka_control_sg(),
+                metadata_cache,
+                controller->get_topics_frontend(),
+                _quota_mgr,
+                group_router,
+                shard_table,
+                partition_manager,
+                coordinator_ntp_mapper,
+                kafka::protocol::shard_aware::yes));
+          })
+          .get();
+        _kafka_shard_aware_server.invoke_on_all(&rpc::server::start).get();
+        vlog(
+          _log.info,
+          "Started shard aware Kafka API server listening at {}",
+          *conf.kafka_api_shard_aware());
+    }
+
+    ss::smp::invoke_on_all([this] { sample_memory_accounting(); }).get();
+    _deferred.emplace_back([] {
+        ss::smp::invoke_on_all([] { shard_memory_accounting().reset(); })
+          .get();
+    });
+
+    construct_service(_memory_governor).get();
+    _memory_governor
+      .invoke_on_all([this](memory_governor& g) {
+          add_memory_budgets(g);
+          return g.start();
+      })
+      .get();
+    // once the histograms of the shards are registered
+    construct_single_service(
+      _node_histograms,
+      conf.node_latency_refresh_interval_ms(),
+      conf.disable_metrics());
+    _node_histograms->start().get();
+    record_startup_phase("kafka", phase);
+    record_startup_phase("total", started);
 
     vlog(_log.info, "Successfully started Redpanda!");
     syschecks::systemd_notify_ready();
 }
 
+void application::drain_leadership() {
+    auto& conf = config::shard_local_cfg();
+    const auto timeout = conf.leadership_drain_timeout_ms();
+    if (timeout <= std::chrono::milliseconds(0)) {
+        return;
+    }
+    // the clients are still served while the leaderships move, so that they
+    // follow the new leaders instead of waiting for elections
+    const auto deadline = model::timeout_clock::now() + timeout;
+    raft_group_manager
+      .invoke_on_all(
+        [deadline, max = conf.leadership_drain_max_concurrent()](
+          raft::group_manager& m) { return m.drain_leadership(max, deadline); })
+      .handle_exception([this](const std::exception_ptr& e) {
+          vlog(_log.warn, "Error draining leadership: {}", e);
+      })
+      .get();
+}
+
+namespace {
+struct partition_recovery {
+    model::ntp ntp;
+    raft::group_id group;
+    raft::follower_recovery_state follower;
+};
+} // namespace
+
+void application::admin_register_config_routes(ss::http_server& server) {
+    ss::httpd::config_json::get_config.set(
+      server._routes, []([[maybe_unused]] ss::const_req req) {
+          rapidjson::StringBuffer buf;
+          rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
+          config::shard_local_cfg().to_json(writer);
+          return ss::json::json_return_type(buf.GetString());
+      });
+
+    ss::httpd::config_json::set_config_property.set(
+      server._routes, [this](std::unique_ptr<ss::httpd::request> req) {
+          auto name = req->param["name"];
+          auto value = req->get_query_param("value");
+          config::base_property* property = nullptr;
+          try {
+              property = &config::shard_local_cfg().get(name);
+          } catch (const std::out_of_range&) {
+              throw ss::httpd::not_found_exception(
+                fmt::format("Unknown property {}", name));
+          }
+          if (!property->is_runtime_updatable()) {
+              throw ss::httpd::bad_param_exception(
+                fmt::format("Property {} needs a restart to change", name));
+          }
+          try {
+              if (auto err = property->validate(YAML::Load(value)); err) {
+                  throw ss::httpd::bad_param_exception(fmt::format(
+                    "Invalid value of {}: {}", name, err->error_message()));
+              }
+          } catch (const YAML::Exception& e) {
+              throw ss::httpd::bad_param_exception(
+                fmt::format("Invalid value of {}: {}", name, e.what()));
+          }
+
+          vlog(_log.info, "Updating property {} to {}", name, value);
+          // each core parses the value into its own copy of the config,
+          // which calls back the watchers of the core
+          return ss::smp::invoke_on_all([name, value] {
+                     config::shard_local_cfg().get(name).set_value(
+                       YAML::Load(value));
+                 })
+            .then([] {
+                return ss::json::json_return_type(ss::json::json_void());
+            });
+      });
+}
+
 void application::admin_register_raft_routes(ss::http_server& server) {
+    ss::httpd::raft_json::get_recovery_status.set(
+      server._routes, [this](std::unique_ptr<ss::httpd::request>) {
+          using recoveries_t = std::vector<partition_recovery>;
+          return partition_manager
+            .map_reduce0(
+              [](cluster::partition_manager& pm) {
+                  recoveries_t ret;
+                  for (const auto& [ntp, p] : pm.partitions()) {
+                      for (auto& f : p->raft()->recovering_followers()) {
+                          ret.push_back(partition_recovery{
+                            .ntp = ntp, .group = p->group(), .follower = f});
+                      }
+                  }
+                  return ret;
+              },
+              recoveries_t{},
+              [](recoveries_t acc, recoveries_t r) {
+                  std::move(r.begin(), r.end(), std::back_inserter(acc));
+                  return acc;
+              })
+            .then([](recoveries_t recoveries) {
+                rapidjson::StringBuffer buf;
+                rapidjson::Writer<rapidjson::StringBuffer> w(buf);
+                w.StartArray();
+                for (const auto& r : recoveries) {
+                    w.StartObject();
+                    w.Key("ns");
+                    w.String(r.ntp.ns().c_str());
+                    w.Key("topic");
+                    w.String(r.ntp.tp.topic().c_str());
+                    w.Key("partition");
+                    w.Int(r.ntp.tp.partition());
+                    w.Key("group_id");
+                    w.Int64(r.group());
+                    w.Key("node_id");
+                    w.Int(r.follower.node());
+                    w.Key("match_index");
+                    w.Int64(r.follower.match_index());
+                    w.Key("last_offset");
+                    w.Int64(r.follower.last_offset());
+                    w.EndObject();
+                }
+                w.EndArray();
+                return ss::json::json_return_type(buf.GetString());
+            });
+      });
+
     ss::httpd::raft_json::transfer_leadership.set(
       server._routes, [this](std::unique_ptr<ss::httpd::request> req) {
           raft::group_id group_id;
@@ -650,4 +1148,444 @@ void application::admin_register_kafka_routes(ss::http_server& server) {
                   });
             });
       });
+
+    ss::httpd::kafka_json::get_hot_keys.set(
+      server._routes, [](std::unique_ptr<ss::httpd::request> req) {
+          size_t limit = 10;
+          if (auto l = req->get_query_param("limit"); !l.empty()) {
+              try {
+                  limit = std::stoul(l);
+              } catch (...) {
+                  throw ss::httpd::bad_param_exception(
+                    fmt::format("Limit must be an integer: {}", l));
+              }
+          }
+          using sketches_t = kafka::load_sketches::sketches;
+          auto shards = boost::irange(0u, ss::smp::count);
+          return ss::map_reduce(
+                   shards.begin(),
+                   shards.end(),
+                   [](ss::shard_id shard) {
+                       return ss::smp::submit_to(shard, [] {
+                           return kafka::shard_load_sketches().get();
+                       });
+                   },
+                   sketches_t{},
+                   [](sketches_t acc, const sketches_t& s) {
+                       acc.merge(s);
+                       return acc;
+                   })
+            .then([limit](sketches_t node) {
+                rapidjson::StringBuffer buf;
+                rapidjson::Writer<rapidjson::StringBuffer> w(buf);
+                auto write_partitions =
+                  [&w, limit](
+                    const char* name,
+                    const kafka::load_sketches::partition_sketch& sketch) {
+                      w.Key(name);
+                      w.StartArray();
+                      for (const auto& e : sketch.top(limit)) {
+                          w.StartObject();
+                          w.Key("topic");
+                          w.String(e.key.tp.topic().c_str());
+                          w.Key("partition");
+                          w.Int(e.key.tp.partition());
+                          w.Key("count");
+                          w.Uint64(e.count);
+                          w.Key("error");
+                          w.Uint64(e.error);
+                          w.EndObject();
+                      }
+                      w.EndArray();
+                  };
+                auto write_clients =
+                  [&w, limit](
+                    const char* name,
+                    const kafka::load_sketches::client_sketch& sketch) {
+                      w.Key(name);
+                      w.StartArray();
+                      for (const auto& e : sketch.top(limit)) {
+                          w.StartObject();
+                          w.Key("client_id");
+                          w.String(e.key.c_str());
+                          w.Key("count");
+                          w.Uint64(e.count);
+                          w.Key("error");
+                          w.Uint64(e.error);
+                          w.EndObject();
+                      }
+                      w.EndArray();
+                  };
+                w.StartObject();
+                write_partitions("partitions_by_bytes", node.partition_bytes);
+                write_partitions(
+                  "partitions_by_requests", node.partition_requests);
+                write_clients("clients_by_bytes", node.client_bytes);
+                write_clients("clients_by_requests", node.client_requests);
+                w.EndObject();
+                return ss::json::json_return_type(buf.GetString());
+            });
+      });
+}
+
+namespace {
+void write_hist(
+  rapidjson::Writer<rapidjson::StringBuffer>& w,
+  const char* name,
+  const task_profiler::hist_summary& h) {
+    w.Key(name);
+    w.StartObject();
+    w.Key("count");
+    w.Uint64(h.count);
+    w.Key("p50_us");
+    w.Int64(h.p50);
+    w.Key("p99_us");
+    w.Int64(h.p99);
+    w.Key("max_us");
+    w.Int64(h.max);
+    w.EndObject();
+}
+} // namespace
+
+void application::admin_register_profiler_routes(ss::http_server& server) {
+    ss::httpd::profiler_json::get_profile.set(
+      server._routes, [](std::unique_ptr<ss::httpd::request>) {
+          using summaries_t = std::vector<task_profiler::summary>;
+          auto shards = boost::irange(0u, ss::smp::count);
+          return ss::map_reduce(
+                   shards.begin(),
+                   shards.end(),
+                   [](ss::shard_id shard) {
+                       return ss::smp::submit_to(shard, [] {
+                           return shard_local_task_profiler().summarize();
+                       });
+                   },
+                   summaries_t{},
+                   [](summaries_t acc, task_profiler::summary s) {
+                       acc.push_back(std::move(s));
+                       return acc;
+                   })
+            .then([](summaries_t summaries) {
+                std::sort(
+                  summaries.begin(),
+                  summaries.end(),
+                  [](const auto& a, const auto& b) {
+                      return a.shard < b.shard;
+                  });
+                rapidjson::StringBuffer buf;
+                rapidjson::Writer<rapidjson::StringBuffer> w(buf);
+                w.StartArray();
+                for (const auto& s : summaries) {
+                    w.StartObject();
+                    w.Key("shard");
+                    w.Uint(s.shard);
+                    w.Key("operations");
+                    w.StartArray();
+                    for (const auto& op : s.ops) {
+                        w.StartObject();
+                        w.Key("name");
+                        w.String(op.name.c_str());
+                        write_hist(w, "runtime", op.runtime);
+                        write_hist(w, "latency", op.latency);
+                        w.Key("stalls");
+                        w.Uint64(op.stalls);
+                        w.Key("stall_samples");
+                        w.StartArray();
+                        for (const auto& sample : op.samples) {
+                            w.StartObject();
+                            w.Key("timestamp_ms");
+                            w.Int64(
+                              std::chrono::duration_cast<
+                                std::chrono::milliseconds>(
+                                sample.at.time_since_epoch())
+                                .count());
+                            w.Key("runtime_us");
+                            w.Int64(sample.runtime.count());
+                            w.Key("backtrace");
+                            w.String(sample.backtrace.c_str());
+                            w.EndObject();
+                        }
+                        w.EndArray();
+                        w.EndObject();
+                    }
+                    w.EndArray();
+                    w.Key("scheduling_groups");
+                    w.StartArray();
+                    for (const auto& g : s.groups) {
+                        w.StartObject();
+                        w.Key("name");
+                        w.String(g.name.c_str());
+                        write_hist(w, "runtime", g.runtime);
+                        w.EndObject();
+                    }
+                    w.EndArray();
+                    w.EndObject();
+                }
+                w.EndArray();
+                return ss::json::json_return_type(buf.GetString());
+            });
+      });
+}
+
+namespace {
+void write_summaries(
+  rapidjson::Writer<rapidjson::StringBuffer>& w,
+  const std::vector<node_histograms::summary>& summaries) {
+    w.StartArray();
+    for (const auto& h : summaries) {
+        w.StartObject();
+        w.Key("name");
+        w.String(h.s.name.c_str());
+        w.Key("labels");
+        w.StartObject();
+        for (const auto& [k, v] : h.s.labels) {
+            w.Key(k.c_str());
+            w.String(v.c_str());
+        }
+        w.EndObject();
+        w.Key("count");
+        w.Uint64(h.count);
+        w.Key("p50_us");
+        w.Int64(h.p50);
+        w.Key("p90_us");
+        w.Int64(h.p90);
+        w.Key("p99_us");
+        w.Int64(h.p99);
+        w.Key("p999_us");
+        w.Int64(h.p999);
+        w.Key("max_us");
+        w.Int64(h.max);
+        w.EndObject();
+    }
+    w.EndArray();
+}
+} // namespace
+
+void application::admin_register_latency_routes(ss::http_server& server) {
+    ss::httpd::latency_json::get_latency.set(
+      server._routes, [this](std::unique_ptr<ss::httpd::request> req) {
+          using shard_summaries_t = std::vector<
+            std::pair<ss::shard_id, std::vector<node_histograms::summary>>>;
+          const bool per_shard = req->get_query_param("shards") == "true";
+          auto node = ss::smp::submit_to(0, [this] {
+              // not until the services are started
+              return _node_histograms ? _node_histograms->summaries()
+                                      : std::vector<node_histograms::summary>{};
+          });
+          auto shards = boost::irange(0u, per_shard ? ss::smp::count : 0u);
+          auto detail = ss::map_reduce(
+            shards.begin(),
+            shards.end(),
+            [](ss::shard_id shard) {
+                return ss::smp::submit_to(shard, [shard] {
+                    return std::make_pair(
+                      shard, node_histograms::shard_summaries());
+                });
+            },
+            shard_summaries_t{},
+            [](shard_summaries_t acc, shard_summaries_t::value_type s) {
+                acc.push_back(std::move(s));
+                return acc;
+            });
+          return ss::when_all_succeed(std::move(node), std::move(detail))
+            .then([per_shard](
+                    std::vector<node_histograms::summary> node,
+                    shard_summaries_t detail) {
+                std::sort(
+                  detail.begin(),
+                  detail.end(),
+                  [](const auto& a, const auto& b) {
+                      return a.first < b.first;
+                  });
+                rapidjson::StringBuffer buf;
+                rapidjson::Writer<rapidjson::StringBuffer> w(buf);
+                w.StartObject();
+                w.Key("node");
+                write_summaries(w, node);
+                if (per_shard) {
+                    w.Key("shards");
+                    w.StartArray();
+                    for (const auto& [shard, summaries] : detail) {
+                        w.StartObject();
+                        w.Key("shard");
+                        w.Uint(shard);
+                        w.Key("histograms");
+                        write_summaries(w, summaries);
+                        w.EndObject();
+                    }
+                    w.EndArray();
+                }
+                w.EndObject();
+                return ss::json::json_return_type(buf.GetString());
+            });
+      });
+}
+
+void application::admin_register_memory_routes(ss::http_server& server) {
+    ss::httpd::memory_json::get_memory.set(
+      server._routes, [](std::unique_ptr<ss::httpd::request>) {
+          struct shard_memory {
+              ss::shard_id shard;
+              size_t total;
+              size_t free;
+              std::array<size_t, memory_accounting::subsystem_count> held;
+          };
+          using shards_t = std::vector<shard_memory>;
+          auto shards = boost::irange(0u, ss::smp::count);
+          return ss::map_reduce(
+                   shards.begin(),
+                   shards.end(),
+                   [](ss::shard_id shard) {
+                       return ss::smp::submit_to(shard, [shard] {
+                           const auto stats = ss::memory::stats();
+                           shard_memory m{
+                             .shard = shard,
+                             .total = stats.total_memory(),
+                             .free = stats.free_memory(),
+                             .held = {}};
+                           for (size_t i = 0; i < m.held.size(); ++i) {
+                               m.held[i] = shard_memory_accounting().held(
+                                 memory_accounting::subsystem(i));
+                           }
+                           return m;
+                       });
+                   },
+                   shards_t{},
+                   [](shards_t acc, shard_memory m) {
+                       acc.push_back(m);
+                       return acc;
+                   })
+            .then([](shards_t shards) {
+                std::sort(
+                  shards.begin(),
+                  shards.end(),
+                  [](const shard_memory& a, const shard_memory& b) {
+                      return a.shard < b.shard;
+                  });
+                rapidjson::StringBuffer buf;
+                rapidjson::Writer<rapidjson::StringBuffer> w(buf);
+                w.StartObject();
+                w.Key("shards");
+                w.StartArray();
+                for (const auto& m : shards) {
+                    w.StartObject();
+                    w.Key("shard");
+                    w.Uint(m.shard);
+                    w.Key("total_bytes");
+                    w.Uint64(m.total);
+                    w.Key("free_bytes");
+                    w.Uint64(m.free);
+                    w.Key("subsystems");
+                    w.StartObject();
+                    for (size_t i = 0; i < m.held.size(); ++i) {
+                        const auto name = memory_accounting::name(
+                          memory_accounting::subsystem(i));
+                        w.Key(name.data(), name.size());
+                        w.Uint64(m.held[i]);
+                    }
+                    w.EndObject();
+                    w.EndObject();
+                }
+                w.EndArray();
+                w.EndObject();
+                return ss::json::json_return_type(buf.GetString());
+            });
+      });
+}
+
+void application::admin_register_failure_probe_routes(
+  ss::http_server& server) {
+    ss::httpd::failure_probes_json::get_failure_probes.set(
+      server._routes, [](std::unique_ptr<ss::httpd::request>) {
+          // every shard has the same probes
+          auto points = finjector::shard_local_badger().points();
+          std::map<ss::sstring, std::vector<ss::sstring>> sorted(
+            points.begin(), points.end());
+          rapidjson::StringBuffer buf;
+          rapidjson::Writer<rapidjson::StringBuffer> w(buf);
+          w.StartObject();
+          for (const auto& [module, module_points] : sorted) {
+              w.Key(module.c_str());
+              w.StartArray();
+              for (const auto& p : module_points) {
+                  w.String(p.c_str());
+              }
+              w.EndArray();
+          }
+          w.EndObject();
+          return ss::make_ready_future<ss::json::json_return_type>(
+            buf.GetString());
+      });
+
+    ss::httpd::failure_probes_json::set_failure_probe.set(
+      server._routes, [this](std::unique_ptr<ss::httpd::request> req) {
+          auto module = req->param["module"];
+          auto point = req->param["point"];
+          auto type = req->param["type"];
+          check_failure_probe(module, point);
+          if (type != "exception" && type != "delay" && type != "terminate") {
+              throw ss::httpd::bad_param_exception(fmt::format(
+                "Failure type must be exception, delay or terminate: {}",
+                type));
+          }
+          auto delay = finjector::probe::default_delay;
+          if (auto ms = req->get_query_param("ms"); !ms.empty()) {
+              try {
+                  delay = std::chrono::milliseconds(std::stoll(ms));
+              } catch (...) {
+                  throw ss::httpd::bad_param_exception(
+                    fmt::format("Delay must be an integer: {}", ms));
+              }
+              if (delay.count() < 0) {
+                  throw ss::httpd::bad_param_exception(
+                    fmt::format("Invalid delay {}ms", delay.count()));
+              }
+          }
+          vlog(
+            _log.info,
+            "Setting failure probe {} of {}-{}",
+            type,
+            module,
+            point);
+          return ss::smp::invoke_on_all([module, point, type, delay] {
+                     auto& badger = finjector::shard_local_badger();
+                     if (type == "exception") {
+                         badger.set_exception(module, point);
+                     } else if (type == "delay") {
+                         badger.set_delay(module, point, delay);
+                     } else {
+                         badger.set_termination(module, point);
+                     }
+                 })
+            .then([] {
+                return ss::json::json_return_type(ss::json::json_void());
+            });
+      });
+
+    ss::httpd::failure_probes_json::unset_failure_probe.set(
+      server._routes, [this](std::unique_ptr<ss::httpd::request> req) {
+          auto module = req->param["module"];
+          auto point = req->param["point"];
+          check_failure_probe(module, point);
+          vlog(_log.info, "Unsetting failure probe of {}-{}", module, point);
+          return ss::smp::invoke_on_all([module, point] {
+                     finjector::shard_local_badger().unset(module, point);
+                 })
+            .then([] {
+                return ss::json::json_return_type(ss::json::json_void());
+            });
+      });
+}
+
+void application::check_failure_probe(
+  const ss::sstring& module, const ss::sstring& point) {
+    auto points = finjector::shard_local_badger().points();
+    auto it = points.find(module);
+    if (
+      it == points.end()
+      || std::find(it->second.begin(), it->second.end(), point)
+           == it->second.end()) {
+        throw ss::httpd::not_found_exception(
+          fmt::format("Failure probe {}-{} not found", module, point));
+    }
 }
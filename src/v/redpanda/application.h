@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include "archival/service.h"
 #include "cluster/controller.h"
 #include "cluster/metadata_cache.h"
 #include "cluster/metadata_dissemination_service.h"
@@ -24,11 +25,16 @@
 #include "kafka/quota_manager.h"
 #include "raft/group_manager.h"
 #include "resource_mgmt/cpu_scheduling.h"
+#include "resource_mgmt/memory_accounting.h"
+#include "resource_mgmt/memory_governor.h"
 #include "resource_mgmt/memory_groups.h"
+#include "resource_mgmt/scheduling_shares_controller.h"
 #include "resource_mgmt/smp_groups.h"
 #include "rpc/server.h"
 #include "seastarx.h"
 #include "storage/api.h"
+#include "syschecks/disk_calibration.h"
+#include "utils/node_histograms.h"
 
 #include <seastar/core/app-template.hh>
 #include <seastar/core/metrics_registration.hh>
@@ -36,6 +42,10 @@
 #include <seastar/http/httpd.hh>
 #include <seastar/util/defer.hh>
 
+#include <chrono>
+#include <optional>
+#include <string_view>
+
 namespace po = boost::program_options; // NOLINT
 using group_router_type = kafka::group_router<kafka::group_manager>;
 
@@ -45,9 +55,15 @@ public:
 
     void initialize();
     void check_environment();
+    /// measures the disk of the data directory, unless it was measured by
+    /// an earlier start
+    void calibrate_disk();
     void configure_admin_server();
     void wire_up_services();
     void start();
+    /// \brief hands the leadership of the local raft groups over to their
+    /// followers, before the services stop on a planned shutdown
+    void drain_leadership();
 
     void shutdown() {
         while (!_deferred.empty()) {
@@ -61,6 +77,7 @@ public:
     ss::sharded<storage::api> storage;
     ss::sharded<coproc::router> router;
     ss::sharded<cluster::partition_manager> partition_manager;
+    ss::sharded<archival::service> archival_service;
     ss::sharded<raft::group_manager> raft_group_manager;
     ss::sharded<cluster::metadata_dissemination_service>
       md_dissemination_service;
@@ -77,8 +94,18 @@ private:
     void validate_arguments(const po::variables_map&);
     void hydrate_config(const po::variables_map&);
 
+    void admin_register_config_routes(ss::http_server& server);
     void admin_register_raft_routes(ss::http_server& server);
     void admin_register_kafka_routes(ss::http_server& server);
+    void admin_register_profiler_routes(ss::http_server& server);
+    void admin_register_latency_routes(ss::http_server& server);
+    void admin_register_memory_routes(ss::http_server& server);
+    void admin_register_failure_probe_routes(ss::http_server& server);
+    static void check_failure_probe(const ss::sstring&, const ss::sstring&);
+
+    bool archival_enabled() {
+        return config::shard_local_cfg().archival_enabled();
+    }
 
     bool coproc_enabled() {
         const auto& cfg = config::shard_local_cfg();
@@ -98,10 +125,22 @@ private:
         _deferred.emplace_back([&s] { s->stop().get(); });
     }
     void setup_metrics();
+    /// \brief hands the budgets of the servers and caches of the shard to
+    /// its memory governor
+    void add_memory_budgets(memory_governor&);
+    void sample_memory_accounting();
+    /// \brief logs how long a phase of the startup took, and exposes it as a
+    /// metric. Returns the end of the phase, the start of the next one
+    std::chrono::steady_clock::time_point record_startup_phase(
+      std::string_view, std::chrono::steady_clock::time_point);
     std::unique_ptr<ss::app_template> _app;
     scheduling_groups _scheduling_groups;
+    ss::sharded<scheduling_shares_controller> _shares_controller;
     smp_groups _smp_groups;
     ss::logger _log{"redpanda::main"};
+    std::optional<syschecks::disk_calibration> _disk_calibration;
+    /// on shard 0
+    std::unique_ptr<node_histograms> _node_histograms;
 
     ss::sharded<rpc::server> _coproc_rpc;
     ss::sharded<rpc::connection_cache> _raft_connection_cache;
@@ -110,6 +149,8 @@ private:
     ss::sharded<ss::http_server> _admin;
     ss::sharded<kafka::quota_manager> _quota_mgr;
     ss::sharded<rpc::server> _kafka_server;
+    ss::sharded<rpc::server> _kafka_shard_aware_server;
+    ss::sharded<memory_governor> _memory_governor;
     ss::metrics::metric_groups _metrics;
     // run these first on destruction
     deferred_actions _deferred;
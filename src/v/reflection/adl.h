@@ -14,13 +14,17 @@
 #include "bytes/iobuf.h"
 #include "bytes/iobuf_parser.h"
 #include "reflection/for_each_field.h"
+#include "reflection/to_tuple.h"
 #include "seastarx.h"
 #include "utils/named_type.h"
 
 #include <seastar/core/byteorder.hh>
 #include <seastar/core/sstring.hh>
 
+#include <bit>
+#include <chrono>
 #include <optional>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
@@ -53,9 +57,75 @@ struct is_ss_bool<ss::bool_class<T>> : std::true_type {};
 template<typename T>
 inline constexpr bool is_ss_bool_v = is_ss_bool<T>::value;
 
+template<typename T>
+struct adl;
+
+namespace detail {
+// only the primary adl template is known to encode types as below
+template<typename T, typename = void>
+struct has_generic_adl : std::false_type {};
+template<typename T>
+struct has_generic_adl<T, std::void_t<decltype(adl<T>::is_generic)>>
+  : std::true_type {};
+
+template<typename T>
+constexpr bool is_raw_encoded();
+
+template<typename... Fields>
+constexpr bool is_packed(std::tuple<Fields...>*, size_t size) {
+    return (is_raw_encoded<std::decay_t<Fields>>() && ...)
+           && (sizeof(std::decay_t<Fields>) + ... + 0) == size;
+}
+
+/// \brief whether the encoding of T is its object representation, so that
+/// it can be copied as is. holds for integers, enums, booleans, named types
+/// of those and the structs made only of them without any padding, on little
+/// endian hosts, as long as no adl specialization overrides them
+template<typename T>
+constexpr bool is_raw_encoded() {
+    using type = std::decay_t<T>;
+    if constexpr (std::endian::native != std::endian::little) {
+        return false;
+    } else if constexpr (is_named_type_v<type>) {
+        using value_type = typename type::type;
+        return sizeof(type) == sizeof(value_type)
+               && std::is_trivially_copyable_v<type>
+               && is_raw_encoded<value_type>() && has_generic_adl<type>::value;
+    } else if constexpr (std::is_integral_v<type> || std::is_enum_v<type>) {
+        return has_generic_adl<type>::value;
+    } else if constexpr (is_ss_bool_v<type>) {
+        return sizeof(type) == sizeof(int8_t) && has_generic_adl<type>::value;
+    } else if constexpr (std::is_same_v<type, std::chrono::milliseconds>) {
+        return sizeof(type) == sizeof(int64_t)
+               && has_generic_adl<type>::value;
+    } else if constexpr (
+      std::is_aggregate_v<type> && !std::is_array_v<type>
+      && std::is_standard_layout_v<type>
+      && std::is_trivially_copyable_v<type>) {
+        if constexpr (has_generic_adl<type>::value) {
+            using fields = decltype(to_tuple(std::declval<type&>()));
+            return is_packed(static_cast<fields*>(nullptr), sizeof(type));
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+}
+
+template<typename T>
+inline constexpr bool is_raw_encoded_v = is_raw_encoded<T>();
+
+// vector<bool> has no contiguous storage
+template<typename T>
+inline constexpr bool is_raw_vector_element_v
+  = is_raw_encoded_v<T> && !std::is_same_v<T, bool>;
+} // namespace detail
+
 template<typename T>
 struct adl {
     using type = std::remove_reference_t<std::decay_t<T>>;
+    static constexpr bool is_generic = true;
     static constexpr bool is_optional = is_std_optional_v<type>;
     static constexpr bool is_sstring = std::is_same_v<type, ss::sstring>;
     static constexpr bool is_vector = is_std_vector_v<type>;
@@ -98,6 +168,12 @@ struct adl {
             using value_type = typename type::value_type;
             int32_t n = in.consume_type<int32_t>();
             std::vector<value_type> ret;
+            if constexpr (detail::is_raw_vector_element_v<value_type>) {
+                ret.resize(n);
+                in.consume_to(
+                  n * sizeof(value_type), reinterpret_cast<char*>(ret.data()));
+                return ret;
+            }
             ret.reserve(n);
             while (n-- > 0) {
                 ret.push_back(adl<value_type>{}.from(in));
@@ -116,11 +192,35 @@ struct adl {
             return std::chrono::milliseconds(
               ss::le_to_cpu(in.consume_type<int64_t>()));
         } else if constexpr (is_standard_layout) {
-            T t;
-            reflection::for_each_field(t, [&in](auto& field) mutable {
-                field = std::move(
-                  adl<std::decay_t<decltype(field)>>{}.from(in));
+            type t;
+            if constexpr (detail::is_raw_encoded_v<type>) {
+                in.consume_to(sizeof(type), reinterpret_cast<char*>(&t));
+                return t;
+            }
+            // fields adjacent in memory and raw encoded are read at once
+            char* run = nullptr;
+            size_t run_size = 0;
+            auto flush = [&in, &run, &run_size] {
+                if (run_size > 0) {
+                    in.consume_to(run_size, run);
+                    run_size = 0;
+                }
+            };
+            reflection::for_each_field(t, [&](auto& field) mutable {
+                using field_t = std::decay_t<decltype(field)>;
+                if constexpr (detail::is_raw_encoded_v<field_t>) {
+                    auto p = reinterpret_cast<char*>(&field);
+                    if (run + run_size != p) {
+                        flush();
+                        run = p;
+                    }
+                    run_size += sizeof(field_t);
+                } else {
+                    flush();
+                    field = std::move(adl<field_t>{}.from(in));
+                }
             });
+            flush();
             return t;
         }
     }
@@ -149,6 +249,12 @@ struct adl {
         } else if constexpr (is_vector) {
             using value_type = typename type::value_type;
             adl<int32_t>{}.to(out, t.size());
+            if constexpr (detail::is_raw_vector_element_v<value_type>) {
+                out.append(
+                  reinterpret_cast<const char*>(t.data()),
+                  t.size() * sizeof(value_type));
+                return;
+            }
             for (value_type& i : t) {
                 adl<value_type>{}.to(out, std::move(i));
             }
@@ -170,15 +276,34 @@ struct adl {
             adl<int64_t>{}.to(out, t.count());
             return;
         } else if constexpr (is_standard_layout) {
-            /*
-            std::apply(
-              [&out](auto&&... args) {
-                  (adl<decltype(args)>{}.to(out, std::move(args)), ...);
-              },
-              reflection::to_tuple(t)); */
-            reflection::for_each_field(t, [&out](auto& field) {
-                adl<std::decay_t<decltype(field)>>{}.to(out, std::move(field));
+            if constexpr (detail::is_raw_encoded_v<type>) {
+                out.append(reinterpret_cast<const char*>(&t), sizeof(type));
+                return;
+            }
+            // fields adjacent in memory and raw encoded are appended at once
+            const char* run = nullptr;
+            size_t run_size = 0;
+            auto flush = [&out, &run, &run_size] {
+                if (run_size > 0) {
+                    out.append(run, run_size);
+                    run_size = 0;
+                }
+            };
+            reflection::for_each_field(t, [&](auto& field) {
+                using field_t = std::decay_t<decltype(field)>;
+                if constexpr (detail::is_raw_encoded_v<field_t>) {
+                    auto p = reinterpret_cast<const char*>(&field);
+                    if (run + run_size != p) {
+                        flush();
+                        run = p;
+                    }
+                    run_size += sizeof(field_t);
+                } else {
+                    flush();
+                    adl<field_t>{}.to(out, std::move(field));
+                }
             });
+            flush();
             return;
         }
     }
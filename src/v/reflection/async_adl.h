@@ -33,6 +33,11 @@ struct async_adl<std::vector<T>> {
     using value_type = std::remove_reference_t<std::decay_t<T>>;
 
     ss::future<> to(iobuf& out, std::vector<value_type> t) {
+        if constexpr (detail::is_raw_vector_element_v<value_type>) {
+            // a single copy, no need to yield
+            adl<std::vector<value_type>>{}.to(out, std::move(t));
+            return ss::make_ready_future<>();
+        }
         reflection::serialize<int32_t>(out, t.size());
         return ss::do_with(std::move(t), [&out](auto& t) {
             return ss::do_for_each(t, [&out](value_type& element) {
@@ -42,6 +47,10 @@ struct async_adl<std::vector<T>> {
     }
 
     ss::future<std::vector<value_type>> from(iobuf_parser& in) {
+        if constexpr (detail::is_raw_vector_element_v<value_type>) {
+            return ss::make_ready_future<std::vector<value_type>>(
+              adl<std::vector<value_type>>{}.from(in));
+        }
         const auto size = adl<int32_t>{}.from(in);
         return ssx::async_transform(
           boost::irange<size_t>(0, size),
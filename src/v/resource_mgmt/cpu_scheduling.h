@@ -21,37 +21,81 @@
 // and any shard that needs to schedule continuations into a given group.
 class scheduling_groups final {
 public:
+    // shares the groups are created with
+    static constexpr float admin_shares = 100;
+    static constexpr float raft_shares = 1000;
+    static constexpr float kafka_shares = 1000;
+    // the group and coordinator requests of the consumers, ahead of the
+    // produce and fetch requests, see kafka::protocol
+    static constexpr float kafka_control_shares = 2000;
+    static constexpr float cluster_shares = 300;
+    static constexpr float coproc_shares = 100;
+    static constexpr float compaction_shares = 100;
+    static constexpr float compression_shares = 100;
+
     ss::future<> create_groups() {
-        return ss::create_scheduling_group("admin", 100)
+        return ss::create_scheduling_group("admin", admin_shares)
           .then([this](ss::scheduling_group sg) { _admin = sg; })
-          .then([] { return ss::create_scheduling_group("raft", 1000); })
+          .then([] {
+              return ss::create_scheduling_group("raft", raft_shares);
+          })
           .then([this](ss::scheduling_group sg) { _raft = sg; })
-          .then([] { return ss::create_scheduling_group("kafka", 1000); })
+          .then([] {
+              return ss::create_scheduling_group("kafka", kafka_shares);
+          })
           .then([this](ss::scheduling_group sg) { _kafka = sg; })
-          .then([] { return ss::create_scheduling_group("cluster", 300); })
+          .then([] {
+              return ss::create_scheduling_group(
+                "kafka_control", kafka_control_shares);
+          })
+          .then([this](ss::scheduling_group sg) { _kafka_control = sg; })
+          .then([] {
+              return ss::create_scheduling_group("cluster", cluster_shares);
+          })
           .then([this](ss::scheduling_group sg) { _cluster = sg; })
-          .then([] { return ss::create_scheduling_group("coproc", 100); })
-          .then([this](ss::scheduling_group sg) { _coproc = sg; });
+          .then([] {
+              return ss::create_scheduling_group("coproc", coproc_shares);
+          })
+          .then([this](ss::scheduling_group sg) { _coproc = sg; })
+          .then([] {
+              return ss::create_scheduling_group(
+                "compaction", compaction_shares);
+          })
+          .then([this](ss::scheduling_group sg) { _compaction = sg; })
+          .then([] {
+              return ss::create_scheduling_group(
+                "compression", compression_shares);
+          })
+          .then([this](ss::scheduling_group sg) { _compression = sg; });
     }
 
     ss::future<> destroy_groups() {
         return destroy_scheduling_group(_admin)
           .then([this] { return destroy_scheduling_group(_raft); })
           .then([this] { return destroy_scheduling_group(_kafka); })
+          .then([this] { return destroy_scheduling_group(_kafka_control); })
           .then([this] { return destroy_scheduling_group(_cluster); })
-          .then([this] { return destroy_scheduling_group(_coproc); });
+          .then([this] { return destroy_scheduling_group(_coproc); })
+          .then([this] { return destroy_scheduling_group(_compaction); })
+          .then([this] { return destroy_scheduling_group(_compression); });
     }
 
     ss::scheduling_group admin_sg() { return _admin; }
     ss::scheduling_group raft_sg() { return _raft; }
     ss::scheduling_group kafka_sg() { return _kafka; }
+    ss::scheduling_group kafka_control_sg() { return _kafka_control; }
     ss::scheduling_group cluster_sg() { return _cluster; }
     ss::scheduling_group coproc_sg() { return _coproc; }
+    ss::scheduling_group compaction_sg() { return _compaction; }
+    ss::scheduling_group compression_sg() { return _compression; }
 
 private:
     ss::scheduling_group _admin;
     ss::scheduling_group _raft;
     ss::scheduling_group _kafka;
+    ss::scheduling_group _kafka_control;
     ss::scheduling_group _cluster;
     ss::scheduling_group _coproc;
+    ss::scheduling_group _compaction;
+    ss::scheduling_group _compression;
 };
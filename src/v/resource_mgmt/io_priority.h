@@ -23,6 +23,10 @@ public:
     ss::io_priority_class controller_priority() { return _controller_priority; }
     ss::io_priority_class kafka_read_priority() { return _kafka_read_priority; }
     ss::io_priority_class compaction_priority() { return _compaction_priority; }
+    ss::io_priority_class raft_recovery_priority() {
+        return _raft_recovery_priority;
+    }
+    ss::io_priority_class scrub_priority() { return _scrub_priority; }
 
     static priority_manager& local() {
         static thread_local priority_manager pm = priority_manager();
@@ -37,12 +41,18 @@ private:
       , _kafka_read_priority(
           ss::engine().register_one_priority_class("kafka_read", 200))
       , _compaction_priority(
-          ss::engine().register_one_priority_class("compaction", 200)) {}
+          ss::engine().register_one_priority_class("compaction", 200))
+      , _raft_recovery_priority(
+          ss::engine().register_one_priority_class("raft_recovery", 200))
+      , _scrub_priority(
+          ss::engine().register_one_priority_class("scrub", 50)) {}
 
     ss::io_priority_class _raft_priority;
     ss::io_priority_class _controller_priority;
     ss::io_priority_class _kafka_read_priority;
     ss::io_priority_class _compaction_priority;
+    ss::io_priority_class _raft_recovery_priority;
+    ss::io_priority_class _scrub_priority;
 };
 
 inline ss::io_priority_class raft_priority() {
@@ -60,3 +70,11 @@ inline ss::io_priority_class kafka_read_priority() {
 inline ss::io_priority_class compaction_priority() {
     return priority_manager::local().compaction_priority();
 }
+
+inline ss::io_priority_class raft_recovery_priority() {
+    return priority_manager::local().raft_recovery_priority();
+}
+
+inline ss::io_priority_class scrub_priority() {
+    return priority_manager::local().scrub_priority();
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "config/configuration.h"
+#include "seastarx.h"
+
+#include <seastar/core/metrics.hh>
+#include <seastar/core/metrics_registration.hh>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <utility>
+
+// memory held by the subsystems of a shard.
+//
+// the subsystems which already keep track of their memory, like the caches
+// and the servers bounded by a semaphore, are sampled from their own counts.
+// the others count the memory they hold where they reserve and release it,
+// with a tracked_memory. the counts are those of the payloads, without the
+// containers holding them, so that they are a lower bound on the memory held.
+class memory_accounting {
+public:
+    enum class subsystem : uint8_t {
+        batch_cache,
+        chunk_cache,
+        kafka_requests,
+        rpc_requests,
+        raft_batcher,
+        group_offsets,
+        compaction_index,
+    };
+    static constexpr size_t subsystem_count = 7;
+
+    static constexpr std::string_view name(subsystem s) {
+        switch (s) {
+        case subsystem::batch_cache:
+            return "batch_cache";
+        case subsystem::chunk_cache:
+            return "chunk_cache";
+        case subsystem::kafka_requests:
+            return "kafka_requests";
+        case subsystem::rpc_requests:
+            return "rpc_requests";
+        case subsystem::raft_batcher:
+            return "raft_batcher";
+        case subsystem::group_offsets:
+            return "group_offsets";
+        case subsystem::compaction_index:
+            return "compaction_index";
+        }
+        return "unknown";
+    }
+
+    void reserve(subsystem s, size_t n) { _counted[index(s)] += n; }
+    void release(subsystem s, size_t n) { _counted[index(s)] -= n; }
+
+    // samples the memory of the subsystem instead of counting it. an empty
+    // function goes back to counting, e.g. when the sampled service stops.
+    void sample(subsystem s, std::function<size_t()> f) {
+        _sampled[index(s)] = std::move(f);
+    }
+
+    size_t held(subsystem s) const {
+        const auto i = index(s);
+        if (_sampled[i]) {
+            return _sampled[i]();
+        }
+        return size_t(std::max<int64_t>(_counted[i], 0));
+    }
+
+    void setup_metrics() {
+        if (config::shard_local_cfg().disable_metrics()) {
+            return;
+        }
+        namespace sm = ss::metrics;
+        for (size_t i = 0; i < subsystem_count; ++i) {
+            const auto s = subsystem(i);
+            _metrics.add_group(
+              "memory_accounting",
+              {sm::make_gauge(
+                "held_bytes",
+                [this, s] { return held(s); },
+                sm::description("Memory held by a subsystem of the shard"),
+                {sm::label("subsystem")(ss::sstring(name(s)))})});
+        }
+    }
+
+    // stops sampling and exporting, before the sampled services stop
+    void reset() {
+        _sampled = {};
+        _metrics.clear();
+    }
+
+private:
+    static constexpr size_t index(subsystem s) { return size_t(s); }
+
+    std::array<int64_t, subsystem_count> _counted{};
+    std::array<std::function<size_t()>, subsystem_count> _sampled;
+    ss::metrics::metric_groups _metrics;
+};
+
+inline memory_accounting& shard_memory_accounting() {
+    static thread_local memory_accounting accounting;
+    return accounting;
+}
+
+// memory counted against a subsystem of the shard for as long as it lives.
+// it moves along with the memory it counts, and a copy counts it again.
+class tracked_memory {
+public:
+    using subsystem = memory_accounting::subsystem;
+
+    explicit tracked_memory(subsystem s) noexcept
+      : _subsystem(s) {}
+    tracked_memory(const tracked_memory& o)
+      : _subsystem(o._subsystem) {
+        add(o._bytes);
+    }
+    tracked_memory(tracked_memory&& o) noexcept
+      : _subsystem(o._subsystem)
+      , _bytes(std::exchange(o._bytes, 0)) {}
+    tracked_memory& operator=(const tracked_memory& o) {
+        if (this != &o) {
+            set(0);
+            _subsystem = o._subsystem;
+            set(o._bytes);
+        }
+        return *this;
+    }
+    tracked_memory& operator=(tracked_memory&& o) noexcept {
+        if (this != &o) {
+            set(0);
+            _subsystem = o._subsystem;
+            _bytes = std::exchange(o._bytes, 0);
+        }
+        return *this;
+    }
+    ~tracked_memory() noexcept { set(0); }
+
+    void add(size_t n) {
+        _bytes += n;
+        shard_memory_accounting().reserve(_subsystem, n);
+    }
+    void sub(size_t n) {
+        _bytes -= n;
+        shard_memory_accounting().release(_subsystem, n);
+    }
+    void set(size_t n) {
+        if (n > _bytes) {
+            add(n - _bytes);
+        } else {
+            sub(_bytes - n);
+        }
+    }
+
+    size_t bytes() const { return _bytes; }
+
+private:
+    subsystem _subsystem;
+    size_t _bytes{0};
+};
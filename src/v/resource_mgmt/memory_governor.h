@@ -0,0 +1,168 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "config/configuration.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/metrics.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/core/timer.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// moves memory between the budgets of the consumers of a shard, by demand.
+//
+// the budgets start at the static split of memory_groups, and their sum stays
+// the same. every memory_governor_interval_ms, each budget that was starved
+// since the last round, e.g. requests waited for memory or the cache was
+// reclaimed, takes a step of memory from the budget that uses the smallest
+// share of its own. a budget gives memory only while it uses less than half of
+// it and stays above its floor, and takes memory up to its ceiling.
+//
+// the budgets of the kafka server, the rpc server and the chunk cache bound
+// their consumers. the batch cache has no bound and is only shrunk by the
+// low-memory reclaimer, so its budget is memory kept away from the others.
+class memory_governor {
+public:
+    struct budget {
+        ss::sstring name;
+        size_t floor;
+        size_t ceiling;
+        size_t initial;
+        // memory in use
+        std::function<size_t()> used;
+        // whether the consumer was starved since the last call
+        std::function<bool()> starved;
+        // applies a new budget to the consumer
+        std::function<void(size_t)> resize;
+    };
+
+    // starved whenever a counter of waits grew since the last call
+    static std::function<bool()>
+    counter_grew(std::function<uint64_t()> counter) {
+        auto last = counter();
+        return [counter = std::move(counter), last]() mutable {
+            auto current = counter();
+            return std::exchange(last, current) != current;
+        };
+    }
+
+    memory_governor()
+      : _interval(config::shard_local_cfg().memory_governor_interval_ms()) {
+        _timer.set_callback([this] { rebalance(); });
+    }
+
+    void add(budget b) {
+        auto size = b.initial;
+        _budgets.push_back(budget_state{.cfg = std::move(b), .size = size});
+    }
+
+    ss::future<> start() {
+        if (_interval == std::chrono::milliseconds::zero()) {
+            return ss::now();
+        }
+        if (!config::shard_local_cfg().disable_metrics()) {
+            setup_metrics();
+        }
+        _timer.arm_periodic(_interval);
+        return ss::now();
+    }
+
+    ss::future<> stop() {
+        _timer.cancel();
+        return ss::now();
+    }
+
+private:
+    struct budget_state {
+        budget cfg;
+        size_t size;
+
+        double usage() const {
+            return size == 0 ? 1.0 : double(cfg.used()) / double(size);
+        }
+        // memory it can give, while keeping twice what it uses
+        size_t spare() const {
+            auto keep = std::max(cfg.floor, 2 * cfg.used());
+            return size > keep ? size - keep : 0;
+        }
+    };
+
+    size_t step() const {
+        size_t total = 0;
+        for (auto& b : _budgets) {
+            total += b.size;
+        }
+        return total / steps;
+    }
+
+    void rebalance() {
+        std::vector<budget_state*> starved;
+        for (auto& b : _budgets) {
+            // polled every round, to reset the demand of the round
+            if (b.cfg.starved() && b.size < b.cfg.ceiling) {
+                starved.push_back(&b);
+            }
+        }
+        const auto step_size = step();
+        for (auto* to : starved) {
+            budget_state* from = nullptr;
+            for (auto& b : _budgets) {
+                if (
+                  &b != to && b.spare() > 0
+                  && std::find(starved.begin(), starved.end(), &b)
+                       == starved.end()
+                  && (!from || b.usage() < from->usage())) {
+                    from = &b;
+                }
+            }
+            if (!from) {
+                return;
+            }
+            auto moved = std::min(
+              {step_size, from->spare(), to->cfg.ceiling - to->size});
+            from->size -= moved;
+            to->size += moved;
+            from->cfg.resize(from->size);
+            to->cfg.resize(to->size);
+        }
+    }
+
+    void setup_metrics() {
+        namespace sm = ss::metrics;
+        for (auto& b : _budgets) {
+            _metrics.add_group(
+              "memory_governor",
+              {sm::make_gauge(
+                "budget_bytes",
+                [&b] { return b.size; },
+                sm::description("Memory budget set by the memory governor"),
+                {sm::label("consumer")(b.cfg.name)})});
+        }
+    }
+
+    // a step is this fraction of the governed memory
+    static constexpr size_t steps = 16;
+
+    std::chrono::milliseconds _interval;
+    std::vector<budget_state> _budgets;
+    ss::timer<> _timer;
+    ss::metrics::metric_groups _metrics;
+};
@@ -21,6 +21,10 @@ struct memory_groups {
         // 30%
         return ss::memory::stats().total_memory() * .30;
     }
+    /// \brief fetch responses held until written, on top of the requests
+    static size_t kafka_fetch_memory() {
+        return ss::memory::stats().total_memory() * .10; // NOLINT
+    }
     /// \brief includes raft & all services
     static size_t rpc_total_memory() {
         // 30%
@@ -28,11 +32,9 @@ struct memory_groups {
     }
 
     /**
-     * The target allocation size for the chunk cache. This is a soft target,
-     * and may be expanded as needed by segment appenders, or reclaimed from by
-     * seastar under memory pressure.
-     *
-     * add upper bound of 30 pct of memory as a hard outstanding limit.
+     * The memory of the chunks allocated by the chunk cache at startup. The
+     * cache grows past it as needed by segment appenders, and frees the chunks
+     * left idle, so that it is a warm start rather than a reservation.
      */
     static size_t chunk_cache_min_memory() {
         return ss::memory::stats().total_memory() * .10; // NOLINT
@@ -46,4 +48,32 @@ struct memory_groups {
     static size_t chunk_cache_max_memory() {
         return ss::memory::stats().total_memory() * .30; // NOLINT
     }
+
+    /**
+     * Bounds of the budgets the memory governor moves between the kafka
+     * server, the rpc server, the chunk cache and the batch cache. The chunk
+     * cache is bounded by its min and max memory above. The batch cache starts
+     * without a budget of its own, and uses what the others leave.
+     */
+    static size_t kafka_min_memory() {
+        return ss::memory::stats().total_memory() * .10; // NOLINT
+    }
+    static size_t kafka_max_memory() {
+        return ss::memory::stats().total_memory() * .50; // NOLINT
+    }
+    static size_t rpc_min_memory() {
+        return ss::memory::stats().total_memory() * .10; // NOLINT
+    }
+    static size_t rpc_max_memory() {
+        return ss::memory::stats().total_memory() * .50; // NOLINT
+    }
+    static size_t batch_cache_max_memory() {
+        return ss::memory::stats().total_memory() * .50; // NOLINT
+    }
+
+    /// \brief the logs of the in-memory topics, outside of the budgets of
+    /// the memory governor
+    static size_t memory_log_memory() {
+        return ss::memory::stats().total_memory() * .10; // NOLINT
+    }
 };
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "config/configuration.h"
+#include "seastarx.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/scheduling.hh>
+#include <seastar/core/timer.hh>
+#include <seastar/core/with_scheduling_group.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+// adjusts the shares of the scheduling groups of a shard to their load.
+//
+// every scheduling_shares_adjust_ms, the latency of the task queue of each
+// group is measured as the time a task submitted to the group waits before it
+// runs. the shares of a group with a latency target are doubled while its
+// latency is over the target, up to max_boost times the shares it was created
+// with, and halved back down once its latency is under half of the target.
+// this keeps raft heartbeats running when produce requests overload the kafka
+// group, instead of letting them time out into elections.
+//
+// the reactor exports the runtime and queue length of every group already,
+// the measured latency and the shares set here are exported next to them.
+class scheduling_shares_controller {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr float max_boost = 8;
+
+    struct group {
+        ss::scheduling_group sg;
+        // shares the group was created with
+        float shares;
+        std::optional<clock::duration> latency_target;
+    };
+
+    explicit scheduling_shares_controller(std::vector<group> groups)
+      : _interval(config::shard_local_cfg().scheduling_shares_adjust_ms()) {
+        _groups.reserve(groups.size());
+        for (auto& g : groups) {
+            _groups.push_back(group_state{.cfg = g, .shares = g.shares});
+        }
+        _timer.set_callback([this] { adjust_in_background(); });
+    }
+
+    ss::future<> start() {
+        if (_interval == clock::duration::zero()) {
+            return ss::now();
+        }
+        if (!config::shard_local_cfg().disable_metrics()) {
+            setup_metrics();
+        }
+        _timer.arm(_interval);
+        return ss::now();
+    }
+
+    ss::future<> stop() {
+        _timer.cancel();
+        return _gate.close();
+    }
+
+private:
+    struct group_state {
+        group cfg;
+        float shares;
+        clock::duration latency{0};
+    };
+
+    void adjust_in_background() {
+        (void)ss::with_gate(_gate, [this] {
+            return measure().then([this] {
+                adjust();
+                if (!_gate.is_closed()) {
+                    _timer.arm(_interval);
+                }
+            });
+        });
+    }
+
+    ss::future<> measure() {
+        return ss::parallel_for_each(_groups, [](group_state& g) {
+            auto submitted = clock::now();
+            return ss::with_scheduling_group(
+                     g.cfg.sg, [submitted] { return clock::now() - submitted; })
+              .then([&g](clock::duration latency) { g.latency = latency; });
+        });
+    }
+
+    void adjust() {
+        for (auto& g : _groups) {
+            if (!g.cfg.latency_target) {
+                continue;
+            }
+            auto target = *g.cfg.latency_target;
+            auto shares = g.shares;
+            if (g.latency > target) {
+                shares = std::min(shares * 2, g.cfg.shares * max_boost);
+            } else if (g.latency < target / 2) {
+                shares = std::max(shares / 2, g.cfg.shares);
+            }
+            if (shares != g.shares) {
+                g.shares = shares;
+                g.cfg.sg.set_shares(shares);
+            }
+        }
+    }
+
+    void setup_metrics() {
+        namespace sm = ss::metrics;
+        for (auto& g : _groups) {
+            std::vector<sm::label_instance> labels = {
+              sm::label("group")(g.cfg.sg.name())};
+            _metrics.add_group(
+              "scheduling_groups",
+              {sm::make_gauge(
+                 "shares",
+                 [&g] { return g.shares; },
+                 sm::description("Shares set by the shares controller"),
+                 labels),
+               sm::make_gauge(
+                 "queue_latency_us",
+                 [&g] {
+                     return std::chrono::duration_cast<
+                              std::chrono::microseconds>(g.latency)
+                       .count();
+                 },
+                 sm::description(
+                   "Time the last probe task waited in the queue of the group"),
+                 labels)});
+        }
+    }
+
+    clock::duration _interval;
+    std::vector<group_state> _groups;
+    ss::timer<> _timer;
+    ss::gate _gate;
+    ss::metrics::metric_groups _metrics;
+};
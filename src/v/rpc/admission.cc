@@ -0,0 +1,50 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "rpc/admission.h"
+
+#include "rpc/logger.h"
+#include "vlog.h"
+
+namespace rpc {
+
+method_admission::method_admission(
+  size_t max_in_flight,
+  clock_type::duration queue_time_target,
+  method_probe& probe)
+  : _slots(max_in_flight ? max_in_flight : ss::semaphore::max_counter())
+  , _target(queue_time_target)
+  , _probe(probe) {}
+
+ss::future<ss::semaphore_units<>> method_admission::enqueue() {
+    ++_queued;
+    return ss::get_units(_slots, 1);
+}
+
+void method_admission::started(
+  clock_type::duration queue_time, clock_type::time_point now) {
+    --_queued;
+    _probe.queued_for(queue_time);
+    if (_target == clock_type::duration::zero() || queue_time <= _target) {
+        _above_target_since = std::nullopt;
+        if (_shedding) {
+            vlog(rpclog.info, "rpc method {} no longer overloaded", _probe);
+        }
+        _shedding = false;
+        return;
+    }
+    if (!_above_target_since) {
+        _above_target_since = now;
+    } else if (!_shedding && now - *_above_target_since >= shedding_interval) {
+        vlog(rpclog.warn, "rpc method {} overloaded, shedding load", _probe);
+        _shedding = true;
+    }
+}
+
+} // namespace rpc
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "rpc/server_probe.h"
+#include "seastarx.h"
+
+#include <seastar/core/semaphore.hh>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace rpc {
+
+/**
+ * Admission of the requests of a single method on a server.
+ *
+ * The requests of a method in flight, i.e. past admission and until their
+ * reply was sent, are capped so that a flood of one method cannot take all
+ * the memory of the server from the others. A request waits for a slot and
+ * for its memory before its handler starts, and that wait is its queue time.
+ *
+ * Once the queue time of the method stayed above the target for a whole
+ * interval, the method is overloaded: requests arriving while others are
+ * still queued are rejected right away instead of waiting, so that the
+ * connection keeps flowing for the other methods. A single request is let
+ * through at a time to sample the queue time, and the first one that starts
+ * within the target ends the overload.
+ */
+class method_admission {
+public:
+    using clock_type = std::chrono::steady_clock;
+    /// how long the queue time must stay above its target to shed requests
+    static constexpr clock_type::duration shedding_interval
+      = std::chrono::milliseconds(100);
+
+    /// a zero max_in_flight does not cap the requests, a zero target never
+    /// sheds them
+    method_admission(
+      size_t max_in_flight,
+      clock_type::duration queue_time_target,
+      method_probe& probe);
+
+    /// \brief whether a request arriving now should be rejected
+    bool should_reject() const { return _shedding && _queued > 0; }
+    void rejected() { _probe.rejected(); }
+
+    /// \brief queues an admitted request, the units are its slot in flight
+    ss::future<ss::semaphore_units<>> enqueue();
+    /// the handler of a queued request started after waiting `queue_time`
+    void started(
+      clock_type::duration queue_time,
+      clock_type::time_point now = clock_type::now());
+    /// a queued request failed before its handler started
+    void dequeued() { --_queued; }
+
+    bool shedding() const { return _shedding; }
+    size_t queued() const { return _queued; }
+    method_probe& probe() { return _probe; }
+
+private:
+    ss::semaphore _slots;
+    clock_type::duration _target;
+    size_t _queued{0};
+    bool _shedding{false};
+    // start of the current run of queue times above the target
+    std::optional<clock_type::time_point> _above_target_since;
+    method_probe& _probe;
+};
+
+} // namespace rpc
@@ -31,6 +31,9 @@ public:
 
         virtual void reset() = 0;
 
+        /// a policy with the same parameters in its initial state
+        virtual std::unique_ptr<impl> clone() const = 0;
+
         virtual ~impl() noexcept = default;
     };
 
@@ -45,6 +48,8 @@ public:
 
     void reset() { _impl->reset(); }
 
+    backoff_policy clone() const { return backoff_policy(_impl->clone()); }
+
 private:
     std::unique_ptr<impl> _impl;
 };
@@ -77,6 +82,10 @@ backoff_policy make_exponential_backoff_policy(
 
         void reset() final { _current = 0; }
 
+        std::unique_ptr<backoff_policy::impl> clone() const final {
+            return std::make_unique<policy>(_base_duration, _max_backoff);
+        }
+
     private:
         DurationType _base_duration;
         DurationType _max_backoff;
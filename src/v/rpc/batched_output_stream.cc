@@ -12,16 +12,28 @@
 #include "likely.h"
 
 #include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
 #include <seastar/core/scattered_message.hh>
 
 #include <fmt/format.h>
 
+#include <algorithm>
+
 namespace rpc {
 batched_output_stream::batched_output_stream(
-  ss::output_stream<char> o, size_t cache)
+  ss::output_stream<char> o,
+  size_t cache,
+  std::chrono::microseconds cork_window,
+  output_stream_stats* stats,
+  size_t coalesce_size)
   : _out(std::move(o))
   , _cache_size(cache)
-  , _write_sem(std::make_unique<ss::semaphore>(1)) {}
+  , _write_sem(std::make_unique<ss::semaphore>(1))
+  , _cork_window(cork_window)
+  , _stats(stats)
+  , _coalesce_size(coalesce_size)
+  , _cork_timer([this] { flush_corked(); })
+  , _cork_gate(std::make_unique<ss::gate>()) {}
 
 [[gnu::cold]] static ss::future<>
 already_closed_error(ss::scattered_message<char>& msg) {
@@ -34,28 +46,122 @@ ss::future<> batched_output_stream::write(ss::scattered_message<char> msg) {
     if (unlikely(_closed)) {
         return already_closed_error(msg);
     }
+    auto m = _coalesce_size > 0 ? coalesce(std::move(msg)) : std::move(msg);
     return ss::with_semaphore(
-      *_write_sem, 1, [this, v = std::move(msg)]() mutable {
-          if (unlikely(_closed)) {
-              return already_closed_error(v);
-          }
-          const size_t vbytes = v.size();
-          return _out.write(std::move(v)).then([this, vbytes] {
-              _unflushed_bytes += vbytes;
-              if (
-                _write_sem->waiters() == 0 || _unflushed_bytes >= _cache_size) {
-                  return do_flush();
-              }
-              return ss::make_ready_future<>();
-          });
-      });
+             *_write_sem,
+             1,
+             [this, v = std::move(m)]() mutable {
+                 if (unlikely(_closed)) {
+                     return already_closed_error(v);
+                 }
+                 const size_t vbytes = v.size();
+                 return _out.write(std::move(v)).then([this, vbytes] {
+                     _unflushed_bytes += vbytes;
+                     if (_unflushed_bytes >= _cache_size) {
+                         return do_flush();
+                     }
+                     if (
+                       _write_sem->waiters() == 0
+                       && _cork_window == std::chrono::microseconds(0)) {
+                         return do_flush();
+                     }
+                     return ss::make_ready_future<>();
+                 });
+             })
+      .then([this] { return wait_corked_flush(); });
+}
+
+ss::scattered_message<char>
+batched_output_stream::coalesce(ss::scattered_message<char> msg) {
+    auto p = std::move(msg).release();
+    ss::scattered_message<char> out;
+    ss::temporary_buffer<char> run;
+    size_t used = 0;
+    auto append_run = [&out, &run, &used] {
+        if (used > 0) {
+            run.trim(used);
+            out.append(std::move(run));
+            run = {};
+            used = 0;
+        }
+    };
+    for (auto& f : p.fragments()) {
+        if (f.size >= _coalesce_size) {
+            append_run();
+            out.append_static(f.base, f.size);
+            continue;
+        }
+        if (_stats) {
+            ++_stats->coalesced_fragments;
+        }
+        size_t copied = 0;
+        while (copied < f.size) {
+            if (run.empty()) {
+                run = ss::temporary_buffer<char>(_coalesce_size);
+            }
+            const auto n = std::min(f.size - copied, run.size() - used);
+            std::copy_n(f.base + copied, n, run.get_write() + used);
+            copied += n;
+            used += n;
+            if (used == run.size()) {
+                append_run();
+            }
+        }
+    }
+    append_run();
+    // the fragments passed through are still those of the message
+    out.on_delete([p = std::move(p)] {});
+    return out;
 }
+
+ss::future<> batched_output_stream::wait_corked_flush() {
+    if (_cork_window == std::chrono::microseconds(0) || _unflushed_bytes == 0) {
+        return ss::make_ready_future<>();
+    }
+    // the first corked write opens the window
+    if (!_corked) {
+        _corked.emplace();
+        _cork_timer.arm(_cork_window);
+    }
+    if (_stats) {
+        ++_stats->corked_writes;
+    }
+    return _corked->get_shared_future();
+}
+
+void batched_output_stream::flush_corked() {
+    // errors are reported to the corked writes by do_flush()
+    (void)ss::with_gate(*_cork_gate, [this] { return flush(); })
+      .handle_exception([](const std::exception_ptr&) {});
+}
+
 ss::future<> batched_output_stream::do_flush() {
+    auto corked = std::exchange(_corked, std::nullopt);
+    _cork_timer.cancel();
     if (_unflushed_bytes == 0) {
+        if (corked) {
+            corked->set_value();
+        }
         return ss::make_ready_future<>();
     }
+    if (_stats) {
+        ++_stats->flushes;
+        _stats->flushed_bytes += _unflushed_bytes;
+    }
     _unflushed_bytes = 0;
-    return _out.flush();
+    return _out.flush().then_wrapped(
+      [corked = std::move(corked)](ss::future<> f) mutable {
+          if (!corked) {
+              return f;
+          }
+          if (f.failed()) {
+              auto e = f.get_exception();
+              corked->set_exception(e);
+              return ss::make_exception_future<>(e);
+          }
+          corked->set_value();
+          return ss::make_ready_future<>();
+      });
 }
 ss::future<> batched_output_stream::flush() {
     return ss::with_semaphore(*_write_sem, 1, [this] { return do_flush(); });
@@ -65,9 +171,16 @@ ss::future<> batched_output_stream::stop() {
         return ss::make_ready_future<>();
     }
     _closed = true;
-    return ss::with_semaphore(*_write_sem, 1, [this] {
-        return do_flush().then([this] { return _out.close(); });
-    });
+    return ss::with_semaphore(
+             *_write_sem,
+             1,
+             [this] {
+                 return do_flush().then([this] { return _out.close(); });
+             })
+      .finally([this] {
+          _cork_timer.cancel();
+          return _cork_gate ? _cork_gate->close() : ss::now();
+      });
 }
 
 } // namespace rpc
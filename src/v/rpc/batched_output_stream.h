@@ -13,21 +13,57 @@
 
 #include "seastarx.h"
 
+#include <seastar/core/gate.hh>
 #include <seastar/core/iostream.hh>
+#include <seastar/core/scattered_message.hh>
 #include <seastar/core/semaphore.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/timer.hh>
 
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <optional>
 
 namespace rpc {
 
+/// flush accounting of batched output streams, owned by a probe
+struct output_stream_stats {
+    uint64_t flushes{0};
+    uint64_t flushed_bytes{0};
+    // writes whose flush was delayed by the cork window
+    uint64_t corked_writes{0};
+    // small fragments copied together before their write
+    uint64_t coalesced_fragments{0};
+};
+
 /// \brief batch operations for zero copy interface of an output_stream<char>
+///
+/// Writes are flushed once no other write is waiting for the stream or the
+/// unflushed bytes reach the cache size. With a non zero cork window, the
+/// last writer does not flush right away either: the flush is delayed until
+/// the window expires so that writes of other senders arriving meanwhile are
+/// sent with the same syscall. Writes still resolve only once their data is
+/// flushed.
+///
+/// With a coalesce size, the fragments of a write smaller than it are copied
+/// together into buffers of that size. TLS streams encrypt every fragment
+/// into records of their own, so that the many small fragments of a reply
+/// would pay the framing, the authentication tag and the cipher setup of a
+/// record each.
 class batched_output_stream {
 public:
     static constexpr size_t default_max_unflushed_bytes = 1024 * 1024;
+    /// the largest payload of a TLS record
+    static constexpr size_t tls_record_size = 16 * 1024;
 
     batched_output_stream() = default;
     explicit batched_output_stream(
-      ss::output_stream<char>, size_t cache = default_max_unflushed_bytes);
+      ss::output_stream<char>,
+      size_t cache = default_max_unflushed_bytes,
+      std::chrono::microseconds cork_window = std::chrono::microseconds(0),
+      output_stream_stats* stats = nullptr,
+      size_t coalesce_size = 0);
     ~batched_output_stream() noexcept = default;
     // NOTE: explicitly defined for a gcc
     batched_output_stream(batched_output_stream&& o) noexcept
@@ -35,7 +71,15 @@ public:
       , _cache_size(o._cache_size)
       , _write_sem(std::move(o._write_sem))
       , _unflushed_bytes(o._unflushed_bytes)
-      , _closed(o._closed) {}
+      , _closed(o._closed)
+      , _cork_window(o._cork_window)
+      , _stats(o._stats)
+      , _coalesce_size(o._coalesce_size)
+      , _corked(std::move(o._corked))
+      , _cork_gate(std::move(o._cork_gate)) {
+        // the timer refers to the stream, streams are only moved uncorked
+        _cork_timer.set_callback([this] { flush_corked(); });
+    }
     batched_output_stream& operator=(batched_output_stream&& o) noexcept {
         if (this != &o) {
             this->~batched_output_stream();
@@ -54,12 +98,23 @@ public:
     ss::future<> stop();
 
 private:
+    ss::scattered_message<char> coalesce(ss::scattered_message<char>);
     ss::future<> do_flush();
+    ss::future<> wait_corked_flush();
+    void flush_corked();
 
     ss::output_stream<char> _out;
     size_t _cache_size{0};
     std::unique_ptr<ss::semaphore> _write_sem;
     size_t _unflushed_bytes{0};
     bool _closed = false;
+
+    std::chrono::microseconds _cork_window{0};
+    output_stream_stats* _stats{nullptr};
+    size_t _coalesce_size{0};
+    // resolved by the next flush, waited on by the corked writes
+    std::optional<ss::shared_promise<>> _corked;
+    ss::timer<> _cork_timer;
+    std::unique_ptr<ss::gate> _cork_gate;
 };
 } // namespace rpc
@@ -10,14 +10,55 @@
  */
 
 #pragma once
+#include "rpc/batched_output_stream.h"
 #include "rpc/logger.h"
+#include "utils/hdr_hist.h"
 
 #include <seastar/core/metrics_registration.hh>
 #include <seastar/net/socket_defs.hh>
 
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <optional>
 
 namespace rpc {
+/// \brief latencies of the requests of a method sent by a client, in
+/// microseconds
+class client_method_probe {
+public:
+    using clock_type = std::chrono::steady_clock;
+    using duration = clock_type::duration;
+
+    explicit client_method_probe(uint32_t method_id)
+      : _method_id(method_id) {}
+
+    /// encoding and compression of the request
+    void serialized_in(duration d) { _serialization_time.record(to_us(d)); }
+    /// from the serialized request until it was written to the connection
+    void queued_for(duration d) { _queue_time.record(to_us(d)); }
+    /// from the serialized request until its reply arrived
+    void replied_in(duration d) { _reply_time.record(to_us(d)); }
+
+    void setup_metrics(
+      ss::metrics::metric_groups&,
+      const std::optional<ss::sstring>& service_name,
+      const ss::sstring& target);
+
+private:
+    static int64_t to_us(duration d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d)
+          .count();
+    }
+
+    uint32_t _method_id;
+    hdr_hist _serialization_time;
+    hdr_hist _queue_time;
+    hdr_hist _reply_time;
+};
+
 class client_probe {
 public:
     void request() {
@@ -69,11 +110,16 @@ public:
 
     void waiting_for_available_memory() { ++_requests_blocked_memory; }
 
+    output_stream_stats& output_stats() { return _output_stats; }
+
     void setup_metrics(
       ss::metrics::metric_groups& mgs,
       const std::optional<ss::sstring>& service_name,
       const ss::socket_address& target_addr);
 
+    /// \brief the probe of a method, created with its first request
+    client_method_probe& method(uint32_t method_id);
+
 private:
     uint64_t _requests = 0;
     uint32_t _requests_pending = 0;
@@ -90,7 +136,14 @@ private:
     uint32_t _server_correlation_errors = 0;
     uint32_t _client_correlation_errors = 0;
     uint32_t _requests_blocked_memory = 0;
+    output_stream_stats _output_stats;
     ss::metrics::metric_groups _metrics;
+    absl::flat_hash_map<uint32_t, std::unique_ptr<client_method_probe>>
+      _methods;
+    // labels of the metrics, set once they are enabled
+    std::optional<ss::sstring> _target;
+    std::optional<ss::sstring> _service_name;
+    ss::metrics::metric_groups _method_metrics;
 
     friend std::ostream& operator<<(std::ostream& o, const client_probe& p);
 };
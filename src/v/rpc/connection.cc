@@ -16,12 +16,19 @@ connection::connection(
   boost::intrusive::list<connection>& hook,
   ss::connected_socket f,
   ss::socket_address a,
-  server_probe& p)
+  server_probe& p,
+  std::chrono::microseconds cork_window,
+  size_t coalesce_size)
   : addr(std::move(a))
   , _hook(hook)
   , _fd(std::move(f))
   , _in(_fd.input())
-  , _out(_fd.output())
+  , _out(
+      _fd.output(),
+      batched_output_stream::default_max_unflushed_bytes,
+      cork_window,
+      &p.output_stats(),
+      coalesce_size)
   , _probe(p) {
     _hook.push_back(*this);
     _probe.connection_established();
@@ -29,7 +29,9 @@ public:
       boost::intrusive::list<connection>& hook,
       ss::connected_socket f,
       ss::socket_address a,
-      server_probe& p);
+      server_probe& p,
+      std::chrono::microseconds cork_window = std::chrono::microseconds(0),
+      size_t coalesce_size = 0);
     ~connection() noexcept;
     connection(const connection&) = delete;
     connection& operator=(const connection&) = delete;
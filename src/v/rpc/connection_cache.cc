@@ -33,38 +33,46 @@ ss::future<> connection_cache::emplace(
           if (_cache.find(n) != _cache.end()) {
               return;
           }
-          _cache.emplace(
-            n,
+          transport_pool pool;
+          pool.reserve(_connections_per_peer);
+          for (size_t i = 1; i < _connections_per_peer; ++i) {
+              pool.push_back(ss::make_lw_shared<rpc::reconnect_transport>(
+                c, backoff_policy.clone()));
+          }
+          pool.insert(
+            pool.begin(),
             ss::make_lw_shared<rpc::reconnect_transport>(
               std::move(c), std::move(backoff_policy)));
+          _cache.emplace(n, std::move(pool));
       });
 }
 ss::future<> connection_cache::remove(model::node_id n) {
     return ss::with_semaphore(
              _sem,
              1,
-             [this, n]() -> transport_ptr {
+             [this, n]() -> transport_pool {
                  auto it = _cache.find(n);
                  if (it == _cache.end()) {
-                     return nullptr;
+                     return {};
                  }
-                 auto ptr = it->second;
+                 auto pool = std::move(it->second);
                  _cache.erase(it);
-                 return ptr;
+                 return pool;
              })
-      .then([](transport_ptr ptr) {
-          if (!ptr) {
-              return ss::now();
-          }
-          return ptr->stop().finally([ptr] {});
+      .then([](transport_pool pool) {
+          return ss::do_with(std::move(pool), [](transport_pool& pool) {
+              return ss::parallel_for_each(
+                pool, [](const transport_ptr& ptr) { return ptr->stop(); });
+          });
       });
 }
 
 /// \brief closes all client connections
 ss::future<> connection_cache::stop() {
     return parallel_for_each(_cache, [](auto& it) {
-        auto& [_, cli] = it;
-        return cli->stop();
+        auto& [_, pool] = it;
+        return ss::parallel_for_each(
+          pool, [](const transport_ptr& cli) { return cli->stop(); });
     });
 }
 
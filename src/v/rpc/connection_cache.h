@@ -23,15 +23,19 @@
 #include <seastar/core/sharded.hh>
 #include <seastar/core/shared_ptr.hh>
 
+#include <algorithm>
 #include <chrono>
 #include <unordered_map>
+#include <vector>
 
 namespace rpc {
 class connection_cache final
   : public ss::peering_sharded_service<connection_cache> {
 public:
     using transport_ptr = ss::lw_shared_ptr<rpc::reconnect_transport>;
-    using underlying = std::unordered_map<model::node_id, transport_ptr>;
+    /// connections to a peer, at most one per traffic class
+    using transport_pool = std::vector<transport_ptr>;
+    using underlying = std::unordered_map<model::node_id, transport_pool>;
     using iterator = typename underlying::iterator;
 
     static inline ss::shard_id shard_for(
@@ -40,11 +44,25 @@ public:
       model::node_id node,
       ss::shard_id max_shards = ss::smp::count);
 
-    connection_cache() = default;
+    /// \brief opens up to `connections_per_peer` connections to every peer,
+    /// so that bulk traffic does not delay latency sensitive requests. traffic
+    /// classes are assigned connections in order, the classes left without
+    /// one share the connection of the last assigned class.
+    explicit connection_cache(size_t connections_per_peer = 1)
+      : _connections_per_peer(
+        std::clamp<size_t>(connections_per_peer, 1, traffic_classes)) {}
+
     bool contains(model::node_id n) const {
         return _cache.find(n) != _cache.end();
     }
-    transport_ptr get(model::node_id n) const { return _cache.find(n)->second; }
+    /// \brief the connection of the control traffic
+    transport_ptr get(model::node_id n) const {
+        return get(n, traffic_class::control);
+    }
+    transport_ptr get(model::node_id n, traffic_class c) const {
+        const auto& pool = _cache.find(n)->second;
+        return pool[std::min(static_cast<size_t>(c), pool.size() - 1)];
+    }
 
     /// \brief needs to be a future, because mutations may come from different
     /// fibers and they need to be synchronized
@@ -68,19 +86,39 @@ public:
         ss::shard_id src_shard,
         model::node_id node_id,
         Func&& f) {
+        return with_node_client<Protocol>(
+          self,
+          src_shard,
+          node_id,
+          traffic_class::control,
+          std::forward<Func>(f));
+    }
+
+    template<typename Protocol, typename Func>
+    // clang-format off
+    CONCEPT(requires requires(Func&& f, Protocol proto) {
+        f(proto);
+    })
+      // clang-format on
+      auto with_node_client(
+        model::node_id self,
+        ss::shard_id src_shard,
+        model::node_id node_id,
+        traffic_class traffic,
+        Func&& f) {
         using ret_t = result_wrap_t<std::invoke_result_t<Func, Protocol>>;
         auto shard = rpc::connection_cache::shard_for(self, src_shard, node_id);
 
         return container().invoke_on(
           shard,
-          [node_id,
-           f = std::forward<Func>(f)](rpc::connection_cache& cache) mutable {
+          [node_id, traffic, f = std::forward<Func>(f)](
+            rpc::connection_cache& cache) mutable {
               if (!cache.contains(node_id)) {
                   // No client available
                   return ss::futurize<ret_t>::convert(
                     rpc::make_error_code(errc::missing_node_rpc_client));
               }
-              return cache.get(node_id)->get_connected().then(
+              return cache.get(node_id, traffic)->get_connected().then(
                 [f = std::forward<Func>(f)](
                   result<rpc::transport*> transport) mutable {
                     if (!transport) {
@@ -94,6 +132,7 @@ public:
     }
 
 private:
+    size_t _connections_per_peer;
     ss::semaphore _sem{1}; // to add/remove nodes
     underlying _cache;
 };
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+
+#include <seastar/core/lowres_clock.hh>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace rpc {
+
+/**
+ * Connections open at once per key of their client, e.g. its address, so
+ * that a single misbehaving client cannot take all the connections of a
+ * core. The counts are those of a core: a client reaches every core of the
+ * node with up to the limit each.
+ */
+template<typename Key, typename Hash = absl::Hash<Key>>
+class connection_counts {
+public:
+    /// a zero max does not limit the connections
+    explicit connection_counts(uint32_t max) noexcept
+      : _max(max) {}
+
+    /// \brief counts a new connection of the key, unless it has too many
+    bool try_add(const Key& k) {
+        if (_max == 0) {
+            return true;
+        }
+        auto& n = _counts[k];
+        if (n >= _max) {
+            return false;
+        }
+        ++n;
+        return true;
+    }
+
+    /// \brief a connection counted by try_add closed
+    void remove(const Key& k) {
+        if (_max == 0) {
+            return;
+        }
+        if (auto it = _counts.find(k); it != _counts.end()) {
+            if (--it->second == 0) {
+                _counts.erase(it);
+            }
+        }
+    }
+
+    uint32_t count(const Key& k) const {
+        auto it = _counts.find(k);
+        return it == _counts.end() ? 0 : it->second;
+    }
+
+private:
+    uint32_t _max;
+    absl::flat_hash_map<Key, uint32_t, Hash> _counts;
+};
+
+/**
+ * Connections a core accepts per second, so that a reconnect storm is turned
+ * away at accept time, before the connections take any memory. A token
+ * bucket holding up to a second of connections: bursts are accepted as long
+ * as the average rate stays under the limit.
+ */
+class accept_rate_limiter {
+public:
+    using clock_type = ss::lowres_clock;
+
+    /// a zero rate does not limit the connections
+    explicit accept_rate_limiter(
+      uint32_t per_second, clock_type::time_point now = clock_type::now())
+      : _rate(per_second)
+      , _tokens(per_second)
+      , _refilled(now) {}
+
+    /// \brief takes a token for a connection accepted now, if any is left
+    bool try_accept(clock_type::time_point now = clock_type::now()) {
+        if (_rate == 0) {
+            return true;
+        }
+        if (now > _refilled) {
+            const std::chrono::duration<double> elapsed = now - _refilled;
+            _tokens = std::min<double>(
+              _rate, _tokens + elapsed.count() * _rate);
+            _refilled = now;
+        }
+        if (_tokens < 1) {
+            return false;
+        }
+        _tokens -= 1;
+        return true;
+    }
+
+private:
+    uint32_t _rate;
+    double _tokens;
+    clock_type::time_point _refilled;
+};
+
+} // namespace rpc
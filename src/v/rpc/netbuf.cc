@@ -10,6 +10,7 @@
 #include "rpc/netbuf.h"
 
 #include "bytes/iobuf.h"
+#include "compression/internal/lz4_frame_compressor.h"
 #include "compression/stream_zstd.h"
 #include "hashing/xx.h"
 #include "reflection/adl.h"
@@ -34,14 +35,14 @@ ss::scattered_message<char> netbuf::as_scattered() && {
           "cannot compose scattered view with incomplete header. missing "
           "correlation_id or remote method id");
     }
-    if (
-      _out.size_bytes() >= _min_compression_bytes
-      && rpc::compression_type::zstd == _hdr.compression) {
-        compression::stream_zstd fn;
-        _out = fn.compress(std::move(_out));
-    } else {
+    if (_out.size_bytes() < _min_compression_bytes) {
         // didn't meet min requirements
         _hdr.compression = rpc::compression_type::none;
+    } else if (_hdr.compression == rpc::compression_type::zstd) {
+        compression::stream_zstd fn;
+        _out = fn.compress(std::move(_out));
+    } else if (_hdr.compression == rpc::compression_type::lz4) {
+        _out = compression::internal::lz4_frame_compressor::compress(_out);
     }
     incremental_xxhash64 h;
     auto in = iobuf::iterator_consumer(_out.cbegin(), _out.cend());
@@ -51,7 +52,16 @@ ss::scattered_message<char> netbuf::as_scattered() && {
     });
     _hdr.payload_checksum = h.digest();
     _hdr.payload_size = _out.size_bytes();
-    _hdr.header_checksum = rpc::checksum_header_only(_hdr);
+    if (_timeout_ms) {
+        _hdr.version |= std::underlying_type_t<header_flags>(
+          header_flags::timeout);
+        _hdr.header_checksum = rpc::checksum_header_only(_hdr, *_timeout_ms);
+        iobuf timeout;
+        reflection::adl<uint32_t>{}.to(timeout, *_timeout_ms);
+        _out.prepend(std::move(timeout));
+    } else {
+        _hdr.header_checksum = rpc::checksum_header_only(_hdr);
+    }
     _out.prepend(header_as_iobuf(_hdr));
 
     // prepare for output
@@ -17,6 +17,11 @@
 
 #include <seastar/core/scattered_message.hh>
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <optional>
+
 namespace rpc {
 class netbuf {
 public:
@@ -29,11 +34,14 @@ public:
     void set_compression(rpc::compression_type c);
     void set_service_method_id(uint32_t);
     void set_min_compression_bytes(size_t);
+    /// \brief sends the time left to the request with it, see header_flags
+    void set_timeout(std::chrono::milliseconds);
     iobuf& buffer();
 
 private:
     size_t _min_compression_bytes{1024};
     header _hdr;
+    std::optional<uint32_t> _timeout_ms;
     iobuf _out;
 };
 
@@ -53,5 +61,10 @@ inline void netbuf::set_service_method_id(uint32_t x) { _hdr.meta = x; }
 inline void netbuf::set_min_compression_bytes(size_t min) {
     _min_compression_bytes = min;
 }
+inline void netbuf::set_timeout(std::chrono::milliseconds t) {
+    using rep = std::chrono::milliseconds::rep;
+    _timeout_ms = uint32_t(std::clamp<rep>(
+      t.count(), 0, std::numeric_limits<uint32_t>::max()));
+}
 
 } // namespace rpc
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include "compression/internal/lz4_frame_compressor.h"
 #include "compression/stream_zstd.h"
 #include "hashing/xx.h"
 #include "likely.h"
@@ -26,6 +27,7 @@
 
 #include <fmt/format.h>
 
+#include <chrono>
 #include <memory>
 #include <optional>
 
@@ -63,6 +65,64 @@ parse_header(ss::input_stream<char>& in) {
     });
 }
 
+/// \brief the header of a request, with the time its client waits for the
+/// reply if the client sent it
+struct request_header {
+    header hdr;
+    std::optional<std::chrono::milliseconds> timeout;
+};
+
+/// \brief parses the header of a request and its timeout extension, see
+/// header_flags. The checksum of a header with a timeout covers both
+inline ss::future<std::optional<request_header>>
+parse_request_header(ss::input_stream<char>& in) {
+    using ret_t = std::optional<request_header>;
+    return read_iobuf_exactly(in, size_of_rpc_header).then([&in](iobuf b) {
+        if (b.size_bytes() != size_of_rpc_header) {
+            return ss::make_ready_future<ret_t>();
+        }
+        iobuf_parser parser(std::move(b));
+        auto h = reflection::adl<header>{}.from(parser);
+        if (!has_flag(h, header_flags::timeout)) {
+            if (auto got = checksum_header_only(h);
+                unlikely(h.header_checksum != got)) {
+                vlog(
+                  rpclog.info,
+                  "rpc header missmatching checksums. expected:{}, got:{} - "
+                  "{}",
+                  h.header_checksum,
+                  got,
+                  h);
+                return ss::make_ready_future<ret_t>();
+            }
+            return ss::make_ready_future<ret_t>(request_header{.hdr = h});
+        }
+        return read_iobuf_exactly(in, size_of_rpc_timeout)
+          .then([h](iobuf b) {
+              if (b.size_bytes() != size_of_rpc_timeout) {
+                  return ret_t();
+              }
+              iobuf_parser parser(std::move(b));
+              auto timeout_ms = reflection::adl<uint32_t>{}.from(parser);
+              if (auto got = checksum_header_only(h, timeout_ms);
+                  unlikely(h.header_checksum != got)) {
+                  vlog(
+                    rpclog.info,
+                    "rpc header missmatching checksums. expected:{}, got:{} "
+                    "- {}, timeout:{}ms",
+                    h.header_checksum,
+                    got,
+                    h,
+                    timeout_ms);
+                  return ret_t();
+              }
+              return ret_t(request_header{
+                .hdr = h,
+                .timeout = std::chrono::milliseconds(timeout_ms)});
+          });
+    });
+}
+
 static inline void
 validate_payload_and_header(const iobuf& io, const header& h) {
     detail::check_out_of_range(io.size_bytes(), h.payload_size);
@@ -102,6 +162,10 @@ ss::future<T> parse_type(ss::input_stream<char>& in, const header& h) {
             io = fn.uncompress(std::move(io));
             return rpc::parse_type_wihout_compression<T>(std::move(io));
         }
+        if (h.compression == compression_type::lz4) {
+            io = compression::internal::lz4_frame_compressor::uncompress(io);
+            return rpc::parse_type_wihout_compression<T>(std::move(io));
+        }
         return ss::make_exception_future<T>(std::runtime_error(
           fmt::format("no compression supported. header: {}", h)));
     });
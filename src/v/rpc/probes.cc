@@ -18,6 +18,10 @@ namespace rpc {
 void server_probe::setup_metrics(
   ss::metrics::metric_groups& mgs, const char* proto) {
     namespace sm = ss::metrics;
+    _proto = proto;
+    for (auto& [_, m] : _methods) {
+        m->setup_metrics(_method_metrics, proto);
+    }
     mgs.add_group(
       prometheus_sanitize::metrics_name(proto),
       {
@@ -36,6 +40,13 @@ void server_probe::setup_metrics(
           [this] { return _connection_close_error; },
           sm::description(fmt::format(
             "{}: Number of errors when shutting down the connection", proto))),
+        sm::make_derive(
+          "connections_rejected",
+          [this] { return _connections_rejected; },
+          sm::description(fmt::format(
+            "{}: Number of connections closed as they were over the "
+            "connection limits",
+            proto))),
         sm::make_derive(
           "requests_completed",
           [this] { return _requests_completed; },
@@ -76,14 +87,157 @@ void server_probe::setup_metrics(
           [this] { return _requests_received - _requests_completed; },
           sm::description(fmt::format(
             "{}: Number of requests being processed by server", proto))),
+        sm::make_derive(
+          "flushes",
+          [this] { return _output_stats.flushes; },
+          sm::description(
+            fmt::format("{}: Number of flushes of connections", proto))),
+        sm::make_total_bytes(
+          "flushed_bytes",
+          [this] { return _output_stats.flushed_bytes; },
+          sm::description(
+            fmt::format("{}: Number of bytes sent by flushes", proto))),
+        sm::make_derive(
+          "corked_writes",
+          [this] { return _output_stats.corked_writes; },
+          sm::description(fmt::format(
+            "{}: Number of writes delayed by the cork window", proto))),
+        sm::make_derive(
+          "coalesced_fragments",
+          [this] { return _output_stats.coalesced_fragments; },
+          sm::description(fmt::format(
+            "{}: Number of small fragments copied together before their "
+            "write",
+            proto))),
+        sm::make_histogram(
+          "requests_in_flight",
+          [this] { return _in_flight_depth.seastar_histogram_logform(); },
+          sm::description(fmt::format(
+            "{}: Requests a connection was processing when it received "
+            "another",
+            proto))),
+        sm::make_histogram(
+          "reply_reorder_time_us",
+          [this] { return _reorder_time.seastar_histogram_logform(); },
+          sm::description(fmt::format(
+            "{}: Time replies waited for the replies of earlier requests of "
+            "their connection",
+            proto))),
+        sm::make_derive(
+          "coalesced_writes",
+          [this] { return _coalesced_writes; },
+          sm::description(fmt::format(
+            "{}: Number of writes of the pending replies of a connection",
+            proto))),
+        sm::make_derive(
+          "coalesced_replies",
+          [this] { return _coalesced_replies; },
+          sm::description(fmt::format(
+            "{}: Number of replies sent by coalesced writes", proto))),
       });
 }
 
+method_probe&
+server_probe::method(uint32_t method_id, const method_info* info) {
+    auto it = _methods.find(method_id);
+    if (it != _methods.end()) {
+        return *it->second;
+    }
+    auto name = info ? info->name : std::string_view{};
+    auto& m = *_methods
+                 .emplace(
+                   method_id, std::make_unique<method_probe>(method_id, name))
+                 .first->second;
+    if (_proto) {
+        m.setup_metrics(_method_metrics, _proto->c_str());
+    }
+    return m;
+}
+
+void method_probe::setup_metrics(
+  ss::metrics::metric_groups& mgs, const char* proto) {
+    namespace sm = ss::metrics;
+    std::vector<sm::label_instance> labels = {
+      sm::label("method_id")(_method_id)};
+    if (!_name.empty()) {
+        labels.push_back(sm::label("method")(_name));
+    }
+    mgs.add_group(
+      prometheus_sanitize::metrics_name(proto),
+      {
+        sm::make_derive(
+          "method_requests",
+          [this] { return _requests; },
+          sm::description(
+            fmt::format("{}: Number of requests of the method", proto)),
+          labels),
+        sm::make_derive(
+          "method_received_bytes",
+          [this] { return _received_bytes; },
+          sm::description(fmt::format(
+            "{}: Bytes of the headers and payloads of requests", proto)),
+          labels),
+        sm::make_derive(
+          "method_sent_bytes",
+          [this] { return _sent_bytes; },
+          sm::description(
+            fmt::format("{}: Bytes of the encoded replies", proto)),
+          labels),
+        sm::make_histogram(
+          "method_queue_time_us",
+          [this] { return _queue_time.seastar_histogram_logform(); },
+          sm::description(fmt::format(
+            "{}: Time requests waited for admission and memory before their "
+            "handler started",
+            proto)),
+          labels),
+        sm::make_histogram(
+          "method_handler_time_us",
+          [this] { return _handler_time.seastar_histogram_logform(); },
+          sm::description(fmt::format(
+            "{}: Time handlers took to produce their reply", proto)),
+          labels),
+        sm::make_histogram(
+          "method_serialization_time_us",
+          [this] { return _serialization_time.seastar_histogram_logform(); },
+          sm::description(fmt::format(
+            "{}: Time taken to encode and compress replies", proto)),
+          labels),
+        sm::make_derive(
+          "method_rejected_requests",
+          [this] { return _rejected; },
+          sm::description(fmt::format(
+            "{}: Number of requests rejected as their method was overloaded",
+            proto)),
+          labels),
+        sm::make_derive(
+          "method_expired_requests",
+          [this] { return _expired; },
+          sm::description(fmt::format(
+            "{}: Number of requests dropped as their client timed out",
+            proto)),
+          labels),
+      });
+}
+
+std::ostream& operator<<(std::ostream& o, const method_probe& p) {
+    return o << "{method_id: " << p._method_id << ", name: " << p._name
+             << ", requests: " << p._requests
+             << ", received bytes: " << p._received_bytes
+             << ", sent bytes: " << p._sent_bytes
+             << ", queue time: " << p._queue_time
+             << ", handler time: " << p._handler_time
+             << ", serialization time: " << p._serialization_time
+             << ", rejected: " << p._rejected << ", expired: " << p._expired
+             << "}";
+}
+
 std::ostream& operator<<(std::ostream& o, const server_probe& p) {
     o << "{"
       << "connects: " << p._connects << ", "
       << "current connections: " << p._connections << ", "
       << "connection close errors: " << p._connection_close_error << ", "
+      << "connections rejected: " << p._connections_rejected << ", "
       << "requests completed: " << p._requests_completed << ", "
       << "received bytes: " << p._in_bytes << ", "
       << "sent bytes: " << p._out_bytes << ", "
@@ -98,9 +252,12 @@ void client_probe::setup_metrics(
   const std::optional<ss::sstring>& service_name,
   const ss::socket_address& target_addr) {
     namespace sm = ss::metrics;
-    auto target = sm::label("target");
-    std::vector<sm::label_instance> labels = {
-      target(fmt::format("{}:{}", target_addr.addr(), target_addr.port()))};
+    _target = fmt::format("{}:{}", target_addr.addr(), target_addr.port());
+    _service_name = service_name;
+    for (auto& [_, m] : _methods) {
+        m->setup_metrics(_method_metrics, _service_name, *_target);
+    }
+    std::vector<sm::label_instance> labels = {sm::label("target")(*_target)};
     if (service_name) {
         labels.push_back(sm::label("service_name")(*service_name));
     }
@@ -178,6 +335,77 @@ void client_probe::setup_metrics(
           sm::description("Number of requests that are blocked beacause"
                           " of insufficient memory"),
           labels),
+        sm::make_derive(
+          "flushes",
+          [this] { return _output_stats.flushes; },
+          sm::description("Number of flushes of the connection"),
+          labels),
+        sm::make_total_bytes(
+          "flushed_bytes",
+          [this] { return _output_stats.flushed_bytes; },
+          sm::description("Number of bytes sent by flushes"),
+          labels),
+        sm::make_derive(
+          "corked_writes",
+          [this] { return _output_stats.corked_writes; },
+          sm::description("Number of writes delayed by the cork window"),
+          labels),
+        sm::make_derive(
+          "coalesced_fragments",
+          [this] { return _output_stats.coalesced_fragments; },
+          sm::description(
+            "Number of small fragments copied together before their write"),
+          labels),
+      });
+}
+
+client_method_probe& client_probe::method(uint32_t method_id) {
+    auto it = _methods.find(method_id);
+    if (it != _methods.end()) {
+        return *it->second;
+    }
+    auto& m = *_methods
+                 .emplace(
+                   method_id, std::make_unique<client_method_probe>(method_id))
+                 .first->second;
+    if (_target) {
+        m.setup_metrics(_method_metrics, _service_name, *_target);
+    }
+    return m;
+}
+
+void client_method_probe::setup_metrics(
+  ss::metrics::metric_groups& mgs,
+  const std::optional<ss::sstring>& service_name,
+  const ss::sstring& target) {
+    namespace sm = ss::metrics;
+    std::vector<sm::label_instance> labels = {
+      sm::label("target")(target), sm::label("method_id")(_method_id)};
+    if (service_name) {
+        labels.push_back(sm::label("service_name")(*service_name));
+    }
+    mgs.add_group(
+      prometheus_sanitize::metrics_name("rpc_client"),
+      {
+        sm::make_histogram(
+          "method_serialization_time_us",
+          [this] { return _serialization_time.seastar_histogram_logform(); },
+          sm::description("Time taken to encode and compress requests"),
+          labels),
+        sm::make_histogram(
+          "method_queue_time_us",
+          [this] { return _queue_time.seastar_histogram_logform(); },
+          sm::description(
+            "Time requests waited for memory and the connection until they "
+            "were written"),
+          labels),
+        sm::make_histogram(
+          "method_reply_time_us",
+          [this] { return _reply_time.seastar_histogram_logform(); },
+          sm::description(
+            "Time from the serialization of requests until their reply "
+            "arrived"),
+          labels),
       });
 }
 
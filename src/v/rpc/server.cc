@@ -28,13 +28,26 @@ namespace rpc {
 
 server::server(server_configuration c)
   : cfg(std::move(c))
-  , _memory(cfg.max_service_memory_per_core)
+  , _max_memory(cfg.max_service_memory_per_core)
+  , _memory(_max_memory)
+  , _connections_per_ip(cfg.max_connections_per_ip)
+  , _accepts(cfg.max_accepts_per_second)
   , _creds(
       cfg.credentials ? (*cfg.credentials).build_server_credentials()
                       : nullptr) {}
 
 server::~server() = default;
 
+void server::set_max_memory(int64_t max_memory) {
+    auto delta = max_memory - _max_memory;
+    _max_memory = max_memory;
+    if (delta > 0) {
+        _memory.signal(delta);
+    } else if (delta < 0) {
+        _memory.consume(-delta);
+    }
+}
+
 void server::start() {
     vassert(_proto, "must have a registered protocol before starting");
     if (!cfg.disable_metrics) {
@@ -105,23 +118,36 @@ ss::future<> server::accept(ss::server_socket& s) {
                     ss::stop_iteration::yes);
               }
               auto ar = f_cs_sa.get();
+              if (!admit_connection(ar.remote_address.addr())) {
+                  // closed before anything is allocated for the connection
+                  ar.connection.shutdown_input();
+                  ar.connection.shutdown_output();
+                  return ss::make_ready_future<ss::stop_iteration>(
+                    ss::stop_iteration::no);
+              }
               ar.connection.set_nodelay(true);
               ar.connection.set_keepalive(true);
               auto conn = ss::make_lw_shared<connection>(
                 _connections,
                 std::move(ar.connection),
                 ar.remote_address,
-                _probe);
+                _probe,
+                cfg.cork_window,
+                _creds ? batched_output_stream::tls_record_size : 0);
               vlog(
                 rpclog.trace, "Incoming connection from {}", ar.remote_address);
               if (_conn_gate.is_closed()) {
+                  _connections_per_ip.remove(conn->addr.addr());
                   return conn->shutdown().then([] {
                       return ss::make_exception_future<ss::stop_iteration>(
                         ss::gate_closed_exception());
                   });
               }
               (void)with_gate(_conn_gate, [this, conn]() mutable {
-                  return apply_proto(_proto.get(), resources(this, conn));
+                  return apply_proto(_proto.get(), resources(this, conn))
+                    .finally([this, conn] {
+                        _connections_per_ip.remove(conn->addr.addr());
+                    });
               });
               return ss::make_ready_future<ss::stop_iteration>(
                 ss::stop_iteration::no);
@@ -129,6 +155,30 @@ ss::future<> server::accept(ss::server_socket& s) {
     });
 } // namespace rpc
 
+bool server::admit_connection(const ss::net::inet_address& addr) {
+    if (!_accepts.try_accept()) {
+        vlog(
+          rpclog.debug,
+          "{} - Rejecting connection from {}, too many connections accepted "
+          "per second",
+          _proto->name(),
+          addr);
+        _probe.connection_rejected();
+        return false;
+    }
+    if (!_connections_per_ip.try_add(addr)) {
+        vlog(
+          rpclog.debug,
+          "{} - Rejecting connection from {}, too many connections open from "
+          "the address",
+          _proto->name(),
+          addr);
+        _probe.connection_rejected();
+        return false;
+    }
+    return true;
+}
+
 ss::future<> server::stop() {
     ss::sstring proto_name = _proto ? _proto->name() : "protocol not set";
     vlog(
@@ -152,6 +202,26 @@ ss::future<> server::stop() {
           _connections, [](connection& c) { return c.shutdown(); });
     });
 }
+method_admission&
+server::admission(uint32_t method_id, const method_info* info) {
+    auto it = _admission.find(method_id);
+    if (it == _admission.end()) {
+        // a limit generated for the method overrides that of the server
+        const size_t max_in_flight = info && info->max_in_flight > 0
+                                       ? info->max_in_flight
+                                       : cfg.max_requests_per_method;
+        it = _admission
+               .emplace(
+                 method_id,
+                 std::make_unique<method_admission>(
+                   max_in_flight,
+                   cfg.queue_time_target,
+                   _probe.method(method_id, info)))
+               .first;
+    }
+    return *it->second;
+}
+
 void server::setup_metrics() {
     namespace sm = ss::metrics;
     if (!_proto) {
@@ -161,12 +231,12 @@ void server::setup_metrics() {
       prometheus_sanitize::metrics_name(cfg.name),
       {sm::make_total_bytes(
          "max_service_mem_bytes",
-         [this] { return cfg.max_service_memory_per_core; },
+         [this] { return _max_memory; },
          sm::description(
            fmt::format("{}: Maximum memory allowed for RPC", cfg.name))),
        sm::make_total_bytes(
          "consumed_mem_bytes",
-         [this] { return cfg.max_service_memory_per_core - _memory.current(); },
+         [this] { return consumed_memory(); },
          sm::description(
            fmt::format("{}: Memory consumed by request processing", cfg.name))),
        sm::make_histogram(
@@ -11,7 +11,9 @@
 
 #pragma once
 
+#include "rpc/admission.h"
 #include "rpc/connection.h"
+#include "rpc/connection_limits.h"
 #include "rpc/types.h"
 #include "utils/hdr_hist.h"
 
@@ -19,10 +21,13 @@
 #include <seastar/core/gate.hh>
 #include <seastar/core/metrics_registration.hh>
 #include <seastar/core/semaphore.hh>
+#include <seastar/net/inet_address.hh>
 
+#include <absl/container/flat_hash_map.h>
 #include <boost/intrusive/list.hpp>
 
 #include <list>
+#include <memory>
 #include <type_traits>
 #include <vector>
 
@@ -42,6 +47,11 @@ public:
 
         server_probe& probe() { return _s->_probe; }
         ss::semaphore& memory() { return _s->_memory; }
+        int64_t max_memory() const { return _s->_max_memory; }
+        method_admission&
+        admission(uint32_t method_id, const method_info* info = nullptr) {
+            return _s->admission(method_id, info);
+        }
         hdr_hist& hist() { return _s->_hist; }
         ss::gate& conn_gate() { return _s->_conn_gate; }
         ss::abort_source& abort_source() { return _s->_as; }
@@ -80,15 +90,33 @@ public:
     const server_configuration cfg; // NOLINT
     const hdr_hist& histogram() const { return _hist; }
 
+    /// \brief resizes the memory budget of request processing. shrinking it
+    /// does not wait for the memory in use, only new requests wait for it
+    void set_max_memory(int64_t);
+    int64_t max_memory() const { return _max_memory; }
+    int64_t consumed_memory() const { return _max_memory - _memory.current(); }
+    /// requests that waited for memory
+    uint32_t memory_waits() const { return _probe.requests_blocked_memory(); }
+
 private:
     friend resources;
     ss::future<> accept(ss::server_socket&);
+    /// \brief whether a connection accepted from the address is served,
+    /// see the connection limits of server_configuration
+    bool admit_connection(const ss::net::inet_address&);
     void setup_metrics();
+    method_admission& admission(uint32_t method_id, const method_info*);
 
     std::unique_ptr<protocol> _proto;
+    int64_t _max_memory;
     ss::semaphore _memory;
+    absl::flat_hash_map<uint32_t, std::unique_ptr<method_admission>>
+      _admission;
     std::vector<std::unique_ptr<ss::server_socket>> _listeners;
     boost::intrusive::list<connection> _connections;
+    connection_counts<ss::net::inet_address, std::hash<ss::net::inet_address>>
+      _connections_per_ip;
+    accept_rate_limiter _accepts;
     ss::abort_source _as;
     ss::gate _conn_gate;
     hdr_hist _hist;
@@ -11,14 +11,73 @@
 
 #pragma once
 
+#include "rpc/batched_output_stream.h"
+#include "rpc/types.h"
 #include "seastarx.h"
+#include "utils/hdr_hist.h"
 
 #include <seastar/core/metrics_registration.hh>
 
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <string_view>
 
 namespace rpc {
 
+/// \brief latencies and admission of the requests of a method on a server,
+/// in microseconds
+class method_probe {
+public:
+    using duration = std::chrono::steady_clock::duration;
+
+    explicit method_probe(uint32_t method_id, std::string_view name = {})
+      : _method_id(method_id)
+      , _name(name) {}
+
+    /// a request of the method, of its header and payload bytes
+    void received(size_t bytes) {
+        ++_requests;
+        _received_bytes += bytes;
+    }
+    /// the reply to a request, once encoded
+    void sent(size_t bytes) { _sent_bytes += bytes; }
+    /// waited for admission and memory, see method_admission
+    void queued_for(duration d) { _queue_time.record(to_us(d)); }
+    /// from the parsed request to the output of the handler
+    void handled_in(duration d) { _handler_time.record(to_us(d)); }
+    /// encoding and compression of the reply
+    void serialized_in(duration d) { _serialization_time.record(to_us(d)); }
+    void rejected() { ++_rejected; }
+    /// dropped as its client already gave up on the reply
+    void expired() { ++_expired; }
+
+    void setup_metrics(ss::metrics::metric_groups&, const char* proto);
+
+private:
+    static int64_t to_us(duration d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d)
+          .count();
+    }
+
+    uint32_t _method_id;
+    ss::sstring _name;
+    uint64_t _requests = 0;
+    uint64_t _received_bytes = 0;
+    uint64_t _sent_bytes = 0;
+    hdr_hist _queue_time;
+    hdr_hist _handler_time;
+    hdr_hist _serialization_time;
+    uint64_t _rejected = 0;
+    uint64_t _expired = 0;
+    friend std::ostream& operator<<(std::ostream& o, const method_probe& p);
+};
+
+std::ostream& operator<<(std::ostream& o, const method_probe& p);
+
 class server_probe {
 public:
     void connection_established() {
@@ -30,6 +89,10 @@ public:
 
     void connection_close_error() { ++_connection_close_error; }
 
+    /// \brief a connection closed right away, as its client or the shard
+    /// were over their connection limits
+    void connection_rejected() { ++_connections_rejected; }
+
     void add_bytes_sent(size_t sent) { _out_bytes += sent; }
 
     void add_bytes_received(size_t recv) { _in_bytes += recv; }
@@ -45,9 +108,34 @@ public:
     void service_error() { ++_service_errors; }
 
     void waiting_for_available_memory() { ++_requests_blocked_memory; }
+    uint32_t requests_blocked_memory() const {
+        return _requests_blocked_memory;
+    }
+
+    output_stream_stats& output_stats() { return _output_stats; }
+
+    /// \brief requests a connection was processing when it received another
+    void requests_in_flight(size_t n) { _in_flight_depth.record(n); }
+
+    /// \brief time a reply waited for the replies sent before it on its
+    /// connection, in microseconds
+    void reply_reordered_for(std::chrono::steady_clock::duration d) {
+        _reorder_time.record(
+          std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    }
+
+    /// \brief replies sent with a single write of a connection
+    void replies_coalesced(size_t n) {
+        ++_coalesced_writes;
+        _coalesced_replies += n;
+    }
 
     void setup_metrics(ss::metrics::metric_groups& mgs, const char* name);
 
+    /// \brief the probe of a method, created with its first request. the
+    /// info of the method, if known, names its metrics
+    method_probe& method(uint32_t method_id, const method_info* = nullptr);
+
 private:
     uint64_t _requests_completed = 0;
     uint64_t _in_bytes = 0;
@@ -57,9 +145,19 @@ private:
     uint64_t _service_errors = 0;
     uint32_t _connections = 0;
     uint32_t _connection_close_error = 0;
+    uint64_t _connections_rejected = 0;
     uint32_t _corrupted_headers = 0;
     uint32_t _method_not_found_errors = 0;
     uint32_t _requests_blocked_memory = 0;
+    output_stream_stats _output_stats;
+    hdr_hist _in_flight_depth;
+    hdr_hist _reorder_time;
+    uint64_t _coalesced_writes = 0;
+    uint64_t _coalesced_replies = 0;
+    absl::flat_hash_map<uint32_t, std::unique_ptr<method_probe>> _methods;
+    // set once metrics are enabled, to register those of new methods
+    std::optional<ss::sstring> _proto;
+    ss::metrics::metric_groups _method_metrics;
     friend std::ostream& operator<<(std::ostream& o, const server_probe& p);
 };
 
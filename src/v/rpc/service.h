@@ -19,6 +19,7 @@
 
 #include <seastar/core/reactor.hh>
 #include <seastar/core/scheduling.hh>
+#include <seastar/core/timed_out_error.hh>
 
 #include <cstdint>
 
@@ -35,6 +36,8 @@ struct service {
     virtual ss::smp_service_group& get_smp_service_group() = 0;
     /// \brief return nullptr when method not found
     virtual method* method_from_id(uint32_t) = 0;
+    /// \brief return nullptr when method not found
+    virtual const method_info* method_info_from_id(uint32_t) const = 0;
 };
 
 class rpc_internal_body_parsing_exception : public std::exception {
@@ -70,10 +73,16 @@ struct service::execution_helper {
                           input_f.get_exception());
                     }
                     ctx.signal_body_parse();
+                    // the client gave up while the payload was parsed
+                    if (ctx.drop_if_expired()) {
+                        return ss::make_exception_future<Output>(
+                          ss::timed_out_error());
+                    }
                     auto input = input_f.get0();
                     return f(std::move(input), ctx);
                 })
-                .then([method_id](Output out) mutable {
+                .then([method_id, &ctx](Output out) mutable {
+                    ctx.signal_handler_done();
                     auto b = std::make_unique<netbuf>();
                     auto raw_b = b.get();
                     raw_b->set_service_method_id(method_id);
@@ -15,12 +15,29 @@
 #include <seastar/core/future-util.hh>
 
 #include <exception>
+#include <optional>
 
 namespace rpc {
 struct server_context_impl final : streaming_context {
-    server_context_impl(server::resources s, header h)
+    server_context_impl(server::resources s, request_header h)
       : res(std::move(s))
-      , hdr(h) {}
+      , hdr(h.hdr) {
+        if (h.timeout) {
+            // the time spent on the wire is unknown, the deadline is thus
+            // later than the one of the client
+            deadline = arrived + *h.timeout;
+            header_size += size_of_rpc_timeout;
+        }
+    }
+    server_context_impl(server_context_impl&&) = delete;
+    server_context_impl& operator=(server_context_impl&&) = delete;
+    server_context_impl(const server_context_impl&) = delete;
+    server_context_impl& operator=(const server_context_impl&) = delete;
+    ~server_context_impl() noexcept final {
+        if (admission) {
+            admission->dequeued();
+        }
+    }
     ss::future<ss::semaphore_units<>> reserve_memory(size_t ask) final {
         auto fut = get_units(res.memory(), ask);
         if (res.memory().waiters()) {
@@ -29,18 +46,53 @@ struct server_context_impl final : streaming_context {
         return fut;
     }
     const header& get_header() const final { return hdr; }
-    void signal_body_parse() final { pr.set_value(); }
+    void signal_body_parse() final {
+        handler_started = clock_type::now();
+        if (admission) {
+            std::exchange(admission, nullptr)
+              ->started(handler_started - arrived, handler_started);
+        }
+        pr.set_value();
+    }
+    bool drop_if_expired() final {
+        if (deadline && clock_type::now() >= *deadline) {
+            if (method) {
+                method->expired();
+            }
+            return true;
+        }
+        return false;
+    }
+    void signal_handler_done() final {
+        handler_done = clock_type::now();
+        if (method) {
+            method->handled_in(*handler_done - handler_started);
+        }
+    }
     server::resources res;
     header hdr;
+    // with the timeout extension, if any
+    size_t header_size{size_of_rpc_header};
     ss::promise<> pr;
+    // set while the request is queued for its handler
+    method_admission* admission{nullptr};
+    // set once the method was found
+    method_probe* method{nullptr};
+
+    using clock_type = method_admission::clock_type;
+    clock_type::time_point arrived{clock_type::now()};
+    // when the client gives up on the reply, if it sent its timeout
+    std::optional<clock_type::time_point> deadline;
+    clock_type::time_point handler_started;
+    std::optional<clock_type::time_point> handler_done;
 };
 
 ss::future<> simple_protocol::apply(server::resources rs) {
     return ss::do_until(
       [rs] { return rs.conn->input().eof() || rs.abort_requested(); },
       [this, rs]() mutable {
-          return parse_header(rs.conn->input())
-            .then([this, rs](std::optional<header> h) mutable {
+          return parse_request_header(rs.conn->input())
+            .then([this, rs](std::optional<request_header> h) mutable {
                 rs.probe().request_received();
                 if (!h) {
                     rpclog.debug(
@@ -59,10 +111,21 @@ ss::future<> simple_protocol::apply(server::resources rs) {
 ss::future<>
 send_reply(ss::lw_shared_ptr<server_context_impl> ctx, netbuf buf) {
     buf.set_min_compression_bytes(1024);
-    buf.set_compression(rpc::compression_type::zstd);
+    // the client decodes the codec of its request, and zstd
+    auto codec = ctx->get_header().compression;
+    buf.set_compression(
+      codec == rpc::compression_type::none ? rpc::compression_type::zstd
+                                           : codec);
     buf.set_correlation_id(ctx->get_header().correlation_id);
 
     auto view = std::move(buf).as_scattered();
+    if (ctx->method) {
+        ctx->method->sent(view.size());
+        if (ctx->handler_done) {
+            ctx->method->serialized_in(
+              server_context_impl::clock_type::now() - *ctx->handler_done);
+        }
+    }
     if (ctx->res.conn_gate().is_closed()) {
         // do not write if gate is closed
         rpclog.debug(
@@ -77,11 +140,62 @@ send_reply(ss::lw_shared_ptr<server_context_impl> ctx, netbuf buf) {
       .finally([ctx] { ctx->res.probe().request_completed(); });
 }
 
+/// skips the payload of a request which is not handled and replies right
+/// away with the status
+static ss::future<>
+reject(ss::lw_shared_ptr<server_context_impl> ctx, rpc::status st) {
+    return ctx->res.conn->input()
+      .skip(ctx->get_header().payload_size)
+      .then_wrapped([ctx, st](ss::future<> f) {
+          if (f.failed()) {
+              ctx->pr.set_exception(f.get_exception());
+              return ss::now();
+          }
+          ctx->signal_body_parse();
+          netbuf reply_buf;
+          reply_buf.set_status(st);
+          return send_reply(ctx, std::move(reply_buf));
+      });
+}
+
+static ss::future<> dispatch_admitted(
+  ss::lw_shared_ptr<server_context_impl> ctx,
+  method* m,
+  server::resources rs) {
+    return (*m)(ctx->res.conn->input(), *ctx)
+      .then_wrapped([ctx, m = ctx->res.hist().auto_measure(), rs](
+                      ss::future<netbuf> fut) mutable {
+          netbuf reply_buf;
+          try {
+              reply_buf = fut.get0();
+              reply_buf.set_status(rpc::status::success);
+          } catch (const rpc_internal_body_parsing_exception& e) {
+              // We have to distinguish between exceptions thrown by the
+              // service handler and the one caused by the corrupted
+              // payload. Data corruption on the wire may lead to the
+              // situation where connection is not longer usable and so it
+              // have to be terminated.
+              ctx->pr.set_exception(e);
+              return ss::now();
+          } catch (const ss::timed_out_error& e) {
+              reply_buf.set_status(rpc::status::request_timeout);
+          } catch (...) {
+              rpclog.error(
+                "Service handler thrown an exception - {}",
+                std::current_exception());
+              rs.probe().service_error();
+              reply_buf.set_status(rpc::status::server_error);
+          }
+          return send_reply(ctx, std::move(reply_buf))
+            .finally([m = std::move(m)] {});
+      });
+}
+
 ss::future<>
-simple_protocol::dispatch_method_once(header h, server::resources rs) {
-    const auto method_id = h.meta;
+simple_protocol::dispatch_method_once(request_header h, server::resources rs) {
+    const auto method_id = h.hdr.meta;
     auto ctx = ss::make_lw_shared<server_context_impl>(rs, h);
-    rs.probe().add_bytes_received(size_of_rpc_header + h.payload_size);
+    rs.probe().add_bytes_received(ctx->header_size + h.hdr.payload_size);
     if (rs.conn_gate().is_closed()) {
         return ss::make_exception_future<>(ss::gate_closed_exception());
     }
@@ -90,13 +204,18 @@ simple_protocol::dispatch_method_once(header h, server::resources rs) {
 
     // background!
     (void)with_gate(rs.conn_gate(), [this, method_id, rs, ctx]() mutable {
-        auto it = std::find_if(
-          _services.begin(),
-          _services.end(),
-          [method_id](std::unique_ptr<service>& srvc) {
-              return srvc->method_from_id(method_id) != nullptr;
-          });
-        if (unlikely(it == _services.end())) {
+        // a single lookup in the generated tables of the services, for both
+        // the method and its info
+        method* m = nullptr;
+        const method_info* info = nullptr;
+        for (auto& srvc : _services) {
+            m = srvc->method_from_id(method_id);
+            if (m) {
+                info = srvc->method_info_from_id(method_id);
+                break;
+            }
+        }
+        if (unlikely(m == nullptr)) {
             rs.probe().method_not_found();
             netbuf reply_buf;
             reply_buf.set_status(rpc::status::method_not_found);
@@ -105,36 +224,31 @@ simple_protocol::dispatch_method_once(header h, server::resources rs) {
             });
         }
 
-        method* m = it->get()->method_from_id(method_id);
-
-        return (*m)(ctx->res.conn->input(), *ctx)
-          .then_wrapped([ctx, m = ctx->res.hist().auto_measure(), rs](
-                          ss::future<netbuf> fut) mutable {
-              netbuf reply_buf;
-              try {
-                  reply_buf = fut.get0();
-                  reply_buf.set_status(rpc::status::success);
-              } catch (const rpc_internal_body_parsing_exception& e) {
-                  // We have to distinguish between exceptions thrown by the
-                  // service handler and the one caused by the corrupted
-                  // payload. Data corruption on the wire may lead to the
-                  // situation where connection is not longer usable and so it
-                  // have to be terminated.
-                  ctx->pr.set_exception(e);
-                  return ss::now();
-              } catch (const ss::timed_out_error& e) {
-                  reply_buf.set_status(rpc::status::request_timeout);
-              } catch (...) {
-                  rpclog.error(
-                    "Service handler thrown an exception - {}",
-                    std::current_exception());
-                  rs.probe().service_error();
-                  reply_buf.set_status(rpc::status::server_error);
+        auto& admission = rs.admission(method_id, info);
+        ctx->method = &admission.probe();
+        ctx->method->received(ctx->header_size + ctx->hdr.payload_size);
+        // the client already gave up on the reply, e.g. the request was sent
+        // with no time left
+        if (ctx->drop_if_expired()) {
+            return reject(ctx, rpc::status::request_timeout);
+        }
+        if (admission.should_reject()) {
+            admission.rejected();
+            return reject(ctx, rpc::status::overloaded);
+        }
+        ctx->admission = &admission;
+        return admission.enqueue().then(
+          [ctx, m, rs](ss::semaphore_units<> slot) mutable {
+              // or while it was queued for its handler
+              if (ctx->drop_if_expired()) {
+                  return reject(ctx, rpc::status::request_timeout)
+                    .finally([slot = std::move(slot)] {});
               }
-              return send_reply(ctx, std::move(reply_buf))
-                .finally([m = std::move(m)] {});
+              return dispatch_admitted(ctx, m, rs).finally(
+                [slot = std::move(slot)] {});
           });
     });
     return fut;
 }
+
 } // namespace rpc
@@ -0,0 +1,121 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "rpc/stream.h"
+
+#include <seastar/core/future-util.hh>
+
+#include <fmt/format.h>
+
+#include <ostream>
+
+namespace rpc {
+
+std::ostream& operator<<(std::ostream& o, const stream_frame& f) {
+    fmt::print(
+      o,
+      "{{stream_id:{}, sequence:{}, last:{}, data:{}}}",
+      f.stream_id,
+      f.sequence,
+      f.last,
+      f.data.size_bytes());
+    return o;
+}
+
+stream_frame_queue::stream_frame_queue()
+  : _idle_timer(
+    [this] { abort(std::make_exception_ptr(ss::timed_out_error())); }) {
+    _idle_timer.arm(idle_timeout);
+}
+
+ss::future<> stream_frame_queue::push(stream_frame f) {
+    if (_error) {
+        return ss::make_exception_future<>(_error);
+    }
+    if (f.sequence != _next_sequence || _eof) {
+        auto e = std::make_exception_ptr(std::runtime_error(fmt::format(
+          "stream {} expected frame {}, got {}",
+          f.stream_id,
+          _next_sequence,
+          f.sequence)));
+        abort(e);
+        return ss::make_exception_future<>(e);
+    }
+    ++_next_sequence;
+    _idle_timer.rearm(ss::timer<>::clock::now() + idle_timeout);
+    _frames.push_back(
+      frame{.data = std::move(f.data), .last = f.last, .consumed = {}});
+    auto consumed = _frames.back().consumed.get_future();
+    notify();
+    return consumed;
+}
+
+void stream_frame_queue::notify() {
+    if (_waiter) {
+        auto w = std::exchange(_waiter, std::nullopt);
+        w->set_value();
+    }
+}
+
+ss::future<ss::temporary_buffer<char>> stream_frame_queue::get() {
+    if (_error) {
+        return ss::make_exception_future<ss::temporary_buffer<char>>(_error);
+    }
+    // acknowledge the frames that were read entirely
+    while (!_frames.empty() && _frames.front().data.empty()) {
+        auto f = std::move(_frames.front());
+        _frames.pop_front();
+        _eof = f.last;
+        f.consumed.set_value();
+    }
+    if (_eof) {
+        _idle_timer.cancel();
+        return ss::make_ready_future<ss::temporary_buffer<char>>();
+    }
+    if (_frames.empty()) {
+        _waiter.emplace();
+        return _waiter->get_future().then([this] { return get(); });
+    }
+    auto& data = _frames.front().data;
+    auto buf = data.begin()->share();
+    data.pop_front();
+    return ss::make_ready_future<ss::temporary_buffer<char>>(std::move(buf));
+}
+
+void stream_frame_queue::abort(std::exception_ptr e) {
+    if (_error) {
+        return;
+    }
+    _error = e;
+    _idle_timer.cancel();
+    for (auto& f : _frames) {
+        f.consumed.set_exception(e);
+    }
+    _frames.clear();
+    if (_waiter) {
+        auto w = std::exchange(_waiter, std::nullopt);
+        w->set_exception(e);
+    }
+}
+
+ss::input_stream<char>
+make_stream_input(ss::lw_shared_ptr<stream_frame_queue> queue) {
+    struct stream_source final : ss::data_source_impl {
+        explicit stream_source(ss::lw_shared_ptr<stream_frame_queue> q)
+          : queue(std::move(q)) {}
+        ss::future<ss::temporary_buffer<char>> get() final {
+            return queue->get();
+        }
+        ss::lw_shared_ptr<stream_frame_queue> queue;
+    };
+    return ss::input_stream<char>(
+      ss::data_source(std::make_unique<stream_source>(std::move(queue))));
+}
+
+} // namespace rpc
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "outcome.h"
+#include "random/generators.h"
+#include "rpc/transport.h"
+#include "rpc/types.h"
+#include "seastarx.h"
+#include "units.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/iostream.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/timer.hh>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <optional>
+
+/**
+ * Streaming methods.
+ *
+ * Requests and replies of regular methods are materialized as a whole on both
+ * sides. A streaming method instead receives its request payload as an input
+ * stream that is sent as a sequence of frames, each one a request of its own.
+ * The sender keeps a bounded window of frames in flight, and the receiver
+ * acknowledges a frame only once the handler consumed it, so the memory used
+ * by a stream is bounded by the window regardless of the payload size.
+ *
+ * The reply to the last frame carries the output of the handler, the other
+ * frames are acknowledged with a default constructed output.
+ */
+namespace rpc {
+
+/// \brief a frame of the payload of a streaming method
+struct stream_frame {
+    /// picked at random by the sender, identifies the stream on the receiver
+    uint64_t stream_id{0};
+    /// position of the frame in the stream, starting at 0
+    uint32_t sequence{0};
+    bool last{false};
+    iobuf data;
+};
+
+std::ostream& operator<<(std::ostream&, const stream_frame&);
+
+struct stream_options {
+    size_t frame_size{128_KiB};
+    size_t max_frames_in_flight{4};
+};
+
+/**
+ * Frames received for a stream, in order, waiting to be read by the handler.
+ */
+class stream_frame_queue {
+public:
+    /// a stream without frames for that long is aborted
+    static constexpr std::chrono::seconds idle_timeout{30};
+
+    stream_frame_queue();
+
+    /// \brief queues the next frame of the stream, the returned future
+    /// resolves once the data of the frame was read
+    ss::future<> push(stream_frame);
+
+    ss::future<ss::temporary_buffer<char>> get();
+
+    /// fails pending and future reads and pushes
+    void abort(std::exception_ptr);
+
+private:
+    struct frame {
+        iobuf data;
+        bool last;
+        ss::promise<> consumed;
+    };
+
+    void notify();
+
+    std::deque<frame> _frames;
+    std::optional<ss::promise<>> _waiter;
+    uint32_t _next_sequence{0};
+    bool _eof{false};
+    std::exception_ptr _error;
+    ss::timer<> _idle_timer;
+};
+
+/// \brief the payload of a stream, as read by the handler
+ss::input_stream<char>
+make_stream_input(ss::lw_shared_ptr<stream_frame_queue>);
+
+/**
+ * Streams of a streaming method in progress on a shard, created by their first
+ * frame and removed once their handler completed.
+ */
+template<typename Output>
+class stream_table {
+public:
+    stream_table()
+      : _streams(ss::make_lw_shared<streams_t>()) {}
+    stream_table(stream_table&&) noexcept = default;
+    stream_table& operator=(stream_table&&) noexcept = default;
+    stream_table(const stream_table&) = delete;
+    stream_table& operator=(const stream_table&) = delete;
+    ~stream_table() noexcept {
+        if (!_streams) {
+            return;
+        }
+        for (auto& [_, s] : *_streams) {
+            s->queue->abort(std::make_exception_ptr(
+              std::runtime_error("stream table destroyed")));
+        }
+    }
+
+    /// \brief hands the frame to its stream, starting the handler with the
+    /// first frame. resolves once the frame was consumed, or with the output
+    /// of the handler for the last frame
+    template<typename Func>
+    ss::future<Output> dispatch(stream_frame f, Func&& handler) {
+        ss::lw_shared_ptr<stream> s;
+        if (auto it = _streams->find(f.stream_id); it != _streams->end()) {
+            s = it->second;
+        } else if (f.sequence == 0) {
+            s = start(f.stream_id, std::forward<Func>(handler));
+        } else {
+            return ss::make_exception_future<Output>(std::runtime_error(
+              fmt::format("unknown stream {}", f.stream_id)));
+        }
+        const bool last = f.last;
+        auto consumed = s->queue->push(std::move(f));
+        if (!last || consumed.failed()) {
+            return consumed.then([] { return Output{}; });
+        }
+        // the output of the handler is the reply to the last frame, whether
+        // the handler read it or not
+        (void)consumed.handle_exception([](const std::exception_ptr&) {});
+        return s->output.get_future();
+    }
+
+private:
+    struct stream {
+        ss::lw_shared_ptr<stream_frame_queue> queue
+          = ss::make_lw_shared<stream_frame_queue>();
+        ss::promise<Output> output;
+    };
+    using streams_t
+      = absl::flat_hash_map<uint64_t, ss::lw_shared_ptr<stream>>;
+
+    template<typename Func>
+    ss::lw_shared_ptr<stream> start(uint64_t id, Func&& handler) {
+        auto s = ss::make_lw_shared<stream>();
+        _streams->emplace(id, s);
+        // background, until the handler read the whole stream
+        (void)ss::futurize_invoke(
+          std::forward<Func>(handler), make_stream_input(s->queue))
+          .then_wrapped([s, id, streams = _streams](ss::future<Output> f) {
+              streams->erase(id);
+              if (f.failed()) {
+                  auto e = f.get_exception();
+                  s->queue->abort(e);
+                  s->output.set_exception(e);
+                  return;
+              }
+              // frames the handler did not read will never be acknowledged
+              s->queue->abort(std::make_exception_ptr(std::runtime_error(
+                fmt::format("stream {} closed by its handler", id))));
+              s->output.set_value(f.get0());
+          });
+        return s;
+    }
+
+    ss::lw_shared_ptr<streams_t> _streams;
+};
+
+namespace detail {
+template<typename Output>
+struct stream_sender {
+    using ret_t = result<client_context<Output>>;
+
+    stream_sender(
+      transport& t,
+      uint32_t method_id,
+      ss::input_stream<char> in,
+      client_opts o,
+      stream_options so)
+      : t(t)
+      , method_id(method_id)
+      , payload(std::move(in))
+      , opts(std::move(o))
+      , so(so)
+      , window(so.max_frames_in_flight) {}
+
+    client_opts frame_opts() const {
+        client_opts o(
+          opts.timeout, opts.compression, opts.min_compression_bytes);
+        o.traffic = opts.traffic;
+        return o;
+    }
+
+    ss::future<ss::stop_iteration> send_next() {
+        return ss::get_units(window, 1).then([this](ss::semaphore_units<> u) {
+            if (error || failure) {
+                return ss::make_ready_future<ss::stop_iteration>(
+                  ss::stop_iteration::yes);
+            }
+            return read_iobuf_exactly(payload, so.frame_size)
+              .then([this, u = std::move(u)](iobuf data) mutable {
+                  const bool last = data.size_bytes() < so.frame_size;
+                  auto sent = send(
+                    stream_frame{
+                      .stream_id = id,
+                      .sequence = sequence++,
+                      .last = last,
+                      .data = std::move(data)},
+                    std::move(u));
+                  if (last) {
+                      return sent.then([] { return ss::stop_iteration::yes; });
+                  }
+                  // background, the window bounds the frames in flight
+                  (void)std::move(sent);
+                  return ss::make_ready_future<ss::stop_iteration>(
+                    ss::stop_iteration::no);
+              });
+        });
+    }
+
+    ss::future<> send(stream_frame f, ss::semaphore_units<> u) {
+        const bool last = f.last;
+        return t.send_typed<stream_frame, Output>(
+                  std::move(f), method_id, frame_opts())
+          .then_wrapped([this, last, u = std::move(u)](ss::future<ret_t> f) {
+              if (f.failed()) {
+                  failure = f.get_exception();
+                  return;
+              }
+              auto r = f.get0();
+              if (!r) {
+                  error = r.error();
+              } else if (last) {
+                  reply = std::move(r);
+              }
+          });
+    }
+
+    /// waits for the frames in flight, then returns the reply of the last one
+    ss::future<ret_t> finish() {
+        return ss::get_units(window, so.max_frames_in_flight)
+          .then([this](ss::semaphore_units<>) {
+              if (failure) {
+                  return ss::make_exception_future<ret_t>(failure);
+              }
+              if (error) {
+                  return ss::make_ready_future<ret_t>(ret_t(*error));
+              }
+              return ss::make_ready_future<ret_t>(std::move(*reply));
+          });
+    }
+
+    transport& t;
+    uint32_t method_id;
+    ss::input_stream<char> payload;
+    client_opts opts;
+    stream_options so;
+    uint64_t id{random_generators::get_int<uint64_t>()};
+    uint32_t sequence{0};
+    ss::semaphore window;
+    std::optional<std::error_code> error;
+    std::exception_ptr failure;
+    std::optional<ret_t> reply;
+};
+} // namespace detail
+
+/**
+ * Sends the payload to a streaming method. Frames are sent while fewer than
+ * `max_frames_in_flight` of them are not yet acknowledged. The deadline of
+ * `opts` applies to every frame.
+ */
+template<typename Output>
+ss::future<result<client_context<Output>>> send_stream(
+  transport& t,
+  uint32_t method_id,
+  ss::input_stream<char> payload,
+  client_opts opts,
+  stream_options so = {}) {
+    auto sender = std::make_unique<detail::stream_sender<Output>>(
+      t, method_id, std::move(payload), std::move(opts), so);
+    auto raw = sender.get();
+    return ss::repeat([raw] { return raw->send_next(); })
+      .then_wrapped([raw](ss::future<> f) {
+          if (f.failed()) {
+              raw->failure = f.get_exception();
+          }
+          return raw->finish();
+      })
+      .finally([sender = std::move(sender)] {});
+}
+
+} // namespace rpc
@@ -0,0 +1,69 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "rpc/admission.h"
+#include "rpc/server_probe.h"
+
+#include <seastar/core/thread.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+using namespace std::chrono_literals;
+using clock_type = rpc::method_admission::clock_type;
+
+SEASTAR_THREAD_TEST_CASE(caps_requests_in_flight) {
+    rpc::method_probe probe(1);
+    rpc::method_admission admission(2, 0ms, probe);
+    auto first = admission.enqueue();
+    auto second = admission.enqueue();
+    auto third = admission.enqueue();
+    BOOST_REQUIRE(first.available());
+    BOOST_REQUIRE(second.available());
+    BOOST_REQUIRE(!third.available());
+    BOOST_REQUIRE_EQUAL(admission.queued(), size_t(3));
+
+    admission.started(0ms);
+    {
+        auto units = first.get0();
+    }
+    auto units = third.get0();
+    admission.started(0ms);
+    admission.started(0ms);
+    BOOST_REQUIRE_EQUAL(admission.queued(), size_t(0));
+    second.get0();
+}
+
+SEASTAR_THREAD_TEST_CASE(sheds_while_queue_time_above_target) {
+    rpc::method_probe probe(1);
+    rpc::method_admission admission(0, 10ms, probe);
+    auto now = clock_type::now();
+
+    // a short spike above the target does not shed
+    admission.enqueue().get0();
+    admission.started(50ms, now);
+    admission.enqueue().get0();
+    admission.started(1ms, now + 50ms);
+    BOOST_REQUIRE(!admission.shedding());
+
+    // a long one does
+    for (auto t = 0ms; t <= rpc::method_admission::shedding_interval;
+         t += 10ms) {
+        admission.enqueue().get0();
+        admission.started(50ms, now + 100ms + t);
+    }
+    BOOST_REQUIRE(admission.shedding());
+    // a single probe goes through at a time
+    BOOST_REQUIRE(!admission.should_reject());
+    admission.enqueue().get0();
+    BOOST_REQUIRE(admission.should_reject());
+
+    // until one starts in time
+    admission.started(1ms, now + 1s);
+    BOOST_REQUIRE(!admission.shedding());
+    BOOST_REQUIRE(!admission.should_reject());
+}
@@ -0,0 +1,67 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "rpc/connection_limits.h"
+
+#include <seastar/core/sstring.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+using namespace std::chrono_literals;
+using clock_type = rpc::accept_rate_limiter::clock_type;
+
+SEASTAR_THREAD_TEST_CASE(counts_connections_per_key) {
+    rpc::connection_counts<ss::sstring> counts(2);
+    BOOST_REQUIRE(counts.try_add("a"));
+    BOOST_REQUIRE(counts.try_add("a"));
+    BOOST_REQUIRE(!counts.try_add("a"));
+    BOOST_REQUIRE(counts.try_add("b"));
+    BOOST_REQUIRE_EQUAL(counts.count("a"), uint32_t(2));
+
+    counts.remove("a");
+    BOOST_REQUIRE(counts.try_add("a"));
+    counts.remove("b");
+    counts.remove("b");
+    BOOST_REQUIRE_EQUAL(counts.count("b"), uint32_t(0));
+}
+
+SEASTAR_THREAD_TEST_CASE(zero_max_does_not_limit_connections) {
+    rpc::connection_counts<ss::sstring> counts(0);
+    for (int i = 0; i < 100; ++i) {
+        BOOST_REQUIRE(counts.try_add("a"));
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(limits_accept_rate) {
+    auto now = clock_type::now();
+    rpc::accept_rate_limiter limiter(10, now);
+    // a burst of a second of connections
+    for (int i = 0; i < 10; ++i) {
+        BOOST_REQUIRE(limiter.try_accept(now));
+    }
+    BOOST_REQUIRE(!limiter.try_accept(now));
+
+    // refilled at the rate
+    BOOST_REQUIRE(!limiter.try_accept(now + 50ms));
+    BOOST_REQUIRE(limiter.try_accept(now + 200ms));
+    BOOST_REQUIRE(!limiter.try_accept(now + 200ms));
+
+    // up to a second of connections
+    now += 10s;
+    for (int i = 0; i < 10; ++i) {
+        BOOST_REQUIRE(limiter.try_accept(now));
+    }
+    BOOST_REQUIRE(!limiter.try_accept(now));
+}
+
+SEASTAR_THREAD_TEST_CASE(zero_rate_does_not_limit_accepts) {
+    rpc::accept_rate_limiter limiter(0);
+    for (int i = 0; i < 100; ++i) {
+        BOOST_REQUIRE(limiter.try_accept());
+    }
+}
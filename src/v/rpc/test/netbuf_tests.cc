@@ -45,3 +45,25 @@ SEASTAR_THREAD_TEST_CASE(netbuf_pod) {
     BOOST_REQUIRE_EQUAL(src.y, dst.y);
     BOOST_REQUIRE_EQUAL(src.z, dst.z);
 }
+
+SEASTAR_THREAD_TEST_CASE(netbuf_pod_with_timeout) {
+    auto n = rpc::netbuf();
+    pod src;
+    src.x = 88;
+    src.y = 88;
+    src.z = 88;
+    n.set_correlation_id(42);
+    n.set_service_method_id(66);
+    n.set_timeout(std::chrono::milliseconds(1500));
+    reflection::async_adl<pod>{}.to(n.buffer(), std::move(src)).get();
+    auto bufs = std::move(n).as_scattered().release().release();
+    auto in = make_iobuf_input_stream(iobuf(std::move(bufs)));
+    auto h = rpc::parse_request_header(in).get0();
+    BOOST_REQUIRE(h);
+    BOOST_REQUIRE(rpc::has_flag(h->hdr, rpc::header_flags::timeout));
+    BOOST_REQUIRE(h->timeout == std::chrono::milliseconds(1500));
+    const pod dst = rpc::parse_type<pod>(in, h->hdr).get0();
+    BOOST_REQUIRE_EQUAL(src.x, dst.x);
+    BOOST_REQUIRE_EQUAL(src.y, dst.y);
+    BOOST_REQUIRE_EQUAL(src.z, dst.z);
+}
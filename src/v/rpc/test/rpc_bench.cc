@@ -8,6 +8,7 @@
 // by the Apache License, Version 2.0
 
 #include "reflection/adl.h"
+#include "utils/named_type.h"
 
 #include <seastar/core/reactor.hh>
 #include <seastar/core/sharded.hh>
@@ -85,3 +86,93 @@ PERF_TEST(big_10mb, serialize) {
 PERF_TEST(big_10mb, deserialize) {
     return deserialize_big(10 << 20 /*10MB*/, 1 << 15 /*32KB*/);
 }
+
+// the fixed layout fields of a struct are copied in runs instead of one by
+// one, compare with the field by field encoding
+using bench_offset = named_type<int64_t, struct bench_offset_tag>;
+
+struct reply_t {
+    int32_t node = 1;
+    bench_offset group{2};
+    bench_offset term{3};
+    bench_offset committed{4};
+    bench_offset dirty{5};
+    bench_offset term_base{6};
+    uint8_t status = 0;
+};
+
+struct meta_t {
+    bench_offset group{1};
+    bench_offset commit{2};
+    bench_offset term{3};
+    bench_offset prev_index{4};
+    bench_offset prev_term{5};
+    bench_offset visible{6};
+};
+static_assert(reflection::detail::is_raw_encoded_v<meta_t>);
+
+static void encode_field_by_field(iobuf& out, const reply_t& t) {
+    reflection::adl<int32_t>{}.to(out, t.node);
+    for (auto o : {t.group, t.term, t.committed, t.dirty, t.term_base}) {
+        reflection::adl<int64_t>{}.to(out, o());
+    }
+    reflection::adl<uint8_t>{}.to(out, t.status);
+}
+
+static void encode_field_by_field(iobuf& out, const meta_t& m) {
+    for (auto o :
+         {m.group, m.commit, m.term, m.prev_index, m.prev_term, m.visible}) {
+        reflection::adl<int64_t>{}.to(out, o());
+    }
+}
+
+PERF_TEST(reply, serialize_field_by_field) {
+    iobuf o;
+    perf_tests::start_measuring_time();
+    for (int i = 0; i < 100; ++i) {
+        encode_field_by_field(o, reply_t{});
+    }
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(reply, serialize) {
+    iobuf o;
+    perf_tests::start_measuring_time();
+    for (int i = 0; i < 100; ++i) {
+        reflection::serialize(o, reply_t{});
+    }
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
+
+static std::vector<meta_t> gen_metas() { return std::vector<meta_t>(10000); }
+
+PERF_TEST(meta_vector, serialize_field_by_field) {
+    auto metas = gen_metas();
+    iobuf o;
+    perf_tests::start_measuring_time();
+    reflection::adl<int32_t>{}.to(o, metas.size());
+    for (auto& m : metas) {
+        encode_field_by_field(o, m);
+    }
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(meta_vector, serialize) {
+    auto metas = gen_metas();
+    iobuf o;
+    perf_tests::start_measuring_time();
+    reflection::serialize(o, std::move(metas));
+    perf_tests::do_not_optimize(o);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST(meta_vector, deserialize) {
+    auto o = reflection::to_iobuf(gen_metas());
+    perf_tests::start_measuring_time();
+    auto result = reflection::from_iobuf<std::vector<meta_t>>(std::move(o));
+    perf_tests::do_not_optimize(result);
+    perf_tests::stop_measuring_time();
+}
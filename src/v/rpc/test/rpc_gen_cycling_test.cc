@@ -9,13 +9,16 @@
 
 #include "model/timeout_clock.h"
 #include "random/generators.h"
+#include "rpc/connection_cache.h"
 #include "rpc/exceptions.h"
+#include "rpc/stream.h"
 #include "rpc/test/rpc_gen_types.h"
 #include "rpc/test/rpc_integration_fixture.h"
 #include "rpc/types.h"
 #include "test_utils/fixture.h"
 
 #include <seastar/core/semaphore.hh>
+#include <seastar/core/sharded.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/util/defer.hh>
 
@@ -100,6 +103,75 @@ FIXTURE_TEST(client_muxing, rpc_integration_fixture) {
     BOOST_REQUIRE_EQUAL(echo_resp.value().data.str, "testing..._suffix");
 }
 
+FIXTURE_TEST(corked_concurrent_requests, rpc_integration_fixture) {
+    configure_server();
+    register_services();
+    start_server();
+
+    auto cfg = client_config();
+    cfg.cork_window = 200us;
+    rpc::client<echo::echo_client_protocol> client(std::move(cfg));
+    client.connect().get();
+    auto dcli = ss::defer([&client] { client.stop().get(); });
+    std::vector<ss::future<result<rpc::client_context<echo::echo_resp>>>>
+      futures;
+    futures.reserve(50);
+    for (int i = 0; i < 50; ++i) {
+        futures.push_back(client.suffix_echo(
+          echo::echo_req{.str = fmt::format("{}", i)},
+          rpc::client_opts(rpc::no_timeout)));
+    }
+    auto replies = ss::when_all_succeed(futures.begin(), futures.end()).get0();
+    for (size_t i = 0; i < replies.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(
+          replies[i].value().data.str, fmt::format("{}_suffix", i));
+    }
+}
+
+FIXTURE_TEST(connection_per_traffic_class, rpc_integration_fixture) {
+    configure_server();
+    register_services();
+    start_server();
+
+    const model::node_id self(0);
+    const model::node_id peer(1);
+    ss::sharded<rpc::connection_cache> cache;
+    cache.start(size_t(2)).get();
+    auto dcache = ss::defer([&cache] { cache.stop().get(); });
+    cache.local()
+      .emplace(
+        peer,
+        client_config(),
+        rpc::make_exponential_backoff_policy<rpc::clock_type>(1s, 10s))
+      .get();
+    // replication and recovery share the second connection
+    auto control = cache.local().get(peer, rpc::traffic_class::control);
+    auto replication = cache.local().get(
+      peer, rpc::traffic_class::replication);
+    BOOST_REQUIRE(control != replication);
+    BOOST_REQUIRE(
+      replication == cache.local().get(peer, rpc::traffic_class::recovery));
+
+    for (auto traffic :
+         {rpc::traffic_class::control, rpc::traffic_class::recovery}) {
+        auto reply = cache.local()
+                       .with_node_client<echo::echo_client_protocol>(
+                         self,
+                         ss::this_shard_id(),
+                         peer,
+                         traffic,
+                         [](echo::echo_client_protocol c) {
+                             return c.suffix_echo(
+                               echo::echo_req{.str = "testing..."},
+                               rpc::client_opts(rpc::no_timeout));
+                         })
+                       .get0();
+        BOOST_REQUIRE_EQUAL(reply.value().data.str, "testing..._suffix");
+    }
+    BOOST_REQUIRE(control->is_valid());
+    BOOST_REQUIRE(replication->is_valid());
+}
+
 FIXTURE_TEST(timeout_test, rpc_integration_fixture) {
     configure_server();
     register_services();
@@ -142,6 +214,16 @@ FIXTURE_TEST(rpc_mixed_compression, rpc_integration_fixture) {
                       0 /*min bytes compress*/))
                   .get0();
     BOOST_REQUIRE_EQUAL(echo_resp.value().data.str, data);
+    BOOST_TEST_MESSAGE("Calling echo method with lz4 compression");
+    echo_resp = client
+                  .echo(
+                    echo::echo_req{.str = data},
+                    rpc::client_opts(
+                      rpc::no_timeout,
+                      rpc::compression_type::lz4,
+                      0 /*min bytes compress*/))
+                  .get0();
+    BOOST_REQUIRE_EQUAL(echo_resp.value().data.str, data);
 
     // close resources
     client.stop().get();
@@ -264,4 +346,39 @@ FIXTURE_TEST(corrupted_data_at_server, rpc_integration_fixture) {
 
         BOOST_REQUIRE_EQUAL(echo_resp_new.value().data.str, "testing...");
     }
-}
\ No newline at end of file
+}
+
+FIXTURE_TEST(streaming_method_test, rpc_integration_fixture) {
+    configure_server();
+    register_services();
+    start_server();
+    rpc::client<echo::echo_client_protocol> client(client_config());
+    client.connect().get();
+    auto stop_action = ss::defer([&client] { client.stop().get(); });
+
+    // larger than the window of frames in flight
+    const auto data = random_generators::gen_alphanum_string(700 * 1024);
+    for (size_t frame_size : {size_t(64_KiB), size_t(700 * 1024)}) {
+        iobuf payload;
+        payload.append(data.data(), data.size());
+        auto reply = client
+                       .echo_stream(
+                         make_iobuf_input_stream(std::move(payload)),
+                         rpc::client_opts(rpc::clock_type::now() + 10s),
+                         rpc::stream_options{
+                           .frame_size = frame_size, .max_frames_in_flight = 2})
+                       .get0();
+        BOOST_REQUIRE(reply);
+        BOOST_REQUIRE_EQUAL(reply.value().data.str, data);
+    }
+}
+
+FIXTURE_TEST(generated_method_infos, rpc_integration_fixture) {
+    using svc = echo::echo_service;
+    static_assert(svc::method_index(svc::method_infos[3].id) == 3);
+    BOOST_REQUIRE_EQUAL(svc::method_infos.size(), 7);
+    BOOST_REQUIRE_EQUAL(svc::method_infos[3].name, "echo::sleep_1s");
+    BOOST_REQUIRE_EQUAL(svc::method_infos[3].max_in_flight, 4);
+    BOOST_REQUIRE_EQUAL(svc::method_infos[0].max_in_flight, 0);
+    BOOST_REQUIRE_EQUAL(svc::method_index(0), -1);
+}
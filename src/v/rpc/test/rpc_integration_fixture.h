@@ -22,6 +22,7 @@
 #include "seastarx.h"
 
 #include <seastar/core/future.hh>
+#include <seastar/core/loop.hh>
 #include <seastar/core/sleep.hh>
 #include <seastar/core/smp.hh>
 #include <seastar/net/inet_address.hh>
@@ -87,6 +88,24 @@ struct echo_impl final : echo::echo_service {
         }
     }
 
+    ss::future<echo::echo_resp>
+    echo_stream(ss::input_stream<char> payload) final {
+        return ss::do_with(
+          std::move(payload), ss::sstring{}, [](auto& in, auto& str) {
+              return ss::repeat([&in, &str] {
+                         return in.read().then(
+                           [&str](ss::temporary_buffer<char> buf) {
+                               if (buf.empty()) {
+                                   return ss::stop_iteration::yes;
+                               }
+                               str.append(buf.get(), buf.size());
+                               return ss::stop_iteration::no;
+                           });
+                     })
+                .then([&str] { return echo::echo_resp{.str = str}; });
+          });
+    }
+
     uint64_t cnt = 0;
 };
 
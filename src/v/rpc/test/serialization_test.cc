@@ -11,6 +11,7 @@
 #include "reflection/adl.h"
 #include "reflection/arity.h"
 #include "rpc/test/test_types.h"
+#include "utils/named_type.h"
 
 #include <seastar/testing/thread_test_case.hh>
 
@@ -79,3 +80,93 @@ SEASTAR_THREAD_TEST_CASE(serialize_sstring_vector) {
       117;
     BOOST_CHECK_EQUAL(b.size_bytes(), expected);
 }
+
+namespace {
+using offset = named_type<int64_t, struct offset_tag>;
+enum class reply_status : uint8_t { success, failure };
+
+// no padding, copied at once
+struct packed_meta {
+    offset commit;
+    offset dirty;
+    int32_t node;
+    uint32_t term;
+};
+
+// padding before group and after status, encoded in three runs
+struct padded_reply {
+    int32_t node = 1;
+    offset group{2};
+    offset term{3};
+    offset committed{4};
+    reply_status status = reply_status::failure;
+    ss::sstring name = "reply";
+    int16_t tail = 5;
+};
+
+static_assert(reflection::detail::is_raw_encoded_v<packed_meta>);
+static_assert(reflection::detail::is_raw_encoded_v<offset>);
+static_assert(!reflection::detail::is_raw_encoded_v<pod>);
+static_assert(!reflection::detail::is_raw_encoded_v<padded_reply>);
+
+template<typename T>
+void field_by_field(iobuf& out, T t) {
+    reflection::for_each_field(t, [&out](auto& f) {
+        reflection::adl<std::decay_t<decltype(f)>>{}.to(out, f);
+    });
+}
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(raw_encoding_matches_field_encoding) {
+    auto meta = packed_meta{
+      .commit = offset(10), .dirty = offset(-1), .node = 7, .term = 3};
+    iobuf expected;
+    field_by_field(expected, meta);
+    auto raw = reflection::to_iobuf(meta);
+    BOOST_REQUIRE_EQUAL(raw, expected);
+    auto decoded = reflection::from_iobuf<packed_meta>(std::move(raw));
+    BOOST_REQUIRE_EQUAL(decoded.commit, meta.commit);
+    BOOST_REQUIRE_EQUAL(decoded.dirty, meta.dirty);
+    BOOST_REQUIRE_EQUAL(decoded.node, meta.node);
+    BOOST_REQUIRE_EQUAL(decoded.term, meta.term);
+}
+
+SEASTAR_THREAD_TEST_CASE(padded_encoding_matches_field_encoding) {
+    padded_reply reply;
+    reply.status = reply_status::success;
+    iobuf expected;
+    field_by_field(expected, reply);
+    BOOST_REQUIRE_EQUAL(expected.size_bytes(), 4 + 3 * 8 + 1 + 4 + 5 + 2);
+    auto encoded = reflection::to_iobuf(reply);
+    BOOST_REQUIRE_EQUAL(encoded, expected);
+    auto decoded = reflection::from_iobuf<padded_reply>(std::move(encoded));
+    BOOST_REQUIRE_EQUAL(decoded.node, reply.node);
+    BOOST_REQUIRE_EQUAL(decoded.group, reply.group);
+    BOOST_REQUIRE_EQUAL(decoded.term, reply.term);
+    BOOST_REQUIRE_EQUAL(decoded.committed, reply.committed);
+    BOOST_REQUIRE(decoded.status == reply.status);
+    BOOST_REQUIRE_EQUAL(decoded.name, reply.name);
+    BOOST_REQUIRE_EQUAL(decoded.tail, reply.tail);
+}
+
+SEASTAR_THREAD_TEST_CASE(raw_vector_encoding_matches_element_encoding) {
+    std::vector<packed_meta> metas;
+    for (int i = 0; i < 100; ++i) {
+        metas.push_back(packed_meta{
+          .commit = offset(i), .dirty = offset(i * 2), .node = i, .term = 1});
+    }
+    iobuf expected;
+    reflection::adl<int32_t>{}.to(expected, int32_t(metas.size()));
+    for (auto& m : metas) {
+        field_by_field(expected, m);
+    }
+    auto encoded = reflection::to_iobuf(metas);
+    BOOST_REQUIRE_EQUAL(encoded, expected);
+    auto decoded = reflection::from_iobuf<std::vector<packed_meta>>(
+      std::move(encoded));
+    BOOST_REQUIRE_EQUAL(decoded.size(), metas.size());
+    for (size_t i = 0; i < metas.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(decoded[i].commit, metas[i].commit);
+        BOOST_REQUIRE_EQUAL(decoded[i].node, metas[i].node);
+    }
+}
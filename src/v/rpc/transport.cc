@@ -9,6 +9,7 @@
 
 #include "rpc/transport.h"
 
+#include "finjector/latency_probe.h"
 #include "likely.h"
 #include "rpc/logger.h"
 #include "rpc/parse_utils.h"
@@ -40,7 +41,8 @@ base_transport::base_transport(configuration c)
   : _server_addr(c.server_addr)
   , _creds(
       c.credentials ? c.credentials->build_certificate_credentials() : nullptr)
-  , _tls_sni_hostname(c.tls_sni_hostname) {}
+  , _tls_sni_hostname(c.tls_sni_hostname)
+  , _cork_window(c.cork_window) {}
 
 transport::transport(
   transport_configuration c,
@@ -48,8 +50,10 @@ transport::transport(
   : base_transport(base_transport::configuration{
     .server_addr = std::move(c.server_addr),
     .credentials = std::move(c.credentials),
+    .cork_window = c.cork_window,
   })
-  , _memory(c.max_queued_bytes) {
+  , _memory(c.max_queued_bytes)
+  , _send_timeouts(c.send_timeouts) {
     if (!c.disable_metrics) {
         setup_metrics(service_name);
     }
@@ -88,7 +92,12 @@ ss::future<> base_transport::do_connect() {
           }
           _probe.connection_established();
           _in = _fd->input();
-          _out = batched_output_stream(_fd->output());
+          _out = batched_output_stream(
+            _fd->output(),
+            batched_output_stream::default_max_unflushed_bytes,
+            _cork_window,
+            &_probe.output_stats(),
+            _creds ? batched_output_stream::tls_record_size : 0);
       });
 }
 ss::future<> base_transport::connect() {
@@ -150,6 +159,19 @@ ss::future<> transport::connect() {
 
 ss::future<result<std::unique_ptr<streaming_context>>>
 transport::send(netbuf b, rpc::client_opts opts) {
+    return do_send(
+      std::move(b),
+      std::move(opts),
+      nullptr,
+      client_method_probe::clock_type::now());
+}
+
+ss::future<result<std::unique_ptr<streaming_context>>> transport::do_send(
+  netbuf b,
+  rpc::client_opts opts,
+  client_method_probe* method,
+  client_method_probe::clock_type::time_point serialization_start) {
+    using clock_type = client_method_probe::clock_type;
     using ret_t = result<std::unique_ptr<streaming_context>>;
     // hold invariant of always having a valid connection _and_ a working
     // dispatch gate where we can wait for async futures
@@ -158,7 +180,11 @@ transport::send(netbuf b, rpc::client_opts opts) {
     }
     return ss::with_gate(
       _dispatch_gate,
-      [this, b = std::move(b), opts = std::move(opts)]() mutable {
+      [this,
+       b = std::move(b),
+       opts = std::move(opts),
+       method,
+       serialization_start]() mutable {
           if (_correlations.find(_correlation_idx + 1) != _correlations.end()) {
               _probe.client_correlation_error();
               throw std::runtime_error(
@@ -188,19 +214,61 @@ transport::send(netbuf b, rpc::client_opts opts) {
           });
 
           // send
+          if (_send_timeouts && opts.timeout != rpc::no_timeout) {
+              b.set_timeout(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                  opts.timeout - rpc::clock_type::now()));
+          }
           auto view = std::move(b).as_scattered();
+          const auto serialized = clock_type::now();
+          if (method) {
+              method->serialized_in(serialized - serialization_start);
+              fut = fut.then([method, serialized](ret_t r) {
+                  if (r) {
+                      method->replied_in(clock_type::now() - serialized);
+                  }
+                  return r;
+              });
+          }
           const auto sz = view.size();
-          return get_units(_memory, sz)
-            .then([this, v = std::move(view), f = std::move(fut)](
-                    ss::semaphore_units<> units) mutable {
+          // a delayed send keeps its memory units, as a slow network would
+          using point = finjector::latency_probe::point;
+          auto& latency = finjector::shard_local_latency_probe();
+          auto units = get_units(_memory, sz);
+          if (unlikely(latency.is_delayed(point::rpc_send))) {
+              units = std::move(units).then([](ss::semaphore_units<> u) {
+                  return finjector::shard_local_latency_probe()
+                    .delay(point::rpc_send)
+                    .then(
+                      [u = std::move(u)]() mutable { return std::move(u); });
+              });
+          }
+          return std::move(units)
+            .then([this,
+                   v = std::move(view),
+                   f = std::move(fut),
+                   method,
+                   serialized](ss::semaphore_units<> units) mutable {
                 /// background
                 (void)ss::with_gate(
                   _dispatch_gate,
-                  [this, v = std::move(v), u = std::move(units)]() mutable {
+                  [this,
+                   v = std::move(v),
+                   u = std::move(units),
+                   method,
+                   serialized]() mutable {
                       auto msg_size = v.size();
                       return _out.write(std::move(v))
-                        .finally([this, msg_size, u = std::move(u)] {
+                        .finally([this,
+                                  msg_size,
+                                  u = std::move(u),
+                                  method,
+                                  serialized] {
                             _probe.add_bytes_sent(msg_size);
+                            if (method) {
+                                method->queued_for(
+                                  clock_type::now() - serialized);
+                            }
                         });
                   })
                   .handle_exception([this](std::exception_ptr e) {
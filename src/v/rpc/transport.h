@@ -46,6 +46,7 @@ public:
         rpc::metrics_disabled disable_metrics = rpc::metrics_disabled::no;
         /// Optional server name indication (SNI) for TLS connection
         std::optional<ss::sstring> tls_sni_hostname;
+        std::chrono::microseconds cork_window{0};
     };
 
     explicit base_transport(configuration c);
@@ -78,6 +79,7 @@ private:
     ss::socket_address _server_addr;
     ss::shared_ptr<ss::tls::certificate_credentials> _creds;
     std::optional<ss::sstring> _tls_sni_hostname;
+    std::chrono::microseconds _cork_window;
 };
 
 class transport final : public base_transport {
@@ -103,12 +105,20 @@ public:
 private:
     friend client_context_impl;
 
+    /// \brief like send(), recording the latencies of the method when set.
+    /// the serialization of the request started at `serialization_start`
+    ss::future<result<std::unique_ptr<streaming_context>>> do_send(
+      netbuf,
+      rpc::client_opts,
+      client_method_probe*,
+      client_method_probe::clock_type::time_point serialization_start);
     ss::future<> do_reads();
     ss::future<> dispatch(header);
     void fail_outstanding_futures() noexcept final;
     void setup_metrics(const std::optional<ss::sstring>&);
 
     ss::semaphore _memory;
+    bool _send_timeouts;
     absl::flat_hash_map<uint32_t, std::unique_ptr<internal::response_handler>>
       _correlations;
     uint32_t _correlation_idx{0};
@@ -141,6 +151,10 @@ result<rpc::client_context<T>> map_result(const header& hdr, T data) {
         return ret_t(errc::method_not_found);
     }
 
+    if (st == status::overloaded) {
+        return ret_t(errc::overloaded);
+    }
+
     return ret_t(errc::service_error);
 }
 } // namespace internal
@@ -151,6 +165,7 @@ transport::send_typed(Input r, uint32_t method_id, rpc::client_opts opts) {
     using ret_t = result<client_context<Output>>;
     _probe.request();
 
+    const auto start = client_method_probe::clock_type::now();
     auto b = std::make_unique<rpc::netbuf>();
     b->set_compression(opts.compression);
     b->set_min_compression_bytes(opts.min_compression_bytes);
@@ -158,8 +173,13 @@ transport::send_typed(Input r, uint32_t method_id, rpc::client_opts opts) {
     raw_b->set_service_method_id(method_id);
     return reflection::async_adl<Input>{}
       .to(raw_b->buffer(), std::move(r))
-      .then([this, b = std::move(b), opts = std::move(opts)]() mutable {
-          return send(std::move(*b), std::move(opts));
+      .then([this,
+             b = std::move(b),
+             opts = std::move(opts),
+             method_id,
+             start]() mutable {
+          return do_send(
+            std::move(*b), std::move(opts), &_probe.method(method_id), start);
       })
       .then([this](result<std::unique_ptr<streaming_context>> sctx) mutable {
           if (!sctx) {
@@ -24,7 +24,7 @@ void crc_one(crc32& crc, T t) {
     crc.extend(args_le);
 }
 
-uint32_t checksum_header_only(const header& h) {
+static crc32 header_crc(const header& h) {
     auto crc = crc32();
     crc_one(
       crc,
@@ -33,6 +33,16 @@ uint32_t checksum_header_only(const header& h) {
     crc_one(crc, h.meta);
     crc_one(crc, h.correlation_id);
     crc_one(crc, h.payload_checksum);
+    return crc;
+}
+
+uint32_t checksum_header_only(const header& h) {
+    return header_crc(h).value();
+}
+
+uint32_t checksum_header_only(const header& h, uint32_t timeout_ms) {
+    auto crc = header_crc(h);
+    crc_one(crc, timeout_ms);
     return crc.value();
 }
 
@@ -47,6 +57,44 @@ std::ostream& operator<<(std::ostream& o, const header& h) {
              << ", payload_checksum:" << h.payload_checksum << "}";
 }
 
+std::ostream& operator<<(std::ostream& o, compression_type c) {
+    switch (c) {
+    case compression_type::none:
+        return o << "none";
+    case compression_type::zstd:
+        return o << "zstd";
+    case compression_type::lz4:
+        return o << "lz4";
+    }
+    return o << "unknown compression_type";
+}
+
+std::optional<compression_type>
+compression_type_from_string(std::string_view s) {
+    if (s == "none") {
+        return compression_type::none;
+    }
+    if (s == "zstd") {
+        return compression_type::zstd;
+    }
+    if (s == "lz4") {
+        return compression_type::lz4;
+    }
+    return std::nullopt;
+}
+
+std::ostream& operator<<(std::ostream& o, traffic_class t) {
+    switch (t) {
+    case traffic_class::control:
+        return o << "control";
+    case traffic_class::replication:
+        return o << "replication";
+    case traffic_class::recovery:
+        return o << "recovery";
+    }
+    return o << "unknown";
+}
+
 std::ostream& operator<<(std::ostream& o, const server_configuration& c) {
     o << "{";
     for (auto& a : c.addrs) {
@@ -54,7 +102,12 @@ std::ostream& operator<<(std::ostream& o, const server_configuration& c) {
     }
     o << ", max_service_memory_per_core: " << c.max_service_memory_per_core
       << ", has_tls_credentials: " << (c.credentials ? "yes" : "no")
-      << ", metrics_enabled:" << !c.disable_metrics;
+      << ", metrics_enabled:" << !c.disable_metrics
+      << ", cork_window_us:" << c.cork_window.count()
+      << ", max_requests_per_method:" << c.max_requests_per_method
+      << ", queue_time_target_ms:" << c.queue_time_target.count()
+      << ", max_connections_per_ip:" << c.max_connections_per_ip
+      << ", max_accepts_per_second:" << c.max_accepts_per_second;
     return o << "}";
 }
 
@@ -68,6 +121,8 @@ std::ostream& operator<<(std::ostream& o, const status& s) {
         return o << "rpc::status::request_timeout";
     case status::server_error:
         return o << "rpc::status::server_error";
+    case status::overloaded:
+        return o << "rpc::status::overloaded";
     default:
         return o << "rpc::status::unknown";
     }
@@ -30,6 +30,8 @@
 #include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <optional>
+#include <string_view>
 #include <type_traits>
 #include <vector>
 
@@ -42,26 +44,38 @@ using timer_type = ss::timer<clock_type>;
 static constexpr clock_type::time_point no_timeout
   = clock_type::time_point::max();
 
+/// \brief the codec of a frame. A server replies with the codec of the
+/// request, or with zstd, which all nodes decode, to uncompressed requests.
+/// A client thus only receives the codecs it sends, and lz4 is only sent to
+/// nodes which decode it
 enum class compression_type : uint8_t {
     none = 0,
     zstd,
+    lz4,
     min = none,
-    max = zstd,
+    max = lz4,
 };
 
 struct negotiation_frame {
     int8_t version = 0;
     /// \brief 0 - no compression
     ///        1 - zstd
+    ///        2 - lz4
     compression_type compression = compression_type::none;
 };
 
+std::ostream& operator<<(std::ostream&, compression_type);
+/// \brief the codec named none, zstd or lz4
+std::optional<compression_type> compression_type_from_string(std::string_view);
+
 /// Response status, we use well known HTTP response codes for readability
 enum class status : uint32_t {
     success = 200,
     method_not_found = 404,
     request_timeout = 408,
     server_error = 500,
+    /// the method shed the request, see method_admission
+    overloaded = 503,
 };
 
 /// \brief core struct for communications. sent with _each_ payload
@@ -98,6 +112,37 @@ static_assert(
 
 uint32_t checksum_header_only(const header& h);
 
+/// \brief bits of header::version. A request with the timeout bit set is
+/// followed by the milliseconds left before the client gives up on it, as a
+/// uint32_t covered by the header checksum, so that the server can drop the
+/// request once nobody waits for its reply. Servers which predate the flag
+/// do not skip the extension, see transport_configuration
+enum class header_flags : uint8_t {
+    timeout = 1,
+};
+static constexpr size_t size_of_rpc_timeout = sizeof(uint32_t);
+
+inline bool has_flag(const header& h, header_flags f) {
+    return h.version & std::underlying_type_t<header_flags>(f);
+}
+
+/// \brief the checksum of a header followed by a timeout extension
+uint32_t checksum_header_only(const header& h, uint32_t timeout_ms);
+
+/// \brief the kind of traffic a request belongs to. a peer may be reached
+/// through a separate connection for each class, see connection_cache
+enum class traffic_class : uint8_t {
+    /// small, latency sensitive requests, e.g. heartbeats and votes
+    control = 0,
+    /// replication of new data
+    replication = 1,
+    /// bulk transfers, e.g. recovery of a follower that fell behind
+    recovery = 2,
+};
+static constexpr size_t traffic_classes = 3;
+
+std::ostream& operator<<(std::ostream&, traffic_class);
+
 struct client_opts {
     client_opts(
       clock_type::time_point client_send_timeout,
@@ -120,6 +165,7 @@ struct client_opts {
     clock_type::time_point timeout;
     compression_type compression;
     size_t min_compression_bytes;
+    traffic_class traffic{traffic_class::control};
 };
 
 /// \brief used to pass environment context to the class
@@ -138,6 +184,12 @@ public:
     /// \brief because we parse the input as a _stream_ we need to signal
     /// to the dispatching thread that it can resume parsing for a new RPC
     virtual void signal_body_parse() = 0;
+    /// \brief the handler produced its output, which is about to be encoded.
+    /// only used to measure the latencies of methods
+    virtual void signal_handler_done() {}
+    /// \brief whether the client already gave up on the reply, in which case
+    /// the request is counted as dropped and should not be handled
+    virtual bool drop_if_expired() { return false; }
 
     /// \brief keep these units until destruction of context.
     /// usually, we want to keep the reservation of the memory size permanently
@@ -158,6 +210,16 @@ private:
 using method = ss::noncopyable_function<ss::future<netbuf>(
   ss::input_stream<char>&, streaming_context&)>;
 
+/// \brief static description of a method, generated along with its service
+struct method_info {
+    uint32_t id;
+    /// service and method, e.g. raftgen::vote
+    std::string_view name;
+    /// requests of the method in flight on a server, 0 takes the
+    /// max_requests_per_method of the server
+    size_t max_in_flight;
+};
+
 /// \brief used in returned types for client::send_typed() calls
 template<typename T>
 struct client_context {
@@ -186,6 +248,18 @@ struct server_configuration {
     // we use the same default as seastar for load balancing algorithm
     ss::server_socket::load_balancing_algorithm load_balancing_algo
       = ss::server_socket::load_balancing_algorithm::connection_distribution;
+    /// delay of the flush of replies to coalesce them, 0 flushes right away
+    std::chrono::microseconds cork_window{0};
+    /// requests of a single method in flight, 0 does not cap them
+    size_t max_requests_per_method{0};
+    /// queue time above which a method sheds requests, 0 never sheds them
+    std::chrono::milliseconds queue_time_target{0};
+    /// connections of a single address open at once on a core, the others
+    /// are closed as soon as they are accepted. 0 does not limit them
+    uint32_t max_connections_per_ip{0};
+    /// connections a core accepts per second, in bursts of up to a second of
+    /// connections. the others are closed right away. 0 does not limit them
+    uint32_t max_accepts_per_second{0};
 
     explicit server_configuration(ss::sstring n)
       : name(std::move(n)) {}
@@ -200,6 +274,12 @@ struct transport_configuration {
     uint32_t max_queued_bytes = std::numeric_limits<uint32_t>::max();
     std::optional<ss::tls::credentials_builder> credentials;
     metrics_disabled disable_metrics = metrics_disabled::no;
+    /// delay of the flush of requests to coalesce them, 0 flushes right away
+    std::chrono::microseconds cork_window{0};
+    /// send the timeout of each request to the server, which drops the
+    /// requests it receives after their client gave up on them. Only to be
+    /// set once every server of the cluster parses the timeout extension
+    bool send_timeouts{false};
 };
 
 std::ostream& operator<<(std::ostream&, const header&);
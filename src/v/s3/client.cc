@@ -0,0 +1,232 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "s3/client.h"
+
+#include "s3/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/do_with.hh>
+#include <seastar/core/loop.hh>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <fmt/format.h>
+
+#include <sstream>
+#include <string>
+
+namespace s3 {
+
+rest_error_response::rest_error_response(
+  boost::beast::http::status status,
+  ss::sstring code,
+  ss::sstring message,
+  ss::sstring resource)
+  : _status(status)
+  , _code(std::move(code))
+  , _message(std::move(message))
+  , _resource(std::move(resource))
+  , _what(fmt::format(
+      "s3 error {} {}: {} ({})",
+      static_cast<unsigned>(status),
+      _code,
+      _message,
+      _resource)) {}
+
+/// Builds the error of a failed request from its xml body, e.g.
+/// <Error><Code>NoSuchKey</Code><Message>...</Message>...</Error>
+static rest_error_response
+parse_rest_error(boost::beast::http::status status, iobuf body) {
+    ss::sstring code;
+    ss::sstring message;
+    ss::sstring resource;
+    if (!body.empty()) {
+        try {
+            std::string xml;
+            xml.reserve(body.size_bytes());
+            for (const auto& f : body) {
+                xml.append(f.get(), f.size());
+            }
+            std::istringstream in(xml);
+            boost::property_tree::ptree tree;
+            boost::property_tree::read_xml(in, tree);
+            code = tree.get<std::string>("Error.Code", "");
+            message = tree.get<std::string>("Error.Message", "");
+            resource = tree.get<std::string>("Error.Resource", "");
+        } catch (const boost::property_tree::ptree_error& e) {
+            vlog(s3_log.debug, "unparsable error body: {}", e.what());
+        }
+    }
+    return rest_error_response(
+      status, std::move(code), std::move(message), std::move(resource));
+}
+
+static ss::future<> drain(
+  const http::client::response_stream_ref& resp,
+  client::body_consumer& consume) {
+    return ss::do_until(
+      [resp] { return resp->is_done(); },
+      [resp, &consume] {
+          return resp->recv_some().then([&consume](iobuf buf) {
+              return buf.empty() ? ss::now() : consume(std::move(buf));
+          });
+      });
+}
+
+/// Reads the response, handing its body out if it has the expected status,
+/// and failing with the error it carries otherwise.
+static ss::future<> read_response(
+  http::client::response_stream_ref resp,
+  boost::beast::http::status expected,
+  client::body_consumer consume) {
+    return ss::do_with(
+      iobuf(),
+      std::move(consume),
+      [resp, expected](iobuf& head, client::body_consumer& consume) {
+          // the parser is eager, body bytes may come with the headers
+          return ss::do_until(
+                   [resp] { return resp->is_header_done(); },
+                   [resp, &head] {
+                       return resp->recv_some().then(
+                         [&head](iobuf buf) { head.append(std::move(buf)); });
+                   })
+            .then([resp, expected, &head, &consume] {
+                auto status = resp->get_headers().result();
+                if (status == expected) {
+                    auto f = head.empty() ? ss::now()
+                                          : consume(std::move(head));
+                    return f.then(
+                      [resp, &consume] { return drain(resp, consume); });
+                }
+                client::body_consumer collect = [&head](iobuf buf) {
+                    head.append(std::move(buf));
+                    return ss::now();
+                };
+                return ss::do_with(
+                  std::move(collect),
+                  [resp, status, &head](client::body_consumer& collect) {
+                      return drain(resp, collect).then([status, &head] {
+                          return ss::make_exception_future<>(
+                            parse_rest_error(status, std::move(head)));
+                      });
+                  });
+            });
+      });
+}
+
+static ss::future<> discard(iobuf) { return ss::now(); }
+
+client::client(const configuration& cfg)
+  : _host(cfg.uri)
+  , _signature(cfg.region, cfg.access_key, cfg.secret_key)
+  , _client(cfg) {}
+
+http::client::request_header client::make_header(
+  boost::beast::http::verb verb,
+  const bucket_name& bucket,
+  const object_key& key,
+  size_t content_length,
+  std::optional<byte_range> range) const {
+    http::client::request_header header;
+    header.method(verb);
+    header.target(fmt::format("/{}/{}", bucket(), key()));
+    header.insert(boost::beast::http::field::host, _host);
+    header.insert(boost::beast::http::field::content_length, content_length);
+    if (range) {
+        header.insert(
+          boost::beast::http::field::range,
+          fmt::format("bytes={}-{}", range->first, range->last));
+    }
+    _signature.sign_header(header);
+    return header;
+}
+
+ss::future<> client::put_object(
+  const bucket_name& bucket,
+  const object_key& key,
+  size_t payload_size,
+  ss::input_stream<char>&& body) {
+    vlog(s3_log.trace, "put_object {}/{} {} bytes", bucket, key, payload_size);
+    auto header = make_header(
+      boost::beast::http::verb::put, bucket, key, payload_size);
+    return ss::do_with(
+      std::move(body),
+      [this, header = std::move(header)](ss::input_stream<char>& body) mutable {
+          return _client.make_request(std::move(header))
+            .then([&body](http::client::request_response_t rr) {
+                auto& [req, resp] = rr;
+                // the first call sends the headers, even without a body
+                return req->send_some(iobuf())
+                  .then([req = req, &body] {
+                      return ss::repeat([req, &body] {
+                          return body.read().then(
+                            [req](ss::temporary_buffer<char> buf) {
+                                if (buf.empty()) {
+                                    return ss::make_ready_future<
+                                      ss::stop_iteration>(
+                                      ss::stop_iteration::yes);
+                                }
+                                iobuf chunk;
+                                chunk.append(std::move(buf));
+                                return req->send_some(std::move(chunk))
+                                  .then([] { return ss::stop_iteration::no; });
+                            });
+                      });
+                  })
+                  .then([req = req] { return req->send_eof(); })
+                  .then([resp = resp] {
+                      return read_response(
+                        resp, boost::beast::http::status::ok, discard);
+                  });
+            })
+            .finally([&body] { return body.close(); });
+      });
+}
+
+ss::future<> client::get_object(
+  const bucket_name& bucket,
+  const object_key& key,
+  body_consumer consume,
+  std::optional<byte_range> range) {
+    vlog(s3_log.trace, "get_object {}/{}", bucket, key);
+    auto header = make_header(
+      boost::beast::http::verb::get, bucket, key, 0, range);
+    auto expected = range ? boost::beast::http::status::partial_content
+                          : boost::beast::http::status::ok;
+    return _client.make_request(std::move(header))
+      .then([expected, consume = std::move(consume)](
+              http::client::request_response_t rr) mutable {
+          auto& [req, resp] = rr;
+          return req->send_some(iobuf())
+            .then([req = req] { return req->send_eof(); })
+            .then(
+              [expected, resp = resp, consume = std::move(consume)]() mutable {
+                  return read_response(resp, expected, std::move(consume));
+              });
+      });
+}
+
+ss::future<>
+client::delete_object(const bucket_name& bucket, const object_key& key) {
+    vlog(s3_log.trace, "delete_object {}/{}", bucket, key);
+    auto header = make_header(boost::beast::http::verb::delete_, bucket, key);
+    return _client.make_request(std::move(header))
+      .then([](http::client::request_response_t rr) {
+          auto& [req, resp] = rr;
+          return req->send_some(iobuf())
+            .then([req = req] { return req->send_eof(); })
+            .then([resp = resp] {
+                return read_response(
+                  resp, boost::beast::http::status::no_content, discard);
+            });
+      });
+}
+
+} // namespace s3
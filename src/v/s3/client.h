@@ -0,0 +1,132 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "http/client.h"
+#include "rpc/transport.h"
+#include "s3/signature.h"
+#include "seastarx.h"
+#include "utils/named_type.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/iostream.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <boost/beast/http/status.hpp>
+
+#include <exception>
+#include <optional>
+
+namespace s3 {
+
+using bucket_name = named_type<ss::sstring, struct s3_bucket_name>;
+using object_key = named_type<ss::sstring, struct s3_object_key>;
+
+/// Connection to an S3 compatible endpoint
+struct configuration : rpc::base_transport::configuration {
+    /// host name of the endpoint, sent in the host header
+    ss::sstring uri;
+    s3::access_key access_key;
+    s3::secret_key secret_key;
+    s3::region region;
+};
+
+/// Inclusive range of bytes of an object
+struct byte_range {
+    size_t first;
+    size_t last;
+};
+
+/// Error returned by the endpoint, with the fields of the xml error body
+class rest_error_response final : public std::exception {
+public:
+    rest_error_response(
+      boost::beast::http::status status,
+      ss::sstring code,
+      ss::sstring message,
+      ss::sstring resource);
+
+    const char* what() const noexcept final { return _what.c_str(); }
+
+    boost::beast::http::status status() const { return _status; }
+    /// e.g. NoSuchKey, empty when the body carried no error
+    const ss::sstring& code() const { return _code; }
+    const ss::sstring& message() const { return _message; }
+
+    bool is_not_found() const {
+        return _status == boost::beast::http::status::not_found;
+    }
+
+private:
+    boost::beast::http::status _status;
+    ss::sstring _code;
+    ss::sstring _message;
+    ss::sstring _resource;
+    ss::sstring _what;
+};
+
+/// S3 REST client, over a single connection
+///
+/// Objects are addressed path style, /bucket/key, and request bodies are
+/// sent unsigned. Like the http::client it is built on, the client sends one
+/// request at a time. Failed requests throw rest_error_response, transport
+/// errors are propagated as is.
+class client {
+public:
+    using body_consumer = ss::noncopyable_function<ss::future<>(iobuf)>;
+
+    explicit client(const configuration& cfg);
+
+    /// \brief Uploads an object
+    ///
+    /// \param payload_size exact number of bytes read from the body
+    /// \param body closed once uploaded
+    ss::future<> put_object(
+      const bucket_name& bucket,
+      const object_key& key,
+      size_t payload_size,
+      ss::input_stream<char>&& body);
+
+    /// \brief Downloads an object, handing its body out in chunks, in order
+    ///
+    /// \param range only these bytes of the object are downloaded
+    ss::future<> get_object(
+      const bucket_name& bucket,
+      const object_key& key,
+      body_consumer consume,
+      std::optional<byte_range> range = std::nullopt);
+
+    /// \brief Removes an object. Removing a missing object succeeds
+    ss::future<>
+    delete_object(const bucket_name& bucket, const object_key& key);
+
+    /// \brief Fails the pending request, if any
+    void shutdown() noexcept { _client.shutdown(); }
+
+    ss::future<> stop() { return _client.stop(); }
+
+private:
+    http::client::request_header make_header(
+      boost::beast::http::verb,
+      const bucket_name&,
+      const object_key&,
+      size_t content_length = 0,
+      std::optional<byte_range> range = std::nullopt) const;
+
+    ss::sstring _host;
+    signature_v4 _signature;
+    http::client _client;
+};
+
+} // namespace s3
@@ -0,0 +1,203 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "s3/signature.h"
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <gnutls/crypto.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <ctime>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace s3 {
+
+using digest = std::array<uint8_t, 32>;
+
+static std::string_view as_view(const digest& d) {
+    return {reinterpret_cast<const char*>(d.data()), d.size()}; // NOLINT
+}
+
+static std::string hex(const digest& d) {
+    static constexpr std::string_view digits = "0123456789abcdef";
+    std::string out;
+    out.reserve(d.size() * 2);
+    for (auto b : d) {
+        out.push_back(digits[b >> 4U]);
+        out.push_back(digits[b & 0xfU]);
+    }
+    return out;
+}
+
+static digest sha256(std::string_view data) {
+    digest out;
+    if (
+      gnutls_hash_fast(
+        GNUTLS_DIG_SHA256, data.data(), data.size(), out.data())
+      < 0) {
+        throw std::runtime_error("sha256 failed");
+    }
+    return out;
+}
+
+static digest hmac(std::string_view key, std::string_view data) {
+    digest out;
+    if (
+      gnutls_hmac_fast(
+        GNUTLS_MAC_SHA256,
+        key.data(),
+        key.size(),
+        data.data(),
+        data.size(),
+        out.data())
+      < 0) {
+        throw std::runtime_error("hmac-sha256 failed");
+    }
+    return out;
+}
+
+ss::sstring sha256_hex(std::string_view data) {
+    auto h = hex(sha256(data));
+    return ss::sstring(h.data(), h.size());
+}
+
+static std::string to_string(boost::beast::string_view v) {
+    return std::string(v.data(), v.size());
+}
+
+/// URI encodes the path of the target, keeping the separators
+static std::string canonical_uri(std::string_view path) {
+    static constexpr std::string_view digits = "0123456789ABCDEF";
+    if (path.empty()) {
+        return "/";
+    }
+    std::string out;
+    out.reserve(path.size());
+    for (char c : path) {
+        if (
+          std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '.'
+          || c == '_' || c == '~' || c == '/') {
+            out.push_back(c);
+        } else {
+            auto b = static_cast<uint8_t>(c);
+            out.push_back('%');
+            out.push_back(digits[b >> 4U]);
+            out.push_back(digits[b & 0xfU]);
+        }
+    }
+    return out;
+}
+
+/// Sorts the parameters of the query, which must already be encoded
+static std::string canonical_query(std::string_view query) {
+    if (query.empty()) {
+        return {};
+    }
+    std::vector<std::string> params;
+    boost::split(params, query, [](char c) { return c == '&'; });
+    for (auto& p : params) {
+        if (p.find('=') == std::string::npos) {
+            p.push_back('=');
+        }
+    }
+    std::sort(params.begin(), params.end());
+    return boost::join(params, "&");
+}
+
+signature_v4::signature_v4(
+  region region, access_key access_key, secret_key secret_key, time_source now)
+  : _region(std::move(region))
+  , _access_key(std::move(access_key))
+  , _secret_key(std::move(secret_key))
+  , _now(std::move(now)) {}
+
+void signature_v4::sign_header(
+  http::client::request_header& header, std::string_view payload_hash) const {
+    static constexpr std::string_view algorithm = "AWS4-HMAC-SHA256";
+    static constexpr std::string_view service = "s3";
+    static constexpr std::string_view terminator = "aws4_request";
+
+    auto tm = fmt::gmtime(std::chrono::system_clock::to_time_t(_now()));
+    auto amz_date = fmt::format("{:%Y%m%dT%H%M%SZ}", tm);
+    auto date = fmt::format("{:%Y%m%d}", tm);
+    header.set("x-amz-date", amz_date);
+    header.set("x-amz-content-sha256", std::string(payload_hash));
+
+    // lower case names, in order, with the values of repeated headers joined
+    std::map<std::string, std::string> headers;
+    for (const auto& f : header) {
+        auto name = boost::to_lower_copy(to_string(f.name_string()));
+        auto value = boost::trim_copy(to_string(f.value()));
+        auto [it, inserted] = headers.emplace(name, value);
+        if (!inserted) {
+            it->second += "," + value;
+        }
+    }
+    std::string canonical_headers;
+    std::vector<std::string> names;
+    names.reserve(headers.size());
+    for (const auto& [name, value] : headers) {
+        canonical_headers += fmt::format("{}:{}\n", name, value);
+        names.push_back(name);
+    }
+    auto signed_headers = boost::join(names, ";");
+
+    auto target = to_string(header.target());
+    auto q = target.find('?');
+    auto path = std::string_view(target).substr(0, q);
+    auto query = q == std::string::npos
+                   ? std::string_view{}
+                   : std::string_view(target).substr(q + 1);
+
+    auto canonical_request = fmt::format(
+      "{}\n{}\n{}\n{}\n{}\n{}",
+      to_string(header.method_string()),
+      canonical_uri(path),
+      canonical_query(query),
+      canonical_headers,
+      signed_headers,
+      payload_hash);
+
+    auto scope = fmt::format(
+      "{}/{}/{}/{}", date, _region(), service, terminator);
+    auto string_to_sign = fmt::format(
+      "{}\n{}\n{}\n{}",
+      algorithm,
+      amz_date,
+      scope,
+      hex(sha256(canonical_request)));
+
+    auto key = hmac(fmt::format("AWS4{}", _secret_key()), date);
+    key = hmac(as_view(key), _region());
+    key = hmac(as_view(key), service);
+    key = hmac(as_view(key), terminator);
+    auto signature = hex(hmac(as_view(key), string_to_sign));
+
+    header.set(
+      boost::beast::http::field::authorization,
+      fmt::format(
+        "{} Credential={}/{},SignedHeaders={},Signature={}",
+        algorithm,
+        _access_key(),
+        scope,
+        signed_headers,
+        signature));
+}
+
+} // namespace s3
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "http/client.h"
+#include "seastarx.h"
+#include "utils/named_type.h"
+
+#include <seastar/core/sstring.hh>
+
+#include <chrono>
+#include <functional>
+#include <string_view>
+
+namespace s3 {
+
+using access_key = named_type<ss::sstring, struct s3_access_key>;
+using secret_key = named_type<ss::sstring, struct s3_secret_key>;
+using region = named_type<ss::sstring, struct s3_region>;
+
+/// Payload hash of requests whose body is not signed
+inline constexpr std::string_view unsigned_payload = "UNSIGNED-PAYLOAD";
+
+/// Signs requests with AWS signature version 4
+///
+/// The host header must be set before the request is signed. The
+/// x-amz-date and x-amz-content-sha256 headers are added, and every header
+/// of the request is signed.
+class signature_v4 {
+public:
+    using time_source = std::function<std::chrono::system_clock::time_point()>;
+
+    signature_v4(
+      region region,
+      access_key access_key,
+      secret_key secret_key,
+      time_source now = &std::chrono::system_clock::now);
+
+    /// \brief Adds the authorization header of the request
+    ///
+    /// \param header the request, with all the headers that are sent
+    /// \param payload_hash hex encoded sha256 of the body or unsigned_payload
+    void sign_header(
+      http::client::request_header& header,
+      std::string_view payload_hash = unsigned_payload) const;
+
+private:
+    region _region;
+    access_key _access_key;
+    secret_key _secret_key;
+    time_source _now;
+};
+
+/// Hex encoded sha256 of the data, e.g. for the x-amz-content-sha256 header
+ss::sstring sha256_hex(std::string_view data);
+
+} // namespace s3
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "seastarx.h"
+#include "storage/flush_coordinator.h"
 #include "storage/kvstore.h"
 #include "storage/log_manager.h"
 
@@ -27,13 +28,14 @@ public:
         _kvstore = std::make_unique<kvstore>(_kv_conf);
         return _kvstore->start().then([this] {
             _log_mgr = std::make_unique<log_manager>(_log_conf, kvs());
+            return _log_mgr->start();
         });
     }
 
     ss::future<> stop() {
-        auto f = ss::now();
+        auto f = _flush_coordinator.stop();
         if (_log_mgr) {
-            f = _log_mgr->stop();
+            f = f.then([this] { return _log_mgr->stop(); });
         }
         if (_kvstore) {
             return f.then([this] { return _kvstore->stop(); });
@@ -43,6 +45,7 @@ public:
 
     kvstore& kvs() { return *_kvstore; }
     log_manager& log_mgr() { return *_log_mgr; }
+    flush_coordinator& flush_coord() { return _flush_coordinator; }
 
 private:
     kvstore_config _kv_conf;
@@ -50,6 +53,7 @@ private:
 
     std::unique_ptr<kvstore> _kvstore;
     std::unique_ptr<log_manager> _log_mgr;
+    flush_coordinator _flush_coordinator;
 };
 
 } // namespace storage
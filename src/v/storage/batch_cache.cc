@@ -11,10 +11,12 @@
 
 #include "vassert.h"
 
+#include <seastar/core/future-util.hh>
+
 namespace storage {
 
-batch_cache::entry_ptr
-batch_cache::put(batch_cache_index& index, const model::record_batch& input) {
+batch_cache::entry_ptr batch_cache::put(
+  batch_cache_index& index, const model::record_batch& input, bool read_ahead) {
 #ifdef SEASTAR_DEFAULT_ALLOCATOR
     static const size_t threshold = ss::memory::stats().total_memory() * .2;
     while (_size_bytes > threshold) {
@@ -25,19 +27,56 @@ batch_cache::put(batch_cache_index& index, const model::record_batch& input) {
     // temporary buffers
     auto batch = input.copy();
     _size_bytes += batch.memory_usage();
-    auto e = new entry(index, std::move(batch));
+    _probe.put(batch.memory_usage(), read_ahead);
+    auto e = new entry(index, std::move(batch), read_ahead);
 
     // if weak_from_this were to cause an allocation--which it shouldn't--`e`
-    // wouldn't be visible to the reclaimer since it isn't on a lru/pool list.
+    // wouldn't be visible to the reclaimer since it isn't on a lru list.
     auto p = e->weak_from_this();
-    _lru.push_back(*e);
+    _probationary.push_back(*e);
     return p;
 }
 
+void batch_cache::touch(entry_ptr& e) {
+    if (!e) {
+        return;
+    }
+    auto p = e.get();
+    p->_hook.unlink();
+    if (p->_protected) {
+        _protected.push_back(*p);
+        return;
+    }
+    if (p->_read_ahead) {
+        // the reader that prefetched the batch is consuming it
+        p->_read_ahead = false;
+        _probationary.push_back(*p);
+        return;
+    }
+    p->_protected = true;
+    _protected_bytes += p->_batch.memory_usage();
+    _probe.promoted();
+    _protected.push_back(*p);
+    maybe_demote();
+}
+
+void batch_cache::maybe_demote() {
+    const auto max_protected = static_cast<size_t>(
+      static_cast<double>(_size_bytes) * max_protected_ratio);
+    while (_protected_bytes > max_protected && !_protected.empty()) {
+        auto& e = _protected.front();
+        e._hook.unlink();
+        e._protected = false;
+        _protected_bytes -= e._batch.memory_usage();
+        _probationary.push_back(e);
+        _probe.demoted();
+    }
+}
+
 batch_cache::~batch_cache() noexcept {
     clear();
     vassert(
-      _size_bytes == 0 && _lru.empty(),
+      _size_bytes == 0 && _protected_bytes == 0 && empty(),
       "Detected incorrect batch_cache accounting. {}",
       *this);
 }
@@ -49,8 +88,13 @@ void batch_cache::evict(entry_ptr&& e) {
         // r-value reference `e` wouldn't do that.
         auto p = std::exchange(e, {});
         _size_bytes -= p->_batch.memory_usage();
-        _lru.erase_and_dispose(
-          _lru.iterator_to(*p), [](entry* e) { delete e; });
+        _probe.evicted();
+        if (p->_protected) {
+            _protected_bytes -= p->_batch.memory_usage();
+        }
+        auto& list = p->_protected ? _protected : _probationary;
+        list.erase_and_dispose(
+          list.iterator_to(*p), [](entry* e) { delete e; });
     }
 }
 
@@ -59,6 +103,7 @@ size_t batch_cache::reclaim(size_t size) {
         return 0;
     }
     batch_reclaiming_lock lock(*this);
+    _probe.reclaim();
 
     /*
      * if the time since the last reclaim is < `reclaim_growth_window` --
@@ -77,6 +122,84 @@ size_t batch_cache::reclaim(size_t size) {
     _reclaim_size = std::min(_reclaim_size, _reclaim_opts.max_size);
     _reclaim_size = std::max(size, _reclaim_size);
 
+    /*
+     * the probationary list is reclaimed first so that scans of the log do not
+     * evict batches that have been read from the cache.
+     */
+    lru_list reclaimed_entries;
+    size_t reclaimed = reclaim_from(
+      _probationary, _reclaim_size, reclaimed_entries);
+    if (reclaimed < _reclaim_size) {
+        reclaimed += reclaim_from(
+          _protected, _reclaim_size - reclaimed, reclaimed_entries);
+    }
+
+    /*
+     * final removal from the index is deferred because there is some chance
+     * that removal allocates, so waiting until the bulk of the reclaims have
+     * occurred reduces the probability of an allocation failure.
+     */
+    reclaimed_entries.clear_and_dispose([](entry* e) {
+        auto offset = e->_batch.base_offset();
+        auto* index = &e->_index;
+        delete e; // NOLINT
+
+        /*
+         * since reclaim may be invoked at any moment and removals may be
+         * deferred if an index is locked, one can imagine races in which a
+         * batch is removed by offset here which is not the same batch that was
+         * reclaimed in a prior pass. at worst this would raise the miss ratio,
+         * but is still generally safe since all batch cache users are prepared
+         * to handle a miss.
+         */
+        index->remove(offset);
+    });
+
+    _last_reclaim = ss::lowres_clock::now();
+    _size_bytes -= reclaimed;
+    return reclaimed;
+}
+
+batch_cache::reclaim_result batch_cache::record_pressure(size_t size) {
+    _reclaim_pressure += size;
+    _probe.reclaim_pressure();
+    if (!_background_reclaim_running && !_background_reclaim_gate.is_closed()) {
+        _background_reclaim_running = true;
+        (void)ss::with_gate(
+          _background_reclaim_gate, [this] { return background_reclaim(); });
+    }
+    // nothing is freed by the upcall itself
+    return reclaim_result::reclaimed_nothing;
+}
+
+ss::future<> batch_cache::background_reclaim() {
+    return ss::do_until(
+             [this] {
+                 return _reclaim_pressure == 0
+                        || _background_reclaim_gate.is_closed();
+             },
+             [this] {
+                 const auto step = std::min(
+                   _reclaim_pressure, _reclaim_opts.max_size);
+                 const auto reclaimed = reclaim(step);
+                 /*
+                  * an empty cache, or one holding only pinned entries, cannot
+                  * make progress. drop the pressure instead of spinning, the
+                  * next upcall will record it again if memory is still low.
+                  */
+                 if (reclaimed == 0) {
+                     _reclaim_pressure = 0;
+                 } else {
+                     _reclaim_pressure -= std::min(
+                       _reclaim_pressure, reclaimed);
+                 }
+                 return ss::later();
+             })
+      .finally([this] { _background_reclaim_running = false; });
+}
+
+size_t
+batch_cache::reclaim_from(lru_list& list, size_t size, lru_list& reclaimed) {
     /*
      * reclaiming is a two pass process. given that the entry isn't pinned (in
      * which case it is skipped), the first step is to reclaim the batch's
@@ -86,23 +209,27 @@ size_t batch_cache::reclaim(size_t size) {
      * invalidated. invalidation is important because the batch reference in the
      * index still exists even though the batch data was removed.
      */
-    size_t reclaimed = 0;
-    intrusive_list<entry, &entry::_hook> reclaimed_entries;
+    size_t reclaimed_bytes = 0;
 
-    for (auto it = _lru.begin(); it != _lru.end();) {
-        if (reclaimed >= _reclaim_size) {
+    for (auto it = list.begin(); it != list.end();) {
+        if (reclaimed_bytes >= size) {
             break;
         }
 
         // skip any entry that has a live reference.
         if (unlikely(it->pinned())) {
+            _probe.reclaim_skip_pinned();
             ++it;
             continue;
         }
 
         // reclaim the batch's record data
-        reclaimed += it->_batch.memory_usage();
+        const auto usage = it->_batch.memory_usage();
         it->_batch.clear_data();
+        const auto freed = usage - it->_batch.memory_usage();
+        if (it->_protected) {
+            _protected_bytes -= usage;
+        }
 
         /*
          * if the owning index is locked invalidate the entry but leave it on
@@ -110,42 +237,25 @@ size_t batch_cache::reclaim(size_t size) {
          * iterators on the index.
          */
         if (unlikely(it->_index.locked())) {
-            reclaimed -= it->_batch.memory_usage();
+            reclaimed_bytes += freed;
+            if (it->_protected) {
+                _protected_bytes += it->_batch.memory_usage();
+            }
             it->invalidate();
+            _probe.reclaim_deferred();
             ++it;
             continue;
         }
 
         // collect the entries that will be fully removed
-        it = _lru.erase_and_dispose(it, [&reclaimed_entries](entry* e) {
-            reclaimed_entries.push_back(*e);
-        });
+        reclaimed_bytes += usage;
+        _probe.reclaimed(usage);
+        it->_protected = false;
+        it = list.erase_and_dispose(
+          it, [&reclaimed](entry* e) { reclaimed.push_back(*e); });
     }
 
-    /*
-     * final removal from the index is deferred because there is some chance
-     * that removal allocates, so waiting until the bulk of the reclaims have
-     * occurred reduces the probability of an allocation failure.
-     */
-    reclaimed_entries.clear_and_dispose([](entry* e) {
-        auto offset = e->_batch.base_offset();
-        auto* index = &e->_index;
-        delete e; // NOLINT
-
-        /*
-         * since reclaim may be invoked at any moment and removals may be
-         * deferred if an index is locked, one can imagine races in which a
-         * batch is removed by offset here which is not the same batch that was
-         * reclaimed in a prior pass. at worst this would raise the miss ratio,
-         * but is still generally safe since all batch cache users are prepared
-         * to handle a miss.
-         */
-        index->remove(offset);
-    });
-
-    _last_reclaim = ss::lowres_clock::now();
-    _size_bytes -= reclaimed;
-    return reclaimed;
+    return reclaimed_bytes;
 }
 
 std::optional<model::record_batch>
@@ -155,8 +265,10 @@ batch_cache_index::get(model::offset offset) {
         batch_cache::entry::lock_guard g(*it->second);
         _cache->touch(it->second);
         auto ret = it->second->batch().share();
+        _cache->probe().hit();
         return ret;
     }
+    _cache->probe().miss();
     return std::nullopt;
 }
 
@@ -225,6 +337,11 @@ batch_cache_index::read_result batch_cache_index::read(
         }
     }
     ret.next_batch = offset;
+    if (ret.batches.empty()) {
+        _cache->probe().miss();
+    } else {
+        _cache->probe().hit();
+    }
     return ret;
 }
 
@@ -246,10 +363,12 @@ void batch_cache_index::truncate(model::offset offset) {
 
 std::ostream& operator<<(std::ostream& o, const batch_cache& b) {
     // NOTE: intrusive list have a O(N) for size.
-    // Do _not_ print size of _lru
+    // Do _not_ print size of the lru lists
     return o << "{is_reclaiming:" << b.is_memory_reclaiming()
+             << ", reclaim_pressure: " << b._reclaim_pressure
              << ", size_bytes: " << b._size_bytes
-             << ", lru_empty:" << b._lru.empty() << "}";
+             << ", protected_bytes: " << b._protected_bytes
+             << ", lru_empty:" << b.empty() << "}";
 }
 std::ostream&
 operator<<(std::ostream& o, const batch_cache_index::read_result& c) {
@@ -12,10 +12,13 @@
 #pragma once
 #include "config/configuration.h"
 #include "model/record.h"
+#include "storage/batch_cache_probe.h"
 #include "utils/intrusive_list_helpers.h"
 #include "vassert.h"
 
 #include <seastar/core/circular_buffer.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
 #include <seastar/core/lowres_clock.hh>
 #include <seastar/core/memory.hh>
 #include <seastar/core/weak_ptr.hh>
@@ -32,9 +35,9 @@ class batch_cache_index;
 
 /**
  * The batch cache system consists of two components. The `batch_cache` is a
- * global (per-shard) LRU cache of batches stored in memory. The second
- * component is the `batch_cache_index` which presents an offset-based index
- * into the global cache.
+ * global (per-shard) segmented LRU cache of batches stored in memory. The
+ * second component is the `batch_cache_index` which presents an offset-based
+ * index into the global cache.
  *
  *    ┌per-shard lru cache──────────────────────────────────────────────┐
  *    │           ┌─────┐    ┌─────┐         ┌─────┐                    │
@@ -51,6 +54,21 @@ class batch_cache_index;
  * example, a batch cache index is created for each log segment, all of which
  * share the same LRU cache.
  *
+ * Scan resistance
+ * ===============
+ *
+ * The LRU is segmented in a probationary and a protected list. Batches enter
+ * the cache at the tail of the probationary list and are promoted to the
+ * protected list when they are read from the cache. The protected list is
+ * bounded to a fraction of the cache and its least recently used batches are
+ * demoted back to the probationary list. Reclaim evicts from the probationary
+ * list first, so a consumer replaying history only churns the probationary
+ * list while the batches read by tailing consumers stay protected.
+ *
+ * Batches inserted by reader read-ahead are expected to be read exactly once
+ * by the reader that prefetched them. The first hit on such a batch keeps it
+ * on the probationary list, and only a later hit promotes it.
+ *
  * The LRU cache serves as an entry point for the Seastar memory reclaimer.
  * During a low-memory event Seastar may make an upcall to the LRU cache to free
  * memory. When memory is reclaimed cache entries are invalidated. Since this
@@ -81,20 +99,34 @@ class batch_cache_index;
  * If an operation may perform an allocation use entry::pin/unpin to guard the
  * reference which will force the reclaimer to skip the entry.
  *
+ * Background reclaim
+ * ==================
+ *
+ * When `reclaim_options::background` is set the cache registers an
+ * asynchronous reclaimer instead. Seastar then makes the low-memory upcall from
+ * a reactor task rather than from inside an allocation, and the upcall only
+ * records the amount of memory requested. A background fiber evicts the
+ * requested amount in steps bounded by `reclaim_options::max_size`, yielding
+ * between steps. Cache operations never observe a reclaim in this mode, so
+ * their allocations are safe and reclaim cost is spread out. The trade-off is
+ * that an allocation which runs out of memory cannot free cache memory
+ * synchronously, so this mode relies on the free memory reserve kept by
+ * Seastar to absorb allocations until the fiber catches up.
+ *
  * IMPORTANT: this is a viral leaky abstraction solution. it relies on all code
  * paths whose call sites are inside the batch cache to have their allocation
  * behavior known. that is generally an aspect of interfaces that are never
  * guaranteed. so, good luck. if you find yourself with mysterious crashes in
  * the future, consider other solutions like blocking the reclaimer or only
  * allowing asynchronous reclaims while executing within the batch catch.
- *
- * TODO:
- *  - add probes to track statistics
  */
 class batch_cache {
     /// Minimum size reclaimed in low-memory situations.
     static constexpr size_t min_reclaim_size = 128 << 10;
 
+    /// Maximum share of the cache memory held by the protected list.
+    static constexpr double max_protected_ratio = 0.8;
+
     using reclaimer = ss::memory::reclaimer;
     using reclaim_scope = ss::memory::reclaimer_scope;
     using reclaim_result = ss::memory::reclaiming_result;
@@ -105,12 +137,17 @@ public:
         ss::lowres_clock::duration stable_window;
         size_t min_size;
         size_t max_size;
+        // record pressure in low-memory upcalls and reclaim in the background
+        bool background{false};
+        // larger batches are not cached. caching copies the batch, which
+        // for a batch of a large message doubles its footprint on the write
+        // path, and such batches are rarely read back from memory.
+        std::optional<size_t> max_batch_size{std::nullopt};
     };
 
     /*
      * An entry manages the lifetime of a cached record batch, and always exists
-     * in either the LRU or the free pool. Any batches stored in the free pool
-     * are in an undefined state.
+     * in either the probationary or the protected LRU list.
      */
     class entry : private ss::weakly_referencable<entry> {
     public:
@@ -130,8 +167,12 @@ public:
             entry& _e;
         };
 
-        explicit entry(batch_cache_index& index, model::record_batch&& batch)
+        entry(
+          batch_cache_index& index,
+          model::record_batch&& batch,
+          bool read_ahead)
           : _batch(std::move(batch))
+          , _read_ahead(read_ahead)
           , _index(index) {}
 
         ~entry() noexcept = default;
@@ -165,6 +206,10 @@ public:
         model::record_batch _batch;
 
         bool _pinned{false};
+        // inserted by read-ahead and not yet read
+        bool _read_ahead;
+        // on the protected list
+        bool _protected{false};
         intrusive_list_hook _hook;
         batch_cache_index& _index;
     };
@@ -174,7 +219,7 @@ public:
     batch_cache(const reclaim_options& opts)
       : _reclaimer(
         [this](reclaimer::request r) { return reclaim(r); },
-        reclaim_scope::sync)
+        opts.background ? reclaim_scope::async : reclaim_scope::sync)
       , _reclaim_opts(opts) {}
 
     batch_cache(const batch_cache&) = delete;
@@ -186,63 +231,88 @@ public:
      * it). the reason is that the reclaimer registers/deregisters itself using
      * `this` as a key in its constructor/destructor which aren't properly
      * balanced for these cases. the reclaimer needs to be fully recreated here,
-     * and the moved from reclaimer will deregister itself properly.
+     * and the moved from reclaimer will deregister itself properly. for the
+     * same reason the probe, whose metrics refer to `this`, is not moved.
+     * caches are moved before they are used, so there is no pending background
+     * reclaim to carry over.
      */
     batch_cache(batch_cache&& o) noexcept
-      : _lru(std::move(o._lru))
+      : _probationary(std::move(o._probationary))
+      , _protected(std::move(o._protected))
       , _reclaimer(
           [this](reclaimer::request r) { return reclaim(r); },
-          reclaim_scope::sync)
+          o._reclaim_opts.background ? reclaim_scope::async
+                                     : reclaim_scope::sync)
       , _is_reclaiming(o._is_reclaiming)
       , _size_bytes(o._size_bytes)
+      , _protected_bytes(o._protected_bytes)
       , _reclaim_opts(o._reclaim_opts) {
         o._size_bytes = 0;
+        o._protected_bytes = 0;
         o._is_reclaiming = false;
     }
 
     ~batch_cache() noexcept;
 
+    /// Stop reclaiming in the background and wait for a running reclaim.
+    ss::future<> stop() { return _background_reclaim_gate.close(); }
+
+    /// The smallest reclaim, from the next reclaim on.
+    void set_reclaim_min_size(size_t min_size) {
+        _reclaim_opts.min_size = min_size;
+    }
+
+    /// Whether the batch fits the size limit of the cached batches.
+    bool admits(const model::record_batch& batch) const {
+        return !_reclaim_opts.max_batch_size
+               || batch.size_bytes() <= *_reclaim_opts.max_batch_size;
+    }
+
+    /// Current memory usage of the cached batches.
+    size_t size_bytes() const { return _size_bytes; }
+
+    /// Current memory usage of the batches on the protected list.
+    size_t protected_bytes() const { return _protected_bytes; }
+
+    batch_cache_probe& probe() { return _probe; }
+    const batch_cache_probe& probe() const { return _probe; }
+
     /// Returns true if the cache is empty, and false otherwise.
-    bool empty() const { return _lru.empty(); }
+    bool empty() const { return _probationary.empty() && _protected.empty(); }
 
     /// Removes all entries from the cache and entry pool.
     void clear() { reclaim(std::numeric_limits<size_t>::max()); }
 
     /**
-     * Copies a batch into the LRU cache.
+     * Copies a batch into the probationary LRU list.
      * Copying is needed to release memory references of underlying tempbufs.
+     * Set `read_ahead` when the batch is inserted ahead of the reader that is
+     * expected to read it.
      *
      * The returned weak_ptr will be invalidated if its memory is reclaimed. To
      * evict the entry, move it into batch_cache::evict().
      */
-    entry_ptr put(batch_cache_index&, const model::record_batch&);
+    entry_ptr put(
+      batch_cache_index&, const model::record_batch&, bool read_ahead = false);
 
     /**
      * \brief Remove a batch from the cache.
      *
      * Memory associated with the batch is released and the cache entry is
-     * returned to the free pool.
+     * deleted.
      *
-     * It is important that this interface act as a sink. Since we are moving
-     * the cache entries into the free pool this means that the weak_ptr
-     * invalidation does not trigger. This is still safe because the caching
-     * interface forces an the caller to give up its entry reference, as well as
-     * preventing multiple weak_ptr references to the same entry.  This is not
-     * relevant for the reclaim interface. Reclaim fully deletes cache entries
-     * which does invoke weak_ptr invalidation.
+     * It is important that this interface act as a sink. The caching interface
+     * forces the caller to give up its entry reference, preventing multiple
+     * weak_ptr references to the same entry.
      */
     void evict(entry_ptr&& e);
 
     /**
-     * Notify the cache that the specified entry was recently used.
+     * Notify the cache that the specified entry was recently used. An entry
+     * on the probationary list is promoted to the protected list, unless this
+     * is the first read of a batch inserted by read-ahead.
      */
-    void touch(entry_ptr& e) {
-        if (e) {
-            auto p = e.get();
-            p->_hook.unlink();
-            _lru.push_back(*p);
-        }
-    }
+    void touch(entry_ptr& e);
 
     /**
      * \brief Evict batches up to the accumulated size specified.
@@ -276,14 +346,17 @@ private:
     };
     friend batch_reclaiming_lock;
     /*
-     * The entry point for the Seastar upcall for relcaiming memory. The
-     * reclaimer is configured to perform the upcall asynchronously in a new
-     * fiber. A more advanced usage that is allowed to invoke reclaim
-     * synchronously with memory allocation is also possible.
+     * The entry point for the Seastar upcall for relcaiming memory. By default
+     * the upcall is made synchronously with memory allocation and reclaims
+     * immediately. In background mode the upcall is made from a reactor task
+     * and only records the request for the background fiber.
      */
     ss::memory::reclaiming_result reclaim(reclaimer::request r) {
         const size_t lower_bound = std::max(
           r.bytes_to_reclaim, min_reclaim_size);
+        if (_reclaim_opts.background) {
+            return record_pressure(lower_bound);
+        }
         // _attempt_ to reclaim lower_bound. stop at greater than or equal to
         // lower_bound
         const size_t reclaimed = reclaim(lower_bound);
@@ -291,15 +364,38 @@ private:
                               : reclaim_result::reclaimed_nothing;
     }
 
-    intrusive_list<entry, &entry::_hook> _lru;
+    /// Record a reclaim request and make sure the background fiber runs.
+    reclaim_result record_pressure(size_t size);
+
+    /// Reclaim the recorded pressure in bounded steps.
+    ss::future<> background_reclaim();
+
+    using lru_list = intrusive_list<entry, &entry::_hook>;
+
+    /// Move the least recently used protected entries to the probationary
+    /// list until the protected list fits in its share of the cache.
+    void maybe_demote();
+
+    /// Reclaim up to `size` bytes from `list` into `reclaimed_entries`.
+    size_t reclaim_from(lru_list& list, size_t size, lru_list& reclaimed);
+
+    lru_list _probationary;
+    lru_list _protected;
     reclaimer _reclaimer;
     bool _is_reclaiming{false};
     size_t _size_bytes{0};
+    size_t _protected_bytes{0};
+    batch_cache_probe _probe;
 
     reclaim_options _reclaim_opts;
     ss::lowres_clock::time_point _last_reclaim;
     size_t _reclaim_size;
 
+    // bytes requested by upcalls and not yet reclaimed in the background
+    size_t _reclaim_pressure{0};
+    bool _background_reclaim_running{false};
+    ss::gate _background_reclaim_gate;
+
     friend std::ostream& operator<<(std::ostream&, const batch_cache&);
 };
 
@@ -332,8 +428,12 @@ public:
 
     bool empty() const { return _index.empty(); }
 
-    void put(const model::record_batch& batch) {
+    void put(const model::record_batch& batch, bool read_ahead = false) {
         lock_guard lk(*this);
+        if (unlikely(!_cache->admits(batch))) {
+            _cache->probe().skip_oversized();
+            return;
+        }
         auto offset = batch.header().base_offset;
         if (likely(!_index.contains(offset))) {
             /*
@@ -342,11 +442,22 @@ public:
              * entries are initialized in the cache and index, clean-up happens
              * correctly on either side.
              */
-            auto p = _cache->put(*this, batch);
+            auto p = _cache->put(*this, batch, read_ahead);
             _index.emplace(offset, std::move(p));
         }
     }
 
+    /**
+     * Evicts the batch at the specified base offset, if it is cached.
+     */
+    void evict(model::offset base_offset) {
+        lock_guard lk(*this);
+        if (auto it = _index.find(base_offset); it != _index.end()) {
+            _cache->evict(std::move(it->second));
+            _index.erase(it);
+        }
+    }
+
     /**
      * Return the batch containing the specified offset, if one exists.
      */
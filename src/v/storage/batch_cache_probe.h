@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include <seastar/core/metrics_registration.hh>
+
+#include <cstdint>
+
+namespace storage {
+
+class batch_cache;
+
+/*
+ * Per-shard batch cache statistics. Per-partition cache hits and misses are
+ * tracked by the partition's storage::probe.
+ */
+class batch_cache_probe {
+public:
+    void hit() { ++_hits; }
+    void miss() { ++_misses; }
+
+    void put(uint64_t bytes, bool read_ahead) {
+        ++_puts;
+        if (read_ahead) {
+            ++_read_ahead_puts;
+        }
+        _put_bytes += bytes;
+    }
+
+    // the batch was larger than the cached batches may be
+    void skip_oversized() { ++_oversized_skips; }
+
+    void promoted() { ++_promotions; }
+    void demoted() { ++_demotions; }
+    void evicted() { ++_evictions; }
+
+    void reclaim() { ++_reclaims; }
+    void reclaimed(uint64_t bytes) {
+        ++_reclaimed_batches;
+        _reclaimed_bytes += bytes;
+    }
+    uint64_t reclaimed_bytes() const { return _reclaimed_bytes; }
+    // reclaim skipped an entry holding a live reference
+    void reclaim_skip_pinned() { ++_reclaim_skipped_pinned; }
+    // reclaim released the data of an entry of a locked index
+    void reclaim_deferred() { ++_reclaim_deferred; }
+    // low-memory upcall deferred to the background reclaimer
+    void reclaim_pressure() { ++_reclaim_pressure_upcalls; }
+
+    /*
+     * Register the metrics of a batch cache. Metrics are per-shard, so only
+     * the shard's main batch cache should register them.
+     */
+    void setup_metrics(const batch_cache&);
+
+private:
+    uint64_t _hits = 0;
+    uint64_t _misses = 0;
+    uint64_t _puts = 0;
+    uint64_t _read_ahead_puts = 0;
+    uint64_t _put_bytes = 0;
+    uint64_t _oversized_skips = 0;
+    uint64_t _promotions = 0;
+    uint64_t _demotions = 0;
+    uint64_t _evictions = 0;
+    uint64_t _reclaims = 0;
+    uint64_t _reclaimed_batches = 0;
+    uint64_t _reclaimed_bytes = 0;
+    uint64_t _reclaim_skipped_pinned = 0;
+    uint64_t _reclaim_deferred = 0;
+    uint64_t _reclaim_pressure_upcalls = 0;
+    ss::metrics::metric_groups _metrics;
+};
+
+} // namespace storage
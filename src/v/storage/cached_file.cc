@@ -0,0 +1,243 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/cached_file.h"
+
+#include "config/configuration.h"
+#include "likely.h"
+#include "storage/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/fstream.hh>
+
+namespace storage {
+
+/*
+ * Open handles of this shard that may be closed, in least recently used
+ * order.
+ */
+struct cached_file::lru {
+    intrusive_list<cached_file, &cached_file::_hook> files;
+    size_t size{0};
+    stats st;
+
+    static lru& get() {
+        static thread_local lru l;
+        return l;
+    }
+
+    void touch(cached_file& f) {
+        if (f._hook.is_linked()) {
+            f._hook.unlink();
+            files.push_back(f);
+        }
+    }
+
+    void insert(cached_file& f) {
+        files.push_back(f);
+        ++size;
+        trim(f);
+    }
+
+    void erase(cached_file& f) {
+        if (f._hook.is_linked()) {
+            f._hook.unlink();
+            --size;
+        }
+    }
+
+    /*
+     * close the least recently used handles over the limit, except those in
+     * use, which are closed on a later trim if still over it, and the one
+     * that was just opened.
+     */
+    void trim(const cached_file& opened) {
+        const size_t max
+          = config::shard_local_cfg().max_open_segment_files();
+        for (auto it = files.begin(); size > max && it != files.end();) {
+            auto& f = *it++;
+            if (&f == &opened || f._users > 0) {
+                continue;
+            }
+            erase(f);
+            f.evict();
+        }
+    }
+};
+
+/*
+ * Opens the file on the first read of the stream, and holds a use of the
+ * handle until the stream is destroyed.
+ */
+class cached_file::lazy_data_source final : public ss::data_source_impl {
+public:
+    lazy_data_source(
+      cached_file_ptr f,
+      uint64_t pos,
+      uint64_t len,
+      ss::file_input_stream_options opts)
+      : _use(f)
+      , _file(std::move(f))
+      , _pos(pos)
+      , _len(len)
+      , _opts(std::move(opts)) {}
+
+    ss::future<ss::temporary_buffer<char>> get() final {
+        if (_source) {
+            return _source->get();
+        }
+        return open().then([this] { return _source->get(); });
+    }
+
+    ss::future<ss::temporary_buffer<char>> skip(uint64_t n) final {
+        if (_source) {
+            return _source->skip(n);
+        }
+        // skipped without reading the skipped bytes
+        const auto skipped = std::min(n, _len);
+        _pos += skipped;
+        _len -= skipped;
+        return get();
+    }
+
+    ss::future<> close() final {
+        if (_source) {
+            return _source->close();
+        }
+        return ss::now();
+    }
+
+private:
+    ss::future<> open() {
+        return _file->get().then([this](ss::file fd) {
+            _source.emplace(ss::make_file_data_source(
+              std::move(fd), _pos, _len, std::move(_opts)));
+        });
+    }
+
+    use _use;
+    cached_file_ptr _file;
+    uint64_t _pos;
+    uint64_t _len;
+    ss::file_input_stream_options _opts;
+    std::optional<ss::data_source> _source;
+};
+
+cached_file::cached_file(ss::sstring name, opener open)
+  : _name(std::move(name))
+  , _open(std::move(open)) {}
+
+cached_file::cached_file(ss::sstring name, ss::file f)
+  : _name(std::move(name))
+  , _file(std::move(f))
+  , _pinned(true)
+  , _reopenable(false) {
+    ++lru::get().st.open;
+}
+
+cached_file::~cached_file() noexcept {
+    lru::get().erase(*this);
+    if (_file) {
+        --lru::get().st.open;
+    }
+}
+
+const cached_file::stats& cached_file::shard_stats() { return lru::get().st; }
+
+void cached_file::pin() {
+    _pinned = true;
+    lru::get().erase(*this);
+}
+
+void cached_file::unpin() {
+    if (!_pinned || !_reopenable) {
+        return;
+    }
+    _pinned = false;
+    if (_file) {
+        lru::get().insert(*this);
+    }
+}
+
+ss::future<ss::file> cached_file::get() {
+    auto& l = lru::get();
+    if (likely(_file)) {
+        ++l.st.hits;
+        l.touch(*this);
+        return ss::make_ready_future<ss::file>(*_file);
+    }
+    ++l.st.misses;
+    return open().then([this] {
+        if (!_file) {
+            return ss::make_exception_future<ss::file>(std::runtime_error(
+              fmt::format("segment file {} closed while opening", _name)));
+        }
+        return ss::make_ready_future<ss::file>(*_file);
+    });
+}
+
+ss::future<> cached_file::open() {
+    if (unlikely(!_reopenable)) {
+        return ss::make_exception_future<>(std::runtime_error(
+          fmt::format("segment file {} is closed", _name)));
+    }
+    // concurrent uses share the open
+    if (!_opening || _opening->available()) {
+        _opening = ss::shared_future<>(_open().then([this](ss::file fd) {
+            _file = std::move(fd);
+            ++lru::get().st.open;
+            if (!_pinned) {
+                lru::get().insert(*this);
+            }
+        }));
+    }
+    return _opening->get_future();
+}
+
+void cached_file::evict() {
+    auto& st = lru::get().st;
+    ++st.evictions;
+    --st.open;
+    auto fd = std::move(*_file);
+    _file.reset();
+    // the streams that read the file hold a use of it, nothing reads the
+    // handle anymore
+    (void)fd.close()
+      .handle_exception([name = _name](std::exception_ptr e) {
+          vlog(stlog.warn, "error closing segment file {}: {}", name, e);
+      })
+      .finally([fd] {});
+}
+
+ss::future<> cached_file::close() {
+    lru::get().erase(*this);
+    auto f = ss::now();
+    if (_opening && !_opening->available()) {
+        f = _opening->get_future().handle_exception([](std::exception_ptr) {});
+    }
+    return f.then([this] {
+        lru::get().erase(*this);
+        if (!_file) {
+            return ss::now();
+        }
+        --lru::get().st.open;
+        auto fd = std::move(*_file);
+        _file.reset();
+        return fd.close().finally([fd] {});
+    });
+}
+
+ss::input_stream<char> cached_file::make_input_stream(
+  uint64_t pos, uint64_t len, ss::file_input_stream_options opts) {
+    return ss::input_stream<char>(ss::data_source(
+      std::make_unique<lazy_data_source>(
+        shared_from_this(), pos, len, std::move(opts))));
+}
+
+} // namespace storage
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+#include "utils/intrusive_list_helpers.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/iostream.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <optional>
+
+namespace storage {
+
+/**
+ * A file of a segment, opened on first use.
+ *
+ * Nodes with tens of thousands of segments run out of file descriptors when
+ * every closed segment keeps its data and index files open. The handles
+ * opened on demand are kept in a per-shard LRU, and the least recently used
+ * ones are closed once more than `max_open_segment_files` are open: the file
+ * is opened again on its next use. A handle in use, by a stream or by an
+ * operation on the file, is not closed, and neither is a pinned handle, such
+ * as those of the active segments, which does not count against the limit.
+ */
+class cached_file : public ss::enable_lw_shared_from_this<cached_file> {
+public:
+    using opener = ss::noncopyable_function<ss::future<ss::file>()>;
+
+    /// the handles of the segment files of the shard
+    struct stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t evictions{0};
+        size_t open{0};
+    };
+
+    /// the handle is not closed by the LRU while a use of it is held
+    class use {
+    public:
+        explicit use(ss::lw_shared_ptr<cached_file> f) noexcept
+          : _f(std::move(f)) {
+            ++_f->_users;
+        }
+        ~use() noexcept {
+            if (_f) {
+                --_f->_users;
+            }
+        }
+        use(use&&) noexcept = default;
+        use& operator=(use&&) = delete;
+        use(const use&) = delete;
+        use& operator=(const use&) = delete;
+
+    private:
+        ss::lw_shared_ptr<cached_file> _f;
+    };
+
+    /// opened on first use, with `opener`
+    cached_file(ss::sstring name, opener);
+    /// opened upfront, the handle is never closed by the LRU
+    cached_file(ss::sstring name, ss::file);
+    ~cached_file() noexcept;
+    cached_file(cached_file&&) = delete;
+    cached_file& operator=(cached_file&&) = delete;
+    cached_file(const cached_file&) = delete;
+    cached_file& operator=(const cached_file&) = delete;
+
+    static const stats& shard_stats();
+
+    const ss::sstring& name() const { return _name; }
+    bool is_open() const { return _file.has_value(); }
+
+    /// \brief the handle is kept open until unpinned or closed
+    void pin();
+    void unpin();
+
+    /// \brief the handle, opened first if needed. it may be closed by the
+    /// LRU once returned, unless a use of it is held
+    ss::future<ss::file> get();
+
+    /// \brief runs `f` with the handle, which is not closed meanwhile
+    template<typename Func>
+    auto with_file(Func f) {
+        return get().then(
+          [f = std::move(f), u = use(shared_from_this())](ss::file fd) mutable {
+              return f(std::move(fd)).finally([u = std::move(u)] {});
+          });
+    }
+
+    /// \brief a stream of the file from `pos`, which opens the file on its
+    /// first read and keeps it open until the stream is destroyed
+    ss::input_stream<char> make_input_stream(
+      uint64_t pos, uint64_t len, ss::file_input_stream_options);
+
+    /// \brief closes the handle, if open
+    ss::future<> close();
+
+private:
+    struct lru;
+    class lazy_data_source;
+
+    ss::future<> open();
+    void evict();
+
+    ss::sstring _name;
+    opener _open;
+    std::optional<ss::file> _file;
+    std::optional<ss::shared_future<>> _opening;
+    bool _pinned{false};
+    bool _reopenable{true};
+    size_t _users{0};
+    intrusive_list_hook _hook;
+};
+
+using cached_file_ptr = ss::lw_shared_ptr<cached_file>;
+
+} // namespace storage
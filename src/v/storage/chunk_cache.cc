@@ -0,0 +1,166 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/chunk_cache.h"
+
+#include "config/configuration.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "storage/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/loop.hh>
+#include <seastar/core/metrics.hh>
+
+#include <boost/iterator/counting_iterator.hpp>
+
+#include <algorithm>
+
+namespace storage::internal {
+
+ss::future<> chunk_cache::start() {
+    const auto num_chunks = memory_groups::chunk_cache_min_memory()
+                            / chunk::chunk_size;
+    return ss::do_for_each(
+             boost::counting_iterator<size_t>(0),
+             boost::counting_iterator<size_t>(num_chunks),
+             [this](size_t) {
+                 auto c = ss::make_lw_shared<chunk>(alignment);
+                 _size_total += chunk::chunk_size;
+                 add(c);
+             })
+      .then([this] {
+          _size_idle = _size_available;
+          _idle_timer.set_callback([this] { release_idle(); });
+          _idle_timer.arm_periodic(idle_window);
+      });
+}
+
+void chunk_cache::add(const chunk_ptr& chunk) {
+    if (_size_total > _size_limit) {
+        _size_total -= chunk::chunk_size;
+        return;
+    }
+    _chunks.push_back(chunk);
+    _size_available += chunk::chunk_size;
+    if (_sem.waiters()) {
+        _sem.signal();
+    }
+}
+
+void chunk_cache::set_size_limit(size_t limit) {
+    _size_limit = limit;
+    // the waiters may allocate under the new limit
+    if (_size_total < _size_limit && _sem.waiters()) {
+        _sem.signal(_sem.waiters());
+    }
+}
+
+void chunk_cache::release_idle() {
+    // the chunks beyond the lowest available memory of the window were
+    // not needed by the appenders since the last release
+    const auto idle = std::min(_size_idle, _size_available);
+    size_t released = 0;
+    while (released < idle && !_chunks.empty()) {
+        _chunks.pop_front();
+        released += chunk::chunk_size;
+    }
+    _size_available -= released;
+    _size_total -= released;
+    _released_bytes += released;
+    _size_idle = _size_available;
+    if (released > 0) {
+        vlog(
+          stlog.debug,
+          "released {} bytes of idle chunks, {} bytes left",
+          released,
+          _size_total);
+    }
+}
+
+ss::future<ss::lw_shared_ptr<segment_appender_chunk>> chunk_cache::do_get() {
+    if (auto c = pop_or_allocate(); c) {
+        return ss::make_ready_future<chunk_ptr>(c);
+    }
+    ++_waits;
+    return wait();
+}
+
+ss::future<ss::lw_shared_ptr<segment_appender_chunk>> chunk_cache::wait() {
+    return ss::get_units(_sem, 1).then(
+      [this, start = clock_type::now()](ss::semaphore_units<>) {
+          _wait_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                        clock_type::now() - start)
+                        .count();
+          return do_get();
+      });
+}
+
+ss::lw_shared_ptr<segment_appender_chunk> chunk_cache::pop_or_allocate() {
+    if (!_chunks.empty()) {
+        auto c = _chunks.front();
+        _chunks.pop_front();
+        _size_available -= chunk::chunk_size;
+        _size_idle = std::min(_size_idle, _size_available);
+        c->reset();
+        return c;
+    }
+    if (_size_total < _size_limit) {
+        try {
+            auto c = ss::make_lw_shared<chunk>(alignment);
+            _size_total += chunk::chunk_size;
+            return c;
+        } catch (const std::bad_alloc& e) {
+            vlog(stlog.debug, "chunk allocation failed: {}", e);
+        }
+    }
+    return nullptr;
+}
+
+void chunk_cache::setup_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:chunk_cache"),
+      {
+        sm::make_gauge(
+          "size_bytes",
+          [this] { return _size_total; },
+          sm::description("Memory of the chunks of the appenders")),
+        sm::make_gauge(
+          "available_bytes",
+          [this] { return _size_available; },
+          sm::description("Memory of the chunks kept for reuse")),
+        sm::make_gauge(
+          "limit_bytes",
+          [this] { return _size_limit; },
+          sm::description("Upper bound on the memory of the chunks")),
+        sm::make_derive(
+          "released_bytes",
+          [this] { return _released_bytes; },
+          sm::description("Memory of the idle chunks freed")),
+        sm::make_gauge(
+          "waiters",
+          [this] { return _sem.waiters(); },
+          sm::description("Number of appenders waiting for a chunk")),
+        sm::make_derive(
+          "waits",
+          [this] { return _waits; },
+          sm::description("Number of appenders that waited for a chunk")),
+        sm::make_derive(
+          "wait_us",
+          [this] { return _wait_us; },
+          sm::description(
+            "Total time appenders waited for a chunk in microseconds")),
+      });
+}
+
+} // namespace storage::internal
@@ -1,26 +1,36 @@
 #pragma once
 #include "resource_mgmt/memory_groups.h"
 #include "seastarx.h"
-#include "storage/logger.h"
 #include "storage/segment_appender_chunk.h"
-#include "vassert.h"
-#include "vlog.h"
 
 #include <seastar/core/chunked_fifo.hh>
 #include <seastar/core/future.hh>
-#include <seastar/core/loop.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
 #include <seastar/core/semaphore.hh>
-#include <seastar/util/later.hh>
+#include <seastar/core/timer.hh>
 
-#include <boost/iterator/counting_iterator.hpp>
+#include <chrono>
+#include <cstdint>
 
 namespace storage::internal {
 
+/**
+ * The chunks of the segment appenders of the shard.
+ *
+ * The cache grows on demand up to its size limit, which is set by the memory
+ * governor, and appenders wait for a chunk to be returned past it. The chunks
+ * returned are kept for reuse, and those which stay unused for a whole idle
+ * window are freed, so that a shard keeps the chunks of its recent peak of
+ * writes rather than a fixed share of its memory.
+ */
 class chunk_cache {
     using chunk = segment_appender_chunk;
     using chunk_ptr = ss::lw_shared_ptr<chunk>;
 
 public:
+    using clock_type = ss::lowres_clock;
+
     /**
      * The chunk cache serves all segment files, which individually may have
      * different alignment requirements (e.g. different file systems or
@@ -30,9 +40,12 @@ public:
      */
     static constexpr const size_t alignment = 4_KiB;
 
+    /// the chunks kept unused for this long are freed
+    static constexpr clock_type::duration idle_window
+      = std::chrono::seconds(30);
+
     chunk_cache() noexcept
-      : _size_target(memory_groups::chunk_cache_min_memory())
-      , _size_limit(memory_groups::chunk_cache_max_memory()) {}
+      : _size_limit(memory_groups::chunk_cache_max_memory()) {}
 
     chunk_cache(chunk_cache&&) = delete;
     chunk_cache& operator=(chunk_cache&&) = delete;
@@ -40,75 +53,55 @@ public:
     chunk_cache& operator=(const chunk_cache&) = delete;
     ~chunk_cache() noexcept = default;
 
-    ss::future<> start() {
-        const auto num_chunks = memory_groups::chunk_cache_min_memory()
-                                / chunk::chunk_size;
-        return ss::do_for_each(
-          boost::counting_iterator<size_t>(0),
-          boost::counting_iterator<size_t>(num_chunks),
-          [this](size_t) {
-              auto c = ss::make_lw_shared<chunk>(alignment);
-              _size_total += chunk::chunk_size;
-              add(c);
-          });
-    }
+    /// allocates the initial chunks, and starts freeing the idle ones
+    ss::future<> start();
 
-    void add(const chunk_ptr& chunk) {
-        if (_size_available >= _size_target) {
-            _size_total -= chunk::chunk_size;
-            return;
-        }
-        _chunks.push_back(chunk);
-        _size_available += chunk::chunk_size;
-        if (_sem.waiters()) {
-            _sem.signal();
-        }
-    }
+    void add(const chunk_ptr& chunk);
 
     ss::future<chunk_ptr> get() {
         // don't steal if there are waiters
         if (!_sem.waiters()) {
             return do_get();
         }
-        return ss::get_units(_sem, 1).then(
-          [this](ss::semaphore_units<>) { return do_get(); });
+        ++_waits;
+        return wait();
     }
 
-private:
-    ss::future<chunk_ptr> do_get() {
-        if (auto c = pop_or_allocate(); c) {
-            return ss::make_ready_future<chunk_ptr>(c);
-        }
-        return ss::get_units(_sem, 1).then(
-          [this](ss::semaphore_units<>) { return do_get(); });
-    }
+    /**
+     * Resizes the upper bound on the memory of the chunks, e.g. by the memory
+     * governor. The chunks over it are freed as they are returned.
+     */
+    void set_size_limit(size_t limit);
 
-    chunk_ptr pop_or_allocate() {
-        if (!_chunks.empty()) {
-            auto c = _chunks.front();
-            _chunks.pop_front();
-            _size_available -= chunk::chunk_size;
-            c->reset();
-            return c;
-        }
-        if (_size_total < _size_limit) {
-            try {
-                auto c = ss::make_lw_shared<chunk>(alignment);
-                _size_total += chunk::chunk_size;
-                return c;
-            } catch (const std::bad_alloc& e) {
-                vlog(stlog.debug, "chunk allocation failed: {}", e);
-            }
-        }
-        return nullptr;
-    }
+    size_t size_limit() const { return _size_limit; }
+    size_t size_bytes() const { return _size_total; }
+    /// the memory of the chunks kept for reuse
+    size_t available_bytes() const { return _size_available; }
+    /// appenders that waited for a chunk to be returned
+    uint64_t waits() const { return _waits; }
+
+    /// frees the chunks unused since the last call
+    void release_idle();
+
+    void setup_metrics();
+
+private:
+    ss::future<chunk_ptr> do_get();
+    ss::future<chunk_ptr> wait();
+    chunk_ptr pop_or_allocate();
 
     ss::chunked_fifo<chunk_ptr> _chunks;
     ss::semaphore _sem{0};
     size_t _size_available{0};
     size_t _size_total{0};
-    const size_t _size_target;
-    const size_t _size_limit;
+    size_t _size_limit;
+    /// the lowest available memory since the chunks were last released
+    size_t _size_idle{0};
+    ss::timer<clock_type> _idle_timer;
+    uint64_t _waits{0};
+    uint64_t _wait_us{0};
+    uint64_t _released_bytes{0};
+    ss::metrics::metric_groups _metrics;
 };
 
 inline chunk_cache& chunks() {
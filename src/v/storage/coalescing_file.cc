@@ -0,0 +1,101 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/coalescing_file.h"
+
+#include <seastar/core/future-util.hh>
+
+#include <algorithm>
+#include <utility>
+
+namespace storage {
+
+coalescing_file::coalescing_file(ss::file f, size_t max_read_size)
+  : _file(std::move(f))
+  , _max_read_size(max_read_size) {}
+
+ss::future<ss::temporary_buffer<uint8_t>> coalescing_file::dma_read_bulk(
+  uint64_t offset, size_t range_size, const ss::io_priority_class& pc) {
+    if (_gate.is_closed() || range_size >= _max_read_size) {
+        return get_file_impl(_file)->dma_read_bulk(offset, range_size, pc);
+    }
+    if (_pending.empty()) {
+        // the reads queued until the task yields are issued together
+        (void)ss::with_gate(_gate, [this] {
+            return ss::later().then([this] { return submit(); });
+        });
+    }
+    _pending.push_back(pending_read{
+      .offset = offset,
+      .size = range_size,
+      .pc = pc,
+    });
+    return _pending.back().promise.get_future();
+}
+
+ss::future<> coalescing_file::submit() {
+    auto reads = std::exchange(_pending, {});
+    std::sort(
+      reads.begin(),
+      reads.end(),
+      [](const pending_read& a, const pending_read& b) {
+          return std::make_pair(a.pc.id(), a.offset)
+                 < std::make_pair(b.pc.id(), b.offset);
+      });
+    std::vector<ss::future<>> merged;
+    size_t i = 0;
+    while (i < reads.size()) {
+        auto start = reads[i].offset;
+        auto end = start + reads[i].size;
+        auto pc_id = reads[i].pc.id();
+        std::vector<pending_read> group;
+        group.push_back(std::move(reads[i++]));
+        while (i < reads.size() && reads[i].pc.id() == pc_id
+               && reads[i].offset <= end) {
+            auto read_end = std::max(end, reads[i].offset + reads[i].size);
+            if (read_end - start > _max_read_size) {
+                break;
+            }
+            end = read_end;
+            group.push_back(std::move(reads[i++]));
+        }
+        merged.push_back(read_merged(start, end - start, std::move(group)));
+    }
+    return ss::when_all_succeed(merged.begin(), merged.end());
+}
+
+ss::future<> coalescing_file::read_merged(
+  uint64_t offset, size_t size, std::vector<pending_read> reads) {
+    auto pc = reads.front().pc;
+    return get_file_impl(_file)
+      ->dma_read_bulk(offset, size, pc)
+      .then_wrapped([offset, reads = std::move(reads)](
+                      ss::future<ss::temporary_buffer<uint8_t>> f) mutable {
+          if (f.failed()) {
+              auto e = f.get_exception();
+              for (auto& r : reads) {
+                  r.promise.set_exception(e);
+              }
+              return;
+          }
+          auto buf = f.get0();
+          // the merged read is short at the end of the file
+          for (auto& r : reads) {
+              auto skip = std::min<size_t>(r.offset - offset, buf.size());
+              r.promise.set_value(
+                buf.share(skip, std::min(r.size, buf.size() - skip)));
+          }
+      });
+}
+
+ss::future<> coalescing_file::close() {
+    return _gate.close().then([this] { return get_file_impl(_file)->close(); });
+}
+
+} // namespace storage
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/temporary_buffer.hh>
+
+#include <vector>
+
+namespace storage {
+
+/*
+ * Merges the concurrent reads of a segment file.
+ *
+ * The bulk reads of the file, which back its input streams, are queued until
+ * the current task yields. Reads of the same priority class that overlap or
+ * are adjacent are then issued as one read of up to max_read_size bytes, and
+ * each of them gets its slice of the merged buffer. This is the case of the
+ * read-ahead of a stream, and of the readers of a partition that follow the
+ * same offsets, e.g. consumers at the tail of the log.
+ *
+ * All other operations go to the file directly.
+ */
+class coalescing_file final : public ss::file_impl {
+public:
+    coalescing_file(ss::file, size_t max_read_size);
+
+    ss::future<ss::temporary_buffer<uint8_t>> dma_read_bulk(
+      uint64_t offset,
+      size_t range_size,
+      const ss::io_priority_class& pc) final;
+
+    ss::future<size_t> read_dma(
+      uint64_t pos,
+      void* buffer,
+      size_t len,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->read_dma(pos, buffer, len, pc);
+    }
+
+    ss::future<size_t> read_dma(
+      uint64_t pos,
+      std::vector<iovec> iov,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->read_dma(pos, std::move(iov), pc);
+    }
+
+    ss::future<size_t> write_dma(
+      uint64_t pos,
+      const void* buffer,
+      size_t len,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->write_dma(pos, buffer, len, pc);
+    }
+
+    ss::future<size_t> write_dma(
+      uint64_t pos,
+      std::vector<iovec> iov,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->write_dma(pos, std::move(iov), pc);
+    }
+
+    ss::future<> flush() final { return get_file_impl(_file)->flush(); }
+
+    ss::future<struct stat> stat() final {
+        return get_file_impl(_file)->stat();
+    }
+
+    ss::future<> truncate(uint64_t length) final {
+        return get_file_impl(_file)->truncate(length);
+    }
+
+    ss::future<> discard(uint64_t offset, uint64_t length) final {
+        return get_file_impl(_file)->discard(offset, length);
+    }
+
+    ss::future<> allocate(uint64_t position, uint64_t length) final {
+        return get_file_impl(_file)->allocate(position, length);
+    }
+
+    ss::future<uint64_t> size() final { return get_file_impl(_file)->size(); }
+
+    /// waits for the queued reads
+    ss::future<> close() final;
+
+    std::unique_ptr<ss::file_handle_impl> dup() final {
+        return get_file_impl(_file)->dup();
+    }
+
+    ss::subscription<ss::directory_entry> list_directory(
+      std::function<ss::future<>(ss::directory_entry de)> next) final {
+        return get_file_impl(_file)->list_directory(std::move(next));
+    }
+
+private:
+    struct pending_read {
+        uint64_t offset;
+        size_t size;
+        ss::io_priority_class pc;
+        ss::promise<ss::temporary_buffer<uint8_t>> promise;
+    };
+
+    /// issues the queued reads, merged
+    ss::future<> submit();
+    ss::future<>
+      read_merged(uint64_t offset, size_t size, std::vector<pending_read>);
+
+    ss::file _file;
+    size_t _max_read_size;
+    std::vector<pending_read> _pending;
+    ss::gate _gate;
+};
+
+} // namespace storage
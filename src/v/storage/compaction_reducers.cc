@@ -18,6 +18,7 @@
 #include "storage/parser_utils.h"
 #include "storage/segment_appender_utils.h"
 #include "storage/segment_utils.h"
+#include "utils/vint.h"
 #include "vlog.h"
 
 #include <absl/algorithm/container.h>
@@ -88,6 +89,61 @@ Roaring compaction_key_reducer::end_of_stream() {
     return std::move(_inverted);
 }
 
+ss::future<ss::stop_iteration>
+compaction_hash_key_reducer::operator()(compacted_index::entry&& e) {
+    using stop_t = ss::stop_iteration;
+    auto f = ss::now();
+    if (_index.needs_eviction()) {
+        f = evict();
+    }
+    return f.then([this, e = std::move(e)] {
+        const model::offset o = e.offset + model::offset(e.delta);
+        const hashed_key_index::key_hash k(e.key);
+        auto& s = _index.find(k);
+        if (s.hash == 0) {
+            _index.insert(s, k, o, _natural_index);
+        } else if (s.fingerprint != k.fingerprint) {
+            // a different key with the same hash - there is no way to tell
+            // which of them is superseded later on, so keep this entry
+            ++_collisions;
+            _inverted.add(_natural_index);
+        } else if (o > s.offset) {
+            // cannot be std::max() because natural_index must be preserved
+            s.offset = o;
+            s.natural_index = _natural_index;
+        }
+        ++_natural_index; // MOST important
+        return stop_t::no;
+    });
+}
+
+ss::future<> compaction_hash_key_reducer::evict() {
+    // evict multiple entries at a time, like the whole key reducer
+    return ss::do_until(
+      [this] { return _index.evicted_enough(); },
+      [this] {
+          auto n = random_generators::get_int<size_t>(
+            0, _index.capacity() - 1);
+          // write the entry again - we ran out of scratch space
+          _inverted.add(_index.evict(n));
+          return ss::now();
+      });
+}
+
+Roaring compaction_hash_key_reducer::end_of_stream() {
+    if (_collisions > 0) {
+        vlog(
+          stlog.info,
+          "kept {} entries of keys with colliding hashes",
+          _collisions);
+    }
+    _index.for_each([this](const hashed_key_index::slot& s) {
+        _inverted.add(s.natural_index);
+    });
+    _inverted.shrinkToFit();
+    return std::move(_inverted);
+}
+
 ss::future<ss::stop_iteration>
 index_filtered_copy_reducer::operator()(compacted_index::entry&& e) {
     using stop_t = ss::stop_iteration;
@@ -218,55 +274,209 @@ copy_data_segment_reducer::filter(model::record_batch&& batch) {
       h, std::move(ret), model::record_batch::tag_ctor_ng{});
     return new_batch;
 }
+/// appends the batch to the rewritten segment and indexes it
+static ss::future<> write_indexed(
+  segment_appender& appender,
+  index_state& idx,
+  size_t& acc,
+  model::record_batch&& b) {
+    return ss::do_with(
+      std::move(b), [&appender, &idx, &acc](model::record_batch& batch) {
+          auto const start_offset = appender.file_byte_offset();
+          auto const header_size = batch.header().size_bytes;
+          acc += header_size;
+          if (idx.maybe_index(
+                acc,
+                32_KiB,
+                start_offset,
+                batch.base_offset(),
+                batch.last_offset(),
+                batch.header().first_timestamp,
+                batch.header().max_timestamp)) {
+              acc = 0;
+          }
+          return storage::write(appender, batch)
+            .then([&appender, start_offset, header_size] {
+                vassert(
+                  appender.file_byte_offset() == start_offset + header_size,
+                  "Size must be deterministic. Expected:{} == {}",
+                  appender.file_byte_offset(),
+                  start_offset + header_size);
+            });
+      });
+}
+
 ss::future<ss::stop_iteration> copy_data_segment_reducer::do_compaction(
-  model::compression original, model::record_batch&& b) {
+  model::record_batch&& b, std::optional<model::record_batch> compressed) {
     using stop_t = ss::stop_iteration;
+    const auto record_count = b.record_count();
     auto to_copy = filter(std::move(b));
     if (to_copy == std::nullopt) {
         return ss::make_ready_future<stop_t>(stop_t::no);
     }
-    return compress_batch(original, std::move(to_copy.value()))
+    if (!compressed) {
+        return write_indexed(*_appender, _idx, _acc, std::move(*to_copy))
+          .then([] { return stop_t::no; });
+    }
+    if (to_copy->record_count() == record_count) {
+        // kept whole: copied as it was written, without compressing it and
+        // checksumming its records again
+        return write_indexed(*_appender, _idx, _acc, std::move(*compressed))
+          .then([] { return stop_t::no; });
+    }
+    return compress_batch(
+             compressed->header().attrs.compression(), std::move(*to_copy))
       .then([this](model::record_batch&& b) {
-          return ss::do_with(std::move(b), [this](model::record_batch& batch) {
-              auto const start_offset = _appender->file_byte_offset();
-              auto const header_size = batch.header().size_bytes;
-              _acc += header_size;
-              if (_idx.maybe_index(
-                    _acc,
-                    32_KiB,
-                    start_offset,
-                    batch.base_offset(),
-                    batch.last_offset(),
-                    batch.header().first_timestamp,
-                    batch.header().max_timestamp)) {
-                  _acc = 0;
-              }
-              return storage::write(*_appender, batch)
-                .then([this, start_offset, header_size] {
-                    vassert(
-                      _appender->file_byte_offset()
-                        == start_offset + header_size,
-                      "Size must be deterministic. Expected:{} == {}",
-                      _appender->file_byte_offset(),
-                      start_offset + header_size);
-                });
-          });
+          return write_indexed(*_appender, _idx, _acc, std::move(b));
       })
-      .then([] { return ss::make_ready_future<stop_t>(stop_t::no); });
+      .then([] { return stop_t::no; });
 }
 
 ss::future<ss::stop_iteration>
 copy_data_segment_reducer::operator()(model::record_batch&& b) {
-    const auto comp = b.header().attrs.compression();
     if (!b.compressed()) {
-        return do_compaction(comp, std::move(b));
+        return do_compaction(std::move(b), std::nullopt);
     }
+    // the records are decompressed to read their offsets only
+    auto compressed = b.share();
     return decompress_batch(std::move(b))
-      .then([comp, this](model::record_batch&& b) {
-          return do_compaction(comp, std::move(b));
+      .then([this, compressed = std::move(compressed)](
+              model::record_batch&& b) mutable {
+          return do_compaction(std::move(b), std::move(compressed));
       });
 }
 
+ss::future<ss::stop_iteration>
+recompress_segment_reducer::operator()(model::record_batch&& b) {
+    using stop_t = ss::stop_iteration;
+    if (!b.compressed() || b.header().attrs.compression() == _target) {
+        return write_indexed(*_appender, _idx, _acc, std::move(b)).then([] {
+            return stop_t::no;
+        });
+    }
+    ++_recompressed;
+    return decompress_batch(std::move(b))
+      .then([this](model::record_batch&& b) {
+          return compress_batch(_target, std::move(b));
+      })
+      .then([this](model::record_batch&& b) {
+          return write_indexed(*_appender, _idx, _acc, std::move(b));
+      })
+      .then([] { return stop_t::no; });
+}
+
+bool coalesce_segment_reducer::can_coalesce(
+  const model::record_batch& b) const {
+    // the batches of raft::data only, as the state machines replay the
+    // others batch by batch
+    const auto& h = b.header();
+    return h.type == model::well_known_record_batch_types[1]
+           && !b.compressed() && h.producer_id < 0
+           && !h.attrs.is_transactional() && !h.attrs.is_control()
+           && h.first_timestamp >= model::timestamp(0)
+           && static_cast<size_t>(h.size_bytes) < _max_bytes;
+}
+
+bool coalesce_segment_reducer::extends_run(
+  const model::record_batch& b) const {
+    const auto& last = _run.back().header();
+    return b.base_offset() == last.last_offset() + model::offset(1)
+           && b.term() == last.ctx.term
+           && b.header().attrs.timestamp_type() == last.attrs.timestamp_type()
+           && _run_bytes + static_cast<size_t>(b.size_bytes()) <= _max_bytes;
+}
+
+ss::future<ss::stop_iteration>
+coalesce_segment_reducer::operator()(model::record_batch&& b) {
+    using stop_t = ss::stop_iteration;
+    auto f = ss::now();
+    if (!_run.empty() && (!can_coalesce(b) || !extends_run(b))) {
+        f = write_run();
+    }
+    return f.then([this, b = std::move(b)]() mutable {
+        if (!can_coalesce(b)) {
+            return write_indexed(*_appender, _idx, _acc, std::move(b))
+              .then([] { return stop_t::no; });
+        }
+        _run_bytes += static_cast<size_t>(b.size_bytes());
+        _run.push_back(std::move(b));
+        return ss::make_ready_future<stop_t>(stop_t::no);
+    });
+}
+
+ss::future<coalesce_segment_reducer::result>
+coalesce_segment_reducer::end_of_stream() {
+    return write_run().then([this] {
+        return result{std::move(_idx), _coalesced};
+    });
+}
+
+/// Writes the run of batches as a single batch. The offset and timestamp
+/// deltas of the records are rebased on the base offset and the earliest
+/// timestamp of the run, which changes the size of their encoding
+ss::future<> coalesce_segment_reducer::write_run() {
+    auto run = std::exchange(_run, {});
+    _run_bytes = 0;
+    if (run.empty()) {
+        return ss::now();
+    }
+    if (run.size() == 1) {
+        return write_indexed(*_appender, _idx, _acc, std::move(run.front()));
+    }
+    _coalesced += run.size() - 1;
+    const auto base = run.front().base_offset();
+    auto first_ts = run.front().header().first_timestamp;
+    auto max_ts = run.front().header().max_timestamp;
+    for (const auto& b : run) {
+        first_ts = std::min(first_ts, b.header().first_timestamp);
+        max_ts = std::max(max_ts, b.header().max_timestamp);
+    }
+    iobuf records;
+    int32_t record_count = 0;
+    for (auto& b : run) {
+        const auto offset_shift = static_cast<int32_t>(
+          b.base_offset()() - base());
+        const int64_t ts_shift = b.header().first_timestamp() - first_ts();
+        b.for_each_record(
+          [&records, &record_count, offset_shift, ts_shift](model::record r) {
+              const int64_t ts_delta = r.timestamp_delta() + ts_shift;
+              const int32_t offset_delta = r.offset_delta() + offset_shift;
+              const auto size = r.size_bytes()
+                                - vint::vint_size(r.timestamp_delta())
+                                - vint::vint_size(r.offset_delta())
+                                + vint::vint_size(ts_delta)
+                                + vint::vint_size(offset_delta);
+              const auto key_size = r.key_size();
+              const auto value_size = r.value_size();
+              model::record rebased(
+                size,
+                r.attributes(),
+                ts_delta,
+                offset_delta,
+                key_size,
+                r.release_key(),
+                value_size,
+                r.release_value(),
+                std::move(r.headers()));
+              model::append_record_to_buffer(records, rebased);
+              ++record_count;
+          });
+    }
+    auto h = run.front().header();
+    h.first_timestamp = first_ts;
+    h.max_timestamp = max_ts;
+    h.record_count = record_count;
+    h.last_offset_delta = static_cast<int32_t>(
+      run.back().last_offset()() - base());
+    reset_size_checksum_metadata(h, records);
+    return write_indexed(
+      *_appender,
+      _idx,
+      _acc,
+      model::record_batch(
+        h, std::move(records), model::record_batch::tag_ctor_ng{}));
+}
+
 ss::future<ss::stop_iteration>
 index_rebuilder_reducer::operator()(model::record_batch&& b) {
     using stop_t = ss::stop_iteration;
@@ -290,4 +500,54 @@ ss::future<> index_rebuilder_reducer::do_index(model::record_batch&& b) {
           });
     });
 }
+
+ss::future<ss::stop_iteration>
+key_offset_index_reducer::operator()(compacted_index::entry&& e) {
+    using stop_t = ss::stop_iteration;
+    if (e.type == compacted_index::entry_type::truncation) {
+        auto truncated = std::remove_if(
+          _offsets.begin(), _offsets.end(), [o = e.offset](model::offset k) {
+              return k >= o;
+          });
+        _offsets.erase(truncated, _offsets.end());
+    } else if (e.type == compacted_index::entry_type::key) {
+        _filter.add(e.key);
+        const model::offset o = e.offset + model::offset(e.delta);
+        if (e.key == _key && o <= _max_offset) {
+            _offsets.push_back(o);
+        }
+    }
+    return ss::make_ready_future<stop_t>(stop_t::no);
+}
+
+key_offset_index_reducer::result key_offset_index_reducer::end_of_stream() {
+    std::optional<model::offset> offset;
+    if (!_offsets.empty()) {
+        offset = *std::max_element(_offsets.begin(), _offsets.end());
+    }
+    return result{.offset = offset, .filter = std::move(_filter)};
+}
+
+ss::future<ss::stop_iteration>
+key_offset_batch_reducer::operator()(model::record_batch&& b) {
+    using stop_t = ss::stop_iteration;
+    if (!b.compressed()) {
+        find(b);
+        return ss::make_ready_future<stop_t>(stop_t::no);
+    }
+    return internal::decompress_batch(std::move(b))
+      .then([this](model::record_batch&& b) {
+          find(b);
+          return stop_t::no;
+      });
+}
+
+void key_offset_batch_reducer::find(const model::record_batch& b) {
+    b.for_each_record([this, o = b.base_offset()](const model::record& r) {
+        if (r.key() == _key) {
+            _offset = o + model::offset(r.offset_delta());
+        }
+    });
+}
+
 } // namespace storage::internal
@@ -15,7 +15,9 @@
 #include "storage/compacted_index.h"
 #include "storage/compacted_index_writer.h"
 #include "storage/compacted_offset_list.h"
+#include "storage/hashed_key_index.h"
 #include "storage/index_state.h"
+#include "storage/key_filter.h"
 #include "storage/logger.h"
 #include "storage/segment_appender.h"
 #include "units.h"
@@ -25,6 +27,9 @@
 #include <fmt/core.h>
 #include <roaring/roaring.hh>
 
+#include <optional>
+#include <vector>
+
 namespace storage::internal {
 
 struct compaction_reducer {};
@@ -61,6 +66,28 @@ private:
     uint32_t _natural_index{0};
 };
 
+/// Same as compaction_key_reducer, but keys are deduplicated by their hash in
+/// a table of fixed size. Entries of keys whose hashes collide are all kept.
+class compaction_hash_key_reducer : public compaction_reducer {
+public:
+    explicit compaction_hash_key_reducer(size_t max_mem)
+      : _index(max_mem) {}
+
+    ss::future<ss::stop_iteration> operator()(compacted_index::entry&&);
+    Roaring end_of_stream();
+
+    /// number of distinct keys that were found to share a hash
+    size_t collisions() const { return _collisions; }
+
+private:
+    ss::future<> evict();
+
+    hashed_key_index _index;
+    Roaring _inverted;
+    size_t _collisions{0};
+    uint32_t _natural_index{0};
+};
+
 /// This class copies the input reader into the writer consulting the bitmap of
 /// wether ot keep the entry or not
 class index_filtered_copy_reducer : public compaction_reducer {
@@ -78,6 +105,24 @@ private:
     compacted_index_writer* _writer;
 };
 
+/// Forwards the entries of several readers into the same reducer, so that a
+/// single reducer can be fed with the compacted indices of many segments.
+template<typename Reducer>
+class chained_reducer : public compaction_reducer {
+public:
+    explicit chained_reducer(Reducer& r) noexcept
+      : _reducer(&r) {}
+
+    ss::future<ss::stop_iteration> operator()(compacted_index::entry&& e) {
+        return (*_reducer)(std::move(e));
+    }
+    /// the end of stream of the underlying reducer is called by the owner
+    void end_of_stream() {}
+
+private:
+    Reducer* _reducer;
+};
+
 class compacted_offset_list_reducer : public compaction_reducer {
 public:
     explicit compacted_offset_list_reducer(model::offset base)
@@ -100,8 +145,10 @@ public:
     storage::index_state end_of_stream() { return std::move(_idx); }
 
 private:
-    ss::future<ss::stop_iteration>
-    do_compaction(model::compression, model::record_batch&&);
+    /// \brief copies the records of b to keep. compressed is the batch as
+    /// it is in the segment, when b is its decompression
+    ss::future<ss::stop_iteration> do_compaction(
+      model::record_batch&& b, std::optional<model::record_batch> compressed);
 
     bool should_keep(model::offset base, int32_t delta) const {
         const auto o = base + model::offset(delta);
@@ -115,6 +162,67 @@ private:
     size_t _acc{0};
 };
 
+/// Copies the batches of a segment, recompressing those compressed with
+/// another codec than the target one. The offsets are unchanged but not the
+/// sizes, so the offset index is rebuilt along the way.
+class recompress_segment_reducer : public compaction_reducer {
+public:
+    struct result {
+        index_state idx;
+        // number of batches that were recompressed
+        size_t recompressed{0};
+    };
+
+    recompress_segment_reducer(
+      model::compression target, segment_appender* a) noexcept
+      : _target(target)
+      , _appender(a) {}
+
+    ss::future<ss::stop_iteration> operator()(model::record_batch&&);
+    result end_of_stream() { return {std::move(_idx), _recompressed}; }
+
+private:
+    model::compression _target;
+    segment_appender* _appender;
+    index_state _idx;
+    size_t _acc{0};
+    size_t _recompressed{0};
+};
+
+/// Copies the batches of a segment, merging the runs of adjacent small
+/// batches of data into batches of up to `max_bytes`. Only the uncompressed
+/// batches of a single term without producer state are merged, so that the
+/// offsets, records and sequence numbers are unchanged. The offset index is
+/// rebuilt along the way.
+class coalesce_segment_reducer : public compaction_reducer {
+public:
+    struct result {
+        index_state idx;
+        // number of batches merged into the batch before them
+        size_t coalesced{0};
+    };
+
+    coalesce_segment_reducer(size_t max_bytes, segment_appender* a) noexcept
+      : _max_bytes(max_bytes)
+      , _appender(a) {}
+
+    ss::future<ss::stop_iteration> operator()(model::record_batch&&);
+    ss::future<result> end_of_stream();
+
+private:
+    bool can_coalesce(const model::record_batch&) const;
+    bool extends_run(const model::record_batch&) const;
+    ss::future<> write_run();
+
+    size_t _max_bytes;
+    segment_appender* _appender;
+    std::vector<model::record_batch> _run;
+    size_t _run_bytes{0};
+    index_state _idx;
+    size_t _acc{0};
+    size_t _coalesced{0};
+};
+
 class index_rebuilder_reducer : public compaction_reducer {
 public:
     explicit index_rebuilder_reducer(compacted_index_writer* w) noexcept
@@ -128,4 +236,47 @@ private:
     compacted_index_writer* _w;
 };
 
+/// Finds the latest offset of a key in the compacted index of a segment, and
+/// builds the filter of all the keys of the index along the way. A truncation
+/// entry drops the offsets of the entries before it that it truncated.
+class key_offset_index_reducer : public compaction_reducer {
+public:
+    struct result {
+        std::optional<model::offset> offset;
+        key_filter filter;
+    };
+
+    /// \param keys entries of the index, to size the filter
+    key_offset_index_reducer(bytes key, size_t keys, model::offset max_offset)
+      : _key(std::move(key))
+      , _filter(keys)
+      , _max_offset(max_offset) {}
+
+    ss::future<ss::stop_iteration> operator()(compacted_index::entry&&);
+    result end_of_stream();
+
+private:
+    bytes _key;
+    key_filter _filter;
+    model::offset _max_offset;
+    /// offsets of the entries of the key
+    std::vector<model::offset> _offsets;
+};
+
+/// Finds the latest offset of a key in the batches of a segment
+class key_offset_batch_reducer : public compaction_reducer {
+public:
+    explicit key_offset_batch_reducer(const bytes& key)
+      : _key(bytes_to_iobuf(key)) {}
+
+    ss::future<ss::stop_iteration> operator()(model::record_batch&&);
+    std::optional<model::offset> end_of_stream() { return _offset; }
+
+private:
+    void find(const model::record_batch&);
+
+    iobuf _key;
+    std::optional<model::offset> _offset;
+};
+
 } // namespace storage::internal
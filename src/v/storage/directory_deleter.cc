@@ -0,0 +1,158 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/directory_deleter.h"
+
+#include "storage/logger.h"
+#include "utils/directory_walker.h"
+#include "vlog.h"
+
+#include <seastar/core/seastar.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/smp.hh>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace storage {
+
+static std::filesystem::path trash_of(const ss::sstring& data_dir) {
+    return std::filesystem::path(data_dir.c_str())
+           / std::string(directory_deleter::trash_dir_name);
+}
+
+ss::future<> directory_deleter::recover(std::vector<ss::sstring> data_dirs) {
+    return ss::do_with(
+      std::move(data_dirs), [this](std::vector<ss::sstring>& dirs) {
+          return ss::do_for_each(dirs, [this](const ss::sstring& dir) {
+              auto trash = trash_of(dir);
+              return ss::file_exists(trash.string())
+                .then([this, trash](bool exists) {
+                    if (!exists) {
+                        return ss::now();
+                    }
+                    return directory_walker::walk(
+                      trash.string(),
+                      [this, trash](ss::directory_entry de) {
+                          queue(trash / de.name.c_str());
+                          return ss::now();
+                      });
+                });
+          });
+      });
+}
+
+ss::future<> directory_deleter::stop() {
+    _as.request_abort();
+    return _gate.close();
+}
+
+ss::future<>
+directory_deleter::remove(std::filesystem::path dir, ss::sstring data_dir) {
+    auto trash = trash_of(data_dir);
+    // unique across the cores and the restarts, and flat, as the topic and
+    // namespace directories of the log are left behind
+    auto name = fmt::format(
+      "{}_{}_{}_{}",
+      dir.lexically_relative(data_dir.c_str()).string(),
+      ss::this_shard_id(),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch())
+        .count(),
+      _renamed++);
+    std::replace(name.begin(), name.end(), '/', '_');
+    auto target = trash / name;
+    return ss::recursive_touch_directory(trash.string())
+      .then([dir, target] {
+          return ss::rename_file(dir.string(), target.string());
+      })
+      .then([trash] { return ss::sync_directory(trash.string()); })
+      .then([this, target] { queue(target); });
+}
+
+void directory_deleter::queue(std::filesystem::path dir) {
+    _queue.push_back(std::move(dir));
+    if (_running || _gate.is_closed()) {
+        return;
+    }
+    _running = true;
+    (void)ss::with_gate(_gate, [this] {
+        return run().finally([this] { _running = false; });
+    }).handle_exception([](std::exception_ptr e) {
+        vlog(stlog.info, "Background directory removal stopped: {}", e);
+    });
+}
+
+ss::future<> directory_deleter::run() {
+    return ss::do_until(
+      [this] { return _queue.empty() || _as.abort_requested(); },
+      [this] {
+          auto dir = std::move(_queue.front());
+          _queue.pop_front();
+          vlog(stlog.info, "Removing {}", dir);
+          return remove_tree(dir).handle_exception(
+            [this, dir](std::exception_ptr e) {
+                if (_as.abort_requested()) {
+                    return;
+                }
+                // retried after the next start
+                vlog(stlog.warn, "Error removing {}: {}", dir, e);
+            });
+      });
+}
+
+ss::future<> directory_deleter::remove_tree(std::filesystem::path dir) {
+    return ss::file_type(dir.string(), ss::follow_symlink::no)
+      .then([this, dir](std::optional<ss::directory_entry_type> type) {
+          if (!type) {
+              return ss::now();
+          }
+          if (*type != ss::directory_entry_type::directory) {
+              return remove_file(dir);
+          }
+          auto entries = ss::make_lw_shared<std::vector<ss::sstring>>();
+          return directory_walker::walk(
+                   dir.string(),
+                   [entries](ss::directory_entry de) {
+                       entries->push_back(std::move(de.name));
+                       return ss::now();
+                   })
+            .then([this, dir, entries] {
+                return ss::do_for_each(
+                  *entries, [this, dir](const ss::sstring& name) {
+                      return remove_tree(dir / name.c_str());
+                  });
+            })
+            .then([dir] { return ss::remove_file(dir.string()); })
+            .finally([entries] {});
+      });
+}
+
+ss::future<> directory_deleter::remove_file(std::filesystem::path file) {
+    if (_as.abort_requested()) {
+        return ss::make_exception_future<>(ss::abort_requested_exception());
+    }
+    return ss::file_size(file.string())
+      .then([this, file](uint64_t size) {
+          return ss::remove_file(file.string()).then([this, size] {
+              _removed_bytes += size;
+              if (!_bytes_per_sec || *_bytes_per_sec == 0) {
+                  return ss::now();
+              }
+              // the next file waits for the bytes of this one to be paid
+              auto pause = std::chrono::milliseconds(
+                size * 1000 / *_bytes_per_sec);
+              return ss::sleep_abortable(pause, _as);
+          });
+      });
+}
+
+} // namespace storage
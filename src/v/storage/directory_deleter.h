@@ -0,0 +1,75 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/sstring.hh>
+
+#include <deque>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace storage {
+
+/**
+ * Removes the directories of the removed logs in the background.
+ *
+ * Removing thousands of logs at once, as when deleting a large topic, used
+ * to unlink all their files inline, stalling the core and the controller
+ * work queued behind the deletion. Instead, the directory of a removed log
+ * is renamed into the trash directory of its data directory, which frees the
+ * name of the log right away, and its files are unlinked here one at a time,
+ * at most `bytes_per_sec` per core. The directories left in the trash by a
+ * crash are removed after the next start.
+ */
+class directory_deleter {
+public:
+    static constexpr std::string_view trash_dir_name = ".deleted";
+
+    explicit directory_deleter(std::optional<size_t> bytes_per_sec)
+      : _bytes_per_sec(bytes_per_sec) {}
+
+    /// \brief queues the directories left in the trash of the data
+    /// directories. must be called on a single core
+    ss::future<> recover(std::vector<ss::sstring> data_dirs);
+    /// \brief the directories still queued are left in the trash
+    ss::future<> stop();
+
+    /// \brief moves the directory into the trash of the data directory it
+    /// is in, and queues it for removal
+    ss::future<> remove(std::filesystem::path dir, ss::sstring data_dir);
+
+    size_t pending() const { return _queue.size(); }
+    uint64_t removed_bytes() const { return _removed_bytes; }
+
+private:
+    void queue(std::filesystem::path);
+    ss::future<> run();
+    ss::future<> remove_tree(std::filesystem::path);
+    ss::future<> remove_file(std::filesystem::path);
+
+    std::optional<size_t> _bytes_per_sec;
+    std::deque<std::filesystem::path> _queue;
+    bool _running{false};
+    uint64_t _removed_bytes{0};
+    uint64_t _renamed{0};
+    ss::gate _gate;
+    ss::abort_source _as;
+};
+
+} // namespace storage
@@ -14,6 +14,7 @@
 #include "storage/disk_log_impl.h"
 #include "storage/logger.h"
 #include "storage/segment_appender.h"
+#include "storage/shared_wal.h"
 #include "vlog.h"
 
 #include <type_traits>
@@ -113,7 +114,13 @@ disk_log_appender::append_batch_to_segment(const model::record_batch& batch) {
         return ss::make_ready_future<ss::stop_iteration>(
           ss::stop_iteration::no);
     }
-    return _seg->append(batch).then([this](append_result r) {
+    if (auto wal = _log._manager.wal()) {
+        // queued first, so that a flush never covers a batch of the segment
+        // which is not in the wal
+        wal->append(_log.config().ntp(), batch);
+    }
+    const bool cache = _log.cache_appended(batch);
+    return _seg->append(batch, cache).then([this](append_result r) {
         _idx = r.last_offset + model::offset(1); // next base offset
         _byte_size += r.byte_size;
         // do not track base_offset, only the last one
@@ -124,6 +131,10 @@ disk_log_appender::append_batch_to_segment(const model::record_batch& batch) {
         // substract the bytes from the append
         // take the min because _bytes_left_in_segment is optimistic
         _bytes_left_in_segment -= std::min(_bytes_left_in_segment, r.byte_size);
+        if (_bytes_left_in_segment == 0) {
+            // the next append rolls, most likely to the next offset
+            _log.prepare_next_segment(_last_term, _idx, _config.io_priority);
+        }
         return ss::stop_iteration::no;
     });
 }
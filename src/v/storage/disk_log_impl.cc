@@ -9,23 +9,31 @@
 
 #include "storage/disk_log_impl.h"
 
+#include "config/configuration.h"
 #include "model/adl_serde.h"
 #include "model/fundamental.h"
 #include "model/timeout_clock.h"
 #include "reflection/adl.h"
+#include "storage/compaction_reducers.h"
 #include "storage/disk_log_appender.h"
+#include "storage/fs_utils.h"
 #include "storage/log_manager.h"
 #include "storage/logger.h"
 #include "storage/offset_assignment.h"
 #include "storage/offset_to_filepos_consumer.h"
+#include "storage/segment_scrubber.h"
 #include "storage/segment_set.h"
 #include "storage/segment_utils.h"
+#include "storage/shared_wal.h"
+#include "storage/spill_key_index.h"
 #include "storage/types.h"
 #include "storage/version.h"
+#include "utils/task_profiler.h"
 #include "vassert.h"
 #include "vlog.h"
 
 #include <seastar/core/abort_source.hh>
+#include <seastar/core/align.hh>
 #include <seastar/core/fair_queue.hh>
 #include <seastar/core/future-util.hh>
 #include <seastar/core/future.hh>
@@ -35,7 +43,9 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <iterator>
+#include <vector>
 
 namespace storage {
 
@@ -47,7 +57,15 @@ disk_log_impl::disk_log_impl(
   , _kvstore(kvstore)
   , _start_offset(read_start_offset())
   , _lock_mngr(_segs)
-  , _max_segment_size(internal::jitter_segment_size(max_segment_size())) {
+  , _readers_cache(
+      config().ntp(), _manager.config().readers_cache_eviction_timeout)
+  , _max_archived_offset(
+      _manager.is_archived(config().ntp())
+        ? model::offset{}
+        : model::model_limits<model::offset>::max())
+  , _max_segment_size(internal::jitter_segment_size(max_segment_size()))
+  , _segment_size_target(_max_segment_size)
+  , _segment_roll_interval(segment_roll_interval()) {
     const bool is_compacted = config().is_compacted();
     for (auto& s : _segs) {
         _probe.add_initial_segment(*s);
@@ -64,18 +82,23 @@ disk_log_impl::~disk_log_impl() {
 ss::future<> disk_log_impl::remove() {
     vassert(!_closed, "Invalid double closing of log - {}", *this);
     _closed = true;
-    // gets all the futures started in the background
-    std::vector<ss::future<>> permanent_delete;
-    permanent_delete.reserve(_segs.size());
-    while (!_segs.empty()) {
-        auto s = _segs.back();
-        _segs.pop_back();
-        permanent_delete.emplace_back(
-          remove_segment_permanently(s, "disk_log_impl::remove()"));
-    }
-    // wait for all futures
-    return ss::when_all_succeed(
-             permanent_delete.begin(), permanent_delete.end())
+    return _readers_cache.stop()
+      .then([this] { return _deletions.close(); })
+      .then([this] { return discard_next_segment(); })
+      .then([this] {
+          // gets all the futures started in the background
+          std::vector<ss::future<>> permanent_delete;
+          permanent_delete.reserve(_segs.size());
+          while (!_segs.empty()) {
+              auto s = _segs.back();
+              _segs.pop_back();
+              permanent_delete.emplace_back(
+                remove_segment_permanently(s, "disk_log_impl::remove()"));
+          }
+          // wait for all futures
+          return ss::when_all_succeed(
+            permanent_delete.begin(), permanent_delete.end());
+      })
       .then([this]() {
           vlog(stlog.info, "Finished removing all segments:{}", config());
       })
@@ -92,11 +115,17 @@ ss::future<> disk_log_impl::close() {
       && !_eviction_monitor->promise.get_future().available()) {
         _eviction_monitor->promise.set_exception(segment_closed_exception());
     }
-    return ss::parallel_for_each(_segs, [](ss::lw_shared_ptr<segment>& h) {
-        return h->close().handle_exception([h](std::exception_ptr e) {
-            vlog(stlog.error, "Error closing segment:{} - {}", e, h);
-        });
-    });
+    return _readers_cache.stop()
+      .then([this] { return _deletions.close(); })
+      .then([this] { return discard_next_segment(); })
+      .then([this] {
+          return ss::parallel_for_each(
+            _segs, [](ss::lw_shared_ptr<segment>& h) {
+                return h->close().handle_exception([h](std::exception_ptr e) {
+                    vlog(stlog.error, "Error closing segment:{} - {}", e, h);
+                });
+            });
+      });
 }
 
 model::offset disk_log_impl::size_based_gc_max_offset(size_t max_size) {
@@ -174,6 +203,94 @@ void disk_log_impl::set_collectible_offset(model::offset o) {
     _max_collectible_offset = o;
 }
 
+void disk_log_impl::set_archived_offset(model::offset o) {
+    if (_manager.is_archived(config().ntp())) {
+        _max_archived_offset = std::max(_max_archived_offset, o);
+    }
+}
+
+void disk_log_impl::set_batch_cache_policy(batch_cache_policy p) {
+    if (p != _cache_policy) {
+        // the batches cached as a leader age out of the cache on their own
+        clear_cached_tail();
+        _cache_policy = p;
+    }
+}
+
+void disk_log_impl::clear_cached_tail() {
+    _cached_tail.clear();
+    _cached_tail_bytes = 0;
+}
+
+bool disk_log_impl::cache_appended(const model::record_batch& b) {
+    if (_cache_policy == batch_cache_policy::all) {
+        return true;
+    }
+    const size_t tail_bytes
+      = config::shard_local_cfg().follower_batch_cache_tail_bytes();
+    const size_t size = b.size_bytes();
+    if (size > tail_bytes) {
+        return false;
+    }
+    _cached_tail.emplace_back(b.base_offset(), size);
+    _cached_tail_bytes += size;
+    while (_cached_tail_bytes > tail_bytes) {
+        auto [offset, bytes] = _cached_tail.front();
+        _cached_tail.pop_front();
+        _cached_tail_bytes -= bytes;
+        // the segment is gone if the log was truncated or collected since
+        if (auto it = _segs.lower_bound(offset);
+            it != _segs.end() && (*it)->has_cache()) {
+            (*it)->cache().evict(offset);
+        }
+    }
+    return true;
+}
+
+namespace {
+struct discarding_consumer {
+    ss::future<ss::stop_iteration> operator()(model::record_batch&&) {
+        return ss::make_ready_future<ss::stop_iteration>(
+          ss::stop_iteration::no);
+    }
+    void end_of_stream() {}
+};
+} // namespace
+
+ss::future<>
+disk_log_impl::warm_batch_cache(size_t bytes, ss::io_priority_class pc) {
+    if (bytes == 0 || _segs.empty()) {
+        return ss::now();
+    }
+    // the first batch of the last `bytes` of the log, from the index of the
+    // segment they start in
+    auto start = _segs.back()->offsets().base_offset;
+    size_t left = bytes;
+    for (auto it = _segs.rbegin(); it != _segs.rend(); ++it) {
+        auto& seg = *it;
+        const size_t size = seg->size_bytes();
+        start = seg->offsets().base_offset;
+        if (size >= left) {
+            if (auto e = seg->index().find_nearest_position(size - left)) {
+                start = e->offset;
+            }
+            break;
+        }
+        left -= size;
+    }
+    const auto stats = offsets();
+    if (stats.dirty_offset < start) {
+        return ss::now();
+    }
+    // an ordinary read inserts the batches it misses into the cache
+    log_reader_config cfg(
+      std::max(start, stats.start_offset), stats.dirty_offset, pc);
+    return make_reader(cfg).then([](model::record_batch_reader reader) {
+        return std::move(reader).consume(
+          discarding_consumer{}, model::no_timeout);
+    });
+}
+
 bool disk_log_impl::is_front_segment(const segment_set::type& ptr) const {
     return !_segs.empty()
            && ptr->reader().filename() == (*_segs.begin())->reader().filename();
@@ -191,7 +308,8 @@ ss::future<> disk_log_impl::garbage_collect_segments(
         _eviction_monitor.reset();
     }
 
-    max_offset = std::min(max_offset, _max_collectible_offset);
+    max_offset = std::min(
+      {max_offset, _max_collectible_offset, _max_archived_offset});
 
     return ss::do_until(
       [this, as, max_offset] {
@@ -218,7 +336,7 @@ ss::future<> disk_log_impl::garbage_collect_segments(
                     return ss::now();
                 }
                 _segs.pop_front();
-                return remove_segment_permanently(ptr, ctx);
+                return remove_segment_in_background(ptr, ctx);
             })
             .then([this] {
                 // we have to update start offset with the most recent offset as
@@ -255,10 +373,147 @@ ss::future<> disk_log_impl::do_compact(compaction_config cfg) {
           .finally([seg] { seg->mark_as_finished_self_compaction(); });
     }
     // all segments are self-compacted
-    // do cross segment compaction
-    return ss::now();
+    return compact_adjacent_segments(cfg);
+}
+
+/// Returns the first run of at least two adjacent segments that can be merged
+/// into a single one: all self-compacted, of the same term - the term of a
+/// segment is part of its name - and whose sizes add up to at most a segment.
+std::vector<ss::lw_shared_ptr<segment>>
+disk_log_impl::find_adjacent_compaction_range() const {
+    const size_t max_size = max_segment_size();
+    // merging keeps the codecs of the batches, so segments to be recompressed
+    // are merged once recompressed
+    const bool recompressed = config().recompression_target().has_value();
+    auto mergeable = [max_size,
+                      recompressed](const ss::lw_shared_ptr<segment>& s) {
+        return !s->has_appender() && s->is_compacted_segment()
+               && s->finished_self_compaction() && !s->is_tombstone()
+               && !s->empty() && s->size_bytes() <= max_size
+               && (!recompressed || s->finished_recompression());
+    };
+    std::vector<ss::lw_shared_ptr<segment>> range;
+    size_t range_size = 0;
+    for (const auto& s : _segs) {
+        if (
+          !range.empty() && mergeable(s)
+          && s->offsets().term == range.front()->offsets().term
+          && range_size + s->size_bytes() <= max_size) {
+            range.push_back(s);
+            range_size += s->size_bytes();
+            continue;
+        }
+        if (range.size() > 1) {
+            break;
+        }
+        range.clear();
+        range_size = 0;
+        if (mergeable(s)) {
+            range.push_back(s);
+            range_size = s->size_bytes();
+        }
+    }
+    if (range.size() < 2) {
+        range.clear();
+    }
+    return range;
 }
+
+ss::future<> disk_log_impl::compact_adjacent_segments(compaction_config cfg) {
+    if (unlikely(cfg.asrc->abort_requested())) {
+        return ss::now();
+    }
+    auto range = find_adjacent_compaction_range();
+    if (range.empty()) {
+        return ss::now();
+    }
+    vlog(
+      stlog.debug,
+      "merging {} adjacent compacted segments of {} into {}",
+      range.size(),
+      config().ntp(),
+      range.front());
+    return storage::internal::merge_adjacent_segments(range, cfg, _probe)
+      .then([this, range](std::vector<ss::rwlock::holder> locks) {
+          if (locks.empty()) {
+              return ss::now();
+          }
+          // the data of the merged segments now lives in the first one of the
+          // range. they are removed from the set while holding their write
+          // locks so that no new reader sees the same offsets twice
+          std::vector<ss::lw_shared_ptr<segment>> merged;
+          merged.reserve(range.size() - 1);
+          for (auto it = std::next(range.begin()); it != range.end(); ++it) {
+              auto pos = std::find(_segs.begin(), _segs.end(), *it);
+              if (pos != _segs.end()) {
+                  _segs.erase(pos, std::next(pos));
+                  merged.push_back(*it);
+              }
+          }
+          auto first = range.front();
+          return first->index()
+            .flush()
+            .handle_exception([first](std::exception_ptr e) {
+                // the index is rebuilt from the data on recovery
+                vlog(stlog.error, "Error flushing index of {}: {}", first, e);
+            })
+            // closing the merged segments requires their write locks
+            .finally([locks = std::move(locks)] {})
+            .then([this, merged = std::move(merged)]() mutable {
+                return ss::do_with(
+                  std::move(merged),
+                  [this](std::vector<ss::lw_shared_ptr<segment>>& merged) {
+                      return ss::do_for_each(
+                        merged, [this](ss::lw_shared_ptr<segment>& s) {
+                            return remove_segment_permanently(
+                              s, "compact_adjacent_segments");
+                        });
+                  });
+            });
+      })
+      .handle_exception_type([](const segment_closed_exception&) {
+          // a segment of the range was removed while merging, e.g. by
+          // retention. the merge is retried by the next compaction
+      });
+}
+compaction_backlog disk_log_impl::get_compaction_backlog() const {
+    compaction_backlog ret{.total_bytes = _probe.partition_size()};
+    if (!config().is_compacted()) {
+        return ret;
+    }
+    // mirrors do_compact(): segments are self-compacted one at a time and
+    // only then merged
+    for (const auto& s : _segs) {
+        if (
+          !s->has_appender() && s->is_compacted_segment()
+          && !s->finished_self_compaction()) {
+            if (ret.dirty_bytes == 0) {
+                ret.next_bytes = s->size_bytes();
+            }
+            ret.dirty_bytes += s->size_bytes();
+        }
+    }
+    if (ret.dirty_bytes == 0) {
+        for (const auto& s : find_adjacent_compaction_range()) {
+            ret.next_bytes += s->size_bytes();
+        }
+        ret.dirty_bytes = ret.next_bytes;
+    }
+    return ret;
+}
+
 ss::future<> disk_log_impl::compact(compaction_config cfg) {
+    return profile_task("disk_log_impl::compact", [this, cfg] {
+        // compaction and retention take the write lock of the segments they
+        // rewrite or remove, which parked readers would hold up
+        return _readers_cache.evict().then(
+          [this, cfg](readers_cache::eviction_guard g) {
+              return do_housekeeping(cfg).finally([g = std::move(g)] {});
+          });
+    });
+}
+
+ss::future<> disk_log_impl::do_housekeeping(compaction_config cfg) {
     ss::future<> f = ss::now();
     if (config().is_collectable()) {
         f = gc(cfg);
@@ -275,23 +530,177 @@ ss::future<> disk_log_impl::compact(compaction_config cfg) {
     if (config().is_compacted() && !_segs.empty()) {
         f = f.then([this, cfg] { return do_compact(cfg); });
     }
+    if (auto max = _manager.config().coalesce_batch_bytes; max) {
+        f = f.then([this, cfg, m = *max] { return coalesce(cfg, m); });
+    }
+    if (auto target = config().recompression_target(); target) {
+        f = f.then([this, cfg, c = *target] { return recompress(cfg, c); });
+    }
     return f;
 }
 
-ss::future<> disk_log_impl::gc(compaction_config cfg) {
-    vassert(!_closed, "gc on closed log - {}", *this);
+/// Merges the runs of small batches of the first closed segment still to be
+/// coalesced, one segment per housekeeping round. Coalescing comes before
+/// recompression, which leaves no uncompressed batch to merge.
+ss::future<> disk_log_impl::coalesce(compaction_config cfg, size_t max_bytes) {
+    if (unlikely(cfg.asrc->abort_requested())) {
+        return ss::now();
+    }
+    auto segit = std::find_if(
+      _segs.begin(), _segs.end(), [](ss::lw_shared_ptr<segment>& s) {
+          return !s->has_appender() && !s->is_tombstone()
+                 && !s->finished_coalescing()
+                 && (!s->is_compacted_segment()
+                     || s->finished_self_compaction());
+      });
+    if (segit == _segs.end()) {
+        return ss::now();
+    }
+    auto seg = *segit;
+    return storage::internal::coalesce_segment(seg, cfg, max_bytes, _probe)
+      .handle_exception_type([](const segment_closed_exception&) {
+          // removed while being coalesced, e.g. by retention
+      })
+      .finally([seg] { seg->mark_as_finished_coalescing(); });
+}
 
+/// Recompresses the first closed segment still to be recompressed to the
+/// codec of the topic, one segment per housekeeping round as for
+/// compaction. A compacted segment is only recompressed once self-compacted,
+/// as compaction rewrites it anyway.
+ss::future<>
+disk_log_impl::recompress(compaction_config cfg, model::compression target) {
     if (unlikely(cfg.asrc->abort_requested())) {
-        return ss::make_ready_future<>();
+        return ss::now();
+    }
+    const bool coalesced = _manager.config().coalesce_batch_bytes.has_value();
+    auto segit = std::find_if(
+      _segs.begin(),
+      _segs.end(),
+      [coalesced](ss::lw_shared_ptr<segment>& s) {
+          return !s->has_appender() && !s->is_tombstone()
+                 && !s->finished_recompression()
+                 && (!coalesced || s->finished_coalescing())
+                 && (!s->is_compacted_segment()
+                     || s->finished_self_compaction());
+      });
+    if (segit == _segs.end()) {
+        return ss::now();
+    }
+    auto seg = *segit;
+    return storage::internal::recompress_segment(seg, cfg, target, _probe)
+      .handle_exception_type([](const segment_closed_exception&) {
+          // removed while being recompressed, e.g. by retention
+      })
+      .finally([seg] { seg->mark_as_finished_recompression(); });
+}
+
+ss::future<scrub_result> disk_log_impl::scrub(scrub_config cfg) {
+    std::vector<ss::lw_shared_ptr<segment>> closed;
+    if (_closed) {
+        // removed while scrubbing other logs
+        return ss::make_ready_future<scrub_result>();
+    }
+    for (const auto& s : _segs) {
+        if (!s->has_appender() && !s->is_tombstone()) {
+            closed.push_back(s);
+        }
     }
+    return ss::do_with(
+      std::move(closed),
+      scrub_result{},
+      [this, cfg](
+        std::vector<ss::lw_shared_ptr<segment>>& closed, scrub_result& ret) {
+          return ss::do_for_each(
+                   closed,
+                   [this, cfg, &ret](ss::lw_shared_ptr<segment>& s) {
+                       if (cfg.asrc->abort_requested()) {
+                           return ss::now();
+                       }
+                       return internal::scrub_segment(s, cfg).then(
+                         [this, s, &ret](scrub_result r) {
+                             ret.segments += r.segments;
+                             ret.bytes += r.bytes;
+                             if (r.segments == 0) {
+                                 // removed or rewritten meanwhile
+                                 return;
+                             }
+                             _probe.segment_scrubbed(r.bytes);
+                             if (!r.corrupt_offset) {
+                                 return;
+                             }
+                             _probe.corrupted_segment();
+                             vlog(
+                               stlog.error,
+                               "Corrupt batch at offset {} in {}",
+                               *r.corrupt_offset,
+                               *s);
+                             if (!ret.corrupt_offset) {
+                                 ret.corrupt_offset = r.corrupt_offset;
+                             }
+                         });
+                   })
+            .then([&ret] { return ret; });
+      });
+}
+
+bool disk_log_impl::is_retention_exempt() const {
     // TODO: this a workaround until we have raft-snapshotting in the the
     // controller so that we can still evict older data. At the moment we keep
     // the full history.
     constexpr std::string_view redpanda_ignored_ns = "redpanda";
     constexpr std::string_view kafka_ignored_ns = "kafka_internal";
+    return config().ntp().ns() == redpanda_ignored_ns
+           || config().ntp().ns() == kafka_ignored_ns;
+}
+
+std::optional<model::timestamp>
+disk_log_impl::oldest_reclaimable_segment() const {
+    if (
+      _closed || _segs.size() <= 1 || !config().is_collectable()
+      || is_retention_exempt()) {
+        return std::nullopt;
+    }
     if (
-      config().ntp().ns() == redpanda_ignored_ns
-      || config().ntp().ns() == kafka_ignored_ns) {
+      config().has_overrides()
+      && config().get_overrides().cleanup_policy_bitflags
+           == model::cleanup_policy_bitflags::none) {
+        return std::nullopt;
+    }
+    const auto& front = _segs.front();
+    if (
+      front->offsets().committed_offset
+      > std::min(_max_collectible_offset, _max_archived_offset)) {
+        return std::nullopt;
+    }
+    return front->index().max_timestamp();
+}
+
+ss::future<size_t>
+disk_log_impl::reclaim_oldest_segment(ss::abort_source& as) {
+    if (!oldest_reclaimable_segment()) {
+        return ss::make_ready_future<size_t>(0);
+    }
+    auto front = _segs.front();
+    const auto size = front->size_bytes();
+    return _readers_cache.evict().then(
+      [this, &as, front, size](readers_cache::eviction_guard g) {
+          return garbage_collect_segments(
+                   front->offsets().committed_offset, &as, "gc[disk_usage]")
+            .then([this, front, size] {
+                return is_front_segment(front) ? size_t(0) : size;
+            })
+            .finally([g = std::move(g)] {});
+      });
+}
+
+ss::future<> disk_log_impl::gc(compaction_config cfg) {
+    vassert(!_closed, "gc on closed log - {}", *this);
+
+    if (unlikely(cfg.asrc->abort_requested())) {
+        return ss::make_ready_future<>();
+    }
+    if (is_retention_exempt()) {
         return ss::make_ready_future<>();
     }
     if (cfg.max_bytes) {
@@ -311,6 +720,161 @@ ss::future<> disk_log_impl::remove_empty_segments() {
       });
 }
 
+std::optional<model::offset>
+disk_log_impl::closed_segment_end(model::offset o) const {
+    auto it = _segs.lower_bound(o);
+    if (it == _segs.end() || (*it)->has_appender() || (*it)->is_tombstone()) {
+        return std::nullopt;
+    }
+    return (*it)->offsets().dirty_offset;
+}
+
+ss::future<std::optional<segment_files>>
+disk_log_impl::open_closed_segment(model::offset base_offset) {
+    using ret_t = std::optional<segment_files>;
+    vassert(!_closed, "open_closed_segment on closed log - {}", *this);
+    auto it = std::find_if(
+      _segs.begin(), _segs.end(), [base_offset](const segment_set::type& s) {
+          return s->offsets().base_offset == base_offset;
+      });
+    if (
+      it == _segs.end() || (*it)->has_appender() || (*it)->empty()
+      || (*it)->is_tombstone()) {
+        return ss::make_ready_future<ret_t>();
+    }
+    auto seg = *it;
+    // the read lock keeps compaction from swapping the files in between
+    return seg->read_lock().then([seg](ss::rwlock::holder h) {
+        if (seg->is_closed()) {
+            return ss::make_ready_future<ret_t>();
+        }
+        auto data_name = ss::sstring(seg->reader().filename());
+        auto index_name = ss::sstring(seg->index().filename());
+        return ss::open_file_dma(data_name, ss::open_flags::ro)
+          .then([index_name](ss::file data) {
+              return ss::open_file_dma(index_name, ss::open_flags::ro)
+                .then([data](ss::file index) mutable {
+                    return std::make_tuple(std::move(data), std::move(index));
+                });
+          })
+          .then([seg](std::tuple<ss::file, ss::file> t) {
+              auto& [data, index] = t;
+              return ss::when_all_succeed(data.size(), index.size())
+                .then([seg, data, index](uint64_t data_sz, uint64_t idx_sz) {
+                    return segment_files{
+                      .base_offset = seg->offsets().base_offset,
+                      .dirty_offset = seg->offsets().dirty_offset,
+                      .term = seg->offsets().term,
+                      .max_timestamp = seg->index().max_timestamp(),
+                      .data = data,
+                      .data_size = data_sz,
+                      .index = index,
+                      .index_size = idx_sz};
+                });
+          })
+          .then([seg](segment_files files) {
+              auto path = ss::sstring(internal::compacted_index_path(
+                                        seg->reader().filename().c_str())
+                                        .string());
+              return ss::file_exists(path).then(
+                [path, files = std::move(files)](bool exists) mutable {
+                    if (!exists) {
+                        return ss::make_ready_future<ret_t>(std::move(files));
+                    }
+                    return ss::open_file_dma(path, ss::open_flags::ro)
+                      .then([files = std::move(files)](ss::file f) mutable {
+                          return f.size().then(
+                            [f, files = std::move(files)](uint64_t sz) mutable {
+                                files.compaction_index = f;
+                                files.compaction_index_size = sz;
+                                return ret_t(std::move(files));
+                            });
+                      });
+                });
+          })
+          .finally([h = std::move(h)] {});
+    });
+}
+
+ss::future<>
+disk_log_impl::install_segment(model::offset base_offset, model::term_id t) {
+    vassert(!_closed, "install_segment on closed log - {}", *this);
+    return _readers_cache.evict().then(
+      [this, base_offset, t](readers_cache::eviction_guard g) {
+          return do_install_segment(base_offset, t)
+            .finally([g = std::move(g)] {});
+      });
+}
+
+ss::future<>
+disk_log_impl::do_install_segment(model::offset base_offset, model::term_id t) {
+    auto ofs = offsets();
+    auto next = ofs.dirty_offset() >= 0
+                  ? ofs.dirty_offset + model::offset(1)
+                  : std::max(ofs.start_offset, model::offset(0));
+    if (base_offset != next || t < term()) {
+        return ss::make_exception_future<>(std::runtime_error(fmt::format(
+          "Cannot install segment at offset {} term {} in {}, "
+          "expected offset {} and term at least {}",
+          base_offset,
+          t,
+          config().ntp(),
+          next,
+          term())));
+    }
+    // the installed files may take the names of the prepared segment
+    auto f = discard_next_segment();
+    if (!_segs.empty() && _segs.back()->has_appender()) {
+        f = f.then([this] { return _segs.back()->release_appender(); });
+    }
+    return f.then([this] { return remove_empty_segments(); })
+      .then([this, base_offset, t] {
+          auto path = segment_path::make_segment_path(
+            config(), base_offset, t, record_version_type::v1);
+          auto index = std::filesystem::path(path).replace_extension(
+            "base_index");
+          auto staged_data = segment_receiver::staging_path(
+            config(), base_offset, t, segment_file_type::data);
+          auto staged_index = segment_receiver::staging_path(
+            config(), base_offset, t, segment_file_type::index);
+          vlog(stlog.info, "Installing received segment {}", path);
+          return ss::rename_file(staged_index.string(), index.string())
+            .then([staged_data, path] {
+                return ss::rename_file(staged_data.string(), path.string());
+            })
+            .then([this] {
+                return ss::sync_directory(config().work_directory());
+            })
+            .then([this, path] { return _manager.open_log_segment(path); });
+      })
+      .then([this](ss::lw_shared_ptr<segment> seg) {
+          return seg->materialize_index().then([this, seg](bool valid) {
+              if (!valid) {
+                  // never adopt a segment whose last offset is unknown
+                  return seg->close().then([seg] {
+                      return ss::when_all_succeed(
+                               ss::remove_file(seg->reader().filename()),
+                               ss::remove_file(seg->index().filename()))
+                        .then([seg] {
+                            return ss::make_exception_future<>(
+                              std::runtime_error(fmt::format(
+                                "Received segment has an invalid index: {}",
+                                seg)));
+                        });
+                  });
+              }
+              vassert(!_closed, "cannot add log segment to closed log");
+              seg->force_set_commit_offset_from_index();
+              if (config().is_compacted()) {
+                  seg->mark_as_compacted_segment();
+              }
+              _segs.add(std::move(seg));
+              _probe.segment_created();
+              return ss::now();
+          });
+      });
+}
+
 model::term_id disk_log_impl::term() const {
     if (_segs.empty()) {
         // does not make sense to return unitinialized term
@@ -382,20 +946,86 @@ ss::future<> disk_log_impl::new_segment(
   model::offset o, model::term_id t, ss::io_priority_class pc) {
     vassert(
       o() >= 0 && t() >= 0, "offset:{} and term:{} must be initialized", o, t);
-    return _manager.make_log_segment(config(), o, t, pc)
+    return take_next_segment(o, t, pc)
       .then([this](ss::lw_shared_ptr<segment> handles) mutable {
-          return remove_empty_segments().then(
-            [this, h = std::move(handles)]() mutable {
-                vassert(!_closed, "cannot add log segment to closed log");
-                if (config().is_compacted()) {
-                    h->mark_as_compacted_segment();
-                }
-                _segs.add(std::move(h));
-                _probe.segment_created();
+          // parked readers do not cover the new segment
+          return _readers_cache.evict().then(
+            [this, h = std::move(handles)](
+              readers_cache::eviction_guard g) mutable {
+                return remove_empty_segments().then(
+                  [this, h = std::move(h), g = std::move(g)]() mutable {
+                      vassert(
+                        !_closed, "cannot add log segment to closed log");
+                      if (config().is_compacted()) {
+                          h->mark_as_compacted_segment();
+                      }
+                      _segs.add(std::move(h));
+                      _segment_opened = ss::lowres_clock::now();
+                      _probe.segment_created();
+                      if (_segs.size() > 1) {
+                          // the previous segment may be compacted or
+                          // collected now that it is closed
+                          _manager.request_housekeeping(config().ntp());
+                      }
+                  });
             });
       });
 }
 
+void disk_log_impl::prepare_next_segment(
+  model::term_id t, model::offset o, ss::io_priority_class pc) {
+    if (_closed || _next_segment) {
+        return;
+    }
+    _next_segment = next_segment{
+      .base_offset = o,
+      .term = t,
+      .segment = ss::futurize_invoke([this, o, t, pc] {
+          return _manager.make_log_segment(
+            config(), o, t, pc, record_version_type::v1, std::nullopt,
+            fallocation_step());
+      }),
+    };
+}
+
+ss::future<ss::lw_shared_ptr<segment>> disk_log_impl::take_next_segment(
+  model::offset o, model::term_id t, ss::io_priority_class pc) {
+    if (
+      !_next_segment || _next_segment->base_offset != o
+      || _next_segment->term != t) {
+        // the roll was not the one that was prepared for
+        return discard_next_segment().then([this, o, t, pc] {
+            return _manager.make_log_segment(
+            config(), o, t, pc, record_version_type::v1, std::nullopt,
+            fallocation_step());
+        });
+    }
+    auto f = _next_segment->segment.get_future();
+    _next_segment.reset();
+    return f.handle_exception([this, o, t, pc](std::exception_ptr e) {
+        vlog(stlog.info, "Could not prepare segment {}: {}", o, e);
+        return _manager.make_log_segment(
+            config(), o, t, pc, record_version_type::v1, std::nullopt,
+            fallocation_step());
+    });
+}
+
+ss::future<> disk_log_impl::discard_next_segment() {
+    if (!_next_segment) {
+        return ss::now();
+    }
+    auto f = _next_segment->segment.get_future();
+    _next_segment.reset();
+    return f
+      .then([](ss::lw_shared_ptr<segment> s) {
+          s->tombstone();
+          return s->close().finally([s] {});
+      })
+      .handle_exception([this](std::exception_ptr e) {
+          vlog(stlog.info, "{} - error discarding next segment: {}", *this, e);
+      });
+}
+
 // config timeout is for the one calling reader consumer
 log_appender disk_log_impl::make_appender(log_append_config cfg) {
     vassert(!_closed, "make_appender on closed log - {}", *this);
@@ -425,6 +1055,18 @@ log_appender disk_log_impl::make_appender(log_append_config cfg) {
 }
 
 ss::future<> disk_log_impl::flush() {
+    vassert(!_closed, "flush on closed log - {}", *this);
+    if (_segs.empty()) {
+        return ss::make_ready_future<>();
+    }
+    if (auto wal = _manager.wal()) {
+        // the batches of the segment were queued for the wal as appended
+        return _segs.back()->flush([wal] { return wal->flush(); });
+    }
+    return _segs.back()->flush();
+}
+
+ss::future<> disk_log_impl::flush_segments() {
     vassert(!_closed, "flush on closed log - {}", *this);
     if (_segs.empty()) {
         return ss::make_ready_future<>();
@@ -443,6 +1085,84 @@ size_t disk_log_impl::max_segment_size() const {
              : _manager.config().max_segment_size;
 }
 
+std::optional<std::chrono::milliseconds>
+disk_log_impl::segment_roll_interval() const {
+    const auto& cfg = _manager.config();
+    const bool overridden = config().has_overrides()
+                            && config().get_overrides().segment_size;
+    if (!cfg.segment_roll_target || overridden) {
+        return std::nullopt;
+    }
+    // a few segments per retention period, so that retention removes the
+    // data close to when it expires
+    auto interval = *cfg.segment_roll_target;
+    if (!config().is_compacted()) {
+        auto retention = cfg.delete_retention;
+        if (
+          config().has_overrides()
+          && config().get_overrides().retention_time.has_value()) {
+            retention = *config().get_overrides().retention_time;
+        }
+        interval = std::min(interval, retention / 4);
+    }
+    return interval;
+}
+
+void disk_log_impl::update_segment_size_target(size_t rolled_bytes) {
+    _segment_roll_interval = segment_roll_interval();
+    if (!_segment_roll_interval) {
+        _segment_size_target = _max_segment_size;
+        return;
+    }
+    // ewma of the rate of the segments, weighing the last one by a third
+    static constexpr double weight = 1.0 / 3;
+    const auto age = std::max<std::chrono::milliseconds>(
+      std::chrono::milliseconds(1),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+        ss::lowres_clock::now() - _segment_opened));
+    const double rate = double(rolled_bytes) * 1000 / age.count();
+    _write_rate = _write_rate == 0 ? rate
+                                   : weight * rate + (1 - weight) * _write_rate;
+
+    auto target = static_cast<size_t>(
+      _write_rate * _segment_roll_interval->count() / 1000);
+    std::optional<size_t> retention_bytes = _manager.config().retention_bytes;
+    if (
+      config().has_overrides()
+      && config().get_overrides().retention_bytes.has_value()) {
+        retention_bytes = *config().get_overrides().retention_bytes;
+    }
+    if (retention_bytes && !config().is_compacted()) {
+        target = std::min(target, *retention_bytes / 4);
+    }
+    const auto min = std::min(
+      _manager.config().min_segment_size, _max_segment_size);
+    _segment_size_target = std::clamp(target, min, _max_segment_size);
+    vlog(
+      stlog.trace,
+      "{} segments target {} bytes, write rate {} bytes/s",
+      config().ntp(),
+      _segment_size_target,
+      size_t(_write_rate));
+}
+
+bool disk_log_impl::segment_expired(size_t size) const {
+    // a segment sized for a faster rate than the log is now written at
+    // would stay open past the roll target
+    return _segment_roll_interval
+           && size >= _manager.config().min_segment_size
+           && ss::lowres_clock::now() - _segment_opened
+                >= *_segment_roll_interval;
+}
+
+size_t disk_log_impl::fallocation_step() const {
+    // the appender grows its step while the segment is written fast
+    return std::clamp<size_t>(
+      ss::align_up<size_t>(_segment_size_target / 4, 4_KiB),
+      1_MiB,
+      segment_appender::fallocation_step);
+}
+
 size_t disk_log_impl::bytes_left_before_roll() const {
     if (_segs.empty()) {
         return 0;
@@ -452,8 +1172,8 @@ size_t disk_log_impl::bytes_left_before_roll() const {
         return 0;
     }
     auto fo = back->appender().file_byte_offset();
-    auto max = _max_segment_size;
-    if (fo >= max) {
+    auto max = _segment_size_target;
+    if (fo >= max || segment_expired(fo)) {
         return 0;
     }
     return max - fo;
@@ -469,12 +1189,11 @@ ss::future<> disk_log_impl::maybe_roll(
     if (!ptr->has_appender()) {
         return new_segment(next_offset, t, iopc);
     }
-    bool size_should_roll = false;
-
-    if (ptr->appender().file_byte_offset() >= _max_segment_size) {
-        size_should_roll = true;
-    }
+    const auto size = ptr->appender().file_byte_offset();
+    const bool size_should_roll = size >= _segment_size_target
+                                  || segment_expired(size);
     if (t != term() || size_should_roll) {
+        update_segment_size_target(size);
         return ptr->release_appender().then([this, next_offset, t, iopc] {
             return new_segment(next_offset, t, iopc);
         });
@@ -488,7 +1207,7 @@ disk_log_impl::make_unchecked_reader(log_reader_config config) {
     return _lock_mngr.range_lock(config).then(
       [this, cfg = config](std::unique_ptr<lock_manager::lease> lease) {
           return model::make_record_batch_reader<log_reader>(
-            std::move(lease), cfg, _probe);
+            std::move(lease), cfg, _probe, &_manager.read_buffers());
       });
 }
 
@@ -502,19 +1221,43 @@ disk_log_impl::make_reader(log_reader_config config) {
             config.start_offset,
             _start_offset)));
     }
-    return make_unchecked_reader(config);
+    if (auto reader = _readers_cache.get_reader(config); reader) {
+        _probe.readers_cache_hit();
+        return ss::make_ready_future<model::record_batch_reader>(
+          std::move(*reader));
+    }
+    _probe.readers_cache_miss();
+    return _lock_mngr.range_lock(config).then(
+      [this, cfg = config](std::unique_ptr<lock_manager::lease> lease) {
+          return _readers_cache.put(std::make_unique<log_reader>(
+            std::move(lease), cfg, _probe, &_manager.read_buffers()));
+      });
 }
 
 ss::future<model::record_batch_reader>
 disk_log_impl::make_reader(timequery_config config) {
     vassert(!_closed, "make_reader on closed log - {}", *this);
-    return _lock_mngr.range_lock(config).then(
-      [this, cfg = config](std::unique_ptr<lock_manager::lease> lease) {
+    return _lock_mngr.range_lock(config)
+      .then([](std::unique_ptr<lock_manager::lease> lease) {
+          using ret_t = std::unique_ptr<lock_manager::lease>;
+          if (lease->range.empty()) {
+              return ss::make_ready_future<ret_t>(std::move(lease));
+          }
+          // the time index of the first segment that reaches the timestamp
+          // tells where the scan for it can start
+          auto& idx = (*lease->range.begin())->index();
+          return idx.ensure_loaded().then(
+            [lease = std::move(lease)]() mutable { return std::move(lease); });
+      })
+      .then([this, cfg = config](std::unique_ptr<lock_manager::lease> lease) {
           auto start_offset = _start_offset;
           if (!lease->range.empty()) {
+              auto& seg = *lease->range.begin();
               // adjust for partial visibility of segment prefix
-              start_offset = std::max(
-                start_offset, (*lease->range.begin())->offsets().base_offset);
+              start_offset = std::max(start_offset, seg->offsets().base_offset);
+              if (auto nearest = seg->index().find_nearest(cfg.time)) {
+                  start_offset = std::max(start_offset, nearest->offset);
+              }
           }
           log_reader_config config(
             start_offset,
@@ -525,8 +1268,10 @@ disk_log_impl::make_reader(timequery_config config) {
             std::nullopt,
             cfg.time,
             cfg.abort_source);
+          // the lookup only looks at the timestamps of the headers
+          config.header_only = true;
           return model::make_record_batch_reader<log_reader>(
-            std::move(lease), config, _probe);
+            std::move(lease), config, _probe, &_manager.read_buffers());
       });
 }
 
@@ -564,19 +1309,139 @@ disk_log_impl::timequery(timequery_config cfg) {
       });
 }
 
-ss::future<> disk_log_impl::remove_segment_permanently(
-  ss::lw_shared_ptr<segment> s, std::string_view ctx) {
+ss::future<std::optional<model::offset>>
+disk_log_impl::find_latest_offset(bytes key, ss::io_priority_class pc) {
+    vassert(!_closed, "find_latest_offset on closed log - {}", *this);
+    using ret_t = std::optional<model::offset>;
+    if (!config().is_compacted()) {
+        return ss::make_exception_future<ret_t>(std::runtime_error(fmt::format(
+          "Key lookups need a compacted log - {}", config().ntp())));
+    }
+    // newest first: the first segment with the key has its latest offset
+    std::vector<ss::lw_shared_ptr<segment>> segs(_segs.begin(), _segs.end());
+    std::reverse(segs.begin(), segs.end());
+    return ss::do_with(
+      std::move(segs),
+      std::move(key),
+      ret_t{},
+      size_t(0),
+      [this, pc](
+        std::vector<ss::lw_shared_ptr<segment>>& segs,
+        const bytes& key,
+        ret_t& found,
+        size_t& i) {
+          return ss::do_until(
+                   [this, &segs, &found, &i] {
+                       return found || i == segs.size()
+                              || segs[i]->offsets().dirty_offset
+                                   < _start_offset;
+                   },
+                   [this, &segs, &key, &found, &i, pc] {
+                       return find_latest_offset(segs[i++], key, pc)
+                         .then([&found](ret_t o) { found = o; });
+                   })
+            .then([&found] { return found; });
+      });
+}
+
+ss::future<std::optional<model::offset>> disk_log_impl::find_latest_offset(
+  ss::lw_shared_ptr<segment> seg, const bytes& key, ss::io_priority_class pc) {
+    using ret_t = std::optional<model::offset>;
+    if (seg->is_tombstone() || seg->empty()) {
+        return ss::make_ready_future<ret_t>();
+    }
+    // the compacted index of the active segment is still being written, and
+    // the index only keeps a prefix of long keys
+    if (
+      seg->has_appender()
+      || key.size() > internal::spill_key_index::max_key_size) {
+        return find_latest_offset_in_data(seg, key, pc);
+    }
+    if (seg->has_key_filter() && !seg->get_key_filter().may_contain(key)) {
+        return ss::make_ready_future<ret_t>();
+    }
+    return find_latest_offset_in_index(seg, key, pc)
+      .handle_exception([this, seg, &key, pc](std::exception_ptr e) {
+          vlog(
+            stlog.debug,
+            "Cannot look up a key in the compacted index of {}, scanning its "
+            "data instead: {}",
+            seg->reader().filename(),
+            e);
+          return find_latest_offset_in_data(seg, key, pc);
+      });
+}
+
+ss::future<std::optional<model::offset>>
+disk_log_impl::find_latest_offset_in_index(
+  ss::lw_shared_ptr<segment> seg, const bytes& key, ss::io_priority_class pc) {
+    using ret_t = std::optional<model::offset>;
+    return seg->read_lock().then([this, seg, &key, pc](
+                                   ss::rwlock::holder h) {
+        if (seg->is_closed()) {
+            return ss::make_ready_future<ret_t>();
+        }
+        auto path = internal::compacted_index_path(
+          seg->reader().filename().c_str());
+        return internal::make_reader_handle(
+                 path, _manager.config().sanitize_fileops)
+          .then([this, seg, path, &key, pc](ss::file f) {
+              auto reader = make_file_backed_compacted_reader(
+                path.string(), std::move(f), pc, 64_KiB);
+              reader.reset();
+              return reader.load_footer()
+                .then([reader, seg, &key](
+                        compacted_index::footer footer) mutable {
+                    return reader.consume(
+                      internal::key_offset_index_reducer(
+                        key, footer.keys, seg->offsets().dirty_offset),
+                      model::no_timeout);
+                })
+                .then([this, seg](
+                        internal::key_offset_index_reducer::result r) {
+                    seg->set_key_filter(std::move(r.filter));
+                    if (r.offset && *r.offset < _start_offset) {
+                        return ret_t();
+                    }
+                    return r.offset;
+                })
+                .finally([reader]() mutable { return reader.close(); });
+          })
+          .finally([h = std::move(h)] {});
+    });
+}
+
+ss::future<std::optional<model::offset>>
+disk_log_impl::find_latest_offset_in_data(
+  ss::lw_shared_ptr<segment> seg, const bytes& key, ss::io_priority_class pc) {
+    using ret_t = std::optional<model::offset>;
+    auto start = std::max(seg->offsets().base_offset, _start_offset);
+    if (start > seg->offsets().dirty_offset) {
+        return ss::make_ready_future<ret_t>();
+    }
+    return make_unchecked_reader(
+             log_reader_config(start, seg->offsets().dirty_offset, pc))
+      .then([&key](model::record_batch_reader reader) {
+          return std::move(reader).consume(
+            internal::key_offset_batch_reducer(key), model::no_timeout);
+      });
+}
+
+static void
+tombstone_segment(storage::probe& probe, segment& s, std::string_view ctx) {
     vlog(stlog.info, "{} - tombstone & delete segment: {}", ctx, s);
     // stats accounting must happen synchronously
-    _probe.delete_segment(*s);
-    // background close
-    s->tombstone();
-    if (s->has_outstanding_locks()) {
+    probe.delete_segment(s);
+    s.tombstone();
+    if (s.has_outstanding_locks()) {
         vlog(
           stlog.info,
           "Segment has outstanding locks. Might take a while to close:{}",
-          s->reader().filename());
+          s.reader().filename());
     }
+}
+
+static ss::future<> close_tombstone(ss::lw_shared_ptr<segment> s) {
     return s->close()
       .handle_exception([s](std::exception_ptr e) {
           vlog(stlog.error, "Cannot close segment: {} - {}", e, s);
@@ -584,6 +1449,28 @@ ss::future<> disk_log_impl::remove_segment_permanently(
       .finally([s] {});
 }
 
+ss::future<> disk_log_impl::remove_segment_permanently(
+  ss::lw_shared_ptr<segment> s, std::string_view ctx) {
+    tombstone_segment(_probe, *s, ctx);
+    return close_tombstone(std::move(s));
+}
+
+ss::future<> disk_log_impl::remove_segment_in_background(
+  ss::lw_shared_ptr<segment> s, std::string_view ctx) {
+    tombstone_segment(_probe, *s, ctx);
+    if (_deletions.is_closed()) {
+        // the log is closing and no longer waits for background deletions
+        return close_tombstone(std::move(s));
+    }
+    (void)ss::with_gate(_deletions, [this, s = std::move(s)]() mutable {
+        return ss::with_semaphore(
+          _manager.segment_deletions(), 1, [s = std::move(s)]() mutable {
+              return close_tombstone(std::move(s));
+          });
+    });
+    return ss::now();
+}
+
 ss::future<> disk_log_impl::remove_full_segments(model::offset o) {
     return ss::do_until(
       [this, o] {
@@ -613,10 +1500,12 @@ disk_log_impl::remove_prefix_full_segments(truncate_prefix_config cfg) {
 
 ss::future<> disk_log_impl::truncate_prefix(truncate_prefix_config cfg) {
     vassert(!_closed, "truncate_prefix() on closed log - {}", *this);
-    return _failure_probes.truncate_prefix().then([this, cfg]() mutable {
-        // dispatch the actual truncation
-        return do_truncate_prefix(cfg);
-    });
+    return _failure_probes.truncate_prefix()
+      .then([this] { return _readers_cache.evict(); })
+      .then([this, cfg](readers_cache::eviction_guard g) mutable {
+          // dispatch the actual truncation
+          return do_truncate_prefix(cfg).finally([g = std::move(g)] {});
+      });
 }
 
 ss::future<> disk_log_impl::do_truncate_prefix(truncate_prefix_config cfg) {
@@ -686,13 +1575,23 @@ ss::future<> disk_log_impl::do_truncate_prefix(truncate_prefix_config cfg) {
 
 ss::future<> disk_log_impl::truncate(truncate_config cfg) {
     vassert(!_closed, "truncate() on closed log - {}", *this);
-    return _failure_probes.truncate().then([this, cfg]() mutable {
-        // dispatch the actual truncation
-        return do_truncate(cfg);
-    });
+    auto f = ss::now();
+    if (auto wal = _manager.wal()) {
+        // the batches past the truncation must not be replayed from the wal
+        f = wal->truncate(config().ntp(), cfg.base_offset);
+    }
+    return f.then([this] { return _failure_probes.truncate(); })
+      .then([this] { return _readers_cache.evict(); })
+      .then([this, cfg](readers_cache::eviction_guard g) mutable {
+          // dispatch the actual truncation
+          return discard_next_segment()
+            .then([this, cfg] { return do_truncate(cfg); })
+            .finally([g = std::move(g)] {});
+      });
 }
 
 ss::future<> disk_log_impl::do_truncate(truncate_config cfg) {
+    clear_cached_tail();
     auto stats = offsets();
     if (cfg.base_offset > stats.dirty_offset) {
         return ss::make_ready_future<>();
@@ -727,8 +1626,10 @@ ss::future<> disk_log_impl::do_truncate(truncate_config cfg) {
           // an unchecked reader is created which does not enforce the logical
           // starting offset. this is needed because we really do want to read
           // all the data in the segment to find the correct physical offset.
-          return make_unchecked_reader(
-                   log_reader_config(start, cfg.base_offset, cfg.prio))
+          // the sizes of the batches are all that is needed to find it.
+          log_reader_config reader_cfg(start, cfg.base_offset, cfg.prio);
+          reader_cfg.header_only = true;
+          return make_unchecked_reader(reader_cfg)
             .then([cfg, initial_size](model::record_batch_reader reader) {
                 return std::move(reader).consume(
                   internal::offset_to_filepos_consumer(
@@ -773,8 +1674,11 @@ ss::future<> disk_log_impl::do_truncate(truncate_config cfg) {
 }
 
 bytes disk_log_impl::start_offset_key() const {
+    return start_offset_key(config().ntp());
+}
+
+bytes disk_log_impl::start_offset_key(model::ntp ntp) {
     iobuf buf;
-    auto ntp = config().ntp();
     reflection::serialize(buf, kvstore_key_type::start_offset, std::move(ntp));
     return iobuf_to_bytes(buf);
 }
@@ -791,6 +1695,7 @@ model::offset disk_log_impl::read_start_offset() const {
 std::ostream& disk_log_impl::print(std::ostream& o) const {
     return o << "{offsets:" << offsets()
              << ", max_collectible_offset: " << _max_collectible_offset
+             << ", max_archived_offset: " << _max_archived_offset
              << ", closed:" << _closed << ", config:" << config()
              << ", logs:" << _segs << "}";
 }
@@ -19,6 +19,7 @@
 #include "storage/log.h"
 #include "storage/log_reader.h"
 #include "storage/probe.h"
+#include "storage/readers_cache.h"
 #include "storage/segment_appender.h"
 #include "storage/segment_reader.h"
 #include "storage/types.h"
@@ -26,9 +27,14 @@
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/shared_future.hh>
 
 #include <absl/container/flat_hash_map.h>
 
+#include <deque>
+#include <utility>
+
 namespace storage {
 
 class disk_log_impl final : public log::impl {
@@ -45,12 +51,19 @@ public:
     ss::future<> close() final;
     ss::future<> remove() final;
     ss::future<> flush() final;
+    ss::future<> flush_segments() final;
     ss::future<> truncate(truncate_config) final;
     ss::future<> truncate_prefix(truncate_prefix_config) final;
     ss::future<> compact(compaction_config) final;
 
     ss::future<model::offset> monitor_eviction(ss::abort_source&) final;
     void set_collectible_offset(model::offset) final;
+    void set_archived_offset(model::offset) final;
+    void set_batch_cache_policy(batch_cache_policy) final;
+    ss::future<> warm_batch_cache(size_t, ss::io_priority_class) final;
+    std::optional<model::timestamp> oldest_reclaimable_segment() const final;
+    ss::future<size_t> reclaim_oldest_segment(ss::abort_source&) final;
+    ss::future<scrub_result> scrub(scrub_config) final;
 
     ss::future<model::record_batch_reader> make_reader(log_reader_config) final;
     ss::future<model::record_batch_reader> make_reader(timequery_config);
@@ -60,12 +73,34 @@ public:
     ss::future<std::optional<timequery_result>>
     timequery(timequery_config cfg) final;
     size_t segment_count() const final { return _segs.size(); }
+    storage::log_stats stats() const final {
+        return storage::log_stats{
+          .size_bytes = _probe.partition_size(),
+          .batch_cache_hits = _probe.batch_cache_hits(),
+          .batch_cache_misses = _probe.batch_cache_misses(),
+        };
+    }
+    storage::compaction_backlog get_compaction_backlog() const final;
+    std::optional<model::offset> closed_segment_end(model::offset) const final;
+    ss::future<std::optional<segment_files>>
+      open_closed_segment(model::offset) final;
+    ss::future<> install_segment(model::offset, model::term_id) final;
+    ss::future<std::optional<model::offset>>
+      find_latest_offset(bytes, ss::io_priority_class) final;
     offset_stats offsets() const final;
     std::optional<model::term_id> get_term(model::offset) const final;
     std::ostream& print(std::ostream&) const final;
 
     ss::future<> maybe_roll(
       model::term_id, model::offset next_offset, ss::io_priority_class);
+    /// \brief creates the segment that follows the active one, in the
+    /// background, once the active one is full
+    ///
+    /// Rolling to the segment at this offset and term then only adds it to
+    /// the log, instead of creating its files on the append path. Any other
+    /// roll, truncation, or close discards it.
+    void prepare_next_segment(
+      model::term_id, model::offset next_offset, ss::io_priority_class);
 
     probe& get_probe() { return _probe; }
     model::term_id term() const;
@@ -73,6 +108,9 @@ public:
     const segment_set& segments() const { return _segs; }
     size_t bytes_left_before_roll() const;
 
+    /// the kvstore key of the start offset of a log
+    static bytes start_offset_key(model::ntp);
+
 private:
     friend class disk_log_appender; // for multi-term appends
     friend class disk_log_builder;  // for tests
@@ -89,19 +127,44 @@ private:
     bytes start_offset_key() const;
     model::offset read_start_offset() const;
 
+    ss::future<> do_housekeeping(compaction_config);
     ss::future<> do_compact(compaction_config);
+    std::vector<ss::lw_shared_ptr<segment>>
+    find_adjacent_compaction_range() const;
+    ss::future<> compact_adjacent_segments(compaction_config);
     ss::future<> gc(compaction_config);
+    ss::future<> recompress(compaction_config, model::compression);
+    ss::future<> coalesce(compaction_config, size_t);
 
     ss::future<> remove_empty_segments();
 
     ss::future<> remove_segment_permanently(
       ss::lw_shared_ptr<segment> segment_to_tombsone,
       std::string_view logging_context_msg);
+    /// \brief tombstones the segment, and closes and deletes it later
+    ///
+    /// The log no longer uses the segment, but its readers may, which
+    /// closing the segment waits for. Deletions are bounded across the logs
+    /// of the core, see log_manager::segment_deletions
+    ss::future<> remove_segment_in_background(
+      ss::lw_shared_ptr<segment>, std::string_view logging_context_msg);
 
     ss::future<> new_segment(
       model::offset starting_offset,
       model::term_id term_for_this_segment,
       ss::io_priority_class prio);
+    ss::future<> do_install_segment(model::offset, model::term_id);
+    /// \brief latest offset of the key in the segment, from the start of
+    /// the log
+    ss::future<std::optional<model::offset>> find_latest_offset(
+      ss::lw_shared_ptr<segment>, const bytes&, ss::io_priority_class);
+    ss::future<std::optional<model::offset>> find_latest_offset_in_index(
+      ss::lw_shared_ptr<segment>, const bytes&, ss::io_priority_class);
+    ss::future<std::optional<model::offset>> find_latest_offset_in_data(
+      ss::lw_shared_ptr<segment>, const bytes&, ss::io_priority_class);
+    ss::future<ss::lw_shared_ptr<segment>>
+      take_next_segment(model::offset, model::term_id, ss::io_priority_class);
+    ss::future<> discard_next_segment();
 
     ss::future<> do_truncate(truncate_config);
     ss::future<> remove_full_segments(model::offset o);
@@ -119,13 +182,36 @@ private:
     model::offset time_based_gc_max_offset(model::timestamp);
 
     bool is_front_segment(const segment_set::type&) const;
+    /// the logs of the internal namespaces, which retention leaves alone
+    bool is_retention_exempt() const;
 
 private:
     size_t max_segment_size() const;
+    /// \brief sizes the next segments from the write rate of the log, as
+    /// measured over the segment being rolled, see
+    /// log_config::segment_roll_target
+    void update_segment_size_target(size_t rolled_bytes);
+    std::optional<std::chrono::milliseconds> segment_roll_interval() const;
+    /// \brief whether the active segment, of this size, has been open for
+    /// longer than the roll interval of the log
+    bool segment_expired(size_t size) const;
+    /// \brief fallocation step of the appender of the next segments, a
+    /// fraction of their target size
+    size_t fallocation_step() const;
+    /// \brief whether the appended batch goes into the batch cache, see
+    /// batch_cache_policy. evicts the batches that fall out of the cached
+    /// tail of a follower
+    bool cache_appended(const model::record_batch&);
+    void clear_cached_tail();
     struct eviction_monitor {
         ss::promise<model::offset> promise;
         ss::abort_source::subscription subscription;
     };
+    struct next_segment {
+        model::offset base_offset;
+        model::term_id term;
+        ss::shared_future<ss::lw_shared_ptr<segment>> segment;
+    };
     bool _closed{false};
     log_manager& _manager;
     segment_set _segs;
@@ -133,10 +219,27 @@ private:
     model::offset _start_offset;
     lock_manager _lock_mngr;
     storage::probe _probe;
+    readers_cache _readers_cache;
+    /// segments being deleted in the background
+    ss::gate _deletions;
     failure_probes _failure_probes;
     std::optional<eviction_monitor> _eviction_monitor;
+    std::optional<next_segment> _next_segment;
     model::offset _max_collectible_offset;
+    model::offset _max_archived_offset;
     size_t _max_segment_size;
+    // the segments of the log roll at this size, or once open for
+    // _segment_roll_interval when sized from the write rate
+    size_t _segment_size_target;
+    std::optional<std::chrono::milliseconds> _segment_roll_interval;
+    ss::lowres_clock::time_point _segment_opened{ss::lowres_clock::now()};
+    // bytes per second written to the log, averaged over its rolls
+    double _write_rate{0};
+    batch_cache_policy _cache_policy{batch_cache_policy::all};
+    // base offsets and sizes of the batches cached under the tail policy,
+    // oldest first
+    std::deque<std::pair<model::offset, size_t>> _cached_tail;
+    size_t _cached_tail_bytes{0};
 };
 
 } // namespace storage
@@ -87,7 +87,8 @@ private:
               method_name)));
         }
         if (_delay_methods & type(method)) {
-            return ss::sleep(std::chrono::milliseconds(_prng() % 50));
+            const auto max = delay_for(type(method)).count();
+            return ss::sleep(std::chrono::milliseconds(_prng() % (max + 1)));
         }
         if (_termination_methods & type(method)) {
             std::terminate();
@@ -131,7 +132,8 @@ private:
                                  "storage::parser::consume"));
         }
         if (_delay_methods & type(methods::consume)) {
-            return ss::sleep(std::chrono::milliseconds(_prng() % 50));
+            const auto max = delay_for(type(methods::consume)).count();
+            return ss::sleep(std::chrono::milliseconds(_prng() % (max + 1)));
         }
         if (_termination_methods & type(methods::consume)) {
             std::terminate();
@@ -0,0 +1,76 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/flush_coordinator.h"
+
+#include "storage/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/future-util.hh>
+
+#include <utility>
+
+namespace storage {
+
+ss::future<> flush_coordinator::flush(log l) {
+    if (_gate.is_closed()) {
+        return ss::make_exception_future<>(ss::gate_closed_exception());
+    }
+    auto ntp = l.config().ntp();
+    auto [it, inserted] = _next.try_emplace(std::move(ntp), std::move(l));
+    if (!inserted) {
+        ++_stats.coalesced;
+    }
+    auto f = it->second.done.get_shared_future();
+    maybe_dispatch_wave();
+    return f;
+}
+
+void flush_coordinator::maybe_dispatch_wave() {
+    if (_wave_in_flight || _next.empty() || _gate.is_closed()) {
+        return;
+    }
+    _wave_in_flight = true;
+    (void)ss::with_gate(_gate, [this] {
+        return dispatch_wave(std::exchange(_next, {})).finally([this] {
+            _wave_in_flight = false;
+            maybe_dispatch_wave();
+        });
+    });
+}
+
+ss::future<> flush_coordinator::dispatch_wave(wave_t wave) {
+    ++_stats.waves;
+    _stats.flushes += wave.size();
+    vlog(stlog.trace, "dispatching flush wave of {} logs", wave.size());
+    return ss::do_with(std::move(wave), [](wave_t& wave) {
+        return ss::parallel_for_each(wave, [](wave_t::value_type& e) {
+            auto& p = e.second;
+            return ss::futurize_invoke([&p] { return p.log.flush(); })
+              .then_wrapped([&p](ss::future<> f) {
+                  if (f.failed()) {
+                      p.done.set_exception(f.get_exception());
+                  } else {
+                      p.done.set_value();
+                  }
+              });
+        });
+    });
+}
+
+ss::future<> flush_coordinator::stop() {
+    return _gate.close().then([this] {
+        for (auto& [ntp, p] : _next) {
+            p.done.set_exception(ss::gate_closed_exception());
+        }
+        _next.clear();
+    });
+}
+
+} // namespace storage
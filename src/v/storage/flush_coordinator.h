@@ -0,0 +1,73 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "model/fundamental.h"
+#include "seastarx.h"
+#include "storage/log.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/shared_future.hh>
+
+#include <absl/container/node_hash_map.h>
+
+namespace storage {
+
+/*
+ * Coalesces the flushes requested by all logs of a shard.
+ *
+ * Requests are grouped in waves. A wave dispatches the flushes of all its
+ * logs at once, so that the fdatasync calls reach the disk together instead
+ * of one after another. While a wave is in flight, new requests are queued
+ * for the next one, which starts as soon as the current wave completes. The
+ * size of the waves therefore adapts to the latency of the disk: an idle
+ * shard flushes right away, a busy one flushes many logs per wave.
+ *
+ * Requests of a log already queued for the next wave share its flush. Each
+ * request is resolved as soon as the flush of its own log completes, without
+ * waiting for the rest of the wave.
+ */
+class flush_coordinator {
+public:
+    struct stats {
+        uint64_t waves{0};
+        uint64_t flushes{0};
+        uint64_t coalesced{0};
+    };
+
+    /// resolves once all data appended to the log so far is durable
+    ss::future<> flush(log);
+
+    ss::future<> stop();
+
+    const stats& get_stats() const { return _stats; }
+
+private:
+    struct pending_flush {
+        explicit pending_flush(log l)
+          : log(std::move(l)) {}
+        storage::log log;
+        ss::shared_promise<> done;
+    };
+    using wave_t = absl::node_hash_map<model::ntp, pending_flush>;
+
+    void maybe_dispatch_wave();
+    ss::future<> dispatch_wave(wave_t);
+
+    wave_t _next;
+    bool _wave_in_flight{false};
+    stats _stats;
+    ss::gate _gate;
+};
+
+} // namespace storage
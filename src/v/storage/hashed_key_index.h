@@ -0,0 +1,159 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/bytes.h"
+#include "hashing/xx.h"
+#include "model/fundamental.h"
+#include "vassert.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace storage::internal {
+
+/**
+ * Flat, open-addressed table of the most recent offset of each key, used to
+ * deduplicate compacted indices whose keyspace does not fit in memory.
+ *
+ * Keys are never stored. A key is identified by its 64-bit xxhash, which also
+ * selects the slot, and distinguished from colliding keys by an independent
+ * 32-bit fingerprint. The table is allocated once with a fixed capacity and
+ * uses linear probing, with backward shift deletion so that no tombstones are
+ * left behind by evictions.
+ */
+class hashed_key_index {
+public:
+    struct slot {
+        /// 0 means the slot is empty
+        uint64_t hash{0};
+        model::offset offset;
+        uint32_t natural_index{0};
+        uint32_t fingerprint{0};
+    };
+
+    struct key_hash {
+        explicit key_hash(bytes_view k) noexcept
+          : hash(xxhash_64(reinterpret_cast<const char*>(k.data()), k.size()))
+          , fingerprint(
+              xxhash_32(reinterpret_cast<const char*>(k.data()), k.size())) {
+            // reserve 0 for empty slots
+            hash = hash == 0 ? 1 : hash;
+        }
+        uint64_t hash;
+        uint32_t fingerprint;
+    };
+
+    static constexpr size_t min_capacity = 16;
+    static constexpr size_t slot_size = sizeof(slot);
+
+    /// the capacity is the largest power of two slots that fit in max_memory
+    explicit hashed_key_index(size_t max_memory)
+      : _slots(capacity_for(max_memory))
+      , _mask(_slots.size() - 1) {}
+
+    size_t size() const { return _size; }
+    size_t capacity() const { return _slots.size(); }
+    size_t memory_usage() const { return capacity() * slot_size; }
+    bool empty() const { return _size == 0; }
+
+    /// past this load the table must be trimmed before inserting
+    bool needs_eviction() const {
+        return _size + 1 > (capacity() / 8) * 7; // 0.875
+    }
+    /// eviction stops once the load is at most 0.8
+    bool evicted_enough() const {
+        return _size == 0 || _size <= (capacity() / 10) * 8;
+    }
+
+    /// returns the slot of the key, or the empty slot where it belongs
+    slot& find(const key_hash& k) {
+        size_t i = k.hash & _mask;
+        while (_slots[i].hash != 0 && _slots[i].hash != k.hash) {
+            i = (i + 1) & _mask;
+        }
+        return _slots[i];
+    }
+
+    /// fills an empty slot returned by find()
+    void insert(slot& s, const key_hash& k, model::offset o, uint32_t idx) {
+        vassert(s.hash == 0, "cannot insert into a used slot");
+        vassert(!needs_eviction(), "hashed key index is full: {}", _size);
+        s = slot{
+          .hash = k.hash,
+          .offset = o,
+          .natural_index = idx,
+          .fingerprint = k.fingerprint};
+        ++_size;
+    }
+
+    /**
+     * Removes the first used slot at or after `start` and returns the natural
+     * index it held.
+     */
+    uint32_t evict(size_t start) {
+        vassert(!empty(), "cannot evict from an empty hashed key index");
+        size_t i = start & _mask;
+        while (_slots[i].hash == 0) {
+            i = (i + 1) & _mask;
+        }
+        auto idx = _slots[i].natural_index;
+        erase(i);
+        return idx;
+    }
+
+    template<typename Func>
+    void for_each(Func&& f) const {
+        for (const auto& s : _slots) {
+            if (s.hash != 0) {
+                f(s);
+            }
+        }
+    }
+
+private:
+    static size_t capacity_for(size_t max_memory) {
+        size_t n = min_capacity;
+        while (n * 2 * slot_size <= max_memory) {
+            n *= 2;
+        }
+        return n;
+    }
+
+    void erase(size_t i) {
+        // shift back every slot of the probe sequence that would become
+        // unreachable from its home slot once `i` is emptied
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & _mask;
+            if (_slots[j].hash == 0) {
+                break;
+            }
+            const size_t home = _slots[j].hash & _mask;
+            const bool reachable = i <= j ? (i < home && home <= j)
+                                          : (i < home || home <= j);
+            if (reachable) {
+                continue;
+            }
+            _slots[i] = _slots[j];
+            i = j;
+        }
+        _slots[i] = slot{};
+        --_size;
+    }
+
+    std::vector<slot> _slots;
+    size_t _mask;
+    size_t _size{0};
+};
+
+} // namespace storage::internal
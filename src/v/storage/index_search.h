@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace storage::details {
+
+/*
+ * Searches over the sorted columns of an index_state.
+ *
+ * The bisection is branchless: each step is a conditional move rather than a
+ * branch, which the cpu cannot predict for random lookups. Both candidate
+ * positions of the next step are prefetched so that the loads of large
+ * indices overlap. Once the remaining range fits in a few cache lines it is
+ * finished with a linear count which the compiler vectorizes.
+ *
+ * The on-disk layout of the index is kept as is, so the index can still be
+ * appended to and truncated in place.
+ */
+
+/// Ranges at most this long are searched linearly.
+static constexpr size_t index_search_linear_threshold = 32;
+
+template<typename Less>
+inline size_t
+index_partition_point(const uint32_t* first, size_t n, Less less) {
+    const uint32_t* base = first;
+    while (n > index_search_linear_threshold) {
+        const size_t half = n / 2;
+        __builtin_prefetch(base + half / 2);
+        __builtin_prefetch(base + half + half / 2);
+        base = less(base[half]) ? base + half : base;
+        n -= half;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += less(base[i]) ? 1 : 0;
+    }
+    return static_cast<size_t>(base - first) + count;
+}
+
+/// Position of the first element not less than `x`, like std::lower_bound.
+inline size_t index_lower_bound(const std::vector<uint32_t>& v, uint32_t x) {
+    return index_partition_point(
+      v.data(), v.size(), [x](uint32_t e) { return e < x; });
+}
+
+/// Position of the first element greater than `x`, like std::upper_bound.
+inline size_t index_upper_bound(const std::vector<uint32_t>& v, uint32_t x) {
+    return index_partition_point(
+      v.data(), v.size(), [x](uint32_t e) { return e <= x; });
+}
+
+} // namespace storage::details
@@ -66,6 +66,7 @@ bool index_state::maybe_index(
     if (empty()) {
         base_timestamp = first_timestamp;
         max_timestamp = first_timestamp;
+        bitflags |= monotonic_time_index;
         retval = true;
     }
     // NOTE: we don't need the 'max()' trick below because we controll the
@@ -74,10 +75,11 @@ bool index_state::maybe_index(
     max_timestamp = std::max(max_timestamp, last_timestamp);
     // always saving the first batch simplifies a lot of book keeping
     if (accumulator >= step || retval) {
-        // We know that a segment cannot be > 4GB
+        // We know that a segment cannot be > 4GB. The running max keeps the
+        // time index sorted when timestamps go backwards
         add_entry(
           batch_base_offset() - base_offset(),
-          last_timestamp() - base_timestamp(),
+          max_timestamp() - base_timestamp(),
           starting_position_in_file);
 
         retval = true;
@@ -98,9 +100,9 @@ std::ostream& operator<<(std::ostream& o, const index_state& s) {
              << ")}";
 }
 
-std::optional<index_state> index_state::hydrate_from_buffer(iobuf b) {
-    iobuf_parser parser(std::move(b));
-    index_state retval;
+/// parses the header fields of `retval` and returns the number of entries
+static std::optional<uint32_t>
+hydrate_header(iobuf_parser& parser, index_state& retval) {
     retval.version = reflection::adl<int8_t>{}.from(parser);
     if (retval.version != 1) {
         // we screwed up version 0; and we only have version 1, so
@@ -119,23 +121,63 @@ std::optional<index_state> index_state::hydrate_from_buffer(iobuf b) {
     retval.max_timestamp = model::timestamp(
       reflection::adl<model::timestamp::type>{}.from(parser));
 
-    const uint32_t vsize = ss::le_to_cpu(
-      reflection::adl<uint32_t>{}.from(parser));
-    retval.relative_offset_index.reserve(vsize);
-    retval.relative_time_index.reserve(vsize);
-    retval.position_index.reserve(vsize);
-    for (auto i = 0U; i < vsize; ++i) {
-        retval.relative_offset_index.push_back(
-          reflection::adl<uint32_t>{}.from(parser));
+    return ss::le_to_cpu(reflection::adl<uint32_t>{}.from(parser));
+}
+
+std::optional<index_state>
+index_state::hydrate_header_from_buffer(iobuf b, size_t file_size) {
+    if (b.size_bytes() < serialized_header_size) {
+        return std::nullopt;
     }
-    for (auto i = 0U; i < vsize; ++i) {
-        retval.relative_time_index.push_back(
-          reflection::adl<uint32_t>{}.from(parser));
+    iobuf_parser parser(std::move(b));
+    index_state retval;
+    auto vsize = hydrate_header(parser, retval);
+    if (!vsize) {
+        return std::nullopt;
     }
-    for (auto i = 0U; i < vsize; ++i) {
-        retval.position_index.push_back(
-          reflection::adl<uint32_t>{}.from(parser));
+    const size_t expected_size = serialized_header_size
+                                 + size_t(*vsize) * sizeof(uint32_t) * 3;
+    if (unlikely(file_size != expected_size)) {
+        vlog(
+          stlog.debug,
+          "Invalid index size. Got:{}, expected:{}",
+          file_size,
+          expected_size);
+        return std::nullopt;
+    }
+    return retval;
+}
+
+/// the columns are arrays of little endian integers, copied as a whole
+static void hydrate_column(
+  iobuf_parser& parser, std::vector<uint32_t>& column, uint32_t n) {
+    column.resize(n);
+    parser.consume_to(
+      size_t(n) * sizeof(uint32_t), reinterpret_cast<char*>(column.data()));
+    for (auto& v : column) {
+        v = ss::le_to_cpu(v);
+    }
+}
+
+std::optional<index_state> index_state::hydrate_from_buffer(iobuf b) {
+    iobuf_parser parser(std::move(b));
+    index_state retval;
+    auto hydrated_size = hydrate_header(parser, retval);
+    if (!hydrated_size) {
+        return std::nullopt;
+    }
+    const uint32_t vsize = *hydrated_size;
+    if (unlikely(parser.bytes_left() < size_t(vsize) * sizeof(uint32_t) * 3)) {
+        vlog(
+          stlog.debug,
+          "Index is too short for {} entries: {} bytes",
+          vsize,
+          parser.bytes_left());
+        return std::nullopt;
     }
+    hydrate_column(parser, retval.relative_offset_index, vsize);
+    hydrate_column(parser, retval.relative_time_index, vsize);
+    hydrate_column(parser, retval.position_index, vsize);
     const auto computed_checksum = storage::index_state::checksum_state(retval);
     if (unlikely(retval.checksum != computed_checksum)) {
         vlog(
@@ -23,7 +23,7 @@ namespace storage {
    1 byte  - version
    4 bytes - size - does not include the version or size
    8 bytes - checksum - xxhash32 -- we checksum everything below the checksum
-   4 bytes - bitflags - unused
+   4 bytes - bitflags - see index_state::monotonic_time_index
    8 bytes - based_offset
    8 bytes - max_offset
    8 bytes - base_time
@@ -46,7 +46,11 @@ struct index_state {
     uint32_t size{0};
     /// \brief currently xxhash64
     uint64_t checksum{0};
-    /// \brief unused
+    /// \brief the relative_time_index holds the running max timestamp of the
+    /// batches up to each entry, rather than the max timestamp of the batch of
+    /// the entry. Indices written before the flag existed are not searched by
+    /// timestamp.
+    static constexpr uint32_t monotonic_time_index = 1;
     uint32_t bitflags{0};
     // the batch's base_offset of the first batch
     model::offset base_offset{0};
@@ -63,6 +67,9 @@ struct index_state {
     std::vector<uint32_t> position_index;
 
     bool empty() const { return relative_offset_index.empty(); }
+    bool has_monotonic_time_index() const {
+        return (bitflags & monotonic_time_index) != 0;
+    }
 
     void
     add_entry(uint32_t relative_offset, uint32_t relative_time, uint32_t pos) {
@@ -70,6 +77,12 @@ struct index_state {
         relative_time_index.push_back(relative_time);
         position_index.push_back(pos);
     }
+    /// releases the spare capacity of the entries, once no more are added
+    void shrink_to_fit() {
+        relative_offset_index.shrink_to_fit();
+        relative_time_index.shrink_to_fit();
+        position_index.shrink_to_fit();
+    }
     void pop_back() {
         relative_offset_index.pop_back();
         relative_time_index.pop_back();
@@ -81,6 +94,12 @@ struct index_state {
     }
     iobuf checksum_and_serialize();
 
+    /// \brief size of the serialized fields that precede the index entries
+    static constexpr size_t serialized_header_size
+      = sizeof(int8_t) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t)
+        + sizeof(model::offset::type) * 2 + sizeof(model::timestamp::type) * 2
+        + sizeof(uint32_t);
+
     bool maybe_index(
       size_t accumulator,
       size_t step,
@@ -91,6 +110,11 @@ struct index_state {
       model::timestamp last_timestamp);
 
     static std::optional<index_state> hydrate_from_buffer(iobuf);
+    /// \brief hydrates the header fields only, the index entries are left
+    /// empty. since the checksum covers the entries, the header is validated
+    /// by checking that `file_size` fits the number of entries instead
+    static std::optional<index_state>
+    hydrate_header_from_buffer(iobuf, size_t file_size);
     static uint64_t checksum_state(const index_state&);
     friend std::ostream& operator<<(std::ostream&, const index_state&);
 };
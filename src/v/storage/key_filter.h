@@ -0,0 +1,82 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/bytes.h"
+#include "hashing/xx.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace storage {
+
+/// \brief bloom filter of the keys of a segment
+///
+/// Answers whether a key may be in the segment, with about 1% false
+/// positives at the default of 10 bits per key, and no false negatives.
+/// The probes are derived from a single 64bit hash of the key, split in two
+/// halves for double hashing.
+class key_filter {
+public:
+    static constexpr size_t default_bits_per_key = 10;
+
+    explicit key_filter(
+      size_t keys, size_t bits_per_key = default_bits_per_key)
+      : _bits(std::max<size_t>(
+        1, (keys * bits_per_key + word_bits - 1) / word_bits))
+      , _probes(std::clamp<size_t>(bits_per_key * 69 / 100, 1, 30)) {}
+
+    void add(bytes_view key) {
+        auto [h, delta] = hash(key);
+        for (size_t i = 0; i < _probes; ++i) {
+            auto bit = h % size_bits();
+            _bits[bit / word_bits] |= uint64_t(1) << (bit % word_bits);
+            h += delta;
+        }
+    }
+
+    bool may_contain(bytes_view key) const {
+        auto [h, delta] = hash(key);
+        for (size_t i = 0; i < _probes; ++i) {
+            auto bit = h % size_bits();
+            auto mask = uint64_t(1) << (bit % word_bits);
+            if ((_bits[bit / word_bits] & mask) == 0) {
+                return false;
+            }
+            h += delta;
+        }
+        return true;
+    }
+
+    size_t memory_usage() const { return _bits.size() * sizeof(uint64_t); }
+
+private:
+    static constexpr size_t word_bits = 64;
+
+    size_t size_bits() const { return _bits.size() * word_bits; }
+
+    static std::pair<uint64_t, uint64_t> hash(bytes_view key) {
+        auto h = xxhash_64(
+          // NOLINTNEXTLINE
+          reinterpret_cast<const char*>(key.data()),
+          key.size());
+        // a zero delta would probe the same bit every time
+        return {h & 0xffffffffU, (h >> 32U) | 1U};
+    }
+
+    std::vector<uint64_t> _bits;
+    size_t _probes;
+};
+
+} // namespace storage
@@ -11,19 +11,26 @@
 
 #include "bytes/iobuf.h"
 #include "cluster/namespace.h"
+#include "config/configuration.h"
+#include "finjector/latency_probe.h"
 #include "prometheus/prometheus_sanitize.h"
 #include "raft/types.h"
 #include "reflection/adl.h"
 #include "storage/record_batch_builder.h"
 #include "storage/segment_set.h"
 #include "storage/types.h"
+#include "utils/vint.h"
 #include "vlog.h"
 
+#include <seastar/core/future-util.hh>
 #include <seastar/core/metrics.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/util/defer.hh>
 #include <seastar/util/log.hh>
 
+#include <algorithm>
+#include <iterator>
+
 static ss::logger lg("kvstore");
 
 namespace storage {
@@ -34,7 +41,12 @@ kvstore::kvstore(kvstore_config kv_conf)
   , _snap(
       std::filesystem::path(_ntpc.work_directory()),
       ss::default_priority_class())
-  , _timer([this] { _sem.signal(); }) {}
+  , _timer([this] { _sem.signal(); }) {
+    _interval_watcher = config::shard_local_cfg().kvstore_flush_interval.watch(
+      [this](std::chrono::milliseconds interval) {
+          _conf.commit_interval = interval;
+      });
+}
 
 ss::future<> kvstore::start() {
     vlog(lg.info, "Starting kvstore: dir {}", _ntpc.work_directory());
@@ -67,6 +79,32 @@ ss::future<> kvstore::start() {
               "key_count",
               [this] { return _db.size(); },
               ss::metrics::description("Number of keys in the database")),
+            ss::metrics::make_total_operations(
+              "flushes",
+              [this] { return _probe.flushes; },
+              ss::metrics::description("Number of flushes of operations")),
+            ss::metrics::make_total_operations(
+              "ops_flushed",
+              [this] { return _probe.ops_flushed; },
+              ss::metrics::description("Number of operations flushed")),
+            ss::metrics::make_histogram(
+              "ops_per_flush",
+              [this] {
+                  return _probe.ops_per_flush.seastar_histogram_logform();
+              },
+              ss::metrics::description(
+                "Number of operations of all key spaces written per flush")),
+            ss::metrics::make_histogram(
+              "flush_latency_us",
+              [this] {
+                  return _probe.flush_latency.seastar_histogram_logform();
+              },
+              ss::metrics::description(
+                "Time to write and flush a batch of operations to disk")),
+            ss::metrics::make_total_operations(
+              "snapshots_saved",
+              [this] { return _probe.snapshots_saved; },
+              ss::metrics::description("Number of snapshots saved")),
           });
     }
 
@@ -216,6 +254,14 @@ ss::future<> kvstore::flush_and_apply_ops() {
 
     // build the operation batch to be logged
     storage::record_batch_builder builder(kvstore_batch_type, _next_offset);
+    size_t reserve = 0;
+    for (auto& op : ops) {
+        // the fields of a record and the tag of its optional value are at
+        // most a vint each
+        reserve += op.key.size() + vint::max_length * 6
+                   + (op.value ? op.value->size_bytes() : 0);
+    }
+    builder.reserve(reserve);
     for (auto& op : ops) {
         std::optional<iobuf> value;
         if (op.value) {
@@ -233,9 +279,19 @@ ss::future<> kvstore::flush_and_apply_ops() {
      * 3. apply db ops
      * 4. notify waiters
      */
-    return _segment->append(std::move(batch))
+    _probe.flushed(ops.size());
+    auto m = _probe.flush_latency.auto_measure();
+    return finjector::shard_local_latency_probe()
+      .delay(finjector::latency_probe::point::kvstore_flush)
+      .then([this, batch = std::move(batch)]() mutable {
+          return _segment->append(std::move(batch));
+      })
       .then([this](append_result) { return _segment->flush(); })
-      .then([this, last_offset, ops = std::move(ops)]() mutable {
+      .then([this,
+             last_offset,
+             ops = std::move(ops),
+             m = std::move(m)]() mutable {
+          m.reset();
           for (auto& op : ops) {
               apply_op(std::move(op.key), std::move(op.value));
               op.done.set_value();
@@ -275,15 +331,13 @@ ss::future<> kvstore::roll() {
         // cleaned-up segment.
         auto seg = std::exchange(_segment, nullptr);
         return seg->close()
-          .then([this] { return save_snapshot(); })
-          .then([seg] {
-              vlog(
-                lg.debug,
-                "Removing old segment with base offset {}",
-                seg->offsets().base_offset);
-              return ss::remove_file(seg->reader().filename()).then([seg] {
-                  return ss::remove_file(seg->index().filename());
-              });
+          .then([this, seg] {
+              _closed_segments.push_back(seg);
+              if (_snapshot_in_progress) {
+                  // the closed segment is removed by a later snapshot
+                  return ss::now();
+              }
+              return start_background_snapshot();
           })
           .then([this] {
               return make_segment(
@@ -304,6 +358,60 @@ ss::future<> kvstore::roll() {
     return ss::now();
 }
 
+ss::future<> kvstore::start_background_snapshot() {
+    // no operations have been applied to the db
+    if (_next_offset == model::offset(0) || _gate.is_closed()) {
+        return ss::now();
+    }
+    _snapshot_in_progress = true;
+    const auto last_offset = _next_offset - model::offset(1);
+    // the flusher waits for the capture, so the db is not modified meanwhile
+    return make_snapshot_data().then([this, last_offset](iobuf data) {
+        if (_gate.is_closed()) {
+            _snapshot_in_progress = false;
+            return;
+        }
+        (void)ss::with_gate(
+          _gate, [this, last_offset, data = std::move(data)]() mutable {
+              return write_snapshot(last_offset, std::move(data))
+                .then([this, last_offset] {
+                    return remove_segments_before(
+                      last_offset + model::offset(1));
+                })
+                .handle_exception([this](std::exception_ptr e) {
+                    vlog(lg.warn, "Failed to save snapshot: {}", e);
+                    return _snap.remove_partial_snapshots();
+                })
+                .finally([this] { _snapshot_in_progress = false; });
+          });
+    });
+}
+
+ss::future<> kvstore::remove_segments_before(model::offset offset) {
+    auto end = std::find_if(
+      _closed_segments.begin(),
+      _closed_segments.end(),
+      [offset](const ss::lw_shared_ptr<segment>& seg) {
+          return seg->offsets().base_offset >= offset;
+      });
+    std::vector<ss::lw_shared_ptr<segment>> removed(
+      std::make_move_iterator(_closed_segments.begin()),
+      std::make_move_iterator(end));
+    _closed_segments.erase(_closed_segments.begin(), end);
+    return ss::do_with(
+      std::move(removed), [](std::vector<ss::lw_shared_ptr<segment>>& segs) {
+          return ss::do_for_each(segs, [](ss::lw_shared_ptr<segment>& seg) {
+              vlog(
+                lg.debug,
+                "Removing old segment with base offset {}",
+                seg->offsets().base_offset);
+              return ss::remove_file(seg->reader().filename()).then([seg] {
+                  return ss::remove_file(seg->index().filename());
+              });
+          });
+      });
+}
+
 ss::future<> kvstore::save_snapshot() {
     vassert(
       _next_offset >= model::offset(0),
@@ -315,35 +423,50 @@ ss::future<> kvstore::save_snapshot() {
         return ss::now();
     }
 
-    vlog(
-      lg.debug,
-      "Creating snapshot at offset {}",
-      _next_offset - model::offset(1));
+    return make_snapshot_data().then([this](iobuf data) {
+        return write_snapshot(_next_offset - model::offset(1), std::move(data));
+    });
+}
 
+ss::future<iobuf> kvstore::make_snapshot_data() {
     // package up the db into a batch
-    storage::record_batch_builder builder(kvstore_batch_type, model::offset(0));
-    for (auto& entry : _db) {
-        builder.add_raw_kv(
-          bytes_to_iobuf(entry.first),
-          entry.second.share(0, entry.second.size_bytes()));
-    }
-    auto batch = std::move(builder).build();
+    return ss::do_with(
+      storage::record_batch_builder(kvstore_batch_type, model::offset(0)),
+      [this](storage::record_batch_builder& builder) {
+          // yields between entries when the task quota is exhausted
+          return ss::do_for_each(
+                   _db,
+                   [&builder](auto& entry) {
+                       builder.add_raw_kv(
+                         bytes_to_iobuf(entry.first),
+                         entry.second.share(0, entry.second.size_bytes()));
+                   })
+            .then([&builder] {
+                auto batch = std::move(builder).build();
+
+                // serialize batch: size_prefix + batch
+                iobuf data;
+                auto ph = data.reserve(sizeof(int32_t));
+                reflection::serialize(data, std::move(batch));
+                auto size = ss::cpu_to_le(
+                  int32_t(data.size_bytes() - sizeof(int32_t)));
+                ph.write((const char*)&size, sizeof(size));
+                return data;
+            });
+      });
+}
 
-    // serialize batch: size_prefix + batch
-    iobuf data;
-    auto ph = data.reserve(sizeof(int32_t));
-    reflection::serialize(data, std::move(batch));
-    auto size = ss::cpu_to_le(int32_t(data.size_bytes() - sizeof(int32_t)));
-    ph.write((const char*)&size, sizeof(size));
+ss::future<> kvstore::write_snapshot(model::offset last_offset, iobuf data) {
+    vlog(lg.debug, "Creating snapshot at offset {}", last_offset);
 
     return _snap.start_snapshot().then(
-      [this, data = std::move(data)](snapshot_writer writer) mutable {
+      [this, last_offset, data = std::move(data)](
+        snapshot_writer writer) mutable {
           return ss::do_with(
             std::move(writer),
-            [this, data = std::move(data)](snapshot_writer& wr) mutable {
+            [this, last_offset, data = std::move(data)](
+              snapshot_writer& wr) mutable {
                 // the last log offset represented in the snapshot
-                auto last_offset = _next_offset - model::offset(1);
-
                 iobuf meta;
                 reflection::serialize(meta, last_offset);
 
@@ -356,7 +479,8 @@ ss::future<> kvstore::save_snapshot() {
                   .then([this, &wr]() {
                       vlog(lg.debug, "Finishing snapshot creation");
                       return _snap.finish_snapshot(wr);
-                  });
+                  })
+                  .then([this] { _probe.snapshot_saved(); });
             });
       });
 }
@@ -11,11 +11,13 @@
 
 #pragma once
 #include "bytes/iobuf.h"
+#include "config/property.h"
 #include "seastarx.h"
 #include "storage/parser.h"
 #include "storage/segment_set.h"
 #include "storage/snapshot.h"
 #include "storage/types.h"
+#include "utils/hdr_hist.h"
 #include "utils/mutex.h"
 
 #include <seastar/core/abort_source.hh>
@@ -26,6 +28,8 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <vector>
+
 namespace storage {
 
 /**
@@ -46,7 +50,18 @@ namespace storage {
  * Operations are staged in an ordered in-memory container. After a commit
  * interval has elapsed the operations are serialized into a single blob and
  * flushed to disk. Once the flush is complete the operations are applied to the
- * in-memory cache, and the associated promise is resolved.
+ * in-memory cache, and the associated promise is resolved. Operations of all
+ * the key spaces share the same flushes.
+ *
+ * Snapshots
+ * =========
+ *
+ * When the segment reaches its maximum size a new segment is started and the
+ * database is captured as of the end of the old one. The capture is written
+ * to a snapshot in the background while operations keep being flushed to the
+ * new segment, and the segments covered by the snapshot are removed once it
+ * is complete. A segment rolled while a snapshot is being written is kept
+ * until a later snapshot covers it.
  *
  * Concurrency
  * ===========
@@ -96,6 +111,7 @@ public:
         consensus = 1,
         storage = 2,
         controller = 3,
+        coproc = 4,
         /* your sub-system here */
     };
 
@@ -144,8 +160,13 @@ private:
     ss::timer<> _timer;
     ss::semaphore _sem{0};
     ss::lw_shared_ptr<segment> _segment;
+    // closed segments, in offset order, waiting for a snapshot to cover them
+    std::vector<ss::lw_shared_ptr<segment>> _closed_segments;
+    bool _snapshot_in_progress{false};
     model::offset _next_offset;
     absl::flat_hash_map<bytes, iobuf, bytes_type_hash, bytes_type_eq> _db;
+    // the commit interval follows the updates of kvstore_flush_interval
+    config::property<std::chrono::milliseconds>::watcher _interval_watcher;
 
     ss::future<> put(key_space ks, bytes key, std::optional<iobuf> value);
     void apply_op(bytes key, std::optional<iobuf> value);
@@ -153,6 +174,13 @@ private:
     ss::future<> roll();
     ss::future<> save_snapshot();
 
+    // serialized db, as of the last applied operation
+    ss::future<iobuf> make_snapshot_data();
+    ss::future<> write_snapshot(model::offset last_offset, iobuf data);
+    // captures the db and writes the snapshot in the background
+    ss::future<> start_background_snapshot();
+    ss::future<> remove_segments_before(model::offset);
+
     /*
      * Recovery
      *
@@ -196,12 +224,23 @@ private:
         void entry_removed() { ++entries_removed; }
         void add_cached_bytes(size_t count) { cached_bytes += count; }
         void dec_cached_bytes(size_t count) { cached_bytes -= count; }
+        void flushed(size_t ops) {
+            ++flushes;
+            ops_flushed += ops;
+            ops_per_flush.record(ops);
+        }
+        void snapshot_saved() { ++snapshots_saved; }
 
         uint64_t segments_rolled{0};
         uint64_t entries_fetched{0};
         uint64_t entries_written{0};
         uint64_t entries_removed{0};
         size_t cached_bytes{0};
+        uint64_t flushes{0};
+        uint64_t ops_flushed{0};
+        uint64_t snapshots_saved{0};
+        hdr_hist flush_latency;
+        hdr_hist ops_per_flush;
 
         ss::metrics::metric_groups metrics;
     };
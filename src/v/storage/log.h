@@ -10,6 +10,7 @@
  */
 
 #pragma once
+#include "bytes/bytes.h"
 #include "model/fundamental.h"
 #include "model/record_batch_reader.h"
 #include "model/timeout_clock.h"
@@ -17,6 +18,7 @@
 #include "seastarx.h"
 #include "storage/log_appender.h"
 #include "storage/segment_reader.h"
+#include "storage/segment_transfer.h"
 #include "storage/types.h"
 
 #include <seastar/core/abort_source.hh>
@@ -60,6 +62,8 @@ public:
         virtual ss::future<> remove() = 0;
 
         virtual ss::future<> flush() = 0;
+        // flushes the segments even when the log is flushed by a shared_wal
+        virtual ss::future<> flush_segments() { return flush(); }
 
         virtual ss::future<std::optional<timequery_result>>
           timequery(timequery_config) = 0;
@@ -68,12 +72,33 @@ public:
 
         virtual size_t segment_count() const = 0;
         virtual storage::offset_stats offsets() const = 0;
+        virtual storage::log_stats stats() const = 0;
         virtual std::ostream& print(std::ostream& o) const = 0;
         virtual std::optional<model::term_id> get_term(model::offset) const = 0;
 
+        virtual storage::compaction_backlog get_compaction_backlog() const = 0;
+
+        virtual std::optional<model::offset>
+          closed_segment_end(model::offset) const = 0;
+        virtual ss::future<std::optional<segment_files>>
+          open_closed_segment(model::offset) = 0;
+        virtual ss::future<> install_segment(model::offset, model::term_id) = 0;
+        virtual ss::future<std::optional<model::offset>>
+          find_latest_offset(bytes, ss::io_priority_class) = 0;
+
         virtual ss::future<model::offset>
         monitor_eviction(ss::abort_source&) = 0;
         virtual void set_collectible_offset(model::offset) = 0;
+        virtual void set_archived_offset(model::offset) = 0;
+        virtual void set_batch_cache_policy(batch_cache_policy) = 0;
+        virtual ss::future<> warm_batch_cache(size_t, ss::io_priority_class)
+          = 0;
+
+        virtual std::optional<model::timestamp>
+        oldest_reclaimable_segment() const = 0;
+        virtual ss::future<size_t> reclaim_oldest_segment(ss::abort_source&)
+          = 0;
+        virtual ss::future<scrub_result> scrub(scrub_config) = 0;
 
     private:
         ntp_config _config;
@@ -85,6 +110,7 @@ public:
     ss::future<> close() { return _impl->close(); }
     ss::future<> remove() { return _impl->remove(); }
     ss::future<> flush() { return _impl->flush(); }
+    ss::future<> flush_segments() { return _impl->flush_segments(); }
 
     /**
      * \brief Truncate the suffix of log at a base offset
@@ -128,6 +154,8 @@ public:
 
     storage::offset_stats offsets() const { return _impl->offsets(); }
 
+    storage::log_stats stats() const { return _impl->stats(); }
+
     std::optional<model::term_id> get_term(model::offset o) const {
         return _impl->get_term(o);
     }
@@ -138,6 +166,51 @@ public:
 
     ss::future<> compact(compaction_config cfg) { return _impl->compact(cfg); }
 
+    /// what the next compactions of the log have to process
+    storage::compaction_backlog get_compaction_backlog() const {
+        return _impl->get_compaction_backlog();
+    }
+
+    /// last offset of the closed segment containing the offset, if any
+    std::optional<model::offset> closed_segment_end(model::offset o) const {
+        return _impl->closed_segment_end(o);
+    }
+
+    /**
+     * \brief Opens the files of the closed segment starting at an offset
+     *
+     * Used to copy whole segments to a replica that is far behind. Returns
+     * nothing if there is no closed, non-empty segment with that base offset.
+     */
+    ss::future<std::optional<segment_files>>
+    open_closed_segment(model::offset base_offset) {
+        return _impl->open_closed_segment(base_offset);
+    }
+
+    /**
+     * \brief Appends a segment whose files were copied from another replica
+     *
+     * The files must have been received with a segment_receiver for the same
+     * base offset and term. The segment must start right after the end of the
+     * log.
+     */
+    ss::future<> install_segment(model::offset base_offset, model::term_id t) {
+        return _impl->install_segment(base_offset, t);
+    }
+
+    /**
+     * \brief Finds the offset of the latest record with a key
+     *
+     * Only for compacted logs. The closed segments are probed newest first,
+     * with the filter of their keys and then their compacted index, so that a
+     * lookup reads the data of the active segment only. Returns nothing if no
+     * record past the start of the log has the key.
+     */
+    ss::future<std::optional<model::offset>>
+    find_latest_offset(bytes key, ss::io_priority_class pc) {
+        return _impl->find_latest_offset(std::move(key), pc);
+    }
+
     /**
      * \brief Returns a future that resolves when log eviction is scheduled
      *
@@ -156,6 +229,62 @@ public:
         return _impl->set_collectible_offset(o);
     };
 
+    /**
+     * Last offset of the segments uploaded to object storage. Segments of an
+     * archived log (see log_manager::is_archived) past it are not evicted by
+     * the log retention policy.
+     */
+    void set_archived_offset(model::offset o) {
+        return _impl->set_archived_offset(o);
+    }
+
+    /**
+     * How the appends to the log populate the batch cache, set by the raft
+     * group of the log as its role changes. Every appended batch is cached
+     * unless set otherwise.
+     */
+    void set_batch_cache_policy(batch_cache_policy p) {
+        return _impl->set_batch_cache_policy(p);
+    }
+
+    /**
+     * \brief Reads the last `bytes` of the log into the batch cache
+     *
+     * So that the consumers of a new leader, tailing the log, are served from
+     * the cache rather than from disk after a failover.
+     */
+    ss::future<> warm_batch_cache(size_t bytes, ss::io_priority_class pc) {
+        return _impl->warm_batch_cache(bytes, pc);
+    }
+
+    /**
+     * Max timestamp of the oldest segment that the retention policy of the
+     * log allows to remove ahead of time when the disk runs out of space:
+     * a closed segment of a deletable log, below the collectible and the
+     * archived offsets. Nothing if there is no such segment.
+     */
+    std::optional<model::timestamp> oldest_reclaimable_segment() const {
+        return _impl->oldest_reclaimable_segment();
+    }
+
+    /// \brief removes the segment of oldest_reclaimable_segment(), if any,
+    /// and returns its size
+    ss::future<size_t> reclaim_oldest_segment(ss::abort_source& as) {
+        return _impl->reclaim_oldest_segment(as);
+    }
+
+    /**
+     * \brief Reads the closed segments back and verifies the checksums of
+     * their batches
+     *
+     * Meant to find bit rot before a consumer or a recovery reads it. The
+     * result holds the first offset failing verification, if any; the
+     * segments past a corrupt one are still verified.
+     */
+    ss::future<scrub_result> scrub(scrub_config cfg) {
+        return _impl->scrub(cfg);
+    }
+
     std::ostream& print(std::ostream& o) const { return _impl->print(o); }
 
     impl* get_impl() const { return _impl.get(); }
@@ -170,10 +299,28 @@ inline std::ostream& operator<<(std::ostream& o, const storage::log& lg) {
     return lg.print(o);
 }
 
+/**
+ * The memory of the in-memory logs of a shard, see
+ * ntp_config::is_in_memory(). A log appended to past the budget evicts its
+ * oldest batches, as far as raft lets it collect them.
+ */
+struct memory_log_budget {
+    explicit memory_log_budget(size_t max) noexcept
+      : max_bytes(max) {}
+
+    bool exceeded() const { return used_bytes > max_bytes; }
+
+    size_t max_bytes;
+    size_t used_bytes{0};
+    uint64_t evicted_bytes{0};
+};
+
 class log_manager;
 class segment_set;
 class kvstore;
-log make_memory_backed_log(ntp_config);
+/// the budget is optional, the logs of a memory log_manager are unbounded
+log make_memory_backed_log(
+  ntp_config, ss::lw_shared_ptr<memory_log_budget> = nullptr);
 log make_disk_backed_log(ntp_config, log_manager&, segment_set, kvstore&);
 
 } // namespace storage
@@ -25,6 +25,9 @@ struct log_housekeeping_meta {
     log handle;
     bitflags flags{bitflags::none};
     ss::lowres_clock::time_point last_compaction;
+    /// when the log is due for housekeeping, see log_manager::housekeeping()
+    ss::lowres_clock::time_point next_housekeeping
+      = ss::lowres_clock::time_point::max();
 };
 
 inline log_housekeeping_meta::bitflags operator|(
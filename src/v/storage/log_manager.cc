@@ -13,8 +13,12 @@
 #include "likely.h"
 #include "model/fundamental.h"
 #include "model/timestamp.h"
+#include "prometheus/prometheus_sanitize.h"
 #include "storage/batch_cache.h"
+#include "storage/cached_file.h"
+#include "storage/coalescing_file.h"
 #include "storage/compacted_index_writer.h"
+#include "storage/disk_log_impl.h"
 #include "storage/fs_utils.h"
 #include "storage/log.h"
 #include "storage/logger.h"
@@ -33,17 +37,23 @@
 #include <seastar/core/future-util.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/gate.hh>
+#include <seastar/core/metrics.hh>
 #include <seastar/core/print.hh>
 #include <seastar/core/seastar.hh>
 #include <seastar/core/shared_ptr.hh>
+#include <seastar/core/smp.hh>
 #include <seastar/core/thread.hh>
 
 #include <fmt/format.h>
+#include <sys/statvfs.h>
 
+#include <algorithm>
 #include <chrono>
 #include <exception>
 #include <filesystem>
 #include <optional>
+#include <string_view>
+#include <vector>
 
 namespace storage {
 using logs_type = absl::flat_hash_map<model::ntp, log_housekeeping_meta>;
@@ -52,88 +62,590 @@ log_manager::log_manager(log_config config, kvstore& kvstore) noexcept
   : _config(std::move(config))
   , _kvstore(kvstore)
   , _jitter(_config.compaction_interval)
-  , _batch_cache(config.reclaim_opts) {
+  , _batch_cache(config.reclaim_opts)
+  , _recovery_sem(_config.max_concurrent_recoveries)
+  , _segment_deletions(_config.max_concurrent_segment_deletions)
+  , _read_buffers(_config.read_buffers_memory)
+  , _memory_log_budget(
+      ss::make_lw_shared<memory_log_budget>(_config.memory_log_bytes))
+  , _deleter(_config.deletion_bytes_per_sec) {
     _compaction_timer.set_callback([this] { trigger_housekeeping(); });
-    _compaction_timer.rearm(_jitter());
+    if (_config.stype == log_config::storage_type::disk) {
+        _disk_check_timer.set_callback([this] { trigger_disk_check(); });
+        _disk_check_timer.rearm(
+          ss::lowres_clock::now() + _config.disk_check_interval);
+    }
+    if (
+      _config.stype == log_config::storage_type::disk
+      && _config.scrub_bytes_per_sec) {
+        _scrub_timer.set_callback([this] { trigger_scrub(); });
+        _scrub_timer.rearm(ss::lowres_clock::now() + _config.scrub_interval);
+    }
+    auto& cfg = config::shard_local_cfg();
+    _compaction_interval_watcher = cfg.log_compaction_interval_ms.watch(
+      [this](std::chrono::milliseconds interval) {
+          set_compaction_interval(interval);
+      });
+    _reclaim_min_size_watcher = cfg.reclaim_min_size.watch(
+      [this](size_t min_size) { _batch_cache.set_reclaim_min_size(min_size); });
+    if (
+      _config.stype == log_config::storage_type::disk
+      && _config.shared_wal_segment_size) {
+        _wal = std::make_unique<shared_wal>(
+          shared_wal_config{
+            .base_dir = _config.base_dir,
+            .max_segment_size = *_config.shared_wal_segment_size,
+            .recovery_timeout = _config.shared_wal_recovery_timeout,
+            .sanitize_fileops = _config.sanitize_fileops},
+          [this](const model::ntp& ntp) {
+              if (_open_gate.is_closed()) {
+                  // the logs are flushed as they are closed
+                  return ss::make_exception_future<>(
+                    ss::gate_closed_exception());
+              }
+              return ss::with_gate(_open_gate, [this, ntp] {
+                  if (auto it = _logs.find(ntp); it != _logs.end()) {
+                      return it->second.handle.flush_segments();
+                  }
+                  // removed or shut down, closed with its segments flushed
+                  return ss::now();
+              });
+          });
+    }
+}
+
+ss::future<> log_manager::start() {
+    auto f = ss::now();
+    if (
+      _config.stype == log_config::storage_type::disk
+      && ss::this_shard_id() == 0) {
+        // the logs removed before a restart are left in the trash
+        f = _deleter.recover(data_dirs());
+    }
+    return f.then([this] { return _wal ? _wal->start() : ss::now(); });
 }
 void log_manager::trigger_housekeeping() {
     (void)ss::with_gate(_open_gate, [this] {
-        auto next_housekeeping = _jitter();
-        return housekeeping().finally([this, next_housekeeping] {
-            // all of these *MUST* be in the finally
-            if (_open_gate.is_closed()) {
-                return;
-            }
-
-            _compaction_timer.rearm(next_housekeeping);
-        });
+        _housekeeping_running = true;
+        return ss::with_scheduling_group(
+                 _config.compaction_sg, [this] { return housekeeping(); })
+          .finally([this] {
+              // all of these *MUST* be in the finally
+              _housekeeping_running = false;
+              _last_housekeeping = ss::lowres_clock::now();
+              if (_open_gate.is_closed()) {
+                  return;
+              }
+              arm_housekeeping();
+          });
     }).handle_exception([](std::exception_ptr e) {
         vlog(stlog.info, "Error processing housekeeping(): {}", e);
     });
 }
 
+void log_manager::arm_housekeeping() {
+    if (_housekeeping_running || _open_gate.is_closed()) {
+        // rearmed once the round is over
+        return;
+    }
+    if (_housekeeping_queue.empty()) {
+        _compaction_timer.cancel();
+        return;
+    }
+    const auto deadline = std::max(
+      _housekeeping_queue.top().deadline,
+      _last_housekeeping + _config.housekeeping_min_interval);
+    if (
+      !_compaction_timer.armed()
+      || _compaction_timer.get_timeout() != deadline) {
+        _compaction_timer.rearm(deadline);
+    }
+}
+
+void log_manager::schedule_housekeeping(
+  log_housekeeping_meta& meta,
+  const model::ntp& ntp,
+  ss::lowres_clock::time_point deadline) {
+    meta.next_housekeeping = deadline;
+    _housekeeping_queue.push(housekeeping_deadline{deadline, ntp});
+}
+
+void log_manager::set_compaction_interval(
+  std::chrono::milliseconds interval) {
+    _config.compaction_interval = interval;
+    _jitter = simple_time_jitter<ss::lowres_clock>(interval);
+    const auto latest = ss::lowres_clock::now() + _jitter.base_duration()
+                        + _jitter.jitter_duration();
+    for (auto& [ntp, meta] : _logs) {
+        if (meta.next_housekeeping > latest) {
+            schedule_housekeeping(meta, ntp, _jitter());
+        }
+    }
+    arm_housekeeping();
+}
+
+void log_manager::request_housekeeping(const model::ntp& ntp) {
+    auto it = _logs.find(ntp);
+    if (it == _logs.end()) {
+        return;
+    }
+    const auto now = ss::lowres_clock::now();
+    if (it->second.next_housekeeping <= now) {
+        return;
+    }
+    schedule_housekeeping(it->second, ntp, now);
+    arm_housekeeping();
+}
+
+ss::lowres_clock::time_point
+log_manager::next_housekeeping(const model::ntp& ntp, const log& l) {
+    const auto now = ss::lowres_clock::now();
+    if (l.get_compaction_backlog().next_bytes > 0) {
+        return now;
+    }
+    // at most an interval apart, for the changes that do not schedule the
+    // log: size based retention and the collectible offsets moving forward
+    auto next = _jitter();
+    if (auto ts = l.oldest_reclaimable_segment(); ts) {
+        auto retention = _config.delete_retention;
+        if (is_archived(ntp)) {
+            retention = std::min(retention, _config.local_delete_retention);
+        }
+        const auto expires_in = std::chrono::milliseconds(ts->value())
+                                + retention
+                                - std::chrono::milliseconds(
+                                  model::timestamp::now().value());
+        if (expires_in <= std::chrono::milliseconds(0)) {
+            return now;
+        }
+        next = std::min(next, now + expires_in);
+    }
+    return next;
+}
+
+std::vector<model::ntp>
+log_manager::due_for_housekeeping(ss::lowres_clock::time_point now) {
+    std::vector<model::ntp> due;
+    while (!_housekeeping_queue.empty()
+           && _housekeeping_queue.top().deadline <= now) {
+        auto top = _housekeeping_queue.top();
+        _housekeeping_queue.pop();
+        auto it = _logs.find(top.ntp);
+        if (
+          it == _logs.end()
+          || it->second.next_housekeeping != top.deadline) {
+            // removed or scheduled again since
+            continue;
+        }
+        // scheduled again once done with, see housekeeping()
+        it->second.next_housekeeping = ss::lowres_clock::time_point::max();
+        due.push_back(std::move(top.ntp));
+    }
+    return due;
+}
+
+void log_manager::trigger_scrub() {
+    (void)ss::with_gate(_open_gate, [this] {
+        return ss::with_scheduling_group(
+                 _config.compaction_sg, [this] { return scrub(); })
+          .handle_exception([](std::exception_ptr e) {
+              vlog(stlog.warn, "Error scrubbing logs: {}", e);
+          })
+          .finally([this] {
+              if (_open_gate.is_closed()) {
+                  return;
+              }
+              _scrub_timer.rearm(
+                ss::lowres_clock::now() + _config.scrub_interval);
+          });
+    }).handle_exception_type([](const ss::gate_closed_exception&) {});
+}
+
+ss::future<> log_manager::scrub() {
+    std::vector<model::ntp> ntps;
+    ntps.reserve(_logs.size());
+    for (const auto& [ntp, _] : _logs) {
+        ntps.push_back(ntp);
+    }
+    vlog(stlog.debug, "Scrubbing {} logs", ntps.size());
+    return ss::do_with(
+      std::move(ntps), scrub_result{}, [this](auto& ntps, auto& total) {
+          return ss::do_for_each(
+                   ntps,
+                   [this, &total](const model::ntp& ntp) {
+                       auto it = _logs.find(ntp);
+                       if (
+                         it == _logs.end()
+                         || _abort_source.abort_requested()) {
+                           // removed while scrubbing other logs
+                           return ss::now();
+                       }
+                       auto l = it->second.handle;
+                       return l
+                         .scrub(scrub_config(
+                           _config.scrub_priority,
+                           _config.scrub_bytes_per_sec,
+                           _abort_source))
+                         .then([&total](scrub_result r) {
+                             total.segments += r.segments;
+                             total.bytes += r.bytes;
+                         })
+                         .finally([l] {});
+                   })
+            .then([&total] {
+                vlog(stlog.info, "Scrubbed the closed segments: {}", total);
+            });
+      });
+}
+
+void log_manager::trigger_disk_check() {
+    (void)ss::with_gate(_open_gate, [this] {
+        return ss::with_scheduling_group(
+                 _config.compaction_sg, [this] { return check_disk_space(); })
+          .handle_exception([](std::exception_ptr e) {
+              vlog(stlog.warn, "Error checking disk space: {}", e);
+          })
+          .finally([this] {
+              if (_open_gate.is_closed()) {
+                  return;
+              }
+              _disk_check_timer.rearm(
+                ss::lowres_clock::now() + _config.disk_check_interval);
+          });
+    }).handle_exception_type([](const ss::gate_closed_exception&) {});
+}
+
+std::vector<ss::sstring> log_manager::data_dirs() const {
+    std::vector<ss::sstring> dirs{_config.base_dir};
+    dirs.insert(
+      dirs.end(), _config.extra_dirs.begin(), _config.extra_dirs.end());
+    return dirs;
+}
+
+ss::future<> log_manager::check_disk_space() {
+    return ss::do_with(data_dirs(), [this](std::vector<ss::sstring>& dirs) {
+        return ss::do_for_each(dirs, [this](const ss::sstring& dir) {
+            return ss::engine().statvfs(dir).then(
+              [this, &dir](struct statvfs st) {
+                  auto& space = _disk_space[dir];
+                  space.free = uint64_t(st.f_bavail) * st.f_frsize;
+                  space.total = uint64_t(st.f_blocks) * st.f_frsize;
+                  if (
+                    !_config.min_free_bytes
+                    || space.free >= *_config.min_free_bytes) {
+                      return ss::now();
+                  }
+                  // the cores share the disk, each reclaims its part of the
+                  // deficit from its own logs
+                  const auto deficit = *_config.min_free_bytes - space.free;
+                  return reclaim_disk_space(
+                    dir, (deficit + ss::smp::count - 1) / ss::smp::count);
+              });
+        });
+    });
+}
+
+std::optional<model::ntp>
+log_manager::next_reclaimable(const ss::sstring& dir) const {
+    std::optional<std::pair<bool, model::timestamp>> best;
+    std::optional<model::ntp> ret;
+    for (const auto& [ntp, meta] : _logs) {
+        if (meta.handle.config().base_directory() != dir) {
+            continue;
+        }
+        auto ts = meta.handle.oldest_reclaimable_segment();
+        if (!ts) {
+            continue;
+        }
+        // archived logs first
+        std::pair<bool, model::timestamp> key{!is_archived(ntp), *ts};
+        if (!best || key < *best) {
+            best = key;
+            ret = ntp;
+        }
+    }
+    return ret;
+}
+
+ss::future<> log_manager::reclaim_disk_space(ss::sstring dir, size_t bytes) {
+    return ss::do_with(
+      std::move(dir),
+      size_t(0),
+      false,
+      [this, bytes](ss::sstring& dir, size_t& reclaimed, bool& exhausted) {
+          return ss::do_until(
+                   [this, bytes, &reclaimed, &exhausted] {
+                       return exhausted || reclaimed >= bytes
+                              || _abort_source.abort_requested();
+                   },
+                   [this, &dir, &reclaimed, &exhausted] {
+                       auto ntp = next_reclaimable(dir);
+                       if (!ntp) {
+                           exhausted = true;
+                           return ss::now();
+                       }
+                       auto l = _logs.find(*ntp)->second.handle;
+                       return l.reclaim_oldest_segment(_abort_source)
+                         .then([this, &reclaimed, &exhausted](size_t n) {
+                             if (n == 0) {
+                                 // removed concurrently, next check retries
+                                 exhausted = true;
+                                 return;
+                             }
+                             reclaimed += n;
+                             _reclaimed_bytes += n;
+                             ++_reclaimed_segments;
+                         })
+                         .finally([l] {});
+                   })
+            .then([bytes, &dir, &reclaimed] {
+                vlog(
+                  stlog.warn,
+                  "Low disk space in {}, removed {} of {} bytes of the "
+                  "oldest segments ahead of retention",
+                  dir,
+                  reclaimed,
+                  bytes);
+            });
+      });
+}
+
+void log_manager::setup_memory_log_metrics() {
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:memory_log"),
+      {
+        sm::make_gauge(
+          "used_bytes",
+          [this] { return _memory_log_budget->used_bytes; },
+          sm::description("Memory held by the logs of the in-memory topics")),
+        sm::make_gauge(
+          "max_bytes",
+          [this] { return _memory_log_budget->max_bytes; },
+          sm::description("Memory budget of the logs of the in-memory topics")),
+        sm::make_derive(
+          "evicted_bytes",
+          [this] { return _memory_log_budget->evicted_bytes; },
+          sm::description("Bytes of the in-memory topics evicted ahead of "
+                          "their retention to stay within the budget")),
+      });
+}
+
+void log_manager::setup_disk_metrics() {
+    namespace sm = ss::metrics;
+    std::vector<sm::metric_definition> defs{
+      sm::make_derive(
+        "reclaimed_bytes",
+        [this] { return _reclaimed_bytes; },
+        sm::description("Bytes of segments removed ahead of retention to "
+                        "keep the minimum free disk space")),
+      sm::make_derive(
+        "reclaimed_segments",
+        [this] { return _reclaimed_segments; },
+        sm::description("Segments removed ahead of retention to keep the "
+                        "minimum free disk space")),
+    };
+    // the space of the disk is the same for all the cores
+    if (ss::this_shard_id() == 0) {
+        for (auto& dir : data_dirs()) {
+            std::vector<sm::label_instance> labels{
+              sm::label("directory")(dir)};
+            defs.push_back(sm::make_gauge(
+              "free_bytes",
+              [this, dir] { return _disk_space[dir].free; },
+              sm::description("Free disk space of the data directory"),
+              labels));
+            defs.push_back(sm::make_gauge(
+              "total_bytes",
+              [this, dir] { return _disk_space[dir].total; },
+              sm::description("Disk space of the data directory"),
+              labels));
+        }
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:disk"), std::move(defs));
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:deletion"),
+      {
+        sm::make_gauge(
+          "pending_directories",
+          [this] { return _deleter.pending(); },
+          sm::description("Directories of removed logs yet to be deleted")),
+        sm::make_derive(
+          "deleted_bytes",
+          [this] { return _deleter.removed_bytes(); },
+          sm::description("Bytes of the files of removed logs deleted in "
+                          "the background")),
+      });
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:segment_files"),
+      {
+        sm::make_derive(
+          "hits",
+          [] { return cached_file::shard_stats().hits; },
+          sm::description("Uses of segment files found open")),
+        sm::make_derive(
+          "misses",
+          [] { return cached_file::shard_stats().misses; },
+          sm::description("Uses of segment files that opened them")),
+        sm::make_derive(
+          "evictions",
+          [] { return cached_file::shard_stats().evictions; },
+          sm::description("Segment files closed to stay within "
+                          "max_open_segment_files")),
+        sm::make_gauge(
+          "open",
+          [] { return cached_file::shard_stats().open; },
+          sm::description("Open data and index files of the segments")),
+      });
+}
+
 ss::future<> log_manager::stop() {
     _compaction_timer.cancel();
+    _disk_check_timer.cancel();
+    _scrub_timer.cancel();
     _abort_source.request_abort();
-    return _open_gate.close().then([this] {
-        return ss::parallel_for_each(_logs, [](logs_type::value_type& entry) {
-            return entry.second.handle.close();
-        });
-    });
+    return _open_gate.close()
+      .then([this] { return _deleter.stop(); })
+      .then([this] {
+          return ss::parallel_for_each(
+            _logs, [](logs_type::value_type& entry) {
+                return entry.second.handle.close();
+            });
+      })
+      .then([this] {
+          // the logs are closed, their segments flushed
+          return _wal ? _wal->stop() : ss::now();
+      })
+      .then([this] { return _batch_cache.stop(); });
 }
 
-inline logs_type::iterator find_next_non_compacted_log(logs_type& logs) {
-    using bflags = log_housekeeping_meta::bitflags;
-    return std::find_if(
-      logs.begin(), logs.end(), [](const logs_type::value_type& l) {
-          return bflags::none == (l.second.flags & bflags::compacted);
+std::vector<model::ntp>
+log_manager::compaction_order(std::vector<model::ntp> ntps) const {
+    std::vector<std::pair<double, model::ntp>> ratios;
+    ratios.reserve(ntps.size());
+    for (auto& ntp : ntps) {
+        auto it = _logs.find(ntp);
+        ratios.emplace_back(
+          it->second.handle.get_compaction_backlog().dirty_ratio(),
+          std::move(ntp));
+    }
+    std::stable_sort(
+      ratios.begin(), ratios.end(), [](const auto& a, const auto& b) {
+          return a.first > b.first;
       });
+    std::vector<model::ntp> ret;
+    ret.reserve(ratios.size());
+    for (auto& r : ratios) {
+        ret.push_back(std::move(r.second));
+    }
+    return ret;
 }
+
 ss::future<> log_manager::housekeeping() {
     auto collection_threshold = model::timestamp(
       model::timestamp::now().value() - _config.delete_retention.count());
+    auto local_threshold = model::timestamp(std::max(
+      collection_threshold.value(),
+      model::timestamp::now().value()
+        - _config.local_delete_retention.count()));
     /**
-     * Note that this loop does a double find - which is not fast. This solution
-     * is the tradeoff to *not* lock the segment during log_manager::remove(ntp)
-     * and to *not* use an ordered container.
+     * Only the logs due are visited, see next_housekeeping(), in descending
+     * order of dirty ratio, so that the logs that gain the most from
+     * compaction go first.
      *
-     * The issue with keeping an iterator and effectively doing a iterator++
-     * is that during a concurrent log_manager::remove() we invalidate all the
-     * iterators for the absl::flat_hash_map; - an alternative here would be to
-     * use a lock
+     * The order is computed once per round, and each log is looked up again
+     * before it is compacted. This is the tradeoff to *not* lock the segment
+     * during log_manager::remove(ntp) and to *not* use an ordered container:
+     * a concurrent log_manager::remove() invalidates all the iterators of the
+     * absl::flat_hash_map, and finds are frequent on this datastructure and in
+     * the hotpath / (request-response).
      *
-     * Note that we also do not use an ordered container like an absl::tree-set
-     * because finds are frequent on this datastructure and we want to serve
-     * them as fast as we can since the majority of the time they will be in the
-     * hotpath / (request-response)
+     * When a compaction rate is configured, the bytes compacted in a round are
+     * bounded by the rate times the time since the last round. Logs whose
+     * next compaction does not fit in what is left of the budget wait for the
+     * next round, except for the first one so that every round makes
+     * progress. Logs with nothing to compact are always visited, since
+     * compact() also applies retention.
      */
-    using bflags = log_housekeeping_meta::bitflags;
-    return ss::do_until(
-             [this] {
-                 auto it = find_next_non_compacted_log(_logs);
-                 return it == _logs.end();
-             },
-             [this, collection_threshold] {
-                 auto it = find_next_non_compacted_log(_logs);
-                 if (it == _logs.end()) {
-                     // must check again because between the stop condition
-                     // and this continuation we might have removed the log
-                     return ss::now();
-                 }
-                 it->second.flags |= bflags::compacted;
-                 it->second.last_compaction = ss::lowres_clock::now();
-                 return it->second.handle.compact(compaction_config(
-                   collection_threshold,
-                   // TODO: [ch433] - this configuration needs to be updated
-                   _config.retention_bytes,
-                   // TODO: change default priority in application.cc
-                   ss::default_priority_class(),
-                   _abort_source));
-             })
-      .finally([this] {
-          for (auto& h : _logs) {
-              h.second.flags &= ~bflags::compacted;
-          }
+    const auto now = ss::lowres_clock::now();
+    std::optional<size_t> budget;
+    if (_config.compaction_bytes_per_sec) {
+        const auto elapsed = std::chrono::duration_cast<
+          std::chrono::milliseconds>(now - _last_housekeeping);
+        budget = *_config.compaction_bytes_per_sec
+                 * static_cast<size_t>(elapsed.count()) / 1000;
+    }
+    return ss::do_with(
+      compaction_order(due_for_housekeeping(now)),
+      budget,
+      false,
+      [this, collection_threshold, local_threshold](
+        std::vector<model::ntp>& ntps,
+        std::optional<size_t>& budget,
+        bool& compacted_any) {
+          return ss::do_for_each(
+            ntps,
+            [this,
+             collection_threshold,
+             local_threshold,
+             &budget,
+             &compacted_any](const model::ntp& ntp) {
+                auto it = _logs.find(ntp);
+                if (it == _logs.end() || _abort_source.abort_requested()) {
+                    // removed while compacting other logs
+                    return ss::now();
+                }
+                const auto next
+                  = it->second.handle.get_compaction_backlog().next_bytes;
+                if (budget && next > 0) {
+                    if (next > *budget && compacted_any) {
+                        vlog(
+                          stlog.trace,
+                          "compaction budget exhausted, skipping {}",
+                          ntp);
+                        schedule_housekeeping(
+                          it->second, ntp, ss::lowres_clock::now());
+                        return ss::now();
+                    }
+                    *budget -= std::min(next, *budget);
+                    compacted_any = true;
+                }
+                it->second.last_compaction = ss::lowres_clock::now();
+                // archived logs are bounded by the local retention on disk
+                const bool archived = is_archived(ntp);
+                auto cfg = compaction_config(
+                  archived ? local_threshold : collection_threshold,
+                  // TODO: [ch433] - this configuration needs to be updated
+                  archived ? local_retention_bytes() : _config.retention_bytes,
+                  _config.compaction_priority,
+                  _abort_source);
+                cfg.hashed_key_index_bytes = _config.hashed_key_index_bytes;
+                auto l = it->second.handle;
+                return l.compact(cfg).then_wrapped(
+                  [this, l, ntp](ss::future<> f) {
+                      const bool failed = f.failed();
+                      if (failed) {
+                          vlog(
+                            stlog.info,
+                            "Error in housekeeping of {}: {}",
+                            ntp,
+                            f.get_exception());
+                      }
+                      auto it = _logs.find(ntp);
+                      if (
+                        it == _logs.end()
+                        || it->second.handle.get_impl() != l.get_impl()) {
+                          return;
+                      }
+                      // a failed log waits for the interval, not to retry
+                      // it on every round
+                      schedule_housekeeping(
+                        it->second,
+                        ntp,
+                        failed ? _jitter() : next_housekeeping(ntp, l));
+                  });
+            });
       });
 }
 ss::future<ss::lw_shared_ptr<segment>> log_manager::make_log_segment(
@@ -142,9 +654,13 @@ ss::future<ss::lw_shared_ptr<segment>> log_manager::make_log_segment(
   model::term_id term,
   ss::io_priority_class pc,
   record_version_type version,
-  size_t buf_size) {
+  std::optional<size_t> buffer_size,
+  size_t fallocation_step) {
+    const auto buf_size = buffer_size.value_or(
+      _config.segment_readahead_size);
     return ss::with_gate(
-      _open_gate, [this, &ntp, base_offset, term, pc, version, buf_size] {
+      _open_gate,
+      [this, &ntp, base_offset, term, pc, version, buf_size, fallocation_step] {
           return make_segment(
             ntp,
             base_offset,
@@ -153,7 +669,22 @@ ss::future<ss::lw_shared_ptr<segment>> log_manager::make_log_segment(
             version,
             buf_size,
             _config.sanitize_fileops,
-            create_cache());
+            create_cache(),
+            data_file_wrapper(),
+            fallocation_step);
+      });
+}
+
+ss::future<ss::lw_shared_ptr<segment>> log_manager::open_log_segment(
+  const std::filesystem::path& path, segment_file_wrapper wrap_data) {
+    return ss::with_gate(
+      _open_gate, [this, path, wrap_data = std::move(wrap_data)]() mutable {
+          return open_segment(
+            path,
+            _config.sanitize_fileops,
+            create_cache(),
+            _config.segment_readahead_size,
+            std::move(wrap_data));
       });
 }
 
@@ -165,12 +696,86 @@ std::optional<batch_cache_index> log_manager::create_cache() {
     return batch_cache_index(_batch_cache);
 }
 
+segment_file_wrapper log_manager::data_file_wrapper() const {
+    if (!_config.coalesced_read_max_bytes) {
+        return {};
+    }
+    return [max = *_config.coalesced_read_max_bytes](ss::file f) {
+        return ss::file(ss::make_shared<coalescing_file>(std::move(f), max));
+    };
+}
+
 ss::future<log> log_manager::manage(ntp_config cfg) {
     return ss::with_gate(_open_gate, [this, cfg = std::move(cfg)]() mutable {
-        return do_manage(std::move(cfg));
+        if (
+          _config.extra_dirs.empty()
+          || cfg.base_directory() != _config.base_dir) {
+            return do_manage(std::move(cfg));
+        }
+        return place(std::move(cfg)).then([this](ntp_config cfg) {
+            auto dir = cfg.base_directory();
+            return do_manage(std::move(cfg))
+              .handle_exception(
+                [this, dir = std::move(dir)](std::exception_ptr e) {
+                    unplace(dir);
+                    return ss::make_exception_future<log>(e);
+                });
+        });
     });
 }
 
+ss::future<ntp_config> log_manager::place(ntp_config cfg) {
+    std::vector<ss::sstring> dirs{_config.base_dir};
+    dirs.insert(
+      dirs.end(), _config.extra_dirs.begin(), _config.extra_dirs.end());
+    return ss::do_with(
+      std::move(dirs),
+      std::move(cfg),
+      std::optional<ss::sstring>(),
+      [this](
+        std::vector<ss::sstring>& dirs,
+        ntp_config& cfg,
+        std::optional<ss::sstring>& found) {
+          return ss::do_for_each(
+                   dirs,
+                   [&cfg, &found](const ss::sstring& dir) {
+                       if (found) {
+                           return ss::now();
+                       }
+                       cfg.base_directory() = dir;
+                       return ss::file_exists(cfg.work_directory())
+                         .then([&found, dir](bool exists) {
+                             if (exists) {
+                                 found = dir;
+                             }
+                         });
+                   })
+            .then([this, &dirs, &cfg, &found] {
+                if (!found) {
+                    // the first of the least loaded, in the order of the
+                    // configuration
+                    found = *std::min_element(
+                      dirs.begin(),
+                      dirs.end(),
+                      [this](const ss::sstring& a, const ss::sstring& b) {
+                          return _logs_per_dir[a] < _logs_per_dir[b];
+                      });
+                }
+                cfg.base_directory() = *found;
+                ++_logs_per_dir[*found];
+                vlog(stlog.debug, "Placed {} in {}", cfg.ntp(), *found);
+                return std::move(cfg);
+            });
+      });
+}
+
+void log_manager::unplace(const ss::sstring& dir) {
+    if (auto it = _logs_per_dir.find(dir);
+        it != _logs_per_dir.end() && it->second > 0) {
+        --it->second;
+    }
+}
+
 ss::future<log> log_manager::do_manage(ntp_config cfg) {
     if (_config.base_dir.empty()) {
         return ss::make_exception_future<log>(std::runtime_error(
@@ -179,24 +784,44 @@ ss::future<log> log_manager::do_manage(ntp_config cfg) {
     ss::sstring path = cfg.work_directory();
     vassert(
       _logs.find(cfg.ntp()) == _logs.end(), "cannot double register same ntp");
-    if (_config.stype == log_config::storage_type::memory) {
-        auto l = storage::make_memory_backed_log(std::move(cfg));
-        _logs.emplace(l.config().ntp(), l);
+    if (
+      _config.stype == log_config::storage_type::memory
+      || cfg.is_in_memory()) {
+        // the logs of a memory log_manager are not bounded by the budget
+        auto budget = cfg.is_in_memory() ? _memory_log_budget : nullptr;
+        auto l = storage::make_memory_backed_log(
+          std::move(cfg), std::move(budget));
+        auto [it, _] = _logs.emplace(l.config().ntp(), l);
+        schedule_housekeeping(it->second, it->first, _jitter());
+        arm_housekeeping();
         // in-memory needs to write vote_for configuration
         return ss::recursive_touch_directory(path).then([l] { return l; });
     }
-    return recover_segments(
-             std::filesystem::path(path),
-             _config.sanitize_fileops,
-             cfg.is_compacted(),
-             [this] { return create_cache(); },
-             _abort_source)
+    return ss::with_semaphore(
+             _recovery_sem,
+             1,
+             [this, path, compacted = cfg.is_compacted()] {
+                 return recover_segments(
+                   std::filesystem::path(path),
+                   _config.sanitize_fileops,
+                   compacted,
+                   [this] { return create_cache(); },
+                   _abort_source,
+                   data_file_wrapper(),
+                   _config.segment_readahead_size);
+             })
       .then([this, cfg = std::move(cfg)](segment_set segments) mutable {
           auto l = storage::make_disk_backed_log(
             std::move(cfg), *this, std::move(segments), _kvstore);
-          auto [_, success] = _logs.emplace(l.config().ntp(), l);
+          auto [it, success] = _logs.emplace(l.config().ntp(), l);
           vassert(success, "Could not keep track of:{} - concurrency issue", l);
-          return l;
+          schedule_housekeeping(it->second, it->first, _jitter());
+          arm_housekeeping();
+          if (!_wal) {
+              return ss::make_ready_future<log>(l);
+          }
+          // the batches flushed to the wal only are appended back
+          return _wal->replay(l).then([l] { return l; });
       });
 }
 
@@ -210,6 +835,7 @@ ss::future<> log_manager::remove(model::ntp ntp) {
         // 'ss::shared_ptr<>' make a copy
         storage::log lg = handle.mapped().handle;
         vlog(stlog.info, "Removing: {}", lg);
+        unplace(lg.config().base_directory());
         // NOTE: it is ok to *not* externally synchronize the log here
         // because remove, takes a write lock on each individual segments
         // waiting for all of them to be closed before actually removing the
@@ -217,8 +843,36 @@ ss::future<> log_manager::remove(model::ntp ntp) {
         // compaction or so, it will block correctly.
         auto ntp_dir = lg.config().work_directory();
         ss::sstring topic_dir = lg.config().topic_directory().string();
-        return lg.remove()
-          .then([dir = std::move(ntp_dir)] { return ss::remove_file(dir); })
+        auto f = _wal ? _wal->detach(lg.config().ntp()) : ss::now();
+        if (
+          _config.stype == log_config::storage_type::memory
+          || lg.config().is_in_memory()) {
+            f = f.then([lg]() mutable { return lg.remove(); })
+                  .then([dir = std::move(ntp_dir)] {
+                      return ss::remove_file(dir);
+                  });
+        } else {
+            // the files of the log are deleted in the background, once its
+            // directory is out of the way of a log of the same name
+            f = f.then([lg]() mutable { return lg.close(); })
+                  .then([this, ntp = lg.config().ntp()] {
+                      auto keys = kvstore_keys(ntp);
+                      return ss::do_with(
+                        std::move(keys), [this](std::vector<bytes>& keys) {
+                            return ss::parallel_for_each(
+                              keys, [this](const bytes& key) {
+                                  return _kvstore.remove(
+                                    kvstore::key_space::storage, key);
+                              });
+                        });
+                  })
+                  .then([this, lg, dir = std::move(ntp_dir)] {
+                      return _deleter.remove(
+                        std::filesystem::path(dir),
+                        lg.config().base_directory());
+                  });
+        }
+        return f
           .then([this, dir = std::move(topic_dir)]() mutable {
               // We always dispatch topic directory deletion to core 0 as
               // requests may come from different cores
@@ -228,6 +882,28 @@ ss::future<> log_manager::remove(model::ntp ntp) {
     });
 }
 
+ss::future<> log_manager::shutdown(model::ntp ntp) {
+    vlog(stlog.info, "Asked to shutdown: {}", ntp);
+    return ss::with_gate(_open_gate, [this, ntp = std::move(ntp)] {
+        auto handle = _logs.extract(ntp);
+        if (handle.empty()) {
+            return ss::make_ready_future<>();
+        }
+        storage::log lg = handle.mapped().handle;
+        unplace(lg.config().base_directory());
+        return lg.close()
+          .then([this, lg] {
+              // the log is flushed, and may be managed by another core next
+              return _wal ? _wal->detach(lg.config().ntp()) : ss::now();
+          })
+          .finally([lg] {});
+    });
+}
+
+std::vector<bytes> log_manager::kvstore_keys(const model::ntp& ntp) {
+    return {disk_log_impl::start_offset_key(ntp)};
+}
+
 ss::future<> log_manager::dispatch_topic_dir_deletion(ss::sstring dir) {
     return ss::smp::submit_to(0, [dir = std::move(dir)]() mutable {
         static thread_local mutex fs_lock;
@@ -269,6 +945,20 @@ std::ostream& operator<<(std::ostream& o, log_config::storage_type t) {
     return o << "{unknown-storage-type}";
 }
 
+bool log_manager::is_archived(const model::ntp& ntp) const {
+    // like the exclusions of gc, internal namespaces are never archived
+    constexpr std::string_view archived_ns = "kafka";
+    return _config.archival_enabled && ntp.ns() == archived_ns;
+}
+
+std::optional<size_t> log_manager::local_retention_bytes() const {
+    if (!_config.retention_bytes || !_config.local_retention_bytes) {
+        return _config.local_retention_bytes ? _config.local_retention_bytes
+                                             : _config.retention_bytes;
+    }
+    return std::min(*_config.retention_bytes, *_config.local_retention_bytes);
+}
+
 std::ostream& operator<<(std::ostream& o, const log_config& c) {
     o << "{type:" << c.stype << ", base_dir:" << c.base_dir
       << ", max_segment.size:" << c.max_segment_size
@@ -282,6 +972,10 @@ std::ostream& operator<<(std::ostream& o, const log_config& c) {
     return o << ", compaction_interval_ms:" << c.compaction_interval.count()
              << ", delete_reteion_ms:" << c.delete_retention.count()
              << ", with_cache:" << c.cache
+             << ", archival_enabled:" << c.archival_enabled
+             << ", min_free_bytes:" << c.min_free_bytes.value_or(0)
+             << ", memory_log_bytes:" << c.memory_log_bytes
+             << ", segment_readahead_size:" << c.segment_readahead_size
              << ", relcaim_opts:" << c.reclaim_opts << "}";
 }
 std::ostream& operator<<(std::ostream& o, const log_manager& m) {
@@ -11,16 +11,21 @@
 
 #pragma once
 
+#include "config/property.h"
 #include "model/fundamental.h"
 #include "random/simple_time_jitter.h"
 #include "seastarx.h"
 #include "storage/batch_cache.h"
+#include "storage/chunk_cache.h"
+#include "storage/directory_deleter.h"
 #include "storage/kvstore.h"
 #include "storage/log.h"
 #include "storage/log_housekeeping_meta.h"
 #include "storage/segment.h"
+#include "storage/shared_wal.h"
 #include "storage/types.h"
 #include "storage/version.h"
+#include "storage/write_behind_controller.h"
 #include "units.h"
 #include "utils/mutex.h"
 
@@ -29,13 +34,20 @@
 #include <seastar/core/future.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/reactor.hh>
+#include <seastar/core/scheduling.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/sstring.hh>
 
 #include <absl/container/flat_hash_map.h>
 
 #include <array>
 #include <chrono>
+#include <memory>
 #include <optional>
+#include <queue>
+#include <vector>
 
 namespace storage {
 
@@ -94,10 +106,19 @@ struct log_config {
 
     storage_type stype;
     ss::sstring base_dir;
+    // the logs created in the base dir are spread among it and these
+    // directories, see log_manager::place()
+    std::vector<ss::sstring> extra_dirs;
     size_t max_segment_size;
 
     // compacted segment size
     size_t max_compacted_segment_size = 256_MiB;
+    // when set, the segments of a log are sized from its write rate to hold
+    // about this long of writes, between the min segment size below and the
+    // segment sizes above, see disk_log_impl::update_segment_size_target()
+    std::optional<std::chrono::milliseconds> segment_roll_target
+      = std::nullopt;
+    size_t min_segment_size = 1_MiB;
     // used for testing: keeps a backtrace of operations for debugging
     debug_sanitize_files sanitize_fileops = debug_sanitize_files::no;
     // same as retention.bytes in kafka
@@ -106,6 +127,68 @@ struct log_config {
     // same as delete.retention.ms in kafka - default 1 week
     std::chrono::milliseconds delete_retention = std::chrono::minutes(10080);
     with_cache cache = log_config::with_cache::yes;
+    // bound on the hashed key index used by compaction, see compaction_config
+    std::optional<size_t> hashed_key_index_bytes = std::nullopt;
+    // bounds the bytes compacted in a housekeeping round to this rate times
+    // the compaction interval. unbounded when not set
+    std::optional<size_t> compaction_bytes_per_sec = std::nullopt;
+    // logs opened and recovered at once by the log manager of a core
+    size_t max_concurrent_recoveries = 64;
+    // segments removed by retention that a core closes and deletes at once,
+    // in the background of the housekeeping that removed them
+    size_t max_concurrent_segment_deletions = 2;
+    // when set, concurrent reads of a segment file that are adjacent are
+    // merged up to this size, see coalescing_file
+    std::optional<size_t> coalesced_read_max_bytes = std::nullopt;
+    // read ahead by the readers of the segment files
+    size_t segment_readahead_size = default_segment_readahead_size;
+    // memory of a core for the buffers of log readers beyond their smallest
+    // size, see read_buffer_sizer
+    size_t read_buffers_memory = 64_MiB;
+    // readers parked between sequential reads of a log are closed after
+    // this long without being resumed, see readers_cache
+    std::chrono::milliseconds readers_cache_eviction_timeout
+      = std::chrono::seconds(30);
+    // segments of the kafka namespace are uploaded to object storage: they
+    // are only collected once uploaded (see log::set_archived_offset), and
+    // the local retention below bounds them on disk instead of the retention
+    // above, which the archival service applies to object storage
+    bool archival_enabled = false;
+    std::optional<size_t> local_retention_bytes = std::nullopt;
+    std::chrono::milliseconds local_delete_retention = std::chrono::hours(24);
+    // when set, the oldest segments of the deletable logs are removed ahead
+    // of their retention while a data directory has less free space than
+    // this, see log_manager::reclaim_disk_space()
+    std::optional<size_t> min_free_bytes = std::nullopt;
+    // housekeeping rounds, which visit the logs due, are at least this far
+    // apart. each log is visited at least every compaction interval
+    std::chrono::milliseconds housekeeping_min_interval
+      = std::chrono::seconds(1);
+    // when set, the closed segments of the logs of a core are read back and
+    // verified in the background at most at this rate, see log::scrub()
+    std::optional<size_t> scrub_bytes_per_sec = std::nullopt;
+    // time between the passes of the scrub over the logs of a core
+    std::chrono::milliseconds scrub_interval = std::chrono::hours(24);
+    ss::io_priority_class scrub_priority = ss::default_priority_class();
+    // memory of a core for the logs of the in-memory topics, see
+    // memory_log_budget
+    size_t memory_log_bytes = 64_MiB;
+    // the free space of the data directories is checked this often
+    std::chrono::milliseconds disk_check_interval = std::chrono::seconds(10);
+    // when set, the logs of a core are flushed through a shared_wal, whose
+    // segments roll at this size
+    std::optional<size_t> shared_wal_segment_size = std::nullopt;
+    std::chrono::milliseconds shared_wal_recovery_timeout
+      = std::chrono::minutes(5);
+    // when set, housekeeping merges the runs of small batches of the closed
+    // segments into batches of up to this size
+    std::optional<size_t> coalesce_batch_bytes = std::nullopt;
+    // when set, the files of the removed logs of a core are deleted at most
+    // at this rate, see directory_deleter
+    std::optional<size_t> deletion_bytes_per_sec = std::nullopt;
+    // cpu and io classes of all housekeeping work
+    ss::scheduling_group compaction_sg = ss::default_scheduling_group();
+    ss::io_priority_class compaction_priority = ss::default_priority_class();
     batch_cache::reclaim_options reclaim_opts{
       .growth_window = std::chrono::seconds(3),
       .stable_window = std::chrono::seconds(10),
@@ -153,6 +236,9 @@ class log_manager {
 public:
     explicit log_manager(log_config, kvstore& kvstore) noexcept;
 
+    /// \brief recovers the shared_wal, if any, before the logs are managed
+    ss::future<> start();
+
     ss::future<log> manage(ntp_config);
 
     /**
@@ -166,18 +252,70 @@ public:
      */
     ss::future<> remove(model::ntp);
 
+    /**
+     * Stop managing an ntp and close its log, keeping its storage, so that
+     * another core of the node can manage it. The state of the log in the
+     * kvstore, see kvstore_keys(), is left to the caller to move along.
+     */
+    ss::future<> shutdown(model::ntp);
+
+    /// The keys of the state of an ntp's log in the storage kvstore
+    static std::vector<bytes> kvstore_keys(const model::ntp&);
+
     ss::future<> stop();
 
+    /**
+     * Register the shard-wide storage metrics, such as those of the batch
+     * cache, of the chunk cache and of the segment appenders write behind.
+     * Metrics are per-shard, so this must only be called for the main log
+     * manager of each shard.
+     */
+    void setup_metrics() {
+        _batch_cache.probe().setup_metrics(_batch_cache);
+        internal::write_behind().setup_metrics();
+        internal::chunks().setup_metrics();
+        setup_disk_metrics();
+        setup_memory_log_metrics();
+    }
+
     ss::future<ss::lw_shared_ptr<segment>> make_log_segment(
       const ntp_config&,
       model::offset,
       model::term_id,
       ss::io_priority_class pc,
       record_version_type = record_version_type::v1,
-      size_t buffer_size = default_segment_readahead_size);
+      std::optional<size_t> buffer_size = std::nullopt,
+      size_t fallocation_step = segment_appender::fallocation_step);
+
+    /// opens an existing segment file, as during recovery
+    ss::future<ss::lw_shared_ptr<segment>> open_log_segment(
+      const std::filesystem::path&, segment_file_wrapper wrap_data = {});
 
     const log_config& config() const { return _config; }
 
+    /// the write-ahead log the logs of the core are flushed through, if any
+    shared_wal* wal() { return _wal.get(); }
+
+    /// the batch cache of the logs of this core
+    const batch_cache& cache() const { return _batch_cache; }
+
+    /// budget of the read buffers of the logs of this core
+    ss::semaphore& read_buffers() { return _read_buffers; }
+
+    /// bounds the segments of this core being closed and deleted in the
+    /// background, see disk_log_impl::remove_segment_in_background
+    ss::semaphore& segment_deletions() { return _segment_deletions; }
+
+    /// whether the segments of the log are uploaded to object storage
+    bool is_archived(const model::ntp&) const;
+
+    /// \brief makes the log due for housekeeping, as when a segment is
+    /// closed and may be compacted or collected
+    void request_housekeeping(const model::ntp&);
+
+    /// \brief the logs due later than the new interval are rescheduled
+    void set_compaction_interval(std::chrono::milliseconds);
+
     /// Returns the number of managed logs.
     size_t size() const { return _logs.size(); }
 
@@ -193,19 +331,62 @@ public:
     absl::flat_hash_map<model::ntp, log> get(const model::topic_namespace&);
 
 private:
+    /// local bound of the size of an archived log, which never exceeds the
+    /// total retention
+    std::optional<size_t> local_retention_bytes() const;
+
     using logs_type = absl::flat_hash_map<model::ntp, log_housekeeping_meta>;
 
     ss::future<log> do_manage(ntp_config);
+    /// \brief moves a log of the base dir to the data directory holding it
+    /// already, or else to the one with the fewest logs of the core
+    ss::future<ntp_config> place(ntp_config);
+    void unplace(const ss::sstring& dir);
 
     /**
      * \brief delete old segments and trigger compacted segments
      *        runs inside a seastar thread
      */
     void trigger_housekeeping();
+    /// arms the timer for the earliest log due, see _housekeeping_queue
     void arm_housekeeping();
     ss::future<> housekeeping();
+    std::vector<model::ntp> compaction_order(std::vector<model::ntp>) const;
+    void schedule_housekeeping(
+      log_housekeeping_meta&, const model::ntp&, ss::lowres_clock::time_point);
+    /// \brief when the log is next due: right away while it has segments to
+    /// compact, or else once its oldest segment expires, and at the latest
+    /// after the compaction interval
+    ss::lowres_clock::time_point
+    next_housekeeping(const model::ntp&, const log&);
+    /// pops the logs due by then
+    std::vector<model::ntp>
+      due_for_housekeeping(ss::lowres_clock::time_point);
+
+    /// the base dir and the extra dirs
+    std::vector<ss::sstring> data_dirs() const;
+    void trigger_disk_check();
+    ss::future<> check_disk_space();
+    /**
+     * \brief removes the oldest reclaimable segments of the logs of the dir
+     * until their sizes add up to the given bytes
+     *
+     * The segments of archived logs go first, as they are in object storage
+     * already, and then the segments in the order of their max timestamp,
+     * across the logs of the core.
+     */
+    ss::future<> reclaim_disk_space(ss::sstring dir, size_t bytes);
+    std::optional<model::ntp> next_reclaimable(const ss::sstring& dir) const;
+    void setup_disk_metrics();
+    void setup_memory_log_metrics();
+
+    void trigger_scrub();
+    /// a pass of the scrub over the logs of the core, one at a time
+    ss::future<> scrub();
 
     std::optional<batch_cache_index> create_cache();
+    /// wraps the data files of the segments, see coalesced_read_max_bytes
+    segment_file_wrapper data_file_wrapper() const;
 
     ss::future<> dispatch_topic_dir_deletion(ss::sstring dir);
 
@@ -214,10 +395,52 @@ private:
     simple_time_jitter<ss::lowres_clock> _jitter;
     ss::timer<ss::lowres_clock> _compaction_timer;
     logs_type _logs;
+
+    struct housekeeping_deadline {
+        ss::lowres_clock::time_point deadline;
+        model::ntp ntp;
+
+        // the earliest on top of the queue
+        bool operator<(const housekeeping_deadline& o) const {
+            return deadline > o.deadline;
+        }
+    };
+    // the next housekeeping of each log. an entry is stale once its log is
+    // removed or scheduled at another time, see
+    // log_housekeeping_meta::next_housekeeping, and dropped once on top
+    std::priority_queue<housekeeping_deadline> _housekeeping_queue;
+    ss::lowres_clock::time_point _last_housekeeping{ss::lowres_clock::now()};
+    bool _housekeeping_running{false};
     batch_cache _batch_cache;
+    // bounds the segments recovered at once, many logs are opened together
+    // at startup
+    ss::semaphore _recovery_sem;
+    // the logs of the core per data directory, when there are extra dirs
+    absl::flat_hash_map<ss::sstring, size_t> _logs_per_dir;
+    ss::semaphore _segment_deletions;
+    ss::semaphore _read_buffers;
     ss::gate _open_gate;
     ss::abort_source _abort_source;
 
+    struct disk_space {
+        uint64_t free{0};
+        uint64_t total{0};
+    };
+    // as of the last check, per data directory
+    absl::flat_hash_map<ss::sstring, disk_space> _disk_space;
+    ss::timer<ss::lowres_clock> _disk_check_timer;
+    ss::timer<ss::lowres_clock> _scrub_timer;
+    uint64_t _reclaimed_bytes{0};
+    uint64_t _reclaimed_segments{0};
+    ss::lw_shared_ptr<memory_log_budget> _memory_log_budget;
+    std::unique_ptr<shared_wal> _wal;
+    directory_deleter _deleter;
+    ss::metrics::metric_groups _metrics;
+    // follow the updates of the properties the config was built from
+    config::property<std::chrono::milliseconds>::watcher
+      _compaction_interval_watcher;
+    config::property<size_t>::watcher _reclaim_min_size_watcher;
+
     friend std::ostream& operator<<(std::ostream&, const log_manager&);
 };
 std::ostream& operator<<(std::ostream& o, log_config::storage_type t);
@@ -20,6 +20,9 @@
 
 #include <fmt/ostream.h>
 
+#include <algorithm>
+#include <limits>
+
 namespace storage {
 using records_t = ss::circular_buffer<model::record_batch>;
 
@@ -40,6 +43,10 @@ batch_consumer::consume_result skipping_consumer::consume_batch_start(
     }
     _expected_next_batch = header.last_offset() + model::offset(1);
 
+    if (_reader._state.read_ahead) {
+        return read_ahead_batch_start(header);
+    }
+
     if (header.last_offset() < _reader._config.start_offset) {
         return skip_batch::yes;
     }
@@ -65,11 +72,17 @@ batch_consumer::consume_result skipping_consumer::consume_batch_start(
            > _reader._config.max_bytes) {
         // signal to log reader to stop (see log_reader::is_done)
         _reader._config.over_budget = true;
+        if (maybe_start_read_ahead()) {
+            return read_ahead_batch_start(header);
+        }
         return stop_parser::yes;
     }
 
     _header = header;
     _header.ctx.term = _reader._seg.offsets().term;
+    if (_reader._config.header_only) {
+        return skip_records::yes;
+    }
     return skip_batch::no;
 }
 
@@ -78,6 +91,9 @@ void skipping_consumer::consume_records(iobuf&& records) {
 }
 
 batch_consumer::stop_parser skipping_consumer::consume_batch_end() {
+    if (_reader._state.read_ahead) {
+        return read_ahead_batch_end();
+    }
     // Note: This is what keeps the train moving. the `_reader.*` transitively
     // updates the next batch to consume
     _reader.add_one(model::record_batch(
@@ -95,32 +111,143 @@ batch_consumer::stop_parser skipping_consumer::consume_batch_end() {
     if (_next_cached_batch == (_header.last_offset() + model::offset(1))) {
         return stop_parser::yes;
     }
+    if (model::timeout_clock::now() >= _timeout) {
+        return stop_parser::yes;
+    }
+    if (_reader._config.bytes_consumed >= _reader._config.max_bytes) {
+        if (!maybe_start_read_ahead()) {
+            return stop_parser::yes;
+        }
+        _header = {};
+        return stop_parser::no;
+    }
+    _header = {};
+    return stop_parser(
+      _reader._state.is_full(_reader._stream_size.slice_size()));
+}
+
+/*
+ * Read-ahead starts once the reader has consumed its byte budget. Instead of
+ * stopping, the parser keeps going and the following batches are inserted in
+ * the batch cache without being returned to the reader, so that the next
+ * sequential read of the log, typically the next fetch of the same consumer,
+ * is served from memory. Read-ahead batches are marked as such so that they
+ * do not displace the batches protected from scans (see batch_cache).
+ */
+bool skipping_consumer::maybe_start_read_ahead() {
     if (
-      _reader._config.bytes_consumed >= _reader._config.max_bytes
+      _reader._config.skip_batch_cache || _reader._config.header_only
+      || _reader._config.read_ahead_bytes == 0) {
+        return false;
+    }
+    _reader._state.read_ahead = true;
+    return true;
+}
+
+batch_consumer::consume_result skipping_consumer::read_ahead_batch_start(
+  const model::record_batch_header& header) {
+    if (header.base_offset() > _reader._config.max_offset) {
+        return stop_parser::yes;
+    }
+    _header = header;
+    _header.ctx.term = _reader._seg.offsets().term;
+    return skip_batch::no;
+}
+
+batch_consumer::stop_parser skipping_consumer::read_ahead_batch_end() {
+    _read_ahead_bytes += _header.size_bytes;
+    if (_reader._data_version == _reader._seg.pin_data()) {
+        _reader._seg.cache_put(
+          model::record_batch(
+            _header, std::move(_records), model::record_batch::tag_ctor_ng{}),
+          true);
+    }
+    if (
+      _header.last_offset() >= _reader._seg.offsets().stable_offset
+      || _header.last_offset() >= _reader._config.max_offset
+      || _next_cached_batch == (_header.last_offset() + model::offset(1))
+      || _read_ahead_bytes >= _reader._config.read_ahead_bytes
       || model::timeout_clock::now() >= _timeout) {
         return stop_parser::yes;
     }
     _header = {};
-    return stop_parser(_reader._state.is_full());
+    return stop_parser::no;
 }
 
 void skipping_consumer::print(std::ostream& os) const {
     fmt::print(os, "storage::skipping_consumer segment {}", _reader._seg);
 }
 
+read_buffer_sizer::stream_size
+read_buffer_sizer::next(size_t wanted, size_t max_buffer_size) {
+    stream_size ret;
+    const size_t target = std::min(
+      std::max(wanted, min_buffer_size << _run),
+      max_buffer_size * max_read_ahead);
+    if (target <= min_buffer_size || max_buffer_size <= min_buffer_size) {
+        return ret;
+    }
+    // buffers grow up to the limit of the segment, then read-ahead deepens
+    size_t buffer = min_buffer_size;
+    while (buffer < target && buffer < max_buffer_size) {
+        buffer *= 2;
+    }
+    buffer = std::min(buffer, max_buffer_size);
+    const auto read_ahead = static_cast<unsigned>(
+      std::clamp<size_t>(target / buffer, 1, max_read_ahead));
+    if (_budget) {
+        auto units = ss::try_get_units(
+          *_budget, buffer * read_ahead - min_buffer_size);
+        if (!units) {
+            return ret;
+        }
+        ret.units = std::move(*units);
+    }
+    ret.buffer_size = buffer;
+    ret.read_ahead = read_ahead;
+    return ret;
+}
+
 log_segment_batch_reader::log_segment_batch_reader(
-  segment& seg, log_reader_config& config, probe& p) noexcept
+  segment& seg,
+  log_reader_config& config,
+  probe& p,
+  read_buffer_sizer& sizer) noexcept
   : _seg(seg)
   , _config(config)
-  , _probe(p) {}
+  , _probe(p)
+  , _sizer(sizer) {}
+
+// bytes the read still wants from disk, including its read-ahead
+static size_t wanted_bytes(const log_reader_config& cfg) {
+    constexpr auto max = std::numeric_limits<size_t>::max();
+    size_t wanted = cfg.max_bytes > cfg.bytes_consumed
+                      ? cfg.max_bytes - cfg.bytes_consumed
+                      : 0;
+    return wanted > max - cfg.read_ahead_bytes ? max
+                                                : wanted + cfg.read_ahead_bytes;
+}
 
 std::unique_ptr<continuous_batch_parser> log_segment_batch_reader::initialize(
   model::timeout_clock::time_point timeout,
   std::optional<model::offset> next_cached_batch) {
-    auto input = _seg.offset_data_stream(_config.start_offset, _config.prio);
+    // releases the memory of the previous stream, if any
+    _stream_size = {};
+    _stream_size = _sizer.next(
+      wanted_bytes(_config), _seg.reader().buffer_size());
+    // the stream and its position are those of the current version, which
+    // is kept open while the stream reads it
+    _data_version = _seg.pin_data();
+    auto input = _seg.offset_data_stream(
+      _config.start_offset,
+      _config.prio,
+      _stream_size.buffer_size,
+      _stream_size.read_ahead);
+    auto consumer = std::make_unique<skipping_consumer>(
+      *this, timeout, next_cached_batch);
+    _consumer = consumer.get();
     return std::make_unique<continuous_batch_parser>(
-      std::make_unique<skipping_consumer>(*this, timeout, next_cached_batch),
-      std::move(input));
+      std::move(consumer), std::move(input));
 }
 
 ss::future<> log_segment_batch_reader::close() {
@@ -138,7 +265,11 @@ void log_segment_batch_reader::add_one(model::record_batch&& batch) {
     _config.bytes_consumed += size_bytes;
     _state.buffer_size += size_bytes;
     _probe.add_bytes_read(size_bytes);
-    if (!_config.skip_batch_cache) {
+    // the batches of a replaced version are not cached, as the batches of
+    // the current one may have been compacted away
+    if (
+      !_config.skip_batch_cache && !_config.header_only
+      && _data_version == _seg.pin_data()) {
         _seg.cache_put(b);
     }
 }
@@ -153,7 +284,7 @@ log_segment_batch_reader::read_some(model::timeout_clock::time_point timeout) {
       _config.max_offset,
       _config.type_filter,
       _config.first_timestamp,
-      max_buffer_size,
+      _stream_size.slice_size(),
       _config.skip_batch_cache);
 
     // handles cases where the type filter skipped batches. see
@@ -167,6 +298,9 @@ log_segment_batch_reader::read_some(model::timeout_clock::time_point timeout) {
         _probe.add_bytes_read(cache_read.memory_usage);
         _probe.add_cached_bytes_read(cache_read.memory_usage);
         _probe.add_cached_batches_read(cache_read.batches.size());
+        if (!cache_read.batches.empty()) {
+            _probe.batch_cache_hit();
+        }
         return ss::make_ready_future<result<records_t>>(
           std::move(cache_read.batches));
     }
@@ -181,43 +315,94 @@ log_segment_batch_reader::read_some(model::timeout_clock::time_point timeout) {
         return ss::make_ready_future<result<records_t>>(records_t{});
     }
 
-    if (!_iterator) {
-        _iterator = initialize(timeout, cache_read.next_cached_batch);
+    _probe.batch_cache_miss();
+    ss::future<> f = ss::now();
+    if (_iterator) {
+        /*
+         * the parser is kept across reads, and across the reads of a reader
+         * parked in the readers cache, as long as it can reach the start
+         * offset by moving forward in its input stream.
+         */
+        if (
+          _iterator->is_resumable()
+          && _consumer->next_batch() <= _config.start_offset) {
+            _consumer->reset(timeout, cache_read.next_cached_batch);
+            return read_from_iterator();
+        }
+        auto it = std::exchange(_iterator, nullptr);
+        _consumer = nullptr;
+        auto raw = it.get();
+        f = raw->close().finally([it = std::move(it)] {});
     }
-    auto ptr = _iterator.get();
-    return ptr->consume().then(
-      [this](result<size_t> bytes_consumed) -> result<records_t> {
-          if (!bytes_consumed) {
-              return bytes_consumed.error();
-          }
-          auto tmp = std::exchange(_state, {});
-          return result<records_t>(std::move(tmp.buffer));
+    // the segment index is loaded on demand to position the parser
+    return f.then([this] { return _seg.index().ensure_loaded(); })
+      .then([this, timeout, next = cache_read.next_cached_batch] {
+          _iterator = initialize(timeout, next);
+          return read_from_iterator();
       });
 }
 
+ss::future<result<records_t>> log_segment_batch_reader::read_from_iterator() {
+    auto ptr = _iterator.get();
+    return ptr->consume().then([this](result<size_t> bytes_consumed) {
+        if (!bytes_consumed) {
+            return ss::make_ready_future<result<records_t>>(
+              bytes_consumed.error());
+        }
+        // after a read-ahead the parser is past the returned batches. the
+        // next read is served from the cache up to the parser position.
+        auto tmp = std::exchange(_state, {});
+        return ss::make_ready_future<result<records_t>>(std::move(tmp.buffer));
+    });
+}
+
 log_reader::log_reader(
   std::unique_ptr<lock_manager::lease> l,
   log_reader_config config,
-  probe& probe) noexcept
+  probe& probe,
+  ss::semaphore* read_buffers) noexcept
   : _lease(std::move(l))
   , _iterator(_lease->range.begin())
   , _config(config)
+  , _sizer(read_buffers)
   , _probe(probe) {
-    if (config.abort_source) {
-        auto op_sub = config.abort_source.value().get().subscribe(
-          [this]() noexcept { set_end_of_stream(); });
-
-        if (op_sub) {
-            _as_sub = std::move(*op_sub);
-        } else {
-            // already aborted
-            set_end_of_stream();
-        }
+    subscribe_abort_source();
+    if (_iterator.next_seg != _lease->range.end()) {
+        _iterator.reader = std::make_unique<log_segment_batch_reader>(
+          **_iterator.next_seg, _config, _probe, _sizer);
     }
+}
 
-    if (_iterator.next_seg != _lease->range.end()) {
+void log_reader::subscribe_abort_source() {
+    if (!_config.abort_source) {
+        return;
+    }
+    auto op_sub = _config.abort_source.value().get().subscribe(
+      [this]() noexcept { set_end_of_stream(); });
+
+    if (op_sub) {
+        _as_sub = std::move(*op_sub);
+    } else {
+        // already aborted
+        set_end_of_stream();
+    }
+}
+
+void log_reader::reset_config(log_reader_config cfg) {
+    vassert(
+      is_reusable() && cfg.start_offset == next_offset(),
+      "reader at {} cannot be reset to {}",
+      next_offset(),
+      cfg);
+    // the segment reader refers to _config, which is updated in place
+    _config = cfg;
+    _last_base = {};
+    _limit_reached = false;
+    _sizer.sequential_read();
+    subscribe_abort_source();
+    if (!_iterator.reader && _iterator.next_seg != _lease->range.end()) {
         _iterator.reader = std::make_unique<log_segment_batch_reader>(
-          **_iterator.next_seg, _config, _probe);
+          **_iterator.next_seg, _config, _probe, _sizer);
     }
 }
 
@@ -226,6 +411,7 @@ ss::future<> log_reader::find_next_valid_iterator() {
         return ss::make_ready_future<>();
     }
     std::unique_ptr<log_segment_batch_reader> tmp_reader = nullptr;
+    _sizer.sequential_read();
     while (_config.start_offset > _iterator.offsets().dirty_offset) {
         _iterator.next_seg++;
         if (!tmp_reader) {
@@ -237,7 +423,7 @@ ss::future<> log_reader::find_next_valid_iterator() {
     }
     if (_iterator.next_seg != _lease->range.end()) {
         _iterator.reader = std::make_unique<log_segment_batch_reader>(
-          **_iterator.next_seg, _config, _probe);
+          **_iterator.next_seg, _config, _probe, _sizer);
     }
     if (tmp_reader) {
         auto raw = tmp_reader.get();
@@ -250,10 +436,10 @@ ss::future<log_reader::storage_t>
 log_reader::do_load_slice(model::timeout_clock::time_point timeout) {
     if (is_done()) {
         // must keep this function because, the segment might not be done
-        // but offsets might have exceeded the read
-        set_end_of_stream();
-        return _iterator.close().then(
-          [] { return ss::make_ready_future<storage_t>(); });
+        // but offsets might have exceeded the read. the reader keeps its
+        // position so that it can be reused; finally() closes it otherwise.
+        _limit_reached = true;
+        return ss::make_ready_future<storage_t>();
     }
     if (_last_base == _config.start_offset) {
         set_end_of_stream();
@@ -23,6 +23,7 @@
 
 #include <seastar/core/circular_buffer.hh>
 #include <seastar/core/io_queue.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/util/optimized_optional.hh>
 
 /**
@@ -70,21 +71,83 @@ public:
     stop_parser consume_batch_end() override;
     void print(std::ostream&) const override;
 
+    /// prepares the consumer of a resumed parser for another read
+    void reset(
+      model::timeout_clock::time_point timeout,
+      std::optional<model::offset> next_cached_batch) {
+        _timeout = timeout;
+        _next_cached_batch = next_cached_batch;
+        _read_ahead_bytes = 0;
+    }
+
+    /// offset of the batch following the last one the parser went through
+    model::offset next_batch() const { return _expected_next_batch; }
+
 private:
+    /// keep reading batches into the cache instead of stopping, if enabled
+    bool maybe_start_read_ahead();
+    consume_result read_ahead_batch_start(const model::record_batch_header&);
+    stop_parser read_ahead_batch_end();
+
     log_segment_batch_reader& _reader;
     model::record_batch_header _header;
     iobuf _records;
     model::timeout_clock::time_point _timeout;
     std::optional<model::offset> _next_cached_batch;
     model::offset _expected_next_batch;
+    // bytes read ahead into the cache
+    size_t _read_ahead_bytes{0};
 };
 
-class log_segment_batch_reader {
+/// \brief Sizes the data streams, and the slices, of a log reader.
+///
+/// Streams start small: tail reads are mostly served from the batch cache and
+/// read a few batches from disk. Reads asking for more bytes get larger
+/// buffers and a deeper read-ahead, and so does a reader that keeps reading
+/// sequentially, moving on to the next segment or being resumed from the
+/// readers cache: each such step doubles the size of its next stream. The
+/// memory above the smallest stream is taken from the read buffer budget of
+/// the shard, when there is one; once it is exhausted, streams keep the
+/// smallest size.
+class read_buffer_sizer {
 public:
-    static constexpr size_t max_buffer_size = 32 * 1024; // 32KB
+    static constexpr size_t min_buffer_size = 32 * 1024; // 32KB
+    static constexpr unsigned max_read_ahead = 4;
+
+    struct stream_size {
+        size_t buffer_size{min_buffer_size};
+        unsigned read_ahead{1};
+        // memory taken from the budget, released with the stream
+        std::optional<ss::semaphore_units<>> units;
+
+        /// bytes of a slice returned by the reader of the stream
+        size_t slice_size() const { return buffer_size * read_ahead; }
+    };
+
+    explicit read_buffer_sizer(ss::semaphore* budget) noexcept
+      : _budget(budget) {}
+
+    /// the next read of the reader continues where the last one stopped
+    void sequential_read() { _run = std::min(_run + 1, max_doublings); }
+
+    /// \brief the size of a stream for a read that wants \p wanted bytes,
+    /// with buffers of at most \p max_buffer_size
+    stream_size next(size_t wanted, size_t max_buffer_size);
+
+private:
+    static constexpr unsigned max_doublings = 5;
+
+    ss::semaphore* _budget;
+    unsigned _run{0};
+};
 
+class log_segment_batch_reader {
+public:
     log_segment_batch_reader(
-      segment&, log_reader_config& config, probe& p) noexcept;
+      segment&,
+      log_reader_config& config,
+      probe& p,
+      read_buffer_sizer& sizer) noexcept;
     log_segment_batch_reader(log_segment_batch_reader&&) noexcept = default;
     log_segment_batch_reader&
     operator=(log_segment_batch_reader&&) noexcept = delete;
@@ -103,20 +166,32 @@ private:
       model::timeout_clock::time_point,
       std::optional<model::offset> next_cached_batch);
 
+    ss::future<result<ss::circular_buffer<model::record_batch>>>
+    read_from_iterator();
+
     void add_one(model::record_batch&&);
 
 private:
     struct tmp_state {
         ss::circular_buffer<model::record_batch> buffer;
         size_t buffer_size = 0;
-        bool is_full() const { return buffer_size >= max_buffer_size; }
+        // the parser read ahead past the batches in the buffer
+        bool read_ahead = false;
+        bool is_full(size_t max) const { return buffer_size >= max; }
     };
 
     segment& _seg;
     log_reader_config& _config;
     probe& _probe;
+    read_buffer_sizer& _sizer;
+    // size of the stream of _iterator
+    read_buffer_sizer::stream_size _stream_size;
+    // the version of the data file streamed by _iterator
+    segment::data_version_ptr _data_version;
 
     std::unique_ptr<continuous_batch_parser> _iterator;
+    // the consumer of _iterator, owned by it
+    skipping_consumer* _consumer{nullptr};
     tmp_state _state;
     friend class skipping_consumer;
 };
@@ -127,15 +202,19 @@ public:
     using foreign_data_t = model::record_batch_reader::foreign_data_t;
     using storage_t = model::record_batch_reader::storage_t;
 
+    /// \p read_buffers is the read buffer budget of the shard, if any
     log_reader(
-      std::unique_ptr<lock_manager::lease>, log_reader_config, probe&) noexcept;
+      std::unique_ptr<lock_manager::lease>,
+      log_reader_config,
+      probe&,
+      ss::semaphore* read_buffers = nullptr) noexcept;
 
     ~log_reader() final {
         vassert(!_iterator.reader, "log reader destroyed with live reader");
     }
 
     bool is_end_of_stream() const final {
-        return _iterator.next_seg == _lease->range.end();
+        return _limit_reached || _iterator.next_seg == _lease->range.end();
     }
 
     ss::future<storage_t> do_load_slice(model::timeout_clock::time_point) final;
@@ -146,13 +225,29 @@ public:
         fmt::print(os, "storage::log_reader. config {}", _config);
     }
 
+    /// \brief the reader stopped at a limit of its config (bytes, max offset,
+    /// end of the log) rather than on an error or an abort, and a new read
+    /// can continue from next_offset() with its segment reader and parser
+    bool is_reusable() const {
+        return _iterator.next_seg != _lease->range.end();
+    }
+
+    /// \brief the offset the next read of this reader starts from
+    model::offset next_offset() const { return _config.start_offset; }
+
+    /// \brief drops the abort source subscription of the read that is over;
+    /// the reader is parked until reset_config()
+    void park() { _as_sub = {}; }
+
+    /// \brief continues a reusable reader with the config of a new read,
+    /// which must start at next_offset()
+    void reset_config(log_reader_config);
+
 private:
     void set_end_of_stream() { _iterator.next_seg = _lease->range.end(); }
     bool is_done();
     ss::future<> find_next_valid_iterator();
-
-    using reader_available = ss::bool_class<struct create_reader_tag>;
-    reader_available maybe_create_segment_reader();
+    void subscribe_abort_source();
 
 private:
     struct iterator_pair {
@@ -176,7 +271,10 @@ private:
     std::unique_ptr<lock_manager::lease> _lease;
     iterator_pair _iterator;
     log_reader_config _config;
+    read_buffer_sizer _sizer;
     model::offset _last_base;
+    // the read is over but the reader keeps its position (see is_reusable)
+    bool _limit_reached{false};
     probe& _probe;
     ss::abort_source::subscription _as_sub;
 };
@@ -9,12 +9,14 @@
 
 #include "storage/log_replayer.h"
 
+#include "bytes/utils.h"
 #include "hashing/crc32c.h"
 #include "likely.h"
 #include "model/record.h"
 #include "model/record_utils.h"
 #include "storage/logger.h"
 #include "storage/parser.h"
+#include "storage/recovery_checkpoint.h"
 #include "utils/vint.h"
 #include "vlog.h"
 
@@ -22,23 +24,21 @@
 #include <type_traits>
 
 namespace storage {
-static inline void crc_extend_iobuf(crc32& crc, const iobuf& buf) {
-    auto in = iobuf::iterator_consumer(buf.cbegin(), buf.cend());
-    (void)in.consume(buf.size_bytes(), [&crc](const char* src, size_t sz) {
-        // NOLINTNEXTLINE
-        crc.extend(reinterpret_cast<const uint8_t*>(src), sz);
-        return ss::stop_iteration::no;
-    });
-}
 class checksumming_consumer final : public batch_consumer {
 public:
     static constexpr size_t max_segment_size = static_cast<size_t>(
       std::numeric_limits<uint32_t>::max());
-    checksumming_consumer(segment* s, log_replayer::checkpoint& c)
+    /// replays the batches from \p start_pos, the end of the prefix of the
+    /// segment whose index is restored already
+    checksumming_consumer(
+      segment* s, log_replayer::checkpoint& c, size_t start_pos)
       : _seg(s)
-      , _cfg(c) {
-        // we'll reconstruct the state manually
-        _seg->index().reset();
+      , _cfg(c)
+      , _start_pos(start_pos) {
+        if (_start_pos == 0) {
+            // we'll reconstruct the state manually
+            _seg->index().reset();
+        }
     }
     checksumming_consumer(const checksumming_consumer&) = delete;
     checksumming_consumer& operator=(const checksumming_consumer&) = delete;
@@ -51,7 +51,8 @@ public:
       size_t physical_base_offset,
       size_t size_on_disk) override {
         _header = header;
-        _file_pos_to_end_of_batch = size_on_disk + physical_base_offset;
+        _file_pos_to_end_of_batch = _start_pos + size_on_disk
+                                    + physical_base_offset;
         _crc = crc32();
         model::crc_record_batch_header(_crc, header);
         return skip_batch::no;
@@ -89,6 +90,7 @@ private:
     segment* _seg;
     log_replayer::checkpoint& _cfg;
     crc32 _crc;
+    size_t _start_pos;
     size_t _file_pos_to_end_of_batch{0};
 };
 
@@ -96,9 +98,18 @@ private:
 log_replayer::checkpoint
 log_replayer::recover_in_thread(const ss::io_priority_class& prio) {
     vlog(stlog.debug, "Recovering segment {}", *_seg);
-    // explicitly not using the index to recover the full file
-    auto data_stream = _seg->reader().data_stream(0, prio);
-    auto consumer = std::make_unique<checksumming_consumer>(_seg, _ckpt);
+    // explicitly not using the index to recover the full file, unless a
+    // recovery checkpoint vouches for the prefix it covers
+    size_t start_pos = 0;
+    if (auto ckpt = restore_checkpoint(); ckpt) {
+        vlog(stlog.info, "Recovering {} from {}", *_seg, *ckpt);
+        start_pos = ckpt->file_pos;
+        _ckpt.last_offset = ckpt->last_offset;
+        _ckpt.truncate_file_pos = ckpt->file_pos;
+    }
+    auto data_stream = _seg->reader().data_stream(start_pos, prio);
+    auto consumer = std::make_unique<checksumming_consumer>(
+      _seg, _ckpt, start_pos);
     auto parser = continuous_batch_parser(
       std::move(consumer), std::move(data_stream));
     try {
@@ -115,6 +126,36 @@ log_replayer::recover_in_thread(const ss::io_priority_class& prio) {
     return _ckpt;
 }
 
+std::optional<recovery_checkpoint> log_replayer::restore_checkpoint() {
+    std::optional<recovery_checkpoint> ckpt;
+    try {
+        ckpt = recovery_checkpoint::read(
+                 recovery_checkpoint::path_of(_seg->reader().filename()))
+                 .get0();
+        if (!ckpt || ckpt->file_pos > _seg->reader().file_size()) {
+            return std::nullopt;
+        }
+        const bool restored = _seg->index()
+                                .restore_checkpoint(
+                                  ckpt->last_offset,
+                                  ckpt->max_timestamp,
+                                  ckpt->index_checksum)
+                                .get0();
+        if (restored) {
+            return ckpt;
+        }
+    } catch (...) {
+        vlog(
+          stlog.info,
+          "Error restoring the checkpoint of {}: {}",
+          *_seg,
+          std::current_exception());
+        return std::nullopt;
+    }
+    vlog(stlog.info, "Ignoring stale checkpoint {} of {}", *ckpt, *_seg);
+    return std::nullopt;
+}
+
 std::ostream& operator<<(std::ostream& o, const log_replayer::checkpoint& c) {
     o << "{ last_offset: ";
     if (c.last_offset) {
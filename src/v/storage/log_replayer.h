@@ -13,6 +13,7 @@
 
 #include "model/fundamental.h"
 #include "seastarx.h"
+#include "storage/recovery_checkpoint.h"
 #include "storage/segment.h"
 
 #include <seastar/core/io_queue.hh>
@@ -39,6 +40,9 @@ public:
     checkpoint recover_in_thread(const ss::io_priority_class&);
 
 private:
+    /// the recovery checkpoint of the segment, if its index is restored
+    std::optional<recovery_checkpoint> restore_checkpoint();
+
     checkpoint _ckpt;
     segment* _seg;
 
@@ -49,9 +49,21 @@ struct entries_ordering {
 };
 
 struct mem_probe {
-    void add_bytes_written(size_t sz) { partition_bytes += sz; }
-    void remove_bytes_written(size_t sz) { partition_bytes -= sz; }
+    void add_bytes_written(size_t sz) {
+        partition_bytes += sz;
+        if (budget) {
+            budget->used_bytes += sz;
+        }
+    }
+    void remove_bytes_written(size_t sz) {
+        partition_bytes -= sz;
+        if (budget) {
+            budget->used_bytes -= sz;
+        }
+    }
     size_t partition_bytes{0};
+    // shared by the in-memory logs of the shard, if any
+    ss::lw_shared_ptr<memory_log_budget> budget;
 };
 
 struct mem_log_impl;
@@ -143,9 +155,14 @@ private:
 struct mem_log_impl final : log::impl {
     using underlying_t = std::deque<model::record_batch>;
     // forward ctor
-    explicit mem_log_impl(ntp_config cfg)
-      : log::impl(std::move(cfg)) {}
-    ~mem_log_impl() override = default;
+    explicit mem_log_impl(
+      ntp_config cfg, ss::lw_shared_ptr<memory_log_budget> budget)
+      : log::impl(std::move(cfg)) {
+        _probe.budget = std::move(budget);
+    }
+    ~mem_log_impl() override {
+        _probe.remove_bytes_written(_probe.partition_bytes);
+    }
     mem_log_impl(const mem_log_impl&) = delete;
     mem_log_impl& operator=(const mem_log_impl&) = delete;
     mem_log_impl(mem_log_impl&&) noexcept = default;
@@ -160,6 +177,22 @@ struct mem_log_impl final : log::impl {
     ss::future<> remove() final { return ss::make_ready_future<>(); }
     ss::future<> flush() final { return ss::make_ready_future<>(); }
     ss::future<> compact(compaction_config cfg) final {
+        // the in-memory logs apply the retention of their topic
+        if (config().is_in_memory()) {
+            const auto& o = config().get_overrides();
+            if (o.retention_bytes.is_disabled()) {
+                cfg.max_bytes = std::nullopt;
+            } else if (o.retention_bytes.has_value()) {
+                cfg.max_bytes = o.retention_bytes.value();
+            }
+            if (o.retention_time.is_disabled()) {
+                cfg.eviction_time = model::timestamp::min();
+            } else if (o.retention_time.has_value()) {
+                cfg.eviction_time = model::timestamp(
+                  model::timestamp::now().value()
+                  - o.retention_time.value().count());
+            }
+        }
         return gc(cfg.eviction_time, cfg.max_bytes);
     }
     std::ostream& print(std::ostream& o) const final {
@@ -259,14 +292,24 @@ struct mem_log_impl final : log::impl {
 
             break;
         }
+        notify_eviction(max_offset);
+        if (max_offset > _max_collectible_offset) {
+            return ss::now();
+        }
+        erase_until(max_offset);
+        return ss::now();
+    }
+
+    /// \brief asks raft to let the log collect up to the offset, see
+    /// set_collectible_offset()
+    void notify_eviction(model::offset max_offset) {
         if (_eviction_monitor) {
             _eviction_monitor->promise.set_value(max_offset);
             _eviction_monitor.reset();
         }
-        if (max_offset > _max_collectible_offset) {
-            return ss::now();
-        }
+    }
 
+    void erase_until(model::offset max_offset) {
         auto it = _data.begin();
         while (it != _data.end() && it->last_offset() <= max_offset) {
             _probe.remove_bytes_written(it->size_bytes());
@@ -277,7 +320,30 @@ struct mem_log_impl final : log::impl {
             _data.erase(_data.begin(), it);
             _data.shrink_to_fit();
         }
-        return ss::now();
+    }
+
+    /// \brief evicts the oldest batches of the log for the memory log
+    /// budget, if exceeded, as far as they are collectible. the last batch
+    /// is kept for the offsets of the log
+    void enforce_budget() {
+        auto& budget = _probe.budget;
+        if (!budget || !budget->exceeded() || _data.size() < 2) {
+            return;
+        }
+        const size_t excess = budget->used_bytes - budget->max_bytes;
+        size_t reclaimed = 0;
+        model::offset max_offset;
+        for (auto it = _data.begin(); std::next(it) != _data.end(); ++it) {
+            if (reclaimed >= excess) {
+                break;
+            }
+            max_offset = it->last_offset();
+            reclaimed += it->size_bytes();
+        }
+        const auto before = _probe.partition_bytes;
+        notify_eviction(max_offset);
+        erase_until(std::min(max_offset, _max_collectible_offset));
+        budget->evicted_bytes += before - _probe.partition_bytes;
     }
 
     ss::future<model::offset> monitor_eviction(ss::abort_source& as) final {
@@ -307,6 +373,28 @@ struct mem_log_impl final : log::impl {
         _max_collectible_offset = o;
     }
 
+    // nothing is archived from memory
+    void set_archived_offset(model::offset) final {}
+
+    // the batches of a memory log are not cached
+    void set_batch_cache_policy(batch_cache_policy) final {}
+    ss::future<> warm_batch_cache(size_t, ss::io_priority_class) final {
+        return ss::now();
+    }
+
+    // the memory of a log is not reclaimed by disk usage
+    std::optional<model::timestamp> oldest_reclaimable_segment() const final {
+        return std::nullopt;
+    }
+
+    ss::future<size_t> reclaim_oldest_segment(ss::abort_source&) final {
+        return ss::make_ready_future<size_t>(0);
+    }
+
+    ss::future<scrub_result> scrub(scrub_config) final {
+        return ss::make_ready_future<scrub_result>();
+    }
+
     ss::future<model::record_batch_reader>
     make_reader(log_reader_config cfg) final {
         auto it = std::lower_bound(
@@ -346,6 +434,35 @@ struct mem_log_impl final : log::impl {
 
     size_t segment_count() const final { return 1; }
 
+    storage::log_stats stats() const final {
+        return storage::log_stats{.size_bytes = _probe.partition_bytes};
+    }
+
+    storage::compaction_backlog get_compaction_backlog() const final {
+        return storage::compaction_backlog{};
+    }
+
+    std::optional<model::offset>
+    closed_segment_end(model::offset) const final {
+        return std::nullopt;
+    }
+
+    ss::future<std::optional<segment_files>>
+    open_closed_segment(model::offset) final {
+        return ss::make_ready_future<std::optional<segment_files>>();
+    }
+
+    ss::future<> install_segment(model::offset, model::term_id) final {
+        return ss::make_exception_future<>(std::runtime_error(
+          "in memory logs do not have segments to install"));
+    }
+
+    ss::future<std::optional<model::offset>>
+    find_latest_offset(bytes, ss::io_priority_class) final {
+        return ss::make_exception_future<std::optional<model::offset>>(
+          std::runtime_error("in memory logs do not index keys"));
+    }
+
     storage::offset_stats offsets() const final {
         // default value
         if (_data.empty()) {
@@ -396,6 +513,7 @@ mem_log_appender::operator()(model::record_batch& batch) {
 }
 
 ss::future<append_result> mem_log_appender::end_of_stream() {
+    _log.enforce_budget();
     append_result ret{
       .append_time = ss::lowres_clock::now(),
       .base_offset = _min_offset,
@@ -405,8 +523,9 @@ ss::future<append_result> mem_log_appender::end_of_stream() {
     return ss::make_ready_future<append_result>(ret);
 }
 
-log make_memory_backed_log(ntp_config cfg) {
-    auto ptr = ss::make_shared<mem_log_impl>(std::move(cfg));
+log make_memory_backed_log(
+  ntp_config cfg, ss::lw_shared_ptr<memory_log_budget> budget) {
+    auto ptr = ss::make_shared<mem_log_impl>(std::move(cfg), std::move(budget));
     return storage::log(ptr);
 }
 } // namespace storage
@@ -10,6 +10,7 @@
  */
 
 #pragma once
+#include "model/compression.h"
 #include "model/fundamental.h"
 #include "tristate.h"
 
@@ -33,6 +34,21 @@ public:
         // will be disabled if there is no value set the default will be used
         tristate<size_t> retention_bytes{std::nullopt};
         tristate<std::chrono::milliseconds> retention_time{std::nullopt};
+
+        // if set, the compressed batches of closed segments are
+        // recompressed to this codec during housekeeping
+        std::optional<model::compression> compression;
+
+        // if either is set, the replicas acknowledge appends before they
+        // are flushed, and flush them once the interval passes or that
+        // many bytes were appended. bounds the loss of a crash of a quorum
+        std::optional<std::chrono::milliseconds> flush_ms;
+        std::optional<size_t> flush_bytes;
+
+        // the log is kept in memory only, bounded by its retention and by
+        // the memory log budget of the shard. it is empty after a restart
+        // and recovered from the other replicas
+        bool in_memory{false};
         friend std::ostream&
         operator<<(std::ostream&, const default_overrides&);
     };
@@ -89,6 +105,27 @@ public:
                == model::cleanup_policy_bitflags::deletion;
     }
 
+    /// \brief true if the appends are acknowledged before they are flushed,
+    /// see default_overrides::flush_ms
+    bool has_bounded_loss() const {
+        return _overrides && (_overrides->flush_ms || _overrides->flush_bytes);
+    }
+
+    /// \brief true if the log is kept in memory, see
+    /// default_overrides::in_memory
+    bool is_in_memory() const { return _overrides && _overrides->in_memory; }
+
+    /// \brief the codec the compressed batches of the closed segments are
+    /// recompressed to, if any. Uncompressed batches are left as is
+    std::optional<model::compression> recompression_target() const {
+        if (
+          _overrides && _overrides->compression
+          && *_overrides->compression != model::compression::none) {
+            return _overrides->compression;
+        }
+        return std::nullopt;
+    }
+
     ss::sstring work_directory() const {
         return fmt::format("{}/{}_{}", _base_dir, _ntp.path(), _ntp_id);
     }
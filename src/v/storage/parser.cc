@@ -31,45 +31,53 @@
 namespace storage {
 using stop_parser = batch_consumer::stop_parser;
 using skip_batch = batch_consumer::skip_batch;
+using skip_records = batch_consumer::skip_records;
+
+namespace {
+/// the on disk layout of a record_batch_header, little endian
+struct [[gnu::packed]] packed_header {
+    uint32_t header_crc;
+    int32_t size_bytes;
+    model::offset::type base_offset;
+    model::record_batch_type::type type;
+    int32_t crc;
+    model::record_batch_attributes::type attrs;
+    int32_t last_offset_delta;
+    model::timestamp::type first_timestamp;
+    model::timestamp::type max_timestamp;
+    int64_t producer_id;
+    int16_t producer_epoch;
+    int32_t base_sequence;
+    int32_t record_count;
+};
+static_assert(
+  sizeof(packed_header) == model::packed_record_batch_header_size,
+  "packed_header must match the on disk header");
+} // namespace
 
 model::record_batch_header header_from_iobuf(iobuf b) {
     iobuf_parser parser(std::move(b));
-    auto header_crc = reflection::adl<uint32_t>{}.from(parser);
-    auto sz = reflection::adl<int32_t>{}.from(parser);
-    using offset_t = model::offset::type;
-    auto off = model::offset(reflection::adl<offset_t>{}.from(parser));
-    auto type = reflection::adl<model::record_batch_type>{}.from(parser);
-    auto crc = reflection::adl<int32_t>{}.from(parser);
-    using attr_t = model::record_batch_attributes::type;
-    auto attrs = model::record_batch_attributes(
-      reflection::adl<attr_t>{}.from(parser));
-    auto delta = reflection::adl<int32_t>{}.from(parser);
-    using tmstmp_t = model::timestamp::type;
-    auto first = model::timestamp(reflection::adl<tmstmp_t>{}.from(parser));
-    auto max = model::timestamp(reflection::adl<tmstmp_t>{}.from(parser));
-    auto producer_id = reflection::adl<int64_t>{}.from(parser);
-    auto producer_epoch = reflection::adl<int16_t>{}.from(parser);
-    auto base_sequence = reflection::adl<int32_t>{}.from(parser);
-    auto record_count = reflection::adl<int32_t>{}.from(parser);
+    // copied in a single pass over the fragments, rather than field by field
+    const auto h = parser.consume_type<packed_header>();
     vassert(
       parser.bytes_consumed() == model::packed_record_batch_header_size,
       "Error in header parsing. Must consume:{} bytes, but consumed:{}",
       model::packed_record_batch_header_size,
       parser.bytes_consumed());
     auto hdr = model::record_batch_header{
-      .header_crc = header_crc,
-      .size_bytes = sz,
-      .base_offset = off,
-      .type = type,
-      .crc = crc,
-      .attrs = attrs,
-      .last_offset_delta = delta,
-      .first_timestamp = first,
-      .max_timestamp = max,
-      .producer_id = producer_id,
-      .producer_epoch = producer_epoch,
-      .base_sequence = base_sequence,
-      .record_count = record_count};
+      .header_crc = ss::le_to_cpu(h.header_crc),
+      .size_bytes = ss::le_to_cpu(h.size_bytes),
+      .base_offset = model::offset(ss::le_to_cpu(h.base_offset)),
+      .type = model::record_batch_type(h.type),
+      .crc = ss::le_to_cpu(h.crc),
+      .attrs = model::record_batch_attributes(ss::le_to_cpu(h.attrs)),
+      .last_offset_delta = ss::le_to_cpu(h.last_offset_delta),
+      .first_timestamp = model::timestamp(ss::le_to_cpu(h.first_timestamp)),
+      .max_timestamp = model::timestamp(ss::le_to_cpu(h.max_timestamp)),
+      .producer_id = ss::le_to_cpu(h.producer_id),
+      .producer_epoch = ss::le_to_cpu(h.producer_epoch),
+      .base_sequence = ss::le_to_cpu(h.base_sequence),
+      .record_count = ss::le_to_cpu(h.record_count)};
     hdr.ctx.owner_shard = ss::this_shard_id();
     return hdr;
 }
@@ -92,6 +100,23 @@ static ss::future<result<iobuf>> verify_read_iobuf(
       });
 }
 
+// skips n bytes without reading them into memory
+static ss::future<result<size_t>>
+verify_skip(ss::input_stream<char>& in, size_t n, ss::sstring msg) {
+    return in.skip(n).then([&in, n, msg = std::move(msg)] {
+        // the stream only reaches its end while skipping if it ends short
+        if (likely(!in.eof())) {
+            return result<size_t>(n);
+        }
+        stlog.error(
+          "Cannot continue parsing. stream ended while skipping:{} bytes. "
+          "context:{}",
+          n,
+          msg);
+        return result<size_t>(parser_errc::input_stream_not_enough_bytes);
+    });
+}
+
 ss::future<result<stop_parser>> continuous_batch_parser::consume_header() {
     return read_iobuf_exactly(_input, model::packed_record_batch_header_size)
       .then([this](iobuf b) -> result<iobuf> {
@@ -153,9 +178,8 @@ ss::future<result<stop_parser>> continuous_batch_parser::consume_header() {
               if (unlikely(bool(s))) {
                   auto remaining = _header.size_bytes
                                    - model::packed_record_batch_header_size;
-                  return verify_read_iobuf(
-                           _input, remaining, "parser::skip_batch")
-                    .then([this](result<iobuf> b) {
+                  return verify_skip(_input, remaining, "parser::skip_batch")
+                    .then([this](result<size_t> b) {
                         if (!b) {
                             return ss::make_ready_future<result<stop_parser>>(
                               b.error());
@@ -168,8 +192,14 @@ ss::future<result<stop_parser>> continuous_batch_parser::consume_header() {
               return ss::make_ready_future<result<stop_parser>>(
                 stop_parser::no);
           }
+          if (std::holds_alternative<skip_records>(ret)) {
+              _header_only = bool(std::get<skip_records>(ret));
+              return ss::make_ready_future<result<stop_parser>>(
+                stop_parser::no);
+          }
           auto s = std::get<stop_parser>(ret);
           if (unlikely(bool(s))) {
+              _stopped_mid_batch = true;
               return ss::make_ready_future<result<stop_parser>>(
                 stop_parser::yes);
           }
@@ -185,6 +215,9 @@ ss::future<result<stop_parser>> continuous_batch_parser::consume_one() {
         if (st.value() == stop_parser::yes) {
             return ss::make_ready_future<result<stop_parser>>(st.value());
         }
+        if (_header_only) {
+            return consume_header_only();
+        }
         return consume_records();
     });
 }
@@ -196,6 +229,7 @@ size_t continuous_batch_parser::consumed_batch_bytes() const {
 void continuous_batch_parser::add_bytes_and_reset() {
     _bytes_consumed += consumed_batch_bytes();
     _header = {}; // reset
+    _header_only = false;
 }
 ss::future<result<stop_parser>> continuous_batch_parser::consume_records() {
     auto sz = _header.size_bytes - model::packed_record_batch_header_size;
@@ -209,6 +243,18 @@ ss::future<result<stop_parser>> continuous_batch_parser::consume_records() {
       });
 }
 
+ss::future<result<stop_parser>>
+continuous_batch_parser::consume_header_only() {
+    auto sz = _header.size_bytes - model::packed_record_batch_header_size;
+    return verify_skip(_input, sz, "parser::consume_header_only")
+      .then([this](result<size_t> skipped) -> result<stop_parser> {
+          if (!skipped) {
+              return skipped.error();
+          }
+          return result<stop_parser>(_consumer->consume_batch_end());
+      });
+}
+
 ss::future<result<size_t>> continuous_batch_parser::consume() {
     if (unlikely(_err != parser_errc::none)) {
         return ss::make_ready_future<result<size_t>>(_err);
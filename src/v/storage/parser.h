@@ -39,7 +39,12 @@ public:
     /// it is a public interface indended to signal the internals of the parser
     /// wether to continue or not.
     using stop_parser = ss::bool_class<struct stop_parser_tag>;
-    using consume_result = std::variant<stop_parser, skip_batch>;
+
+    /// \brief the consumer only needs the header of the current batch. the
+    /// records are skipped over in the stream without being read into memory
+    /// and consume_records() is not called before consume_batch_end()
+    using skip_records = ss::bool_class<struct skip_records_tag>;
+    using consume_result = std::variant<stop_parser, skip_batch, skip_records>;
 
     batch_consumer() noexcept = default;
     batch_consumer(const batch_consumer&) = default;
@@ -88,6 +93,13 @@ public:
     /// \brief cleans up async resources like the input stream
     ss::future<> close() { return _input.close(); }
 
+    /// \brief a later consume() continues from where the last one stopped:
+    /// the parser stopped in between two batches, before the end of its input
+    bool is_resumable() const {
+        return _err == parser_errc::none && !_stopped_mid_batch
+               && !_input.eof();
+    }
+
 private:
     /// \brief consumes _one_ full batch.
     ss::future<result<batch_consumer::stop_parser>> consume_one();
@@ -98,6 +110,9 @@ private:
     /// consume the [un]compressed records
     ss::future<result<batch_consumer::stop_parser>> consume_records();
 
+    /// skips over the records of a batch whose consumer needs the header only
+    ss::future<result<batch_consumer::stop_parser>> consume_header_only();
+
     size_t consumed_batch_bytes() const;
     void add_bytes_and_reset();
 
@@ -106,6 +121,10 @@ private:
     ss::input_stream<char> _input;
     model::record_batch_header _header;
     parser_errc _err = parser_errc::none;
+    // the consumer asked for the header of the current batch only
+    bool _header_only{false};
+    // the consumer stopped the parser after the header of a batch
+    bool _stopped_mid_batch{false};
     size_t _bytes_consumed{0};
     size_t _physical_base_offset{0};
 };
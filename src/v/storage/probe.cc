@@ -11,6 +11,8 @@
 
 #include "config/configuration.h"
 #include "prometheus/prometheus_sanitize.h"
+#include "storage/batch_cache.h"
+#include "storage/batch_cache_probe.h"
 
 #include <seastar/core/metrics.hh>
 
@@ -89,6 +91,44 @@ void probe::setup_metrics(const model::ntp& ntp) {
           [this] { return _segment_compacted; },
           sm::description("Number of compacted segments"),
           labels),
+        sm::make_derive(
+          "scrubbed_segments",
+          [this] { return _segments_scrubbed; },
+          sm::description("Number of closed segments read back and verified "
+                          "in the background"),
+          labels),
+        sm::make_total_bytes(
+          "scrubbed_bytes",
+          [this] { return _bytes_scrubbed; },
+          sm::description("Bytes of closed segments read back and verified "
+                          "in the background"),
+          labels),
+        sm::make_derive(
+          "corrupted_segments",
+          [this] { return _corrupted_segments; },
+          sm::description("Number of closed segments found with a batch "
+                          "failing its checksum in the background"),
+          labels),
+        sm::make_derive(
+          "batch_cache_hits",
+          [this] { return _batch_cache_hits; },
+          sm::description("Number of reads served from the batch cache"),
+          labels),
+        sm::make_derive(
+          "batch_cache_misses",
+          [this] { return _batch_cache_misses; },
+          sm::description("Number of reads that missed the batch cache"),
+          labels),
+        sm::make_derive(
+          "readers_cache_hits",
+          [this] { return _readers_cache_hits; },
+          sm::description("Number of reads resuming a parked log reader"),
+          labels),
+        sm::make_derive(
+          "readers_cache_misses",
+          [this] { return _readers_cache_misses; },
+          sm::description("Number of reads creating a new log reader"),
+          labels),
         sm::make_gauge(
           "partition_size",
           [this] { return _partition_bytes; },
@@ -103,4 +143,87 @@ void probe::add_initial_segment(const segment& s) {
 void probe::delete_segment(const segment& s) {
     _partition_bytes -= s.reader().file_size();
 }
+
+void batch_cache_probe::setup_metrics(const batch_cache& cache) {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:batch_cache"),
+      {
+        sm::make_derive(
+          "hits",
+          [this] { return _hits; },
+          sm::description("Number of cache lookups that found a batch")),
+        sm::make_derive(
+          "misses",
+          [this] { return _misses; },
+          sm::description("Number of cache lookups that found no batch")),
+        sm::make_derive(
+          "puts",
+          [this] { return _puts; },
+          sm::description("Number of batches inserted in the cache")),
+        sm::make_derive(
+          "read_ahead_puts",
+          [this] { return _read_ahead_puts; },
+          sm::description("Number of batches inserted by reader read-ahead")),
+        sm::make_total_bytes(
+          "put_bytes",
+          [this] { return _put_bytes; },
+          sm::description("Total number of bytes inserted in the cache")),
+        sm::make_derive(
+          "oversized_skips",
+          [this] { return _oversized_skips; },
+          sm::description("Number of batches too large to be cached")),
+        sm::make_derive(
+          "promotions",
+          [this] { return _promotions; },
+          sm::description("Number of batches promoted to the protected lru")),
+        sm::make_derive(
+          "demotions",
+          [this] { return _demotions; },
+          sm::description("Number of batches demoted to the probationary lru")),
+        sm::make_derive(
+          "evictions",
+          [this] { return _evictions; },
+          sm::description("Number of batches evicted by truncation or close")),
+        sm::make_derive(
+          "reclaims",
+          [this] { return _reclaims; },
+          sm::description("Number of low-memory reclaim passes")),
+        sm::make_derive(
+          "reclaimed_batches",
+          [this] { return _reclaimed_batches; },
+          sm::description("Number of batches released by reclaim")),
+        sm::make_total_bytes(
+          "reclaimed_bytes",
+          [this] { return _reclaimed_bytes; },
+          sm::description("Total number of bytes released by reclaim")),
+        sm::make_derive(
+          "reclaim_skipped_pinned",
+          [this] { return _reclaim_skipped_pinned; },
+          sm::description("Number of pinned batches skipped by reclaim")),
+        sm::make_derive(
+          "reclaim_deferred",
+          [this] { return _reclaim_deferred; },
+          sm::description(
+            "Number of batches whose removal was deferred by a locked index")),
+        sm::make_derive(
+          "reclaim_pressure_upcalls",
+          [this] { return _reclaim_pressure_upcalls; },
+          sm::description(
+            "Number of low-memory upcalls deferred to background reclaim")),
+        sm::make_gauge(
+          "size_bytes",
+          [&cache] { return cache.size_bytes(); },
+          sm::description("Current size of the cache in bytes")),
+        sm::make_gauge(
+          "protected_bytes",
+          [&cache] { return cache.protected_bytes(); },
+          sm::description("Current size of the protected lru in bytes")),
+      });
+}
+
 } // namespace storage
@@ -38,6 +38,12 @@ public:
 
     void segment_compacted() { ++_segment_compacted; }
 
+    void segment_scrubbed(size_t bytes) {
+        ++_segments_scrubbed;
+        _bytes_scrubbed += bytes;
+    }
+    void corrupted_segment() { ++_corrupted_segments; }
+
     void batch_write_error(const std::exception_ptr& e) {
         stlog.error("Error writing record batch {}", e);
         ++_batch_write_errors;
@@ -50,11 +56,19 @@ public:
 
     void batch_parse_error() { ++_batch_parse_errors; }
 
+    void batch_cache_hit() { ++_batch_cache_hits; }
+    void batch_cache_miss() { ++_batch_cache_misses; }
+
+    void readers_cache_hit() { ++_readers_cache_hits; }
+    void readers_cache_miss() { ++_readers_cache_misses; }
+
     void setup_metrics(const model::ntp&);
 
     void delete_segment(const segment&);
 
     size_t partition_size() const { return _partition_bytes; }
+    uint64_t batch_cache_hits() const { return _batch_cache_hits; }
+    uint64_t batch_cache_misses() const { return _batch_cache_misses; }
     void add_initial_segment(const segment&);
     void remove_partition_bytes(size_t remove) { _partition_bytes -= remove; }
 
@@ -68,7 +82,16 @@ private:
     uint64_t _batches_read = 0;
     uint64_t _cached_batches_read = 0;
 
+    uint64_t _batch_cache_hits = 0;
+    uint64_t _batch_cache_misses = 0;
+
+    uint64_t _readers_cache_hits = 0;
+    uint64_t _readers_cache_misses = 0;
+
     uint32_t _segment_compacted = 0;
+    uint64_t _segments_scrubbed = 0;
+    uint64_t _bytes_scrubbed = 0;
+    uint32_t _corrupted_segments = 0;
     uint32_t _corrupted_compaction_index = 0;
     uint32_t _log_segments_created = 0;
     uint32_t _batch_parse_errors = 0;
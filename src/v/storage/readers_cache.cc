@@ -0,0 +1,182 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/readers_cache.h"
+
+#include "storage/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/future-util.hh>
+
+#include <fmt/ostream.h>
+
+#include <algorithm>
+
+namespace storage {
+
+/// parks the reader it wraps once the read is over, instead of closing it
+class readers_cache::cached_reader final
+  : public model::record_batch_reader::impl {
+public:
+    using storage_t = model::record_batch_reader::storage_t;
+
+    cached_reader(
+      readers_cache& cache,
+      std::unique_ptr<log_reader> reader,
+      uint64_t generation) noexcept
+      : _cache(cache)
+      , _reader(std::move(reader))
+      , _generation(generation) {}
+
+    bool is_end_of_stream() const final { return _reader->is_end_of_stream(); }
+
+    ss::future<storage_t>
+    do_load_slice(model::timeout_clock::time_point timeout) final {
+        return _reader->do_load_slice(timeout);
+    }
+
+    ss::future<> finally() noexcept final {
+        return _cache.park(std::move(_reader), _generation);
+    }
+
+    void print(std::ostream& os) final {
+        fmt::print(os, "storage::readers_cache::cached_reader ");
+        _reader->print(os);
+    }
+
+private:
+    readers_cache& _cache;
+    std::unique_ptr<log_reader> _reader;
+    uint64_t _generation;
+};
+
+readers_cache::eviction_guard::eviction_guard(readers_cache& c) noexcept
+  : _cache(&c) {
+    ++_cache->_guards;
+    ++_cache->_generation;
+}
+
+readers_cache::eviction_guard::~eviction_guard() noexcept {
+    if (_cache) {
+        --_cache->_guards;
+        ++_cache->_generation;
+    }
+}
+
+readers_cache::readers_cache(
+  model::ntp ntp, std::chrono::milliseconds eviction_timeout)
+  : _ntp(std::move(ntp))
+  , _eviction_timeout(eviction_timeout) {
+    _eviction_timer.set_callback([this] { evict_expired(); });
+}
+
+std::optional<model::record_batch_reader>
+readers_cache::get_reader(const log_reader_config& cfg) {
+    auto it = std::find_if(
+      _readers.begin(), _readers.end(), [&cfg](const entry& e) {
+          return e.reader->next_offset() == cfg.start_offset;
+      });
+    if (it == _readers.end()) {
+        return std::nullopt;
+    }
+    auto reader = std::move(it->reader);
+    _readers.erase(it);
+    reader->reset_config(cfg);
+    return model::make_record_batch_reader<cached_reader>(
+      *this, std::move(reader), _generation);
+}
+
+model::record_batch_reader
+readers_cache::put(std::unique_ptr<log_reader> reader) {
+    return model::make_record_batch_reader<cached_reader>(
+      *this, std::move(reader), _generation);
+}
+
+ss::future<>
+readers_cache::park(std::unique_ptr<log_reader> reader, uint64_t generation) {
+    if (
+      _gate.is_closed() || _guards > 0 || generation != _generation
+      || !reader->is_reusable()) {
+        return close(std::move(reader));
+    }
+    reader->park();
+    std::vector<entry> evicted;
+    // only one reader is kept per offset, and the oldest one makes room
+    auto it = std::find_if(
+      _readers.begin(), _readers.end(), [&reader](const entry& e) {
+          return e.reader->next_offset() == reader->next_offset();
+      });
+    if (it == _readers.end() && _readers.size() >= max_readers) {
+        it = _readers.begin();
+    }
+    if (it != _readers.end()) {
+        evicted.push_back(std::move(*it));
+        _readers.erase(it);
+    }
+    _readers.push_back(entry{
+      .reader = std::move(reader), .parked_at = ss::lowres_clock::now()});
+    if (!_eviction_timer.armed()) {
+        _eviction_timer.arm(_eviction_timeout);
+    }
+    return close(std::move(evicted));
+}
+
+void readers_cache::evict_expired() {
+    auto deadline = ss::lowres_clock::now() - _eviction_timeout;
+    auto it = std::find_if(
+      _readers.begin(), _readers.end(), [deadline](const entry& e) {
+          return e.parked_at > deadline;
+      });
+    std::vector<entry> expired(
+      std::make_move_iterator(_readers.begin()), std::make_move_iterator(it));
+    _readers.erase(_readers.begin(), it);
+    if (!_readers.empty()) {
+        _eviction_timer.arm(
+          _readers.front().parked_at + _eviction_timeout
+          - ss::lowres_clock::now());
+    }
+    if (expired.empty()) {
+        return;
+    }
+    vlog(stlog.trace, "{} - evicting {} idle readers", _ntp, expired.size());
+    (void)ss::with_gate(_gate, [expired = std::move(expired)]() mutable {
+        return close(std::move(expired));
+    });
+}
+
+ss::future<readers_cache::eviction_guard> readers_cache::evict() {
+    eviction_guard guard(*this);
+    _eviction_timer.cancel();
+    return close(std::exchange(_readers, {}))
+      .then([g = std::move(guard)]() mutable { return std::move(g); });
+}
+
+ss::future<> readers_cache::stop() {
+    _eviction_timer.cancel();
+    return _gate.close().then(
+      [this] { return close(std::exchange(_readers, {})); });
+}
+
+ss::future<> readers_cache::close(std::unique_ptr<log_reader> reader) {
+    auto raw = reader.get();
+    return raw->finally().finally([r = std::move(reader)] {});
+}
+
+ss::future<> readers_cache::close(std::vector<entry> readers) {
+    if (readers.empty()) {
+        return ss::now();
+    }
+    return ss::do_with(std::move(readers), [](std::vector<entry>& readers) {
+        return ss::parallel_for_each(readers, [](entry& e) {
+            return close(std::move(e.reader));
+        });
+    });
+}
+
+} // namespace storage
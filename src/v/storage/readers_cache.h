@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "model/fundamental.h"
+#include "model/record_batch_reader.h"
+#include "seastarx.h"
+#include "storage/log_reader.h"
+#include "storage/types.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/timer.hh>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace storage {
+
+/*
+ * Parks the readers of a log in between sequential reads.
+ *
+ * A reader that stopped at a limit of its read (bytes, max offset, end of the
+ * log) is parked, keyed by the offset its next read starts from. A new read
+ * starting at that offset, typically the next fetch of a consumer tailing the
+ * partition or the next round of a follower recovery, resumes the parked
+ * reader: its segment iterator, segment reader and parser, with the input
+ * stream and its read-ahead, are reused instead of locking the segments,
+ * looking the segment and the index position up and opening a new stream.
+ *
+ * A parked reader holds the read locks of its segments and a copy of the
+ * segment set taken when it was created. The log evicts the parked readers
+ * before operations that take the write lock of a segment or change the
+ * segment set (see eviction_guard). Readers parked for longer than the
+ * eviction timeout are closed in the background.
+ */
+class readers_cache {
+public:
+    static constexpr size_t max_readers = 8;
+
+    /// \brief While alive, readers are not parked. Neither are the readers
+    /// handed out before it was released, as their segment set may be stale.
+    class eviction_guard {
+    public:
+        explicit eviction_guard(readers_cache&) noexcept;
+        eviction_guard(eviction_guard&& o) noexcept
+          : _cache(std::exchange(o._cache, nullptr)) {}
+        eviction_guard& operator=(eviction_guard&&) = delete;
+        eviction_guard(const eviction_guard&) = delete;
+        eviction_guard& operator=(const eviction_guard&) = delete;
+        ~eviction_guard() noexcept;
+
+    private:
+        readers_cache* _cache;
+    };
+
+    readers_cache(model::ntp, std::chrono::milliseconds eviction_timeout);
+
+    /// \brief a parked reader stopped at the start offset of the config,
+    /// continuing with that config
+    std::optional<model::record_batch_reader>
+    get_reader(const log_reader_config&);
+
+    /// \brief wraps a new reader so that it is parked once consumed
+    model::record_batch_reader put(std::unique_ptr<log_reader>);
+
+    /// \brief closes the parked readers; none is parked until the guard is
+    /// released
+    ss::future<eviction_guard> evict();
+
+    ss::future<> stop();
+
+private:
+    class cached_reader;
+    struct entry {
+        std::unique_ptr<log_reader> reader;
+        ss::lowres_clock::time_point parked_at;
+    };
+
+    ss::future<> park(std::unique_ptr<log_reader>, uint64_t generation);
+    void evict_expired();
+    static ss::future<> close(std::unique_ptr<log_reader>);
+    static ss::future<> close(std::vector<entry>);
+
+    model::ntp _ntp;
+    std::chrono::milliseconds _eviction_timeout;
+    // in parking order
+    std::vector<entry> _readers;
+    // bumped by eviction guards, see park()
+    uint64_t _generation{0};
+    size_t _guards{0};
+    ss::timer<ss::lowres_clock> _eviction_timer;
+    ss::gate _gate;
+};
+
+} // namespace storage
@@ -10,12 +10,13 @@
 #include "storage/record_batch_builder.h"
 
 #include "model/record.h"
-#include "model/record_utils.h"
 #include "model/timeout_clock.h"
 #include "storage/parser_utils.h"
 
 #include <seastar/core/smp.hh>
 
+#include <array>
+
 namespace storage {
 
 record_batch_builder::record_batch_builder(
@@ -25,8 +26,39 @@ record_batch_builder::record_batch_builder(
 
 record_batch_builder::~record_batch_builder() {}
 
+record_batch_builder&
+record_batch_builder::add_raw_kv(iobuf&& key, iobuf&& value) {
+    const auto offset_delta = _record_count++;
+    const auto kz = key.size_bytes();
+    const auto vz = value.size_bytes();
+    append_vint(record_size(offset_delta, kz, vz));
+    const auto attrs = model::record_attributes::type(0);
+    // NOLINTNEXTLINE
+    _records.append(reinterpret_cast<const char*>(&attrs), sizeof(attrs));
+    append_vint(0); // timestamp delta
+    append_vint(offset_delta);
+    append_vint(kz);
+    append_bytes(key);
+    append_vint(vz);
+    append_bytes(value);
+    append_vint(0); // headers count
+    return *this;
+}
+
+void record_batch_builder::append_vint(int64_t v) {
+    std::array<uint8_t, vint::max_length> buf;
+    const auto sz = vint::serialize(v, buf.data());
+    // NOLINTNEXTLINE
+    _records.append(reinterpret_cast<const char*>(buf.data()), sz);
+}
+
+void record_batch_builder::append_bytes(const iobuf& b) {
+    for (auto& f : b) {
+        _records.append(f.get(), f.size());
+    }
+}
+
 model::record_batch record_batch_builder::build() && {
-    int32_t offset_delta = 0;
     auto now_ts = model::timestamp::now();
 
     model::record_batch_header header = {
@@ -35,50 +67,31 @@ model::record_batch record_batch_builder::build() && {
       .type = _batch_type,
       .crc = 0, // crc computed later
       .attrs = model::record_batch_attributes{} |= model::compression::none,
-      .last_offset_delta = static_cast<int32_t>(_records.size() - 1),
+      .last_offset_delta = _record_count - 1,
       .first_timestamp = now_ts,
       .max_timestamp = now_ts,
       .producer_id = -1,
       .producer_epoch = -1,
       .base_sequence = -1,
-      .record_count = static_cast<int32_t>(_records.size()),
+      .record_count = _record_count,
       .ctx = model::record_batch_header::context(
         model::term_id(0), ss::this_shard_id())};
 
-    iobuf records;
-    for (auto& sr : _records) {
-        auto rec_sz = record_size(offset_delta, sr);
-        auto kz = sr.key.size_bytes();
-        auto vz = sr.value.size_bytes();
-        auto r = model::record(
-          rec_sz,
-          model::record_attributes{},
-          0,
-          offset_delta,
-          kz,
-          std::move(sr.key),
-          vz,
-          std::move(sr.value),
-          std::vector<model::record_header>{});
-        ++offset_delta;
-        model::append_record_to_buffer(records, r);
-    }
-
-    internal::reset_size_checksum_metadata(header, records);
+    internal::reset_size_checksum_metadata(header, _records);
     return model::record_batch(
-      header, std::move(records), model::record_batch::tag_ctor_ng{});
+      header, std::move(_records), model::record_batch::tag_ctor_ng{});
 }
 
 uint32_t record_batch_builder::record_size(
-  int32_t offset_delta, const serialized_record& r) {
-    return sizeof(model::record_attributes::type)  // attributes
-           + zero_vint_size                        // timestamp delta
-           + vint::vint_size(offset_delta)         // offset_delta
-           + vint::vint_size(r.key.size_bytes())   // key size
-           + r.key.size_bytes()                    // key
-           + vint::vint_size(r.value.size_bytes()) // value size
-           + r.value.size_bytes()                  // value
-           + zero_vint_size;                       // headers size
+  int32_t offset_delta, size_t key_size, size_t value_size) {
+    return sizeof(model::record_attributes::type) // attributes
+           + zero_vint_size                       // timestamp delta
+           + vint::vint_size(offset_delta)        // offset_delta
+           + vint::vint_size(key_size)            // key size
+           + key_size                             // key
+           + vint::vint_size(value_size)          // value size
+           + value_size                           // value
+           + zero_vint_size;                      // headers size
 }
 
 } // namespace storage
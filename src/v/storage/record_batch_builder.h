@@ -16,6 +16,12 @@
 #include "utils/vint.h"
 
 namespace storage {
+/**
+ * Builds a batch of key/value records without compression. The records are
+ * encoded in the wire format as they are added, into the single buffer
+ * which becomes the body of the batch; build() only fills in the header and
+ * its checksums.
+ */
 class record_batch_builder {
 public:
     record_batch_builder(model::record_batch_type, model::offset);
@@ -24,32 +30,29 @@ public:
     record_batch_builder& operator=(record_batch_builder&&) = default;
     record_batch_builder& operator=(const record_batch_builder&) = delete;
 
-    virtual record_batch_builder& add_raw_kv(iobuf&& key, iobuf&& value) {
-        _records.emplace_back(std::move(key), std::move(value));
+    /// reserves the buffer for the records about to be added, in bytes
+    record_batch_builder& reserve(size_t bytes) {
+        _records.reserve_memory(bytes);
         return *this;
     }
+
+    virtual record_batch_builder& add_raw_kv(iobuf&& key, iobuf&& value);
     virtual model::record_batch build() &&;
     virtual ~record_batch_builder();
 
 private:
     static constexpr int64_t zero_vint_size = vint::vint_size(0);
-    struct serialized_record {
-        serialized_record(iobuf k, iobuf v)
-          : key(std::move(k))
-          , value(std::move(v)) {}
-
-        iobuf key;
-        iobuf value;
 
-        uint32_t size_bytes() const {
-            return key.size_bytes() + value.size_bytes();
-        }
-    };
+    static uint32_t
+    record_size(int32_t offset_delta, size_t key_size, size_t value_size);
 
-    uint32_t record_size(int32_t offset_delta, const serialized_record& r);
+    void append_vint(int64_t);
+    void append_bytes(const iobuf&);
 
     model::record_batch_type _batch_type;
     model::offset _base_offset;
-    std::vector<serialized_record> _records;
+    int32_t _record_count{0};
+    /// the records encoded so far, the body of the batch
+    iobuf _records;
 };
 } // namespace storage
@@ -0,0 +1,153 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/recovery_checkpoint.h"
+
+#include "bytes/iobuf_parser.h"
+#include "hashing/xx.h"
+#include "reflection/adl.h"
+#include "storage/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/do_with.hh>
+#include <seastar/core/file.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/seastar.hh>
+
+#include <fmt/ostream.h>
+
+namespace storage {
+
+static constexpr size_t serialized_size = sizeof(int8_t)
+                                          + sizeof(uint64_t) * 2
+                                          + sizeof(model::offset::type)
+                                          + sizeof(model::timestamp::type)
+                                          + sizeof(uint64_t);
+
+static uint64_t checksum_of(const recovery_checkpoint& c) {
+    auto xx = incremental_xxhash64{};
+    xx.update_all(
+      recovery_checkpoint::current_version,
+      c.file_pos,
+      c.last_offset(),
+      c.max_timestamp(),
+      c.index_checksum);
+    return xx.digest();
+}
+
+std::filesystem::path
+recovery_checkpoint::path_of(const ss::sstring& data_file) {
+    return std::filesystem::path(data_file.c_str())
+      .replace_extension("recovery_checkpoint");
+}
+
+iobuf recovery_checkpoint::serialize() const {
+    iobuf out;
+    reflection::serialize(
+      out,
+      current_version,
+      file_pos,
+      last_offset(),
+      max_timestamp(),
+      index_checksum,
+      checksum_of(*this));
+    return out;
+}
+
+std::optional<recovery_checkpoint>
+recovery_checkpoint::deserialize(iobuf b) {
+    if (b.size_bytes() != serialized_size) {
+        return std::nullopt;
+    }
+    iobuf_parser parser(std::move(b));
+    if (reflection::adl<int8_t>{}.from(parser) != current_version) {
+        return std::nullopt;
+    }
+    recovery_checkpoint c;
+    c.file_pos = reflection::adl<uint64_t>{}.from(parser);
+    c.last_offset = model::offset(
+      reflection::adl<model::offset::type>{}.from(parser));
+    c.max_timestamp = model::timestamp(
+      reflection::adl<model::timestamp::type>{}.from(parser));
+    c.index_checksum = reflection::adl<uint64_t>{}.from(parser);
+    if (reflection::adl<uint64_t>{}.from(parser) != checksum_of(c)) {
+        return std::nullopt;
+    }
+    return c;
+}
+
+ss::future<> recovery_checkpoint::write(std::filesystem::path path) const {
+    // written aside and renamed over, so that a torn write leaves the
+    // previous checkpoint in place
+    auto staging = path;
+    staging += ".staging";
+    const auto flags = ss::open_flags::wo | ss::open_flags::create
+                       | ss::open_flags::truncate;
+    return ss::open_file_dma(staging.string(), flags)
+      .then(
+        [](ss::file f) { return ss::make_file_output_stream(std::move(f)); })
+      .then([buf = serialize()](ss::output_stream<char> out) mutable {
+          return ss::do_with(
+            std::move(buf),
+            std::move(out),
+            [](iobuf& buf, ss::output_stream<char>& out) {
+                return ss::do_for_each(
+                         buf,
+                         [&out](const iobuf::fragment& f) {
+                             return out.write(f.get(), f.size());
+                         })
+                  .then([&out] { return out.flush(); })
+                  .then([&out] { return out.close(); });
+            });
+      })
+      .then([staging, path] {
+          return ss::rename_file(staging.string(), path.string());
+      });
+}
+
+ss::future<std::optional<recovery_checkpoint>>
+recovery_checkpoint::read(std::filesystem::path path) {
+    using ret_t = std::optional<recovery_checkpoint>;
+    return ss::file_exists(path.string()).then([path](bool exists) {
+        if (!exists) {
+            return ss::make_ready_future<ret_t>(std::nullopt);
+        }
+        return ss::open_file_dma(path.string(), ss::open_flags::ro)
+          .then([](ss::file f) {
+              return f.size()
+                .then([f](uint64_t size) mutable {
+                    return f.dma_read_bulk<char>(0, size);
+                })
+                .finally([f]() mutable { return f.close(); });
+          })
+          .then([path](ss::temporary_buffer<char> buf) {
+              iobuf b;
+              b.append(std::move(buf));
+              auto c = deserialize(std::move(b));
+              if (!c) {
+                  vlog(stlog.info, "Ignoring invalid checkpoint {}", path);
+              }
+              return c;
+          });
+    });
+}
+
+std::ostream& operator<<(std::ostream& o, const recovery_checkpoint& c) {
+    fmt::print(
+      o,
+      "{{file_pos:{}, last_offset:{}, max_timestamp:{}, index_checksum:{}}}",
+      c.file_pos,
+      c.last_offset,
+      c.max_timestamp,
+      c.index_checksum);
+    return o;
+}
+
+} // namespace storage
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "model/fundamental.h"
+#include "model/timestamp.h"
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/sstring.hh>
+
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <optional>
+
+namespace storage {
+
+/* Fileformat:
+   1 byte  - version
+   8 bytes - file_pos
+   8 bytes - last_offset
+   8 bytes - max_timestamp
+   8 bytes - index_checksum
+   8 bytes - checksum - xxhash64 of the fields above
+ */
+/**
+ * The durable prefix of an active segment, written once the data up to
+ * `file_pos` is flushed and the index covering it is persisted. Recovery
+ * after an unclean shutdown trusts the batches before it, provided the index
+ * on disk is the one whose checksum it records, and only replays the batches
+ * written after it.
+ */
+struct recovery_checkpoint {
+    static constexpr int8_t current_version = 1;
+
+    /// the end of the last batch of the prefix
+    uint64_t file_pos{0};
+    model::offset last_offset;
+    model::timestamp max_timestamp;
+    /// the checksum of the index written before the checkpoint
+    uint64_t index_checksum{0};
+
+    /// the checkpoint of the segment of the data file
+    static std::filesystem::path path_of(const ss::sstring& data_file);
+
+    iobuf serialize() const;
+    static std::optional<recovery_checkpoint> deserialize(iobuf);
+
+    /// replaces the checkpoint at the path
+    ss::future<> write(std::filesystem::path) const;
+    /// none if missing or invalid
+    static ss::future<std::optional<recovery_checkpoint>>
+      read(std::filesystem::path);
+
+    friend std::ostream& operator<<(std::ostream&, const recovery_checkpoint&);
+};
+
+} // namespace storage
@@ -15,6 +15,7 @@
 #include "storage/fs_utils.h"
 #include "storage/logger.h"
 #include "storage/parser_utils.h"
+#include "storage/recovery_checkpoint.h"
 #include "storage/segment_appender_utils.h"
 #include "storage/segment_set.h"
 #include "storage/segment_utils.h"
@@ -33,6 +34,7 @@
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/smp.hh>
 
+#include <algorithm>
 #include <optional>
 #include <stdexcept>
 #include <utility>
@@ -55,9 +57,39 @@ segment::segment(
   , _cache(std::move(c)) {
     if (_appender) {
         _appender->set_callbacks(&_appender_callbacks);
+        // the files of the active segment stay open
+        _reader.pin();
+        _idx.pin();
     }
 }
 
+segment::data_version::~data_version() noexcept {
+    if (!_retired) {
+        return;
+    }
+    try {
+        auto r = ss::make_lw_shared<segment_reader>(std::move(*_retired));
+        (void)r->close()
+          .handle_exception([r](std::exception_ptr e) {
+              vlog(stlog.warn, "error closing replaced file {}: {}", *r, e);
+          })
+          .finally([r] {});
+    } catch (...) {
+        vlog(
+          stlog.error,
+          "leaking replaced segment file: {}",
+          std::current_exception());
+    }
+}
+
+void segment::swap_data(segment_reader r, index_state idx) {
+    _data_version->_retired.emplace(std::exchange(_reader, std::move(r)));
+    _data_version = ss::make_lw_shared<data_version>();
+    _idx.swap_index_state(std::move(idx));
+    force_set_commit_offset_from_index();
+    reset_key_filter();
+}
+
 void segment::check_segment_not_closed(const char* msg) {
     if (unlikely(is_closed())) {
         throw std::runtime_error(fmt::format(
@@ -88,10 +120,60 @@ ss::future<> segment::close() {
     });
 }
 
+static ss::future<>
+remove_recovery_checkpoint(const ss::sstring& data_file) {
+    auto path = recovery_checkpoint::path_of(data_file);
+    return ss::file_exists(path.string()).then([path](bool exists) {
+        if (!exists) {
+            return ss::now();
+        }
+        return ss::remove_file(path.string())
+          .handle_exception([path](const std::exception_ptr& e) {
+              vlog(stlog.warn, "error removing {}: {}", path, e);
+          });
+    });
+}
+
+/// shrinks the file a step at a time, so that the filesystem frees the
+/// extents of a large file over several operations instead of in the unlink
+static ss::future<> truncate_in_steps(ss::sstring name, size_t step) {
+    return ss::open_file_dma(name, ss::open_flags::rw)
+      .then([step](ss::file f) {
+          return f.size()
+            .then([f, step](uint64_t size) mutable {
+                return ss::do_with(size, [f, step](uint64_t& size) mutable {
+                    return ss::do_until(
+                      [&size] { return size == 0; },
+                      [f, step, &size]() mutable {
+                          size -= std::min<uint64_t>(size, step);
+                          return f.truncate(size);
+                      });
+                });
+            })
+            .finally([f]() mutable { return f.close(); });
+      });
+}
+
 ss::future<> segment::remove_tombstones() {
     if (!is_tombstone()) {
         return ss::make_ready_future<>();
     }
+    auto step = config::shard_local_cfg().segment_deletion_truncate_step();
+    auto f = ss::now();
+    if (step && *step > 0) {
+        f = truncate_in_steps(reader().filename(), *step)
+              .handle_exception([this](std::exception_ptr e) {
+                  vlog(
+                    stlog.info,
+                    "error truncating {}: {}",
+                    reader().filename(),
+                    e);
+              });
+    }
+    return f.then([this] { return remove_tombstone_files(); });
+}
+
+ss::future<> segment::remove_tombstone_files() {
     std::vector<std::filesystem::path> rm;
     rm.reserve(3);
     rm.emplace_back(reader().filename().c_str());
@@ -102,14 +184,25 @@ ss::future<> segment::remove_tombstones() {
     }
     vlog(stlog.info, "removing: {}", rm);
     return ss::do_with(
-      std::move(rm), [](const std::vector<std::filesystem::path>& to_remove) {
-          return ss::do_for_each(
-            to_remove, [](const std::filesystem::path& name) {
-                return ss::remove_file(name.c_str())
-                  .handle_exception([name](std::exception_ptr e) {
-                      vlog(stlog.info, "error removing {}: {}", name, e);
-                  });
-            });
+             std::move(rm),
+             [](const std::vector<std::filesystem::path>& to_remove) {
+                 return ss::do_for_each(
+                   to_remove, [](const std::filesystem::path& name) {
+                       return ss::remove_file(name.c_str())
+                         .handle_exception([name](std::exception_ptr e) {
+                             vlog(
+                               stlog.info, "error removing {}: {}", name, e);
+                         });
+                   });
+             })
+      .then([this] { return remove_recovery_checkpoint(reader().filename()); });
+}
+
+ss::future<> remove_compacted_index(const ss::sstring& reader_path) {
+    auto path = internal::compacted_index_path(reader_path.c_str());
+    return ss::remove_file(path.c_str())
+      .handle_exception([path](const std::exception_ptr& e) {
+          vlog(stlog.warn, "error removing compacted index {} - {}", path, e);
       });
 }
 
@@ -139,11 +232,22 @@ ss::future<> segment::do_release_appender(
         std::optional<compacted_index_writer>& compacted_index) {
           return appender->close()
             .then([this] { return _idx.flush(); })
+            .then([this] {
+                _idx.seal();
+                _reader.unpin();
+            })
             .then([&compacted_index] {
                 if (compacted_index) {
                     return compacted_index->close();
                 }
                 return ss::now();
+            })
+            .then([this] {
+                if (!std::exchange(_index_failed, false)) {
+                    return ss::now();
+                }
+                // missing, it is rebuilt before the segment is compacted
+                return remove_compacted_index(_reader.filename());
             });
       });
 }
@@ -168,6 +272,7 @@ ss::future<> segment::release_appender() {
         _destructive_ops.write_unlock();
         return write_lock().then([this](ss::rwlock::holder h) {
             return do_flush()
+              .then([this] { return drain_compaction_index(); })
               .then([this] {
                   auto a = std::exchange(_appender, std::nullopt);
                   auto c
@@ -183,6 +288,7 @@ ss::future<> segment::release_appender() {
     } else {
         return read_lock().then([this](ss::rwlock::holder h) {
             return do_flush()
+              .then([this] { return drain_compaction_index(); })
               .then([this] {
                   auto a = std::exchange(_appender, std::nullopt);
                   auto c
@@ -218,25 +324,87 @@ ss::future<> segment::flush() {
         return do_flush().finally([h = std::move(h)] {});
     });
 }
+ss::future<>
+segment::flush(ss::noncopyable_function<ss::future<>()> durable) {
+    check_segment_not_closed("flush()");
+    return read_lock().then(
+      [this, durable = std::move(durable)](ss::rwlock::holder h) mutable {
+          if (!_appender) {
+              return ss::make_ready_future<>();
+          }
+          auto o = _tracker.dirty_offset;
+          auto fsize = _appender->file_byte_offset();
+          return ss::when_all_succeed(_appender->write_out(), durable())
+            .discard_result()
+            .then([this, o, fsize] {
+                _tracker.committed_offset = o;
+                _tracker.stable_offset = o;
+                _reader.set_file_size(fsize);
+            })
+            .finally([h = std::move(h)] {});
+      });
+}
+
 ss::future<> segment::do_flush() {
     if (!_appender) {
         return ss::make_ready_future<>();
     }
     auto o = _tracker.dirty_offset;
     auto fsize = _appender->file_byte_offset();
-    return _appender->flush().then([this, o, fsize] {
+    // the index tracks the batches as they are appended, so that this is the
+    // max timestamp of the batches up to o
+    auto max_ts = _idx.max_timestamp();
+    return _appender->flush().then([this, o, fsize, max_ts] {
         _tracker.committed_offset = o;
         _tracker.stable_offset = o;
         _reader.set_file_size(fsize);
+        maybe_checkpoint(fsize, o, max_ts);
     });
 }
 
-ss::future<> remove_compacted_index(const ss::sstring& reader_path) {
-    auto path = internal::compacted_index_path(reader_path.c_str());
-    return ss::remove_file(path.c_str())
-      .handle_exception([path](const std::exception_ptr& e) {
-          vlog(stlog.warn, "error removing compacted index {} - {}", path, e);
-      });
+void segment::maybe_checkpoint(
+  size_t file_pos, model::offset last_offset, model::timestamp max_ts) {
+    const auto interval
+      = config::shard_local_cfg().segment_recovery_checkpoint_bytes();
+    if (
+      !interval || *interval == 0 || _checkpointing
+      || file_pos < _checkpoint_pos + *interval || _gate.is_closed()) {
+        return;
+    }
+    _checkpointing = true;
+    (void)ss::with_gate(_gate, [this, file_pos, last_offset, max_ts] {
+        return write_checkpoint(file_pos, last_offset, max_ts)
+          .handle_exception([this](std::exception_ptr e) {
+              vlog(stlog.warn, "Error checkpointing {}: {}", *this, e);
+          })
+          .finally([this] { _checkpointing = false; });
+    });
+}
+
+ss::future<> segment::write_checkpoint(
+  size_t file_pos, model::offset last_offset, model::timestamp max_ts) {
+    return read_lock().then([this,
+                             file_pos,
+                             last_offset,
+                             max_ts,
+                             truncations = _truncations](ss::rwlock::holder h) {
+        if (truncations != _truncations || is_closed() || !_appender) {
+            return ss::now();
+        }
+        // the index on disk covers the prefix, and possibly more batches
+        return _idx.flush()
+          .then([this, file_pos, last_offset, max_ts] {
+              auto ckpt = recovery_checkpoint{
+                .file_pos = file_pos,
+                .last_offset = last_offset,
+                .max_timestamp = max_ts,
+                .index_checksum = _idx.checksum()};
+              return ckpt.write(
+                recovery_checkpoint::path_of(_reader.filename()));
+          })
+          .then([this, file_pos] { _checkpoint_pos = file_pos; })
+          .finally([h = std::move(h)] {});
+    });
 }
 
 ss::future<>
@@ -251,20 +419,27 @@ segment::truncate(model::offset prev_last_offset, size_t physical) {
 
 ss::future<>
 segment::do_truncate(model::offset prev_last_offset, size_t physical) {
+    ++_truncations;
+    _checkpoint_pos = 0;
     _tracker.committed_offset = prev_last_offset;
     _tracker.stable_offset = prev_last_offset;
     _tracker.dirty_offset = prev_last_offset;
     _reader.set_file_size(physical);
     cache_truncate(prev_last_offset + model::offset(1));
-    auto f = ss::now();
+    // the bytes past the truncation point are written again
+    auto f = remove_recovery_checkpoint(_reader.filename());
     if (is_compacted_segment()) {
         // if compaction index is opened close it
         if (_compaction_index) {
-            f = ss::do_with(
-              std::exchange(_compaction_index, std::nullopt),
-              [](std::optional<compacted_index_writer>& c) {
-                  return c->close();
-              });
+            f = f.then([this] { return drain_compaction_index(); });
+            f = f.then([this] {
+                _index_failed = false;
+                return ss::do_with(
+                  std::exchange(_compaction_index, std::nullopt),
+                  [](std::optional<compacted_index_writer>& c) {
+                      return c->close();
+                  });
+            });
         }
         // always remove compaction index when truncating compacted segments
         f = f.then(
@@ -299,7 +474,7 @@ ss::future<bool> segment::materialize_index() {
       _tracker.base_offset == _tracker.dirty_offset,
       "Materializing the index must happen tracking any data. {}",
       *this);
-    return _idx.materialize_index().then([this](bool yn) {
+    return _idx.materialize_index_header().then([this](bool yn) {
         if (yn) {
             _tracker.committed_offset = _idx.max_offset();
             _tracker.stable_offset = _idx.max_offset();
@@ -337,7 +512,70 @@ ss::future<> segment::compaction_index_batch(const model::record_batch& b) {
     });
 }
 
-ss::future<append_result> segment::append(const model::record_batch& b) {
+ss::future<>
+segment::queue_compaction_index_batch(const model::record_batch& b) {
+    if (!has_compaction_index() || _index_failed) {
+        return ss::now();
+    }
+    // a batch larger than the queue waits for the queue to be empty
+    const auto bytes = std::min<size_t>(
+      b.size_bytes(), max_index_queue_bytes);
+    return ss::get_units(_index_queue_bytes, bytes)
+      .then([this, batch = b.copy()](ss::semaphore_units<> u) mutable {
+          _index_queue.push_back(
+            queued_index_batch{std::move(batch), std::move(u)});
+          index_in_background();
+      });
+}
+
+void segment::index_in_background() {
+    if (_indexing_active || _gate.is_closed()) {
+        return;
+    }
+    _indexing_active = true;
+    auto f = ss::with_gate(_gate, [this] {
+        return ss::do_until(
+                 [this] {
+                     // inactive as soon as the queue is seen empty, so that
+                     // the next queued batch starts another pass
+                     _indexing_active = !_index_queue.empty();
+                     return !_indexing_active;
+                 },
+                 [this] {
+                     // the batches queued since the last pass, at once
+                     auto queued = std::exchange(_index_queue, {});
+                     return ss::do_with(
+                       std::move(queued),
+                       [this](std::deque<queued_index_batch>& queued) {
+                           return ss::do_for_each(
+                             queued, [this](queued_index_batch& q) {
+                                 return compaction_index_batch(q.batch);
+                             });
+                       });
+                 })
+          .handle_exception([this](std::exception_ptr e) {
+              vlog(
+                stlog.warn,
+                "Could not index batches of {}, the compaction index is "
+                "rebuilt: {}",
+                *this,
+                e);
+              _index_failed = true;
+              _index_queue.clear();
+              _indexing_active = false;
+          });
+    });
+    _indexing = ss::shared_future<>(std::move(f));
+}
+
+ss::future<> segment::drain_compaction_index() {
+    return ss::do_until(
+      [this] { return !_indexing_active; },
+      [this] { return _indexing->get_future(); });
+}
+
+ss::future<append_result>
+segment::append(const model::record_batch& b, bool cache) {
     check_segment_not_closed("append()");
     vassert(
       b.base_offset() >= _tracker.base_offset,
@@ -362,7 +600,7 @@ ss::future<append_result> segment::append(const model::record_batch& b) {
     const auto start_physical_offset = _appender->file_byte_offset();
     // proxy serialization to segment_appender_utils
     auto write_fut
-      = write(*_appender, b).then([this, &b, start_physical_offset] {
+      = write(*_appender, b).then([this, &b, start_physical_offset, cache] {
             _tracker.dirty_offset = b.last_offset();
             const auto end_physical_offset = _appender->file_byte_offset();
             const auto expected_end_physical = start_physical_offset
@@ -384,10 +622,12 @@ ss::future<append_result> segment::append(const model::record_batch& b) {
               .last_offset = b.last_offset(),
               .byte_size = (size_t)b.size_bytes()};
             // cache always copies the batch
-            cache_put(b);
+            if (cache) {
+                cache_put(b);
+            }
             return ret;
         });
-    auto index_fut = compaction_index_batch(b);
+    auto index_fut = queue_compaction_index_batch(b);
     return ss::when_all(std::move(write_fut), std::move(index_fut))
       .then([](std::tuple<ss::future<append_result>, ss::future<>> p) {
           auto& [append_fut, index_fut] = p;
@@ -415,21 +655,31 @@ ss::future<append_result> segment::append(const model::record_batch& b) {
           return ss::make_exception_future<append_result>(index_err);
       });
 }
-ss::future<append_result> segment::append(model::record_batch&& b) {
-    return ss::do_with(std::move(b), [this](model::record_batch& b) mutable {
-        return append(b);
-    });
+ss::future<append_result>
+segment::append(model::record_batch&& b, bool cache) {
+    return ss::do_with(
+      std::move(b), [this, cache](model::record_batch& b) mutable {
+          return append(b, cache);
+      });
 }
 
 ss::input_stream<char>
 segment::offset_data_stream(model::offset o, ss::io_priority_class iopc) {
+    return offset_data_stream(o, iopc, _reader.buffer_size(), 4);
+}
+
+ss::input_stream<char> segment::offset_data_stream(
+  model::offset o,
+  ss::io_priority_class iopc,
+  size_t buffer_size,
+  unsigned read_ahead) {
     check_segment_not_closed("offset_data_stream()");
     auto nearest = _idx.find_nearest(o);
     size_t position = 0;
     if (nearest) {
         position = nearest->filepos;
     }
-    return _reader.data_stream(position, iopc);
+    return _reader.data_stream(position, iopc, buffer_size, read_ahead);
 }
 
 void segment::advance_stable_offset(size_t offset) {
@@ -511,7 +761,8 @@ ss::future<ss::lw_shared_ptr<segment>> open_segment(
   const std::filesystem::path& path,
   debug_sanitize_files sanitize_fileops,
   std::optional<batch_cache_index> batch_cache,
-  size_t buf_size) {
+  size_t buf_size,
+  segment_file_wrapper wrap_data) {
     auto const meta = segment_path::parse_segment_filename(
       path.filename().string());
     if (!meta || meta->version != record_version_type::v1) {
@@ -532,60 +783,58 @@ ss::future<ss::lw_shared_ptr<segment>> open_segment(
     // preventing x-file synchronization This is fine, because truncation to
     // sealed segments are supposed to be very rare events. The hotpath of
     // truncating the appender, is optimized.
-    return internal::make_reader_handle(path, sanitize_fileops)
-      .then([](ss::file f) {
-          return f.stat().then([f](struct stat s) {
-              return ss::make_ready_future<std::tuple<uint64_t, ss::file>>(
-                std::make_tuple(s.st_size, f));
+    //
+    // the files are opened on first use, see cached_file. the data file may
+    // not exist yet, for a segment being created
+    auto open_data = [path, sanitize_fileops, wrap_data]() {
+        return internal::make_reader_handle(path, sanitize_fileops)
+          .then([wrap_data](ss::file f) {
+              if (wrap_data) {
+                  f = wrap_data(std::move(f));
+              }
+              return f;
           });
+    };
+    auto index_name = std::filesystem::path(path)
+                        .replace_extension("base_index")
+                        .string();
+    auto open_index = [index_name, sanitize_fileops]() {
+        return ss::open_file_dma(
+                 index_name, ss::open_flags::create | ss::open_flags::rw)
+          .then([sanitize_fileops](ss::file fd) {
+              if (sanitize_fileops) {
+                  fd = ss::file(
+                    ss::make_shared(file_io_sanitizer(std::move(fd))));
+              }
+              return fd;
+          });
+    };
+    return ss::file_exists(path.string())
+      .then([path](bool exists) {
+          if (!exists) {
+              return ss::make_ready_future<uint64_t>(0);
+          }
+          return ss::file_size(path.string());
       })
-      .then([buf_size, path](std::tuple<uint64_t, ss::file> t) {
-          auto& [size, fd] = t;
-          return std::make_unique<segment_reader>(
-            path.string(), std::move(fd), size, buf_size);
-      })
-      .then([batch_cache = std::move(batch_cache), meta, sanitize_fileops](
-              std::unique_ptr<segment_reader> rdr) mutable {
-          auto ptr = rdr.get();
-          auto index_name = std::filesystem::path(ptr->filename().c_str())
-                              .replace_extension("base_index")
-                              .string();
-          return ss::open_file_dma(
-                   index_name, ss::open_flags::create | ss::open_flags::rw)
-            .then_wrapped([batch_cache = std::move(batch_cache),
-                           ptr,
-                           sanitize_fileops,
-                           rdr = std::move(rdr),
-                           index_name,
-                           meta](ss::future<ss::file> f) mutable {
-                ss::file fd;
-                try {
-                    fd = f.get0();
-                } catch (...) {
-                    return ptr->close().then(
-                      [rdr = std::move(rdr), e = std::current_exception()] {
-                          return ss::make_exception_future<
-                            ss::lw_shared_ptr<segment>>(e);
-                      });
-                }
-                if (sanitize_fileops) {
-                    fd = ss::file(
-                      ss::make_shared(file_io_sanitizer(std::move(fd))));
-                }
-                auto idx = segment_index(
-                  index_name,
-                  fd,
-                  meta->base_offset,
-                  segment_index::default_data_buffer_step);
-                return ss::make_ready_future<ss::lw_shared_ptr<segment>>(
-                  ss::make_lw_shared<segment>(
-                    segment::offset_tracker(meta->term, meta->base_offset),
-                    std::move(*rdr),
-                    std::move(idx),
-                    std::nullopt,
-                    std::nullopt,
-                    std::move(batch_cache)));
-            });
+      .then([path,
+             buf_size,
+             meta,
+             index_name,
+             batch_cache = std::move(batch_cache),
+             open_data = std::move(open_data),
+             open_index = std::move(open_index)](uint64_t size) mutable {
+          return ss::make_lw_shared<segment>(
+            segment::offset_tracker(meta->term, meta->base_offset),
+            segment_reader(
+              path.string(), std::move(open_data), size, buf_size),
+            segment_index(
+              index_name,
+              std::move(open_index),
+              meta->base_offset,
+              config::shard_local_cfg().segment_index_step()),
+            std::nullopt,
+            std::nullopt,
+            std::move(batch_cache));
       });
 }
 
@@ -597,23 +846,30 @@ ss::future<ss::lw_shared_ptr<segment>> make_segment(
   record_version_type version,
   size_t buf_size,
   debug_sanitize_files sanitize_fileops,
-  std::optional<batch_cache_index> batch_cache) {
+  std::optional<batch_cache_index> batch_cache,
+  segment_file_wrapper wrap_data,
+  size_t fallocation_step) {
     auto path = segment_path::make_segment_path(
       ntpc, base_offset, term, version);
     vlog(stlog.info, "Creating new segment {}", path.string());
     return open_segment(
-             path, sanitize_fileops, std::move(batch_cache), buf_size)
-      .then([path, &ntpc, sanitize_fileops, pc](
+             path,
+             sanitize_fileops,
+             std::move(batch_cache),
+             buf_size,
+             std::move(wrap_data))
+      .then([path, &ntpc, sanitize_fileops, pc, fallocation_step](
               ss::lw_shared_ptr<segment> seg) {
           return with_segment(
             std::move(seg),
-            [path, &ntpc, sanitize_fileops, pc](
+            [path, &ntpc, sanitize_fileops, pc, fallocation_step](
               const ss::lw_shared_ptr<segment>& seg) {
                 return internal::make_segment_appender(
                          path,
                          sanitize_fileops,
                          internal::number_of_chunks_from_config(ntpc),
-                         pc)
+                         pc,
+                         fallocation_step)
                   .then([seg](segment_appender_ptr a) {
                       return ss::make_ready_future<ss::lw_shared_ptr<segment>>(
                         ss::make_lw_shared<segment>(
@@ -13,6 +13,7 @@
 
 #include "storage/batch_cache.h"
 #include "storage/compacted_index_writer.h"
+#include "storage/key_filter.h"
 #include "storage/segment_appender.h"
 #include "storage/segment_index.h"
 #include "storage/segment_reader.h"
@@ -22,8 +23,14 @@
 #include <seastar/core/file.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/core/rwlock.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/util/noncopyable_function.hh>
 
+#include <deque>
 #include <exception>
+#include <functional>
 #include <optional>
 
 namespace storage {
@@ -61,9 +68,34 @@ public:
         finished_self_compaction = 1U << 1U,
         mark_tombstone = 1U << 2U,
         closed = 1U << 3U,
+        finished_recompression = 1U << 4U,
+        finished_coalescing = 1U << 5U,
     };
 
 public:
+    /**
+     * A version of the data file of the segment, pinned by the readers that
+     * stream from it. Compaction swaps in a new version without waiting for
+     * these readers: the file of a replaced version is closed once the last
+     * reader that pinned it is done, and its space reclaimed by the
+     * filesystem then.
+     */
+    class data_version {
+    public:
+        data_version() noexcept = default;
+        data_version(data_version&&) = delete;
+        data_version& operator=(data_version&&) = delete;
+        data_version(const data_version&) = delete;
+        data_version& operator=(const data_version&) = delete;
+        ~data_version() noexcept;
+
+    private:
+        friend segment;
+        /// set once replaced
+        std::optional<segment_reader> _retired;
+    };
+    using data_version_ptr = ss::lw_shared_ptr<data_version>;
+
     segment(
       offset_tracker tracker,
       segment_reader,
@@ -78,8 +110,16 @@ public:
     segment(const segment&) = delete;
     segment& operator=(const segment&) = delete;
 
+    /// bytes of the appended batches a segment queues for its compaction
+    /// index, see queue_compaction_index_batch()
+    static constexpr size_t max_index_queue_bytes = 4_MiB;
+
     ss::future<> close();
     ss::future<> flush();
+    /// \brief as flush(), but the appended batches are made durable by
+    /// `durable`, e.g. a flush of the shared_wal, instead of a sync of the
+    /// segment: they are visible to the readers once it resolves
+    ss::future<> flush(ss::noncopyable_function<ss::future<>()> durable);
     ss::future<> release_appender();
     ss::future<> truncate(model::offset, size_t physical);
 
@@ -87,13 +127,29 @@ public:
     /// auto indexes record_batch
     /// We recommend using the const-ref method below over the r-value since we
     /// do not need to take ownership of the batch itself
-    ss::future<append_result> append(model::record_batch&&);
-    ss::future<append_result> append(const model::record_batch&);
+    ///
+    /// the batch is copied into the cache of the segment, if any, unless
+    /// `cache` is false
+    ss::future<append_result> append(model::record_batch&&, bool cache = true);
+    ss::future<append_result>
+    append(const model::record_batch&, bool cache = true);
+    /// hydrates the offset tracker from the bounds of the index. the index
+    /// entries are loaded on the first read of the segment
     ss::future<bool> materialize_index();
 
     /// main read interface
     ss::input_stream<char>
       offset_data_stream(model::offset, ss::io_priority_class);
+    /// same, with the buffer size and read-ahead depth of the stream
+    ss::input_stream<char> offset_data_stream(
+      model::offset, ss::io_priority_class, size_t, unsigned);
+
+    /// the current version of the data file, to pin along with the streams
+    /// of offset_data_stream()
+    data_version_ptr pin_data() const { return _data_version; }
+    /// \brief swaps in a new data file along with its index, e.g. once
+    /// compacted. the readers of the previous file keep streaming from it.
+    void swap_data(segment_reader, index_state);
 
     const offset_tracker& offsets() const { return _tracker; }
     bool empty() const;
@@ -107,6 +163,13 @@ public:
     bool is_compacted_segment() const;
     void mark_as_finished_self_compaction();
     bool finished_self_compaction() const;
+    /// \brief whether the batches were recompressed to the codec of the
+    /// topic, not persisted: checked again once per segment after a restart
+    void mark_as_finished_recompression();
+    bool finished_recompression() const;
+    /// \brief whether the small batches were coalesced, not persisted either
+    void mark_as_finished_coalescing();
+    bool finished_coalescing() const;
     /// \brief used for compaction, to reset the tracker from index
     void force_set_commit_offset_from_index();
     // low level api's are discouraged and might be deprecated
@@ -120,6 +183,13 @@ public:
     bool has_appender() const;
     compacted_index_writer& compaction_index();
     const compacted_index_writer& compaction_index() const;
+    /// \brief filter of the keys of the compacted index, built on the first
+    /// key lookup of the closed segment, see disk_log_impl::find_latest_offset
+    bool has_key_filter() const { return _key_filter.has_value(); }
+    const key_filter& get_key_filter() const { return *_key_filter; }
+    void set_key_filter(key_filter f) { _key_filter = std::move(f); }
+    /// \brief drops the filter, when compaction rewrites the segment
+    void reset_key_filter() { _key_filter = std::nullopt; }
 
     /** Cache methods */
     batch_cache_index& cache();
@@ -132,7 +202,7 @@ public:
       std::optional<model::timestamp> first_ts,
       size_t max_bytes,
       bool skip_lru_promote);
-    void cache_put(const model::record_batch& batch);
+    void cache_put(const model::record_batch& batch, bool read_ahead = false);
 
     ss::future<ss::rwlock::holder> read_lock(
       ss::semaphore::time_point timeout = ss::semaphore::time_point::max());
@@ -147,13 +217,27 @@ private:
     ss::future<> do_truncate(model::offset prev_last_offset, size_t physical);
     ss::future<> do_close();
     ss::future<> do_flush();
+    /// persists the index and a recovery checkpoint of the flushed prefix, in
+    /// the background, every segment_recovery_checkpoint_bytes
+    void maybe_checkpoint(size_t file_pos, model::offset, model::timestamp);
+    ss::future<>
+    write_checkpoint(size_t file_pos, model::offset, model::timestamp);
     ss::future<> do_release_appender(
       std::optional<segment_appender>,
       std::optional<batch_cache_index>,
       std::optional<compacted_index_writer>);
     ss::future<> remove_tombstones();
+    ss::future<> remove_tombstone_files();
     ss::future<> compaction_index_batch(const model::record_batch&);
     ss::future<> do_compaction_index_batch(const model::record_batch&);
+    /// \brief queues a copy of the appended batch for the compaction index,
+    /// which the keys of its records are added to in the background. waits
+    /// for room in the queue only when indexing falls behind the appends
+    ss::future<> queue_compaction_index_batch(const model::record_batch&);
+    void index_in_background();
+    /// \brief resolves once the queued batches are in the compaction index.
+    /// a barrier before the index is closed, truncated or released
+    ss::future<> drain_compaction_index();
 
     struct appender_callbacks : segment_appender::callbacks {
         explicit appender_callbacks(segment* segment)
@@ -172,19 +256,41 @@ private:
 
     offset_tracker _tracker;
     segment_reader _reader;
+    data_version_ptr _data_version = ss::make_lw_shared<data_version>();
     segment_index _idx;
     bitflags _flags{bitflags::none};
     std::optional<segment_appender> _appender;
     std::optional<compacted_index_writer> _compaction_index;
+    struct queued_index_batch {
+        model::record_batch batch;
+        ss::semaphore_units<> units;
+    };
+    std::deque<queued_index_batch> _index_queue;
+    ss::semaphore _index_queue_bytes{max_index_queue_bytes};
+    std::optional<ss::shared_future<>> _indexing;
+    bool _indexing_active{false};
+    // set when a batch could not be indexed: the index is removed once
+    // released, to be rebuilt by compaction
+    bool _index_failed{false};
+    std::optional<key_filter> _key_filter;
     std::optional<batch_cache_index> _cache;
     ss::rwlock _destructive_ops;
     ss::gate _gate;
+    /// the file position of the last recovery checkpoint
+    size_t _checkpoint_pos{0};
+    bool _checkpointing{false};
+    /// checkpoints taken before a truncation are not written
+    uint64_t _truncations{0};
 
     absl::btree_map<size_t, model::offset> _inflight;
 
     friend std::ostream& operator<<(std::ostream&, const segment&);
 };
 
+/// wraps the data file of a segment being opened, e.g. to fetch its content
+/// on demand
+using segment_file_wrapper = std::function<ss::file(ss::file)>;
+
 /**
  * \brief Create a segment reader for the specified file.
  *
@@ -198,13 +304,14 @@ private:
  *
  * Returns an open segment if the segment was successfully opened.
  * Including a valid index and recovery for the index if one does not
- * exist
+ * exist. The data file is read through wrap_data, if set.
  */
 ss::future<ss::lw_shared_ptr<segment>> open_segment(
   const std::filesystem::path& path,
   debug_sanitize_files sanitize_fileops,
   std::optional<batch_cache_index> batch_cache,
-  size_t buf_size = default_segment_readahead_size);
+  size_t buf_size = default_segment_readahead_size,
+  segment_file_wrapper wrap_data = {});
 
 ss::future<ss::lw_shared_ptr<segment>> make_segment(
   const ntp_config& ntpc,
@@ -214,7 +321,9 @@ ss::future<ss::lw_shared_ptr<segment>> make_segment(
   record_version_type version,
   size_t buf_size,
   debug_sanitize_files sanitize_fileops,
-  std::optional<batch_cache_index> batch_cache);
+  std::optional<batch_cache_index> batch_cache,
+  segment_file_wrapper wrap_data = {},
+  size_t fallocation_step = segment_appender::fallocation_step);
 
 // bitflags operators
 [[gnu::always_inline]] inline segment::bitflags
@@ -274,6 +383,20 @@ inline bool segment::finished_self_compaction() const {
     return (_flags & bitflags::finished_self_compaction)
            == bitflags::finished_self_compaction;
 }
+inline void segment::mark_as_finished_recompression() {
+    _flags |= bitflags::finished_recompression;
+}
+inline bool segment::finished_recompression() const {
+    return (_flags & bitflags::finished_recompression)
+           == bitflags::finished_recompression;
+}
+inline void segment::mark_as_finished_coalescing() {
+    _flags |= bitflags::finished_coalescing;
+}
+inline bool segment::finished_coalescing() const {
+    return (_flags & bitflags::finished_coalescing)
+           == bitflags::finished_coalescing;
+}
 inline batch_cache_index& segment::cache() { return *_cache; }
 inline const batch_cache_index& segment::cache() const { return *_cache; }
 inline bool segment::has_cache() const { return _cache != std::nullopt; }
@@ -297,9 +420,10 @@ inline batch_cache_index::read_result segment::cache_get(
       .next_batch = offset,
     };
 }
-inline void segment::cache_put(const model::record_batch& batch) {
+inline void
+segment::cache_put(const model::record_batch& batch, bool read_ahead) {
     if (likely(bool(_cache))) {
-        _cache->put(batch);
+        _cache->put(batch, read_ahead);
     }
 }
 inline ss::future<ss::rwlock::holder>
@@ -10,9 +10,11 @@
 #include "storage/segment_appender.h"
 
 #include "config/configuration.h"
+#include "finjector/latency_probe.h"
 #include "likely.h"
 #include "storage/chunk_cache.h"
 #include "storage/logger.h"
+#include "storage/write_behind_controller.h"
 #include "vassert.h"
 #include "vlog.h"
 
@@ -23,8 +25,12 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+
 namespace storage {
 
+using write_behind_clock = internal::write_behind_controller::clock_type;
+
 [[gnu::cold]] static ss::future<>
 size_missmatch_error(const char* ctx, size_t expected, size_t got) {
     return ss::make_exception_future<>(fmt::format(
@@ -35,6 +41,12 @@ segment_appender::segment_appender(ss::file f, options opts)
   : _out(std::move(f))
   , _opts(opts)
   , _concurrent_flushes(ss::semaphore::max_counter())
+  , _write_depth(std::clamp(
+      internal::write_behind().depth(),
+      internal::write_behind_controller::min_depth,
+      std::max(_opts.number_of_chunks, size_t(1))))
+  , _write_slots(_write_depth)
+  , _falloc_step(_opts.falloc_step)
   , _inactive_timer([this] { handle_inactive_timer(); }) {
     const auto alignment = _out.disk_write_dma_alignment();
     vassert(
@@ -63,6 +75,10 @@ segment_appender::segment_appender(segment_appender&& o) noexcept
   , _fallocation_offset(o._fallocation_offset)
   , _bytes_flush_pending(o._bytes_flush_pending)
   , _concurrent_flushes(std::move(o._concurrent_flushes))
+  , _write_depth(o._write_depth)
+  , _write_slots(std::move(o._write_slots))
+  , _falloc_step(o._falloc_step)
+  , _last_fallocation(o._last_fallocation)
   , _head(std::move(o._head))
   , _inflight(std::move(o._inflight))
   , _callbacks(std::exchange(o._callbacks, nullptr))
@@ -79,10 +95,82 @@ ss::future<> segment_appender::append(bytes_view s) {
 ss::future<> segment_appender::append(const iobuf& io) {
     return ss::do_for_each(
       io.begin(), io.end(), [this](const iobuf::fragment& f) {
-          return append(f.get(), f.size());
+          const char* buf = f.get();
+          const size_t n = f.size();
+          const size_t direct = direct_write_size(buf, n);
+          if (direct == 0) {
+              return append(buf, n);
+          }
+          return write_direct(buf, direct).then([this, buf, n, direct] {
+              return n == direct ? ss::now() : append(buf + direct, n - direct);
+          });
       });
 }
 
+size_t segment_appender::direct_write_size(const char* buf, size_t n) const {
+    /*
+     * a fragment is written in place when the chunks hold no pending bytes,
+     * so that nothing is written before it, and when both the fragment and
+     * the end of the file are aligned, as dma requires. its unaligned tail
+     * goes through the chunks as usual.
+     */
+    if (
+      n < min_direct_write || _closed || _previously_inactive
+      || _bytes_flush_pending > 0) {
+        return 0;
+    }
+    const size_t alignment = _out.disk_write_dma_alignment();
+    // NOLINTNEXTLINE
+    const auto addr = reinterpret_cast<uintptr_t>(buf);
+    if (
+      _committed_offset % alignment != 0
+      || addr % _out.memory_dma_alignment() != 0 || addr % alignment != 0) {
+        return 0;
+    }
+    const size_t sz = ss::align_down<size_t>(n, alignment);
+    return sz >= min_direct_write ? sz : 0;
+}
+
+ss::future<> segment_appender::write_direct(const char* buf, size_t n) {
+    _inactive_timer.cancel();
+    if (_committed_offset + n > _fallocation_offset) {
+        return do_next_adaptive_fallocation().then(
+          [this, buf, n] { return write_direct(buf, n); });
+    }
+    update_write_depth();
+    // the slot is held until the write completes, as for a chunk
+    return _write_slots.wait(1).then([this, buf, n] {
+        const size_t start_offset = _committed_offset;
+        _committed_offset += n;
+        _inflight.emplace_back(
+          ss::make_lw_shared<inflight_write>(_committed_offset));
+        auto w = _inflight.back();
+        internal::write_behind().write_dispatched();
+        const auto dispatched = write_behind_clock::now();
+        return ss::with_semaphore(
+                 _concurrent_flushes,
+                 1,
+                 [this, w, start_offset, buf, n, dispatched] {
+                     return _out
+                       .dma_write(start_offset, buf, n, _opts.priority)
+                       .then([this, w, n, dispatched](size_t got) {
+                           internal::write_behind().write_completed(
+                             write_behind_clock::now() - dispatched);
+                           _write_slots.signal(1);
+                           if (unlikely(n != got)) {
+                               return size_missmatch_error(
+                                 "direct::write", n, got);
+                           }
+                           maybe_advance_stable_offset(w);
+                           return ss::make_ready_future<>();
+                       });
+                 })
+          .handle_exception([this](std::exception_ptr e) {
+              vassert(false, "Could not dma_write: {} - {}", e, *this);
+          });
+    });
+}
+
 ss::future<> segment_appender::append(const char* buf, const size_t n) {
     // seastar is optimized for timers that never fire. here the timer is
     // cancelled because it firing may dispatch a background write, which as
@@ -150,19 +238,48 @@ ss::future<> segment_appender::do_append(const char* buf, const size_t n) {
         return ss::make_ready_future<>();
     }
 
-    return ss::get_units(_concurrent_flushes, 1)
-      .then([this, next_buf = buf + written, next_sz = n - written](
+    /*
+     * wait for a new head chunk. the appender may not have more chunk writes
+     * in flight than the write behind depth allows, and the chunk cache may
+     * be out of chunks.
+     */
+    update_write_depth();
+    const auto wait_start = write_behind_clock::now();
+    return _write_slots.wait(1)
+      .then([this] {
+          // do not hold the slot, it is taken once the chunk is dispatched
+          _write_slots.signal(1);
+          return ss::get_units(_concurrent_flushes, 1);
+      })
+      .then([this, next_buf = buf + written, next_sz = n - written, wait_start](
               ss::semaphore_units<>) {
           // do not hold the units!
           return internal::chunks().get().then(
-            [this, next_buf, next_sz](ss::lw_shared_ptr<chunk> chunk) {
+            [this, next_buf, next_sz, wait_start](
+              ss::lw_shared_ptr<chunk> chunk) {
                 vassert(!_head, "cannot overwrite existing chunk");
                 _head = std::move(chunk);
+                internal::write_behind().head_chunk_wait(
+                  write_behind_clock::now() - wait_start);
                 return do_append(next_buf, next_sz);
             });
       });
 }
 
+void segment_appender::update_write_depth() {
+    const auto depth = std::clamp(
+      internal::write_behind().depth(),
+      internal::write_behind_controller::min_depth,
+      std::max(_opts.number_of_chunks, size_t(1)));
+    if (depth > _write_depth) {
+        _write_slots.signal(depth - _write_depth);
+    } else if (depth < _write_depth) {
+        // may leave the semaphore negative until writes in flight complete
+        _write_slots.consume(_write_depth - depth);
+    }
+    _write_depth = depth;
+}
+
 void segment_appender::handle_inactive_timer() {
     _previously_inactive = true;
 
@@ -299,7 +416,7 @@ ss::future<> segment_appender::do_next_adaptive_fallocation() {
                  // step - compute step rounded to 4096; this is needed because
                  // during a truncation the follow up fallocation might not be
                  // page aligned
-                 auto step = _opts.falloc_step;
+                 auto step = next_fallocation_step();
                  if (_fallocation_offset % 4096 != 0) {
                      // add left over bytes to a full page
                      step += 4096 - (_fallocation_offset % 4096);
@@ -324,6 +441,24 @@ ss::future<> segment_appender::do_next_adaptive_fallocation() {
       });
 }
 
+size_t segment_appender::next_fallocation_step() {
+    /*
+     * segments that are appended to quickly fallocate in bigger steps, which
+     * keeps the number of fallocations, which stall appends, low on fast
+     * devices. the space allocated past the end is released on close.
+     */
+    const auto now = ss::lowres_clock::now();
+    if (_fallocation_offset > 0) {
+        if (now - _last_fallocation < fast_fallocation_interval) {
+            _falloc_step = std::min(_falloc_step * 2, max_fallocation_step);
+        } else {
+            _falloc_step = std::max(_falloc_step / 2, _opts.falloc_step);
+        }
+    }
+    _last_fallocation = now;
+    return _falloc_step;
+}
+
 void segment_appender::maybe_advance_stable_offset(
   const ss::lw_shared_ptr<inflight_write>& write) {
     /*
@@ -383,12 +518,18 @@ void segment_appender::dispatch_background_head_write() {
     _inflight.emplace_back(
       ss::make_lw_shared<inflight_write>(_committed_offset));
     auto w = _inflight.back();
+    _write_slots.consume(1);
+    internal::write_behind().write_dispatched();
+    const auto dispatched = write_behind_clock::now();
     (void)ss::with_semaphore(
       _concurrent_flushes,
       1,
-      [h, w, this, start_offset, expected, src] {
+      [h, w, this, start_offset, expected, src, dispatched] {
           return _out.dma_write(start_offset, src, expected, _opts.priority)
-            .then([this, h, w, expected](size_t got) {
+            .then([this, h, w, expected, dispatched](size_t got) {
+                internal::write_behind().write_completed(
+                  write_behind_clock::now() - dispatched);
+                _write_slots.signal(1);
                 if (h->is_full()) {
                     h->reset();
                 }
@@ -417,15 +558,39 @@ ss::future<> segment_appender::flush() {
     return ss::with_semaphore(
              _concurrent_flushes,
              ss::semaphore::max_counter(),
-             [this]() mutable { return _out.flush(); })
+             [this]() mutable {
+                 using point = finjector::latency_probe::point;
+                 auto& latency = finjector::shard_local_latency_probe();
+                 if (unlikely(latency.is_delayed(point::segment_flush))) {
+                     return latency.delay(point::segment_flush).then([this] {
+                         return _out.flush();
+                     });
+                 }
+                 return _out.flush();
+             })
       .handle_exception([this](std::exception_ptr e) {
           vassert(false, "Could not flush: {} - {}", e, *this);
       });
 }
 
+ss::future<> segment_appender::write_out() {
+    _inactive_timer.cancel();
+    if (_head && _head->bytes_pending()) {
+        dispatch_background_head_write();
+    }
+    // the writes in flight are done once all the units are returned
+    return ss::get_units(_concurrent_flushes, ss::semaphore::max_counter())
+      .discard_result()
+      .handle_exception([this](std::exception_ptr e) {
+          vassert(false, "Could not write out: {} - {}", e, *this);
+      });
+}
+
 std::ostream& operator<<(std::ostream& o, const segment_appender& a) {
     // NOTE: intrusivelist.size() == O(N) but often N is very small, ~8
     return o << "{no_of_chunks:" << a._opts.number_of_chunks
+             << ", write_depth:" << a._write_depth
+             << ", falloc_step:" << a._falloc_step
              << ", closed:" << a._closed
              << ", fallocation_offset:" << a._fallocation_offset
              << ", committed_offset:" << a._committed_offset
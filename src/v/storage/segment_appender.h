@@ -23,6 +23,7 @@
 #include <seastar/core/iostream.hh>
 #include <seastar/core/sstring.hh>
 
+#include <chrono>
 #include <iostream>
 
 namespace storage {
@@ -40,6 +41,11 @@ public:
                                                      / chunk::chunk_size;
     static constexpr const size_t chunk_size = chunk::chunk_size;
     static constexpr const size_t fallocation_step = 32_MiB;
+    static constexpr const size_t max_fallocation_step = 128_MiB;
+    // an fallocation consumed faster than this doubles the next step
+    static constexpr const std::chrono::seconds fast_fallocation_interval{1};
+    // aligned runs of iobuf fragments from this size are written in place
+    static constexpr const size_t min_direct_write = chunk_size;
 
     struct options {
         options(ss::io_priority_class p, size_t chunks_no)
@@ -51,7 +57,9 @@ public:
           , falloc_step(step) {}
 
         ss::io_priority_class priority;
+        // upper bound of the adaptive write behind depth
         size_t number_of_chunks{chunks_no_buffer};
+        // lower bound of the adaptive fallocation step
         size_t falloc_step{fallocation_step};
     };
 
@@ -69,10 +77,15 @@ public:
 
     ss::future<> append(const char* buf, const size_t n);
     ss::future<> append(bytes_view s);
+    /// \brief the fragments which are aligned like the end of the file are
+    /// written from the iobuf without copying them to the chunks, and the
+    /// returned future waits for their write: the iobuf must outlive it
     ss::future<> append(const iobuf& io);
     ss::future<> truncate(size_t n);
     ss::future<> close();
     ss::future<> flush();
+    /// \brief as flush(), without making the writes durable
+    ss::future<> write_out();
 
     struct callbacks {
         virtual void committed_physical_offset(size_t) = 0;
@@ -82,10 +95,14 @@ public:
 
 private:
     void dispatch_background_head_write();
+    void update_write_depth();
+    size_t next_fallocation_step();
     ss::future<> do_next_adaptive_fallocation();
     ss::future<> hydrate_last_half_page();
     ss::future<> do_truncation(size_t);
     ss::future<> do_append(const char* buf, const size_t n);
+    size_t direct_write_size(const char* buf, size_t n) const;
+    ss::future<> write_direct(const char* buf, size_t n);
 
     /*
      * committed offset isn't updated until the background write is dispatched.
@@ -108,6 +125,12 @@ private:
     size_t _fallocation_offset{0};
     size_t _bytes_flush_pending{0};
     ss::semaphore _concurrent_flushes;
+    // chunk writes the appender may still dispatch before it has to wait for
+    // one to complete, see internal::write_behind_controller
+    size_t _write_depth;
+    ss::semaphore _write_slots;
+    size_t _falloc_step;
+    ss::lowres_clock::time_point _last_fallocation;
     ss::lw_shared_ptr<chunk> _head;
 
     struct inflight_write {
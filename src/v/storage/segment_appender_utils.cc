@@ -9,6 +9,7 @@
 
 #include "storage/segment_appender_utils.h"
 
+#include "finjector/latency_probe.h"
 #include "model/record.h"
 #include "model/timestamp.h"
 #include "reflection/adl.h"
@@ -53,8 +54,8 @@ static iobuf disk_header_to_iobuf(const model::record_batch_header& h) {
     return b;
 }
 
-ss::future<>
-write(segment_appender& appender, const model::record_batch& batch) {
+static ss::future<>
+do_write(segment_appender& appender, const model::record_batch& batch) {
     auto hdrbuf = std::make_unique<iobuf>(disk_header_to_iobuf(batch.header()));
     auto ptr = hdrbuf.get();
     return appender.append(*ptr).then(
@@ -63,4 +64,15 @@ write(segment_appender& appender, const model::record_batch& batch) {
       });
 }
 
+ss::future<>
+write(segment_appender& appender, const model::record_batch& batch) {
+    using point = finjector::latency_probe::point;
+    auto& latency = finjector::shard_local_latency_probe();
+    if (unlikely(latency.is_delayed(point::segment_append))) {
+        return latency.delay(point::segment_append)
+          .then([&appender, &batch] { return do_write(appender, batch); });
+    }
+    return do_write(appender, batch);
+}
+
 } // namespace storage
@@ -9,9 +9,13 @@
 
 #include "storage/segment_index.h"
 
+#include "config/configuration.h"
+#include "likely.h"
 #include "model/timestamp.h"
+#include "storage/index_search.h"
 #include "storage/logger.h"
 #include "vassert.h"
+#include "vlog.h"
 
 #include <seastar/core/fstream.hh>
 #include <seastar/core/iostream.hh>
@@ -21,6 +25,7 @@
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <limits>
 
 namespace storage {
 
@@ -34,29 +39,109 @@ static inline segment_index::entry translate_index_entry(
     };
 }
 
+/*
+ * Lazily loaded indices whose entries are resident on this shard, in least
+ * recently used order.
+ */
+struct segment_index::resident_lru {
+    intrusive_list<segment_index, &segment_index::_resident_hook> indices;
+    size_t size{0};
+
+    static resident_lru& get() {
+        static thread_local resident_lru lru;
+        return lru;
+    }
+
+    void touch(segment_index& idx) {
+        idx._resident_hook.unlink();
+        indices.push_back(idx);
+    }
+
+    void insert(segment_index& idx) {
+        indices.push_back(idx);
+        ++size;
+        trim(idx);
+    }
+
+    void erase(segment_index& idx) {
+        if (idx._resident_hook.is_linked()) {
+            idx._resident_hook.unlink();
+            --size;
+        }
+    }
+
+    /*
+     * release the least recently used indices over the limit. indices with
+     * unflushed changes are skipped since their entries cannot be loaded
+     * again from disk, and so is the index that was just loaded.
+     */
+    void trim(const segment_index& loaded) {
+        const size_t max
+          = config::shard_local_cfg().max_resident_segment_indices();
+        for (auto it = indices.begin(); size > max && it != indices.end();) {
+            auto& idx = *it++;
+            if (&idx == &loaded || idx._needs_persistence) {
+                continue;
+            }
+            erase(idx);
+            idx.release_entries();
+        }
+    }
+};
+
 segment_index::segment_index(
   ss::sstring filename, ss::file f, model::offset base, size_t step)
   : _name(std::move(filename))
-  , _out(std::move(f))
+  , _out(ss::make_lw_shared<cached_file>(_name, std::move(f)))
+  , _step(step) {
+    _state.base_offset = base;
+}
+
+segment_index::segment_index(
+  ss::sstring filename,
+  cached_file::opener open,
+  model::offset base,
+  size_t step)
+  : _name(std::move(filename))
+  , _out(ss::make_lw_shared<cached_file>(_name, std::move(open)))
   , _step(step) {
     _state.base_offset = base;
 }
 
+segment_index::~segment_index() noexcept { resident_lru::get().erase(*this); }
+
 void segment_index::reset() {
     auto base = _state.base_offset;
     _state = {};
     _state.base_offset = base;
     _acc = 0;
+    _loaded = true;
+    resident_lru::get().erase(*this);
 }
 
 void segment_index::swap_index_state(index_state&& o) {
     _needs_persistence = true;
     _acc = 0;
     std::swap(_state, o);
+    if (!_loaded) {
+        // the new entries are persisted by the next flush, after which they
+        // may be released like those of any other lazily loaded index
+        _loaded = true;
+        resident_lru::get().insert(*this);
+    }
+}
+
+void segment_index::seal() {
+    _out->unpin();
+    _state.shrink_to_fit();
+    if (_loaded && !_resident_hook.is_linked()) {
+        resident_lru::get().insert(*this);
+    }
 }
 
 void segment_index::maybe_track(
   const model::record_batch_header& hdr, size_t filepos) {
+    vassert(_loaded, "cannot track batches in an unloaded index: {}", *this);
     _acc += hdr.size_bytes;
     if (_state.maybe_index(
           _acc,
@@ -72,24 +157,36 @@ void segment_index::maybe_track(
 }
 
 std::optional<segment_index::entry>
-segment_index::find_nearest(model::timestamp t) {
-    if (t < _state.base_timestamp) {
+segment_index::find_nearest_position(size_t filepos) {
+    if (_state.empty()) {
         return std::nullopt;
     }
-    if (_state.empty()) {
+    const auto needle = static_cast<uint32_t>(
+      std::min<size_t>(filepos, std::numeric_limits<uint32_t>::max()));
+    const auto pos = details::index_upper_bound(_state.position_index, needle);
+    if (pos == 0) {
         return std::nullopt;
     }
-    const uint32_t i = t() - _state.base_timestamp();
-    auto it = std::lower_bound(
-      std::begin(_state.relative_time_index),
-      std::end(_state.relative_time_index),
-      i,
-      std::less<uint32_t>{});
-    if (it == _state.relative_offset_index.end()) {
+    return translate_index_entry(_state, _state.get_entry(pos - 1));
+}
+
+std::optional<segment_index::entry>
+segment_index::find_nearest(model::timestamp t) {
+    if (
+      _state.empty() || !_state.has_monotonic_time_index()
+      || t <= _state.base_timestamp) {
+        return std::nullopt;
+    }
+    const auto needle = static_cast<uint32_t>(std::min<int64_t>(
+      t() - _state.base_timestamp(), std::numeric_limits<uint32_t>::max()));
+    // the first entry whose running max timestamp reaches the needle. all the
+    // batches up to the entry before it are older than the needle
+    const auto pos = details::index_lower_bound(
+      _state.relative_time_index, needle);
+    if (pos == 0) {
         return std::nullopt;
     }
-    auto dist = std::distance(_state.relative_offset_index.begin(), it);
-    return translate_index_entry(_state, _state.get_entry(dist));
+    return translate_index_entry(_state, _state.get_entry(pos - 1));
 }
 
 std::optional<segment_index::entry>
@@ -98,29 +195,22 @@ segment_index::find_nearest(model::offset o) {
         return std::nullopt;
     }
     const uint32_t needle = o() - _state.base_offset();
-    auto it = std::lower_bound(
-      std::begin(_state.relative_offset_index),
-      std::end(_state.relative_offset_index),
-      needle,
-      std::less<uint32_t>{});
-    if (it == _state.relative_offset_index.end()) {
-        it = std::prev(it);
-    }
-    // make it signed so it can be negative
-    int i = std::distance(_state.relative_offset_index.begin(), it);
-    do {
-        if (_state.relative_offset_index[i] <= needle) {
-            return translate_index_entry(_state, _state.get_entry(i));
-        }
-    } while (i-- > 0);
-
-    return std::nullopt;
+    // the nearest entry is the last one at or below the needle
+    const auto pos = details::index_upper_bound(
+      _state.relative_offset_index, needle);
+    if (pos == 0) {
+        return std::nullopt;
+    }
+    return translate_index_entry(_state, _state.get_entry(pos - 1));
 }
 
 ss::future<> segment_index::truncate(model::offset o) {
     if (o < _state.base_offset) {
         return ss::now();
     }
+    if (unlikely(!_loaded)) {
+        return ensure_loaded().then([this, o] { return truncate(o); });
+    }
     const uint32_t i = o() - _state.base_offset();
     auto it = std::lower_bound(
       std::begin(_state.relative_offset_index),
@@ -147,29 +237,131 @@ ss::future<> segment_index::truncate(model::offset o) {
     return flush();
 }
 
-ss::future<bool> segment_index::materialize_index() {
-    return _out.size()
-      .then([this](uint64_t size) mutable {
-          return _out.dma_read_bulk<char>(0, size);
+ss::future<std::optional<index_state>> segment_index::read_index_state() {
+    return _out
+      ->with_file([](ss::file f) {
+          return f.size().then([f](uint64_t size) mutable {
+              return f.dma_read_bulk<char>(0, size);
+          });
       })
-      .then([this](ss::temporary_buffer<char> buf) {
+      .then([](ss::temporary_buffer<char> buf) -> std::optional<index_state> {
           if (buf.empty()) {
-              return false;
+              return std::nullopt;
           }
           iobuf b;
           b.append(std::move(buf));
-          auto hydrated = index_state::hydrate_from_buffer(std::move(b));
-          if (!hydrated) {
+          return index_state::hydrate_from_buffer(std::move(b));
+      });
+}
+
+ss::future<bool> segment_index::restore_checkpoint(
+  model::offset last_offset,
+  model::timestamp max_timestamp,
+  uint64_t checksum) {
+    return read_index_state().then(
+      [this, last_offset, max_timestamp, checksum](
+        std::optional<index_state> st) {
+          if (
+            !st || st->checksum != checksum
+            || st->base_offset != _state.base_offset
+            || st->max_offset < last_offset) {
               return false;
           }
-          _state = std::move(hydrated.value());
+          while (!st->empty()
+                 && st->base_offset() + st->relative_offset_index.back()
+                      > last_offset()) {
+              st->pop_back();
+          }
+          st->max_offset = last_offset;
+          st->max_timestamp = max_timestamp;
+          swap_index_state(std::move(*st));
           return true;
       });
 }
 
+ss::future<bool> segment_index::materialize_index() {
+    return read_index_state().then([this](std::optional<index_state> st) {
+        if (!st) {
+            return false;
+        }
+        _state = std::move(st.value());
+        _loaded = true;
+        return true;
+    });
+}
+
+ss::future<bool> segment_index::materialize_index_header() {
+    return _out->with_file([this](ss::file f) {
+        return f.size().then([this, f](uint64_t size) mutable {
+            if (size < index_state::serialized_header_size) {
+                return ss::make_ready_future<bool>(false);
+            }
+            return f
+              .dma_read_bulk<char>(0, index_state::serialized_header_size)
+              .then([this, size](ss::temporary_buffer<char> buf) {
+                  iobuf b;
+                  b.append(std::move(buf));
+                  auto hydrated = index_state::hydrate_header_from_buffer(
+                    std::move(b), size);
+                  if (!hydrated) {
+                      return false;
+                  }
+                  _state = std::move(hydrated.value());
+                  // an index without entries has nothing left to load
+                  _loaded = size == index_state::serialized_header_size;
+                  return true;
+              });
+        });
+    });
+}
+
+ss::future<> segment_index::ensure_loaded() {
+    if (likely(_loaded)) {
+        if (_resident_hook.is_linked()) {
+            resident_lru::get().touch(*this);
+        }
+        return ss::now();
+    }
+    // a resolved load is left from before the entries were released
+    if (!_loading || _loading->available()) {
+        _loading = ss::shared_future<>(load_entries());
+    }
+    return _loading->get_future();
+}
+
+ss::future<> segment_index::load_entries() {
+    return read_index_state()
+      .handle_exception([this](std::exception_ptr e) {
+          vlog(stlog.warn, "Error loading index:{}. Details:{}", _name, e);
+          return std::optional<index_state>();
+      })
+      .then([this](std::optional<index_state> st) {
+          if (_loaded) {
+              // the state was replaced while loading, e.g. by compaction
+              return;
+          }
+          _loaded = true;
+          if (!st) {
+              // lookups find no entry and read the segment from its start
+              vlog(stlog.warn, "Could not load entries of index:{}", _name);
+              return;
+          }
+          _state = std::move(st.value());
+          resident_lru::get().insert(*this);
+      });
+}
+
+void segment_index::release_entries() {
+    // release the memory of the entries, the header fields are kept
+    _state.relative_offset_index = {};
+    _state.relative_time_index = {};
+    _state.position_index = {};
+    _loaded = false;
+}
+
 ss::future<> segment_index::drop_all_data() {
     reset();
-    return _out.truncate(0);
+    return _out->with_file([](ss::file f) { return f.truncate(0); });
 }
 
 ss::future<> segment_index::flush() {
@@ -177,27 +369,30 @@ ss::future<> segment_index::flush() {
         return ss::make_ready_future<>();
     }
     _needs_persistence = false;
-    return _out.truncate(0)
-      .then(
-        [this] { return ss::make_file_output_stream(ss::file(_out.dup())); })
-      .then([this](ss::output_stream<char> out) {
-          auto b = _state.checksum_and_serialize();
-          return do_with(
-            std::move(b),
-            std::move(out),
-            [](iobuf& buff, ss::output_stream<char>& out) {
-                return ss::do_for_each(
-                         buff,
-                         [&out](const iobuf::fragment& f) {
-                             return out.write(f.get(), f.size());
-                         })
-                  .then([&out] { return out.flush(); })
-                  .then([&out] { return out.close(); });
-            });
-      });
+    return _out->with_file([this](ss::file f) {
+        return f.truncate(0)
+          .then([f]() mutable {
+              return ss::make_file_output_stream(ss::file(f.dup()));
+          })
+          .then([this](ss::output_stream<char> out) {
+              auto b = _state.checksum_and_serialize();
+              return do_with(
+                std::move(b),
+                std::move(out),
+                [](iobuf& buff, ss::output_stream<char>& out) {
+                    return ss::do_for_each(
+                             buff,
+                             [&out](const iobuf::fragment& f) {
+                                 return out.write(f.get(), f.size());
+                             })
+                      .then([&out] { return out.flush(); })
+                      .then([&out] { return out.close(); });
+                });
+          });
+    });
 }
 ss::future<> segment_index::close() {
-    return flush().then([this] { return _out.close(); });
+    return flush().then([this] { return _out->close(); });
 }
 std::ostream& operator<<(std::ostream& o, const segment_index& i) {
     return o << "{file:" << i.filename() << ", offsets:" << i.base_offset()
@@ -13,9 +13,12 @@
 #include "model/fundamental.h"
 #include "model/record.h"
 #include "model/timestamp.h"
+#include "storage/cached_file.h"
 #include "storage/index_state.h"
+#include "utils/intrusive_list_helpers.h"
 
 #include <seastar/core/file.hh>
+#include <seastar/core/shared_future.hh>
 #include <seastar/core/unaligned.hh>
 
 #include <memory>
@@ -34,6 +37,18 @@ namespace storage {
  *
  * The name of this index _must_ be then:
  *     default/test/0/1-1-v1.base_index
+ *
+ * Lazy loading
+ * ============
+ *
+ * At startup the indices of closed segments only hydrate their header, which
+ * holds the offset and timestamp bounds of the segment. The entries are loaded
+ * by `ensure_loaded()` on the first lookup. Lazily loaded indices are kept in
+ * a per-shard LRU and the entries of the least recently used ones are released
+ * once more than `max_resident_segment_indices` are resident. An unloaded
+ * index is loaded again on its next lookup. Indices that were hydrated
+ * eagerly, such as the index of the active segment, are released the same
+ * way once sealed, when their segment no longer takes appends.
  */
 class segment_index {
 public:
@@ -50,7 +65,14 @@ public:
 
     segment_index(
       ss::sstring filename, ss::file, model::offset base, size_t step);
-    ~segment_index() noexcept = default;
+    /// the file is opened on first use, and may be closed again by the
+    /// per-shard cache of segment files, see cached_file
+    segment_index(
+      ss::sstring filename,
+      cached_file::opener,
+      model::offset base,
+      size_t step);
+    ~segment_index() noexcept;
     segment_index(segment_index&&) noexcept = default;
     segment_index& operator=(segment_index&&) noexcept = default;
     segment_index(const segment_index&) = delete;
@@ -58,7 +80,14 @@ public:
 
     void maybe_track(const model::record_batch_header&, size_t filepos);
     std::optional<entry> find_nearest(model::offset);
+    /// \brief the last entry before which every batch is older than the
+    /// timestamp, where a scan for the first batch at or after the timestamp
+    /// can start. none if the scan has to start at the base of the segment
     std::optional<entry> find_nearest(model::timestamp);
+    /// \brief the last entry at or before the file position, where a read of
+    /// the batches past the position can start. none if the read has to start
+    /// at the base of the segment
+    std::optional<entry> find_nearest_position(size_t filepos);
 
     model::offset base_offset() const { return _state.base_offset; }
     model::offset max_offset() const { return _state.max_offset; }
@@ -67,6 +96,18 @@ public:
     const ss::sstring& filename() const { return _name; }
 
     ss::future<bool> materialize_index();
+    /// \brief hydrates the offset and timestamp bounds of the index. the
+    /// entries are loaded by `ensure_loaded()` on first use
+    ss::future<bool> materialize_index_header();
+    /// \brief loads the entries of a lazily materialized index. lookups on an
+    /// index whose entries are not loaded return no entry
+    ss::future<> ensure_loaded();
+    bool loaded() const { return _loaded; }
+    /// \brief keeps the file open, as for the active segment, until sealed
+    void pin() { _out->pin(); }
+    /// \brief no more entries are tracked. the entries may be released once
+    /// flushed, and are loaded again on use, as may the file
+    void seal();
     ss::future<> close();
     ss::future<> flush();
     ss::future<> truncate(model::offset);
@@ -81,15 +122,36 @@ public:
     void reset();
     void swap_index_state(index_state&&);
     bool needs_persistence() const { return _needs_persistence; }
+    /// the checksum of the state last persisted or hydrated
+    uint64_t checksum() const { return _state.checksum; }
+
+    /// \brief hydrates the index written with a recovery checkpoint, without
+    /// the entries of the batches after the checkpoint. false if the index on
+    /// disk is not the one whose checksum the checkpoint recorded
+    ss::future<bool> restore_checkpoint(
+      model::offset last_offset,
+      model::timestamp max_timestamp,
+      uint64_t checksum);
 
 private:
+    struct resident_lru;
+
+    ss::future<std::optional<index_state>> read_index_state();
+    ss::future<> load_entries();
+    void release_entries();
+
     ss::sstring _name;
-    ss::file _out;
+    cached_file_ptr _out;
     size_t _step;
     size_t _acc{0};
     bool _needs_persistence{false};
     index_state _state;
 
+    // false while only the header of a lazily materialized index is loaded
+    bool _loaded{true};
+    std::optional<ss::shared_future<>> _loading;
+    intrusive_list_hook _resident_hook;
+
     friend std::ostream& operator<<(std::ostream&, const segment_index&);
 };
 
@@ -23,26 +23,44 @@ segment_reader::segment_reader(
   ss::sstring filename,
   ss::file data_file,
   size_t file_size,
-  size_t buffer_size) noexcept
+  size_t buffer_size)
   : _filename(std::move(filename))
-  , _data_file(std::move(data_file))
+  , _data_file(ss::make_lw_shared<cached_file>(_filename, std::move(data_file)))
+  , _file_size(file_size)
+  , _buffer_size(buffer_size) {}
+
+segment_reader::segment_reader(
+  ss::sstring filename,
+  cached_file::opener open,
+  size_t file_size,
+  size_t buffer_size)
+  : _filename(std::move(filename))
+  , _data_file(ss::make_lw_shared<cached_file>(_filename, std::move(open)))
   , _file_size(file_size)
   , _buffer_size(buffer_size) {}
 
 ss::input_stream<char>
 segment_reader::data_stream(size_t pos, const ss::io_priority_class& pc) {
+    return data_stream(pos, pc, _buffer_size, 4); // FIXME: scylla uses 10
+}
+
+ss::input_stream<char> segment_reader::data_stream(
+  size_t pos,
+  const ss::io_priority_class& pc,
+  size_t buffer_size,
+  unsigned read_ahead) {
     vassert(
       pos <= _file_size,
       "cannot read negative bytes. Asked to read at position: '{}' - {}",
       pos,
       *this);
     ss::file_input_stream_options options;
-    options.buffer_size = _buffer_size;
+    options.buffer_size = buffer_size;
     options.io_priority_class = pc;
-    options.read_ahead = 4; // FIXME: scylla uses 10
+    options.read_ahead = read_ahead;
     options.dynamic_adjustments = _history;
-    return make_file_input_stream(
-      _data_file, pos, _file_size - pos, std::move(options));
+    return _data_file->make_input_stream(
+      pos, _file_size - pos, std::move(options));
 }
 
 ss::future<> segment_reader::truncate(size_t n) {
@@ -13,6 +13,7 @@
 
 #include "model/fundamental.h"
 #include "seastarx.h"
+#include "storage/cached_file.h"
 
 #include <seastar/core/file.hh>
 #include <seastar/core/fstream.hh>
@@ -32,7 +33,14 @@ public:
       ss::sstring filename,
       ss::file,
       size_t file_size,
-      size_t buffer_size) noexcept;
+      size_t buffer_size);
+    /// the file is opened on first read, and may be closed again by the
+    /// per-shard cache of segment files, see cached_file
+    segment_reader(
+      ss::sstring filename,
+      cached_file::opener,
+      size_t file_size,
+      size_t buffer_size);
     ~segment_reader() noexcept = default;
     segment_reader(segment_reader&&) noexcept = default;
     segment_reader& operator=(segment_reader&&) noexcept = default;
@@ -49,25 +57,52 @@ public:
     bool empty() const { return _file_size == 0; }
 
     /// close the underlying file handle
-    ss::future<> close() { return _data_file.close(); }
+    ss::future<> close() { return _data_file->close(); }
+
+    /// \brief keeps the file open, as for the active segment, until unpinned
+    void pin() { _data_file->pin(); }
+    void unpin() { _data_file->unpin(); }
+    /// \brief opens the file and keeps it open until closed, so that the
+    /// streams of the reader read this file even once it is renamed over
+    ss::future<> hold_open() {
+        _data_file->pin();
+        return _data_file->get().discard_result();
+    }
 
     /// perform syscall stat
-    ss::future<struct stat> stat() { return _data_file.stat(); }
+    ss::future<struct stat> stat() {
+        return _data_file->with_file([](ss::file f) { return f.stat(); });
+    }
 
     /// truncates file starting at this phyiscal offset
     ss::future<> truncate(size_t sz);
 
-    /// flushes the file metadata
-    ss::future<> flush() { return _data_file.flush(); }
+    /// flushes the file metadata, if the file is open
+    ss::future<> flush() {
+        if (!_data_file->is_open()) {
+            return ss::now();
+        }
+        return _data_file->with_file([](ss::file f) { return f.flush(); });
+    }
+
+    /// buffer size of the streams created with default options
+    size_t buffer_size() const { return _buffer_size; }
 
     /// create an input stream _sharing_ the underlying file handle
     /// starting at position @pos
     ss::input_stream<char>
     data_stream(size_t pos, const ss::io_priority_class&);
 
+    /// same, with the buffer size and read-ahead depth of the stream
+    ss::input_stream<char> data_stream(
+      size_t pos,
+      const ss::io_priority_class&,
+      size_t buffer_size,
+      unsigned read_ahead);
+
 private:
     ss::sstring _filename;
-    ss::file _data_file;
+    cached_file_ptr _data_file;
     size_t _file_size{0};
     size_t _buffer_size{0};
     ss::lw_shared_ptr<ss::file_input_stream_history> _history
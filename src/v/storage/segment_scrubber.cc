@@ -0,0 +1,175 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/segment_scrubber.h"
+
+#include "bytes/utils.h"
+#include "hashing/crc32c.h"
+#include "model/record_utils.h"
+#include "storage/parser.h"
+#include "units.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/sleep.hh>
+
+#include <chrono>
+
+namespace storage::internal {
+
+namespace {
+
+// the parser stops after this many bytes so that the reads are paced
+constexpr size_t scrub_chunk_size = 1_MiB;
+
+struct scrub_state {
+    explicit scrub_state(model::offset base)
+      : next_offset(base) {}
+
+    // the first offset past the batches verified
+    model::offset next_offset;
+    // the end of the batches verified in the file
+    size_t verified_bytes{0};
+    bool corrupt{false};
+};
+
+class scrubbing_consumer final : public batch_consumer {
+public:
+    explicit scrubbing_consumer(scrub_state& st) noexcept
+      : _state(&st) {}
+
+    consume_result consume_batch_start(
+      model::record_batch_header header, size_t, size_t) override {
+        _header = header;
+        _crc = crc32();
+        model::crc_record_batch_header(_crc, header);
+        return skip_batch::no;
+    }
+
+    void consume_records(iobuf&& records) override {
+        crc_extend_iobuf(_crc, records);
+    }
+
+    stop_parser consume_batch_end() override {
+        // crc is calculated as a uint32_t but because of kafka we carry
+        // around a signed type in the batch structure
+        if ((uint32_t)_header.crc != _crc.value()) {
+            _state->corrupt = true;
+            return stop_parser::yes;
+        }
+        _state->next_offset = _header.last_offset() + model::offset(1);
+        _state->verified_bytes += _header.size_bytes;
+        _chunk_bytes += _header.size_bytes;
+        if (_chunk_bytes >= scrub_chunk_size) {
+            _chunk_bytes = 0;
+            return stop_parser::yes;
+        }
+        return stop_parser::no;
+    }
+
+    void print(std::ostream& os) const override {
+        fmt::print(
+          os, "storage::scrubbing_consumer next: {}", _state->next_offset);
+    }
+
+private:
+    scrub_state* _state;
+    model::record_batch_header _header;
+    crc32 _crc;
+    size_t _chunk_bytes{0};
+};
+
+/// closing or removing the segment waits for the scrub to release its lock
+bool is_going_away(const segment& s) {
+    return s.is_closed() || s.is_tombstone();
+}
+
+/// sleeps for what is left of the time reading the bytes takes at the rate
+ss::future<> pace(
+  size_t bytes,
+  ss::lowres_clock::time_point start,
+  const scrub_config& cfg) {
+    if (!cfg.max_bytes_per_sec || *cfg.max_bytes_per_sec == 0) {
+        return ss::now();
+    }
+    const auto target = start
+                        + std::chrono::milliseconds(
+                          bytes * 1000 / *cfg.max_bytes_per_sec);
+    const auto now = ss::lowres_clock::now();
+    if (target <= now) {
+        return ss::now();
+    }
+    return ss::sleep_abortable<ss::lowres_clock>(target - now, *cfg.asrc)
+      .handle_exception_type([](const ss::sleep_aborted&) {});
+}
+
+ss::future<scrub_result>
+do_scrub(ss::lw_shared_ptr<segment> seg, scrub_config cfg) {
+    auto st = std::make_unique<scrub_state>(seg->offsets().base_offset);
+    auto parser = std::make_unique<continuous_batch_parser>(
+      std::make_unique<scrubbing_consumer>(*st),
+      seg->reader().data_stream(0, cfg.iopc));
+    return ss::do_with(
+      std::move(st),
+      std::move(parser),
+      [seg, cfg](
+        std::unique_ptr<scrub_state>& st,
+        std::unique_ptr<continuous_batch_parser>& parser) {
+          return ss::repeat([seg, &st, &parser, cfg] {
+                     const auto start = ss::lowres_clock::now();
+                     const auto before = st->verified_bytes;
+                     return parser->consume().then(
+                       [seg, &st, &parser, cfg, start, before](
+                         result<size_t>) {
+                           if (
+                             st->corrupt || !parser->is_resumable()
+                             || cfg.asrc->abort_requested()
+                             || is_going_away(*seg)) {
+                               return ss::make_ready_future<
+                                 ss::stop_iteration>(ss::stop_iteration::yes);
+                           }
+                           return pace(
+                                    st->verified_bytes - before, start, cfg)
+                             .then([] { return ss::stop_iteration::no; });
+                       });
+                 })
+            .then([&parser] { return parser->close(); })
+            .then([seg, cfg, &st] {
+                scrub_result ret{
+                  .segments = 1,
+                  .bytes = st->verified_bytes,
+                };
+                if (cfg.asrc->abort_requested() || is_going_away(*seg)) {
+                    // partially verified
+                    return ret;
+                }
+                // the parser also stops on a corrupt header, or on a batch
+                // cut short, before the end of the file
+                if (
+                  st->corrupt
+                  || st->verified_bytes < seg->reader().file_size()) {
+                    ret.corrupt_offset = st->next_offset;
+                }
+                return ret;
+            });
+      });
+}
+
+} // namespace
+
+ss::future<scrub_result>
+scrub_segment(ss::lw_shared_ptr<segment> seg, scrub_config cfg) {
+    return seg->read_lock().then([seg, cfg](ss::rwlock::holder h) {
+        if (is_going_away(*seg) || seg->has_appender()) {
+            return ss::make_ready_future<scrub_result>();
+        }
+        return do_scrub(seg, cfg).finally([h = std::move(h)] {});
+    });
+}
+
+} // namespace storage::internal
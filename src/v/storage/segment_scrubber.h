@@ -0,0 +1,32 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+#include "storage/segment.h"
+#include "storage/types.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/shared_ptr.hh>
+
+namespace storage::internal {
+
+/// \brief reads the whole closed segment back and verifies the crc of each
+/// of its batches, stopping at the first one which fails
+///
+/// The segment is read under its read lock, so that compaction does not swap
+/// its files meanwhile, in chunks paced to the rate of the config. A segment
+/// closed in between is skipped.
+ss::future<scrub_result>
+  scrub_segment(ss::lw_shared_ptr<segment>, scrub_config);
+
+} // namespace storage::internal
@@ -12,6 +12,7 @@
 #include "storage/fs_utils.h"
 #include "storage/log_replayer.h"
 #include "storage/logger.h"
+#include "storage/segment_utils.h"
 #include "utils/directory_walker.h"
 #include "vassert.h"
 #include "vlog.h"
@@ -23,6 +24,7 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <exception>
 
 namespace storage {
@@ -60,6 +62,9 @@ void segment_set::add(ss::lw_shared_ptr<segment> h) {
 
 void segment_set::pop_back() { _handles.pop_back(); }
 void segment_set::pop_front() { _handles.pop_front(); }
+void segment_set::erase(iterator first, iterator last) {
+    _handles.erase(first, last);
+}
 
 template<typename Iterator>
 struct needle_in_range {
@@ -149,6 +154,50 @@ std::ostream& operator<<(std::ostream& o, const segment_set& s) {
 // Recover the last segment. Whenever we close a segment, we will likely
 // open a new one to which we will direct new writes. That new segment
 // might be empty. To optimize log replay, implement #140.
+/**
+ * Merging adjacent compacted segments rewrites the first segment of the run
+ * before the others are removed. A crash in between leaves segments whose
+ * offsets are fully covered by their predecessor. Those are removed, and so is
+ * the compacted index of the predecessor, which is rebuilt from its data.
+ *
+ * Must run in a seastar thread.
+ */
+static segment_set::underlying_t
+remove_merged_segments(segment_set::underlying_t segs) {
+    std::sort(segs.begin(), segs.end(), segment_ordering{});
+    segment_set::underlying_t ret;
+    ret.reserve(segs.size());
+    for (auto& s : segs) {
+        if (!ret.empty()) {
+            auto& prev = ret.back();
+            const auto& o = s->offsets();
+            if (
+              o.base_offset <= prev->offsets().dirty_offset
+              && o.dirty_offset <= prev->offsets().dirty_offset) {
+                vlog(
+                  stlog.info,
+                  "Removing segment: {} already merged into: {}",
+                  s,
+                  prev);
+                auto merged_index = internal::compacted_index_path(
+                  s->reader().filename().c_str());
+                auto prev_index = internal::compacted_index_path(
+                  prev->reader().filename().c_str());
+                s->tombstone();
+                s->close().get();
+                for (auto& p : {merged_index, prev_index}) {
+                    if (ss::file_exists(p.string()).get0()) {
+                        ss::remove_file(p.string()).get();
+                    }
+                }
+                continue;
+            }
+        }
+        ret.push_back(std::move(s));
+    }
+    return ret;
+}
+
 static ss::future<segment_set>
 unsafe_do_recover(segment_set&& segments, ss::abort_source& as) {
     return ss::async([segments = std::move(segments), &as]() mutable {
@@ -165,7 +214,8 @@ unsafe_do_recover(segment_set&& segments, ss::abort_source& as) {
               auto& s = *ss;
               try {
                   // use the segment materialize instead of going through
-                  // the index directly to hydrate the max_offset state
+                  // the index directly to hydrate the max_offset state. only
+                  // the index header is read, its entries are loaded lazily
                   return s.materialize_index().get0();
               } catch (...) {
                   vlog(
@@ -236,7 +286,7 @@ unsafe_do_recover(segment_set&& segments, ss::abort_source& as) {
             vlog(stlog.info, "Recovered: {}", s);
             good.emplace_back(std::move(s));
         }
-        return segment_set(std::move(good));
+        return segment_set(remove_merged_segments(std::move(good)));
     });
 }
 
@@ -283,16 +333,27 @@ static ss::future<segment_set::underlying_t> open_segments(
   ss::sstring dir,
   debug_sanitize_files sanitize_fileops,
   std::function<std::optional<batch_cache_index>()> cache_factory,
-  ss::abort_source& as) {
+  ss::abort_source& as,
+  segment_file_wrapper wrap_data,
+  size_t buf_size) {
     using segs_type = segment_set::underlying_t;
     return ss::do_with(
       segs_type{},
-      [&as, cache_factory, sanitize_fileops, dir = std::move(dir)](
-        segs_type& segs) {
+      [&as,
+       cache_factory,
+       sanitize_fileops,
+       buf_size,
+       dir = std::move(dir),
+       wrap_data = std::move(wrap_data)](segs_type& segs) {
           auto f = directory_walker::walk(
             dir,
-            [&as, cache_factory, dir, sanitize_fileops, &segs](
-              ss::directory_entry seg) {
+            [&as,
+             cache_factory,
+             dir,
+             sanitize_fileops,
+             buf_size,
+             &segs,
+             wrap_data](ss::directory_entry seg) {
                 // abort if requested
                 if (as.abort_requested()) {
                     return ss::now();
@@ -316,7 +377,12 @@ static ss::future<segment_set::underlying_t> open_segments(
                     // not a reader filename
                     return ss::make_ready_future<>();
                 }
-                return open_segment(path, sanitize_fileops, cache_factory())
+                return open_segment(
+                         path,
+                         sanitize_fileops,
+                         cache_factory(),
+                         buf_size,
+                         wrap_data)
                   .then([&segs](ss::lw_shared_ptr<segment> p) {
                       segs.push_back(std::move(p));
                   });
@@ -337,11 +403,23 @@ ss::future<segment_set> recover_segments(
   debug_sanitize_files sanitize_fileops,
   bool is_compaction_enabled,
   std::function<std::optional<batch_cache_index>()> cache_factory,
-  ss::abort_source& as) {
+  ss::abort_source& as,
+  segment_file_wrapper wrap_data,
+  size_t buf_size) {
     return ss::recursive_touch_directory(path.string())
-      .then([&as, cache_factory, sanitize_fileops, path = std::move(path)] {
+      .then([&as,
+             cache_factory,
+             sanitize_fileops,
+             buf_size,
+             path = std::move(path),
+             wrap_data = std::move(wrap_data)]() mutable {
           return open_segments(
-            path.string(), sanitize_fileops, cache_factory, as);
+            path.string(),
+            sanitize_fileops,
+            cache_factory,
+            as,
+            std::move(wrap_data),
+            buf_size);
       })
       .then([&as, is_compaction_enabled](segment_set::underlying_t segs) {
           auto segments = segment_set(std::move(segs));
@@ -60,6 +60,8 @@ public:
 
     void pop_back();
     void pop_front();
+    /// removes the segments in [first, last)
+    void erase(iterator first, iterator last);
 
     underlying_t release() && { return std::move(_handles); }
     type& back() { return _handles.back(); }
@@ -91,7 +93,9 @@ ss::future<segment_set> recover_segments(
   debug_sanitize_files sanitize_fileops,
   bool is_compaction_enabled,
   std::function<std::optional<batch_cache_index>()> batch_cache_factory,
-  ss::abort_source& as);
+  ss::abort_source& as,
+  segment_file_wrapper wrap_data = {},
+  size_t buf_size = default_segment_readahead_size);
 
 std::ostream& operator<<(std::ostream&, const segment_set&);
 
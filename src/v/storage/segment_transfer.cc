@@ -0,0 +1,137 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/segment_transfer.h"
+
+#include "storage/fs_utils.h"
+#include "storage/logger.h"
+#include "storage/version.h"
+#include "vlog.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/seastar.hh>
+
+#include <ostream>
+
+namespace storage {
+
+std::ostream& operator<<(std::ostream& o, segment_file_type t) {
+    switch (t) {
+    case segment_file_type::data:
+        return o << "data";
+    case segment_file_type::index:
+        return o << "index";
+    }
+    return o << "unknown";
+}
+
+ss::future<> segment_files::close() {
+    return ss::when_all_succeed(
+      data.close(),
+      index.close(),
+      compaction_index ? compaction_index->close() : ss::now());
+}
+
+std::filesystem::path segment_receiver::staging_path(
+  const ntp_config& cfg,
+  model::offset base_offset,
+  model::term_id term,
+  segment_file_type type) {
+    auto path = segment_path::make_segment_path(
+      cfg, base_offset, term, record_version_type::v1);
+    if (type == segment_file_type::index) {
+        path.replace_extension("base_index");
+    }
+    path += ".recovery";
+    return path;
+}
+
+static ss::future<ss::output_stream<char>>
+open_staged_file(const std::filesystem::path& path, ss::io_priority_class pc) {
+    const auto flags = ss::open_flags::wo | ss::open_flags::create
+                       | ss::open_flags::truncate;
+    return ss::open_file_dma(path.string(), flags).then([pc](ss::file f) {
+        ss::file_output_stream_options options;
+        options.io_priority_class = pc;
+        return ss::make_file_output_stream(std::move(f), options);
+    });
+}
+
+ss::future<segment_receiver> segment_receiver::open(
+  const ntp_config& cfg,
+  model::offset base_offset,
+  model::term_id term,
+  ss::io_priority_class pc) {
+    auto data = staging_path(cfg, base_offset, term, segment_file_type::data);
+    auto index = staging_path(
+      cfg, base_offset, term, segment_file_type::index);
+    vlog(stlog.info, "Receiving segment {}", data);
+    return open_staged_file(data, pc).then(
+      [base_offset, term, data, index, pc](ss::output_stream<char> data_out) {
+          return open_staged_file(index, pc).then(
+            [base_offset, term, data, index, data_out = std::move(data_out)](
+              ss::output_stream<char> index_out) mutable {
+                return segment_receiver(
+                  base_offset,
+                  term,
+                  staged_file{.path = data, .output = std::move(data_out)},
+                  staged_file{.path = index, .output = std::move(index_out)});
+            });
+      });
+}
+
+segment_receiver::segment_receiver(
+  model::offset base_offset,
+  model::term_id term,
+  staged_file data,
+  staged_file index)
+  : _base_offset(base_offset)
+  , _term(term)
+  , _data(std::move(data))
+  , _index(std::move(index)) {}
+
+ss::future<> segment_receiver::write(segment_file_type t, iobuf chunk) {
+    auto& f = get(t);
+    f.bytes += chunk.size_bytes();
+    return write_iobuf_to_output_stream(std::move(chunk), f.output);
+}
+
+ss::future<> segment_receiver::close() {
+    if (_closed) {
+        return ss::now();
+    }
+    _closed = true;
+    return ss::when_all_succeed(
+      _data.output.flush().then([this] { return _data.output.close(); }),
+      _index.output.flush().then([this] { return _index.output.close(); }));
+}
+
+ss::future<> segment_receiver::abort() {
+    return close().then_wrapped([this](ss::future<> f) {
+        if (f.failed()) {
+            vlog(
+              stlog.warn,
+              "Error closing received segment {}: {}",
+              _data.path,
+              f.get_exception());
+        }
+        return ss::when_all_succeed(
+                 ss::remove_file(_data.path.string()),
+                 ss::remove_file(_index.path.string()))
+          .handle_exception([this](const std::exception_ptr& e) {
+              vlog(
+                stlog.debug,
+                "Error removing received segment {}: {}",
+                _data.path,
+                e);
+          });
+    });
+}
+
+} // namespace storage
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "bytes/iobuf.h"
+#include "model/fundamental.h"
+#include "model/timestamp.h"
+#include "seastarx.h"
+#include "storage/ntp_config.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/fstream.hh>
+
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <optional>
+
+namespace storage {
+
+/// The files of a segment that are copied between replicas.
+enum class segment_file_type : int8_t { data = 0, index = 1 };
+
+std::ostream& operator<<(std::ostream&, segment_file_type);
+
+/*
+ * Files of a closed segment, opened for reading so that they can be copied
+ * byte for byte to another replica. Both files are opened under the segment
+ * read lock, they stay consistent with each other even if the segment is
+ * compacted or removed while they are being read.
+ */
+struct segment_files {
+    model::offset base_offset;
+    model::offset dirty_offset;
+    model::term_id term;
+    model::timestamp max_timestamp;
+    ss::file data;
+    size_t data_size{0};
+    ss::file index;
+    size_t index_size{0};
+    /// compaction index of the segment, if it has one. Replicas rebuild it
+    /// rather than copying it, object storage keeps it with the segment.
+    std::optional<ss::file> compaction_index;
+    size_t compaction_index_size{0};
+
+    ss::file& get(segment_file_type t) {
+        return t == segment_file_type::data ? data : index;
+    }
+    size_t size(segment_file_type t) const {
+        return t == segment_file_type::data ? data_size : index_size;
+    }
+    ss::future<> close();
+};
+
+/*
+ * Receives the files of a segment copied from another replica.
+ *
+ * The files are written in the log directory under staging names, which
+ * recovery does not pick up, and become part of the log once complete with
+ * log::install_segment(). Chunks of each file must be written in order.
+ */
+class segment_receiver {
+public:
+    static std::filesystem::path staging_path(
+      const ntp_config&, model::offset, model::term_id, segment_file_type);
+
+    static ss::future<segment_receiver> open(
+      const ntp_config&, model::offset, model::term_id, ss::io_priority_class);
+
+    segment_receiver(segment_receiver&&) noexcept = default;
+    segment_receiver& operator=(segment_receiver&&) noexcept = default;
+    segment_receiver(const segment_receiver&) = delete;
+    segment_receiver& operator=(const segment_receiver&) = delete;
+    ~segment_receiver() noexcept = default;
+
+    model::offset base_offset() const { return _base_offset; }
+    model::term_id term() const { return _term; }
+
+    /// bytes of the file written so far
+    uint64_t bytes_stored(segment_file_type t) const {
+        return get(t).bytes;
+    }
+
+    ss::future<> write(segment_file_type, iobuf);
+    /// flushes and closes both files
+    ss::future<> close();
+    /// closes and removes both files
+    ss::future<> abort();
+
+private:
+    struct staged_file {
+        std::filesystem::path path;
+        ss::output_stream<char> output;
+        uint64_t bytes{0};
+    };
+
+    segment_receiver(
+      model::offset, model::term_id, staged_file data, staged_file index);
+
+    staged_file& get(segment_file_type t) {
+        return t == segment_file_type::data ? _data : _index;
+    }
+    const staged_file& get(segment_file_type t) const {
+        return t == segment_file_type::data ? _data : _index;
+    }
+
+    model::offset _base_offset;
+    model::term_id _term;
+    staged_file _data;
+    staged_file _index;
+    bool _closed{false};
+};
+
+} // namespace storage
@@ -29,6 +29,7 @@
 
 #include <seastar/core/file-types.hh>
 #include <seastar/core/future.hh>
+#include <seastar/core/loop.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/core/rwlock.hh>
 #include <seastar/core/seastar.hh>
@@ -38,6 +39,10 @@
 #include <fmt/core.h>
 #include <roaring/roaring.hh>
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
 namespace storage::internal {
 using namespace storage; // NOLINT
 
@@ -119,16 +124,20 @@ ss::future<segment_appender_ptr> make_segment_appender(
   const std::filesystem::path& path,
   debug_sanitize_files debug,
   size_t number_of_chunks,
-  ss::io_priority_class iopc) {
+  ss::io_priority_class iopc,
+  size_t fallocation_step) {
     return internal::make_writer_handle(path, debug)
-      .then([number_of_chunks, iopc, path](ss::file writer) {
+      .then([number_of_chunks, iopc, path, fallocation_step](
+              ss::file writer) {
           try {
               // NOTE: This try-catch is needed to not uncover the real
               // exception during an OOM condition, since the appender allocates
               // 1MB of memory aligned buffers
               return ss::make_ready_future<segment_appender_ptr>(
                 std::make_unique<segment_appender>(
-                  writer, segment_appender::options(iopc, number_of_chunks)));
+                  writer,
+                  segment_appender::options(
+                    iopc, number_of_chunks, fallocation_step)));
           } catch (...) {
               auto e = std::current_exception();
               vlog(stlog.error, "could not allocate appender: {}", e);
@@ -156,6 +165,17 @@ natural_index_of_entries_to_keep(compacted_index_reader reader) {
     return reader.consume(compaction_key_reducer(), model::no_timeout);
 }
 
+ss::future<Roaring> natural_index_of_entries_to_keep(
+  compacted_index_reader reader, compaction_config cfg) {
+    if (!cfg.hashed_key_index_bytes) {
+        return natural_index_of_entries_to_keep(std::move(reader));
+    }
+    reader.reset();
+    return reader.consume(
+      compaction_hash_key_reducer(*cfg.hashed_key_index_bytes),
+      model::no_timeout);
+}
+
 ss::future<> copy_filtered_entries(
   compacted_index_reader reader,
   Roaring to_copy_index,
@@ -180,8 +200,8 @@ ss::future<> copy_filtered_entries(
 
 static ss::future<> do_write_clean_compacted_index(
   compacted_index_reader reader, compaction_config cfg) {
-    return natural_index_of_entries_to_keep(reader).then([reader,
-                                                          cfg](Roaring bitmap) {
+    return natural_index_of_entries_to_keep(reader, cfg).then([reader, cfg](
+                                                               Roaring bitmap) {
         const auto tmpname = std::filesystem::path(
           fmt::format("{}.staging", reader.filename()));
         return make_handle(
@@ -346,38 +366,69 @@ ss::future<> do_swap_data_file_handles(
   std::filesystem::path compacted,
   ss::lw_shared_ptr<storage::segment> s,
   storage::compaction_config cfg,
-  probe& pb) {
+  probe& pb,
+  index_state idx) {
+    // the readers of the current file keep it open, and the file stays on
+    // disk until they close it even once renamed over
+    ss::sstring staged = compacted.string();
     return s->reader()
-      .close()
-      .then([compacted, s] {
-          ss::sstring old_name = compacted.string();
-          return ss::rename_file(old_name, s->reader().filename());
-      })
-      .then([s, cfg] {
-          auto to_open = std::filesystem::path(s->reader().filename().c_str());
-          return make_reader_handle(to_open, cfg.sanitize);
+      .hold_open()
+      .then([s, staged] {
+          return ss::rename_file(staged, s->reader().filename());
       })
-      .then([s, &pb](ss::file f) mutable {
-          return f.stat()
-            .then([f](struct stat s) {
-                return ss::make_ready_future<std::tuple<uint64_t, ss::file>>(
-                  std::make_tuple(s.st_size, f));
-            })
-            .then([s, &pb](std::tuple<uint64_t, ss::file> t) {
-                auto& [size, fd] = t;
-                auto r = segment_reader(
-                  s->reader().filename(),
-                  std::move(fd),
-                  size,
-                  default_segment_readahead_size);
-                // update partition size probe
-                pb.delete_segment(*s.get());
-                std::swap(s->reader(), r);
-                pb.add_initial_segment(*s.get());
-            });
+      .then([s] { return ss::file_size(s->reader().filename()); })
+      .then([s, cfg, &pb, idx = std::move(idx)](uint64_t size) mutable {
+          auto path = std::filesystem::path(s->reader().filename().c_str());
+          // opened on first read, as the other closed segments
+          auto r = segment_reader(
+            s->reader().filename(),
+            [path, sanitize = cfg.sanitize] {
+                return make_reader_handle(path, sanitize);
+            },
+            size,
+            default_segment_readahead_size);
+          // update partition size probe
+          pb.delete_segment(*s.get());
+          // the file and its index are swapped at once, so that the
+          // readers never position a stream with the other's index
+          s->swap_data(std::move(r), std::move(idx));
+          pb.add_initial_segment(*s.get());
       });
 }
 
+/// replaces the data of the segment with that of its staging file, written
+/// with `idx` as offset index. the READ-lock excludes truncation and close
+/// only: the readers of the segment keep streaming from the previous file,
+/// and new readers are not held back by the swap.
+static ss::future<> swap_staged_segment_data(
+  ss::lw_shared_ptr<segment> s,
+  compaction_config cfg,
+  storage::probe& pb,
+  storage::index_state idx) {
+    return s->read_lock().then([s, cfg, &pb, idx = std::move(idx)](
+                                 ss::rwlock::holder h) mutable {
+        if (s->is_closed()) {
+            return ss::make_exception_future<>(segment_closed_exception());
+        }
+        // an empty index on disk makes recovery rebuild it, should the
+        // swap not complete. readers find no entry meanwhile and read the
+        // current file from its start.
+        return s->index()
+          .drop_all_data()
+          .then([s, cfg, &pb, idx = std::move(idx)]() mutable {
+              auto compacted_file = data_segment_staging_name(s);
+              return do_swap_data_file_handles(
+                compacted_file, s, cfg, pb, std::move(idx));
+          })
+          .then([s] {
+              // FIXME(noah): crashes if we evic the cache
+              // s->cache().purge();
+              return s->index().flush();
+          })
+          .finally([h = std::move(h)] {});
+    });
+}
+
 ss::future<> do_self_compact_segment(
   ss::lw_shared_ptr<segment> s, compaction_config cfg, storage::probe& pb) {
     return s->read_lock()
@@ -394,33 +445,115 @@ ss::future<> do_self_compact_segment(
                 return do_copy_segment_data(s, cfg, pb, std::move(h));
             });
       })
-      .then([s](storage::index_state idx) {
-          return s->write_lock().then(
-            [s, idx = std::move(idx)](ss::rwlock::holder h) mutable {
-                using type = std::tuple<index_state, ss::rwlock::holder>;
-                if (s->is_closed()) {
-                    return ss::make_exception_future<type>(
-                      segment_closed_exception());
-                }
-                return ss::make_ready_future<type>(
-                  std::make_tuple(std::move(idx), std::move(h)));
+      .then([cfg, s, &pb](storage::index_state idx) {
+          return swap_staged_segment_data(s, cfg, pb, std::move(idx));
+      });
+}
+
+ss::future<> recompress_segment(
+  ss::lw_shared_ptr<segment> s,
+  compaction_config cfg,
+  model::compression target,
+  storage::probe& pb) {
+    if (s->has_appender()) {
+        return ss::make_exception_future<>(std::runtime_error(fmt::format(
+          "Cannot recompress an active segment. cfg:{} - segment:{}",
+          cfg,
+          s)));
+    }
+    using result = recompress_segment_reducer::result;
+    return s->read_lock()
+      .then([s, cfg, target, &pb](ss::rwlock::holder h) {
+          if (s->is_closed()) {
+              return ss::make_exception_future<result>(
+                segment_closed_exception());
+          }
+          return make_segment_appender(
+                   data_segment_staging_name(s),
+                   cfg.sanitize,
+                   segment_appender::chunks_no_buffer,
+                   cfg.iopc)
+            .then([s, cfg, target, &pb, h = std::move(h)](
+                    segment_appender_ptr w) mutable {
+                auto raw = w.get();
+                auto r = create_segment_full_reader(s, cfg, pb, std::move(h));
+                return std::move(r)
+                  .consume(
+                    recompress_segment_reducer(target, raw), model::no_timeout)
+                  .finally([raw, w = std::move(w)]() mutable {
+                      return raw->close()
+                        .handle_exception([](std::exception_ptr e) {
+                            vlog(
+                              stlog.error,
+                              "Error closing recompressed segment:{}",
+                              e);
+                        })
+                        .finally([w = std::move(w)] {});
+                  });
             });
       })
-      .then([cfg, s, &pb](std::tuple<index_state, ss::rwlock::holder> h) {
-          return s->index()
-            .drop_all_data()
-            .then([s, cfg, &pb] {
-                auto compacted_file = data_segment_staging_name(s);
-                return do_swap_data_file_handles(compacted_file, s, cfg, pb);
-            })
-            .then([h = std::move(h), s]() mutable {
-                auto& [idx, lock] = h;
-                s->index().swap_index_state(std::move(idx));
-                s->force_set_commit_offset_from_index();
-                // FIXME(noah): crashes if we evic the cache
-                // s->cache().purge();
-                return s->index().flush().finally([l = std::move(lock)] {});
+      .then([s, cfg, target, &pb](result r) {
+          if (r.recompressed == 0) {
+              // already in the codec of the topic
+              return ss::remove_file(data_segment_staging_name(s).string());
+          }
+          vlog(
+            stlog.debug,
+            "recompressed {} batches of {} to {}",
+            r.recompressed,
+            s,
+            target);
+          return swap_staged_segment_data(s, cfg, pb, std::move(r.idx));
+      });
+}
+
+ss::future<> coalesce_segment(
+  ss::lw_shared_ptr<segment> s,
+  compaction_config cfg,
+  size_t max_bytes,
+  storage::probe& pb) {
+    if (s->has_appender()) {
+        return ss::make_exception_future<>(std::runtime_error(fmt::format(
+          "Cannot coalesce an active segment. cfg:{} - segment:{}", cfg, s)));
+    }
+    using result = coalesce_segment_reducer::result;
+    return s->read_lock()
+      .then([s, cfg, max_bytes, &pb](ss::rwlock::holder h) {
+          if (s->is_closed()) {
+              return ss::make_exception_future<result>(
+                segment_closed_exception());
+          }
+          return make_segment_appender(
+                   data_segment_staging_name(s),
+                   cfg.sanitize,
+                   segment_appender::chunks_no_buffer,
+                   cfg.iopc)
+            .then([s, cfg, max_bytes, &pb, h = std::move(h)](
+                    segment_appender_ptr w) mutable {
+                auto raw = w.get();
+                auto r = create_segment_full_reader(s, cfg, pb, std::move(h));
+                return std::move(r)
+                  .consume(
+                    coalesce_segment_reducer(max_bytes, raw),
+                    model::no_timeout)
+                  .finally([raw, w = std::move(w)]() mutable {
+                      return raw->close()
+                        .handle_exception([](std::exception_ptr e) {
+                            vlog(
+                              stlog.error,
+                              "Error closing coalesced segment:{}",
+                              e);
+                        })
+                        .finally([w = std::move(w)] {});
+                  });
             });
+      })
+      .then([s, cfg, &pb](result r) {
+          if (r.coalesced == 0) {
+              return ss::remove_file(data_segment_staging_name(s).string());
+          }
+          vlog(stlog.debug, "coalesced {} batches of {}", r.coalesced, s);
+          return swap_staged_segment_data(s, cfg, pb, std::move(r.idx));
       });
 }
 
@@ -498,6 +631,355 @@ ss::future<> self_compact_segment(
       .finally([&pb] { pb.segment_compacted(); });
 }
 
+using segments_t = std::vector<ss::lw_shared_ptr<segment>>;
+
+/// locks are taken in offset order, the same order used by the lock_manager
+static ss::future<std::vector<ss::rwlock::holder>>
+lock_segments(segments_t segs, bool write) {
+    return ss::do_with(
+      std::move(segs),
+      std::vector<ss::rwlock::holder>{},
+      [write](segments_t& segs, std::vector<ss::rwlock::holder>& locks) {
+          locks.reserve(segs.size());
+          return ss::do_for_each(
+                   segs,
+                   [write, &locks](ss::lw_shared_ptr<segment>& s) {
+                       auto f = write ? s->write_lock() : s->read_lock();
+                       return f.then([&locks](ss::rwlock::holder h) {
+                           locks.push_back(std::move(h));
+                       });
+                   })
+            .then([&locks] { return std::move(locks); });
+      });
+}
+
+static bool any_segment_closed(const segments_t& segs) {
+    return std::any_of(
+      segs.begin(), segs.end(), [](const ss::lw_shared_ptr<segment>& s) {
+          return s->is_closed() || s->is_tombstone();
+      });
+}
+
+static ss::future<>
+close_compacted_indices(std::vector<compacted_index_reader> readers) {
+    return ss::do_with(
+      std::move(readers), [](std::vector<compacted_index_reader>& readers) {
+          return ss::do_for_each(readers, [](compacted_index_reader& r) {
+              return r.close().then_wrapped([](ss::future<>) { /*ignore*/ });
+          });
+      });
+}
+
+static ss::future<std::vector<compacted_index_reader>>
+open_compacted_indices(segments_t segs, compaction_config cfg) {
+    using ret_t = std::vector<compacted_index_reader>;
+    return ss::do_with(
+      std::move(segs), ret_t{}, [cfg](segments_t& segs, ret_t& readers) {
+          return ss::do_for_each(
+                   segs,
+                   [cfg, &readers](ss::lw_shared_ptr<segment>& s) {
+                       auto path = compacted_index_path(
+                         s->reader().filename().c_str());
+                       return make_reader_handle(path, cfg.sanitize)
+                         .then([cfg, path, &readers](ss::file f) {
+                             readers.push_back(
+                               make_file_backed_compacted_reader(
+                                 path.string(),
+                                 std::move(f),
+                                 cfg.iopc,
+                                 64_KiB));
+                         });
+                   })
+            .then_wrapped([&readers](ss::future<> f) {
+                if (!f.failed()) {
+                    return ss::make_ready_future<ret_t>(std::move(readers));
+                }
+                auto e = f.get_exception();
+                return close_compacted_indices(std::move(readers)).then([e] {
+                    return ss::make_exception_future<ret_t>(e);
+                });
+            });
+      });
+}
+
+/// feeds every reader, in order, to the same reducer
+template<typename Reducer>
+static ss::future<> consume_compacted_indices(
+  std::vector<compacted_index_reader>& readers, Reducer& reducer) {
+    return ss::do_for_each(
+      readers, [&reducer](compacted_index_reader& reader) {
+          reader.reset();
+          return reader.consume(
+            chained_reducer<Reducer>(reducer), model::no_timeout);
+      });
+}
+
+/// writes the compacted index of the merged segment. the natural index of an
+/// entry keeps counting across readers, so the key bitmap of the whole run is
+/// valid for the copy pass over the same readers
+template<typename Reducer>
+static ss::future<Roaring> natural_index_of_merged_entries_to_keep(
+  std::vector<compacted_index_reader>& readers, Reducer reducer) {
+    return ss::do_with(std::move(reducer), [&readers](Reducer& keys) {
+        return consume_compacted_indices(readers, keys).then(
+          [&keys] { return keys.end_of_stream(); });
+    });
+}
+
+static ss::future<Roaring> natural_index_of_merged_entries_to_keep(
+  std::vector<compacted_index_reader>& readers, compaction_config cfg) {
+    if (cfg.hashed_key_index_bytes) {
+        return natural_index_of_merged_entries_to_keep(
+          readers, compaction_hash_key_reducer(*cfg.hashed_key_index_bytes));
+    }
+    return natural_index_of_merged_entries_to_keep(
+      readers, compaction_key_reducer());
+}
+
+static ss::future<> write_merged_compacted_index(
+  std::vector<compacted_index_reader>& readers,
+  std::filesystem::path tmpname,
+  compaction_config cfg) {
+    return natural_index_of_merged_entries_to_keep(readers, cfg)
+      .then([&readers, tmpname, cfg](Roaring bitmap) {
+          return make_handle(
+                   tmpname,
+                   ss::open_flags::rw | ss::open_flags::truncate
+                     | ss::open_flags::create,
+                   writer_opts(),
+                   cfg.sanitize)
+            .then([&readers, tmpname, cfg, bm = std::move(bitmap)](
+                    ss::file f) mutable {
+                return ss::do_with(
+                  make_file_backed_compacted_index(
+                    tmpname.string(),
+                    std::move(f),
+                    cfg.iopc,
+                    segment_appender::write_behind_memory / 2),
+                  [&readers, bm = std::move(bm)](
+                    compacted_index_writer& writer) mutable {
+                      return ss::do_with(
+                               index_filtered_copy_reducer(
+                                 std::move(bm), writer),
+                               [&readers](index_filtered_copy_reducer& copy) {
+                                   return consume_compacted_indices(
+                                     readers, copy);
+                               })
+                        // must be last
+                        .finally([&writer] {
+                            writer.set_flag(
+                              compacted_index::footer_flags::self_compaction);
+                            return writer.close();
+                        });
+                  });
+            });
+      });
+}
+
+static ss::future<> do_write_merged_compacted_index(
+  segments_t segs, std::filesystem::path tmpname, compaction_config cfg) {
+    return open_compacted_indices(std::move(segs), cfg)
+      .then([tmpname, cfg](std::vector<compacted_index_reader> readers) {
+          return ss::do_with(
+            std::move(readers),
+            [tmpname, cfg](std::vector<compacted_index_reader>& readers) {
+                return write_merged_compacted_index(readers, tmpname, cfg)
+                  .finally([&readers] {
+                      return close_compacted_indices(std::move(readers));
+                  });
+            });
+      });
+}
+
+static model::record_batch_reader create_segments_full_reader(
+  const segments_t& segs,
+  compaction_config cfg,
+  storage::probe& pb,
+  std::vector<ss::rwlock::holder> locks) {
+    auto reader_cfg = log_reader_config(
+      segs.front()->offsets().base_offset,
+      segs.back()->offsets().dirty_offset,
+      cfg.iopc);
+    reader_cfg.skip_batch_cache = true;
+    segment_set::underlying_t set;
+    set.reserve(segs.size());
+    std::copy(segs.begin(), segs.end(), std::back_inserter(set));
+    auto lease = std::make_unique<lock_manager::lease>(
+      segment_set(std::move(set)));
+    lease->locks = std::move(locks);
+    return model::make_record_batch_reader<log_reader>(
+      std::move(lease), reader_cfg, pb);
+}
+
+static ss::future<storage::index_state> do_copy_segments_data(
+  segments_t segs,
+  std::filesystem::path merged_index,
+  compaction_config cfg,
+  storage::probe& pb,
+  std::vector<ss::rwlock::holder> locks) {
+    const auto base = segs.front()->offsets().base_offset;
+    return make_reader_handle(merged_index, cfg.sanitize)
+      .then([base, cfg, merged_index](ss::file f) {
+          auto reader = make_file_backed_compacted_reader(
+            merged_index.string(), std::move(f), cfg.iopc, 64_KiB);
+          return generate_compacted_list(base, reader)
+            .finally([reader]() mutable {
+                return reader.close().then_wrapped([](ss::future<>) {});
+            });
+      })
+      .then([segs = std::move(segs), cfg, &pb, locks = std::move(locks)](
+              compacted_offset_list list) mutable {
+          const auto tmpname = data_segment_staging_name(segs.front());
+          return make_segment_appender(
+                   tmpname,
+                   cfg.sanitize,
+                   segment_appender::chunks_no_buffer,
+                   cfg.iopc)
+            .then([l = std::move(list),
+                   segs = std::move(segs),
+                   locks = std::move(locks),
+                   cfg,
+                   &pb](segment_appender_ptr w) mutable {
+                auto raw = w.get();
+                auto red = copy_data_segment_reducer(std::move(l), raw);
+                auto r = create_segments_full_reader(
+                  segs, cfg, pb, std::move(locks));
+                return std::move(r)
+                  .consume(std::move(red), model::no_timeout)
+                  .finally([raw, w = std::move(w)]() mutable {
+                      return raw->close()
+                        .handle_exception([](std::exception_ptr e) {
+                            vlog(
+                              stlog.error,
+                              "Error copying merged segments data:{}",
+                              e);
+                        })
+                        .finally([w = std::move(w)] {});
+                  });
+            });
+      });
+}
+
+static ss::future<std::vector<ss::rwlock::holder>> do_merge_adjacent_segments(
+  segments_t segs, compaction_config cfg, storage::probe& pb) {
+    auto first = segs.front();
+    const auto merged_index = std::filesystem::path(fmt::format(
+      "{}.staging",
+      compacted_index_path(first->reader().filename().c_str()).string()));
+    return lock_segments(segs, false)
+      .then([segs, merged_index, cfg, &pb](
+              std::vector<ss::rwlock::holder> locks) {
+          if (any_segment_closed(segs)) {
+              return ss::make_exception_future<index_state>(
+                segment_closed_exception());
+          }
+          // like self compaction, the bytes are copied with the READ-lock
+          return do_write_merged_compacted_index(segs, merged_index, cfg)
+            .then(
+              [segs, merged_index, cfg, &pb, l = std::move(locks)]() mutable {
+                  return do_copy_segments_data(
+                    segs, merged_index, cfg, pb, std::move(l));
+              });
+      })
+      .then([segs](index_state idx) {
+          return lock_segments(segs, true).then(
+            [segs, idx = std::move(idx)](
+              std::vector<ss::rwlock::holder> locks) mutable {
+                using type
+                  = std::tuple<index_state, std::vector<ss::rwlock::holder>>;
+                if (any_segment_closed(segs)) {
+                    return ss::make_exception_future<type>(
+                      segment_closed_exception());
+                }
+                return ss::make_ready_future<type>(
+                  std::make_tuple(std::move(idx), std::move(locks)));
+            });
+      })
+      .then([segs, first, merged_index, cfg, &pb](
+              std::tuple<index_state, std::vector<ss::rwlock::holder>> t) {
+          auto idx = std::move(std::get<index_state>(t));
+          // the last record of the run is always kept, this only guards the
+          // offsets reported by the merged segment
+          idx.max_offset = std::max(
+            idx.max_offset, segs.back()->offsets().dirty_offset);
+          idx.max_timestamp = std::max(
+            idx.max_timestamp, segs.back()->index().max_timestamp());
+          // an empty index makes recovery rebuild it from the merged data, and
+          // drop the merged segments that are left over, see segment_set.cc
+          return first->index()
+            .drop_all_data()
+            .then([first, cfg, &pb, idx = std::move(idx)]() mutable {
+                return do_swap_data_file_handles(
+                  data_segment_staging_name(first),
+                  first,
+                  cfg,
+                  pb,
+                  std::move(idx));
+            })
+            .then([first, merged_index] {
+                return ss::rename_file(
+                  merged_index.string(),
+                  compacted_index_path(first->reader().filename().c_str())
+                    .string());
+            })
+            .then([t = std::move(t)]() mutable {
+                return std::move(
+                  std::get<std::vector<ss::rwlock::holder>>(t));
+            });
+      });
+}
+
+ss::future<std::vector<ss::rwlock::holder>> merge_adjacent_segments(
+  segments_t segs, compaction_config cfg, storage::probe& pb) {
+    using ret_t = std::vector<ss::rwlock::holder>;
+    if (segs.size() < 2) {
+        return ss::make_ready_future<ret_t>();
+    }
+    for (auto& s : segs) {
+        if (s->has_appender() || !s->finished_self_compaction()) {
+            return ss::make_exception_future<ret_t>(
+              std::runtime_error(fmt::format(
+                "Cannot merge a segment that is not self compacted. cfg:{} - "
+                "segment:{}",
+                cfg,
+                s)));
+        }
+    }
+    // the compacted index of every segment must have been rewritten by the
+    // self compaction, otherwise it may reference removed entries
+    using state = compacted_index::recovery_state;
+    return ss::do_with(
+             segs,
+             true,
+             [cfg](segments_t& segs, bool& recovered) {
+                 return ss::do_for_each(
+                          segs,
+                          [cfg, &recovered](ss::lw_shared_ptr<segment>& s) {
+                              auto p = compacted_index_path(
+                                s->reader().filename().c_str());
+                              return detect_compaction_index_state(p, cfg).then(
+                                [&recovered](state st) {
+                                    if (st != state::recovered) {
+                                        recovered = false;
+                                    }
+                                });
+                          })
+                   .then([&recovered] { return recovered; });
+             })
+      .then([segs = std::move(segs), cfg, &pb](bool recovered) mutable {
+          if (!recovered) {
+              vlog(
+                stlog.info,
+                "skipping merge of segments:[{}, {}], a compacted index is "
+                "not self compacted",
+                segs.front(),
+                segs.back());
+              return ss::make_ready_future<ret_t>();
+          }
+          return do_merge_adjacent_segments(std::move(segs), cfg, pb);
+      });
+}
+
 std::filesystem::path compacted_index_path(std::filesystem::path segment_path) {
     return segment_path.replace_extension(".compaction_index");
 }
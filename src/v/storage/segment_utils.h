@@ -26,8 +26,28 @@
 
 #include <roaring/roaring.hh>
 
+#include <vector>
+
 namespace storage::internal {
 
+/// \brief rewrites the segment with its compressed batches recompressed to
+/// `target`, if any is compressed with another codec. This method acquires
+/// its own locks on the segment
+ss::future<> recompress_segment(
+  ss::lw_shared_ptr<storage::segment>,
+  storage::compaction_config,
+  model::compression target,
+  storage::probe&);
+
+/// \brief rewrites the segment with its runs of small batches of data
+/// merged into batches of up to `max_bytes`, see coalesce_segment_reducer.
+/// This method acquires its own locks on the segment
+ss::future<> coalesce_segment(
+  ss::lw_shared_ptr<storage::segment>,
+  storage::compaction_config,
+  size_t max_bytes,
+  storage::probe&);
+
 /// \brief, this method will acquire it's own locks on the segment
 ///
 ss::future<> self_compact_segment(
@@ -51,7 +71,8 @@ ss::future<segment_appender_ptr> make_segment_appender(
   const std::filesystem::path& path,
   storage::debug_sanitize_files debug,
   size_t number_of_chunks,
-  ss::io_priority_class iopc);
+  ss::io_priority_class iopc,
+  size_t fallocation_step = segment_appender::fallocation_step);
 
 size_t number_of_chunks_from_config(const storage::ntp_config&);
 
@@ -66,6 +87,9 @@ size_t number_of_chunks_from_config(const storage::ntp_config&);
 /// save starting at 0 on a *new* `.compacted_index` file this represents
 /// the fully dedupped entries, clean of truncations, etc
 ss::future<Roaring> natural_index_of_entries_to_keep(compacted_index_reader);
+/// \brief same as above, using the key index selected by the config
+ss::future<Roaring> natural_index_of_entries_to_keep(
+  compacted_index_reader, storage::compaction_config);
 
 ss::future<> copy_filtered_entries(
   storage::compacted_index_reader input,
@@ -97,10 +121,25 @@ ss::future<storage::index_state> do_copy_segment_data(
   storage::probe&,
   ss::rwlock::holder);
 
+/// \brief renames the compacted file over the data file of the segment,
+/// and swaps it in along with its index. the readers of the previous file
+/// keep streaming from it until they are done.
 ss::future<> do_swap_data_file_handles(
   std::filesystem::path compacted,
   ss::lw_shared_ptr<storage::segment>,
-  storage::compaction_config);
+  storage::compaction_config,
+  storage::probe&,
+  storage::index_state);
+
+/// \brief merges a run of adjacent, self-compacted segments into the first
+/// segment of the run. Keys are deduplicated across the whole run using the
+/// compacted index of each segment. On success the write locks of all the
+/// segments are returned; the caller must remove every segment but the first
+/// one before releasing them. This method acquires its own locks.
+ss::future<std::vector<ss::rwlock::holder>> merge_adjacent_segments(
+  std::vector<ss::lw_shared_ptr<storage::segment>>,
+  storage::compaction_config,
+  storage::probe&);
 
 std::filesystem::path compacted_index_path(std::filesystem::path segment_path);
 
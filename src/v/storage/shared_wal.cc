@@ -0,0 +1,508 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/shared_wal.h"
+
+#include "bytes/iobuf_parser.h"
+#include "cluster/namespace.h"
+#include "model/adl_serde.h"
+#include "model/record_batch_reader.h"
+#include "reflection/adl.h"
+#include "storage/logger.h"
+#include "storage/record_batch_builder.h"
+#include "storage/segment_set.h"
+#include "units.h"
+#include "vlog.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/thread.hh>
+
+#include <algorithm>
+
+namespace storage {
+
+// without a flush, the queued entries are written once they add up to this
+static constexpr size_t max_pending_bytes = 1_MiB;
+
+shared_wal::shared_wal(shared_wal_config conf, materialize_fn materialize)
+  : _conf(std::move(conf))
+  , _ntpc(cluster::shared_wal_ntp(ss::this_shard_id()), _conf.base_dir)
+  , _materialize(std::move(materialize))
+  , _recovery_timer([this] { drop_recovered(); }) {}
+
+ss::future<> shared_wal::start() {
+    vlog(stlog.info, "Starting shared wal: dir {}", _ntpc.work_directory());
+    return recover().then([this] { return make_active_segment(); });
+}
+
+ss::future<> shared_wal::stop() {
+    vlog(stlog.info, "Stopping shared wal: dir {}", _ntpc.work_directory());
+    _as.request_abort();
+    _recovery_timer.cancel();
+    auto f = _gate.close();
+    // the logs are closed, nothing waits for the entries still queued
+    if (_next_flush) {
+        _next_flush->set_exception(ss::gate_closed_exception());
+        _next_flush = nullptr;
+    }
+    _pending.clear();
+    _pending_bytes = 0;
+    return f.then([this] {
+        auto close = ss::now();
+        if (_segment) {
+            auto seg = std::exchange(_segment, nullptr);
+            auto closed = ss::make_lw_shared<closed_segment>();
+            closed->files = {seg->reader().filename(), seg->index().filename()};
+            _closed.push_back(std::move(closed));
+            close = seg->close().finally([seg] {});
+        }
+        return close.then([this] {
+            if (!_recovered.empty()) {
+                // kept for the logs not replayed yet, along with the entries
+                // written after them
+                return ss::now();
+            }
+            // the segments of the closed logs are flushed
+            for (auto& seg : _closed) {
+                seg->materialized = true;
+            }
+            return remove_materialized_segments();
+        });
+    });
+}
+
+void shared_wal::append(const model::ntp& ntp, const model::record_batch& b) {
+    if (_gate.is_closed()) {
+        return;
+    }
+    _pending_bytes += b.size_bytes();
+    _pending.push_back(
+      entry{.type = entry::kind::batch, .ntp = ntp, .batch = b.copy()});
+    maybe_dispatch_flush();
+}
+
+ss::future<> shared_wal::flush() {
+    if (_gate.is_closed()) {
+        return ss::make_exception_future<>(ss::gate_closed_exception());
+    }
+    if (_pending.empty() && !_flush_in_flight) {
+        return ss::now();
+    }
+    if (!_next_flush) {
+        _next_flush = ss::make_lw_shared<ss::shared_promise<>>();
+    }
+    auto f = _next_flush->get_shared_future();
+    maybe_dispatch_flush();
+    return f;
+}
+
+ss::future<> shared_wal::truncate(const model::ntp& ntp, model::offset o) {
+    return enqueue(
+      entry{.type = entry::kind::truncation, .ntp = ntp, .offset = o});
+}
+
+ss::future<> shared_wal::detach(const model::ntp& ntp) {
+    vlog(stlog.debug, "Detaching {} from the shared wal", ntp);
+    return enqueue(entry{.type = entry::kind::detach, .ntp = ntp});
+}
+
+ss::future<> shared_wal::enqueue(entry e) {
+    if (_gate.is_closed()) {
+        return ss::make_exception_future<>(ss::gate_closed_exception());
+    }
+    _pending.push_back(std::move(e));
+    return flush();
+}
+
+void shared_wal::maybe_dispatch_flush() {
+    if (
+      _flush_in_flight || _gate.is_closed()
+      || (!_next_flush && _pending_bytes < max_pending_bytes)) {
+        return;
+    }
+    _flush_in_flight = true;
+    auto done = std::exchange(_next_flush, nullptr);
+    auto entries = std::exchange(_pending, {});
+    _pending_bytes = 0;
+    (void)ss::with_gate(
+      _gate, [this, done, entries = std::move(entries)]() mutable {
+          return write_pending(std::move(entries))
+            .then_wrapped([this, done](ss::future<> f) {
+                _flush_in_flight = false;
+                if (f.failed()) {
+                    auto e = f.get_exception();
+                    vlog(stlog.error, "Failed to flush the shared wal: {}", e);
+                    if (done) {
+                        done->set_exception(e);
+                    }
+                } else if (done) {
+                    done->set_value();
+                }
+                // the entries queued meanwhile make up the next flush
+                maybe_dispatch_flush();
+            });
+      });
+}
+
+ss::future<> shared_wal::write_pending(std::vector<entry> entries) {
+    if (entries.empty()) {
+        return ss::now();
+    }
+    return roll().then([this, entries = std::move(entries)]() mutable {
+        // all the entries of the flush are a single batch of the wal
+        storage::record_batch_builder builder(
+          shared_wal_batch_type, _next_offset);
+        for (auto& e : entries) {
+            _dirty.insert(e.ntp);
+            auto key = reflection::to_iobuf(e.ntp);
+            builder.add_raw_kv(std::move(key), encode(std::move(e)));
+        }
+        auto batch = std::move(builder).build();
+        auto last_offset = batch.last_offset();
+        return _segment->append(std::move(batch))
+          .then([this](append_result) { return _segment->flush(); })
+          .then([this, last_offset] {
+              _next_offset = last_offset + model::offset(1);
+          });
+    });
+}
+
+iobuf shared_wal::encode(entry e) {
+    iobuf value;
+    reflection::serialize(value, static_cast<int8_t>(e.type));
+    switch (e.type) {
+    case entry::kind::batch: {
+        auto header = e.batch->header();
+        reflection::serialize(
+          value, header, std::move(*e.batch).release_data());
+        break;
+    }
+    case entry::kind::truncation:
+        reflection::serialize(value, e.offset);
+        break;
+    case entry::kind::detach:
+        break;
+    }
+    return value;
+}
+
+shared_wal::entry shared_wal::decode(iobuf key, iobuf value) {
+    entry e;
+    e.ntp = reflection::from_iobuf<model::ntp>(std::move(key));
+    iobuf_parser parser(std::move(value));
+    e.type = static_cast<entry::kind>(reflection::adl<int8_t>{}.from(parser));
+    switch (e.type) {
+    case entry::kind::batch: {
+        auto header = reflection::adl<model::record_batch_header>{}.from(
+          parser);
+        auto records = reflection::adl<iobuf>{}.from(parser);
+        e.batch = model::record_batch(
+          header, std::move(records), model::record_batch::tag_ctor_ng{});
+        break;
+    }
+    case entry::kind::truncation:
+        e.offset = reflection::adl<model::offset>{}.from(parser);
+        break;
+    case entry::kind::detach:
+        break;
+    }
+    return e;
+}
+
+ss::future<> shared_wal::roll() {
+    if (!_segment) {
+        return make_active_segment();
+    }
+    if (_segment->appender().file_byte_offset() <= _conf.max_segment_size) {
+        return ss::now();
+    }
+    vlog(
+      stlog.debug,
+      "Rolling shared wal segment with base offset {} size {}",
+      _segment->offsets().base_offset,
+      _segment->appender().file_byte_offset());
+    // cleared first, so that stop() does not close the segment again
+    auto seg = std::exchange(_segment, nullptr);
+    auto closed = ss::make_lw_shared<closed_segment>();
+    closed->files = {seg->reader().filename(), seg->index().filename()};
+    closed->dirty = std::exchange(_dirty, {});
+    return seg->close().then([this, seg, closed] {
+        _closed.push_back(closed);
+        start_checkpoints();
+        return make_active_segment();
+    });
+}
+
+ss::future<> shared_wal::make_active_segment() {
+    return make_segment(
+             _ntpc,
+             _next_offset,
+             model::term_id(0),
+             ss::default_priority_class(),
+             record_version_type::v1,
+             default_segment_readahead_size,
+             _conf.sanitize_fileops,
+             std::nullopt)
+      .then([this](ss::lw_shared_ptr<segment> seg) {
+          _segment = std::move(seg);
+      });
+}
+
+void shared_wal::start_checkpoints() {
+    if (_gate.is_closed()) {
+        return;
+    }
+    // the segments whose checkpoint failed are retried along the new one
+    for (auto& seg : _closed) {
+        if (
+          seg == _recovered_segments || seg->checkpointing
+          || seg->materialized) {
+            continue;
+        }
+        seg->checkpointing = true;
+        (void)ss::with_gate(_gate, [this, seg] { return checkpoint(seg); })
+          .handle_exception([](std::exception_ptr e) {
+              vlog(stlog.warn, "Shared wal checkpoint failed: {}", e);
+          });
+    }
+}
+
+ss::future<>
+shared_wal::checkpoint(ss::lw_shared_ptr<closed_segment> closed) {
+    vlog(
+      stlog.debug,
+      "Flushing the segments of {} logs of a shared wal segment",
+      closed->dirty.size());
+    return ss::parallel_for_each(
+             closed->dirty,
+             [this](const model::ntp& ntp) { return _materialize(ntp); })
+      .then_wrapped([this, closed](ss::future<> f) {
+          closed->checkpointing = false;
+          if (f.failed()) {
+              // kept until a later checkpoint succeeds
+              return ss::make_exception_future<>(f.get_exception());
+          }
+          closed->materialized = true;
+          closed->dirty.clear();
+          return remove_materialized_segments();
+      });
+}
+
+ss::future<> shared_wal::remove_materialized_segments() {
+    if (_removing) {
+        // the removal in progress goes on with the segments materialized since
+        return ss::now();
+    }
+    _removing = true;
+    // in order: the truncations of a segment must not be lost while the
+    // batches written before them may still be replayed
+    return ss::do_until(
+             [this] {
+                 return _closed.empty() || !_closed.front()->materialized;
+             },
+             [this] {
+                 auto closed = _closed.front();
+                 _closed.pop_front();
+                 if (closed == _recovered_segments) {
+                     _recovered_segments = nullptr;
+                 }
+                 return ss::do_for_each(
+                          closed->files,
+                          [](const ss::sstring& f) {
+                              vlog(stlog.debug, "Removing {}", f);
+                              return ss::remove_file(f);
+                          })
+                   .finally([closed] {});
+             })
+      .finally([this] { _removing = false; });
+}
+
+ss::future<> shared_wal::recover() {
+    return ss::async([this] {
+        auto segments = recover_segments(
+                          std::filesystem::path(_ntpc.work_directory()),
+                          _conf.sanitize_fileops,
+                          false,
+                          [] { return std::nullopt; },
+                          _as)
+                          .get0();
+        if (segments.empty()) {
+            return;
+        }
+        vlog(
+          stlog.info,
+          "Recovering {} shared wal segments from offset {}",
+          segments.size(),
+          segments.front()->offsets().base_offset);
+
+        auto recovered = ss::make_lw_shared<closed_segment>();
+        for (auto& seg : segments) {
+            auto input = seg->reader().data_stream(
+              0, ss::default_priority_class());
+            auto parser = std::make_unique<continuous_batch_parser>(
+              std::make_unique<replay_consumer>(this), std::move(input));
+            auto p = parser.get();
+            p->consume()
+              .discard_result()
+              .finally([parser = std::move(parser)] {})
+              .get();
+            // early out on shutdown
+            _gate.check();
+
+            // an empty segment would have the base offset of the next one
+            _next_offset = std::max(
+              _next_offset, seg->offsets().base_offset + model::offset(1));
+            seg->close().get();
+            recovered->files.push_back(seg->reader().filename());
+            recovered->files.push_back(seg->index().filename());
+        }
+
+        _recovered_segments = recovered;
+        _closed.push_back(std::move(recovered));
+        if (_recovered.empty()) {
+            drop_recovered();
+            return;
+        }
+        vlog(
+          stlog.info,
+          "Recovered the shared wal entries of {} logs",
+          _recovered.size());
+        _recovery_timer.arm(_conf.recovery_timeout);
+    });
+}
+
+void shared_wal::apply_recovered(entry e) {
+    if (e.type == entry::kind::detach) {
+        _recovered.erase(e.ntp);
+        return;
+    }
+    auto& entries = _recovered[e.ntp];
+    entries.push_back(std::move(e));
+}
+
+void shared_wal::drop_recovered() {
+    _recovery_timer.cancel();
+    if (!_recovered.empty()) {
+        vlog(
+          stlog.warn,
+          "Dropping the shared wal entries of {} logs not managed since the "
+          "start",
+          _recovered.size());
+        _recovered.clear();
+    }
+    if (!_recovered_segments || _gate.is_closed()) {
+        return;
+    }
+    _recovered_segments->materialized = true;
+    (void)ss::with_gate(
+      _gate, [this] { return remove_materialized_segments(); })
+      .handle_exception([](std::exception_ptr e) {
+          vlog(stlog.warn, "Failed to remove shared wal segments: {}", e);
+      });
+}
+
+ss::future<> shared_wal::replay(log l) {
+    auto it = _recovered.find(l.config().ntp());
+    if (it == _recovered.end()) {
+        return ss::now();
+    }
+    auto entries = std::move(it->second);
+    _recovered.erase(it);
+    vlog(
+      stlog.info,
+      "Replaying {} shared wal entries onto {}",
+      entries.size(),
+      l.config().ntp());
+    return ss::do_with(
+             std::move(entries),
+             [l](std::vector<entry>& entries) mutable {
+                 return ss::do_for_each(
+                          entries,
+                          [l](entry& e) mutable { return replay_entry(l, e); })
+                   .then([l]() mutable {
+                       // the batches appended are in the new segment of the
+                       // wal once flushed
+                       return l.flush();
+                   });
+             })
+      .finally([this] {
+          if (_recovered.empty()) {
+              drop_recovered();
+          }
+      });
+}
+
+ss::future<> shared_wal::replay_entry(log l, entry& e) {
+    const auto ofs = l.offsets();
+    if (e.type == entry::kind::truncation) {
+        if (e.offset > ofs.dirty_offset) {
+            return ss::now();
+        }
+        return l.truncate(
+          truncate_config(e.offset, ss::default_priority_class()));
+    }
+    // like log::make_appender()
+    auto next = ofs.dirty_offset >= model::offset(0)
+                  ? ofs.dirty_offset + model::offset(1)
+                  : std::max(ofs.start_offset, model::offset(0));
+    auto& batch = *e.batch;
+    if (batch.base_offset() < next) {
+        // durable in the segments of the log already
+        return ss::now();
+    }
+    if (batch.base_offset() > next || batch.term() < ofs.dirty_offset_term) {
+        vlog(
+          stlog.warn,
+          "Skipping shared wal batch {} of {}: the log ends at {}",
+          batch.header(),
+          l.config().ntp(),
+          ofs);
+        return ss::now();
+    }
+    auto cfg = log_append_config{
+      .should_fsync = log_append_config::fsync::no,
+      .io_priority = ss::default_priority_class(),
+      .timeout = model::no_timeout};
+    auto reader = model::make_memory_record_batch_reader(std::move(batch));
+    return std::move(reader)
+      .for_each_ref(l.make_appender(cfg), cfg.timeout)
+      .discard_result();
+}
+
+batch_consumer::consume_result
+shared_wal::replay_consumer::consume_batch_start(
+  model::record_batch_header header, size_t, size_t) {
+    if (_wal->_gate.is_closed()) {
+        // early out on shutdown
+        return stop_parser::yes;
+    }
+    _header = header;
+    return skip_batch::no;
+}
+
+void shared_wal::replay_consumer::consume_records(iobuf&& records) {
+    _records = std::move(records);
+}
+
+batch_consumer::stop_parser shared_wal::replay_consumer::consume_batch_end() {
+    model::record_batch batch(
+      _header, std::move(_records), model::record_batch::tag_ctor_ng{});
+    batch.for_each_record([this](model::record r) {
+        _wal->apply_recovered(decode(r.release_key(), r.release_value()));
+    });
+    _wal->_next_offset = _header.last_offset() + model::offset(1);
+    return stop_parser::no;
+}
+
+void shared_wal::replay_consumer::print(std::ostream& os) const {
+    os << "storage::shared_wal";
+}
+
+} // namespace storage
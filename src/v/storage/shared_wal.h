@@ -0,0 +1,200 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "model/fundamental.h"
+#include "model/record.h"
+#include "seastarx.h"
+#include "storage/log.h"
+#include "storage/ntp_config.h"
+#include "storage/parser.h"
+#include "storage/segment.h"
+#include "storage/types.h"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/timer.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace storage {
+
+static constexpr const model::record_batch_type shared_wal_batch_type(8);
+
+struct shared_wal_config {
+    ss::sstring base_dir;
+    // the segments of the wal roll, and checkpoint, at this size
+    size_t max_segment_size;
+    // the recovered entries of the logs that are not managed again by then
+    // are dropped
+    std::chrono::milliseconds recovery_timeout;
+    debug_sanitize_files sanitize_fileops;
+};
+
+/**
+ * Write-ahead log shared by the logs of a core.
+ *
+ * With many partitions of low throughput per core, the flushes of the logs
+ * are tiny writes spread over as many files, each with its own fdatasync.
+ * With the shared wal, the batches appended to the logs of the core are also
+ * queued for the wal, and flushing a log flushes the wal instead of the
+ * segments of the log: the queued batches of all the logs are written one
+ * after the other and made durable by a single fdatasync. The segments of the
+ * logs are written as usual, but not flushed, so the readers of the logs are
+ * unchanged. As with the flush_coordinator, the batches queued while a flush
+ * is in flight make up the next one.
+ *
+ * Checkpoints
+ * ===========
+ *
+ * When the segment of the wal reaches its maximum size a new one is started,
+ * and the logs that wrote to the old one flush their segments in the
+ * background. The old segment is removed once they are done, and once the
+ * segments before it are removed: a truncation recorded in a segment must
+ * not be replayed without the batches that followed it.
+ *
+ * Recovery
+ * ========
+ *
+ * On start, the entries of the wal are read back per log and replayed onto
+ * the log when it is managed again: the truncations are applied in order and
+ * the batches past the end of the log are appended again, which also writes
+ * them to the new segment of the wal. The recovered segments are removed once
+ * every log they hold has been replayed, or after the recovery timeout for
+ * the logs not managed by the core anymore.
+ *
+ * A log that is removed or moved to another core is detached: its entries
+ * written so far are not replayed.
+ */
+class shared_wal {
+public:
+    /// flushes the segments of a log, if the core still manages it
+    using materialize_fn
+      = ss::noncopyable_function<ss::future<>(const model::ntp&)>;
+
+    shared_wal(shared_wal_config, materialize_fn);
+
+    /// \brief recovers the entries of the wal, to be replayed onto the logs
+    ss::future<> start();
+    /// \brief the logs must be closed, and their segments flushed, before
+    ss::future<> stop();
+
+    /// \brief queues the batch appended to the log for the next flush
+    void append(const model::ntp&, const model::record_batch&);
+    /// \brief resolves once the entries queued so far are durable
+    ss::future<> flush();
+    /// \brief records a suffix truncation of the log, which must be durable
+    /// before the segments of the log are truncated
+    ss::future<> truncate(const model::ntp&, model::offset);
+    /// \brief records that the log is removed or moved away
+    ss::future<> detach(const model::ntp&);
+
+    /// \brief replays the recovered entries of the log onto it
+    ss::future<> replay(log);
+
+    /// the logs with entries recovered but not replayed yet
+    size_t recovered_logs() const { return _recovered.size(); }
+
+private:
+    struct entry {
+        enum class kind : int8_t { batch = 0, truncation = 1, detach = 2 };
+
+        kind type;
+        model::ntp ntp;
+        // the base offset of a truncation
+        model::offset offset;
+        std::optional<model::record_batch> batch;
+    };
+
+    // a segment of the wal waiting to be removed
+    struct closed_segment {
+        std::vector<ss::sstring> files;
+        // the logs to flush the segments of before the removal
+        absl::flat_hash_set<model::ntp> dirty;
+        bool checkpointing{false};
+        bool materialized{false};
+    };
+
+    static iobuf encode(entry);
+    static entry decode(iobuf key, iobuf value);
+    static ss::future<> replay_entry(log, entry&);
+
+    ss::future<> enqueue(entry);
+    void maybe_dispatch_flush();
+    ss::future<> write_pending(std::vector<entry>);
+    ss::future<> roll();
+    ss::future<> make_active_segment();
+    void start_checkpoints();
+    ss::future<> checkpoint(ss::lw_shared_ptr<closed_segment>);
+    ss::future<> remove_materialized_segments();
+    void drop_recovered();
+
+    ss::future<> recover();
+    void apply_recovered(entry);
+
+    /// Reads the entries of the wal back, in recovery:
+    ///    segment -> parser -> replay_consumer -> _recovered
+    class replay_consumer final : public batch_consumer {
+    public:
+        explicit replay_consumer(shared_wal* wal)
+          : _wal(wal) {}
+
+        consume_result consume_batch_start(
+          model::record_batch_header header, size_t, size_t) override;
+        void consume_records(iobuf&&) override;
+        stop_parser consume_batch_end() override;
+        void print(std::ostream&) const override;
+
+    private:
+        shared_wal* _wal;
+        model::record_batch_header _header;
+        iobuf _records;
+    };
+
+    friend replay_consumer;
+
+    shared_wal_config _conf;
+    ntp_config _ntpc;
+    materialize_fn _materialize;
+    ss::gate _gate;
+    ss::abort_source _as;
+
+    // the entries queued for the next flush, which starts once the one in
+    // flight, if any, is done
+    std::vector<entry> _pending;
+    size_t _pending_bytes{0};
+    ss::lw_shared_ptr<ss::shared_promise<>> _next_flush;
+    bool _flush_in_flight{false};
+
+    ss::lw_shared_ptr<segment> _segment;
+    model::offset _next_offset{0};
+    // the logs with entries in the active segment
+    absl::flat_hash_set<model::ntp> _dirty;
+    // oldest first, the recovered segments, if any, in front
+    std::deque<ss::lw_shared_ptr<closed_segment>> _closed;
+    bool _removing{false};
+
+    absl::flat_hash_map<model::ntp, std::vector<entry>> _recovered;
+    ss::lw_shared_ptr<closed_segment> _recovered_segments;
+    ss::timer<ss::lowres_clock> _recovery_timer;
+};
+
+} // namespace storage
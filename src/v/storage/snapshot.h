@@ -17,6 +17,7 @@
 #include <seastar/core/file.hh>
 #include <seastar/core/fstream.hh>
 #include <seastar/core/seastar.hh>
+#include <seastar/core/sstring.hh>
 #include <seastar/util/log.hh>
 
 #include <filesystem>
@@ -35,6 +36,8 @@ class snapshot_writer;
  *    <dir>/
  *      - snapshot              <- current snapshot (optional)
  *      - snapshot.partial.ts   <- partially written snapshot
+ *
+ * where `snapshot` is the file name given to the manager.
  *      - ...
  *
  * Snapshots are initially created as `snapshot.partial.*` files. When a
@@ -89,13 +92,18 @@ class snapshot_writer;
  *       mgr.remove_partial_snapshots();
  */
 class snapshot_manager {
-    static constexpr const char* snapshot_filename = "snapshot";
-
 public:
+    static constexpr const char* default_snapshot_filename = "snapshot";
+
+    /// snapshots of several state machines may share a directory as long as
+    /// each of them uses its own file name
     snapshot_manager(
-      std::filesystem::path dir, ss::io_priority_class io_prio) noexcept
+      std::filesystem::path dir,
+      ss::io_priority_class io_prio,
+      ss::sstring filename = default_snapshot_filename) noexcept
       : _dir(std::move(dir))
-      , _io_prio(io_prio) {}
+      , _io_prio(io_prio)
+      , _filename(std::move(filename)) {}
 
     ss::future<std::optional<snapshot_reader>> open_snapshot();
 
@@ -103,7 +111,7 @@ public:
     ss::future<> finish_snapshot(snapshot_writer&);
 
     std::filesystem::path snapshot_path() const {
-        return _dir / snapshot_filename;
+        return _dir / _filename.c_str();
     }
 
     ss::future<> remove_partial_snapshots();
@@ -111,6 +119,7 @@ public:
 private:
     std::filesystem::path _dir;
     ss::io_priority_class _io_prio;
+    ss::sstring _filename;
 };
 
 /**
@@ -86,16 +86,21 @@ ss::future<> spill_key_index::add_key(bytes b, value_type v) {
                     node.mapped(),
                     [this](const bytes& k, value_type o) {
                         _keys_mem_usage -= k.size();
+                        update_memory();
                         return spill(compacted_index::entry_type::key, k, o);
                     });
               })
-              .then([this] { _midx.rehash(0); });
+              .then([this] {
+                  _midx.rehash(0);
+                  update_memory();
+              });
     }
 
     return f.then([this, b = std::move(b), v]() mutable {
         // convert iobuf to key
         _keys_mem_usage += b.size();
         _midx.insert({std::move(b), v});
+        update_memory();
     });
 }
 
@@ -180,6 +185,7 @@ ss::future<> spill_key_index::drain_all_keys() {
       [this] {
           auto node = _midx.extract(_midx.begin());
           _keys_mem_usage -= node.key().size();
+          update_memory();
           return ss::do_with(
             node.key(), node.mapped(), [this](const bytes& k, value_type o) {
                 return spill(compacted_index::entry_type::key, k, o);
@@ -13,6 +13,7 @@
 #include "bytes/bytes.h"
 #include "hashing/crc32c.h"
 #include "model/fundamental.h"
+#include "resource_mgmt/memory_accounting.h"
 #include "storage/compacted_index.h"
 #include "storage/compacted_index_writer.h"
 #include "storage/segment_appender.h"
@@ -71,6 +72,13 @@ private:
           HashtableDebugAccess<underlying_t>;
         return debug::AllocatedByteSize(_midx);
     }
+    /// accounts for the keys and the nodes of the map, and for its slots
+    /// as estimated from its capacity, as the exact size is not cheap
+    void update_memory() {
+        _memory.set(
+          _keys_mem_usage + _midx.size() * sizeof(underlying_t::value_type)
+          + _midx.bucket_count() * (sizeof(void*) + 1));
+    }
     ss::future<> drain_all_keys();
     ss::future<> add_key(bytes b, value_type);
     ss::future<> spill(compacted_index::entry_type, bytes_view, value_type);
@@ -79,6 +87,7 @@ private:
     underlying_t _midx;
     size_t _max_mem;
     size_t _keys_mem_usage{0};
+    tracked_memory _memory{tracked_memory::subsystem::compaction_index};
     compacted_index::footer _footer;
     crc32 _crc;
 
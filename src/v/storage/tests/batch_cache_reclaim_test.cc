@@ -19,6 +19,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <algorithm>
+#include <vector>
 
 static storage::batch_cache::reclaim_options opts = {
   .growth_window = std::chrono::milliseconds(3000),
@@ -121,3 +122,50 @@ FIXTURE_TEST(reclaim, fixture) {
       bytes_until_reclaim / 1024,
       stats.reclaims());
 }
+
+FIXTURE_TEST(background_reclaim, fixture) {
+    using namespace std::chrono_literals;
+
+    auto background_opts = opts;
+    background_opts.background = true;
+    storage::batch_cache cache(background_opts);
+    storage::batch_cache_index index(cache);
+    std::vector<storage::batch_cache::entry_ptr> cache_entries;
+
+    auto stats = ss::memory::stats();
+    BOOST_REQUIRE(stats.free_memory() > ss::memory::min_free_memory());
+    size_t pages_until_reclaim = (stats.free_memory()
+                                  - ss::memory::min_free_memory())
+                                 / ss::memory::page_size;
+    BOOST_TEST_REQUIRE(pages_until_reclaim > 20, "please run with more memory");
+    cache_entries.reserve(pages_until_reclaim + 10);
+
+    // allocate slightly past the low-memory threshold. the excess is served
+    // from the free memory reserve since nothing is reclaimed synchronously.
+    for (size_t i = 0; i < pages_until_reclaim + 10; i++) {
+        size_t buf_size = ss::memory::page_size - sizeof(model::record_batch);
+        auto e = cache.put(index, make_batch(buf_size));
+        BOOST_REQUIRE((bool)e);
+        cache_entries.emplace_back(std::move(e));
+    }
+
+    // the upcall only records pressure, so no entry has been reclaimed yet
+    BOOST_CHECK(std::all_of(
+      cache_entries.begin(),
+      cache_entries.end(),
+      [](storage::batch_cache::entry_ptr& e) { return (bool)e; }));
+
+    // give the upcall and the background fiber a chance to run
+    auto some_reclaimed = [&cache_entries] {
+        return std::any_of(
+          cache_entries.begin(),
+          cache_entries.end(),
+          [](storage::batch_cache::entry_ptr& e) { return !e; });
+    };
+    for (int i = 0; i < 100 && !some_reclaimed(); i++) {
+        ss::sleep(10ms).get();
+    }
+    BOOST_CHECK(some_reclaimed());
+
+    cache.stop().get();
+}
@@ -13,6 +13,8 @@
 
 #include <seastar/testing/thread_test_case.hh>
 
+#include <vector>
+
 static storage::batch_cache::reclaim_options opts = {
   .growth_window = std::chrono::milliseconds(3000),
   .stable_window = std::chrono::milliseconds(10000),
@@ -140,6 +142,76 @@ SEASTAR_THREAD_TEST_CASE(touch) {
     }
 }
 
+SEASTAR_THREAD_TEST_CASE(scan_resistance) {
+    static storage::batch_cache::reclaim_options opts = {
+      .growth_window = std::chrono::milliseconds(3000),
+      .stable_window = std::chrono::milliseconds(10000),
+      .min_size = 1,
+      .max_size = 1,
+    };
+
+    storage::batch_cache c(opts);
+    storage::batch_cache_index index(c);
+    auto hot = c.put(index, make_batch(10));
+    auto b0 = c.put(index, make_batch(10));
+
+    // a hit promotes the batch out of the probationary list
+    c.touch(hot);
+
+    // batches inserted by a scan are reclaimed before the hot batch, even
+    // though the hot batch is the least recently used one
+    std::vector<storage::batch_cache::entry_ptr> scan;
+    for (int i = 0; i < 4; ++i) {
+        scan.push_back(c.put(index, make_batch(10)));
+    }
+    for (int i = 0; i < 4; ++i) {
+        c.reclaim(1);
+    }
+    BOOST_CHECK(hot);
+    BOOST_CHECK(!b0);
+    BOOST_CHECK(!scan[0]);
+    BOOST_CHECK(!scan[1]);
+    BOOST_CHECK(!scan[2]);
+    BOOST_CHECK(scan[3]);
+}
+
+SEASTAR_THREAD_TEST_CASE(read_ahead_first_hit_not_promoted) {
+    static storage::batch_cache::reclaim_options opts = {
+      .growth_window = std::chrono::milliseconds(3000),
+      .stable_window = std::chrono::milliseconds(10000),
+      .min_size = 1,
+      .max_size = 1,
+    };
+
+    storage::batch_cache c(opts);
+    storage::batch_cache_index index(c);
+    auto prefetched = c.put(index, make_batch(10), true);
+    auto hot = c.put(index, make_batch(10));
+
+    c.touch(hot);
+    // the reader that prefetched the batch reads it
+    c.touch(prefetched);
+
+    c.reclaim(1);
+    BOOST_CHECK(!prefetched);
+    BOOST_CHECK(hot);
+}
+
+SEASTAR_THREAD_TEST_CASE(index_skips_oversized_batches) {
+    auto small = make_batch(1, model::offset(0));
+    auto large = make_batch(100, model::offset(1));
+    auto limited = opts;
+    limited.max_batch_size = small.size_bytes();
+
+    storage::batch_cache cache(limited);
+    storage::batch_cache_index index(cache);
+    index.put(small);
+    index.put(large);
+
+    BOOST_CHECK(index.get(model::offset(0)));
+    BOOST_CHECK(!index.get(model::offset(1)));
+}
+
 SEASTAR_THREAD_TEST_CASE(index_get_empty) {
     storage::batch_cache cache(opts);
     storage::batch_cache_index index(cache);
@@ -0,0 +1,96 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "config/configuration.h"
+#include "storage/cached_file.h"
+#include "utils/tmpbuf_file.h"
+
+#include <seastar/core/fstream.hh>
+#include <seastar/testing/thread_test_case.hh>
+#include <seastar/util/defer.hh>
+
+using namespace storage; // NOLINT
+
+struct test_file {
+    explicit test_file(ss::sstring content) {
+        auto out = ss::make_file_output_stream(
+          ss::file(ss::make_shared(tmpbuf_file(store))));
+        out.write(content).get();
+        out.close().get();
+        f = ss::make_lw_shared<cached_file>("test", [this] {
+            ++opens;
+            return ss::make_ready_future<ss::file>(
+              ss::file(ss::make_shared(tmpbuf_file(store))));
+        });
+    }
+
+    ss::sstring read(size_t pos = 0) {
+        auto in = f->make_input_stream(pos, store.size - pos, {});
+        auto buf = in.read_exactly(store.size - pos).get0();
+        in.close().get();
+        return ss::sstring(buf.get(), buf.size());
+    }
+
+    tmpbuf_file::store_t store;
+    cached_file_ptr f;
+    size_t opens{0};
+};
+
+SEASTAR_THREAD_TEST_CASE(test_opens_on_first_read) {
+    test_file a("hello world");
+    BOOST_REQUIRE(!a.f->is_open());
+    BOOST_REQUIRE_EQUAL(a.opens, 0);
+    BOOST_REQUIRE_EQUAL(a.read(6), "world");
+    BOOST_REQUIRE_EQUAL(a.read(), "hello world");
+    BOOST_REQUIRE_EQUAL(a.opens, 1);
+    a.f->close().get();
+    BOOST_REQUIRE(!a.f->is_open());
+}
+
+SEASTAR_THREAD_TEST_CASE(test_closes_least_recently_used) {
+    auto& max_open = config::shard_local_cfg().max_open_segment_files;
+    auto restore = ss::defer(
+      [&max_open, prev = max_open()] { max_open.set_value(prev); });
+    max_open.set_value(size_t(1));
+
+    test_file a("aaaa");
+    test_file b("bbbb");
+    const auto evictions = cached_file::shard_stats().evictions;
+    BOOST_REQUIRE_EQUAL(a.read(), "aaaa");
+    BOOST_REQUIRE_EQUAL(b.read(), "bbbb");
+    BOOST_REQUIRE(!a.f->is_open());
+    BOOST_REQUIRE(b.f->is_open());
+    BOOST_REQUIRE_EQUAL(cached_file::shard_stats().evictions, evictions + 1);
+
+    // opened again on its next read
+    BOOST_REQUIRE_EQUAL(a.read(), "aaaa");
+    BOOST_REQUIRE_EQUAL(a.opens, 2);
+
+    {
+        // a file read by a stream stays open
+        auto in = a.f->make_input_stream(0, a.store.size, {});
+        BOOST_REQUIRE_EQUAL(in.read_exactly(2).get0().size(), 2);
+        BOOST_REQUIRE_EQUAL(b.read(), "bbbb");
+        BOOST_REQUIRE(a.f->is_open());
+        BOOST_REQUIRE_EQUAL(in.read_exactly(2).get0().size(), 2);
+        in.close().get();
+    }
+
+    // and so does a pinned one
+    b.f->pin();
+    BOOST_REQUIRE_EQUAL(a.read(), "aaaa");
+    BOOST_REQUIRE(b.f->is_open());
+    // unpinned, it is the most recently used
+    b.f->unpin();
+    BOOST_REQUIRE(b.f->is_open());
+    BOOST_REQUIRE(!a.f->is_open());
+
+    a.f->close().get();
+    b.f->close().get();
+}
@@ -0,0 +1,153 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/coalescing_file.h"
+#include "units.h"
+#include "utils/tmpbuf_file.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <vector>
+
+using namespace storage; // NOLINT
+
+/// counts the bulk reads that reach the file
+class counting_file final : public ss::file_impl {
+public:
+    counting_file(ss::file f, size_t& reads)
+      : _file(std::move(f))
+      , _reads(reads) {}
+
+    ss::future<ss::temporary_buffer<uint8_t>> dma_read_bulk(
+      uint64_t offset,
+      size_t range_size,
+      const ss::io_priority_class& pc) final {
+        ++_reads;
+        return get_file_impl(_file)->dma_read_bulk(offset, range_size, pc);
+    }
+    ss::future<size_t> read_dma(
+      uint64_t pos,
+      void* buffer,
+      size_t len,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->read_dma(pos, buffer, len, pc);
+    }
+    ss::future<size_t> read_dma(
+      uint64_t pos,
+      std::vector<iovec> iov,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->read_dma(pos, std::move(iov), pc);
+    }
+    ss::future<size_t> write_dma(
+      uint64_t pos,
+      const void* buffer,
+      size_t len,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->write_dma(pos, buffer, len, pc);
+    }
+    ss::future<size_t> write_dma(
+      uint64_t pos,
+      std::vector<iovec> iov,
+      const ss::io_priority_class& pc) final {
+        return get_file_impl(_file)->write_dma(pos, std::move(iov), pc);
+    }
+    ss::future<> flush() final { return get_file_impl(_file)->flush(); }
+    ss::future<struct stat> stat() final {
+        return get_file_impl(_file)->stat();
+    }
+    ss::future<> truncate(uint64_t length) final {
+        return get_file_impl(_file)->truncate(length);
+    }
+    ss::future<> discard(uint64_t offset, uint64_t length) final {
+        return get_file_impl(_file)->discard(offset, length);
+    }
+    ss::future<> allocate(uint64_t position, uint64_t length) final {
+        return get_file_impl(_file)->allocate(position, length);
+    }
+    ss::future<uint64_t> size() final { return get_file_impl(_file)->size(); }
+    ss::future<> close() final { return get_file_impl(_file)->close(); }
+    std::unique_ptr<ss::file_handle_impl> dup() final {
+        return get_file_impl(_file)->dup();
+    }
+    ss::subscription<ss::directory_entry> list_directory(
+      std::function<ss::future<>(ss::directory_entry de)> next) final {
+        return get_file_impl(_file)->list_directory(std::move(next));
+    }
+
+private:
+    ss::file _file;
+    size_t& _reads;
+};
+
+struct coalescing_fixture {
+    static constexpr size_t file_size = 64_KiB;
+
+    coalescing_fixture() {
+        auto f = ss::file(ss::make_shared(tmpbuf_file(store)));
+        std::vector<char> data(file_size);
+        for (size_t i = 0; i < file_size; ++i) {
+            data[i] = static_cast<char>(i % 251);
+        }
+        f.dma_write(0, data.data(), data.size(), ss::default_priority_class())
+          .get();
+        file = ss::file(ss::make_shared<coalescing_file>(
+          ss::file(ss::make_shared<counting_file>(f, reads)), 16_KiB));
+    }
+
+    ~coalescing_fixture() { file.close().get(); }
+
+    /// reads the ranges concurrently, and checks their content
+    void read_all(std::vector<std::pair<uint64_t, size_t>> ranges) {
+        std::vector<ss::future<ss::temporary_buffer<uint8_t>>> reads;
+        for (auto [pos, len] : ranges) {
+            reads.push_back(file.dma_read_bulk<uint8_t>(
+              pos, len, ss::default_priority_class()));
+        }
+        auto bufs = ss::when_all_succeed(reads.begin(), reads.end()).get0();
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            auto [pos, len] = ranges[i];
+            auto expected = std::min(len, file_size - std::min(pos, file_size));
+            BOOST_REQUIRE_EQUAL(bufs[i].size(), expected);
+            for (size_t j = 0; j < bufs[i].size(); ++j) {
+                BOOST_REQUIRE_EQUAL(
+                  bufs[i][j], static_cast<uint8_t>((pos + j) % 251));
+            }
+        }
+    }
+
+    tmpbuf_file::store_t store;
+    size_t reads{0};
+    ss::file file;
+};
+
+SEASTAR_THREAD_TEST_CASE(adjacent_reads_are_merged) {
+    coalescing_fixture f;
+    f.read_all({{0, 4_KiB}, {4_KiB, 4_KiB}, {2_KiB, 4_KiB}, {8_KiB, 1_KiB}});
+    BOOST_REQUIRE_EQUAL(f.reads, 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(distant_reads_are_not_merged) {
+    coalescing_fixture f;
+    f.read_all({{0, 4_KiB}, {32_KiB, 4_KiB}});
+    BOOST_REQUIRE_EQUAL(f.reads, 2);
+}
+
+SEASTAR_THREAD_TEST_CASE(merged_reads_are_bounded) {
+    coalescing_fixture f;
+    f.read_all({{0, 8_KiB}, {8_KiB, 8_KiB}, {16_KiB, 8_KiB}});
+    BOOST_REQUIRE_EQUAL(f.reads, 2);
+}
+
+SEASTAR_THREAD_TEST_CASE(merged_reads_past_the_end) {
+    coalescing_fixture f;
+    f.read_all({{60_KiB, 4_KiB}, {62_KiB, 4_KiB}});
+    BOOST_REQUIRE_EQUAL(f.reads, 1);
+}
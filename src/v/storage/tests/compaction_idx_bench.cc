@@ -39,3 +39,21 @@ PERF_TEST_F(reducer_bench, compaction_key_reducer_test) {
         perf_tests::stop_measuring_time();
     });
 }
+
+struct hash_reducer_bench {
+    storage::internal::compaction_hash_key_reducer reducer{
+      storage::internal::compaction_key_reducer::default_max_memory_usage};
+};
+
+PERF_TEST_F(hash_reducer_bench, compaction_hash_key_reducer_test) {
+    model::offset o{0};
+    auto key = random_generators::get_bytes(20);
+
+    storage::compacted_index::entry entry(
+      storage::compacted_index::entry_type::key, std::move(key), o, 0);
+
+    perf_tests::start_measuring_time();
+    return reducer(std::move(entry)).discard_result().finally([] {
+        perf_tests::stop_measuring_time();
+    });
+}
@@ -15,6 +15,7 @@
 #include "storage/compacted_index_reader.h"
 #include "storage/compacted_index_writer.h"
 #include "storage/compaction_reducers.h"
+#include "storage/hashed_key_index.h"
 #include "storage/segment_utils.h"
 #include "storage/spill_key_index.h"
 #include "test_utils/fixture.h"
@@ -24,6 +25,9 @@
 
 #include <boost/test/unit_test_suite.hpp>
 
+#include <algorithm>
+#include <vector>
+
 struct compacted_topic_fixture {};
 FIXTURE_TEST(format_verification, compacted_topic_fixture) {
     tmpbuf_file::store_t index_data;
@@ -344,3 +348,80 @@ FIXTURE_TEST(index_filtered_copy_tests, compacted_topic_fixture) {
         }
     }
 }
+
+FIXTURE_TEST(hash_key_reducer, compacted_topic_fixture) {
+    tmpbuf_file::store_t index_data;
+    auto idx = storage::make_file_backed_compacted_index(
+      "dummy name",
+      ss::file(ss::make_shared(tmpbuf_file(index_data))),
+      ss::default_priority_class(),
+      // FORCE eviction with every key basically
+      1_KiB);
+
+    const auto key1 = random_generators::get_bytes(1_KiB);
+    const auto key2 = random_generators::get_bytes(1_KiB);
+    for (auto i = 0; i < 100; ++i) {
+        bytes_view put_key;
+        if (i % 2) {
+            put_key = key1;
+        } else {
+            put_key = key2;
+        }
+        idx.index(put_key, model::offset(i), 0).get();
+    }
+    idx.close().get();
+
+    auto rdr = storage::make_file_backed_compacted_reader(
+      "dummy name",
+      ss::file(ss::make_shared(tmpbuf_file(index_data))),
+      ss::default_priority_class(),
+      32_KiB);
+    rdr.verify_integrity().get();
+    rdr.reset();
+    // the memory of the hashed index does not depend on the key sizes
+    auto key_bitmap = rdr
+                        .consume(
+                          storage::internal::compaction_hash_key_reducer(
+                            1_KiB),
+                          model::no_timeout)
+                        .get0();
+
+    info("key bitmap: {}", key_bitmap.toString());
+    BOOST_REQUIRE_EQUAL(key_bitmap.cardinality(), 2);
+    BOOST_REQUIRE(key_bitmap.contains(98));
+    BOOST_REQUIRE(key_bitmap.contains(99));
+}
+
+FIXTURE_TEST(hashed_key_index_eviction, compacted_topic_fixture) {
+    using index_t = storage::internal::hashed_key_index;
+    index_t idx(index_t::min_capacity * index_t::slot_size);
+    BOOST_REQUIRE_EQUAL(idx.capacity(), index_t::min_capacity);
+
+    std::vector<bytes> keys;
+    while (!idx.needs_eviction()) {
+        keys.push_back(random_generators::get_bytes(16));
+        const index_t::key_hash k(keys.back());
+        auto& s = idx.find(k);
+        BOOST_REQUIRE_EQUAL(s.hash, 0);
+        const auto i = static_cast<uint32_t>(keys.size() - 1);
+        idx.insert(s, k, model::offset(i), i);
+    }
+    BOOST_REQUIRE_EQUAL(idx.size(), keys.size());
+
+    // every remaining key is still found after evictions shift slots back
+    std::vector<uint32_t> evicted;
+    while (!idx.evicted_enough()) {
+        evicted.push_back(idx.evict(random_generators::get_int<size_t>(
+          0, idx.capacity() - 1)));
+    }
+    BOOST_REQUIRE_EQUAL(idx.size() + evicted.size(), keys.size());
+    for (uint32_t i = 0; i < keys.size(); ++i) {
+        auto& s = idx.find(index_t::key_hash(keys[i]));
+        const bool was_evicted = std::count(
+          evicted.begin(), evicted.end(), i);
+        BOOST_REQUIRE_EQUAL(s.hash == 0, was_evicted);
+        if (!was_evicted) {
+            BOOST_REQUIRE_EQUAL(s.natural_index, i);
+        }
+    }
+}
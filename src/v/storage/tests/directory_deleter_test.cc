@@ -0,0 +1,86 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/directory_deleter.h"
+#include "storage/tests/utils/disk_log_builder.h"
+#include "test_utils/async.h"
+#include "utils/directory_walker.h"
+
+#include <seastar/core/seastar.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <chrono>
+#include <fstream>
+
+using namespace std::chrono_literals; // NOLINT
+using namespace storage;              // NOLINT
+
+static std::filesystem::path
+make_log_dir(const ss::sstring& base, std::string_view name) {
+    auto dir = std::filesystem::path(base.c_str()) / "kafka" / "tapioca"
+               / std::string(name);
+    std::filesystem::create_directories(dir / "nested");
+    std::ofstream(dir / "0-1-v1.log") << "0123456789";
+    std::ofstream(dir / "nested" / "0-1-v1.base_index") << "01234";
+    return dir;
+}
+
+static std::filesystem::path trash_of(const ss::sstring& base) {
+    return std::filesystem::path(base.c_str())
+           / std::string(directory_deleter::trash_dir_name);
+}
+
+static void wait_until_empty(const std::filesystem::path& trash) {
+    tests::cooperative_spin_wait_with_timeout(
+      5s, [&trash] { return directory_walker::empty(trash); })
+      .get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_removes_directory_in_background) {
+    auto base = random_dir();
+    auto dir = make_log_dir(base, "0_1");
+    directory_deleter deleter(std::nullopt);
+
+    deleter.remove(dir, base).get();
+    // renamed out of the way right away
+    BOOST_REQUIRE(!ss::file_exists(dir.string()).get0());
+    wait_until_empty(trash_of(base));
+    BOOST_REQUIRE_EQUAL(deleter.pending(), 0);
+    BOOST_REQUIRE_EQUAL(deleter.removed_bytes(), 15);
+
+    // a log of the same name is removed again
+    dir = make_log_dir(base, "0_1");
+    deleter.remove(dir, base).get();
+    wait_until_empty(trash_of(base));
+    BOOST_REQUIRE_EQUAL(deleter.removed_bytes(), 30);
+    deleter.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_recovers_trash) {
+    auto base = random_dir();
+    auto dir = make_log_dir(base, "0_1");
+    auto trash = trash_of(base);
+    std::filesystem::create_directories(trash);
+    std::filesystem::rename(dir, trash / "left_behind");
+
+    directory_deleter deleter(std::nullopt);
+    deleter.recover({base}).get();
+    wait_until_empty(trash);
+    BOOST_REQUIRE_EQUAL(deleter.removed_bytes(), 15);
+    deleter.stop().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_stop_leaves_queued_directories) {
+    auto base = random_dir();
+    // a byte per second: the first file stalls the removal
+    directory_deleter deleter(1);
+    deleter.remove(make_log_dir(base, "0_1"), base).get();
+    deleter.stop().get();
+    BOOST_REQUIRE(!directory_walker::empty(trash_of(base)).get0());
+}
@@ -0,0 +1,62 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "random/generators.h"
+#include "storage/index_search.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Lookups in the relative offset index of a large segment indexed with a small
+ * data buffer step, e.g. a 1GiB segment indexed every 4KiB.
+ */
+struct index_search_bench {
+    static constexpr size_t entries = 256 * 1024;
+    static constexpr size_t lookups = 1024;
+
+    index_search_bench() {
+        index.reserve(entries);
+        uint32_t offset = 0;
+        for (size_t i = 0; i < entries; ++i) {
+            offset += random_generators::get_int<uint32_t>(1, 64);
+            index.push_back(offset);
+        }
+        needles.reserve(lookups);
+        for (size_t i = 0; i < lookups; ++i) {
+            needles.push_back(random_generators::get_int<uint32_t>(offset));
+        }
+    }
+
+    std::vector<uint32_t> index;
+    std::vector<uint32_t> needles;
+};
+
+PERF_TEST_F(index_search_bench, std_upper_bound) {
+    size_t acc = 0;
+    perf_tests::start_measuring_time();
+    for (auto needle : needles) {
+        acc += std::distance(
+          index.begin(), std::upper_bound(index.begin(), index.end(), needle));
+    }
+    perf_tests::do_not_optimize(acc);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(index_search_bench, index_upper_bound) {
+    size_t acc = 0;
+    perf_tests::start_measuring_time();
+    for (auto needle : needles) {
+        acc += storage::details::index_upper_bound(index, needle);
+    }
+    perf_tests::do_not_optimize(acc);
+    perf_tests::stop_measuring_time();
+}
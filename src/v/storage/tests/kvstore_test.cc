@@ -11,8 +11,11 @@
 #include "reflection/adl.h"
 #include "storage/kvstore.h"
 
+#include <seastar/core/when_all.hh>
 #include <seastar/testing/thread_test_case.hh>
 
+#include <filesystem>
+
 template<typename T>
 static void set_configuration(ss::sstring p_name, T v) {
     ss::smp::invoke_on_all([p_name, v = std::move(v)] {
@@ -201,3 +204,53 @@ SEASTAR_THREAD_TEST_CASE(kvstore) {
     }
     kvs->stop().get();
 }
+
+SEASTAR_THREAD_TEST_CASE(kvstore_rolls_while_writing) {
+    set_configuration("disable_metrics", true);
+
+    auto dir = fmt::format("kvstore_test_{}", random_generators::get_int(4000));
+
+    auto conf = get_conf(dir);
+
+    std::unordered_map<bytes, iobuf> truth;
+
+    auto kvs = std::make_unique<storage::kvstore>(conf);
+    kvs->start().get();
+    // concurrent puts of all the key spaces, each flush rolling the segment
+    for (int round = 0; round < 20; round++) {
+        std::vector<ss::future<>> puts;
+        for (int i = 0; i < 20; i++) {
+            auto key = random_generators::get_bytes(4);
+            auto value = bytes_to_iobuf(random_generators::get_bytes(1000));
+            auto ks = i % 2 ? storage::kvstore::key_space::testing
+                            : storage::kvstore::key_space::consensus;
+            truth[key] = value.copy();
+            puts.push_back(kvs->put(ks, key, std::move(value)));
+        }
+        ss::when_all_succeed(puts.begin(), puts.end()).get();
+    }
+    kvs->stop().get();
+    kvs.reset(nullptr);
+
+    // the segments covered by the snapshots were removed
+    size_t segments = 0;
+    for (auto& e : std::filesystem::recursive_directory_iterator(dir)) {
+        segments += e.path().extension() == ".log";
+    }
+    BOOST_REQUIRE_LE(segments, size_t(3));
+
+    kvs = std::make_unique<storage::kvstore>(conf);
+    kvs->start().get();
+    size_t found = 0;
+    for (auto& e : truth) {
+        for (auto ks : {storage::kvstore::key_space::testing,
+                        storage::kvstore::key_space::consensus}) {
+            if (auto v = kvs->get(ks, e.first)) {
+                BOOST_REQUIRE(*v == e.second);
+                ++found;
+            }
+        }
+    }
+    BOOST_REQUIRE_EQUAL(found, truth.size());
+    kvs->stop().get();
+}
@@ -114,3 +114,44 @@ SEASTAR_THREAD_TEST_CASE(test_can_load_logs) {
     BOOST_CHECK(
       file_exists(seg4->reader().filename() + ".cannotrecover").get0());
 }
+
+SEASTAR_THREAD_TEST_CASE(test_spread_logs_across_data_directories) {
+    auto conf = make_config();
+    conf.extra_dirs = {"test.dir.extra"};
+    storage::api store(
+      storage::kvstore_config(
+        1_MiB, 10ms, conf.base_dir, storage::debug_sanitize_files::yes),
+      conf);
+    store.start().get();
+    auto stop_kvstore = ss::defer([&store] { store.stop().get(); });
+    auto& m = store.log_mgr();
+
+    // the extra directory holds the log of ntps[1] already
+    std::vector<model::ntp> ntps;
+    for (int i = 0; i < 3; ++i) {
+        ntps.emplace_back("spread", "topic", i);
+    }
+    directories::initialize(
+      ntp_config(ntps[1], "test.dir.extra").work_directory())
+      .get();
+
+    for (auto& ntp : ntps) {
+        m.manage(config_from_ntp(ntp)).get();
+    }
+    auto dir_of = [&m](const model::ntp& ntp) {
+        return m.get(ntp)->config().base_directory();
+    };
+    BOOST_CHECK_EQUAL(dir_of(ntps[0]), "test.dir");
+    BOOST_CHECK_EQUAL(dir_of(ntps[1]), "test.dir.extra");
+    BOOST_CHECK_EQUAL(dir_of(ntps[2]), "test.dir");
+
+    // reopened where they were created
+    m.shutdown(ntps[1]).get();
+    m.manage(config_from_ntp(ntps[1])).get();
+    BOOST_CHECK_EQUAL(dir_of(ntps[1]), "test.dir.extra");
+
+    // a new log goes to the least loaded directory
+    m.manage(config_from_ntp(model::ntp("spread", "topic", 3))).get();
+    BOOST_CHECK_EQUAL(
+      dir_of(model::ntp("spread", "topic", 3)), "test.dir.extra");
+}
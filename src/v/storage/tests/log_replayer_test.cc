@@ -13,6 +13,7 @@
 #include "storage/disk_log_appender.h"
 #include "storage/log_replayer.h"
 #include "storage/logger.h"
+#include "storage/recovery_checkpoint.h"
 #include "storage/segment_appender_utils.h"
 #include "storage/segment_index.h"
 #include "storage/segment_reader.h"
@@ -195,3 +196,56 @@ SEASTAR_THREAD_TEST_CASE(test_reset_index) {
     storage::stlog.info("Recovered segment:{}", ctx._seg);
     BOOST_CHECK(ctx._seg->index().needs_persistence());
 }
+
+SEASTAR_THREAD_TEST_CASE(test_recover_from_checkpoint) {
+    context ctx;
+    auto batches = test::make_random_batches(model::offset(1), 10);
+    // a prefix covered by the checkpoint is not verified again
+    batches[2].header().crc = 10;
+    size_t file_pos = 0;
+    for (size_t i = 0; i < 5; ++i) {
+        file_pos += batches[i].header().size_bytes;
+    }
+    auto ckpt = recovery_checkpoint{
+      .file_pos = file_pos,
+      .last_offset = batches[4].last_offset(),
+      .max_timestamp = batches[4].header().max_timestamp};
+    auto last_offset = batches.back().last_offset();
+    ctx.write(batches);
+    // the index written along with the checkpoint, as by segment::append
+    size_t pos = 0;
+    for (const auto& b : batches) {
+        ctx._seg->index().maybe_track(b.header(), pos);
+        pos += b.header().size_bytes;
+    }
+    ctx._seg->index().flush().get();
+    ckpt.index_checksum = ctx._seg->index().checksum();
+    auto path = recovery_checkpoint::path_of(ctx.base_name);
+    ckpt.write(path).get();
+    auto recovered = ctx.replayer().recover_in_thread(
+      ss::default_priority_class());
+    ss::remove_file(path.string()).get();
+    BOOST_CHECK(bool(recovered));
+    BOOST_CHECK_EQUAL(recovered.last_offset.value(), last_offset);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_ignore_stale_checkpoint) {
+    context ctx;
+    auto batches = test::make_random_batches(model::offset(1), 10);
+    batches[2].header().crc = 10;
+    auto ckpt = recovery_checkpoint{
+      .file_pos = batches[0].header().size_bytes,
+      .last_offset = batches[0].last_offset(),
+      .max_timestamp = batches[0].header().max_timestamp,
+      // not the checksum of the index on disk
+      .index_checksum = 0};
+    ctx.write(batches);
+    ctx._seg->index().flush().get();
+    auto path = recovery_checkpoint::path_of(ctx.base_name);
+    ckpt.write(path).get();
+    auto recovered = ctx.replayer().recover_in_thread(
+      ss::default_priority_class());
+    ss::remove_file(path.string()).get();
+    BOOST_CHECK(bool(recovered));
+    BOOST_CHECK_EQUAL(recovered.last_offset.value(), batches[1].last_offset());
+}
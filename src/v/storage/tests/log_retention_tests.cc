@@ -7,7 +7,9 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "storage/log.h"
 #include "storage/tests/utils/disk_log_builder.h"
+#include "storage/tests/utils/random_batch.h"
 // fixture
 #include "test_utils/fixture.h"
 
@@ -93,3 +95,77 @@ FIXTURE_TEST(retention_test_after_truncation, gc_fixture) {
     BOOST_CHECK_EQUAL(
       builder.get_disk_log_impl().get_probe().partition_size(), 0);
 }
+
+FIXTURE_TEST(reclaim_oldest_segment_test, gc_fixture) {
+    builder | storage::start() | storage::add_segment(0)
+      | storage::add_random_batch(0, 100, storage::maybe_compress_batches::yes)
+      | storage::add_segment(100)
+      | storage::add_random_batch(100, 2, storage::maybe_compress_batches::yes)
+      | storage::add_segment(102) | storage::add_random_batches(102, 3);
+    ss::abort_source as;
+    BOOST_TEST_MESSAGE("Should not reclaim segments above collectible offset");
+    BOOST_REQUIRE(!builder.get_log().oldest_reclaimable_segment());
+    BOOST_CHECK_EQUAL(
+      builder.get_log().reclaim_oldest_segment(as).get0(), size_t(0));
+    BOOST_CHECK_EQUAL(builder.get_log().segment_count(), 3);
+
+    builder.get_log().set_collectible_offset(
+      builder.get_log().offsets().dirty_offset);
+    BOOST_REQUIRE(builder.get_log().oldest_reclaimable_segment());
+    const auto front_size
+      = builder.get_disk_log_impl().segments().front()->size_bytes();
+    BOOST_CHECK_EQUAL(
+      builder.get_log().reclaim_oldest_segment(as).get0(), front_size);
+    BOOST_CHECK_EQUAL(builder.get_log().segment_count(), 2);
+    BOOST_CHECK_EQUAL(
+      builder.get_log().offsets().start_offset, model::offset(100));
+
+    BOOST_TEST_MESSAGE("Should leave the active segment");
+    builder.get_log().reclaim_oldest_segment(as).get();
+    BOOST_REQUIRE(!builder.get_log().oldest_reclaimable_segment());
+    BOOST_CHECK_EQUAL(
+      builder.get_log().reclaim_oldest_segment(as).get0(), size_t(0));
+    builder | storage::stop();
+    BOOST_CHECK_EQUAL(builder.get_log().segment_count(), 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(memory_log_budget_test) {
+    auto overrides = std::make_unique<storage::ntp_config::default_overrides>();
+    overrides->in_memory = true;
+    auto budget = ss::make_lw_shared<storage::memory_log_budget>(1);
+    {
+        auto log = storage::make_memory_backed_log(
+          storage::ntp_config(
+            model::ntp("test", "memory", 0), "base", std::move(overrides)),
+          budget);
+        auto append = [&log](model::offset o) {
+            auto rdr = model::make_memory_record_batch_reader(
+              storage::test::make_random_batches(o, 5, false));
+            return rdr
+              .for_each_ref(
+                log.make_appender(storage::log_append_config{
+                  .should_fsync = storage::log_append_config::fsync::no,
+                  .io_priority = ss::default_priority_class(),
+                  .timeout = model::no_timeout}),
+                model::no_timeout)
+              .get0();
+        };
+
+        BOOST_TEST_MESSAGE("Should not evict above the collectible offset");
+        auto first = append(model::offset(0));
+        BOOST_CHECK_EQUAL(budget->used_bytes, log.stats().size_bytes);
+        BOOST_CHECK_EQUAL(budget->evicted_bytes, uint64_t(0));
+        BOOST_CHECK_EQUAL(log.offsets().start_offset, model::offset(0));
+
+        BOOST_TEST_MESSAGE("Should evict up to the collectible offset");
+        log.set_collectible_offset(first.last_offset);
+        auto second = append(first.last_offset + model::offset(1));
+        BOOST_CHECK_GT(budget->evicted_bytes, uint64_t(0));
+        BOOST_CHECK_EQUAL(log.offsets().start_offset, second.base_offset);
+        BOOST_CHECK_EQUAL(log.offsets().dirty_offset, second.last_offset);
+        BOOST_CHECK_EQUAL(budget->used_bytes, log.stats().size_bytes);
+        log.close().get();
+    }
+    BOOST_TEST_MESSAGE("Should give back the memory of a destroyed log");
+    BOOST_CHECK_EQUAL(budget->used_bytes, size_t(0));
+}
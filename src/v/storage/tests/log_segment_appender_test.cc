@@ -11,6 +11,7 @@
 #include "random/generators.h"
 #include "seastarx.h"
 #include "storage/segment_appender.h"
+#include "storage/write_behind_controller.h"
 
 #include <seastar/core/reactor.hh>
 #include <seastar/core/thread.hh>
@@ -217,3 +218,77 @@ SEASTAR_THREAD_TEST_CASE(test_can_append_little_data) {
     BOOST_REQUIRE_EQUAL(appender.file_byte_offset(), data.size());
     appender.close().get();
 }
+
+SEASTAR_THREAD_TEST_CASE(test_can_append_aligned_fragments_in_place) {
+    auto f = ss::open_file_dma(
+               "test_segment_appender_in_place.log",
+               ss::open_flags::create | ss::open_flags::rw
+                 | ss::open_flags::truncate)
+               .get0();
+    auto appender = segment_appender(
+      f, segment_appender::options(ss::default_priority_class(), 1));
+    const auto alignment = f.disk_write_dma_alignment();
+    auto aligned_fragment = [alignment](size_t n) {
+        auto buf = ss::temporary_buffer<char>::aligned(alignment, n);
+        const auto data = random_generators::gen_alphanum_string(n);
+        std::copy_n(data.data(), n, buf.get_write());
+        return buf;
+    };
+
+    iobuf expected;
+    // written in place up to its unaligned tail, then copied as the end of
+    // the file is no longer aligned
+    for (size_t i = 0; i < 3; ++i) {
+        iobuf b;
+        b.append(aligned_fragment(segment_appender::min_direct_write * 4 + 7));
+        expected.append(b.copy());
+        appender.append(b).get();
+    }
+    // in place again, from the aligned end of the file left by the flush
+    appender.flush().get();
+    const auto padding = alignment - expected.size_bytes() % alignment;
+    const auto pad = random_generators::gen_alphanum_string(padding);
+    expected.append(pad.data(), pad.size());
+    appender.append(pad.data(), pad.size()).get();
+    appender.flush().get();
+    iobuf b;
+    b.append(aligned_fragment(segment_appender::min_direct_write * 2));
+    expected.append(b.copy());
+    appender.append(b).get();
+    appender.flush().get();
+
+    BOOST_REQUIRE_EQUAL(appender.file_byte_offset(), expected.size_bytes());
+    auto in = make_file_input_stream(f, 0);
+    iobuf result = read_iobuf_exactly(in, expected.size_bytes()).get0();
+    BOOST_REQUIRE_EQUAL(result, expected);
+    in.close().get();
+    appender.close().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_write_behind_depth_follows_latency) {
+    using controller = internal::write_behind_controller;
+    using namespace std::chrono_literals; // NOLINT
+    controller c;
+    auto now = controller::clock_type::now();
+    auto complete = [&c, &now](std::chrono::microseconds latency) {
+        now += controller::adjust_interval;
+        c.write_dispatched();
+        c.write_completed(latency, now);
+    };
+    // a device that does not queue lets the depth grow to the maximum
+    for (size_t i = 0; i < 2 * controller::max_depth; ++i) {
+        complete(100us);
+    }
+    BOOST_REQUIRE_EQUAL(c.depth(), controller::max_depth);
+    BOOST_REQUIRE_EQUAL(c.writes_in_flight(), uint64_t(0));
+    // queueing on the device shrinks it down to the minimum
+    for (size_t i = 0; i < 100; ++i) {
+        complete(10ms);
+    }
+    BOOST_REQUIRE_EQUAL(c.depth(), controller::min_depth);
+    // once the baseline window rolls over, the new latency is the baseline
+    for (auto end = now + 3 * controller::baseline_window; now < end;) {
+        complete(10ms);
+    }
+    BOOST_REQUIRE_GT(c.depth(), controller::min_depth);
+}
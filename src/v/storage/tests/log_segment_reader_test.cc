@@ -288,3 +288,36 @@ SEASTAR_THREAD_TEST_CASE(test_does_not_read_past_max_offset) {
     b | stop();
     check_batches(res, batches);
 }
+
+SEASTAR_THREAD_TEST_CASE(test_read_buffer_sizer) {
+    constexpr size_t min = read_buffer_sizer::min_buffer_size;
+    constexpr size_t max = 128 * 1024;
+    ss::semaphore budget(1024 * 1024);
+    read_buffer_sizer sizer(&budget);
+
+    // tail reads keep the smallest stream
+    auto tail = sizer.next(4096, max);
+    BOOST_REQUIRE_EQUAL(tail.buffer_size, min);
+    BOOST_REQUIRE_EQUAL(tail.read_ahead, 1);
+    BOOST_REQUIRE(!tail.units);
+
+    // large reads get large buffers and a deep read-ahead
+    auto large = sizer.next(1024 * 1024, max);
+    BOOST_REQUIRE_EQUAL(large.buffer_size, max);
+    BOOST_REQUIRE_EQUAL(large.read_ahead, read_buffer_sizer::max_read_ahead);
+    BOOST_REQUIRE_EQUAL(
+      static_cast<size_t>(budget.available_units()),
+      1024 * 1024 - 4 * max + min);
+
+    // sequential reads double the stream
+    sizer.sequential_read();
+    auto seq = sizer.next(4096, max);
+    BOOST_REQUIRE_EQUAL(seq.buffer_size, 2 * min);
+    BOOST_REQUIRE_EQUAL(seq.read_ahead, 1);
+
+    // the smallest stream once the budget is exhausted
+    auto exhausted = ss::consume_units(budget, budget.available_units());
+    auto over = sizer.next(1024 * 1024, max);
+    BOOST_REQUIRE_EQUAL(over.buffer_size, min);
+    BOOST_REQUIRE_EQUAL(over.read_ahead, 1);
+}
@@ -6,7 +6,9 @@
 // As of the Change Date specified in that file, in accordance with
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
+#include "config/configuration.h"
 #include "random/generators.h"
+#include "storage/index_search.h"
 #include "storage/segment_index.h"
 #include "test_utils/fixture.h"
 #include "utils/file_io.h"
@@ -14,9 +16,13 @@
 
 #include <seastar/core/seastar.hh>
 #include <seastar/core/shared_ptr.hh>
+#include <seastar/util/defer.hh>
 
 #include <boost/test/tools/old/interface.hpp>
 
+#include <algorithm>
+#include <vector>
+
 struct context {
     context(model::offset base = model::offset(0)) {
         _base_offset = base;
@@ -126,3 +132,109 @@ FIXTURE_TEST(bucket_truncate, context) {
         BOOST_REQUIRE_EQUAL(p->filepos, 458048);
     }
 }
+FIXTURE_TEST(index_search_matches_std, context) {
+    for (int round = 0; round < 100; ++round) {
+        std::vector<uint32_t> index(random_generators::get_int<size_t>(500));
+        std::generate(index.begin(), index.end(), [] {
+            return random_generators::get_int<uint32_t>(10000);
+        });
+        std::sort(index.begin(), index.end());
+        for (int i = 0; i < 100; ++i) {
+            auto needle = random_generators::get_int<uint32_t>(11000);
+            BOOST_REQUIRE_EQUAL(
+              storage::details::index_lower_bound(index, needle),
+              static_cast<size_t>(std::distance(
+                index.begin(),
+                std::lower_bound(index.begin(), index.end(), needle))));
+            BOOST_REQUIRE_EQUAL(
+              storage::details::index_upper_bound(index, needle),
+              static_cast<size_t>(std::distance(
+                index.begin(),
+                std::upper_bound(index.begin(), index.end(), needle))));
+        }
+    }
+}
+FIXTURE_TEST(index_lazy_load, context) {
+    for (uint32_t i = 0; i < 1024; ++i) {
+        model::offset o = _base_offset + model::offset(i);
+        _idx->maybe_track(
+          modify_get(o, storage::segment_index::default_data_buffer_step), i);
+    }
+    _idx->flush().get0();
+
+    storage::segment_index lazy(
+      "lazy in memory iobuf",
+      ss::file(ss::make_shared(tmpbuf_file(_data))),
+      _base_offset,
+      storage::segment_index::default_data_buffer_step);
+    BOOST_REQUIRE(lazy.materialize_index_header().get0());
+    BOOST_REQUIRE(!lazy.loaded());
+    BOOST_REQUIRE_EQUAL(lazy.max_offset(), model::offset(1023));
+    BOOST_REQUIRE_EQUAL(lazy.max_timestamp(), _idx->max_timestamp());
+    // lookups before the entries are loaded find nothing
+    BOOST_REQUIRE(!lazy.find_nearest(model::offset(512)));
+
+    lazy.ensure_loaded().get();
+    BOOST_REQUIRE(lazy.loaded());
+    auto p = lazy.find_nearest(model::offset(512));
+    BOOST_REQUIRE(bool(p));
+    BOOST_REQUIRE_EQUAL(p->offset, model::offset(512));
+    BOOST_REQUIRE_EQUAL(p->filepos, 512);
+    lazy.close().get();
+}
+FIXTURE_TEST(index_time_lookup_backwards_timestamps, context) {
+    // every batch is indexed. timestamps go back in time at offset 3
+    const std::vector<int64_t> timestamps = {100, 110, 120, 105, 130, 140};
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        auto hdr = modify_get(
+          _base_offset + model::offset(i),
+          storage::segment_index::default_data_buffer_step);
+        hdr.first_timestamp = model::timestamp(timestamps[i]);
+        hdr.max_timestamp = model::timestamp(timestamps[i]);
+        _idx->maybe_track(hdr, i);
+    }
+    // nothing is older than the first timestamp
+    BOOST_REQUIRE(!_idx->find_nearest(model::timestamp(100)));
+    // the scan starts before the first batch that may reach the timestamp
+    auto p = _idx->find_nearest(model::timestamp(115));
+    BOOST_REQUIRE(bool(p));
+    BOOST_REQUIRE_EQUAL(p->offset, model::offset(1));
+    // 105 is behind the running max of 120, it does not end the prefix
+    p = _idx->find_nearest(model::timestamp(125));
+    BOOST_REQUIRE(bool(p));
+    BOOST_REQUIRE_EQUAL(p->offset, model::offset(3));
+    p = _idx->find_nearest(model::timestamp(1000));
+    BOOST_REQUIRE(bool(p));
+    BOOST_REQUIRE_EQUAL(p->offset, model::offset(5));
+}
+FIXTURE_TEST(sealed_index_is_released, context) {
+    auto& max_resident = config::shard_local_cfg().max_resident_segment_indices;
+    auto restore = ss::defer(
+      [&max_resident, prev = max_resident()] { max_resident.set_value(prev); });
+    max_resident.set_value(size_t(1));
+    for (uint32_t i = 0; i < 1024; ++i) {
+        model::offset o = _base_offset + model::offset(i);
+        _idx->maybe_track(
+          modify_get(o, storage::segment_index::default_data_buffer_step), i);
+    }
+    _idx->flush().get0();
+    _idx->seal();
+    BOOST_REQUIRE(_idx->loaded());
+
+    // sealing another index goes over the resident bound
+    tmpbuf_file::store_t other_data;
+    storage::segment_index other(
+      "other in memory iobuf",
+      ss::file(ss::make_shared(tmpbuf_file(other_data))),
+      model::offset(2048),
+      storage::segment_index::default_data_buffer_step);
+    other.maybe_track(modify_get(model::offset(2048), 1), 0);
+    other.flush().get0();
+    other.seal();
+    BOOST_REQUIRE(other.loaded());
+    BOOST_REQUIRE(!_idx->loaded());
+
+    _idx->ensure_loaded().get();
+    index_entry_expect(512, 512);
+    other.close().get();
+}
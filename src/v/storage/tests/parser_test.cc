@@ -7,12 +7,16 @@
 // the Business Source License, use of this software will be governed
 // by the Apache License, Version 2.0
 
+#include "bytes/bytes.h"
 #include "bytes/iobuf.h"
 #include "model/compression.h"
 #include "model/fundamental.h"
 #include "model/record.h"
+#include "model/record_utils.h"
+#include "random/generators.h"
 #include "storage/disk_log_appender.h"
 #include "storage/parser.h"
+#include "storage/record_batch_builder.h"
 #include "storage/segment_appender_utils.h"
 #include "storage/segment_reader.h"
 #include "storage/tests/utils/random_batch.h"
@@ -30,6 +34,40 @@ struct test_consumer_reporter {
 };
 
 SEASTAR_THREAD_TEST_CASE(dummy) { BOOST_REQUIRE(true); }
+
+SEASTAR_THREAD_TEST_CASE(test_builder_wire_format) {
+    record_batch_builder builder(
+      model::record_batch_type(1), model::offset(10));
+    builder.reserve(64);
+    for (int i = 0; i < 200; ++i) {
+        auto k = fmt::format("key-{}", i);
+        iobuf key;
+        key.append(k.data(), k.size());
+        // large enough values for multi-byte vints
+        builder.add_raw_kv(
+          std::move(key), bytes_to_iobuf(random_generators::get_bytes(i)));
+    }
+    auto batch = std::move(builder).build();
+
+    BOOST_REQUIRE_EQUAL(batch.record_count(), 200);
+    BOOST_REQUIRE_EQUAL(batch.last_offset(), model::offset(209));
+    BOOST_REQUIRE_EQUAL(
+      batch.size_bytes(),
+      model::packed_record_batch_header_size + batch.data().size_bytes());
+    BOOST_REQUIRE_EQUAL(batch.header().crc, model::crc_record_batch(batch));
+    BOOST_REQUIRE_EQUAL(
+      batch.header().header_crc,
+      model::internal_header_only_crc(batch.header()));
+
+    int32_t delta = 0;
+    batch.for_each_record([&delta](model::record r) {
+        BOOST_REQUIRE_EQUAL(r.offset_delta(), delta);
+        BOOST_REQUIRE_EQUAL(r.value_size(), delta);
+        BOOST_REQUIRE_EQUAL(r.headers().size(), 0);
+        ++delta;
+    });
+    BOOST_REQUIRE_EQUAL(delta, 200);
+}
 #if 0
 class test_consumer : public batch_consumer {
 public:
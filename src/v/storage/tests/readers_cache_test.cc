@@ -0,0 +1,77 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "model/record.h"
+#include "seastarx.h"
+#include "storage/tests/utils/disk_log_builder.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <vector>
+
+using namespace storage; // NOLINT
+
+// without the batch cache every read goes through the parser of the reader
+static log_config uncached_config() {
+    auto cfg = log_builder_config();
+    cfg.cache = log_config::with_cache::no;
+    return cfg;
+}
+
+static log_reader_config one_batch_config(model::offset o) {
+    // the first batch is always read, whatever the byte budget
+    return log_reader_config(
+      o,
+      model::model_limits<model::offset>::max(),
+      0,
+      1,
+      ss::default_priority_class(),
+      std::nullopt,
+      std::nullopt,
+      std::nullopt);
+}
+
+SEASTAR_THREAD_TEST_CASE(sequential_reads_resume_parked_readers) {
+    disk_log_builder b(uncached_config());
+    b | start() | add_segment(0) | add_random_batches(0, 20);
+    auto next = b.get_log().offsets().dirty_offset + model::offset(1);
+    b | add_segment(next) | add_random_batches(next, 20);
+    auto dirty = b.get_log().offsets().dirty_offset;
+
+    auto all = b.consume().get0();
+    std::vector<model::record_batch> read;
+    model::offset o(0);
+    while (o <= dirty) {
+        auto batches = b.consume(one_batch_config(o)).get0();
+        BOOST_REQUIRE_EQUAL(batches.size(), 1);
+        o = batches.back().last_offset() + model::offset(1);
+        read.push_back(std::move(batches.back()));
+    }
+    BOOST_REQUIRE_EQUAL(read.size(), all.size());
+    for (size_t i = 0; i < read.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(read[i].header(), all[i].header());
+    }
+    b | stop();
+}
+
+SEASTAR_THREAD_TEST_CASE(truncation_evicts_parked_readers) {
+    disk_log_builder b(uncached_config());
+    b | start() | add_segment(0) | add_random_batches(0, 10);
+
+    // parks a reader at the start of the second batch
+    auto batches = b.consume(one_batch_config(model::offset(0))).get0();
+    BOOST_REQUIRE_EQUAL(batches.size(), 1);
+    auto o = batches.back().last_offset() + model::offset(1);
+
+    b.get_log()
+      .truncate(truncate_config(o, ss::default_priority_class()))
+      .get();
+    BOOST_REQUIRE(b.consume(one_batch_config(o)).get0().empty());
+    b | stop();
+}
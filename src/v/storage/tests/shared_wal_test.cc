@@ -0,0 +1,99 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/shared_wal.h"
+#include "storage/tests/storage_test_fixture.h"
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include <filesystem>
+#include <memory>
+
+static std::unique_ptr<storage::shared_wal> make_wal(ss::sstring dir) {
+    return std::make_unique<storage::shared_wal>(
+      storage::shared_wal_config{
+        .base_dir = std::move(dir),
+        .max_segment_size = 1_MiB,
+        .recovery_timeout = std::chrono::minutes(1),
+        .sanitize_fileops = storage::debug_sanitize_files::yes},
+      [](const model::ntp&) { return ss::now(); });
+}
+
+FIXTURE_TEST(test_replays_flushed_entries, storage_test_fixture) {
+    const auto a = model::ntp("kafka", "a", 0);
+    const auto b = model::ntp("kafka", "b", 0);
+    const auto wal_dir = test_dir + "_wal";
+    const auto crash_dir = test_dir + "_crash";
+
+    auto wal = make_wal(wal_dir);
+    wal->start().get();
+    auto batches = storage::test::make_random_batches(model::offset(0), 10);
+    for (auto& batch : batches) {
+        wal->append(a, batch);
+        wal->append(b, batch);
+    }
+    wal->truncate(a, batches[5].base_offset()).get();
+    wal->detach(b).get();
+    wal->flush().get();
+
+    // the wal as left by a crash right after the flush
+    std::filesystem::copy(
+      wal_dir.c_str(),
+      crash_dir.c_str(),
+      std::filesystem::copy_options::recursive);
+    wal->stop().get();
+
+    auto recovered = make_wal(crash_dir);
+    recovered->start().get();
+    // the entries of the detached log are not replayed
+    BOOST_REQUIRE_EQUAL(recovered->recovered_logs(), 1);
+
+    auto mgr = make_log_manager(storage::log_config(
+      storage::log_config::storage_type::disk,
+      test_dir,
+      200_MiB,
+      storage::debug_sanitize_files::yes));
+    auto log = mgr.manage(storage::ntp_config(a, mgr.config().base_dir)).get0();
+    recovered->replay(log).get();
+    BOOST_REQUIRE_EQUAL(recovered->recovered_logs(), 0);
+
+    auto read = read_and_validate_all_batches(log);
+    BOOST_REQUIRE_EQUAL(read.size(), 5);
+    for (size_t i = 0; i < read.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(read[i].base_offset(), batches[i].base_offset());
+        BOOST_REQUIRE_EQUAL(read[i].header().crc, batches[i].header().crc);
+    }
+
+    // replayed once only
+    recovered->replay(log).get();
+    BOOST_REQUIRE_EQUAL(log.offsets().dirty_offset, batches[4].last_offset());
+
+    mgr.stop().get();
+    recovered->stop().get();
+}
+
+FIXTURE_TEST(test_stop_removes_materialized_segments, storage_test_fixture) {
+    const auto a = model::ntp("kafka", "a", 0);
+    const auto wal_dir = test_dir + "_wal";
+
+    auto wal = make_wal(wal_dir);
+    wal->start().get();
+    for (auto& batch :
+         storage::test::make_random_batches(model::offset(0), 10)) {
+        wal->append(a, batch);
+    }
+    wal->flush().get();
+    wal->stop().get();
+
+    // the logs were closed, with their segments flushed
+    wal = make_wal(wal_dir);
+    wal->start().get();
+    BOOST_REQUIRE_EQUAL(wal->recovered_logs(), 0);
+    wal->stop().get();
+}
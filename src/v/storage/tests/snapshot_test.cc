@@ -163,3 +163,38 @@ SEASTAR_THREAD_TEST_CASE(remove_partial_snapshots) {
     BOOST_REQUIRE(!ss::file_exists(p1.string()).get0());
     BOOST_REQUIRE(!ss::file_exists(p2.string()).get0());
 }
+
+SEASTAR_THREAD_TEST_CASE(snapshots_with_different_names_share_a_directory) {
+    storage::snapshot_manager a(".", ss::default_priority_class(), "a_snap");
+    storage::snapshot_manager b(".", ss::default_priority_class(), "b_snap");
+    BOOST_REQUIRE(a.snapshot_path() != b.snapshot_path());
+
+    auto write = [](storage::snapshot_manager& mgr, ss::sstring blob) {
+        auto writer = mgr.start_snapshot().get0();
+        writer.write_metadata(iobuf()).get();
+        writer.output().write(blob).get();
+        writer.close().get();
+        mgr.finish_snapshot(writer).get();
+    };
+    auto read = [](storage::snapshot_manager& mgr) {
+        auto reader = mgr.open_snapshot().get0();
+        BOOST_REQUIRE(reader);
+        reader->read_metadata().get();
+        auto blob = reader->input().read_exactly(3).get0();
+        reader->close().get();
+        return ss::to_sstring(std::move(blob));
+    };
+
+    write(a, "aaa");
+    write(b, "bbb");
+    BOOST_REQUIRE_EQUAL(read(a), "aaa");
+    BOOST_REQUIRE_EQUAL(read(b), "bbb");
+
+    // removing the partial snapshots of one leaves those of the other
+    auto partial = b.start_snapshot().get0();
+    partial.close().get();
+    a.remove_partial_snapshots().get();
+    BOOST_REQUIRE(ss::file_exists(partial.path().string()).get0());
+    b.remove_partial_snapshots().get();
+    BOOST_REQUIRE(!ss::file_exists(partial.path().string()).get0());
+}
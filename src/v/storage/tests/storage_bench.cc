@@ -0,0 +1,307 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "model/record_batch_reader.h"
+#include "random/generators.h"
+#include "storage/batch_cache.h"
+#include "storage/segment_appender.h"
+#include "storage/tests/utils/disk_log_builder.h"
+#include "storage/tests/utils/random_batch.h"
+#include "units.h"
+
+#include <seastar/core/reactor.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/testing/perf_tests.hh>
+
+#include <vector>
+
+/*
+ * Write and read paths of the storage layer, to compare the tunables of
+ * segment_appender (write behind chunks and fallocation step), the cost of
+ * fsync on append, and reads served by the batch cache against disk reads.
+ */
+
+namespace {
+
+/*
+ * Appends 16MiB in writes of write_size, then flushes. The file is
+ * preallocated by the appender in steps of falloc_step, and up to chunks
+ * chunks of segment_appender::chunk_size are written behind.
+ */
+void append_flush(size_t chunks, size_t write_size, size_t falloc_step) {
+    static constexpr size_t total = 16_MiB;
+    const auto name = fmt::format(
+      "storage_bench.{}.log", random_generators::gen_alphanum_string(8));
+    auto f = ss::open_file_dma(
+               name,
+               ss::open_flags::create | ss::open_flags::rw
+                 | ss::open_flags::truncate)
+               .get0();
+    storage::segment_appender appender(
+      f,
+      storage::segment_appender::options(
+        ss::default_priority_class(), chunks, falloc_step));
+    const auto data = random_generators::gen_alphanum_string(write_size);
+
+    perf_tests::start_measuring_time();
+    for (size_t written = 0; written < total; written += write_size) {
+        appender.append(data.data(), data.size()).get();
+    }
+    appender.flush().get();
+    perf_tests::stop_measuring_time();
+
+    appender.close().get();
+    ss::remove_file(name).get();
+}
+
+/*
+ * A disk log started with the batch cache on or off, optionally populated
+ * with uncompressed batches of 10 records.
+ */
+class log_fixture {
+public:
+    static constexpr int populated_batches = 1000;
+
+    explicit log_fixture(
+      storage::log_config::with_cache cache, bool populate = true)
+      : _builder(make_config(cache)) {
+        _builder.start().get();
+        if (populate) {
+            for (int i = 0; i < populated_batches; ++i) {
+                append(storage::log_append_config::fsync::no);
+            }
+            log().flush().get();
+        }
+    }
+
+    ~log_fixture() { _builder.stop().get(); }
+
+    log_fixture(const log_fixture&) = delete;
+    log_fixture& operator=(const log_fixture&) = delete;
+    log_fixture(log_fixture&&) = delete;
+    log_fixture& operator=(log_fixture&&) = delete;
+
+    storage::log& log() { return _builder.get_log(); }
+
+    void append(storage::log_append_config::fsync sync) {
+        storage::log_append_config cfg{
+          .should_fsync = sync,
+          .io_priority = ss::default_priority_class(),
+          .timeout = model::no_timeout};
+        auto batches = ss::circular_buffer<model::record_batch>{};
+        batches.push_back(
+          storage::test::make_random_batch(model::offset(0), 10, false));
+        model::make_memory_record_batch_reader(std::move(batches))
+          .for_each_ref(log().make_appender(cfg), cfg.timeout)
+          .get();
+    }
+
+    /// reads from start up to max_bytes, returning the batches read
+    size_t read(model::offset start, size_t max_bytes) {
+        storage::log_reader_config cfg(
+          start,
+          model::model_limits<model::offset>::max(),
+          0,
+          max_bytes,
+          ss::default_priority_class(),
+          std::nullopt,
+          std::nullopt,
+          std::nullopt);
+        auto reader = log().make_reader(cfg).get0();
+        auto batches = model::consume_reader_to_memory(
+                         std::move(reader), model::no_timeout)
+                         .get0();
+        return batches.size();
+    }
+
+    model::offset random_offset() {
+        auto offsets = log().offsets();
+        return model::offset(random_generators::get_int<int64_t>(
+          offsets.start_offset(), offsets.dirty_offset()));
+    }
+
+private:
+    static storage::log_config
+    make_config(storage::log_config::with_cache cache) {
+        return storage::log_config(
+          storage::log_config::storage_type::disk,
+          storage::random_dir(),
+          100_MiB,
+          storage::debug_sanitize_files::no,
+          cache);
+    }
+
+    storage::disk_log_builder _builder;
+};
+
+struct empty_log_bench : log_fixture {
+    empty_log_bench()
+      : log_fixture(storage::log_config::with_cache::yes, false) {}
+};
+
+struct cached_log_bench : log_fixture {
+    cached_log_bench()
+      : log_fixture(storage::log_config::with_cache::yes) {}
+};
+
+struct uncached_log_bench : log_fixture {
+    uncached_log_bench()
+      : log_fixture(storage::log_config::with_cache::no) {}
+};
+
+storage::batch_cache::reclaim_options cache_opts = {
+  .growth_window = std::chrono::milliseconds(3000),
+  .stable_window = std::chrono::milliseconds(10000),
+  .min_size = 128 << 10,
+  .max_size = 4 << 20,
+};
+
+/*
+ * A batch cache index over batches at offsets 0, 10, ..., with a hole at
+ * every other batch, so that lookups can be steered to hits or misses.
+ */
+struct batch_cache_bench {
+    static constexpr int batches = 1024;
+
+    batch_cache_bench() {
+        for (int i = 0; i < batches; i += 2) {
+            index.put(storage::test::make_random_batch(
+              model::offset(i * 10), 10, false));
+        }
+    }
+
+    model::offset lookup(bool hit) const {
+        auto i = random_generators::get_int(0, batches / 2 - 1) * 2;
+        return model::offset((hit ? i : i + 1) * 10);
+    }
+
+    storage::batch_cache cache{cache_opts};
+    storage::batch_cache_index index{cache};
+};
+
+} // namespace
+
+// segment_appender::write_behind_memory / chunk_size is the default depth
+
+PERF_TEST(segment_appender, append_4k_chunks_1) {
+    append_flush(1, 4_KiB, storage::segment_appender::fallocation_step);
+}
+
+PERF_TEST(segment_appender, append_4k_chunks_8) {
+    append_flush(8, 4_KiB, storage::segment_appender::fallocation_step);
+}
+
+PERF_TEST(segment_appender, append_4k_chunks_default) {
+    append_flush(
+      storage::segment_appender::chunks_no_buffer,
+      4_KiB,
+      storage::segment_appender::fallocation_step);
+}
+
+PERF_TEST(segment_appender, append_4k_chunks_256) {
+    append_flush(256, 4_KiB, storage::segment_appender::fallocation_step);
+}
+
+PERF_TEST(segment_appender, append_512_chunks_default) {
+    append_flush(
+      storage::segment_appender::chunks_no_buffer,
+      512,
+      storage::segment_appender::fallocation_step);
+}
+
+PERF_TEST(segment_appender, append_64k_chunks_default) {
+    append_flush(
+      storage::segment_appender::chunks_no_buffer,
+      64_KiB,
+      storage::segment_appender::fallocation_step);
+}
+
+PERF_TEST(segment_appender, append_1m_chunks_default) {
+    append_flush(
+      storage::segment_appender::chunks_no_buffer,
+      1_MiB,
+      storage::segment_appender::fallocation_step);
+}
+
+PERF_TEST(segment_appender, append_4k_falloc_1m) {
+    append_flush(storage::segment_appender::chunks_no_buffer, 4_KiB, 1_MiB);
+}
+
+PERF_TEST(segment_appender, append_4k_falloc_4m) {
+    append_flush(storage::segment_appender::chunks_no_buffer, 4_KiB, 4_MiB);
+}
+
+PERF_TEST(segment_appender, append_4k_falloc_128m) {
+    append_flush(storage::segment_appender::chunks_no_buffer, 4_KiB, 128_MiB);
+}
+
+PERF_TEST_F(empty_log_bench, append) {
+    perf_tests::start_measuring_time();
+    append(storage::log_append_config::fsync::no);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(empty_log_bench, append_flush) {
+    perf_tests::start_measuring_time();
+    append(storage::log_append_config::fsync::no);
+    log().flush().get();
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(empty_log_bench, append_fsync) {
+    perf_tests::start_measuring_time();
+    append(storage::log_append_config::fsync::yes);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(cached_log_bench, sequential_read) {
+    perf_tests::start_measuring_time();
+    auto n = read(model::offset(0), std::numeric_limits<size_t>::max());
+    perf_tests::do_not_optimize(n);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(uncached_log_bench, sequential_read) {
+    perf_tests::start_measuring_time();
+    auto n = read(model::offset(0), std::numeric_limits<size_t>::max());
+    perf_tests::do_not_optimize(n);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(cached_log_bench, random_read) {
+    auto o = random_offset();
+    perf_tests::start_measuring_time();
+    auto n = read(o, 1);
+    perf_tests::do_not_optimize(n);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(uncached_log_bench, random_read) {
+    auto o = random_offset();
+    perf_tests::start_measuring_time();
+    auto n = read(o, 1);
+    perf_tests::do_not_optimize(n);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(batch_cache_bench, get_hit) {
+    auto o = lookup(true);
+    perf_tests::start_measuring_time();
+    auto b = index.get(o);
+    perf_tests::do_not_optimize(b);
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(batch_cache_bench, get_miss) {
+    auto o = lookup(false);
+    perf_tests::start_measuring_time();
+    auto b = index.get(o);
+    perf_tests::do_not_optimize(b);
+    perf_tests::stop_measuring_time();
+}
@@ -8,20 +8,30 @@
 // by the Apache License, Version 2.0
 
 #include "bytes/bytes.h"
+#include "config/configuration.h"
 #include "model/fundamental.h"
 #include "model/record.h"
 #include "model/record_batch_reader.h"
+#include "model/record_utils.h"
 #include "model/timeout_clock.h"
 #include "model/timestamp.h"
 #include "random/generators.h"
 #include "storage/batch_cache.h"
+#include "storage/compacted_index_reader.h"
+#include "storage/flush_coordinator.h"
+#include "storage/fs_utils.h"
 #include "storage/log_manager.h"
 #include "storage/record_batch_builder.h"
+#include "storage/segment_transfer.h"
+#include "storage/segment_utils.h"
 #include "storage/tests/storage_test_fixture.h"
 #include "storage/tests/utils/disk_log_builder.h"
 #include "storage/tests/utils/random_batch.h"
 #include "storage/types.h"
+#include "test_utils/async.h"
+#include "utils/to_string.h"
 
+#include <seastar/core/seastar.hh>
 #include <seastar/core/sleep.hh>
 #include <seastar/util/defer.hh>
 #include <seastar/util/log.hh>
@@ -29,6 +39,7 @@
 #include <boost/test/tools/old/interface.hpp>
 
 #include <algorithm>
+#include <fstream>
 #include <iterator>
 #include <numeric>
 
@@ -1065,3 +1076,695 @@ FIXTURE_TEST(check_segment_size_jitter, storage_test_fixture) {
     // check if all logs have unique segment size
     BOOST_REQUIRE_EQUAL(unique_cnt, sizes.size());
 }
+
+FIXTURE_TEST(merge_adjacent_compacted_segments, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    // make sure segments are small
+    cfg.max_compacted_segment_size = 10_KiB;
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.cache = storage::log_config::with_cache::no;
+    ss::abort_source as;
+    storage::log_manager mgr = make_log_manager(cfg);
+
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.cleanup_policy_bitflags = model::cleanup_policy_bitflags::compaction;
+
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    storage::ntp_config ntp_cfg(
+      ntp, mgr.config().base_dir, std::make_unique<overrides_t>(ov));
+    auto log = mgr.manage(std::move(ntp_cfg)).get0();
+
+    // all batches share the same key and term, and roll ~10 segments
+    append_exactly(log, 100, 1_KiB, "key").get0();
+    const auto segments_before = log.segment_count();
+    BOOST_REQUIRE_GT(segments_before, 2);
+
+    storage::compaction_config ccfg(
+      model::timestamp::min(), std::nullopt, ss::default_priority_class(), as);
+    // self compact every closed segment, then merge them
+    for (size_t i = 0; i < 2 * segments_before; ++i) {
+        log.compact(ccfg).get0();
+    }
+
+    // a single compacted segment is left in front of the active one
+    BOOST_REQUIRE_EQUAL(log.segment_count(), 2);
+    auto& segs = get_disk_log(log)->segments();
+    BOOST_REQUIRE_EQUAL(
+      segs.front()->offsets().dirty_offset,
+      segs.back()->offsets().base_offset - model::offset(1));
+    BOOST_REQUIRE_EQUAL(log.offsets().dirty_offset, model::offset(99));
+
+    // only the most recent value of the key is kept by the compacted segment
+    auto batches = read_and_validate_all_batches(log);
+    auto compacted = std::count_if(
+      batches.begin(), batches.end(), [&segs](const model::record_batch& b) {
+          return b.last_offset() < segs.back()->offsets().base_offset;
+      });
+    BOOST_REQUIRE_EQUAL(compacted, 1);
+};
+
+FIXTURE_TEST(recompress_closed_segments, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.cache = storage::log_config::with_cache::no;
+    ss::abort_source as;
+    storage::log_manager mgr = make_log_manager(cfg);
+
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.compression = model::compression::zstd;
+
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    storage::ntp_config ntp_cfg(
+      ntp, mgr.config().base_dir, std::make_unique<overrides_t>(ov));
+    auto log = mgr.manage(std::move(ntp_cfg)).get0();
+
+    // a segment per term, with batches of random codecs
+    for (int i = 0; i < 3; ++i) {
+        append_random_batches(log, 5, model::term_id(i));
+    }
+    BOOST_REQUIRE_EQUAL(log.segment_count(), 3);
+    auto before = read_and_validate_all_batches(log);
+
+    storage::compaction_config ccfg(
+      model::timestamp::min(), std::nullopt, ss::default_priority_class(), as);
+    for (size_t i = 0; i < log.segment_count(); ++i) {
+        log.compact(ccfg).get0();
+    }
+
+    auto& segs = get_disk_log(log)->segments();
+    const auto active_base = segs.back()->offsets().base_offset;
+    auto after = read_and_validate_all_batches(log);
+    BOOST_REQUIRE_EQUAL(before.size(), after.size());
+    for (size_t i = 0; i < before.size(); ++i) {
+        const auto& b = before[i];
+        const auto& a = after[i];
+        BOOST_REQUIRE_EQUAL(a.base_offset(), b.base_offset());
+        BOOST_REQUIRE_EQUAL(a.record_count(), b.record_count());
+        auto expected = b.header().attrs.compression();
+        if (b.compressed() && b.base_offset() < active_base) {
+            expected = model::compression::zstd;
+        }
+        BOOST_REQUIRE_EQUAL(a.header().attrs.compression(), expected);
+    }
+};
+
+// small uncompressed batches of non idempotent producers
+struct tiny_batch_generator {
+    ss::circular_buffer<model::record_batch> operator()() {
+        ss::circular_buffer<model::record_batch> ret;
+        for (int i = 0; i < 10; ++i) {
+            auto b = storage::test::make_random_batch(
+              model::offset(0), 2, false);
+            b.header().producer_id = -1;
+            b.header().crc = model::crc_record_batch(b);
+            b.header().header_crc = model::internal_header_only_crc(
+              b.header());
+            ret.push_back(std::move(b));
+        }
+        return ret;
+    }
+};
+
+FIXTURE_TEST(coalesce_closed_segments, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.cache = storage::log_config::with_cache::no;
+    cfg.coalesce_batch_bytes = 64_KiB;
+    ss::abort_source as;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    auto log = mgr.manage(storage::ntp_config(ntp, mgr.config().base_dir))
+                 .get0();
+
+    // a segment per term
+    for (int i = 0; i < 3; ++i) {
+        append_random_batches<tiny_batch_generator>(
+          log, 1, model::term_id(i));
+    }
+    BOOST_REQUIRE_EQUAL(log.segment_count(), 3);
+    auto before = read_and_validate_all_batches(log);
+
+    storage::compaction_config ccfg(
+      model::timestamp::min(), std::nullopt, ss::default_priority_class(), as);
+    for (size_t i = 0; i < log.segment_count(); ++i) {
+        log.compact(ccfg).get0();
+    }
+
+    // a batch per closed segment, the active one untouched
+    auto after = read_and_validate_all_batches(log);
+    BOOST_REQUIRE_EQUAL(after.size(), 2 + 10);
+    BOOST_REQUIRE_EQUAL(log.offsets().dirty_offset, model::offset(59));
+    auto next = model::offset(0);
+    for (const auto& b : after) {
+        BOOST_REQUIRE_EQUAL(b.base_offset(), next);
+        BOOST_REQUIRE_EQUAL(
+          b.record_count(), b.last_offset()() - b.base_offset()() + 1);
+        next = b.last_offset() + model::offset(1);
+    }
+    size_t records = 0;
+    for (const auto& b : before) {
+        records += b.record_count();
+    }
+    BOOST_REQUIRE_EQUAL(records, 60);
+    BOOST_REQUIRE_EQUAL(after.front().record_count(), 20);
+};
+
+FIXTURE_TEST(recompress_segments_with_open_reader, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.cache = storage::log_config::with_cache::no;
+    ss::abort_source as;
+    storage::log_manager mgr = make_log_manager(cfg);
+
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.compression = model::compression::zstd;
+
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    storage::ntp_config ntp_cfg(
+      ntp, mgr.config().base_dir, std::make_unique<overrides_t>(ov));
+    auto log = mgr.manage(std::move(ntp_cfg)).get0();
+
+    for (int i = 0; i < 3; ++i) {
+        append_random_batches(log, 5, model::term_id(i));
+    }
+    auto before = read_and_validate_all_batches(log);
+
+    // the reader holds its range of segments while they are swapped
+    storage::log_reader_config reader_cfg(
+      model::offset(0),
+      model::model_limits<model::offset>::max(),
+      ss::default_priority_class());
+    auto reader = log.make_reader(reader_cfg).get0();
+
+    storage::compaction_config ccfg(
+      model::timestamp::min(), std::nullopt, ss::default_priority_class(), as);
+    for (size_t i = 0; i < log.segment_count(); ++i) {
+        log.compact(ccfg).get0();
+    }
+
+    auto res = model::consume_reader_to_memory(
+                 std::move(reader), model::no_timeout)
+                 .get0();
+    auto& read = std::get<model::record_batch_reader::data_t>(res);
+    BOOST_REQUIRE_EQUAL(read.size(), before.size());
+    for (size_t i = 0; i < read.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(read[i].base_offset(), before[i].base_offset());
+        BOOST_REQUIRE_EQUAL(read[i].record_count(), before[i].record_count());
+    }
+    auto after = read_and_validate_all_batches(log);
+    BOOST_REQUIRE_EQUAL(after.size(), before.size());
+};
+
+FIXTURE_TEST(header_only_reads, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.cache = storage::log_config::with_cache::no;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    auto log
+      = mgr.manage(storage::ntp_config(ntp, mgr.config().base_dir)).get0();
+    append_random_batches(log, 10);
+    log.flush().get0();
+    auto batches = read_and_validate_all_batches(log);
+
+    storage::log_reader_config reader_cfg(
+      model::offset(0),
+      model::model_limits<model::offset>::max(),
+      ss::default_priority_class());
+    reader_cfg.header_only = true;
+    auto reader = log.make_reader(reader_cfg).get0();
+    auto headers = model::consume_reader_to_memory(
+                     std::move(reader), model::no_timeout)
+                     .get0();
+    auto& read = std::get<model::record_batch_reader::data_t>(headers);
+    BOOST_REQUIRE_EQUAL(read.size(), batches.size());
+    for (size_t i = 0; i < read.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(read[i].header(), batches[i].header());
+        BOOST_REQUIRE(read[i].data().empty());
+    }
+    // the records are still there for the readers that need them
+    auto again = read_and_validate_all_batches(log);
+    BOOST_REQUIRE_EQUAL(again.size(), batches.size());
+    for (size_t i = 0; i < again.size(); ++i) {
+        BOOST_REQUIRE(again[i] == batches[i]);
+    }
+};
+
+FIXTURE_TEST(compaction_backlog, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.max_compacted_segment_size = 10_KiB;
+    cfg.stype = storage::log_config::storage_type::disk;
+    ss::abort_source as;
+    storage::log_manager mgr = make_log_manager(cfg);
+
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.cleanup_policy_bitflags = model::cleanup_policy_bitflags::compaction;
+
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    storage::ntp_config ntp_cfg(
+      ntp, mgr.config().base_dir, std::make_unique<overrides_t>(ov));
+    auto log = mgr.manage(std::move(ntp_cfg)).get0();
+
+    append_exactly(log, 100, 1_KiB, "key").get0();
+    auto& segs = get_disk_log(log)->segments();
+    auto backlog = log.get_compaction_backlog();
+    info("backlog before compaction: {}", backlog);
+    // every closed segment is waiting for self compaction
+    BOOST_REQUIRE_EQUAL(
+      backlog.dirty_bytes,
+      get_disk_log(log)->get_probe().partition_size()
+        - segs.back()->size_bytes());
+    BOOST_REQUIRE_EQUAL(backlog.next_bytes, segs.front()->size_bytes());
+    BOOST_REQUIRE_GT(backlog.dirty_ratio(), 0.5);
+
+    storage::compaction_config ccfg(
+      model::timestamp::min(), std::nullopt, ss::default_priority_class(), as);
+    for (size_t i = 0; i < 2 * segs.size(); ++i) {
+        log.compact(ccfg).get0();
+    }
+    backlog = log.get_compaction_backlog();
+    info("backlog after compaction: {}", backlog);
+    BOOST_REQUIRE_EQUAL(backlog.dirty_bytes, 0);
+    BOOST_REQUIRE_EQUAL(backlog.next_bytes, 0);
+};
+
+FIXTURE_TEST(flush_coordinator_coalesces_flushes, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    storage::flush_coordinator coordinator;
+    auto deferred = ss::defer([&mgr, &coordinator]() mutable {
+        coordinator.stop().get0();
+        mgr.stop().get0();
+    });
+
+    std::vector<storage::log> logs;
+    for (int i = 0; i < 3; ++i) {
+        auto ntp = model::ntp("default", "test", i);
+        logs.push_back(
+          mgr.manage(storage::ntp_config(ntp, mgr.config().base_dir)).get0());
+        append_exactly(logs.back(), 10, 100).get0();
+    }
+
+    std::vector<ss::future<>> flushes;
+    for (auto& log : logs) {
+        flushes.push_back(coordinator.flush(log));
+    }
+    // already queued for the next wave
+    flushes.push_back(coordinator.flush(logs.back()));
+    ss::when_all_succeed(flushes.begin(), flushes.end()).get0();
+
+    for (auto& log : logs) {
+        auto offsets = log.offsets();
+        BOOST_REQUIRE_EQUAL(offsets.committed_offset, offsets.dirty_offset);
+    }
+    auto& stats = coordinator.get_stats();
+    info("flush coordinator waves: {}", stats.waves);
+    BOOST_REQUIRE_EQUAL(stats.coalesced, 1);
+    BOOST_REQUIRE_EQUAL(stats.flushes, logs.size());
+    BOOST_REQUIRE_LE(stats.waves, 2);
+};
+
+FIXTURE_TEST(install_segment_copied_from_other_log, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto src = mgr.manage(storage::ntp_config(
+                            model::ntp("default", "test", 0),
+                            mgr.config().base_dir))
+                 .get0();
+    auto dst = mgr.manage(storage::ntp_config(
+                            model::ntp("default", "test", 1),
+                            mgr.config().base_dir))
+                 .get0();
+    // new term rolls the segment, the first one is closed
+    append_random_batches(src, 10, model::term_id(0));
+    append_random_batches(src, 10, model::term_id(1));
+    src.flush().get0();
+
+    BOOST_REQUIRE(!src.open_closed_segment(model::offset(1)).get0());
+    auto files = src.open_closed_segment(model::offset(0)).get0();
+    BOOST_REQUIRE(files);
+    BOOST_REQUIRE_EQUAL(
+      src.closed_segment_end(model::offset(0)).value(), files->dirty_offset);
+
+    auto rcv = storage::segment_receiver::open(
+                 dst.config(),
+                 files->base_offset,
+                 files->term,
+                 ss::default_priority_class())
+                 .get0();
+    const auto file_types = {
+      storage::segment_file_type::data, storage::segment_file_type::index};
+    for (auto t : file_types) {
+        auto size = files->size(t);
+        if (size == 0) {
+            continue;
+        }
+        auto buf = files->get(t).dma_read_bulk<char>(0, size).get0();
+        iobuf chunk;
+        chunk.append(std::move(buf));
+        rcv.write(t, std::move(chunk)).get0();
+        BOOST_REQUIRE_EQUAL(rcv.bytes_stored(t), size);
+    }
+    rcv.close().get0();
+    files->close().get0();
+    dst.install_segment(files->base_offset, files->term).get0();
+
+    auto lstats = dst.offsets();
+    BOOST_REQUIRE_EQUAL(lstats.dirty_offset, files->dirty_offset);
+    BOOST_REQUIRE_EQUAL(lstats.committed_offset, files->dirty_offset);
+    BOOST_REQUIRE_EQUAL(lstats.dirty_offset_term, model::term_id(0));
+    auto batches = read_and_validate_all_batches(dst);
+    BOOST_REQUIRE_EQUAL(batches.back().last_offset(), files->dirty_offset);
+};
+
+FIXTURE_TEST(gc_deletes_segments_in_background, storage_test_fixture) {
+    config::shard_local_cfg().segment_deletion_truncate_step.set_value(
+      std::optional<size_t>(4_KiB));
+    auto reset = ss::defer([] {
+        config::shard_local_cfg().segment_deletion_truncate_step.set_value(
+          std::optional<size_t>());
+    });
+    auto cfg = default_log_config(test_dir);
+    cfg.max_segment_size = 10;
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.max_concurrent_segment_deletions = 1;
+    ss::abort_source as;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+
+    storage::ntp_config ntp_cfg(ntp, mgr.config().base_dir);
+    auto log = mgr.manage(std::move(ntp_cfg)).get0();
+    auto headers = append_random_batches(
+      log,
+      10,
+      model::term_id(0),
+      custom_ts_batch_generator(model::timestamp::now()));
+    log.flush().get0();
+    model::timestamp gc_ts = headers.back().max_timestamp;
+    auto lstats = log.offsets();
+    std::vector<ss::sstring> evicted;
+    for (auto& s : get_disk_log(log)->segments()) {
+        evicted.push_back(s->reader().filename());
+        evicted.push_back(s->index().filename());
+    }
+    append_random_batches(
+      log,
+      10,
+      model::term_id(0),
+      custom_ts_batch_generator(model::timestamp(gc_ts() + 10)));
+
+    storage::compaction_config ccfg(
+      gc_ts, std::nullopt, ss::default_priority_class(), as);
+    log.set_collectible_offset(log.offsets().dirty_offset);
+    log.compact(ccfg).get0();
+    // the segments are gone from the log right away
+    BOOST_REQUIRE_EQUAL(
+      log.offsets().start_offset, lstats.dirty_offset + model::offset(1));
+
+    // closing the log waits for the deletions in the background
+    mgr.shutdown(ntp).get0();
+    for (auto& f : evicted) {
+        BOOST_REQUIRE(!ss::file_exists(f).get0());
+    }
+};
+
+FIXTURE_TEST(roll_to_prepared_segment, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.max_segment_size = 10;
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    storage::ntp_config ntp_cfg(ntp, mgr.config().base_dir);
+    auto log = mgr.manage(storage::ntp_config(ntp_cfg)).get0();
+
+    auto append_one = [this, &log](model::term_id term) {
+        append_random_batches(log, 1, term, []() {
+            ss::circular_buffer<model::record_batch> batches;
+            batches.push_back(
+              storage::test::make_random_batch(model::offset(0), 1, true));
+            return batches;
+        });
+    };
+    auto segment_path = [&ntp_cfg](model::offset o, model::term_id t) {
+        return storage::segment_path::make_segment_path(
+                 ntp_cfg, o, t, storage::record_version_type::v1)
+          .string();
+    };
+
+    // filling up the active segment prepares the next one
+    append_one(model::term_id(0));
+    auto next = log.offsets().dirty_offset + model::offset(1);
+    tests::cooperative_spin_wait_with_timeout(5s, [&] {
+        return ss::file_exists(segment_path(next, model::term_id(0)));
+    }).get();
+    append_one(model::term_id(0));
+    BOOST_REQUIRE_EQUAL(
+      get_disk_log(log)->segments().back()->offsets().base_offset, next);
+
+    // a roll to another term discards the prepared segment
+    auto discarded = log.offsets().dirty_offset + model::offset(1);
+    tests::cooperative_spin_wait_with_timeout(5s, [&] {
+        return ss::file_exists(segment_path(discarded, model::term_id(0)));
+    }).get();
+    append_one(model::term_id(1));
+    BOOST_REQUIRE(
+      !ss::file_exists(segment_path(discarded, model::term_id(0))).get0());
+    BOOST_REQUIRE_EQUAL(
+      get_disk_log(log)->segments().back()->offsets().term, model::term_id(1));
+};
+
+FIXTURE_TEST(find_latest_offset_of_key, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.cleanup_policy_bitflags = model::cleanup_policy_bitflags::compaction;
+    auto ntp = model::ntp("default", "test", 0);
+    auto log = mgr.manage(storage::ntp_config(
+                            ntp,
+                            mgr.config().base_dir,
+                            std::make_unique<overrides_t>(ov)))
+                 .get0();
+
+    auto append_key = [&log](ss::sstring key, model::term_id term) {
+        storage::record_batch_builder builder(
+          model::record_batch_type(1), model::offset(0));
+        builder.add_raw_kv(
+          bytes_to_iobuf(bytes(key.c_str())),
+          bytes_to_iobuf(bytes("value")));
+        auto batch = std::move(builder).build();
+        batch.set_term(term);
+        storage::log_append_config cfg{
+          .should_fsync = storage::log_append_config::fsync::no,
+          .io_priority = ss::default_priority_class(),
+          .timeout = model::no_timeout,
+        };
+        model::make_memory_record_batch_reader(std::move(batch))
+          .for_each_ref(log.make_appender(cfg), cfg.timeout)
+          .get0();
+    };
+    auto find = [&log](ss::sstring key) {
+        return log
+          .find_latest_offset(
+            bytes(key.c_str()), ss::default_priority_class())
+          .get0();
+    };
+
+    // a new term rolls the segment
+    append_key("a", model::term_id(1));
+    append_key("b", model::term_id(1));
+    append_key("a", model::term_id(2));
+    append_key("b", model::term_id(2));
+    append_key("c", model::term_id(3));
+    log.flush().get0();
+    BOOST_REQUIRE_EQUAL(get_disk_log(log)->segments().size(), 3);
+
+    BOOST_REQUIRE_EQUAL(find("c"), model::offset(4));
+    BOOST_REQUIRE_EQUAL(find("b"), model::offset(3));
+    BOOST_REQUIRE_EQUAL(find("a"), model::offset(2));
+    BOOST_REQUIRE(!find("d"));
+
+    // the closed segments were probed through their compacted index
+    auto& segs = get_disk_log(log)->segments();
+    for (size_t i = 0; i < 2; ++i) {
+        BOOST_REQUIRE(segs[i]->has_key_filter());
+        BOOST_REQUIRE(segs[i]->get_key_filter().may_contain(bytes("a")));
+    }
+    BOOST_REQUIRE(!segs[2]->has_key_filter());
+    BOOST_REQUIRE(!find("d"));
+};
+
+FIXTURE_TEST(scrub_finds_corrupt_batch, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.max_segment_size = 10;
+    cfg.stype = storage::log_config::storage_type::disk;
+    ss::abort_source as;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+
+    storage::ntp_config ntp_cfg(ntp, mgr.config().base_dir);
+    auto log = mgr.manage(std::move(ntp_cfg)).get0();
+    append_random_batches(log, 10, model::term_id(0));
+    log.flush().get0();
+
+    storage::scrub_config scfg(ss::default_priority_class(), 1_MiB, as);
+    auto res = log.scrub(scfg).get0();
+    info("scrub before corruption: {}", res);
+    BOOST_REQUIRE_EQUAL(res.segments, log.segment_count() - 1);
+    BOOST_REQUIRE(!res.corrupt_offset);
+
+    // flip a byte in the records of the first batch of the front segment
+    auto& front = get_disk_log(log)->segments().front();
+    const auto base = front->offsets().base_offset;
+    {
+        std::fstream f(
+          std::string(front->reader().filename()),
+          std::ios::in | std::ios::out | std::ios::binary);
+        f.seekg(model::packed_record_batch_header_size + 1);
+        char c = 0;
+        f.read(&c, 1);
+        f.seekp(model::packed_record_batch_header_size + 1);
+        c = static_cast<char>(~c);
+        f.write(&c, 1);
+    }
+    res = log.scrub(scfg).get0();
+    info("scrub after corruption: {}", res);
+    BOOST_REQUIRE(res.corrupt_offset);
+    BOOST_REQUIRE_EQUAL(*res.corrupt_offset, base);
+};
+
+FIXTURE_TEST(batch_cache_policy_of_followers, storage_test_fixture) {
+    config::shard_local_cfg().follower_batch_cache_tail_bytes.set_value(
+      size_t(0));
+    auto reset = ss::defer([] {
+        config::shard_local_cfg().follower_batch_cache_tail_bytes.set_value(
+          size_t(1_MiB));
+    });
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.cache = storage::log_config::with_cache::yes;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    auto log
+      = mgr.manage(storage::ntp_config(ntp, mgr.config().base_dir)).get0();
+
+    // a follower with an empty tail window caches none of its appends
+    log.set_batch_cache_policy(storage::batch_cache_policy::tail);
+    append_random_batches(log, 10);
+    log.flush().get0();
+    read_and_validate_all_batches(log);
+    BOOST_REQUIRE_EQUAL(log.stats().batch_cache_hits, 0);
+
+    // once leader, warming reads the tail back into the cache
+    append_random_batches(log, 10);
+    log.flush().get0();
+    log.set_batch_cache_policy(storage::batch_cache_policy::all);
+    log.warm_batch_cache(200_MiB, ss::default_priority_class()).get();
+    const auto misses = log.stats().batch_cache_misses;
+    read_and_validate_all_batches(log);
+    const auto stats = log.stats();
+    BOOST_REQUIRE_GT(stats.batch_cache_hits, 0);
+    BOOST_REQUIRE_EQUAL(stats.batch_cache_misses, misses);
+};
+
+FIXTURE_TEST(adaptive_segment_size, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    cfg.max_segment_size = 100_KiB;
+    cfg.segment_roll_target = std::chrono::hours(1);
+    cfg.min_segment_size = 1_KiB;
+    // a quarter of the retention bounds the segments after the first roll
+    cfg.retention_bytes = 40_KiB;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    auto ntp = model::ntp("default", "test", 0);
+    auto log
+      = mgr.manage(storage::ntp_config(ntp, mgr.config().base_dir)).get0();
+    append_exactly(log, 3000, 100).get0();
+
+    auto& segs = get_disk_log(log)->segments();
+    const auto small = std::count_if(
+      segs.begin(),
+      segs.end(),
+      [](const ss::lw_shared_ptr<storage::segment>& s) {
+          return s->size_bytes() < 20_KiB;
+      });
+    BOOST_REQUIRE_GE(small, 5);
+    for (auto& s : segs) {
+        BOOST_REQUIRE_LE(s->size_bytes(), 110_KiB);
+    }
+};
+
+FIXTURE_TEST(compaction_index_complete_on_roll, storage_test_fixture) {
+    auto cfg = default_log_config(test_dir);
+    cfg.stype = storage::log_config::storage_type::disk;
+    storage::log_manager mgr = make_log_manager(cfg);
+    auto deferred = ss::defer([&mgr]() mutable { mgr.stop().get0(); });
+    using overrides_t = storage::ntp_config::default_overrides;
+    overrides_t ov;
+    ov.cleanup_policy_bitflags = model::cleanup_policy_bitflags::compaction;
+    auto ntp = model::ntp("default", "test", 0);
+    auto log = mgr.manage(storage::ntp_config(
+                            ntp,
+                            mgr.config().base_dir,
+                            std::make_unique<overrides_t>(ov)))
+                 .get0();
+
+    storage::log_append_config acfg{
+      .should_fsync = storage::log_append_config::fsync::no,
+      .io_priority = ss::default_priority_class(),
+      .timeout = model::no_timeout,
+    };
+    auto append_keys = [&log, &acfg](int keys, model::term_id term) {
+        ss::circular_buffer<model::record_batch> batches;
+        for (int i = 0; i < keys; ++i) {
+            storage::record_batch_builder builder(
+              model::record_batch_type(1), model::offset(0));
+            builder.add_raw_kv(
+              bytes_to_iobuf(random_generators::get_bytes(20)),
+              bytes_to_iobuf(bytes("value")));
+            batches.push_back(std::move(builder).build());
+            batches.back().set_term(term);
+        }
+        model::make_memory_record_batch_reader(std::move(batches))
+          .for_each_ref(log.make_appender(acfg), acfg.timeout)
+          .get0();
+    };
+    // indexed in the background, and completely once the term rolls
+    append_keys(500, model::term_id(1));
+    append_keys(1, model::term_id(2));
+    BOOST_REQUIRE_EQUAL(get_disk_log(log)->segments().size(), 2);
+
+    auto& front = get_disk_log(log)->segments().front();
+    auto path = storage::internal::compacted_index_path(
+      std::string(front->reader().filename()));
+    auto rdr = storage::make_file_backed_compacted_reader(
+      path.string(),
+      storage::internal::make_reader_handle(
+        path, storage::debug_sanitize_files::no)
+        .get0(),
+      ss::default_priority_class(),
+      32_KiB);
+    auto footer = rdr.load_footer().get0();
+    rdr.close().get();
+    BOOST_REQUIRE_EQUAL(footer.keys, 500);
+};
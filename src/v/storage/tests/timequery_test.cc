@@ -113,3 +113,33 @@ FIXTURE_TEST(timequery_single_value, log_builder_fixture) {
     BOOST_TEST(res->offset == model::offset(0));
     b | stop();
 }
+
+FIXTURE_TEST(timequery_backwards_timestamps, log_builder_fixture) {
+    using namespace storage; // NOLINT
+
+    b | start();
+
+    // timestamps [1000...1099] but for offset 50, which goes back to 900
+    b | add_segment(0);
+    for (auto offset = 0; offset < 100; ++offset) {
+        auto ts = offset == 50 ? 900 : offset + 1000;
+        auto batch = test::make_random_batch(model::offset(offset), 1, false);
+        batch.header().first_timestamp = model::timestamp(ts);
+        batch.header().max_timestamp = model::timestamp(ts);
+        b | add_batch(std::move(batch));
+    }
+
+    auto log = b.get_log();
+    for (auto ts = 1000; ts < 1100; ++ts) {
+        storage::timequery_config config(
+          model::timestamp(ts),
+          log.offsets().dirty_offset,
+          ss::default_priority_class());
+        auto res = log.timequery(config).get0();
+        BOOST_TEST_REQUIRE(res);
+        // no batch has 1050, the next one that reaches it is at offset 51
+        auto expected = ts == 1050 ? 51 : ts - 1000;
+        BOOST_TEST(res->offset == model::offset(expected));
+    }
+    b | stop();
+}
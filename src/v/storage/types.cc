@@ -30,7 +30,7 @@ std::ostream& operator<<(std::ostream& o, const log_reader_config& cfg) {
     } else {
         o << "nullopt";
     }
-    return o << "}";
+    return o << ", header_only:" << cfg.header_only << "}";
 }
 
 std::ostream& operator<<(std::ostream& o, const append_result& a) {
@@ -54,12 +54,17 @@ operator<<(std::ostream& o, const ntp_config::default_overrides& v) {
     fmt::print(
       o,
       "{{compaction_strategy: {}, cleanup_policy_bitflags: {}, segment_size: "
-      "{}, retention_bytes: {}, retention_time_ms: {}}}",
+      "{}, retention_bytes: {}, retention_time_ms: {}, compression: {}, "
+      "flush_ms: {}, flush_bytes: {}, in_memory: {}}}",
       v.compaction_strategy,
       v.cleanup_policy_bitflags,
       v.segment_size,
       v.retention_bytes,
-      v.retention_time);
+      v.retention_time,
+      v.compression,
+      v.flush_ms,
+      v.flush_bytes,
+      v.in_memory);
 
     return o;
 }
@@ -99,13 +104,35 @@ std::ostream& operator<<(std::ostream& o, const offset_stats& s) {
     return o;
 }
 
+std::ostream& operator<<(std::ostream& o, const compaction_backlog& b) {
+    fmt::print(
+      o,
+      "{{next_bytes:{}, dirty_bytes:{}, total_bytes:{}}}",
+      b.next_bytes,
+      b.dirty_bytes,
+      b.total_bytes);
+    return o;
+}
+
 std::ostream& operator<<(std::ostream& o, const compaction_config& c) {
     fmt::print(
       o,
-      "{{evicition_time:{}, max_bytes:{}, should_sanitize:{}}}",
+      "{{evicition_time:{}, max_bytes:{}, should_sanitize:{}, "
+      "hashed_key_index_bytes:{}}}",
       c.eviction_time,
       c.max_bytes.value_or(-1),
-      c.sanitize);
+      c.sanitize,
+      c.hashed_key_index_bytes.value_or(0));
+    return o;
+}
+
+std::ostream& operator<<(std::ostream& o, const scrub_result& r) {
+    fmt::print(
+      o,
+      "{{segments:{}, bytes:{}, corrupt_offset:{}}}",
+      r.segments,
+      r.bytes,
+      r.corrupt_offset ? *r.corrupt_offset : model::offset{});
     return o;
 }
 
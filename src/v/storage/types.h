@@ -57,6 +57,46 @@ struct offset_stats {
     friend std::ostream& operator<<(std::ostream&, const offset_stats&);
 };
 
+/// size of a log and the efficiency of its batch cache
+struct log_stats {
+    size_t size_bytes{0};
+    uint64_t batch_cache_hits{0};
+    uint64_t batch_cache_misses{0};
+};
+
+/// bytes of a log that compaction has yet to process
+struct compaction_backlog {
+    // bytes processed by the next call to log::compact()
+    size_t next_bytes{0};
+    // bytes of all the segments that are waiting for compaction
+    size_t dirty_bytes{0};
+    // bytes of the whole log
+    size_t total_bytes{0};
+
+    double dirty_ratio() const {
+        if (total_bytes == 0) {
+            return 0;
+        }
+        return static_cast<double>(dirty_bytes) / total_bytes;
+    }
+
+    friend std::ostream& operator<<(std::ostream&, const compaction_backlog&);
+};
+
+/// \brief how the appends to a log populate the batch cache
+///
+/// The batches appended by a leader are read back by its consumers and the
+/// recoveries of its followers. Those appended by a follower are only read if
+/// clients fetch from followers, or once it becomes the leader, so it keeps
+/// only the last few of them, see log::set_batch_cache_policy
+enum class batch_cache_policy : int8_t {
+    /// every appended batch is cached
+    all,
+    /// only the batches of the last `follower_batch_cache_tail_bytes`
+    /// appended are kept in the cache
+    tail,
+};
+
 struct log_append_config {
     using fsync = ss::bool_class<class skip_tag>;
     fsync should_fsync;
@@ -177,6 +217,16 @@ struct log_reader_config {
     // historical read-once workloads like compaction).
     bool skip_batch_cache{false};
 
+    // once max_bytes has been read from disk, keep reading up to this many
+    // bytes into the batch cache so that the next sequential read of the log
+    // is served from the cache. a value of zero disables read-ahead.
+    size_t read_ahead_bytes{0};
+
+    // only the batch headers are needed: the records of the batches read from
+    // disk are skipped over and the batches are returned without them. such
+    // batches are not inserted into the batch cache.
+    bool header_only{false};
+
     log_reader_config(
       model::offset start_offset,
       model::offset max_offset,
@@ -239,7 +289,36 @@ struct compaction_config {
     debug_sanitize_files sanitize;
     // abort source for compaction task
     ss::abort_source* asrc;
+    // when set, the keys of a segment are deduplicated by hash in a table of
+    // at most this many bytes instead of by the whole key. Meant for very
+    // large keyspaces. Compactions of a shard run one at a time, so this is
+    // also the memory budget of the shard
+    std::optional<size_t> hashed_key_index_bytes;
 
     friend std::ostream& operator<<(std::ostream&, const compaction_config&);
 };
+
+struct scrub_config {
+    scrub_config(
+      ss::io_priority_class p,
+      std::optional<size_t> max_rate,
+      ss::abort_source& as)
+      : iopc(p)
+      , max_bytes_per_sec(max_rate)
+      , asrc(&as) {}
+
+    ss::io_priority_class iopc;
+    // bound of the rate at which segments are read, unbounded when not set
+    std::optional<size_t> max_bytes_per_sec;
+    ss::abort_source* asrc;
+};
+
+struct scrub_result {
+    size_t segments{0};
+    size_t bytes{0};
+    // the first offset which failed verification, if any
+    std::optional<model::offset> corrupt_offset;
+
+    friend std::ostream& operator<<(std::ostream&, const scrub_result&);
+};
 } // namespace storage
@@ -0,0 +1,115 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "storage/write_behind_controller.h"
+
+#include "config/configuration.h"
+#include "prometheus/prometheus_sanitize.h"
+#include "storage/logger.h"
+#include "vlog.h"
+
+#include <seastar/core/metrics.hh>
+
+namespace storage::internal {
+
+// weight of a new sample in the latency moving average
+static constexpr double latency_alpha = 0.1;
+
+void write_behind_controller::write_completed(
+  clock_type::duration latency, clock_type::time_point now) {
+    if (_in_flight > 0) {
+        --_in_flight;
+    }
+    const auto us = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    if (_writes++ == 0) {
+        _latency_us = us;
+        _window_start = now;
+        _last_adjust = now;
+    } else {
+        _latency_us += latency_alpha * (us - _latency_us);
+    }
+    if (now - _window_start >= baseline_window) {
+        _prev_window_min_us = _window_min_us;
+        _window_min_us = std::numeric_limits<double>::max();
+        _window_start = now;
+    }
+    _window_min_us = std::min(_window_min_us, us);
+    maybe_adjust_depth(now);
+}
+
+void write_behind_controller::maybe_adjust_depth(clock_type::time_point now) {
+    if (now - _last_adjust < adjust_interval) {
+        return;
+    }
+    _last_adjust = now;
+    // never let a sub-microsecond baseline make every latency look queued
+    const auto baseline = std::max(baseline_latency_us(), 1.0);
+    const auto prev = _depth;
+    if (_latency_us <= baseline * grow_threshold) {
+        _depth = std::min(_depth + 1, max_depth);
+    } else if (_latency_us > baseline * shrink_threshold) {
+        _depth = std::max(_depth * 3 / 4, min_depth);
+    }
+    if (_depth != prev) {
+        vlog(
+          stlog.trace,
+          "write behind depth {} -> {}, latency {}us, baseline {}us",
+          prev,
+          _depth,
+          _latency_us,
+          baseline);
+    }
+}
+
+void write_behind_controller::head_chunk_wait(clock_type::duration d) {
+    ++_head_chunk_waits;
+    _head_chunk_wait_us
+      += std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+void write_behind_controller::setup_metrics() {
+    if (config::shard_local_cfg().disable_metrics()) {
+        return;
+    }
+
+    namespace sm = ss::metrics;
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("storage:segment_appender"),
+      {
+        sm::make_gauge(
+          "dma_writes_in_flight",
+          [this] { return _in_flight; },
+          sm::description("Number of chunk dma writes in flight")),
+        sm::make_derive(
+          "dma_writes",
+          [this] { return _writes; },
+          sm::description("Number of completed chunk dma writes")),
+        sm::make_gauge(
+          "dma_write_latency_us",
+          [this] { return _latency_us; },
+          sm::description(
+            "Moving average of chunk dma write latency in microseconds")),
+        sm::make_gauge(
+          "write_behind_depth",
+          [this] { return _depth; },
+          sm::description("Chunk writes each appender may keep in flight")),
+        sm::make_derive(
+          "head_chunk_waits",
+          [this] { return _head_chunk_waits; },
+          sm::description("Number of appends that waited for a head chunk")),
+        sm::make_derive(
+          "head_chunk_wait_us",
+          [this] { return _head_chunk_wait_us; },
+          sm::description(
+            "Total time appends waited for a head chunk in microseconds")),
+      });
+}
+
+} // namespace storage::internal
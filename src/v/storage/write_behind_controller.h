@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+
+#include <seastar/core/metrics_registration.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace storage::internal {
+
+/*
+ * Shard-wide write behind control of the segment appenders.
+ *
+ * Like the chunk cache, it assumes that all segments share the same device.
+ * The completion latency of every dma write of a chunk is tracked as a moving
+ * average and compared to the lowest latency recently observed, which
+ * approximates the service time of the device when it is not queueing. The
+ * write behind depth, i.e. the number of chunk writes each appender keeps in
+ * flight, grows by one while the average latency stays within a small
+ * multiple of that baseline and shrinks multiplicatively once requests start
+ * queueing on the device. A fast device thus ends up with a deep queue while
+ * a slow one stays shallow, without any per device configuration.
+ */
+class write_behind_controller {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    static constexpr size_t min_depth = 1;
+    static constexpr size_t max_depth = 64;
+    static constexpr size_t initial_depth = 8;
+    // the depth is adjusted at most once per interval
+    static constexpr clock_type::duration adjust_interval
+      = std::chrono::milliseconds(10);
+    // the baseline latency is the minimum over the last two windows
+    static constexpr clock_type::duration baseline_window
+      = std::chrono::seconds(10);
+    // latency multiples of the baseline below which the depth grows and above
+    // which it shrinks
+    static constexpr double grow_threshold = 2.0;
+    static constexpr double shrink_threshold = 4.0;
+
+    write_behind_controller() noexcept = default;
+    write_behind_controller(write_behind_controller&&) = delete;
+    write_behind_controller& operator=(write_behind_controller&&) = delete;
+    write_behind_controller(const write_behind_controller&) = delete;
+    write_behind_controller& operator=(const write_behind_controller&)
+      = delete;
+    ~write_behind_controller() noexcept = default;
+
+    size_t depth() const { return _depth; }
+    uint64_t writes_in_flight() const { return _in_flight; }
+    /// moving average of the write completion latency, in microseconds
+    double write_latency_us() const { return _latency_us; }
+
+    void write_dispatched() { ++_in_flight; }
+    void write_completed(
+      clock_type::duration latency,
+      clock_type::time_point now = clock_type::now());
+
+    /// an appender waited for a new head chunk to append to
+    void head_chunk_wait(clock_type::duration);
+
+    void setup_metrics();
+
+private:
+    double baseline_latency_us() const {
+        return std::min(_window_min_us, _prev_window_min_us);
+    }
+    void maybe_adjust_depth(clock_type::time_point now);
+
+    size_t _depth{initial_depth};
+    uint64_t _in_flight{0};
+    uint64_t _writes{0};
+    double _latency_us{0};
+    double _window_min_us{std::numeric_limits<double>::max()};
+    double _prev_window_min_us{std::numeric_limits<double>::max()};
+    clock_type::time_point _window_start{};
+    clock_type::time_point _last_adjust{};
+    uint64_t _head_chunk_waits{0};
+    uint64_t _head_chunk_wait_us{0};
+    ss::metrics::metric_groups _metrics;
+};
+
+inline write_behind_controller& write_behind() {
+    static thread_local write_behind_controller controller;
+    return controller;
+}
+
+} // namespace storage::internal
@@ -0,0 +1,291 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "syschecks/disk_calibration.h"
+
+#include "syschecks/syschecks.h"
+#include "units.h"
+#include "utils/file_io.h"
+
+#include <seastar/core/file.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/thread.hh>
+
+#include <boost/range/irange.hpp>
+#include <fmt/format.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <random>
+
+namespace syschecks {
+
+using clock_type = std::chrono::steady_clock;
+
+static constexpr auto scratch_file_name = ".disk_calibration.tmp";
+static constexpr auto calibration_file_name = "disk_calibration.yaml";
+// the ios are spread over the whole scratch file, so that the device and not
+// its cache is measured
+static constexpr size_t scratch_file_size = 256_MiB;
+static constexpr std::array<size_t, 6> io_sizes{
+  4_KiB, 16_KiB, 64_KiB, 128_KiB, 256_KiB, 1_MiB};
+// moved for each io size, with a few ios in flight like the segment appender
+static constexpr size_t bandwidth_bytes = 64_MiB;
+static constexpr size_t bandwidth_depth = 4;
+static constexpr size_t small_io_size = 4_KiB;
+static constexpr size_t latency_ios = 256;
+static constexpr size_t iops_ios = 8192;
+static constexpr size_t iops_depth = 16;
+
+enum class io_kind { write, read };
+
+/// issues count ios of the size with up to depth of them in flight, at
+/// successive offsets of the scratch file or at random ones, and returns how
+/// long they took. called from a seastar thread
+static clock_type::duration run_ios(
+  ss::file& f,
+  io_kind kind,
+  size_t size,
+  size_t count,
+  size_t depth,
+  bool random) {
+    auto buf = ss::allocate_aligned_buffer<char>(
+      size * depth, f.memory_dma_alignment());
+    std::fill_n(buf.get(), size * depth, 'r');
+    const auto slots = scratch_file_size / size;
+    std::default_random_engine rng(std::random_device{}());
+    std::uniform_int_distribution<size_t> dist(0, slots - 1);
+    size_t issued = 0;
+    const auto start = clock_type::now();
+    ss::parallel_for_each(
+      boost::irange<size_t>(0, depth),
+      [&](size_t worker) {
+          char* ptr = buf.get() + worker * size;
+          return ss::do_until(
+            [&issued, count] { return issued >= count; },
+            [&, ptr] {
+                const auto slot = random ? dist(rng) : issued % slots;
+                ++issued;
+                auto done = kind == io_kind::write
+                              ? f.dma_write<char>(slot * size, ptr, size)
+                              : f.dma_read<char>(slot * size, ptr, size);
+                return done.then([size](size_t n) {
+                    if (n != size) {
+                        throw std::runtime_error(fmt::format(
+                          "Short io of {} bytes out of {}", n, size));
+                    }
+                });
+            });
+      })
+      .get();
+    return clock_type::now() - start;
+}
+
+static uint64_t per_second(uint64_t n, clock_type::duration d) {
+    const auto us = std::max<int64_t>(
+      1, std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    return n * 1'000'000 / us;
+}
+
+/// the bandwidth at the smallest io size within 90% of the best one
+static void set_bandwidth(
+  const std::array<uint64_t, io_sizes.size()>& bw,
+  uint64_t& bandwidth,
+  size_t& io_size) {
+    const auto best = *std::max_element(bw.begin(), bw.end());
+    for (size_t i = 0; i < io_sizes.size(); ++i) {
+        if (bw[i] * 10 >= best * 9) {
+            bandwidth = bw[i];
+            io_size = io_sizes[i];
+            return;
+        }
+    }
+}
+
+static disk_calibration measure(ss::file& f) {
+    disk_calibration c;
+    // written first, so that the reads are of allocated blocks
+    f.allocate(0, scratch_file_size).get();
+    run_ios(
+      f, io_kind::write, 1_MiB, scratch_file_size / 1_MiB, iops_depth, false);
+    f.flush().get();
+
+    std::array<uint64_t, io_sizes.size()> write_bw{};
+    std::array<uint64_t, io_sizes.size()> read_bw{};
+    for (size_t i = 0; i < io_sizes.size(); ++i) {
+        const auto count = bandwidth_bytes / io_sizes[i];
+        write_bw[i] = per_second(
+          bandwidth_bytes,
+          run_ios(
+            f, io_kind::write, io_sizes[i], count, bandwidth_depth, false));
+        read_bw[i] = per_second(
+          bandwidth_bytes,
+          run_ios(
+            f, io_kind::read, io_sizes[i], count, bandwidth_depth, false));
+    }
+    set_bandwidth(write_bw, c.write_bandwidth, c.write_io_size);
+    set_bandwidth(read_bw, c.read_bandwidth, c.read_io_size);
+
+    auto latency = [&f](io_kind kind) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+          run_ios(f, kind, small_io_size, latency_ios, 1, true) / latency_ios);
+    };
+    c.write_latency = latency(io_kind::write);
+    c.read_latency = latency(io_kind::read);
+
+    c.write_iops = per_second(
+      iops_ios,
+      run_ios(f, io_kind::write, small_io_size, iops_ios, iops_depth, true));
+    c.read_iops = per_second(
+      iops_ios,
+      run_ios(f, io_kind::read, small_io_size, iops_ios, iops_depth, true));
+    return c;
+}
+
+ss::future<disk_calibration> calibrate_disk(ss::sstring dir) {
+    return ss::async([dir = std::move(dir)] {
+        const auto path
+          = (std::filesystem::path(dir) / scratch_file_name).string();
+        checklog.info("Calibrating the disk of {}", dir);
+        auto f = ss::open_file_dma(
+                   path,
+                   ss::open_flags::rw | ss::open_flags::create
+                     | ss::open_flags::truncate)
+                   .get0();
+        disk_calibration c;
+        std::exception_ptr err;
+        try {
+            c = measure(f);
+        } catch (...) {
+            err = std::current_exception();
+        }
+        f.close().get();
+        ss::remove_file(path).get();
+        if (err) {
+            std::rethrow_exception(err);
+        }
+        checklog.info("Calibrated the disk of {}: {}", dir, c);
+        return c;
+    });
+}
+
+static ss::future<> write_text(ss::sstring path, ss::sstring text) {
+    const auto flags = ss::open_flags::wo | ss::open_flags::create
+                       | ss::open_flags::truncate;
+    return ss::open_file_dma(path, flags)
+      .then(
+        [](ss::file f) { return ss::make_file_output_stream(std::move(f)); })
+      .then([text = std::move(text)](ss::output_stream<char> out) {
+          return ss::do_with(
+            std::move(out), [&text](ss::output_stream<char>& out) {
+                return out.write(text)
+                  .then([&out] { return out.flush(); })
+                  .finally([&out] { return out.close(); });
+            });
+      });
+}
+
+ss::future<std::optional<disk_calibration>>
+read_disk_calibration(ss::sstring dir) {
+    auto path = (std::filesystem::path(dir) / calibration_file_name).string();
+    return ss::file_exists(path).then([path](bool exists) {
+        if (!exists) {
+            return ss::make_ready_future<std::optional<disk_calibration>>(
+              std::nullopt);
+        }
+        return read_fully_tmpbuf(path).then(
+          [path](ss::temporary_buffer<char> buf) {
+              std::optional<disk_calibration> ret;
+              try {
+                  auto n = YAML::Load(std::string(buf.get(), buf.size()));
+                  disk_calibration c;
+                  c.write_bandwidth = n["write_bandwidth"].as<uint64_t>();
+                  c.read_bandwidth = n["read_bandwidth"].as<uint64_t>();
+                  c.write_iops = n["write_iops"].as<uint64_t>();
+                  c.read_iops = n["read_iops"].as<uint64_t>();
+                  c.write_latency = std::chrono::microseconds(
+                    n["write_latency_us"].as<int64_t>());
+                  c.read_latency = std::chrono::microseconds(
+                    n["read_latency_us"].as<int64_t>());
+                  c.write_io_size = n["write_io_size"].as<size_t>();
+                  c.read_io_size = n["read_io_size"].as<size_t>();
+                  ret = c;
+              } catch (const YAML::Exception& e) {
+                  // measured again
+                  checklog.warn(
+                    "Ignoring the disk calibration {}: {}", path, e.what());
+              }
+              return ret;
+          });
+    });
+}
+
+ss::future<> write_disk_calibration(ss::sstring dir, disk_calibration c) {
+    auto path = (std::filesystem::path(dir) / calibration_file_name).string();
+    return write_text(
+      path,
+      fmt::format(
+        "write_bandwidth: {}\n"
+        "read_bandwidth: {}\n"
+        "write_iops: {}\n"
+        "read_iops: {}\n"
+        "write_latency_us: {}\n"
+        "read_latency_us: {}\n"
+        "write_io_size: {}\n"
+        "read_io_size: {}\n",
+        c.write_bandwidth,
+        c.read_bandwidth,
+        c.write_iops,
+        c.read_iops,
+        c.write_latency.count(),
+        c.read_latency.count(),
+        c.write_io_size,
+        c.read_io_size));
+}
+
+ss::future<> write_io_properties(
+  ss::sstring path, ss::sstring mountpoint, disk_calibration c) {
+    return write_text(
+      std::move(path),
+      fmt::format(
+        "disks:\n"
+        "  - mountpoint: {}\n"
+        "    read_iops: {}\n"
+        "    read_bandwidth: {}\n"
+        "    write_iops: {}\n"
+        "    write_bandwidth: {}\n",
+        mountpoint,
+        c.read_iops,
+        c.read_bandwidth,
+        c.write_iops,
+        c.write_bandwidth));
+}
+
+std::ostream& operator<<(std::ostream& o, const disk_calibration& c) {
+    fmt::print(
+      o,
+      "{{write_bandwidth:{}, read_bandwidth:{}, write_iops:{}, read_iops:{}, "
+      "write_latency:{}us, read_latency:{}us, write_io_size:{}, "
+      "read_io_size:{}}}",
+      c.write_bandwidth,
+      c.read_bandwidth,
+      c.write_iops,
+      c.read_iops,
+      c.write_latency.count(),
+      c.read_latency.count(),
+      c.write_io_size,
+      c.read_io_size);
+    return o;
+}
+
+} // namespace syschecks
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/sstring.hh>
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+
+namespace syschecks {
+
+/**
+ * The performance of the disk of a data directory, measured with direct io
+ * on a scratch file of the directory.
+ *
+ * The bandwidths are those of sequential ios of the optimal io size, which
+ * is the smallest of the sizes tried that gets at least 90% of the best
+ * bandwidth. The latencies are those of a single 4KiB io in flight, and the
+ * iops those of random 4KiB ios with many in flight.
+ */
+struct disk_calibration {
+    uint64_t write_bandwidth{0};
+    uint64_t read_bandwidth{0};
+    uint64_t write_iops{0};
+    uint64_t read_iops{0};
+    std::chrono::microseconds write_latency{0};
+    std::chrono::microseconds read_latency{0};
+    size_t write_io_size{0};
+    size_t read_io_size{0};
+
+    friend std::ostream& operator<<(std::ostream&, const disk_calibration&);
+};
+
+/// measures the disk of the directory. takes a few seconds, and writes a
+/// few hundred MiB which are removed once done
+ss::future<disk_calibration> calibrate_disk(ss::sstring dir);
+
+/// the calibration persisted in the directory, if any
+ss::future<std::optional<disk_calibration>>
+read_disk_calibration(ss::sstring dir);
+
+/// persists the calibration in the directory, so that it is measured once
+ss::future<> write_disk_calibration(ss::sstring dir, disk_calibration);
+
+/// writes the calibration of the mountpoint as a seastar io properties file,
+/// which the io scheduler reads with --io-properties-file when it starts
+ss::future<> write_io_properties(
+  ss::sstring path, ss::sstring mountpoint, disk_calibration);
+
+} // namespace syschecks
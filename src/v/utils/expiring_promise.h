@@ -11,17 +11,23 @@
 
 #pragma once
 #include "seastarx.h"
+#include "utils/timing_wheel.h"
 
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/lowres_clock.hh>
 #include <seastar/core/shared_future.hh>
-#include <seastar/core/timer.hh>
 
 #include <system_error>
 
+/// The deadlines are armed on the timing wheel of the shard, whose clock is
+/// the lowres clock.
 template<typename T, typename Clock = ss::lowres_clock>
 class expiring_promise {
+    static_assert(
+      std::is_same_v<Clock, timing_wheel::clock>,
+      "expiring_promise deadlines are kept by the timing wheel");
+
 public:
     template<typename ErrorFactory>
     ss::future<T> get_future_with_timeout(
@@ -60,7 +66,7 @@ public:
                   }
                   unlink_abort_source();
               });
-            _timer.arm(timeout);
+            timing_wheel::local().arm(_timer, timeout);
         }
 
         auto f = _promise.get_shared_future();
@@ -106,6 +112,6 @@ private:
     }
 
     ss::shared_promise<T> _promise;
-    ss::timer<Clock> _timer;
+    timing_wheel::entry _timer;
     ss::abort_source::subscription _sub;
 };
@@ -36,9 +36,46 @@ void hdr_hist::record_corrected(uint64_t value, uint64_t interval) {
 
 hdr_hist& hdr_hist::operator+=(const hdr_hist& o) {
     ::hdr_add(_hist.get(), o._hist.get());
+    _sample_count += o._sample_count;
+    _sample_sum += o._sample_sum;
     return *this;
 }
 
+hdr_hist& hdr_hist::operator+=(const snapshot& s) {
+    for (const auto& [value, count] : s.counts) {
+        ::hdr_record_values(_hist.get(), value, count);
+    }
+    _sample_count += s.sample_count;
+    _sample_sum += s.sample_sum;
+    return *this;
+}
+
+hdr_hist::snapshot hdr_hist::take_snapshot() const {
+    snapshot s;
+    s.sample_count = _sample_count;
+    s.sample_sum = _sample_sum;
+    // stack allocated; no cleanup needed
+    struct hdr_iter iter;
+    hdr_iter_recorded_init(&iter, _hist.get());
+    while (hdr_iter_next(&iter)) {
+        s.counts.emplace_back(iter.value, iter.count);
+    }
+    return s;
+}
+
+hdr_hist::snapshot& hdr_hist::snapshot::operator+=(const snapshot& o) {
+    counts.insert(counts.end(), o.counts.begin(), o.counts.end());
+    sample_count += o.sample_count;
+    sample_sum += o.sample_sum;
+    return *this;
+}
+
+void hdr_hist::reset() {
+    ::hdr_reset(_hist.get());
+    _sample_count = 0;
+    _sample_sum = 0;
+}
+
 ss::temporary_buffer<char> hdr_hist::print_classic() const {
     char* buf = nullptr;
     std::size_t len = 0;
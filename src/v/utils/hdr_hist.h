@@ -29,6 +29,7 @@
 #include <chrono>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace hist_internal {
 using hdr_histogram_ptr = std::
@@ -104,6 +105,18 @@ public:
         friend std::ostream& operator<<(std::ostream& o, const measurement&);
     };
 
+    /// \brief the recorded values of a histogram, a few KiB at most, to be
+    /// sent to another shard and merged into a histogram there. Snapshots
+    /// are merged by appending their counts
+    struct snapshot {
+        /// value of a bucket and its count, for the non empty buckets
+        std::vector<std::pair<int64_t, int64_t>> counts;
+        uint64_t sample_count{0};
+        uint64_t sample_sum{0};
+
+        snapshot& operator+=(const snapshot&);
+    };
+
     hdr_hist(
       int64_t max_value = 3600000000,
       int64_t min = 1,
@@ -127,6 +140,10 @@ public:
     ~hdr_hist() noexcept;
 
     hdr_hist& operator+=(const hdr_hist& o);
+    hdr_hist& operator+=(const snapshot& s);
+    snapshot take_snapshot() const;
+    /// forgets the recorded values
+    void reset();
     ss::temporary_buffer<char> print_classic() const;
     void record(uint64_t value);
     void record_multiple_times(uint64_t value, uint32_t times);
@@ -135,6 +152,7 @@ public:
     int64_t get_value_at(double percentile) const;
     double stddev() const;
     double mean() const;
+    uint64_t sample_count() const { return _sample_count; }
     size_t memory_size() const;
     ss::metrics::histogram seastar_histogram_logform() const;
 
@@ -0,0 +1,183 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/node_histograms.h"
+
+#include "prometheus/prometheus_sanitize.h"
+#include "vlog.h"
+
+#include <seastar/core/metrics.hh>
+#include <seastar/core/smp.hh>
+#include <seastar/util/log.hh>
+
+#include <boost/range/irange.hpp>
+#include <fmt/format.h>
+
+static ss::logger histlog{"node_histograms"};
+
+node_histograms::registration::registration(series s, const hdr_hist& h)
+  : _series(std::move(s))
+  , _hist(&h) {}
+
+node_histograms::registration::registration(registration&& o) noexcept
+  : _series(std::move(o._series))
+  , _hist(o._hist) {
+    if (o._hook.is_linked()) {
+        _hook.swap_nodes(o._hook);
+    }
+}
+
+node_histograms::registration&
+node_histograms::registration::operator=(registration&& o) noexcept {
+    if (this != &o) {
+        if (_hook.is_linked()) {
+            _hook.unlink();
+        }
+        _series = std::move(o._series);
+        _hist = o._hist;
+        if (o._hook.is_linked()) {
+            _hook.swap_nodes(o._hook);
+        }
+    }
+    return *this;
+}
+
+node_histograms::registrations& node_histograms::local_registrations() {
+    static thread_local registrations regs;
+    return regs;
+}
+
+node_histograms::registration
+node_histograms::add(ss::sstring name, label_set labels, const hdr_hist& h) {
+    registration r(series{std::move(name), std::move(labels)}, h);
+    local_registrations().push_back(r);
+    return r;
+}
+
+std::map<node_histograms::series, hdr_hist::snapshot>
+node_histograms::shard_snapshot() {
+    std::map<series, hdr_hist::snapshot> ret;
+    for (const auto& r : local_registrations()) {
+        ret[r._series] += r._hist->take_snapshot();
+    }
+    return ret;
+}
+
+node_histograms::summary
+node_histograms::summarize(const series& s, const hdr_hist& h) {
+    return summary{
+      .s = s,
+      .count = h.sample_count(),
+      .p50 = h.get_value_at(50.0),
+      .p90 = h.get_value_at(90.0),
+      .p99 = h.get_value_at(99.0),
+      .p999 = h.get_value_at(99.9),
+      .max = h.get_value_at(100.0),
+    };
+}
+
+std::vector<node_histograms::summary> node_histograms::shard_summaries() {
+    std::vector<summary> ret;
+    for (auto& [s, snap] : shard_snapshot()) {
+        hdr_hist h;
+        h += snap;
+        ret.push_back(summarize(s, h));
+    }
+    return ret;
+}
+
+node_histograms::node_histograms(
+  std::chrono::milliseconds refresh_interval, bool disable_metrics)
+  : _refresh_interval(refresh_interval)
+  , _disable_metrics(disable_metrics) {
+    _timer.set_callback([this] {
+        (void)ss::with_gate(_gate, [this] {
+            return refresh()
+              .handle_exception([](std::exception_ptr e) {
+                  vlog(histlog.warn, "Could not merge the histograms: {}", e);
+              })
+              .finally([this] {
+                  if (!_gate.is_closed()) {
+                      _timer.arm(_refresh_interval);
+                  }
+              });
+        });
+    });
+}
+
+ss::future<> node_histograms::start() {
+    return refresh().then([this] { _timer.arm(_refresh_interval); });
+}
+
+ss::future<> node_histograms::stop() {
+    _timer.cancel();
+    return _gate.close();
+}
+
+ss::future<> node_histograms::refresh() {
+    using snapshots_t = std::map<series, hdr_hist::snapshot>;
+    auto shards = boost::irange(0u, ss::smp::count);
+    return ss::map_reduce(
+             shards.begin(),
+             shards.end(),
+             [](ss::shard_id shard) {
+                 return ss::smp::submit_to(
+                   shard, [] { return shard_snapshot(); });
+             },
+             snapshots_t{},
+             [](snapshots_t acc, snapshots_t snapshots) {
+                 for (auto& [s, snap] : snapshots) {
+                     acc[s] += snap;
+                 }
+                 return acc;
+             })
+      .then([this](snapshots_t snapshots) { merge(std::move(snapshots)); });
+}
+
+void node_histograms::merge(std::map<series, hdr_hist::snapshot> snapshots) {
+    for (auto& [s, snap] : snapshots) {
+        auto it = _hists.find(s);
+        if (it == _hists.end()) {
+            it = _hists.emplace(s, hdr_hist()).first;
+            if (!_disable_metrics) {
+                add_metric(it->first, it->second);
+            }
+        }
+        // the histograms of the shards are cumulative, and so are their
+        // snapshots
+        it->second.reset();
+        it->second += snap;
+    }
+}
+
+void node_histograms::add_metric(const series& s, const hdr_hist& h) {
+    namespace sm = ss::metrics;
+    std::vector<sm::label_instance> labels;
+    labels.reserve(s.labels.size());
+    for (const auto& [k, v] : s.labels) {
+        labels.push_back(sm::label(k)(v));
+    }
+    _metrics.add_group(
+      prometheus_sanitize::metrics_name("node"),
+      {sm::make_histogram(
+        s.name,
+        [&h] { return h.seastar_histogram_logform(); },
+        sm::description(
+          fmt::format("{} of every shard of the node, merged", s.name)),
+        labels)});
+}
+
+std::vector<node_histograms::summary> node_histograms::summaries() const {
+    std::vector<summary> ret;
+    ret.reserve(_hists.size());
+    for (const auto& [s, h] : _hists) {
+        ret.push_back(summarize(s, h));
+    }
+    return ret;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+#include "utils/hdr_hist.h"
+#include "utils/intrusive_list_helpers.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/core/timer.hh>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * Latency histograms of the node, merged from the histograms of every shard.
+ *
+ * The histograms of a shard are registered under the name and labels of
+ * their series, and every refresh interval the shards send a snapshot of
+ * their histograms to the shard running the node histograms, which merges
+ * the snapshots of each series into a node histogram. The node histograms
+ * are exposed as metrics, in the node group, so that the percentiles of the
+ * node are known without summing up the series of every shard.
+ */
+class node_histograms {
+public:
+    using label_set = std::vector<std::pair<ss::sstring, ss::sstring>>;
+
+    struct series {
+        ss::sstring name;
+        label_set labels;
+
+        friend bool operator<(const series& a, const series& b) {
+            return std::tie(a.name, a.labels) < std::tie(b.name, b.labels);
+        }
+    };
+
+    /**
+     * A histogram of the shard, merged into the node histograms until the
+     * registration is dropped. Moving a registration keeps it registered.
+     */
+    class registration {
+    public:
+        registration() = default;
+        registration(registration&&) noexcept;
+        registration& operator=(registration&&) noexcept;
+        registration(const registration&) = delete;
+        registration& operator=(const registration&) = delete;
+        ~registration() = default;
+
+    private:
+        friend node_histograms;
+
+        registration(series, const hdr_hist&);
+
+        intrusive_list_hook _hook;
+        series _series;
+        const hdr_hist* _hist{nullptr};
+    };
+
+    /// in microseconds
+    struct summary {
+        series s;
+        uint64_t count{0};
+        int64_t p50{0};
+        int64_t p90{0};
+        int64_t p99{0};
+        int64_t p999{0};
+        int64_t max{0};
+    };
+
+    /// registers a histogram of the current shard, which must outlive the
+    /// registration
+    [[nodiscard]] static registration
+    add(ss::sstring name, label_set, const hdr_hist&);
+
+    /// the histograms of the current shard, merged per series
+    static std::map<series, hdr_hist::snapshot> shard_snapshot();
+
+    /// the summaries of the histograms of the current shard
+    static std::vector<summary> shard_summaries();
+
+    node_histograms(
+      std::chrono::milliseconds refresh_interval, bool disable_metrics);
+
+    /// merges the histograms of every shard, and then again every refresh
+    /// interval
+    ss::future<> start();
+    ss::future<> stop();
+
+    /// merges the histograms of every shard now
+    ss::future<> refresh();
+
+    /// the summaries of the node histograms as of the last refresh
+    std::vector<summary> summaries() const;
+
+private:
+    using registrations = intrusive_list<registration, &registration::_hook>;
+
+    static registrations& local_registrations();
+    static summary summarize(const series&, const hdr_hist&);
+
+    void merge(std::map<series, hdr_hist::snapshot>);
+    void add_metric(const series&, const hdr_hist&);
+
+    std::chrono::milliseconds _refresh_interval;
+    bool _disable_metrics;
+    std::map<series, hdr_hist> _hists;
+    ss::timer<ss::lowres_clock> _timer;
+    ss::gate _gate;
+    ss::metrics::metric_groups _metrics;
+};
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Heaviest keys of a stream, with the space-saving algorithm: at most
+ * `capacity` keys are counted, and a key which is not counted takes the
+ * place of the lightest one, inheriting its count as the error of its own.
+ *
+ * Every key weighing more than total / capacity is counted, and the count of
+ * a key overestimates its weight by at most its error. The lightest key is
+ * found with a scan of the counters, which is only done for keys that are
+ * not counted once the sketch is full: capacities are meant to be small.
+ */
+template<typename Key, typename Hash = absl::Hash<Key>>
+class space_saving {
+public:
+    struct entry {
+        Key key;
+        uint64_t count;
+        /// the count overestimates the weight of the key by at most this
+        uint64_t error;
+    };
+
+    explicit space_saving(size_t capacity)
+      : _capacity(std::max<size_t>(capacity, 1)) {}
+
+    void add(const Key& k, uint64_t weight = 1) {
+        if (auto it = _counters.find(k); it != _counters.end()) {
+            it->second.count += weight;
+            return;
+        }
+        if (_counters.size() < _capacity) {
+            _counters.emplace(k, counter{.count = weight, .error = 0});
+            return;
+        }
+        auto lightest = min_counter();
+        const auto floor = lightest->second.count;
+        _counters.erase(lightest);
+        _counters.emplace(
+          k, counter{.count = floor + weight, .error = floor});
+    }
+
+    /// \brief adds the keys of another sketch, e.g. of another core. A key
+    /// missing from a full sketch may have weighed up to its lightest count
+    /// there, which is added to the count and error of the key
+    void merge(const space_saving& o) {
+        const auto floor = full() ? min_counter()->second.count : 0;
+        const auto other_floor = o.full() ? o.min_counter()->second.count : 0;
+        for (auto& [k, c] : _counters) {
+            if (!o._counters.contains(k)) {
+                c.count += other_floor;
+                c.error += other_floor;
+            }
+        }
+        for (const auto& [k, c] : o._counters) {
+            auto [it, inserted] = _counters.try_emplace(
+              k,
+              counter{.count = c.count + floor, .error = c.error + floor});
+            if (!inserted) {
+                it->second.count += c.count;
+                it->second.error += c.error;
+            }
+        }
+        while (_counters.size() > _capacity) {
+            _counters.erase(min_counter());
+        }
+    }
+
+    /// \brief halves the counts, so that the sketch follows the recent load
+    /// instead of the load since the start
+    void decay() {
+        for (auto it = _counters.begin(); it != _counters.end();) {
+            it->second.count /= 2;
+            it->second.error /= 2;
+            if (it->second.count == 0) {
+                _counters.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /// \brief the `n` heaviest keys, heaviest first
+    std::vector<entry> top(size_t n) const {
+        std::vector<entry> ret;
+        ret.reserve(_counters.size());
+        for (const auto& [k, c] : _counters) {
+            ret.push_back(entry{.key = k, .count = c.count, .error = c.error});
+        }
+        n = std::min(n, ret.size());
+        std::partial_sort(
+          ret.begin(),
+          ret.begin() + n,
+          ret.end(),
+          [](const entry& a, const entry& b) { return a.count > b.count; });
+        ret.resize(n);
+        return ret;
+    }
+
+    size_t size() const { return _counters.size(); }
+    size_t capacity() const { return _capacity; }
+    bool full() const { return _counters.size() >= _capacity; }
+
+private:
+    struct counter {
+        uint64_t count;
+        uint64_t error;
+    };
+    using counters_t = absl::flat_hash_map<Key, counter, Hash>;
+
+    typename counters_t::iterator min_counter() {
+        return std::min_element(
+          _counters.begin(), _counters.end(), [](const auto& a, const auto& b) {
+              return a.second.count < b.second.count;
+          });
+    }
+    typename counters_t::const_iterator min_counter() const {
+        return std::min_element(
+          _counters.begin(), _counters.end(), [](const auto& a, const auto& b) {
+              return a.second.count < b.second.count;
+          });
+    }
+
+    size_t _capacity;
+    counters_t _counters;
+};
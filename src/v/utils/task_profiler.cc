@@ -0,0 +1,87 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/task_profiler.h"
+
+#include <seastar/core/smp.hh>
+#include <seastar/util/backtrace.hh>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+// up to an hour at 2 significant figures, a few KB instead of the ~185KB of
+// the default granularity
+task_profiler::counted_hist::counted_hist()
+  : hist(3600000000, 1, 2) {}
+
+task_profiler::hist_summary task_profiler::counted_hist::summarize() const {
+    return hist_summary{
+      .count = count,
+      .p50 = hist.get_value_at(50.0),
+      .p99 = hist.get_value_at(99.0),
+      .max = hist.get_value_at(100.0),
+    };
+}
+
+task_profiler::op_profile&
+task_profiler::record_runtime(std::string_view op, clock::duration runtime) {
+    auto& o = _ops[op];
+    o.last_runtime = std::chrono::duration_cast<std::chrono::microseconds>(
+      runtime);
+    o.runtime.record(o.last_runtime.count());
+    _groups[ss::current_scheduling_group().name()].record(
+      o.last_runtime.count());
+    if (
+      _stall_threshold != std::chrono::milliseconds::zero()
+      && runtime > _stall_threshold) {
+        ++o.stalls;
+        sample_stall(o, clock::now());
+    }
+    return o;
+}
+
+void task_profiler::sample_stall(op_profile& o, clock::time_point now) {
+    if (!o.samples.empty() && now - o.last_sample < stall_sample_interval) {
+        return;
+    }
+    o.last_sample = now;
+    o.samples.push_back(stall_sample{
+      .at = ss::lowres_system_clock::now(),
+      .runtime = o.last_runtime,
+      .backtrace = fmt::format("{}", ss::current_backtrace()),
+    });
+    if (o.samples.size() > max_stall_samples) {
+        o.samples.pop_front();
+    }
+}
+
+task_profiler::summary task_profiler::summarize() const {
+    summary ret{.shard = ss::this_shard_id()};
+    ret.ops.reserve(_ops.size());
+    for (auto& [name, o] : _ops) {
+        ret.ops.push_back(op_summary{
+          .name = ss::sstring(name),
+          .runtime = o.runtime.summarize(),
+          .latency = o.latency.summarize(),
+          .stalls = o.stalls,
+          .samples = {o.samples.begin(), o.samples.end()},
+        });
+    }
+    ret.groups.reserve(_groups.size());
+    for (auto& [name, h] : _groups) {
+        ret.groups.push_back(
+          group_summary{.name = name, .runtime = h.summarize()});
+    }
+    return ret;
+}
+
+task_profiler& shard_local_task_profiler() {
+    static thread_local task_profiler profiler;
+    return profiler;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+
+#include "seastarx.h"
+#include "utils/hdr_hist.h"
+
+#include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/scheduling.hh>
+#include <seastar/core/sstring.hh>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string_view>
+#include <vector>
+
+/// \brief per shard runtime profile of the hot operations
+///
+/// A profiled operation records two histograms: its runtime, the time the
+/// call itself ran before returning its future, which is the time it held the
+/// reactor, and its latency, the time until its future resolved. The runtime
+/// is also accounted to the scheduling group the operation ran in.
+///
+/// A call that holds the reactor for longer than the stall threshold is
+/// counted as a stall, and its backtrace is sampled, at most once a second per
+/// operation, keeping the last few samples.
+class task_profiler {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr size_t max_stall_samples = 16;
+    static constexpr auto stall_sample_interval = std::chrono::seconds(1);
+
+    struct stall_sample {
+        ss::lowres_system_clock::time_point at;
+        std::chrono::microseconds runtime;
+        ss::sstring backtrace;
+    };
+
+    struct hist_summary {
+        uint64_t count{0};
+        int64_t p50{0};
+        int64_t p99{0};
+        int64_t max{0};
+    };
+
+    struct op_summary {
+        ss::sstring name;
+        hist_summary runtime;
+        hist_summary latency;
+        uint64_t stalls{0};
+        std::vector<stall_sample> samples;
+    };
+
+    struct group_summary {
+        ss::sstring name;
+        hist_summary runtime;
+    };
+
+    /// copyable snapshot of the profile of a shard, in microseconds
+    struct summary {
+        ss::shard_id shard;
+        std::vector<op_summary> ops;
+        std::vector<group_summary> groups;
+    };
+
+    /// zero disables the sampling of stalls
+    void set_stall_threshold(std::chrono::milliseconds threshold) {
+        _stall_threshold = threshold;
+    }
+
+    /// runs f as the operation named op, which must outlive the profiler
+    template<typename Func>
+    auto profile(std::string_view op, Func&& f) {
+        auto begin = clock::now();
+        auto fut = ss::futurize_invoke(std::forward<Func>(f));
+        auto& o = record_runtime(op, clock::now() - begin);
+        if (fut.available()) {
+            o.latency.record(o.last_runtime.count());
+            return fut;
+        }
+        return fut.finally(
+          [&o, begin] { o.latency.record(micros(clock::now() - begin)); });
+    }
+
+    summary summarize() const;
+
+private:
+    struct counted_hist {
+        counted_hist();
+        void record(int64_t v) {
+            ++count;
+            hist.record(v);
+        }
+        hist_summary summarize() const;
+
+        hdr_hist hist;
+        uint64_t count{0};
+    };
+
+    struct op_profile {
+        counted_hist runtime;
+        counted_hist latency;
+        std::chrono::microseconds last_runtime{0};
+        uint64_t stalls{0};
+        clock::time_point last_sample;
+        std::deque<stall_sample> samples;
+    };
+
+    static int64_t micros(clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d)
+          .count();
+    }
+
+    op_profile& record_runtime(std::string_view op, clock::duration runtime);
+    void sample_stall(op_profile& o, clock::time_point now);
+
+    std::chrono::milliseconds _stall_threshold{0};
+    // entries are never erased, so that pending latency measurements can
+    // keep a reference to their operation
+    std::map<std::string_view, op_profile> _ops;
+    std::map<ss::sstring, counted_hist> _groups;
+};
+
+task_profiler& shard_local_task_profiler();
+
+/// profiles f as op in the profiler of the shard
+template<typename Func>
+auto profile_task(std::string_view op, Func&& f) {
+    return shard_local_task_profiler().profile(op, std::forward<Func>(f));
+}
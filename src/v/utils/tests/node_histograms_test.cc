@@ -0,0 +1,75 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/node_histograms.h"
+
+#include <seastar/core/sharded.hh>
+#include <seastar/core/smp.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+using namespace std::chrono_literals; // NOLINT
+
+namespace {
+struct shard_probe {
+    shard_probe()
+      : reg(node_histograms::add("latency_us", {{"op", "test"}}, hist)) {
+        // the shards record distinct values
+        for (int i = 0; i < 100; ++i) {
+            hist.record((ss::this_shard_id() + 1) * 1000);
+        }
+    }
+    ss::future<> stop() { return ss::now(); }
+
+    hdr_hist hist;
+    node_histograms::registration reg;
+};
+} // namespace
+
+SEASTAR_THREAD_TEST_CASE(snapshot_merges_into_histogram) {
+    hdr_hist a;
+    hdr_hist b;
+    for (int i = 1; i <= 100; ++i) {
+        a.record(i);
+        b.record(i * 100);
+    }
+    auto snap = a.take_snapshot();
+    snap += b.take_snapshot();
+    hdr_hist merged;
+    merged += snap;
+    BOOST_REQUIRE_EQUAL(merged.sample_count(), uint64_t(200));
+    BOOST_REQUIRE_EQUAL(merged.get_value_at(100.0), b.get_value_at(100.0));
+    BOOST_REQUIRE_EQUAL(merged.get_value_at(25.0), a.get_value_at(50.0));
+}
+
+SEASTAR_THREAD_TEST_CASE(merges_the_histograms_of_every_shard) {
+    ss::sharded<shard_probe> probes;
+    probes.start().get();
+    node_histograms node(1h, true);
+    node.start().get();
+
+    auto summaries = node.summaries();
+    BOOST_REQUIRE_EQUAL(summaries.size(), size_t(1));
+    auto& s = summaries[0];
+    BOOST_REQUIRE_EQUAL(s.s.name, "latency_us");
+    BOOST_REQUIRE_EQUAL(s.count, uint64_t(100) * ss::smp::count);
+    BOOST_REQUIRE_GE(s.max, int64_t(ss::smp::count) * 1000);
+
+    // the histograms of another shard alone
+    auto last = ss::smp::submit_to(ss::smp::count - 1, [] {
+                    return node_histograms::shard_summaries();
+                }).get0();
+    BOOST_REQUIRE_EQUAL(last.size(), size_t(1));
+    BOOST_REQUIRE_EQUAL(last[0].count, uint64_t(100));
+    BOOST_REQUIRE_EQUAL(last[0].p50, last[0].max);
+
+    // dropped registrations are no longer merged
+    probes.stop().get();
+    BOOST_REQUIRE(node_histograms::shard_summaries().empty());
+    node.stop().get();
+}
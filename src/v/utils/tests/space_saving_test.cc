@@ -0,0 +1,71 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#define BOOST_TEST_MODULE utils
+#include "utils/space_saving.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_AUTO_TEST_CASE(counts_keys_under_capacity_exactly) {
+    space_saving<std::string> s(4);
+    s.add("a", 10);
+    s.add("b", 5);
+    s.add("a", 1);
+    auto top = s.top(10);
+    BOOST_REQUIRE_EQUAL(top.size(), 2u);
+    BOOST_REQUIRE_EQUAL(top[0].key, "a");
+    BOOST_REQUIRE_EQUAL(top[0].count, 11u);
+    BOOST_REQUIRE_EQUAL(top[0].error, 0u);
+    BOOST_REQUIRE_EQUAL(top[1].key, "b");
+}
+
+BOOST_AUTO_TEST_CASE(keeps_heavy_keys_over_capacity) {
+    space_saving<std::string> s(3);
+    // a heavy key among many light ones
+    for (int i = 0; i < 1000; ++i) {
+        s.add("heavy");
+        s.add(std::to_string(i));
+    }
+    BOOST_REQUIRE_EQUAL(s.size(), 3u);
+    auto top = s.top(1);
+    BOOST_REQUIRE_EQUAL(top[0].key, "heavy");
+    // the count overestimates the weight by at most the error
+    BOOST_REQUIRE_GE(top[0].count, 1000u);
+    BOOST_REQUIRE_LE(top[0].count - top[0].error, 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(merges_sketches) {
+    space_saving<std::string> a(2);
+    space_saving<std::string> b(2);
+    a.add("x", 10);
+    a.add("y", 1);
+    b.add("x", 5);
+    b.add("z", 20);
+    a.merge(b);
+    BOOST_REQUIRE_EQUAL(a.size(), 2u);
+    auto top = a.top(2);
+    BOOST_REQUIRE_EQUAL(top[0].key, "z");
+    BOOST_REQUIRE_EQUAL(top[1].key, "x");
+    BOOST_REQUIRE_EQUAL(top[1].count, 15u);
+    // z may have weighed up to the lightest count of the full sketch a
+    BOOST_REQUIRE_EQUAL(top[0].count, 21u);
+    BOOST_REQUIRE_EQUAL(top[0].error, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(decays_counts) {
+    space_saving<std::string> s(4);
+    s.add("a", 8);
+    s.add("b", 1);
+    s.decay();
+    auto top = s.top(4);
+    BOOST_REQUIRE_EQUAL(top.size(), 1u);
+    BOOST_REQUIRE_EQUAL(top[0].count, 4u);
+}
@@ -0,0 +1,55 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/task_profiler.h"
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <thread>
+
+using namespace std::chrono_literals; // NOLINT
+
+SEASTAR_THREAD_TEST_CASE(records_runtime_and_latency) {
+    task_profiler p;
+    p.profile("ready", [] { return 1; }).get();
+    p.profile("sleep", [] { return ss::sleep(10ms); }).get();
+    p.profile("sleep", [] { return ss::sleep(10ms); }).get();
+
+    auto s = p.summarize();
+    BOOST_REQUIRE_EQUAL(s.ops.size(), 2);
+    auto& ready = s.ops[0];
+    BOOST_REQUIRE_EQUAL(ready.name, "ready");
+    BOOST_REQUIRE_EQUAL(ready.runtime.count, 1);
+    BOOST_REQUIRE_EQUAL(ready.latency.count, 1);
+    auto& sleep = s.ops[1];
+    BOOST_REQUIRE_EQUAL(sleep.name, "sleep");
+    BOOST_REQUIRE_EQUAL(sleep.runtime.count, 2);
+    BOOST_REQUIRE_EQUAL(sleep.latency.count, 2);
+    BOOST_REQUIRE_GE(sleep.latency.p50, 10000);
+    BOOST_REQUIRE_LT(sleep.runtime.max, sleep.latency.p50);
+    BOOST_REQUIRE_EQUAL(sleep.stalls, 0);
+
+    BOOST_REQUIRE_EQUAL(s.groups.size(), 1);
+    BOOST_REQUIRE_EQUAL(s.groups[0].runtime.count, 3);
+}
+
+SEASTAR_THREAD_TEST_CASE(samples_stalls_once_a_second) {
+    task_profiler p;
+    p.set_stall_threshold(1ms);
+    for (int i = 0; i < 3; ++i) {
+        p.profile("stall", [] { std::this_thread::sleep_for(2ms); }).get();
+    }
+    auto s = p.summarize();
+    BOOST_REQUIRE_EQUAL(s.ops.size(), 1);
+    BOOST_REQUIRE_EQUAL(s.ops[0].stalls, 3);
+    BOOST_REQUIRE_EQUAL(s.ops[0].samples.size(), 1);
+    BOOST_REQUIRE(!s.ops[0].samples[0].backtrace.empty());
+}
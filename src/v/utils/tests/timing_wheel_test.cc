@@ -0,0 +1,79 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "seastarx.h"
+#include "utils/timing_wheel.h"
+
+#include <seastar/core/sleep.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono_literals; // NOLINT
+
+SEASTAR_THREAD_TEST_CASE(expires_in_deadline_order) {
+    auto now = timing_wheel::clock::now();
+    std::vector<int> fired;
+    // spread over the first two levels, armed out of order
+    std::vector<timing_wheel::entry> entries;
+    entries.emplace_back([&fired] { fired.push_back(2); });
+    entries.emplace_back([&fired] { fired.push_back(0); });
+    entries.emplace_back([&fired] { fired.push_back(1); });
+    timing_wheel::local().arm(entries[0], now + 900ms);
+    timing_wheel::local().arm(entries[1], now + 20ms);
+    timing_wheel::local().arm(entries[2], now + 300ms);
+
+    ss::sleep(1200ms).get();
+    BOOST_REQUIRE(fired == (std::vector<int>{0, 1, 2}));
+    for (auto& e : entries) {
+        BOOST_REQUIRE(!e.armed());
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(cancelled_entries_do_not_fire) {
+    auto now = timing_wheel::clock::now();
+    int fired = 0;
+    timing_wheel::entry cancelled([&fired] { ++fired; });
+    timing_wheel::local().arm(cancelled, now + 50ms);
+    BOOST_REQUIRE(cancelled.armed());
+    BOOST_REQUIRE(cancelled.cancel());
+    BOOST_REQUIRE(!cancelled.cancel());
+    {
+        timing_wheel::entry destroyed([&fired] { ++fired; });
+        timing_wheel::local().arm(destroyed, now + 50ms);
+    }
+    ss::sleep(200ms).get();
+    BOOST_REQUIRE_EQUAL(fired, 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(moved_entries_stay_armed) {
+    int fired = 0;
+    timing_wheel::entry e([&fired] { ++fired; });
+    timing_wheel::local().arm(e, timing_wheel::clock::now() + 50ms);
+    timing_wheel::entry moved(std::move(e));
+    BOOST_REQUIRE(!e.armed()); // NOLINT
+    BOOST_REQUIRE(moved.armed());
+    ss::sleep(200ms).get();
+    BOOST_REQUIRE_EQUAL(fired, 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(rearm_moves_the_deadline) {
+    auto now = timing_wheel::clock::now();
+    int fired = 0;
+    timing_wheel::entry e([&fired] { ++fired; });
+    timing_wheel::local().arm(e, now + 50ms);
+    timing_wheel::local().arm(e, now + 2s);
+    ss::sleep(300ms).get();
+    BOOST_REQUIRE_EQUAL(fired, 0);
+    BOOST_REQUIRE(e.armed());
+    timing_wheel::local().arm(e, now);
+    ss::sleep(100ms).get();
+    BOOST_REQUIRE_EQUAL(fired, 1);
+}
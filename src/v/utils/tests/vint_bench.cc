@@ -0,0 +1,65 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "bytes/iobuf.h"
+#include "bytes/iobuf_parser.h"
+#include "utils/vint.h"
+
+#include <seastar/testing/perf_tests.hh>
+
+#include <random>
+
+// the varints of the records of a batch of small records: the timestamp
+// delta, offset delta and key length of each record
+static constexpr size_t records = 1000;
+
+static iobuf make_varints() {
+    std::mt19937_64 rng(0); // NOLINT
+    iobuf buf;
+    for (size_t i = 0; i < records; ++i) {
+        for (int64_t v : {int64_t(rng() % 100000), int64_t(i), int64_t(16)}) {
+            auto b = vint::to_bytes(v);
+            buf.append(b.data(), b.size());
+        }
+    }
+    return buf;
+}
+
+struct vint_bench {
+    iobuf buf = make_varints();
+};
+
+PERF_TEST_F(vint_bench, byte_iterator) {
+    iobuf::iterator_consumer in(buf.cbegin(), buf.cend());
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < 3 * records; ++i) {
+        auto [v, n] = vint::deserialize(in);
+        in.skip(n);
+        perf_tests::do_not_optimize(v);
+    }
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(vint_bench, read_varlong) {
+    iobuf_const_parser p(buf);
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < 3 * records; ++i) {
+        perf_tests::do_not_optimize(p.read_varlong());
+    }
+    perf_tests::stop_measuring_time();
+}
+
+PERF_TEST_F(vint_bench, read_varlongs) {
+    iobuf_const_parser p(buf);
+    perf_tests::start_measuring_time();
+    for (size_t i = 0; i < records; ++i) {
+        perf_tests::do_not_optimize(p.read_varlongs<3>());
+    }
+    perf_tests::stop_measuring_time();
+}
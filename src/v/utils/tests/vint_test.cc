@@ -8,6 +8,8 @@
 // by the Apache License, Version 2.0
 
 #include "bytes/bytes.h"
+#include "bytes/iobuf.h"
+#include "bytes/iobuf_parser.h"
 #include "utils/vint.h"
 
 #include <seastar/testing/thread_test_case.hh>
@@ -17,7 +19,9 @@
 #include <array>
 #include <cstdint>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <vector>
 
 namespace {
 
@@ -31,8 +35,105 @@ void check_roundtrip_sweep(int64_t count) {
     }
 }
 
+// values of all the encoded lengths
+std::vector<int64_t> random_values(size_t n) {
+    std::mt19937_64 rng(0); // NOLINT
+    std::vector<int64_t> values;
+    values.reserve(n + 2);
+    values.push_back(std::numeric_limits<int64_t>::min());
+    values.push_back(std::numeric_limits<int64_t>::max());
+    while (values.size() < n) {
+        auto v = static_cast<int64_t>(rng() >> (rng() % 64));
+        values.push_back(rng() % 2 ? v : -v);
+    }
+    return values;
+}
+
+void append_fragment(iobuf& buf, const char* data, size_t n) {
+    if (n > 0) {
+        buf.append_take_ownership(new iobuf::fragment(
+          ss::temporary_buffer<char>(data, n), iobuf::fragment::full{}));
+    }
+}
+
 } // namespace
 
 SEASTAR_THREAD_TEST_CASE(sanity_signed_sweep_64) {
     check_roundtrip_sweep(100000000);
 }
+
+SEASTAR_THREAD_TEST_CASE(contiguous_matches_generic) {
+    for (auto v : random_values(100000)) {
+        std::array<uint8_t, 2 * vint::max_length> buf{};
+        const auto n = vint::serialize(v, buf.data());
+        // shorter buffers than the varint are reported as such
+        for (size_t len = 0; len <= buf.size(); ++len) {
+            auto [decoded, used] = vint::deserialize(buf.data(), len);
+            if (len < n) {
+                BOOST_REQUIRE_EQUAL(used, size_t(0));
+            } else {
+                BOOST_REQUIRE_EQUAL(used, n);
+                BOOST_REQUIRE_EQUAL(decoded, v);
+            }
+        }
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(contiguous_overlong) {
+    // continuation bits set past the maximum length
+    std::array<uint8_t, 2 * vint::max_length> buf{};
+    buf.fill(0xff);
+    const auto view = bytes_view(buf.data(), buf.size());
+    const auto expected = vint::deserialize(view);
+    const auto decoded = vint::deserialize(buf.data(), buf.size());
+    BOOST_REQUIRE_EQUAL(decoded.first, expected.first);
+    BOOST_REQUIRE_EQUAL(decoded.second, expected.second);
+    BOOST_REQUIRE_EQUAL(decoded.second, vint::max_length);
+}
+
+SEASTAR_THREAD_TEST_CASE(batch_roundtrip) {
+    const auto values = random_values(10000);
+    bytes buf(values.size() * vint::max_length, 0);
+    size_t len = 0;
+    for (auto v : values) {
+        len += vint::serialize(v, buf.data() + len);
+    }
+    std::vector<int64_t> decoded(values.size());
+    BOOST_REQUIRE_EQUAL(
+      vint::deserialize_batch(
+        buf.data(), len, decoded.data(), decoded.size()),
+      len);
+    BOOST_REQUIRE(decoded == values);
+    // the last varint is cut
+    BOOST_REQUIRE_EQUAL(
+      vint::deserialize_batch(
+        buf.data(), len - 1, decoded.data(), decoded.size()),
+      size_t(0));
+}
+
+SEASTAR_THREAD_TEST_CASE(parser_across_fragments) {
+    const auto values = random_values(3000);
+    iobuf buf;
+    for (auto v : values) {
+        // small fragments so that varints span them
+        const auto b = vint::to_bytes(v);
+        const auto* data = reinterpret_cast<const char*>(b.data()); // NOLINT
+        const auto mid = b.size() / 2;
+        append_fragment(buf, data, mid);
+        append_fragment(buf, data + mid, b.size() - mid); // NOLINT
+    }
+    iobuf_const_parser p1(buf);
+    for (auto v : values) {
+        BOOST_REQUIRE_EQUAL(p1.read_varlong().first, v);
+    }
+    BOOST_REQUIRE_EQUAL(p1.bytes_left(), size_t(0));
+
+    iobuf_const_parser p3(buf);
+    for (size_t i = 0; i < values.size(); i += 3) {
+        auto [a, b, c] = p3.read_varlongs<3>();
+        BOOST_REQUIRE_EQUAL(a, values[i]);
+        BOOST_REQUIRE_EQUAL(b, values[i + 1]);
+        BOOST_REQUIRE_EQUAL(c, values[i + 2]);
+    }
+    BOOST_REQUIRE_EQUAL(p3.bytes_left(), size_t(0));
+}
@@ -0,0 +1,157 @@
+// Copyright 2020 Vectorized, Inc.
+//
+// Use of this software is governed by the Business Source License
+// included in the file licenses/BSL.md
+//
+// As of the Change Date specified in that file, in accordance with
+// the Business Source License, use of this software will be governed
+// by the Apache License, Version 2.0
+
+#include "utils/timing_wheel.h"
+
+#include <algorithm>
+
+timing_wheel::entry::entry(entry&& o) noexcept
+  : _tick(o._tick)
+  , _callback(std::move(o._callback)) {
+    if (o._hook.is_linked()) {
+        _hook.swap_nodes(o._hook);
+    }
+}
+
+timing_wheel::entry& timing_wheel::entry::operator=(entry&& o) noexcept {
+    if (this != &o) {
+        cancel();
+        _tick = o._tick;
+        _callback = std::move(o._callback);
+        if (o._hook.is_linked()) {
+            _hook.swap_nodes(o._hook);
+        }
+    }
+    return *this;
+}
+
+timing_wheel::timing_wheel()
+  : _tick(floor_tick(clock::now())) {
+    _timer.set_callback([this] {
+        expire();
+        schedule();
+    });
+}
+
+timing_wheel& timing_wheel::local() {
+    static thread_local timing_wheel wheel;
+    return wheel;
+}
+
+uint64_t timing_wheel::floor_tick(clock::time_point tp) {
+    return tp.time_since_epoch() / tick;
+}
+
+uint64_t timing_wheel::ceil_tick(clock::time_point tp) {
+    const auto d = tp.time_since_epoch();
+    return floor_tick(tp) + (d % tick != clock::duration::zero() ? 1 : 0);
+}
+
+bool timing_wheel::empty() const {
+    return _overflow.empty()
+           && std::all_of(_occupied.begin(), _occupied.end(), [](uint64_t b) {
+                  return b == 0;
+              });
+}
+
+void timing_wheel::arm(entry& e, clock::time_point deadline) {
+    e.cancel();
+    if (empty()) {
+        // an idle wheel does not advance
+        _tick = floor_tick(clock::now());
+    }
+    e._tick = std::max(ceil_tick(deadline), _tick + 1);
+    place(e);
+    schedule();
+}
+
+void timing_wheel::place(entry& e) {
+    const auto delta = e._tick - _tick;
+    for (size_t level = 0; level < levels; ++level) {
+        const auto shift = slot_bits * level;
+        if (delta < (uint64_t(1) << (shift + slot_bits))) {
+            const auto idx = (e._tick >> shift) & (slots - 1);
+            _wheel[level][idx].push_back(e);
+            _occupied[level] |= uint64_t(1) << idx;
+            return;
+        }
+    }
+    _overflow.push_back(e);
+}
+
+void timing_wheel::cascade(size_t level) {
+    const auto idx = (_tick >> (slot_bits * level)) & (slots - 1);
+    _occupied[level] &= ~(uint64_t(1) << idx);
+    slot entries;
+    entries.splice(entries.end(), _wheel[level][idx]);
+    while (!entries.empty()) {
+        auto& e = entries.front();
+        entries.pop_front();
+        place(e);
+    }
+}
+
+void timing_wheel::expire() {
+    const auto now = floor_tick(clock::now());
+    while (_tick < now) {
+        ++_tick;
+        // the levels whose lower level wrapped around, top first
+        size_t wrapped = 0;
+        while (wrapped < levels
+               && (_tick & ((uint64_t(1) << (slot_bits * (wrapped + 1))) - 1))
+                    == 0) {
+            ++wrapped;
+        }
+        if (wrapped == levels) {
+            slot entries;
+            entries.splice(entries.end(), _overflow);
+            while (!entries.empty()) {
+                auto& e = entries.front();
+                entries.pop_front();
+                place(e);
+            }
+            --wrapped;
+        }
+        for (auto level = wrapped; level > 0; --level) {
+            cascade(level);
+        }
+
+        const auto idx = _tick & (slots - 1);
+        _occupied[0] &= ~(uint64_t(1) << idx);
+        slot expired;
+        expired.splice(expired.end(), _wheel[0][idx]);
+        while (!expired.empty()) {
+            auto& e = expired.front();
+            expired.pop_front();
+            // the callback may destroy the entry, or arm it again
+            e._callback();
+        }
+    }
+}
+
+void timing_wheel::schedule() {
+    if (empty()) {
+        _timer.cancel();
+        return;
+    }
+    // the next occupied slot of the lowest level, or else the tick at which
+    // it wraps around and the slots of the upper levels move down
+    auto next = (_tick | (slots - 1)) + 1;
+    if (_occupied[0] != 0) {
+        const auto start = (_tick + 1) & (slots - 1);
+        const auto bits = start == 0 ? _occupied[0]
+                                     : (_occupied[0] >> start)
+                                         | (_occupied[0] << (slots - start));
+        next = _tick + 1 + __builtin_ctzll(bits);
+    }
+    const auto deadline = clock::time_point(next * tick);
+    if (!_timer.armed() || _timer.get_timeout() != deadline) {
+        _timer.rearm(deadline);
+    }
+}
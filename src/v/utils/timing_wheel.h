@@ -0,0 +1,119 @@
+/*
+ * Copyright 2020 Vectorized, Inc.
+ *
+ * Use of this software is governed by the Business Source License
+ * included in the file licenses/BSL.md
+ *
+ * As of the Change Date specified in that file, in accordance with
+ * the Business Source License, use of this software will be governed
+ * by the Apache License, Version 2.0
+ */
+
+#pragma once
+#include "seastarx.h"
+#include "utils/intrusive_list_helpers.h"
+
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/timer.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * A hierarchical timing wheel of the shard, for the deadlines of the waits
+ * which are mostly cancelled before they expire: offset waits, long polls and
+ * expiring promises.
+ *
+ * Arming and cancelling an entry links and unlinks it from the list of a slot,
+ * in constant time, and the whole wheel is driven by a single reactor timer
+ * armed only while entries are pending. The deadlines are rounded up to the
+ * tick, which is the resolution of the lowres clock.
+ *
+ * Level L has slots of 64^L ticks. An entry is placed in the lowest level
+ * which covers its deadline, and moved down a level once the level below
+ * wraps around to its slot.
+ */
+class timing_wheel {
+public:
+    using clock = ss::lowres_clock;
+    static constexpr clock::duration tick = std::chrono::milliseconds(10);
+    static constexpr size_t slot_bits = 6;
+    static constexpr size_t slots = 1 << slot_bits;
+    static constexpr size_t levels = 4;
+
+    /**
+     * A deadline armed on the wheel. The callback runs once the deadline
+     * passes, unless the entry is cancelled or destroyed before. Moving an
+     * armed entry keeps it armed.
+     */
+    class entry {
+    public:
+        entry() = default;
+        explicit entry(ss::noncopyable_function<void()> cb)
+          : _callback(std::move(cb)) {}
+        entry(const entry&) = delete;
+        entry& operator=(const entry&) = delete;
+        entry(entry&&) noexcept;
+        entry& operator=(entry&&) noexcept;
+        ~entry() = default;
+
+        void set_callback(ss::noncopyable_function<void()> cb) {
+            _callback = std::move(cb);
+        }
+
+        bool armed() const { return _hook.is_linked(); }
+
+        /// returns true if the entry was armed
+        bool cancel() {
+            if (!armed()) {
+                return false;
+            }
+            _hook.unlink();
+            return true;
+        }
+
+    private:
+        friend timing_wheel;
+
+        intrusive_list_hook _hook;
+        uint64_t _tick{0};
+        ss::noncopyable_function<void()> _callback;
+    };
+
+    timing_wheel();
+    timing_wheel(const timing_wheel&) = delete;
+    timing_wheel& operator=(const timing_wheel&) = delete;
+    timing_wheel(timing_wheel&&) = delete;
+    timing_wheel& operator=(timing_wheel&&) = delete;
+    ~timing_wheel() = default;
+
+    /// arms the entry, or moves its deadline if armed already
+    void arm(entry&, clock::time_point);
+
+    /// the wheel of the current shard
+    static timing_wheel& local();
+
+private:
+    using slot = intrusive_list<entry, &entry::_hook>;
+
+    static uint64_t floor_tick(clock::time_point);
+    static uint64_t ceil_tick(clock::time_point);
+
+    void place(entry&);
+    void expire();
+    void cascade(size_t level);
+    void schedule();
+    bool empty() const;
+
+    /// the last tick processed
+    uint64_t _tick;
+    std::array<std::array<slot, slots>, levels> _wheel;
+    /// the slots which may hold entries, per level. the bits of the slots
+    /// whose entries were all cancelled are cleared once the slot is visited.
+    std::array<uint64_t, levels> _occupied{};
+    /// beyond the top level, checked when the top level wraps around
+    slot _overflow;
+    ss::timer<clock> _timer;
+};
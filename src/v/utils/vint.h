@@ -12,7 +12,12 @@
 #pragma once
 #include "bytes/bytes.h"
 
+#include <seastar/core/byteorder.hh>
+
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <utility>
 
 // class is actually zigzag vint; always signed ints
 // matches exactly the kafka encoding which uses protobuf
@@ -97,4 +102,69 @@ inline std::pair<int64_t, size_t> deserialize(Range&& r) noexcept {
     return {decode_zigzag(result), bytes_read};
 }
 
+namespace detail {
+/// \brief the encoded value and length of a varint of at most 8 bytes at the
+/// front of the little endian word w, or a length of 0 if it is longer.
+///
+/// The last byte is found from the continuation bits of the 8 bytes at once
+/// and the 7 bit groups are packed by halving the number of lanes at each
+/// step, rather than shifting in a byte at a time.
+inline std::pair<uint64_t, size_t> decode_word(uint64_t w) noexcept {
+    const uint64_t stops = ~w & 0x8080808080808080ULL;
+    if (unlikely(stops == 0)) {
+        return {0, 0};
+    }
+    // the bytes up to and including the last one of the varint
+    const uint64_t mask = stops ^ (stops - 1);
+    uint64_t x = w & mask & 0x7f7f7f7f7f7f7f7fULL;
+    x = (x & 0x007f007f007f007fULL) | ((x & 0x7f007f007f007f00ULL) >> 1U);
+    x = (x & 0x00003fff00003fffULL) | ((x & 0x3fff00003fff0000ULL) >> 2U);
+    x = (x & 0x000000000fffffffULL) | ((x & 0x0fffffff00000000ULL) >> 4U);
+    return {x, (static_cast<size_t>(__builtin_ctzll(stops)) + 1) / 8};
+}
+} // namespace detail
+
+/// \brief decodes the varint at the front of a contiguous buffer of len
+/// bytes. Same result as the generic deserialize(), except that a length of
+/// 0 is returned when the buffer ends before the varint does, so that the
+/// caller may continue with the bytes that follow the buffer.
+inline std::pair<int64_t, size_t>
+deserialize(const uint8_t* src, size_t len) noexcept {
+    if (likely(len >= sizeof(uint64_t))) {
+        uint64_t w;
+        std::memcpy(&w, src, sizeof(w));
+        auto [v, n] = detail::decode_word(ss::le_to_cpu(w));
+        if (likely(n > 0)) {
+            return {decode_zigzag(v), n};
+        }
+    }
+    uint64_t result = 0;
+    const size_t n = std::min(len, max_length);
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t byte = src[i];
+        result |= (byte & 127U) << (7 * i);
+        if (!(byte & 128U) || i + 1 == max_length) {
+            return {decode_zigzag(result), i + 1};
+        }
+    }
+    return {0, 0};
+}
+
+/// \brief decodes count consecutive varints of a contiguous buffer of len
+/// bytes into out. Returns the number of bytes decoded, or 0 if the buffer
+/// ends before the last varint does.
+inline size_t deserialize_batch(
+  const uint8_t* src, size_t len, int64_t* out, size_t count) noexcept {
+    size_t used = 0;
+    for (size_t i = 0; i < count; ++i) {
+        auto [v, n] = deserialize(src + used, len - used);
+        if (unlikely(n == 0)) {
+            return 0;
+        }
+        out[i] = v;
+        used += n;
+    }
+    return used;
+}
+
 } // namespace vint
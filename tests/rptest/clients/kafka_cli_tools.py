@@ -7,6 +7,7 @@
 # the Business Source License, use of this software will be governed
 # by the Apache License, Version 2.0
 
+import re
 import subprocess
 
 
@@ -80,6 +81,45 @@ class KafkaCliTools:
         ]
         self._execute(cmd)
 
+    def consume_perf(self, topic, num_records, group="ducktape-perf"):
+        """
+        Consume the records of the topic from its start, and return the
+        statistics of the consumer perf tool, such as MB.sec and nMsg.sec.
+        """
+        self._redpanda.logger.debug("Consuming from topic: %s", topic)
+        cmd = [self._script("kafka-consumer-perf-test.sh")]
+        cmd += ["--topic", topic]
+        cmd += ["--messages", str(num_records)]
+        cmd += ["--group", group]
+        cmd += ["--bootstrap-server", self._redpanda.brokers()]
+        res = self._execute(cmd)
+        assert res, "consumer perf test failed"
+        # a header line and a line of values, both comma separated
+        lines = [l for l in res.splitlines() if ", " in l]
+        keys = [k.strip() for k in lines[-2].split(",")]
+        values = [v.strip() for v in lines[-1].split(",")]
+        return dict(zip(keys, values))
+
+    def end_to_end_latency(self, topic, num_records, record_size, acks=-1):
+        """
+        Produce records one at a time and consume each of them before the
+        next one, and return the average and percentile latencies in ms.
+        """
+        self._redpanda.logger.debug("Measuring latency of topic: %s", topic)
+        cmd = [self._script("kafka-run-class.sh")]
+        cmd += ["kafka.tools.EndToEndLatency", self._redpanda.brokers()]
+        cmd += [topic, str(num_records), str(acks), str(record_size)]
+        res = self._execute(cmd)
+        assert res, "end to end latency tool failed"
+        avg = re.search(r"Avg latency: ([\d.]+) ms", res)
+        pct = re.search(
+            r"Percentiles: 50th = (\d+), 99th = (\d+), 99.9th = (\d+)", res)
+        assert avg and pct, "unexpected output: {}".format(res)
+        return dict(avg=float(avg.group(1)),
+                    p50=int(pct.group(1)),
+                    p99=int(pct.group(2)),
+                    p999=int(pct.group(3)))
+
     def _run(self, script, args):
         cmd = [self._script(script)]
         cmd += ["--bootstrap-server", self._redpanda.brokers()]
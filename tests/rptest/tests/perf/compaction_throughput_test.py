@@ -0,0 +1,72 @@
+# Copyright 2020 Vectorized, Inc.
+#
+# Use of this software is governed by the Business Source License
+# included in the file licenses/BSL.md
+#
+# As of the Change Date specified in that file, in accordance with
+# the Business Source License, use of this software will be governed
+# by the Apache License, Version 2.0
+
+import time
+
+from ducktape.mark.resource import cluster
+from ducktape.utils.util import wait_until
+from kafka import KafkaProducer
+
+from rptest.tests.perf.perf_test import PerfTest
+
+
+class CompactionThroughputTest(PerfTest):
+    """
+    Rate at which compaction shrinks a topic of a few keys, each written
+    many times: the bytes written over the time from the end of the writes
+    until the partition is down to a tenth of them.
+    """
+    RECORDS = 200000
+    RECORD_SIZE = 1024
+    KEYS = 100
+
+    def __init__(self, test_context):
+        extra_rp_conf = dict(
+            log_compaction_interval_ms=1000,
+            compacted_log_segment_size=1048576,
+            log_segment_size=1048576,
+        )
+        super(CompactionThroughputTest, self).__init__(
+            test_context=test_context,
+            extra_rp_conf=extra_rp_conf,
+            topics=dict(compacted=dict(cleanup_policy="compact")))
+
+    def _partition_size(self, node):
+        size = 0
+        for family in self.redpanda.metrics(node):
+            for sample in family.samples:
+                if sample.name == "vectorized_storage_log_partition_size" and \
+                        sample.labels["namespace"] == "kafka" and \
+                        sample.labels["topic"] == "compacted":
+                    size += int(sample.value)
+        return size
+
+    @cluster(num_nodes=3)
+    def test_compaction_throughput(self):
+        producer = KafkaProducer(bootstrap_servers=self.redpanda.brokers(),
+                                 acks="all")
+        value = b"v" * CompactionThroughputTest.RECORD_SIZE
+        for i in range(CompactionThroughputTest.RECORDS):
+            key = str(i % CompactionThroughputTest.KEYS).encode()
+            producer.send("compacted", key=key, value=value)
+        producer.flush()
+        producer.close()
+        start = time.time()
+
+        written = CompactionThroughputTest.RECORDS * \
+            CompactionThroughputTest.RECORD_SIZE
+        wait_until(lambda: all(
+            self._partition_size(n) < written / 10 for n in self.redpanda.nodes),
+                   timeout_sec=600,
+                   backoff_sec=1,
+                   err_msg="Topic was not compacted")
+        elapsed = time.time() - start
+        self.results.record("compaction_mb_per_sec",
+                            written / elapsed / 1048576, "MB/s", True)
+        self.check_baseline()
@@ -0,0 +1,36 @@
+# Copyright 2020 Vectorized, Inc.
+#
+# Use of this software is governed by the Business Source License
+# included in the file licenses/BSL.md
+#
+# As of the Change Date specified in that file, in accordance with
+# the Business Source License, use of this software will be governed
+# by the Apache License, Version 2.0
+
+from ducktape.mark.resource import cluster
+
+from rptest.clients.kafka_cli_tools import KafkaCliTools
+from rptest.tests.perf.perf_test import PerfTest
+
+
+class EndToEndLatencyTest(PerfTest):
+    """
+    Latency from the produce of a record with acks=all until it is fetched
+    by a consumer, one record in flight at a time.
+    """
+    def __init__(self, test_context):
+        super(EndToEndLatencyTest,
+              self).__init__(test_context=test_context,
+                             topics=dict(latency=dict(partitions=1)))
+
+    @cluster(num_nodes=3)
+    def test_end_to_end_latency(self):
+        kafka_tools = KafkaCliTools(self.redpanda)
+        # warm up the connections and the leader
+        kafka_tools.end_to_end_latency("latency", 1000, 512)
+        latency = kafka_tools.end_to_end_latency("latency", 10000, 512)
+        self.results.record("avg_ms", latency["avg"], "ms", False)
+        self.results.record("p50_ms", latency["p50"], "ms", False)
+        self.results.record("p99_ms", latency["p99"], "ms", False)
+        self.results.record("p999_ms", latency["p999"], "ms", False)
+        self.check_baseline()
@@ -0,0 +1,40 @@
+# Copyright 2020 Vectorized, Inc.
+#
+# Use of this software is governed by the Business Source License
+# included in the file licenses/BSL.md
+#
+# As of the Change Date specified in that file, in accordance with
+# the Business Source License, use of this software will be governed
+# by the Apache License, Version 2.0
+
+from ducktape.mark.resource import cluster
+
+from rptest.clients.kafka_cli_tools import KafkaCliTools
+from rptest.tests.perf.perf_test import PerfTest
+
+
+class FetchCatchUpTest(PerfTest):
+    """
+    Throughput of a consumer reading a backlog from the start of the log,
+    which is mostly served from disk rather than from the batch cache.
+    """
+    RECORDS = 1000000
+    RECORD_SIZE = 1024
+
+    def __init__(self, test_context):
+        super(FetchCatchUpTest,
+              self).__init__(test_context=test_context,
+                             topics=dict(backlog=dict(partitions=6)))
+
+    @cluster(num_nodes=3)
+    def test_fetch_catch_up(self):
+        kafka_tools = KafkaCliTools(self.redpanda)
+        kafka_tools.produce("backlog", FetchCatchUpTest.RECORDS,
+                            FetchCatchUpTest.RECORD_SIZE)
+        stats = kafka_tools.consume_perf("backlog", FetchCatchUpTest.RECORDS)
+        self.results.record("fetch_mb_per_sec", float(stats["fetch.MB.sec"]),
+                            "MB/s", True)
+        self.results.record("fetch_records_per_sec",
+                            float(stats["fetch.nMsg.sec"]), "records/s",
+                            True)
+        self.check_baseline()
@@ -0,0 +1,93 @@
+# Copyright 2020 Vectorized, Inc.
+#
+# Use of this software is governed by the Business Source License
+# included in the file licenses/BSL.md
+#
+# As of the Change Date specified in that file, in accordance with
+# the Business Source License, use of this software will be governed
+# by the Apache License, Version 2.0
+
+import time
+import threading
+
+from ducktape.mark.resource import cluster
+from ducktape.utils.util import wait_until
+from kafka import KafkaConsumer
+
+from rptest.tests.perf.perf_test import PerfTest
+
+
+class GroupMember(threading.Thread):
+    """
+    A consumer of the group polling in the background, which publishes the
+    partitions it was last assigned.
+    """
+    def __init__(self, brokers, topic, group):
+        super(GroupMember, self).__init__(daemon=True)
+        self.assignment = set()
+        self._done = threading.Event()
+        self._consumer = KafkaConsumer(topic,
+                                       bootstrap_servers=brokers,
+                                       group_id=group)
+
+    def run(self):
+        while not self._done.is_set():
+            self._consumer.poll(timeout_ms=100)
+            self.assignment = {
+                tp.partition
+                for tp in self._consumer.assignment()
+            }
+        self._consumer.close()
+
+    def stop(self):
+        self._done.set()
+        self.join()
+
+
+class GroupRebalanceTest(PerfTest):
+    """
+    Time for a consumer group to rebalance once a member joins it: from the
+    start of the new member until the partitions are spread over every
+    member.
+    """
+    PARTITIONS = 12
+    MEMBERS = 4
+
+    def __init__(self, test_context):
+        super(GroupRebalanceTest, self).__init__(
+            test_context=test_context,
+            topics=dict(
+                rebalance=dict(partitions=GroupRebalanceTest.PARTITIONS)))
+
+    @cluster(num_nodes=3)
+    def test_group_rebalance(self):
+        members = []
+
+        def balanced():
+            assigned = [m.assignment for m in members]
+            return all(assigned) and \
+                sum(map(len, assigned)) == GroupRebalanceTest.PARTITIONS and \
+                len(set().union(*assigned)) == GroupRebalanceTest.PARTITIONS
+
+        durations = []
+        try:
+            for _ in range(GroupRebalanceTest.MEMBERS):
+                start = time.time()
+                m = GroupMember(self.redpanda.brokers(), "rebalance", "perf")
+                members.append(m)
+                m.start()
+                wait_until(balanced,
+                           timeout_sec=120,
+                           backoff_sec=0.1,
+                           err_msg="Group did not rebalance")
+                durations.append(time.time() - start)
+        finally:
+            for m in members:
+                m.stop()
+
+        # the first join also finds the coordinator of the group
+        self.results.record("first_join_sec", durations[0], "s", False)
+        rejoins = durations[1:]
+        self.results.record("rebalance_sec",
+                            sum(rejoins) / len(rejoins), "s", False)
+        self.check_baseline()
@@ -0,0 +1,58 @@
+# Copyright 2020 Vectorized, Inc.
+#
+# Use of this software is governed by the Business Source License
+# included in the file licenses/BSL.md
+#
+# As of the Change Date specified in that file, in accordance with
+# the Business Source License, use of this software will be governed
+# by the Apache License, Version 2.0
+
+import time
+
+from ducktape.mark.resource import cluster
+from ducktape.utils.util import wait_until
+
+from rptest.clients.kafka_cat import KafkaCat
+from rptest.clients.kafka_cli_tools import KafkaCliTools
+from rptest.tests.perf.perf_test import PerfTest
+
+
+class ManyPartitionsMetadataTest(PerfTest):
+    """
+    Time to create a topic of many partitions until all of them have a
+    leader, and time of the metadata requests of a cluster holding it.
+    """
+    PARTITIONS = 1000
+    REQUESTS = 20
+
+    @cluster(num_nodes=3)
+    def test_many_partitions_metadata(self):
+        kafka_tools = KafkaCliTools(self.redpanda)
+        kc = KafkaCat(self.redpanda)
+
+        def all_led():
+            md = kc.metadata()
+            topic = [t for t in md["topics"] if t["topic"] == "wide"]
+            return topic and len(topic[0]["partitions"]) == \
+                ManyPartitionsMetadataTest.PARTITIONS and \
+                all(p["leader"] != -1 for p in topic[0]["partitions"])
+
+        start = time.time()
+        kafka_tools.create_topic("wide",
+                                 ManyPartitionsMetadataTest.PARTITIONS)
+        wait_until(all_led,
+                   timeout_sec=300,
+                   backoff_sec=1,
+                   err_msg="Partitions were not all assigned a leader")
+        self.results.record("create_topic_sec",
+                            time.time() - start, "s", False)
+
+        start = time.time()
+        for _ in range(ManyPartitionsMetadataTest.REQUESTS):
+            kc.metadata()
+        elapsed = time.time() - start
+        self.results.record(
+            "metadata_request_ms",
+            elapsed * 1000 / ManyPartitionsMetadataTest.REQUESTS, "ms",
+            False)
+        self.check_baseline()
@@ -0,0 +1,63 @@
+# Copyright 2020 Vectorized, Inc.
+#
+# Use of this software is governed by the Business Source License
+# included in the file licenses/BSL.md
+#
+# As of the Change Date specified in that file, in accordance with
+# the Business Source License, use of this software will be governed
+# by the Apache License, Version 2.0
+
+import time
+
+from ducktape.mark.resource import cluster
+from ducktape.utils.util import wait_until
+
+from rptest.clients.kafka_cli_tools import KafkaCliTools
+from rptest.tests.perf.perf_test import PerfTest
+
+
+class NodeRecoveryTest(PerfTest):
+    """
+    Time for a node to restart with the logs of many partitions, and then
+    to catch up with the records written while it was down.
+    """
+    PARTITIONS = 100
+
+    def __init__(self, test_context):
+        super(NodeRecoveryTest, self).__init__(
+            test_context=test_context,
+            topics=dict(recovery=dict(
+                partitions=NodeRecoveryTest.PARTITIONS)))
+
+    def _offsets(self, node):
+        total = 0
+        for family in self.redpanda.metrics(node):
+            for sample in family.samples:
+                if sample.name == "vectorized_cluster_partition_last_stable_offset" and \
+                        sample.labels["namespace"] == "kafka" and \
+                        sample.labels["topic"] == "recovery":
+                    total += int(sample.value)
+        return total
+
+    @cluster(num_nodes=3)
+    def test_node_recovery(self):
+        kafka_tools = KafkaCliTools(self.redpanda)
+        kafka_tools.produce("recovery", 500000, 1024)
+
+        node = self.redpanda.get_node(1)
+        self.redpanda.stop_node(node)
+        # written while the node is down, for it to catch up with
+        kafka_tools.produce("recovery", 100000, 1024)
+
+        start = time.time()
+        self.redpanda.start_node(node)
+        started = time.time()
+        others = [n for n in self.redpanda.nodes if n != node]
+        wait_until(lambda: self._offsets(node) == self._offsets(others[0]),
+                   timeout_sec=300,
+                   backoff_sec=1,
+                   err_msg="Node did not catch up")
+        self.results.record("restart_sec", started - start, "s", False)
+        self.results.record("catch_up_sec",
+                            time.time() - started, "s", False)
+        self.check_baseline()
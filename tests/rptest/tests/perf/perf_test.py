@@ -0,0 +1,89 @@
+# Copyright 2020 Vectorized, Inc.
+#
+# Use of this software is governed by the Business Source License
+# included in the file licenses/BSL.md
+#
+# As of the Change Date specified in that file, in accordance with
+# the Business Source License, use of this software will be governed
+# by the Apache License, Version 2.0
+
+import os
+import json
+
+from rptest.tests.redpanda_test import RedpandaTest
+
+
+class PerfResults:
+    """
+    Measurements of a perf test, compared to the baseline.
+
+    The measurements are written as JSON to the results directory of the
+    test, and a measurement worse than its baseline by more than the
+    tolerance is a regression. The baseline is perf_baseline.json next to
+    this file unless the `perf_baseline` ducktape global names another one,
+    such as the perf_results.json of an earlier run. Measurements missing
+    from the baseline are only recorded.
+    """
+
+    BASELINE_KEY = "perf_baseline"
+    TOLERANCE_KEY = "perf_tolerance"
+    DEFAULT_BASELINE = os.path.join(os.path.dirname(__file__),
+                                    "perf_baseline.json")
+    DEFAULT_TOLERANCE = 0.2
+    RESULTS_FILE = "perf_results.json"
+
+    def __init__(self, test):
+        self._test = test
+        self._name = type(test).__name__
+        self._results = dict()
+        g = test.test_context.globals
+        self._tolerance = float(
+            g.get(PerfResults.TOLERANCE_KEY, PerfResults.DEFAULT_TOLERANCE))
+        path = g.get(PerfResults.BASELINE_KEY, PerfResults.DEFAULT_BASELINE)
+        with open(path) as f:
+            self._baseline = json.load(f)
+
+    def record(self, metric, value, unit, higher_is_better):
+        self._test.logger.info("%s.%s: %s %s", self._name, metric, value,
+                               unit)
+        self._results[f"{self._name}.{metric}"] = dict(
+            value=value, unit=unit, higher_is_better=higher_is_better)
+
+    def regressions(self):
+        found = []
+        for key, r in self._results.items():
+            base = self._baseline.get(key, None)
+            if base is None:
+                continue
+            base = base["value"]
+            if r["higher_is_better"]:
+                worse = r["value"] < base * (1 - self._tolerance)
+            else:
+                worse = r["value"] > base * (1 + self._tolerance)
+            if worse:
+                found.append(f"{key}: {r['value']} {r['unit']}, "
+                             f"baseline {base} {r['unit']}")
+        return found
+
+    def write(self):
+        results_dir = self._test.test_context.results_dir
+        os.makedirs(results_dir, exist_ok=True)
+        path = os.path.join(results_dir, PerfResults.RESULTS_FILE)
+        with open(path, "w") as f:
+            json.dump(self._results, f, indent=2, sort_keys=True)
+
+
+class PerfTest(RedpandaTest):
+    """
+    Base class of the perf suite, see test_suite_perf.yml. A test records
+    its measurements and ends with check_baseline().
+    """
+    def __init__(self, test_context, **kwargs):
+        super(PerfTest, self).__init__(test_context, **kwargs)
+        self.results = PerfResults(self)
+
+    def check_baseline(self):
+        self.results.write()
+        regressions = self.results.regressions()
+        assert not regressions, "Regressions: {}".format(
+            "; ".join(regressions))
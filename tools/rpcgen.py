@@ -30,6 +30,7 @@ RPC_TEMPLATE = """
 #include "rpc/parse_utils.h"
 #include "rpc/transport.h"
 #include "rpc/service.h"
+#include "rpc/stream.h"
 #include "finjector/hbadger.h"
 #include "utils/string_switch.h"
 #include "random/fast_prng.h"
@@ -80,15 +81,53 @@ public:
        return _ssg;
     }
 
-    rpc::method* method_from_id(uint32_t idx) final {
+    /// \\brief the methods of the service, in the order of _methods
+    static constexpr std::array<rpc::method_info, {{methods|length}}> method_infos{%raw %}{{{% endraw %}
+      {%- for method in methods %}
+      rpc::method_info{ {{method.id}}, "{{namespace}}::{{method.name}}", {{method.max_in_flight}} }{{ "," if not loop.last }}
+      {%- endfor %}
+    {% raw %}}}{% endraw %};
+
+    /// \\brief index of the method in method_infos and _methods, -1 if none
+    static constexpr int method_index(uint32_t idx) {
        switch(idx) {
        {%- for method in methods %}
-         case {{method.id}}: return &_methods[{{loop.index - 1}}];
+         case {{method.id}}: return {{loop.index - 1}};
        {%- endfor %}
-         default: return nullptr;
+         default: return -1;
        }
     }
+
+    rpc::method* method_from_id(uint32_t idx) final {
+       const int i = method_index(idx);
+       return i < 0 ? nullptr : &_methods[i];
+    }
+
+    const rpc::method_info* method_info_from_id(uint32_t idx) const final {
+       const int i = method_index(idx);
+       return i < 0 ? nullptr : &method_infos[i];
+    }
     {%- for method in methods %}
+    {%- if method.streaming %}
+    /// \\brief streamed payload -> {{method.output_type}}
+    virtual ss::future<rpc::netbuf>
+    raw_{{method.name}}(ss::input_stream<char>& in, rpc::streaming_context& ctx) {
+      return execution_helper<rpc::stream_frame,
+                              {{method.output_type}}>::exec(in, ctx, {{method.id}},
+      [this](
+          rpc::stream_frame&& f, rpc::streaming_context&) -> ss::future<{{method.output_type}}> {
+          return _{{method.name}}_streams.dispatch(std::move(f),
+            [this](ss::input_stream<char> payload) {
+                return {{method.name}}(std::move(payload));
+            });
+      });
+    }
+    /// \\brief the payload must be read until its end
+    virtual ss::future<{{method.output_type}}>
+    {{method.name}}(ss::input_stream<char>) {
+       throw std::runtime_error("unimplemented method");
+    }
+    {%- else %}
     /// \\brief {{method.input_type}} -> {{method.output_type}}
     virtual ss::future<rpc::netbuf>
     raw_{{method.name}}(ss::input_stream<char>& in, rpc::streaming_context& ctx) {
@@ -103,10 +142,14 @@ public:
     {{method.name}}({{method.input_type}}&&, rpc::streaming_context&) {
        throw std::runtime_error("unimplemented method");
     }
+    {%- endif %}
     {%- endfor %}
 private:
     ss::scheduling_group _sc;
     ss::smp_service_group _ssg;
+    {%- for method in methods if method.streaming %}
+    rpc::stream_table<{{method.output_type}}> _{{method.name}}_streams;
+    {%- endfor %}
     std::array<rpc::method, {{methods|length}}> _methods{%raw %}{{{% endraw %}
       {%- for method in methods %}
       rpc::method([this] (ss::input_stream<char>& in, rpc::streaming_context& ctx) {
@@ -124,10 +167,17 @@ public:
     virtual ~{{service_name}}_client_protocol() = default;
 
     {%- for method in methods %}
+    {%- if method.streaming %}
+    virtual inline ss::future<result<rpc::client_context<{{method.output_type}}>>>
+    {{method.name}}(ss::input_stream<char>&& payload, rpc::client_opts opts, rpc::stream_options so = {}) {
+       return rpc::send_stream<{{method.output_type}}>(_transport, {{method.id}}, std::move(payload), std::move(opts), so);
+    }
+    {%- else %}
     virtual inline ss::future<result<rpc::client_context<{{method.output_type}}>>>
     {{method.name}}({{method.input_type}}&& r, rpc::client_opts opts) {
        return _transport.send_typed<{{method.input_type}}, {{method.output_type}}>(std::move(r), {{method.id}}, std::move(opts));
     }
+    {%- endif %}
     {%- endfor %}
 
 private:
@@ -142,7 +192,7 @@ public:
 
     enum class methods: type {
     {%- for method in methods %}
-        {{method.name}} = 1 << {{loop.index}}{{ "," if not loop.last }}
+        {{method.name}} = 1 << {{loop.index0}}{{ "," if not loop.last }}
     {%- endfor %}
     };
     type method_for_point(std::string_view point) const final {
@@ -177,7 +227,8 @@ private:
             "{{namespace}}::{{service_name}}::{{method.name}}"));
         }
         if (_delay_methods & type(methods::{{method.name}})) {
-            return ss::sleep(std::chrono::milliseconds(_prng() % 50));
+            const auto max = delay_for(type(methods::{{method.name}})).count();
+            return ss::sleep(std::chrono::milliseconds(_prng() % (max + 1)));
         }
         if (_termination_methods & type(methods::{{method.name}})) {
             std::terminate();
@@ -211,7 +262,12 @@ def _enrich_methods(service):
         return service["id"] ^ zlib.crc32(bytes(mid, 'utf-8'))
 
     for m in service["methods"]:
+        # the request of a streaming method is a frame of its payload
+        if m.get("streaming", False):
+            m["input_type"] = "rpc::stream_frame"
         m["id"] = _xor_id(m)
+        # requests in flight on a server, 0 for the server wide limit
+        m.setdefault("max_in_flight", 0)
 
     return service
 